@@ -0,0 +1,166 @@
+#include "PrefetchLoader.h"
+#include "Dataset.h"
+#include "ATen/ATen.h"
+#include "ATen/PinnedMemoryAllocator.h"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+using namespace at;
+
+PrefetchLoader::PrefetchLoader(Dataset& dataset, Fields& sample, uint64_t batchsize,
+                               uint64_t numthreads, uint64_t maxinflight)
+   : PrefetchLoader(dataset, sample, batchsize, numthreads, maxinflight, false, true) {
+}
+
+PrefetchLoader::PrefetchLoader(Dataset& dataset, Fields& sample, uint64_t batchsize,
+                               uint64_t numthreads, uint64_t maxinflight, bool pinmemory,
+                               bool fullbatches) {
+   if(batchsize == 0 || numthreads == 0 || maxinflight == 0)
+      throw std::invalid_argument("PrefetchLoader: batchsize, numthreads and maxinflight must be positive");
+   dataset_ = &dataset;
+   batchsize_ = batchsize;
+   maxinflight_ = maxinflight;
+   uint64_t datasetsize = dataset_->size();
+   if(fullbatches)
+      size_ = datasetsize / batchsize_;
+   else
+      size_ = (datasetsize + batchsize_ - 1) / batchsize_;
+
+   // one more batch than can be in flight, for the one being consumed:
+   slots_.resize(maxinflight_ + 1);
+   for(auto& slot : slots_) {
+      for(auto& field : sample) {
+         std::vector<int64_t> fieldsize;
+         fieldsize.push_back(batchsize_);
+         for(int64_t d = 0; d < field.second.dim(); ++d) {
+            fieldsize.push_back(field.second.size(d));
+         }
+         Type& type = field.second.type();
+         if(pinmemory) {
+            auto allocator = std::unique_ptr<Allocator>(new PinnedMemoryAllocator());
+            slot.fields[field.first] = type.tensorWithAllocator(fieldsize, std::move(allocator));
+         } else {
+            slot.fields[field.first] = type.tensor(fieldsize);
+         }
+      }
+      slot.ready = false;
+   }
+
+   // start the workers and the first batches:
+   for(uint64_t i = 0; i < numthreads; ++i) {
+      workers_.emplace_back([this] { work(); });
+   }
+   std::unique_lock<std::mutex> lock(mutex_);
+   schedule();
+}
+
+// queues the batches that fit in the window after the next one to return,
+// must be called with mutex_ held
+void PrefetchLoader::schedule() {
+   while(nextscheduled_ < size_ && nextscheduled_ < nextreturned_ + maxinflight_) {
+      Slot& slot = slots_[nextscheduled_ % slots_.size()];
+      slot.ready = false;
+      slot.error = nullptr;
+      tasks_.push(nextscheduled_++);
+      pending_++;
+      taskready_.notify_one();
+   }
+}
+
+void PrefetchLoader::loadBatch(uint64_t batchidx, Slot& slot) {
+   uint64_t first = batchidx * batchsize_;
+   uint64_t count = std::min(batchsize_, dataset_->size() - first);
+   for(auto& field : slot.fields) {
+      std::string fieldkey = field.first;
+      for(uint64_t n = 0; n < count; n++) {
+         Tensor row = field.second.select(0, n);
+         Tensor sample = row;
+         dataset_->getField(first + n, fieldkey, sample);
+
+         // the dataset may return a tensor of its own instead of filling ours:
+         if(sample.data_ptr() != row.data_ptr())
+            row.copy_(sample);
+      }
+   }
+}
+
+void PrefetchLoader::work() {
+   for(;;) {
+      uint64_t batchidx;
+      {
+         std::unique_lock<std::mutex> lock(mutex_);
+         taskready_.wait(lock, [this]{ return stop_ || !tasks_.empty(); });
+         if(stop_)
+            return;
+         batchidx = tasks_.front();
+         tasks_.pop();
+      }
+      Slot& slot = slots_[batchidx % slots_.size()];
+      std::exception_ptr error;
+      try {
+         loadBatch(batchidx, slot);
+      } catch(...) {
+         error = std::current_exception();
+      }
+      {
+         std::unique_lock<std::mutex> lock(mutex_);
+         slot.error = error;
+         slot.ready = true;
+         pending_--;
+      }
+      batchready_.notify_all();
+   }
+}
+
+bool PrefetchLoader::next(Fields& batch) {
+   std::unique_lock<std::mutex> lock(mutex_);
+   if(nextreturned_ >= size_)
+      return false;
+   uint64_t batchidx = nextreturned_;
+   Slot& slot = slots_[batchidx % slots_.size()];
+   batchready_.wait(lock, [&slot]{ return slot.ready; });
+
+   // the slot of the previous batch can be refilled now:
+   nextreturned_++;
+   schedule();
+   if(slot.error)
+      std::rethrow_exception(slot.error);
+
+   uint64_t count = std::min(batchsize_, dataset_->size() - batchidx * batchsize_);
+   batch.clear();
+   for(auto& field : slot.fields) {
+      if(count == batchsize_)
+         batch[field.first] = field.second;
+      else
+         batch[field.first] = field.second.narrow(0, 0, count);
+   }
+   return true;
+}
+
+void PrefetchLoader::reset() {
+   std::unique_lock<std::mutex> lock(mutex_);
+
+   // drop the batches not started yet, and wait for the others:
+   pending_ -= tasks_.size();
+   std::queue<uint64_t>().swap(tasks_);
+   batchready_.wait(lock, [this]{ return pending_ == 0; });
+
+   nextscheduled_ = 0;
+   nextreturned_ = 0;
+   schedule();
+}
+
+uint64_t PrefetchLoader::size() {
+   return size_;
+}
+
+PrefetchLoader::~PrefetchLoader() {
+   {
+      std::unique_lock<std::mutex> lock(mutex_);
+      stop_ = true;
+   }
+   taskready_.notify_all();
+   for(std::thread& worker : workers_)
+      worker.join();
+}
@@ -0,0 +1,73 @@
+#ifndef AT_PREFETCH_LOADER_H
+#define AT_PREFETCH_LOADER_H
+
+#include "Dataset.h"
+#include "ATen/ATen.h"
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads batches of a dataset ahead of time on a set of worker threads.
+//
+// Each batch is assembled by one worker, which copies its samples straight
+// into one of a fixed set of preallocated batch tensors (in pinned memory if
+// requested, so they can be copied to the GPU asynchronously). Like for
+// Dataset::get, sample holds a tensor of the size and type of a sample for
+// each field to load. At most maxinflight batches are being loaded or waiting
+// to be consumed at any time, and next() returns them in order, so the
+// sequence of batches is the same regardless of the number of threads.
+//
+// The samples of a field must all have the same size and type, and getField
+// of the dataset must be safe to call from several threads at once. The
+// tensors returned by next() are only valid until the following call, which
+// reuses their memory for a later batch.
+class PrefetchLoader
+{
+public:
+   PrefetchLoader(Dataset& dataset, Fields& sample, uint64_t batchsize,
+                  uint64_t numthreads, uint64_t maxinflight);
+   PrefetchLoader(Dataset& dataset, Fields& sample, uint64_t batchsize,
+                  uint64_t numthreads, uint64_t maxinflight, bool pinmemory,
+                  bool fullbatches);
+   // fills batch with the next batch, returns false at the end of the epoch
+   bool next(Fields& batch);
+   // starts a new epoch, e.g. after resampling the dataset
+   void reset();
+   uint64_t size();
+   ~PrefetchLoader();
+private:
+   struct Slot {
+      Fields fields;
+      bool ready;
+      std::exception_ptr error;
+   };
+
+   void schedule();
+   void loadBatch(uint64_t batchidx, Slot& slot);
+   void work();
+
+   Dataset* dataset_;
+   uint64_t batchsize_;
+   uint64_t maxinflight_;
+   uint64_t size_;
+   std::vector<Slot> slots_;
+   std::vector<std::thread> workers_;
+
+   // batches are scheduled and returned in increasing order:
+   uint64_t nextscheduled_ = 0;
+   uint64_t nextreturned_ = 0;
+   uint64_t pending_ = 0;
+
+   // synchronization:
+   std::queue<uint64_t> tasks_;
+   std::mutex mutex_;
+   std::condition_variable taskready_;
+   std::condition_variable batchready_;
+   bool stop_ = false;
+};
+
+#endif
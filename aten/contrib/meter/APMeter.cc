@@ -1,5 +1,9 @@
 #include "APMeter.h"
+#include "ATen/Parallel.h"
+#include <algorithm>
 #include <math.h>
+#include <numeric>
+#include <vector>
 #include <cassert>
 
 using namespace at;
@@ -19,27 +23,23 @@ void APMeter::add(Tensor& output, Tensor& target) {
    // assertions and allocations:
    assert(output.dim() == 2 && target.dim() == 2);
    //assert(isSameSizeAs(output, target));
-   assert(output.size(1) == outputs_.size(1));
-
-   // get current outputs and targets:
-   Tensor curoutputs = getOutputs();
-   Tensor curtargets = getTargets();
-
-   // make sure underlying storages are sufficiently large:
-   if(numel(outputs_) < numel(curoutputs) + numel(output)) {
-      long long newsize = ceil(numel(outputs_) * 1.5);
-      outputs_.resize_({newsize + numel(output)});
-      targets_.resize_({newsize + numel(output)});
+   assert(n_ == 0 || output.size(1) == outputs_.size(1));
+
+   // make sure underlying storages are sufficiently large, growing the rows of
+   // contiguous tensors keeps the ones stored so far:
+   int64_t capacity = (outputs_.dim() == 2) ? outputs_.size(0) : 0;
+   if(capacity < (int64_t) n_ + output.size(0)) {
+      int64_t newsize = std::max<int64_t>(ceil(capacity * 1.5), n_ + output.size(0));
+      outputs_.resize_({newsize, output.size(1)});
+      targets_.resize_({newsize, output.size(1)});
    }
-   n_ += output.size(0);
 
    // store scores and targets:
-   uint64_t offset = (numel(curoutputs) > 0) ? curoutputs.size(0) : 0;
-   Tensor outputbuffer = outputs_.narrow( 0, offset, output.size(0));
-   Tensor targetbuffer = targets_.narrow( 0, offset, target.size(0));
-
+   Tensor outputbuffer = outputs_.narrow(0, n_, output.size(0));
+   Tensor targetbuffer = targets_.narrow(0, n_, target.size(0));
    outputbuffer.copy_(output);
    targetbuffer.copy_(target);
+   n_ += output.size(0);
 }
 
 Tensor APMeter::getOutputs() {
@@ -52,38 +52,37 @@ Tensor APMeter::getTargets() {
 void APMeter::value(Tensor& val) {
 
    // get current outputs and targets:
-   Tensor curoutputs = getOutputs();
-   Tensor curtargets = getTargets();
+   Tensor curoutputs = getOutputs().contiguous().toType(CPU(kDouble));
+   Tensor curtargets = getTargets().contiguous().toType(CPU(kDouble));
+   int64_t n = curoutputs.size(0);
+   int64_t nclasses = curoutputs.size(1);
+   double * outputs_d = curoutputs.data<double>();
+   double * targets_d = curtargets.data<double>();
 
    // allocate some memory:
-   val.resize_({curoutputs.size(1)});
+   val.resize_({nclasses});
    double * val_d = val.data<double>();
-   Tensor outputbuffer, targetbuffer, sortval, sortidx, sorttgt;
-   Tensor truepos, precision;
-   Tensor range = val.type().range(0,curoutputs.size(0));
-
-   // loop over all classes:
-   for(uint64_t k = 0; k < curoutputs.size(1); ++k) {
 
-      // sort scores:
-      outputbuffer = curoutputs.narrow( 1, k, 1);
-      targetbuffer = curtargets.narrow(1, k, 1).contiguous().toType(CPU(kDouble));
-      double * targetbuffer_d = targetbuffer.data<double>();
-      std::tie(sortval, sortidx) = sort(curoutputs, 0);
-      sorttgt = index_select(targetbuffer, 0, sortidx);
-
-      // compue true positive sums, and precision:
-      truepos = cumsum(targetbuffer,0);  // NOTE: Cast to double first?
-      precision = div(truepos, range);
-      double * precision_d = precision.data<double>();
-      // compute average precision:
-      val_d[k] = .0;
-      for(uint64_t n = 0; n < precision.size(0); ++n) {
-         if(targetbuffer_d[n] != 0.)
-            val_d[k] += precision_d[n];
+   // the classes are sorted and summed independently, in parallel:
+   parallel_for(0, nclasses, 1, [&](int64_t begin, int64_t end) {
+      std::vector<int64_t> order(n);
+      for(int64_t k = begin; k < end; ++k) {
+
+         // sort scores in decreasing order:
+         std::iota(order.begin(), order.end(), 0);
+         std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+            return outputs_d[a * nclasses + k] > outputs_d[b * nclasses + k];
+         });
+
+         // sum the precision at each positive:
+         double truepos = 0., sumprecision = 0.;
+         for(int64_t r = 0; r < n; ++r) {
+            if(targets_d[order[r] * nclasses + k] != 0.) {
+               truepos += 1.;
+               sumprecision += truepos / (r + 1);
+            }
+         }
+         val_d[k] = truepos > 0 ? sumprecision / truepos : 0.;
       }
-      auto norm = sum(targetbuffer).toCDouble();
-      if(norm > 0)
-        val_d[k] /= norm;
-   }
+   });
 }
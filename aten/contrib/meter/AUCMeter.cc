@@ -1,5 +1,8 @@
 #include "AUCMeter.h"
 #include "APMeter.h"
+#include <algorithm>
+#include <numeric>
+#include <vector>
 #include <cassert>
 
 using namespace at;
@@ -19,42 +22,37 @@ void AUCMeter::add(Tensor& output, Tensor& target) {
 void AUCMeter::value(Tensor& val) {
 
    // get data from APMeter:
-   Tensor outputs = meter_.getOutputs();
-   Tensor targets = meter_.getTargets();
-
-   // sort scores:
-   Tensor sortval, sortidx, sorttgt;
-   std::tie(sortval, sortidx) = sort(outputs, 0, true);
-   sorttgt = index_select(targets, 0, sortidx);
-   int64_t * sortidx_d = sortidx.data<int64_t>();
-   int16_t * targets_d = sortidx.data<int16_t>();
-   // construct the ROC curve:
-   Tensor tpr = zeros(CPU(kDouble), {numel(outputs)});
-   Tensor fpr = zeros(CPU(kDouble), {numel(outputs)});
-
-   double * tpr_d = tpr.data<double>();
-   double * fpr_d = fpr.data<double>();
-   for(uint64_t n = 1; n <= numel(outputs); ++n) {
-      if(targets_d[sortidx_d[n - 1]] == 1) {
-         tpr_d[n] = tpr_d[n - 1] + 1.;
-         fpr_d[n] = fpr_d[n - 1];
-      } else {
-         tpr_d[n] = tpr_d[n - 1];
-         fpr_d[n] = fpr_d[n - 1] + 1.;
+   Tensor outputs = meter_.getOutputs().contiguous().toType(CPU(kDouble));
+   Tensor targets = meter_.getTargets().contiguous().toType(CPU(kDouble));
+   int64_t n = numel(outputs);
+   double * outputs_d = outputs.data<double>();
+   double * targets_d = targets.data<double>();
+
+   // sort scores in decreasing order:
+   std::vector<int64_t> order(n);
+   std::iota(order.begin(), order.end(), 0);
+   std::sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+      return outputs_d[a] > outputs_d[b];
+   });
+
+   // walk down the ROC curve, one group of tied scores at a time, counting
+   // the positives ranked above each negative (ties count for half):
+   double truepos = 0., falsepos = 0., area = 0.;
+   for(int64_t r = 0; r < n;) {
+      double tiedpos = 0., tiedneg = 0.;
+      int64_t s = r;
+      for(; s < n && outputs_d[order[s]] == outputs_d[order[r]]; ++s) {
+         if(targets_d[order[s]] != 0.)
+            tiedpos += 1.;
+         else
+            tiedneg += 1.;
       }
+      area += tiedneg * (truepos + tiedpos / 2.);
+      truepos += tiedpos;
+      falsepos += tiedneg;
+      r = s;
    }
-   tpr.div_(sum(targets));
-   fpr.div_(sum(at::add(mul(targets, -1.), 1.)));
-
-   /**
-   local auc = torch.cmul(
-      tpr:narrow(1, 1, tpr:nElement() - 1),
-      fpr:narrow(1, 2, fpr:nElement() - 1) -
-      fpr:narrow(1, 1, fpr:nElement() - 1)):sum()
-   */
-
-   val.resize_({1}).fill_(
-     sum(mul(tpr.narrow(0, 0, numel(tpr) - 1),
-                sub(fpr.narrow(0, 1, numel(tpr) - 1),
-                     fpr.narrow(0, 0, numel(tpr) - 1)))));
+
+   double auc = (truepos > 0 && falsepos > 0) ? area / (truepos * falsepos) : 0.;
+   val.resize_({1}).fill_(auc);
 }
@@ -0,0 +1,33 @@
+#include "BinnedAPMeter.h"
+#include "ATen/ATen.h"
+
+using namespace at;
+
+BinnedAPMeter::BinnedAPMeter(int64_t nclasses)
+   : BinnedMeter(nclasses, 10000, 0., 1.) {
+}
+
+BinnedAPMeter::BinnedAPMeter(int64_t nclasses, int64_t nbins, double minscore, double maxscore)
+   : BinnedMeter(nclasses, nbins, minscore, maxscore) {
+}
+
+void BinnedAPMeter::value(Tensor& val) {
+   val.resize_({nclasses_});
+   double * val_d = val.data<double>();
+   double * positives_d = positives_.data<double>();
+   double * negatives_d = negatives_.data<double>();
+
+   // walk down the scores, adding the precision at each bin with positives:
+   for(int64_t k = 0; k < nclasses_; ++k) {
+      double * pos = positives_d + k * nbins_;
+      double * neg = negatives_d + k * nbins_;
+      double truepos = 0., falsepos = 0., sumprecision = 0.;
+      for(int64_t b = nbins_ - 1; b >= 0; --b) {
+         truepos += pos[b];
+         falsepos += neg[b];
+         if(pos[b] > 0)
+            sumprecision += pos[b] * truepos / (truepos + falsepos);
+      }
+      val_d[k] = truepos > 0 ? sumprecision / truepos : 0.;
+   }
+}
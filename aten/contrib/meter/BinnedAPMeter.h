@@ -0,0 +1,18 @@
+#ifndef AT_BINNED_AP_METER_H
+#define AT_BINNED_AP_METER_H
+
+#include "BinnedMeter.h"
+#include "ATen/ATen.h"
+
+// Average precision of each class, computed from score histograms (see
+// BinnedMeter). The precision of the positives of a bin is the one after the
+// whole bin, so ties are ranked pessimistically.
+class BinnedAPMeter : public BinnedMeter
+{
+public:
+   BinnedAPMeter(int64_t nclasses);
+   BinnedAPMeter(int64_t nclasses, int64_t nbins, double minscore, double maxscore);
+   virtual void value(Tensor& val);
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include "BinnedAUCMeter.h"
+#include "ATen/ATen.h"
+
+using namespace at;
+
+BinnedAUCMeter::BinnedAUCMeter(int64_t nclasses)
+   : BinnedMeter(nclasses, 10000, 0., 1.) {
+}
+
+BinnedAUCMeter::BinnedAUCMeter(int64_t nclasses, int64_t nbins, double minscore, double maxscore)
+   : BinnedMeter(nclasses, nbins, minscore, maxscore) {
+}
+
+void BinnedAUCMeter::value(Tensor& val) {
+   val.resize_({nclasses_});
+   double * val_d = val.data<double>();
+   double * positives_d = positives_.data<double>();
+   double * negatives_d = negatives_.data<double>();
+
+   // walk down the scores, counting the positives ranked above each negative:
+   for(int64_t k = 0; k < nclasses_; ++k) {
+      double * pos = positives_d + k * nbins_;
+      double * neg = negatives_d + k * nbins_;
+      double truepos = 0., falsepos = 0., area = 0.;
+      for(int64_t b = nbins_ - 1; b >= 0; --b) {
+         area += neg[b] * (truepos + pos[b] / 2.);
+         truepos += pos[b];
+         falsepos += neg[b];
+      }
+      val_d[k] = (truepos > 0 && falsepos > 0) ? area / (truepos * falsepos) : 0.;
+   }
+}
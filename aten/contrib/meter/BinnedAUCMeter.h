@@ -0,0 +1,18 @@
+#ifndef AT_BINNED_AUC_METER_H
+#define AT_BINNED_AUC_METER_H
+
+#include "BinnedMeter.h"
+#include "ATen/ATen.h"
+
+// Area under the ROC curve of each class, computed from score histograms
+// (see BinnedMeter). Examples in the same bin count as ties, i.e. half
+// correctly ranked.
+class BinnedAUCMeter : public BinnedMeter
+{
+public:
+   BinnedAUCMeter(int64_t nclasses);
+   BinnedAUCMeter(int64_t nclasses, int64_t nbins, double minscore, double maxscore);
+   virtual void value(Tensor& val);
+};
+
+#endif
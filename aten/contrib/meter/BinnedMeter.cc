@@ -0,0 +1,74 @@
+#include "BinnedMeter.h"
+#include "ATen/ATen.h"
+#include "ATen/Parallel.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace at;
+
+BinnedMeter::BinnedMeter(int64_t nclasses, int64_t nbins, double minscore, double maxscore) {
+   assert(nclasses > 0 && nbins > 0 && maxscore > minscore);
+   nclasses_ = nclasses;
+   nbins_ = nbins;
+   minscore_ = minscore;
+   maxscore_ = maxscore;
+   positives_ = zeros(CPU(kDouble), {nclasses_, nbins_});
+   negatives_ = zeros(CPU(kDouble), {nclasses_, nbins_});
+}
+
+void BinnedMeter::reset() {
+   positives_.zero_();
+   negatives_.zero_();
+}
+
+void BinnedMeter::add(Tensor& output, Tensor& target) {
+
+   // assertions:
+   assert(output.dim() == 1 || output.dim() == 2);
+   assert(output.dim() == target.dim());
+   int64_t n = output.size(0);
+   assert(target.size(0) == n);
+   assert((output.dim() == 1 ? 1 : output.size(1)) == nclasses_);
+
+   // get scores and targets as doubles:
+   Tensor outputs = output.contiguous().toType(CPU(kDouble));
+   Tensor targets = target.contiguous().toType(CPU(kDouble));
+   double * outputs_d = outputs.data<double>();
+   double * targets_d = targets.data<double>();
+   double * positives_d = positives_.data<double>();
+   double * negatives_d = negatives_.data<double>();
+
+   // each class has its own histograms, so they can be filled in parallel:
+   double scale = nbins_ / (maxscore_ - minscore_);
+   int64_t grainsize = std::max<int64_t>(1, internal::TBB_GRAIN_SIZE / std::max<int64_t>(n, 1));
+   parallel_for(0, nclasses_, grainsize, [&](int64_t begin, int64_t end) {
+      for(int64_t k = begin; k < end; ++k) {
+         double * pos = positives_d + k * nbins_;
+         double * neg = negatives_d + k * nbins_;
+         for(int64_t i = 0; i < n; ++i) {
+            double bin = std::floor((outputs_d[i * nclasses_ + k] - minscore_) * scale);
+            int64_t b = (int64_t) std::min<double>(std::max<double>(bin, 0.), nbins_ - 1);
+            if(targets_d[i * nclasses_ + k] != 0.)
+               pos[b] += 1.;
+            else
+               neg[b] += 1.;
+         }
+      }
+   });
+}
+
+void BinnedMeter::merge(BinnedMeter& other) {
+   assert(other.nclasses_ == nclasses_ && other.nbins_ == nbins_);
+   assert(other.minscore_ == minscore_ && other.maxscore_ == maxscore_);
+   positives_.add_(other.positives_);
+   negatives_.add_(other.negatives_);
+}
+
+Tensor& BinnedMeter::positives() {
+   return positives_;
+}
+
+Tensor& BinnedMeter::negatives() {
+   return negatives_;
+}
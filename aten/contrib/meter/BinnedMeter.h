@@ -0,0 +1,36 @@
+#ifndef AT_BINNED_METER_H
+#define AT_BINNED_METER_H
+
+#include "Meter.h"
+#include "ATen/ATen.h"
+
+// Base of the meters that approximate ranking metrics from histograms of the
+// scores of the positive and negative examples of each class, instead of
+// keeping and sorting all of them. Memory is bounded by nclasses * nbins, and
+// the value only depends on the counts, so the meters of several threads or
+// processes can be combined by adding their histograms: with merge(), or by
+// summing positives() and negatives() across ranks (e.g. with an all-reduce).
+//
+// Scores are binned uniformly over [minscore, maxscore], scores outside of it
+// fall in the first or last bin. Examples within a bin count as ties, so the
+// error of the approximation shrinks as the number of bins grows.
+class BinnedMeter : public Meter
+{
+public:
+   BinnedMeter(int64_t nclasses, int64_t nbins, double minscore, double maxscore);
+   // output and target are of size N x nclasses, or N if nclasses is 1
+   virtual void add(Tensor& output, Tensor& target);
+   virtual void reset();
+   virtual void merge(BinnedMeter& other);
+   virtual Tensor& positives();
+   virtual Tensor& negatives();
+protected:
+   int64_t nclasses_;
+   int64_t nbins_;
+   double minscore_;
+   double maxscore_;
+   Tensor positives_;  // nclasses x nbins counts, as doubles
+   Tensor negatives_;
+};
+
+#endif
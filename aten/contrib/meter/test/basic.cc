@@ -1,4 +1,5 @@
 #include "APMeter.h"
+#include "BinnedAPMeter.h"
 #include <iostream>
 
 using namespace at;
@@ -21,5 +22,17 @@ int main()
    Tensor val;
    meter.value(val);
    std::cout << "value: " << val << std::endl;
+
+   // the binned approximation on sigmoid scores, merged from two halves:
+   Tensor scores = sigmoid(output);
+   BinnedAPMeter first(7), second(7);
+   Tensor firsthalf = scores.narrow(0, 0, 5), secondhalf = scores.narrow(0, 5, 5);
+   Tensor firsttargets = target.narrow(0, 0, 5), secondtargets = target.narrow(0, 5, 5);
+   first.add(firsthalf, firsttargets);
+   second.add(secondhalf, secondtargets);
+   first.merge(second);
+   Tensor binnedval = CPU(kDouble).tensor();
+   first.value(binnedval);
+   std::cout << "binned value: " << binnedval << std::endl;
    return 0;
 }
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <initializer_list>
 #include <sstream>
+#include <vector>
+#include "ATen/Parallel.h"
 #include "ATen/TensorUtils.h"
 
 namespace at {
@@ -307,4 +311,304 @@ void CPU_tensor_apply4(Tensor tensor1, Tensor tensor2, Tensor tensor3, Tensor te
   CPU_tensor_apply4_dim<scalar1, scalar2, scalar3, scalar4, Op>(tensor1, tensor2, tensor3, tensor4, -1, op);
 }
 
+/*
+ * The parallel variants below split the linear index space [0, numel) into
+ * chunks of at least internal::TBB_GRAIN_SIZE elements with parallel_for. Every
+ * chunk maps its first index back to an offset into the storage of each tensor
+ * and walks the tensors in spans: runs of elements that are equally spaced in
+ * all of them, so that the inner loop is a plain strided (or contiguous) loop.
+ *
+ * The op must be safe to call concurrently on different elements, e.g. it may
+ * not draw from a shared random number generator.
+ */
+namespace detail {
+
+// Walks the elements of a tensor in the order of its linear index, from any
+// starting index. Dimensions of size 1 are dropped and neighbouring dimensions
+// that can be walked as one are merged.
+template <typename scalar_t>
+class StridedTensorIter {
+ public:
+  // If unit_stride_spans is set, span() is 1 wherever the innermost dimension
+  // is not contiguous, so that all spans are contiguous.
+  StridedTensorIter(const Tensor& tensor, bool unit_stride_spans)
+    : base_(tensor.data<scalar_t>()), data_(base_) {
+    for (int64_t d = tensor.dim() - 1; d >= 0; d--) {
+      int64_t size = tensor.sizes()[d];
+      int64_t stride = tensor.strides()[d];
+      if (size == 1) {
+        continue;
+      }
+      if (!sizes_.empty() && stride == sizes_.back() * strides_.back()) {
+        sizes_.back() *= size;
+      } else {
+        sizes_.push_back(size);
+        strides_.push_back(stride);
+      }
+    }
+    if (sizes_.empty()) {
+      sizes_.push_back(1);
+      strides_.push_back(1);
+    }
+    // Dimensions are kept innermost first
+    index_.assign(sizes_.size(), 0);
+    unit_stride_spans_ = unit_stride_spans && strides_[0] != 1;
+  }
+
+  void seek(int64_t linear) {
+    data_ = base_;
+    for (size_t d = 0; d != sizes_.size(); d++) {
+      index_[d] = linear % sizes_[d];
+      linear /= sizes_[d];
+      data_ += index_[d] * strides_[d];
+    }
+  }
+
+  // Number of elements from the current one that are stride() apart
+  int64_t span() const {
+    return unit_stride_spans_ ? 1 : sizes_[0] - index_[0];
+  }
+
+  int64_t stride() const {
+    return strides_[0];
+  }
+
+  scalar_t* data() const {
+    return data_;
+  }
+
+  // Moves n <= span() elements forward, carrying over into the outer
+  // dimensions
+  void advance(int64_t n) {
+    index_[0] += n;
+    data_ += n * strides_[0];
+    for (size_t d = 0; d + 1 < sizes_.size() && index_[d] == sizes_[d]; d++) {
+      data_ += strides_[d + 1] - sizes_[d] * strides_[d];
+      index_[d] = 0;
+      index_[d + 1]++;
+    }
+  }
+
+ private:
+  scalar_t* base_;
+  scalar_t* data_;
+  std::vector<int64_t> sizes_;
+  std::vector<int64_t> strides_;
+  std::vector<int64_t> index_;
+  bool unit_stride_spans_;
+};
+
+// Evaluates its arguments, in order, for their side effects, to apply an
+// expression to every element of a parameter pack
+inline void for_each_arg(std::initializer_list<int>) {}
+
+template <typename Op, typename... Iters>
+void apply_spans(int64_t begin, int64_t end, const Op& op, Iters... iters) {
+  for_each_arg({(iters.seek(begin), 0)...});
+  while (begin < end) {
+    int64_t n = end - begin;
+    for_each_arg({(n = std::min(n, iters.span()), 0)...});
+    op(n, iters...);
+    for_each_arg({(iters.advance(n), 0)...});
+    begin += n;
+  }
+}
+
+inline void check_same_numel(const char* name, TensorList tensors) {
+  for (const auto& tensor : tensors) {
+    if (tensor.numel() != tensors[0].numel()) {
+      std::ostringstream oss;
+      oss << name << ": inconsistent tensor size, expected the tensors of sizes";
+      for (const auto& t : tensors) {
+        oss << " " << t.sizes();
+      }
+      oss << " to have the same number of elements";
+      throw std::runtime_error(oss.str());
+    }
+  }
+}
+
+template <typename Op, typename... Iters>
+void parallel_apply_spans(int64_t numel, const Op& op, Iters... iters) {
+  parallel_for(0, numel, internal::TBB_GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+    apply_spans(begin, end, op, iters...);
+  });
+}
+
+} // namespace detail
+
+/*
+  Parallel counterparts of CPU_tensor_apply1..4, with the same calling
+  convention for op. The tensors are visited in parallel chunks, so op must not
+  depend on the order in which the elements are visited.
+*/
+template <typename scalar1, typename Op>
+void CPU_tensor_parallel_apply1(Tensor tensor1, const Op op) {
+  checkBackend("CPU_tensor_parallel_apply1", {tensor1}, Backend::CPU);
+  detail::parallel_apply_spans(
+      tensor1.numel(),
+      [&](int64_t n, detail::StridedTensorIter<scalar1>& it1) {
+        scalar1* data1 = it1.data();
+        int64_t stride1 = it1.stride();
+        if (stride1 == 1) {
+          for (int64_t i = 0; i < n; i++) {
+            op(data1[i]);
+          }
+        } else {
+          for (int64_t i = 0; i < n; i++) {
+            op(data1[i * stride1]);
+          }
+        }
+      },
+      detail::StridedTensorIter<scalar1>(tensor1, false));
+}
+
+template <typename scalar1, typename scalar2, typename Op>
+void CPU_tensor_parallel_apply2(Tensor tensor1, Tensor tensor2, const Op op) {
+  checkBackend("CPU_tensor_parallel_apply2", {tensor1, tensor2}, Backend::CPU);
+  detail::check_same_numel("CPU_tensor_parallel_apply2", {tensor1, tensor2});
+  detail::parallel_apply_spans(
+      tensor1.numel(),
+      [&](int64_t n,
+          detail::StridedTensorIter<scalar1>& it1,
+          detail::StridedTensorIter<scalar2>& it2) {
+        scalar1* data1 = it1.data();
+        scalar2* data2 = it2.data();
+        int64_t stride1 = it1.stride();
+        int64_t stride2 = it2.stride();
+        if (stride1 == 1 && stride2 == 1) {
+          for (int64_t i = 0; i < n; i++) {
+            op(data1[i], data2[i]);
+          }
+        } else {
+          for (int64_t i = 0; i < n; i++) {
+            op(data1[i * stride1], data2[i * stride2]);
+          }
+        }
+      },
+      detail::StridedTensorIter<scalar1>(tensor1, false),
+      detail::StridedTensorIter<scalar2>(tensor2, false));
+}
+
+template <typename scalar1, typename scalar2, typename scalar3, typename Op>
+void CPU_tensor_parallel_apply3(Tensor tensor1, Tensor tensor2, Tensor tensor3, const Op op) {
+  checkBackend("CPU_tensor_parallel_apply3", {tensor1, tensor2, tensor3}, Backend::CPU);
+  detail::check_same_numel("CPU_tensor_parallel_apply3", {tensor1, tensor2, tensor3});
+  detail::parallel_apply_spans(
+      tensor1.numel(),
+      [&](int64_t n,
+          detail::StridedTensorIter<scalar1>& it1,
+          detail::StridedTensorIter<scalar2>& it2,
+          detail::StridedTensorIter<scalar3>& it3) {
+        scalar1* data1 = it1.data();
+        scalar2* data2 = it2.data();
+        scalar3* data3 = it3.data();
+        int64_t stride1 = it1.stride();
+        int64_t stride2 = it2.stride();
+        int64_t stride3 = it3.stride();
+        if (stride1 == 1 && stride2 == 1 && stride3 == 1) {
+          for (int64_t i = 0; i < n; i++) {
+            op(data1[i], data2[i], data3[i]);
+          }
+        } else {
+          for (int64_t i = 0; i < n; i++) {
+            op(data1[i * stride1], data2[i * stride2], data3[i * stride3]);
+          }
+        }
+      },
+      detail::StridedTensorIter<scalar1>(tensor1, false),
+      detail::StridedTensorIter<scalar2>(tensor2, false),
+      detail::StridedTensorIter<scalar3>(tensor3, false));
+}
+
+template <typename scalar1, typename scalar2, typename scalar3, typename scalar4, typename Op>
+void CPU_tensor_parallel_apply4(Tensor tensor1, Tensor tensor2, Tensor tensor3, Tensor tensor4, const Op op) {
+  checkBackend("CPU_tensor_parallel_apply4", {tensor1, tensor2, tensor3, tensor4}, Backend::CPU);
+  detail::check_same_numel("CPU_tensor_parallel_apply4", {tensor1, tensor2, tensor3, tensor4});
+  detail::parallel_apply_spans(
+      tensor1.numel(),
+      [&](int64_t n,
+          detail::StridedTensorIter<scalar1>& it1,
+          detail::StridedTensorIter<scalar2>& it2,
+          detail::StridedTensorIter<scalar3>& it3,
+          detail::StridedTensorIter<scalar4>& it4) {
+        scalar1* data1 = it1.data();
+        scalar2* data2 = it2.data();
+        scalar3* data3 = it3.data();
+        scalar4* data4 = it4.data();
+        int64_t stride1 = it1.stride();
+        int64_t stride2 = it2.stride();
+        int64_t stride3 = it3.stride();
+        int64_t stride4 = it4.stride();
+        if (stride1 == 1 && stride2 == 1 && stride3 == 1 && stride4 == 1) {
+          for (int64_t i = 0; i < n; i++) {
+            op(data1[i], data2[i], data3[i], data4[i]);
+          }
+        } else {
+          for (int64_t i = 0; i < n; i++) {
+            op(data1[i * stride1], data2[i * stride2], data3[i * stride3], data4[i * stride4]);
+          }
+        }
+      },
+      detail::StridedTensorIter<scalar1>(tensor1, false),
+      detail::StridedTensorIter<scalar2>(tensor2, false),
+      detail::StridedTensorIter<scalar3>(tensor3, false),
+      detail::StridedTensorIter<scalar4>(tensor4, false));
+}
+
+/*
+  Like CPU_tensor_parallel_apply1..3, but op is called on contiguous spans of
+  all the tensors, so that it can be vectorized. For example, to compute
+  a = b + c:
+  [](int64_t n, scalar* a, const scalar* b, const scalar* c) {
+    for (int64_t i = 0; i < n; i++) {
+      a[i] = b[i] + c[i];
+    }
+  };
+  Where the innermost dimension of a tensor is not contiguous, op is called one
+  element at a time, so this is only worth it for tensors that mostly are.
+*/
+template <typename scalar1, typename Op>
+void CPU_tensor_parallel_kernel_apply1(Tensor tensor1, const Op op) {
+  checkBackend("CPU_tensor_parallel_kernel_apply1", {tensor1}, Backend::CPU);
+  detail::parallel_apply_spans(
+      tensor1.numel(),
+      [&](int64_t n, detail::StridedTensorIter<scalar1>& it1) {
+        op(n, it1.data());
+      },
+      detail::StridedTensorIter<scalar1>(tensor1, true));
+}
+
+template <typename scalar1, typename scalar2, typename Op>
+void CPU_tensor_parallel_kernel_apply2(Tensor tensor1, Tensor tensor2, const Op op) {
+  checkBackend("CPU_tensor_parallel_kernel_apply2", {tensor1, tensor2}, Backend::CPU);
+  detail::check_same_numel("CPU_tensor_parallel_kernel_apply2", {tensor1, tensor2});
+  detail::parallel_apply_spans(
+      tensor1.numel(),
+      [&](int64_t n,
+          detail::StridedTensorIter<scalar1>& it1,
+          detail::StridedTensorIter<scalar2>& it2) {
+        op(n, it1.data(), it2.data());
+      },
+      detail::StridedTensorIter<scalar1>(tensor1, true),
+      detail::StridedTensorIter<scalar2>(tensor2, true));
+}
+
+template <typename scalar1, typename scalar2, typename scalar3, typename Op>
+void CPU_tensor_parallel_kernel_apply3(Tensor tensor1, Tensor tensor2, Tensor tensor3, const Op op) {
+  checkBackend("CPU_tensor_parallel_kernel_apply3", {tensor1, tensor2, tensor3}, Backend::CPU);
+  detail::check_same_numel("CPU_tensor_parallel_kernel_apply3", {tensor1, tensor2, tensor3});
+  detail::parallel_apply_spans(
+      tensor1.numel(),
+      [&](int64_t n,
+          detail::StridedTensorIter<scalar1>& it1,
+          detail::StridedTensorIter<scalar2>& it2,
+          detail::StridedTensorIter<scalar3>& it3) {
+        op(n, it1.data(), it2.data(), it3.data());
+      },
+      detail::StridedTensorIter<scalar1>(tensor1, true),
+      detail::StridedTensorIter<scalar2>(tensor2, true),
+      detail::StridedTensorIter<scalar3>(tensor3, true));
+}
+
 }
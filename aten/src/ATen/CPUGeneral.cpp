@@ -1,5 +1,9 @@
 #include <ATen/CPUGeneral.h>
+#include <ATen/Error.h>
+#include <TH/TH.h>
 #include <atomic>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <thread>
 
@@ -10,7 +14,40 @@ std::atomic<int> num_threads(-1);
 void set_num_threads(int num_threads_) {
   if (num_threads_ >= 0)
     num_threads.store(num_threads_);
+  // Keeps the OpenMP loops of TH on the same number of threads.
+  if (num_threads_ > 0)
+    THSetNumThreads(num_threads_);
 }
 
 int get_num_threads() { return num_threads.load(); }
+
+static ParallelBackend default_parallel_backend() {
+  const char* name = std::getenv("ATEN_PARALLEL_BACKEND");
+  if (!name || std::strcmp(name, "tbb") == 0) {
+    return ParallelBackend::TBB;
+  } else if (std::strcmp(name, "openmp") == 0) {
+    return ParallelBackend::OpenMP;
+  } else if (std::strcmp(name, "native") == 0) {
+    return ParallelBackend::Native;
+  }
+  AT_ERROR("ATEN_PARALLEL_BACKEND must be tbb, openmp or native, got %s", name);
+}
+
+static std::atomic<int>& parallel_backend() {
+  static std::atomic<int> backend(static_cast<int>(default_parallel_backend()));
+  return backend;
+}
+
+void set_parallel_backend(ParallelBackend backend) {
+#ifndef _OPENMP
+  if (backend == ParallelBackend::OpenMP) {
+    AT_ERROR("ATen was built without OpenMP");
+  }
+#endif
+  parallel_backend().store(static_cast<int>(backend));
+}
+
+ParallelBackend get_parallel_backend() {
+  return static_cast<ParallelBackend>(parallel_backend().load());
+}
 }
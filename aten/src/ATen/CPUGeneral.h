@@ -7,6 +7,16 @@
 #include "ATen/ATenGeneral.h"
 
 namespace at {
+// The number of threads used by the parallel CPU kernels of ATen and by the
+// OpenMP loops of TH. Negative (the default) means one per core.
 AT_API void set_num_threads(int);
 AT_API int get_num_threads();
+
+// The library parallel_for and parallel_reduce in ATen/Parallel.h run on.
+// Native is a thread pool owned by ATen. The default is TBB, or the value of
+// the ATEN_PARALLEL_BACKEND environment variable ("tbb", "openmp" or
+// "native") if it is set.
+enum class ParallelBackend { TBB, OpenMP, Native };
+AT_API void set_parallel_backend(ParallelBackend);
+AT_API ParallelBackend get_parallel_backend();
 }
@@ -97,6 +97,14 @@ bool Context::hasMKL() const {
 #endif
 }
 
+bool Context::hasMKLDNN() const {
+#if AT_MKLDNN_ENABLED()
+  return true;
+#else
+  return false;
+#endif
+}
+
 bool Context::hasCUDA() const {
 #if AT_CUDA_ENABLED()
   int count;
@@ -114,6 +122,9 @@ bool Context::hasCUDA() const {
 cudaStream_t Context::getCurrentCUDAStream() const {
   return THCState_getCurrentStream(thc_state);
 }
+THCStream* Context::getCUDAStreamFromPool(int device, bool high_priority) const {
+  return THCStream_getPoolStream(device, high_priority);
+}
 struct cudaDeviceProp* Context::getCurrentDeviceProperties() const {
   return THCState_getCurrentDeviceProperties(thc_state);
 }
@@ -124,6 +135,9 @@ struct cudaDeviceProp* Context::getDeviceProperties(int device) const {
 cudaStream_t Context::getCurrentCUDAStream() const {
   throw std::runtime_error("ATen not compiled with CUDA");
 }
+THCStream* Context::getCUDAStreamFromPool(int device, bool high_priority) const {
+  throw std::runtime_error("ATen not compiled with CUDA");
+}
 struct cudaDeviceProp* Context::getCurrentDeviceProperties() const {
   throw std::runtime_error("ATen not compiled with CUDA");
 }
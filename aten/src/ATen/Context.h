@@ -14,6 +14,7 @@
 // Forwarde declare these CUDA types here to avoid including CUDA headers in
 // ATen headers, which would make ATen always require CUDA to build.
 struct THCState;
+struct THCStream;
 struct CUstream_st;
 typedef struct CUstream_st *cudaStream_t;
 struct cudaDeviceProp;
@@ -45,6 +46,7 @@ public:
     return *generator;
   }
   bool hasMKL() const;
+  bool hasMKLDNN() const;
   bool hasCUDA() const;
   int64_t current_device() const;
   // defined in header so that getType has ability to inline
@@ -57,6 +59,9 @@ public:
   }
 
   cudaStream_t getCurrentCUDAStream() const;
+  // One of the streams of a per-device pool of high or low priority streams,
+  // see THCStream_getPoolStream. The caller owns the returned reference.
+  THCStream* getCUDAStreamFromPool(int device, bool high_priority) const;
   cudaDeviceProp* getCurrentDeviceProperties() const;
   cudaDeviceProp* getDeviceProperties(int device) const;
 
@@ -124,6 +129,10 @@ static inline bool hasMKL() {
   return globalContext().hasMKL();
 }
 
+static inline bool hasMKLDNN() {
+  return globalContext().hasMKLDNN();
+}
+
 static inline int64_t current_device() {
   return globalContext().current_device();
 }
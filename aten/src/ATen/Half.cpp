@@ -32,6 +32,13 @@ template<> AT_API int64_t convert(Half f) {
   return static_cast<int64_t>(convert<double,Half>(f));
 }
 
+void convert(const Half* src, float* dst, int64_t n) {
+  THFloatVector_fromHalf(dst, reinterpret_cast<const THHalf*>(src), n);
+}
+void convert(const float* src, Half* dst, int64_t n) {
+  THFloatVector_toHalf(reinterpret_cast<THHalf*>(dst), src, n);
+}
+
 template<> bool overflows<Half, double>(double f) {
   return f > 65504 || f < -65504;
 }
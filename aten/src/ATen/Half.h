@@ -57,6 +57,10 @@ template<> AT_API double convert(Half f);
 template<> AT_API Half convert(int64_t f);
 template<> AT_API int64_t convert(Half f);
 
+// Converts n values at once, with the F16C instructions when the CPU has them
+AT_API void convert(const Half* src, float* dst, int64_t n);
+AT_API void convert(const float* src, Half* dst, int64_t n);
+
 inline Half::operator double() {
   return convert<double, Half>(*this);
 }
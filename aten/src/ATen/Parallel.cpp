@@ -4,9 +4,18 @@
 #include <tbb/parallel_reduce.h>
 #include <tbb/partitioner.h>
 #include <tbb/tbb.h>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <thread>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace at { namespace internal {
 
 // thread_local variable with internal linkage
@@ -51,4 +60,231 @@ void init_tbb_num_threads() {
     num_threads_ = num_threads;
   }
 }
+
+namespace {
+
+// Whether the current thread is running a chunk of an OpenMP or native
+// parallel_for, in which case nested ones run serially.
+thread_local bool in_parallel_region = false;
+
+struct ParallelRegionGuard {
+  ParallelRegionGuard() : previous(in_parallel_region) {
+    in_parallel_region = true;
+  }
+  ~ParallelRegionGuard() {
+    in_parallel_region = previous;
+  }
+  bool previous;
+};
+
+int num_threads_to_use() {
+  int num_threads = at::get_num_threads();
+  if (num_threads < 0) {
+    num_threads = std::thread::hardware_concurrency();
+  }
+  return std::max(num_threads, 1);
+}
+
+// A fixed set of worker threads that, together with the calling thread, run
+// the chunks of one parallel_for at a time.
+class ThreadPool {
+ public:
+  explicit ThreadPool(int num_threads) : num_threads_(num_threads) {
+    for (int i = 1; i < num_threads; i++) {
+      workers_.emplace_back([this] { work(); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  int num_threads() const {
+    return num_threads_;
+  }
+
+  // Runs task(i) for i in [0, num_tasks) and returns when all are done, or
+  // returns false without running anything if the pool is busy with another
+  // caller's tasks. The first exception thrown by a task is rethrown here.
+  bool run(int64_t num_tasks, const std::function<void(int64_t)>& task) {
+    std::unique_lock<std::mutex> run_lock(run_mutex_, std::try_to_lock);
+    if (!run_lock.owns_lock()) {
+      return false;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      task_ = &task;
+      num_tasks_ = num_tasks;
+      next_task_ = 0;
+      pending_ = num_tasks;
+      error_ = nullptr;
+      generation_++;
+    }
+    wake_.notify_all();
+    run_tasks();
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return pending_ == 0; });
+    task_ = nullptr;
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return true;
+  }
+
+ private:
+  void work() {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+      if (stop_) {
+        return;
+      }
+      seen = generation_;
+      lock.unlock();
+      run_tasks();
+      lock.lock();
+    }
+  }
+
+  // Takes tasks of the current run until there are none left.
+  void run_tasks() {
+    ParallelRegionGuard guard;
+    while (true) {
+      int64_t i;
+      const std::function<void(int64_t)>* task;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!task_ || next_task_ == num_tasks_) {
+          return;
+        }
+        i = next_task_++;
+        task = task_;
+      }
+      std::exception_ptr error;
+      try {
+        (*task)(i);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (error && !error_) {
+        error_ = error;
+      }
+      if (--pending_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+
+  const int num_threads_;
+  std::vector<std::thread> workers_;
+  // Held by the caller whose tasks the pool is running.
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  const std::function<void(int64_t)>* task_ = nullptr;
+  int64_t num_tasks_ = 0;
+  int64_t next_task_ = 0;
+  int64_t pending_ = 0;
+  std::exception_ptr error_;
+  uint64_t generation_ = 0;
+  bool stop_ = false;
+};
+
+// The pool for the current number of threads. It is replaced when that
+// changes, and the old one is destroyed once no caller is using it.
+std::shared_ptr<ThreadPool> get_thread_pool(int num_threads) {
+  static std::mutex mutex;
+  static std::shared_ptr<ThreadPool> pool;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!pool || pool->num_threads() != num_threads) {
+    pool = std::make_shared<ThreadPool>(num_threads);
+  }
+  return pool;
+}
+
+// Splits [begin, end) into num_chunks chunks of nearly the same size.
+void run_chunk(
+    int64_t begin,
+    int64_t end,
+    int64_t num_chunks,
+    int64_t chunk,
+    const std::function<void(int64_t, int64_t)>& f) {
+  int64_t n = end - begin;
+  int64_t chunk_begin = begin + n * chunk / num_chunks;
+  int64_t chunk_end = begin + n * (chunk + 1) / num_chunks;
+  f(chunk_begin, chunk_end);
+}
+
+} // namespace
+
+void parallel_run(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& f) {
+  ParallelBackend backend = get_parallel_backend();
+  if (backend != ParallelBackend::TBB && in_parallel_region) {
+    f(begin, end);
+    return;
+  }
+  grain_size = std::max<int64_t>(grain_size, 1);
+  int64_t max_chunks = (end - begin + grain_size - 1) / grain_size;
+  switch (backend) {
+#ifdef _OPENMP
+    case ParallelBackend::OpenMP: {
+      int64_t num_chunks = std::min<int64_t>(num_threads_to_use(), max_chunks);
+      std::exception_ptr error;
+      #pragma omp parallel for num_threads(num_chunks) schedule(static, 1)
+      for (int64_t chunk = 0; chunk < num_chunks; chunk++) {
+        ParallelRegionGuard guard;
+        try {
+          run_chunk(begin, end, num_chunks, chunk, f);
+        } catch (...) {
+          #pragma omp critical
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+      }
+      if (error) {
+        std::rethrow_exception(error);
+      }
+      return;
+    }
+#endif
+    case ParallelBackend::Native: {
+      int num_threads = num_threads_to_use();
+      int64_t num_chunks = std::min<int64_t>(num_threads, max_chunks);
+      if (num_chunks > 1) {
+        auto pool = get_thread_pool(num_threads);
+        bool ran = pool->run(num_chunks, [&](int64_t chunk) {
+          run_chunk(begin, end, num_chunks, chunk, f);
+        });
+        if (ran) {
+          return;
+        }
+      }
+      // One thread, or the pool is busy with another caller's loop.
+      f(begin, end);
+      return;
+    }
+    default:
+      init_tbb_num_threads();
+      tbb::parallel_for(
+          tbb::blocked_range<int64_t>(begin, end, grain_size),
+          [&f](const tbb::blocked_range<int64_t>& r) { f(r.begin(), r.end()); });
+      return;
+  }
+}
+
 }} // namespace at::internal
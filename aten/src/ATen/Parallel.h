@@ -1,7 +1,10 @@
 #pragma once
 #include <ATen/ATen.h>
-#include <tbb/tbb.h>
+#include <algorithm>
 #include <cstddef>
+#include <functional>
+#include <numeric>
+#include <vector>
 
 namespace at {
 namespace internal {
@@ -15,15 +18,65 @@ namespace internal {
 // for a certain number of workers. If there are multiple threads making
 // a request at the size of the maximum number of threads, they will
 // be allocated a number proportional to the other requests.
-void init_tbb_num_threads();
+// parallel_for calls it when the TBB backend is selected.
+AT_API void init_tbb_num_threads();
 // This parameter is heuristically chosen to determine the minimum number of
 // work that warrants paralellism. For example, when summing an array, it is
 // deemed inefficient to parallelise over arrays shorter than 32768. Further,
 // no parallel algorithm (such as parallel_reduce) should split work into
 // smaller than GRAIN_SIZE chunks.
 constexpr int64_t TBB_GRAIN_SIZE = 32768;
+
+// Runs f on chunks of [begin, end) of at least grain_size elements with the
+// backend returned by get_parallel_backend(). Nested calls from inside a
+// chunk run serially unless the backend is TBB.
+AT_API void parallel_run(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& f);
 } // namespace internal
 
+// Calls f(chunk_begin, chunk_end) on disjoint chunks of [begin, end) of about
+// grain_size elements, in parallel if there is more than one chunk.
+template <class F>
+void parallel_for(int64_t begin, int64_t end, int64_t grain_size, const F& f) {
+  if (end - begin <= grain_size) {
+    if (begin < end) {
+      f(begin, end);
+    }
+    return;
+  }
+  internal::parallel_run(begin, end, grain_size, f);
+}
+
+// Reduces [begin, end) by computing f(chunk_begin, chunk_end, ident) over
+// chunks of grain_size elements in parallel and combining the partial results
+// with sf(a, b), in the order of the chunks. The chunks only depend on
+// grain_size, so the result is the same for any number of threads and any
+// backend.
+template <class scalar_t, class F, class SF>
+scalar_t parallel_reduce(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    const scalar_t ident,
+    const F& f,
+    const SF& sf) {
+  if (end - begin <= grain_size) {
+    return begin < end ? f(begin, end, ident) : ident;
+  }
+  int64_t num_chunks = (end - begin + grain_size - 1) / grain_size;
+  std::vector<scalar_t> results(num_chunks, ident);
+  parallel_for(0, num_chunks, 1, [&](int64_t chunk_begin, int64_t chunk_end) {
+    for (int64_t c = chunk_begin; c != chunk_end; c++) {
+      int64_t b = begin + c * grain_size;
+      results[c] = f(b, std::min(end, b + grain_size), ident);
+    }
+  });
+  return std::accumulate(results.begin(), results.end(), ident, sf);
+}
+
 template <class T, template <class> class OP>
 T parallel_reduce(
     T (*f)(const T*, size_t, size_t, T),
@@ -31,23 +84,13 @@ T parallel_reduce(
     size_t start,
     size_t end,
     T init_) {
-  internal::init_tbb_num_threads();
-
-  T result_;
-  static tbb::affinity_partitioner ap;
-  if (end - start < internal::TBB_GRAIN_SIZE) {
-    result_ = f(data, start, end, init_);
-  } else {
-    result_ = tbb::parallel_reduce(
-        tbb::blocked_range<size_t>(start, end, internal::TBB_GRAIN_SIZE),
-        init_,
-        [&data, &f](const tbb::blocked_range<size_t> r, T init) -> T {
-          return f(data, r.begin(), r.end(), init);
-        },
-        OP<T>(),
-        ap);
-  }
-  return result_;
+  return parallel_reduce(
+      start,
+      end,
+      internal::TBB_GRAIN_SIZE,
+      init_,
+      [&](int64_t b, int64_t e, T init) { return f(data, b, e, init); },
+      OP<T>());
 }
 
 template <class T>
@@ -58,35 +101,18 @@ void parallel_reduce_2d(
     size_t numel,
     const T* arr_,
     T* outarr_) {
-  internal::init_tbb_num_threads();
-
-  static tbb::affinity_partitioner ap;
-
   size_t max_i_ =
       (numel && num_rows && num_cols) ? numel / (num_rows * num_cols) : 0;
-  if (numel < internal::TBB_GRAIN_SIZE) {
-    for (size_t i_ = 0; i_ < max_i_; i_++) {
+  int64_t grain = numel < internal::TBB_GRAIN_SIZE ? max_i_ : 1;
+  parallel_for(0, max_i_, grain, [&](int64_t begin, int64_t end) {
+    for (int64_t i_ = begin; i_ < end; i_++) {
       int64_t i = i_ * num_rows * num_cols;
       int64_t i_r = i_ * num_cols;
       const T* arr = arr_ + i;
       T* outarr = outarr_ + i_r;
       f(arr, outarr, num_rows, num_cols);
     }
-  } else {
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(0, max_i_, 1),
-        [&arr_, &outarr_, num_rows, num_cols, &f](
-            const tbb::blocked_range<size_t> r) {
-          for (size_t i_ = r.begin(); i_ < r.end(); i_++) {
-            int64_t i = i_ * num_rows * num_cols;
-            int64_t i_r = i_ * num_cols;
-            const T* arr = arr_ + i;
-            T* outarr = outarr_ + i_r;
-            f(arr, outarr, num_rows, num_cols);
-          }
-        },
-        ap);
-  }
+  });
 }
 
 } // namespace at
@@ -23,6 +23,12 @@ COPY = CodeTemplate("""\
 ${THTensor}_copy${cuda}${src_scalar_name}(${state,}self_->tensor, static_cast<${src_tensor}*>(src.pImpl)->tensor);
 """)
 
+# Copies between tensors of the same CPU type use the generic copy, which has
+# fast paths for contiguous and permuted tensors.
+COPY_SAME_TYPE_CPU = CodeTemplate("""\
+${THTensor}_copy(self_->tensor, static_cast<${src_tensor}*>(src.pImpl)->tensor);
+""")
+
 COPY_ASYNC_CPU = CodeTemplate("""\
 if (non_blocking) {
     ${THTensor}_copyAsyncCPU(${state,}self_->tensor, static_cast<${src_tensor}*>(src.pImpl)->tensor);
@@ -87,7 +93,11 @@ def create_one(env, all_types):
                 copies.append(COPY_ASYNC_CPU.substitute(combined))
             if env['Backend'] == 'CPU' and src_type['Backend'] == 'CUDA':
                 copies.append(COPY_ASYNC_CUDA.substitute(combined))
-        copies.append(COPY.substitute(combined))
+        if env['Backend'] == 'CPU' and src_type['Backend'] == 'CPU' and \
+                env['ScalarType'] == src_type['ScalarType']:
+            copies.append(COPY_SAME_TYPE_CPU.substitute(combined))
+        else:
+            copies.append(COPY.substitute(combined))
 
         copy_body.append(CASE.substitute(combined, copies=copies))
     return FUNCTION.substitute(env, copy_body=copy_body)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cmath>
 #include <cstring>
 
 #if defined(__GNUC__)
@@ -84,6 +85,50 @@ struct Vec256 {
   Vec256<T> sqrt() const {
     return map(std::sqrt);
   }
+  Vec256<T> acos() const {
+    return map(std::acos);
+  }
+  Vec256<T> asin() const {
+    return map(std::asin);
+  }
+  Vec256<T> atan() const {
+    return map(std::atan);
+  }
+  Vec256<T> cosh() const {
+    return map(std::cosh);
+  }
+  Vec256<T> erf() const {
+    return map(std::erf);
+  }
+  Vec256<T> expm1() const {
+    return map(std::expm1);
+  }
+  Vec256<T> frac() const {
+    return map([](T x) -> T { return x - std::trunc(x); });
+  }
+  Vec256<T> log1p() const {
+    return map(std::log1p);
+  }
+  Vec256<T> rsqrt() const {
+    return map([](T x) -> T { return 1 / std::sqrt(x); });
+  }
+  Vec256<T> sigmoid() const {
+    // Written in terms of exp(-|x|) so that it neither overflows nor flushes
+    // the small results for negative x to 0.
+    return map([](T x) -> T {
+      T e = std::exp(-std::abs(x));
+      return (x < 0 ? e : 1) / (1 + e);
+    });
+  }
+  Vec256<T> sinh() const {
+    return map(std::sinh);
+  }
+  Vec256<T> tan() const {
+    return map(std::tan);
+  }
+  Vec256<T> tanh() const {
+    return map(std::tanh);
+  }
 };
 
 template <class T> Vec256<T> operator+(const Vec256<T> &a, const Vec256<T> &b) {
@@ -102,5 +147,41 @@ template <class T> Vec256<T> operator*(const Vec256<T> &a, const Vec256<T> &b) {
   return c;
 }
 
+template <class T> Vec256<T> operator-(const Vec256<T> &a, const Vec256<T> &b) {
+  Vec256<T> c = Vec256<T>();
+  for (int i = 0; i != c.size; i++) {
+    c.values[i] = a.values[i] - b.values[i];
+  }
+  return c;
+}
+
+template <class T> Vec256<T> operator/(const Vec256<T> &a, const Vec256<T> &b) {
+  Vec256<T> c = Vec256<T>();
+  for (int i = 0; i != c.size; i++) {
+    c.values[i] = a.values[i] / b.values[i];
+  }
+  return c;
+}
+
+// Elementwise maximum and minimum. Unlike std::max and std::min these
+// propagate NaN from either argument.
+template <class T> Vec256<T> maximum(const Vec256<T> &a, const Vec256<T> &b) {
+  Vec256<T> c = Vec256<T>();
+  for (int i = 0; i != c.size; i++) {
+    c.values[i] = (a.values[i] > b.values[i] || a.values[i] != a.values[i])
+        ? a.values[i] : b.values[i];
+  }
+  return c;
+}
+
+template <class T> Vec256<T> minimum(const Vec256<T> &a, const Vec256<T> &b) {
+  Vec256<T> c = Vec256<T>();
+  for (int i = 0; i != c.size; i++) {
+    c.values[i] = (a.values[i] < b.values[i] || a.values[i] != a.values[i])
+        ? a.values[i] : b.values[i];
+  }
+  return c;
+}
+
 }
 }
@@ -3,6 +3,8 @@
 #include "intrinsics.h"
 #include "vec256_base.h"
 
+#include <limits>
+
 namespace at {
 namespace vec256 {
 
@@ -53,12 +55,8 @@ public:
     auto mask = _mm256_set1_pd(-0.f);
     return _mm256_andnot_pd(mask, values);
   }
-  Vec256<double> exp() const {
-    return map(std::exp);
-  }
-  Vec256<double> log() const {
-    return map(std::log);
-  }
+  Vec256<double> exp() const;
+  Vec256<double> log() const;
   Vec256<double> sin() const {
     return map(std::sin);
   }
@@ -80,6 +78,33 @@ public:
   Vec256<double> sqrt() const {
     return _mm256_sqrt_pd(values);
   }
+  Vec256<double> acos() const {
+    return map(std::acos);
+  }
+  Vec256<double> asin() const {
+    return map(std::asin);
+  }
+  Vec256<double> atan() const {
+    return map(std::atan);
+  }
+  Vec256<double> cosh() const;
+  Vec256<double> erf() const {
+    return map(std::erf);
+  }
+  Vec256<double> expm1() const;
+  Vec256<double> frac() const {
+    return _mm256_sub_pd(values, trunc());
+  }
+  Vec256<double> log1p() const;
+  Vec256<double> rsqrt() const {
+    return _mm256_div_pd(_mm256_set1_pd(1.), sqrt());
+  }
+  Vec256<double> sigmoid() const;
+  Vec256<double> sinh() const;
+  Vec256<double> tan() const {
+    return map(std::tan);
+  }
+  Vec256<double> tanh() const;
 };
 
 template <>
@@ -92,6 +117,181 @@ Vec256<double> inline operator*(const Vec256<double>& a, const Vec256<double>& b
   return _mm256_mul_pd(a, b);
 }
 
+template <>
+Vec256<double> inline operator-(const Vec256<double>& a, const Vec256<double>& b) {
+  return _mm256_sub_pd(a, b);
+}
+
+template <>
+Vec256<double> inline operator/(const Vec256<double>& a, const Vec256<double>& b) {
+  return _mm256_div_pd(a, b);
+}
+
+// _mm256_max_pd returns its second argument if either is NaN, so a NaN in
+// `a` is put back by or-ing in its unordered mask (all ones is a NaN).
+template <>
+Vec256<double> inline maximum(const Vec256<double>& a, const Vec256<double>& b) {
+  Vec256<double> max = _mm256_max_pd(a, b);
+  Vec256<double> isnan = _mm256_cmp_pd(a, a, _CMP_UNORD_Q);
+  return _mm256_or_pd(max, isnan);
+}
+
+template <>
+Vec256<double> inline minimum(const Vec256<double>& a, const Vec256<double>& b) {
+  Vec256<double> min = _mm256_min_pd(a, b);
+  Vec256<double> isnan = _mm256_cmp_pd(a, a, _CMP_UNORD_Q);
+  return _mm256_or_pd(min, isnan);
+}
+
+// exp and log below follow the double precision Cephes implementations, and
+// the functions built on them use the same identities as the float versions.
+// The trigonometric functions and erf use libm.
+
+static inline __m256d fmadd_pd(__m256d a, __m256d b, __m256d c) {
+  return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+}
+
+static inline __m256d sign_pd(__m256d x) {
+  return _mm256_and_pd(x, _mm256_set1_pd(-0.));
+}
+
+// 2^n for integral n in [-1022, 1023], built from its exponent bits.
+static inline __m256d pow2_pd(__m256d n) {
+  __m128i e = _mm256_cvtpd_epi32(n);
+  e = _mm_slli_epi32(_mm_add_epi32(e, _mm_set1_epi32(1023)), 20);
+  __m128i zero = _mm_setzero_si128();
+  __m256i bits = _mm256_insertf128_si256(
+      _mm256_castsi128_si256(_mm_unpacklo_epi32(zero, e)), _mm_unpackhi_epi32(zero, e), 1);
+  return _mm256_castsi256_pd(bits);
+}
+
+inline Vec256<double> Vec256<double>::exp() const {
+  // exp(x) = 2^n * exp(r) with n = round(x / ln 2) and exp(r) a rational
+  // function of r, applied like in the float version.
+  __m256d x = _mm256_min_pd(_mm256_set1_pd(710.), values);
+  x = _mm256_max_pd(_mm256_set1_pd(-750.), x);
+  __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(1.4426950408889634073599)),
+                              _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  __m256d r = _mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(6.93145751953125E-1)));
+  r = _mm256_sub_pd(r, _mm256_mul_pd(n, _mm256_set1_pd(1.42860682030941723212E-6)));
+  __m256d r2 = _mm256_mul_pd(r, r);
+  __m256d p = _mm256_set1_pd(1.26177193074810590878E-4);
+  p = fmadd_pd(p, r2, _mm256_set1_pd(3.02994407707441961300E-2));
+  p = fmadd_pd(p, r2, _mm256_set1_pd(9.99999999999999999910E-1));
+  p = _mm256_mul_pd(p, r);
+  __m256d q = _mm256_set1_pd(3.00198505138664455042E-6);
+  q = fmadd_pd(q, r2, _mm256_set1_pd(2.52448340349684104192E-3));
+  q = fmadd_pd(q, r2, _mm256_set1_pd(2.27265548208155028766E-1));
+  q = fmadd_pd(q, r2, _mm256_set1_pd(2.00000000000000000009E0));
+  __m256d y = _mm256_div_pd(p, _mm256_sub_pd(q, p));
+  y = fmadd_pd(y, _mm256_set1_pd(2.), _mm256_set1_pd(1.));
+  __m256d n1 = _mm256_floor_pd(_mm256_mul_pd(n, _mm256_set1_pd(0.5)));
+  __m256d n2 = _mm256_sub_pd(n, n1);
+  return _mm256_mul_pd(_mm256_mul_pd(y, pow2_pd(n1)), pow2_pd(n2));
+}
+
+inline Vec256<double> Vec256<double>::log() const {
+  // log(x) = e * ln 2 + log(m) with x = m * 2^e and m in [sqrt(1/2), sqrt(2)),
+  // where log(m) is a rational function of m - 1.
+  __m256d denormal = _mm256_cmp_pd(values, _mm256_set1_pd(std::numeric_limits<double>::min()), _CMP_LT_OQ);
+  __m256d x = _mm256_blendv_pd(values, _mm256_mul_pd(values, _mm256_set1_pd(4503599627370496.)), denormal);
+  __m256d e = _mm256_and_pd(denormal, _mm256_set1_pd(-52.));
+  // The exponent field is in the high 32 bits of each lane.
+  __m256 xs = _mm256_castpd_ps(x);
+  __m128i high = _mm_castps_si128(_mm_shuffle_ps(
+      _mm256_castps256_ps128(xs), _mm256_extractf128_ps(xs, 1), _MM_SHUFFLE(3, 1, 3, 1)));
+  __m128i exponent = _mm_and_si128(_mm_srli_epi32(high, 20), _mm_set1_epi32(0x7ff));
+  e = _mm256_add_pd(e, _mm256_sub_pd(_mm256_cvtepi32_pd(exponent), _mm256_set1_pd(1022.)));
+  __m256d m = _mm256_and_pd(x, _mm256_castsi256_pd(_mm256_set1_epi64x(~0x7ff0000000000000LL)));
+  m = _mm256_or_pd(m, _mm256_set1_pd(0.5));
+  __m256d small = _mm256_cmp_pd(m, _mm256_set1_pd(0.70710678118654752440), _CMP_LT_OQ);
+  e = _mm256_sub_pd(e, _mm256_and_pd(small, _mm256_set1_pd(1.)));
+  m = _mm256_sub_pd(_mm256_add_pd(m, _mm256_and_pd(small, m)), _mm256_set1_pd(1.));
+  __m256d z = _mm256_mul_pd(m, m);
+  __m256d p = _mm256_set1_pd(1.01875663804580931796E-4);
+  p = fmadd_pd(p, m, _mm256_set1_pd(4.97494994976747001425E-1));
+  p = fmadd_pd(p, m, _mm256_set1_pd(4.70579119878881725854E0));
+  p = fmadd_pd(p, m, _mm256_set1_pd(1.44989225341610930846E1));
+  p = fmadd_pd(p, m, _mm256_set1_pd(1.79368678507819816313E1));
+  p = fmadd_pd(p, m, _mm256_set1_pd(7.70838733755885391666E0));
+  __m256d q = _mm256_add_pd(m, _mm256_set1_pd(1.12873587189167450590E1));
+  q = fmadd_pd(q, m, _mm256_set1_pd(4.52279145837532221105E1));
+  q = fmadd_pd(q, m, _mm256_set1_pd(8.29875266912776603211E1));
+  q = fmadd_pd(q, m, _mm256_set1_pd(7.11544750618563894466E1));
+  q = fmadd_pd(q, m, _mm256_set1_pd(2.31251620126765340583E1));
+  __m256d y = _mm256_mul_pd(m, _mm256_div_pd(_mm256_mul_pd(z, p), q));
+  y = fmadd_pd(e, _mm256_set1_pd(-2.121944400546905827679e-4), y);
+  y = fmadd_pd(z, _mm256_set1_pd(-0.5), y);
+  __m256d result = _mm256_add_pd(m, y);
+  result = fmadd_pd(e, _mm256_set1_pd(0.693359375), result);
+
+  __m256d inf = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+  __m256d zero = _mm256_setzero_pd();
+  result = _mm256_blendv_pd(result, _mm256_sub_pd(zero, inf), _mm256_cmp_pd(values, zero, _CMP_EQ_OQ));
+  result = _mm256_blendv_pd(result, _mm256_set1_pd(std::numeric_limits<double>::quiet_NaN()),
+                            _mm256_cmp_pd(values, zero, _CMP_LT_OQ));
+  __m256d passthrough = _mm256_or_pd(_mm256_cmp_pd(values, inf, _CMP_EQ_OQ),
+                                     _mm256_cmp_pd(values, values, _CMP_UNORD_Q));
+  return _mm256_blendv_pd(result, values, passthrough);
+}
+
+inline Vec256<double> Vec256<double>::expm1() const {
+  // Kahan's method for |x| < 1, see the float version.
+  __m256d one = _mm256_set1_pd(1.);
+  Vec256<double> u = exp();
+  __m256d um1 = _mm256_sub_pd(u, one);
+  __m256d result = _mm256_div_pd(_mm256_mul_pd(um1, values), u.log());
+  result = _mm256_blendv_pd(result, values, _mm256_cmp_pd(u, one, _CMP_EQ_OQ));
+  return _mm256_blendv_pd(um1, result, _mm256_cmp_pd(abs(), one, _CMP_LT_OQ));
+}
+
+inline Vec256<double> Vec256<double>::log1p() const {
+  __m256d one = _mm256_set1_pd(1.);
+  Vec256<double> u = _mm256_add_pd(values, one);
+  __m256d result = _mm256_div_pd(_mm256_mul_pd(u.log(), values), _mm256_sub_pd(u, one));
+  __m256d passthrough = _mm256_or_pd(_mm256_cmp_pd(u, one, _CMP_EQ_OQ),
+      _mm256_cmp_pd(values, _mm256_set1_pd(std::numeric_limits<double>::infinity()), _CMP_EQ_OQ));
+  return _mm256_blendv_pd(result, values, passthrough);
+}
+
+inline Vec256<double> Vec256<double>::sigmoid() const {
+  __m256d one = _mm256_set1_pd(1.);
+  __m256d e = Vec256<double>(_mm256_sub_pd(_mm256_setzero_pd(), abs())).exp();
+  __m256d num = _mm256_blendv_pd(one, e, _mm256_cmp_pd(values, _mm256_setzero_pd(), _CMP_LT_OQ));
+  return _mm256_div_pd(num, _mm256_add_pd(one, e));
+}
+
+inline Vec256<double> Vec256<double>::tanh() const {
+  // tanh rounds to 1 in double precision for |x| >= 20.
+  __m256d ax = _mm256_min_pd(_mm256_set1_pd(20.), abs());
+  __m256d t = Vec256<double>(_mm256_add_pd(ax, ax)).expm1();
+  __m256d y = _mm256_div_pd(t, _mm256_add_pd(t, _mm256_set1_pd(2.)));
+  return _mm256_xor_pd(y, sign_pd(values));
+}
+
+inline Vec256<double> Vec256<double>::sinh() const {
+  __m256d ax = abs();
+  __m256d limit = _mm256_set1_pd(20.);
+  __m256d half = _mm256_set1_pd(0.5);
+  __m256d t = Vec256<double>(_mm256_min_pd(limit, ax)).expm1();
+  __m256d small = _mm256_mul_pd(half, _mm256_add_pd(t, _mm256_div_pd(t, _mm256_add_pd(t, _mm256_set1_pd(1.)))));
+  __m256d h = Vec256<double>(_mm256_mul_pd(half, ax)).exp();
+  __m256d big = _mm256_mul_pd(_mm256_mul_pd(half, h), h);
+  __m256d y = _mm256_blendv_pd(small, big, _mm256_cmp_pd(ax, limit, _CMP_GT_OQ));
+  return _mm256_xor_pd(y, sign_pd(values));
+}
+
+inline Vec256<double> Vec256<double>::cosh() const {
+  __m256d ax = abs();
+  __m256d limit = _mm256_set1_pd(20.);
+  __m256d half = _mm256_set1_pd(0.5);
+  __m256d e = Vec256<double>(_mm256_min_pd(limit, ax)).exp();
+  __m256d small = _mm256_mul_pd(half, _mm256_add_pd(e, _mm256_div_pd(_mm256_set1_pd(1.), e)));
+  __m256d h = Vec256<double>(_mm256_mul_pd(half, ax)).exp();
+  __m256d big = _mm256_mul_pd(_mm256_mul_pd(half, h), h);
+  return _mm256_blendv_pd(small, big, _mm256_cmp_pd(ax, limit, _CMP_GT_OQ));
+}
+
 #endif
 
 }}
@@ -3,6 +3,8 @@
 #include "intrinsics.h"
 #include "vec256_base.h"
 
+#include <limits>
+
 namespace at {
 namespace vec256 {
 
@@ -53,18 +55,10 @@ public:
     auto mask = _mm256_set1_ps(-0.f);
     return _mm256_andnot_ps(mask, values);
   }
-  Vec256<float> exp() const {
-    return map(std::exp);
-  }
-  Vec256<float> log() const {
-    return map(std::log);
-  }
-  Vec256<float> sin() const {
-    return map(std::sin);
-  }
-  Vec256<float> cos() const {
-    return map(std::cos);
-  }
+  Vec256<float> exp() const;
+  Vec256<float> log() const;
+  Vec256<float> sin() const;
+  Vec256<float> cos() const;
   Vec256<float> ceil() const {
     return _mm256_ceil_ps(values);
   }
@@ -80,6 +74,23 @@ public:
   Vec256<float> sqrt() const {
     return _mm256_sqrt_ps(values);
   }
+  Vec256<float> acos() const;
+  Vec256<float> asin() const;
+  Vec256<float> atan() const;
+  Vec256<float> cosh() const;
+  Vec256<float> erf() const;
+  Vec256<float> expm1() const;
+  Vec256<float> frac() const {
+    return _mm256_sub_ps(values, trunc());
+  }
+  Vec256<float> log1p() const;
+  Vec256<float> rsqrt() const {
+    return _mm256_div_ps(_mm256_set1_ps(1.f), sqrt());
+  }
+  Vec256<float> sigmoid() const;
+  Vec256<float> sinh() const;
+  Vec256<float> tan() const;
+  Vec256<float> tanh() const;
 };
 
 template <>
@@ -92,6 +103,357 @@ Vec256<float> inline operator*(const Vec256<float>& a, const Vec256<float>& b) {
   return _mm256_mul_ps(a, b);
 }
 
+template <>
+Vec256<float> inline operator-(const Vec256<float>& a, const Vec256<float>& b) {
+  return _mm256_sub_ps(a, b);
+}
+
+template <>
+Vec256<float> inline operator/(const Vec256<float>& a, const Vec256<float>& b) {
+  return _mm256_div_ps(a, b);
+}
+
+// _mm256_max_ps returns its second argument if either is NaN, so a NaN in
+// `a` is put back by or-ing in its unordered mask (all ones is a NaN).
+template <>
+Vec256<float> inline maximum(const Vec256<float>& a, const Vec256<float>& b) {
+  Vec256<float> max = _mm256_max_ps(a, b);
+  Vec256<float> isnan = _mm256_cmp_ps(a, a, _CMP_UNORD_Q);
+  return _mm256_or_ps(max, isnan);
+}
+
+template <>
+Vec256<float> inline minimum(const Vec256<float>& a, const Vec256<float>& b) {
+  Vec256<float> min = _mm256_min_ps(a, b);
+  Vec256<float> isnan = _mm256_cmp_ps(a, a, _CMP_UNORD_Q);
+  return _mm256_or_ps(min, isnan);
+}
+
+// The transcendental functions below follow the single precision Cephes
+// implementations: the argument is reduced to a small range, where a
+// polynomial approximates the function, and the result is put back together.
+// Their accuracy against libm is checked in test/unary_ops_test.cpp.
+
+static inline __m256 fmadd_ps(__m256 a, __m256 b, __m256 c) {
+  return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+}
+
+static inline __m256 sign_ps(__m256 x) {
+  return _mm256_and_ps(x, _mm256_set1_ps(-0.f));
+}
+
+// 2^n for integral n in [-126, 127], built from its exponent bits.
+static inline __m256 pow2_ps(__m256 n) {
+  __m256 bits = _mm256_mul_ps(_mm256_add_ps(n, _mm256_set1_ps(127.f)), _mm256_set1_ps(8388608.f));
+  return _mm256_castsi256_ps(_mm256_cvtps_epi32(bits));
+}
+
+inline Vec256<float> Vec256<float>::exp() const {
+  // exp(x) = 2^n * exp(r) with n = round(x / ln 2). ln 2 is split in two so
+  // that r = x - n * ln 2 is exact. 2^n is applied in two halves so that
+  // results that overflow or are denormal come out right.
+  __m256 x = _mm256_min_ps(_mm256_set1_ps(89.f), values);
+  x = _mm256_max_ps(_mm256_set1_ps(-104.f), x);
+  __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+                             _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(0.693359375f)));
+  r = _mm256_sub_ps(r, _mm256_mul_ps(n, _mm256_set1_ps(-2.12194440e-4f)));
+  __m256 r2 = _mm256_mul_ps(r, r);
+  __m256 y = _mm256_set1_ps(1.9875691500E-4f);
+  y = fmadd_ps(y, r, _mm256_set1_ps(1.3981999507E-3f));
+  y = fmadd_ps(y, r, _mm256_set1_ps(8.3334519073E-3f));
+  y = fmadd_ps(y, r, _mm256_set1_ps(4.1665795894E-2f));
+  y = fmadd_ps(y, r, _mm256_set1_ps(1.6666665459E-1f));
+  y = fmadd_ps(y, r, _mm256_set1_ps(5.0000001201E-1f));
+  y = _mm256_add_ps(fmadd_ps(y, r2, r), _mm256_set1_ps(1.f));
+  __m256 n1 = _mm256_floor_ps(_mm256_mul_ps(n, _mm256_set1_ps(0.5f)));
+  __m256 n2 = _mm256_sub_ps(n, n1);
+  return _mm256_mul_ps(_mm256_mul_ps(y, pow2_ps(n1)), pow2_ps(n2));
+}
+
+inline Vec256<float> Vec256<float>::log() const {
+  // log(x) = e * ln 2 + log(m) with x = m * 2^e and m in [sqrt(1/2), sqrt(2)).
+  // Denormals are scaled into the normal range first.
+  __m256 denormal = _mm256_cmp_ps(values, _mm256_set1_ps(std::numeric_limits<float>::min()), _CMP_LT_OQ);
+  __m256 x = _mm256_blendv_ps(values, _mm256_mul_ps(values, _mm256_set1_ps(8388608.f)), denormal);
+  __m256 e = _mm256_and_ps(denormal, _mm256_set1_ps(-23.f));
+  __m256 exponent = _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x7f800000)));
+  exponent = _mm256_cvtepi32_ps(_mm256_castps_si256(exponent));
+  e = _mm256_add_ps(e, fmadd_ps(exponent, _mm256_set1_ps(1.f / 8388608.f), _mm256_set1_ps(-126.f)));
+  __m256 m = _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(~0x7f800000)));
+  m = _mm256_or_ps(m, _mm256_set1_ps(0.5f));
+  __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+  e = _mm256_sub_ps(e, _mm256_and_ps(small, _mm256_set1_ps(1.f)));
+  m = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(small, m)), _mm256_set1_ps(1.f));
+  __m256 z = _mm256_mul_ps(m, m);
+  __m256 y = _mm256_set1_ps(7.0376836292E-2f);
+  y = fmadd_ps(y, m, _mm256_set1_ps(-1.1514610310E-1f));
+  y = fmadd_ps(y, m, _mm256_set1_ps(1.1676998740E-1f));
+  y = fmadd_ps(y, m, _mm256_set1_ps(-1.2420140846E-1f));
+  y = fmadd_ps(y, m, _mm256_set1_ps(1.4249322787E-1f));
+  y = fmadd_ps(y, m, _mm256_set1_ps(-1.6668057665E-1f));
+  y = fmadd_ps(y, m, _mm256_set1_ps(2.0000714765E-1f));
+  y = fmadd_ps(y, m, _mm256_set1_ps(-2.4999993993E-1f));
+  y = fmadd_ps(y, m, _mm256_set1_ps(3.3333331174E-1f));
+  y = _mm256_mul_ps(_mm256_mul_ps(y, m), z);
+  y = fmadd_ps(e, _mm256_set1_ps(-2.12194440e-4f), y);
+  y = fmadd_ps(z, _mm256_set1_ps(-0.5f), y);
+  __m256 result = _mm256_add_ps(m, y);
+  result = fmadd_ps(e, _mm256_set1_ps(0.693359375f), result);
+
+  __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+  __m256 zero = _mm256_setzero_ps();
+  result = _mm256_blendv_ps(result, _mm256_sub_ps(zero, inf), _mm256_cmp_ps(values, zero, _CMP_EQ_OQ));
+  result = _mm256_blendv_ps(result, _mm256_set1_ps(std::numeric_limits<float>::quiet_NaN()),
+                            _mm256_cmp_ps(values, zero, _CMP_LT_OQ));
+  __m256 passthrough = _mm256_or_ps(_mm256_cmp_ps(values, inf, _CMP_EQ_OQ),
+                                    _mm256_cmp_ps(values, values, _CMP_UNORD_Q));
+  return _mm256_blendv_ps(result, values, passthrough);
+}
+
+// |x| - j * pi/4 for the low four lanes, in double precision with pi/4 split
+// in three parts. This keeps the result accurate to the last bit of a float,
+// even close to the zeros of sin and cos, for |x| up to 2^20.
+static inline __m256d reduce_pd(__m256 ax, __m256 j) {
+  __m256d r = _mm256_cvtps_pd(_mm256_castps256_ps128(ax));
+  __m256d jd = _mm256_cvtps_pd(_mm256_castps256_ps128(j));
+  r = _mm256_sub_pd(r, _mm256_mul_pd(jd, _mm256_set1_pd(7.85398125648498535156E-1)));
+  r = _mm256_sub_pd(r, _mm256_mul_pd(jd, _mm256_set1_pd(3.77489470793079817668E-8)));
+  return _mm256_sub_pd(r, _mm256_mul_pd(jd, _mm256_set1_pd(2.69515142907905952645E-15)));
+}
+
+// Reduces |x| = j * pi/4 + r with even j and |r| <= pi/4, and returns sin(r),
+// cos(r) and j mod 8 (0, 2, 4 or 6).
+static inline void sincos_reduce_ps(__m256 ax, __m256& sin_r, __m256& cos_r, __m256& octant) {
+  __m256 j = _mm256_floor_ps(_mm256_mul_ps(ax, _mm256_set1_ps(1.27323954473516f)));
+  __m256 half_j = _mm256_floor_ps(_mm256_mul_ps(j, _mm256_set1_ps(0.5f)));
+  j = _mm256_add_ps(j, _mm256_sub_ps(j, _mm256_add_ps(half_j, half_j)));
+  __m128 r_lo = _mm256_cvtpd_ps(reduce_pd(ax, j));
+  __m128 r_hi = _mm256_cvtpd_ps(reduce_pd(_mm256_permute2f128_ps(ax, ax, 1), _mm256_permute2f128_ps(j, j, 1)));
+  __m256 r = _mm256_insertf128_ps(_mm256_castps128_ps256(r_lo), r_hi, 1);
+  octant = fmadd_ps(_mm256_floor_ps(_mm256_mul_ps(j, _mm256_set1_ps(0.125f))), _mm256_set1_ps(-8.f), j);
+  __m256 z = _mm256_mul_ps(r, r);
+  __m256 c = _mm256_set1_ps(2.443315711809948E-005f);
+  c = fmadd_ps(c, z, _mm256_set1_ps(-1.388731625493765E-003f));
+  c = fmadd_ps(c, z, _mm256_set1_ps(4.166664568298827E-002f));
+  c = _mm256_mul_ps(_mm256_mul_ps(c, z), z);
+  cos_r = _mm256_add_ps(fmadd_ps(z, _mm256_set1_ps(-0.5f), c), _mm256_set1_ps(1.f));
+  __m256 s = _mm256_set1_ps(-1.9515295891E-4f);
+  s = fmadd_ps(s, z, _mm256_set1_ps(8.3321608736E-3f));
+  s = fmadd_ps(s, z, _mm256_set1_ps(-1.6666654611E-1f));
+  sin_r = fmadd_ps(_mm256_mul_ps(s, z), r, r);
+}
+
+// Whether the octant from sincos_reduce_ps is 2 or 6.
+static inline __m256 odd_quadrant_ps(__m256 octant) {
+  return _mm256_or_ps(_mm256_cmp_ps(octant, _mm256_set1_ps(2.f), _CMP_EQ_OQ),
+                      _mm256_cmp_ps(octant, _mm256_set1_ps(6.f), _CMP_EQ_OQ));
+}
+
+// Whether any |x| is beyond the range where sincos_reduce_ps is accurate.
+static inline bool sincos_out_of_range_ps(__m256 ax) {
+  return _mm256_movemask_ps(_mm256_cmp_ps(ax, _mm256_set1_ps(1048576.f), _CMP_GT_OQ)) != 0;
+}
+
+inline Vec256<float> Vec256<float>::sin() const {
+  __m256 ax = abs();
+  if (sincos_out_of_range_ps(ax)) {
+    return map(std::sin);
+  }
+  __m256 sin_r, cos_r, octant;
+  sincos_reduce_ps(ax, sin_r, cos_r, octant);
+  // sin(|x|) is sin(r), cos(r), -sin(r) and -cos(r) for octants 0, 2, 4 and 6.
+  __m256 odd_quadrant = odd_quadrant_ps(octant);
+  __m256 y = _mm256_blendv_ps(sin_r, cos_r, odd_quadrant);
+  __m256 negate = _mm256_and_ps(_mm256_cmp_ps(octant, _mm256_set1_ps(4.f), _CMP_GE_OQ), _mm256_set1_ps(-0.f));
+  return _mm256_xor_ps(y, _mm256_xor_ps(negate, sign_ps(values)));
+}
+
+inline Vec256<float> Vec256<float>::cos() const {
+  __m256 ax = abs();
+  if (sincos_out_of_range_ps(ax)) {
+    return map(std::cos);
+  }
+  __m256 sin_r, cos_r, octant;
+  sincos_reduce_ps(ax, sin_r, cos_r, octant);
+  // cos(|x|) is cos(r), -sin(r), -cos(r) and sin(r) for octants 0, 2, 4 and 6.
+  __m256 odd_quadrant = odd_quadrant_ps(octant);
+  __m256 y = _mm256_blendv_ps(cos_r, sin_r, odd_quadrant);
+  __m256 negate = _mm256_and_ps(_mm256_cmp_ps(octant, _mm256_set1_ps(1.f), _CMP_GT_OQ),
+                                _mm256_cmp_ps(octant, _mm256_set1_ps(5.f), _CMP_LT_OQ));
+  return _mm256_xor_ps(y, _mm256_and_ps(negate, _mm256_set1_ps(-0.f)));
+}
+
+inline Vec256<float> Vec256<float>::tan() const {
+  __m256 ax = abs();
+  if (sincos_out_of_range_ps(ax)) {
+    return map(std::tan);
+  }
+  __m256 sin_r, cos_r, octant;
+  sincos_reduce_ps(ax, sin_r, cos_r, octant);
+  // tan(|x|) is tan(r) for octants 0 and 4 and -1 / tan(r) for 2 and 6.
+  __m256 odd_quadrant = odd_quadrant_ps(octant);
+  __m256 num = _mm256_blendv_ps(sin_r, _mm256_xor_ps(cos_r, _mm256_set1_ps(-0.f)), odd_quadrant);
+  __m256 den = _mm256_blendv_ps(cos_r, sin_r, odd_quadrant);
+  return _mm256_xor_ps(_mm256_div_ps(num, den), sign_ps(values));
+}
+
+// asin(u) for |u| <= 1/2.
+static inline __m256 asin_small_ps(__m256 u) {
+  __m256 z = _mm256_mul_ps(u, u);
+  __m256 p = _mm256_set1_ps(4.2163199048E-2f);
+  p = fmadd_ps(p, z, _mm256_set1_ps(2.4181311049E-2f));
+  p = fmadd_ps(p, z, _mm256_set1_ps(4.5470025998E-2f));
+  p = fmadd_ps(p, z, _mm256_set1_ps(7.4953002686E-2f));
+  p = fmadd_ps(p, z, _mm256_set1_ps(1.6666752422E-1f));
+  return fmadd_ps(_mm256_mul_ps(p, z), u, u);
+}
+
+inline Vec256<float> Vec256<float>::asin() const {
+  // asin(x) = pi/2 - 2 asin(sqrt((1 - x) / 2)) for x > 1/2. |x| > 1 gives the
+  // square root of a negative number, which is NaN.
+  __m256 ax = abs();
+  __m256 big = _mm256_cmp_ps(ax, _mm256_set1_ps(0.5f), _CMP_GT_OQ);
+  __m256 u = _mm256_sqrt_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(1.f), ax), _mm256_set1_ps(0.5f)));
+  __m256 s = asin_small_ps(_mm256_blendv_ps(values, u, big));
+  __m256 s_big = fmadd_ps(s, _mm256_set1_ps(-2.f), _mm256_set1_ps(1.57079632679489661923f));
+  return _mm256_blendv_ps(s, _mm256_xor_ps(s_big, sign_ps(values)), big);
+}
+
+inline Vec256<float> Vec256<float>::acos() const {
+  // acos(x) = pi/2 - asin(x), and for |x| > 1/2 acos(x) = 2 asin(sqrt((1 - x) / 2))
+  // and acos(-x) = pi - acos(x).
+  __m256 ax = abs();
+  __m256 big = _mm256_cmp_ps(ax, _mm256_set1_ps(0.5f), _CMP_GT_OQ);
+  __m256 u = _mm256_sqrt_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(1.f), ax), _mm256_set1_ps(0.5f)));
+  __m256 s = asin_small_ps(_mm256_blendv_ps(values, u, big));
+  __m256 s_small = _mm256_sub_ps(_mm256_set1_ps(1.57079632679489661923f), s);
+  __m256 s_big = _mm256_add_ps(s, s);
+  __m256 negative = _mm256_cmp_ps(values, _mm256_setzero_ps(), _CMP_LT_OQ);
+  s_big = _mm256_blendv_ps(s_big, _mm256_sub_ps(_mm256_set1_ps(3.14159265358979323846f), s_big), negative);
+  return _mm256_blendv_ps(s_small, s_big, big);
+}
+
+inline Vec256<float> Vec256<float>::atan() const {
+  // atan(x) = pi/2 + atan(-1 / x) for x > tan(3 pi/8) and
+  // pi/4 + atan((x - 1) / (x + 1)) for x > tan(pi/8).
+  __m256 ax = abs();
+  __m256 one = _mm256_set1_ps(1.f);
+  __m256 big = _mm256_cmp_ps(ax, _mm256_set1_ps(2.414213562373095f), _CMP_GT_OQ);
+  __m256 mid = _mm256_cmp_ps(ax, _mm256_set1_ps(0.4142135623730950f), _CMP_GT_OQ);
+  __m256 y = _mm256_and_ps(mid, _mm256_set1_ps(0.78539816339744830962f));
+  y = _mm256_blendv_ps(y, _mm256_set1_ps(1.57079632679489661923f), big);
+  __m256 x = _mm256_blendv_ps(ax, _mm256_div_ps(_mm256_sub_ps(ax, one), _mm256_add_ps(ax, one)), mid);
+  x = _mm256_blendv_ps(x, _mm256_div_ps(_mm256_set1_ps(-1.f), ax), big);
+  __m256 z = _mm256_mul_ps(x, x);
+  __m256 p = _mm256_set1_ps(8.05374449538e-2f);
+  p = fmadd_ps(p, z, _mm256_set1_ps(-1.38776856032E-1f));
+  p = fmadd_ps(p, z, _mm256_set1_ps(1.99777106478E-1f));
+  p = fmadd_ps(p, z, _mm256_set1_ps(-3.33329491539E-1f));
+  y = _mm256_add_ps(y, fmadd_ps(_mm256_mul_ps(p, z), x, x));
+  return _mm256_xor_ps(y, sign_ps(values));
+}
+
+inline Vec256<float> Vec256<float>::erf() const {
+  // A polynomial in x^2 times x for |x| < 1, and 1 - erfc(|x|) with the
+  // Numerical Recipes approximation of erfc (relative error < 1.2e-7) above.
+  __m256 ax = abs();
+  __m256 z = _mm256_mul_ps(values, values);
+  __m256 p = _mm256_set1_ps(7.853861353153693E-5f);
+  p = fmadd_ps(p, z, _mm256_set1_ps(-8.010193625184903E-4f));
+  p = fmadd_ps(p, z, _mm256_set1_ps(5.188327685732524E-3f));
+  p = fmadd_ps(p, z, _mm256_set1_ps(-2.685381193529856E-2f));
+  p = fmadd_ps(p, z, _mm256_set1_ps(1.128358514861418E-1f));
+  p = fmadd_ps(p, z, _mm256_set1_ps(-3.761262582423300E-1f));
+  p = fmadd_ps(p, z, _mm256_set1_ps(1.128379165726710E+0f));
+  __m256 small = _mm256_mul_ps(p, values);
+
+  __m256 one = _mm256_set1_ps(1.f);
+  __m256 t = _mm256_div_ps(one, fmadd_ps(ax, _mm256_set1_ps(0.5f), one));
+  __m256 q = _mm256_set1_ps(0.17087277f);
+  q = fmadd_ps(q, t, _mm256_set1_ps(-0.82215223f));
+  q = fmadd_ps(q, t, _mm256_set1_ps(1.48851587f));
+  q = fmadd_ps(q, t, _mm256_set1_ps(-1.13520398f));
+  q = fmadd_ps(q, t, _mm256_set1_ps(0.27886807f));
+  q = fmadd_ps(q, t, _mm256_set1_ps(-0.18628806f));
+  q = fmadd_ps(q, t, _mm256_set1_ps(0.09678418f));
+  q = fmadd_ps(q, t, _mm256_set1_ps(0.37409196f));
+  q = fmadd_ps(q, t, _mm256_set1_ps(1.00002368f));
+  q = fmadd_ps(q, t, _mm256_set1_ps(-1.26551223f));
+  __m256 erfc = _mm256_mul_ps(t, Vec256<float>(_mm256_sub_ps(q, z)).exp());
+  __m256 big = _mm256_xor_ps(_mm256_sub_ps(one, erfc), sign_ps(values));
+  return _mm256_blendv_ps(big, small, _mm256_cmp_ps(ax, one, _CMP_LT_OQ));
+}
+
+inline Vec256<float> Vec256<float>::expm1() const {
+  // exp(x) - 1 loses most of its bits to cancellation for small x. Kahan's
+  // method recovers them: with u = exp(x) rounded, (u - 1) * x / log(u)
+  // cancels the rounding error of u - 1. It is used for |x| < 1, where it
+  // cannot overflow.
+  __m256 one = _mm256_set1_ps(1.f);
+  Vec256<float> u = exp();
+  __m256 um1 = _mm256_sub_ps(u, one);
+  __m256 result = _mm256_div_ps(_mm256_mul_ps(um1, values), u.log());
+  result = _mm256_blendv_ps(result, values, _mm256_cmp_ps(u, one, _CMP_EQ_OQ));
+  return _mm256_blendv_ps(um1, result, _mm256_cmp_ps(abs(), one, _CMP_LT_OQ));
+}
+
+inline Vec256<float> Vec256<float>::log1p() const {
+  // Like expm1, with u = 1 + x rounded, log(u) * x / (u - 1).
+  __m256 one = _mm256_set1_ps(1.f);
+  Vec256<float> u = _mm256_add_ps(values, one);
+  __m256 result = _mm256_div_ps(_mm256_mul_ps(u.log(), values), _mm256_sub_ps(u, one));
+  __m256 passthrough = _mm256_or_ps(_mm256_cmp_ps(u, one, _CMP_EQ_OQ),
+      _mm256_cmp_ps(values, _mm256_set1_ps(std::numeric_limits<float>::infinity()), _CMP_EQ_OQ));
+  return _mm256_blendv_ps(result, values, passthrough);
+}
+
+inline Vec256<float> Vec256<float>::sigmoid() const {
+  // 1 / (1 + e) for x >= 0 and e / (1 + e) for x < 0 with e = exp(-|x|),
+  // which cannot overflow.
+  __m256 one = _mm256_set1_ps(1.f);
+  __m256 e = Vec256<float>(_mm256_sub_ps(_mm256_setzero_ps(), abs())).exp();
+  __m256 num = _mm256_blendv_ps(one, e, _mm256_cmp_ps(values, _mm256_setzero_ps(), _CMP_LT_OQ));
+  return _mm256_div_ps(num, _mm256_add_ps(one, e));
+}
+
+inline Vec256<float> Vec256<float>::tanh() const {
+  // tanh(|x|) = t / (t + 2) with t = expm1(2|x|). tanh rounds to 1 in single
+  // precision for |x| >= 10, which also keeps t finite.
+  __m256 ax = _mm256_min_ps(_mm256_set1_ps(10.f), abs());
+  __m256 t = Vec256<float>(_mm256_add_ps(ax, ax)).expm1();
+  __m256 y = _mm256_div_ps(t, _mm256_add_ps(t, _mm256_set1_ps(2.f)));
+  return _mm256_xor_ps(y, sign_ps(values));
+}
+
+inline Vec256<float> Vec256<float>::sinh() const {
+  // sinh(|x|) = (t + t / (t + 1)) / 2 with t = expm1(|x|), and exp(|x|) / 2
+  // computed as exp(|x| / 2)^2 / 2 so that it does not overflow early for
+  // |x| > 20.
+  __m256 ax = abs();
+  __m256 limit = _mm256_set1_ps(20.f);
+  __m256 half = _mm256_set1_ps(0.5f);
+  __m256 t = Vec256<float>(_mm256_min_ps(limit, ax)).expm1();
+  __m256 small = _mm256_mul_ps(half, _mm256_add_ps(t, _mm256_div_ps(t, _mm256_add_ps(t, _mm256_set1_ps(1.f)))));
+  __m256 h = Vec256<float>(_mm256_mul_ps(half, ax)).exp();
+  __m256 big = _mm256_mul_ps(_mm256_mul_ps(half, h), h);
+  __m256 y = _mm256_blendv_ps(small, big, _mm256_cmp_ps(ax, limit, _CMP_GT_OQ));
+  return _mm256_xor_ps(y, sign_ps(values));
+}
+
+inline Vec256<float> Vec256<float>::cosh() const {
+  // cosh(|x|) = (e + 1 / e) / 2 with e = exp(|x|), computed like sinh for
+  // |x| > 20.
+  __m256 ax = abs();
+  __m256 limit = _mm256_set1_ps(20.f);
+  __m256 half = _mm256_set1_ps(0.5f);
+  __m256 e = Vec256<float>(_mm256_min_ps(limit, ax)).exp();
+  __m256 small = _mm256_mul_ps(half, _mm256_add_ps(e, _mm256_div_ps(_mm256_set1_ps(1.f), e)));
+  __m256 h = Vec256<float>(_mm256_mul_ps(half, ax)).exp();
+  __m256 big = _mm256_mul_ps(_mm256_mul_ps(half, h), h);
+  return _mm256_blendv_ps(small, big, _mm256_cmp_ps(ax, limit, _CMP_GT_OQ));
+}
+
 #endif
 
 }}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "ATen/ATenGeneral.h"
+
+#include <cstdint>
+
+// Control of the cache of cuFFT plans that fft, rfft, stft etc. keep on each
+// device, see _fft_cufft in native/cuda/SpectralOps.cu.
+
+namespace at { namespace cuda {
+
+struct CUFFTPlanCacheInfo {
+  int64_t size;
+  int64_t max_size;
+  int64_t hits;
+  int64_t misses;
+};
+
+AT_API CUFFTPlanCacheInfo cufft_plan_cache_info(int64_t device);
+// A max_size of 0 disables the cache on the device
+AT_API void cufft_set_plan_cache_max_size(int64_t device, int64_t max_size);
+AT_API void cufft_clear_plan_cache(int64_t device);
+
+}} // namespace at::cuda
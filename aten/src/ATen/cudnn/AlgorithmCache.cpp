@@ -0,0 +1,115 @@
+#include "AlgorithmCache.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+namespace at { namespace native {
+
+namespace {
+
+using Entries = std::unordered_map<std::string, std::pair<int, float>>;
+
+void readEntries(const std::string& path, Entries* entries) {
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream fields(line);
+    std::string key;
+    int algo;
+    float time;
+    if (fields >> key >> algo >> time) {
+      (*entries)[key] = std::make_pair(algo, time);
+    }
+  }
+}
+
+struct PersistentCache {
+  std::mutex mutex;
+  std::string path;
+  Entries entries;
+  bool dirty = false;
+
+  PersistentCache() {
+    const char* env = std::getenv("CUDNN_ALGO_CACHE_FILE");
+    if (env) {
+      path = env;
+      readEntries(path, &entries);
+    }
+  }
+
+  ~PersistentCache() {
+    flush();
+  }
+
+  void flush() {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (path.empty() || !dirty) {
+      return;
+    }
+    // Keep what other processes added since we loaded the file; our own
+    // entries win
+    Entries merged;
+    readEntries(path, &merged);
+    for (const auto& entry : entries) {
+      merged[entry.first] = entry.second;
+    }
+    // Write a private file and rename it over the cache, so that readers
+    // never see a partial file
+    std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+    {
+      std::ofstream file(tmp_path);
+      for (const auto& entry : merged) {
+        file << entry.first << " " << entry.second.first << " "
+             << entry.second.second << "\n";
+      }
+      if (!file) {
+        std::cerr << "Could not write the cuDNN algorithm cache " << tmp_path
+                  << std::endl;
+        std::remove(tmp_path.c_str());
+        return;
+      }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+      std::cerr << "Could not replace the cuDNN algorithm cache " << path
+                << std::endl;
+      std::remove(tmp_path.c_str());
+      return;
+    }
+    dirty = false;
+  }
+};
+
+PersistentCache& persistentCache() {
+  static PersistentCache cache;
+  return cache;
+}
+
+}  // namespace
+
+bool findPersistentAlgorithm(const std::string& key, int* algo) {
+  auto& cache = persistentCache();
+  std::lock_guard<std::mutex> guard(cache.mutex);
+  auto it = cache.entries.find(key);
+  if (it == cache.entries.end()) {
+    return false;
+  }
+  *algo = it->second.first;
+  return true;
+}
+
+void insertPersistentAlgorithm(const std::string& key, int algo) {
+  auto& cache = persistentCache();
+  std::lock_guard<std::mutex> guard(cache.mutex);
+  cache.entries[key] = std::make_pair(algo, -1.f);
+  cache.dirty = true;
+}
+
+}}  // namespace at::native
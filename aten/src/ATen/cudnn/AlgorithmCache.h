@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+namespace at { namespace native {
+
+// Benchmarked cuDNN algorithms, kept across processes in the file named by
+// the CUDNN_ALGO_CACHE_FILE environment variable. The file is read on first
+// use and written back at exit, merged with whatever other processes wrote to
+// it meanwhile. It has one entry per line,
+//
+//   <key> <algorithm> <time in ms>
+//
+// where the key spells out every input of the search and has no whitespace.
+// This is the format of caffe2's PersistentAlgorithmsCache, so the two can
+// share a file. ATen does not keep the times and writes -1.
+bool findPersistentAlgorithm(const std::string& key, int* algo);
+void insertPersistentAlgorithm(const std::string& key, int algo);
+
+}}  // namespace at::native
@@ -0,0 +1,52 @@
+#include "WorkspaceArena.h"
+
+#include <ATen/ATen.h>
+#include "THC/THC.h"
+
+#include "Exceptions.h"
+
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace at { namespace native {
+
+namespace {
+
+struct Arena {
+  void* data = nullptr;
+  size_t size = 0;
+};
+
+std::mutex mutex;
+std::map<std::pair<int, cudaStream_t>, Arena> arenas;
+
+}  // namespace
+
+void* getCudnnWorkspace(size_t size) {
+  if (size == 0) {
+    return nullptr;
+  }
+  int device;
+  CUDA_CHECK(cudaGetDevice(&device));
+  THCState* state = globalContext().lazyInitCUDA();
+  cudaStream_t stream = THCState_getCurrentStream(state);
+
+  std::lock_guard<std::mutex> guard(mutex);
+  auto& arena = arenas[std::make_pair(device, stream)];
+  if (arena.size < size) {
+    // Free first, so that the caching allocator can hand the memory back for
+    // the larger buffer. Work queued before on this stream that still uses
+    // the old buffer runs before anything the new buffer is used for.
+    if (arena.data) {
+      THCudaFree(state, arena.data);
+      arena.data = nullptr;
+      arena.size = 0;
+    }
+    CUDA_CHECK(THCudaMalloc(state, &arena.data, size));
+    arena.size = size;
+  }
+  return arena.data;
+}
+
+}}  // namespace at::native
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+namespace at { namespace native {
+
+// Returns scratch space of at least size bytes for cuDNN calls on the current
+// device and stream. There is one buffer per (device, stream), grown on
+// demand to the largest request seen. The work queued on a stream runs in
+// order, so calls on the same stream can reuse the buffer. This avoids
+// allocating and freeing large workspaces through the caching allocator on
+// every call. The buffer stays valid until the next call for the same device
+// and stream.
+void* getCudnnWorkspace(size_t size);
+
+}}  // namespace at::native
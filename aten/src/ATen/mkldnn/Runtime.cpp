@@ -1,5 +1,27 @@
 #include "Runtime.h"
 
+#include <map>
+
 namespace at { namespace native {
 
+// Shapes vary little in practice; the bound only keeps a thread that sees
+// ever new shapes from holding on to all their nets
+constexpr size_t max_cached_primitive_nets = 1024;
+
+std::shared_ptr<PrimitiveNet> cached_primitive_net(
+    const PrimitiveKey& key, const std::function<void(PrimitiveNet&)>& create) {
+  static thread_local std::map<std::vector<int64_t>, std::shared_ptr<PrimitiveNet>> cache;
+  auto it = cache.find(key.values);
+  if (it != cache.end()) {
+    return it->second;
+  }
+  if (cache.size() >= max_cached_primitive_nets) {
+    cache.clear();
+  }
+  auto net = std::make_shared<PrimitiveNet>();
+  create(*net);
+  cache.emplace(key.values, net);
+  return net;
+}
+
 }}  // namespace at::native
@@ -1,7 +1,15 @@
 #pragma once
 
+#include <ATen/ScalarType.h>
+
 #include <mkldnn.hpp>
 
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
 using namespace mkldnn;
 
 namespace at { namespace native {
@@ -46,4 +54,97 @@ private:
   stream _cpu_stream;
 };
 
+// A chain of primitives, with the memories that wrap the user tensors it reads
+// and writes. The primitives are created once for some shapes and parameters,
+// and run on the data of every call with these shapes: run() points the user
+// memories at the data, in the order in which they were added, and submits the
+// chain. Intermediate memories, e.g. inputs reordered into the blocked layouts
+// the primitives prefer, belong to the primitives and are reused across runs.
+struct PrimitiveNet {
+  // Adds a memory wrapping a user tensor of the given description
+  memory add_user_memory(const memory::desc& md) {
+    user_memories.push_back(memory({md, CpuEngine::Instance().get_engine()}, nullptr));
+    return user_memories.back();
+  }
+
+  // Returns the memory in the layout pd that the primitive should read, which
+  // is user itself if it already has that layout
+  memory reorder_input(const memory& user, const memory::primitive_desc& pd) {
+    if (user.get_primitive_desc() == pd) {
+      return user;
+    }
+    memory reordered(pd);
+    net.push_back(reorder(user, reordered));
+    return reordered;
+  }
+
+  // Returns the memory in the layout pd that the primitive should write, and
+  // the reorder into user that has to follow the primitive, if any
+  memory output_memory(const memory& user, const memory::primitive_desc& pd) {
+    return user.get_primitive_desc() == pd ? user : memory(pd);
+  }
+  void reorder_output(const memory& output, const memory& user) {
+    if (output != user) {
+      net.push_back(reorder(output, user));
+    }
+  }
+
+  void run(std::initializer_list<void*> data) {
+    auto it = user_memories.begin();
+    for (void* handle : data) {
+      (it++)->set_data_handle(handle);
+    }
+    Stream::Instance().get_stream().submit(net);
+  }
+
+  std::vector<memory> user_memories;
+  std::vector<primitive> net;
+};
+
+// The key of a PrimitiveNet: the kind of the net, then the shapes and
+// parameters it was created for
+struct PrimitiveKey {
+  explicit PrimitiveKey(int kind) : values{kind} {}
+
+  PrimitiveKey& add(IntList list) {
+    values.push_back(list.size());
+    values.insert(values.end(), list.begin(), list.end());
+    return *this;
+  }
+  PrimitiveKey& add(int64_t value) {
+    values.push_back(value);
+    return *this;
+  }
+  PrimitiveKey& add(bool value) {
+    values.push_back(value);
+    return *this;
+  }
+  PrimitiveKey& add(double value) {
+    int64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    values.push_back(bits);
+    return *this;
+  }
+
+  std::vector<int64_t> values;
+};
+
+// The kinds of PrimitiveNet
+enum PrimitiveKind {
+  kPrimitiveRelu,
+  kPrimitiveMaxPool2d,
+  kPrimitiveAvgPool2d,
+  kPrimitiveBatchNorm,
+  kPrimitiveLRN,
+  kPrimitiveLinear,
+};
+
+// Returns the net cached for key, calling create on a new net if there is
+// none. The cache is per thread, since a net points its memories at the data
+// of the call that runs it, and is shared by all the MKL-DNN ops in the thread,
+// which get repeated calls with the same shapes when running a model on batch
+// after batch.
+std::shared_ptr<PrimitiveNet> cached_primitive_net(
+    const PrimitiveKey& key, const std::function<void(PrimitiveNet&)>& create);
+
 }}  // namespace at::native
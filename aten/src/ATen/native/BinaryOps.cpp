@@ -0,0 +1,65 @@
+#include "ATen/native/BinaryOps.h"
+
+#include "ATen/native/cpu/BinaryOpsKernel.h"
+
+namespace at { namespace native {
+
+static bool can_use_binary_kernel(const Tensor& self, const Tensor& other) {
+  return !self.is_sparse() && !other.is_sparse() && self.sizes().equals(other.sizes());
+}
+
+// Overlap would make the result depend on the order the elements are written
+// in. Only the cheap check for broadcast (stride 0) dimensions is done.
+static bool has_overlap(const Tensor& result) {
+  for (int64_t d = 0; d < result.dim(); d++) {
+    if (result.size(d) > 1 && result.stride(d) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool prepare_result(Tensor& result, const Tensor& self, const Tensor& other) {
+  if (!can_use_binary_kernel(self, other)) {
+    return false;
+  }
+  // TH resizes the result in the same way, so it is safe to fall back after.
+  result.resize_(self.sizes());
+  return !has_overlap(result);
+}
+
+bool try_add_out_cpu(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha) {
+  if (!prepare_result(result, self, other)) {
+    return false;
+  }
+  add_kernel(result, self, other, alpha);
+  return true;
+}
+
+bool try_sub_out_cpu(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha) {
+  if (!prepare_result(result, self, other)) {
+    return false;
+  }
+  sub_kernel(result, self, other, alpha);
+  return true;
+}
+
+#define IMPLEMENT_BINARY_OP(op)                                                      \
+  bool try_##op##_out_cpu(Tensor& result, const Tensor& self, const Tensor& other) { \
+    if (!prepare_result(result, self, other)) {                                      \
+      return false;                                                                  \
+    }                                                                                \
+    op##_kernel(result, self, other);                                                \
+    return true;                                                                     \
+  }
+
+IMPLEMENT_BINARY_OP(mul)
+IMPLEMENT_BINARY_OP(div)
+IMPLEMENT_BINARY_OP(lt)
+IMPLEMENT_BINARY_OP(le)
+IMPLEMENT_BINARY_OP(gt)
+IMPLEMENT_BINARY_OP(ge)
+IMPLEMENT_BINARY_OP(eq)
+IMPLEMENT_BINARY_OP(ne)
+
+}} // namespace at::native
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "ATen/ATen.h"
+
+namespace at { namespace native {
+
+// Elementwise ops on CPU tensors that the generated CPU types run instead of
+// the TH ones (see aten_custom_call in Declarations.cwrap). They resize
+// `result` to the sizes of `self` and return true, or return false to leave
+// the op to TH for the cases they do not handle: sparse tensors, tensors of
+// different sizes (the deprecated TH fallback that pairs up elements by
+// linear index) and results with overlapping elements.
+bool try_add_out_cpu(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha);
+bool try_sub_out_cpu(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha);
+bool try_mul_out_cpu(Tensor& result, const Tensor& self, const Tensor& other);
+bool try_div_out_cpu(Tensor& result, const Tensor& self, const Tensor& other);
+bool try_lt_out_cpu(Tensor& result, const Tensor& self, const Tensor& other);
+bool try_le_out_cpu(Tensor& result, const Tensor& self, const Tensor& other);
+bool try_gt_out_cpu(Tensor& result, const Tensor& self, const Tensor& other);
+bool try_ge_out_cpu(Tensor& result, const Tensor& self, const Tensor& other);
+bool try_eq_out_cpu(Tensor& result, const Tensor& self, const Tensor& other);
+bool try_ne_out_cpu(Tensor& result, const Tensor& self, const Tensor& other);
+
+}} // namespace at::native
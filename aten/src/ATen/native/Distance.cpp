@@ -1,10 +1,67 @@
 #include "ATen/ATen.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/TensorUtils.h"
+#include "ATen/native/cpu/DistanceOpsKernel.h"
+
+#include <sstream>
 
 
 namespace at { namespace native {
 
+// cdist with p = 2 uses _euclidean_dist when either side has more rows than
+// this, below it the matrix multiply does not pay off.
+static constexpr int64_t CDIST_MM_MIN_ROWS = 25;
+
 Tensor pairwise_distance(const Tensor& x1, const Tensor& x2, double p, double eps, bool keepdim) {
-  return norm(x1 - x2 + eps, p, 1, keepdim);
+  return at::norm(x1 - x2 + eps, p, 1, keepdim);
+}
+
+Tensor cdist(const Tensor& x1, const Tensor& x2, double p) {
+  auto x1_arg = TensorArg(x1, "x1", 1);
+  auto x2_arg = TensorArg(x2, "x2", 2);
+  checkDim("cdist", x1_arg, 2);
+  checkDim("cdist", x2_arg, 2);
+  checkSameType("cdist", x1_arg, x2_arg);
+  checkScalarTypes("cdist", x1_arg, {kFloat, kDouble});
+  if (x1.size(1) != x2.size(1)) {
+    std::ostringstream ss;
+    ss << "cdist: expected x1 and x2 to have the same number of columns, "
+       << "but got x1 " << x1.sizes() << " and x2 " << x2.sizes();
+    throw std::runtime_error(ss.str());
+  }
+  if (p < 0) {
+    std::ostringstream ss;
+    ss << "cdist: expected p >= 0, but got p=" << p;
+    throw std::runtime_error(ss.str());
+  }
+  if (p == 2 && (x1.size(0) > CDIST_MM_MIN_ROWS || x2.size(0) > CDIST_MM_MIN_ROWS)) {
+    return at::_euclidean_dist(x1.contiguous(), x2.contiguous());
+  }
+  return at::_cdist_forward(x1.contiguous(), x2.contiguous(), p);
+}
+
+// sqrt(||x1||^2 + ||x2||^2 - 2 x1 x2^T), where the cross term is a matrix
+// multiply. This is done in place in the result, so it takes no more memory
+// than the result and the norms. Distances that are small relative to the
+// norms lose some precision to cancellation.
+Tensor _euclidean_dist(const Tensor& x1, const Tensor& x2) {
+  auto x1_norm = x1.pow(2).sum(1, true);
+  auto x2_norm = x2.pow(2).sum(1, true);
+  auto result = x1.mm(x2.t());
+  result.mul_(-2).add_(x1_norm).add_(x2_norm.t());
+  return result.clamp_min_(0).sqrt_();
 }
+
+Tensor _cdist_forward_cpu(const Tensor& x1, const Tensor& x2, double p) {
+  auto result = x1.type().tensor({x1.size(0), x2.size(0)});
+  cdist_kernel(result, x1, x2, p);
+  return result;
+}
+
+Tensor _cdist_backward_cpu(const Tensor& grad, const Tensor& x1, const Tensor& x2, double p, const Tensor& cdist) {
+  auto result = at::zeros_like(x1);
+  cdist_backward_kernel(result, grad.contiguous(), x1, x2, p, cdist.contiguous());
+  return result;
+}
+
 }}  // namespace at::native
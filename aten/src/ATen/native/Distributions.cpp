@@ -180,6 +180,14 @@ Tensor& bernoulli_(Tensor& self, const Tensor& p, Generator* generator) {
 }
 
 Tensor& bernoulli_(Tensor& self, double p, Generator* generator) {
+  if (!self.type().is_cuda() && isFloatingType(self.type().scalarType())) {
+    // The parallel uniform fill, compared in place, rather than a sample per
+    // element of an expanded tensor of probabilities
+    if (!(p >= 0 && p <= 1)) {
+      AT_ERROR("bernoulli_ expects 0 <= p <= 1, but got p=%f", p);
+    }
+    return self.uniform_(0, 1, generator).lt_(p);
+  }
   Tensor probs = self.type().toScalarType(kDouble).tensor({}).fill_(p);
   return native::bernoulli_(self, probs, generator);
 }
@@ -187,7 +195,7 @@ Tensor& bernoulli_(Tensor& self, double p, Generator* generator) {
 Tensor _standard_gamma_grad_cpu(const Tensor& self, const Tensor& output) {
   Tensor ret = self.type().tensor(self.sizes());
   AT_DISPATCH_FLOATING_TYPES(self.type(), "_standard_gamma_grad", [&] {
-    CPU_tensor_apply3<scalar_t, scalar_t, scalar_t>(ret, self, output,
+    CPU_tensor_parallel_apply3<scalar_t, scalar_t, scalar_t>(ret, self, output,
       [](scalar_t& ret_val, const scalar_t& self_val, const scalar_t &output_val) {
          ret_val = standard_gamma_grad_one(self_val, output_val);
       }
@@ -1,10 +1,15 @@
 #include "ATen/ATen.h"
+#include "ATen/Dispatch.h"
 #include "ATen/TensorUtils.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/Parallel.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstring>
-#include <memory>
 #include <sstream>
+#include <tuple>
 #include <vector>
 
 #ifdef _OPENMP
@@ -14,6 +19,86 @@
 
 namespace at { namespace native {
 
+namespace {
+
+// The positions in indices of each of its distinct values other than
+// padding_idx, grouped: unique[u] is at positions[offsets[u]] to
+// positions[offsets[u + 1] - 1], in increasing order. counts[u] is the
+// number of those positions.
+struct IndexGroups {
+  std::vector<int64_t> unique;
+  std::vector<int64_t> offsets;
+  std::vector<int64_t> positions;
+
+  int64_t size() const { return unique.size(); }
+  int64_t count(int64_t u) const { return offsets[u + 1] - offsets[u]; }
+};
+
+IndexGroups groupIndices(const Tensor & indices, int64_t padding_idx) {
+  Tensor unique, inverse, counts;
+  std::tie(unique, inverse, counts) = at::_unique(indices, false, true, true);
+  int64_t num_unique = unique.numel();
+  auto unique_data = unique.data<int64_t>();
+  auto inverse_data = inverse.data<int64_t>();
+  auto counts_data = counts.data<int64_t>();
+
+  // the group of each unique index, or -1 for padding_idx
+  IndexGroups groups;
+  std::vector<int64_t> group(num_unique);
+  groups.offsets.push_back(0);
+  for (int64_t u = 0; u < num_unique; u++) {
+    if (unique_data[u] == padding_idx) {
+      group[u] = -1;
+      continue;
+    }
+    group[u] = groups.unique.size();
+    groups.unique.push_back(unique_data[u]);
+    groups.offsets.push_back(groups.offsets.back() + counts_data[u]);
+  }
+
+  std::vector<int64_t> next(groups.offsets.begin(), groups.offsets.end() - 1);
+  groups.positions.resize(groups.offsets.back());
+  for (int64_t i = 0; i < indices.numel(); i++) {
+    int64_t g = group[inverse_data[i]];
+    if (g >= 0) {
+      groups.positions[next[g]++] = i;
+    }
+  }
+  return groups;
+}
+
+// Sets out to the sum of the rows of grad at the positions of group u,
+// divided by their number if scale_grad_by_freq
+template <typename scalar_t>
+void sumGroup(const IndexGroups & groups, int64_t u, const scalar_t* grad,
+              int64_t num_features, bool scale_grad_by_freq, scalar_t* out) {
+  std::fill(out, out + num_features, scalar_t(0));
+  for (int64_t j = groups.offsets[u]; j < groups.offsets[u + 1]; j++) {
+    const scalar_t* row = grad + groups.positions[j] * num_features;
+    for (int64_t f = 0; f < num_features; f++) {
+      out[f] += row[f];
+    }
+  }
+  if (scale_grad_by_freq) {
+    scalar_t scale = scalar_t(1) / groups.count(u);
+    for (int64_t f = 0; f < num_features; f++) {
+      out[f] *= scale;
+    }
+  }
+}
+
+// Calls f(begin, end) on ranges of groups in parallel, with ranges of about
+// TBB_GRAIN_SIZE elements of grad each
+template <typename F>
+void parallelOverGroups(const IndexGroups & groups, int64_t num_features, const F & f) {
+  int64_t rows_per_group = groups.size() == 0 ? 1 : (groups.positions.size() + groups.size() - 1) / groups.size();
+  int64_t grain = std::max<int64_t>(
+      1, internal::TBB_GRAIN_SIZE / std::max<int64_t>(1, rows_per_group * num_features));
+  parallel_for(0, groups.size(), grain, f);
+}
+
+} // namespace
+
 Tensor embedding(const Tensor & weight, const Tensor & indices,
                  int64_t padding_idx, bool scale_grad_by_freq, bool sparse) {
   auto indices_arg = TensorArg(indices, "indices", 1);
@@ -58,6 +143,35 @@ Tensor embedding_sparse_backward(
         "embedding_backward: scale_grad_by_freq not supported with sparse gradients");
   }
 
+  int64_t num_features = grad_.size(-1);
+  auto weight_size = std::array<int64_t, 2>{{ num_weights, num_features }};
+  auto& dense_type = grad_.type();
+  auto& sparse_type = dense_type.toBackend(grad_.is_cuda() ? kSparseCUDA : kSparseCPU);
+
+  if (!grad_.is_cuda()) {
+    // One row of values per distinct index, summed in parallel
+    auto groups = groupIndices(indices_, padding_idx);
+    // check if all our grad come from padding_idx
+    if (groups.size() == 0) {
+      return sparse_type.sparse_coo_tensor(indices_.type().tensor(),
+                                           dense_type.tensor(), weight_size);
+    }
+    auto grad = grad_.contiguous();
+    auto index = indices_.type().tensor({1, groups.size()});
+    std::copy(groups.unique.begin(), groups.unique.end(), index.data<int64_t>());
+    auto values = dense_type.tensor({groups.size(), num_features});
+    AT_DISPATCH_FLOATING_TYPES(grad.type(), "embedding_backward", [&] {
+      auto grad_data = grad.data<scalar_t>();
+      auto values_data = values.data<scalar_t>();
+      parallelOverGroups(groups, num_features, [&](int64_t begin, int64_t end) {
+        for (int64_t u = begin; u < end; u++) {
+          sumGroup(groups, u, grad_data, num_features, false, values_data + u * num_features);
+        }
+      });
+    });
+    return sparse_type.sparse_coo_tensor(index, values, weight_size);
+  }
+
   Tensor indices = indices_;
   Tensor grad = grad_;
   if (padding_idx != -1) {
@@ -66,11 +180,6 @@ Tensor embedding_sparse_backward(
     grad = grad.index(c);
   }
 
-  int64_t num_features = grad_.size(-1);
-  auto weight_size = std::array<int64_t, 2>{{ num_weights, num_features }};
-  auto& dense_type = grad.type();
-  auto& sparse_type = dense_type.toBackend(grad.is_cuda() ? kSparseCUDA : kSparseCPU);
-
   // check if all our grad come from padding_idx
   if (grad.numel() == 0) {
     return sparse_type.sparse_coo_tensor(indices_.type().tensor(),
@@ -90,64 +199,77 @@ Tensor embedding_backward_cpu(
   checkScalarType("embedding_backward", indices_arg, kLong);
   checkContiguous("embedding_backward", indices_arg);
 
-  auto indices_data = indices.data<int64_t>();
-  int64_t numel = indices.numel();
+  // Each distinct index has its row of grad_weight written by one thread,
+  // so the rows are summed without atomics and in a fixed order
+  auto groups = groupIndices(indices, padding_idx);
+  int64_t num_features = grad_.size(-1);
+  auto grad = grad_.contiguous();
+  auto grad_weight = at::zeros(grad_.type(), {num_weights, num_features});
 
-  std::unique_ptr<int64_t[]> counts;
-  if (scale_grad_by_freq) {
-    counts.reset(new int64_t[num_weights]);
-    for (int i = 0; i < numel; i++) {
-      counts[indices_data[i]] = 0;
-    }
-    for (int i = 0; i < numel; i++) {
-      counts[indices_data[i]]++;
-    }
-  }
+  AT_DISPATCH_FLOATING_TYPES(grad.type(), "embedding_backward", [&] {
+    auto grad_data = grad.data<scalar_t>();
+    auto grad_weight_data = grad_weight.data<scalar_t>();
+    parallelOverGroups(groups, num_features, [&](int64_t begin, int64_t end) {
+      for (int64_t u = begin; u < end; u++) {
+        sumGroup(groups, u, grad_data, num_features, scale_grad_by_freq,
+                 grad_weight_data + groups.unique[u] * num_features);
+      }
+    });
+  });
+
+  return grad_weight;
+}
 
-  auto grad = grad_.contiguous().view({numel, grad_.size(-1)});
-  auto grad_weight = at::zeros(grad_.type(), {num_weights, grad_.size(-1)});
+Tensor & embedding_sparse_adagrad_cpu_(
+    Tensor & self, const Tensor & state_sum, const Tensor & grad_, const Tensor & indices,
+    double lr, double eps, int64_t padding_idx) {
+  auto self_arg = TensorArg(self, "self", 1);
+  auto state_sum_arg = TensorArg(state_sum, "state_sum", 2);
+  auto indices_arg = TensorArg(indices, "indices", 4);
+  checkContiguous("embedding_sparse_adagrad_", self_arg);
+  checkContiguous("embedding_sparse_adagrad_", state_sum_arg);
+  checkDim("embedding_sparse_adagrad_", self_arg, 2);
+  checkSameSize("embedding_sparse_adagrad_", self_arg, state_sum_arg);
+  checkContiguous("embedding_sparse_adagrad_", indices_arg);
+  checkScalarType("embedding_sparse_adagrad_", indices_arg, kLong);
 
-#ifdef _OPENMP
-  if (numel > 1000) {
-    // The strategy is to parallelize over sections of the vocabulary, so that
-    // thread 1 handles updates to gradWeight[0..nVocab/nThreads]. Every thread
-    // has to traverse the entire input, but the dominating factor is the axpy
-    // BLAS call.
-    #pragma omp parallel
-    {
-      int tid = omp_get_thread_num();
-      int nthreads = omp_get_num_threads();
-      int64_t start = tid * (num_weights/nthreads + 1);
-      int64_t end = start + (num_weights/nthreads + 1);
-      for (int64_t i = 0; i < numel; i++) {
-        if (indices_data[i] != padding_idx) {
-          int64_t k = indices_data[i];
-          if (k >= start && k < end) {
-            double scale = 1.0;
-            if (scale_grad_by_freq) {
-              scale /= counts[k];
-            }
-            grad_weight[k].add_(grad[i], scale);
-          }
-        }
-      }
+  // The gradient of each distinct index is summed into a per-thread row and
+  // applied right away, so the gradient of the weight is never materialized
+  auto groups = groupIndices(indices, padding_idx);
+  int64_t num_features = self.size(1);
+  auto grad = grad_.contiguous();
+  if (grad.numel() != indices.numel() * num_features) {
+    AT_ERROR("embedding_sparse_adagrad_: expected grad to have %lld elements, but got %lld",
+        (long long)(indices.numel() * num_features), (long long)grad.numel());
+  }
+  for (auto k : groups.unique) {
+    if (k < 0 || k >= self.size(0)) {
+      AT_ERROR("embedding_sparse_adagrad_: index %lld out of range for weight with %lld rows",
+          (long long)k, (long long)self.size(0));
     }
-    return grad_weight;
   }
-#endif
 
-  for (int64_t i = 0; i < numel; i++) {
-    if (indices_data[i] != padding_idx) {
-      int64_t k = indices_data[i];
-      double scale = 1.0;
-      if (scale_grad_by_freq) {
-        scale /= counts[k];
+  AT_DISPATCH_FLOATING_TYPES(self.type(), "embedding_sparse_adagrad_", [&] {
+    auto grad_data = grad.data<scalar_t>();
+    auto self_data = self.data<scalar_t>();
+    auto state_sum_data = state_sum.data<scalar_t>();
+    scalar_t lr_ = lr;
+    scalar_t eps_ = eps;
+    parallelOverGroups(groups, num_features, [&](int64_t begin, int64_t end) {
+      std::vector<scalar_t> g(num_features);
+      for (int64_t u = begin; u < end; u++) {
+        sumGroup(groups, u, grad_data, num_features, false, g.data());
+        scalar_t* w = self_data + groups.unique[u] * num_features;
+        scalar_t* h = state_sum_data + groups.unique[u] * num_features;
+        for (int64_t f = 0; f < num_features; f++) {
+          h[f] += g[f] * g[f];
+          w[f] -= lr_ * g[f] / (std::sqrt(h[f]) + eps_);
+        }
       }
-      grad_weight[k].add_(grad[i], scale);
-    }
-  }
+    });
+  });
 
-  return grad_weight;
+  return self;
 }
 
 Tensor & embedding_renorm_cpu_(
@@ -1,6 +1,7 @@
 #include "ATen/ATen.h"
 #include "ATen/TensorUtils.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/native/cpu/EmbeddingBagKernel.h"
 
 #include <cstring>
 #include <iostream>
@@ -37,26 +38,6 @@ void axpy<double>(int64_t n, double a, double *x, int64_t incx,
   THDoubleBlas_axpy(n, a, x, incx, y, incy);
 }
 
-// This function combines index_select (using select_indices as the index) and
-// index_add (using add_indices as the index), without creating an intermediary
-// tensor to hold the selected embeddings
-template<typename T>
-static void index_select_add(const Tensor &select_indices,
-                             const Tensor &add_indices,
-                             const Tensor &src,
-                             Tensor &output) {
-  auto add_indices_data = add_indices.data<int64_t>();
-  auto select_indices_data = select_indices.data<int64_t>();
-  auto src_data = src.data<T>();
-  auto output_data = output.data<T>();
-  auto numel = add_indices.numel();
-  int64_t ddim = src.sizes()[1];
-  for (int64_t i = 0; i < numel; i++) {
-    axpy<T>(ddim, 1, src_data + ddim * select_indices_data[i], 1,
-            output_data + ddim * add_indices_data[i], 1);
-  }
-}
-
 static void make_bag_size(const Tensor &offsets, const Tensor &indices,
                           const int64_t mode, Tensor &bag_size) {
   if (mode == 1) { // MODE_MEAN
@@ -69,22 +50,6 @@ static void make_bag_size(const Tensor &offsets, const Tensor &indices,
   }
 }
 
-static Tensor apply_bag_size(const Tensor &offsets, const Tensor &indices,
-                             const int64_t mode, Tensor &output,
-                             const Tensor &bag_size) {
-  if (mode == 1) { // MODE_MEAN
-    if (offsets.sizes()[0] == 1) {
-      auto bag_size_ = indices.sizes()[0];
-      output /= bag_size_;
-    } else {
-      auto bag_size_ =
-          bag_size.toType(output.type()).unsqueeze(1).expand_as(output);
-      output /= bag_size_;
-    }
-  }
-  return output;
-}
-
 static Tensor apply_bag_size_backward(const Tensor &offsets,
                                       const Tensor &indices, const int64_t mode,
                                       Tensor &output, const Tensor &offset2bag,
@@ -121,14 +86,9 @@ embedding_bag_cpu(const Tensor &weight, const Tensor &indices__,
       at::zeros(indices__.type(), {indices.sizes()[0]}); // offset2bag = [0 0 0 0 0]
   make_offset2bag(offsets, indices, offset2bag);
   auto output = at::zeros(weight.type(), {offsets.sizes()[0], weight.sizes()[1]});
-  if (weight.type().scalarType() == kFloat) {
-    index_select_add<float>(indices, offset2bag, weight, output);
-  } else if (weight.type().scalarType() == kDouble) {
-    index_select_add<double>(indices, offset2bag, weight, output);
-  }
+  embedding_bag_kernel(output, weight.contiguous(), indices, offsets, mode);
   make_bag_size(offsets, indices, mode, bag_size);
-  auto ret = apply_bag_size(offsets, indices, mode, output, bag_size);
-  return std::tuple<Tensor, Tensor, Tensor>(ret, offset2bag, bag_size);
+  return std::tuple<Tensor, Tensor, Tensor>(output, offset2bag, bag_size);
 }
 
 Tensor embedding_bag_backward(const Tensor &grad_, const Tensor &indices__,
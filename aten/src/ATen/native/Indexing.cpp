@@ -20,15 +20,23 @@
 // Note 2: The behavior is more complicated when the index tensors are not all
 // adjacent (e.g. x[[0, 1], :, [2, 3]]). In this case, self and the index
 // tensors are transposed to the front: x.transpose(1, 2)[[0, 1], [2, 3]]
+//
+// The broadcast index tensors are stacked into one [k x index shape] tensor
+// for the k indexed dimensions, which _index_gather and _index_scatter_ read
+// directly along with the strides of self. So the only temporary is the
+// size of the index, not of the result.
 
 
 #include "ATen/ATen.h"
+#include "ATen/Dispatch.h"
 #include "ATen/NativeFunctions.h"
 #include "ATen/ExpandUtils.h"
+#include "ATen/Parallel.h"
 
 #include <algorithm>
 #include <functional>
 #include <numeric>
+#include <sstream>
 #include <vector>
 
 namespace at { namespace native {
@@ -122,80 +130,6 @@ transposeToFront(Tensor self, TensorList indices) {
   return std::make_tuple(self.permute(dims), std::move(transposedIndices));
 }
 
-static std::vector<int64_t> computeLinearStride(const Tensor & tensor) {
-  // computes the stride as if tensor were contigous
-  auto sizes = tensor.sizes();
-  std::vector<int64_t> stride(tensor.dim());
-  stride[tensor.dim() - 1] = 1;
-  std::partial_sum(sizes.rbegin(), sizes.rend() - 1, stride.rbegin() + 1, std::multiplies<int64_t>());
-  return stride;
-}
-
-// Unsqueezes src `before` times at the front and `after` times at the end
-static Tensor unsqueezeN(const Tensor & src, int64_t before, int64_t after) {
-  auto srcSizes = src.sizes();
-  auto nDim = src.dim();
-  std::vector<int64_t> sizes(nDim + before + after, 1);
-  for (int64_t i = 0; i < nDim; i++) {
-    sizes[i + before] = srcSizes[i];
-  }
-  return src.view(sizes);
-}
-
-static Tensor computeLinearIndex(const Tensor & src, TensorList indices) {
-  auto strides = computeLinearStride(src);
-  Type& longType = src.type().toScalarType(kLong);
-
-  // Compute the linear index by multiplying the indexing tensors by the
-  // stride and summing them. All the indexing tensors have the same shape at
-  // this point. We also compute the number of dimensions before and after that
-  // are not being index.
-  Tensor linearIndex;
-  int64_t emptyBefore = 0, emptyAfter = 0, nElemBefore = 1, nElemAfter = 1;
-  for (int64_t i = 0; i < src.dim(); i++) {
-    if (indices[i].defined()) {
-      // Cast index to the longType matching src's backend
-      // This allows us to support ie indexing a cuda tensor with a cpu tensor
-      Tensor index = (indices[i] * strides[i]).toType(longType);
-      if (linearIndex.defined()) {
-        linearIndex += index;
-      } else {
-        linearIndex = index;
-      }
-    } else if (linearIndex.defined()) {
-      emptyAfter++;
-      nElemAfter *= src.size(i);
-    } else {
-      emptyBefore++;
-      nElemBefore *= src.size(i);
-    }
-  }
-
-  // Compute the linear indices for the parts of the tensor not being indexed
-  Tensor beforeIndex;
-  if (emptyBefore > 0) {
-    auto index = at::arange(longType, 0, nElemBefore) * strides[emptyBefore - 1];
-    index = index.view(src.sizes().slice(0, emptyBefore));
-    beforeIndex = unsqueezeN(index, 0, linearIndex.dim() + emptyAfter);
-  }
-  Tensor afterIndex;
-  if (emptyAfter > 0) {
-    auto index = at::arange(longType, 0, nElemAfter);
-    index = index.view(src.sizes().slice(src.dim() - emptyAfter, emptyAfter));
-    afterIndex = unsqueezeN(index, linearIndex.dim() + emptyBefore, 0);
-  }
-
-  // Sum with broadcasting to compute the full index
-  linearIndex = unsqueezeN(linearIndex, emptyBefore, emptyAfter);
-  if (beforeIndex.defined()) {
-    linearIndex = linearIndex + beforeIndex;
-  }
-  if (afterIndex.defined()) {
-    linearIndex = linearIndex + afterIndex;
-  }
-  return linearIndex;
-}
-
 static bool hasEmptyTensor(TensorList tensors) {
   for (auto& tensor : tensors) {
     if (tensor.defined() && tensor.numel() == 0) {
@@ -205,12 +139,15 @@ static bool hasEmptyTensor(TensorList tensors) {
   return false;
 }
 
-static std::tuple<Tensor, Tensor> makeLinearIndex(Tensor self, TensorList orig) {
+// Returns self, transposed if needed so that the indexed dimensions are
+// adjacent, the stacked [k x index shape] index for them, and the number of
+// dimensions before them. The index is undefined if it selects nothing.
+static std::tuple<Tensor, Tensor, int64_t> makeIndex(Tensor self, TensorList orig) {
   checkIndexTensorTypes(orig);
   // first expand ByteTensor (boolean masks) into 1 or more LongTensors
   auto indices = expandByteTensors(self, orig);
   if (hasEmptyTensor(indices)) {
-    return std::make_tuple(self, self.type().toScalarType(kLong).tensor());
+    return std::make_tuple(self, Tensor(), 0);
   }
   // next broadcast all index tensors together
   indices = expand_outplace(indices);
@@ -223,8 +160,28 @@ static std::tuple<Tensor, Tensor> makeLinearIndex(Tensor self, TensorList orig)
   if (!hasContiguousSubspace(indices)) {
     std::tie(self, indices) = transposeToFront(self, indices);
   }
-  auto linearIndex = computeLinearIndex(self, indices);
-  return std::make_tuple(self, linearIndex);
+  int64_t dims_before = 0;
+  while (!indices[dims_before].defined()) {
+    dims_before++;
+  }
+  // Cast the indices to the longType matching self's backend. This allows
+  // us to support ie indexing a cuda tensor with a cpu tensor
+  Type& longType = self.type().toScalarType(kLong);
+  std::vector<Tensor> defined;
+  for (auto& index : indices) {
+    if (index.defined()) {
+      defined.emplace_back(index.toType(longType));
+    }
+  }
+  return std::make_tuple(self, at::stack(defined, 0), dims_before);
+}
+
+// The sizes of the result of indexing self with index
+static std::vector<int64_t> indexedSizes(const Tensor & self, const Tensor & index, int64_t dims_before) {
+  std::vector<int64_t> sizes(self.sizes().begin(), self.sizes().begin() + dims_before);
+  sizes.insert(sizes.end(), index.sizes().begin() + 1, index.sizes().end());
+  sizes.insert(sizes.end(), self.sizes().begin() + dims_before + index.size(0), self.sizes().end());
+  return sizes;
 }
 
 Tensor index(const Tensor & self, TensorList indices) {
@@ -233,21 +190,190 @@ Tensor index(const Tensor & self, TensorList indices) {
       (int)self.dim(), (int)indices.size());
   }
 
-  Tensor src, linearIndex;
-  std::tie(src, linearIndex) = makeLinearIndex(self, indices);
-  return src.take(linearIndex);
+  Tensor src, index;
+  int64_t dims_before;
+  std::tie(src, index, dims_before) = makeIndex(self, indices);
+  if (!index.defined()) {
+    return self.type().tensor();
+  }
+  return at::_index_gather(src, index, dims_before);
 }
 
-Tensor & index_put_(Tensor & self, TensorList indices, const Tensor & value) {
+Tensor & index_put_(Tensor & self, TensorList indices, const Tensor & value, bool accumulate) {
   if (indices.size() > (size_t)self.dim()) {
    AT_ERROR("too many indices for tensor of dimension %d (got %d)",
       (int)self.dim(), (int)indices.size());
   }
 
-  Tensor src, linearIndex, expandedValue;
-  std::tie(src, linearIndex) = makeLinearIndex(self, indices);
-  std::tie(expandedValue) = expand_inplace(linearIndex, value);
-  return src.put_(linearIndex, expandedValue);
+  Tensor src, index;
+  int64_t dims_before;
+  std::tie(src, index, dims_before) = makeIndex(self, indices);
+  if (!index.defined()) {
+    return self;
+  }
+  auto expandedValue = value.expand(indexedSizes(src, index, dims_before));
+  src._index_scatter_(index, expandedValue, dims_before, accumulate);
+  return self;
+}
+
+// Element offsets into a tensor of the elements of a group of its dimensions,
+// in linear order. Dimensions that can be walked with one stride, in all the
+// tensors the group is used for, are collapsed first.
+struct DimGroup {
+  std::vector<int64_t> sizes;
+  std::vector<int64_t> strides;
+
+  int64_t numel() const {
+    return std::accumulate(sizes.begin(), sizes.end(), (int64_t)1, std::multiplies<int64_t>());
+  }
+
+  int64_t offset(int64_t linear) const {
+    int64_t offset = 0;
+    for (int64_t d = sizes.size() - 1; d >= 0; d--) {
+      offset += (linear % sizes[d]) * strides[d];
+      linear /= sizes[d];
+    }
+    return offset;
+  }
+};
+
+// The dims [begin, end) of a and b, which have the same sizes there
+static std::tuple<DimGroup, DimGroup> makeDimGroups(
+    IntList sizes, IntList a_strides, IntList b_strides, int64_t a_begin, int64_t b_begin, int64_t count) {
+  DimGroup a, b;
+  for (int64_t d = 0; d < count; d++) {
+    int64_t size = sizes[d];
+    int64_t a_stride = a_strides[a_begin + d];
+    int64_t b_stride = b_strides[b_begin + d];
+    if (size == 1) {
+      continue;
+    }
+    if (!a.sizes.empty() &&
+        a.strides.back() == a_stride * size && b.strides.back() == b_stride * size) {
+      a.sizes.back() *= size;
+      b.sizes.back() *= size;
+      a.strides.back() = a_stride;
+      b.strides.back() = b_stride;
+    } else {
+      a.sizes.push_back(size);
+      b.sizes.push_back(size);
+      a.strides.push_back(a_stride);
+      b.strides.push_back(b_stride);
+    }
+  }
+  return std::make_tuple(a, b);
+}
+
+// Calls op(self element, other element) for all the elements of other, a
+// tensor of the indexed shape, and the elements of self they index. Runs in
+// parallel over the parts of self that different indices cannot both write
+// to if serial_index, otherwise over everything.
+template <typename scalar_t, typename Op>
+static void index_apply_cpu(
+    const Tensor & self, const Tensor & index, const Tensor & other,
+    int64_t dims_before, bool serial_index, const Op & op) {
+  int64_t num_indexed = index.size(0);
+  int64_t dims_index = index.dim() - 1;
+  int64_t dims_after = self.dim() - dims_before - num_indexed;
+  auto sizes = other.sizes();
+
+  // the offsets into self of the indexed elements, checked against the sizes
+  int64_t ni = index.numel() / num_indexed;
+  std::vector<int64_t> index_offsets(ni, 0);
+  auto contig_index = index.contiguous();
+  const int64_t* index_data = contig_index.data<int64_t>();
+  for (int64_t j = 0; j < num_indexed; j++) {
+    int64_t size = self.size(dims_before + j);
+    int64_t stride = self.stride(dims_before + j);
+    for (int64_t i = 0; i < ni; i++) {
+      int64_t idx = index_data[j * ni + i];
+      if (idx < -size || idx >= size) {
+        AT_ERROR("index %lld is out of bounds for dimension %lld with size %lld",
+            (long long)idx, (long long)(dims_before + j), (long long)size);
+      }
+      index_offsets[i] += (idx < 0 ? idx + size : idx) * stride;
+    }
+  }
+
+  DimGroup self_before, other_before, other_index, self_after, other_after, unused;
+  std::tie(self_before, other_before) = makeDimGroups(
+      sizes.slice(0, dims_before), self.strides(), other.strides(), 0, 0, dims_before);
+  std::tie(other_index, unused) = makeDimGroups(
+      sizes.slice(dims_before, dims_index), other.strides(), other.strides(),
+      dims_before, dims_before, dims_index);
+  std::tie(self_after, other_after) = makeDimGroups(
+      sizes.slice(dims_before + dims_index), self.strides(), other.strides(),
+      dims_before + num_indexed, dims_before + dims_index, dims_after);
+  int64_t nb = self_before.numel();
+  int64_t na = self_after.numel();
+
+  scalar_t* self_data = self.data<scalar_t>();
+  scalar_t* other_data = other.data<scalar_t>();
+  auto apply = [&](int64_t o, int64_t i, int64_t a_begin, int64_t a_end) {
+    scalar_t* self_ptr = self_data + self_before.offset(o) + index_offsets[i];
+    scalar_t* other_ptr = other_data + other_before.offset(o) + other_index.offset(i);
+    for (int64_t a = a_begin; a < a_end; a++) {
+      op(self_ptr + self_after.offset(a), other_ptr + other_after.offset(a));
+    }
+  };
+
+  if (!serial_index) {
+    int64_t grain = std::max<int64_t>(1, internal::TBB_GRAIN_SIZE / std::max<int64_t>(1, na));
+    parallel_for(0, nb * ni, grain, [&](int64_t begin, int64_t end) {
+      for (int64_t t = begin; t < end; t++) {
+        apply(t / ni, t % ni, 0, na);
+      }
+    });
+  } else {
+    // Different indices only write to the same element for the same before
+    // and after positions, so split over those and loop over the indices
+    int64_t chunk = std::min(na, std::max<int64_t>(1, internal::TBB_GRAIN_SIZE / std::max<int64_t>(1, ni)));
+    int64_t num_chunks = na == 0 ? 0 : (na + chunk - 1) / chunk;
+    int64_t grain = std::max<int64_t>(1, internal::TBB_GRAIN_SIZE / std::max<int64_t>(1, ni * chunk));
+    parallel_for(0, nb * num_chunks, grain, [&](int64_t begin, int64_t end) {
+      for (int64_t t = begin; t < end; t++) {
+        int64_t a_begin = (t % num_chunks) * chunk;
+        int64_t a_end = std::min(na, a_begin + chunk);
+        for (int64_t i = 0; i < ni; i++) {
+          apply(t / num_chunks, i, a_begin, a_end);
+        }
+      }
+    });
+  }
+}
+
+Tensor _index_gather_cpu(const Tensor & self, const Tensor & index, int64_t dims_before) {
+  auto result = self.type().tensor(indexedSizes(self, index, dims_before));
+  if (result.numel() == 0) {
+    return result;
+  }
+  AT_DISPATCH_ALL_TYPES(self.type(), "index", [&] {
+    index_apply_cpu<scalar_t>(self, index, result, dims_before, false,
+        [](scalar_t* self_elem, scalar_t* result_elem) {
+          *result_elem = *self_elem;
+        });
+  });
+  return result;
+}
+
+Tensor & _index_scatter_cpu_(Tensor & self, const Tensor & index, const Tensor & source, int64_t dims_before, bool accumulate) {
+  if (source.numel() == 0) {
+    return self;
+  }
+  AT_DISPATCH_ALL_TYPES(self.type(), "index_put_", [&] {
+    if (accumulate) {
+      index_apply_cpu<scalar_t>(self, index, source, dims_before, true,
+          [](scalar_t* self_elem, scalar_t* source_elem) {
+            *self_elem += *source_elem;
+          });
+    } else {
+      index_apply_cpu<scalar_t>(self, index, source, dims_before, false,
+          [](scalar_t* self_elem, scalar_t* source_elem) {
+            *self_elem = *source_elem;
+          });
+    }
+  });
+  return self;
 }
 
 Tensor & index_copy_(Tensor & self, int64_t dim, const Tensor & index, const Tensor & source) {
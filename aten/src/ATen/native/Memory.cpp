@@ -16,5 +16,13 @@ Tensor pin_memory(const Tensor& self) {
   return tensor;
 }
 
+Tensor _to_host_async_cpu(const Tensor& self) {
+  AT_ERROR("_to_host_async: expected a CUDA tensor, but got '%s'", self.type().toString());
+}
+
+Tensor & _copy_from_host_async_cpu_(Tensor& self, const Tensor& src) {
+  AT_ERROR("_copy_from_host_async_: expected a CUDA tensor, but got '%s'", self.type().toString());
+}
+
 }
 }
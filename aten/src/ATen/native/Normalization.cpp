@@ -65,6 +65,16 @@ Tensor batch_norm(
                         training, momentum, eps));
   }
 #endif
+
+#if AT_MKLDNN_ENABLED()
+  if (!training && input.type().backend() == kCPU
+      && input.type().scalarType() == kFloat
+      && weight.defined() && bias.defined()
+      && input.dim() >= 2 && input.dim() <= 4) {
+    return at::mkldnn_batch_norm(
+              input, weight, bias, running_mean, running_var, eps);
+  }
+#endif
   return at::thnn_batch_norm(
             input, weight, bias,
             running_mean, running_var, training, momentum, eps);
@@ -18,27 +18,84 @@ namespace native {
 // ALL REDUCE #################################################################
 
 Tensor _sum_cpu(const Tensor& self) {
-  if (self.is_contiguous()) {
-    Tensor result = self.type().tensor({});
-    sum_kernel(result, self, at::nullopt);
-    return result;
-  }
-  return self._sumall();
+  Tensor result = self.type().tensor({});
+  sum_kernel(result, self, IntList());
+  return result;
 }
 
 Tensor _prod_cpu(const Tensor &self) {
-  if (self.is_contiguous()) {
-    Tensor result = self.type().tensor({});
-    prod_kernel(result, self, at::nullopt);
-    return result;
-  }
-  return self._prodall();
+  Tensor result = self.type().tensor({});
+  prod_kernel(result, self, IntList());
+  return result;
 }
 
 Tensor _sum_cuda(const Tensor &self_) { return self_._sumall(); }
 
 Tensor _prod_cuda(const Tensor &self_) { return self_._prodall(); }
 
+// The reductions below leave empty tensors to TH, whose results (or errors)
+// for them are the legacy behavior.
+
+Tensor _mean_cpu(const Tensor &self) {
+  if (self.numel() == 0) return self._mean();
+  Tensor result = self.type().tensor({});
+  mean_kernel(result, self, IntList());
+  return result;
+}
+
+Tensor _max_cpu(const Tensor &self) {
+  if (self.numel() == 0) return self._maxall();
+  Tensor result = self.type().tensor({});
+  max_kernel(result, self, IntList());
+  return result;
+}
+
+Tensor _min_cpu(const Tensor &self) {
+  if (self.numel() == 0) return self._minall();
+  Tensor result = self.type().tensor({});
+  min_kernel(result, self, IntList());
+  return result;
+}
+
+Tensor _norm_cpu(const Tensor &self, Scalar p) {
+  if (self.numel() == 0) return self._norm(p);
+  Tensor result = self.type().tensor({});
+  norm_kernel(result, self, p, IntList());
+  return result;
+}
+
+Tensor _var_cpu(const Tensor &self, bool unbiased) {
+  if (self.numel() == 0) return self._var(unbiased);
+  Tensor result = self.type().tensor({});
+  var_kernel(result, self, unbiased, false, IntList());
+  return result;
+}
+
+Tensor _std_cpu(const Tensor &self, bool unbiased) {
+  if (self.numel() == 0) return self._std(unbiased);
+  Tensor result = self.type().tensor({});
+  var_kernel(result, self, unbiased, true, IntList());
+  return result;
+}
+
+Tensor _mean_cuda(const Tensor &self) { return self._mean(); }
+
+Tensor _max_cuda(const Tensor &self) { return self._maxall(); }
+
+Tensor _min_cuda(const Tensor &self) { return self._minall(); }
+
+Tensor _norm_cuda(const Tensor &self, Scalar p) { return self._norm(p); }
+
+Tensor _norm_sparse(const Tensor &self, Scalar p) { return self._norm(p); }
+
+Tensor _var_cuda(const Tensor &self, bool unbiased) {
+  return self._var(unbiased);
+}
+
+Tensor _std_cuda(const Tensor &self, bool unbiased) {
+  return self._std(unbiased);
+}
+
 // \ALL REDUCE ################################################################
 
 // DIM REDUCE #################################################################
@@ -69,18 +126,39 @@ static Tensor &_dimreduce_setup(Tensor &result, const Tensor &self,
   return result;
 }
 
+// Resizes result to the sizes of self with dim set to 1 and calls
+// kernel(out, dims) to reduce self over dims into out, which is result itself
+// or a contiguous temporary copied into result if result is not contiguous.
+template <typename Kernel>
+static Tensor &_dimreduce_cpu(Tensor &result, const Tensor &self, int64_t dim,
+                               bool keepdim, Kernel kernel) {
+  // a scalar has no dimension to reduce but is reduced as a single element
+  IntList dims = self.dim() == 0 ? IntList() : IntList(dim);
+  if (self.dim() == 0) {
+    result.resize_({});
+  } else {
+    _dimreduce_setup(result, self, dim);
+  }
+  if (result.is_contiguous()) {
+    kernel(result, dims);
+  } else {
+    Tensor out = result.type().tensor(result.sizes());
+    kernel(out, dims);
+    result.copy_(out);
+  }
+  if (!keepdim && self.dim() != 0) result.squeeze_(dim);
+  return result;
+}
+
 Tensor &_sum_out_cpu(Tensor &result, const Tensor &self, int64_t dim_,
                      bool keepdim) {
   int64_t dim = maybe_wrap_dim(dim_, self.dim());
   if (_dimreduce_return_trivial(result, self, 0))
     return result;
-  if (self.is_contiguous() && result.is_contiguous()) {
-    _dimreduce_setup(result, self, dim);
-    sum_kernel(result, self, dim);
-    if (!keepdim) result.squeeze_(dim);
-    return result;
-  }
-  return at::_sum_out(result, self, dim, keepdim);
+  return _dimreduce_cpu(result, self, dim, keepdim,
+                        [&](Tensor &out, IntList dims) {
+                          sum_kernel(out, self, dims);
+                        });
 }
 
 Tensor &_prod_out_cpu(Tensor &result, const Tensor &self, int64_t dim_,
@@ -88,13 +166,54 @@ Tensor &_prod_out_cpu(Tensor &result, const Tensor &self, int64_t dim_,
   int64_t dim = maybe_wrap_dim(dim_, self.dim());
   if (_dimreduce_return_trivial(result, self, 1))
     return result;
-  if (self.is_contiguous() && result.is_contiguous()) {
-    _dimreduce_setup(result, self, dim);
-    prod_kernel(result, self, dim);
-    if (!keepdim) result.squeeze_(dim);
-    return result;
-  }
-  return at::_prod_out(result, self, dim, keepdim);
+  return _dimreduce_cpu(result, self, dim, keepdim,
+                        [&](Tensor &out, IntList dims) {
+                          prod_kernel(out, self, dims);
+                        });
+}
+
+Tensor &_mean_out_cpu(Tensor &result, const Tensor &self, int64_t dim_,
+                      bool keepdim) {
+  int64_t dim = maybe_wrap_dim(dim_, self.dim());
+  if (self.numel() == 0)
+    return at::_mean_out(result, self, dim, keepdim);
+  return _dimreduce_cpu(result, self, dim, keepdim,
+                        [&](Tensor &out, IntList dims) {
+                          mean_kernel(out, self, dims);
+                        });
+}
+
+Tensor &_norm_out_cpu(Tensor &result, const Tensor &self, Scalar p,
+                      int64_t dim_, bool keepdim) {
+  int64_t dim = maybe_wrap_dim(dim_, self.dim());
+  if (self.numel() == 0)
+    return at::_norm_out(result, self, p, dim, keepdim);
+  return _dimreduce_cpu(result, self, dim, keepdim,
+                        [&](Tensor &out, IntList dims) {
+                          norm_kernel(out, self, p, dims);
+                        });
+}
+
+Tensor &_var_out_cpu(Tensor &result, const Tensor &self, int64_t dim_,
+                     bool unbiased, bool keepdim) {
+  int64_t dim = maybe_wrap_dim(dim_, self.dim());
+  if (self.numel() == 0)
+    return at::_var_out(result, self, dim, unbiased, keepdim);
+  return _dimreduce_cpu(result, self, dim, keepdim,
+                        [&](Tensor &out, IntList dims) {
+                          var_kernel(out, self, unbiased, false, dims);
+                        });
+}
+
+Tensor &_std_out_cpu(Tensor &result, const Tensor &self, int64_t dim_,
+                     bool unbiased, bool keepdim) {
+  int64_t dim = maybe_wrap_dim(dim_, self.dim());
+  if (self.numel() == 0)
+    return at::_std_out(result, self, dim, unbiased, keepdim);
+  return _dimreduce_cpu(result, self, dim, keepdim,
+                        [&](Tensor &out, IntList dims) {
+                          var_kernel(out, self, unbiased, true, dims);
+                        });
 }
 
 Tensor &_sum_out_cuda(Tensor &result, const Tensor &self, int64_t dim,
@@ -107,6 +226,26 @@ Tensor &_prod_out_cuda(Tensor &result, const Tensor &self, int64_t dim,
   return at::_prod_out(result, self, dim, keepdim);
 }
 
+Tensor &_mean_out_cuda(Tensor &result, const Tensor &self, int64_t dim,
+                       bool keepdim) {
+  return at::_mean_out(result, self, dim, keepdim);
+}
+
+Tensor &_norm_out_cuda(Tensor &result, const Tensor &self, Scalar p,
+                       int64_t dim, bool keepdim) {
+  return at::_norm_out(result, self, p, dim, keepdim);
+}
+
+Tensor &_var_out_cuda(Tensor &result, const Tensor &self, int64_t dim,
+                      bool unbiased, bool keepdim) {
+  return at::_var_out(result, self, dim, unbiased, keepdim);
+}
+
+Tensor &_std_out_cuda(Tensor &result, const Tensor &self, int64_t dim,
+                      bool unbiased, bool keepdim) {
+  return at::_std_out(result, self, dim, unbiased, keepdim);
+}
+
 Tensor sum(const Tensor &self, int64_t dim_, bool keepdim) {
   int64_t dim = maybe_wrap_dim(dim_, self.dim());
   Tensor result = self.type().tensor();
@@ -119,6 +258,30 @@ Tensor prod(const Tensor &self, int64_t dim_, bool keepdim) {
   return at::prod_out(result, self, dim, keepdim);
 }
 
+Tensor mean(const Tensor &self, int64_t dim_, bool keepdim) {
+  int64_t dim = maybe_wrap_dim(dim_, self.dim());
+  Tensor result = self.type().tensor();
+  return at::mean_out(result, self, dim, keepdim);
+}
+
+Tensor norm(const Tensor &self, Scalar p, int64_t dim_, bool keepdim) {
+  int64_t dim = maybe_wrap_dim(dim_, self.dim());
+  Tensor result = self.type().tensor();
+  return at::norm_out(result, self, p, dim, keepdim);
+}
+
+Tensor var(const Tensor &self, int64_t dim_, bool unbiased, bool keepdim) {
+  int64_t dim = maybe_wrap_dim(dim_, self.dim());
+  Tensor result = self.type().tensor();
+  return at::var_out(result, self, dim, unbiased, keepdim);
+}
+
+Tensor std(const Tensor &self, int64_t dim_, bool unbiased, bool keepdim) {
+  int64_t dim = maybe_wrap_dim(dim_, self.dim());
+  Tensor result = self.type().tensor();
+  return at::std_out(result, self, dim, unbiased, keepdim);
+}
+
 // \DIM REDUCE ################################################################
 }
 }
@@ -186,13 +186,9 @@ Tensor stft(const Tensor& self, const int64_t frame_length,
     REPR(ss) << ": expected pad_end >= 0, but got pad_end=" << pad_end;
     throw std::runtime_error(ss.str());
   }
-  // pad zeros
-  if (pad_end != 0) {
-    Tensor padded_input = at::zeros(self.type(), {batch, len + pad_end});
-    padded_input.narrow(1, 0, len).copy_(input);
-    len += pad_end;
-    input = padded_input;
-  }
+  // the input is padded with zeros below, once we know how much is needed
+  int64_t input_len = len;
+  len += pad_end;
   if (frame_length <= 0 || frame_length > len) {
     std::ostringstream ss;
     REPR(ss) << ": expected 0 < frame_length < " << len
@@ -218,6 +214,62 @@ Tensor stft(const Tensor& self, const int64_t frame_length,
   }
   #undef REPR
   int64_t return_size = onesided ? infer_ft_real_to_complex_onesided_size(fft_size) : fft_size;
+  int64_t n_frames = 1 + (len - frame_length) / hop;
+
+  // Take the frames as a view of the input and rfft them, so that the only
+  // copy of the frames is the one that applies the window. A frame shorter
+  // than fft_size is padded with zeros, which is done by padding the end of
+  // the input instead and zero-filling the window past frame_length, so that
+  // the padding is also part of that one copy.
+  bool use_fft = frame_length <= fft_size &&
+                 self.type().scalarType() != ScalarType::Half &&
+                 (self.type().is_cuda() || AT_MKL_ENABLED());
+  if (use_fft) {
+    int64_t extra_pad = fft_size - frame_length;
+    if (pad_end + extra_pad != 0) {
+      Tensor padded_input = at::zeros(self.type(), {batch, len + extra_pad});
+      padded_input.narrow(1, 0, input_len).copy_(input);
+      input = padded_input;
+    }
+    // [batch x n_frames x fft_size]
+    auto frames = input.unfold(1, fft_size, hop);
+    // [(batch * n_frames) x fft_size]
+    Tensor windowed;
+    if (window.defined() || normalized || extra_pad != 0) {
+      Tensor fft_window = at::zeros(self.type(), {fft_size});
+      if (window.defined()) {
+        fft_window.narrow(0, 0, frame_length).copy_(window);
+      } else {
+        fft_window.narrow(0, 0, frame_length).fill_(1);
+      }
+      if (normalized) {
+        fft_window.div_(std::sqrt(static_cast<double>(frame_length)));
+      }
+      windowed = (frames * fft_window).view({batch * n_frames, fft_size});
+    } else if (batch == 1 || input.stride(0) == n_frames * frames.stride(1)) {
+      // the frames of all signals are evenly spaced, rfft can read them
+      // from the input directly
+      windowed = input.as_strided({batch * n_frames, fft_size},
+                                  {frames.stride(1), frames.stride(2)});
+    } else {
+      windowed = frames.contiguous().view({batch * n_frames, fft_size});
+    }
+    auto out = at::rfft(windowed, 1, /* normalized */ false, onesided)
+                 .view({batch, n_frames, return_size, 2});
+    if (self.dim() == 1) {
+      return out.squeeze_(0);
+    } else {
+      return out;
+    }
+  }
+
+  // Otherwise correlate the input with the DFT basis, which also handles a
+  // frame_length larger than fft_size.
+  if (pad_end != 0) {
+    Tensor padded_input = at::zeros(self.type(), {batch, len});
+    padded_input.narrow(1, 0, input_len).copy_(input);
+    input = padded_input;
+  }
   // build ft kernel
   // k[omega, t] = cos (2 pi omega t / N) - j sin (2 pi omega t / N)
   double N = static_cast<double>(fft_size);
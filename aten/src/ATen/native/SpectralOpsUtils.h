@@ -1,8 +1,14 @@
 #pragma once
 
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <stdexcept>
 #include <sstream>
+#include <unordered_map>
+#include <utility>
 
 namespace at { namespace native {
 
@@ -34,4 +40,104 @@ inline int64_t infer_ft_complex_to_real_onesided_size(int64_t complex_size, int6
   }
 }
 
+// A least recently used cache of FFT plans (cuFFT plans, MKL descriptors),
+// so that transforms repeated with the same shapes do not make a new plan
+// every time. Params is a plain struct of everything the plan depends on;
+// it is hashed and compared bytewise, so it must be zero-filled (memset)
+// before its fields are set. Plans are shared, so that one which is evicted
+// while another thread uses it stays alive until that thread is done.
+template <typename Params, typename Plan>
+class FFTPlanCache {
+public:
+  explicit FFTPlanCache(int64_t max_size) : max_size_(max_size) {}
+
+  // Returns the plan for params, made by make_plan() on a miss
+  template <typename MakePlan>
+  std::shared_ptr<Plan> lookup(const Params& params, MakePlan make_plan) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = map_.find(params);
+    if (it != map_.end()) {
+      hits_++;
+      // move to the front of the list, i.e. most recently used
+      plans_.splice(plans_.begin(), plans_, it->second);
+      return it->second->second;
+    }
+    misses_++;
+    std::shared_ptr<Plan> plan(make_plan());
+    if (max_size_ > 0) {
+      plans_.emplace_front(params, plan);
+      map_.emplace(params, plans_.begin());
+      trim();
+    }
+    return plan;
+  }
+
+  int64_t size() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return plans_.size();
+  }
+  int64_t max_size() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return max_size_;
+  }
+  int64_t hits() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return hits_;
+  }
+  int64_t misses() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return misses_;
+  }
+
+  void set_max_size(int64_t max_size) {
+    if (max_size < 0) {
+      throw std::runtime_error("FFT plan cache size must be non-negative");
+    }
+    std::lock_guard<std::mutex> guard(mutex_);
+    max_size_ = max_size;
+    trim();
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    map_.clear();
+    plans_.clear();
+  }
+
+private:
+  struct ParamsHash {
+    size_t operator()(const Params& params) const {
+      // FNV-1a
+      auto bytes = reinterpret_cast<const uint8_t*>(&params);
+      size_t value = 14695981039346656037ull;
+      for (size_t i = 0; i < sizeof(Params); i++) {
+        value = (value ^ bytes[i]) * 1099511628211ull;
+      }
+      return value;
+    }
+  };
+
+  struct ParamsEqual {
+    bool operator()(const Params& a, const Params& b) const {
+      return std::memcmp(&a, &b, sizeof(Params)) == 0;
+    }
+  };
+
+  typedef std::list<std::pair<Params, std::shared_ptr<Plan>>> PlanList;
+
+  void trim() {
+    while (static_cast<int64_t>(plans_.size()) > max_size_) {
+      map_.erase(plans_.back().first);
+      plans_.pop_back();
+    }
+  }
+
+  std::mutex mutex_;
+  PlanList plans_;
+  std::unordered_map<Params, typename PlanList::iterator, ParamsHash, ParamsEqual> map_;
+  int64_t max_size_;
+  int64_t hits_ = 0;
+  int64_t misses_ = 0;
+};
+
 }} // at::native
@@ -12,7 +12,7 @@ void where_cpu(
     const at::Tensor& condition,
     const at::Tensor& self,
     const at::Tensor& other) {
-  at::CPU_tensor_apply4<scalar_t, uint8_t, scalar_t, scalar_t>(
+  at::CPU_tensor_parallel_apply4<scalar_t, uint8_t, scalar_t, scalar_t>(
       ret,
       condition,
       self,
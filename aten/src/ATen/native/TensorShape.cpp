@@ -6,6 +6,7 @@
 #include "ATen/optional.h"
 
 #include <algorithm>
+#include <sstream>
 
 namespace at {
 namespace native {
@@ -343,11 +344,32 @@ static inline std::vector<Tensor> get_stack_inputs(TensorList tensors, int64_t d
   return inputs;
 }
 
+static inline void check_stack_sizes(TensorList tensors) {
+  for (size_t i = 1; i < tensors.size(); ++i) {
+    if (!tensors[i].sizes().equals(tensors[0].sizes())) {
+      std::ostringstream first, other;
+      first << tensors[0].sizes();
+      other << tensors[i].sizes();
+      AT_ERROR("stack expects each tensor to be equal size, but got %s at entry 0 and %s at entry %zu",
+               first.str().c_str(), other.str().c_str(), i);
+    }
+  }
+}
+
 Tensor stack(TensorList tensors, int64_t dim) {
   if (tensors.size() == 0) {
     throw std::runtime_error("stack expects a non-empty TensorList");
   }
   dim = maybe_wrap_dim(dim, tensors[0].dim() + 1);
+  if (dim < tensors[0].dim() && tensors[0].numel() > 0) {
+    // Catting equally sized inputs along an existing dim lays them out in the
+    // (contiguous) result exactly like stacking them along it, so the result
+    // only needs a view instead of every input an unsqueeze.
+    check_stack_sizes(tensors);
+    auto sizes = tensors[0].sizes().vec();
+    sizes.insert(sizes.begin() + dim, tensors.size());
+    return at::cat(tensors, dim).view(sizes);
+  }
   return at::cat(get_stack_inputs(tensors, dim), dim);
 }
 
@@ -37,14 +37,27 @@ Tensor& _ ## op ## _out_cpu(Tensor& result, const Tensor& self) {             \
 }
 
 IMPLEMENT_UNARY_OP(abs)
+IMPLEMENT_UNARY_OP(acos)
+IMPLEMENT_UNARY_OP(asin)
+IMPLEMENT_UNARY_OP(atan)
 IMPLEMENT_UNARY_OP(ceil)
 IMPLEMENT_UNARY_OP(cos)
+IMPLEMENT_UNARY_OP(cosh)
+IMPLEMENT_UNARY_OP(erf)
 IMPLEMENT_UNARY_OP(exp)
+IMPLEMENT_UNARY_OP(expm1)
 IMPLEMENT_UNARY_OP(floor)
+IMPLEMENT_UNARY_OP(frac)
 IMPLEMENT_UNARY_OP(log)
+IMPLEMENT_UNARY_OP(log1p)
 IMPLEMENT_UNARY_OP(round)
+IMPLEMENT_UNARY_OP(rsqrt)
+IMPLEMENT_UNARY_OP(sigmoid)
 IMPLEMENT_UNARY_OP(sin)
+IMPLEMENT_UNARY_OP(sinh)
 IMPLEMENT_UNARY_OP(sqrt)
+IMPLEMENT_UNARY_OP(tan)
+IMPLEMENT_UNARY_OP(tanh)
 IMPLEMENT_UNARY_OP(trunc)
 
 }} // namespace at::native
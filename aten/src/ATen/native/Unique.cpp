@@ -1,58 +1,173 @@
 // Returns unique elements of input tensor.
+//
+// The elements are split into partitions by hash, and each partition is
+// deduplicated into its own hash map in parallel. The unique elements are
+// the concatenation of the partitions (sorted afterwards if asked to), and
+// the counts and inverse indices are collected in the same pass.
 
 #include "ATen/ATen.h"
 #include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
 
-#include <set>
+#include <algorithm>
+#include <cstdint>
 #include <tuple>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 namespace at {
 namespace native{
 
 namespace {
 
+constexpr int64_t UNIQUE_MAX_PARTITIONS = 64;
+
 template <typename scalar_t>
-std::tuple<Tensor, Tensor> _unique_cpu_template(
+std::tuple<Tensor, Tensor, Tensor> _unique_cpu_template(
     const Tensor& self,
     const bool sorted,
-    const bool return_inverse) {
+    const bool return_inverse,
+    const bool return_counts) {
   const Tensor& input = self.contiguous();
   const scalar_t* input_data = input.data<scalar_t>();
-  std::unordered_set<scalar_t> set(input_data, input_data + input.numel());
-  Tensor output = input.type().tensor({static_cast<int64_t>(set.size())});
-  scalar_t* output_data = output.data<scalar_t>();
+  int64_t numel = input.numel();
 
-  if (sorted) {
-    std::vector<scalar_t> vec(set.begin(), set.end());
-    std::sort(vec.begin(), vec.end());
-    std::copy(vec.begin(), vec.end(), output_data);
-  } else {
-    std::copy(set.begin(), set.end(), output_data);
+  // The number of partitions only depends on the size of the input, so the
+  // order of the unsorted output does not depend on the number of threads
+  int64_t num_partitions = std::min(
+      UNIQUE_MAX_PARTITIONS,
+      std::max<int64_t>(1, numel / internal::TBB_GRAIN_SIZE));
+
+  // order lists the elements of the partitions one after the other, each in
+  // the order of the input, so that each partition reads only its elements
+  std::vector<uint8_t> partition;
+  std::vector<int64_t> order;
+  std::vector<int64_t> partition_begin(num_partitions + 1, 0);
+  partition_begin[1] = numel;
+  if (num_partitions > 1) {
+    partition.resize(numel);
+    order.resize(numel);
+    const int64_t chunk = internal::TBB_GRAIN_SIZE;
+    const int64_t num_chunks = (numel + chunk - 1) / chunk;
+    std::vector<int64_t> chunk_offsets(num_chunks * num_partitions, 0);
+    parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+      std::hash<scalar_t> hash;
+      for (int64_t c = begin; c < end; c++) {
+        for (int64_t i = c * chunk; i < std::min(numel, (c + 1) * chunk); i++) {
+          uint64_t h = static_cast<uint64_t>(hash(input_data[i])) * 0x9E3779B97F4A7C15ULL;
+          partition[i] = static_cast<uint8_t>((h >> 32) % num_partitions);
+          chunk_offsets[c * num_partitions + partition[i]]++;
+        }
+      }
+    });
+    int64_t offset = 0;
+    for (int64_t p = 0; p < num_partitions; p++) {
+      partition_begin[p] = offset;
+      for (int64_t c = 0; c < num_chunks; c++) {
+        int64_t count = chunk_offsets[c * num_partitions + p];
+        chunk_offsets[c * num_partitions + p] = offset;
+        offset += count;
+      }
+    }
+    partition_begin[num_partitions] = offset;
+    parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t c = begin; c < end; c++) {
+        int64_t* next = &chunk_offsets[c * num_partitions];
+        for (int64_t i = c * chunk; i < std::min(numel, (c + 1) * chunk); i++) {
+          order[next[partition[i]]++] = i;
+        }
+      }
+    });
   }
 
   Tensor inverse_indices = self.type().toScalarType(kLong).tensor({0});
+  int64_t* inverse_indices_data = nullptr;
   if (return_inverse) {
     inverse_indices.resize_(input.sizes());
-    int64_t* inverse_indices_data = inverse_indices.data<int64_t>();
-    std::unordered_map<scalar_t, int64_t> inverse_map;
-    inverse_map.reserve(output.numel());
-    for (int i = 0; i < output.numel(); ++i) {
-      inverse_map[output_data[i]] = i;
+    inverse_indices_data = inverse_indices.data<int64_t>();
+  }
+
+  // the unique elements of each partition in order of first occurrence and
+  // their counts. The inverse indices are their positions in the partition
+  // until the output is assembled.
+  std::vector<std::vector<scalar_t>> keys(num_partitions);
+  std::vector<std::vector<int64_t>> counts(num_partitions);
+  parallel_for(0, num_partitions, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t p = begin; p < end; p++) {
+      std::unordered_map<scalar_t, int64_t> map;
+      for (int64_t j = partition_begin[p]; j < partition_begin[p + 1]; j++) {
+        int64_t i = num_partitions > 1 ? order[j] : j;
+        auto it = map.emplace(input_data[i], static_cast<int64_t>(keys[p].size()));
+        if (it.second) {
+          keys[p].push_back(input_data[i]);
+          counts[p].push_back(0);
+        }
+        counts[p][it.first->second]++;
+        if (return_inverse) {
+          inverse_indices_data[i] = it.first->second;
+        }
+      }
+    }
+  });
+
+  std::vector<int64_t> partition_offsets(num_partitions + 1, 0);
+  for (int64_t p = 0; p < num_partitions; p++) {
+    partition_offsets[p + 1] = partition_offsets[p] + keys[p].size();
+  }
+  int64_t num_unique = partition_offsets[num_partitions];
+  Tensor output = input.type().tensor({num_unique});
+  scalar_t* output_data = output.data<scalar_t>();
+  for (int64_t p = 0; p < num_partitions; p++) {
+    std::copy(keys[p].begin(), keys[p].end(), output_data + partition_offsets[p]);
+  }
+
+  // the position in the output of each element of each partition
+  std::vector<std::vector<int64_t>> positions(num_partitions);
+  if (sorted) {
+    std::sort(output_data, output_data + num_unique);
+    if (return_inverse || return_counts) {
+      parallel_for(0, num_partitions, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t p = begin; p < end; p++) {
+          positions[p].resize(keys[p].size());
+          for (size_t k = 0; k < keys[p].size(); k++) {
+            positions[p][k] =
+                std::lower_bound(output_data, output_data + num_unique, keys[p][k]) - output_data;
+          }
+        }
+      });
     }
-    for (int i = 0; i < input.numel(); ++i) {
-      inverse_indices_data[i] = inverse_map[input_data[i]];
+  }
+  auto position = [&](int64_t p, int64_t k) {
+    return sorted ? positions[p][k] : partition_offsets[p] + k;
+  };
+
+  if (return_inverse) {
+    parallel_for(0, numel, internal::TBB_GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        int64_t p = num_partitions > 1 ? partition[i] : 0;
+        inverse_indices_data[i] = position(p, inverse_indices_data[i]);
+      }
+    });
+  }
+
+  Tensor counts_tensor = self.type().toScalarType(kLong).tensor({0});
+  if (return_counts) {
+    counts_tensor.resize_({num_unique});
+    int64_t* counts_data = counts_tensor.data<int64_t>();
+    for (int64_t p = 0; p < num_partitions; p++) {
+      for (size_t k = 0; k < counts[p].size(); k++) {
+        counts_data[position(p, k)] = counts[p][k];
+      }
     }
   }
-  return std::make_tuple(output, inverse_indices);
+  return std::make_tuple(output, inverse_indices, counts_tensor);
 }
 } // namespace
 
-std::tuple<Tensor, Tensor>
-_unique_cpu(const Tensor& self, const bool sorted, const bool return_inverse) {
+std::tuple<Tensor, Tensor, Tensor>
+_unique_cpu(const Tensor& self, const bool sorted, const bool return_inverse, const bool return_counts) {
   return AT_DISPATCH_ALL_TYPES(self.type(), "unique", [&] {
-    return _unique_cpu_template<scalar_t>(self, sorted, return_inverse);
+    return _unique_cpu_template<scalar_t>(self, sorted, return_inverse, return_counts);
   });
 }
 
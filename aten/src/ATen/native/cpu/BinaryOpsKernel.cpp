@@ -0,0 +1,115 @@
+#include "ATen/native/cpu/BinaryOpsKernel.h"
+
+#include <functional>
+#include <type_traits>
+
+#include "ATen/Dispatch.h"
+#include "ATen/native/cpu/Loops.h"
+
+namespace at {
+namespace native {
+namespace {
+
+using namespace vec256;
+
+template <typename scalar_t>
+void div(Tensor& result, const Tensor& self, const Tensor& other, std::true_type /* is_floating_point */) {
+  binary_kernel_vec<scalar_t>(result, self, other,
+    [](scalar_t a, scalar_t b) -> scalar_t { return a / b; },
+    [](const Vec256<scalar_t>& a, const Vec256<scalar_t>& b) { return a / b; });
+}
+
+// Vec256 has no integer division.
+template <typename scalar_t>
+void div(Tensor& result, const Tensor& self, const Tensor& other, std::false_type /* is_floating_point */) {
+  binary_kernel<scalar_t, scalar_t, scalar_t>(result, self, other,
+    [](scalar_t a, scalar_t b) -> scalar_t { return a / b; });
+}
+
+template <template <class> class Op>
+void compare(Tensor& result, const Tensor& self, const Tensor& other, const char* name) {
+  AT_DISPATCH_ALL_TYPES(self.type(), name, [&] {
+    Op<scalar_t> op;
+    if (result.type().scalarType() == kByte) {
+      binary_kernel<uint8_t, scalar_t, scalar_t>(result, self, other,
+        [op](scalar_t a, scalar_t b) -> uint8_t { return op(a, b); });
+    } else {
+      binary_kernel<scalar_t, scalar_t, scalar_t>(result, self, other,
+        [op](scalar_t a, scalar_t b) -> scalar_t { return op(a, b); });
+    }
+  });
+}
+
+} // anonymous namespace
+
+static void add_kernel_impl(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha_scalar) {
+  AT_DISPATCH_ALL_TYPES(self.type(), "add", [&] {
+    auto alpha = alpha_scalar.to<scalar_t>();
+    Vec256<scalar_t> alpha_vec(alpha);
+    binary_kernel_vec<scalar_t>(result, self, other,
+      [=](scalar_t a, scalar_t b) -> scalar_t { return a + alpha * b; },
+      [=](const Vec256<scalar_t>& a, const Vec256<scalar_t>& b) { return a + alpha_vec * b; });
+  });
+}
+
+static void sub_kernel_impl(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha_scalar) {
+  AT_DISPATCH_ALL_TYPES(self.type(), "sub", [&] {
+    auto alpha = alpha_scalar.to<scalar_t>();
+    Vec256<scalar_t> alpha_vec(alpha);
+    binary_kernel_vec<scalar_t>(result, self, other,
+      [=](scalar_t a, scalar_t b) -> scalar_t { return a - alpha * b; },
+      [=](const Vec256<scalar_t>& a, const Vec256<scalar_t>& b) { return a - alpha_vec * b; });
+  });
+}
+
+static void mul_kernel_impl(Tensor& result, const Tensor& self, const Tensor& other) {
+  AT_DISPATCH_ALL_TYPES(self.type(), "mul", [&] {
+    binary_kernel_vec<scalar_t>(result, self, other,
+      [](scalar_t a, scalar_t b) -> scalar_t { return a * b; },
+      [](const Vec256<scalar_t>& a, const Vec256<scalar_t>& b) { return a * b; });
+  });
+}
+
+static void div_kernel_impl(Tensor& result, const Tensor& self, const Tensor& other) {
+  AT_DISPATCH_ALL_TYPES(self.type(), "div", [&] {
+    div<scalar_t>(result, self, other, std::is_floating_point<scalar_t>());
+  });
+}
+
+static void lt_kernel_impl(Tensor& result, const Tensor& self, const Tensor& other) {
+  compare<std::less>(result, self, other, "lt");
+}
+
+static void le_kernel_impl(Tensor& result, const Tensor& self, const Tensor& other) {
+  compare<std::less_equal>(result, self, other, "le");
+}
+
+static void gt_kernel_impl(Tensor& result, const Tensor& self, const Tensor& other) {
+  compare<std::greater>(result, self, other, "gt");
+}
+
+static void ge_kernel_impl(Tensor& result, const Tensor& self, const Tensor& other) {
+  compare<std::greater_equal>(result, self, other, "ge");
+}
+
+static void eq_kernel_impl(Tensor& result, const Tensor& self, const Tensor& other) {
+  compare<std::equal_to>(result, self, other, "eq");
+}
+
+static void ne_kernel_impl(Tensor& result, const Tensor& self, const Tensor& other) {
+  compare<std::not_equal_to>(result, self, other, "ne");
+}
+
+REGISTER_DISPATCH(add_kernel, &add_kernel_impl);
+REGISTER_DISPATCH(sub_kernel, &sub_kernel_impl);
+REGISTER_DISPATCH(mul_kernel, &mul_kernel_impl);
+REGISTER_DISPATCH(div_kernel, &div_kernel_impl);
+REGISTER_DISPATCH(lt_kernel, &lt_kernel_impl);
+REGISTER_DISPATCH(le_kernel, &le_kernel_impl);
+REGISTER_DISPATCH(gt_kernel, &gt_kernel_impl);
+REGISTER_DISPATCH(ge_kernel, &ge_kernel_impl);
+REGISTER_DISPATCH(eq_kernel, &eq_kernel_impl);
+REGISTER_DISPATCH(ne_kernel, &ne_kernel_impl);
+
+}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at {
+namespace native {
+
+// The kernels below compute `result` elementwise from `self` and `other`,
+// which have the sizes of `result` or broadcast to them and may have any
+// strides. `result` must not have overlapping elements. The comparison
+// kernels write 0 or 1 into a Byte `result` or into one of the type of `self`.
+using binary_fn = void(*)(Tensor& result, const Tensor& self, const Tensor& other);
+// Computes self + alpha * other, or self - alpha * other for sub_kernel.
+using add_fn = void(*)(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha);
+
+extern DispatchStub<add_fn> add_kernel;
+extern DispatchStub<add_fn> sub_kernel;
+extern DispatchStub<binary_fn> mul_kernel;
+extern DispatchStub<binary_fn> div_kernel;
+extern DispatchStub<binary_fn> lt_kernel;
+extern DispatchStub<binary_fn> le_kernel;
+extern DispatchStub<binary_fn> gt_kernel;
+extern DispatchStub<binary_fn> ge_kernel;
+extern DispatchStub<binary_fn> eq_kernel;
+extern DispatchStub<binary_fn> ne_kernel;
+
+}
+}
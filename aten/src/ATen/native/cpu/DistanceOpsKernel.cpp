@@ -0,0 +1,232 @@
+#include "ATen/native/cpu/DistanceOpsKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/cpu/vec256/vec256.h"
+
+namespace at {
+namespace native {
+
+using namespace vec256;
+
+// The rows of x2 are taken in blocks of about this many bytes, which stay in
+// L2 while they are compared with the rows of x1 of a task.
+static constexpr int64_t X2_BLOCK_BYTES = 128 * 1024;
+
+template <typename scalar_t>
+static inline scalar_t sign(scalar_t val) {
+  return (0 < val) - (val < 0);
+}
+
+template <typename scalar_t>
+struct Dist {
+  using Vec = Vec256<scalar_t>;
+
+  // Each norm maps the differences of the coordinates, reduces the mapped
+  // values and finishes the reduced one into the distance. backward is the
+  // gradient with respect to one difference, given the gradient of the
+  // distance. The norms with a vmap and vred are vectorized.
+
+  // Zero "norm": the number of coordinates that differ
+  struct zdist {
+    using vectorized = std::false_type;
+    static inline scalar_t map(scalar_t diff, scalar_t p) { return diff != 0; }
+    static inline scalar_t red(scalar_t agg, scalar_t up) { return agg + up; }
+    static inline scalar_t finish(scalar_t agg, scalar_t p) { return agg; }
+    static inline scalar_t backward(scalar_t diff, scalar_t grad, scalar_t dist, scalar_t p) { return 0; }
+  };
+
+  // One norm
+  struct odist {
+    using vectorized = std::true_type;
+    static inline scalar_t map(scalar_t diff, scalar_t p) { return std::abs(diff); }
+    static inline scalar_t red(scalar_t agg, scalar_t up) { return agg + up; }
+    static inline scalar_t finish(scalar_t agg, scalar_t p) { return agg; }
+    static inline Vec vmap(const Vec& diff) { return diff.abs(); }
+    static inline Vec vred(const Vec& agg, const Vec& up) { return agg + up; }
+    static inline scalar_t backward(scalar_t diff, scalar_t grad, scalar_t dist, scalar_t p) { return grad * sign(diff); }
+  };
+
+  // Two norm
+  struct tdist {
+    using vectorized = std::true_type;
+    static inline scalar_t map(scalar_t diff, scalar_t p) { return diff * diff; }
+    static inline scalar_t red(scalar_t agg, scalar_t up) { return agg + up; }
+    static inline scalar_t finish(scalar_t agg, scalar_t p) { return std::sqrt(agg); }
+    static inline Vec vmap(const Vec& diff) { return diff * diff; }
+    static inline Vec vred(const Vec& agg, const Vec& up) { return agg + up; }
+    static inline scalar_t backward(scalar_t diff, scalar_t grad, scalar_t dist, scalar_t p) { return dist == 0 ? 0 : grad * diff / dist; }
+  };
+
+  // Infinity norm
+  struct idist {
+    using vectorized = std::true_type;
+    static inline scalar_t map(scalar_t diff, scalar_t p) { return std::abs(diff); }
+    static inline scalar_t red(scalar_t agg, scalar_t up) { return std::max(agg, up); }
+    static inline scalar_t finish(scalar_t agg, scalar_t p) { return agg; }
+    static inline Vec vmap(const Vec& diff) { return diff.abs(); }
+    static inline Vec vred(const Vec& agg, const Vec& up) { return maximum(agg, up); }
+    static inline scalar_t backward(scalar_t diff, scalar_t grad, scalar_t dist, scalar_t p) { return grad * sign(diff) * (std::abs(diff) == dist); }
+  };
+
+  // General p norm
+  struct pdist {
+    using vectorized = std::false_type;
+    static inline scalar_t map(scalar_t diff, scalar_t p) { return std::pow(std::abs(diff), p); }
+    static inline scalar_t red(scalar_t agg, scalar_t up) { return agg + up; }
+    static inline scalar_t finish(scalar_t agg, scalar_t p) { return std::pow(agg, 1.0 / p); }
+    static inline scalar_t backward(scalar_t diff, scalar_t grad, scalar_t dist, scalar_t p) {
+      return dist == 0 || (p < 1 && diff == 0) ? 0 :
+          grad * sign(diff) * std::pow(std::abs(diff), p - 1) / std::pow(dist, p - 1);
+    }
+  };
+
+  template <typename F>
+  static inline scalar_t reduce_row(const scalar_t* a, const scalar_t* b, int64_t m, scalar_t p, std::false_type) {
+    scalar_t agg = 0;
+    for (int64_t k = 0; k != m; k++) {
+      agg = F::red(agg, F::map(a[k] - b[k], p));
+    }
+    return agg;
+  }
+
+  template <typename F>
+  static inline scalar_t reduce_row(const scalar_t* a, const scalar_t* b, int64_t m, scalar_t p, std::true_type) {
+    int64_t m_rounded = m - (m % Vec::size);
+    Vec acc(0);
+    int64_t k = 0;
+    for (; k != m_rounded; k += Vec::size) {
+      acc = F::vred(acc, F::vmap(Vec::s_load(a + k) - Vec::s_load(b + k)));
+    }
+    __at_align32__ scalar_t lanes[Vec::size];
+    acc.store(lanes);
+    scalar_t agg = 0;
+    for (int64_t l = 0; l != Vec::size; l++) {
+      agg = F::red(agg, lanes[l]);
+    }
+    for (; k != m; k++) {
+      agg = F::red(agg, F::map(a[k] - b[k], p));
+    }
+    return agg;
+  }
+
+  // Runs f(i, j_begin, j_end) over all the rows i of x1 and blocks of rows of
+  // x2, in parallel over both so that a few rows of x1 against many of x2
+  // are spread out as well. The tasks go through all i of a block of x2
+  // before the next block.
+  template <typename F>
+  static void parallel_blocks(int64_t r1, int64_t r2, int64_t m, const F& f) {
+    if (r1 == 0 || r2 == 0) {
+      return;
+    }
+    int64_t block = std::max<int64_t>(1, X2_BLOCK_BYTES / std::max<int64_t>(1, m * sizeof(scalar_t)));
+    block = std::min(block, r2);
+    int64_t num_blocks = (r2 + block - 1) / block;
+    int64_t grain = std::max<int64_t>(1, internal::TBB_GRAIN_SIZE / std::max<int64_t>(1, block * m));
+    parallel_for(0, r1 * num_blocks, grain, [&](int64_t begin, int64_t end) {
+      for (int64_t t = begin; t != end; t++) {
+        int64_t j = (t / r1) * block;
+        f(t % r1, j, std::min(r2, j + block));
+      }
+    });
+  }
+
+  template <typename F>
+  static void run_forward(Tensor& result, const Tensor& x1, const Tensor& x2, scalar_t p) {
+    const scalar_t* x1_data = x1.data<scalar_t>();
+    const scalar_t* x2_data = x2.data<scalar_t>();
+    scalar_t* res = result.data<scalar_t>();
+    int64_t r1 = x1.size(0);
+    int64_t r2 = x2.size(0);
+    int64_t m = x1.size(1);
+    parallel_blocks(r1, r2, m, [=](int64_t i, int64_t j_begin, int64_t j_end) {
+      const scalar_t* a = x1_data + i * m;
+      for (int64_t j = j_begin; j != j_end; j++) {
+        scalar_t agg = reduce_row<F>(a, x2_data + j * m, m, p, typename F::vectorized());
+        res[i * r2 + j] = F::finish(agg, p);
+      }
+    });
+  }
+
+  template <typename F>
+  static void run_backward(Tensor& result, const Tensor& grad, const Tensor& x1, const Tensor& x2, scalar_t p, const Tensor& dist) {
+    const scalar_t* grad_data = grad.data<scalar_t>();
+    const scalar_t* dist_data = dist.data<scalar_t>();
+    const scalar_t* x1_data = x1.data<scalar_t>();
+    const scalar_t* x2_data = x2.data<scalar_t>();
+    scalar_t* res = result.data<scalar_t>();
+    int64_t r1 = x1.size(0);
+    int64_t r2 = x2.size(0);
+    int64_t m = x1.size(1);
+    // Rows of the result are summed over all of x2, so only parallel over
+    // the rows of x1
+    int64_t grain = std::max<int64_t>(1, internal::TBB_GRAIN_SIZE / std::max<int64_t>(1, r2 * m));
+    parallel_for(0, r1, grain, [=](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i != end; i++) {
+        const scalar_t* a = x1_data + i * m;
+        scalar_t* out = res + i * m;
+        for (int64_t j = 0; j != r2; j++) {
+          scalar_t g = grad_data[i * r2 + j];
+          if (g == 0) {
+            continue;
+          }
+          scalar_t d = dist_data[i * r2 + j];
+          const scalar_t* b = x2_data + j * m;
+          for (int64_t k = 0; k != m; k++) {
+            out[k] += F::backward(a[k] - b[k], g, d, p);
+          }
+        }
+      }
+    });
+  }
+
+  static void apply(Tensor& result, const Tensor& x1, const Tensor& x2, scalar_t p) {
+    if (p == 0.0) {
+      run_forward<zdist>(result, x1, x2, p);
+    } else if (p == 1.0) {
+      run_forward<odist>(result, x1, x2, p);
+    } else if (p == 2.0) {
+      run_forward<tdist>(result, x1, x2, p);
+    } else if (std::isinf(p)) {
+      run_forward<idist>(result, x1, x2, p);
+    } else {
+      run_forward<pdist>(result, x1, x2, p);
+    }
+  }
+
+  static void apply_backward(Tensor& result, const Tensor& grad, const Tensor& x1, const Tensor& x2, scalar_t p, const Tensor& dist) {
+    if (p == 0.0) {
+      return;
+    } else if (p == 1.0) {
+      run_backward<odist>(result, grad, x1, x2, p, dist);
+    } else if (p == 2.0) {
+      run_backward<tdist>(result, grad, x1, x2, p, dist);
+    } else if (std::isinf(p)) {
+      run_backward<idist>(result, grad, x1, x2, p, dist);
+    } else {
+      run_backward<pdist>(result, grad, x1, x2, p, dist);
+    }
+  }
+};
+
+static void cdist_kernel_impl(Tensor& result, const Tensor& x1, const Tensor& x2, double p) {
+  AT_DISPATCH_FLOATING_TYPES(x1.type(), "cdist", [&] {
+    Dist<scalar_t>::apply(result, x1, x2, p);
+  });
+}
+
+static void cdist_backward_kernel_impl(Tensor& result, const Tensor& grad, const Tensor& x1, const Tensor& x2, double p, const Tensor& dist) {
+  AT_DISPATCH_FLOATING_TYPES(x1.type(), "cdist_backward", [&] {
+    Dist<scalar_t>::apply_backward(result, grad, x1, x2, p, dist);
+  });
+}
+
+REGISTER_DISPATCH(cdist_kernel, &cdist_kernel_impl);
+REGISTER_DISPATCH(cdist_backward_kernel, &cdist_backward_kernel_impl);
+
+}
+}
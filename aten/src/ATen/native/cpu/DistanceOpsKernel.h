@@ -0,0 +1,32 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at {
+namespace native {
+
+// The p-norm distances between the rows of x1 [r1 x m] and the rows of x2
+// [r2 x m], written to result [r1 x r2]. x1 and x2 have to be contiguous.
+using cdist_fn = void (*)(
+    Tensor& result,
+    const Tensor& x1,
+    const Tensor& x2,
+    double p);
+
+// The gradient of cdist with respect to x1, given the gradient grad and the
+// distances dist [r1 x r2]. result [r1 x m] has to be zero-filled, and all
+// inputs contiguous.
+using cdist_backward_fn = void (*)(
+    Tensor& result,
+    const Tensor& grad,
+    const Tensor& x1,
+    const Tensor& x2,
+    double p,
+    const Tensor& dist);
+
+extern DispatchStub<cdist_fn> cdist_kernel;
+extern DispatchStub<cdist_backward_fn> cdist_backward_kernel;
+
+}
+}
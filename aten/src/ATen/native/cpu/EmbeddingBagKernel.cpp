@@ -0,0 +1,125 @@
+#include "ATen/native/cpu/EmbeddingBagKernel.h"
+
+#include <algorithm>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/cpu/vec256/vec256.h"
+
+namespace at {
+namespace native {
+
+using namespace vec256;
+
+// How many indices ahead the rows of weight are prefetched. The rows are
+// gathered from all over a big table, so this hides the misses to memory
+// behind the additions of the rows that are already on their way.
+static constexpr int64_t PREFETCH_DISTANCE = 16;
+
+template <typename scalar_t>
+static inline void prefetch_row(const scalar_t* row, int64_t ddim) {
+#if defined(__GNUC__)
+  for (int64_t j = 0; j < ddim; j += 64 / sizeof(scalar_t)) {
+    __builtin_prefetch(row + j, 0 /* read */, 3 /* keep in all caches */);
+  }
+#endif
+}
+
+template <typename scalar_t>
+struct EmbeddingBag {
+  using Vec = Vec256<scalar_t>;
+
+  static void apply(
+      Tensor& output,
+      const Tensor& weight,
+      const Tensor& indices,
+      const Tensor& offsets,
+      int64_t mode) {
+    auto out = output.data<scalar_t>();
+    auto weight_data = weight.data<scalar_t>();
+    auto indices_data = indices.data<int64_t>();
+    auto offsets_data = offsets.data<int64_t>();
+    int64_t num_bags = offsets.numel();
+    int64_t numel = indices.numel();
+    int64_t ddim = weight.size(1);
+
+    auto bag = [=](int64_t b) {
+      // the indices before the first offset go to the first bag
+      int64_t start = b == 0 ? 0 : offsets_data[b];
+      int64_t end = b + 1 < num_bags ? offsets_data[b + 1] : numel;
+      sum_bag(
+          out + b * ddim, weight_data, indices_data, start, end, numel, ddim);
+      if (mode == 1 && end - start > 1) { // MODE_MEAN
+        scale(out + b * ddim, ddim, scalar_t(1) / (end - start));
+      }
+    };
+
+    int64_t work = numel * ddim;
+    if (work < internal::TBB_GRAIN_SIZE || num_bags == 1) {
+      for (int64_t b = 0; b < num_bags; b++) {
+        bag(b);
+      }
+      return;
+    }
+    // bags of about TBB_GRAIN_SIZE elements in total per task
+    int64_t grain = std::max<int64_t>(
+        1, num_bags * internal::TBB_GRAIN_SIZE / work);
+    parallel_for(0, num_bags, grain, [&](int64_t begin, int64_t end) {
+      for (int64_t b = begin; b != end; b++) {
+        bag(b);
+      }
+    });
+  }
+
+  static void sum_bag(
+      scalar_t* out,
+      const scalar_t* weight,
+      const int64_t* indices,
+      int64_t start,
+      int64_t end,
+      int64_t numel,
+      int64_t ddim) {
+    int64_t ddim_rounded = ddim - (ddim % Vec::size);
+    for (int64_t i = start; i < end; i++) {
+      if (i + PREFETCH_DISTANCE < numel) {
+        prefetch_row(weight + ddim * indices[i + PREFETCH_DISTANCE], ddim);
+      }
+      const scalar_t* row = weight + ddim * indices[i];
+      int64_t j = 0;
+      for (; j != ddim_rounded; j += Vec::size) {
+        (Vec::s_load(out + j) + Vec::s_load(row + j)).store(out + j);
+      }
+      for (; j != ddim; j++) {
+        out[j] += row[j];
+      }
+    }
+  }
+
+  static void scale(scalar_t* out, int64_t ddim, scalar_t factor) {
+    int64_t ddim_rounded = ddim - (ddim % Vec::size);
+    Vec factor_vec(factor);
+    int64_t j = 0;
+    for (; j != ddim_rounded; j += Vec::size) {
+      (Vec::s_load(out + j) * factor_vec).store(out + j);
+    }
+    for (; j != ddim; j++) {
+      out[j] *= factor;
+    }
+  }
+};
+
+static void embedding_bag_kernel_impl(
+    Tensor& output,
+    const Tensor& weight,
+    const Tensor& indices,
+    const Tensor& offsets,
+    int64_t mode) {
+  AT_DISPATCH_FLOATING_TYPES(weight.type(), "embedding_bag", [&] {
+    EmbeddingBag<scalar_t>::apply(output, weight, indices, offsets, mode);
+  });
+}
+
+REGISTER_DISPATCH(embedding_bag_kernel, &embedding_bag_kernel_impl);
+
+}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at {
+namespace native {
+
+// Adds up the rows of weight selected by indices into one row of output per
+// bag, where bag b starts at offsets[b]. With mode 1 (mean), every bag is then
+// divided by its number of indices. output has to be zero-filled and weight
+// contiguous.
+using embedding_bag_fn = void (*)(
+    Tensor& output,
+    const Tensor& weight,
+    const Tensor& indices,
+    const Tensor& offsets,
+    int64_t mode);
+
+extern DispatchStub<embedding_bag_fn> embedding_bag_kernel;
+
+}
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+// Elementwise loops over tensors of any strides for the kernels in this
+// directory. The files including this header are compiled once per CPU
+// capability, so everything here lives in an anonymous namespace to keep the
+// differently compiled copies of the templates apart.
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "ATen/ATen.h"
+#include "ATen/Parallel.h"
+#include "ATen/cpu/vec256/vec256.h"
+
+namespace at {
+namespace native {
+namespace {
+
+// The dimensions of an elementwise loop over NARGS tensors, the output first,
+// with the strides in elements of every tensor along them. The inputs
+// broadcast to the sizes of the output: they may have fewer dimensions, and
+// dimensions of size 1, which get stride 0. The dimensions are ordered
+// innermost (smallest output stride) first, size-1 dimensions are dropped and
+// neighbours that can be walked as one are merged, so that e.g. adding two
+// contiguous tensors is a single run of numel elements.
+template <int NARGS>
+struct LoopDims {
+  struct Dim {
+    int64_t size;
+    std::array<int64_t, NARGS> stride;
+  };
+
+  explicit LoopDims(const std::array<const Tensor*, NARGS>& tensors) {
+    const Tensor& out = *tensors[0];
+    int64_t ndim = out.dim();
+    std::vector<Dim> unsorted;
+    for (int64_t d = ndim - 1; d >= 0; d--) {
+      Dim dim;
+      dim.size = out.size(d);
+      if (dim.size == 1) {
+        continue;
+      }
+      for (int k = 0; k < NARGS; k++) {
+        const Tensor& t = *tensors[k];
+        int64_t td = d - (ndim - t.dim());
+        AT_ASSERT(td < 0 || t.size(td) == 1 || t.size(td) == dim.size,
+                  "size mismatch in elementwise loop");
+        dim.stride[k] = (td >= 0 && t.size(td) != 1) ? t.stride(td) : 0;
+      }
+      unsorted.push_back(dim);
+    }
+    std::stable_sort(unsorted.begin(), unsorted.end(), [](const Dim& a, const Dim& b) {
+      return a.stride[0] < b.stride[0];
+    });
+    for (const auto& dim : unsorted) {
+      if (!dims.empty() && can_merge(dims.back(), dim)) {
+        dims.back().size *= dim.size;
+      } else {
+        dims.push_back(dim);
+      }
+    }
+    if (dims.empty()) {
+      Dim dim;
+      dim.size = 1;
+      dim.stride.fill(0);
+      dims.push_back(dim);
+    }
+  }
+
+  static bool can_merge(const Dim& inner, const Dim& outer) {
+    for (int k = 0; k < NARGS; k++) {
+      if (outer.stride[k] != inner.size * inner.stride[k]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::vector<Dim> dims;
+};
+
+// Walks over the positions of a LoopDims, innermost first, and keeps track of
+// the offsets of every tensor at the current position.
+template <int NARGS>
+struct LoopCounter {
+  LoopCounter(const LoopDims<NARGS>& loop, int64_t linear)
+    : dims(loop.dims), index(dims.size()) {
+    offset.fill(0);
+    for (size_t d = 0; d != dims.size(); d++) {
+      index[d] = linear % dims[d].size;
+      linear /= dims[d].size;
+      for (int k = 0; k < NARGS; k++) {
+        offset[k] += index[d] * dims[d].stride[k];
+      }
+    }
+  }
+
+  // Number of positions left along the innermost dimension.
+  int64_t remaining() const {
+    return dims[0].size - index[0];
+  }
+
+  // Moves `step` positions along the innermost dimension, at most up to its
+  // end, and carries over into the outer dimensions.
+  void advance(int64_t step) {
+    index[0] += step;
+    for (int k = 0; k < NARGS; k++) {
+      offset[k] += step * dims[0].stride[k];
+    }
+    for (size_t d = 0; d + 1 < dims.size() && index[d] == dims[d].size; d++) {
+      for (int k = 0; k < NARGS; k++) {
+        offset[k] += dims[d + 1].stride[k] - dims[d].size * dims[d].stride[k];
+      }
+      index[d] = 0;
+      index[d + 1]++;
+    }
+  }
+
+  const std::vector<typename LoopDims<NARGS>::Dim>& dims;
+  std::vector<int64_t> index;
+  std::array<int64_t, NARGS> offset;
+};
+
+// Splits the elements of `out` into chunks that are processed in parallel and
+// calls run(out, a, b, strides, n) for each run of n elements along the
+// innermost dimension. A chunk may start and end in the middle of a run.
+template <typename out_t, typename a_t, typename b_t, typename Run>
+void binary_loop(Tensor& out, const Tensor& a, const Tensor& b, const Run& run) {
+  std::array<const Tensor*, 3> tensors = {{&out, &a, &b}};
+  LoopDims<3> loop(tensors);
+  out_t* out_data = out.data<out_t>();
+  const a_t* a_data = a.data<a_t>();
+  const b_t* b_data = b.data<b_t>();
+  const auto& strides = loop.dims[0].stride;
+  parallel_for(0, out.numel(), internal::TBB_GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+    LoopCounter<3> counter(loop, begin);
+    while (begin < end) {
+      int64_t n = std::min(counter.remaining(), end - begin);
+      const auto& offset = counter.offset;
+      run(out_data + offset[0], a_data + offset[1], b_data + offset[2], strides, n);
+      counter.advance(n);
+      begin += n;
+    }
+  });
+}
+
+template <typename out_t, typename a_t, typename b_t, typename Op>
+inline void binary_run(out_t* out, const a_t* a, const b_t* b,
+                       const std::array<int64_t, 3>& strides, int64_t n, const Op& op) {
+  if (strides[0] == 1 && strides[1] == 1 && strides[2] == 1) {
+    // Lets the compiler vectorize the common contiguous case.
+    for (int64_t i = 0; i < n; i++) {
+      out[i] = op(a[i], b[i]);
+    }
+  } else {
+    for (int64_t i = 0; i < n; i++) {
+      out[i * strides[0]] = op(a[i * strides[1]], b[i * strides[2]]);
+    }
+  }
+}
+
+// Computes out = op(a, b) elementwise, where `a` and `b` broadcast to the
+// sizes of `out` and `out` has no overlapping elements.
+template <typename out_t, typename a_t, typename b_t, typename Op>
+void binary_kernel(Tensor& out, const Tensor& a, const Tensor& b, const Op& op) {
+  binary_loop<out_t, a_t, b_t>(out, a, b, [&op](
+      out_t* out, const a_t* a, const b_t* b, const std::array<int64_t, 3>& strides, int64_t n) {
+    binary_run(out, a, b, strides, n, op);
+  });
+}
+
+// Like binary_kernel, with `vop` the Vec256 version of `op`. It is used for
+// runs along which the output and the inputs are contiguous, or an input is
+// a broadcast scalar, and `op` for the rest.
+template <typename scalar_t, typename Op, typename VecOp>
+void binary_kernel_vec(Tensor& out, const Tensor& a, const Tensor& b, const Op& op, const VecOp& vop) {
+  using Vec = vec256::Vec256<scalar_t>;
+  binary_loop<scalar_t, scalar_t, scalar_t>(out, a, b, [&](
+      scalar_t* out, const scalar_t* a, const scalar_t* b,
+      const std::array<int64_t, 3>& strides, int64_t n) {
+    int64_t i = 0;
+    if (strides[0] == 1 && strides[1] == 1 && strides[2] == 1) {
+      for (; i + Vec::size <= n; i += Vec::size) {
+        vop(Vec::s_load(a + i), Vec::s_load(b + i)).store(out + i);
+      }
+    } else if (strides[0] == 1 && strides[1] == 1 && strides[2] == 0) {
+      Vec b_vec(*b);
+      for (; i + Vec::size <= n; i += Vec::size) {
+        vop(Vec::s_load(a + i), b_vec).store(out + i);
+      }
+    } else if (strides[0] == 1 && strides[1] == 0 && strides[2] == 1) {
+      Vec a_vec(*a);
+      for (; i + Vec::size <= n; i += Vec::size) {
+        vop(a_vec, Vec::s_load(b + i)).store(out + i);
+      }
+    }
+    binary_run(out + i * strides[0], a + i * strides[1], b + i * strides[2], strides, n - i, op);
+  });
+}
+
+}  // namespace
+}  // namespace native
+}  // namespace at
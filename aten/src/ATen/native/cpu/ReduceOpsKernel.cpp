@@ -1,154 +1,596 @@
 #include "ATen/native/cpu/ReduceOpsKernel.h"
 
-#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
 
 #include "ATen/Dispatch.h"
 #include "ATen/Parallel.h"
-#include "ATen/optional.h"
 #include "ATen/cpu/vec256/vec256.h"
 
 namespace at {
 namespace native {
+namespace {
 
 using namespace vec256;
 
-static inline int64_t round_down(int64_t a, int64_t m) {
-  return a - (a % m);
-}
+// With fewer outputs than this, each output is reduced in parallel instead of
+// computing the outputs in parallel, which would leave most threads idle.
+static constexpr int64_t MIN_PARALLEL_OUTPUTS = 64;
+
+// A dimension of a reduction, with the strides in elements of the input and
+// the output along it. The output stride of a reduced dimension is 0.
+struct ReduceDim {
+  int64_t size;
+  int64_t in_stride;
+  int64_t out_stride;
+};
+
+// Walks over the positions of a list of dimensions, innermost first, and
+// keeps track of the input and output offsets of the current position.
+struct DimCounter {
+  DimCounter(const std::vector<ReduceDim>& dims, int64_t linear)
+    : dims(dims), index(dims.size()), in_offset(0), out_offset(0) {
+    for (size_t d = 0; d != dims.size(); d++) {
+      index[d] = linear % dims[d].size;
+      linear /= dims[d].size;
+      in_offset += index[d] * dims[d].in_stride;
+      out_offset += index[d] * dims[d].out_stride;
+    }
+  }
+
+  // Number of positions left along the innermost dimension.
+  int64_t remaining() const {
+    return dims[0].size - index[0];
+  }
 
-template<typename F>
-static void parallel_for(int64_t end, int64_t step, bool parallelize, F func) {
-  if (parallelize) {
-    tbb::parallel_for<int64_t>(0, end, step, func);
-  } else {
-    for (int64_t i = 0; i != end; i += step) {
-      func(i);
+  // Moves `step` positions along the innermost dimension, at most up to its
+  // end, and carries over into the outer dimensions.
+  void advance(int64_t step) {
+    index[0] += step;
+    in_offset += step * dims[0].in_stride;
+    out_offset += step * dims[0].out_stride;
+    for (size_t d = 0; d + 1 < dims.size() && index[d] == dims[d].size; d++) {
+      in_offset += dims[d + 1].in_stride - dims[d].size * dims[d].in_stride;
+      out_offset += dims[d + 1].out_stride - dims[d].size * dims[d].out_stride;
+      index[d] = 0;
+      index[d + 1]++;
     }
   }
+
+  const std::vector<ReduceDim>& dims;
+  std::vector<int64_t> index;
+  int64_t in_offset;
+  int64_t out_offset;
+};
+
+// Sorts dims innermost (smallest input stride) first and merges neighbours
+// that can be walked as one dimension, so that e.g. reducing all of a
+// contiguous tensor is a single run of numel elements. An empty list becomes
+// a single dimension of size 1.
+static void coalesce(std::vector<ReduceDim>& dims) {
+  std::stable_sort(dims.begin(), dims.end(), [](const ReduceDim& a, const ReduceDim& b) {
+    return a.in_stride < b.in_stride;
+  });
+  std::vector<ReduceDim> merged;
+  for (const auto& dim : dims) {
+    if (!merged.empty()) {
+      auto& inner = merged.back();
+      if (dim.in_stride == inner.size * inner.in_stride &&
+          dim.out_stride == inner.size * inner.out_stride) {
+        inner.size *= dim.size;
+        continue;
+      }
+    }
+    merged.push_back(dim);
+  }
+  if (merged.empty()) {
+    merged.push_back({1, 0, 0});
+  }
+  dims.swap(merged);
 }
 
-static tbb::affinity_partitioner ap;
+template <typename T>
+static inline T max_propagate_nan(T a, T b) {
+  return (a > b || a != a) ? a : b;
+}
 
-// Vectorized reduction defined by reduce operation `Op` with identity `ident`.
-// The reduction is built on top of reduce128, which reduces down a column
-// 128 bytes wide (WIDTH scalar elements). The width of 128 bytes is chosen
-// because of the "adjacent cache line prefetch" behavior on x86 CPUs.
-template<typename scalar_t, template <class> class Op, int ident>
-struct Reduction {
-  // reduction width in number of scalar elements
-  static constexpr int WIDTH = 128 / sizeof(scalar_t);
+template <typename T>
+static inline T min_propagate_nan(T a, T b) {
+  return (a < b || a != a) ? a : b;
+}
+
+template <typename T>
+static inline T lowest() {
+  return std::numeric_limits<T>::has_infinity
+      ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+}
+
+template <typename T>
+static inline T highest() {
+  return std::numeric_limits<T>::has_infinity
+      ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+}
+
+// A reduction is defined by its Ops:
+//   acc_t                the type of the running state
+//   identity()           the state of an empty reduction
+//   reduce(acc, x)       adds element x to the state
+//   combine(a, b)        merges the states of two disjoint parts
+//   project(acc, n)      turns the state of n elements into the result
+// Ops with `vectorized` set have acc_t == scalar_t and also provide
+// reduce(Vec256 acc, Vec256 x), for which every lane is a separate state.
 
+template <typename scalar_t>
+struct SumOps {
+  using acc_t = scalar_t;
   using Vec = Vec256<scalar_t>;
-  using Reduce = Op<Vec>;
-  using ReduceScalar = Op<scalar_t>;
+  static constexpr bool vectorized = true;
+  acc_t identity() const { return 0; }
+  acc_t reduce(acc_t acc, scalar_t x) const { return acc + x; }
+  Vec reduce(Vec acc, Vec x) const { return acc + x; }
+  acc_t combine(acc_t a, acc_t b) const { return a + b; }
+  scalar_t project(acc_t acc, int64_t /*n*/) const { return acc; }
+};
+
+template <typename scalar_t>
+struct MeanOps : SumOps<scalar_t> {
+  scalar_t project(scalar_t acc, int64_t n) const { return acc / n; }
+};
 
-  static void apply(Tensor& res, const Tensor& self, at::optional<int64_t> dim) {
-    internal::init_tbb_num_threads();
+template <typename scalar_t>
+struct ProdOps {
+  using acc_t = scalar_t;
+  using Vec = Vec256<scalar_t>;
+  static constexpr bool vectorized = true;
+  acc_t identity() const { return 1; }
+  acc_t reduce(acc_t acc, scalar_t x) const { return acc * x; }
+  Vec reduce(Vec acc, Vec x) const { return acc * x; }
+  acc_t combine(acc_t a, acc_t b) const { return a * b; }
+  scalar_t project(acc_t acc, int64_t /*n*/) const { return acc; }
+};
+
+template <typename scalar_t>
+struct MaxOps {
+  using acc_t = scalar_t;
+  using Vec = Vec256<scalar_t>;
+  static constexpr bool vectorized = true;
+  acc_t identity() const { return lowest<scalar_t>(); }
+  acc_t reduce(acc_t acc, scalar_t x) const { return max_propagate_nan(acc, x); }
+  Vec reduce(Vec acc, Vec x) const { return maximum(acc, x); }
+  acc_t combine(acc_t a, acc_t b) const { return max_propagate_nan(a, b); }
+  scalar_t project(acc_t acc, int64_t /*n*/) const { return acc; }
+};
+
+template <typename scalar_t>
+struct MinOps {
+  using acc_t = scalar_t;
+  using Vec = Vec256<scalar_t>;
+  static constexpr bool vectorized = true;
+  acc_t identity() const { return highest<scalar_t>(); }
+  acc_t reduce(acc_t acc, scalar_t x) const { return min_propagate_nan(acc, x); }
+  Vec reduce(Vec acc, Vec x) const { return minimum(acc, x); }
+  acc_t combine(acc_t a, acc_t b) const { return min_propagate_nan(a, b); }
+  scalar_t project(acc_t acc, int64_t /*n*/) const { return acc; }
+};
+
+// number of non-zero elements
+template <typename scalar_t>
+struct NormZeroOps {
+  using acc_t = scalar_t;
+  static constexpr bool vectorized = false;
+  acc_t identity() const { return 0; }
+  acc_t reduce(acc_t acc, scalar_t x) const { return acc + (x != 0); }
+  acc_t combine(acc_t a, acc_t b) const { return a + b; }
+  scalar_t project(acc_t acc, int64_t /*n*/) const { return acc; }
+};
+
+template <typename scalar_t>
+struct NormOneOps {
+  using acc_t = scalar_t;
+  using Vec = Vec256<scalar_t>;
+  static constexpr bool vectorized = true;
+  acc_t identity() const { return 0; }
+  acc_t reduce(acc_t acc, scalar_t x) const { return acc + std::abs(x); }
+  Vec reduce(Vec acc, Vec x) const { return acc + x.abs(); }
+  acc_t combine(acc_t a, acc_t b) const { return a + b; }
+  scalar_t project(acc_t acc, int64_t /*n*/) const { return acc; }
+};
+
+template <typename scalar_t>
+struct NormTwoOps {
+  using acc_t = scalar_t;
+  using Vec = Vec256<scalar_t>;
+  static constexpr bool vectorized = true;
+  acc_t identity() const { return 0; }
+  acc_t reduce(acc_t acc, scalar_t x) const { return acc + x * x; }
+  Vec reduce(Vec acc, Vec x) const { return acc + x * x; }
+  acc_t combine(acc_t a, acc_t b) const { return a + b; }
+  scalar_t project(acc_t acc, int64_t /*n*/) const { return std::sqrt(acc); }
+};
+
+// largest absolute value
+template <typename scalar_t>
+struct NormInfOps {
+  using acc_t = scalar_t;
+  using Vec = Vec256<scalar_t>;
+  static constexpr bool vectorized = true;
+  acc_t identity() const { return 0; }
+  acc_t reduce(acc_t acc, scalar_t x) const { return max_propagate_nan(acc, std::abs(x)); }
+  Vec reduce(Vec acc, Vec x) const { return maximum(acc, x.abs()); }
+  acc_t combine(acc_t a, acc_t b) const { return max_propagate_nan(a, b); }
+  scalar_t project(acc_t acc, int64_t /*n*/) const { return acc; }
+};
+
+template <typename scalar_t>
+struct NormOps {
+  using acc_t = scalar_t;
+  static constexpr bool vectorized = false;
+  scalar_t p;
+  acc_t identity() const { return 0; }
+  acc_t reduce(acc_t acc, scalar_t x) const { return acc + std::pow(std::abs(x), p); }
+  acc_t combine(acc_t a, acc_t b) const { return a + b; }
+  scalar_t project(acc_t acc, int64_t /*n*/) const { return std::pow(acc, 1 / p); }
+};
+
+// Running mean and sum of squared deviations of n elements (Welford), kept in
+// double like the accreal of TH.
+struct WelfordData {
+  double mean;
+  double m2;
+  int64_t n;
+};
+
+template <typename scalar_t>
+struct VarOps {
+  using acc_t = WelfordData;
+  static constexpr bool vectorized = false;
+  bool unbiased;
+  bool take_sqrt;
+  acc_t identity() const { return {0, 0, 0}; }
+  acc_t reduce(acc_t acc, scalar_t x) const {
+    acc.n++;
+    double delta = x - acc.mean;
+    acc.mean += delta / acc.n;
+    acc.m2 += delta * (x - acc.mean);
+    return acc;
+  }
+  acc_t combine(acc_t a, acc_t b) const {
+    if (a.n == 0) return b;
+    if (b.n == 0) return a;
+    int64_t n = a.n + b.n;
+    double delta = b.mean - a.mean;
+    double weight = static_cast<double>(a.n) * b.n / n;
+    return {a.mean + delta * b.n / n, a.m2 + b.m2 + delta * delta * weight, n};
+  }
+  scalar_t project(acc_t acc, int64_t /*n*/) const {
+    double var = acc.m2 / (acc.n - unbiased);
+    return take_sqrt ? std::sqrt(var) : var;
+  }
+};
+
+// Reduces a tensor of any strides over any set of its dimensions.
+//
+// The dimensions are split into the kept and the reduced ones and both are
+// coalesced. If the innermost reduced dimension is contiguous, each output
+// is the reduction of runs of contiguous elements, which the vectorized Ops
+// reduce in 128 byte steps (the two cache lines the "adjacent cache line
+// prefetch" of x86 CPUs fetches together) into four vector accumulators.
+// Otherwise, if the innermost kept dimension is contiguous, as when reducing
+// over the first dimension of a matrix, blocks of 128 bytes worth of adjacent
+// outputs are reduced at once so that every input position loads full
+// vectors. Everything else runs a scalar loop over the strides.
+template <typename scalar_t, typename Ops>
+struct Reduction {
+  using acc_t = typename Ops::acc_t;
+  using Vec = Vec256<scalar_t>;
+  using vectorized = std::integral_constant<bool, Ops::vectorized>;
+
+  // block width in number of scalar elements
+  static constexpr int64_t WIDTH = 4 * Vec::size;
+
+  Reduction(Tensor& result, const Tensor& self, IntList dims, Ops ops)
+    : ops(ops), in(self.data<scalar_t>()), out(result.data<scalar_t>()) {
+    int64_t ndim = self.dim();
+    std::vector<bool> is_reduced(ndim, dims.empty());
+    for (auto d : dims) {
+      is_reduced[d] = true;
+    }
+    for (int64_t d = 0; d != ndim; d++) {
+      if (self.size(d) == 1) {
+        continue;
+      }
+      if (is_reduced[d]) {
+        reduced.push_back({self.size(d), self.stride(d), 0});
+      } else {
+        kept.push_back({self.size(d), self.stride(d), result.stride(d)});
+      }
+    }
+    coalesce(kept);
+    coalesce(reduced);
+    num_outputs = 1;
+    for (const auto& dim : kept) {
+      num_outputs *= dim.size;
+    }
+    num_reduced = 1;
+    for (const auto& dim : reduced) {
+      num_reduced *= dim.size;
+    }
+  }
 
-    auto out = res.data<scalar_t>();
-    auto data = self.data<scalar_t>();
-    auto numel = self.numel();
-    if (!dim.has_value()) {
-      *out = reduce_all(data, numel);
+  void apply() {
+    if (num_outputs == 0) {
       return;
     }
+    apply(vectorized());
+  }
+
+  void apply(std::true_type) {
+    if (num_reduced > 0 && reduced[0].in_stride != 1 && kept[0].in_stride == 1 &&
+        kept[0].out_stride == 1 && kept[0].size >= Vec::size) {
+      apply_blocks();
+    } else {
+      apply_runs();
+    }
+  }
 
-    int64_t n = self.size(*dim);
-    int64_t stride = self.stride(*dim);
-    int64_t batch = numel / (n * stride);
-    bool paralellize = batch * n > internal::TBB_GRAIN_SIZE;
-    parallel_for(batch, 1, paralellize, [=](int64_t b) {
-      if (stride == 1) {
-        out[b] = reduce_all(&data[b * n], n);
-      } else {
-        reduce2d(&data[b * n * stride], &out[b * stride], n, stride, stride);
+  void apply(std::false_type) {
+    apply_runs();
+  }
+
+  void apply_runs() {
+    auto reduce_outputs = [&](int64_t begin, int64_t end) {
+      DimCounter output(kept, begin);
+      for (int64_t i = begin; i != end; i++) {
+        auto acc = reduce_positions(output.in_offset, 0, num_reduced);
+        out[output.out_offset] = ops.project(acc, num_reduced);
+        output.advance(1);
       }
-    });
-  }
-
-  static scalar_t reduce_all(const scalar_t* data, int64_t size) {
-    int64_t k = size / WIDTH;
-
-    scalar_t sum;
-    if (size > internal::TBB_GRAIN_SIZE) {
-      sum = tbb::parallel_reduce(
-          tbb::blocked_range<int64_t>(0, k, internal::TBB_GRAIN_SIZE / WIDTH),
-          scalar_t(ident),
-          [=](const tbb::blocked_range<int64_t>& r, scalar_t init) {
-            scalar_t buf[WIDTH];
-            reduce128(&data[r.begin() * WIDTH], buf, r.end() - r.begin(), WIDTH);
-            return std::accumulate(buf, buf + WIDTH, init, ReduceScalar());
-          },
-          ReduceScalar(),
-          ap);
+    };
+
+    if (num_outputs * num_reduced < internal::TBB_GRAIN_SIZE) {
+      reduce_outputs(0, num_outputs);
+    } else if (num_outputs >= MIN_PARALLEL_OUTPUTS ||
+               num_reduced < internal::TBB_GRAIN_SIZE) {
+      int64_t grain = std::max<int64_t>(1, internal::TBB_GRAIN_SIZE / num_reduced);
+      parallel_for(0, num_outputs, grain, reduce_outputs);
     } else {
-      scalar_t buf[WIDTH];
-      reduce128(data, buf, k, WIDTH);
-      sum = std::accumulate(buf, buf + WIDTH, scalar_t(ident), ReduceScalar());
+      DimCounter output(kept, 0);
+      for (int64_t i = 0; i != num_outputs; i++) {
+        int64_t base = output.in_offset;
+        auto acc = parallel_reduce(
+            0, num_reduced, internal::TBB_GRAIN_SIZE, ops.identity(),
+            [&](int64_t begin, int64_t end, acc_t acc) {
+              return ops.combine(acc, reduce_positions(base, begin, end));
+            },
+            [&](acc_t a, acc_t b) { return ops.combine(a, b); });
+        out[output.out_offset] = ops.project(acc, num_reduced);
+        output.advance(1);
+      }
     }
+  }
 
-    for (int i = k * WIDTH; i != size; i++) {
-      sum = ReduceScalar()(sum, data[i]);
+  // Reduces the reduced positions [begin, end), counted innermost first, of
+  // the output whose first input element is in[base].
+  acc_t reduce_positions(int64_t base, int64_t begin, int64_t end) const {
+    acc_t acc = ops.identity();
+    if (begin == end) {
+      return acc;
     }
-    return sum;
+    DimCounter position(reduced, begin);
+    for (int64_t i = begin; i != end;) {
+      int64_t n = std::min(position.remaining(), end - i);
+      acc = reduce_run(
+          acc, in + base + position.in_offset, n, reduced[0].in_stride, vectorized());
+      position.advance(n);
+      i += n;
+    }
+    return acc;
   }
 
-  // Reduce down a column of WIDTH elements (128 bytes) with the given number
-  // of rows. Stores the results in out[0 ... WIDTH-1].
-  static void reduce128(const scalar_t* data, scalar_t* out, int64_t rows, int64_t stride) {
-    Vec acc[4] = {ident, ident, ident, ident};  // 128 bytes (two cache lines)
-    static_assert(sizeof(acc) == 128, "accumulator should be 128 bytes");
-    for (int64_t row = 0; row != rows; row++) {
+  acc_t reduce_run(acc_t acc, const scalar_t* data, int64_t n, int64_t stride, std::true_type) const {
+    if (stride != 1 || n < WIDTH) {
+      return reduce_run(acc, data, n, stride, std::false_type());
+    }
+    Vec vacc[4] = {ops.identity(), ops.identity(), ops.identity(), ops.identity()};
+    int64_t i = 0;
+    for (; i + WIDTH <= n; i += WIDTH) {
       for (int j = 0; j != 4; j++) {
-        auto val = Vec::s_load(&data[row * stride + j * Vec::size]);
-        acc[j] = Reduce()(acc[j], val);
+        vacc[j] = ops.reduce(vacc[j], Vec::s_load(data + i + j * Vec::size));
       }
     }
+    __at_align32__ scalar_t buf[WIDTH];
     for (int j = 0; j != 4; j++) {
-      acc[j].store(&out[j * Vec::size]);
+      vacc[j].store(buf + j * Vec::size);
     }
+    for (int64_t k = 0; k != WIDTH; k++) {
+      acc = ops.combine(acc, buf[k]);
+    }
+    for (; i != n; i++) {
+      acc = ops.reduce(acc, data[i]);
+    }
+    return acc;
   }
 
-  // Reduce a 2d matrix down each column. Stores the results in out[0 ... cols-1]
-  static void reduce2d(const scalar_t* data, scalar_t* out, int64_t rows, int64_t cols, int64_t stride) {
-    int64_t cols_rounded = round_down(cols, WIDTH);
-    bool paralellize = cols * rows > internal::TBB_GRAIN_SIZE;
-    parallel_for(cols_rounded, WIDTH, paralellize, [=](int64_t col) {
-      reduce128(&data[col], &out[col], rows, stride);
-    });
+  acc_t reduce_run(acc_t acc, const scalar_t* data, int64_t n, int64_t stride, std::false_type) const {
+    for (int64_t i = 0; i != n; i++) {
+      acc = ops.reduce(acc, data[i * stride]);
+    }
+    return acc;
+  }
 
-    if (cols_rounded != cols) {
-      scalar_t buf[WIDTH];
-      for (int64_t j = 0; j != cols - cols_rounded; j++) {
-        buf[j] = ident;
+  // The states of one block of up to WIDTH adjacent outputs.
+  struct Block {
+    acc_t acc[WIDTH];
+  };
+
+  void apply_blocks() {
+    const int64_t cols = kept[0].size;
+    const int64_t num_blocks = (cols + WIDTH - 1) / WIDTH;
+    std::vector<ReduceDim> outer(kept.begin() + 1, kept.end());
+    coalesce(outer);
+    const int64_t num_tasks = num_outputs / cols * num_blocks;
+
+    Block identity;
+    std::fill(identity.acc, identity.acc + WIDTH, ops.identity());
+
+    auto finish_block = [&](const DimCounter& row, int64_t col, const Block& block) {
+      scalar_t* dst = out + row.out_offset + col;
+      for (int64_t k = 0; k != std::min(WIDTH, cols - col); k++) {
+        dst[k] = ops.project(block.acc[k], num_reduced);
+      }
+    };
+    auto reduce_tasks = [&](int64_t begin, int64_t end) {
+      for (int64_t t = begin; t != end; t++) {
+        DimCounter row(outer, t / num_blocks);
+        int64_t col = (t % num_blocks) * WIDTH;
+        Block block = identity;
+        reduce_block(row.in_offset + col, std::min(WIDTH, cols - col), 0, num_reduced, block);
+        finish_block(row, col, block);
+      }
+    };
+
+    if (num_outputs * num_reduced < internal::TBB_GRAIN_SIZE) {
+      reduce_tasks(0, num_tasks);
+    } else if (num_tasks >= MIN_PARALLEL_OUTPUTS ||
+               num_reduced * WIDTH < internal::TBB_GRAIN_SIZE) {
+      int64_t grain = std::max<int64_t>(1, internal::TBB_GRAIN_SIZE / (num_reduced * WIDTH));
+      parallel_for(0, num_tasks, grain, reduce_tasks);
+    } else {
+      for (int64_t t = 0; t != num_tasks; t++) {
+        DimCounter row(outer, t / num_blocks);
+        int64_t col = (t % num_blocks) * WIDTH;
+        int64_t width = std::min(WIDTH, cols - col);
+        int64_t base = row.in_offset + col;
+        Block block = parallel_reduce(
+            0, num_reduced, internal::TBB_GRAIN_SIZE / WIDTH, identity,
+            [&](int64_t begin, int64_t end, Block block) {
+              reduce_block(base, width, begin, end, block);
+              return block;
+            },
+            [&](Block a, const Block& b) {
+              for (int64_t k = 0; k != width; k++) {
+                a.acc[k] = ops.combine(a.acc[k], b.acc[k]);
+              }
+              return a;
+            });
+        finish_block(row, col, block);
       }
-      for (int64_t row = 0; row != rows; row++) {
-        for (int64_t j = 0; j != cols - cols_rounded; j++) {
-          auto val = data[row * stride + j + cols_rounded];
-          buf[j] = ReduceScalar()(buf[j], val);
+    }
+  }
+
+  // Reduces the reduced positions [begin, end) of the `width` adjacent
+  // outputs whose first input elements start at in[base] into `block`.
+  void reduce_block(int64_t base, int64_t width, int64_t begin, int64_t end, Block& block) const {
+    DimCounter position(reduced, begin);
+    if (width == WIDTH) {
+      Vec vacc[4] = {ops.identity(), ops.identity(), ops.identity(), ops.identity()};
+      for (int64_t i = begin; i != end; i++) {
+        const scalar_t* data = in + base + position.in_offset;
+        for (int j = 0; j != 4; j++) {
+          vacc[j] = ops.reduce(vacc[j], Vec::s_load(data + j * Vec::size));
         }
+        position.advance(1);
+      }
+      __at_align32__ scalar_t buf[WIDTH];
+      for (int j = 0; j != 4; j++) {
+        vacc[j].store(buf + j * Vec::size);
+      }
+      for (int64_t k = 0; k != WIDTH; k++) {
+        block.acc[k] = ops.combine(block.acc[k], buf[k]);
       }
-      for (int64_t j = 0; j != cols - cols_rounded; j++) {
-        out[j + cols_rounded] = buf[j];
+    } else {
+      for (int64_t i = begin; i != end; i++) {
+        const scalar_t* data = in + base + position.in_offset;
+        for (int64_t k = 0; k != width; k++) {
+          block.acc[k] = ops.reduce(block.acc[k], data[k]);
+        }
+        position.advance(1);
       }
     }
   }
+
+  const Ops ops;
+  const scalar_t* in;
+  scalar_t* out;
+  std::vector<ReduceDim> kept;
+  std::vector<ReduceDim> reduced;
+  int64_t num_outputs;
+  int64_t num_reduced;
 };
 
-static void sum_kernel_impl(Tensor& result, const Tensor& self, at::optional<int64_t> dim) {
+template <typename scalar_t, typename Ops>
+constexpr int64_t Reduction<scalar_t, Ops>::WIDTH;
+
+template <typename scalar_t, typename Ops>
+void reduce(Tensor& result, const Tensor& self, IntList dims, Ops ops) {
+  Reduction<scalar_t, Ops>(result, self, dims, ops).apply();
+}
+
+} // anonymous namespace
+
+static void sum_kernel_impl(Tensor& result, const Tensor& self, IntList dims) {
   AT_DISPATCH_ALL_TYPES(self.type(), "sum", [&] {
-    Reduction<scalar_t, std::plus, 0>::apply(result, self, dim);
+    reduce<scalar_t>(result, self, dims, SumOps<scalar_t>());
   });
 }
 
-static void prod_kernel_impl(Tensor& result, const Tensor& self, at::optional<int64_t> dim) {
+static void prod_kernel_impl(Tensor& result, const Tensor& self, IntList dims) {
   AT_DISPATCH_ALL_TYPES(self.type(), "prod", [&] {
-    Reduction<scalar_t, std::multiplies, 1>::apply(result, self, dim);
+    reduce<scalar_t>(result, self, dims, ProdOps<scalar_t>());
+  });
+}
+
+static void mean_kernel_impl(Tensor& result, const Tensor& self, IntList dims) {
+  AT_DISPATCH_FLOATING_TYPES(self.type(), "mean", [&] {
+    reduce<scalar_t>(result, self, dims, MeanOps<scalar_t>());
+  });
+}
+
+static void max_kernel_impl(Tensor& result, const Tensor& self, IntList dims) {
+  AT_DISPATCH_ALL_TYPES(self.type(), "max", [&] {
+    reduce<scalar_t>(result, self, dims, MaxOps<scalar_t>());
+  });
+}
+
+static void min_kernel_impl(Tensor& result, const Tensor& self, IntList dims) {
+  AT_DISPATCH_ALL_TYPES(self.type(), "min", [&] {
+    reduce<scalar_t>(result, self, dims, MinOps<scalar_t>());
+  });
+}
+
+static void norm_kernel_impl(Tensor& result, const Tensor& self, Scalar p, IntList dims) {
+  double pvalue = p.toDouble();
+  AT_DISPATCH_FLOATING_TYPES(self.type(), "norm", [&] {
+    if (pvalue == 0) {
+      reduce<scalar_t>(result, self, dims, NormZeroOps<scalar_t>());
+    } else if (pvalue == 1) {
+      reduce<scalar_t>(result, self, dims, NormOneOps<scalar_t>());
+    } else if (pvalue == 2) {
+      reduce<scalar_t>(result, self, dims, NormTwoOps<scalar_t>());
+    } else if (pvalue == std::numeric_limits<double>::infinity()) {
+      reduce<scalar_t>(result, self, dims, NormInfOps<scalar_t>());
+    } else {
+      reduce<scalar_t>(result, self, dims, NormOps<scalar_t>{static_cast<scalar_t>(pvalue)});
+    }
+  });
+}
+
+static void var_kernel_impl(Tensor& result, const Tensor& self, bool unbiased, bool take_sqrt, IntList dims) {
+  AT_DISPATCH_FLOATING_TYPES(self.type(), "var", [&] {
+    reduce<scalar_t>(result, self, dims, VarOps<scalar_t>{unbiased, take_sqrt});
   });
 }
 
 REGISTER_DISPATCH(sum_kernel, &sum_kernel_impl);
 REGISTER_DISPATCH(prod_kernel, &prod_kernel_impl);
+REGISTER_DISPATCH(mean_kernel, &mean_kernel_impl);
+REGISTER_DISPATCH(max_kernel, &max_kernel_impl);
+REGISTER_DISPATCH(min_kernel, &min_kernel_impl);
+REGISTER_DISPATCH(norm_kernel, &norm_kernel_impl);
+REGISTER_DISPATCH(var_kernel, &var_kernel_impl);
 
 }
 }
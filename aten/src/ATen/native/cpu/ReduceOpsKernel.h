@@ -1,16 +1,27 @@
 #pragma once
 
 #include <ATen/ATen.h>
-#include <ATen/optional.h>
 #include "CapabilityDispatch.h"
 
 namespace at {
 namespace native {
 
-using reduce_fn = void(*)(Tensor &, const Tensor &, at::optional<int64_t>);
+// The kernels below reduce `self` over the dimensions in `dims`, or over all
+// dimensions if `dims` is empty, and write into `result`. `self` may have any
+// strides. `result` has to be contiguous and have the sizes of `self` with
+// the reduced dimensions set to 1 (or be a scalar if all are reduced).
+using reduce_fn = void(*)(Tensor& result, const Tensor& self, IntList dims);
+using norm_fn = void(*)(Tensor& result, const Tensor& self, Scalar p, IntList dims);
+// Computes the standard deviation instead of the variance if take_sqrt.
+using var_fn = void(*)(Tensor& result, const Tensor& self, bool unbiased, bool take_sqrt, IntList dims);
 
 extern DispatchStub<reduce_fn> sum_kernel;
 extern DispatchStub<reduce_fn> prod_kernel;
+extern DispatchStub<reduce_fn> mean_kernel;
+extern DispatchStub<reduce_fn> max_kernel;
+extern DispatchStub<reduce_fn> min_kernel;
+extern DispatchStub<norm_fn> norm_kernel;
+extern DispatchStub<var_fn> var_kernel;
 
 }
 }
@@ -30,24 +30,11 @@ static void unary_kernel(scalar_t* arr_out, const scalar_t* arr_in, int64_t size
 
 template <class scalar_t, class F>
 static void parallel_apply(Tensor& result, const Tensor& self, F f) {
-  internal::init_tbb_num_threads();
-
-  static tbb::affinity_partitioner ap;
-
   auto arr_out = result.data<scalar_t>();
   auto arr_in = self.data<scalar_t>();
-  int64_t size = self.numel();
-  if (size < internal::TBB_GRAIN_SIZE) {
-    unary_kernel(arr_out, arr_in, size, f);
-  } else {
-    tbb::parallel_for(
-        tbb::blocked_range<int64_t>(0, size, internal::TBB_GRAIN_SIZE),
-        [&](const tbb::blocked_range<int64_t>& r) {
-          auto size = r.end() - r.begin();
-          unary_kernel(arr_out + r.begin(), arr_in + r.begin(), size, f);
-        },
-        ap);
-  }
+  parallel_for(0, self.numel(), internal::TBB_GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+    unary_kernel(arr_out + begin, arr_in + begin, end - begin, f);
+  });
 }
 
 static void abs_kernel(Tensor& result, const Tensor& self) {
@@ -58,87 +45,41 @@ static void abs_kernel(Tensor& result, const Tensor& self) {
   });
 }
 
-static void ceil_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "ceil", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
-      return x.ceil();
-    });
-  });
-}
-
-static void cos_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "cos", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
-      return x.cos();
-    });
-  });
-}
-
-static void exp_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "exp", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
-      return x.exp();
-    });
-  });
-}
-
-static void floor_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "floor", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
-      return x.floor();
-    });
-  });
-}
-
-static void log_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "log", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
-      return x.log();
-    });
-  });
-}
-
-static void round_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "round", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
-      return x.round();
-    });
-  });
-}
-
-static void sin_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "sin", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
-      return x.sin();
-    });
-  });
-}
-
-static void sqrt_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "sqrt", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
-      return x.sqrt();
-    });
-  });
-}
-
-static void trunc_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "trunc", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
-      return x.trunc();
-    });
-  });
-}
-
 REGISTER_DISPATCH(absImpl, &abs_kernel);
-REGISTER_DISPATCH(ceilImpl, &ceil_kernel);
-REGISTER_DISPATCH(cosImpl, &cos_kernel);
-REGISTER_DISPATCH(expImpl, &exp_kernel);
-REGISTER_DISPATCH(floorImpl, &floor_kernel);
-REGISTER_DISPATCH(logImpl, &log_kernel);
-REGISTER_DISPATCH(roundImpl, &round_kernel);
-REGISTER_DISPATCH(sinImpl, &sin_kernel);
-REGISTER_DISPATCH(sqrtImpl, &sqrt_kernel);
-REGISTER_DISPATCH(truncImpl, &trunc_kernel);
+
+// Defines the kernel of a unary op on floating point tensors from the
+// Vec256 member function of the same name.
+#define IMPLEMENT_FLOAT_KERNEL(op)                                            \
+  static void op##_kernel(Tensor& result, const Tensor& self) {               \
+    AT_DISPATCH_FLOATING_TYPES(self.type(), #op, [&] {                        \
+      parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {  \
+        return x.op();                                                        \
+      });                                                                     \
+    });                                                                       \
+  }                                                                           \
+  REGISTER_DISPATCH(op##Impl, &op##_kernel)
+
+IMPLEMENT_FLOAT_KERNEL(acos);
+IMPLEMENT_FLOAT_KERNEL(asin);
+IMPLEMENT_FLOAT_KERNEL(atan);
+IMPLEMENT_FLOAT_KERNEL(ceil);
+IMPLEMENT_FLOAT_KERNEL(cos);
+IMPLEMENT_FLOAT_KERNEL(cosh);
+IMPLEMENT_FLOAT_KERNEL(erf);
+IMPLEMENT_FLOAT_KERNEL(exp);
+IMPLEMENT_FLOAT_KERNEL(expm1);
+IMPLEMENT_FLOAT_KERNEL(floor);
+IMPLEMENT_FLOAT_KERNEL(frac);
+IMPLEMENT_FLOAT_KERNEL(log);
+IMPLEMENT_FLOAT_KERNEL(log1p);
+IMPLEMENT_FLOAT_KERNEL(round);
+IMPLEMENT_FLOAT_KERNEL(rsqrt);
+IMPLEMENT_FLOAT_KERNEL(sigmoid);
+IMPLEMENT_FLOAT_KERNEL(sin);
+IMPLEMENT_FLOAT_KERNEL(sinh);
+IMPLEMENT_FLOAT_KERNEL(sqrt);
+IMPLEMENT_FLOAT_KERNEL(tan);
+IMPLEMENT_FLOAT_KERNEL(tanh);
+IMPLEMENT_FLOAT_KERNEL(trunc);
 
 }} // namespace at::native
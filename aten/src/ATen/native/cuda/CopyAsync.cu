@@ -0,0 +1,108 @@
+// Copies between host and device on the dedicated copy stream of the device
+// (see THCState_getCopyStream), so that they overlap with the kernels queued
+// on the current stream instead of being serialized with them.
+//
+// The host side is always pinned memory from the host allocator, which is
+// what lets cudaMemcpyAsync return without waiting for the copy. Both sides
+// are marked as in use by the copy stream, so neither is reused before the
+// copy completes even if the tensors are freed right away.
+
+#include "ATen/ATen.h"
+#include "ATen/Error.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/PinnedMemoryAllocator.h"
+
+#include <THC/THC.h>
+#include <THC/THCCachingAllocator.h>
+#include <THC/THCCachingHostAllocator.h>
+
+namespace at { namespace native {
+
+namespace {
+
+// Makes the work queued on waiting from now on wait for the work queued so
+// far on other, without blocking the host
+void streamWaitStream(THCStream* waiting, THCStream* other) {
+  cudaEvent_t event;
+  THCudaCheck(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+  THCudaCheck(cudaEventRecord(event, other->stream));
+  THCudaCheck(cudaStreamWaitEvent(waiting->stream, event, 0));
+  THCudaCheck(cudaEventDestroy(event));
+}
+
+// Marks the storages of device and host as in use by stream until the work
+// queued on it so far completes
+void recordStreamUse(THCState* state, const Tensor& device, const Tensor& host, THCStream* stream) {
+  if (THCState_isCachingAllocatorEnabled(state)) {
+    THCCachingAllocator_recordStream(device.storage()->data(), stream);
+  }
+  if (THCState_getCudaHostAllocator(state) == &THCCachingHostAllocator) {
+    THCudaCheck(THCCachingHostAllocator_recordEvent(host.storage()->data(), stream));
+  }
+}
+
+Tensor pinnedTensor(const Type& type, IntList sizes) {
+  auto allocator = std::unique_ptr<Allocator>(new PinnedMemoryAllocator());
+  return type.tensorWithAllocator(sizes, std::move(allocator));
+}
+
+} // namespace
+
+Tensor _to_host_async_cuda(const Tensor& self) {
+  auto state = globalContext().lazyInitCUDA();
+  auto src = self.contiguous();
+  auto result = pinnedTensor(self.type().toBackend(kCPU), self.sizes());
+  if (self.numel() == 0) {
+    return result;
+  }
+
+  THCStream* current = THCState_getStream(state);
+  THCStream* copy = THCState_getCopyStream(state, self.get_device());
+  streamWaitStream(copy, current);
+  THCudaCheck(cudaMemcpyAsync(result.data_ptr(), src.data_ptr(),
+                              src.numel() * src.type().elementSizeInBytes(),
+                              cudaMemcpyDeviceToHost, copy->stream));
+  recordStreamUse(state, src, result, copy);
+  return result;
+}
+
+Tensor & _copy_from_host_async_cuda_(Tensor& self, const Tensor& src) {
+  if (src.type().backend() != kCPU) {
+    AT_ERROR("_copy_from_host_async_: expected a CPU source, but got '%s'", src.type().toString());
+  }
+  if (src.type().scalarType() != self.type().scalarType()) {
+    AT_ERROR("_copy_from_host_async_: expected a source of type %s, but got %s",
+        at::toString(self.type().scalarType()), at::toString(src.type().scalarType()));
+  }
+  if (src.numel() != self.numel()) {
+    AT_ERROR("_copy_from_host_async_: sizes do not match (%lld and %lld elements)",
+        (long long)self.numel(), (long long)src.numel());
+  }
+  if (self.numel() == 0) {
+    return self;
+  }
+
+  // The host copy into the staging buffer is synchronous but only involves
+  // the CPU; the transfer to the device is not
+  auto state = globalContext().lazyInitCUDA();
+  auto staging = pinnedTensor(src.type(), src.sizes());
+  staging.copy_(src);
+  bool direct = self.is_contiguous();
+  auto dst = direct ? self : self.type().tensor(self.sizes());
+
+  THCStream* current = THCState_getStream(state);
+  THCStream* copy = THCState_getCopyStream(state, self.get_device());
+  streamWaitStream(copy, current);
+  THCudaCheck(cudaMemcpyAsync(dst.data_ptr(), staging.data_ptr(),
+                              staging.numel() * staging.type().elementSizeInBytes(),
+                              cudaMemcpyHostToDevice, copy->stream));
+  recordStreamUse(state, dst, staging, copy);
+  // later work on the current stream sees the copied values
+  streamWaitStream(current, copy);
+  if (!direct) {
+    self.copy_(dst);
+  }
+  return self;
+}
+
+}} // at::native
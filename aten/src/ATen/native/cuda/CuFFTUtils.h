@@ -71,6 +71,8 @@ public:
   explicit CufftHandle() {
     CUFFT_CHECK(cufftCreate(&raw_plan));
   }
+  CufftHandle(const CufftHandle&) = delete;
+  CufftHandle& operator=(const CufftHandle&) = delete;
 
   const cufftHandle &get() const { return raw_plan; }
 
@@ -0,0 +1,200 @@
+#include "ATen/ATen.h"
+#include "ATen/Dispatch.h"
+#include "ATen/NativeFunctions.h"
+
+#include <THC/THCGeneral.h>
+#include <THC/THCNumerics.cuh>
+
+#include <algorithm>
+#include <cmath>
+
+namespace at { namespace native {
+
+namespace {
+
+// The forward is blocked like a matrix multiply: a block computes a TILE x
+// TILE tile of distances from TILE rows of x1 and of x2, which it stages in
+// shared memory TILE coordinates at a time.
+constexpr int CDIST_TILE = 16;
+// The backward has a thread per coordinate of x1, with the threads of a warp
+// along the coordinates of one row.
+constexpr int CDIST_BACKWARD_THREADS_X = 32;
+constexpr int CDIST_BACKWARD_THREADS_Y = 8;
+constexpr int64_t MAX_GRID_Y = 65535;
+
+template <typename scalar_t>
+struct dists {
+  using N = THCNumerics<scalar_t>;
+
+  static __forceinline__ __device__ scalar_t sign(scalar_t val) {
+    return (0 < val) - (val < 0);
+  }
+
+  // Zero "norm": the number of coordinates that differ
+  struct zdist {
+    static __forceinline__ __device__ scalar_t map(scalar_t diff, scalar_t p) { return diff != 0; }
+    static __forceinline__ __device__ scalar_t red(scalar_t agg, scalar_t up) { return agg + up; }
+    static __forceinline__ __device__ scalar_t finish(scalar_t agg, scalar_t p) { return agg; }
+    static __forceinline__ __device__ scalar_t backward(scalar_t diff, scalar_t grad, scalar_t dist, scalar_t p) { return 0; }
+  };
+
+  // One norm
+  struct odist {
+    static __forceinline__ __device__ scalar_t map(scalar_t diff, scalar_t p) { return N::abs(diff); }
+    static __forceinline__ __device__ scalar_t red(scalar_t agg, scalar_t up) { return agg + up; }
+    static __forceinline__ __device__ scalar_t finish(scalar_t agg, scalar_t p) { return agg; }
+    static __forceinline__ __device__ scalar_t backward(scalar_t diff, scalar_t grad, scalar_t dist, scalar_t p) { return grad * sign(diff); }
+  };
+
+  // Two norm
+  struct tdist {
+    static __forceinline__ __device__ scalar_t map(scalar_t diff, scalar_t p) { return diff * diff; }
+    static __forceinline__ __device__ scalar_t red(scalar_t agg, scalar_t up) { return agg + up; }
+    static __forceinline__ __device__ scalar_t finish(scalar_t agg, scalar_t p) { return N::sqrt(agg); }
+    static __forceinline__ __device__ scalar_t backward(scalar_t diff, scalar_t grad, scalar_t dist, scalar_t p) { return dist == 0 ? 0 : grad * diff / dist; }
+  };
+
+  // Infinity norm
+  struct idist {
+    static __forceinline__ __device__ scalar_t map(scalar_t diff, scalar_t p) { return N::abs(diff); }
+    static __forceinline__ __device__ scalar_t red(scalar_t agg, scalar_t up) { return agg > up ? agg : up; }
+    static __forceinline__ __device__ scalar_t finish(scalar_t agg, scalar_t p) { return agg; }
+    static __forceinline__ __device__ scalar_t backward(scalar_t diff, scalar_t grad, scalar_t dist, scalar_t p) { return grad * sign(diff) * (N::abs(diff) == dist); }
+  };
+
+  // General p norm
+  struct pdist {
+    static __forceinline__ __device__ scalar_t map(scalar_t diff, scalar_t p) { return N::pow(N::abs(diff), p); }
+    static __forceinline__ __device__ scalar_t red(scalar_t agg, scalar_t up) { return agg + up; }
+    static __forceinline__ __device__ scalar_t finish(scalar_t agg, scalar_t p) { return N::pow(agg, scalar_t(1) / p); }
+    static __forceinline__ __device__ scalar_t backward(scalar_t diff, scalar_t grad, scalar_t dist, scalar_t p) {
+      return dist == 0 || (p < 1 && diff == 0) ? 0 :
+          grad * sign(diff) * N::pow(N::abs(diff), p - 1) / N::pow(dist, p - 1);
+    }
+  };
+};
+
+template <typename scalar_t, typename F>
+__global__ void cdist_kernel_cuda_impl(scalar_t* result, const scalar_t* x1, const scalar_t* x2,
+                                       const scalar_t p, const int64_t r1, const int64_t r2, const int64_t m) {
+  // padded against bank conflicts when read down the columns
+  __shared__ scalar_t tile1[CDIST_TILE][CDIST_TILE + 1];
+  __shared__ scalar_t tile2[CDIST_TILE][CDIST_TILE + 1];
+  const int tx = threadIdx.x;
+  const int ty = threadIdx.y;
+  const int64_t j = blockIdx.x * CDIST_TILE + tx;
+  const int64_t row2 = blockIdx.x * CDIST_TILE + ty;
+
+  for (int64_t block_y = blockIdx.y; block_y * CDIST_TILE < r1; block_y += gridDim.y) {
+    const int64_t i = block_y * CDIST_TILE + ty;
+    scalar_t agg = 0;
+    for (int64_t k0 = 0; k0 < m; k0 += CDIST_TILE) {
+      const int64_t k = k0 + tx;
+      tile1[ty][tx] = i < r1 && k < m ? x1[i * m + k] : scalar_t(0);
+      tile2[ty][tx] = row2 < r2 && k < m ? x2[row2 * m + k] : scalar_t(0);
+      __syncthreads();
+      const int kmax = m - k0 < CDIST_TILE ? m - k0 : CDIST_TILE;
+      for (int kk = 0; kk < kmax; kk++) {
+        agg = F::red(agg, F::map(tile1[ty][kk] - tile2[tx][kk], p));
+      }
+      __syncthreads();
+    }
+    if (i < r1 && j < r2) {
+      result[i * r2 + j] = F::finish(agg, p);
+    }
+  }
+}
+
+template <typename scalar_t, typename F>
+__global__ void cdist_backward_kernel_cuda_impl(scalar_t* result, const scalar_t* grad, const scalar_t* x1,
+                                                const scalar_t* x2, const scalar_t* dist, const scalar_t p,
+                                                const int64_t r1, const int64_t r2, const int64_t m) {
+  const int64_t k = blockIdx.x * blockDim.x + threadIdx.x;
+  for (int64_t i = blockIdx.y * blockDim.y + threadIdx.y; i < r1; i += gridDim.y * blockDim.y) {
+    if (k >= m) {
+      continue;
+    }
+    const scalar_t a = x1[i * m + k];
+    scalar_t agg = 0;
+    for (int64_t j = 0; j < r2; j++) {
+      agg += F::backward(a - x2[j * m + k], grad[i * r2 + j], dist[i * r2 + j], p);
+    }
+    result[i * m + k] = agg;
+  }
+}
+
+template <typename scalar_t, typename F>
+void launch_cdist(Tensor& result, const Tensor& x1, const Tensor& x2, scalar_t p) {
+  const int64_t r1 = x1.size(0);
+  const int64_t r2 = x2.size(0);
+  const int64_t m = x1.size(1);
+  const dim3 block(CDIST_TILE, CDIST_TILE);
+  const dim3 grid((r2 + CDIST_TILE - 1) / CDIST_TILE,
+                  std::min((r1 + CDIST_TILE - 1) / CDIST_TILE, MAX_GRID_Y));
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  cdist_kernel_cuda_impl<scalar_t, F><<<grid, block, 0, stream>>>(
+      result.data<scalar_t>(), x1.data<scalar_t>(), x2.data<scalar_t>(), p, r1, r2, m);
+  THCudaCheck(cudaGetLastError());
+}
+
+template <typename scalar_t, typename F>
+void launch_cdist_backward(Tensor& result, const Tensor& grad, const Tensor& x1, const Tensor& x2,
+                           scalar_t p, const Tensor& dist) {
+  const int64_t r1 = x1.size(0);
+  const int64_t r2 = x2.size(0);
+  const int64_t m = x1.size(1);
+  const dim3 block(CDIST_BACKWARD_THREADS_X, CDIST_BACKWARD_THREADS_Y);
+  const dim3 grid((m + CDIST_BACKWARD_THREADS_X - 1) / CDIST_BACKWARD_THREADS_X,
+                  std::min((r1 + CDIST_BACKWARD_THREADS_Y - 1) / CDIST_BACKWARD_THREADS_Y, MAX_GRID_Y));
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  cdist_backward_kernel_cuda_impl<scalar_t, F><<<grid, block, 0, stream>>>(
+      result.data<scalar_t>(), grad.data<scalar_t>(), x1.data<scalar_t>(), x2.data<scalar_t>(),
+      dist.data<scalar_t>(), p, r1, r2, m);
+  THCudaCheck(cudaGetLastError());
+}
+
+} // namespace
+
+Tensor _cdist_forward_cuda(const Tensor& x1, const Tensor& x2, double p) {
+  auto result = x1.type().tensor({x1.size(0), x2.size(0)});
+  if (result.numel() == 0) {
+    return result;
+  }
+  AT_DISPATCH_FLOATING_TYPES(x1.type(), "cdist_cuda", [&] {
+    if (p == 0.0) {
+      launch_cdist<scalar_t, typename dists<scalar_t>::zdist>(result, x1, x2, p);
+    } else if (p == 1.0) {
+      launch_cdist<scalar_t, typename dists<scalar_t>::odist>(result, x1, x2, p);
+    } else if (p == 2.0) {
+      launch_cdist<scalar_t, typename dists<scalar_t>::tdist>(result, x1, x2, p);
+    } else if (std::isinf(p)) {
+      launch_cdist<scalar_t, typename dists<scalar_t>::idist>(result, x1, x2, p);
+    } else {
+      launch_cdist<scalar_t, typename dists<scalar_t>::pdist>(result, x1, x2, p);
+    }
+  });
+  return result;
+}
+
+Tensor _cdist_backward_cuda(const Tensor& grad_, const Tensor& x1, const Tensor& x2, double p, const Tensor& cdist_) {
+  auto result = at::zeros_like(x1);
+  if (result.numel() == 0 || x2.size(0) == 0 || p == 0.0) {
+    return result;
+  }
+  auto grad = grad_.contiguous();
+  auto cdist = cdist_.contiguous();
+  AT_DISPATCH_FLOATING_TYPES(x1.type(), "cdist_backward_cuda", [&] {
+    if (p == 1.0) {
+      launch_cdist_backward<scalar_t, typename dists<scalar_t>::odist>(result, grad, x1, x2, p, cdist);
+    } else if (p == 2.0) {
+      launch_cdist_backward<scalar_t, typename dists<scalar_t>::tdist>(result, grad, x1, x2, p, cdist);
+    } else if (std::isinf(p)) {
+      launch_cdist_backward<scalar_t, typename dists<scalar_t>::idist>(result, grad, x1, x2, p, cdist);
+    } else {
+      launch_cdist_backward<scalar_t, typename dists<scalar_t>::pdist>(result, grad, x1, x2, p, cdist);
+    }
+  });
+  return result;
+}
+
+}} // namespace at::native
@@ -350,4 +350,12 @@ Tensor & embedding_renorm_cuda_(Tensor & self, const Tensor & indices,
   return self;
 }
 
+Tensor & embedding_sparse_adagrad_cuda_(
+    Tensor & self, const Tensor & state_sum, const Tensor & grad, const Tensor & indices,
+    double lr, double eps, int64_t padding_idx) {
+  throw std::runtime_error(
+      "embedding_sparse_adagrad_ is currently CPU-only, and lacks CUDA support. "
+      "Pull requests welcome!");
+}
+
 }}  // namespace at::native
@@ -0,0 +1,167 @@
+#include "ATen/ATen.h"
+#include "ATen/Dispatch.h"
+#include "ATen/NativeFunctions.h"
+
+#include "ATen/cuda/CUDATypeConversion.cuh"
+
+#include <THC/THCAtomics.cuh>
+#include <THC/THCGeneral.h>
+
+#include <algorithm>
+#include <assert.h>
+
+namespace at { namespace native {
+
+namespace {
+
+constexpr int MAX_INDEX_DIMS = 25;
+constexpr int INDEX_THREADS = 256;
+constexpr int64_t INDEX_MAX_BLOCKS = 65535;
+
+// The sizes of the indexed shape, the strides of self and of the other tensor
+// along it, and the sizes and strides of the indexed dimensions of self.
+// Self has a zero stride along the index dimensions of the indexed shape,
+// which the kernel replaces with the index.
+struct IndexGeometry {
+  int dims;
+  int dims_before;
+  int dims_index;
+  int num_indexed;
+  int64_t ni;
+  int64_t sizes[MAX_INDEX_DIMS];
+  int64_t self_strides[MAX_INDEX_DIMS];
+  int64_t other_strides[MAX_INDEX_DIMS];
+  int64_t indexed_sizes[MAX_INDEX_DIMS];
+  int64_t indexed_strides[MAX_INDEX_DIMS];
+};
+
+IndexGeometry makeGeometry(const Tensor & self, const Tensor & index, const Tensor & other, int64_t dims_before) {
+  IndexGeometry g;
+  g.dims = other.dim();
+  g.dims_before = dims_before;
+  g.dims_index = index.dim() - 1;
+  g.num_indexed = index.size(0);
+  g.ni = index.numel() / g.num_indexed;
+  if (g.dims > MAX_INDEX_DIMS || g.num_indexed > MAX_INDEX_DIMS) {
+    AT_ERROR("indexing supports at most %d dimensions on CUDA", MAX_INDEX_DIMS);
+  }
+  int64_t after_shift = g.num_indexed - g.dims_index;
+  for (int d = 0; d < g.dims; d++) {
+    g.sizes[d] = other.size(d);
+    g.other_strides[d] = other.stride(d);
+    if (d < g.dims_before) {
+      g.self_strides[d] = self.stride(d);
+    } else if (d < g.dims_before + g.dims_index) {
+      g.self_strides[d] = 0;
+    } else {
+      g.self_strides[d] = self.stride(d + after_shift);
+    }
+  }
+  for (int j = 0; j < g.num_indexed; j++) {
+    g.indexed_sizes[j] = self.size(dims_before + j);
+    g.indexed_strides[j] = self.stride(dims_before + j);
+  }
+  return g;
+}
+
+// Calls op(self element, other element) for all the n elements of other, a
+// tensor of the indexed shape, and the elements of self they index.
+template <typename scalar_t, typename Op>
+__global__ void index_apply_kernel(
+    scalar_t* self, const int64_t* index, scalar_t* other, int64_t n, IndexGeometry g, Op op) {
+  for (int64_t linear = blockIdx.x * (int64_t)blockDim.x + threadIdx.x; linear < n;
+       linear += (int64_t)gridDim.x * blockDim.x) {
+    int64_t self_offset = 0;
+    int64_t other_offset = 0;
+    int64_t i = 0;
+    int64_t i_stride = 1;
+    int64_t rem = linear;
+    for (int d = g.dims - 1; d >= 0; d--) {
+      int64_t c = rem % g.sizes[d];
+      rem /= g.sizes[d];
+      self_offset += c * g.self_strides[d];
+      other_offset += c * g.other_strides[d];
+      if (d >= g.dims_before && d < g.dims_before + g.dims_index) {
+        i += c * i_stride;
+        i_stride *= g.sizes[d];
+      }
+    }
+    for (int j = 0; j < g.num_indexed; j++) {
+      int64_t idx = index[j * g.ni + i];
+      int64_t size = g.indexed_sizes[j];
+      assert(idx >= -size && idx < size);
+      self_offset += (idx < 0 ? idx + size : idx) * g.indexed_strides[j];
+    }
+    op(self + self_offset, other + other_offset);
+  }
+}
+
+template <typename scalar_t>
+struct GatherOp {
+  __device__ __forceinline__ void operator()(scalar_t* self_elem, scalar_t* result_elem) const {
+    *result_elem = *self_elem;
+  }
+};
+
+template <typename scalar_t>
+struct ScatterOp {
+  __device__ __forceinline__ void operator()(scalar_t* self_elem, scalar_t* source_elem) const {
+    *self_elem = *source_elem;
+  }
+};
+
+template <typename scalar_t>
+struct ScatterAddOp {
+  __device__ __forceinline__ void operator()(scalar_t* self_elem, scalar_t* source_elem) const {
+    atomicAdd(self_elem, *source_elem);
+  }
+};
+
+template <typename scalar_t, typename Op>
+void index_apply_cuda(const Tensor & self, const Tensor & index, const Tensor & other, int64_t dims_before, Op op) {
+  auto g = makeGeometry(self, index, other, dims_before);
+  auto contig_index = index.contiguous();
+  int64_t n = other.numel();
+  int64_t blocks = std::min<int64_t>((n + INDEX_THREADS - 1) / INDEX_THREADS, INDEX_MAX_BLOCKS);
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  index_apply_kernel<<<blocks, INDEX_THREADS, 0, stream>>>(
+      reinterpret_cast<scalar_t*>(self.data_ptr()),
+      contig_index.data<int64_t>(),
+      reinterpret_cast<scalar_t*>(other.data_ptr()),
+      n, g, op);
+  THCudaCheck(cudaGetLastError());
+}
+
+} // namespace
+
+Tensor _index_gather_cuda(const Tensor & self, const Tensor & index, int64_t dims_before) {
+  std::vector<int64_t> sizes(self.sizes().begin(), self.sizes().begin() + dims_before);
+  sizes.insert(sizes.end(), index.sizes().begin() + 1, index.sizes().end());
+  sizes.insert(sizes.end(), self.sizes().begin() + dims_before + index.size(0), self.sizes().end());
+  auto result = self.type().tensor(sizes);
+  if (result.numel() == 0) {
+    return result;
+  }
+  AT_DISPATCH_ALL_TYPES_AND_HALF(self.type(), "index", [&] {
+    using cuda_scalar_t = cuda::type<scalar_t>;
+    index_apply_cuda<cuda_scalar_t>(self, index, result, dims_before, GatherOp<cuda_scalar_t>());
+  });
+  return result;
+}
+
+Tensor & _index_scatter_cuda_(Tensor & self, const Tensor & index, const Tensor & source, int64_t dims_before, bool accumulate) {
+  if (source.numel() == 0) {
+    return self;
+  }
+  AT_DISPATCH_ALL_TYPES_AND_HALF(self.type(), "index_put_", [&] {
+    using cuda_scalar_t = cuda::type<scalar_t>;
+    if (accumulate) {
+      index_apply_cuda<cuda_scalar_t>(self, index, source, dims_before, ScatterAddOp<cuda_scalar_t>());
+    } else {
+      index_apply_cuda<cuda_scalar_t>(self, index, source, dims_before, ScatterOp<cuda_scalar_t>());
+    }
+  });
+  return self;
+}
+
+}} // at::native
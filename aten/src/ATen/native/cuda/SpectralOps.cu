@@ -6,6 +6,7 @@
 #include "ATen/native/cuda/CuFFTUtils.h"
 
 #include "ATen/cuda/AccumulateType.cuh"
+#include "ATen/cuda/CUFFTPlanCache.h"
 #include "ATen/cuda/CUDATensorMethods.cuh"
 #include "ATen/cuda/CUDATypeConversion.cuh"
 
@@ -21,8 +22,11 @@
 #include <cufft.h>
 #include <cufftXt.h>
 #include <cmath>
+#include <cstring>
 #include <numeric>
 #include <iostream>
+#include <mutex>
+#include <vector>
 
 namespace at { namespace native {
 
@@ -135,6 +139,61 @@ static void _fft_fill_with_conjugate_symmetry_(Tensor& input,
   });
 }
 
+// Everything a cuFFT plan depends on; see FFTPlanCache for why it is a
+// plain struct.
+struct CuFFTParams {
+  int64_t signal_ndim;
+  long long int signal_sizes[3];
+  long long int inembed[3];
+  long long int onembed[3];
+  long long int istride, idist, ostride, odist, batch;
+  cudaDataType itype, otype, exec_type;
+};
+
+// A cuFFT plan without its own workspace: that is taken from the caching
+// allocator for each transform, so that cached plans don't hold on to device
+// memory.
+struct CuFFTConfig {
+  explicit CuFFTConfig(const CuFFTParams& params) {
+    CUFFT_CHECK(cufftSetAutoAllocation(plan.get(), 0));
+    // cuFFT takes non-const pointers to the sizes
+    CuFFTParams p = params;
+    CUFFT_CHECK(cufftXtMakePlanMany(plan.get(), p.signal_ndim, p.signal_sizes,
+      p.inembed, p.istride, p.idist, p.itype, p.onembed, p.ostride, p.odist,
+      p.otype, p.batch, &ws_size, p.exec_type));
+  }
+
+  CufftHandle plan;
+  size_t ws_size = 0;
+  // The stream and work area are set on the plan itself, so threads that
+  // share it take turns
+  std::mutex mutex;
+};
+
+// Large enough that an stft or conv loop over a few hundred shapes does not
+// thrash, see torch.cuda.set_cufft_plan_cache_max_size
+constexpr int64_t CUFFT_DEFAULT_PLAN_CACHE_SIZE = 1024;
+
+typedef FFTPlanCache<CuFFTParams, CuFFTConfig> CuFFTPlanCache;
+
+static CuFFTPlanCache& cufft_plan_cache(int64_t device) {
+  static std::once_flag init_flag;
+  static std::vector<std::unique_ptr<CuFFTPlanCache>> caches;
+  std::call_once(init_flag, [] {
+    int count = 0;
+    cudaGetDeviceCount(&count);
+    for (int i = 0; i < count; i++) {
+      caches.emplace_back(new CuFFTPlanCache(CUFFT_DEFAULT_PLAN_CACHE_SIZE));
+    }
+  });
+  if (device < 0 || device >= static_cast<int64_t>(caches.size())) {
+    std::ostringstream ss;
+    ss << "cuFFT plan cache: invalid device " << device;
+    throw std::runtime_error(ss.str());
+  }
+  return *caches[device];
+}
+
 // cuFFT
 // Currently not utilizing multi GPUs so this potentially speed up.
 Tensor _fft_cufft(const Tensor& self, int64_t signal_ndim,
@@ -254,8 +313,6 @@ Tensor _fft_cufft(const Tensor& self, int64_t signal_ndim,
   std::vector<long long int> onembed(output_sizes.data() + 1, output_sizes.data() + signal_ndim + 1);
   long long int base_ostride = 1;
 
-  CufftHandle plan;
-  size_t ws = 0;
   cudaDataType itype, otype, exec_type;
   if (input.type().scalarType() == ScalarType::Float) {
     itype = complex_input ? CUDA_C_32F : CUDA_R_32F;
@@ -276,17 +333,41 @@ Tensor _fft_cufft(const Tensor& self, int64_t signal_ndim,
     throw std::runtime_error(ss.str());
   }
 
-  // make plan
-  CUFFT_CHECK(cufftXtMakePlanMany(plan.get(), signal_ndim, signal_sizes.data(),
-    inembed.data(), base_istride, idist, itype, onembed.data(), base_ostride,
-    odist, otype, batch, &ws, exec_type));
+  // get the plan, made only the first time these parameters are seen
+  CuFFTParams params;
+  std::memset(&params, 0, sizeof(params));
+  params.signal_ndim = signal_ndim;
+  std::copy(signal_sizes.begin(), signal_sizes.end(), params.signal_sizes);
+  std::copy(inembed.begin(), inembed.end(), params.inembed);
+  std::copy(onembed.begin(), onembed.end(), params.onembed);
+  params.istride = base_istride;
+  params.idist = idist;
+  params.ostride = base_ostride;
+  params.odist = odist;
+  params.batch = batch;
+  params.itype = itype;
+  params.otype = otype;
+  params.exec_type = exec_type;
+  auto config = cufft_plan_cache(input.get_device()).lookup(params, [&] {
+    return new CuFFTConfig(params);
+  });
 
-  // set to current stream
-  CUFFT_CHECK(cufftSetStream(plan.get(), at::globalContext().getCurrentCUDAStream()));
+  {
+    std::lock_guard<std::mutex> guard(config->mutex);
+    // set to current stream
+    CUFFT_CHECK(cufftSetStream(config->plan.get(), at::globalContext().getCurrentCUDAStream()));
+    // The workspace goes back to the caching allocator right after the
+    // launch, which is safe as later work on the stream runs after it
+    Tensor workspace;
+    if (config->ws_size > 0) {
+      workspace = input.type().toScalarType(kByte).tensor({static_cast<int64_t>(config->ws_size)});
+      CUFFT_CHECK(cufftSetWorkArea(config->plan.get(), workspace.data_ptr()));
+    }
 
-  // run
-  CUFFT_CHECK(cufftXtExec(plan.get(), input.data_ptr(), output.data_ptr(),
-    inverse ? CUFFT_INVERSE : CUFFT_FORWARD));
+    // run
+    CUFFT_CHECK(cufftXtExec(config->plan.get(), input.data_ptr(), output.data_ptr(),
+      inverse ? CUFFT_INVERSE : CUFFT_FORWARD));
+  }
 
   // rescale if needed by normalized flag or inverse transform
   auto size_last_signal_dim = checked_signal_sizes[signal_ndim - 1];
@@ -315,3 +396,25 @@ Tensor _fft_cufft(const Tensor& self, int64_t signal_ndim,
 }
 
 }} // at::native
+
+namespace at { namespace cuda {
+
+CUFFTPlanCacheInfo cufft_plan_cache_info(int64_t device) {
+  auto& cache = native::cufft_plan_cache(device);
+  CUFFTPlanCacheInfo info;
+  info.size = cache.size();
+  info.max_size = cache.max_size();
+  info.hits = cache.hits();
+  info.misses = cache.misses();
+  return info;
+}
+
+void cufft_set_plan_cache_max_size(int64_t device, int64_t max_size) {
+  native::cufft_plan_cache(device).set_max_size(max_size);
+}
+
+void cufft_clear_plan_cache(int64_t device) {
+  native::cufft_plan_cache(device).clear();
+}
+
+}} // namespace at::cuda
@@ -1,15 +1,107 @@
 #include "ATen/ATen.h"
+#include "ATen/Dispatch.h"
+
+#include <THC/THCThrustAllocator.cuh>
+
+#include <thrust/execution_policy.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/scatter.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/unique.h>
 
 #include <tuple>
 
 namespace at {
 namespace native{
 
-std::tuple<Tensor, Tensor>
-_unique_cuda(const Tensor& self, const bool sorted, const bool return_inverse) {
-  throw std::runtime_error(
-      "unique is currently CPU-only, and lacks CUDA support. "
-      "Pull requests welcome!");
+namespace {
+
+// Whether each element of a sorted sequence starts a new group of equal ones
+template <typename scalar_t>
+struct NotEqualToPrevious {
+  const scalar_t* data;
+
+  __host__ __device__ int64_t operator()(int64_t i) const {
+    return i > 0 && data[i] != data[i - 1];
+  }
+};
+
+// The input is sorted, with the permutation if the inverse is needed. The
+// unique elements are the first of each run of equal ones; their counts come
+// from the same reduce_by_key that finds them, and the inverse indices are the
+// run numbers, scattered back through the permutation.
+template <typename scalar_t>
+std::tuple<Tensor, Tensor, Tensor> _unique_cuda_template(
+    const Tensor& self,
+    const bool return_inverse,
+    const bool return_counts) {
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  auto allocator = THCThrustAllocator(globalContext().lazyInitCUDA());
+  auto policy = thrust::cuda::par(allocator).on(stream);
+
+  Type& longType = self.type().toScalarType(kLong);
+  int64_t numel = self.numel();
+  if (numel == 0) {
+    return std::make_tuple(self.type().tensor({0}), longType.tensor({0}), longType.tensor({0}));
+  }
+  Tensor sorted = self.contiguous().view({-1}).clone();
+  scalar_t* sorted_data = sorted.data<scalar_t>();
+
+  Tensor inverse_indices = longType.tensor({0});
+  if (return_inverse) {
+    Tensor permutation = longType.tensor({numel});
+    int64_t* permutation_data = permutation.data<int64_t>();
+    thrust::sequence(policy, permutation_data, permutation_data + numel);
+    thrust::sort_by_key(policy, sorted_data, sorted_data + numel, permutation_data);
+
+    Tensor run = longType.tensor({numel});
+    int64_t* run_data = run.data<int64_t>();
+    thrust::transform(policy,
+        thrust::make_counting_iterator<int64_t>(0),
+        thrust::make_counting_iterator<int64_t>(numel),
+        run_data, NotEqualToPrevious<scalar_t>{sorted_data});
+    thrust::inclusive_scan(policy, run_data, run_data + numel, run_data);
+
+    inverse_indices.resize_(self.sizes());
+    thrust::scatter(policy, run_data, run_data + numel, permutation_data,
+        inverse_indices.data<int64_t>());
+  } else {
+    thrust::sort(policy, sorted_data, sorted_data + numel);
+  }
+
+  Tensor output = self.type().tensor({numel});
+  Tensor counts = longType.tensor({0});
+  int64_t num_unique;
+  if (return_counts) {
+    counts.resize_({numel});
+    auto ends = thrust::reduce_by_key(policy,
+        sorted_data, sorted_data + numel,
+        thrust::make_constant_iterator<int64_t>(1),
+        output.data<scalar_t>(), counts.data<int64_t>());
+    num_unique = ends.first - output.data<scalar_t>();
+    counts.resize_({num_unique});
+  } else {
+    auto end = thrust::unique_copy(policy,
+        sorted_data, sorted_data + numel, output.data<scalar_t>());
+    num_unique = end - output.data<scalar_t>();
+  }
+  output.resize_({num_unique});
+  return std::make_tuple(output, inverse_indices, counts);
+}
+
+} // namespace
+
+// The unique elements are always sorted on CUDA, as they come from sorting.
+std::tuple<Tensor, Tensor, Tensor>
+_unique_cuda(const Tensor& self, const bool sorted, const bool return_inverse, const bool return_counts) {
+  return AT_DISPATCH_ALL_TYPES(self.type(), "unique", [&] {
+    return _unique_cuda_template<scalar_t>(self, return_inverse, return_counts);
+  });
 }
 
 }  // namespace native
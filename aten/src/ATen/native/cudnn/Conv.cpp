@@ -75,10 +75,12 @@ std::tuple<at::Tensor,at::Tensor,at::Tensor> cudnn_convolution_transpose_backwar
 
 #include "THC/THC.h"
 
+#include <ATen/cudnn/AlgorithmCache.h>
 #include <ATen/cudnn/cudnn-wrapper.h>
 #include <ATen/cudnn/Descriptors.h>
 #include <ATen/cudnn/Types.h>
 #include <ATen/cudnn/Utils.h>
+#include <ATen/cudnn/WorkspaceArena.h>
 
 #include <ATen/TensorUtils.h>
 
@@ -341,31 +343,68 @@ struct ParamsEqual {
   }
 };
 
+// The key of a benchmark in the persistent algorithm cache (see
+// ATen/cudnn/AlgorithmCache.h): the GPU architecture, the cuDNN version and
+// every field of the params.
+std::string persistentKey(const char* pass, const ConvolutionParams& params) {
+  auto prop = globalContext().getCurrentDeviceProperties();
+  std::ostringstream key;
+  auto join = [&key](const char* name, const int* values, int n) {
+    key << ";" << name << "=";
+    for (int i = 0; i < n; ++i) {
+      key << (i ? "x" : "") << values[i];
+    }
+  };
+  key << "aten;" << pass << ";sm" << prop->major << prop->minor
+      << ";cudnn" << cudnnGetVersion() << ";type=" << params.dataType;
+  join("input", params.input_size, 2 + max_dim);
+  join("stride", params.input_stride, 2 + max_dim);
+  join("weight", params.weight_size, 2 + max_dim);
+  join("pad", params.padding, max_dim);
+  join("conv_stride", params.stride, max_dim);
+  join("dilation", params.dilation, max_dim);
+  key << ";groups=" << params.groups
+      << ";deterministic=" << params.deterministic;
+  return key.str();
+}
+
 // TODO: Use something less heavy duty than a big honking mutex
 template <typename T>
 struct BenchmarkCache {
   std::mutex mutex;
   std::unordered_map<ConvolutionParams, T, ParamsHash, ParamsEqual> map;
+  // Names the pass in the persistent cache
+  const char* pass;
+
+  explicit BenchmarkCache(const char* pass) : pass(pass) {}
 
   bool find(const ConvolutionParams& params, T* results) {
     std::lock_guard<std::mutex> guard(mutex);
     auto it = map.find(params);
-    if (it == map.end()) {
-      return false;
+    if (it != map.end()) {
+      *results = it->second;
+      return true;
+    }
+    int algo;
+    if (findPersistentAlgorithm(persistentKey(pass, params), &algo)) {
+      *results = static_cast<T>(algo);
+      map[params] = *results;
+      return true;
     }
-    *results = it->second;
-    return true;
+    return false;
   }
 
   void insert(const ConvolutionParams& params, const T& results) {
     std::lock_guard<std::mutex> guard(mutex);
     map[params] = results;
+    insertPersistentAlgorithm(
+        persistentKey(pass, params), static_cast<int>(results));
   }
 };
 
-BenchmarkCache<cudnnConvolutionFwdAlgo_t> fwd_algos;
-BenchmarkCache<cudnnConvolutionBwdDataAlgo_t> bwd_data_algos;
-BenchmarkCache<cudnnConvolutionBwdFilterAlgo_t> bwd_filter_algos;
+BenchmarkCache<cudnnConvolutionFwdAlgo_t> fwd_algos("fwd");
+BenchmarkCache<cudnnConvolutionBwdDataAlgo_t> bwd_data_algos("bwd_data");
+BenchmarkCache<cudnnConvolutionBwdFilterAlgo_t> bwd_filter_algos("bwd_filter");
 
 // TODO: Stop manually allocating CUDA memory; allocate an ATen byte
 // tensor instead.
@@ -718,8 +757,15 @@ void findAlgorithm(const ConvolutionArgs& args, bool benchmark, algo_t* algo) {
   CUDA_CHECK(allocator->emptyCache(allocator->state));
 }
 
+// Scratch space from the shared arena (see ATen/cudnn/WorkspaceArena.h),
+// which owns it
+struct ArenaWorkspace {
+  void* data;
+  size_t size;
+};
+
 template<typename algo_t>
-Workspace chooseAlgorithm(
+ArenaWorkspace chooseAlgorithm(
     const ConvolutionArgs& args,
     bool benchmark,
     algo_t* algo)
@@ -730,7 +776,7 @@ Workspace chooseAlgorithm(
   size_t workspace_size;
   search::getWorkspaceSize(args, *algo, &workspace_size);
   try {
-    return Workspace(workspace_size);
+    return {getCudnnWorkspace(workspace_size), workspace_size};
   } catch (std::runtime_error& e) {
     cudaGetLastError(); // clear OOM error
 
@@ -740,7 +786,7 @@ Workspace chooseAlgorithm(
     search::cache().insert(args.params, *algo);
 
     search::getWorkspaceSize(args, *algo, &workspace_size);
-    return Workspace(workspace_size);
+    return {getCudnnWorkspace(workspace_size), workspace_size};
   }
 }
 
@@ -834,7 +880,7 @@ void raw_cudnn_convolution_forward_out(
   // convolution support is already pretty slow, so this might not
   // matter.  (This applies to raw_cudnn_convolution_backward_input as well.)
   cudnnConvolutionFwdAlgo_t fwdAlg;
-  Workspace workspace = chooseAlgorithm(args, benchmark, &fwdAlg);
+  ArenaWorkspace workspace = chooseAlgorithm(args, benchmark, &fwdAlg);
 
   Constant one(dataType, 1);
   Constant zero(dataType, 0);
@@ -962,7 +1008,7 @@ void raw_cudnn_convolution_backward_input_out(
   args.cdesc.set(dataType, grad_output.dim() - 2, args.params.padding, args.params.stride, args.params.dilation, args.params.groups);
 
   cudnnConvolutionBwdDataAlgo_t bwdDataAlg;
-  Workspace workspace = chooseAlgorithm(args, benchmark, &bwdDataAlg);
+  ArenaWorkspace workspace = chooseAlgorithm(args, benchmark, &bwdDataAlg);
 
   Constant one(dataType, 1);
   Constant zero(dataType, 0);
@@ -1106,7 +1152,7 @@ void raw_cudnn_convolution_backward_weight_out(
   args.cdesc.set(dataType, input.dim() - 2, args.params.padding, args.params.stride, args.params.dilation, args.params.groups);
 
   cudnnConvolutionBwdFilterAlgo_t bwdFilterAlg;
-  Workspace workspace = chooseAlgorithm(args, benchmark, &bwdFilterAlg);
+  ArenaWorkspace workspace = chooseAlgorithm(args, benchmark, &bwdFilterAlg);
 
   Constant one(dataType, 1);
   Constant zero(dataType, 0);
@@ -57,6 +57,7 @@ Tensor _cudnn_init_dropout_state(const Type& ty, double dropout, bool train, int
 #include <ATen/cudnn/Descriptors.h>
 #include <ATen/cudnn/Types.h>
 #include <ATen/cudnn/Utils.h>
+#include <ATen/cudnn/WorkspaceArena.h>
 
 namespace at { namespace native {
 
@@ -658,7 +659,7 @@ std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _cudnn_rnn(
         x_descs_arr.data(),
         &workspace_size
         ));
-  Tensor workspace = input.type().toScalarType(kByte).tensor(workspace_size);
+  void* workspace = getCudnnWorkspace(workspace_size);
 
   Tensor reserve;
   // NB: Previously, the test was for fn.requires_grad, but we don't have
@@ -684,7 +685,7 @@ std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _cudnn_rnn(
           y_descs_arr.data(), y.data_ptr(),
           descs.hy_desc.desc(), hy.data_ptr(),
           descs.cy_desc.desc(), cy.defined() ? cy.data_ptr() : nullptr,
-          workspace.data_ptr(), workspace.size(0),
+          workspace, workspace_size,
           reserve.data_ptr(), reserve.size(0)
           ));
   } else { // inference
@@ -700,7 +701,7 @@ std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _cudnn_rnn(
           y_descs_arr.data(), y.data_ptr(),
           descs.hy_desc.desc(), hy.data_ptr(),
           descs.cy_desc.desc(), cy.defined() ? cy.data_ptr() : nullptr,
-          workspace.data_ptr(), workspace.size(0)
+          workspace, workspace_size
           ));
 
   }
@@ -822,8 +823,7 @@ std::tuple<Tensor, Tensor, Tensor> _cudnn_rnn_backward_input(
         x_descs_arr.data(),
         &workspace_size
         ));
-  // TODO: put this in the correct device???
-  Tensor workspace = input.type().toScalarType(kByte).tensor(workspace_size);
+  void* workspace = getCudnnWorkspace(workspace_size);
 
   CUDNN_CHECK(cudnnRNNBackwardData(
         handle,
@@ -839,7 +839,7 @@ std::tuple<Tensor, Tensor, Tensor> _cudnn_rnn_backward_input(
         x_descs_arr.data(), dx.data_ptr(),
         descs.hx_desc.desc(), dhx.data_ptr(),
         descs.cx_desc.desc(), cx.defined() ? dcx.data_ptr() : nullptr,
-        workspace.data_ptr(), workspace.size(0),
+        workspace, workspace_size,
         fn_reserve.data_ptr(), fn_reserve.size(0)
         ));
 
@@ -932,7 +932,7 @@ std::vector<Tensor> _cudnn_rnn_backward_weight(
         x_descs_arr.data(),
         &workspace_size
         ));
-  Tensor workspace = input.type().toScalarType(kByte).tensor(workspace_size);
+  void* workspace = getCudnnWorkspace(workspace_size);
 
   CUDNN_CHECK(cudnnRNNBackwardWeights(
         handle,
@@ -941,7 +941,7 @@ std::vector<Tensor> _cudnn_rnn_backward_weight(
         x_descs_arr.data(), x.data_ptr(),
         descs.hx_desc.desc(), hx.data_ptr(),
         y_descs_arr.data(), y.data_ptr(),
-        workspace.data_ptr(), workspace.size(0),
+        workspace, workspace_size,
         w_desc.desc(), dw.data_ptr(),
         fn_reserve.data_ptr(), fn_reserve.size(0)
         ));
@@ -28,6 +28,8 @@ Tensor _fft_mkl(const Tensor& input, int64_t signal_ndim,
 #include <vector>
 #include <numeric>
 #include <cmath>
+#include <cstring>
+#include <mutex>
 
 #include <mkl_dfti.h>
 #include <ATen/mkl/Exceptions.h>
@@ -157,6 +159,71 @@ static inline void _fft_fill_with_conjugate_symmetry_(Tensor& input,
   });
 }
 
+// Everything a committed DFTI descriptor depends on; see FFTPlanCache for
+// why it is a plain struct.
+struct MKLFFTParams {
+  DFTI_CONFIG_VALUE prec, signal_type;
+  int64_t signal_ndim;
+  MKL_LONG signal_sizes[3];
+  MKL_LONG batch, idist, odist;
+  MKL_LONG istrides[4], ostrides[4];
+  bool complex_input, complex_output, normalized, inverse;
+};
+
+struct MKLFFTConfig {
+  DftiDescriptor descriptor;
+  // DftiCompute* is only documented to be thread safe for separate
+  // descriptors, so threads that share one take turns
+  std::mutex mutex;
+};
+
+static MKLFFTConfig* make_mkl_fft_config(const MKLFFTParams& params) {
+  std::unique_ptr<MKLFFTConfig> config(new MKLFFTConfig());
+  auto& descriptor = config->descriptor;
+  MKLFFTParams p = params;
+  descriptor.init(p.prec, p.signal_type, p.signal_ndim, p.signal_sizes);
+  // out of place FFT
+  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_PLACEMENT, DFTI_NOT_INPLACE));
+  // batch mode
+  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_NUMBER_OF_TRANSFORMS, p.batch));
+  // batch dim stride, i.e., dist between each data
+  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_INPUT_DISTANCE, p.idist));
+  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_OUTPUT_DISTANCE, p.odist));
+  // signal strides
+  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_INPUT_STRIDES, p.istrides));
+  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_OUTPUT_STRIDES, p.ostrides));
+  // if conjugate domain of real is involved, set standard CCE storage type
+  // this will become default in MKL in future
+  if (!p.complex_input || !p.complex_output) {
+    MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_CONJUGATE_EVEN_STORAGE, DFTI_COMPLEX_COMPLEX));
+  }
+  // rescale if needed by normalized flag or inverse transform
+  if (p.normalized || p.inverse) {
+    auto signal_numel = std::accumulate(p.signal_sizes, p.signal_sizes + p.signal_ndim, 1, std::multiplies<int64_t>());
+    double double_scale;
+    if (p.normalized) {
+      double_scale = 1.0 / std::sqrt(static_cast<double>(signal_numel));
+    } else {
+      double_scale = 1.0 / static_cast<double>(signal_numel);
+    }
+    MKL_DFTI_CHECK(DftiSetValue(descriptor.get(),
+      p.inverse ? DFTI_BACKWARD_SCALE : DFTI_FORWARD_SCALE,
+      p.prec == DFTI_DOUBLE ? double_scale : static_cast<float>(double_scale)));
+  }
+  // finalize
+  MKL_DFTI_CHECK(DftiCommitDescriptor(descriptor.get()));
+  return config.release();
+}
+
+// Committing a descriptor precomputes the twiddle factors, which costs more
+// than the transform itself for the small signals of e.g. stft
+constexpr int64_t MKL_FFT_PLAN_CACHE_SIZE = 256;
+
+static FFTPlanCache<MKLFFTParams, MKLFFTConfig>& mkl_fft_plan_cache() {
+  static FFTPlanCache<MKLFFTParams, MKLFFTConfig> cache(MKL_FFT_PLAN_CACHE_SIZE);
+  return cache;
+}
+
 // MKL DFTI
 Tensor _fft_mkl(const Tensor& self, int64_t signal_ndim,
                 bool complex_input, bool complex_output,
@@ -228,59 +295,44 @@ Tensor _fft_mkl(const Tensor& self, int64_t signal_ndim,
   } else {
     signal_type = complex_output ? DFTI_COMPLEX : DFTI_REAL;
   }
-  // create descriptor with signal size
-  std::vector<MKL_LONG> mkl_signal_sizes(checked_signal_sizes.begin(), checked_signal_sizes.end());
-  for (int64_t i = 0; i < signal_ndim; i++) {
-    mkl_signal_sizes[i] = checked_signal_sizes[i];
-  }
-  DftiDescriptor descriptor;
-  descriptor.init(prec, signal_type, signal_ndim, mkl_signal_sizes.data());
-  // out of place FFT
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_PLACEMENT, DFTI_NOT_INPLACE));
-  // batch mode
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_NUMBER_OF_TRANSFORMS, batch));
+  // get the committed descriptor, made only the first time these parameters
+  // are seen
+  MKLFFTParams params;
+  std::memset(&params, 0, sizeof(params));
+  params.prec = prec;
+  params.signal_type = signal_type;
+  params.signal_ndim = signal_ndim;
+  std::copy(checked_signal_sizes.begin(), checked_signal_sizes.end(), params.signal_sizes);
+  params.batch = batch;
 
   auto istrides = input.strides();
   auto ostrides = output.strides();
   // batch dim stride, i.e., dist between each data
-  MKL_LONG idist = complex_input ? istrides[0] >> 1 : istrides[0];
-  MKL_LONG odist = complex_output ? ostrides[0] >> 1 : ostrides[0];
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_INPUT_DISTANCE, idist));
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_OUTPUT_DISTANCE, odist));
+  params.idist = complex_input ? istrides[0] >> 1 : istrides[0];
+  params.odist = complex_output ? ostrides[0] >> 1 : ostrides[0];
   // signal strides
   // first val is offset, set to zero (ignored)
-  std::vector<MKL_LONG> mkl_istrides(1 + signal_ndim, 0), mkl_ostrides(1 + signal_ndim, 0);
   for (int64_t i = 1; i <= signal_ndim; i++) {
-    mkl_istrides[i] = complex_input ? istrides[i] >> 1 : istrides[i];
-    mkl_ostrides[i] = complex_output ? ostrides[i] >> 1 : ostrides[i];
+    params.istrides[i] = complex_input ? istrides[i] >> 1 : istrides[i];
+    params.ostrides[i] = complex_output ? ostrides[i] >> 1 : ostrides[i];
   }
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_INPUT_STRIDES, mkl_istrides.data()));
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_OUTPUT_STRIDES, mkl_ostrides.data()));
-  // if conjugate domain of real is involved, set standard CCE storage type
-  // this will become default in MKL in future
-  if (!complex_input || !complex_output) {
-    MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_CONJUGATE_EVEN_STORAGE, DFTI_COMPLEX_COMPLEX));
-  }
-  // rescale if needed by normalized flag or inverse transform
-  if (normalized || inverse) {
-    auto signal_numel = std::accumulate(checked_signal_sizes.begin(), checked_signal_sizes.end(), 1, std::multiplies<int64_t>());
-    double double_scale;
-    if (normalized) {
-      double_scale = 1.0 / std::sqrt(static_cast<double>(signal_numel));
+  params.complex_input = complex_input;
+  params.complex_output = complex_output;
+  params.normalized = normalized;
+  params.inverse = inverse;
+  auto config = mkl_fft_plan_cache().lookup(params, [&] {
+    return make_mkl_fft_config(params);
+  });
+
+  // run
+  {
+    std::lock_guard<std::mutex> guard(config->mutex);
+    auto desc = config->descriptor.get();
+    if (!inverse) {
+      MKL_DFTI_CHECK(DftiComputeForward(desc, input.data_ptr(), output.data_ptr()));
     } else {
-      double_scale = 1.0 / static_cast<double>(signal_numel);
+      MKL_DFTI_CHECK(DftiComputeBackward(desc, input.data_ptr(), output.data_ptr()));
     }
-    MKL_DFTI_CHECK(DftiSetValue(descriptor.get(),
-      inverse ? DFTI_BACKWARD_SCALE : DFTI_FORWARD_SCALE,
-      prec == DFTI_DOUBLE ? double_scale : static_cast<float>(double_scale)));
-  }
-  // finalize
-  MKL_DFTI_CHECK(DftiCommitDescriptor(descriptor.get()));
-  // run
-  if (!inverse) {
-    MKL_DFTI_CHECK(DftiComputeForward(descriptor.get(), input.data_ptr(), output.data_ptr()));
-  } else {
-    MKL_DFTI_CHECK(DftiComputeBackward(descriptor.get(), input.data_ptr(), output.data_ptr()));
   }
   // now if needed, fill out the other half using Hermitian symmetry dim
   if (!complex_input && complex_output && !onesided) {
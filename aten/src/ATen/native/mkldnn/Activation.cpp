@@ -0,0 +1,56 @@
+#include <ATen/ATen.h>
+#include <ATen/NativeFunctions.h>
+#include <ATen/Config.h>
+
+#if !AT_MKLDNN_ENABLED()
+
+namespace at { namespace native {
+
+at::Tensor mkldnn_relu(const at::Tensor& self) {
+  throw std::runtime_error("mkldnn_relu: ATen not compiled with MKLDNN support");
+}
+
+}}
+
+#else // AT_MKLDNN_EBABLED
+
+#include <ATen/mkldnn/Runtime.h>
+
+#include <limits>
+
+using namespace mkldnn;
+
+namespace at { namespace native {
+
+at::Tensor mkldnn_relu(const at::Tensor& self)
+{
+  if (self.numel() > std::numeric_limits<int32_t>::max()) {
+    throw std::runtime_error("mkldnn_relu: tensors of more than 2^31 - 1 elements are not supported");
+  }
+  auto input = self.contiguous();
+  auto output = input.type().tensor(input.sizes());
+
+  auto net = cached_primitive_net(
+    PrimitiveKey(kPrimitiveRelu).add(input.numel()),
+    [&](PrimitiveNet& net) {
+      auto cpu_engine = CpuEngine::Instance().get_engine();
+      // The elements are independent, so any tensor is a vector of them
+      memory::dims tz = {static_cast<int32_t>(input.numel())};
+      auto md = memory::desc({tz}, memory::data_type::f32, memory::format::x);
+
+      auto relu_forward_desc = eltwise_forward::desc(prop_kind::forward_inference,
+        algorithm::eltwise_relu, md, 0.f);
+      auto relu_forward_pd = eltwise_forward::primitive_desc(relu_forward_desc, cpu_engine);
+
+      auto input_memory = net.add_user_memory(md);
+      auto output_memory = net.add_user_memory(md);
+      net.net.push_back(eltwise_forward(relu_forward_pd, input_memory, output_memory));
+    });
+  net->run({input.data_ptr(), output.data_ptr()});
+
+  return output;
+}
+
+}}  // namespace at::native
+
+#endif
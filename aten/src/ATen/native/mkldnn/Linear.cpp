@@ -0,0 +1,98 @@
+#include <ATen/ATen.h>
+#include <ATen/NativeFunctions.h>
+#include <ATen/Config.h>
+
+#if !AT_MKLDNN_ENABLED()
+
+namespace at { namespace native {
+
+at::Tensor mkldnn_linear(
+    const at::Tensor& self, const at::Tensor& weight, const at::Tensor& bias) {
+  throw std::runtime_error("mkldnn_linear: ATen not compiled with MKLDNN support");
+}
+
+}}
+
+#else // AT_MKLDNN_EBABLED
+
+#include <ATen/mkldnn/Runtime.h>
+
+using namespace mkldnn;
+
+namespace at { namespace native {
+
+at::Tensor mkldnn_linear(
+    const at::Tensor& self, const at::Tensor& weight, const at::Tensor& bias)
+{
+  if (self.dim() != 2 || weight.dim() != 2) {
+    throw std::runtime_error("mkldnn_linear: expected a 2-d input and weight");
+  }
+  auto input = self.contiguous();
+  auto weight_ = weight.contiguous();
+  auto bias_ = bias.defined() ? bias.contiguous() : bias;
+  auto output = input.type().tensor({input.size(0), weight_.size(0)});
+
+  auto net = cached_primitive_net(
+    PrimitiveKey(kPrimitiveLinear).add(input.sizes()).add(weight_.sizes()).add(bias.defined()),
+    [&](PrimitiveNet& net) {
+      auto cpu_engine = CpuEngine::Instance().get_engine();
+
+      int32_t n = input.size(0);
+      int32_t ic = input.size(1);
+      int32_t oc = weight_.size(0);
+
+      auto data_t = memory::data_type::f32;
+      auto format_any = memory::format::any;
+
+      memory::dims input_tz = {n, ic};
+      memory::dims weight_tz = {oc, ic};
+      memory::dims bias_tz = {oc};
+      memory::dims output_tz = {n, oc};
+
+      auto input_md = memory::desc({input_tz}, data_t, format_any);
+      auto weight_md = memory::desc({weight_tz}, data_t, format_any);
+      auto bias_md = memory::desc({bias_tz}, data_t, format_any);
+      auto output_md = memory::desc({output_tz}, data_t, format_any);
+
+      std::shared_ptr<inner_product_forward::desc> ip_forward_desc;
+      if (bias.defined()) {
+        ip_forward_desc.reset(new inner_product_forward::desc(prop_kind::forward_inference,
+          input_md, weight_md, bias_md, output_md));
+      } else {
+        ip_forward_desc.reset(new inner_product_forward::desc(prop_kind::forward_inference,
+          input_md, weight_md, output_md));
+      }
+      auto ip_forward_pd = inner_product_forward::primitive_desc(*ip_forward_desc, cpu_engine);
+
+      // The user memories, in the order of run() below
+      auto input_usr_memory = net.add_user_memory({{input_tz}, data_t, memory::format::nc});
+      auto weight_usr_memory = net.add_user_memory({{weight_tz}, data_t, memory::format::oi});
+      auto output_usr_memory = net.add_user_memory({{output_tz}, data_t, memory::format::nc});
+
+      // The weight is reordered on every run, as it may have changed in place
+      auto input_memory = net.reorder_input(input_usr_memory, ip_forward_pd.src_primitive_desc());
+      auto weight_memory = net.reorder_input(weight_usr_memory, ip_forward_pd.weights_primitive_desc());
+      auto output_memory = net.output_memory(output_usr_memory, ip_forward_pd.dst_primitive_desc());
+
+      if (bias.defined()) {
+        auto bias_usr_memory = net.add_user_memory({{bias_tz}, data_t, memory::format::x});
+        net.net.push_back(inner_product_forward(ip_forward_pd, input_memory,
+          weight_memory, bias_usr_memory, output_memory));
+      } else {
+        net.net.push_back(inner_product_forward(ip_forward_pd, input_memory,
+          weight_memory, output_memory));
+      }
+      net.reorder_output(output_memory, output_usr_memory);
+    });
+  if (bias.defined()) {
+    net->run({input.data_ptr(), weight_.data_ptr(), output.data_ptr(), bias_.data_ptr()});
+  } else {
+    net->run({input.data_ptr(), weight_.data_ptr(), output.data_ptr()});
+  }
+
+  return output;
+}
+
+}}  // namespace at::native
+
+#endif
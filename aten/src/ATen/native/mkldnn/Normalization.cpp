@@ -0,0 +1,131 @@
+#include <ATen/ATen.h>
+#include <ATen/NativeFunctions.h>
+#include <ATen/Config.h>
+
+#if !AT_MKLDNN_ENABLED()
+
+namespace at { namespace native {
+
+at::Tensor mkldnn_batch_norm(
+    const at::Tensor& self, const at::Tensor& weight, const at::Tensor& bias,
+    const at::Tensor& running_mean, const at::Tensor& running_var, double eps) {
+  throw std::runtime_error("mkldnn_batch_norm: ATen not compiled with MKLDNN support");
+}
+
+at::Tensor mkldnn_local_response_norm(
+    const at::Tensor& self, int64_t size, double alpha, double beta, double k) {
+  throw std::runtime_error("mkldnn_local_response_norm: ATen not compiled with MKLDNN support");
+}
+
+}}
+
+#else // AT_MKLDNN_EBABLED
+
+#include <ATen/mkldnn/Runtime.h>
+
+using namespace mkldnn;
+
+namespace at { namespace native {
+
+namespace {
+
+// MKL-DNN normalizes 4-d tensors; an (N, C, ...) input of fewer dimensions is
+// viewed as (N, C, H, 1) or (N, C, 1, 1)
+memory::dims nchw_dims(const at::Tensor& input)
+{
+  if (input.dim() < 2 || input.dim() > 4) {
+    throw std::runtime_error("mkldnn: expected a 2-d, 3-d or 4-d input");
+  }
+  return {
+    static_cast<int32_t>(input.size(0)),
+    static_cast<int32_t>(input.size(1)),
+    static_cast<int32_t>(input.dim() > 2 ? input.size(2) : 1),
+    static_cast<int32_t>(input.dim() > 3 ? input.size(3) : 1)};
+}
+
+}  // namespace
+
+at::Tensor mkldnn_batch_norm(
+    const at::Tensor& self, const at::Tensor& weight, const at::Tensor& bias,
+    const at::Tensor& running_mean, const at::Tensor& running_var, double eps)
+{
+  auto input = self.contiguous();
+  auto output = input.type().tensor(input.sizes());
+  // The scale and shift are a single (2, C) tensor for MKL-DNN
+  auto scale_shift = at::stack({weight, bias}).contiguous();
+  auto mean = running_mean.contiguous();
+  auto variance = running_var.contiguous();
+
+  auto net = cached_primitive_net(
+    PrimitiveKey(kPrimitiveBatchNorm).add(input.sizes()).add(eps),
+    [&](PrimitiveNet& net) {
+      auto cpu_engine = CpuEngine::Instance().get_engine();
+
+      auto data_t = memory::data_type::f32;
+      memory::dims input_tz = nchw_dims(input);
+      memory::dims stats_tz = {input_tz[1]};
+      memory::dims scale_shift_tz = {2, input_tz[1]};
+
+      auto input_md = memory::desc({input_tz}, data_t, memory::format::nchw);
+      auto stats_md = memory::desc({stats_tz}, data_t, memory::format::x);
+      auto scale_shift_md = memory::desc({scale_shift_tz}, data_t, memory::format::nc);
+
+      // Normalize with the running statistics, as in evaluation mode
+      auto bn_forward_desc = batch_normalization_forward::desc(
+        prop_kind::forward_inference, input_md, static_cast<float>(eps),
+        use_global_stats | use_scale_shift);
+      auto bn_forward_pd = batch_normalization_forward::primitive_desc(
+        bn_forward_desc, cpu_engine);
+
+      auto input_memory = net.add_user_memory(input_md);
+      auto mean_memory = net.add_user_memory(stats_md);
+      auto variance_memory = net.add_user_memory(stats_md);
+      auto scale_shift_memory = net.add_user_memory(scale_shift_md);
+      auto output_memory = net.add_user_memory(input_md);
+      net.net.push_back(batch_normalization_forward(bn_forward_pd,
+        input_memory, mean_memory, variance_memory, scale_shift_memory,
+        output_memory));
+    });
+  net->run({input.data_ptr(), mean.data_ptr(), variance.data_ptr(),
+            scale_shift.data_ptr(), output.data_ptr()});
+
+  return output;
+}
+
+at::Tensor mkldnn_local_response_norm(
+    const at::Tensor& self, int64_t size, double alpha, double beta, double k)
+{
+  if (size % 2 == 0) {
+    // The window of MKL-DNN is centered on the channel, which it can only be
+    // for odd sizes
+    throw std::runtime_error("mkldnn_local_response_norm: expected an odd size");
+  }
+  auto input = self.contiguous();
+  auto output = input.type().tensor(input.sizes());
+
+  auto net = cached_primitive_net(
+    PrimitiveKey(kPrimitiveLRN).add(input.sizes()).add(size).add(alpha).add(beta).add(k),
+    [&](PrimitiveNet& net) {
+      auto cpu_engine = CpuEngine::Instance().get_engine();
+
+      auto input_md = memory::desc({nchw_dims(input)}, memory::data_type::f32,
+        memory::format::nchw);
+
+      // Like torch.nn.LocalResponseNorm, MKL-DNN divides alpha by the size
+      auto lrn_forward_desc = lrn_forward::desc(prop_kind::forward_inference,
+        algorithm::lrn_across_channels, input_md, static_cast<int>(size),
+        static_cast<float>(alpha), static_cast<float>(beta), static_cast<float>(k));
+      auto lrn_forward_pd = lrn_forward::primitive_desc(lrn_forward_desc, cpu_engine);
+
+      auto input_memory = net.add_user_memory(input_md);
+      auto output_memory = net.add_user_memory(input_md);
+      net.net.push_back(lrn_forward(lrn_forward_pd, input_memory, output_memory));
+    });
+  net->run({input.data_ptr(), output.data_ptr()});
+
+  return output;
+}
+
+}}  // namespace at::native
+
+#endif
@@ -0,0 +1,142 @@
+#include <ATen/ATen.h>
+#include <ATen/NativeFunctions.h>
+#include <ATen/Config.h>
+
+#if !AT_MKLDNN_ENABLED()
+
+namespace at { namespace native {
+
+at::Tensor mkldnn_max_pool2d(
+    const at::Tensor& self, IntList kernel_size, IntList stride,
+    IntList padding, bool ceil_mode) {
+  throw std::runtime_error("mkldnn_max_pool2d: ATen not compiled with MKLDNN support");
+}
+
+at::Tensor mkldnn_avg_pool2d(
+    const at::Tensor& self, IntList kernel_size, IntList stride,
+    IntList padding, bool ceil_mode, bool count_include_pad) {
+  throw std::runtime_error("mkldnn_avg_pool2d: ATen not compiled with MKLDNN support");
+}
+
+}}
+
+#else // AT_MKLDNN_EBABLED
+
+#include <ATen/mkldnn/Runtime.h>
+
+using namespace mkldnn;
+
+namespace at { namespace native {
+
+namespace {
+
+// Same as THNN's SpatialMaxPooling and SpatialAveragePooling: with ceil_mode,
+// the last window may stick out of the input, but must start inside it if the
+// input is padded
+int64_t pool_output_size(
+    int64_t input_size, int64_t kernel, int64_t stride, int64_t padding,
+    bool ceil_mode, bool padded)
+{
+  int64_t span = input_size + 2 * padding - kernel;
+  int64_t output_size = (ceil_mode ? (span + stride - 1) / stride : span / stride) + 1;
+  if (ceil_mode && padded && (output_size - 1) * stride >= input_size + padding) {
+    --output_size;
+  }
+  return output_size;
+}
+
+at::Tensor mkldnn_pool2d(
+    const at::Tensor& self, IntList kernel_size, IntList stride,
+    IntList padding, bool ceil_mode, algorithm pooling_algorithm)
+{
+  if (self.dim() != 4 || kernel_size.size() != 2 || padding.size() != 2
+      || (stride.size() != 2 && stride.size() != 0)) {
+    throw std::runtime_error("mkldnn_pool2d: expected a 4-d input, and 2 kernel sizes, strides and paddings");
+  }
+  // As in THNN, the stride defaults to the kernel size
+  if (stride.size() == 0) {
+    stride = kernel_size;
+  }
+
+  auto input = self.contiguous();
+  int32_t n = input.size(0);
+  int32_t c = input.size(1);
+  int32_t ih = input.size(2);
+  int32_t iw = input.size(3);
+
+  bool padded = padding[0] != 0 || padding[1] != 0;
+  int32_t oh = pool_output_size(ih, kernel_size[0], stride[0], padding[0], ceil_mode, padded);
+  int32_t ow = pool_output_size(iw, kernel_size[1], stride[1], padding[1], ceil_mode, padded);
+  auto output = input.type().tensor({n, c, oh, ow});
+
+  auto net = cached_primitive_net(
+    PrimitiveKey(pooling_algorithm == algorithm::pooling_max ? kPrimitiveMaxPool2d : kPrimitiveAvgPool2d)
+      .add(input.sizes()).add(kernel_size).add(stride).add(padding).add(ceil_mode)
+      .add(static_cast<int64_t>(pooling_algorithm)),
+    [&](PrimitiveNet& net) {
+      auto cpu_engine = CpuEngine::Instance().get_engine();
+
+      int32_t kh = kernel_size[0];
+      int32_t kw = kernel_size[1];
+      int32_t sh = stride[0];
+      int32_t sw = stride[1];
+      int32_t ph = padding[0];
+      int32_t pw = padding[1];
+
+      auto data_t = memory::data_type::f32;
+      auto format_nchw = memory::format::nchw;
+
+      memory::dims input_tz = {n, c, ih, iw};
+      memory::dims output_tz = {n, c, oh, ow};
+      memory::dims _kernel = {kh, kw};
+      memory::dims _stride = {sh, sw};
+      memory::dims _padding_l = {ph, pw};
+      // The extra padding of the last window in ceil_mode is on the right
+      memory::dims _padding_r = {
+        (oh - 1) * sh + kh - ih - ph > ph ? (oh - 1) * sh + kh - ih - ph : ph,
+        (ow - 1) * sw + kw - iw - pw > pw ? (ow - 1) * sw + kw - iw - pw : pw};
+
+      auto input_md = memory::desc({input_tz}, data_t, format_nchw);
+      auto output_md = memory::desc({output_tz}, data_t, format_nchw);
+
+      auto pool_forward_desc = pooling_forward::desc(prop_kind::forward_inference,
+        pooling_algorithm, input_md, output_md, _stride, _kernel,
+        _padding_l, _padding_r, padding_kind::zero);
+      auto pool_forward_pd = pooling_forward::primitive_desc(pool_forward_desc, cpu_engine);
+
+      auto input_memory = net.add_user_memory(input_md);
+      auto output_memory = net.add_user_memory(output_md);
+      net.net.push_back(pooling_forward(pool_forward_pd, input_memory, output_memory));
+    });
+  net->run({input.data_ptr(), output.data_ptr()});
+
+  return output;
+}
+
+}  // namespace
+
+at::Tensor mkldnn_max_pool2d(
+    const at::Tensor& self, IntList kernel_size, IntList stride,
+    IntList padding, bool ceil_mode)
+{
+  return mkldnn_pool2d(self, kernel_size, stride, padding, ceil_mode,
+                       algorithm::pooling_max);
+}
+
+at::Tensor mkldnn_avg_pool2d(
+    const at::Tensor& self, IntList kernel_size, IntList stride,
+    IntList padding, bool ceil_mode, bool count_include_pad)
+{
+  if (ceil_mode && count_include_pad) {
+    // MKL-DNN would count the extra padding of the last window in ceil_mode,
+    // which THNN does not
+    throw std::runtime_error("mkldnn_avg_pool2d: ceil_mode with count_include_pad is not supported");
+  }
+  return mkldnn_pool2d(self, kernel_size, stride, padding, ceil_mode,
+                       count_include_pad ? algorithm::pooling_avg_include_padding
+                                         : algorithm::pooling_avg_exclude_padding);
+}
+
+}}  // namespace at::native
+
+#endif
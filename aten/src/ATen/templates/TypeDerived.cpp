@@ -20,6 +20,7 @@
 #include "ATen/THLongStorageView.h"
 #include "ATen/UndefinedTensor.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/native/BinaryOps.h"
 #include <iostream>
 #include <sstream>
 
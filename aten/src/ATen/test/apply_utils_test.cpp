@@ -0,0 +1,65 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "ATen/ATen.h"
+#include "ATen/CPUApplyUtils.h"
+#include "test_seed.h"
+
+using namespace at;
+
+// A tensor and non-contiguous views of it, large enough to be split into
+// several chunks
+static std::vector<Tensor> views(const Tensor& t) {
+  return {
+    t,
+    t.transpose(0, 2),
+    t.narrow(1, 1, 500),
+    t.select(2, 3).unsqueeze(2).expand({8, 1000, 16}),
+  };
+}
+
+// An uninitialized tensor of the given sizes with reversed strides
+static Tensor transposed_tensor(IntList sizes) {
+  return CPU(kDouble).tensor({sizes[2], sizes[1], sizes[0]}).transpose(0, 2);
+}
+
+TEST_CASE( "parallel apply matches the serial apply", "[cpu]" ) {
+  manual_seed(123);
+  auto a = randn(CPU(kDouble), {8, 1000, 16});
+  auto b = randn(CPU(kDouble), {8, 1000, 16});
+  auto op = [](double& out, const double& x, const double& y) {
+    out = x * 2 + y;
+  };
+
+  for (int num_threads : {1, 4}) {
+    set_num_threads(num_threads);
+    for (const auto& x : views(a)) {
+      for (const auto& y : views(b)) {
+        if (x.numel() != y.numel()) {
+          continue;
+        }
+        INFO("sizes " << x.sizes() << " and " << y.sizes() << " with " << num_threads << " threads");
+        auto expected = CPU(kDouble).tensor(x.sizes());
+        CPU_tensor_apply3<double, double, double>(expected, x, y, op);
+
+        auto out = transposed_tensor(x.sizes());
+        CPU_tensor_parallel_apply3<double, double, double>(out, x, y, op);
+        REQUIRE(out.equal(expected));
+
+        out = transposed_tensor(x.sizes());
+        CPU_tensor_parallel_kernel_apply3<double, double, double>(out, x, y,
+          [](int64_t n, double* out, const double* x, const double* y) {
+            for (int64_t i = 0; i < n; i++) {
+              out[i] = x[i] * 2 + y[i];
+            }
+          });
+        REQUIRE(out.equal(expected));
+      }
+    }
+  }
+
+  auto c = CPU(kDouble).tensor({8, 1000});
+  REQUIRE_THROWS_AS(
+      (CPU_tensor_parallel_apply3<double, double, double>(c, a, b, op)),
+      std::runtime_error);
+}
@@ -153,6 +153,37 @@ static void test(Type & type) {
     }
   }
 
+  SECTION( "copy (permuted)" ) {
+    // Big enough to take the blocked transpose path, with sizes that are not
+    // multiples of the block size.
+    Tensor a = rand(type, {67, 130, 9});
+    auto a_cpu = a.toBackend(kCPU);
+    auto acc = a_cpu.accessor<float, 3>();
+    std::vector<std::vector<int64_t>> perms = {{1, 0, 2}, {2, 1, 0}, {0, 2, 1}, {2, 0, 1}};
+    for (auto& perm : perms) {
+      Tensor p = a.permute(perm);
+      Tensor c = p.contiguous();
+      REQUIRE(c.is_contiguous());
+      REQUIRE(c.sizes().equals(p.sizes()));
+      Tensor d = zeros(type, p.sizes());
+      d.copy_(p);
+      REQUIRE(d.equal(c));
+      auto c_cpu = c.toBackend(kCPU);
+      auto c_acc = c_cpu.accessor<float, 3>();
+      int64_t index[3];
+      bool same = true;
+      for (index[0] = 0; index[0] < a.size(0); index[0]++) {
+        for (index[1] = 0; index[1] < a.size(1); index[1]++) {
+          for (index[2] = 0; index[2] < a.size(2); index[2]++) {
+            same = same && c_acc[index[perm[0]]][index[perm[1]]][index[perm[2]]] ==
+                acc[index[0]][index[1]][index[2]];
+          }
+        }
+      }
+      REQUIRE(same);
+    }
+  }
+
   SECTION( "abs(value)" ) {
     Tensor r = at::abs(type.scalarTensor(-3));
     REQUIRE(Scalar(r).toInt() == 3);
@@ -0,0 +1,136 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "ATen/ATen.h"
+#include "ATen/ExpandUtils.h"
+#include "test_seed.h"
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+using namespace at;
+
+// Computes op one element at a time on contiguous copies of the operands
+// broadcast to a common size.
+template <typename scalar_t, typename out_t, typename Op>
+static Tensor reference(const Tensor& a, const Tensor& b, Type& out_type, Op op) {
+  auto sizes = infer_size(a.sizes(), b.sizes());
+  auto a_ = a.expand(sizes).contiguous();
+  auto b_ = b.expand(sizes).contiguous();
+  auto result = out_type.tensor(sizes);
+  auto a_data = a_.data<scalar_t>();
+  auto b_data = b_.data<scalar_t>();
+  auto result_data = result.data<out_t>();
+  for (int64_t i = 0; i < result.numel(); i++) {
+    result_data[i] = op(a_data[i], b_data[i]);
+  }
+  return result;
+}
+
+// Operand pairs laid out in all the ways the kernels distinguish:
+// contiguous, transposed, strided, broadcast along either side, scalars, and
+// big enough to run in parallel.
+static std::vector<std::pair<Tensor, Tensor>> operands(Type& T) {
+  auto big = T.randn({300, 500});
+  return {
+    {T.randn({5}), T.randn({5})},
+    {T.randn({37, 50}), T.randn({37, 50})},
+    {T.randn({37, 50}), T.randn({50, 37}).t()},
+    {T.randn({50, 37}).t(), T.randn({50, 37}).t()},
+    {T.randn({20, 30, 40}).slice(2, 1, 40, 3), T.randn({20, 30, 13})},
+    {T.randn({37, 50}), T.randn({50})},
+    {T.randn({37, 1}), T.randn({37, 50})},
+    {T.randn({7, 1, 9}), T.randn({1, 11, 1})},
+    {T.randn({}), T.randn({3, 4})},
+    {big, big},
+    {big, T.randn({500, 300}).t()},
+    {big, T.randn({300, 1})},
+  };
+}
+
+template <typename scalar_t>
+static void test_ops(Type& T, double atol, double rtol) {
+  Type& B = T.toScalarType(kByte);
+  for (auto& p : operands(T)) {
+    auto& a = p.first;
+    // Keeps divisors away from 0.
+    auto b = p.second.abs().add(1);
+
+    auto add = reference<scalar_t, scalar_t>(a, b, T, [](scalar_t x, scalar_t y) -> scalar_t { return x + 2 * y; });
+    auto sub = reference<scalar_t, scalar_t>(a, b, T, [](scalar_t x, scalar_t y) -> scalar_t { return x - 2 * y; });
+    auto mul = reference<scalar_t, scalar_t>(a, b, T, [](scalar_t x, scalar_t y) -> scalar_t { return x * y; });
+    auto div = reference<scalar_t, scalar_t>(a, b, T, [](scalar_t x, scalar_t y) -> scalar_t { return x / y; });
+    REQUIRE(a.add(b, 2).allclose(add, rtol, atol));
+    REQUIRE(a.sub(b, 2).allclose(sub, rtol, atol));
+    REQUIRE(a.mul(b).allclose(mul, rtol, atol));
+    REQUIRE(a.div(b).allclose(div, rtol, atol));
+
+    auto lt = reference<scalar_t, uint8_t>(a, b, B, std::less<scalar_t>());
+    auto ge = reference<scalar_t, uint8_t>(a, b, B, std::greater_equal<scalar_t>());
+    auto eq = reference<scalar_t, uint8_t>(a, a, B, std::equal_to<scalar_t>());
+    REQUIRE(a.lt(b).equal(lt));
+    REQUIRE(b.le(a).equal(ge));
+    REQUIRE(b.gt(a).equal(lt));
+    REQUIRE(a.ge(b).equal(ge));
+    REQUIRE(a.eq(a).equal(eq));
+    REQUIRE(a.ne(a).equal(1 - eq));
+
+    if (a.sizes().equals(add.sizes())) {
+      auto x = a.clone();
+      x.add_(b, 2);
+      REQUIRE(x.allclose(add, rtol, atol));
+      x = a.clone();
+      x.lt_(b);
+      REQUIRE(x.equal(lt.toType(T)));
+    }
+    if (a.dim() == 2 && a.sizes().equals(add.sizes())) {
+      // In-place ops keep the strides of a non-contiguous self.
+      auto x = a.t().clone().t();
+      x.mul_(b);
+      REQUIRE(x.allclose(mul, rtol, atol));
+    }
+  }
+}
+
+TEST_CASE( "binary ops CPU", "[cpu]" ) {
+  manual_seed(123);
+
+  SECTION( "floating types match an elementwise reference" ) {
+    test_ops<float>(CPU(kFloat), 1e-5, 1e-5);
+    test_ops<double>(CPU(kDouble), 1e-12, 1e-12);
+  }
+
+  SECTION( "integral types match the floating point results" ) {
+    for (auto s : {kInt, kLong}) {
+      for (auto& p : operands(CPU(kFloat))) {
+        auto a = p.first.mul(10).toType(s);
+        auto b = p.second.mul(10).abs().add(1).toType(s);
+        auto a_ = a.toType(kDouble);
+        auto b_ = b.toType(kDouble);
+        REQUIRE(a.add(b, 3).equal(a_.add(b_, 3).toType(s)));
+        REQUIRE(a.sub(b, 3).equal(a_.sub(b_, 3).toType(s)));
+        REQUIRE(a.mul(b).equal(a_.mul(b_).toType(s)));
+        REQUIRE(a.div(b).equal(a_.div(b_).trunc().toType(s)));
+        REQUIRE(a.lt(b).equal(a_.lt(b_)));
+        REQUIRE(a.eq(b).equal(a_.eq(b_)));
+      }
+    }
+  }
+
+  SECTION( "results are written into non-contiguous outputs" ) {
+    auto a = CPU(kFloat).randn({40, 30});
+    auto b = CPU(kFloat).randn({40, 30});
+    auto result = CPU(kFloat).randn({30, 40}).t();
+    at::add_out(result, a, b);
+    REQUIRE(result.equal(a.add(b)));
+    REQUIRE(result.stride(0) == 1);
+  }
+
+  SECTION( "in-place ops can take self as the other operand" ) {
+    auto a = CPU(kFloat).randn({300, 500});
+    auto expected = a.mul(2);
+    a.add_(a);
+    REQUIRE(a.equal(expected));
+  }
+}
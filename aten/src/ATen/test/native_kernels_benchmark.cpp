@@ -0,0 +1,334 @@
+#include "benchmark/benchmark.h"
+
+#include "ATen/ATen.h"
+#include "ATen/CPUGeneral.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace at;
+
+// Benchmarks of the ATen native kernels, for catching performance
+// regressions, e.g. a reduction that stops being vectorized.
+//
+// Every benchmark is registered for each device, input layout and number of
+// threads, under a name of the form kernel/device/layout/threads:N/size:M, so
+// results of different builds can be compared by name. Use
+// --benchmark_out=<file> --benchmark_out_format=json to record them.
+
+namespace {
+
+// Matrices laid out in the ways the kernels distinguish.
+enum class Layout { Contiguous, Transposed, Strided, Broadcast };
+
+const char* layoutName(Layout layout) {
+  switch (layout) {
+    case Layout::Contiguous:
+      return "contiguous";
+    case Layout::Transposed:
+      return "transposed";
+    case Layout::Strided:
+      return "strided";
+    case Layout::Broadcast:
+      return "broadcast";
+  }
+  return "";
+}
+
+// A rows x cols matrix in the given layout.
+Tensor matrix(Type& T, int64_t rows, int64_t cols, Layout layout) {
+  switch (layout) {
+    case Layout::Contiguous:
+      return randn(T, {rows, cols});
+    case Layout::Transposed:
+      return randn(T, {cols, rows}).t();
+    case Layout::Strided:
+      return randn(T, {rows, 2 * cols}).slice(1, 0, 2 * cols, 2);
+    case Layout::Broadcast:
+      return randn(T, {1, cols}).expand({rows, cols});
+  }
+  return Tensor();
+}
+
+// Kernels on CUDA run asynchronously: reading back one element of the result
+// waits for them to finish, at the cost of a small copy.
+void sync(const Tensor& result) {
+  if (result.type().is_cuda()) {
+    result.view({-1})[0].toCDouble();
+  }
+}
+
+typedef std::function<Tensor(const Tensor&)> Kernel;
+
+struct KernelSpec {
+  std::string name;
+  Kernel kernel;
+  // bytes read and written per element of the input
+  int64_t bytes_per_element;
+};
+
+void runKernel(
+    benchmark::State& state,
+    Type& T,
+    const Kernel& kernel,
+    int64_t bytes_per_element,
+    Layout layout) {
+  const int64_t threads = state.range(0);
+  const int64_t size = state.range(1);
+  const int64_t cols = std::min<int64_t>(size, 1024);
+  const int64_t rows = size / cols;
+  if (!T.is_cuda()) {
+    at::set_num_threads(threads);
+  }
+  auto input = matrix(T, rows, cols, layout);
+  sync(kernel(input));
+  while (state.KeepRunning()) {
+    auto result = kernel(input);
+    sync(result);
+  }
+  state.SetItemsProcessed(state.iterations() * input.numel());
+  state.SetBytesProcessed(
+      state.iterations() * input.numel() * T.elementSizeInBytes() *
+      bytes_per_element);
+}
+
+std::vector<KernelSpec> matrixKernels() {
+  return {
+      {"sum", [](const Tensor& x) { return x.sum(); }, 1},
+      {"sum_dim0", [](const Tensor& x) { return x.sum(0); }, 1},
+      {"sum_dim1", [](const Tensor& x) { return x.sum(1); }, 1},
+      {"mean_dim1", [](const Tensor& x) { return x.mean(1); }, 1},
+      {"max_dim1",
+       [](const Tensor& x) { return std::get<0>(x.max(1)); },
+       1},
+      {"norm", [](const Tensor& x) { return x.norm(); }, 1},
+      {"add", [](const Tensor& x) { return x + x; }, 3},
+      {"mul_scalar", [](const Tensor& x) { return x * 2; }, 2},
+      {"exp", [](const Tensor& x) { return x.exp(); }, 2},
+      {"sigmoid", [](const Tensor& x) { return x.sigmoid(); }, 2},
+      {"add_inplace",
+       [](const Tensor& x) {
+         auto y = x.contiguous();
+         return y.add_(y);
+       },
+       3},
+      {"contiguous", [](const Tensor& x) { return x.contiguous(); }, 2},
+      {"copy",
+       [](const Tensor& x) {
+         auto y = x.type().tensor(x.sizes());
+         return y.copy_(x);
+       },
+       2},
+      {"index_select",
+       [](const Tensor& x) {
+         auto index = x.type().toScalarType(kLong).arange(0, x.size(0), 2);
+         return x.index_select(0, index);
+       },
+       1},
+      {"advanced_index",
+       [](const Tensor& x) {
+         auto index = x.type().toScalarType(kLong).arange(0, x.size(0), 2);
+         return x.index({index});
+       },
+       1},
+  };
+}
+
+void embeddingBag(benchmark::State& state, Type& T) {
+  const int64_t threads = state.range(0);
+  const int64_t num_indices = state.range(1);
+  const int64_t num_embeddings = 100000;
+  const int64_t dim = 64;
+  const int64_t bag_size = 20;
+  if (!T.is_cuda()) {
+    at::set_num_threads(threads);
+  }
+  auto weight = randn(T, {num_embeddings, dim});
+  auto& L = T.toScalarType(kLong);
+  auto indices = L.copy(
+      CPU(kLong).randperm(num_embeddings).slice(0, 0, num_indices));
+  auto offsets = L.arange(0, num_indices, bag_size);
+  while (state.KeepRunning()) {
+    auto result = std::get<0>(at::embedding_bag(weight, indices, offsets));
+    sync(result);
+  }
+  state.SetItemsProcessed(state.iterations() * num_indices);
+  state.SetBytesProcessed(
+      state.iterations() * num_indices * dim * T.elementSizeInBytes());
+}
+
+void conv2d(benchmark::State& state, Type& T) {
+  const int64_t threads = state.range(0);
+  const int64_t channels = state.range(1);
+  if (!T.is_cuda()) {
+    at::set_num_threads(threads);
+  }
+  auto input = randn(T, {8, channels, 56, 56});
+  auto weight = randn(T, {channels, channels, 3, 3});
+  while (state.KeepRunning()) {
+    auto result = at::conv2d(input, weight, {}, 1, 1);
+    sync(result);
+  }
+  // multiply-adds of the convolution
+  state.SetItemsProcessed(
+      state.iterations() * 8 * 56 * 56 * channels * channels * 9);
+}
+
+// Square matrix products. Floating point types go to BLAS when it is linked,
+// so comparing a build with BLAS (e.g. OpenBLAS) to one without compares it
+// with the fallback GEMM of THBlas, which integer types always use.
+void mm(benchmark::State& state, Type& T, bool transposed) {
+  const int64_t threads = state.range(0);
+  const int64_t size = state.range(1);
+  if (!T.is_cuda()) {
+    at::set_num_threads(threads);
+  }
+  // small integers, so that integer types don't overflow
+  auto a = T.copy(randn(CPU(kFloat), {size, size}).mul(8));
+  auto b = T.copy(randn(CPU(kFloat), {size, size}).mul(8));
+  if (transposed) {
+    a = a.t();
+  }
+  while (state.KeepRunning()) {
+    auto result = a.mm(b);
+    sync(result);
+  }
+  // multiply-adds of the product
+  state.SetItemsProcessed(state.iterations() * size * size * size);
+}
+
+// Sparse COO matrices with about 1% of non-zero elements.
+Tensor sparseMatrix(Type& T, int64_t size) {
+  const int64_t nnz = size * size / 100;
+  auto& L = T.toScalarType(kLong);
+  auto indices = L.copy(CPU(kLong).randperm(size * size).slice(0, 0, nnz));
+  auto rows_and_cols = at::stack({indices / size, indices.remainder(size)});
+  return T.toBackend(T.is_cuda() ? kSparseCUDA : kSparseCPU)
+      .sparse_coo_tensor(rows_and_cols, randn(T, {nnz}), {size, size});
+}
+
+void sparseAdd(benchmark::State& state, Type& T) {
+  const int64_t size = state.range(1);
+  auto a = sparseMatrix(T, size);
+  auto b = sparseMatrix(T, size);
+  while (state.KeepRunning()) {
+    auto result = a + b;
+    sync(result._values());
+  }
+  state.SetItemsProcessed(state.iterations() * a._nnz());
+}
+
+void sparseToDense(benchmark::State& state, Type& T) {
+  const int64_t size = state.range(1);
+  auto a = sparseMatrix(T, size);
+  while (state.KeepRunning()) {
+    auto result = a.to_dense();
+    sync(result);
+  }
+  state.SetItemsProcessed(state.iterations() * size * size);
+}
+
+void sparseDenseMatmul(benchmark::State& state, Type& T) {
+  const int64_t threads = state.range(0);
+  const int64_t size = state.range(1);
+  if (!T.is_cuda()) {
+    at::set_num_threads(threads);
+  }
+  auto a = sparseMatrix(T, size);
+  auto b = randn(T, {size, 64});
+  auto c = T.zeros({size, 64});
+  while (state.KeepRunning()) {
+    auto result = at::addmm(c, a, b);
+    sync(result);
+  }
+  state.SetItemsProcessed(state.iterations() * a._nnz() * 64);
+}
+
+std::vector<int64_t> threadCounts(Type& T) {
+  const int64_t max_threads = at::get_num_threads();
+  if (T.is_cuda() || max_threads == 1) {
+    return {1};
+  }
+  return {1, max_threads};
+}
+
+void registerBenchmark(
+    Type& T,
+    const std::string& name,
+    std::function<void(benchmark::State&)> fn,
+    std::vector<int64_t> sizes) {
+  auto* b = benchmark::RegisterBenchmark(
+      name.c_str(), [fn](benchmark::State& state) { fn(state); });
+  b->ArgNames({"threads", "size"});
+  for (auto t : threadCounts(T)) {
+    for (auto s : sizes) {
+      b->Args({t, s});
+    }
+  }
+  b->UseRealTime();
+}
+
+void registerMatmulBenchmarks(Type& T, const std::string& device) {
+  for (bool transposed : {false, true}) {
+    registerBenchmark(
+        T,
+        std::string("mm/") + device + "/" + at::toString(T.scalarType()) +
+            (transposed ? "/transposed" : "/contiguous"),
+        [&T, transposed](benchmark::State& state) { mm(state, T, transposed); },
+        {64, 256, 1024});
+  }
+}
+
+void registerBenchmarks(Type& T, const std::string& device) {
+  auto add = [&](const std::string& name,
+                 std::function<void(benchmark::State&)> fn,
+                 std::vector<int64_t> sizes) {
+    registerBenchmark(T, name + "/" + device, fn, sizes);
+  };
+
+  for (const auto& spec : matrixKernels()) {
+    for (auto layout : {Layout::Contiguous,
+                        Layout::Transposed,
+                        Layout::Strided,
+                        Layout::Broadcast}) {
+      auto kernel = spec.kernel;
+      auto bytes_per_element = spec.bytes_per_element;
+      add(spec.name + "/" + layoutName(layout),
+          [&T, kernel, bytes_per_element, layout](benchmark::State& state) {
+            runKernel(state, T, kernel, bytes_per_element, layout);
+          },
+          {1 << 10, 1 << 16, 1 << 22});
+    }
+  }
+  add("embedding_bag",
+      [&T](benchmark::State& state) { embeddingBag(state, T); },
+      {1 << 10, 1 << 16});
+  add("conv2d",
+      [&T](benchmark::State& state) { conv2d(state, T); },
+      {16, 64});
+  add("sparse_add",
+      [&T](benchmark::State& state) { sparseAdd(state, T); },
+      {1 << 10, 1 << 12});
+  add("sparse_to_dense",
+      [&T](benchmark::State& state) { sparseToDense(state, T); },
+      {1 << 10, 1 << 12});
+  add("sparse_dense_matmul",
+      [&T](benchmark::State& state) { sparseDenseMatmul(state, T); },
+      {1 << 10, 1 << 12});
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  registerBenchmarks(CPU(kFloat), "CPU");
+  for (auto scalar_type : {kFloat, kDouble, kInt, kLong}) {
+    registerMatmulBenchmarks(CPU(scalar_type), "CPU");
+  }
+  if (at::hasCUDA()) {
+    registerBenchmarks(CUDA(kFloat), "CUDA");
+  }
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,131 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "ATen/ATen.h"
+#include "test_seed.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace at;
+
+#define REQUIRE_ALLCLOSE(t1, t2, atol, rtol) \
+  REQUIRE(t1.is_same_size(t2));              \
+  REQUIRE(t1.allclose(t2, rtol, atol));
+
+// Inputs laid out in all the ways the reduction kernels distinguish:
+// contiguous, transposed, permuted, strided and broadcast, big enough to be
+// reduced in parallel and with few and many outputs.
+static std::vector<Tensor> inputs(Type& T) {
+  return {
+    randn(T, {5}),
+    randn(T, {37, 50}),
+    randn(T, {37, 50}).t(),
+    randn(T, {7, 50, 33}).permute({2, 0, 1}),
+    randn(T, {20, 30, 40}).slice(2, 1, 40, 3),
+    randn(T, {64, 1}).expand({64, 48}),
+    randn(T, {600, 500}),
+    randn(T, {500, 600}).t(),
+    randn(T, {3, 70000}),
+    randn(T, {70000, 3}),
+    randn(T, {40000, 64}),
+  };
+}
+
+void test(Type& T, double atol, double rtol) {
+  SECTION( "sum and mean match TH" ) {
+    for (auto& x : inputs(T)) {
+      REQUIRE_ALLCLOSE(x.sum(), x._sumall(), atol, rtol);
+      REQUIRE_ALLCLOSE(x.mean(), x._mean(), atol, rtol);
+      for (int64_t dim = 0; dim < x.dim(); dim++) {
+        for (bool keepdim : {false, true}) {
+          REQUIRE_ALLCLOSE(x.sum(dim, keepdim), x._sum(dim, keepdim), atol, rtol);
+          REQUIRE_ALLCLOSE(x.mean(dim, keepdim), x._mean(dim, keepdim), atol, rtol);
+        }
+      }
+    }
+  }
+
+  SECTION( "prod matches TH" ) {
+    for (auto& x : inputs(T)) {
+      auto y = (x.slice(0, 0, 8) * 0.01 + 1);
+      REQUIRE_ALLCLOSE(y.prod(), y._prodall(), atol, rtol);
+      for (int64_t dim = 0; dim < y.dim(); dim++) {
+        REQUIRE_ALLCLOSE(y.prod(dim), y._prod(dim), atol, rtol);
+      }
+    }
+  }
+
+  SECTION( "var and std match TH" ) {
+    for (auto& x : inputs(T)) {
+      for (bool unbiased : {false, true}) {
+        REQUIRE_ALLCLOSE(x.var(unbiased), x._var(unbiased), atol, rtol);
+        REQUIRE_ALLCLOSE(x.std(unbiased), x._std(unbiased), atol, rtol);
+        for (int64_t dim = 0; dim < x.dim(); dim++) {
+          REQUIRE_ALLCLOSE(x.var(dim, unbiased), x._var(dim, unbiased), atol, rtol);
+          REQUIRE_ALLCLOSE(x.std(dim, unbiased, true), x._std(dim, unbiased, true), atol, rtol);
+        }
+      }
+    }
+  }
+
+  SECTION( "norm matches TH" ) {
+    for (auto& x : inputs(T)) {
+      for (double p : {0.0, 1.0, 2.0, 3.0, 1.5}) {
+        REQUIRE_ALLCLOSE(x.norm(p), x._norm(p), atol, rtol);
+        for (int64_t dim = 0; dim < x.dim(); dim++) {
+          REQUIRE_ALLCLOSE(x.norm(p, dim), x._norm(p, dim), atol, rtol);
+        }
+      }
+      auto inf = std::numeric_limits<double>::infinity();
+      REQUIRE_ALLCLOSE(x.norm(inf), x.abs()._maxall(), atol, rtol);
+    }
+  }
+
+  SECTION( "max and min match TH" ) {
+    for (auto& x : inputs(T)) {
+      REQUIRE(x.max().equal(x._maxall()));
+      REQUIRE(x.min().equal(x._minall()));
+    }
+    auto x = randn(T, {1000});
+    x[517] = NAN;
+    REQUIRE(std::isnan(x.max().toCDouble()));
+    REQUIRE(std::isnan(x.min().toCDouble()));
+  }
+
+  SECTION( "out variants resize and fill non-contiguous results" ) {
+    auto x = randn(T, {30, 40, 50});
+    auto result = T.tensor({50, 30}).t();
+    at::mean_out(result, x, 2, false);
+    REQUIRE_ALLCLOSE(result, x._mean(2), atol, rtol);
+    at::sum_out(result, x.transpose(0, 2), 0, false);
+    REQUIRE_ALLCLOSE(result, x._sum(2).t(), atol, rtol);
+  }
+
+  SECTION( "scalars are reduced as one element" ) {
+    auto x = T.tensor({}).fill_(-2);
+    REQUIRE(x.mean(0).toCDouble() == -2);
+    REQUIRE(x.norm(2, 0).toCDouble() == 2);
+    REQUIRE(x.var(0, false).toCDouble() == 0);
+    REQUIRE(std::isnan(x.std(0, true).toCDouble()));
+  }
+}
+
+TEST_CASE( "reduce ops CPU", "[cpu]" ) {
+  manual_seed(123);
+
+  test(CPU(kFloat), 1e-3, 1e-4);
+  test(CPU(kDouble), 1e-8, 1e-8);
+}
+
+TEST_CASE( "reduce ops CPU integral", "[cpu]" ) {
+  manual_seed(123);
+
+  auto x = randn(CPU(kFloat), {300, 400}).mul(100).toType(kLong).t();
+  REQUIRE(x.sum().equal(x._sumall()));
+  REQUIRE(x.sum(0).equal(x._sum(0)));
+  REQUIRE(x.sum(1).equal(x._sum(1)));
+  REQUIRE(x.max().equal(x._maxall()));
+  REQUIRE(x.min().equal(x._minall()));
+}
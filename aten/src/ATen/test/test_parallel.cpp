@@ -3,10 +3,16 @@
 
 #include "ATen/ATen.h"
 #include "ATen/DLConvertor.h"
+#include "ATen/Parallel.h"
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <iostream>
+#include <stdexcept>
 #include <string.h>
 #include <sstream>
+#include <vector>
 #include "test_seed.h"
 
 using namespace at;
@@ -27,3 +33,75 @@ TEST_CASE( "parallel", "[cpu]" ) {
   REQUIRE(a.sum(0).equal(as));
 }
 
+
+static std::vector<ParallelBackend> backends() {
+  std::vector<ParallelBackend> result = {ParallelBackend::TBB, ParallelBackend::Native};
+#ifdef _OPENMP
+  result.push_back(ParallelBackend::OpenMP);
+#endif
+  return result;
+}
+
+static double parallel_sum(const Tensor& x) {
+  auto data = x.data<double>();
+  return parallel_reduce(
+      0, x.numel(), 1000, 0.0,
+      [&](int64_t begin, int64_t end, double acc) {
+        for (int64_t i = begin; i < end; i++) {
+          acc += data[i];
+        }
+        return acc;
+      },
+      std::plus<double>());
+}
+
+TEST_CASE( "parallel backends", "[cpu]" ) {
+  manual_seed(123);
+  auto x = randn(CPU(kDouble), {1000 * 1000});
+  auto expected_sum = x.sum();
+  set_num_threads(1);
+  double serial_sum = parallel_sum(x);
+
+  for (auto backend : backends()) {
+    set_parallel_backend(backend);
+    for (int num_threads : {1, 3, 8}) {
+      set_num_threads(num_threads);
+      INFO("backend " << static_cast<int>(backend) << " with " << num_threads << " threads");
+
+      // parallel_for visits every index once, in chunks of at least the grain
+      std::vector<std::atomic<int>> visits(100003);
+      std::atomic<bool> small_chunk(false);
+      parallel_for(0, visits.size(), 1000, [&](int64_t begin, int64_t end) {
+        if (end - begin < 1000) {
+          small_chunk = true;
+        }
+        for (int64_t i = begin; i < end; i++) {
+          visits[i]++;
+        }
+      });
+      REQUIRE(!small_chunk);
+      REQUIRE(std::all_of(visits.begin(), visits.end(), [](const std::atomic<int>& v) { return v == 1; }));
+
+      // parallel_reduce does not depend on the number of threads
+      REQUIRE(parallel_sum(x) == serial_sum);
+
+      // nested loops and kernels run
+      std::atomic<int64_t> count(0);
+      parallel_for(0, 64, 1, [&](int64_t begin, int64_t end) {
+        parallel_for(0, 1000, 10, [&](int64_t b, int64_t e) { count += (end - begin) * (e - b); });
+      });
+      REQUIRE(count == 64 * 1000);
+      REQUIRE(x.sum().allclose(expected_sum));
+
+      // exceptions are rethrown in the caller
+      REQUIRE_THROWS_AS(
+          parallel_for(0, 1000, 1, [](int64_t begin, int64_t end) {
+            if (begin <= 500 && 500 < end) {
+              throw std::runtime_error("chunk failed");
+            }
+          }),
+          std::runtime_error);
+    }
+  }
+  set_parallel_backend(ParallelBackend::TBB);
+}
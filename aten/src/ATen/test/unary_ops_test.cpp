@@ -0,0 +1,139 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "ATen/ATen.h"
+#include "test_seed.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <vector>
+
+using namespace at;
+
+// Distance between a and b in units in the last place, with inf for values
+// that are not both NaN or both the same infinity.
+template <typename scalar_t>
+static double ulps(scalar_t a, scalar_t b) {
+  if (std::isnan(a) || std::isnan(b)) {
+    return std::isnan(a) && std::isnan(b) ? 0 : INFINITY;
+  }
+  if (std::isinf(a) || std::isinf(b)) {
+    return a == b ? 0 : INFINITY;
+  }
+  // Maps the floats onto integers that are ordered like them.
+  auto ordered = [](scalar_t x) -> int64_t {
+    typename std::conditional<sizeof(scalar_t) == 4, int32_t, int64_t>::type bits;
+    std::memcpy(&bits, &x, sizeof(x));
+    return bits < 0 ? std::numeric_limits<decltype(bits)>::min() - bits : bits;
+  };
+  return std::abs(static_cast<double>(ordered(a) - ordered(b)));
+}
+
+// Inputs for an op with the given domain: a dense sweep, values close to 0,
+// special values and enough elements to be computed in parallel, with a
+// length that leaves a partial vector at the end.
+template <typename scalar_t>
+static Tensor inputs(Type& T, double lo, double hi) {
+  std::vector<scalar_t> values = {0, -0.0, INFINITY, -INFINITY, NAN,
+                                  std::numeric_limits<scalar_t>::min(),
+                                  std::numeric_limits<scalar_t>::denorm_min()};
+  for (double x = 1e-30; x < 1; x *= 3.3) {
+    values.push_back(x);
+    values.push_back(-x);
+  }
+  int64_t n = 100003;
+  for (int64_t i = 0; i < n; i++) {
+    values.push_back(lo + (hi - lo) * i / (n - 1));
+  }
+  auto t = T.tensor({static_cast<int64_t>(values.size())});
+  std::memcpy(t.template data<scalar_t>(), values.data(), values.size() * sizeof(scalar_t));
+  return t;
+}
+
+template <typename scalar_t>
+static void check(Type& T, const char* name, std::function<Tensor(const Tensor&)> op,
+                  std::function<scalar_t(scalar_t)> reference, double max_ulps,
+                  double lo, double hi) {
+  INFO(name);
+  auto x = inputs<scalar_t>(T, lo, hi);
+  auto result = op(x);
+  REQUIRE(result.is_same_size(x));
+  auto x_data = x.template data<scalar_t>();
+  auto result_data = result.template data<scalar_t>();
+  double worst = 0;
+  for (int64_t i = 0; i < x.numel(); i++) {
+    double d = ulps(result_data[i], reference(x_data[i]));
+    if (d > worst) {
+      worst = d;
+      INFO("at " << x_data[i] << ": " << result_data[i] << " vs " << reference(x_data[i]));
+      CHECK(d <= max_ulps);
+    }
+  }
+}
+
+#define CHECK_OP(op, max_ulps, lo, hi)                                 \
+  check<scalar_t>(T, #op, [](const Tensor& t) { return t.op(); },     \
+                  [](scalar_t x) -> scalar_t { return std::op(x); },  \
+                  max_ulps, lo, hi)
+
+// The CPU kernels use the vectorized functions in cpu/vec256, which are
+// accurate to these many ulps of libm over the whole domain.
+template <typename scalar_t>
+static void test(Type& T) {
+  CHECK_OP(exp, 2, -110, 110);
+  CHECK_OP(log, 1, 0, 1e6);
+  CHECK_OP(expm1, 3, -110, 110);
+  CHECK_OP(log1p, 2, -1, 1e6);
+  CHECK_OP(sin, 2, -1e4, 1e4);
+  CHECK_OP(cos, 2, -1e4, 1e4);
+  CHECK_OP(tan, 4, -1e4, 1e4);
+  CHECK_OP(asin, 2, -1, 1);
+  CHECK_OP(acos, 2, -1, 1);
+  CHECK_OP(atan, 3, -1e4, 1e4);
+  CHECK_OP(sinh, 4, -100, 100);
+  CHECK_OP(cosh, 4, -100, 100);
+  CHECK_OP(tanh, 4, -20, 20);
+  CHECK_OP(erf, 3, -6, 6);
+  CHECK_OP(sqrt, 0, 0, 1e6);
+  check<scalar_t>(T, "sigmoid", [](const Tensor& t) { return t.sigmoid(); },
+                  [](scalar_t x) -> scalar_t {
+                    scalar_t e = std::exp(-std::abs(x));
+                    return (x < 0 ? e : 1) / (1 + e);
+                  },
+                  3, -110, 110);
+  check<scalar_t>(T, "rsqrt", [](const Tensor& t) { return t.rsqrt(); },
+                  [](scalar_t x) -> scalar_t { return 1 / std::sqrt(x); },
+                  0, 0, 1e6);
+  check<scalar_t>(T, "frac", [](const Tensor& t) { return t.frac(); },
+                  [](scalar_t x) -> scalar_t { return x - std::trunc(x); },
+                  0, -1e4, 1e4);
+}
+
+TEST_CASE( "unary ops CPU", "[cpu]" ) {
+  manual_seed(123);
+
+  SECTION( "float results are within the documented ulps of libm" ) {
+    test<float>(CPU(kFloat));
+  }
+
+  SECTION( "double results are within the documented ulps of libm" ) {
+    test<double>(CPU(kDouble));
+  }
+
+  SECTION( "non-contiguous and in-place ops match the contiguous results" ) {
+    auto x = CPU(kFloat).randn({300, 200});
+    auto t = x.t();
+    REQUIRE(t.tanh().allclose(t.contiguous().tanh()));
+    REQUIRE(t.sigmoid().allclose(t.contiguous().sigmoid()));
+    REQUIRE(t.expm1().allclose(t.contiguous().expm1()));
+    auto y = x.abs();
+    y.log1p_();
+    REQUIRE(y.equal(x.abs().log1p()));
+    auto z = x.clone();
+    at::erf_out(z, x);
+    REQUIRE(z.equal(x.erf()));
+  }
+}
@@ -80,6 +80,14 @@ THMapAllocatorContext *THMapAllocatorContext_new(const char *filename, int flags
   if ((flags ^ TH_ALLOCATOR_MAPPED_EXCLUSIVE) == 0)
     THError("TH_ALLOCATOR_MAPPED_EXCLUSIVE flag requires opening the file "
         "in shared mode");
+  if ((flags & TH_ALLOCATOR_MAPPED_READONLY) &&
+      (flags & (TH_ALLOCATOR_MAPPED_SHARED | TH_ALLOCATOR_MAPPED_SHAREDMEM)))
+    THError("TH_ALLOCATOR_MAPPED_READONLY flag can't be combined with "
+        "TH_ALLOCATOR_MAPPED_SHARED or TH_ALLOCATOR_MAPPED_SHAREDMEM");
+#ifdef _WIN32
+  if (flags & TH_ALLOCATOR_MAPPED_READONLY)
+    THError("TH_ALLOCATOR_MAPPED_READONLY not supported on Windows");
+#endif
 
   if (filename) {
     ctx->filename = THAlloc(strlen(filename)+1);
@@ -364,7 +372,7 @@ static void *_map_alloc(void* ctx_, ptrdiff_t size)
     {
       if(size > file_stat.st_size)
       {
-        if(ctx->flags)
+        if(ctx->flags && !(ctx->flags & TH_ALLOCATOR_MAPPED_READONLY))
         {
           if(ftruncate(fd, size) == -1)
             THError("unable to resize file <%s> to the right size", ctx->filename);
@@ -399,6 +407,8 @@ static void *_map_alloc(void* ctx_, ptrdiff_t size)
     /* map it */
     if (ctx->flags & (TH_ALLOCATOR_MAPPED_SHARED | TH_ALLOCATOR_MAPPED_SHAREDMEM))
       data = mmap(NULL, ctx->size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    else if (ctx->flags & TH_ALLOCATOR_MAPPED_READONLY)
+      data = mmap(NULL, ctx->size, PROT_READ, MAP_SHARED, fd, 0);
     else
       data = mmap(NULL, ctx->size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
 
@@ -594,6 +604,12 @@ int THRefcountedMapAllocator_decref(THMapAllocatorContext *ctx, void *data)
   return THAtomicDecrementRef(&map_info->refcount);
 }
 
+int THRefcountedMapAllocator_refcount(THMapAllocatorContext *ctx, void *data)
+{
+  THMapInfo *map_info = (THMapInfo*)(((char*)data) - TH_ALLOC_ALIGNMENT);
+  return THAtomicGet(&map_info->refcount);
+}
+
 #else
 
 static void * THRefcountedMapAllocator_alloc(void *ctx, ptrdiff_t size) {
@@ -621,6 +637,12 @@ int THRefcountedMapAllocator_decref(THMapAllocatorContext *ctx, void *data)
   return 0;
 }
 
+int THRefcountedMapAllocator_refcount(THMapAllocatorContext *ctx, void *data)
+{
+  THError("refcounted file mapping not supported on your system");
+  return 0;
+}
+
 #endif
 
 THAllocator THMapAllocator = {
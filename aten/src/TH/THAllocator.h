@@ -10,6 +10,9 @@
 #define TH_ALLOCATOR_MAPPED_KEEPFD 16
 #define TH_ALLOCATOR_MAPPED_FROMFD 32
 #define TH_ALLOCATOR_MAPPED_UNLINK 64
+/* map an existing file read-only and shared with the other processes mapping
+ * it, so that they all use the same pages; writes to the storage fault */
+#define TH_ALLOCATOR_MAPPED_READONLY 128
 
 /* Custom allocator
  */
@@ -36,6 +39,7 @@ TH_API ptrdiff_t THMapAllocatorContext_size(THMapAllocatorContext *ctx);
 TH_API void THMapAllocatorContext_free(THMapAllocatorContext *ctx);
 TH_API void THRefcountedMapAllocator_incref(THMapAllocatorContext *ctx, void *data);
 TH_API int THRefcountedMapAllocator_decref(THMapAllocatorContext *ctx, void *data);
+TH_API int THRefcountedMapAllocator_refcount(THMapAllocatorContext *ctx, void *data);
 
 TH_API THAllocator THMapAllocator;
 TH_API THAllocator THRefcountedMapAllocator;
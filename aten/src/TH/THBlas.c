@@ -1,4 +1,14 @@
 #include "THBlas.h"
 
+/* Block sizes of the fallback GEMM, in elements: an MC x KC block of A and
+   KC x NR panels of B stay in the L2 and L1 caches, and an MR x NR tile of
+   C in registers. */
+#define THBLAS_GEMM_MR 8
+#define THBLAS_GEMM_NR 4
+#define THBLAS_GEMM_MC 128
+#define THBLAS_GEMM_KC 256
+#define THBLAS_GEMM_NC 1024
+#define TH_OMP_OVERHEAD_THRESHOLD_GEMM 100000
+
 #include "generic/THBlas.c"
 #include "THGenerateAllTypes.h"
@@ -241,6 +241,56 @@ static float uniform_float(THGenerator *_generator)
   return (x & FLOAT_MASK) * FLOAT_DIVISOR;
 }
 
+/* Philox4x32-10, the 32 bits halves of the counter being
+   (block low, block high, 0, 0) */
+void THRandom_philox(uint64_t key, uint64_t block, uint32_t *out)
+{
+  uint32_t c0 = (uint32_t)block, c1 = (uint32_t)(block >> 32), c2 = 0, c3 = 0;
+  uint32_t k0 = (uint32_t)key, k1 = (uint32_t)(key >> 32);
+  int round;
+  for (round = 0; round < 10; ++round) {
+    const uint64_t p0 = (uint64_t)0xD2511F53 * c0;
+    const uint64_t p1 = (uint64_t)0xCD9E8D57 * c2;
+    c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+    c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+    c1 = (uint32_t)p1;
+    c3 = (uint32_t)p0;
+    k0 += 0x9E3779B9;
+    k1 += 0xBB67AE85;
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+void THRandom_philoxUniformFloat(float *data, int64_t size, uint64_t key, uint64_t offset)
+{
+  int64_t i = 0;
+  uint32_t words[4];
+  while (i < size) {
+    const uint64_t position = offset + i;
+    THRandom_philox(key, position / 4, words);
+    for (int w = position % 4; w < 4 && i < size; ++w, ++i) {
+      data[i] = (words[w] & FLOAT_MASK) * FLOAT_DIVISOR;
+    }
+  }
+}
+
+void THRandom_philoxUniformDouble(double *data, int64_t size, uint64_t key, uint64_t offset)
+{
+  int64_t i = 0;
+  uint32_t words[4];
+  while (i < size) {
+    const uint64_t position = offset + i;
+    THRandom_philox(key, position / 2, words);
+    for (int w = position % 2; w < 2 && i < size; ++w, ++i) {
+      const uint64_t x = ((uint64_t)words[2 * w] << 32) | words[2 * w + 1];
+      data[i] = (x & DOUBLE_MASK) * DOUBLE_DIVISOR;
+    }
+  }
+}
+
 /*********************************************************
 
  Thanks *a lot* Takuji Nishimura and Makoto Matsumoto!
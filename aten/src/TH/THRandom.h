@@ -88,6 +88,24 @@ TH_API int THRandom_geometric(THGenerator *_generator, double p);
 
 /* Returns true with probability $p$ and false with probability $1-p$ (p > 0). */
 TH_API int THRandom_bernoulli(THGenerator *_generator, double p);
+
+/* Philox4x32-10 counter-based generator (Salmon et al., "Parallel Random
+   Numbers: As Easy as 1, 2, 3", SC 2011). The numbers of a stream are a
+   function of its 64 bits key and of their position in the stream, so that
+   any part of a fill can be generated independently of the others, on any
+   thread, with the same result. The key of a fill is drawn from a THGenerator.
+*/
+
+/* Writes the 4 uniform 32 bits integers of the given block of the stream. */
+TH_API void THRandom_philox(uint64_t key, uint64_t block, uint32_t *out);
+
+/* Writes the uniform floats on [0,1) at positions [offset, offset + size) of
+   the stream, 4 per block. */
+TH_API void THRandom_philoxUniformFloat(float *data, int64_t size, uint64_t key, uint64_t offset);
+
+/* Writes the uniform doubles on [0,1) at positions [offset, offset + size) of
+   the stream, 2 per block. */
+TH_API void THRandom_philoxUniformDouble(double *data, int64_t size, uint64_t key, uint64_t offset);
 #ifdef __cplusplus
 }
 #endif
@@ -3,6 +3,7 @@
 
 #include "THGeneral.h"
 #include "THMath.h"
+#include "THHalf.h"
 
 #define THVector_(NAME) TH_CONCAT_4(TH,Real,Vector_,NAME)
 
@@ -292,6 +292,155 @@ void THBlas_(ger)(int64_t m, int64_t n, real alpha, real *x, int64_t incx, real
   }
 }
 
+/* Fallback GEMM, for types without a BLAS routine and builds without BLAS.
+   Like BLAS implementations, it copies blocks of op(A) and op(B) that fit in
+   cache into contiguous panels, so that the innermost kernel reads both
+   sequentially, whatever the transposition of the inputs, and computes
+   an MR x NR tile of C with accumulators the compiler keeps in (vector)
+   registers. C is updated one MC x NC block at a time, over KC long slices
+   of the inner dimension; the tiles of a block are computed in parallel. */
+
+/* Copies the mc x kc block of op(A) starting at (i0, l0) into panels of MR
+   rows, the rows of each column contiguous, padding the last panel with zeros. */
+static void THBlas_(gemmPackA)(int transa, int64_t mc, int64_t kc, real *a, int64_t lda,
+                               int64_t i0, int64_t l0, real *packed)
+{
+  int64_t ip;
+  int64_t num_panels = (mc + THBLAS_GEMM_MR - 1) / THBLAS_GEMM_MR;
+#pragma omp parallel for if(mc * kc > TH_OMP_OVERHEAD_THRESHOLD_GEMM) private(ip)
+  for(ip = 0; ip < num_panels; ip++)
+  {
+    real *panel = packed + ip * THBLAS_GEMM_MR * kc;
+    int64_t mr = THMin(THBLAS_GEMM_MR, mc - ip * THBLAS_GEMM_MR);
+    int64_t l, ii;
+    for(l = 0; l < kc; l++)
+    {
+      for(ii = 0; ii < mr; ii++)
+      {
+        int64_t i = i0 + ip * THBLAS_GEMM_MR + ii;
+        panel[l * THBLAS_GEMM_MR + ii] = transa ? a[i * lda + l0 + l] : a[(l0 + l) * lda + i];
+      }
+      for(; ii < THBLAS_GEMM_MR; ii++)
+        panel[l * THBLAS_GEMM_MR + ii] = 0;
+    }
+  }
+}
+
+/* Copies the kc x nc block of op(B) starting at (l0, j0) into panels of NR
+   columns, the columns of each row contiguous. */
+static void THBlas_(gemmPackB)(int transb, int64_t kc, int64_t nc, real *b, int64_t ldb,
+                               int64_t l0, int64_t j0, real *packed)
+{
+  int64_t jp;
+  int64_t num_panels = (nc + THBLAS_GEMM_NR - 1) / THBLAS_GEMM_NR;
+#pragma omp parallel for if(kc * nc > TH_OMP_OVERHEAD_THRESHOLD_GEMM) private(jp)
+  for(jp = 0; jp < num_panels; jp++)
+  {
+    real *panel = packed + jp * THBLAS_GEMM_NR * kc;
+    int64_t nr = THMin(THBLAS_GEMM_NR, nc - jp * THBLAS_GEMM_NR);
+    int64_t l, jj;
+    for(l = 0; l < kc; l++)
+    {
+      for(jj = 0; jj < nr; jj++)
+      {
+        int64_t j = j0 + jp * THBLAS_GEMM_NR + jj;
+        panel[l * THBLAS_GEMM_NR + jj] = transb ? b[(l0 + l) * ldb + j] : b[j * ldb + l0 + l];
+      }
+      for(; jj < THBLAS_GEMM_NR; jj++)
+        panel[l * THBLAS_GEMM_NR + jj] = 0;
+    }
+  }
+}
+
+/* C[0:mr, 0:nr] += alpha * (A panel) * (B panel) */
+static void THBlas_(gemmKernel)(int64_t kc, const real *a_panel, const real *b_panel,
+                                real alpha, real *c, int64_t ldc, int64_t mr, int64_t nr)
+{
+  real acc[THBLAS_GEMM_NR][THBLAS_GEMM_MR];
+  int64_t l, ii, jj;
+  for(jj = 0; jj < THBLAS_GEMM_NR; jj++)
+    for(ii = 0; ii < THBLAS_GEMM_MR; ii++)
+      acc[jj][ii] = 0;
+  for(l = 0; l < kc; l++)
+  {
+    const real *a_ = a_panel + l * THBLAS_GEMM_MR;
+    const real *b_ = b_panel + l * THBLAS_GEMM_NR;
+    for(jj = 0; jj < THBLAS_GEMM_NR; jj++)
+    {
+      real b_val = b_[jj];
+      for(ii = 0; ii < THBLAS_GEMM_MR; ii++)
+        acc[jj][ii] += a_[ii] * b_val;
+    }
+  }
+  for(jj = 0; jj < nr; jj++)
+    for(ii = 0; ii < mr; ii++)
+      c[jj * ldc + ii] += alpha * acc[jj][ii];
+}
+
+static void THBlas_(gemmBlocked)(int transa, int transb, int64_t m, int64_t n, int64_t k,
+                                 real alpha, real *a, int64_t lda, real *b, int64_t ldb,
+                                 real beta, real *c, int64_t ldc)
+{
+  int64_t i, j;
+  int64_t kc_max = THMin(k, THBLAS_GEMM_KC);
+  int64_t mc_max = THMin(m, THBLAS_GEMM_MC);
+  int64_t nc_max = THMin(n, THBLAS_GEMM_NC);
+  real *a_packed, *b_packed;
+  int64_t ic, jc, pc;
+
+  /* c = beta * c; c is not read when beta is 0, like in BLAS */
+  for(j = 0; j < n; j++)
+  {
+    real *c_ = c + j * ldc;
+    if(beta == 0)
+      for(i = 0; i < m; i++)
+        c_[i] = 0;
+    else if(beta != 1)
+      for(i = 0; i < m; i++)
+        c_[i] *= beta;
+  }
+  if(m == 0 || n == 0 || k == 0 || alpha == 0)
+    return;
+
+  a_packed = (real*)THAlloc(sizeof(real) * kc_max *
+                            ((mc_max + THBLAS_GEMM_MR - 1) / THBLAS_GEMM_MR) * THBLAS_GEMM_MR);
+  b_packed = (real*)THAlloc(sizeof(real) * kc_max *
+                            ((nc_max + THBLAS_GEMM_NR - 1) / THBLAS_GEMM_NR) * THBLAS_GEMM_NR);
+  for(jc = 0; jc < n; jc += THBLAS_GEMM_NC)
+  {
+    int64_t nc = THMin(THBLAS_GEMM_NC, n - jc);
+    int64_t num_col_panels = (nc + THBLAS_GEMM_NR - 1) / THBLAS_GEMM_NR;
+    for(pc = 0; pc < k; pc += THBLAS_GEMM_KC)
+    {
+      int64_t kc = THMin(THBLAS_GEMM_KC, k - pc);
+      THBlas_(gemmPackB)(transb, kc, nc, b, ldb, pc, jc, b_packed);
+      for(ic = 0; ic < m; ic += THBLAS_GEMM_MC)
+      {
+        int64_t mc = THMin(THBLAS_GEMM_MC, m - ic);
+        int64_t num_row_panels = (mc + THBLAS_GEMM_MR - 1) / THBLAS_GEMM_MR;
+        int64_t tile;
+        THBlas_(gemmPackA)(transa, mc, kc, a, lda, ic, pc, a_packed);
+#pragma omp parallel for if(mc * nc * kc > TH_OMP_OVERHEAD_THRESHOLD_GEMM) private(tile)
+        for(tile = 0; tile < num_row_panels * num_col_panels; tile++)
+        {
+          int64_t ip = tile % num_row_panels;
+          int64_t jp = tile / num_row_panels;
+          int64_t mr = THMin(THBLAS_GEMM_MR, mc - ip * THBLAS_GEMM_MR);
+          int64_t nr = THMin(THBLAS_GEMM_NR, nc - jp * THBLAS_GEMM_NR);
+          THBlas_(gemmKernel)(kc,
+                              a_packed + ip * THBLAS_GEMM_MR * kc,
+                              b_packed + jp * THBLAS_GEMM_NR * kc,
+                              alpha,
+                              c + (jc + jp * THBLAS_GEMM_NR) * ldc + ic + ip * THBLAS_GEMM_MR,
+                              ldc, mr, nr);
+        }
+      }
+    }
+  }
+  THFree(a_packed);
+  THFree(b_packed);
+}
+
 void THBlas_(gemm)(char transa, char transb, int64_t m, int64_t n, int64_t k, real alpha, real *a, int64_t lda, real *b, int64_t ldb, real beta, real *c, int64_t ldc)
 {
   int transa_ = ((transa == 't') || (transa == 'T'));
@@ -347,89 +496,7 @@ void THBlas_(gemm)(char transa, char transb, int64_t m, int64_t n, int64_t k, re
     return;
   }
 #endif
-  {
-    int64_t i, j, l;
-    if(!transa_ && !transb_)
-    {
-      real *a_ = a;
-      for(i = 0; i < m; i++)
-      {
-        real *b_ = b;
-        for(j = 0; j < n; j++)
-        {
-          real sum = 0;
-          for(l = 0; l < k; l++)
-            sum += a_[l*lda]*b_[l];
-          b_ += ldb;
-	  if (beta == 0)
-	    c[j*ldc+i] = alpha*sum;
-	  else
-	    c[j*ldc+i] = beta*c[j*ldc+i]+alpha*sum;
-        }
-        a_++;
-      }
-    }
-    else if(transa_ && !transb_)
-    {
-      real *a_ = a;
-      for(i = 0; i < m; i++)
-      {
-        real *b_ = b;
-        for(j = 0; j < n; j++)
-        {
-          real sum = 0;
-          for(l = 0; l < k; l++)
-            sum += a_[l]*b_[l];
-          b_ += ldb;
-	  if (beta == 0)
-	    c[j*ldc+i] = alpha*sum;
-	  else
-	    c[j*ldc+i] = beta*c[j*ldc+i]+alpha*sum;
-        }
-        a_ += lda;
-      }
-    }
-    else if(!transa_ && transb_)
-    {
-      real *a_ = a;
-      for(i = 0; i < m; i++)
-      {
-        real *b_ = b;
-        for(j = 0; j < n; j++)
-        {
-          real sum = 0;
-          for(l = 0; l < k; l++)
-            sum += a_[l*lda]*b_[l*ldb];
-          b_++;
-	  if (beta == 0)
-	    c[j*ldc+i] = alpha*sum;
-	  else
-	    c[j*ldc+i] = beta*c[j*ldc+i]+alpha*sum;
-        }
-        a_++;
-      }
-    }
-    else
-    {
-      real *a_ = a;
-      for(i = 0; i < m; i++)
-      {
-        real *b_ = b;
-        for(j = 0; j < n; j++)
-        {
-          real sum = 0;
-          for(l = 0; l < k; l++)
-            sum += a_[l]*b_[l*ldb];
-          b_++;
-	  if (beta == 0)
-	    c[j*ldc+i] = alpha*sum;
-	  else
-	    c[j*ldc+i] = beta*c[j*ldc+i]+alpha*sum;
-        }
-        a_ += lda;
-      }
-    }
-  }
+  THBlas_(gemmBlocked)(transa_, transb_, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
 }
 
 #endif
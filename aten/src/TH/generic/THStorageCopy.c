@@ -50,6 +50,22 @@ void THStorage_(copy##TYPENAMESRC)(THStorage *storage, TH##TYPENAMESRC##Storage
     storage->data[i] = src->data[i];		\
 }
 
+#if defined(TH_REAL_IS_FLOAT)
+void THStorage_(copyHalf)(THStorage *storage, THHalfStorage *src)
+{
+  THArgCheck(storage->size == src->size, 2, "size mismatch");
+  THFloatVector_fromHalf(storage->data, src->data, storage->size);
+}
+#endif
+
+#if defined(TH_REAL_IS_HALF)
+void THStorage_(copyFloat)(THStorage *storage, THFloatStorage *src)
+{
+  THArgCheck(storage->size == src->size, 2, "size mismatch");
+  THFloatVector_toHalf(storage->data, src->data, storage->size);
+}
+#endif
+
 #ifndef TH_REAL_IS_HALF
 IMPLEMENT_THStorage_COPY(Byte)
 IMPLEMENT_THStorage_COPY(Char)
@@ -58,7 +74,9 @@ IMPLEMENT_THStorage_COPY(Int)
 IMPLEMENT_THStorage_COPY(Long)
 IMPLEMENT_THStorage_COPY(Float)
 IMPLEMENT_THStorage_COPY(Double)
+#ifndef TH_REAL_IS_FLOAT
 IMPLEMENT_THStorage_COPY_FROM_HALF(Half)
+#endif
 #else
 /* only allow pass-through for Half */
 IMPLEMENT_THStorage_COPY_TO_FROM_HALF(Half)
@@ -67,7 +85,6 @@ IMPLEMENT_THStorage_COPY_TO_HALF(Char)
 IMPLEMENT_THStorage_COPY_TO_HALF(Short)
 IMPLEMENT_THStorage_COPY_TO_HALF(Int)
 IMPLEMENT_THStorage_COPY_TO_HALF(Long)
-IMPLEMENT_THStorage_COPY_TO_HALF(Float)
 IMPLEMENT_THStorage_COPY_TO_HALF(Double)
 #endif
 
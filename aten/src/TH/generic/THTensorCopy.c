@@ -13,20 +13,42 @@
 #include <omp.h>
 #endif
 
-int THTensor_(copyTransposeValid)(THTensor *tensor, THTensor *src) {
+// Returns the dimension along which src is contiguous if tensor is contiguous
+// and src is laid out as a permutation of it with a different innermost
+// dimension, such as the transpose of a matrix or most results of permute().
+// Returns -1 if the copy doesn't have that form or is too small to benefit
+// from copyTranspose.
+int THTensor_(copyTransposeDim)(THTensor *tensor, THTensor *src) {
   const int MIN_SZ = 60 * 60;
-  return THTensor_(isContiguous)(tensor) &&
-         THTensor_(nDimension)(src) == 2 &&
-         THTensor_(stride)(src, 0) == 1 &&
-         THTensor_(stride)(src, 1) == THTensor_(size)(src, 0) &&
-         THTensor_(nElement)(tensor) >= MIN_SZ;
+  int ndim = THTensor_(nDimension)(src);
+  if (!THTensor_(isContiguous)(tensor) ||
+      THTensor_(nDimension)(tensor) != ndim ||
+      THTensor_(nElement)(tensor) < MIN_SZ) {
+    return -1;
+  }
+  int inner = -1;
+  int dim = -1;
+  for (int d = 0; d < ndim; d++) {
+    if (THTensor_(size)(tensor, d) != THTensor_(size)(src, d)) {
+      return -1;
+    }
+    if (THTensor_(size)(src, d) > 1) {
+      inner = d;
+      if (THTensor_(stride)(src, d) == 1) {
+        dim = d;
+      }
+    }
+  }
+  return dim == inner ? -1 : dim;
 }
 
-// special case copy where tensor is contiguous and src is a transposed matrix
-// This can be generalized to most copies, but it's tricker
-void THTensor_(copyTranspose)(THTensor *tensor, THTensor *src) {
+// Copies src into the contiguous tensor, where src is contiguous along `dim`
+// (see copyTransposeDim). The innermost dimension and `dim` are copied in
+// square blocks through a buffer that stays in cache, so that both the reads
+// from src and the writes to tensor are contiguous runs of memory. Every
+// other dimension is iterated over, and the blocks are copied in parallel.
+void THTensor_(copyTranspose)(THTensor *tensor, THTensor *src, int dim) {
   #define MIN(x, y) (((x) < (y)) ? (x) : (y))
-  #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 
 #ifdef TH_REAL_IS_BYTE
   const int BLOCK_SZ = 120;
@@ -34,48 +56,64 @@ void THTensor_(copyTranspose)(THTensor *tensor, THTensor *src) {
   const int BLOCK_SZ = 60;
 #endif
 
-  THTensor *buf = THTensor_(newWithSize2d)(BLOCK_SZ, BLOCK_SZ);
+  int ndim = THTensor_(nDimension)(src);
+  int inner = ndim - 1;
+  while (THTensor_(size)(src, inner) == 1) {
+    inner--;
+  }
   real *sp = THTensor_(data)(src);
   real *rp = THTensor_(data)(tensor);
-  real *bp = THTensor_(data)(buf);
-
+  // Sizes and strides of the block dimensions: the rows are along `dim`, the
+  // columns along the innermost dimension of tensor.
+  int64_t NR = THTensor_(size)(src, dim);
+  int64_t NC = THTensor_(size)(src, inner);
+  int64_t src_col_stride = THTensor_(stride)(src, inner);
+  int64_t dst_row_stride = THTensor_(stride)(tensor, dim);
+  int64_t row_blocks = (NR + BLOCK_SZ - 1) / BLOCK_SZ;
+  int64_t outer = THTensor_(nElement)(src) / (NR * NC);
+  int64_t tasks = outer * row_blocks;
 
-  int64_t NR = THTensor_(size)(src, 0);
-  int64_t NC = THTensor_(size)(src, 1);
-  for (int64_t R = 0; R < NR; R += BLOCK_SZ) {
+  int64_t t;
+#ifdef _OPENMP
+  int inOMP = omp_in_parallel();
+  #pragma omp parallel for private(t) if ((THTensor_(nElement)(src) > TH_OMP_OVERHEAD_THRESHOLD_COPY) && (!inOMP))
+#endif
+  for (t = 0; t < tasks; t++) {
+    real bp[BLOCK_SZ * BLOCK_SZ];
+    int64_t R = (t % row_blocks) * BLOCK_SZ;
+    // Offsets of the block at row R in the outer position t / row_blocks.
+    int64_t o = t / row_blocks;
+    real *spo = sp + R;
+    real *rpo = rp + R * dst_row_stride;
+    for (int d = ndim - 1; d >= 0; d--) {
+      if (d == dim || d == inner) {
+        continue;
+      }
+      int64_t size = THTensor_(size)(src, d);
+      int64_t i = o % size;
+      o /= size;
+      spo += i * THTensor_(stride)(src, d);
+      rpo += i * THTensor_(stride)(tensor, d);
+    }
+    int nr = MIN(NR - R, BLOCK_SZ);
     for (int64_t C = 0; C < NC; C += BLOCK_SZ) {
-      real *spo = sp + R + C * NR;
-      real *rpo = rp + C + R * NC;
-
-      int nr = MIN(NR - R, BLOCK_SZ);
       int nc = MIN(NC - C, BLOCK_SZ);
 
       // 1. copy columns from src to buf
       for (int c = 0; c < nc; c++) {
-        memcpy(bp + c * BLOCK_SZ, spo + c * NR, nr * sizeof(real));
+        memcpy(bp + c * BLOCK_SZ, spo + (C + c) * src_col_stride, nr * sizeof(real));
       }
 
-      // 2. transpose buf in place
-      int rc_max = MAX(nr, nc);
-      int rc_min = MIN(nr, nc);
-      for (int r = 0; r < rc_max; r++) {
-        int end = MIN(r, rc_min);
-        for (int c = 0; c < end; c++) {
-          real tmp = bp[r + BLOCK_SZ * c];
-          bp[r + BLOCK_SZ * c] = bp[r * BLOCK_SZ + c];
-          bp[r * BLOCK_SZ + c] = tmp;
-        }
-      }
-
-      // 3. copy rows from buf to dst
+      // 2. copy rows from buf to dst
       for (int r = 0; r < nr; r++) {
-        memcpy(rpo + r * NC, bp + r * BLOCK_SZ, nc * sizeof(real));
+        real *row = rpo + r * dst_row_stride + C;
+        for (int c = 0; c < nc; c++) {
+          row[c] = bp[c * BLOCK_SZ + r];
+        }
       }
     }
   }
-  THTensor_(free)(buf);
   #undef MIN
-  #undef MAX
 }
 
 void THTensor_(copy)(THTensor *tensor, THTensor *src)
@@ -87,6 +125,7 @@ void THTensor_(copy)(THTensor *tensor, THTensor *src)
   int srcContig = THTensor_(isContiguous)(src);
 
   int serial_path = 0;
+  int transposeDim;
 #ifdef _OPENMP
   int inOMP = omp_in_parallel();
 #endif
@@ -130,8 +169,8 @@ void THTensor_(copy)(THTensor *tensor, THTensor *src)
 #endif
 
 #ifndef TH_REAL_IS_HALF
-    } else if (THTensor_(copyTransposeValid)(tensor, src)) {
-      THTensor_(copyTranspose)(tensor, src);
+    } else if ((transposeDim = THTensor_(copyTransposeDim)(tensor, src)) >= 0) {
+      THTensor_(copyTranspose)(tensor, src, transposeDim);
 #endif
     } else {
 #ifdef _OPENMP
@@ -177,6 +216,57 @@ void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src
  TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = *src_data;) \
 }
 
+// Converts contiguous tensors in bulk with THFloatVector_fromHalf and
+// THFloatVector_toHalf, e.g. when loading half precision checkpoints.
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_HALF)
+#ifdef _OPENMP
+#define TH_HALF_CONVERT_PARALLEL(FUNC, DST, SRC, SIZE) \
+{ \
+  int inOMP = omp_in_parallel(); \
+  PRAGMA(omp parallel if ((SIZE > TH_OMP_OVERHEAD_THRESHOLD_COPY) && (!inOMP))) \
+  { \
+    ptrdiff_t num_threads = omp_get_num_threads(); \
+    ptrdiff_t tid = omp_get_thread_num(); \
+    ptrdiff_t offset = tid * (SIZE / num_threads); \
+    ptrdiff_t end = (tid == num_threads - 1) ? SIZE : offset + SIZE / num_threads; \
+    FUNC(DST + offset, SRC + offset, end - offset); \
+  } \
+}
+#else
+#define TH_HALF_CONVERT_PARALLEL(FUNC, DST, SRC, SIZE) FUNC(DST, SRC, SIZE);
+#endif
+#endif
+
+#if defined(TH_REAL_IS_FLOAT)
+void THTensor_(copyHalf)(THTensor *tensor, THHalfTensor *src)
+{
+  ptrdiff_t size = THTensor_(nElement)(tensor);
+  if (size == THHalfTensor_nElement(src) &&
+      THTensor_(isContiguous)(tensor) && THHalfTensor_isContiguous(src)) {
+    real *rp = THTensor_(data)(tensor);
+    THHalf *sp = THHalfTensor_data(src);
+    TH_HALF_CONVERT_PARALLEL(THFloatVector_fromHalf, rp, sp, size)
+    return;
+  }
+  TH_TENSOR_APPLY2(real, tensor, THHalf, src, *tensor_data = TH_half2float(*src_data);)
+}
+#endif
+
+#if defined(TH_REAL_IS_HALF)
+void THTensor_(copyFloat)(THTensor *tensor, THFloatTensor *src)
+{
+  ptrdiff_t size = THTensor_(nElement)(tensor);
+  if (size == THFloatTensor_nElement(src) &&
+      THTensor_(isContiguous)(tensor) && THFloatTensor_isContiguous(src)) {
+    real *rp = THTensor_(data)(tensor);
+    float *sp = THFloatTensor_data(src);
+    TH_HALF_CONVERT_PARALLEL(THFloatVector_toHalf, rp, sp, size)
+    return;
+  }
+  TH_TENSOR_APPLY2(real, tensor, float, src, *tensor_data = TH_float2half(*src_data);)
+}
+#endif
+
 #ifndef TH_REAL_IS_HALF
 IMPLEMENT_THTensor_COPY(Byte, uint8_t)
 IMPLEMENT_THTensor_COPY(Char, int8_t)
@@ -185,7 +275,9 @@ IMPLEMENT_THTensor_COPY(Int, int32_t)
 IMPLEMENT_THTensor_COPY(Long, int64_t)
 IMPLEMENT_THTensor_COPY(Float, float)
 IMPLEMENT_THTensor_COPY(Double, double)
+#ifndef TH_REAL_IS_FLOAT
 IMPLEMENT_THTensor_COPY_FROM_HALF(Half, THHalf)
+#endif
 #else
 /* only allow pass-through for Half */
 IMPLEMENT_THTensor_COPY_TO_FROM_HALF(Half, THHalf)
@@ -194,9 +286,10 @@ IMPLEMENT_THTensor_COPY_TO_HALF(Char, int8_t)
 IMPLEMENT_THTensor_COPY_TO_HALF(Short, int16_t)
 IMPLEMENT_THTensor_COPY_TO_HALF(Int, int32_t)
 IMPLEMENT_THTensor_COPY_TO_HALF(Long, int64_t)
-IMPLEMENT_THTensor_COPY_TO_HALF(Float, float)
 IMPLEMENT_THTensor_COPY_TO_HALF(Double, double)
 
 #endif /* REAL_IS_HALF */
 
+#undef TH_HALF_CONVERT_PARALLEL
+
 #endif
@@ -101,11 +101,361 @@ static THTensor *THTensor_(cloneColumnMajor)(THTensor *self, THTensor *src)
   return THTensor_(cloneColumnMajorNrows)(self, src, src->size[0]);
 }
 
+/*
+Lapack calls on tensors with more than 2 dimensions treat them as batches of
+matrices in the last two dimensions, e.g. many 3x3 inverses or a Cholesky
+factorization per Gaussian process. The matrices of a batch are independent,
+so they are run in parallel, each with its own Lapack call.
+*/
+#ifdef _OPENMP
+#define TH_OMP_OVERHEAD_THRESHOLD_LAPACK 100000
+#include <omp.h>
+#endif
+
+static int64_t THTensor_(batchCount)(THTensor *self)
+{
+  int64_t count = 1;
+  int d;
+  for (d = 0; d < self->nDimension - 2; d++)
+    count *= self->size[d];
+  return count;
+}
+
+/*
+Whether it pays off to hand the matrices of a batch to several threads,
+given that factorizing an nxn matrix takes about n^3 operations.
+*/
+static int THTensor_(parallelizeBatch)(int64_t count, int64_t n)
+{
+#ifdef _OPENMP
+  return count > 1 && count * n * n * n > TH_OMP_OVERHEAD_THRESHOLD_LAPACK && !omp_in_parallel();
+#else
+  return 0;
+#endif
+}
+
+/*
+Check if the matrices of self are column major and follow each other in memory,
+which is the layout newBatchColumnMajor returns.
+*/
+static int THTensor_(isBatchColumnMajor)(THTensor *self)
+{
+  int d = self->nDimension;
+  int64_t expected = self->size[d - 2] * self->size[d - 1];
+  int k;
+  if (self->stride[d - 2] != 1 || self->stride[d - 1] != self->size[d - 2])
+    return 0;
+  for (k = d - 3; k >= 0; k--) {
+    if (self->size[k] != 1 && self->stride[k] != expected)
+      return 0;
+    expected *= self->size[k];
+  }
+  return 1;
+}
+
+/*
+Batched version of cloneColumnMajor: a new tensor with the sizes of src, in
+which each matrix is column major, and matrix i starts i*rows*cols elements
+after the first one. The returned tensor has to be freed by the calling function.
+*/
+static THTensor *THTensor_(newBatchColumnMajor)(THTensor *src)
+{
+  int d = src->nDimension;
+  THTensor *transposed = THTensor_(newTranspose)(src, d - 2, d - 1);
+  THTensor *result = THTensor_(newClone)(transposed);
+  THTensor_(free)(transposed);
+  THTensor_(transpose)(result, NULL, d - 2, d - 1);
+  return result;
+}
+
+static void THTensor_(checkBatchSizes)(THTensor *b, THTensor *a)
+{
+  int d = a->nDimension;
+  int k;
+  THArgCheck(b->nDimension == d, 1, "B should have %d dimensions, like A, but has %d",
+      d, b->nDimension);
+  for (k = 0; k < d - 2; k++) {
+    THArgCheck(a->size[k] == b->size[k], 1, "A,B batch sizes incompatible - A has "
+        "size %ld in dimension %d, B has %ld", a->size[k], k, b->size[k]);
+  }
+  THArgCheck(a->size[d - 2] == a->size[d - 1], 2, "A should be a batch of square "
+      "matrices, but they are %ldx%ld", a->size[d - 2], a->size[d - 1]);
+  THArgCheck(a->size[d - 2] == b->size[d - 2], 2, "A,B size incompatible - A has %ld "
+      "rows, B has %ld", a->size[d - 2], b->size[d - 2]);
+}
+
+/* Index of the first matrix of a batch for which Lapack failed, or -1 */
+static int64_t THTensor_(firstBatchError)(const int *info, int64_t count)
+{
+  int64_t i;
+  for (i = 0; i < count; i++) {
+    if (info[i] != 0)
+      return i;
+  }
+  return -1;
+}
+
+static void THTensor_(batchError)(const char *func, const char *reason, int64_t batch, int info)
+{
+  if (info < 0)
+    THError("Lapack Error in %s : Illegal Argument %d", func, -info);
+  THError("Lapack Error in %s : %s for batch element %ld (info == %d)",
+          func, reason, batch, info);
+}
+
+/*
+Closed-form inverse of a 1x1, 2x2 or 3x3 matrix, as the adjugate divided by the
+determinant. Since inv(A') == inv(A)', it works for row and column major input.
+Returns a non-zero value if the matrix is singular.
+*/
+static int THTensor_(smallInverse)(real *r, const real *m, int n)
+{
+  real det;
+  if (n == 1) {
+    if (m[0] == 0)
+      return 1;
+    r[0] = 1 / m[0];
+    return 0;
+  }
+  if (n == 2) {
+    det = m[0] * m[3] - m[1] * m[2];
+    if (det == 0)
+      return 2;
+    r[0] = m[3] / det;
+    r[1] = -m[1] / det;
+    r[2] = -m[2] / det;
+    r[3] = m[0] / det;
+    return 0;
+  }
+  {
+    real c0 = m[4] * m[8] - m[5] * m[7];
+    real c1 = m[5] * m[6] - m[3] * m[8];
+    real c2 = m[3] * m[7] - m[4] * m[6];
+    real inv;
+    det = m[0] * c0 + m[1] * c1 + m[2] * c2;
+    if (det == 0)
+      return 3;
+    inv = 1 / det;
+    r[0] = c0 * inv;
+    r[1] = (m[2] * m[7] - m[1] * m[8]) * inv;
+    r[2] = (m[1] * m[5] - m[2] * m[4]) * inv;
+    r[3] = c1 * inv;
+    r[4] = (m[0] * m[8] - m[2] * m[6]) * inv;
+    r[5] = (m[2] * m[3] - m[0] * m[5]) * inv;
+    r[6] = c2 * inv;
+    r[7] = (m[1] * m[6] - m[0] * m[7]) * inv;
+    r[8] = (m[0] * m[4] - m[1] * m[3]) * inv;
+  }
+  return 0;
+}
+
+/*
+Zeroes the lower triangle of the column major nxn matrix p for uplo == 'U',
+and its upper triangle for uplo == 'L', which Lapack leaves untouched.
+*/
+static void THTensor_(clearUpLoTriangleData)(real *p, int64_t n, char uplo)
+{
+  int64_t i, j;
+
+  /* Upper Triangular Case */
+  if (uplo == 'U')
+  {
+    /* Clear lower triangle (excluding diagonals) */
+    for (i=0; i<n; i++) {
+     for (j=i+1; j<n; j++) {
+        p[n*i + j] = 0;
+      }
+    }
+  }
+  /* Lower Triangular Case */
+  else if (uplo == 'L')
+  {
+    /* Clear upper triangle (excluding diagonals) */
+    for (i=0; i<n; i++) {
+      for (j=0; j<i; j++) {
+        p[n*i + j] = 0;
+      }
+    }
+  }
+}
+
+static void THTensor_(gesvBatched)(THTensor *rb_, THTensor *ra_, THTensor *b, THTensor *a)
+{
+  THTensor_(checkBatchSizes)(b, a);
+
+  int d = a->nDimension;
+  int n = (int)a->size[d - 1];
+  int nrhs = (int)b->size[d - 1];
+  int64_t count = THTensor_(batchCount)(a);
+  int64_t i;
+
+  THTensor *ra__ = THTensor_(newBatchColumnMajor)(a);
+  THTensor *rb__ = THTensor_(newBatchColumnMajor)(b);
+  THIntTensor *ipiv = THIntTensor_newWithSize1d(count * n);
+  THIntTensor *info = THIntTensor_newWithSize1d(count);
+  real *a_data = THTensor_(data)(ra__);
+  real *b_data = THTensor_(data)(rb__);
+  int *ipiv_data = THIntTensor_data(ipiv);
+  int *info_data = THIntTensor_data(info);
+
+#ifdef _OPENMP
+  #pragma omp parallel for private(i) if (THTensor_(parallelizeBatch)(count, n))
+#endif
+  for (i = 0; i < count; i++) {
+    THLapack_(gesv)(n, nrhs, a_data + i * n * n, n, ipiv_data + i * n,
+                    b_data + i * n * nrhs, n, info_data + i);
+  }
+
+  int64_t bad = THTensor_(firstBatchError)(info_data, count);
+  int bad_info = bad >= 0 ? info_data[bad] : 0;
+  THIntTensor_free(ipiv);
+  THIntTensor_free(info);
+  if (bad >= 0) {
+    THTensor_(free)(ra__);
+    THTensor_(free)(rb__);
+    THTensor_(batchError)("gesv", "singular U", bad, bad_info);
+  }
+
+  THTensor_(resizeAs)(ra_, a);
+  THTensor_(resizeAs)(rb_, b);
+  THTensor_(freeCopyTo)(ra__, ra_);
+  THTensor_(freeCopyTo)(rb__, rb_);
+}
+
+static void THTensor_(getriBatched)(THTensor *ra_, THTensor *a)
+{
+  int d = a->nDimension;
+  THArgCheck(a->size[d - 2] == a->size[d - 1], 1, "A should be a batch of square "
+      "matrices, but they are %ldx%ld", a->size[d - 2], a->size[d - 1]);
+
+  int n = (int)a->size[d - 1];
+  int64_t count = THTensor_(batchCount)(a);
+  int64_t i;
+
+  /* The inverses are solutions of A X = I, which needs no Lapack workspace */
+  THTensor *a__ = THTensor_(newBatchColumnMajor)(a);
+  THTensor *ra__ = THTensor_(newBatchColumnMajor)(a);
+  THIntTensor *ipiv = THIntTensor_newWithSize1d(count * n);
+  THIntTensor *info = THIntTensor_newWithSize1d(count);
+  real *a_data = THTensor_(data)(a__);
+  real *r_data = THTensor_(data)(ra__);
+  int *ipiv_data = THIntTensor_data(ipiv);
+  int *info_data = THIntTensor_data(info);
+
+#ifdef _OPENMP
+  #pragma omp parallel for private(i) if (THTensor_(parallelizeBatch)(count, n))
+#endif
+  for (i = 0; i < count; i++) {
+    real *ai = a_data + i * n * n;
+    real *ri = r_data + i * n * n;
+    if (n <= 3) {
+      info_data[i] = THTensor_(smallInverse)(ri, ai, n);
+    } else {
+      int64_t j;
+      for (j = 0; j < (int64_t)n * n; j++)
+        ri[j] = 0;
+      for (j = 0; j < n; j++)
+        ri[j * n + j] = 1;
+      THLapack_(gesv)(n, n, ai, n, ipiv_data + i * n, ri, n, info_data + i);
+    }
+  }
+
+  int64_t bad = THTensor_(firstBatchError)(info_data, count);
+  int bad_info = bad >= 0 ? info_data[bad] : 0;
+  THTensor_(free)(a__);
+  THIntTensor_free(ipiv);
+  THIntTensor_free(info);
+  if (bad >= 0) {
+    THTensor_(free)(ra__);
+    THTensor_(batchError)("getri", "singular matrix", bad, bad_info);
+  }
+
+  THTensor_(resizeAs)(ra_, a);
+  THTensor_(freeCopyTo)(ra__, ra_);
+}
+
+static void THTensor_(potrfBatched)(THTensor *ra_, THTensor *a, const char *uplo)
+{
+  int d = a->nDimension;
+  THArgCheck(a->size[d - 2] == a->size[d - 1], 1, "A should be a batch of square "
+      "matrices, but they are %ldx%ld", a->size[d - 2], a->size[d - 1]);
+
+  int n = (int)a->size[d - 1];
+  int64_t count = THTensor_(batchCount)(a);
+  int64_t i;
+
+  THTensor *ra__ = THTensor_(newBatchColumnMajor)(a);
+  THIntTensor *info = THIntTensor_newWithSize1d(count);
+  real *data = THTensor_(data)(ra__);
+  int *info_data = THIntTensor_data(info);
+
+#ifdef _OPENMP
+  #pragma omp parallel for private(i) if (THTensor_(parallelizeBatch)(count, n))
+#endif
+  for (i = 0; i < count; i++) {
+    THLapack_(potrf)(uplo[0], n, data + i * n * n, n, info_data + i);
+    THTensor_(clearUpLoTriangleData)(data + i * n * n, n, uplo[0]);
+  }
+
+  int64_t bad = THTensor_(firstBatchError)(info_data, count);
+  int bad_info = bad >= 0 ? info_data[bad] : 0;
+  THIntTensor_free(info);
+  if (bad >= 0) {
+    THTensor_(free)(ra__);
+    THTensor_(batchError)("potrf", "a leading minor is not positive definite", bad, bad_info);
+  }
+
+  THTensor_(resizeAs)(ra_, a);
+  THTensor_(freeCopyTo)(ra__, ra_);
+}
+
+static void THTensor_(potrsBatched)(THTensor *rb_, THTensor *b, THTensor *a, const char *uplo)
+{
+  THTensor_(checkBatchSizes)(b, a);
+
+  int d = a->nDimension;
+  int n = (int)a->size[d - 1];
+  int nrhs = (int)b->size[d - 1];
+  int64_t count = THTensor_(batchCount)(a);
+  int64_t i;
+
+  THTensor *ra__ = THTensor_(newBatchColumnMajor)(a);
+  THTensor *rb__ = THTensor_(newBatchColumnMajor)(b);
+  THIntTensor *info = THIntTensor_newWithSize1d(count);
+  real *a_data = THTensor_(data)(ra__);
+  real *b_data = THTensor_(data)(rb__);
+  int *info_data = THIntTensor_data(info);
+
+#ifdef _OPENMP
+  #pragma omp parallel for private(i) if (THTensor_(parallelizeBatch)(count, n))
+#endif
+  for (i = 0; i < count; i++) {
+    THLapack_(potrs)(uplo[0], n, nrhs, a_data + i * n * n, n,
+                     b_data + i * n * nrhs, n, info_data + i);
+  }
+
+  int64_t bad = THTensor_(firstBatchError)(info_data, count);
+  int bad_info = bad >= 0 ? info_data[bad] : 0;
+  THIntTensor_free(info);
+  THTensor_(free)(ra__);
+  if (bad >= 0) {
+    THTensor_(free)(rb__);
+    THTensor_(batchError)("potrs", "singular A", bad, bad_info);
+  }
+
+  THTensor_(resizeAs)(rb_, b);
+  THTensor_(freeCopyTo)(rb__, rb_);
+}
+
 void THTensor_(gesv)(THTensor *rb_, THTensor *ra_, THTensor *b, THTensor *a)
 {
   int free_b = 0;
   if (a == NULL) a = ra_;
   if (b == NULL) b = rb_;
+  if (a->nDimension > 2) {
+    THTensor_(gesvBatched)(rb_, ra_, b, a);
+    return;
+  }
   THArgCheck(a->nDimension == 2, 2, "A should have 2 dimensions, but has %d",
       a->nDimension);
   THArgCheck(b->nDimension == 1 || b->nDimension == 2, 1, "B should have 1 or 2 "
@@ -489,6 +839,10 @@ void THTensor_(gesvd2)(THTensor *ru_, THTensor *rs_, THTensor *rv_, THTensor *ra
 void THTensor_(getri)(THTensor *ra_, THTensor *a)
 {
   if (a == NULL) a = ra_;
+  if (a->nDimension > 2) {
+    THTensor_(getriBatched)(ra_, a);
+    return;
+  }
   THArgCheck(a->nDimension == 2, 1, "A should be 2 dimensional");
   THArgCheck(a->size[0] == a->size[1], 1, "A should be square");
 
@@ -535,32 +889,7 @@ void THTensor_(clearUpLoTriangle)(THTensor *a, const char *uplo)
   THArgCheck(a->nDimension == 2, 1, "A should be 2 dimensional");
   THArgCheck(a->size[0] == a->size[1], 1, "A should be square");
 
-  int n = a->size[0];
-
-  /* Build full matrix */
-  real *p = THTensor_(data)(a);
-  int64_t i, j;
-
-  /* Upper Triangular Case */
-  if (uplo[0] == 'U')
-  {
-    /* Clear lower triangle (excluding diagonals) */
-    for (i=0; i<n; i++) {
-     for (j=i+1; j<n; j++) {
-        p[n*i + j] = 0;
-      }
-    }
-  }
-  /* Lower Triangular Case */
-  else if (uplo[0] == 'L')
-  {
-    /* Clear upper triangle (excluding diagonals) */
-    for (i=0; i<n; i++) {
-      for (j=0; j<i; j++) {
-        p[n*i + j] = 0;
-      }
-    }
-  }
+  THTensor_(clearUpLoTriangleData)(THTensor_(data)(a), a->size[0], uplo[0]);
 }
 
 void THTensor_(copyUpLoTriangle)(THTensor *a, const char *uplo)
@@ -599,6 +928,10 @@ void THTensor_(copyUpLoTriangle)(THTensor *a, const char *uplo)
 void THTensor_(potrf)(THTensor *ra_, THTensor *a, const char *uplo)
 {
   if (a == NULL) a = ra_;
+  if (a->nDimension > 2) {
+    THTensor_(potrfBatched)(ra_, a, uplo);
+    return;
+  }
   THArgCheck(a->nDimension == 2, 1, "A should be 2 dimensional");
   THArgCheck(a->size[0] == a->size[1], 1, "A should be square");
 
@@ -624,6 +957,10 @@ void THTensor_(potrs)(THTensor *rb_, THTensor *b, THTensor *a, const char *uplo)
 {
   int free_b = 0;
   if (b == NULL) b = rb_;
+  if (a->nDimension > 2) {
+    THTensor_(potrsBatched)(rb_, b, a, uplo);
+    return;
+  }
 
   THArgCheck(a->nDimension == 2, 2, "A should have 2 dimensions, but has %d",
       a->nDimension);
@@ -948,7 +1285,8 @@ void THTensor_(ormqr)(THTensor *ra_, THTensor *a, THTensor *tau, THTensor *c, co
 
 void THTensor_(btrifact)(THTensor *ra_, THIntTensor *rpivots_, THIntTensor *rinfo_, int pivot, THTensor *a)
 {
-  THArgCheck(THTensor_(nDimension)(a) == 3, 1, "expected 3D tensor, got %dD", THTensor_(nDimension)(a));
+  int dim = THTensor_(nDimension)(a);
+  THArgCheck(dim >= 3, 1, "expected a tensor with at least 3 dimensions, got %dD", dim);
   if (!pivot) {
     THError("btrifact without pivoting is not implemented on the CPU");
   }
@@ -958,66 +1296,63 @@ void THTensor_(btrifact)(THTensor *ra_, THIntTensor *rpivots_, THIntTensor *rinf
     THTensor_(copy)(ra_, a);
   }
 
-  int m = a->size[1];
-  int n = a->size[2];
+  int m = a->size[dim - 2];
+  int n = a->size[dim - 1];
   if (m != n) {
     THError("btrifact is only implemented for square matrices");
   }
-  int64_t num_batches = THTensor_(size)(a, 0);
+  int64_t num_batches = THTensor_(batchCount)(a);
+  int64_t batch;
   THTensor *ra__;
-  int lda;
 
-  if (ra_->stride[1] == 1) {
+  if (THTensor_(isBatchColumnMajor)(ra_)) {
     // column ordered, what BLAS wants
-    lda = ra_->stride[2];
+    THTensor_(retain)(ra_);
     ra__ = ra_;
   } else {
     // not column ordered, need to make it such (requires copy)
-    THTensor *transp_r_ = THTensor_(newTranspose)(ra_, 1, 2);
-    ra__ = THTensor_(newClone)(transp_r_);
-    THTensor_(free)(transp_r_);
-    THTensor_(transpose)(ra__, NULL, 1, 2);
-    lda = ra__->stride[2];
+    ra__ = THTensor_(newBatchColumnMajor)(ra_);
   }
 
-  THTensor *ai = THTensor_(new)();
-  THTensor *rai = THTensor_(new)();
-  THIntTensor *rpivoti = THIntTensor_new();
+  // pivots have the sizes of a without its last dimension, infos without the
+  // last two
+  THLongStorage *sizes = THLongStorage_newWithSize(dim - 1);
+  for (int d = 0; d < dim - 2; d++) {
+    THLongStorage_set(sizes, d, a->size[d]);
+  }
+  THLongStorage_set(sizes, dim - 2, n);
+  THIntTensor_resize(rpivots_, sizes, NULL);
 
-  int info = 0;
-  int *info_ptr = &info;
+  THIntTensor *info = rinfo_;
   if (rinfo_) {
-    THIntTensor_resize1d(rinfo_, num_batches);
-    info_ptr = THIntTensor_data(rinfo_);
+    THLongStorage_resize(sizes, dim - 2);
+    THIntTensor_resize(rinfo_, sizes, NULL);
+  } else {
+    info = THIntTensor_newWithSize1d(num_batches);
   }
+  THLongStorage_free(sizes);
 
-  THIntTensor_resize2d(rpivots_, num_batches, n);
-
-  int64_t batch = 0;
-  for (; batch < num_batches; ++batch) {
-    THTensor_(select)(ai, a, 0, batch);
-    THTensor_(select)(rai, ra__, 0, batch);
-    THIntTensor_select(rpivoti, rpivots_, 0, batch);
+  real *data = THTensor_(data)(ra__);
+  int *pivots_data = THIntTensor_data(rpivots_);
+  int *info_data = THIntTensor_data(info);
 
-    THLapack_(getrf)(n, n, THTensor_(data)(rai), lda,
-                     THIntTensor_data(rpivoti), info_ptr);
-    if (rinfo_) {
-      info_ptr++;
-    } else if (info != 0) {
-      break;
-    }
+#ifdef _OPENMP
+  #pragma omp parallel for private(batch) if (THTensor_(parallelizeBatch)(num_batches, n))
+#endif
+  for (batch = 0; batch < num_batches; ++batch) {
+    THLapack_(getrf)(n, n, data + batch * n * n, n,
+                     pivots_data + batch * n, info_data + batch);
   }
 
-  THTensor_(free)(ai);
-  THTensor_(free)(rai);
-  THIntTensor_free(rpivoti);
-
-  if (ra__ != ra_) {
-    THTensor_(freeCopyTo)(ra__, ra_);
-  }
+  THTensor_(freeCopyTo)(ra__, ra_);
 
-  if (!rinfo_ && info != 0) {
-    THError("failed to factorize batch element %ld (info == %d)", batch, info);
+  if (!rinfo_) {
+    batch = THTensor_(firstBatchError)(info_data, num_batches);
+    int bad_info = batch >= 0 ? info_data[batch] : 0;
+    THIntTensor_free(info);
+    if (batch >= 0) {
+      THError("failed to factorize batch element %ld (info == %d)", batch, bad_info);
+    }
   }
 }
 
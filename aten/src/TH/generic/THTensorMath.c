@@ -3649,21 +3649,47 @@ void THTensor_(catArray)(THTensor *result, THTensor **inputs, int numInputs, int
   }
   allContiguous = allContiguous && THTensor_(isContiguous)(result);
 
-  // First path is for contiguous inputs along dim 0
+  // First path is for contiguous inputs and result, in any dimension
   // Second path for non-contiguous
   int64_t offset;
-  if (cat_dimension == 0 && allContiguous) {
-    real* result_data = result->storage->data + result->storageOffset;
+  if (allContiguous) {
+    // The result is `outer` rows, each made of one contiguous slice of every
+    // input in turn. The offset of each input in a row is computed up front,
+    // so that all the (row, input) slices can be copied in parallel.
+    int64_t outer = 1;
+    int64_t inner = 1;
+    for (int dim = 0; dim < cat_dimension; dim++) {
+      outer *= result->size[dim];
+    }
+    for (int dim = cat_dimension + 1; dim < nDims; dim++) {
+      inner *= result->size[dim];
+    }
+    int64_t result_row_size = cat_dim_size * inner;
+    real* result_data = THTensor_(data)(result);
+    int64_t *input_offsets = (int64_t*)THAlloc(sizeof(int64_t) * numInputs);
     offset = 0;
     for (int j = 0; j < numInputs; j++) {
+      input_offsets[j] = offset;
       if (inputs[j]->nDimension) {
-        THTensor* input0 = inputs[j];
-        real* input0_data = input0->storage->data + input0->storageOffset;
-        int64_t input0_size = THTensor_(nElement)(input0);
-        memcpy(result_data + offset, input0_data, input0_size*sizeof(real));
-        offset += input0_size;
+        offset += inputs[j]->size[cat_dimension] * inner;
+      }
+    }
+    ptrdiff_t result_size = THTensor_(nElement)(result);
+    ptrdiff_t numSlices = result_size > 0 ? (ptrdiff_t)outer * numInputs : 0;
+    ptrdiff_t slice;
+#pragma omp parallel for if(result_size > TH_OMP_OVERHEAD_THRESHOLD && numSlices > 1) private(slice)
+    for (slice = 0; slice < numSlices; slice++) {
+      int64_t row = slice / numInputs;
+      THTensor *input = inputs[slice % numInputs];
+      if (input->nDimension) {
+        int64_t slice_size = input->size[cat_dimension] * inner;
+        real* input_data = THTensor_(data)(input);
+        memcpy(result_data + row * result_row_size + input_offsets[slice % numInputs],
+               input_data + row * slice_size,
+               slice_size * sizeof(real));
       }
     }
+    THFree(input_offsets);
   } else {
     offset = 0;
     for (int j = 0; j < numInputs; j++) {
@@ -4,6 +4,48 @@
 
 #include "THGenerator.h"
 
+#ifndef TH_RANDOM_PHILOX_CHUNK
+#include <algorithm>
+
+// The contiguous fills are split in chunks of this many elements, each
+// generated from its own positions of a Philox stream so that the chunks run
+// on any number of threads with the same result. A multiple of 16 for the
+// normal fill.
+#define TH_RANDOM_PHILOX_CHUNK 16384
+#define TH_RANDOM_OMP_OVERHEAD_THRESHOLD 100000
+
+// Draws the key of the Philox stream of a fill
+static uint64_t THRandom_philoxKey(THGenerator *_generator)
+{
+  std::lock_guard<std::mutex> lock(_generator->mutex);
+  return THRandom_random64(_generator);
+}
+
+// Writes 0 or 1 into the contiguous data of a bernoulli fill, with the
+// probabilities of the contiguous pf or pd if given, or p otherwise
+template <typename T>
+static void THRandom_philoxBernoulli(
+    T *data, const int64_t size, const uint64_t key,
+    const float *pf, const double *pd, const double p)
+{
+  for (int64_t i = 0; i < size && (pf || pd); ++i) {
+    const double prob = pf ? pf[i] : pd[i];
+    THArgCheck(prob >= 0 && prob <= 1, 1, "must be >= 0 and <= 1");
+  }
+  const int64_t numBlocks = (size + 3) / 4;
+  int64_t block;
+#pragma omp parallel for if (size > TH_RANDOM_OMP_OVERHEAD_THRESHOLD)
+  for (block = 0; block < numBlocks; ++block) {
+    uint32_t words[4];
+    THRandom_philox(key, block, words);
+    for (int64_t i = block * 4; i < std::min(size, block * 4 + 4); ++i) {
+      const double prob = pf ? pf[i] : (pd ? pd[i] : p);
+      data[i] = (T)(words[i % 4] * (1.0 / 4294967296.0) < prob);
+    }
+  }
+}
+#endif
+
 void THTensor_(random)(THTensor *self, THGenerator *_generator)
 {
   std::lock_guard<std::mutex> lock(_generator->mutex);
@@ -53,18 +95,38 @@ void THTensor_(geometric)(THTensor *self, THGenerator *_generator, double p)
 
 void THTensor_(bernoulli)(THTensor *self, THGenerator *_generator, double p)
 {
+  if (THTensor_(isContiguous)(self)) {
+    THArgCheck(p >= 0 && p <= 1, 1, "must be >= 0 and <= 1");
+    THRandom_philoxBernoulli(THTensor_(data)(self), THTensor_(nElement)(self),
+                             THRandom_philoxKey(_generator), NULL, NULL, p);
+    return;
+  }
   std::lock_guard<std::mutex> lock(_generator->mutex);
   TH_TENSOR_APPLY(real, self, *self_data = (real)THRandom_bernoulli(_generator, p););
 }
 
 void THTensor_(bernoulli_FloatTensor)(THTensor *self, THGenerator *_generator, THFloatTensor *p)
 {
+  if (THTensor_(isContiguous)(self) && THFloatTensor_isContiguous(p) &&
+      THTensor_(nElement)(self) == THFloatTensor_nElement(p)) {
+    THRandom_philoxBernoulli(THTensor_(data)(self), THTensor_(nElement)(self),
+                             THRandom_philoxKey(_generator),
+                             THFloatTensor_data(p), NULL, 0);
+    return;
+  }
   std::lock_guard<std::mutex> lock(_generator->mutex);
   TH_TENSOR_APPLY2(real, self, float, p, *self_data = (real)THRandom_bernoulli(_generator, (double)*p_data););
 }
 
 void THTensor_(bernoulli_DoubleTensor)(THTensor *self, THGenerator *_generator, THDoubleTensor *p)
 {
+  if (THTensor_(isContiguous)(self) && THDoubleTensor_isContiguous(p) &&
+      THTensor_(nElement)(self) == THDoubleTensor_nElement(p)) {
+    THRandom_philoxBernoulli(THTensor_(data)(self), THTensor_(nElement)(self),
+                             THRandom_philoxKey(_generator),
+                             NULL, THDoubleTensor_data(p), 0);
+    return;
+  }
   std::lock_guard<std::mutex> lock(_generator->mutex);
   TH_TENSOR_APPLY2(real, self, double, p, *self_data = (real)THRandom_bernoulli(_generator, (double)*p_data););
 }
@@ -88,6 +150,30 @@ void THTensor_(bernoulli_Tensor)(THTensor *self, THGenerator *_generator, THTens
 
 void THTensor_(uniform)(THTensor *self, THGenerator *_generator, double a, double b)
 {
+  if (THTensor_(isContiguous)(self)) {
+    const int64_t size = THTensor_(nElement)(self);
+    const int64_t numChunks = (size + TH_RANDOM_PHILOX_CHUNK - 1) / TH_RANDOM_PHILOX_CHUNK;
+    const uint64_t key = THRandom_philoxKey(_generator);
+    real *data = THTensor_(data)(self);
+    int64_t chunk;
+#pragma omp parallel for if (size > TH_RANDOM_OMP_OVERHEAD_THRESHOLD)
+    for (chunk = 0; chunk < numChunks; ++chunk) {
+      const int64_t begin = chunk * TH_RANDOM_PHILOX_CHUNK;
+      const int64_t end = std::min(size, begin + TH_RANDOM_PHILOX_CHUNK);
+#if defined(TH_REAL_IS_FLOAT)
+      THRandom_philoxUniformFloat(data + begin, end - begin, key, begin);
+      for (int64_t i = begin; i < end; ++i) {
+        data[i] = data[i] * ((real)b - (real)a) + (real)a;
+      }
+#else
+      THRandom_philoxUniformDouble(data + begin, end - begin, key, begin);
+      for (int64_t i = begin; i < end; ++i) {
+        data[i] = data[i] * (b - a) + a;
+      }
+#endif
+    }
+    return;
+  }
   std::lock_guard<std::mutex> lock(_generator->mutex);
   #if defined(TH_REAL_IS_FLOAT)
   TH_TENSOR_APPLY(real, self, *self_data =
@@ -100,11 +186,20 @@ void THTensor_(uniform)(THTensor *self, THGenerator *_generator, double a, doubl
 
 void THTensor_(normal)(THTensor *self, THGenerator *_generator, double mean, double stddev)
 {
-  std::lock_guard<std::mutex> lock(_generator->mutex);
-  const int64_t size = THTensor_(numel)(self);
-  if (size >= 16 && THTensor_(isContiguous)(self)) {
-    THVector_(normal_fill)(self->storage->data, size, _generator, mean, stddev);
+  if (THTensor_(isContiguous)(self)) {
+    const int64_t size = THTensor_(numel)(self);
+    const int64_t numChunks = (size + TH_RANDOM_PHILOX_CHUNK - 1) / TH_RANDOM_PHILOX_CHUNK;
+    const uint64_t key = THRandom_philoxKey(_generator);
+    real *data = THTensor_(data)(self);
+    int64_t chunk;
+#pragma omp parallel for if (size > TH_RANDOM_OMP_OVERHEAD_THRESHOLD)
+    for (chunk = 0; chunk < numChunks; ++chunk) {
+      const int64_t begin = chunk * TH_RANDOM_PHILOX_CHUNK;
+      const int64_t end = std::min(size, begin + TH_RANDOM_PHILOX_CHUNK);
+      THVector_(normal_fill)(data + begin, end - begin, key, begin, mean, stddev);
+    }
   } else {
+    std::lock_guard<std::mutex> lock(_generator->mutex);
     TH_TENSOR_APPLY(real, self, *self_data = (real)THRandom_normal(_generator, mean, stddev););
   }
 }
@@ -2,8 +2,6 @@
 #define TH_GENERIC_FILE "generic/THVector.h"
 #else
 
-struct THGenerator;
-
 TH_API void THVector_(fill)(real *x, const real c, const ptrdiff_t n);
 TH_API void THVector_(cadd)(real *z, const real *x, const real *y, const real c, const ptrdiff_t n);
 TH_API void THVector_(adds)(real *y, const real *x, const real c, const ptrdiff_t n);
@@ -13,12 +11,22 @@ TH_API void THVector_(cdiv)(real *z, const real *x, const real *y, const ptrdiff
 TH_API void THVector_(divs)(real *y, const real *x, const real c, const ptrdiff_t n);
 TH_API void THVector_(copy)(real *y, const real *x, const ptrdiff_t n);
 TH_API void THVector_(neg)(real *y, const real *x, const ptrdiff_t n);
+/* Fills data with the normal samples at positions [offset, offset + size) of
+   the Philox stream of key (see THRandom_philox) */
 TH_API void THVector_(normal_fill)(real *data,
                                    const int64_t size,
-                                   struct THGenerator *generator,
+                                   const uint64_t key,
+                                   const uint64_t offset,
                                    const real mean,
                                    const real stddev);
 
+#if defined(TH_REAL_IS_FLOAT)
+/* Bulk conversions between half and single precision, rounding to nearest
+   even like TH_float2half */
+TH_API void THVector_(fromHalf)(real *y, const THHalf *x, const ptrdiff_t n);
+TH_API void THVector_(toHalf)(THHalf *y, const real *x, const ptrdiff_t n);
+#endif
+
 #if defined(TH_REAL_IS_SHORT) || defined(TH_REAL_IS_INT) || defined(TH_REAL_IS_LONG)
 TH_API void THVector_(abs)(real *y, const real *x, const ptrdiff_t n);
 #endif
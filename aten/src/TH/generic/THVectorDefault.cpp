@@ -130,6 +130,25 @@ void THVector_(divs_DEFAULT)(real *y, const real *x, const real c, const ptrdiff
     y[i] = x[i] / c;
 }
 
+// Fills 16 uniform numbers on [0, 1) into data, from positions
+// [offset, offset + 16) of the Philox stream of key
+static void THVector_(philox_uniform_16)(real *data,
+                                         const uint64_t key,
+                                         const uint64_t offset)
+{
+#if defined(TH_REAL_IS_FLOAT)
+  THRandom_philoxUniformFloat(data, 16, key, offset);
+#elif defined(TH_REAL_IS_DOUBLE)
+  THRandom_philoxUniformDouble(data, 16, key, offset);
+#else
+  double uniform[16];
+  THRandom_philoxUniformDouble(uniform, 16, key, offset);
+  for (int j = 0; j < 16; ++j) {
+    data[j] = uniform[j];
+  }
+#endif
+}
+
 // Fills 16 normally distributed samples into data, interleaved with a
 // stride of 8, i.e. in order of ([0], [8]), ([1], [9]), ...
 static void THVector_(interleaved_normal_fill_16)(real *data,
@@ -149,36 +168,29 @@ static void THVector_(interleaved_normal_fill_16)(real *data,
 }
 
 void THVector_(normal_fill_DEFAULT)(real *data,
-                                    int64_t size,
-                                    THGenerator *generator,
+                                    const int64_t size,
+                                    const uint64_t key,
+                                    const uint64_t offset,
                                     const real mean,
                                     const real stddev)
 {
-  THAssert(size >= 16 && "Size must be >= 16 for normal fill");
-
-  for (int64_t i = 0; i < size; ++i) {
-#ifdef TH_REAL_IS_FLOAT
-    data[i] = THRandom_uniformFloat(generator, 0, 1);
-#else
-    data[i] = THRandom_uniform(generator, 0, 1);
-#endif
-  }
-
-  for (int64_t i = 0; i < size - 15; i += 16) {
+  // Box-Mueller maps 16 uniform numbers to 16 normal numbers, so that each
+  // group of 16 samples is computed in place from the uniform numbers at the
+  // same positions of the stream.
+  int64_t i = 0;
+  for (; i < size - 15; i += 16) {
+    THVector_(philox_uniform_16)(data + i, key, offset + i);
     THVector_(interleaved_normal_fill_16)(data + i, mean, stddev);
   }
 
-  if (size % 16 != 0) {
-    // Recompute the last 16 values.
-    data = data + size - 16;
-    for (int64_t i = 0; i < 16; ++i) {
-#ifdef TH_REAL_IS_FLOAT
-      data[i] = THRandom_uniformFloat(generator, 0, 1);
-#else
-      data[i] = THRandom_uniform(generator, 0, 1);
-#endif
+  if (i < size) {
+    // The last group is computed whole, and only its first samples are kept.
+    real buffer[16];
+    THVector_(philox_uniform_16)(buffer, key, offset + i);
+    THVector_(interleaved_normal_fill_16)(buffer, mean, stddev);
+    for (int j = 0; i < size; ++i, ++j) {
+      data[i] = buffer[j];
     }
-    THVector_(interleaved_normal_fill_16)(data, mean, stddev);
   }
 }
 
@@ -265,4 +277,18 @@ VECTOR_IMPLEMENT_FUNCTION(cinv, TH_MATH_NAME(1.0) / )
 
 VECTOR_IMPLEMENT_FUNCTION(neg,-)
 
+#if defined(TH_REAL_IS_FLOAT)
+void THVector_(fromHalf_DEFAULT)(real *y, const THHalf *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  for (i = 0; i < n; i++)
+    y[i] = TH_half2float(x[i]);
+}
+
+void THVector_(toHalf_DEFAULT)(THHalf *y, const real *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  for (i = 0; i < n; i++)
+    y[i] = TH_float2half(x[i]);
+}
+#endif
+
 #endif
@@ -239,7 +239,7 @@ void THVector_(copy)(real *y, const real *x, const ptrdiff_t n) {
   THVector_(copy_DISPATCHPTR)(y, x, n);
 }
 
-static void (*THVector_(normal_fill_DISPATCHPTR))(real *, const int64_t, THGenerator *, const real, const real) = &THVector_(normal_fill_DEFAULT);
+static void (*THVector_(normal_fill_DISPATCHPTR))(real *, const int64_t, const uint64_t, const uint64_t, const real, const real) = &THVector_(normal_fill_DEFAULT);
 static FunctionDescription THVector_(normal_fill_DISPATCHTABLE)[] = {
   #if defined(TH_REAL_IS_FLOAT) && defined(USE_AVX2)
       FUNCTION_IMPL(THVector_(normal_fill_AVX2), SIMDExtension_AVX2),
@@ -249,10 +249,11 @@ static FunctionDescription THVector_(normal_fill_DISPATCHTABLE)[] = {
 };
 void THVector_(normal_fill)(real *data,
                             const int64_t size,
-                            struct THGenerator *generator,
+                            const uint64_t key,
+                            const uint64_t offset,
                             const real mean,
                             const real stddev) {
-  THVector_(normal_fill_DISPATCHPTR)(data, size, generator, mean, stddev);
+  THVector_(normal_fill_DISPATCHPTR)(data, size, key, offset, mean, stddev);
 }
 
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
@@ -269,6 +270,34 @@ void THVector_(sigmoid)(real *y, const real *x, const ptrdiff_t n) {
 }
 #endif
 
+#if defined(TH_REAL_IS_FLOAT)
+// The AVX2 versions use the F16C conversion instructions, which every CPU
+// with AVX2 has.
+static void (*THVector_(fromHalf_DISPATCHPTR))(real *, const THHalf *, const ptrdiff_t) = &THVector_(fromHalf_DEFAULT);
+static FunctionDescription THVector_(fromHalf_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+      FUNCTION_IMPL(THVector_(fromHalf_AVX2), SIMDExtension_AVX2),
+  #endif
+
+  FUNCTION_IMPL(THVector_(fromHalf_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(fromHalf)(real *y, const THHalf *x, const ptrdiff_t n) {
+  THVector_(fromHalf_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(toHalf_DISPATCHPTR))(THHalf *, const real *, const ptrdiff_t) = &THVector_(toHalf_DEFAULT);
+static FunctionDescription THVector_(toHalf_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+      FUNCTION_IMPL(THVector_(toHalf_AVX2), SIMDExtension_AVX2),
+  #endif
+
+  FUNCTION_IMPL(THVector_(toHalf_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(toHalf)(THHalf *y, const real *x, const ptrdiff_t n) {
+  THVector_(toHalf_DISPATCHPTR)(y, x, n);
+}
+#endif
+
 /*
  * This struct's constructor initalizes the dispatch tables. It simply checks
  * what SIMD extensions are available, and then walks the dispatch table
@@ -293,6 +322,11 @@ struct THVector_(startup) {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
     INIT_DISPATCH_PTR(sigmoid);
 #endif
+
+#if defined(TH_REAL_IS_FLOAT)
+    INIT_DISPATCH_PTR(fromHalf);
+    INIT_DISPATCH_PTR(toHalf);
+#endif
   }
 };
 
@@ -8,6 +8,7 @@
 #include "AVX2.h"
 #include <ATen/native/cpu/avx_mathfun.h>
 #include "../THRandom.h"
+#include <string.h>
 
 void THDoubleVector_cadd_AVX2(double *z, const double *x, const double *y, const double c, const ptrdiff_t n) {
   ptrdiff_t i;
@@ -72,36 +73,34 @@ static void normal_fill_16_AVX2(float *data,
 
 void THFloatVector_normal_fill_AVX2(float *data,
                                     const int64_t size,
-                                    THGenerator *generator,
+                                    const uint64_t key,
+                                    const uint64_t offset,
                                     const float mean,
                                     const float stddev)
 {
-  THAssert(size >= 16 && "Size must be >= 16 for AVX2 normal fill");
   const __m256 two_pi = _mm256_set1_ps(2.0f * M_PI);
   const __m256 one = _mm256_set1_ps(1.0f);
   const __m256 minus_two = _mm256_set1_ps(-2.0f);
   const __m256 mean_v = _mm256_set1_ps(mean);
   const __m256 stddev_v = _mm256_set1_ps(stddev);
 
-  // First fill the data with the uniform numbers. Box-Mueller is a 2 -> 2
-  // mapping of 2 uniform numbers to 2 normal numbers (per iteration), so we
-  // we need exactly as much space for uniform and normal numbers and can just
-  // use the single buffer for both.
-  for (int64_t i = 0; i < size; ++i) {
-    data[i] = THRandom_uniformFloat(generator, 0, 1);
-  }
-
-  for (int64_t i = 0; i < size - 15; i += 16) {
+  // Box-Mueller is a 2 -> 2 mapping of 2 uniform numbers to 2 normal numbers
+  // (per iteration), so that each group of 16 samples is computed in place
+  // from the uniform numbers at the same positions of the stream.
+  int64_t i = 0;
+  for (; i < size - 15; i += 16) {
+    THRandom_philoxUniformFloat(data + i, 16, key, offset + i);
     normal_fill_16_AVX2(data + i, &two_pi, &one, &minus_two, &mean_v, &stddev_v);
   }
 
-  if (size % 16 != 0) {
-    // We rewind so that we have 16 values and then compute them in one step.
-    data = data + size - 16;
-    for (int i = 0; i < 16; ++i) {
-      data[i] = THRandom_uniformFloat(generator, 0, 1);
+  if (i < size) {
+    // The last group is computed whole, and only its first samples are kept.
+    float buffer[16];
+    THRandom_philoxUniformFloat(buffer, 16, key, offset + i);
+    normal_fill_16_AVX2(buffer, &two_pi, &one, &minus_two, &mean_v, &stddev_v);
+    for (int j = 0; i < size; ++i, ++j) {
+      data[i] = buffer[j];
     }
-    normal_fill_16_AVX2(data, &two_pi, &one, &minus_two, &mean_v, &stddev_v);
   }
 }
 
@@ -127,4 +126,44 @@ void THFloatVector_sigmoid_AVX2(float *y, const float *x, const ptrdiff_t n) {
   }
 }
 
+// The tails go through the vector instructions as well, so that every
+// element is converted the same way (e.g. NaN payloads are kept).
+void THFloatVector_fromHalf_AVX2(float *y, const THHalf *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  __m128i XMM0, XMM1;
+  for (i = 0; i <= ((n)-16); i += 16) {
+    XMM0 = _mm_loadu_si128((const __m128i *)(x + i));
+    XMM1 = _mm_loadu_si128((const __m128i *)(x + i + 8));
+    _mm256_storeu_ps(y + i, _mm256_cvtph_ps(XMM0));
+    _mm256_storeu_ps(y + i + 8, _mm256_cvtph_ps(XMM1));
+  }
+  for (; i < (n); i += 8) {
+    ptrdiff_t len = n - i < 8 ? n - i : 8;
+    THHalf buffer[8] = {};
+    float result[8];
+    memcpy(buffer, x + i, len * sizeof(THHalf));
+    _mm256_storeu_ps(result, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)buffer)));
+    memcpy(y + i, result, len * sizeof(float));
+  }
+}
+
+void THFloatVector_toHalf_AVX2(THHalf *y, const float *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  __m256 YMM0, YMM1;
+  for (i = 0; i <= ((n)-16); i += 16) {
+    YMM0 = _mm256_loadu_ps(x + i);
+    YMM1 = _mm256_loadu_ps(x + i + 8);
+    _mm_storeu_si128((__m128i *)(y + i), _mm256_cvtps_ph(YMM0, _MM_FROUND_TO_NEAREST_INT));
+    _mm_storeu_si128((__m128i *)(y + i + 8), _mm256_cvtps_ph(YMM1, _MM_FROUND_TO_NEAREST_INT));
+  }
+  for (; i < (n); i += 8) {
+    ptrdiff_t len = n - i < 8 ? n - i : 8;
+    float buffer[8] = {};
+    THHalf result[8];
+    memcpy(buffer, x + i, len * sizeof(float));
+    _mm_storeu_si128((__m128i *)result, _mm256_cvtps_ph(_mm256_loadu_ps(buffer), _MM_FROUND_TO_NEAREST_INT));
+    memcpy(y + i, result, len * sizeof(THHalf));
+  }
+}
+
 #endif // defined(__AVX2__)
@@ -2,7 +2,11 @@
 
 #include <cuda_runtime_api.h>
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
 #include <deque>
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -23,6 +27,10 @@
 // - Large (>1MB) and small allocation requests are handled separately. Large
 //   allocation requests can be filled by a cudaMalloc call of the exact size.
 //   Small requests will allocate and split a 1MB buffer, if necessary.
+// - Setting THC_CACHING_ALLOCATOR_MAX_SPLIT_SIZE (in MiB) stops large blocks
+//   of at least that size from being split. Such oversize blocks are only
+//   reused by requests that would waste less than kMaxOversizeWaste of them,
+//   so they stay whole and can always be released by an out-of-memory retry.
 //
 // With this allocator, allocations and frees should logically be considered
 // "usages" of the memory segment associated with streams, just like kernel
@@ -34,6 +42,25 @@
 // ensure that the block is not reused before each recorded stream completes
 // work.
 //
+// Setting THC_CACHING_ALLOCATOR_BINNED=1 in the environment switches small
+// (<= 1MB) allocations to a size-class binned mode:
+//
+// - Requests are rounded up to one of kNumSizeClasses size classes (512 byte
+//   steps up to 4 KiB, then four classes per power of two up to 1 MiB).
+// - Each (device, stream) pair owns a pool with one free list per size class
+//   and its own lock. Segments obtained from cudaMalloc are carved into blocks
+//   of a single size class, so allocation and free are O(1) list operations.
+// - The global lock is only taken to refill a pool with a new segment, for
+//   large allocations, and for blocks that have outstanding stream uses.
+// - Blocks are never split or merged; a segment is returned to the system by
+//   emptyCache() (or an out-of-memory retry) once all its blocks are free.
+//
+// Work captured into a CUDA graph keeps using the memory it was captured
+// with every time the graph is launched. Between beginCapture() and
+// endCapture() on a stream, blocks allocated on that stream are tagged with
+// the capture, and once freed they are kept aside instead of being cached,
+// until releaseCapture() says the graph is gone.
+//
 
 
 namespace {
@@ -44,16 +71,22 @@ typedef std::set<THCStreamPtr> stream_set;
 const size_t kRoundSmall = 512;     // round up small allocs to 512 bytes
 const size_t kRoundLarge = 131072;  // round up large allocs to 128 KiB
 const size_t kSmallAlloc = 1048576; // largest "small" allocation is 1 MiB
+const size_t kMaxOversizeWaste = 20971520; // oversize blocks waste at most 20 MiB
+
+const int    kNumSizeClasses = 40;     // binned size classes up to kSmallAlloc
+const size_t kLinearClassMax = 4096;   // size classes step by kRoundSmall up to here
+const size_t kNumAllocatedShards = 16; // shards of the binned allocated-block map
 
 struct DeviceStats {
   uint64_t   amount_allocated;      // total amount allocated in bytes
   uint64_t   max_amount_allocated;  // max total amount allocated in bytes
   uint64_t   amount_cached;         // total amount in cache in bytes
   uint64_t   max_amount_cached;     // max total amount in cache in bytes
+  uint64_t   num_segments;          // number of cudaMalloc'd segments
 
   DeviceStats() :
       amount_allocated(0), max_amount_allocated(0),
-      amount_cached(0), max_amount_cached(0) { }
+      amount_cached(0), max_amount_cached(0), num_segments(0) { }
 
   void increaseAllocated(size_t delta) {
     amount_allocated += delta;
@@ -64,16 +97,33 @@ struct DeviceStats {
     amount_allocated -= delta;
   }
 
+  // the cache grows and shrinks one segment at a time
   void increaseCached(size_t delta) {
     amount_cached += delta;
     max_amount_cached = std::max(max_amount_cached, amount_cached);
+    num_segments++;
   }
 
   void decreaseCached(size_t delta) {
     amount_cached -= delta;
+    num_segments--;
   }
 };
 
+struct Block;
+struct BinnedPool;
+
+struct BinnedSegment {
+  int                 device;     // gpu
+  cudaStream_t        stream;     // allocation stream
+  BinnedPool*         pool;       // owning (device, stream) pool
+  char*               ptr;        // base address returned by cudaMalloc
+  size_t              size;       // segment size in bytes
+  int                 size_class; // size class of every block in the segment
+  size_t              num_free;   // number of blocks currently in a free list
+  std::vector<Block*> blocks;     // all blocks carved from this segment
+};
+
 struct Block {
   int           device;      // gpu
   cudaStream_t  stream;      // allocation stream
@@ -84,12 +134,78 @@ struct Block {
   Block*        prev;        // prev block if split from a larger allocation
   Block*        next;        // next block if split from a larger allocation
   int           event_count; // number of outstanding CUDA events
+  BinnedSegment* segment;    // owning segment (binned mode only)
+  Block*        bin_next;    // next block in a binned free list
+  int           capture_id;  // graph capture which allocated the block, or 0
 
   Block(int device, cudaStream_t stream, size_t size, char* ptr=NULL) :
       device(device), stream(stream), stream_uses(), size(size), ptr(ptr),
-      allocated(0), prev(NULL), next(NULL), event_count(0) { }
+      allocated(0), prev(NULL), next(NULL), event_count(0), segment(NULL),
+      bin_next(NULL), capture_id(0) { }
 };
 
+// per-(device, stream) free lists used in binned mode
+struct BinnedPool {
+  std::mutex                  mutex;
+  Block*                      free_lists[kNumSizeClasses];
+  std::vector<BinnedSegment*> segments;
+
+  BinnedPool() : segments() {
+    std::fill(free_lists, free_lists + kNumSizeClasses, (Block*)NULL);
+  }
+};
+
+struct AllocatedShard {
+  std::mutex                        mutex;
+  std::unordered_map<void*, Block*> blocks;
+};
+
+static int size_class(size_t size)
+{
+  if (size <= kLinearClassMax) {
+    return size == 0 ? 0 : (int)((size - 1) / kRoundSmall);
+  }
+  // find k such that 2^k < size <= 2^(k+1), then split that range in four
+  int k = 0;
+  while (((size_t)2 << k) < size) {
+    k++;
+  }
+  size_t step = ((size_t)1 << k) / 4;
+  int sub = (int)((size - 1 - ((size_t)1 << k)) / step);
+  return (int)(kLinearClassMax / kRoundSmall) + (k - 12) * 4 + sub;
+}
+
+static size_t size_class_size(int cls)
+{
+  int linear = (int)(kLinearClassMax / kRoundSmall);
+  if (cls < linear) {
+    return (cls + 1) * kRoundSmall;
+  }
+  int k = 12 + (cls - linear) / 4;
+  int sub = (cls - linear) % 4;
+  return ((size_t)1 << k) + (sub + 1) * (((size_t)1 << k) / 4);
+}
+
+static size_t max_split_size_from_env()
+{
+  const char* env = getenv("THC_CACHING_ALLOCATOR_MAX_SPLIT_SIZE");
+  if (!env || strcmp(env, "") == 0) {
+    return std::numeric_limits<size_t>::max();
+  }
+  size_t mb = strtoull(env, NULL, 10);
+  if (mb == 0 || mb > std::numeric_limits<size_t>::max() / 1048576) {
+    return std::numeric_limits<size_t>::max();
+  }
+  // splitting is what small segments are for, so never restrict those
+  return std::max(mb * 1048576, kSmallAlloc + 1);
+}
+
+static bool binned_mode_from_env()
+{
+  const char* env = getenv("THC_CACHING_ALLOCATOR_BINNED");
+  return env && strcmp(env, "") != 0 && strcmp(env, "0") != 0;
+}
+
 static bool BlockComparator(const Block* a, const Block* b)
 {
   if (a->device != b->device) {
@@ -120,6 +236,9 @@ struct THCCachingAllocator
   // lock around calls to cudaFree (to prevent deadlocks with NCCL)
   std::mutex cuda_free_mutex;
 
+  // lock around device_stats; taken last, after any other lock
+  std::mutex stats_mutex;
+
   // cached blocks larger than 1 MB
   FreeBlocks large_blocks;
 
@@ -132,10 +251,41 @@ struct THCCachingAllocator
   // outstanding cuda events
   std::deque<std::pair<cudaEvent_t, Block*>> cuda_events;
 
+  // large blocks of at least this size are never split
+  size_t max_split_size;
+
+  // serve small allocations from per-stream size-class pools
+  bool binned;
+
+  // lock around binned_pools; never held while taking another lock
+  std::mutex pools_mutex;
+
+  // binned pools by (device, stream); pools are never destroyed
+  std::map<std::pair<int, cudaStream_t>, BinnedPool*> binned_pools;
+
+  // allocated binned blocks by device pointer, sharded to spread the locking
+  AllocatedShard binned_allocated[kNumAllocatedShards];
+
+  // streams being captured into a CUDA graph, and their capture ids
+  std::unordered_map<cudaStream_t, int> capturing_streams;
+
+  // number of entries in capturing_streams, read without the lock
+  std::atomic<int> num_capturing_streams;
+
+  // freed blocks of each capture whose graph may still be launched
+  std::map<int, std::vector<Block*>> capture_blocks;
+
+  int next_capture_id;
+
   THCCachingAllocator() :
       large_blocks(BlockComparator),
-      small_blocks(BlockComparator) {}
+      small_blocks(BlockComparator),
+      max_split_size(max_split_size_from_env()),
+      binned(binned_mode_from_env()),
+      num_capturing_streams(0),
+      next_capture_id(1) {}
 
+  // must be called with stats_mutex held
   DeviceStats &get_stats_for_device(int device) {
     THAssert(device >= 0);
     if ((size_t) device >= device_stats.size()) {
@@ -144,9 +294,20 @@ struct THCCachingAllocator
     return device_stats.at(device);
   }
 
+  DeviceStats get_stats(int device) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return get_stats_for_device(device);
+  }
+
   /** allocates a block which is safe to use from the provided stream */
   cudaError_t malloc(void** devPtr, size_t size, cudaStream_t stream)
   {
+    // binned blocks can't be tagged with a capture, so they aren't used while
+    // any stream is captured
+    if (binned && size <= kSmallAlloc && num_capturing_streams.load() == 0) {
+      return binned_malloc(devPtr, size, stream);
+    }
+
     std::lock_guard<std::mutex> lock(mutex);
 
     int device;
@@ -155,16 +316,20 @@ struct THCCachingAllocator
       return err;
     }
 
-    err = process_events();
-    if (err != cudaSuccess) {
-      return err;
+    auto capture = capturing_streams.find(stream);
+    int capture_id = capture == capturing_streams.end() ? 0 : capture->second;
+
+    // querying events isn't allowed while capturing
+    if (!capture_id) {
+      err = process_events();
+      if (err != cudaSuccess) {
+        return err;
+      }
     }
 
     size = round_size(size);
     bool small = size <= kSmallAlloc;
 
-    DeviceStats &stats = get_stats_for_device(device);
-
     Block search_key(device, stream, size);
     auto& free_blocks = small ? large_blocks : small_blocks;
 
@@ -172,21 +337,27 @@ struct THCCachingAllocator
     Block* remaining = NULL;
 
     auto it = free_blocks.lower_bound(&search_key);
-    if (it != free_blocks.end() && (*it)->device == device && (*it)->stream == stream) {
+    if (it != free_blocks.end() && (*it)->device == device && (*it)->stream == stream &&
+        (small || can_use_block(size, (*it)->size))) {
       block = *it;
       free_blocks.erase(it);
     } else {
       void* ptr;
       size_t alloc_size = small ? kSmallAlloc : size;
-      err = cuda_malloc_retry(device, &ptr, alloc_size);
+      if (capture_id) {
+        err = cuda_malloc_while_capturing(device, &ptr, alloc_size);
+      } else {
+        err = cuda_malloc_retry(device, &ptr, alloc_size);
+      }
       if (err != cudaSuccess) {
         return err;
       }
-      stats.increaseCached(alloc_size);
+      increase_cached(device, alloc_size);
       block = new Block(device, stream, alloc_size, (char*)ptr);
     }
 
-    if (block->size - size >= (small ? kRoundSmall : kSmallAlloc + 1)) {
+    if (block->size - size >= (small ? kRoundSmall : kSmallAlloc + 1) &&
+        (small || block->size < max_split_size)) {
       remaining = block;
 
       block = new Block(device, stream, size, block->ptr);
@@ -203,20 +374,28 @@ struct THCCachingAllocator
     }
 
     block->allocated = true;
+    block->capture_id = capture_id;
     allocated_blocks[block->ptr] = block;
 
     *devPtr = (void*)block->ptr;
 
-    stats.increaseAllocated(block->size);
+    increase_allocated(device, block->size);
     return cudaSuccess;
   }
 
   cudaError_t free(void* ptr)
   {
-    std::lock_guard<std::mutex> lock(mutex);
     if (!ptr) {
       return cudaSuccess;
     }
+    if (binned) {
+      Block* block = take_binned_allocated_block(ptr);
+      if (block) {
+        return binned_free(block);
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
 
     auto it = allocated_blocks.find(ptr);
     if (it == allocated_blocks.end()) {
@@ -225,9 +404,18 @@ struct THCCachingAllocator
 
     Block* block = it->second;
     allocated_blocks.erase(it);
+    if (block->capture_id) {
+      auto capture = capture_blocks.find(block->capture_id);
+      if (capture != capture_blocks.end()) {
+        // the graph may still use the block
+        capture->second.push_back(block);
+        return cudaSuccess;
+      }
+      block->capture_id = 0;
+    }
     block->allocated = false;
 
-    get_stats_for_device(block->device).decreaseAllocated(block->size);
+    decrease_allocated(block->device, block->size);
     if (!block->stream_uses.empty()) {
       return insert_events(block);
     }
@@ -236,6 +424,317 @@ struct THCCachingAllocator
     return cudaSuccess;
   }
 
+  /** tags the blocks allocated on stream until endCapture(stream) */
+  int beginCapture(cudaStream_t stream)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    THAssert(capturing_streams.count(stream) == 0);
+    int id = next_capture_id++;
+    capturing_streams[stream] = id;
+    capture_blocks[id];
+    num_capturing_streams++;
+    return id;
+  }
+
+  void endCapture(cudaStream_t stream)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (capturing_streams.erase(stream)) {
+      num_capturing_streams--;
+    }
+  }
+
+  /** frees the blocks kept for a capture, whose graph won't be launched again */
+  cudaError_t releaseCapture(int id)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto capture = capture_blocks.find(id);
+    if (capture == capture_blocks.end()) {
+      return cudaSuccess;
+    }
+    std::vector<Block*> blocks(std::move(capture->second));
+    capture_blocks.erase(capture);
+    cudaError_t err = cudaSuccess;
+    for (Block* block : blocks) {
+      block->capture_id = 0;
+      block->allocated = false;
+      decrease_allocated(block->device, block->size);
+      if (!block->stream_uses.empty()) {
+        cudaError_t event_err = insert_events(block);
+        if (event_err != cudaSuccess) {
+          err = event_err;
+        }
+      } else {
+        free_block(block);
+      }
+    }
+    return err;
+  }
+
+  /** whether a large request may be served by a cached large block */
+  bool can_use_block(size_t size, size_t block_size)
+  {
+    if (block_size < max_split_size) {
+      return true;
+    }
+    // oversize blocks are not split, so only hand them out to requests that
+    // use most of them
+    return size >= max_split_size && block_size - size < kMaxOversizeWaste;
+  }
+
+  /** allocates a block of a size class from the (device, stream) pool */
+  cudaError_t binned_malloc(void** devPtr, size_t size, cudaStream_t stream)
+  {
+    int device;
+    cudaError_t err = cudaGetDevice(&device);
+    if (err != cudaSuccess) {
+      return err;
+    }
+
+    int cls = size_class(size);
+    BinnedPool* pool = get_binned_pool(device, stream);
+
+    Block* block;
+    {
+      std::unique_lock<std::mutex> pool_lock(pool->mutex);
+      while (!pool->free_lists[cls]) {
+        pool_lock.unlock();
+        err = refill_binned_pool(pool, device, stream, cls);
+        if (err != cudaSuccess) {
+          return err;
+        }
+        pool_lock.lock();
+      }
+      block = pool->free_lists[cls];
+      pool->free_lists[cls] = block->bin_next;
+      block->bin_next = NULL;
+      block->segment->num_free--;
+    }
+
+    block->allocated = true;
+    {
+      AllocatedShard& shard = get_allocated_shard(block->ptr);
+      std::lock_guard<std::mutex> shard_lock(shard.mutex);
+      shard.blocks[block->ptr] = block;
+    }
+
+    *devPtr = (void*)block->ptr;
+
+    increase_allocated(device, block->size);
+    return cudaSuccess;
+  }
+
+  cudaError_t binned_free(Block* block)
+  {
+    block->allocated = false;
+    decrease_allocated(block->device, block->size);
+    if (!block->stream_uses.empty()) {
+      std::lock_guard<std::mutex> lock(mutex);
+      return insert_events(block);
+    }
+    return_binned_block(block);
+    return cudaSuccess;
+  }
+
+  /** adds a new segment of size class `cls` to the pool */
+  cudaError_t refill_binned_pool(BinnedPool* pool, int device, cudaStream_t stream, int cls)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // completed events may have returned blocks to the pool
+    cudaError_t err = process_events();
+    if (err != cudaSuccess) {
+      return err;
+    }
+    {
+      std::lock_guard<std::mutex> pool_lock(pool->mutex);
+      if (pool->free_lists[cls]) {
+        return cudaSuccess;
+      }
+    }
+
+    // carve the segment into as many blocks as fit in kSmallAlloc, but at
+    // least one, so that large classes do not waste most of a segment
+    size_t block_size = size_class_size(cls);
+    size_t num_blocks = std::max(kSmallAlloc / block_size, (size_t)1);
+    size_t segment_size = block_size * num_blocks;
+
+    void* ptr;
+    err = cuda_malloc_retry(device, &ptr, segment_size);
+    if (err != cudaSuccess) {
+      return err;
+    }
+    increase_cached(device, segment_size);
+
+    BinnedSegment* segment = new BinnedSegment();
+    segment->device = device;
+    segment->stream = stream;
+    segment->pool = pool;
+    segment->ptr = (char*)ptr;
+    segment->size = segment_size;
+    segment->size_class = cls;
+    segment->num_free = num_blocks;
+    segment->blocks.reserve(num_blocks);
+
+    std::lock_guard<std::mutex> pool_lock(pool->mutex);
+    for (size_t i = num_blocks; i-- > 0;) {
+      Block* block = new Block(device, stream, block_size, segment->ptr + i * block_size);
+      block->segment = segment;
+      block->bin_next = pool->free_lists[cls];
+      pool->free_lists[cls] = block;
+      segment->blocks.push_back(block);
+    }
+    pool->segments.push_back(segment);
+    return cudaSuccess;
+  }
+
+  /** moves a binned block back into its pool's free list */
+  void return_binned_block(Block* block)
+  {
+    THAssert(!block->allocated && block->event_count == 0);
+    BinnedSegment* segment = block->segment;
+    BinnedPool* pool = segment->pool;
+    std::lock_guard<std::mutex> pool_lock(pool->mutex);
+    block->bin_next = pool->free_lists[segment->size_class];
+    pool->free_lists[segment->size_class] = block;
+    segment->num_free++;
+  }
+
+  BinnedPool* get_binned_pool(int device, cudaStream_t stream)
+  {
+    // Pools are never destroyed, so the last pool used by this thread can be
+    // reused without taking pools_mutex.
+    static thread_local int cached_device = -1;
+    static thread_local cudaStream_t cached_stream = NULL;
+    static thread_local BinnedPool* cached_pool = NULL;
+    if (cached_pool && cached_device == device && cached_stream == stream) {
+      return cached_pool;
+    }
+
+    std::lock_guard<std::mutex> lock(pools_mutex);
+    BinnedPool*& pool = binned_pools[std::make_pair(device, stream)];
+    if (!pool) {
+      pool = new BinnedPool();
+    }
+    cached_device = device;
+    cached_stream = stream;
+    cached_pool = pool;
+    return pool;
+  }
+
+  /** returns the binned pools of a device; device -1 means all */
+  std::vector<BinnedPool*> get_binned_pools(int device)
+  {
+    std::vector<BinnedPool*> pools;
+    std::lock_guard<std::mutex> lock(pools_mutex);
+    for (auto& entry : binned_pools) {
+      if (device == -1 || entry.first.first == device) {
+        pools.push_back(entry.second);
+      }
+    }
+    return pools;
+  }
+
+  AllocatedShard& get_allocated_shard(void* ptr)
+  {
+    // blocks are at least kRoundSmall aligned, so drop the low bits
+    return binned_allocated[((uintptr_t)ptr / kRoundSmall) % kNumAllocatedShards];
+  }
+
+  /** removes and returns the allocated binned block at ptr, if any */
+  Block* take_binned_allocated_block(void* ptr)
+  {
+    AllocatedShard& shard = get_allocated_shard(ptr);
+    std::lock_guard<std::mutex> shard_lock(shard.mutex);
+    auto it = shard.blocks.find(ptr);
+    if (it == shard.blocks.end()) {
+      return NULL;
+    }
+    Block* block = it->second;
+    shard.blocks.erase(it);
+    return block;
+  }
+
+  /** frees binned segments with no allocated blocks; device -1 means all */
+  cudaError_t free_binned_segments(int device)
+  {
+    std::vector<BinnedPool*> pools = get_binned_pools(device);
+
+    std::lock_guard<std::mutex> free_lock(cuda_free_mutex);
+    for (BinnedPool* pool : pools) {
+      std::lock_guard<std::mutex> pool_lock(pool->mutex);
+      auto is_unused = [](BinnedSegment* segment) {
+        return segment->num_free == segment->blocks.size();
+      };
+      auto unused = std::partition(pool->segments.begin(), pool->segments.end(),
+          [&](BinnedSegment* segment) { return !is_unused(segment); });
+      if (unused == pool->segments.end()) {
+        continue;
+      }
+
+      // unlink the blocks of unused segments from the free lists
+      for (int cls = 0; cls < kNumSizeClasses; cls++) {
+        Block** link = &pool->free_lists[cls];
+        while (*link) {
+          if (is_unused((*link)->segment)) {
+            *link = (*link)->bin_next;
+          } else {
+            link = &(*link)->bin_next;
+          }
+        }
+      }
+
+      cudaError_t err = cudaSuccess;
+      for (auto it = unused; it != pool->segments.end(); ++it) {
+        BinnedSegment* segment = *it;
+        err = cudaFree((void*)segment->ptr);
+        if (err != cudaSuccess) {
+          break;
+        }
+        decrease_cached(segment->device, segment->size);
+        for (Block* block : segment->blocks) {
+          delete block;
+        }
+        delete segment;
+        *it = NULL;
+      }
+
+      // keep any segment whose cudaFree failed, relinking its blocks
+      auto failed = std::remove(unused, pool->segments.end(), (BinnedSegment*)NULL);
+      for (auto it = unused; it != failed; ++it) {
+        for (Block* block : (*it)->blocks) {
+          block->bin_next = pool->free_lists[(*it)->size_class];
+          pool->free_lists[(*it)->size_class] = block;
+        }
+      }
+      pool->segments.erase(failed, pool->segments.end());
+      if (err != cudaSuccess) {
+        return err;
+      }
+    }
+    return cudaSuccess;
+  }
+
+  void increase_allocated(int device, size_t delta) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    get_stats_for_device(device).increaseAllocated(delta);
+  }
+
+  void decrease_allocated(int device, size_t delta) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    get_stats_for_device(device).decreaseAllocated(delta);
+  }
+
+  void increase_cached(int device, size_t delta) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    get_stats_for_device(device).increaseCached(delta);
+  }
+
+  void decrease_cached(int device, size_t delta) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    get_stats_for_device(device).decreaseCached(delta);
+  }
+
   /** returns cached blocks to the system allocator */
   cudaError_t emptyCache()
   {
@@ -248,11 +747,27 @@ struct THCCachingAllocator
     if (err != cudaSuccess) {
       return err;
     }
+    if (binned) {
+      return free_binned_segments(-1);
+    }
     return cudaSuccess;
   }
 
   void* getBaseAllocation(void* ptr, size_t* outSize)
   {
+    if (binned) {
+      AllocatedShard& shard = get_allocated_shard(ptr);
+      std::lock_guard<std::mutex> shard_lock(shard.mutex);
+      auto it = shard.blocks.find(ptr);
+      if (it != shard.blocks.end()) {
+        BinnedSegment* segment = it->second->segment;
+        if (outSize) {
+          *outSize = segment->size;
+        }
+        return segment->ptr;
+      }
+    }
+
     std::lock_guard<std::mutex> lock(mutex);
     Block* block = find_allocated_block(ptr);
     if (!block) {
@@ -292,15 +807,86 @@ struct THCCachingAllocator
     std::lock_guard<std::mutex> lock(mutex);
     cacheInfoAux(large_blocks, dev_id, total, largest);
     cacheInfoAux(small_blocks, dev_id, total, largest);
+    if (binned) {
+      for (BinnedPool* pool : get_binned_pools(dev_id)) {
+        std::lock_guard<std::mutex> pool_lock(pool->mutex);
+        for (BinnedSegment* segment : pool->segments) {
+          size_t blocksize = size_class_size(segment->size_class);
+          *total += segment->num_free * blocksize;
+          if (segment->num_free > 0 && blocksize > *largest) {
+            *largest = blocksize;
+          }
+        }
+      }
+    }
+  }
+
+  // Accumulates fragmentation statistics of a device's blocks in a free list
+  void fragmentationInfoAux(FreeBlocks& blocks, int dev_id, THCCachingAllocatorFragmentation* info)
+  {
+    Block search_key(dev_id, 0, 0);
+    auto it = blocks.lower_bound(&search_key);
+    for (;it != blocks.end() && *it && (*it)->device == dev_id; ++it) {
+      Block* block = *it;
+      info->num_free_blocks++;
+      info->largest_free_block = std::max<uint64_t>(info->largest_free_block, block->size);
+      if (block->prev || block->next) {
+        // free blocks are merged eagerly, so a split free block always shares
+        // its segment with an allocated (or pending) block
+        info->inactive_split_bytes += block->size;
+      }
+    }
+  }
+
+  void fragmentationInfo(int dev_id, THCCachingAllocatorFragmentation* info)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    info->num_segments = get_stats(dev_id).num_segments;
+    info->num_free_blocks = 0;
+    info->largest_free_block = 0;
+    info->inactive_split_bytes = 0;
+    fragmentationInfoAux(large_blocks, dev_id, info);
+    fragmentationInfoAux(small_blocks, dev_id, info);
+    if (binned) {
+      for (BinnedPool* pool : get_binned_pools(dev_id)) {
+        std::lock_guard<std::mutex> pool_lock(pool->mutex);
+        for (BinnedSegment* segment : pool->segments) {
+          if (segment->num_free == 0) {
+            continue;
+          }
+          size_t blocksize = size_class_size(segment->size_class);
+          info->num_free_blocks += segment->num_free;
+          info->largest_free_block = std::max<uint64_t>(info->largest_free_block, blocksize);
+          if (segment->num_free < segment->blocks.size()) {
+            info->inactive_split_bytes += segment->num_free * blocksize;
+          }
+        }
+      }
+    }
   }
 
   void recordStream(void* ptr, THCStream* stream)
   {
+    if (binned) {
+      AllocatedShard& shard = get_allocated_shard(ptr);
+      std::lock_guard<std::mutex> shard_lock(shard.mutex);
+      auto it = shard.blocks.find(ptr);
+      if (it != shard.blocks.end()) {
+        record_stream_use(it->second, stream);
+        return;
+      }
+    }
+
     std::lock_guard<std::mutex> lock(mutex);
     Block* block = find_allocated_block(ptr);
     if (!block) {
       THError("invalid device pointer: %p", ptr);
     }
+    record_stream_use(block, stream);
+  }
+
+  void record_stream_use(Block* block, THCStream* stream)
+  {
     if (stream->stream == block->stream) {
       // ignore uses on the allocation stream, since those don't require any
       // special synchronization
@@ -314,6 +900,10 @@ struct THCCachingAllocator
   void free_block(Block* block)
   {
     THAssert(!block->allocated && block->event_count == 0);
+    if (block->segment) {
+      return_binned_block(block);
+      return;
+    }
     bool small = block->size <= kSmallAlloc;
     auto& free_blocks = small ? large_blocks : small_blocks;
     try_merge_blocks(block, block->prev, free_blocks);
@@ -375,6 +965,23 @@ struct THCCachingAllocator
     return cudaSuccess;
   }
 
+  cudaError_t cuda_malloc_while_capturing(int device, void** devPtr, size_t size)
+  {
+#if CUDA_VERSION >= 10010
+    // cudaMalloc isn't captured, but is refused in the stricter capture modes
+    cudaStreamCaptureMode mode = cudaStreamCaptureModeRelaxed;
+    cudaError_t err = cudaThreadExchangeStreamCaptureMode(&mode);
+    if (err != cudaSuccess) {
+      return err;
+    }
+    err = cudaMalloc(devPtr, size);
+    cudaThreadExchangeStreamCaptureMode(&mode);
+    return err;
+#else
+    return cudaMalloc(devPtr, size);
+#endif
+  }
+
   cudaError_t free_cached_blocks(int device)
   {
     // Free all non-split cached blocks on device
@@ -392,6 +999,12 @@ struct THCCachingAllocator
         small_blocks,
         small_blocks.lower_bound(&lower_bound),
         small_blocks.lower_bound(&upper_bound));
+    if (err != cudaSuccess) {
+      return err;
+    }
+    if (binned) {
+      err = free_binned_segments(device);
+    }
     return err;
   }
 
@@ -406,7 +1019,7 @@ struct THCCachingAllocator
         if (err != cudaSuccess) {
           return err;
         }
-        get_stats_for_device(block->device).decreaseCached(block->size);
+        decrease_cached(block->device, block->size);
         auto cur = it;
         ++it;
         blocks.erase(cur);
@@ -540,6 +1153,21 @@ THC_API void THCCachingAllocator_recordStream(void *ptr, THCStream* stream)
   caching_allocator.recordStream(ptr, stream);
 }
 
+THC_API int THCCachingAllocator_beginCapture(cudaStream_t stream)
+{
+  return caching_allocator.beginCapture(stream);
+}
+
+THC_API void THCCachingAllocator_endCapture(cudaStream_t stream)
+{
+  caching_allocator.endCapture(stream);
+}
+
+THC_API void THCCachingAllocator_releaseCapture(int id)
+{
+  THCudaCheck(caching_allocator.releaseCapture(id));
+}
+
 THC_API std::mutex* THCCachingAllocator_getCudaFreeMutex()
 {
   return &caching_allocator.cuda_free_mutex;
@@ -554,21 +1182,27 @@ static inline void assertValidDevice(int device) {
 THC_API uint64_t THCCachingAllocator_currentMemoryAllocated(int device)
 {
   assertValidDevice(device);
-  return caching_allocator.get_stats_for_device(device).amount_allocated;
+  return caching_allocator.get_stats(device).amount_allocated;
 }
 
 THC_API uint64_t THCCachingAllocator_maxMemoryAllocated(int device) {
   assertValidDevice(device);
-  return caching_allocator.get_stats_for_device(device).max_amount_allocated;
+  return caching_allocator.get_stats(device).max_amount_allocated;
 }
 
 THC_API uint64_t THCCachingAllocator_currentMemoryCached(int device)
 {
   assertValidDevice(device);
-  return caching_allocator.get_stats_for_device(device).amount_cached;
+  return caching_allocator.get_stats(device).amount_cached;
 }
 
 THC_API uint64_t THCCachingAllocator_maxMemoryCached(int device) {
   assertValidDevice(device);
-  return caching_allocator.get_stats_for_device(device).max_amount_cached;
+  return caching_allocator.get_stats(device).max_amount_cached;
+}
+
+THC_API void THCCachingAllocator_fragmentationInfo(int device, THCCachingAllocatorFragmentation* info)
+{
+  assertValidDevice(device);
+  caching_allocator.fragmentationInfo(device, info);
 }
@@ -8,6 +8,13 @@
 #include "THCGeneral.h"
 #include "THCStream.h"
 
+typedef struct THCCachingAllocatorFragmentation {
+  uint64_t num_segments;         /* segments obtained from cudaMalloc */
+  uint64_t num_free_blocks;      /* cached blocks not in use */
+  uint64_t largest_free_block;   /* size of the largest cached block in bytes */
+  uint64_t inactive_split_bytes; /* free bytes in segments that can't be released */
+} THCCachingAllocatorFragmentation;
+
 THC_API THCDeviceAllocator* THCCachingAllocator_get(void);
 THC_API void* THCCachingAllocator_getBaseAllocation(void *ptr, size_t *size);
 THC_API void THCCachingAllocator_recordStream(void *ptr, THCStream* stream);
@@ -15,6 +22,14 @@ THC_API uint64_t THCCachingAllocator_currentMemoryAllocated(int device);
 THC_API uint64_t THCCachingAllocator_maxMemoryAllocated(int device);
 THC_API uint64_t THCCachingAllocator_currentMemoryCached(int device);
 THC_API uint64_t THCCachingAllocator_maxMemoryCached(int device);
+THC_API void THCCachingAllocator_fragmentationInfo(int device, THCCachingAllocatorFragmentation* info);
+
+/* Blocks allocated on stream between beginCapture and endCapture, while it is
+   captured into a CUDA graph, aren't reused once freed until the id returned
+   by beginCapture is released. */
+THC_API int THCCachingAllocator_beginCapture(cudaStream_t stream);
+THC_API void THCCachingAllocator_endCapture(cudaStream_t stream);
+THC_API void THCCachingAllocator_releaseCapture(int id);
 
 #if (__cplusplus >= 201103L) || (defined(_MSC_VER) && defined(__cplusplus))
 THC_API std::mutex* THCCachingAllocator_getCudaFreeMutex();
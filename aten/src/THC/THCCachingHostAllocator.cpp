@@ -1,96 +1,174 @@
 #include "THCCachingHostAllocator.h"
 
 #include <cuda_runtime_api.h>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
 #include <deque>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <stdint.h>
+#include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 
 namespace {
 
 typedef std::shared_ptr<THCStream> THCStreamPtr;
 
-struct BlockSize
+const size_t kMinBlockSize = 4096;                // smallest size class
+const int    kNumSizeClasses = 1 + (64 - 12) * 4; // four classes per power of two
+
+// Requests are rounded up to one of kNumSizeClasses sizes: one page, then
+// four evenly spaced classes per power of two, so at most 25% is wasted.
+static int size_class(size_t size)
 {
-  size_t  size; // allocation size
-  void*   ptr;  // host memory pointer
+  if (size <= kMinBlockSize) {
+    return 0;
+  }
+  // find k such that 2^k < size <= 2^(k+1)
+  int k = 12;
+  while (k < 63 && ((size_t)2 << k) < size) {
+    k++;
+  }
+  size_t step = ((size_t)1 << k) / 4;
+  int sub = (int)((size - 1 - ((size_t)1 << k)) / step);
+  return 1 + (k - 12) * 4 + sub;
+}
 
-  BlockSize(size_t size, void* ptr=NULL) : size(size), ptr(ptr) {}
-};
+static size_t size_class_size(int cls)
+{
+  if (cls == 0) {
+    return kMinBlockSize;
+  }
+  int k = 12 + (cls - 1) / 4;
+  int sub = (cls - 1) % 4;
+  return ((size_t)1 << k) + (sub + 1) * (((size_t)1 << k) / 4);
+}
 
-struct Block : public BlockSize
+struct Block
 {
-  bool  allocated;    // true if the block is currently allocated
-  int   event_count;  // number of outstanding cuda events
+  size_t  size;         // allocation size (of the size class)
+  void*   ptr;          // host memory pointer
+  int     size_class;   // index of the size class
+  bool    allocated;    // true if the block is currently allocated
+  bool    in_arena;     // true if carved from a reserved arena
+  int     event_count;  // number of outstanding cuda events
   std::set<THCStreamPtr> streams;
 
-  Block(size_t size, void* ptr, bool allocated) :
-      BlockSize(size, ptr), allocated(allocated), event_count(0), streams() {}
+  Block(size_t size, void* ptr, int size_class, bool in_arena) :
+      size(size), ptr(ptr), size_class(size_class), allocated(true),
+      in_arena(in_arena), event_count(0), streams() {}
 };
 
-static bool BlockComparator(const BlockSize& a, const BlockSize& b)
-{
-  // sort by size, break ties with pointer
-  if (a.size != b.size) {
-    return a.size < b.size;
-  }
-  return (uintptr_t)a.ptr < (uintptr_t)b.ptr;
-}
-
 struct HostAllocator
 {
-  typedef bool (*Comparison)(const BlockSize&, const BlockSize&);
-
   // lock around all operations
   std::mutex mutex;
 
   // blocks by pointer
   std::unordered_map<void*, Block> blocks;
 
-  // pointers that are ready to be allocated (event_count=0)
-  std::set<BlockSize, Comparison> available;
+  // pointers that are ready to be allocated (event_count=0), by size class
+  std::vector<void*> available[kNumSizeClasses];
 
   // outstanding cuda events
   std::deque<std::pair<cudaEvent_t, void*>> cuda_events;
 
-  HostAllocator() : available(BlockComparator) {}
+  // reserved pinned arenas; blocks are carved from the last one
+  std::vector<std::pair<char*, size_t>> arenas;
+  size_t arena_offset;
+  bool arena_env_checked;
+
+  THCCachingHostAllocatorStats stats;
+
+  // background thread that waits on cuda_events and recycles their blocks
+  std::thread reclaimer;
+  std::condition_variable reclaim_cv;
+  bool reclaimer_stop;
+  bool reclaimer_failed;
+  bool reclaimer_waiting;   // reclaimer is blocked on the front event
+  int  empty_cache_pending; // emptyCache calls waiting for the reclaimer
+
+  HostAllocator() :
+      arena_offset(0), arena_env_checked(false), reclaimer_stop(false),
+      reclaimer_failed(false), reclaimer_waiting(false),
+      empty_cache_pending(0) {
+    memset(&stats, 0, sizeof(stats));
+  }
+
+  ~HostAllocator()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      reclaimer_stop = true;
+    }
+    reclaim_cv.notify_all();
+    if (reclaimer.joinable()) {
+      reclaimer.join();
+    }
+  }
 
   cudaError_t malloc(void** ptr, size_t size)
   {
     std::lock_guard<std::mutex> lock(mutex);
 
-    // process outstanding cuda events which may have occurred
-    cudaError_t err = processEvents();
-    if (err != cudaSuccess) {
-      return err;
+    if (!arena_env_checked) {
+      arena_env_checked = true;
+      const char* env = getenv("THC_CACHING_HOST_ALLOCATOR_ARENA_SIZE");
+      size_t mb = env ? strtoull(env, NULL, 10) : 0;
+      if (mb > 0) {
+        THCudaCheckWarn(reserveArena(mb * 1048576));
+      }
     }
 
-    // search for the smallest block which can hold this allocation
-    BlockSize search_key(size);
-    auto it = available.lower_bound(search_key);
-    if (it != available.end()) {
-      Block& block = blocks.at(it->ptr);
+    // note that cudaHostAlloc may not touch pointer if size is 0
+    *ptr = 0;
+    if (size == 0) {
+      return cudaSuccess;
+    }
+
+    int cls = size_class(size);
+    if (available[cls].empty() && !reclaimerRunning()) {
+      // process outstanding cuda events which may have occurred
+      cudaError_t err = processEvents();
+      if (err != cudaSuccess) {
+        return err;
+      }
+    }
+
+    if (!available[cls].empty()) {
+      Block& block = blocks.at(available[cls].back());
+      available[cls].pop_back();
       THAssert(!block.allocated && block.event_count == 0);
       block.allocated = true;
       *ptr = block.ptr;
-      available.erase(it);
+      stats.hits++;
+      stats.bytes_allocated += block.size;
       return cudaSuccess;
     }
 
-    // note that cudaHostAlloc may not touch pointer if size is 0
-    *ptr = 0;
-
-    // allocate a new block if no cached allocation is found
-    err = cudaHostAlloc(ptr, size, cudaHostAllocDefault);
-    if (err != cudaSuccess) {
-      return err;
+    // carve a new block from the arena, or allocate it if the arena is full
+    size_t block_size = size_class_size(cls);
+    bool in_arena = false;
+    if (!arenas.empty() && arenas.back().second - arena_offset >= block_size) {
+      *ptr = arenas.back().first + arena_offset;
+      arena_offset += block_size;
+      in_arena = true;
+    } else {
+      cudaError_t err = cudaHostAlloc(ptr, block_size, cudaHostAllocDefault);
+      if (err != cudaSuccess) {
+        return err;
+      }
+      stats.bytes_pinned += block_size;
     }
 
-    blocks.insert({*ptr, Block(size, *ptr, true)});
+    blocks.insert({*ptr, Block(block_size, *ptr, cls, in_arena)});
+    stats.misses++;
+    stats.bytes_allocated += block_size;
     return cudaSuccess;
   }
 
@@ -102,10 +180,13 @@ struct HostAllocator
       return cudaSuccess;
     }
 
-    // process outstanding cuda events which may have occurred
-    cudaError_t err = processEvents();
-    if (err != cudaSuccess) {
-      return err;
+    cudaError_t err;
+    if (!reclaimerRunning()) {
+      // process outstanding cuda events which may have occurred
+      err = processEvents();
+      if (err != cudaSuccess) {
+        return err;
+      }
     }
 
     auto it = blocks.find(ptr);
@@ -117,6 +198,7 @@ struct HostAllocator
     // free (on valid memory) shouldn't fail, so mark unallocated before
     // we process the streams.
     block.allocated = false;
+    stats.bytes_allocated -= block.size;
 
     // insert CUDA events for each stream on which this block was used. This
     err = insertEvents(block);
@@ -126,7 +208,10 @@ struct HostAllocator
 
     if (block.event_count == 0) {
       // the block can be re-used if there are no outstanding cuda events
-      available.insert(block);
+      available[block.size_class].push_back(block.ptr);
+    } else {
+      startReclaimer();
+      reclaim_cv.notify_all();
     }
     return cudaSuccess;
   }
@@ -176,43 +261,134 @@ struct HostAllocator
       Block& block = blocks.at(e.second);
       block.event_count--;
       if (block.event_count == 0 && !block.allocated) {
-        available.insert(block);
+        available[block.size_class].push_back(block.ptr);
       }
       cuda_events.pop_front();
     }
     return cudaSuccess;
   }
 
-  void emptyCache()
+  bool reclaimerRunning()
+  {
+    return reclaimer.joinable() && !reclaimer_failed;
+  }
+
+  void startReclaimer()
+  {
+    if (!reclaimer.joinable()) {
+      reclaimer = std::thread([this]() { reclaimLoop(); });
+    }
+  }
+
+  void reclaimLoop()
+  {
+    // Waits for the oldest outstanding event without holding the lock, so
+    // that blocks are recycled as soon as their copies complete instead of
+    // being polled for on the next allocation.
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      reclaim_cv.wait(lock, [this]() {
+        return reclaimer_stop || (!cuda_events.empty() && empty_cache_pending == 0);
+      });
+      if (reclaimer_stop) {
+        return;
+      }
+
+      cudaEvent_t event = cuda_events.front().first;
+      reclaimer_waiting = true;
+      lock.unlock();
+      cudaError_t err = cudaEventSynchronize(event);
+      lock.lock();
+      reclaimer_waiting = false;
+      reclaim_cv.notify_all();
+
+      if (err == cudaSuccess) {
+        err = processEvents();
+      }
+      if (err != cudaSuccess) {
+        // leave the events to be polled by malloc and free
+        cudaGetLastError();
+        reclaimer_failed = true;
+        return;
+      }
+    }
+  }
+
+  cudaError_t reserveArena(size_t size)
+  {
+    size = (size + kMinBlockSize - 1) / kMinBlockSize * kMinBlockSize;
+    void* ptr = 0;
+    cudaError_t err = cudaHostAlloc(&ptr, size, cudaHostAllocDefault);
+    if (err != cudaSuccess) {
+      return err;
+    }
+    // the unused tail of the previous arena is not carved any further
+    arenas.emplace_back((char*)ptr, size);
+    arena_offset = 0;
+    stats.bytes_pinned += size;
+    stats.arena_bytes += size;
+    return cudaSuccess;
+  }
+
+  cudaError_t reserve(size_t size)
   {
     std::lock_guard<std::mutex> lock(mutex);
+    return reserveArena(size);
+  }
+
+  void emptyCache()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // the reclaimer must not be waiting on an event we are about to destroy
+    empty_cache_pending++;
+    reclaim_cv.wait(lock, [this]() { return !reclaimer_waiting; });
+    empty_cache_pending--;
 
-    // remove events for freed blocks
+    // remove events for freed blocks that are about to be released; arena
+    // blocks stay cached, so their events must still complete
+    std::deque<std::pair<cudaEvent_t, void*>> arena_events;
     for (auto it = cuda_events.begin(); it != cuda_events.end(); ++it) {
       cudaEvent_t event = it->first;
       Block& block = blocks.at(it->second);
-      if (!block.allocated) {
+      if (block.in_arena) {
+        arena_events.push_back(*it);
+      } else if (!block.allocated) {
         THCudaCheckWarn(cudaEventDestroy(event));
         block.event_count--;
       }
     }
-
-    // all cuda_events have been processed
-    cuda_events.clear();
+    cuda_events.swap(arena_events);
 
     // clear list of available blocks
-    available.clear();
+    for (int cls = 0; cls < kNumSizeClasses; cls++) {
+      available[cls].clear();
+    }
 
     // free and erase non-allocated blocks
     for (auto it = blocks.begin(); it != blocks.end();) {
       Block& block = it->second;
-      if (!block.allocated) {
+      if (block.allocated) {
+        ++it;
+      } else if (block.in_arena) {
+        if (block.event_count == 0) {
+          available[block.size_class].push_back(block.ptr);
+        }
+        ++it;
+      } else {
         THCudaCheckWarn(cudaFreeHost(block.ptr));
+        stats.bytes_pinned -= block.size;
         it = blocks.erase(it);
-      } else {
-        ++it;
       }
     }
+
+    reclaim_cv.notify_all();
+  }
+
+  void getStats(THCCachingHostAllocatorStats* out)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    *out = stats;
   }
 
   cudaError_t insertEvents(Block& block)
@@ -273,6 +449,16 @@ void THCCachingHostAllocator_emptyCache()
   allocator.emptyCache();
 }
 
+cudaError_t THCCachingHostAllocator_reserve(size_t size)
+{
+  return allocator.reserve(size);
+}
+
+void THCCachingHostAllocator_getStats(THCCachingHostAllocatorStats* stats)
+{
+  allocator.getStats(stats);
+}
+
 THAllocator THCCachingHostAllocator = {
   &THCCachingHostAllocator_malloc,
   NULL,
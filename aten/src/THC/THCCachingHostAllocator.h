@@ -17,15 +17,37 @@
 // and tensors in THCTensor_(copyAsyncCPU) and THCTensor_(copyAsyncCuda).
 //
 // Note that this allocator does not split larger allocations into smaller
-// blocks, unlike the caching device allocator.
+// blocks, unlike the caching device allocator. Requests are rounded up to a
+// size class (four per power of two) and cached in one free list per class.
+//
+// Blocks are carved from a reserved pinned arena when one is available (see
+// THCCachingHostAllocator_reserve and THC_CACHING_HOST_ALLOCATOR_ARENA_SIZE,
+// in MiB), so cudaHostAlloc is only called once the arena is exhausted. A
+// background thread waits on the recorded events and returns blocks to their
+// free list as soon as the copies using them complete.
 //
 THC_API THAllocator THCCachingHostAllocator;
 
+typedef struct THCCachingHostAllocatorStats {
+  uint64_t hits;            /* allocations served from the cache */
+  uint64_t misses;          /* allocations that needed a new block */
+  uint64_t bytes_pinned;    /* total pinned memory held, including arenas */
+  uint64_t bytes_allocated; /* pinned memory currently handed out */
+  uint64_t arena_bytes;     /* pinned memory reserved as arenas */
+} THCCachingHostAllocatorStats;
+
 // Records an event in the specified stream. The allocation 'ptr' will not be
 // re-used until the event has occurred.
 THC_API cudaError_t THCCachingHostAllocator_recordEvent(void *ptr, THCStream *stream);
 
-// Releases cached pinned memory allocations via cudaHostFree
+// Releases cached pinned memory allocations via cudaHostFree. Reserved arenas
+// are kept.
 THC_API void THCCachingHostAllocator_emptyCache(void);
 
+// Reserves a pinned arena of 'size' bytes that new blocks are carved from.
+THC_API cudaError_t THCCachingHostAllocator_reserve(size_t size);
+
+// Copies the allocator's counters into 'stats'.
+THC_API void THCCachingHostAllocator_getStats(THCCachingHostAllocatorStats* stats);
+
 #endif
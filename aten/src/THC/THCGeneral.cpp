@@ -7,6 +7,7 @@
 #include "THCTensorRandom.h"
 #include <stdlib.h>
 #include <stdint.h>
+#include <mutex>
 
 /* Size of scratch space available in global memory per each SM + stream */
 #define MIN_GLOBAL_SCRATCH_SPACE_PER_SM_STREAM 4 * sizeof(float)
@@ -96,6 +97,7 @@ void THCudaInit(THCState* state)
   // should be cross-GPU leads to synchronization errors. The user can choose
   // to disable this functionality, however.
   state->p2pKernelAccessEnabled = 0;
+  state->deterministic = 0;
 
   // p2pAccessEnabled records if p2p copies are allowed between pairs of
   // devices. Values include "1" (copy allowed), "0" (copy not allowed), and
@@ -191,6 +193,8 @@ void THCudaShutdown(THCState* state)
       }
     }
 
+    THCStream_free(res->copyStream);
+
     free(res->streams);
     free(res->blasHandles);
     free(res->sparseHandles);
@@ -288,6 +292,14 @@ void THCState_setKernelPeerToPeerAccessEnabled(THCState* state, int val) {
   state->p2pKernelAccessEnabled = val;
 }
 
+int THCState_getDeterministic(THCState* state) {
+  return state->deterministic;
+}
+
+void THCState_setDeterministic(THCState* state, int val) {
+  state->deterministic = val;
+}
+
 struct cudaDeviceProp* THCState_getCurrentDeviceProperties(THCState* state)
 {
   int curDev = -1;
@@ -646,6 +658,24 @@ void THCState_setStream(THCState *state, THCStream *stream)
   THCState_setStreamOnDevice(state, device, stream);
 }
 
+THCStream* THCState_getCopyStream(THCState *state, int device)
+{
+  static std::mutex mutex;
+  if (device < 0 || device >= state->numDevices) {
+    THError("%d is not a device", device);
+  }
+  THCCudaResourcesPerDevice* res = THCState_getDeviceResourcePtr(state, device);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!res->copyStream) {
+    int prevDev = -1;
+    THCudaCheck(cudaGetDevice(&prevDev));
+    THCudaCheck(cudaSetDevice(device));
+    res->copyStream = THCStream_new(cudaStreamNonBlocking);
+    THCudaCheck(cudaSetDevice(prevDev));
+  }
+  return res->copyStream;
+}
+
 void THCState_setCurrentStreamIndex(THCState *state, int streamIndex)
 {
   if (streamIndex < 0 || streamIndex > state->numUserStreams) {
@@ -15,6 +15,16 @@
 // Threads per thread block
 #define THC_NONCONTIG_REDUCE_BLOCK_SIZE 32 * 16
 
+// Writes the reduced value of a slice to its point in `out`. Reductions
+// whose accumulator carries several values (e.g. the mean and M2 of
+// Welford's variance) pass their own op to compute the output from it.
+struct ReduceFinalizeConvert {
+  template <typename T, typename AccT>
+  inline __device__ void operator()(T* out, AccT r) const {
+    *out = ScalarConvert<AccT, T>::to(r);
+  }
+};
+
 template <typename IndexType>
 __device__ __forceinline__ IndexType getReduceNoncontigDimSliceIndex() {
   // Each thread handles one slice
@@ -25,6 +35,7 @@ __device__ __forceinline__ IndexType getReduceNoncontigDimSliceIndex() {
 template <typename ModifyOp,
           typename ReduceOp,
           typename ReduceAccOp,
+          typename FinalizeOp,
           typename T,
           typename AccT,
           typename IndexType,
@@ -41,7 +52,8 @@ kernelReduceNoncontigDim_shared(TensorInfo<T, IndexType> out,
                          AccT init,
                          ModifyOp modifyOp,
                          ReduceOp reduceOp,
-                         ReduceAccOp reduceAccOp) {
+                         ReduceAccOp reduceAccOp,
+                         FinalizeOp finalizeOp) {
 
   IndexType sliceIndex  = blockIdx.x * blockDim.x + threadIdx.x;
   IndexType sliceStride = gridDim.x * blockDim.x;
@@ -103,7 +115,7 @@ kernelReduceNoncontigDim_shared(TensorInfo<T, IndexType> out,
       dimy /= 2;
     }
     if(threadIdx.y == 0)
-      out.data[outOffset] = ScalarConvert<AccT, T>::to(*shmem);
+      finalizeOp(&out.data[outOffset], *shmem);
   }
 }
 
@@ -112,6 +124,7 @@ kernelReduceNoncontigDim_shared(TensorInfo<T, IndexType> out,
 template <typename ModifyOp,
           typename ReduceOp,
           typename ReduceAccOp,
+          typename FinalizeOp,
           typename T,
           typename AccT,
           typename IndexType,
@@ -128,7 +141,8 @@ kernelReduceNoncontigDim(TensorInfo<T, IndexType> out,
                          AccT init,
                          ModifyOp modifyOp,
                          ReduceOp reduceOp,
-                         ReduceAccOp reduceAccOp) {
+                         ReduceAccOp reduceAccOp,
+                         FinalizeOp finalizeOp) {
   const IndexType sliceIndex = getReduceNoncontigDimSliceIndex<IndexType>();
 
   if (sliceIndex >= totalSlices) {
@@ -152,7 +166,7 @@ kernelReduceNoncontigDim(TensorInfo<T, IndexType> out,
   }
 
   // Write out reduced value
-  out.data[outOffset] = ScalarConvert<AccT, T>::to(r);
+  finalizeOp(&out.data[outOffset], r);
 }
 
 template <typename IndexType>
@@ -166,6 +180,7 @@ __device__ __forceinline__ IndexType getReduceContigDimSliceIndex() {
 template <typename ModifyOp,
           typename ReduceOp,
           typename ReduceAccOp,
+          typename FinalizeOp,
           typename T,
           typename AccT,
           typename IndexType,
@@ -178,7 +193,8 @@ kernelReduceContigDim(TensorInfo<T, IndexType> out,
                       AccT init,
                       ModifyOp modifyOp,
                       ReduceOp reduceOp,
-                      ReduceAccOp reduceAccOp) {
+                      ReduceAccOp reduceAccOp,
+                      FinalizeOp finalizeOp) {
   const IndexType sliceIndex = getReduceContigDimSliceIndex<IndexType>();
 
   if (sliceIndex >= totalSlices) {
@@ -209,7 +225,7 @@ kernelReduceContigDim(TensorInfo<T, IndexType> out,
 
   if (threadIdx.x == 0) {
     // Write out reduced value
-    out.data[outOffset] = ScalarConvert<AccT, T>::to(r);
+    finalizeOp(&out.data[outOffset], r);
   }
 }
 
@@ -253,13 +269,14 @@ inline bool getContigReduceGrid(ptrdiff_t elements, dim3& grid) {
   return THC_getGridFromTiles(elements, grid);
 }
 
-// Performs a reduction out[..., 0, ...] = reduce_i(modify(in[..., i, ...])) for
-// all in where i and the out's 0 are indexed at dimension `dim`
-template <typename TensorType, 
-typename ModifyOp, 
-typename ReduceOp, 
-typename ReduceAccOp, 
-typename AccT>
+// Performs a reduction out[..., 0, ...] = finalize(reduce_i(modify(in[..., i, ...])))
+// for all in where i and the out's 0 are indexed at dimension `dim`
+template <typename TensorType,
+typename ModifyOp,
+typename ReduceOp,
+typename ReduceAccOp,
+typename AccT,
+typename FinalizeOp>
 bool THC_reduceDim(THCState* state,
                    TensorType* out,
                    TensorType* in,
@@ -267,6 +284,7 @@ bool THC_reduceDim(THCState* state,
                    const ReduceOp& reduceOp,
                    const ReduceAccOp& reduceAccOp,
                    AccT init,
+                   const FinalizeOp& finalizeOp,
                    int dim,
                    int keepdim) {
   ptrdiff_t inElements = TensorUtils<TensorType>::getNumElements(state, in);
@@ -348,31 +366,35 @@ bool THC_reduceDim(THCState* state,
   // index can be similarly collapsed. That is what this unrolling is for.
 #define HANDLE_CASE(TYPE, OUT, IN)                                      \
   if (contigReduction) {                                                \
-    kernelReduceContigDim<ModifyOp, ReduceOp, ReduceAccOp,              \
+    kernelReduceContigDim<ModifyOp, ReduceOp, ReduceAccOp, FinalizeOp,  \
                           typename TensorUtils<TensorType>::DataType,   \
                           AccT,                                         \
                           TYPE, OUT, IN>                                \
       <<<grid, block, smemSize, THCState_getCurrentStream(state)>>>(    \
         outInfo, inInfo, reductionSize,                                 \
-        (TYPE) outElements, init, modifyOp, reduceOp, reduceAccOp);     \
+        (TYPE) outElements, init, modifyOp, reduceOp, reduceAccOp,      \
+        finalizeOp);                                                    \
   } else {                                                              \
     if(block.y == 1){                                                   \
         kernelReduceNoncontigDim<ModifyOp, ReduceOp, ReduceAccOp,       \
+                           FinalizeOp,                                  \
                            typename TensorUtils<TensorType>::DataType,  \
                            AccT,                                        \
                            TYPE, OUT, IN>                               \
         <<<grid, block, 0, THCState_getCurrentStream(state)>>>(         \
                        outInfo, inInfo, reductionStride, reductionSize, \
-        (TYPE) outElements, init, modifyOp, reduceOp, reduceAccOp);     \
+        (TYPE) outElements, init, modifyOp, reduceOp, reduceAccOp,      \
+        finalizeOp);                                                    \
     }else{                                                              \
         kernelReduceNoncontigDim_shared<ModifyOp, ReduceOp,ReduceAccOp, \
+                           FinalizeOp,                                  \
                            typename TensorUtils<TensorType>::DataType,  \
                            AccT,                                        \
                            TYPE, OUT, IN>                               \
         <<<grid, block, 0, THCState_getCurrentStream(state)>>>(         \
                        outInfo, inInfo, reductionStride, reductionSize, \
                        (TYPE) outElements, init, modifyOp, reduceOp,    \
-                       reduceAccOp);                                    \
+                       reduceAccOp, finalizeOp);                        \
     }                                                                   \
   }                                                                     \
 
@@ -459,6 +481,26 @@ bool THC_reduceDim(THCState* state,
   return true;
 }
 
+// Performs a reduction out[..., 0, ...] = reduce_i(modify(in[..., i, ...])) for
+// all in where i and the out's 0 are indexed at dimension `dim`
+template <typename TensorType,
+typename ModifyOp,
+typename ReduceOp,
+typename ReduceAccOp,
+typename AccT>
+bool THC_reduceDim(THCState* state,
+                   TensorType* out,
+                   TensorType* in,
+                   const ModifyOp& modifyOp,
+                   const ReduceOp& reduceOp,
+                   const ReduceAccOp& reduceAccOp,
+                   AccT init,
+                   int dim,
+                   int keepdim) {
+  return THC_reduceDim(state, out, in, modifyOp, reduceOp, reduceAccOp, init,
+                       ReduceFinalizeConvert(), dim, keepdim);
+}
+
 #undef THC_NONCONTIG_REDUCE_BLOCK_SIZE
 
 #endif // THC_REDUCE_INC
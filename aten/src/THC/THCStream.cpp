@@ -1,12 +1,23 @@
 #include "THCStream.h"
 
+#include <atomic>
 #include <mutex>
 #include <cuda_runtime_api.h>
 #include "THAtomic.h"
 
 #define MAX_DEVICES 256
+#define STREAMS_PER_POOL 32
 static THCStream default_streams[MAX_DEVICES];
 
+// pool_streams[device][high_priority] are created on first use and never
+// destroyed
+struct THCStreamPool {
+  std::once_flag once;
+  THCStream* streams[STREAMS_PER_POOL];
+  std::atomic<unsigned> next;
+};
+static THCStreamPool pools[MAX_DEVICES][2];
+
 static void initialize_default_streams()
 {
   for (int i = 0; i < MAX_DEVICES; i++) {
@@ -41,6 +52,34 @@ THCStream* THCStream_newWithPriority(int flags, int priority)
   return self;
 }
 
+static void initialize_pool(int device, int high_priority)
+{
+  int prev_device;
+  THCudaCheck(cudaGetDevice(&prev_device));
+  THCudaCheck(cudaSetDevice(device));
+  // greater numbers are lower priorities, and 0 is the default
+  int least_priority, greatest_priority;
+  THCudaCheck(cudaDeviceGetStreamPriorityRange(&least_priority, &greatest_priority));
+  THCStreamPool& pool = pools[device][high_priority];
+  for (int i = 0; i < STREAMS_PER_POOL; i++) {
+    pool.streams[i] = THCStream_newWithPriority(
+        cudaStreamNonBlocking, high_priority ? greatest_priority : least_priority);
+  }
+  pool.next = 0;
+  THCudaCheck(cudaSetDevice(prev_device));
+}
+
+THCStream* THCStream_getPoolStream(int device, int high_priority)
+{
+  THAssert(device >= 0 && device < MAX_DEVICES);
+  high_priority = high_priority ? 1 : 0;
+  THCStreamPool& pool = pools[device][high_priority];
+  std::call_once(pool.once, &initialize_pool, device, high_priority);
+  THCStream* stream = pool.streams[pool.next++ % STREAMS_PER_POOL];
+  THCStream_retain(stream);
+  return stream;
+}
+
 void THCStream_free(THCStream* self)
 {
   if (!self || !self->stream) {
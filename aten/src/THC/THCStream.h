@@ -18,4 +18,13 @@ THC_API THCStream* THCStream_newWithPriority(int flags, int priority);
 THC_API void THCStream_free(THCStream* self);
 THC_API void THCStream_retain(THCStream* self);
 
+/* Returns one of the non-blocking streams of a per-device pool, in turn, so
+   that many users can share a few streams instead of creating their own.
+   The streams of the high priority pool have the greatest priority of the
+   device, those of the low priority pool the default (and lowest) one, so
+   kernels queued on the former run ahead of those pending on the latter.
+   The pool keeps a reference to its streams; the caller owns the returned
+   reference and releases it with THCStream_free. */
+THC_API THCStream* THCStream_getPoolStream(int device, int high_priority);
+
 #endif // THC_STREAM_INC
@@ -13,6 +13,7 @@
 #include "THCThrustAllocator.cuh"
 #include "THCTensorSort.cuh"
 #include <thrust/device_ptr.h>
+#include <thrust/sequence.h>
 #include <thrust/sort.h>
 #include <algorithm> // for std::min
 
@@ -199,6 +200,57 @@ __global__ void indexAddLargeIndex(TensorInfo<T, IndexType> dst,
   }
 }
 
+// The atomic-free variant of indexAddLargeIndex, for many duplicate
+// indices or a deterministic result. `sortedIndices` are the indices
+// after a stable sort, and `sortedPositions` the position in `src` of
+// each of them. The thread for the first index of a run of equal ones
+// sums the source slices of the whole run in order, and adds the sum to
+// the destination once.
+template <typename T, typename AccT, typename IndexType, int DstDim, int SrcDim>
+__global__ void indexAddSortedIndex(TensorInfo<T, IndexType> dst,
+                                    TensorInfo<T, IndexType> src,
+                                    const int64_t* sortedIndices,
+                                    const int64_t* sortedPositions,
+                                    int dstAddDim,
+                                    int srcAddDim,
+                                    IndexType totalSize,
+                                    IndexType innerSize,
+                                    IndexType numIndices,
+                                    int64_t dstAddDimSize) {
+  for (IndexType linearIndex = blockIdx.x * blockDim.x + threadIdx.x;
+       linearIndex < totalSize;
+       linearIndex += gridDim.x * blockDim.x) {
+    IndexType runStart = linearIndex / innerSize;
+    IndexType elementInSlice = linearIndex % innerSize;
+
+    int64_t index = sortedIndices[runStart];
+    if (runStart > 0 && sortedIndices[runStart - 1] == index) {
+      continue;
+    }
+    // Lua indices begin at 1
+    IndexType dstIndex = index - TH_INDEX_BASE;
+    assert(dstIndex < dstAddDimSize);
+
+    IndexType srcOffset =
+      IndexToOffset<T, IndexType, SrcDim>::get(elementInSlice, src);
+
+    AccT sum = ScalarConvert<int, AccT>::to(0);
+    for (IndexType i = runStart; i < numIndices && sortedIndices[i] == index; ++i) {
+      IndexType srcIndex = sortedPositions[i];
+      sum = THCNumerics<AccT>::add(
+        sum, ScalarConvert<T, AccT>::to(
+          src.data[srcOffset + srcIndex * src.strides[srcAddDim]]));
+    }
+
+    IndexType dstOffset =
+      IndexToOffset<T, IndexType, DstDim>::get(elementInSlice, dst);
+    dstOffset += dstIndex * dst.strides[dstAddDim];
+
+    dst.data[dstOffset] = ScalarConvert<AccT, T>::to(
+      THCNumerics<AccT>::add(ScalarConvert<T, AccT>::to(dst.data[dstOffset]), sum));
+  }
+}
+
 // We prefer this kernel to avoid reloading index points if the number
 // of indices is a small number.
 // This kernel in fact works for all choices of problem size, but if
@@ -2,12 +2,11 @@
 #include "THCTensorMath.h"
 #include "THCTensorCopy.h"
 #include "THCTensorMathMagma.cuh"
+#include "THCBlas.h"
 #include <algorithm>
 
 #ifdef USE_MAGMA
 #include <magma.h>
-#else
-#include "THCBlas.h"
 #endif
 
 #ifndef DIVUP
@@ -75,33 +75,6 @@ struct ReduceMultiply<half, float> {
 };
 #endif // CUDA_HALF_TENSOR
 
-template <typename ResT, typename ArgT>
-struct SquareFunctor {
-    SquareFunctor(ResT mean): mean_(mean) {}
-
-    inline __device__ ResT operator()(ArgT x) const {
-      return (((ResT) x) - mean_) * (((ResT) x) - mean_);
-    }
-
-    const ResT mean_;
-};
-
-#ifdef CUDA_HALF_TENSOR
-template <typename ResT>
-struct SquareFunctor<ResT, half> {
-    SquareFunctor(ResT mean): mean_(mean) {}
-
-    inline __device__ ResT operator()(half x) const {
-      return THCNumerics<ResT>::mul(
-        THCNumerics<ResT>::sub(mean_, ScalarConvert<half, ResT>::to(x)),
-        THCNumerics<ResT>::sub(mean_, ScalarConvert<half, ResT>::to(x))
-      );
-    }
-
-    const ResT mean_;
-};
-#endif // CUDA_HALF_TENSOR
-
 template <typename T>
 struct ReduceMin {
   inline __device__ T operator()(T a, T b) const {
@@ -130,54 +103,161 @@ struct LogicalAny {
   }
 };
 
-template<typename Real>
-__global__ void THCTensor_kernel_renorm(Real *data, const Real value, const ptrdiff_t size, const Real maxnorm)
-{
-  __shared__ Real buffer[32];
-  int64_t tx = threadIdx.x;
-  int64_t bx = blockIdx.x;
-  int64_t step = blockDim.x;
-  Real *row = data + size*bx;
-
-  buffer[tx] = ScalarConvert<int, Real>::to(0);
-
-  // get norm of axis
-  for (ptrdiff_t i=tx; i<size; i+=step)
-  {
-    buffer[tx] = THCNumerics<Real>::add(
-      buffer[tx],
-      THCNumerics<Real>::pow(
-        THCNumerics<Real>::abs(row[i]),
-        value)
-    );
+// The count, mean and sum of squared differences from the mean (M2) of a
+// set of values, accumulated in a single pass by Welford's algorithm. Two
+// sets are combined with
+//
+//    mean = mean_a + (mean_b - mean_a) * n_b / n
+//    M2 = M2_a + M2_b + (mean_b - mean_a)^2 * n_a * n_b / n
+template <typename Acc>
+struct WelfordData {
+  Acc mean;
+  Acc m2;
+  int64_t count;
+
+  static inline __host__ __device__ WelfordData<Acc> zero() {
+    WelfordData<Acc> r;
+    r.mean = ScalarConvert<int, Acc>::to(0);
+    r.m2 = ScalarConvert<int, Acc>::to(0);
+    r.count = 0;
+    return r;
   }
-  // add (reduce)
-  for (unsigned int stride = blockDim.x >> 1; stride > 0; stride >>= 1)
-  {
-    __syncthreads();
-    if (tx < stride)
-      buffer[tx] = THCNumerics<Real>::add(buffer[tx], buffer[tx+stride]);
-  }
-  // clip norms
-  __syncthreads();
-  Real norm = THCNumerics<Real>::pow(buffer[0], THCNumerics<Real>::cinv(value));
-  if (THCNumerics<Real>::gt(norm, maxnorm))
-  {
-    norm = THCNumerics<Real>::div(
-      maxnorm,
-      THCNumerics<Real>::add(
-        norm,
-        ScalarConvert<float, Real>::to(1e-7)
-      )
-    );
-    // renormalize
-    for (ptrdiff_t i=tx; i<size; i+=step)
-    {
-      row[i] = THCNumerics<Real>::mul(row[i], norm);
+};
+
+// Both the reduce and the reduce-acc op of a Welford reduction
+template <typename T, typename Acc>
+struct ReduceWelford {
+  inline __device__ WelfordData<Acc> operator()(WelfordData<Acc> a, T x) const {
+    Acc val = ScalarConvert<T, Acc>::to(x);
+    a.count += 1;
+    Acc delta = THCNumerics<Acc>::sub(val, a.mean);
+    a.mean = THCNumerics<Acc>::add(
+      a.mean, THCNumerics<Acc>::div(delta, ScalarConvert<int64_t, Acc>::to(a.count)));
+    a.m2 = THCNumerics<Acc>::add(
+      a.m2, THCNumerics<Acc>::mul(delta, THCNumerics<Acc>::sub(val, a.mean)));
+    return a;
+  }
+
+  inline __device__ WelfordData<Acc> operator()(WelfordData<Acc> a, WelfordData<Acc> b) const {
+    if (a.count == 0) {
+      return b;
+    }
+    if (b.count == 0) {
+      return a;
     }
+    WelfordData<Acc> r;
+    r.count = a.count + b.count;
+    Acc delta = THCNumerics<Acc>::sub(b.mean, a.mean);
+    Acc bFraction = THCNumerics<Acc>::div(ScalarConvert<int64_t, Acc>::to(b.count),
+                                          ScalarConvert<int64_t, Acc>::to(r.count));
+    r.mean = THCNumerics<Acc>::add(a.mean, THCNumerics<Acc>::mul(delta, bFraction));
+    r.m2 = THCNumerics<Acc>::add(
+      THCNumerics<Acc>::add(a.m2, b.m2),
+      THCNumerics<Acc>::mul(
+        THCNumerics<Acc>::mul(delta, delta),
+        THCNumerics<Acc>::mul(ScalarConvert<int64_t, Acc>::to(a.count), bFraction)));
+    return r;
   }
+};
+
+// The variance (or standard deviation) of a Welford accumulation; if biased
+// is set, normalize by the count instead of the count - 1
+template <typename Acc, bool apply_sqrt>
+inline __host__ __device__ Acc THCTensor_welfordVar(WelfordData<Acc> r, int biased) {
+  Acc var = THCNumerics<Acc>::div(
+    r.m2, ScalarConvert<int64_t, Acc>::to(r.count - (biased ? 0 : 1)));
+  return apply_sqrt ? THCNumerics<Acc>::sqrt(var) : var;
 }
 
+template <typename Acc, bool apply_sqrt>
+struct WelfordFinalizeVar {
+  WelfordFinalizeVar(int biased) : biased(biased) {}
+
+  template <typename T>
+  inline __device__ void operator()(T* out, WelfordData<Acc> r) const {
+    *out = ScalarConvert<Acc, T>::to(THCTensor_welfordVar<Acc, apply_sqrt>(r, biased));
+  }
+
+  const int biased;
+};
+
+// The minimum and maximum of a set of values, reduced in a single pass
+template <typename T>
+struct MinMaxData {
+  T min;
+  T max;
+
+  static inline __host__ __device__ MinMaxData<T> init() {
+    MinMaxData<T> r;
+    r.min = THCNumerics<T>::max();
+    r.max = THCNumerics<T>::min();
+    return r;
+  }
+};
+
+// Both the reduce and the reduce-acc op of a min/max reduction
+template <typename T>
+struct ReduceMinMax {
+  inline __device__ MinMaxData<T> operator()(MinMaxData<T> a, T x) const {
+    a.min = THCNumerics<T>::lt(x, a.min) ? x : a.min;
+    a.max = THCNumerics<T>::gt(x, a.max) ? x : a.max;
+    return a;
+  }
+
+  inline __device__ MinMaxData<T> operator()(MinMaxData<T> a, MinMaxData<T> b) const {
+    a.min = THCNumerics<T>::lt(b.min, a.min) ? b.min : a.min;
+    a.max = THCNumerics<T>::gt(b.max, a.max) ? b.max : a.max;
+    return a;
+  }
+};
+
+// Computes the p-norm of a slice from the sum of |x|^p, so that norm does
+// not take another pass over its output for the root
+template <typename Acc, int StaticExp>
+struct TensorNormFinalize {
+  TensorNormFinalize(Acc exp) : exponent(exp) {}
+
+  template <typename T>
+  inline __device__ void operator()(T* out, Acc r) const {
+    if (StaticExp == 2) {
+      *out = ScalarConvert<Acc, T>::to(THCNumerics<Acc>::sqrt(r));
+    } else {
+      *out = ScalarConvert<Acc, T>::to(
+        THCNumerics<Acc>::pow(r, THCNumerics<Acc>::cinv(exponent)));
+    }
+  }
+
+  const Acc exponent;
+};
+
+// Computes, from the sum of |x|^p of a slice, the factor that scales the
+// slice down to a p-norm of maxnorm, or 1 if its norm is within maxnorm
+template <typename Acc, int StaticExp>
+struct TensorRenormFinalize {
+  TensorRenormFinalize(Acc exp, Acc maxnorm) : exponent(exp), maxnorm(maxnorm) {}
+
+  template <typename T>
+  inline __device__ void operator()(T* out, Acc r) const {
+    Acc norm;
+    if (StaticExp == 1) {
+      norm = r;
+    } else if (StaticExp == 2) {
+      norm = THCNumerics<Acc>::sqrt(r);
+    } else {
+      norm = THCNumerics<Acc>::pow(r, THCNumerics<Acc>::cinv(exponent));
+    }
+    Acc factor = ScalarConvert<int, Acc>::to(1);
+    if (THCNumerics<Acc>::gt(norm, maxnorm)) {
+      factor = THCNumerics<Acc>::div(
+        maxnorm, THCNumerics<Acc>::add(norm, ScalarConvert<float, Acc>::to(1e-7)));
+    }
+    *out = ScalarConvert<Acc, T>::to(factor);
+  }
+
+  const Acc exponent;
+  const Acc maxnorm;
+};
+
 template <typename T>
 struct TensorNonZeroOp
 {
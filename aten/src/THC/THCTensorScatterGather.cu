@@ -2,6 +2,8 @@
 #include "THCGeneral.h"
 #include "THCAtomics.cuh"
 #include "THCApply.cuh"
+#include "THCNumerics.cuh"
+#include "THCTensorSort.cuh"
 
 // Compute the offsets into the given tensors for a linear index. For the 't2'
 // tensor, dimension 'dim' is skipped. The tensors are assumed to have the same
@@ -155,6 +157,65 @@ __global__ void THCudaTensor_scatterAddKernel(
   }
 }
 
+// The atomic-free variant of scatterAdd, for many duplicate indices or a
+// deterministic result. `sortedIndex` is `index` made contiguous with each
+// line along `dim` sorted, and `sortedPosition` holds the position along
+// `dim` in `src` of each of its elements. The thread for the first element
+// of a run of equal indices in a line sums the sources of the whole run in
+// order, and adds the sum to the destination once.
+template <typename IndexType, typename Real, typename AccReal, int Dims>
+__global__ void THCudaTensor_scatterAddSortedKernel(
+    TensorInfo<Real, IndexType> tensor,
+    TensorInfo<Real, IndexType> src,
+    TensorInfo<int64_t, IndexType> sortedIndex,
+    const int64_t* sortedPosition,
+    const int dim,
+    const IndexType totalElements) {
+  const IndexType lineStride = sortedIndex.strides[dim];
+  const IndexType lineSize = sortedIndex.sizes[dim];
+
+  for (IndexType linearId = blockIdx.x * blockDim.x + threadIdx.x;
+       linearId < totalElements;
+       linearId += gridDim.x * blockDim.x) {
+    // `sortedIndex` is contiguous, so that linearId is also its offset
+    int64_t indexValue = sortedIndex.data[linearId];
+    IndexType runStart = (linearId / lineStride) % lineSize;
+    if (runStart > 0 && sortedIndex.data[linearId - lineStride] == indexValue) {
+      continue;
+    }
+
+    IndexType tensorOffset = 0;
+    IndexType srcOffset = 0;
+    IndexType indexOffset = 0;
+    IndexToScatterGatherOffsets<IndexType, Real, Dims>::compute(linearId, dim,
+                                                          sortedIndex, &indexOffset,
+                                                          tensor, &tensorOffset);
+    indexOffset = 0;
+    IndexToScatterGatherOffsets<IndexType, Real, Dims>::compute(linearId, dim,
+                                                          sortedIndex, &indexOffset,
+                                                          src, &srcOffset);
+
+    AccReal sum = ScalarConvert<int, AccReal>::to(0);
+    IndexType offset = linearId;
+    for (IndexType i = runStart;
+         i < lineSize && sortedIndex.data[offset] == indexValue;
+         ++i, offset += lineStride) {
+      int64_t position = sortedPosition[offset] - TH_INDEX_BASE;
+      sum = THCNumerics<AccReal>::add(
+        sum, ScalarConvert<Real, AccReal>::to(
+          src.data[srcOffset + position * src.strides[dim]]));
+    }
+
+    indexValue -= TH_INDEX_BASE;
+    assert(indexValue >= 0 && indexValue < tensor.sizes[dim]);
+    tensorOffset += indexValue * tensor.strides[dim];
+
+    tensor.data[tensorOffset] = ScalarConvert<AccReal, Real>::to(
+      THCNumerics<AccReal>::add(
+        ScalarConvert<Real, AccReal>::to(tensor.data[tensorOffset]), sum));
+  }
+}
+
 template <typename IndexType, typename Real, int Dims>
 __global__ void THCudaTensor_scatterFillKernel(
     TensorInfo<Real, IndexType> tensor,
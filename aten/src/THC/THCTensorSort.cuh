@@ -1,10 +1,15 @@
 #ifndef THC_TENSORSORT_CUH
 #define THC_TENSORSORT_CUH
 
+#include "THCAsmUtils.cuh"
+#include "THCDeviceUtils.cuh"
 #include "THCReduceApplyUtils.cuh"
+#include "THCScanUtils.cuh"
 #include "THCSortUtils.cuh"
 #include "THCTensorCopy.h"
 #include "THCTensorTypeUtils.cuh"
+// for the radix representation of the keys
+#include "THCTensorTopK.cuh"
 
 #include "THCThrustAllocator.cuh"
 #include <thrust/device_ptr.h>
@@ -80,6 +85,167 @@ struct GlobalIndexToPerSliceIndex {
   const int64_t sliceSize;
 };
 
+// Segmented radix sort: each block sorts one slice of `input` with a
+// least-significant-digit radix sort, over the radix representation of
+// the keys from TopKTypeConfig, in sizeof(K) * 8 / RADIX_SORT_BITS stable
+// counting passes. The first pass reads `input`, the last one writes the
+// sorted keys and their slice-relative indices to `keys` and `values`,
+// and the passes in between go through `keyScratch` and `indexScratch`,
+// which hold two buffers of numSlices * sliceSize elements each.
+// With HasValues, the indices that are sorted along with the keys are read
+// from `values` rather than generated, which sorts (key, index) pairs in
+// place. As a slice is only read in the first pass, `keys` may be `input`.
+#define RADIX_SORT_BITS 4
+#define RADIX_SORT_SIZE 16
+#define RADIX_SORT_THREADS 256
+
+template <typename K, typename IndexType, int Dim, bool Descending,
+          bool HasValues>
+__launch_bounds__(RADIX_SORT_THREADS)
+__global__ void
+radixSortSlices(TensorInfo<K, IndexType> input,
+                IndexType inputSliceStride,
+                TensorInfo<K, IndexType> keys,
+                IndexType keySliceStride,
+                TensorInfo<int64_t, IndexType> values,
+                IndexType valueSliceStride,
+                IndexType numSlices,
+                uint32_t sliceSize,
+                typename TopKTypeConfig<K>::RadixType* keyScratch,
+                uint32_t* indexScratch) {
+  typedef typename TopKTypeConfig<K>::RadixType RadixType;
+  const int kKeyBits = sizeof(K) * 8;
+  const int kWarps = RADIX_SORT_THREADS / 32;
+  // The radix types of the narrow types are wider than their keys
+  const RadixType keyMask = kKeyBits >= sizeof(RadixType) * 8 ?
+    ~RadixType(0) :
+    (RadixType(1) << (kKeyBits % (sizeof(RadixType) * 8))) - 1;
+
+  // The first element of each digit in the output of the pass, and
+  // then of each (digit, warp) in that of the current tile
+  __shared__ uint32_t digitStart[RADIX_SORT_SIZE];
+  __shared__ uint32_t warpStart[RADIX_SORT_SIZE][kWarps];
+
+  IndexType slice = getLinearBlockId<IndexType>();
+  if (slice >= numSlices) {
+    return;
+  }
+
+  const K* in =
+    &input.data[IndexToOffset<K, IndexType, Dim>::get(slice, input)];
+  K* outKeys =
+    &keys.data[IndexToOffset<K, IndexType, Dim>::get(slice, keys)];
+  int64_t* outValues =
+    &values.data[IndexToOffset<int64_t, IndexType, Dim>::get(slice, values)];
+
+  const uint64_t bufferSize = (uint64_t) numSlices * sliceSize;
+  const uint64_t sliceOffset = (uint64_t) slice * sliceSize;
+  RadixType* keyBuffers[2] = {keyScratch + sliceOffset,
+                              keyScratch + bufferSize + sliceOffset};
+  uint32_t* indexBuffers[2] = {indexScratch + sliceOffset,
+                               indexScratch + bufferSize + sliceOffset};
+
+  const int warp = threadIdx.x / 32;
+  const int numPasses = kKeyBits / RADIX_SORT_BITS;
+  for (int pass = 0; pass < numPasses; ++pass) {
+    const int shift = pass * RADIX_SORT_BITS;
+    const bool first = pass == 0;
+    const bool last = pass == numPasses - 1;
+    const RadixType* srcKeys = keyBuffers[(pass + 1) % 2];
+    const uint32_t* srcIndices = indexBuffers[(pass + 1) % 2];
+    RadixType* dstKeys = keyBuffers[pass % 2];
+    uint32_t* dstIndices = indexBuffers[pass % 2];
+
+    // Count the keys of each digit over the slice
+    if (threadIdx.x < RADIX_SORT_SIZE) {
+      digitStart[threadIdx.x] = 0;
+    }
+    __syncthreads();
+
+    for (uint32_t i = threadIdx.x; i < sliceSize; i += blockDim.x) {
+      RadixType key;
+      if (first) {
+        key = TopKTypeConfig<K>::convert(in[i * inputSliceStride]) & keyMask;
+        key = Descending ? ~key & keyMask : key;
+      } else {
+        key = srcKeys[i];
+      }
+      atomicAdd(&digitStart[(key >> shift) & (RADIX_SORT_SIZE - 1)], 1);
+    }
+    __syncthreads();
+
+    if (threadIdx.x == 0) {
+      uint32_t sum = 0;
+      for (int d = 0; d < RADIX_SORT_SIZE; ++d) {
+        uint32_t count = digitStart[d];
+        digitStart[d] = sum;
+        sum += count;
+      }
+    }
+    __syncthreads();
+
+    // Scatter the slice a tile at a time; the keys of a digit keep
+    // their order within and across tiles, so that each pass is stable
+    for (uint32_t tile = 0; tile < sliceSize; tile += blockDim.x) {
+      const uint32_t i = tile + threadIdx.x;
+      const bool valid = i < sliceSize;
+      RadixType key = 0;
+      uint32_t index = 0;
+      if (valid) {
+        if (first) {
+          key = TopKTypeConfig<K>::convert(in[i * inputSliceStride]) & keyMask;
+          key = Descending ? ~key & keyMask : key;
+          index = HasValues ?
+            (uint32_t) (outValues[i * valueSliceStride] - TH_INDEX_BASE) : i;
+        } else {
+          key = srcKeys[i];
+          index = srcIndices[i];
+        }
+      }
+      const uint32_t digit =
+        valid ? (key >> shift) & (RADIX_SORT_SIZE - 1) : RADIX_SORT_SIZE;
+
+      // The rank of the key among those of its digit in the warp
+      uint32_t rank = 0;
+#pragma unroll
+      for (uint32_t d = 0; d < RADIX_SORT_SIZE; ++d) {
+        unsigned vote = WARP_BALLOT(digit == d);
+        if (digit == d) {
+          rank = __popc(vote & getLaneMaskLt());
+        }
+        if (getLaneId() == 0) {
+          warpStart[d][warp] = __popc(vote);
+        }
+      }
+      __syncthreads();
+
+      if (threadIdx.x < RADIX_SORT_SIZE) {
+        uint32_t sum = digitStart[threadIdx.x];
+        for (int w = 0; w < kWarps; ++w) {
+          uint32_t count = warpStart[threadIdx.x][w];
+          warpStart[threadIdx.x][w] = sum;
+          sum += count;
+        }
+        digitStart[threadIdx.x] = sum;
+      }
+      __syncthreads();
+
+      if (valid) {
+        const uint32_t dst = warpStart[digit][warp] + rank;
+        if (last) {
+          outKeys[dst * keySliceStride] = TopKTypeConfig<K>::deconvert(
+            Descending ? ~key & keyMask : key);
+          outValues[dst * valueSliceStride] = index + TH_INDEX_BASE;
+        } else {
+          dstKeys[dst] = key;
+          dstIndices[dst] = index;
+        }
+      }
+      __syncthreads();
+    }
+  }
+}
+
 void THCudaLongTensor_fillSliceWithIndex(THCState* state,
                                          THCudaLongTensor* t,
                                          int dim);
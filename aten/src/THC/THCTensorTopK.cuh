@@ -482,4 +482,170 @@ __global__ void gatherTopK(TensorInfo<T, IndexType> input,
 #undef RADIX_SIZE
 #undef RADIX_MASK
 
+// Multi-block radix selection, for slices too long and too few for one
+// block per slice to keep the device busy: the blocks of a slice count
+// the digits of its values together in countRadixMultiBlock, then
+// selectRadixDigit picks the digit of the k-th value, from the most to the
+// least significant digit, and gatherTopKMultiBlock writes the values that
+// rank before the k-th value and as many of those equal to it as needed.
+#define RADIX_SELECT_BITS 4 // digits are base-(2 ^ RADIX_SELECT_BITS)
+#define RADIX_SELECT_SIZE 16 // 2 ^ RADIX_SELECT_BITS
+
+template <typename RadixType>
+struct RadixSelectState {
+  // The digits of the k-th value found so far, and their mask
+  RadixType desired;
+  RadixType desiredMask;
+  // The number of values that rank before all those matching `desired`
+  unsigned int numBefore;
+  // The output positions taken so far by the gather
+  unsigned int numWrittenBefore;
+  unsigned int numWrittenEqual;
+  unsigned int counts[RADIX_SELECT_SIZE];
+};
+
+template <typename T, typename IndexType, int Dim>
+__global__ void
+countRadixMultiBlock(TensorInfo<T, IndexType> input,
+                     IndexType sliceSize,
+                     IndexType withinSliceStride,
+                     RadixSelectState<typename TopKTypeConfig<T>::RadixType>* states,
+                     int digitPos) {
+  typedef typename TopKTypeConfig<T>::RadixType RadixType;
+  __shared__ unsigned int counts[RADIX_SELECT_SIZE];
+
+  // One row of blocks per slice
+  IndexType slice = blockIdx.y;
+  RadixSelectState<RadixType>* state = &states[slice];
+  const RadixType desired = state->desired;
+  const RadixType desiredMask = state->desiredMask;
+  T* data = &input.data[IndexToOffset<T, IndexType, Dim>::get(slice, input)];
+
+  if (threadIdx.x < RADIX_SELECT_SIZE) {
+    counts[threadIdx.x] = 0;
+  }
+  __syncthreads();
+
+  for (IndexType i = blockIdx.x * blockDim.x + threadIdx.x; i < sliceSize;
+       i += gridDim.x * blockDim.x) {
+    RadixType v = TopKTypeConfig<T>::convert(doLdg(&data[i * withinSliceStride]));
+    if ((v & desiredMask) == desired) {
+      atomicAdd(&counts[Bitfield<RadixType>::getBitfield(
+                  v, digitPos, RADIX_SELECT_BITS)], 1);
+    }
+  }
+  __syncthreads();
+
+  if (threadIdx.x < RADIX_SELECT_SIZE && counts[threadIdx.x] > 0) {
+    atomicAdd(&state->counts[threadIdx.x], counts[threadIdx.x]);
+  }
+}
+
+// One thread per slice; also clears the counts for the next digit
+template <typename RadixType, bool Order>
+__global__ void
+selectRadixDigit(RadixSelectState<RadixType>* states,
+                 unsigned int numSlices,
+                 unsigned int k,
+                 int digitPos) {
+  unsigned int slice = blockIdx.x * blockDim.x + threadIdx.x;
+  if (slice >= numSlices) {
+    return;
+  }
+  RadixSelectState<RadixType>* state = &states[slice];
+
+  bool found = false;
+  for (int i = 0; i < RADIX_SELECT_SIZE; ++i) {
+    // Ascending or descending order of the digits
+    int digit = Order ? RADIX_SELECT_SIZE - 1 - i : i;
+    unsigned int count = state->counts[digit];
+    state->counts[digit] = 0;
+    if (found) {
+      continue;
+    }
+    if (count >= k - state->numBefore) {
+      state->desired = Bitfield<RadixType>::setBitfield(
+        state->desired, digit, digitPos, RADIX_SELECT_BITS);
+      state->desiredMask = Bitfield<RadixType>::setBitfield(
+        state->desiredMask, RADIX_SELECT_SIZE - 1, digitPos, RADIX_SELECT_BITS);
+      found = true;
+    } else {
+      state->numBefore += count;
+    }
+  }
+}
+
+// The output of a slice is unordered: each block appends to it in turn
+template <typename T, typename IndexType, int Dim, bool Order>
+__global__ void
+gatherTopKMultiBlock(TensorInfo<T, IndexType> input,
+                     IndexType inputSliceSize,
+                     IndexType outputSliceSize, // aka `k`
+                     IndexType inputWithinSliceStride,
+                     TensorInfo<T, IndexType> topK,
+                     IndexType topKWithinSliceStride,
+                     TensorInfo<int64_t, IndexType> indices,
+                     IndexType indicesWithinSliceStride,
+                     RadixSelectState<typename TopKTypeConfig<T>::RadixType>* states) {
+  typedef typename TopKTypeConfig<T>::RadixType RadixType;
+  __shared__ int smem[32]; // one per each warp, up to warp limit
+  __shared__ unsigned int writeIndexStart;
+
+  IndexType slice = blockIdx.y;
+  RadixSelectState<RadixType>* state = &states[slice];
+  // The k-th value, with all its digits
+  const RadixType desired = state->desired;
+  const RadixType desiredMask = state->desiredMask;
+  const IndexType numBefore = state->numBefore;
+
+  T* inputSliceStart =
+    &input.data[IndexToOffset<T, IndexType, Dim>::get(slice, input)];
+  T* topKSliceStart =
+    &topK.data[IndexToOffset<T, IndexType, Dim>::get(slice, topK)];
+  int64_t* indicesSliceStart =
+    &indices.data[IndexToOffset<int64_t, IndexType, Dim>::get(slice, indices)];
+
+  // All threads of a block participate in the loop and the prefix sums
+  IndexType stride = gridDim.x * blockDim.x;
+  IndexType numIterations = THCRoundUp(inputSliceSize, stride);
+  for (IndexType i = blockIdx.x * blockDim.x + threadIdx.x; i < numIterations;
+       i += stride) {
+    bool inRange = (i < inputSliceSize);
+    T v = inRange ?
+      doLdg(&inputSliceStart[i * inputWithinSliceStride]) :
+      ScalarConvert<int, T>::to(0);
+    RadixType key = TopKTypeConfig<T>::convert(v) & desiredMask;
+    bool isBefore = inRange && (Order ? key > desired : key < desired);
+    bool isEqual = inRange && key == desired;
+
+    int index;
+    int carry;
+    exclusiveBinaryPrefixScan<int, true>(smem, isBefore, &index, &carry, AddOp<int>());
+    if (threadIdx.x == 0) {
+      writeIndexStart = atomicAdd(&state->numWrittenBefore, carry);
+    }
+    __syncthreads();
+    if (isBefore) {
+      IndexType writeIndex = writeIndexStart + index;
+      topKSliceStart[writeIndex * topKWithinSliceStride] = v;
+      indicesSliceStart[writeIndex * indicesWithinSliceStride] =
+        i + TH_INDEX_BASE; // to Lua index
+    }
+    __syncthreads();
+
+    exclusiveBinaryPrefixScan<int, true>(smem, isEqual, &index, &carry, AddOp<int>());
+    if (threadIdx.x == 0) {
+      writeIndexStart = atomicAdd(&state->numWrittenEqual, carry);
+    }
+    __syncthreads();
+    if (isEqual && writeIndexStart + index < outputSliceSize - numBefore) {
+      IndexType writeIndex = numBefore + writeIndexStart + index;
+      topKSliceStart[writeIndex * topKWithinSliceStride] = v;
+      indicesSliceStart[writeIndex * indicesWithinSliceStride] =
+        i + TH_INDEX_BASE; // to Lua index
+    }
+    __syncthreads();
+  }
+}
+
 #endif // THC_TENSOR_TOPK_CUH
@@ -348,12 +348,47 @@ void THCTensor_(indexAdd)(THCState *state, THCTensor *dst, int dim, THCudaLongTe
       (IDX_IS_MAJOR) ? sliceSize : numIndices,                \
       dstAddDimSize);
 
+#define SORTED_INDEX(TENSOR_TYPE, TYPE, DST_DIM, SRC_DIM)           \
+  indexAddSortedIndex<TENSOR_TYPE, accreal, TYPE, DST_DIM, SRC_DIM> \
+    <<<largeIndexGrid, largeIndexBlock, 0, stream>>>(               \
+      dstInfo, srcInfo,                                             \
+      THCudaLongTensor_data(state, sortedIndices),                  \
+      THCudaLongTensor_data(state, sortedPositions),                \
+      dstAddDim, srcAddDim, srcTotalSize, sliceSize,                \
+      numIndices, dstAddDimSize);
+
   dim3 smallIndexGrid(std::min(THCCeilDiv(sliceSize, (ptrdiff_t)128), (ptrdiff_t)(mpc * 8)));
   dim3 smallIndexBlock(std::min(sliceSize, (ptrdiff_t)128));
 
   dim3 largeIndexGrid(std::min(THCCeilDiv(srcTotalSize, (ptrdiff_t)128), (ptrdiff_t)(mpc * 8)));
   dim3 largeIndexBlock(std::min(srcTotalSize, (ptrdiff_t)128));
 
+  // Sort the indices, so that each destination slice is written once
+  // without atomics, when the result has to be deterministic, or when the
+  // indices outnumber the destination slices so that the atomics on the
+  // same slices would contend.
+  bool sortIndices = numIndices > 0 &&
+    (THCState_getDeterministic(state) ||
+     (numIndices >= 2 * dstAddDimSize && sliceSize >= 32));
+
+  THCudaLongTensor *sortedIndices = NULL;
+  THCudaLongTensor *sortedPositions = NULL;
+  if (sortIndices) {
+    sortedIndices = THCudaLongTensor_newClone(state, indices);
+    sortedPositions = THCudaLongTensor_newWithSize1d(state, numIndices);
+
+    THCThrustAllocator thrustAlloc(state);
+    auto index_iter = thrust::device_ptr<int64_t>(THCudaLongTensor_data(state, sortedIndices));
+    auto position_iter = thrust::device_ptr<int64_t>(THCudaLongTensor_data(state, sortedPositions));
+    thrust::sequence(
+      thrust::cuda::par(thrustAlloc).on(stream),
+      position_iter, position_iter + numIndices);
+    thrust::stable_sort_by_key(
+      thrust::cuda::par(thrustAlloc).on(stream),
+      index_iter, index_iter + numIndices,
+      position_iter, ThrustLTOp<int64_t>());
+  }
+
   if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, dst) &&
       TensorUtils<THCTensor>::canUse32BitIndexMath(state, src) &&
       TensorUtils<THCudaLongTensor>::canUse32BitIndexMath(state, indices)) {
@@ -371,9 +406,19 @@ void THCTensor_(indexAdd)(THCState *state, THCTensor *dst, int dim, THCudaLongTe
       getTensorInfo<THCudaLongTensor, unsigned int>(state, indices);
     indicesInfo.collapseDims();
 
-    // A reasonable choice for when to have each thread iterate over
-    // indices to choose
-    if (numIndices <= 16) {
+    // Past the sorted indices, a reasonable choice for when to have each
+    // thread iterate over indices to choose
+    if (sortIndices) {
+      if (dstInfo.dims == 1 && srcInfo.dims == 1) {
+        SORTED_INDEX(real, unsigned int, 1, 1);
+      } else if (dstInfo.dims == 2 && srcInfo.dims == 2) {
+        SORTED_INDEX(real, unsigned int, 2, 2);
+      } else if (dstInfo.dims == 3 && srcInfo.dims == 3) {
+        SORTED_INDEX(real, unsigned int, 3, 3);
+      } else {
+        SORTED_INDEX(real, unsigned int, -1, -1);
+      }
+    } else if (numIndices <= 16) {
       if (dstInfo.dims == 1 && srcInfo.dims == 1 && indContig) {
         SMALL_INDEX(real, unsigned int, 1, 1, -2);
       } else if (dstInfo.dims == 2 && srcInfo.dims == 2 && indContig) {
@@ -419,11 +464,21 @@ void THCTensor_(indexAdd)(THCState *state, THCTensor *dst, int dim, THCudaLongTe
       getTensorInfo<THCudaLongTensor, uint64_t>(state, indices);
     indicesInfo.collapseDims();
 
-    LARGE_INDEX(real, uint64_t, -1, -1, -1, true);
+    if (sortIndices) {
+      SORTED_INDEX(real, uint64_t, -1, -1);
+    } else {
+      LARGE_INDEX(real, uint64_t, -1, -1, -1, true);
+    }
+  }
+
+  if (sortIndices) {
+    THCudaLongTensor_free(state, sortedIndices);
+    THCudaLongTensor_free(state, sortedPositions);
   }
 
 #undef SMALL_INDEX
 #undef LARGE_INDEX
+#undef SORTED_INDEX
 }
 
 void THCTensor_(indexFill_long)(THCState *state, THCTensor *dst, int dim, THLongTensor *indices, real val)
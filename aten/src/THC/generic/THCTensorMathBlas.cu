@@ -730,7 +730,42 @@ THC_API void THCTensor_(btrifact)(THCState *state, THCTensor *ra_, THCudaIntTens
 {
 #if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE)
   THAssert(THCTensor_(checkGPU)(state, 2, ra_, a));
-  THArgCheck(THCTensor_(nDimension)(state, a) == 3, 3, "expected 3D tensor");
+  int dim = THCTensor_(nDimension)(state, a);
+  THArgCheck(dim >= 3, 3, "expected a tensor with at least 3 dimensions");
+  if (dim > 3) {
+    // factorize the matrices as a 3D batch, then restore the leading dimensions
+    int64_t n = a->size[dim - 1];
+    int64_t num_batches = 1;
+    for (int d = 0; d < dim - 2; d++) {
+      num_batches *= a->size[d];
+    }
+    THCTensor *a_ = THCTensor_(newContiguous)(state, a);
+    THLongStorage *sizes = THLongStorage_newWithSize3(num_batches, a->size[dim - 2], n);
+    THCTensor *batch = THCTensor_(newView)(state, a_, sizes);
+    THCTensor *ra__ = THCTensor_(new)(state);
+    THCTensor_(btrifact)(state, ra__, rpivots_, rinfo_, pivot, batch);
+
+    THCTensor_(resizeAs)(state, ra_, a);
+    THCTensor_(copy)(state, ra_, ra__);
+    // pivots have the sizes of a without its last dimension, infos without
+    // the last two
+    THLongStorage_resize(sizes, dim - 1);
+    for (int d = 0; d < dim - 2; d++) {
+      THLongStorage_set(sizes, d, a->size[d]);
+    }
+    THLongStorage_set(sizes, dim - 2, n);
+    THCudaIntTensor_resize(state, rpivots_, sizes, NULL);
+    if (rinfo_) {
+      THLongStorage_resize(sizes, dim - 2);
+      THCudaIntTensor_resize(state, rinfo_, sizes, NULL);
+    }
+
+    THLongStorage_free(sizes);
+    THCTensor_(free)(state, ra__);
+    THCTensor_(free)(state, batch);
+    THCTensor_(free)(state, a_);
+    return;
+  }
   THArgCheck(THCTensor_(size)(state, a, 1) ==
              THCTensor_(size)(state, a, 2), 3, "matrices must be square");
 
@@ -813,8 +848,8 @@ THC_API void THCTensor_(btrifact)(THCState *state, THCTensor *ra_, THCudaIntTens
   }
 
   if (free_rinfo_) {
-    int min = THCudaIntTensor_minall(state, rinfo_);
-    int max = THCudaIntTensor_maxall(state, rinfo_);
+    int min, max;
+    THCudaIntTensor_minmaxall(state, rinfo_, &min, &max);
     THCudaIntTensor_free(state, rinfo_);
     if (min != 0 || max != 0) {
       THError("failed to factorize some batch elements (min info == %d, max info == %d)",
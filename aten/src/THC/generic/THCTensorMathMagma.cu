@@ -59,9 +59,276 @@ static THCTensor* THCTensor_(newColumnMajor)(THCState *state, THCTensor *self, T
   return self;
 }
 
+// Tensors with more than 2 dimensions are batches of matrices in their last
+// two dimensions, which are solved with a single call to the batched cuBLAS
+// or MAGMA routines instead of one launch per matrix.
+
+static int64_t THCTensor_(batchCount)(THCState *state, THCTensor *self)
+{
+  int64_t count = 1;
+  for (int d = 0; d < self->nDimension - 2; d++)
+    count *= self->size[d];
+  return count;
+}
+
+// A new tensor with the sizes of src, in which each matrix is column major
+// and matrix i starts i*rows*cols elements after the first one.
+static THCTensor* THCTensor_(newBatchColumnMajor)(THCState *state, THCTensor *src)
+{
+  int d = src->nDimension;
+  THCTensor *transposed = THCTensor_(newTranspose)(state, src, d - 2, d - 1);
+  THCTensor *result = THCTensor_(newClone)(state, transposed);
+  THCTensor_(free)(state, transposed);
+  THCTensor_(transpose)(state, result, NULL, d - 2, d - 1);
+  return result;
+}
+
+static void THCTensor_(checkBatchSizes)(THCState *state, THCTensor *b, THCTensor *a)
+{
+  int d = a->nDimension;
+  THArgCheck(b->nDimension == d, 1, "B should have %d dimensions, like A, but has %d",
+             d, b->nDimension);
+  for (int k = 0; k < d - 2; k++) {
+    THArgCheck(a->size[k] == b->size[k], 1, "A,B batch sizes incompatible - A has "
+               "size %ld in dimension %d, B has %ld", a->size[k], k, b->size[k]);
+  }
+  THArgCheck(a->size[d - 2] == a->size[d - 1], 2, "A should be a batch of square matrices");
+  THArgCheck(a->size[d - 2] == b->size[d - 2], 2, "A,B size incompatible");
+}
+
+__global__ void THCTensor_(createBatchLapackBuffer)(real **buffer, real *data,
+                                                    int64_t stride, int64_t num_batches)
+{
+  const int64_t idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (idx < num_batches) {
+    buffer[idx] = data + idx * stride;
+  }
+}
+
+// An array on the device with the address of each matrix of self, which has
+// to be freed with THCudaFree.
+static real** THCTensor_(newBatchPointers)(THCState *state, THCTensor *self)
+{
+  int64_t num_batches = THCTensor_(batchCount)(state, self);
+  int d = self->nDimension;
+  real **buffer;
+  THCudaCheck(THCudaMalloc(state, (void**)&buffer, num_batches * sizeof(real*)));
+
+  const int64_t block = 512;
+  const int64_t grid = (num_batches + block - 1) / block;
+  THCTensor_(createBatchLapackBuffer)<<<grid, block, 0, THCState_getCurrentStream(state)>>>(
+    buffer, THCTensor_(data)(state, self), self->size[d - 2] * self->size[d - 1], num_batches);
+  THCudaCheck(cudaGetLastError());
+  return buffer;
+}
+
+// Raises an error if info is not zero for every matrix of the batch
+static void THCTensor_(checkBatchInfo)(THCState *state, THCudaIntTensor *info, const char *func)
+{
+  int min, max;
+  THCudaIntTensor_minmaxall(state, info, &min, &max);
+  if (min < 0) {
+    THError("%s : Argument %d : illegal value", func, -min);
+  } else if (max > 0) {
+    THError("%s : failed for some batch elements (max info == %d)", func, max);
+  }
+}
+
+static void THCTensor_(getriBatched)(THCState *state, THCTensor *ra_, THCTensor *a)
+{
+  int d = a->nDimension;
+  THArgCheck(a->size[d - 2] == a->size[d - 1], 2, "A should be a batch of square matrices");
+
+  int n = a->size[d - 1];
+  int64_t num_batches = THCTensor_(batchCount)(state, a);
+
+  THCTensor *input = THCTensor_(newBatchColumnMajor)(state, a);
+  THCTensor *output = THCTensor_(newBatchColumnMajor)(state, a);
+  real **d_input = THCTensor_(newBatchPointers)(state, input);
+  real **d_output = THCTensor_(newBatchPointers)(state, output);
+
+  THCudaIntTensor *ipiv = THCudaIntTensor_newWithSize1d(state, num_batches * n);
+  THCudaIntTensor *info = THCudaIntTensor_newWithSize1d(state, num_batches);
+  int *ipiv_gpu = THCudaIntTensor_data(state, ipiv);
+  int *info_gpu = THCudaIntTensor_data(state, info);
+
+#if defined(THC_REAL_IS_FLOAT)
+  THCudaBlas_Sgetrf(state, n, d_input, n, ipiv_gpu, info_gpu, num_batches);
+#else
+  THCudaBlas_Dgetrf(state, n, d_input, n, ipiv_gpu, info_gpu, num_batches);
+#endif
+  THCTensor_(checkBatchInfo)(state, info, "CUBLAS getrf");
+
+#if defined(THC_REAL_IS_FLOAT)
+  THCudaBlas_Sgetri(state, n, (const real**)d_input, n, ipiv_gpu, d_output, n, info_gpu, num_batches);
+#else
+  THCudaBlas_Dgetri(state, n, (const real**)d_input, n, ipiv_gpu, d_output, n, info_gpu, num_batches);
+#endif
+  THCTensor_(checkBatchInfo)(state, info, "CUBLAS getri");
+
+  THCudaCheck(THCudaFree(state, d_input));
+  THCudaCheck(THCudaFree(state, d_output));
+  THCudaIntTensor_free(state, ipiv);
+  THCudaIntTensor_free(state, info);
+  THCTensor_(free)(state, input);
+
+  THCTensor_(resizeAs)(state, ra_, a);
+  THCTensor_(freeCopyTo)(state, output, ra_);
+}
+
+static void THCTensor_(gesvBatched)(THCState *state, THCTensor *rb_, THCTensor *ra_, THCTensor *b, THCTensor *a)
+{
+  THCTensor_(checkBatchSizes)(state, b, a);
+
+  int d = a->nDimension;
+  int n = a->size[d - 1];
+  int nrhs = b->size[d - 1];
+  int64_t num_batches = THCTensor_(batchCount)(state, a);
+
+  THCTensor *a_ = THCTensor_(newBatchColumnMajor)(state, a);
+  THCTensor *b_ = THCTensor_(newBatchColumnMajor)(state, b);
+  real **d_a = THCTensor_(newBatchPointers)(state, a_);
+  real **d_b = THCTensor_(newBatchPointers)(state, b_);
+
+  THCudaIntTensor *ipiv = THCudaIntTensor_newWithSize1d(state, num_batches * n);
+  THCudaIntTensor *info = THCudaIntTensor_newWithSize1d(state, num_batches);
+  int *ipiv_gpu = THCudaIntTensor_data(state, ipiv);
+
+#if defined(THC_REAL_IS_FLOAT)
+  THCudaBlas_Sgetrf(state, n, d_a, n, ipiv_gpu, THCudaIntTensor_data(state, info), num_batches);
+#else
+  THCudaBlas_Dgetrf(state, n, d_a, n, ipiv_gpu, THCudaIntTensor_data(state, info), num_batches);
+#endif
+  THCTensor_(checkBatchInfo)(state, info, "CUBLAS getrf");
+
+  int getrs_info;
+#if defined(THC_REAL_IS_FLOAT)
+  THCudaBlas_Sgetrs(state, 'n', n, nrhs, (const real**)d_a, n, ipiv_gpu, d_b, n, &getrs_info, num_batches);
+#else
+  THCudaBlas_Dgetrs(state, 'n', n, nrhs, (const real**)d_a, n, ipiv_gpu, d_b, n, &getrs_info, num_batches);
+#endif
+  if (getrs_info < 0)
+    THError("CUBLAS getrs : Argument %d : illegal value", -getrs_info);
+
+  THCudaCheck(THCudaFree(state, d_a));
+  THCudaCheck(THCudaFree(state, d_b));
+  THCudaIntTensor_free(state, ipiv);
+  THCudaIntTensor_free(state, info);
+
+  THCTensor_(resizeAs)(state, ra_, a);
+  THCTensor_(resizeAs)(state, rb_, b);
+  THCTensor_(freeCopyTo)(state, a_, ra_);
+  THCTensor_(freeCopyTo)(state, b_, rb_);
+}
+
+__global__ void THCTensor_(clearUpLoTriangleBatched)(real *data, int n, int64_t len, bool upper)
+{
+  for (int64_t idx = threadIdx.x + blockIdx.x * blockDim.x; idx < len;
+       idx += blockDim.x * gridDim.x) {
+    // column major
+    const int64_t e = idx % (n * n);
+    const int64_t r = e % n;
+    const int64_t c = e / n;
+    if (upper ? r > c : r < c) {
+      data[idx] = 0;
+    }
+  }
+}
+
+#ifdef MAGMA_V2
+static magma_queue_t THCTensor_(newMagmaQueue)(THCState *state)
+{
+  int device;
+  THCudaCheck(cudaGetDevice(&device));
+  magma_queue_t queue;
+  magma_queue_create_from_cuda(device, THCState_getCurrentStream(state),
+                               THCState_getCurrentBlasHandle(state), NULL, &queue);
+  return queue;
+}
+#endif
+
+static void THCTensor_(potrfBatched)(THCState *state, THCTensor *ra_, THCTensor *a, const char *uplo)
+{
+#ifdef MAGMA_V2
+  int d = a->nDimension;
+  THArgCheck(a->size[d - 2] == a->size[d - 1], 2, "A should be a batch of square matrices");
+
+  int n = a->size[d - 1];
+  int64_t num_batches = THCTensor_(batchCount)(state, a);
+  magma_uplo_t ul = uplo[0] == 'U' ?  MagmaUpper : MagmaLower;
+
+  THCTensor *input = THCTensor_(newBatchColumnMajor)(state, a);
+  real **d_input = THCTensor_(newBatchPointers)(state, input);
+  THCudaIntTensor *info = THCudaIntTensor_newWithSize1d(state, num_batches);
+
+  magma_queue_t queue = THCTensor_(newMagmaQueue)(state);
+#if defined(THC_REAL_IS_FLOAT)
+  magma_spotrf_batched(ul, n, d_input, n, THCudaIntTensor_data(state, info), num_batches, queue);
+#else
+  magma_dpotrf_batched(ul, n, d_input, n, THCudaIntTensor_data(state, info), num_batches, queue);
+#endif
+  magma_queue_destroy(queue);
+  THCudaCheck(THCudaFree(state, d_input));
+
+  THCTensor_(checkBatchInfo)(state, info, "MAGMA potrf");
+  THCudaIntTensor_free(state, info);
+
+  const int64_t len = THCTensor_(nElement)(state, input);
+  dim3 blocks(std::min(DIVUP(len, 128), (int64_t)65535));
+  dim3 threads(128);
+  THCTensor_(clearUpLoTriangleBatched)<<<blocks, threads, 0, THCState_getCurrentStream(state)>>>(
+    THCTensor_(data)(state, input), n, len, uplo[0] == 'U');
+  THCudaCheck(cudaGetLastError());
+
+  THCTensor_(resizeAs)(state, ra_, a);
+  THCTensor_(freeCopyTo)(state, input, ra_);
+#else
+  THError("batched potrf needs MAGMA 2 (http://icl.cs.utk.edu/magma/)");
+#endif
+}
+
+static void THCTensor_(potrsBatched)(THCState *state, THCTensor *rb_, THCTensor *b, THCTensor *a, const char *uplo)
+{
+#ifdef MAGMA_V2
+  THCTensor_(checkBatchSizes)(state, b, a);
+
+  int d = a->nDimension;
+  int n = a->size[d - 1];
+  int nrhs = b->size[d - 1];
+  int64_t num_batches = THCTensor_(batchCount)(state, a);
+  magma_uplo_t ul = uplo[0] == 'U' ?  MagmaUpper : MagmaLower;
+
+  THCTensor *a_ = THCTensor_(newBatchColumnMajor)(state, a);
+  THCTensor *b_ = THCTensor_(newBatchColumnMajor)(state, b);
+  real **d_a = THCTensor_(newBatchPointers)(state, a_);
+  real **d_b = THCTensor_(newBatchPointers)(state, b_);
+
+  magma_queue_t queue = THCTensor_(newMagmaQueue)(state);
+#if defined(THC_REAL_IS_FLOAT)
+  magma_spotrs_batched(ul, n, nrhs, d_a, n, d_b, n, num_batches, queue);
+#else
+  magma_dpotrs_batched(ul, n, nrhs, d_a, n, d_b, n, num_batches, queue);
+#endif
+  magma_queue_destroy(queue);
+
+  THCudaCheck(THCudaFree(state, d_a));
+  THCudaCheck(THCudaFree(state, d_b));
+  THCTensor_(free)(state, a_);
+
+  THCTensor_(resizeAs)(state, rb_, b);
+  THCTensor_(freeCopyTo)(state, b_, rb_);
+#else
+  THError("batched potrs needs MAGMA 2 (http://icl.cs.utk.edu/magma/)");
+#endif
+}
+
 
 THC_API void THCTensor_(gesv)(THCState *state, THCTensor *rb_, THCTensor *ra_, THCTensor *b_, THCTensor *a_)
 {
+  if (a_->nDimension > 2) {
+    THCTensor_(gesvBatched)(state, rb_, ra_, b_, a_);
+    return;
+  }
 #ifdef USE_MAGMA
   THArgCheck(a_->nDimension == 2, 1, "A should be 2 dimensional");
   THArgCheck(b_->nDimension == 2, 2, "b should be 2 dimensional");
@@ -347,6 +614,10 @@ THC_API void THCTensor_(gesvd2)(THCState *state, THCTensor *ru_, THCTensor *rs_,
 
 THC_API void THCTensor_(getri)(THCState *state, THCTensor *ra_, THCTensor *a)
 {
+  if (a->nDimension > 2) {
+    THCTensor_(getriBatched)(state, ra_, a);
+    return;
+  }
   THArgCheck(a->nDimension == 2, 2, "A should be 2 dimensional");
   THArgCheck(a->size[0] == a->size[1], 2, "A should be square");
 
@@ -518,6 +789,10 @@ THC_API void THCTensor_(potri)(THCState *state, THCTensor *ra_, THCTensor *a, co
 
 THC_API void THCTensor_(potrf)(THCState *state, THCTensor *ra_, THCTensor *a, const char *uplo)
 {
+  if (a->nDimension > 2) {
+    THCTensor_(potrfBatched)(state, ra_, a, uplo);
+    return;
+  }
 #ifdef USE_MAGMA
   THArgCheck(a->nDimension == 2, 2, "A should be 2 dimensional");
   THArgCheck(a->size[0] == a->size[1], 2, "A should be square");
@@ -554,6 +829,10 @@ THC_API void THCTensor_(potrf)(THCState *state, THCTensor *ra_, THCTensor *a, co
 
 THC_API void THCTensor_(potrs)(THCState *state, THCTensor *rb_, THCTensor *b, THCTensor *a, const char *uplo)
 {
+  if (a->nDimension > 2) {
+    THCTensor_(potrsBatched)(state, rb_, b, a, uplo);
+    return;
+  }
 #ifdef USE_MAGMA
   THArgCheck(a->size[0] == a->size[1], 2, "A should be square");
 
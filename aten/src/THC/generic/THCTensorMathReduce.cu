@@ -48,29 +48,59 @@ THC_API void
 THCTensor_(renorm)(THCState *state, THCTensor* self, THCTensor* src, real value, int dimension, real maxnorm)
 {
   THCAssertSameGPU(THCTensor_(checkGPU)(state, 2, self, src));
-  THCTensor *self_;
-  THCTensor *src_ = THCTensor_(newTranspose)(state, src, dimension, 0);
-  THCTensor *data = THCTensor_(newClone)(state, src_);
-  ptrdiff_t size = THCTensor_(nElement)(state, data)/data->size[0];
-
   THArgCheck(dimension >= 0 && dimension < THCTensor_(nDimension)(state, src), 3, "invalid dimension");
   THArgCheck(THCNumerics<real>::gt(value, ScalarConvert<int, real>::to(0)), 2, "non-positive-norm not supported");
   THArgCheck(THCTensor_(nDimension)(state, src) > 1, 1, "need at least 2 dimensions");
 
-  dim3 grid(data->size[0]);
-  dim3 threads(32);
-
-  THCTensor_kernel_renorm<real><<<grid, threads, 0, THCState_getCurrentStream(state)>>>(THCTensor_(data)(state, data), value, size, maxnorm);
-
-  cudaError errcode = cudaGetLastError();
-  if(errcode != cudaSuccess)
-    THError(cudaGetErrorString(errcode));
-
-  THCTensor_(free)(state, src_);
-  self_ = THCTensor_(newTranspose)(state, data, dimension, 0);
-  THCTensor_(resizeAs)(state, self, self_);
-  THCTensor_(freeCopyTo)(state, self_, self);
+  // The scale factor of each slice along `dimension` is reduced from a
+  // (slices, size) view of src, which is only copied if it is not
+  // contiguous with `dimension` outermost, and applied to src as it is
+  // written to self.
+  THCTensor *src_ = THCTensor_(newTranspose)(state, src, dimension, 0);
+  THCTensor *data = THCTensor_(newContiguous)(state, src_);
+  int64_t slices = data->size[0];
+  THLongStorage *rowsSize = THLongStorage_newWithSize2(slices, THCTensor_(nElement)(state, data) / slices);
+  THCTensor *rows = THCTensor_(newView)(state, data, rowsSize);
+  THLongStorage_free(rowsSize);
+
+  THCTensor *factor = THCTensor_(new)(state);
+  accreal init = ScalarConvert<int, accreal>::to(0);
+  accreal value_ = ScalarConvert<real, accreal>::to(value);
+  accreal maxnorm_ = ScalarConvert<real, accreal>::to(maxnorm);
+  bool ok;
+  if (THCNumerics<real>::eq(value, ScalarConvert<float, real>::to(1.0))) {
+    ok = THC_reduceDim(state, factor, rows,
+                       TensorNormOp<real, 1>(value), ReduceAdd<real, accreal>(), ReduceAdd<accreal, accreal>(),
+                       init, TensorRenormFinalize<accreal, 1>(value_, maxnorm_), 1, 1);
+  } else if (THCNumerics<real>::eq(value, ScalarConvert<float, real>::to(2.0))) {
+    ok = THC_reduceDim(state, factor, rows,
+                       TensorNormOp<real, 2>(value), ReduceAdd<real, accreal>(), ReduceAdd<accreal, accreal>(),
+                       init, TensorRenormFinalize<accreal, 2>(value_, maxnorm_), 1, 1);
+  } else {
+    ok = THC_reduceDim(state, factor, rows,
+                       TensorNormOp<real, -1>(value), ReduceAdd<real, accreal>(), ReduceAdd<accreal, accreal>(),
+                       init, TensorRenormFinalize<accreal, -1>(value_, maxnorm_), 1, 1);
+  }
+  THArgCheck(ok, 2, CUTORCH_DIM_WARNING);
+
+  // Broadcast the factors along the other dimensions of src
+  int nDim = THCTensor_(nDimension)(state, src);
+  THLongStorage *scaleSize = THCTensor_(newSizeOf)(state, src);
+  THLongStorage *scaleStride = THLongStorage_newWithSize(nDim);
+  THLongStorage_fill(scaleStride, 0);
+  THLongStorage_set(scaleStride, dimension, THCTensor_(stride)(state, factor, 0));
+  THCTensor *scale = THCTensor_(newWithStorage)(state, factor->storage, factor->storageOffset,
+                                                scaleSize, scaleStride);
+  THLongStorage_free(scaleSize);
+  THLongStorage_free(scaleStride);
+
+  THCTensor_(cmul)(state, self, src, scale);
+
+  THCTensor_(free)(state, scale);
+  THCTensor_(free)(state, factor);
+  THCTensor_(free)(state, rows);
   THCTensor_(free)(state, data);
+  THCTensor_(free)(state, src_);
 }
 
 THC_API void
@@ -78,6 +108,21 @@ THCTensor_(std)(THCState *state, THCTensor *self_, THCTensor *src, int dimension
 {
   THCAssertSameGPU(THCTensor_(checkGPU)(state, 2, self_, src));
 
+  if (!THCTensor_(isContiguous)(state, src)) {
+    // Reduce in place, instead of making the whole input contiguous first
+    if (!THC_reduceDim(state, self_, src,
+                       thrust::identity<real>(),
+                       ReduceWelford<real, accreal>(),
+                       ReduceWelford<real, accreal>(),
+                       WelfordData<accreal>::zero(),
+                       WelfordFinalizeVar<accreal, true>(biased),
+                       dimension, keepdim)) {
+      THArgCheck(false, 2, CUTORCH_DIM_WARNING);
+    }
+    THCudaCheck(cudaGetLastError());
+    return;
+  }
+
   TensorUtils<THCTensor>::preserveReduceDimSemantics(
       state, self_, THCTensor_(nDimension)(state, src), dimension, keepdim);
   THLongStorage *dim = THCTensor_(newSizeOf)(state, src);
@@ -107,6 +152,21 @@ THCTensor_(var)(THCState *state, THCTensor *self_, THCTensor *src, int dimension
 {
   THCAssertSameGPU(THCTensor_(checkGPU)(state, 2, self_, src));
 
+  if (!THCTensor_(isContiguous)(state, src)) {
+    // Reduce in place, instead of making the whole input contiguous first
+    if (!THC_reduceDim(state, self_, src,
+                       thrust::identity<real>(),
+                       ReduceWelford<real, accreal>(),
+                       ReduceWelford<real, accreal>(),
+                       WelfordData<accreal>::zero(),
+                       WelfordFinalizeVar<accreal, false>(biased),
+                       dimension, keepdim)) {
+      THArgCheck(false, 2, CUTORCH_DIM_WARNING);
+    }
+    THCudaCheck(cudaGetLastError());
+    return;
+  }
+
   TensorUtils<THCTensor>::preserveReduceDimSemantics(
       state, self_, THCTensor_(nDimension)(state, src), dimension, keepdim);
   THLongStorage *dim = THCTensor_(newSizeOf)(state, src);
@@ -142,25 +202,20 @@ THC_API accreal
 THCTensor_(varall)(THCState *state, THCTensor *self, int biased)
 {
   THCAssertSameGPU(THCTensor_(checkGPU)(state, 1, self));
-  accreal mean = THCTensor_(meanall)(state, self);
 
-  accreal val;
+  // The mean and M2 in a single pass
+  WelfordData<accreal> result;
   if (!THC_reduceAll(state, self,
-                     SquareFunctor<accreal, real>(mean),
-                     ReduceAdd<accreal, accreal>(),
-                     ReduceAdd<accreal, accreal>(),
-                     ScalarConvert<int, accreal>::to(0),
-                     &val, 0)) {
+                     thrust::identity<real>(),
+                     ReduceWelford<real, accreal>(),
+                     ReduceWelford<real, accreal>(),
+                     WelfordData<accreal>::zero(),
+                     &result, 0)) {
     THArgCheck(false, 1, CUTORCH_DIM_WARNING);
   }
 
-  val = THCNumerics<accreal>::div(
-    val,
-    ScalarConvert<ptrdiff_t, accreal>::to(THCTensor_(nElement)(state, self) - (biased ? 0 : 1))
-  );
-
   THCudaCheck(cudaGetLastError());
-  return val;
+  return THCTensor_welfordVar<accreal, false>(result, biased);
 }
 
 THC_API void
@@ -179,14 +234,16 @@ THCTensor_(norm)(THCState *state, THCTensor* self, THCTensor* src, real value, i
   } else if (THCNumerics<real>::eq(value, ScalarConvert<float, real>::to(2.0))) {
     THC_reduceDim(state, self, src,
                   TensorNormOp<real, 2>(value), ReduceAdd<real, accreal>(), ReduceAdd<accreal, accreal>(),
-                  ScalarConvert<float, accreal>::to(0.0), dimension, keepdim);
-    THCTensor_(pow)(state, self, self, ScalarConvert<float, real>::to(0.5));
+                  ScalarConvert<float, accreal>::to(0.0),
+                  TensorNormFinalize<accreal, 2>(ScalarConvert<real, accreal>::to(value)),
+                  dimension, keepdim);
 
   } else {
     THC_reduceDim(state, self, src,
                   TensorNormOp<real, -1>(value), ReduceAdd<real, accreal>(), ReduceAdd<accreal, accreal>(),
-                  ScalarConvert<float, accreal>::to(0.0), dimension, keepdim);
-    THCTensor_(pow)(state, self, self, THCNumerics<real>::cinv(value));
+                  ScalarConvert<float, accreal>::to(0.0),
+                  TensorNormFinalize<accreal, -1>(ScalarConvert<real, accreal>::to(value)),
+                  dimension, keepdim);
   }
 
   THCudaCheck(cudaGetLastError());
@@ -338,6 +395,23 @@ THCTensor_(maxall)(THCState *state, THCTensor *self) {
   return val;
 }
 
+THC_API void
+THCTensor_(minmaxall)(THCState *state, THCTensor *self, real *minValue, real *maxValue) {
+  THCAssertSameGPU(THCTensor_(checkGPU)(state, 1, self));
+  MinMaxData<real> val;
+  if (!THC_reduceAll(state, self,
+                     thrust::identity<real>(),
+                     ReduceMinMax<real>(),
+                     ReduceMinMax<real>(),
+                     MinMaxData<real>::init(), &val, 0)) {
+    THArgCheck(false, 1, CUTORCH_DIM_WARNING);
+  }
+
+  THCudaCheck(cudaGetLastError());
+  *minValue = val.min;
+  *maxValue = val.max;
+}
+
 THC_API real
 THCTensor_(medianall)(THCState *state, THCTensor *self) {
   THCAssertSameGPU(THCTensor_(checkGPU)(state, 1, self));
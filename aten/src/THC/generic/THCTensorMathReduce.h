@@ -34,6 +34,8 @@ THC_API void THCTensor_(max)(THCState *state,
 
 THC_API real THCTensor_(minall)(THCState *state, THCTensor *self);
 THC_API real THCTensor_(maxall)(THCState *state, THCTensor *self);
+/* The minimum and maximum of self, in a single pass */
+THC_API void THCTensor_(minmaxall)(THCState *state, THCTensor *self, real *minValue, real *maxValue);
 THC_API real THCTensor_(medianall)(THCState *state, THCTensor *self);
 
 THC_API void THCTensor_(median)(THCState *state,
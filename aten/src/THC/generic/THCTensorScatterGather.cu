@@ -185,9 +185,17 @@ void THCTensor_(scatter)(THCState* state, THCTensor *tensor, int dim, THCudaLong
 #undef RUN
 
 #define RUN(TYPE, DIMS, REAL)                                           \
-  THCudaTensor_scatterAddKernel<TYPE, REAL, DIMS>                               \
-  <<<grid, block, 0, THCState_getCurrentStream(state)>>>(               \
-    tensorInfo, srcInfo, indexInfo, dim, (TYPE)totalElements);
+  if (sortIndex) {                                                      \
+    THCudaTensor_scatterAddSortedKernel<TYPE, REAL, accreal, DIMS>      \
+    <<<grid, block, 0, THCState_getCurrentStream(state)>>>(             \
+      tensorInfo, srcInfo, indexInfo,                                   \
+      THCudaLongTensor_data(state, sortedPosition),                     \
+      dim, (TYPE)totalElements);                                        \
+  } else {                                                              \
+    THCudaTensor_scatterAddKernel<TYPE, REAL, DIMS>                     \
+    <<<grid, block, 0, THCState_getCurrentStream(state)>>>(             \
+      tensorInfo, srcInfo, indexInfo, dim, (TYPE)totalElements);        \
+  }
 
 void THCTensor_(scatterAdd)(THCState* state, THCTensor *tensor, int dim, THCudaLongTensor *index, THCTensor *src) {
   THCAssertSameGPU(THCTensor_(checkGPU)(state, 2, tensor, src));
@@ -225,6 +233,27 @@ void THCTensor_(scatterAdd)(THCState* state, THCTensor *tensor, int dim, THCudaL
     tensor = THCTensor_(newContiguous)(state, tensor);
   }
 
+  // Sort each line of the index along `dim`, so that each destination
+  // element is written once without atomics, when the result has to be
+  // deterministic, or when the lines have many duplicates and are short
+  // enough for a block to sort each of them.
+  const int64_t srcDimSize = THCTensor_(size)(state, src, dim);
+  const int64_t dstDimSize = THCTensor_(size)(state, tensor, dim);
+  const bool sortIndex = totalElements > 0 &&
+    (THCState_getDeterministic(state) ||
+     (srcDimSize >= 2 * dstDimSize && srcDimSize <= 1024));
+
+  THCudaLongTensor* sortedIndex = NULL;
+  THCudaLongTensor* sortedPosition = NULL;
+  if (sortIndex) {
+    sortedIndex = THCudaLongTensor_newClone(state, index);
+    sortedPosition = THCudaLongTensor_new(state);
+    THCudaLongTensor_resizeAs(state, sortedPosition, sortedIndex);
+    THCudaLongTensor_fillSliceWithIndex(state, sortedPosition, dim);
+    THCudaLongTensor_sortKeyValueInplace(state, sortedIndex, sortedPosition, dim, 0);
+    index = sortedIndex;
+  }
+
   if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, tensor) &&
       TensorUtils<THCTensor>::canUse32BitIndexMath(state, src) &&
       TensorUtils<THCudaLongTensor>::canUse32BitIndexMath(state, index)) {
@@ -261,6 +290,11 @@ void THCTensor_(scatterAdd)(THCState* state, THCTensor *tensor, int dim, THCudaL
     RUN(uint64_t, -1, real)
   }
 
+  if (sortIndex) {
+    THCudaLongTensor_free(state, sortedIndex);
+    THCudaLongTensor_free(state, sortedPosition);
+  }
+
   if (oldTensor) {
     TensorUtils<THCTensor>::copyIgnoringOverlaps(state, oldTensor, tensor);
     THCTensor_(free)(state, tensor);
@@ -2,6 +2,101 @@
 #define THC_GENERIC_FILE "generic/THCTensorSort.cu"
 #else
 
+// Sorts each slice of `input` along `dim` with one block, by a segmented
+// radix sort, into `sorted` and `indices` whatever their layout, without
+// copies nor transpositions: the only allocation is the scratch space of
+// the intermediate passes. With hasValues, `indices` holds the values to
+// permute along with the keys, rather than receiving the sorted positions.
+void sortViaRadix(THCState* state,
+                  THCTensor* sorted,
+                  THCudaLongTensor* indices,
+                  THCTensor* input,
+                  int dim, bool dir, bool hasValues) {
+  typedef typename TopKTypeConfig<real>::RadixType RadixType;
+
+  ptrdiff_t totalElements = THCTensor_(nElement)(state, input);
+  int64_t sliceSize = THCTensor_(size)(state, input, dim);
+  ptrdiff_t numSlices = totalElements / sliceSize;
+
+  dim3 grid;
+  if (!THC_getGridFromTiles(numSlices, grid)) {
+    THError("Slice to sort is too large");
+  }
+  dim3 block(RADIX_SORT_THREADS);
+
+  // Two buffers of keys and slice-relative indices
+  size_t bufferElements = 2 * (size_t) totalElements;
+  RadixType* keyScratch;
+  THCudaCheck(THCudaMalloc(state, (void**) &keyScratch,
+                           bufferElements * (sizeof(RadixType) + sizeof(uint32_t))));
+  uint32_t* indexScratch = (uint32_t*) (keyScratch + bufferElements);
+
+#define HANDLE_RADIX_KERNEL(TYPE, A, DIR, HAS_VALUES)                  \
+  radixSortSlices<real, TYPE, A, DIR, HAS_VALUES>                       \
+    <<<grid, block, 0, THCState_getCurrentStream(state)>>>(             \
+      inputInfo, (TYPE) inputInfo.strides[collapseInputDim],            \
+      sortedInfo, (TYPE) sortedInfo.strides[collapseSortedDim],         \
+      indicesInfo, (TYPE) indicesInfo.strides[collapseIndicesDim],      \
+      (TYPE) numSlices, (uint32_t) sliceSize,                           \
+      keyScratch, indexScratch)
+
+#define HANDLE_RADIX_CASE(TYPE, A)                                      \
+  do {                                                                  \
+    if (dir) {                                                          \
+      if (hasValues) {                                                  \
+        HANDLE_RADIX_KERNEL(TYPE, A, true, true);                       \
+      } else {                                                          \
+        HANDLE_RADIX_KERNEL(TYPE, A, true, false);                      \
+      }                                                                 \
+    } else {                                                            \
+      if (hasValues) {                                                  \
+        HANDLE_RADIX_KERNEL(TYPE, A, false, true);                      \
+      } else {                                                          \
+        HANDLE_RADIX_KERNEL(TYPE, A, false, false);                     \
+      }                                                                 \
+    }                                                                   \
+  } while (0)
+
+#define RUN_RADIX_SORT(TYPE)                                            \
+  do {                                                                  \
+    TensorInfo<real, TYPE> inputInfo =                                  \
+      getTensorInfo<THCTensor, TYPE>(state, input);                     \
+    inputInfo.reduceDim(dim);                                           \
+    int collapseInputDim = inputInfo.collapseDims(dim);                 \
+                                                                        \
+    TensorInfo<real, TYPE> sortedInfo =                                 \
+      getTensorInfo<THCTensor, TYPE>(state, sorted);                    \
+    sortedInfo.reduceDim(dim);                                          \
+    int collapseSortedDim = sortedInfo.collapseDims(dim);               \
+                                                                        \
+    TensorInfo<int64_t, TYPE> indicesInfo =                             \
+      getTensorInfo<THCudaLongTensor, TYPE>(state, indices);            \
+    indicesInfo.reduceDim(dim);                                         \
+    int collapseIndicesDim = indicesInfo.collapseDims(dim);             \
+                                                                        \
+    if (inputInfo.isContiguous() && sortedInfo.isContiguous() &&        \
+        indicesInfo.isContiguous()) {                                   \
+      HANDLE_RADIX_CASE(TYPE, -2);                                      \
+    } else {                                                            \
+      HANDLE_RADIX_CASE(TYPE, -1);                                      \
+    }                                                                   \
+  } while (0)
+
+  if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, input) &&
+      TensorUtils<THCTensor>::canUse32BitIndexMath(state, sorted) &&
+      TensorUtils<THCudaLongTensor>::canUse32BitIndexMath(state, indices)) {
+    RUN_RADIX_SORT(unsigned int);
+  } else {
+    RUN_RADIX_SORT(uint64_t);
+  }
+#undef HANDLE_RADIX_KERNEL
+#undef HANDLE_RADIX_CASE
+#undef RUN_RADIX_SORT
+
+  THCudaCheck(cudaGetLastError());
+  THCudaCheck(THCudaFree(state, keyScratch));
+}
+
 // In alignment with default sort on a c++ map, this function
 // will permute key and value tensors identically, and
 // in such a way that the 'key' tensor is ordered numerically
@@ -32,10 +127,17 @@ THC_API void THCTensor_(sortKeyValueInplace)(THCState* state,
   // size.
   int64_t ceilPowerOf2 = nextHighestPowerOf2(keySliceSize);
 
-  // FIXME: We'd have to find some other trick with Thrust to perform a
-  // vectorized (key, value) sort by slice segment
-  if (ceilPowerOf2 > 2048) {
-    THError("sortKeyValueInplace only works for sizes <= 2048 at present");
+  // Larger slices are sorted in place by the segmented radix sort, with
+  // the values read from `value` as they are permuted along
+#if CUDA_VERSION >= 8000 && (defined(THC_REAL_IS_DOUBLE) || defined(THC_REAL_IS_LONG))
+  const int64_t maxBitonicSliceSize = 1024;
+#else
+  const int64_t maxBitonicSliceSize = 2048;
+#endif
+  if (keySliceSize > maxBitonicSliceSize) {
+    THArgCheck(keySliceSize <= UINT32_MAX, 2, "slice to sort is too large");
+    sortViaRadix(state, key, value, key, dim, dir, true);
+    return;
   }
 
   // The grid is based on the number of independent slices that we
@@ -298,6 +400,13 @@ THC_API void THCTensor_(sort)(THCState* state,
 
   // How large are the slices that we are sorting?
   int64_t sliceSize = THCTensor_(size)(state, input, dim);
+  ptrdiff_t numSlices =
+    sliceSize > 0 ? THCTensor_(nElement)(state, input) / sliceSize : 0;
+  int numSMs = THCState_getCurrentDeviceProperties(state)->multiProcessorCount;
+  // Above this size, the radix sort of a slice by a single block is
+  // slower than the device-wide sort if there are too few slices to fill
+  // the device
+  const int64_t kMaxRadixSortSliceSize = 65536;
 
   // Workaround:
   // CUDA 8 uses more shared memory than 7.5 for bitonicSortKVInPlace,
@@ -324,9 +433,14 @@ THC_API void THCTensor_(sort)(THCState* state,
     // Sort using our in-place k/v kernel that supports arbitrary
     // layout
     THCTensor_(sortKeyValueInplace)(state, sorted, indices, dim, order);
+  } else if (sliceSize <= UINT32_MAX &&
+             (numSlices >= numSMs || sliceSize <= kMaxRadixSortSliceSize)) {
+    // Many slices, or slices small enough for a block to sort them
+    // quickly: sort each slice with its own block
+    sortViaRadix(state, sorted, indices, input, dim, (bool) order, false);
   } else {
-    // Otherwise, fall back upon Thrust, which handles all other cases
-    // (potentially slowly, with extra copies/memory allocations)
+    // Otherwise, fall back upon Thrust, which sorts a few large slices
+    // with the whole device (with extra copies/memory allocations)
     sortViaThrust(state, sorted, indices, input, dim, (bool) order);
   }
 
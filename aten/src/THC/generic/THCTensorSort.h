@@ -2,8 +2,9 @@
 #define THC_GENERIC_FILE "generic/THCTensorSort.h"
 #else
 
-/* Performs an in-place sort of (keys, values). Only works for slice sizes
-   <= 2048 at the moment (slice size == size of keys/values dim `dim`) */
+/* Performs an in-place sort of (keys, values). Slices of up to 2048 elements
+   (slice size == size of keys/values dim `dim`) are sorted by a bitonic
+   network in shared memory, larger ones by the segmented radix sort */
 THC_API void THCTensor_(sortKeyValueInplace)(THCState* state,
                                              THCTensor* keys,
                                              THCudaLongTensor* values,
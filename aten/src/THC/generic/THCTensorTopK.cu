@@ -2,6 +2,90 @@
 #define THC_GENERIC_FILE "generic/THCTensorTopK.cu"
 #else
 
+// Top-k of a few long slices, with several blocks per slice; see
+// countRadixMultiBlock. The output of a slice is unordered.
+void topkMultiBlock(THCState* state,
+                    THCTensor *topK,
+                    THCudaLongTensor *indices,
+                    THCTensor *input,
+                    int64_t k, int dim, int dir) {
+  typedef typename TopKTypeConfig<real>::RadixType RadixType;
+
+  int64_t sliceSize = THCTensor_(size)(state, input, dim);
+  int64_t numSlices = THCTensor_(nElement)(state, input) / sliceSize;
+  int numSMs = THCState_getCurrentDeviceProperties(state)->multiProcessorCount;
+
+  // Enough blocks to fill the device, each with a few thousand values
+  const int kThreads = 512;
+  int64_t blocksPerSlice = std::min(
+    THCCeilDiv(sliceSize, (int64_t) kThreads * 8),
+    THCCeilDiv((int64_t) 4 * numSMs, numSlices));
+  dim3 grid(blocksPerSlice, numSlices);
+  dim3 block(kThreads);
+
+  size_t stateSize = numSlices * sizeof(RadixSelectState<RadixType>);
+  RadixSelectState<RadixType>* states;
+  THCudaCheck(THCudaMalloc(state, (void**) &states, stateSize));
+  THCudaCheck(cudaMemsetAsync(states, 0, stateSize, THCState_getCurrentStream(state)));
+
+#define RUN_SELECT(INDEX_T, DIR)                                        \
+  for (int digitPos = sizeof(real) * 8 - RADIX_SELECT_BITS;             \
+       digitPos >= 0;                                                   \
+       digitPos -= RADIX_SELECT_BITS) {                                 \
+    countRadixMultiBlock<real, INDEX_T, -1>                             \
+      <<<grid, block, 0, THCState_getCurrentStream(state)>>>(           \
+        inputInfo, sliceSize, inputInfo.strides[collapseInputDim],      \
+        states, digitPos);                                              \
+    selectRadixDigit<RadixType, DIR>                                    \
+      <<<THCCeilDiv(numSlices, (int64_t) 32), 32, 0,                    \
+         THCState_getCurrentStream(state)>>>(                           \
+        states, numSlices, k, digitPos);                                \
+  }                                                                     \
+  gatherTopKMultiBlock<real, INDEX_T, -1, DIR>                          \
+    <<<grid, block, 0, THCState_getCurrentStream(state)>>>(             \
+      inputInfo, sliceSize, k, inputInfo.strides[collapseInputDim],     \
+      topKInfo, topKInfo.strides[collapseTopKDim],                      \
+      indicesInfo, indicesInfo.strides[collapseIndicesDim],             \
+      states)
+
+#define RUN_T(INDEX_T)                                                  \
+  do {                                                                  \
+    TensorInfo<real, INDEX_T> inputInfo =                               \
+      getTensorInfo<THCTensor, INDEX_T>(state, input);                  \
+    TensorInfo<real, INDEX_T> topKInfo =                                \
+      getTensorInfo<THCTensor, INDEX_T>(state, topK);                   \
+    TensorInfo<int64_t, INDEX_T> indicesInfo =                          \
+      getTensorInfo<THCudaLongTensor, INDEX_T>(state, indices);         \
+                                                                        \
+    inputInfo.sizes[dim] = 1;                                           \
+    topKInfo.sizes[dim] = 1;                                            \
+    indicesInfo.sizes[dim] = 1;                                         \
+                                                                        \
+    int collapseInputDim = inputInfo.collapseDims(dim);                 \
+    int collapseTopKDim = topKInfo.collapseDims(dim);                   \
+    int collapseIndicesDim = indicesInfo.collapseDims(dim);             \
+                                                                        \
+    if (dir) {                                                          \
+      RUN_SELECT(INDEX_T, true);                                        \
+    } else {                                                            \
+      RUN_SELECT(INDEX_T, false);                                       \
+    }                                                                   \
+  } while (0)
+
+  if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, input) &&
+      TensorUtils<THCTensor>::canUse32BitIndexMath(state, topK) &&
+      TensorUtils<THCudaLongTensor>::canUse32BitIndexMath(state, indices)) {
+    RUN_T(uint32_t);
+  } else {
+    RUN_T(uint64_t);
+  }
+#undef RUN_T
+#undef RUN_SELECT
+
+  THCudaCheck(cudaGetLastError());
+  THCudaCheck(THCudaFree(state, states));
+}
+
 THC_API void THCTensor_(topk)(THCState* state,
                                THCTensor *topK,
                                THCudaLongTensor *indices,
@@ -28,6 +112,13 @@ THC_API void THCTensor_(topk)(THCState* state,
   THCudaLongTensor_resize(state, indices, topKSize, NULL);
   THLongStorage_free(topKSize);
 
+  // A few long slices are split between several blocks each, so as to
+  // fill the device
+  int64_t numSlices = THCTensor_(nElement)(state, input) / sliceSize;
+  int numSMs = THCState_getCurrentDeviceProperties(state)->multiProcessorCount;
+  bool multiBlock = sliceSize >= 16384 && sliceSize <= UINT32_MAX &&
+    numSlices < numSMs;
+
 #define RUN_K(INDEX_T, DIM, DIR)                                        \
   gatherTopK<real, INDEX_T, DIM, DIR>                                   \
     <<<grid, block, 0, THCState_getCurrentStream(state)>>>(             \
@@ -110,7 +201,9 @@ THC_API void THCTensor_(topk)(THCState* state,
 
   // Based on required index size, run the algorithm with the
   // appropriate index type
-  if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, input) &&
+  if (multiBlock) {
+    topkMultiBlock(state, topK, indices, input, k, dim, dir);
+  } else if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, input) &&
       TensorUtils<THCTensor>::canUse32BitIndexMath(state, topK) &&
       TensorUtils<THCudaLongTensor>::canUse32BitIndexMath(state, indices)) {
     RUN_T(uint32_t);
@@ -123,36 +216,11 @@ THC_API void THCTensor_(topk)(THCState* state,
 #undef RUN_K
 
   // Sort the results if the user wants them sorted, since our
-  // selection routine does not ensure sorting
+  // selection routine does not ensure sorting. This sorts the k values
+  // of each slice in place along with their indices, without allocating
+  // tensors (nor any memory for k <= 2048)
   if (sorted) {
-    // FIXME: the k/v inplace sort along slice only works for size <=
-    // 2048 at the moment
-    if (sliceSize <= 2048) {
-      // This avoids any memory allocations and performs all sorting
-      // work inplace along the slice
-      THCTensor_(sortKeyValueInplace)(state, topK, indices, dim, dir);
-    } else {
-      // Depend upon the backup sort that returns indices, which we
-      // can use in conjunction with gather to produce the original
-      // indices.
-      // This is not the most efficient implementation, especially since
-      // there are memory allocations performed here. If the user desires
-      // greater performance, they should torch.gather() the results
-      // themselves using the reported indices, providing previously
-      // allocated tensors to receive the results.
-      THCTensor* sortedTopK = THCTensor_(new)(state);
-      THCudaLongTensor* sortedIndices = THCudaLongTensor_new(state);
-      THCTensor_(sort)(state, sortedTopK, sortedIndices, topK, dim, dir);
-
-      THCudaLongTensor* sortedTopKIndices = THCudaLongTensor_new(state);
-
-      THCudaLongTensor_resizeAs(state, sortedTopKIndices, indices);
-      THCudaLongTensor_gather(state, sortedTopKIndices, indices, dim, sortedIndices);
-
-      THCTensor_(freeCopyTo)(state, sortedTopK, topK);
-      THCudaLongTensor_freeCopyTo(state, sortedTopKIndices, indices);
-      THCudaLongTensor_free(state, sortedIndices);
-    }
+    THCTensor_(sortKeyValueInplace)(state, topK, indices, dim, dir);
   }
 
   THCudaCheck(cudaGetLastError());
@@ -73,6 +73,7 @@ static void THCSTensor_(rawInit)(THCState *state, THCSTensor *self)
   self->nDimensionV = 0;
   self->coalesced = 0;
   self->nnz = 0;
+  self->csr = NULL;
   // self->flag = TH_TENSOR_REFCOUNTED;
   self->refcount = 1;
 }
@@ -86,6 +87,7 @@ THCSTensor* THCSTensor_(rawResize)(THCState *state, THCSTensor *self, int nDimI,
   }
   self->nDimensionI = nDimI;
   self->nDimensionV = nDimV;
+  THCSTensor_(_clearCSR)(state, self);
   return self;
 }
 
@@ -111,6 +113,7 @@ THCSTensor* THCSTensor_(_move)(THCState *state, THCSTensor *self, THCIndexTensor
   self->values = values;
   self->nnz = empty ? 0 : THCTensor_(size)(state, values, 0);
   self->coalesced = 0;
+  THCSTensor_(_clearCSR)(state, self);
 
   return self;
 }
@@ -120,6 +123,11 @@ THCSTensor* THCSTensor_(_set)(THCState *state, THCSTensor *self, THCIndexTensor
   return THCSTensor_(_move)(state, self, THCIndexTensor_(newClone)(state, indices), THCTensor_(newClone)(state, values));
 }
 
+void THCSTensor_(_clearCSR)(THCState *state, THCSTensor *self) {
+  THCudaIntTensor_free(state, self->csr);
+  self->csr = NULL;
+}
+
 /*** end helper methods ***/
 
 /* Empty init */
@@ -362,6 +370,7 @@ void THCSTensor_(free)(THCState *state, THCSTensor *self)
     THFree(self->size);
     THCIndexTensor_(free)(state, self->indices);
     THCTensor_(free)(state, self->values);
+    THCudaIntTensor_free(state, self->csr);
     THFree(self);
   }
 }
@@ -84,10 +84,16 @@ THCSTensor *THCSTensor_(newCoalesce)(THCState *state, THCSTensor *self) {
   THRUST_EXEC(thrust::copy, countIterI, countIterI + nnz, origIndicesIter);
   THRUST_EXEC(thrust::copy, countIterO, countIterO + nnz, uniqueOffsetsIter);
 
-  THRUST_EXEC(thrust::sort_by_key,
-    indicesIter, indicesIter + nnz,
-    origIndicesIter, ThrustLTOp<int64_t>()
-  );
+  // Without a comparator, Thrust sorts the int64 keys with a (stable) radix
+  // sort, which is much faster than the merge sort it uses otherwise. The
+  // indices of tensors that are appended to in order are often sorted
+  // already, and then the sort is skipped altogether.
+  if (!THRUST_EXEC(thrust::is_sorted, indicesIter, indicesIter + nnz)) {
+    THRUST_EXEC(thrust::sort_by_key,
+      indicesIter, indicesIter + nnz,
+      origIndicesIter
+    );
+  }
 
   // this forces device-host synchronization!
   thrust::pair<thrust_ptr, thrust_ptr> newEnd = THRUST_EXEC(
@@ -220,6 +226,7 @@ void THCSTensor_(transpose)(THCState *state, THCSTensor *self, int d1, int d2) {
   int64_t i = self->size[d1];
   self->size[d1] = self->size[d2];
   self->size[d2] = i;
+  THCSTensor_(_clearCSR)(state, self);
   THCIndexTensor_(free)(state, indices);
   THCIndexTensor_(free)(state, buffer);
   THCIndexTensor_(free)(state, slice1);
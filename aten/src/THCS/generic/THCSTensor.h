@@ -15,6 +15,9 @@ typedef struct THCSTensor
     THCTensor *values;
     // Some math operations can only be performed on ordered sparse tensors
     int coalesced;
+    // Row pointers in the int32 layout cuSPARSE takes, built on first use by
+    // THCSTensor_(newCSR) and dropped whenever the indices change
+    THCudaIntTensor *csr;
     int refcount;
 
 } THCSTensor;
@@ -28,6 +31,7 @@ TH_API ptrdiff_t THCSTensor_(nnz)(THCState *state, const THCSTensor *self);
 TH_API THLongStorage *THCSTensor_(newSizeOf)(THCState *state, THCSTensor *self);
 TH_API THCIndexTensor *THCSTensor_(newIndices)(THCState *state, const THCSTensor *self);
 TH_API THCTensor *THCSTensor_(newValues)(THCState *state, const THCSTensor *self);
+TH_API THCudaIntTensor *THCSTensor_(newCSR)(THCState *state, THCSTensor *self);
 
 /**** creation methods ****/
 TH_API THCSTensor *THCSTensor_(new)(THCState *state);
@@ -76,6 +80,7 @@ TH_API THCSTensor* THCSTensor_(rawResize)(THCState *state, THCSTensor *self, int
 TH_API THCTensor *THCSTensor_(newValuesWithSizeOf)(THCState *state, THCTensor *values, int64_t nnz);
 TH_API THCSTensor* THCSTensor_(_move)(THCState *state, THCSTensor *self, THCIndexTensor *indices, THCTensor *values);
 TH_API THCSTensor* THCSTensor_(_set)(THCState *state, THCSTensor *self, THCIndexTensor *indices, THCTensor *values);
+TH_API void THCSTensor_(_clearCSR)(THCState *state, THCSTensor *self);
 // forceClone is intended to use as a boolean
 TH_API THCIndexTensor* THCSTensor_(newFlattenedIndices)(THCState *state, THCSTensor *self, int forceClone);
 
@@ -23,6 +23,24 @@ THCudaIntTensor *THCSTensor_(toCSR)(THCState *state, THCIndexTensor *rowIndices,
   return csr;
 }
 
+THCudaIntTensor *THCSTensor_(newCSR)(THCState *state, THCSTensor *self) {
+  THArgCheck(self->coalesced, 1, "CSR row pointers need a coalesced tensor");
+  THArgCheck(self->nDimensionI >= 1, 1, "CSR row pointers need sparse dimensions");
+  if (!self->csr) {
+    THCIndexTensor *indices = THCSTensor_(newIndices)(state, self);
+    THCIndexTensor *rowIndices = THCIndexTensor_(newSelect)(state, indices, 0, 0);
+    THCudaIntTensor *csr = THCSTensor_(toCSR)(state, rowIndices, self->size[0], self->nnz);
+    THCIndexTensor_(free)(state, indices);
+    THCIndexTensor_(free)(state, rowIndices);
+    if (!THAtomicCompareAndSwapPtrdiff(
+            (ptrdiff_t volatile *)&self->csr, 0, (ptrdiff_t)csr)) {
+      THCudaIntTensor_free(state, csr);
+    }
+  }
+  THCudaIntTensor_retain(state, self->csr);
+  return self->csr;
+}
+
 void THCSTensor_(zero)(THCState *state, THCSTensor *self) {
   if (self->indices->nDimension) {
     THCIndexTensor_(resizeNd)(state, self->indices, 0, NULL, NULL);
@@ -31,6 +49,7 @@ void THCSTensor_(zero)(THCState *state, THCSTensor *self) {
     THCTensor_(resizeNd)(state, self->values, 0, NULL, NULL);
   }
   self->nnz = 0;
+  THCSTensor_(_clearCSR)(state, self);
 }
 
 void THCSTensor_(zeros)(THCState *state, THCSTensor *r_, THLongStorage *size)
@@ -88,9 +107,8 @@ void THCSTensor_(spaddmm)(THCState *state, THCTensor *r_, real beta, THCTensor *
   indices = THCSTensor_(newIndices)(state, sparse);
   values = THCSTensor_(newValues)(state, sparse);
 
-  THCIndexTensor *rowIndices = THCIndexTensor_(newSelect)(state, indices, 0, 0);
   THCIndexTensor *colIndices = THCIndexTensor_(newSelect)(state, indices, 0, 1);
-  csr = THCSTensor_(toCSR)(state, rowIndices, m, nnz);
+  csr = THCSTensor_(newCSR)(state, sparse);
   THCudaIntTensor *colIndicesInt = THCudaIntTensor_newWithSize1d(state, colIndices->size[0]);
   THCudaIntTensor_copyCudaLong(state, colIndicesInt, colIndices);
 
@@ -158,7 +176,6 @@ void THCSTensor_(spaddmm)(THCState *state, THCTensor *r_, real beta, THCTensor *
   THCudaIntTensor_free(state, colIndicesInt);
   THCudaIntTensor_free(state, csr);
   THCIndexTensor_(free)(state, indices);
-  THCIndexTensor_(free)(state, rowIndices);
   THCIndexTensor_(free)(state, colIndices);
   THCTensor_(free)(state, values);
   THCSTensor_(free)(state, sparse);
@@ -333,6 +350,7 @@ void THCSTensor_(mul)(THCState *state, THCSTensor *r_, THCSTensor *t, real value
     THCTensor_(mul)(state, r_values_, t_values_, value);
     r_->nnz = t->nnz;
     r_->coalesced = t->coalesced;
+    THCSTensor_(_clearCSR)(state, r_);
 
     THCIndexTensor_(free)(state, r_indices_);
     THCTensor_(free)(state, r_values_);
@@ -359,6 +377,7 @@ void THCSTensor_(div)(THCState *state, THCSTensor *r_, THCSTensor *t, real value
     THCTensor_(div)(state, r_values_, t_values_, value);
     r_->nnz = t->nnz;
     r_->coalesced = t->coalesced;
+    THCSTensor_(_clearCSR)(state, r_);
 
     THCIndexTensor_(free)(state, r_indices_);
     THCTensor_(free)(state, r_values_);
@@ -470,6 +489,7 @@ void THCSTensor_(cmul)(THCState *state, THCSTensor *r_, THCSTensor *t_, THCSTens
   r_->nnz = THCudaLongStorage_get(state, resultNnz, 0);
   THCudaLongStorage_free(state, resultNnz);
   r_->coalesced = 1;
+  THCSTensor_(_clearCSR)(state, r_);
 
   THCIndexTensor_(free)(state, t_indices_);
   THCTensor_(free)(state, t_values_);
@@ -496,6 +516,7 @@ void THCSTensor_(pow)(THCState *state, THCSTensor *r_, THCSTensor *t_, real valu
   THCTensor_(pow)(state, r_values_, t_values_, value);
   r_->nnz = t->nnz;
   r_->coalesced = t->coalesced;
+  THCSTensor_(_clearCSR)(state, r_);
 
   THCIndexTensor_(free)(state, r_indices_);
   THCTensor_(free)(state, r_values_);
@@ -21,6 +21,13 @@
 #define THNN_INDEXLINEAR_SIGN(a) ( ( (a) < 0 )  ?  -1   : ( (a) > 0 ) )
 #endif
 
+/* Thread that applies the updates of a key, when they are spread over
+ * nThreads threads: the updates of a key are all applied by the same thread,
+ * in order, so that the results are the same as when run serially. */
+#ifndef THNN_INDEXLINEAR_KEY_OWNER
+#define THNN_INDEXLINEAR_KEY_OWNER(key, nThreads) ( (int)((uint64_t)(key) % (uint64_t)(nThreads)) )
+#endif
+
 static bool THNN_(checkKeysValues)(THLongTensor* keys, THTensor* values)
 {
   return THLongTensor_size(keys, 0) == THTensor_(nElement)(values)
@@ -79,6 +86,57 @@ void THNN_(IndexLinear_updateOutput)(
   THArgCheck(THTensor_(isContiguous)(normalizedValues), 9, "normalizedValues vector must be contiguous");
   int64_t i,j,k;
 
+  /* When training, normalizing the values updates the max of each key, so the
+   * values are normalized first, key by key: every thread goes through all the
+   * keys but only normalizes the values of the keys it owns, in order, so that
+   * they are normalized as when run serially. */
+  if (maxNormalize && train)
+  {
+#pragma omp parallel private(i) if(keysSize*outDim > THNN_SPARSE_OMP_THRESHOLD && batchSize > 1)
+    {
+      int nThreads = 1;
+      int threadId = 0;
+#ifdef _OPENMP
+      nThreads = omp_get_num_threads();
+      threadId = omp_get_thread_num();
+#endif
+      for (i = 0; i < keysSize; i++)
+      {
+        if (THNN_INDEXLINEAR_KEY_OWNER(keysData[i] + keysOffset, nThreads) != threadId) continue;
+        int64_t woffset = weightStride0*(keysData[i] + keysOffset);
+        real val = valuesData[i];
+        real absVal = fabs(val);
+        if (absVal > weightData[woffset])
+        {
+          weightData[woffset] = absVal;
+          weightData[woffset+1] = 1/absVal;
+        }
+
+        /*
+         * The following can be used to scale the size of the updates
+         * depending on some rule, e.g. the frequency of a feature, ...
+         * The commented section thereafter is just an example of what can be done:
+         *
+         *```
+         * weightData[woffset+2] = weightData[woffset+2]==0?1:(weightData[woffset+2] / (weightData[woffset+2] + 1));
+         * real alpha = 1;
+         * real beta = 0.01;
+         * real gamma = 1 - 0.000001;
+         * real l = weightData[woffset+2]==0?1/gamma:(weightData[woffset+2] - beta) / (alpha - beta);
+         * l = gamma*l;
+         * weightData[woffset+2] = (alpha-beta)*l + beta;
+         * ```
+         *
+         * TODO: implement a smarter update scale.
+         */
+        weightData[woffset+2] = 1;
+
+        /* Normalize + Clamp */
+        normalizedValuesData[i] = (absVal > weightData[woffset] ? THNN_INDEXLINEAR_SIGN(val):val*weightData[woffset+1]) + weightData[woffset+3];
+      }
+    }
+  }
+
   /* Separate cases: output dimension is == 1, or > 1
    * This allows for some optimizations. */
   if (outDim == 1)
@@ -105,24 +163,11 @@ void THNN_(IndexLinear_updateOutput)(
         for (i = 0; i < sizesData[j]; i++)
         {
           int64_t woffset = weightStride0*(keysData[offset] + keysOffset);
-          absVal = fabs(valuesData[offset]);
-          if (train)
+          if (!train)
           {
-            if (absVal > weightData[woffset])
-            {
-              weightData[woffset] = absVal;
-              weightData[woffset+1] = 1/absVal;
-            }
-
-            /*
-             * The following can be used to scale the size of the updates
-             * depending on some rule, e.g. the frequency of a feature, ...
-             * This is used at update time.
-             * TODO: implement a smarter update scale.
-             */
-            weightData[woffset+2] = 1;
+            absVal = fabs(valuesData[offset]);
+            normalizedValuesData[offset] = (absVal > weightData[woffset] ? THNN_INDEXLINEAR_SIGN(valuesData[offset]):valuesData[offset]*weightData[woffset+1]) + weightData[woffset+3];
           }
-          normalizedValuesData[offset] = (absVal > weightData[woffset] ? THNN_INDEXLINEAR_SIGN(valuesData[offset]):valuesData[offset]*weightData[woffset+1]) + weightData[woffset+3];
           val += normalizedValuesData[offset] * weightData[woffset+maxNormalize];
           offset++;
         }
@@ -176,39 +221,15 @@ void THNN_(IndexLinear_updateOutput)(
         int64_t woffset = weightStride0*(keysData[offset] + keysOffset);
         if (maxNormalize)
         {
-          val = valuesData[offset];
-          real absVal = fabs(val);
-          if (train)
+          if (!train)
           {
-            if (absVal > weightData[woffset])
-            {
-              weightData[woffset] = absVal;
-              weightData[woffset+1] = 1/absVal;
-            }
+            val = valuesData[offset];
+            real absVal = fabs(val);
 
-            /*
-             * The following can be used to scale the size of the updates
-             * depending on some rule, e.g. the frequency of a feature, ...
-             * The commented section thereafter is just an example of what can be done:
-             *
-             *```
-             * weightData[woffset+2] = weightData[woffset+2]==0?1:(weightData[woffset+2] / (weightData[woffset+2] + 1));
-             * real alpha = 1;
-             * real beta = 0.01;
-             * real gamma = 1 - 0.000001;
-             * real l = weightData[woffset+2]==0?1/gamma:(weightData[woffset+2] - beta) / (alpha - beta);
-             * l = gamma*l;
-             * weightData[woffset+2] = (alpha-beta)*l + beta;
-             * ```
-             *
-             * TODO: implement a smarter update scale.
-             */
-            weightData[woffset+2] = 1;
+            /* Normalize + Clamp */
+            normalizedValuesData[offset] = (absVal > weightData[woffset] ? THNN_INDEXLINEAR_SIGN(val):val*weightData[woffset+1]) + weightData[woffset+3];
           }
-
-          /* Normalize + Clamp */
-          val = (absVal > weightData[woffset] ? THNN_INDEXLINEAR_SIGN(val):val*weightData[woffset+1]) + weightData[woffset+3];
-          normalizedValuesData[offset] = val;
+          val = normalizedValuesData[offset];
 
           lweightData = weightData + woffset + maxNormalize;
         }
@@ -270,108 +291,122 @@ void THNN_(IndexLinear_updateParameters)(
   THArgCheck(THTensor_(isContiguous)(bias), 4, "gradBias vector must be contiguous");
   THArgCheck(THLongTensor_isContiguous(runningKeys), 5, "keys vector must be contiguous");
 
-  int j, k;
-
   /* Update the bias first */
   THVector_(cadd)(biasData, biasData, gradBiasData, -learningRate, outDim);
 
   /* Separate cases: output dimension is == 1, or > 1
    * This allows for some optimizations.
-   * No multithreading here as this could
-   * corrupt the results (hogwild style) */
-  if (outDim == 1)
+   * Multithreaded by key: every thread goes through all the keys but only
+   * applies the updates of the keys it owns, so that two threads never
+   * update the same weights (no hogwild style corruption). */
+#pragma omp parallel if(keysSize*outDim > THNN_SPARSE_OMP_THRESHOLD)
   {
-    if (maxNormalize)
+    int j, k;
+    int nThreads = 1;
+    int threadId = 0;
+#ifdef _OPENMP
+    nThreads = omp_get_num_threads();
+    threadId = omp_get_thread_num();
+#endif
+    if (outDim == 1)
     {
-      if (weightDecay)
+      if (maxNormalize)
       {
-        for (j = 0; j < keysSize; j++)
+        if (weightDecay)
+        {
+          for (j = 0; j < keysSize; j++)
+          {
+            if (THNN_INDEXLINEAR_KEY_OWNER(keysData[j] + keysOffset, nThreads) != threadId) continue;
+            int64_t woffset = weightStride0*(keysData[j] + keysOffset) + maxNormalize;
+            real lr = learningRate*weightData[woffset-2];
+            weightData[woffset-1] -= weightData[woffset]*gradWeightData[2*j]*lr;
+            weightData[woffset] -= gradWeightData[2*j+1]*lr - weightDecay * weightData[woffset-2] * weightData[woffset];
+          }
+        }
+        else
         {
-          int64_t woffset = weightStride0*(keysData[j] + keysOffset) + maxNormalize;
-          real lr = learningRate*weightData[woffset-2];
-          weightData[woffset-1] -= weightData[woffset]*gradWeightData[2*j]*lr;
-          weightData[woffset] -= gradWeightData[2*j+1]*lr - weightDecay * weightData[woffset-2] * weightData[woffset];
+          for (j = 0; j < keysSize; j++)
+          {
+            if (THNN_INDEXLINEAR_KEY_OWNER(keysData[j] + keysOffset, nThreads) != threadId) continue;
+            int64_t woffset = weightStride0*(keysData[j] + keysOffset) + maxNormalize;
+            real lr = learningRate*weightData[woffset-2];
+            weightData[woffset-1] -= weightData[woffset]*gradWeightData[2*j]*lr;
+            weightData[woffset] -= gradWeightData[2*j+1]*lr;
+          }
         }
       }
       else
       {
-        for (j = 0; j < keysSize; j++)
+        if (weightDecay)
+        {
+          for (j = 0; j < keysSize; j++)
+          {
+            if (THNN_INDEXLINEAR_KEY_OWNER(keysData[j] + keysOffset, nThreads) != threadId) continue;
+            int64_t woffset = weightStride0*(keysData[j] + keysOffset);
+            weightData[woffset] -= gradWeightData[j]*learningRate + weightDecay * weightData[woffset];
+          }
+        }
+        else
         {
-          int64_t woffset = weightStride0*(keysData[j] + keysOffset) + maxNormalize;
-          real lr = learningRate*weightData[woffset-2];
-          weightData[woffset-1] -= weightData[woffset]*gradWeightData[2*j]*lr;
-          weightData[woffset] -= gradWeightData[2*j+1]*lr;
+          for (j = 0; j < keysSize; j++)
+          {
+            if (THNN_INDEXLINEAR_KEY_OWNER(keysData[j] + keysOffset, nThreads) != threadId) continue;
+            weightData[weightStride0*(keysData[j] + keysOffset)] -= gradWeightData[j]*learningRate;
+          }
         }
       }
     }
     else
     {
-      if (weightDecay)
+      for (j = 0; j < keysSize; j++)
       {
-        for (j = 0; j < keysSize; j++)
+        if (THNN_INDEXLINEAR_KEY_OWNER(keysData[j] + keysOffset, nThreads) != threadId) continue;
+        real lr = learningRate;
+        real wd = weightDecay;
+        real* lweightData;
+        int64_t woffset = weightStride0*(keysData[j] + keysOffset);
+        real* lgradWeightData = gradWeightData + j*outDim;
+        if (maxNormalize)
         {
-          int64_t woffset = weightStride0*(keysData[j] + keysOffset);
-          weightData[woffset] -= gradWeightData[j]*learningRate + weightDecay * weightData[woffset];
+          lgradWeightData += j*outDim;
+          /* weightData[woffset + 2] */
+          lweightData = weightData + woffset + maxNormalize - 2;
+          lr = lr*lweightData[0];
+          wd = weightDecay*lweightData[0];
+          /* weightData[woffset + 3] */
+          lweightData++;
+          for (k=0; k < outDim; k++)
+          {
+              lweightData[0] -= lgradWeightData[k]*lweightData[k+1]*lr;
+          }
+          lweightData++;
+          lgradWeightData += outDim;
         }
-      }
-      else
-      {
-        for (j = 0; j < keysSize; j++)
+        else
         {
-          weightData[weightStride0*(keysData[j] + keysOffset)] -= gradWeightData[j]*learningRate;
+          lweightData = weightData + woffset;
         }
-      }
-    }
-  }
-  else
-  {
-    for (j = 0; j < keysSize; j++)
-    {
-      real lr = learningRate;
-      real wd = weightDecay;
-      real* lweightData;
-      int64_t woffset = weightStride0*(keysData[j] + keysOffset);
-      real* lgradWeightData = gradWeightData + j*outDim;
-      if (maxNormalize)
-      {
-        lgradWeightData += j*outDim;
-        /* weightData[woffset + 2] */
-        lweightData = weightData + woffset + maxNormalize - 2;
-        lr = lr*lweightData[0];
-        wd = weightDecay*lweightData[0];
-        /* weightData[woffset + 3] */
-        lweightData++;
-        for (k=0; k < outDim; k++)
+
+        /* We do sparse weight decay.
+         * We think it makes more sense. */
+        if (weightDecay)
         {
-            lweightData[0] -= lgradWeightData[k]*lweightData[k+1]*lr;
+          for (k=0; k < outDim; k++)
+          {
+              lweightData[k] -= lweightData[k]*wd;
+          }
         }
-        lweightData++;
-        lgradWeightData += outDim;
-      }
-      else
-      {
-        lweightData = weightData + woffset;
-      }
 
-      /* We do sparse weight decay.
-       * We think it makes more sense. */
-      if (weightDecay)
-      {
-        for (k=0; k < outDim; k++)
+        if (outDim > THNN_SPARSE_OUTDIM_THRESHOLD)
         {
-            lweightData[k] -= lweightData[k]*wd;
+          THBlas_(axpy)(outDim, -lr, lgradWeightData, 1, lweightData, 1);
         }
-      }
-
-      if (outDim > THNN_SPARSE_OUTDIM_THRESHOLD)
-      {
-        THBlas_(axpy)(outDim, -lr, lgradWeightData, 1, lweightData, 1);
-      }
-      else
-      {
-        for (k=0; k < outDim; k++)
+        else
         {
-          lweightData[k] -= lgradWeightData[k]*lr;
+          for (k=0; k < outDim; k++)
+          {
+            lweightData[k] -= lgradWeightData[k]*lr;
+          }
         }
       }
     }
@@ -396,6 +431,7 @@ void THNN_(IndexLinear_accUpdateGradParameters)(
   real scale = TH_CONVERT_ACCREAL_TO_REAL(scale_);
   /* Retrieve all the dimensions of the problem */
   int64_t batchSize = THLongTensor_size(sizes, 0);
+  int64_t keysSize = THLongTensor_size(keys, 0);
   int64_t outDim = THTensor_(size)(bias, 0);
   int64_t woutDim = THTensor_(size)(weight, 1);
   int maxNormalize = woutDim - outDim;
@@ -417,164 +453,185 @@ void THNN_(IndexLinear_accUpdateGradParameters)(
   THArgCheck(THTensor_(isContiguous)(weight), 7, "weight matrix must be contiguous");
   THArgCheck(THTensor_(isContiguous)(bias), 8, "bias matrix must be contiguous");
 
-  int i,j,k;
-
   /* Separate cases: output dimension is == 1, or > 1
    * This allows for some optimizations.
-   * No multithreading here as this could
-   * corrupt the results (hogwild style) */
-  if (outDim == 1)
+   * Multithreaded by key as in updateParameters, so that two threads never
+   * update the same weights (no hogwild style corruption). The first thread
+   * also updates the bias. */
+#pragma omp parallel if(keysSize*outDim > THNN_SPARSE_OMP_THRESHOLD)
   {
-    if (maxNormalize)
+    int i,j,k;
+    int nThreads = 1;
+    int threadId = 0;
+#ifdef _OPENMP
+    nThreads = omp_get_num_threads();
+    threadId = omp_get_thread_num();
+#endif
+    if (outDim == 1)
     {
-        int64_t offset = 0;
-        for (j = 0; j < batchSize; j++)
-        {
-          real* lgradOutputData = gradOutputData + j;
-          *biasData -= *lgradOutputData * scale;
-          real val = *lgradOutputData * scale;
-          for (i = 0; i < sizesData[j]; i++)
+      if (maxNormalize)
+      {
+          int64_t offset = 0;
+          for (j = 0; j < batchSize; j++)
           {
-            int64_t idx = weightStride0*(keysData[offset] + keysOffset) + maxNormalize;
-            weightData[idx-1] -= weightData[idx]*val*weightData[idx-2];
-            weightData[idx] -= (val*valuesData[offset] - weightDecay * weightData[idx])*weightData[idx-2];
-            offset++;
+            real* lgradOutputData = gradOutputData + j;
+            if (threadId == 0)
+            {
+              *biasData -= *lgradOutputData * scale;
+            }
+            real val = *lgradOutputData * scale;
+            for (i = 0; i < sizesData[j]; i++, offset++)
+            {
+              if (THNN_INDEXLINEAR_KEY_OWNER(keysData[offset] + keysOffset, nThreads) != threadId) continue;
+              int64_t idx = weightStride0*(keysData[offset] + keysOffset) + maxNormalize;
+              weightData[idx-1] -= weightData[idx]*val*weightData[idx-2];
+              weightData[idx] -= (val*valuesData[offset] - weightDecay * weightData[idx])*weightData[idx-2];
+            }
           }
-        }
 
-        offset = 0;
-        for (j = 0; j < batchSize; j++)
-        {
-          for (i = 0; i < sizesData[j]; i++)
+          offset = 0;
+          for (j = 0; j < batchSize; j++)
           {
-            int64_t idx = weightStride0*(keysData[offset] + keysOffset) + maxNormalize;
-            weightData[idx-2] = 0;
-            offset++;
+            for (i = 0; i < sizesData[j]; i++, offset++)
+            {
+              if (THNN_INDEXLINEAR_KEY_OWNER(keysData[offset] + keysOffset, nThreads) != threadId) continue;
+              int64_t idx = weightStride0*(keysData[offset] + keysOffset) + maxNormalize;
+              weightData[idx-2] = 0;
+            }
           }
-        }
-    }
-    else
-    {
-      if (weightDecay)
+      }
+      else
       {
-        int64_t offset = 0;
-        for (j = 0; j < batchSize; j++)
+        if (weightDecay)
         {
-          real* lgradOutputData = gradOutputData + j;
-          *biasData -= *lgradOutputData * scale;
-          real val = *lgradOutputData * scale;
-          for (i = 0; i < sizesData[j]; i++)
+          int64_t offset = 0;
+          for (j = 0; j < batchSize; j++)
           {
-            int64_t idx = weightStride0*(keysData[offset] + keysOffset);
-            weightData[idx] -= val * valuesData[offset] + weightData[idx] * weightDecay;
-            offset++;
+            real* lgradOutputData = gradOutputData + j;
+            if (threadId == 0)
+            {
+              *biasData -= *lgradOutputData * scale;
+            }
+            real val = *lgradOutputData * scale;
+            for (i = 0; i < sizesData[j]; i++, offset++)
+            {
+              if (THNN_INDEXLINEAR_KEY_OWNER(keysData[offset] + keysOffset, nThreads) != threadId) continue;
+              int64_t idx = weightStride0*(keysData[offset] + keysOffset);
+              weightData[idx] -= val * valuesData[offset] + weightData[idx] * weightDecay;
+            }
           }
         }
-      }
-      else
-      {
-        int64_t offset = 0;
-        for (j = 0; j < batchSize; j++)
+        else
         {
-          real val = gradOutputData[j] * scale;
-          for (i = 0; i < sizesData[j]; i++)
+          int64_t offset = 0;
+          for (j = 0; j < batchSize; j++)
           {
-            weightData[(keysData[offset] + keysOffset)*weightStride0] -= val * valuesData[offset];
-            offset++;
+            real val = gradOutputData[j] * scale;
+            for (i = 0; i < sizesData[j]; i++, offset++)
+            {
+              if (THNN_INDEXLINEAR_KEY_OWNER(keysData[offset] + keysOffset, nThreads) != threadId) continue;
+              weightData[(keysData[offset] + keysOffset)*weightStride0] -= val * valuesData[offset];
+            }
+            if (threadId == 0)
+            {
+              *biasData -= val;
+            }
           }
-          *biasData -= val;
         }
       }
     }
-  }
-  else {
-    int64_t offset = 0;
-    for (j = 0; j < batchSize; j++)
-    {
-      real* lgradOutputData = gradOutputData + j*outDim;
-      real* lweightData = weightData;
-      THVector_(cadd)(biasData, biasData, lgradOutputData, -scale, outDim);
-      for (i = 0; i < sizesData[j]; i++)
+    else {
+      int64_t offset = 0;
+      for (j = 0; j < batchSize; j++)
       {
-        real val = valuesData[offset] * scale;
-        real wd = weightDecay;
-
-        // Max normalize case
-        if (maxNormalize)
+        real* lgradOutputData = gradOutputData + j*outDim;
+        real* lweightData = weightData;
+        if (threadId == 0)
         {
-          lweightData = weightData + weightStride0*(keysData[offset] + keysOffset) + (maxNormalize-2);
-          val *= lweightData[0];
-          wd *= lweightData[0];
-          for (k=0; k < outDim; k++)
-          {
-            lweightData[1] -= lweightData[k+2]*scale*lgradOutputData[k]*lweightData[0];
-          }
-          lweightData += 2;
+          THVector_(cadd)(biasData, biasData, lgradOutputData, -scale, outDim);
         }
-        else
+        for (i = 0; i < sizesData[j]; i++, offset++)
         {
-          lweightData = weightData + weightStride0*(keysData[offset] + keysOffset);
-        }
+          if (THNN_INDEXLINEAR_KEY_OWNER(keysData[offset] + keysOffset, nThreads) != threadId) continue;
+          real val = valuesData[offset] * scale;
+          real wd = weightDecay;
 
-        /* We do sparse weight decay.
-         * We think it makes more sense. */
-        if (weightDecay)
-        {
-          if (outDim > THNN_SPARSE_OUTDIM_THRESHOLD)
+          // Max normalize case
+          if (maxNormalize)
           {
-            THBlas_(axpy)(outDim, -wd, lweightData, 1, lweightData, 1);
+            lweightData = weightData + weightStride0*(keysData[offset] + keysOffset) + (maxNormalize-2);
+            val *= lweightData[0];
+            wd *= lweightData[0];
+            for (k=0; k < outDim; k++)
+            {
+              lweightData[1] -= lweightData[k+2]*scale*lgradOutputData[k]*lweightData[0];
+            }
+            lweightData += 2;
           }
           else
           {
-            for (k=0; k < outDim; k++)
+            lweightData = weightData + weightStride0*(keysData[offset] + keysOffset);
+          }
+
+          /* We do sparse weight decay.
+           * We think it makes more sense. */
+          if (weightDecay)
+          {
+            if (outDim > THNN_SPARSE_OUTDIM_THRESHOLD)
             {
-              lweightData[k] -= wd * lweightData[k];
+              THBlas_(axpy)(outDim, -wd, lweightData, 1, lweightData, 1);
+            }
+            else
+            {
+              for (k=0; k < outDim; k++)
+              {
+                lweightData[k] -= wd * lweightData[k];
+              }
             }
           }
-        }
 
-        if (outDim > THNN_SPARSE_OUTDIM_THRESHOLD)
-        {
-          THBlas_(axpy)(outDim, -val, lgradOutputData, 1, lweightData, 1);
-        }
-        else
-        {
-          for (k=0; k < outDim; k++)
+          if (outDim > THNN_SPARSE_OUTDIM_THRESHOLD)
+          {
+            THBlas_(axpy)(outDim, -val, lgradOutputData, 1, lweightData, 1);
+          }
+          else
           {
-            lweightData[k] -= val * lgradOutputData[k];
+            for (k=0; k < outDim; k++)
+            {
+              lweightData[k] -= val * lgradOutputData[k];
+            }
           }
         }
-        offset++;
       }
     }
+  }
 
-    /* Max Normalize case:
-     * Reset the smart update scaling if
-     * one does it batch-wise.
-     * TODO: Decide what to do with that piece of code.
-     * NB: If the code belowe is uncommented, so should the commented
-     * code in IndexLinear:zeroGradParameters() */
+  /* Max Normalize case:
+   * Reset the smart update scaling if
+   * one does it batch-wise.
+   * TODO: Decide what to do with that piece of code.
+   * NB: If the code belowe is uncommented, so should the commented
+   * code in IndexLinear:zeroGradParameters() */
 
-    /*
-    if (maxNormalize)
+  /*
+  if (maxNormalize)
+  {
+    offset = 0;
+    for (j = 0; j < batchSize; j++)
     {
-      offset = 0;
-      for (j = 0; j < batchSize; j++)
+      real* lweightData = weightData;
+      for (i = 0; i < sizesData[j]; i++)
       {
-        real* lweightData = weightData;
-        for (i = 0; i < sizesData[j]; i++)
-        {
-          real val = valuesData[offset] * scale;
-          real wd = weightDecay;
+        real val = valuesData[offset] * scale;
+        real wd = weightDecay;
 
-          lweightData = weightData + weightStride0*(keysData[offset] + keysOffset) + (maxNormalize-2);
-          lweightData[0] = 0;
-          offset++;
-        }
+        lweightData = weightData + weightStride0*(keysData[offset] + keysOffset) + (maxNormalize-2);
+        lweightData[0] = 0;
+        offset++;
       }
     }
-    */
   }
+  */
   return;
 }
 
@@ -633,10 +690,12 @@ void THNN_(IndexLinear_accGradParameters)(
 
   /* Separate cases: output dimension is == 1, or > 1
    * This allows for some optimizations.
-   * No multithreading here as this could
-   * corrupt the results (hogwild style) */
+   * Every key has its own gradWeight row, so the batch is parallelized on;
+   * the bias gradient is accumulated afterwards, in order. */
   if (outDim == 1)
   {
+#pragma omp parallel for private(i, j) schedule(static) \
+    if(keysSize*outDim > THNN_SPARSE_OMP_THRESHOLD && batchSize > 1)
     for (j = 0; j < batchSize; j++)
     {
       int64_t offset = j==0?0:cumSizesData[j-1];
@@ -671,17 +730,20 @@ void THNN_(IndexLinear_accGradParameters)(
           lgradWeightData[i] = val * lvaluesData[i];
         }
       }
-      *gradBiasData += val;
-      offset += end;
+    }
+    for (j = 0; j < batchSize; j++)
+    {
+      *gradBiasData += gradOutputData[j] * scale;
     }
   }
   else {
+#pragma omp parallel for private(i, j, k) schedule(static) \
+    if(keysSize*outDim > THNN_SPARSE_OMP_THRESHOLD && batchSize > 1)
     for (j = 0; j < batchSize; j++)
     {
       int64_t offset = j==0?0:cumSizesData[j-1];
       real* lgradOutputData = gradOutputData + j*outDim;
       real* lgradWeightData = gradWeightData;
-      THVector_(cadd)(gradBiasData, gradBiasData, lgradOutputData, scale, outDim);
       for (i = 0; i < sizesData[j]; i++)
       {
         real val = valuesData[offset] * scale;
@@ -720,6 +782,10 @@ void THNN_(IndexLinear_accGradParameters)(
         offset++;
       }
     }
+    for (j = 0; j < batchSize; j++)
+    {
+      THVector_(cadd)(gradBiasData, gradBiasData, gradOutputData + j*outDim, scale, outDim);
+    }
   }
   THLongTensor_free(cumSizes);
   return;
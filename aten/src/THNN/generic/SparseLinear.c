@@ -41,6 +41,62 @@ static real THNN_(get2d)(const THTensor *t, int64_t x0, int64_t x1) {
                          x0*t->stride[0] + x1*t->stride[1]);
 }
 
+/* Groups the entries of a coo input by column, so that every column can be
+ * updated by a single thread: the entries of the c-th column are
+ * order[starts[c]] ... order[starts[c+1]-1], in input order, each encoded as
+ * column * nnz + entry. With skipZeros, the entries with a 0 value are left
+ * out. Returns the number of columns that have entries. */
+static int64_t THNN_(SparseLinear_groupByColumn)(
+          THTensor *input,
+          int64_t inDim,
+          int skipZeros,
+          const char *caller,
+          THLongTensor *order,
+          THLongTensor *starts)
+{
+  int64_t i, cnt = 0, nCols = 0;
+  int64_t nnz = THTensor_(size)(input, 0);
+
+  THLongTensor *keys = THLongTensor_newWithSize1d(nnz > 0 ? nnz : 1);
+  int64_t *keysData = THLongTensor_data(keys);
+  for (i = 0; i < nnz; i++) {
+    if (skipZeros && THNN_(get2d)(input, i, 2) == 0) {
+      continue;
+    }
+    int64_t offset = (int64_t)(THNN_(get2d)(input, i, 1)) - 1;
+    if (offset >= 0 && offset < inDim) {
+      keysData[cnt++] = offset * nnz + i;
+    } else {
+      THLongTensor_free(keys);
+      THError("index out of bound. %s: %d not between 1 and %d",
+          caller, offset + 1, inDim);
+    }
+  }
+  THLongTensor_resize1d(order, cnt);
+  THLongTensor_resize1d(starts, cnt + 1);
+  if (cnt == 0) {
+    THLongTensor_free(keys);
+    return 0;
+  }
+  THLongTensor_resize1d(keys, cnt);
+
+  /* the keys are unique, so sorting them keeps the input order in a column */
+  THLongTensor *ri = THLongTensor_new();
+  THLongTensor_sort(order, ri, keys, 0, 0);
+  THLongTensor_free(ri);
+  THLongTensor_free(keys);
+
+  int64_t *orderData = THLongTensor_data(order);
+  int64_t *startsData = THLongTensor_data(starts);
+  for (i = 0; i < cnt; i++) {
+    if (i == 0 || orderData[i] / nnz != orderData[i - 1] / nnz) {
+      startsData[nCols++] = i;
+    }
+  }
+  startsData[nCols] = cnt;
+  return nCols;
+}
+
 void THNN_(SparseLinear_updateOutput)(
           THNNState *state,
           THTensor *input,
@@ -61,27 +117,32 @@ void THNN_(SparseLinear_updateOutput)(
 
   THLongTensor * csr = THLongTensor_newWithSize1d(batchSize+1);
   THLongTensor_zero(csr);
+  int64_t *csrData = THLongTensor_data(csr);
 
   weight = THTensor_(newContiguous)(weight);
+  bias = THTensor_(newContiguous)(bias);
+  real *biasData = THTensor_(data)(bias);
 
-//#pragma omp parallel for private(i, h, hp0, hp1) schedule(static) if (nnz > 10000)
+  // the rows of the input are sorted, so every entry sets its own range
+#pragma omp parallel for private(i, h, hp0, hp1) schedule(static) if (nnz > 10000)
   for (i=0; i<nnz; i++) {
     hp0 = (int64_t)(THNN_(get2d)(input, i, 0)) - 1;
     hp1 = (i+1 == nnz) ?
             batchSize :
             (int64_t)(THNN_(get2d)(input, i+1, 0)) - 1;
     if (hp0 != hp1) for (h = hp0; h < hp1; h++) {
-      THLongTensor_set1d(csr, h+1, i+1);
+      csrData[h+1] = i+1;
     }
   }
 
 
   // output = weight * input + bias
-  THTensor_(zero)(output);
-#pragma omp parallel for private(h, i) schedule(static) if (nnz > 10000)
+#pragma omp parallel for private(h, i) schedule(static) if (   \
+  batchSize > 1 && (nnz + batchSize) * outDim > 10000)
   for (h = 0; h < batchSize; h++) {
-    int64_t i_start = THLongTensor_get1d(csr, h);
-    int64_t i_end = THLongTensor_get1d(csr, h+1);
+    int64_t i_start = csrData[h];
+    int64_t i_end = csrData[h+1];
+    memcpy(ROW_PTR2(output, h), biasData, outDim * sizeof(real));
     for (i = i_start; i < i_end; i++) {
       real val = THNN_(get2d)(input, i, 2);
       if (val == 0) {
@@ -101,14 +162,9 @@ void THNN_(SparseLinear_updateOutput)(
     }
   }
 
-  THTensor* output_row = THTensor_(new)();
-  for (h = 0; h < batchSize; h++) {
-    THTensor_(select)(output_row, output, 0, h);
-    THTensor_(cadd)(output_row, bias, 1.0, output_row);
-  }
-  THTensor_(free)(output_row);
   THLongTensor_free(csr);
   THTensor_(free)(weight);
+  THTensor_(free)(bias);
 }
 
 void THNN_(SparseLinear_legacyUpdateOutput)(
@@ -178,7 +234,7 @@ void THNN_(SparseLinear_accGradParameters)(
 {
   real weightDecay = TH_CONVERT_ACCREAL_TO_REAL(weightDecay_);
   real scale = TH_CONVERT_ACCREAL_TO_REAL(scale_);
-  int64_t h, i, col, hp0, hp1;
+  int64_t h, i, c;
   int64_t outDim = THTensor_(size)(weight, 0);
   int64_t inDim = THTensor_(size)(weight, 1);
 
@@ -193,42 +249,27 @@ void THNN_(SparseLinear_accGradParameters)(
 
   int64_t nnz = THTensor_(size)(input, 0);
 
-  THLongTensor* csc = THLongTensor_newWithSize1d(inDim+1);
-  THLongTensor_zero(csc);
+  THLongTensor* order = THLongTensor_new();
+  THLongTensor* starts = THLongTensor_new();
+  int64_t nCols = THNN_(SparseLinear_groupByColumn)(
+      input, inDim, 0, "accGradParameters", order, starts);
+  int64_t *orderData = THLongTensor_data(order);
+  int64_t *startsData = THLongTensor_data(starts);
   weight = THTensor_(newContiguous)(weight);
 
-#pragma omp parallel for private(i, h, hp0, hp1) schedule(static) if (nnz > 10000)
-  for (i = 0; i < nnz; i++) {
-    hp0 = (int64_t)(THNN_(get2d)(input, i, 1)) - 1;
-    hp1 = (i+1 == nnz) ?
-            inDim :
-            (int64_t)(THNN_(get2d)(input, i+1, 1)) - 1;
-    if (hp0 != hp1) for (h = hp0; h < hp1; h++) {
-      THLongTensor_set1d(csc, h+1, i+1);
-    }
-  }
-
-  // gradWeight += gradOutput * input
-#pragma omp parallel for private(h, i, col) schedule(static) if (nnz > 10000)
-  for (col = 0; col < inDim; col++) {
-    int64_t i_start = THLongTensor_get1d(csc, col);
-    int64_t i_end = THLongTensor_get1d(csc, col+1);
-    for (i = i_start; i < i_end; i++) {
-      real val = scale * THNN_(get2d)(input, i, 2);
-
-      h = (int64_t)(THNN_(get2d)(input, i, 0)) - 1;
-      int64_t offset = (int64_t)(THNN_(get2d)(input, i, 1)) - 1;
-      if (offset >= 0 && offset < inDim) {
-        THBlas_(axpy)(outDim,
-            val,
-            ROW_PTR2(gradOutput, h), gradOutput->stride[1],
-            COL_PTR2(gradWeight, offset), gradWeight->stride[0]);
-      } else {
-        THError(
-            "index out of bound. accGradParameters: %d not between 1 and %d",
-            offset + 1,
-            inDim);
-      }
+  // gradWeight += gradOutput * input, one thread per column
+#pragma omp parallel for private(h, i, c) schedule(static) if (nnz * outDim > 10000)
+  for (c = 0; c < nCols; c++) {
+    int64_t offset = orderData[startsData[c]] / nnz;
+    for (i = startsData[c]; i < startsData[c+1]; i++) {
+      int64_t entry = orderData[i] % nnz;
+      real val = scale * THNN_(get2d)(input, entry, 2);
+
+      h = (int64_t)(THNN_(get2d)(input, entry, 0)) - 1;
+      THBlas_(axpy)(outDim,
+          val,
+          ROW_PTR2(gradOutput, h), gradOutput->stride[1],
+          COL_PTR2(gradWeight, offset), gradWeight->stride[0]);
     }
   }
 
@@ -237,7 +278,8 @@ void THNN_(SparseLinear_accGradParameters)(
   THTensor_(sum)(buf, gradOutput, 0, 1);
   THTensor_(cadd)(gradBias, gradBias, scale, buf);
   THTensor_(free)(buf);
-  THLongTensor_free(csc);
+  THLongTensor_free(order);
+  THLongTensor_free(starts);
 
   if (weightDecay != 0) {
     THTensor_(cadd)(gradWeight, gradWeight, weightDecay, weight);
@@ -338,53 +380,95 @@ void THNN_(SparseLinear_updateParameters)(
   int64_t nnz = THTensor_(size)(lastInput, 0);
 
   // collect unique offsets of non-0 val in input
-  THTensor* offsets = THTensor_(newWithSize1d)(nnz);
-  int64_t cnt = 0;
-  for (i = 0; i < nnz; i++) {
-    real val = THNN_(get2d)(lastInput, i, 2);
-    if (val == 0) {
-      continue;
-    }
-    int64_t offset = (int64_t)(THNN_(get2d)(lastInput, i, 1)) - 1;
-    if (offset >= 0 && offset < inDim) {
-      THNN_(set1d)(offsets, cnt++, offset);
-    } else {
-      THError(
-          "index out of bound. updateParameters: %d not between 1 and %d",
-          offset + 1,
-          inDim);
-    }
+  THLongTensor* order = THLongTensor_new();
+  THLongTensor* starts = THLongTensor_new();
+  int64_t cnt = THNN_(SparseLinear_groupByColumn)(
+      lastInput, inDim, 1, "updateParameters", order, starts);
+  int64_t *orderData = THLongTensor_data(order);
+  int64_t *startsData = THLongTensor_data(starts);
+  if (cnt == 0) {
+    THLongTensor_free(order);
+    THLongTensor_free(starts);
+    return;
   }
-  if (cnt == 0) return;
-  THTensor_(resize1d)(offsets, cnt);
-
-  THTensor* uniqueOffsets = THTensor_(new)();
-  THLongTensor* ri = THLongTensor_new();
-  THTensor_(sort)(uniqueOffsets, ri, offsets, 0, 0);
-  THLongTensor_free(ri);
-  THTensor_(free)(offsets);
-
-  cnt = 1;
-  real* uniqueOffsets_p = THTensor_(data)(uniqueOffsets);
-  for (i = 1; i < THTensor_(size)(uniqueOffsets, 0); i++) {
-    if (uniqueOffsets_p[i] != uniqueOffsets_p[i - 1]) {
-      uniqueOffsets_p[cnt++] = uniqueOffsets_p[i];
-    }
-  }
-  THTensor_(resize1d)(uniqueOffsets, cnt);
 
   // weight += -learningRate * gradWeight
   THTensor_(cadd)(bias, bias, -learningRate, gradBias);
 #pragma omp parallel for private(i) schedule(static) if (cnt * outDim > 10000)
   for (i = 0; i < cnt; i++) {
-    int64_t offset = (int64_t)uniqueOffsets_p[i];
+    int64_t offset = orderData[startsData[i]] / nnz;
     THBlas_(axpy)(outDim,
                   -learningRate,
                   COL_PTR2(gradWeight, offset), gradWeight->stride[0],
                   COL_PTR2(weight, offset), weight->stride[0]);
   }
 
-  THTensor_(free)(uniqueOffsets);
+  THLongTensor_free(order);
+  THLongTensor_free(starts);
+}
+
+void THNN_(SparseLinear_accUpdateGradParameters)(
+          THNNState *state,
+          THTensor *input,
+          THTensor *gradOutput,
+          THTensor *weight,
+          THTensor *bias,
+          accreal weightDecay_,
+          accreal learningRate_)
+{
+  real weightDecay = TH_CONVERT_ACCREAL_TO_REAL(weightDecay_);
+  real learningRate = TH_CONVERT_ACCREAL_TO_REAL(learningRate_);
+  int64_t h, i, c, k;
+  int64_t outDim = THTensor_(size)(weight, 0);
+  int64_t inDim = THTensor_(size)(weight, 1);
+
+  THArgCheck(THNN_(checkInput)(input), 2,
+             "input must be in coo format, nnz x 3");
+  THArgCheck(THNN_(checkSize1D)(bias, outDim), 5, "bias size wrong");
+  THArgCheck(THTensor_(isContiguous)(gradOutput), 3,
+             "gradOutput must be contiguous");
+
+  int64_t nnz = THTensor_(size)(input, 0);
+
+  THLongTensor* order = THLongTensor_new();
+  THLongTensor* starts = THLongTensor_new();
+  int64_t nCols = THNN_(SparseLinear_groupByColumn)(
+      input, inDim, 1, "accUpdateGradParameters", order, starts);
+  int64_t *orderData = THLongTensor_data(order);
+  int64_t *startsData = THLongTensor_data(starts);
+
+  // weight -= learningRate * (gradOutput * input + weightDecay * weight),
+  // with the weight decay only on the columns of the input, as
+  // accGradParameters followed by updateParameters does, but without the
+  // gradWeight buffer. One thread per column.
+#pragma omp parallel for private(h, i, c, k) schedule(static) if (nnz * outDim > 10000)
+  for (c = 0; c < nCols; c++) {
+    int64_t offset = orderData[startsData[c]] / nnz;
+    real *weightCol = COL_PTR2(weight, offset);
+    if (weightDecay != 0) {
+      for (k = 0; k < outDim; k++) {
+        weightCol[k * weight->stride[0]] *= 1 - learningRate * weightDecay;
+      }
+    }
+    for (i = startsData[c]; i < startsData[c+1]; i++) {
+      int64_t entry = orderData[i] % nnz;
+      real val = learningRate * THNN_(get2d)(input, entry, 2);
+
+      h = (int64_t)(THNN_(get2d)(input, entry, 0)) - 1;
+      THBlas_(axpy)(outDim,
+          -val,
+          ROW_PTR2(gradOutput, h), gradOutput->stride[1],
+          weightCol, weight->stride[0]);
+    }
+  }
+
+  // bias -= learningRate * gradOutput
+  THTensor* buf = THTensor_(new)();
+  THTensor_(sum)(buf, gradOutput, 0, 1);
+  THTensor_(cadd)(bias, bias, -learningRate, buf);
+  THTensor_(free)(buf);
+  THLongTensor_free(order);
+  THLongTensor_free(starts);
 }
 
 void THNN_(SparseLinear_legacyUpdateParameters)(
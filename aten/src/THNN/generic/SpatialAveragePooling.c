@@ -143,55 +143,62 @@ void THNN_(SpatialAveragePooling_updateOutput)(
   input_data = THTensor_(data)(input);
   output_data = THTensor_(data)(output);
 
+  /* The planes of all frames follow each other, so they are pooled in
+     parallel whatever the batch size. For each output row, the kH input rows
+     of its windows are first summed into rowsum, in loops over contiguous
+     rows which the compiler vectorizes, and then kW of these sums for each
+     output pixel. */
 #pragma omp parallel for private(k)
-  for(k = 0; k < nInputPlane; k++)
+  for(k = 0; k < nbatch*nInputPlane; k++)
   {
-    int64_t p;
-    for(p = 0; p < nbatch; p++)
+    real *ptr_output = output_data + k*outputWidth*outputHeight;
+    real *ptr_input = input_data + k*inputWidth*inputHeight;
+    real *rowsum = (real*)THAlloc(sizeof(real)*inputWidth);
+    int64_t xx, yy, x;
+
+    for(yy = 0; yy < outputHeight; yy++)
     {
-      int64_t xx, yy;
-      /* For all output pixels... */
-      real *ptr_output = output_data + p*nInputPlane*outputWidth*outputHeight + k*outputWidth*outputHeight;
-      real *ptr_input = input_data + p*nInputPlane*inputWidth*inputHeight + k*inputWidth*inputHeight;
-      int64_t i;
-      for(i = 0; i < outputWidth*outputHeight; i++)
-        ptr_output[i] = 0;
-
-      for(yy = 0; yy < outputHeight; yy++)
+      int64_t hstart = yy * dH - padH;
+      int64_t hend = fminf(hstart + kH, inputHeight + padH);
+      int64_t pool_height = hend - hstart;
+      hstart = fmaxf(hstart, 0);
+      hend = fminf(hend, inputHeight);
+
+      int64_t ky;
+      for(x = 0; x < inputWidth; x++)
+        rowsum[x] = 0;
+      for(ky = hstart; ky < hend; ky++)
       {
-        for(xx = 0; xx < outputWidth; xx++)
-        {
-          /* Compute the mean of the input image... */
-          int64_t hstart = yy * dH - padH;
-          int64_t wstart = xx * dW - padW;
-          int64_t hend = fminf(hstart + kH, inputHeight + padH);
-          int64_t wend = fminf(wstart + kW, inputWidth + padW);
-          int pool_size = (hend - hstart) * (wend - wstart);
-          hstart = fmaxf(hstart, 0);
-          wstart = fmaxf(wstart, 0);
-          hend = fminf(hend, inputHeight);
-          wend = fminf(wend, inputWidth);
-
-          real sum = 0;
-
-          int divide_factor;
-          if(count_include_pad)
-            divide_factor = pool_size;
-          else
-            divide_factor = (hend - hstart) * (wend - wstart);
-
-          int64_t kx, ky;
-
-          for(ky = hstart; ky < hend; ky++)
-          {
-            for(kx = wstart; kx < wend; kx++)
-              sum += ptr_input[ky*inputWidth + kx];
-          }
-          /* Update output */
-          *ptr_output++ += sum/divide_factor;
-        }
+        real *row = ptr_input + ky*inputWidth;
+        for(x = 0; x < inputWidth; x++)
+          rowsum[x] += row[x];
+      }
+
+      for(xx = 0; xx < outputWidth; xx++)
+      {
+        /* Compute the mean of the input image... */
+        int64_t wstart = xx * dW - padW;
+        int64_t wend = wstart + kW < inputWidth + padW ? wstart + kW : inputWidth + padW;
+        int pool_size = pool_height * (wend - wstart);
+        wstart = wstart > 0 ? wstart : 0;
+        wend = wend < inputWidth ? wend : inputWidth;
+
+        real sum = 0;
+
+        int divide_factor;
+        if(count_include_pad)
+          divide_factor = pool_size;
+        else
+          divide_factor = (hend - hstart) * (wend - wstart);
+
+        int64_t kx;
+        for(kx = wstart; kx < wend; kx++)
+          sum += rowsum[kx];
+        /* Update output */
+        *ptr_output++ = sum/divide_factor;
       }
     }
+    THFree(rowsum);
   }
   THTensor_(free)(input);
 }
@@ -274,50 +281,47 @@ void THNN_(SpatialAveragePooling_updateGradInput)(
   gradInput_data = THTensor_(data)(gradInput);
   gradOutput_data = THTensor_(data)(gradOutput);
 
+  /* see updateOutput */
 #pragma omp parallel for private(k)
-  for(k = 0; k < nInputPlane; k++)
+  for(k = 0; k < nbatch*nInputPlane; k++)
   {
-    int64_t p;
-    for(p = 0; p < nbatch; p++)
-    {
-      real *ptr_gradOutput = gradOutput_data + p*nInputPlane*outputHeight*outputWidth + k*outputWidth*outputHeight;
-      int64_t xx, yy;
+    real *ptr_gradOutput = gradOutput_data + k*outputWidth*outputHeight;
+    real *ptr_gradInput = gradInput_data + k*inputWidth*inputHeight;
+    int64_t xx, yy;
 
-      real* ptr_gi = gradInput_data + p*nInputPlane*inputWidth*inputHeight + k*inputWidth*inputHeight;
-      real *ptr_gradInput = gradInput_data + p*nInputPlane*inputWidth*inputHeight + k*inputWidth*inputHeight;
+    int64_t i;
+    for(i=0; i<inputWidth*inputHeight; i++)
+      ptr_gradInput[i] = 0.0;
 
-      int64_t i;
-      for(i=0; i<inputWidth*inputHeight; i++)
-        ptr_gi[i] = 0.0;
-
-      for(yy = 0; yy < outputHeight; yy++)
+    for(yy = 0; yy < outputHeight; yy++)
+    {
+      for(xx = 0; xx < outputWidth; xx++)
       {
-        for(xx = 0; xx < outputWidth; xx++)
+        int64_t hstart = yy * dH - padH;
+        int64_t wstart = xx * dW - padW;
+        int64_t hend = fminf(hstart + kH, inputHeight + padH);
+        int64_t wend = fminf(wstart + kW, inputWidth + padW);
+        int pool_size = (hend - hstart) * (wend - wstart);
+        hstart = fmaxf(hstart, 0);
+        wstart = fmaxf(wstart, 0);
+        hend = fminf(hend, inputHeight);
+        wend = fminf(wend, inputWidth);
+
+        real z = *ptr_gradOutput++;
+
+        int divide_factor;
+        if(count_include_pad)
+          divide_factor = pool_size;
+        else
+          divide_factor = (hend - hstart) * (wend - wstart);
+
+        real g = z/divide_factor;
+        int64_t kx, ky;
+        for(ky = hstart ; ky < hend; ky++)
         {
-          int64_t hstart = yy * dH - padH;
-          int64_t wstart = xx * dW - padW;
-          int64_t hend = fminf(hstart + kH, inputHeight + padH);
-          int64_t wend = fminf(wstart + kW, inputWidth + padW);
-          int pool_size = (hend - hstart) * (wend - wstart);
-          hstart = fmaxf(hstart, 0);
-          wstart = fmaxf(wstart, 0);
-          hend = fminf(hend, inputHeight);
-          wend = fminf(wend, inputWidth);
-
-          real z = *ptr_gradOutput++;
-
-          int divide_factor;
-          if(count_include_pad)
-            divide_factor = pool_size;
-          else
-            divide_factor = (hend - hstart) * (wend - wstart);
-
-          int64_t kx, ky;
-          for(ky = hstart ; ky < hend; ky++)
-          {
-            for(kx = wstart; kx < wend; kx++)
-              ptr_gradInput[ky*inputWidth + kx] += z/divide_factor;
-          }
+          real *row = ptr_gradInput + ky*inputWidth;
+          for(kx = wstart; kx < wend; kx++)
+            row[kx] += g;
         }
       }
     }
@@ -192,7 +192,10 @@ void THNN_(SpatialConvolutionMM_updateOutput)(
     THTensor_(resize3d)(finput, T, kW*kH*nInputPlane, outputHeight*outputWidth);
     THTensor_(resize4d)(output, T, nOutputPlane, outputHeight, outputWidth);
 
-#pragma omp parallel for private(t)
+    /* With fewer frames than threads, the frames run one after the other so
+       that unfolded_copy and the GEMM of each frame can use all threads, which
+       they can't inside of a parallel region. */
+#pragma omp parallel for if (T >= omp_get_max_threads()) private(t)
     for(t = 0; t < T; t++)
     {
       THTensor *input_t = THTensor_(newSelect)(input, 0, t);
@@ -286,7 +289,8 @@ void THNN_(SpatialConvolutionMM_updateGradInput)(
     int64_t T = input->size[0];
     int64_t t;
 
-#pragma omp parallel for private(t)
+    /* see updateOutput */
+#pragma omp parallel for if (T >= omp_get_max_threads()) private(t)
     for(t = 0; t < T; t++)
     {
       THTensor *gradInput_t = THTensor_(newSelect)(gradInput, 0, t);
@@ -241,8 +241,6 @@ void THNN_(SpatialDilatedMaxPooling_updateOutput)(
   }
   else
   {
-    int64_t p;
-
     THTensor_(resize4d)(output, nbatch, nInputPlane, outputHeight, outputWidth);
     /* indices will contain the locations for each output point */
     THIndexTensor_(resize4d)(indices, nbatch, nInputPlane, outputHeight, outputWidth);
@@ -251,21 +249,18 @@ void THNN_(SpatialDilatedMaxPooling_updateOutput)(
     output_data = THTensor_(data)(output);
     indices_data = THIndexTensor_(data)(indices);
 
-#pragma omp parallel for private(p)
-    for (p = 0; p < nbatch; p++)
-    {
-      THNN_(SpatialDilatedMaxPooling_updateOutput_frame)
-	(input_data+p*nInputPlane*inputWidth*inputHeight,
-	 output_data+p*nInputPlane*outputWidth*outputHeight,
-	 indices_data+p*nInputPlane*outputWidth*outputHeight,
-	 nInputPlane,
-	 inputWidth, inputHeight,
-	 outputWidth, outputHeight,
-	 kW, kH, dW, dH,
-	 padW, padH,
-	 dilationW, dilationH
-	 );
-    }
+    /* The planes of all frames follow each other, so they are pooled as the
+       planes of a single frame, in parallel whatever the batch size. */
+    THNN_(SpatialDilatedMaxPooling_updateOutput_frame)
+      (input_data, output_data,
+       indices_data,
+       nbatch*nInputPlane,
+       inputWidth, inputHeight,
+       outputWidth, outputHeight,
+       kW, kH, dW, dH,
+       padW, padH,
+       dilationW, dilationH
+       );
   }
 
   /* cleanup */
@@ -379,19 +374,14 @@ void THNN_(SpatialDilatedMaxPooling_updateGradInput)(
   }
   else
   {
-    int64_t p;
-#pragma omp parallel for private(p)
-    for (p = 0; p < nbatch; p++)
-    {
-      THNN_(SpatialDilatedMaxPooling_updateGradInput_frame)
-	(gradInput_data+p*nInputPlane*inputWidth*inputHeight,
-	 gradOutput_data+p*nInputPlane*outputWidth*outputHeight,
-	 indices_data+p*nInputPlane*outputWidth*outputHeight,
-	 nInputPlane,
-	 inputWidth, inputHeight,
-	 outputWidth, outputHeight,
-	 dW, dH);
-    }
+    /* see updateOutput */
+    THNN_(SpatialDilatedMaxPooling_updateGradInput_frame)
+      (gradInput_data, gradOutput_data,
+       indices_data,
+       nbatch*nInputPlane,
+       inputWidth, inputHeight,
+       outputWidth, outputHeight,
+       dW, dH);
   }
 
   /* cleanup */
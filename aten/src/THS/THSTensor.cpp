@@ -1,5 +1,9 @@
 #include "THSTensor.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
 #include "generic/THSTensor.cpp"
 #include "THSGenerateAllTypes.h"
 
@@ -73,6 +73,7 @@ static void THSTensor_(rawInit)(THSTensor *self)
   self->nDimensionV = 0;
   self->coalesced = 0;
   self->nnz = 0;
+  self->csr = NULL;
   // self->flag = TH_TENSOR_REFCOUNTED;
 }
 
@@ -85,6 +86,7 @@ THSTensor* THSTensor_(rawResize)(THSTensor *self, int nDimI, int nDimV, int64_t
   }
   self->nDimensionI = nDimI;
   self->nDimensionV = nDimV;
+  THSTensor_(_clearCSR)(self);
 
   return self;
 }
@@ -111,6 +113,7 @@ THSTensor* THSTensor_(_move)(THSTensor *self, THLongTensor *indices, THTensor *v
   self->values = values;
   self->nnz = empty ? 0 : THTensor_(size)(values, 0);
   self->coalesced = 0;
+  THSTensor_(_clearCSR)(self);
 
   return self;
 }
@@ -121,6 +124,11 @@ THSTensor* THSTensor_(_set)(THSTensor *self, THLongTensor *indices, THTensor *va
     self, THLongTensor_newClone(indices), THTensor_(newClone)(values));
 }
 
+void THSTensor_(_clearCSR)(THSTensor *self) {
+  THLongTensor_free(self->csr);
+  self->csr = NULL;
+}
+
 
 /*** end helper methods ***/
 
@@ -374,6 +382,7 @@ void THSTensor_(transpose)(THSTensor *self, int d1, int d2) {
   i = self->size[d1];
   self->size[d1] = self->size[d2];
   self->size[d2] = i;
+  THSTensor_(_clearCSR)(self);
   THLongTensor_free(indices);
 }
 
@@ -439,10 +448,9 @@ THSTensor *THSTensor_(newCoalesce)(THSTensor *self) {
   int64_t nDimI = THSTensor_(nDimensionI)(self);
   int64_t nDimV = THSTensor_(nDimensionV)(self);
 
-  THLongTensor *indicesScalar = THLongTensor_newWithSize1d(self->nnz);
+  ptrdiff_t nnz = self->nnz;
+  THLongTensor *indicesScalar = THLongTensor_newWithSize1d(nnz);
   THLongTensor *indicesSlice = THLongTensor_new();
-  THLongTensor *indicesBuffer = THLongTensor_newWithSize1d(self->nnz);
-  THLongTensor *indicesPermutation = THLongTensor_newWithSize1d(self->nnz);
   THLongTensor_zero(indicesScalar);
   int64_t factor = 1;
   for (int64_t d = nDimI - 1; d >= 0; d--) {
@@ -450,44 +458,93 @@ THSTensor *THSTensor_(newCoalesce)(THSTensor *self) {
     THLongTensor_cadd(indicesScalar, indicesScalar, factor, indicesSlice);
     factor *= self->size[d];
   }
+  const int64_t *keys = THLongTensor_data(indicesScalar);
+
+  // The entries in the order of their index, grouped by index: segment k of
+  // the output is order[segments[k]] .. order[segments[k + 1] - 1], with the
+  // entries of a segment in their original order.
+  std::vector<int64_t> order(nnz);
+  std::vector<int64_t> segments;
+  int sorted = 1;
+  for (ptrdiff_t j = 1; j < nnz; j++) {
+    if (keys[j] < keys[j - 1]) {
+      sorted = 0;
+      break;
+    }
+  }
+  if (sorted) {
+    // Already in order (e.g. appended to a coalesced tensor in order), so
+    // only the duplicates are merged
+    for (ptrdiff_t j = 0; j < nnz; j++) {
+      order[j] = j;
+      if (j == 0 || keys[j] != keys[j - 1]) {
+        segments.push_back(j);
+      }
+    }
+  } else {
+    // Sparse gradients repeat few indices many times, so the distinct
+    // indices are found with a hash table and only those are sorted; the
+    // entries are then bucketed into their segments by counting.
+    std::unordered_map<int64_t, int64_t> uniqueIds;
+    uniqueIds.reserve(nnz);
+    std::vector<int64_t> ids(nnz);
+    std::vector<std::pair<int64_t, int64_t> > uniqueKeys;
+    for (ptrdiff_t j = 0; j < nnz; j++) {
+      auto it = uniqueIds.emplace(keys[j], (int64_t) uniqueKeys.size());
+      if (it.second) {
+        uniqueKeys.emplace_back(keys[j], it.first->second);
+      }
+      ids[j] = it.first->second;
+    }
+    std::sort(uniqueKeys.begin(), uniqueKeys.end());
+    int64_t numUnique = uniqueKeys.size();
+    std::vector<int64_t> rank(numUnique);
+    for (int64_t k = 0; k < numUnique; k++) {
+      rank[uniqueKeys[k].second] = k;
+    }
+    segments.assign(numUnique, 0);
+    for (ptrdiff_t j = 0; j < nnz; j++) {
+      segments[rank[ids[j]]]++;
+    }
+    int64_t offset = 0;
+    for (int64_t k = 0; k < numUnique; k++) {
+      int64_t count = segments[k];
+      segments[k] = offset;
+      offset += count;
+    }
+    std::vector<int64_t> next(segments);
+    for (ptrdiff_t j = 0; j < nnz; j++) {
+      order[next[rank[ids[j]]]++] = j;
+    }
+  }
+  int64_t newNnz = segments.size();
+  segments.push_back(nnz);
 
-  THLongTensor *newIndices = THLongTensor_new();
-  THTensor *newValues = THTensor_(new)();
-  THLongTensor_resizeAs(newIndices, indices);
-  THTensor_(resizeAs)(newValues, values_);
-  // THSTensor_(_move)(self, newIndices, newValues);
+  THLongTensor *newIndices = THLongTensor_newWithSize2d(nDimI, newNnz);
+  THTensor *newValues = THSTensor_(newValuesWithSizeOf)(values, newNnz);
   THSTensor *dst = THSTensor_(new)();
   THSTensor_(rawResize)(dst, nDimI, nDimV, self->size);
   THSTensor_(_move)(dst, newIndices, newValues);
 
-  THLongTensor_sort(indicesBuffer, indicesPermutation, indicesScalar, 0, 0);
-
-  int64_t i = -1;
-  int64_t prev = -1;
   int64_t blockSize = values->stride[0];
-  for (int64_t j = 0; j < self->nnz; j++) {
-    int64_t pos = THTensor_fastGet1d(indicesPermutation, j);
-    int64_t curr = THTensor_fastGet1d(indicesBuffer, j);
-    if (curr == prev) {
+  int64_t k;
+#pragma omp parallel for private(k) schedule(static) if (nnz * blockSize > 10000)
+  for (k = 0; k < newNnz; k++) {
+    int64_t first = order[segments[k]];
+    for (int64_t d = 0; d < nDimI; d++) {
+      THTensor_fastSet2d(newIndices, d, k, THTensor_fastGet2d(indices, d, first));
+    }
+    THBlas_(copy)(blockSize,
+      THTensor_(data)(values) + first * blockSize, 1,
+      THTensor_(data)(newValues) + k * blockSize, 1);
+    for (int64_t j = segments[k] + 1; j < segments[k + 1]; j++) {
       THBlas_(axpy)(blockSize, 1,
-        THTensor_(data)(values) + pos * blockSize, 1,
-        THTensor_(data)(newValues) + i * blockSize, 1);
-    } else {
-      ++i;
-      for (int64_t d = 0; d < nDimI; d++) {
-        THTensor_fastSet2d(newIndices, d, i, THTensor_fastGet2d(indices, d, pos));
-      }
-      THBlas_(copy)(blockSize,
-        THTensor_(data)(values) + pos * blockSize, 1,
-        THTensor_(data)(newValues) + i * blockSize, 1);
+        THTensor_(data)(values) + order[j] * blockSize, 1,
+        THTensor_(data)(newValues) + k * blockSize, 1);
     }
-    prev = curr;
   }
-  dst->nnz = i + 1;
   dst->coalesced = 1;
   THLongTensor_free(indicesScalar);
-  THLongTensor_free(indicesBuffer);
-  THLongTensor_free(indicesPermutation);
   THLongTensor_free(indicesSlice);
   THLongTensor_free(indices);
   THTensor_(free)(values_);
@@ -550,6 +607,7 @@ void THSTensor_(free)(THSTensor *self)
     THFree(self->size);
     THLongTensor_free(self->indices);
     THTensor_(free)(self->values);
+    THLongTensor_free(self->csr);
     THFree(self);
   }
 }
@@ -17,6 +17,11 @@ typedef struct THSTensor
     // the indices tensor, and the indices are in sorted order.
     // Most math operations can only be performed on ordered sparse tensors
     int coalesced;
+    // Row pointers (size[0] + 1 offsets into the nnz entries) of a coalesced
+    // tensor, built on first use by THSTensor_(newCSR) and dropped whenever
+    // the indices change, so that repeated products with the same sparse
+    // matrix convert it once.
+    THLongTensor *csr;
     int refcount;
 
 } THSTensor;
@@ -30,6 +35,7 @@ TH_API ptrdiff_t THSTensor_(nnz)(const THSTensor *self);
 TH_API THLongStorage *THSTensor_(newSizeOf)(THSTensor *self);
 TH_API THLongTensor *THSTensor_(newIndices)(const THSTensor *self);
 TH_API THTensor *THSTensor_(newValues)(const THSTensor *self);
+TH_API THLongTensor *THSTensor_(newCSR)(THSTensor *self);
 
 /**** creation methods ****/
 TH_API THSTensor *THSTensor_(new)(void);
@@ -79,5 +85,6 @@ TH_API void THSTensor_(select)(THSTensor *self, THSTensor *src, int dimension_,
 TH_API THSTensor* THSTensor_(rawResize)(THSTensor *self, int nDimI, int nDimV, int64_t *size);
 THSTensor* THSTensor_(_move)(THSTensor *self, THLongTensor *indices, THTensor *values);
 THSTensor* THSTensor_(_set)(THSTensor *self, THLongTensor *indices, THTensor *values);
+void THSTensor_(_clearCSR)(THSTensor *self);
 
 #endif
@@ -13,6 +13,7 @@ void THSTensor_(zero)(THSTensor *self) {
     THTensor_(resizeNd)(self->values, 0, NULL, NULL);
   }
   self->nnz = 0;
+  THSTensor_(_clearCSR)(self);
 }
 
 void THSTensor_(zeros)(THSTensor *r_, THLongStorage *size)
@@ -45,6 +46,7 @@ void THSTensor_(mul)(THSTensor *r_, THSTensor *t, real value) {
     THTensor_(mul)(r_values_, t_values_, value);
     r_->nnz = t->nnz;
     r_->coalesced = t->coalesced;
+    THSTensor_(_clearCSR)(r_);
 
     THLongTensor_free(r_indices_);
     THTensor_(free)(r_values_);
@@ -73,6 +75,7 @@ void THSTensor_(pow)(THSTensor *r_, THSTensor *t_, real value) {
   THTensor_(pow)(r_values_, t_values_, value);
   r_->nnz = t->nnz;
   r_->coalesced = t->coalesced;
+  THSTensor_(_clearCSR)(r_);
 
   THLongTensor_free(r_indices_);
   THTensor_(free)(r_values_);
@@ -113,6 +116,7 @@ void THSTensor_(div)(THSTensor *r_, THSTensor *t, real value) {
     THTensor_(div)(r_values_, t_values_, value);
     r_->nnz = t->nnz;
     r_->coalesced = t->coalesced;
+    THSTensor_(_clearCSR)(r_);
 
     THLongTensor_free(r_indices_);
     THTensor_(free)(r_values_);
@@ -137,7 +141,7 @@ void THSTensor_(cadd)(THSTensor *r_, THSTensor *t, real value, THSTensor *src) {
 
   // saving those because they can be overwritten when doing in-place operations
   ptrdiff_t t_nnz = t->nnz, s_nnz = src->nnz, max_nnz = t_nnz + s_nnz;
-  int t_coalesced = t->coalesced, s_coalesced = src->coalesced;
+  int r_coalesced = 1;
   int64_t nDimI = THSTensor_(nDimensionI)(src);
   THLongTensor *t_indices_ = THSTensor_(newIndices)(t);
   THTensor *t_values_ = THSTensor_(newValues)(t);
@@ -188,15 +192,28 @@ void THSTensor_(cadd)(THSTensor *r_, THSTensor *t, real value, THSTensor *src) {
         THTensor_(data)(r_values_) + r_i * blockSize, 1);
       s_i++;
     }
+    // The result is coalesced if its indices strictly increase, which also
+    // holds for some uncoalesced inputs, so that a chain of additions does
+    // not coalesce again
+    if (r_coalesced && r_i > 0) {
+      for (d = 0; d < nDimI; d++) {
+        int64_t prev = THTensor_fastGet2d(r_indices_, d, r_i - 1);
+        int64_t curr = THTensor_fastGet2d(r_indices_, d, r_i);
+        if (prev != curr) {
+          r_coalesced = prev < curr;
+          break;
+        }
+      }
+      if (d == nDimI) {
+        r_coalesced = 0;
+      }
+    }
     r_i++;
   }
 
   r_->nnz = r_i;
-  // TODO: I think it may be possible to track inside the loop and
-  // detect when we are uncoalesced (e.g., by observing that an
-  // index goes backwards) which may be more precise than using the
-  // coalesced flag here.  But this is easy.
-  r_->coalesced = t_coalesced && s_coalesced;
+  r_->coalesced = r_coalesced;
+  THSTensor_(_clearCSR)(r_);
 
   THLongTensor_free(t_indices_);
   THTensor_(free)(t_values_);
@@ -266,6 +283,7 @@ void THSTensor_(cmul)(THSTensor *r_, THSTensor *t_, THSTensor *src_) {
 
   r_->nnz = r_i;
   r_->coalesced = 1;
+  THSTensor_(_clearCSR)(r_);
 
   THLongTensor_free(t_indices_);
   THTensor_(free)(t_values_);
@@ -302,6 +320,23 @@ THLongTensor *THSTensor_(toCSR)(int64_t const *indices, int64_t dim, int64_t nnz
   return csr;
 }
 
+THLongTensor *THSTensor_(newCSR)(THSTensor *self) {
+  THArgCheck(self->coalesced, 1, "CSR row pointers need a coalesced tensor");
+  THArgCheck(self->nDimensionI >= 1, 1, "CSR row pointers need sparse dimensions");
+  if (!self->csr) {
+    THLongTensor *indices = THSTensor_(newIndices)(self);
+    THLongTensor *csr = THSTensor_(toCSR)(THLongTensor_data(indices), self->size[0], self->nnz);
+    THLongTensor_free(indices);
+    // Two products that share the matrix may build it concurrently
+    if (!THAtomicCompareAndSwapPtrdiff(
+            (ptrdiff_t volatile *)&self->csr, 0, (ptrdiff_t)csr)) {
+      THLongTensor_free(csr);
+    }
+  }
+  THLongTensor_retain(self->csr);
+  return self->csr;
+}
+
 void THSTensor_(spaddmm)(THTensor *r_,
     real beta, THTensor *t,
     real alpha, THSTensor *sparse_, THTensor *dense) {
@@ -337,7 +372,7 @@ void THSTensor_(spaddmm)(THTensor *r_,
   indices = THSTensor_(newIndices)(sparse);
   values  = THSTensor_(newValues)(sparse);
 
-  csr = THSTensor_(toCSR)(THLongTensor_data(indices), dim_i, nnz);
+  csr = THSTensor_(newCSR)(sparse);
 
   // r_ = alpha * sparse * dense
   if (beta == 0) {
@@ -349,7 +384,9 @@ void THSTensor_(spaddmm)(THTensor *r_,
   } else {
     THTensor_(mul)(r_, t, beta);
   }
-#pragma omp parallel for private(h, i) schedule(static) if (nnz > 10000)
+  // The rows of a graph adjacency have very different lengths, so they are
+  // handed out in small chunks rather than split evenly between threads
+#pragma omp parallel for private(h, i) schedule(dynamic, 16) if (nnz * dim_k > 10000)
   for (h = 0; h < dim_i; h++) {
     int64_t i_start = THTensor_fastGet1d(csr, h);
     int64_t i_end = THTensor_fastGet1d(csr, h+1);
@@ -410,7 +447,7 @@ void THSTensor_(sspaddmm)(THSTensor *r_,
   indices = THSTensor_(newIndices)(sparse);
   values  = THSTensor_(newValues)(sparse);
 
-  csr = THSTensor_(toCSR)(THLongTensor_data(indices), dim_i, nnz);
+  csr = THSTensor_(newCSR)(sparse);
 
   t_nnz = THSTensor_(nnz)(t);
   r_nnz = nnz * dim_k + t_nnz;
@@ -6,12 +6,16 @@ VALGRIND=${VALGRIND:=ON}
 BUILD_ROOT=$1
 $BUILD_ROOT/src/ATen/test/basic
 $BUILD_ROOT/src/ATen/test/atest
+$BUILD_ROOT/src/ATen/test/apply_utils_test
 $BUILD_ROOT/src/ATen/test/scalar_test
 $BUILD_ROOT/src/ATen/test/broadcast_test
 $BUILD_ROOT/src/ATen/test/wrapdim_test
 $BUILD_ROOT/src/ATen/test/dlconvertor_test
 $BUILD_ROOT/src/ATen/test/native_test
+$BUILD_ROOT/src/ATen/test/binary_ops_test
+$BUILD_ROOT/src/ATen/test/reduce_ops_test
 $BUILD_ROOT/src/ATen/test/scalar_tensor_test
+$BUILD_ROOT/src/ATen/test/unary_ops_test
 $BUILD_ROOT/src/ATen/test/undefined_tensor_test
 if [[ -x $BUILD_ROOT/src/ATen/test/cudnn_test ]]; then
   $BUILD_ROOT/src/ATen/test/cudnn_test
@@ -0,0 +1,46 @@
+"""Microbenchmark of the per-call overhead of binding Python arguments.
+
+Times calls on tiny CPU tensors, whose cost is dominated by argument
+parsing and dispatch rather than by the operation itself. The cases cover
+single signatures, overloads resolved by argument type (add with a Tensor
+or a number), keyword arguments and var-args IntLists.
+
+    python benchmarks/arg_parser.py [--iters N] [--repeat R]
+"""
+import argparse
+import timeit
+
+import torch
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--iters', type=int, default=100000)
+    parser.add_argument('--repeat', type=int, default=5)
+    args = parser.parse_args()
+
+    x = torch.randn(1)
+    y = torch.randn(1)
+    m = torch.randn(2, 3)
+    cases = [
+        ('x.neg()', lambda: x.neg()),
+        ('x.add(y)', lambda: x.add(y)),
+        ('x.add(1)', lambda: x.add(1)),
+        ('x.add(y, alpha=2)', lambda: x.add(y, alpha=2)),
+        ('torch.add(x, y)', lambda: torch.add(x, y)),
+        ('torch.add(x, 1)', lambda: torch.add(x, 1)),
+        ('m.sum(0)', lambda: m.sum(0)),
+        ('m.sum(dim=0)', lambda: m.sum(dim=0)),
+        ('m.view(3, 2)', lambda: m.view(3, 2)),
+        ('m.view((3, 2))', lambda: m.view((3, 2))),
+    ]
+
+    print('{:<20} {:>10}'.format('call', 'us'))
+    for name, fn in cases:
+        fn()
+        t = min(timeit.repeat(fn, number=args.iters, repeat=args.repeat)) / args.iters
+        print('{:<20} {:>10.3f}'.format(name, t * 1e6))
+
+
+if __name__ == '__main__':
+    main()
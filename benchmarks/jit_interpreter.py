@@ -0,0 +1,80 @@
+"""Microbenchmark of JIT interpreter overhead.
+
+Runs functions made of many cheap operations on tiny tensors, where the time
+spent in the interpreter dominates, once with register instructions (the
+default) and once with PYTORCH_JIT_STACK_INTERPRETER=1. 'traced' is straight
+line code, 'loop' is a script loop with loop-carried values.
+
+    python benchmarks/jit_interpreter.py [--iters N] [--ops N]
+"""
+import argparse
+import os
+import subprocess
+import sys
+import timeit
+
+import torch
+from torch.autograd import Variable
+
+
+def make_fn(num_ops):
+    def fn(x, y):
+        for i in range(num_ops // 2):
+            x = x * y
+            y = y + x
+        return x, y
+    return fn
+
+
+def loop(i, n, a, b):
+    while i < n:
+        c = a + b
+        a = b
+        b = c
+        i = i + 1
+    return a, b
+
+
+def run(args):
+    compiled = torch.jit.compile(make_fn(args.ops), nderivs=0, optimize=False)
+    x = Variable(torch.ones(1))
+    y = Variable(torch.ones(1) * 0.5)
+    compiled(x, y)  # trace and compile
+    traced = timeit.repeat(lambda: compiled(x, y), number=args.iters, repeat=args.repeat)
+
+    scripted = torch.jit.script(loop)
+    loop_args = [torch.tensor(v, dtype=torch.int) for v in [0, args.ops // 4, 0, 1]]
+    scripted(*loop_args)
+    looped = timeit.repeat(lambda: scripted(*loop_args), number=args.iters, repeat=args.repeat)
+    return min(traced) / args.iters, min(looped) / args.iters
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--iters', type=int, default=1000)
+    parser.add_argument('--repeat', type=int, default=5)
+    parser.add_argument('--ops', type=int, default=100)
+    parser.add_argument('--single', action='store_true',
+                        help='only time the mode selected by the environment')
+    args = parser.parse_args()
+
+    if args.single:
+        print(' '.join(str(t) for t in run(args)))
+        return
+
+    results = {}
+    for mode, stack in [('stack', '1'), ('register', '0')]:
+        env = dict(os.environ, PYTORCH_JIT_STACK_INTERPRETER=stack)
+        out = subprocess.check_output([sys.executable, __file__, '--single',
+                                       '--iters', str(args.iters),
+                                       '--repeat', str(args.repeat),
+                                       '--ops', str(args.ops)], env=env)
+        results[mode] = [float(t) for t in out.decode().strip().splitlines()[-1].split()]
+    for i, workload in enumerate(['traced', 'loop']):
+        for mode in ['stack', 'register']:
+            print('{:>7} {:>9}: {:8.2f} us per call'.format(workload, mode, results[mode][i] * 1e6))
+        print('{:>7}   speedup: {:.2f}x'.format(workload, results['stack'][i] / results['register'][i]))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,53 @@
+"""Microbenchmark of the fixed per-op cost of eager autograd.
+
+Times ops on tiny CPU tensors, with and without inputs that require grad,
+so that the difference is the cost of recording the graph: checking the
+inputs, creating the grad_fn, collecting its next edges and saving
+variables. A full forward and backward of a small chain is timed as well.
+
+    python benchmarks/op_overhead.py [--iters N] [--repeat R]
+"""
+import argparse
+import timeit
+
+import torch
+from torch.autograd import Variable
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--iters', type=int, default=100000)
+    parser.add_argument('--repeat', type=int, default=5)
+    args = parser.parse_args()
+
+    def time_us(fn, iters):
+        fn()
+        return min(timeit.repeat(fn, number=iters, repeat=args.repeat)) / iters * 1e6
+
+    print('{:<16} {:>12} {:>16}'.format('op', 'no grad us', 'requires grad us'))
+    x, y = torch.randn(1), torch.randn(1)
+    gx = Variable(torch.randn(1), requires_grad=True)
+    gy = Variable(torch.randn(1), requires_grad=True)
+    ops = [
+        ('neg', lambda a, b: a.neg()),
+        ('add', lambda a, b: a + b),
+        ('mul', lambda a, b: a * b),
+        ('addcmul', lambda a, b: a.addcmul(a, b)),
+        ('cat', lambda a, b: torch.cat([a, b, a])),
+        ('view', lambda a, b: a.view(1, 1)),
+    ]
+    for name, op in ops:
+        plain = time_us(lambda: op(x, y), args.iters)
+        grad = time_us(lambda: op(gx, gy), args.iters)
+        print('{:<16} {:>12.3f} {:>16.3f}'.format(name, plain, grad))
+
+    def chain():
+        z = gx
+        for _ in range(10):
+            z = z * gy + gx
+        z.backward()
+    print('{:<16} {:>12} {:>16.3f}'.format('chain backward', '-', time_us(chain, args.iters // 100)))
+
+
+if __name__ == '__main__':
+    main()
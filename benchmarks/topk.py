@@ -0,0 +1,60 @@
+"""Microbenchmark of CUDA top-k and sort along the last dimension.
+
+Times torch.topk (sorted and unsorted) over a grid of (rows, length, k)
+shapes, and torch.sort over the (rows, length) ones, on float tensors on
+the current device.
+
+    python benchmarks/topk.py [--iters N] [--rows 1,64,4096] [--length 1000,100000] [--k 1,100,5000]
+"""
+import argparse
+import timeit
+
+import torch
+
+
+def int_list(s):
+    return [int(v) for v in s.split(',')]
+
+
+def time_cuda(fn, iters, repeat):
+    fn()
+    torch.cuda.synchronize()
+
+    def run():
+        for _ in range(iters):
+            fn()
+        torch.cuda.synchronize()
+    return min(timeit.repeat(run, number=1, repeat=repeat)) / iters
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--iters', type=int, default=20)
+    parser.add_argument('--repeat', type=int, default=3)
+    parser.add_argument('--rows', type=int_list, default=[1, 64, 4096])
+    parser.add_argument('--length', type=int_list, default=[1000, 10000, 100000, 1000000])
+    parser.add_argument('--k', type=int_list, default=[1, 100, 1000, 5000])
+    args = parser.parse_args()
+
+    print('{:>6} {:>8} {:>6} {:>12} {:>12} {:>12}'.format(
+        'rows', 'length', 'k', 'topk us', 'sorted us', 'sort us'))
+    for rows in args.rows:
+        for length in args.length:
+            if rows * length > 1 << 28:
+                continue
+            x = torch.randn(rows, length).cuda()
+            sort_time = time_cuda(lambda: x.sort(dim=-1, descending=True),
+                                  args.iters, args.repeat)
+            for k in args.k:
+                if k > length:
+                    continue
+                unsorted = time_cuda(lambda: x.topk(k, dim=-1, sorted=False),
+                                     args.iters, args.repeat)
+                sorted_ = time_cuda(lambda: x.topk(k, dim=-1, sorted=True),
+                                    args.iters, args.repeat)
+                print('{:>6} {:>8} {:>6} {:>12.1f} {:>12.1f} {:>12.1f}'.format(
+                    rows, length, k, unsorted * 1e6, sorted_ * 1e6, sort_time * 1e6))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,75 @@
+#include <cstdio>
+
+#include "caffe2/core/compiled_net.h"
+#include "caffe2/core/init.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/core/workspace.h"
+
+CAFFE2_DEFINE_int(num_ops, 200, "The number of operators in the net.");
+CAFFE2_DEFINE_int(num_nets, 1000, "The number of nets per iteration.");
+CAFFE2_DEFINE_int(repeat, 5, "The number of iterations.");
+CAFFE2_DEFINE_string(net_type, "simple", "The type of the net to create.");
+
+// Compares instantiating the same net over and over from its NetDef with
+// instantiating it from a CompiledNetDef, which checks the operators against
+// their schemas, parses their arguments and looks up their creators once.
+
+static caffe2::NetDef SyntheticNet() {
+  caffe2::NetDef net_def;
+  net_def.set_name("synthetic");
+  net_def.set_type(caffe2::FLAGS_net_type);
+  net_def.mutable_device_option()->set_device_type(caffe2::CPU);
+  for (int i = 0; i < caffe2::FLAGS_num_ops; ++i) {
+    const std::string blob = "x" + caffe2::to_string(i);
+    auto* fill = net_def.add_op();
+    fill->set_type("ConstantFill");
+    fill->add_output(blob);
+    auto* shape = fill->add_arg();
+    shape->set_name("shape");
+    shape->add_ints(16);
+    shape->add_ints(16);
+    auto* value = fill->add_arg();
+    value->set_name("value");
+    value->set_f(1.0f);
+    auto* relu = net_def.add_op();
+    relu->set_type("Relu");
+    relu->add_input(blob);
+    relu->add_output(blob);
+  }
+  return net_def;
+}
+
+int main(int argc, char** argv) {
+  caffe2::GlobalInit(&argc, &argv);
+  CAFFE_ENFORCE_GT(caffe2::FLAGS_num_ops, 0);
+  CAFFE_ENFORCE_GT(caffe2::FLAGS_num_nets, 0);
+  const caffe2::NetDef net_def = SyntheticNet();
+  caffe2::Workspace ws;
+  for (int iter = 0; iter < caffe2::FLAGS_repeat; ++iter) {
+    caffe2::Timer timer;
+    for (int i = 0; i < caffe2::FLAGS_num_nets; ++i) {
+      CAFFE_ENFORCE(caffe2::CreateNet(net_def, &ws));
+    }
+    const double from_def = timer.Seconds();
+
+    timer.Start();
+    caffe2::CompiledNetDef compiled(net_def);
+    const double compile = timer.Seconds();
+    timer.Start();
+    for (int i = 0; i < caffe2::FLAGS_num_nets; ++i) {
+      CAFFE_ENFORCE(compiled.CreateNet(&ws));
+    }
+    const double from_compiled = timer.Seconds();
+    printf(
+        "iteration %02d: NetDef %4.4f ms/net, compile %4.4f ms, "
+        "CompiledNetDef %4.4f ms/net (%.2fx)\n",
+        iter,
+        from_def * 1000 / caffe2::FLAGS_num_nets,
+        compile * 1000,
+        from_compiled * 1000 / caffe2::FLAGS_num_nets,
+        from_def / from_compiled);
+  }
+  return 0;
+}
@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/init.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+#include "caffe2/utils/string_utils.h"
+
+CAFFE2_DEFINE_string(operator_type, "", "The type of the operator to run.");
+CAFFE2_DEFINE_string(
+    shapes,
+    "",
+    "The input shapes to sweep. Shapes of different configurations are "
+    "separated by '|', shapes of the inputs of one configuration by ';' and "
+    "dimensions by ',', e.g. '64,256;256,256|128,512;512,512'.");
+CAFFE2_DEFINE_string(
+    dtypes,
+    "float",
+    "Comma separated input types to sweep (float, double, float16, int, "
+    "int64, uint8). Inputs are filled as floats and cast.");
+CAFFE2_DEFINE_string(
+    devices,
+    "CPU",
+    "Comma separated devices to sweep (CPU, CUDA). CUDA is skipped if the "
+    "binary has no CUDA runtime.");
+CAFFE2_DEFINE_string(
+    engines,
+    "DEFAULT",
+    "Comma separated engines to sweep, e.g. 'DEFAULT,NNPACK,CUDNN'. Engines "
+    "that are not registered for the operator on a device are skipped.");
+CAFFE2_DEFINE_string(
+    args,
+    "",
+    "Comma separated arguments of the operator, as name=value. Values are "
+    "parsed as int, then float, then taken as a string; use ':' to separate "
+    "the items of a list of ints or floats, e.g. 'kernel=3,pads=1:1:1:1'.");
+CAFFE2_DEFINE_int(num_outputs, 1, "The number of outputs of the operator.");
+CAFFE2_DEFINE_double(fill_min, -1, "The lower bound of the input values.");
+CAFFE2_DEFINE_double(fill_max, 1, "The upper bound of the input values.");
+CAFFE2_DEFINE_int(warmup, 10, "The number of iterations to warm up.");
+CAFFE2_DEFINE_int(iter, 100, "The number of iterations to time.");
+CAFFE2_DEFINE_string(
+    json,
+    "",
+    "If set, the results are also written to this file as JSON, one object "
+    "per configuration, for regression tracking.");
+
+CAFFE2_DECLARE_bool(caffe2_disable_implicit_engine_preference);
+
+// Benchmarks a single operator in isolation: for every combination of input
+// shapes, input type, device and engine, it times the operator on its own
+// and reports the median and 99th percentile latency, as well as the
+// throughput in GFLOP/s and GB/s for operators with a cost inference
+// function.
+
+using std::string;
+using std::vector;
+
+namespace {
+
+struct BenchmarkResult {
+  string device;
+  string engine;
+  string dtype;
+  string shapes;
+  bool ok = false;
+  string error;
+  double median_us = 0;
+  double p99_us = 0;
+  uint64_t flops = 0;
+  uint64_t bytes_moved = 0;
+};
+
+caffe2::TensorProto::DataType ParseDataType(const string& name) {
+  static const std::map<string, caffe2::TensorProto::DataType> types{
+      {"float", caffe2::TensorProto::FLOAT},
+      {"double", caffe2::TensorProto::DOUBLE},
+      {"float16", caffe2::TensorProto::FLOAT16},
+      {"int", caffe2::TensorProto::INT32},
+      {"int64", caffe2::TensorProto::INT64},
+      {"uint8", caffe2::TensorProto::UINT8},
+  };
+  auto it = types.find(name);
+  CAFFE_ENFORCE(it != types.end(), "Unknown dtype: ", name);
+  return it->second;
+}
+
+caffe2::DeviceType ParseDevice(const string& name) {
+  if (name == "CPU") {
+    return caffe2::CPU;
+  }
+  CAFFE_ENFORCE_EQ(name, "CUDA", "Unknown device: ", name);
+  return caffe2::CUDA;
+}
+
+vector<vector<caffe2::TIndex>> ParseShapes(const string& config) {
+  vector<vector<caffe2::TIndex>> shapes;
+  for (const auto& shape : caffe2::split(';', config)) {
+    vector<caffe2::TIndex> dims;
+    for (const auto& dim : caffe2::split(',', shape)) {
+      dims.push_back(std::stoll(dim));
+    }
+    shapes.push_back(dims);
+  }
+  return shapes;
+}
+
+bool ParseNumber(const string& value, float* f, bool* is_int) {
+  std::istringstream in(value);
+  double number;
+  if (!(in >> number) || !in.eof()) {
+    return false;
+  }
+  *f = number;
+  *is_int = value.find_first_of(".eE") == string::npos;
+  return true;
+}
+
+void AddArguments(const string& spec, caffe2::OperatorDef* def) {
+  if (spec.empty()) {
+    return;
+  }
+  for (const auto& item : caffe2::split(',', spec)) {
+    auto pos = item.find('=');
+    CAFFE_ENFORCE(pos != string::npos, "Argument without value: ", item);
+    auto* arg = def->add_arg();
+    arg->set_name(item.substr(0, pos));
+    const string value = item.substr(pos + 1);
+    const auto items = caffe2::split(':', value);
+    vector<float> numbers;
+    bool all_ints = true;
+    for (const auto& v : items) {
+      float f;
+      bool is_int;
+      if (!ParseNumber(v, &f, &is_int)) {
+        break;
+      }
+      numbers.push_back(f);
+      all_ints = all_ints && is_int;
+    }
+    if (numbers.size() != items.size()) {
+      arg->set_s(value);
+    } else if (items.size() == 1 && all_ints) {
+      arg->set_i(std::stoll(value));
+    } else if (items.size() == 1) {
+      arg->set_f(numbers[0]);
+    } else if (all_ints) {
+      for (const auto& v : items) {
+        arg->add_ints(std::stoll(v));
+      }
+    } else {
+      for (auto f : numbers) {
+        arg->add_floats(f);
+      }
+    }
+  }
+}
+
+// Fills the inputs on the device of the operator: uniform floats, cast to
+// the benchmarked type if needed.
+void FillInputs(
+    const vector<vector<caffe2::TIndex>>& shapes,
+    caffe2::TensorProto::DataType dtype,
+    const caffe2::DeviceOption& device_option,
+    caffe2::Workspace* ws) {
+  caffe2::NetDef fill_net;
+  fill_net.set_name("fill_inputs");
+  for (int i = 0; i < shapes.size(); ++i) {
+    const string input = "X" + caffe2::to_string(i);
+    auto* fill = fill_net.add_op();
+    fill->set_type("UniformFill");
+    fill->add_output(input);
+    fill->mutable_device_option()->CopyFrom(device_option);
+    auto* shape = fill->add_arg();
+    shape->set_name("shape");
+    for (auto d : shapes[i]) {
+      shape->add_ints(d);
+    }
+    auto* min = fill->add_arg();
+    min->set_name("min");
+    min->set_f(caffe2::FLAGS_fill_min);
+    auto* max = fill->add_arg();
+    max->set_name("max");
+    max->set_f(caffe2::FLAGS_fill_max);
+    if (dtype != caffe2::TensorProto::FLOAT) {
+      auto* cast = fill_net.add_op();
+      cast->set_type("Cast");
+      cast->add_input(input);
+      cast->add_output(input);
+      cast->mutable_device_option()->CopyFrom(device_option);
+      auto* to = cast->add_arg();
+      to->set_name("to");
+      to->set_i(dtype);
+    }
+  }
+  CAFFE_ENFORCE(ws->RunNetOnce(fill_net), "Could not fill the inputs");
+}
+
+void Benchmark(
+    const vector<vector<caffe2::TIndex>>& shapes,
+    const string& dtype_name,
+    caffe2::DeviceType device,
+    const string& engine,
+    BenchmarkResult* result) {
+  caffe2::Workspace ws;
+  caffe2::DeviceOption device_option;
+  device_option.set_device_type(device);
+  const auto dtype = ParseDataType(dtype_name);
+  FillInputs(shapes, dtype, device_option, &ws);
+
+  caffe2::OperatorDef def;
+  def.set_type(caffe2::FLAGS_operator_type);
+  def.mutable_device_option()->CopyFrom(device_option);
+  if (engine != "DEFAULT") {
+    def.set_engine(engine);
+  }
+  for (int i = 0; i < shapes.size(); ++i) {
+    def.add_input("X" + caffe2::to_string(i));
+  }
+  for (int i = 0; i < caffe2::FLAGS_num_outputs; ++i) {
+    def.add_output("Y" + caffe2::to_string(i));
+  }
+  AddArguments(caffe2::FLAGS_args, &def);
+
+  auto op = caffe2::CreateOperator(def, &ws);
+  // engines that do not support the arguments fall back to the default one
+  CAFFE_ENFORCE(
+      engine == "DEFAULT" || op->engine() == engine,
+      "Engine ",
+      engine,
+      " does not support this configuration");
+  for (int i = 0; i < caffe2::FLAGS_warmup; ++i) {
+    CAFFE_ENFORCE(op->Run(), "Warmup run ", i, " has failed.");
+  }
+  vector<double> times;
+  times.reserve(caffe2::FLAGS_iter);
+  for (int i = 0; i < caffe2::FLAGS_iter; ++i) {
+    caffe2::Timer timer;
+    CAFFE_ENFORCE(op->Run(), "Run ", i, " has failed.");
+    times.push_back(timer.MicroSeconds());
+  }
+  std::sort(times.begin(), times.end());
+  result->median_us = times[times.size() / 2];
+  result->p99_us = times[std::min<size_t>(
+      times.size() - 1, static_cast<size_t>(times.size() * 0.99))];
+
+  const auto* schema = caffe2::OpSchemaRegistry::Schema(def.type());
+  if (schema && schema->HasCostInferenceFunction()) {
+    vector<caffe2::TensorShape> input_shapes;
+    for (int i = 0; i < shapes.size(); ++i) {
+      input_shapes.push_back(caffe2::GetTensorShapeOfBlob(
+          ws.GetBlob("X" + caffe2::to_string(i))));
+    }
+    auto cost = schema->InferCost(def, input_shapes);
+    result->flops = cost.flops;
+    result->bytes_moved = cost.bytes_moved;
+  }
+  result->ok = true;
+}
+
+string JsonString(const string& s) {
+  std::ostringstream out;
+  out << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (c == '\n') {
+      out << "\\n";
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+  return out.str();
+}
+
+void WriteJson(const vector<BenchmarkResult>& results, const string& path) {
+  std::ofstream out(path);
+  CAFFE_ENFORCE(out.good(), "Cannot open ", path);
+  out << "[\n";
+  for (int i = 0; i < results.size(); ++i) {
+    const auto& r = results[i];
+    out << "  {\"operator\": " << JsonString(caffe2::FLAGS_operator_type)
+        << ", \"device\": " << JsonString(r.device)
+        << ", \"engine\": " << JsonString(r.engine)
+        << ", \"dtype\": " << JsonString(r.dtype)
+        << ", \"shapes\": " << JsonString(r.shapes)
+        << ", \"ok\": " << (r.ok ? "true" : "false");
+    if (r.ok) {
+      out << ", \"median_us\": " << r.median_us
+          << ", \"p99_us\": " << r.p99_us << ", \"flops\": " << r.flops
+          << ", \"bytes_moved\": " << r.bytes_moved;
+    } else {
+      out << ", \"error\": " << JsonString(r.error);
+    }
+    out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  out << "]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  caffe2::GlobalInit(&argc, &argv);
+  CAFFE_ENFORCE(
+      !caffe2::FLAGS_operator_type.empty(), "--operator_type is required");
+  CAFFE_ENFORCE(!caffe2::FLAGS_shapes.empty(), "--shapes is required");
+  CAFFE_ENFORCE_GT(caffe2::FLAGS_iter, 0);
+  // DEFAULT benchmarks the default implementation, not a preferred engine
+  caffe2::FLAGS_caffe2_disable_implicit_engine_preference = true;
+
+  vector<BenchmarkResult> results;
+  printf(
+      "%-6s %-10s %-8s %-30s %12s %12s %10s %10s\n",
+      "device",
+      "engine",
+      "dtype",
+      "shapes",
+      "median (us)",
+      "p99 (us)",
+      "GFLOP/s",
+      "GB/s");
+  for (const auto& device_name : caffe2::split(',', caffe2::FLAGS_devices)) {
+    const auto device = ParseDevice(device_name);
+    if (device == caffe2::CUDA && !caffe2::HasCudaRuntime()) {
+      LOG(WARNING) << "No CUDA runtime, skipping CUDA.";
+      continue;
+    }
+    auto* registry = caffe2::gDeviceTypeRegistry()->at(device);
+    for (const auto& engine : caffe2::split(',', caffe2::FLAGS_engines)) {
+      if (!registry->Has(
+              caffe2::OpRegistryKey(caffe2::FLAGS_operator_type, engine))) {
+        LOG(INFO) << "Engine " << engine << " of "
+                  << caffe2::FLAGS_operator_type << " is not registered on "
+                  << device_name << ", skipping.";
+        continue;
+      }
+      for (const auto& dtype : caffe2::split(',', caffe2::FLAGS_dtypes)) {
+        for (const auto& config : caffe2::split('|', caffe2::FLAGS_shapes)) {
+          BenchmarkResult result;
+          result.device = device_name;
+          result.engine = engine;
+          result.dtype = dtype;
+          result.shapes = config;
+          try {
+            Benchmark(ParseShapes(config), dtype, device, engine, &result);
+          } catch (const std::exception& e) {
+            result.error = e.what();
+          }
+          if (result.ok) {
+            const double seconds = result.median_us * 1e-6;
+            printf(
+                "%-6s %-10s %-8s %-30s %12.2f %12.2f %10.2f %10.2f\n",
+                device_name.c_str(),
+                engine.c_str(),
+                dtype.c_str(),
+                config.c_str(),
+                result.median_us,
+                result.p99_us,
+                result.flops / seconds * 1e-9,
+                result.bytes_moved / seconds * 1e-9);
+          } else {
+            printf(
+                "%-6s %-10s %-8s %-30s failed: %s\n",
+                device_name.c_str(),
+                engine.c_str(),
+                dtype.c_str(),
+                config.c_str(),
+                result.error.substr(0, result.error.find('\n')).c_str());
+          }
+          results.push_back(result);
+        }
+      }
+    }
+  }
+  if (!caffe2::FLAGS_json.empty()) {
+    WriteJson(results, caffe2::FLAGS_json);
+  }
+  return 0;
+}
@@ -0,0 +1,94 @@
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "caffe2/core/init.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/utils/thread_pool.h"
+
+CAFFE2_DEFINE_int(pool_size, 8, "The number of worker threads.");
+CAFFE2_DEFINE_int(num_producers, 4, "The number of threads posting tasks.");
+CAFFE2_DEFINE_int(num_tasks, 1000000, "The number of tasks per iteration.");
+CAFFE2_DEFINE_int(task_work, 100, "The number of loop iterations per task.");
+CAFFE2_DEFINE_int(queue_size, 4096, "The size of the lock-free queue.");
+CAFFE2_DEFINE_int(repeat, 5, "The number of iterations per queue type.");
+
+// Compares the mutex-guarded and the lock-free TaskThreadPool on many tiny
+// tasks, posted both from outside of the pool and by tasks themselves (the
+// way async nets schedule the children of a finished chain).
+
+static std::atomic<int> sink;
+
+static void Work() {
+  int x = 0;
+  for (int i = 0; i < caffe2::FLAGS_task_work; ++i) {
+    x += i * i;
+  }
+  sink += x;
+}
+
+static double RunExternalProducers(caffe2::TaskThreadPool& pool) {
+  caffe2::Timer timer;
+  std::vector<std::thread> producers;
+  const int tasks_per_producer =
+      caffe2::FLAGS_num_tasks / caffe2::FLAGS_num_producers;
+  for (int p = 0; p < caffe2::FLAGS_num_producers; ++p) {
+    producers.emplace_back([&pool, tasks_per_producer]() {
+      for (int i = 0; i < tasks_per_producer; ++i) {
+        pool.run(Work);
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  pool.waitWorkComplete();
+  return timer.Seconds();
+}
+
+static double RunChainedTasks(caffe2::TaskThreadPool& pool) {
+  // every task posts the next one of its chain, one chain per worker
+  caffe2::Timer timer;
+  const int chain_length = caffe2::FLAGS_num_tasks / caffe2::FLAGS_pool_size;
+  std::function<void(int)> step = [&pool, &step](int remaining) {
+    Work();
+    if (remaining > 0) {
+      pool.run([&step, remaining]() { step(remaining - 1); });
+    }
+  };
+  for (int c = 0; c < caffe2::FLAGS_pool_size; ++c) {
+    pool.run([&step, chain_length]() { step(chain_length - 1); });
+  }
+  pool.waitWorkComplete();
+  return timer.Seconds();
+}
+
+static void Benchmark(const char* name, size_t lock_free_capacity) {
+  caffe2::TaskThreadPool pool(
+      caffe2::FLAGS_pool_size, -1, lock_free_capacity);
+  for (int iter = 0; iter < caffe2::FLAGS_repeat; ++iter) {
+    double external = RunExternalProducers(pool);
+    double chained = RunChainedTasks(pool);
+    printf(
+        "%-10s iteration %02d: external producers %4.4f s (%.0f tasks/s), "
+        "chained %4.4f s (%.0f tasks/s)\n",
+        name,
+        iter,
+        external,
+        caffe2::FLAGS_num_tasks / external,
+        chained,
+        caffe2::FLAGS_num_tasks / chained);
+  }
+}
+
+int main(int argc, char** argv) {
+  caffe2::GlobalInit(&argc, &argv);
+  CAFFE_ENFORCE_GT(caffe2::FLAGS_pool_size, 0);
+  CAFFE_ENFORCE_GT(caffe2::FLAGS_num_producers, 0);
+  CAFFE_ENFORCE_GT(caffe2::FLAGS_queue_size, 0);
+  Benchmark("mutex", 0);
+  Benchmark("lock-free", caffe2::FLAGS_queue_size);
+  return 0;
+}
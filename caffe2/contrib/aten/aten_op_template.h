@@ -1,6 +1,10 @@
 #pragma once
 #include <unordered_map>
 #include <string>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 #include <ATen/ATen.h>
 #include <caffe2/core/context.h>
 #include <caffe2/core/operator.h>
@@ -57,9 +61,72 @@ private:
   at::Type & typeFor(const Tensor<Context> & ten) {
     return at::getType(backend(), atScalarTypeFor(ten.meta()));
   }
+  // Hands out the memory of a caffe2 output as the storage of an ATen tensor,
+  // so that _out variants write their result straight into the output blob.
+  // Each allocation keeps a tensor sharing the data of the output, so the
+  // memory stays valid for as long as ATen uses it, even if the output is
+  // resized or reallocated in the meantime.
+  struct OutputAllocator final : public at::Allocator {
+    OutputAllocator(Tensor<Context>* dst, const TypeMeta& meta)
+    : dst(dst), meta(meta) {}
+    void* allocate(std::size_t n) const override {
+      if (n == 0) {
+        return nullptr;
+      }
+      dst->Resize(static_cast<TIndex>(n / meta.itemsize()));
+      void* data = dst->raw_mutable_data(meta);
+      std::unique_ptr<Tensor<Context>> holder(new Tensor<Context>());
+      holder->ResizeLike(*dst);
+      holder->ShareData(*dst);
+      std::lock_guard<std::mutex> lock(mutex);
+      holders.emplace_back(data, std::move(holder));
+      return data;
+    }
+    void deallocate(void* ptr) const override {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (auto it = holders.begin(); it != holders.end(); ++it) {
+        if (it->first == ptr) {
+          holders.erase(it);
+          return;
+        }
+      }
+    }
+  private:
+    Tensor<Context>* dst;
+    TypeMeta meta;
+    mutable std::mutex mutex;
+    mutable std::vector<std::pair<void*, std::unique_ptr<Tensor<Context>>>> holders;
+  };
+
   at::Tensor tensorWrapping(const Tensor<Context>& ten_) {
     auto& ten = const_cast<Tensor<Context>&>(ten_);
-    return typeFor(ten).tensorFromBlob(ten.raw_mutable_data(), ten.dims());
+    void* data = ten.raw_mutable_data();
+    // the ATen tensor shares the memory of the input, so results that are
+    // views of it stay valid after the input blob is overwritten
+    auto owner = std::make_shared<Tensor<Context>>();
+    owner->ResizeLike(ten);
+    owner->ShareData(ten);
+    return typeFor(ten).tensorFromBlob(data, ten.dims(), [owner](void*) mutable {
+      owner.reset();
+    });
+  }
+  // an empty tensor of the given type whose storage is allocated in Output(i)
+  at::Tensor allocateOutput(size_t i, at::Type & type) {
+    auto allocator = std::unique_ptr<at::Allocator>(
+        new OutputAllocator(Output(i), typeMetaFor(type.scalarType())));
+    return type.tensorWithAllocator({0}, std::move(allocator));
+  }
+  // outputs can only be computed in place if none of them is also an input,
+  // as the kernel would otherwise overwrite its own arguments
+  bool canComputeOutputsInPlace() {
+    for (auto output : OperatorBase::Outputs()) {
+      for (auto input : OperatorBase::Inputs()) {
+        if (output == input) {
+          return false;
+        }
+      }
+    }
+    return true;
   }
   at::Tensor loadInput(size_t i) {
     return tensorWrapping(Input(i));
@@ -81,9 +148,29 @@ private:
     CAFFE_THROW("Unknown type meta"); // TODO: improve error message...
   }
   void assignTo(Tensor<Context> * dst, const at::Tensor & src_) {
-    at::Tensor src = src_.contiguous();
-    auto at_sizes = src.sizes();
+    auto at_sizes = src_.sizes();
     std::vector<int64_t> dims(at_sizes.begin(),at_sizes.end());
+    auto meta = typeMetaFor(src_);
+    if (src_.is_contiguous() && src_.numel() > 0 &&
+        src_.numel() == dst->size() && dst->meta() == meta &&
+        src_.data_ptr() == dst->raw_mutable_data(meta)) {
+      // already computed in the output by an _out variant
+      dst->Reshape(dims);
+      return;
+    }
+    if (!src_.is_contiguous() && src_.numel() > 0) {
+      // copy straight into the memory of the output rather than into a
+      // contiguous ATen tensor, unless the output shares memory with src
+      dst->Resize(dims);
+      auto begin = static_cast<char*>(src_.storage()->data());
+      auto end = begin + src_.storage()->size() * meta.itemsize();
+      auto data = static_cast<char*>(dst->raw_mutable_data(meta));
+      if (data + dst->nbytes() <= begin || data >= end) {
+        typeFor(*dst).tensorFromBlob(data, dims).copy_(src_);
+        return;
+      }
+    }
+    at::Tensor src = src_.contiguous();
     dst->Resize(dims);
     dst->ShareExternalPointer(
         src.data_ptr(), typeMetaFor(src), 0, [src](void* ptr) mutable {
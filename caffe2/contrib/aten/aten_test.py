@@ -28,6 +28,30 @@ class TestATen(hu.HypothesisTestCase):
             return [X + Y]
         self.assertReferenceChecks(gc, op, inputs, ref)
 
+    @given(inputs=hu.tensors(n=2), **hu.gcs)
+    def test_add_inplace(self, inputs, gc, dc):
+        op = core.CreateOperator(
+             "ATen",
+             ["X", "Y"],
+             ["X"],
+             operator="add")
+
+        def ref(X, Y):
+            return [X + Y]
+        self.assertReferenceChecks(gc, op, inputs, ref)
+
+    @given(inputs=hu.tensors(n=1, min_dim=2, max_dim=2), **hu.gcs)
+    def test_t(self, inputs, gc, dc):
+        op = core.CreateOperator(
+             "ATen",
+             ["X"],
+             ["Z"],
+             operator="t")
+
+        def ref(X):
+            return [X.T]
+        self.assertReferenceChecks(gc, op, inputs, ref)
+
     @given(inputs=hu.tensors(n=1), **hu.gcs)
     def test_pow(self, inputs, gc, dc):
         op = core.CreateOperator(
@@ -110,8 +110,9 @@ def supports(o):
     if o['inplace']:
         return False
 
-    # _out variants also work in-place on arguments taken as destinations
-    # we also cannot handle these because aten cannot resize caffe2 Tensors
+    # _out variants take their destinations as arguments. They are not
+    # operators of their own, but are used to compute the outputs of the
+    # corresponding function in place (see [OUT VARIANTS])
     if "_out" in o['name']:
         return False
 
@@ -150,6 +151,58 @@ case ${key}: { // ${name}
 """)
 
 
+# [OUT VARIANTS]
+# when a function has an _out variant, the operator allocates the outputs
+# in the memory of the caffe2 output blobs (see allocateOutput) and calls the
+# variant, so that the results need neither a copy nor an ATen allocation.
+# It falls back to the function when an output blob is also an input.
+OUT_OPTION_TEMPLATE = CT("""\
+case ${key}: { // ${name}
+    ${initialization}
+    run_op = [=] {
+        ${statements}
+        if (canComputeOutputsInPlace()) {
+            ${out_statements}
+            ${out_invocation};
+            ${out_assignments}
+        } else {
+            auto the_result = ${invocation};
+            ${assignments}
+        }
+        return true;
+    };
+} break;
+""")
+
+# dynamic types of _out destinations, and how to get their type from the
+# type inferred for the operator
+OUT_TYPE_MAP = {
+    'Tensor': '*inferred_type',
+    'IndexTensor': 'inferred_type->toScalarType(at::kLong)',
+}
+
+
+def out_variant_key(name, arguments):
+    return (name, tuple(a['name'] for a in arguments if not a.get('output')))
+
+
+def find_out_variants(decls):
+    variants = {}
+    for o in decls:
+        if not o['name'].endswith('_out') or o['inplace']:
+            continue
+        if 'namespace' not in o['method_of']:
+            continue
+        outputs = [a for a in o['arguments'] if a.get('output')]
+        if not all(value_is_tensor_type(a) and a['dynamic_type'] in OUT_TYPE_MAP
+                   for a in outputs):
+            continue
+        for expanded in expand(o):
+            key = out_variant_key(o['name'][:-len('_out')], expanded['arguments'])
+            variants[key] = expanded
+    return variants
+
+
 def get_output(o, i):
     if len(o['returns']) == 1:
         return 'the_result'
@@ -183,6 +236,7 @@ def get_num_inputs(o):
 if __name__ == '__main__':
     decls = yaml.load(read(os.path.join(args.yaml_dir, 'Declarations.yaml')), Loader=Loader)
     filtered = [expanded for o in decls for expanded in expand(o) if supports(expanded)]
+    out_variants = find_out_variants(decls)
     top_env = {
         'mappings': [],
         'implementations': [],
@@ -217,6 +271,7 @@ if __name__ == '__main__':
             'key': str(key),
         }
         defined_inferred_type = False
+        out_variant = out_variants.get(out_variant_key(o['name'], o['arguments']))
 
         if 'Tensor' in o['method_of']:
             # make sure 'self' is the first argument. currently Declarations.yaml
@@ -269,6 +324,25 @@ if __name__ == '__main__':
             env['invocation'] = CT(
                 'inferred_type->${name}(${arguments})').substitute(env)
 
+        if out_variant is not None and defined_inferred_type:
+            outputs = [a for a in out_variant['arguments'] if a.get('output')]
+            if len(outputs) == len(o['returns']) and \
+                    all(value_is_tensor_type(r) for r in o['returns']):
+                env['out_statements'] = []
+                env['out_assignments'] = []
+                for i, arg in enumerate(outputs):
+                    env['out_statements'].append(
+                        'auto {} = allocateOutput({}, {});'.format(
+                            arg['name'], i, OUT_TYPE_MAP[arg['dynamic_type']]))
+                    env['out_assignments'].append(
+                        'assignTo(Output({}),{});'.format(i, arg['name']))
+                env['out_invocation'] = 'at::{}({})'.format(
+                    out_variant['name'],
+                    ', '.join(a['name'] for a in out_variant['arguments']))
+                top_env['implementations'].append(OUT_OPTION_TEMPLATE.substitute(env))
+                key += 1
+                continue
+
         top_env['implementations'].append(OPTION_TEMPLATE.substitute(env))
         key += 1
     write(os.path.join(args.install_dir, args.output_prefix + "aten_op.h"), OP_TEMPLATE.substitute(top_env))
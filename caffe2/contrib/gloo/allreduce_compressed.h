@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "caffe2/core/logging.h"
+
+#include <gloo/algorithm.h>
+#include <gloo/allgather_ring.h>
+#include <gloo/context.h>
+#include <gloo/types.h>
+
+namespace caffe2 {
+namespace gloo {
+
+// Allreduce of float buffers that sends half precision values. The buffers
+// are summed locally, the sum is rounded to float16, all-reduced by the
+// algorithm that makeAlgorithm builds for the half precision buffer, and
+// widened back into every buffer. This halves the bytes that go over the
+// network at the cost of float16 precision and range in the reduced sum.
+class AllreduceHalfPrecision : public ::gloo::Algorithm {
+ public:
+  using Factory = std::function<std::unique_ptr<::gloo::Algorithm>(
+      const std::vector<::gloo::float16*>&)>;
+
+  AllreduceHalfPrecision(
+      const std::shared_ptr<::gloo::Context>& context,
+      const std::vector<float*>& ptrs,
+      size_t count,
+      const Factory& makeAlgorithm)
+      : ::gloo::Algorithm(context), ptrs_(ptrs), count_(count), half_(count) {
+    algorithm_ = makeAlgorithm({half_.data()});
+  }
+
+  void run() override {
+    // Reduce specified pointers into ptrs_[0]
+    for (size_t i = 1; i < ptrs_.size(); i++) {
+      ::gloo::ReductionFunction<float>::sum->call(ptrs_[0], ptrs_[i], count_);
+    }
+
+    for (size_t i = 0; i < count_; i++) {
+      half_[i] = ::gloo::cpu_float2half_rn(ptrs_[0][i]);
+    }
+    algorithm_->run();
+    for (size_t i = 0; i < count_; i++) {
+      ptrs_[0][i] = ::gloo::cpu_half2float(half_[i]);
+    }
+
+    // Broadcast ptrs_[0]
+    for (size_t i = 1; i < ptrs_.size(); i++) {
+      memcpy(ptrs_[i], ptrs_[0], count_ * sizeof(float));
+    }
+  }
+
+  size_t compressedBytes() const {
+    return count_ * sizeof(::gloo::float16);
+  }
+
+ protected:
+  std::vector<float*> ptrs_;
+  const size_t count_;
+  std::vector<::gloo::float16> half_;
+  std::unique_ptr<::gloo::Algorithm> algorithm_;
+};
+
+// Sparse allreduce of float buffers with error feedback. Every run, each rank
+// adds the residual it kept from earlier runs to the local sum of its buffers
+// and only sends the k = ceil(ratio * count) entries of largest magnitude,
+// as index and value pairs. Everything it did not send becomes its new
+// residual, so no part of a gradient is dropped, only delayed. The pairs of
+// all ranks are allgathered and summed, in order of rank so that all ranks
+// end up with identical buffers, into an otherwise zero result.
+//
+// With a ratio of 1 every entry is sent and the result is the exact sum.
+class AllreduceTopK : public ::gloo::Algorithm {
+ public:
+  AllreduceTopK(
+      const std::shared_ptr<::gloo::Context>& context,
+      const std::vector<float*>& ptrs,
+      size_t count,
+      float ratio)
+      : ::gloo::Algorithm(context),
+        ptrs_(ptrs),
+        count_(count),
+        k_(std::min(
+            count,
+            std::max(size_t(1), size_t(std::ceil(ratio * count))))),
+        residual_(count, 0),
+        order_(count),
+        indices_(k_),
+        values_(k_),
+        gatheredIndices_(k_ * this->contextSize_),
+        gatheredValues_(k_ * this->contextSize_) {
+    CAFFE_ENFORCE(ratio > 0 && ratio <= 1, "Invalid top-k ratio: ", ratio);
+    CAFFE_ENFORCE_LE(count, size_t(std::numeric_limits<int>::max()));
+    indicesAllgather_.reset(new ::gloo::AllgatherRing<int>(
+        context,
+        std::vector<const int*>{indices_.data()},
+        gatheredIndices_.data(),
+        k_));
+    valuesAllgather_.reset(new ::gloo::AllgatherRing<float>(
+        context,
+        std::vector<const float*>{values_.data()},
+        gatheredValues_.data(),
+        k_));
+  }
+
+  void run() override {
+    float* acc = residual_.data();
+    for (size_t i = 0; i < ptrs_.size(); i++) {
+      ::gloo::ReductionFunction<float>::sum->call(acc, ptrs_[i], count_);
+    }
+
+    if (k_ < count_) {
+      for (size_t i = 0; i < count_; i++) {
+        order_[i] = i;
+      }
+      std::nth_element(
+          order_.begin(),
+          order_.begin() + k_,
+          order_.end(),
+          [acc](int a, int b) { return std::abs(acc[a]) > std::abs(acc[b]); });
+    }
+    for (size_t i = 0; i < k_; i++) {
+      const int index = k_ < count_ ? order_[i] : i;
+      indices_[i] = index;
+      values_[i] = acc[index];
+      acc[index] = 0;
+    }
+
+    indicesAllgather_->run();
+    valuesAllgather_->run();
+
+    memset(ptrs_[0], 0, count_ * sizeof(float));
+    for (size_t i = 0; i < gatheredIndices_.size(); i++) {
+      ptrs_[0][gatheredIndices_[i]] += gatheredValues_[i];
+    }
+
+    // Broadcast ptrs_[0]
+    for (size_t i = 1; i < ptrs_.size(); i++) {
+      memcpy(ptrs_[i], ptrs_[0], count_ * sizeof(float));
+    }
+  }
+
+  size_t compressedBytes() const {
+    return k_ * (sizeof(int) + sizeof(float));
+  }
+
+ protected:
+  std::vector<float*> ptrs_;
+  const size_t count_;
+  const size_t k_;
+  // Holds the unsent part of the previous runs, and during a run the sum
+  // of that and the buffers.
+  std::vector<float> residual_;
+  std::vector<int> order_;
+  std::vector<int> indices_;
+  std::vector<float> values_;
+  std::vector<int> gatheredIndices_;
+  std::vector<float> gatheredValues_;
+  std::unique_ptr<::gloo::Algorithm> indicesAllgather_;
+  std::unique_ptr<::gloo::Algorithm> valuesAllgather_;
+};
+
+} // namespace gloo
+} // namespace caffe2
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "caffe2/core/logging.h"
+
+#include <gloo/algorithm.h>
+#include <gloo/context.h>
+#include <gloo/transport/buffer.h>
+
+namespace caffe2 {
+namespace gloo {
+
+// Whether the ranks described by nodes (see detectNodes) can be all-reduced
+// hierarchically: there must be more than one node, every node must hold the
+// same number of ranks, and more than one, and every rank must get at least one
+// element of count.
+inline bool isHierarchicalTopology(
+    const std::vector<int>& nodes,
+    size_t count) {
+  std::map<int, size_t> ranksPerNode;
+  for (auto node : nodes) {
+    ranksPerNode[node]++;
+  }
+  if (ranksPerNode.size() < 2) {
+    return false;
+  }
+  auto localSize = ranksPerNode.begin()->second;
+  for (auto& it : ranksPerNode) {
+    if (it.second != localSize) {
+      return false;
+    }
+  }
+  return localSize > 1 && count >= localSize;
+}
+
+// Topology aware allreduce, for ranks spread evenly over several nodes. It
+// runs in three phases:
+//
+//   1. A reduce-scatter within every node, after which the i-th rank of a
+//      node holds the sum over the node of the i-th chunk of the buffer.
+//   2. An allreduce of that chunk among the i-th ranks of all nodes.
+//   3. An allgather within every node.
+//
+// Only the second phase crosses nodes, and every rank sends just 1 / (ranks
+// per node) of the buffer to each of the other nodes, so the links between
+// nodes carry much less than with a flat ring or halving doubling.
+//
+// Every chunk is summed in the same order on all ranks, so they all end up
+// with bitwise identical results.
+template <typename T>
+class AllreduceHierarchical : public ::gloo::Algorithm {
+ public:
+  AllreduceHierarchical(
+      const std::shared_ptr<::gloo::Context>& context,
+      const std::vector<T*>& ptrs,
+      size_t count,
+      const std::vector<int>& nodes,
+      const ::gloo::ReductionFunction<T>* fn =
+          ::gloo::ReductionFunction<T>::sum)
+      : ::gloo::Algorithm(context),
+        ptrs_(ptrs),
+        count_(count),
+        bytes_(count * sizeof(T)),
+        fn_(fn) {
+    CAFFE_ENFORCE(isHierarchicalTopology(nodes, count));
+    CAFFE_ENFORCE_EQ(nodes.size(), size_t(this->contextSize_));
+
+    // Local ranks are the ranks of our node, cross ranks the ranks with the
+    // same local rank as ours on every node, both in increasing order.
+    std::map<int, std::vector<int>> nodeRanks;
+    for (int i = 0; i < this->contextSize_; i++) {
+      nodeRanks[nodes[i]].push_back(i);
+    }
+    localRanks_ = nodeRanks[nodes[this->contextRank_]];
+    for (size_t i = 0; i < localRanks_.size(); i++) {
+      if (localRanks_[i] == this->contextRank_) {
+        localRank_ = i;
+      }
+    }
+    for (auto& it : nodeRanks) {
+      if (it.second[localRank_] == this->contextRank_) {
+        crossRank_ = crossRanks_.size();
+      }
+      crossRanks_.push_back(it.second[localRank_]);
+    }
+
+    const auto localSize = localRanks_.size();
+    const auto crossSize = crossRanks_.size();
+    maxChunk_ = (count_ + localSize - 1) / localSize;
+    localInbox_.resize(localSize * maxChunk_);
+    crossInbox_.resize(crossSize * maxChunk_);
+    accum_.resize(maxChunk_);
+
+    auto reduceScatterSlot = this->context_->nextSlot();
+    auto allgatherSlot = this->context_->nextSlot();
+    auto crossSlot = this->context_->nextSlot();
+    auto notificationSlot = this->context_->nextSlot();
+
+    reduceScatterSend_.resize(localSize);
+    reduceScatterRecv_.resize(localSize);
+    allgatherSend_.resize(localSize);
+    allgatherRecv_.resize(localSize);
+    for (size_t j = 0; j < localSize; j++) {
+      if (j == localRank_) {
+        continue;
+      }
+      auto& pair = this->getPair(localRanks_[j]);
+      reduceScatterSend_[j] =
+          pair->createSendBuffer(reduceScatterSlot, ptrs_[0], bytes_);
+      reduceScatterRecv_[j] = pair->createRecvBuffer(
+          reduceScatterSlot,
+          &localInbox_[j * maxChunk_],
+          maxChunk_ * sizeof(T));
+      allgatherSend_[j] =
+          pair->createSendBuffer(allgatherSlot, ptrs_[0], bytes_);
+      allgatherRecv_[j] =
+          pair->createRecvBuffer(allgatherSlot, ptrs_[0], bytes_);
+    }
+
+    crossSend_.resize(crossSize);
+    crossRecv_.resize(crossSize);
+    notificationSend_.resize(crossSize);
+    notificationRecv_.resize(crossSize);
+    for (size_t k = 0; k < crossSize; k++) {
+      if (k == crossRank_) {
+        continue;
+      }
+      auto& pair = this->getPair(crossRanks_[k]);
+      crossSend_[k] = pair->createSendBuffer(crossSlot, ptrs_[0], bytes_);
+      crossRecv_[k] = pair->createRecvBuffer(
+          crossSlot, &crossInbox_[k * maxChunk_], maxChunk_ * sizeof(T));
+      notificationSend_[k] =
+          pair->createSendBuffer(notificationSlot, &dummy_, sizeof(dummy_));
+      notificationRecv_[k] =
+          pair->createRecvBuffer(notificationSlot, &dummy_, sizeof(dummy_));
+    }
+  }
+
+  void run() override {
+    // Reduce specified pointers into ptrs_[0]
+    for (size_t i = 1; i < ptrs_.size(); i++) {
+      fn_->call(ptrs_[0], ptrs_[i], count_);
+    }
+
+    const auto localSize = localRanks_.size();
+    const auto crossSize = crossRanks_.size();
+    T* chunk = ptrs_[0] + chunkBegin(localRank_);
+    const size_t chunkOffset = chunkBegin(localRank_) * sizeof(T);
+    const size_t chunkCount = chunkSize(localRank_);
+    const size_t chunkBytes = chunkCount * sizeof(T);
+
+    // Reduce-scatter within the node: chunk j goes to local rank j
+    for (size_t j = 0; j < localSize; j++) {
+      if (j != localRank_) {
+        reduceScatterSend_[j]->send(
+            chunkBegin(j) * sizeof(T), chunkSize(j) * sizeof(T));
+      }
+    }
+    for (size_t j = 0; j < localSize; j++) {
+      if (j != localRank_) {
+        reduceScatterRecv_[j]->waitRecv();
+        fn_->call(chunk, &localInbox_[j * maxChunk_], chunkCount);
+      }
+    }
+    for (size_t j = 0; j < localSize; j++) {
+      if (j != localRank_) {
+        reduceScatterSend_[j]->waitSend();
+      }
+    }
+
+    // Allreduce of our chunk across the nodes. Every rank sends its chunk to
+    // all others, and all of them sum the chunks in the order of the nodes.
+    for (size_t k = 0; k < crossSize; k++) {
+      if (k != crossRank_) {
+        crossSend_[k]->send(chunkOffset, chunkBytes);
+      }
+    }
+    for (size_t k = 0; k < crossSize; k++) {
+      if (k != crossRank_) {
+        crossRecv_[k]->waitRecv();
+      }
+    }
+    for (size_t k = 0; k < crossSize; k++) {
+      if (k != crossRank_) {
+        crossSend_[k]->waitSend();
+      }
+    }
+    for (size_t k = 0; k < crossSize; k++) {
+      const T* other = k == crossRank_ ? chunk : &crossInbox_[k * maxChunk_];
+      if (k == 0) {
+        memcpy(accum_.data(), other, chunkBytes);
+      } else {
+        fn_->call(accum_.data(), other, chunkCount);
+      }
+    }
+    memcpy(chunk, accum_.data(), chunkBytes);
+
+    // The ranks on the other nodes may only send the chunk of the next run
+    // once we are done with the one of this run.
+    for (size_t k = 0; k < crossSize; k++) {
+      if (k != crossRank_) {
+        notificationSend_[k]->send();
+      }
+    }
+    for (size_t k = 0; k < crossSize; k++) {
+      if (k != crossRank_) {
+        notificationRecv_[k]->waitRecv();
+      }
+    }
+    for (size_t k = 0; k < crossSize; k++) {
+      if (k != crossRank_) {
+        notificationSend_[k]->waitSend();
+      }
+    }
+
+    // Allgather within the node
+    for (size_t j = 0; j < localSize; j++) {
+      if (j != localRank_) {
+        allgatherSend_[j]->send(chunkOffset, chunkBytes, chunkOffset);
+      }
+    }
+    for (size_t j = 0; j < localSize; j++) {
+      if (j != localRank_) {
+        allgatherRecv_[j]->waitRecv();
+      }
+    }
+    for (size_t j = 0; j < localSize; j++) {
+      if (j != localRank_) {
+        allgatherSend_[j]->waitSend();
+      }
+    }
+
+    // Broadcast ptrs_[0]
+    for (size_t i = 1; i < ptrs_.size(); i++) {
+      memcpy(ptrs_[i], ptrs_[0], bytes_);
+    }
+  }
+
+ protected:
+  size_t chunkBegin(size_t chunk) const {
+    return count_ * chunk / localRanks_.size();
+  }
+
+  size_t chunkSize(size_t chunk) const {
+    return chunkBegin(chunk + 1) - chunkBegin(chunk);
+  }
+
+  std::vector<T*> ptrs_;
+  const size_t count_;
+  const size_t bytes_;
+  const ::gloo::ReductionFunction<T>* fn_;
+
+  std::vector<int> localRanks_;
+  std::vector<int> crossRanks_;
+  size_t localRank_ = 0;
+  size_t crossRank_ = 0;
+
+  size_t maxChunk_;
+  std::vector<T> localInbox_;
+  std::vector<T> crossInbox_;
+  std::vector<T> accum_;
+
+  std::vector<std::unique_ptr<::gloo::transport::Buffer>> reduceScatterSend_;
+  std::vector<std::unique_ptr<::gloo::transport::Buffer>> reduceScatterRecv_;
+  std::vector<std::unique_ptr<::gloo::transport::Buffer>> allgatherSend_;
+  std::vector<std::unique_ptr<::gloo::transport::Buffer>> allgatherRecv_;
+  std::vector<std::unique_ptr<::gloo::transport::Buffer>> crossSend_;
+  std::vector<std::unique_ptr<::gloo::transport::Buffer>> crossRecv_;
+  std::vector<std::unique_ptr<::gloo::transport::Buffer>> notificationSend_;
+  std::vector<std::unique_ptr<::gloo::transport::Buffer>> notificationRecv_;
+  int dummy_;
+};
+
+} // namespace gloo
+} // namespace caffe2
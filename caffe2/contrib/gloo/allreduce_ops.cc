@@ -1,4 +1,6 @@
 #include "allreduce_ops.h"
+#include "allreduce_compressed.h"
+#include "allreduce_hierarchical.h"
 
 #include <gloo/allreduce_halving_doubling.h>
 #include <gloo/allreduce_ring.h>
@@ -53,9 +55,98 @@ void AllreduceOp<Context>::initializeRingChunked() {
   }
 }
 
+template <class Context>
+void AllreduceOp<Context>::initializeHierarchical() {
+  auto nodes = detectNodes(init_.context, ranks_per_node_);
+  if (!isHierarchicalTopology(nodes, init_.size)) {
+    LOG(INFO) << "Ranks are not spread evenly over several nodes; "
+              << "using halving doubling instead of hierarchical allreduce";
+    initializeHalvingDoubling();
+    return;
+  }
+
+  if (init_.template IsType<float>()) {
+    algorithm_.reset(new AllreduceHierarchical<float>(
+        init_.context, init_.template getOutputs<float>(), init_.size, nodes));
+  } else if (init_.template IsType<::caffe2::float16>()) {
+    algorithm_.reset(new AllreduceHierarchical<::gloo::float16>(
+        init_.context,
+        init_.template getOutputs<::gloo::float16>(),
+        init_.size,
+        nodes));
+  } else {
+    CAFFE_ENFORCE(false, "Unhandled type: ", init_.meta.name());
+  }
+}
+
+template <class Context>
+bool AllreduceOp<Context>::initializeCompressed() {
+  if (!init_.template IsType<float>()) {
+    LOG(INFO) << "Allreduce compression only applies to float tensors; "
+              << "sending " << init_.meta.name() << " tensors as they are";
+    return false;
+  }
+
+  auto ptrs = init_.template getOutputs<float>();
+  if (compression_ == FP16_COMPRESSION) {
+    std::unique_ptr<AllreduceHalfPrecision> algorithm(
+        new AllreduceHalfPrecision(
+            init_.context,
+            ptrs,
+            init_.size,
+            [this](const std::vector<::gloo::float16*>& half) {
+              return createHalfPrecisionAlgorithm(half);
+            }));
+    compressed_bytes_ = algorithm->compressedBytes();
+    algorithm_ = std::move(algorithm);
+  } else {
+    std::unique_ptr<AllreduceTopK> algorithm(
+        new AllreduceTopK(init_.context, ptrs, init_.size, topk_ratio_));
+    compressed_bytes_ = algorithm->compressedBytes();
+    algorithm_ = std::move(algorithm);
+  }
+  return true;
+}
+
+template <class Context>
+std::unique_ptr<::gloo::Algorithm>
+AllreduceOp<Context>::createHalfPrecisionAlgorithm(
+    const std::vector<::gloo::float16*>& ptrs) {
+  using ::gloo::float16;
+  switch (mode_) {
+    case RING_FULL:
+      return std::unique_ptr<::gloo::Algorithm>(
+          new ::gloo::AllreduceRing<float16>(init_.context, ptrs, init_.size));
+    case RING_CHUNKED:
+      return std::unique_ptr<::gloo::Algorithm>(
+          new ::gloo::AllreduceRingChunked<float16>(
+              init_.context, ptrs, init_.size));
+    case HIERARCHICAL: {
+      auto nodes = detectNodes(init_.context, ranks_per_node_);
+      if (isHierarchicalTopology(nodes, init_.size)) {
+        return std::unique_ptr<::gloo::Algorithm>(
+            new AllreduceHierarchical<float16>(
+                init_.context, ptrs, init_.size, nodes));
+      }
+      LOG(INFO) << "Ranks are not spread evenly over several nodes; "
+                << "using halving doubling instead of hierarchical allreduce";
+      break;
+    }
+    case HALVING_DOUBLING:
+      break;
+  }
+  return std::unique_ptr<::gloo::Algorithm>(
+      new ::gloo::AllreduceHalvingDoubling<float16>(
+          init_.context, ptrs, init_.size));
+}
+
 namespace {
 
 REGISTER_CPU_OPERATOR_WITH_ENGINE(Allreduce, GLOO, AllreduceOp<CPUContext>);
+REGISTER_CPU_OPERATOR_WITH_ENGINE(
+    AllreduceAsync,
+    GLOO,
+    AllreduceOp<CPUContext>);
 
 } // namespace
 } // namespace gloo
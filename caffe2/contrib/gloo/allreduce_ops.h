@@ -4,18 +4,21 @@
 
 #include "caffe2/contrib/gloo/common.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
 #include "caffe2/utils/math.h"
 
 #include <gloo/algorithm.h>
 #include <gloo/common/error.h>
 #include <gloo/context.h>
+#include <gloo/types.h>
 
 namespace caffe2 {
 namespace gloo {
 
 template <class Context>
 class AllreduceOp final : public Operator<Context> {
-  enum Mode { RING_FULL, RING_CHUNKED, HALVING_DOUBLING };
+  enum Mode { RING_FULL, RING_CHUNKED, HALVING_DOUBLING, HIERARCHICAL };
+  enum Compression { NO_COMPRESSION, FP16_COMPRESSION, TOPK_COMPRESSION };
 
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
@@ -25,14 +28,55 @@ class AllreduceOp final : public Operator<Context> {
         ws_(ws),
         status_blob_(
             OperatorBase::GetSingleArgument<std::string>("status_blob", "")),
+        // The asynchronous variant outputs a handle after the tensors
+        async_(OutputSize() == InputSize()),
         gpu_direct_(
-            OperatorBase::GetSingleArgument<bool>("gpu_direct", false)) {
+            OperatorBase::GetSingleArgument<bool>("gpu_direct", false)),
+        ranks_per_node_(
+            OperatorBase::GetSingleArgument<int>("ranks_per_node", 0)),
+        topk_ratio_(
+            OperatorBase::GetSingleArgument<float>("topk_ratio", 0.01f)),
+        stats_(std::string("gloo_allreduce/") + operator_def.output(0)) {
     if (status_blob_ != "") {
       ws_->CreateBlob(status_blob_);
     }
+    auto algorithm = OperatorBase::GetSingleArgument<std::string>(
+        "algorithm", "halving_doubling");
+    if (algorithm == "halving_doubling") {
+      mode_ = HALVING_DOUBLING;
+    } else if (algorithm == "ring") {
+      mode_ = RING_FULL;
+    } else if (algorithm == "ring_chunked") {
+      mode_ = RING_CHUNKED;
+    } else if (algorithm == "hierarchical") {
+      mode_ = HIERARCHICAL;
+    } else {
+      CAFFE_THROW("Unknown allreduce algorithm: ", algorithm);
+    }
+    auto compression =
+        OperatorBase::GetSingleArgument<std::string>("compression", "none");
+    if (compression == "none") {
+      compression_ = NO_COMPRESSION;
+    } else if (compression == "fp16") {
+      compression_ = FP16_COMPRESSION;
+    } else if (compression == "topk") {
+      compression_ = TOPK_COMPRESSION;
+    } else {
+      CAFFE_THROW("Unknown allreduce compression: ", compression);
+    }
   }
 
-  virtual ~AllreduceOp() {}
+  virtual ~AllreduceOp() {
+    // The algorithm may still be running
+    if (handle_) {
+      try {
+        handle_->Wait();
+      } catch (const std::exception& e) {
+        LOG(ERROR) << "Caught exception while waiting for collective: "
+                   << e.what();
+      }
+    }
+  }
 
   bool RunOnDevice() override {
     std::call_once(once_, [&] { initialize(); });
@@ -42,6 +86,18 @@ class AllreduceOp final : public Operator<Context> {
     update(current_);
     CAFFE_ENFORCE(current_ == init_, "Inputs/outputs have changed");
 
+    if (async_) {
+      startAsync();
+    } else if (!runAlgorithm()) {
+      return false;
+    }
+    CAFFE_EVENT(stats_, bytes, bytes_);
+    CAFFE_EVENT(stats_, compressed_bytes, compressed_bytes_);
+    return true;
+  }
+
+ protected:
+  bool runAlgorithm() {
     try {
       algorithm_->run();
     } catch (::gloo::IoException& ioe) {
@@ -56,10 +112,21 @@ class AllreduceOp final : public Operator<Context> {
     return true;
   }
 
- protected:
+  // Runs the algorithm on a thread of its own and outputs the handle to wait
+  // for it. The tensors must not be touched until the handle is waited for.
+  void startAsync() {
+    // The algorithm reads the tensors, which may still be computed
+    context_.FinishDeviceComputation();
+    if (!handle_) {
+      handle_ = std::make_shared<AsyncCollective>();
+    }
+    handle_->Start([this] { return runAlgorithm(); });
+    *OperatorBase::Output<std::shared_ptr<AsyncCollective>>(OutputSize() - 1) =
+        handle_;
+  }
+
   void initialize() {
-    Mode mode = HALVING_DOUBLING;
-    auto bytes = Input(1).nbytes();
+    Mode mode = mode_;
 
     // Store which inputs/outputs this instance initialized with
     update(init_);
@@ -82,6 +149,12 @@ class AllreduceOp final : public Operator<Context> {
       CAFFE_ENFORCE(Input(i).meta() == meta);
     }
 
+    bytes_ = size * meta.itemsize();
+    compressed_bytes_ = bytes_;
+    if (compression_ != NO_COMPRESSION && initializeCompressed()) {
+      return;
+    }
+
     switch (mode) {
       case RING_FULL:
         initializeRingFull();
@@ -92,6 +165,9 @@ class AllreduceOp final : public Operator<Context> {
       case HALVING_DOUBLING:
         initializeHalvingDoubling();
         return;
+      case HIERARCHICAL:
+        initializeHierarchical();
+        return;
     }
 
     CAFFE_ENFORCE(false, "Unreachable code");
@@ -100,6 +176,14 @@ class AllreduceOp final : public Operator<Context> {
   void initializeHalvingDoubling();
   void initializeRingFull();
   void initializeRingChunked();
+  // Falls back to halving doubling if the ranks are not spread evenly over
+  // several nodes.
+  void initializeHierarchical();
+  // Returns false, leaving the choice of algorithm to the mode, if the
+  // compression does not apply to the tensors.
+  bool initializeCompressed();
+  std::unique_ptr<::gloo::Algorithm> createHalfPrecisionAlgorithm(
+      const std::vector<::gloo::float16*>& ptrs);
 
   std::once_flag once_;
   std::unique_ptr<::gloo::Algorithm> algorithm_;
@@ -111,7 +195,7 @@ class AllreduceOp final : public Operator<Context> {
   void update(GlooParameters& params) {
     params.context = OperatorBase::Input<std::shared_ptr<::gloo::Context>>(0);
     params.inputs.resize(InputSize() - 1);
-    params.outputs.resize(OutputSize());
+    params.outputs.resize(InputSize() - 1);
     for (auto i = 0; i < params.inputs.size(); i++) {
       params.inputs[i] = Input(i + 1).template raw_data();
       params.outputs[i] = Output(i)->template raw_mutable_data();
@@ -124,7 +208,25 @@ class AllreduceOp final : public Operator<Context> {
   GlooParameters current_;
   Workspace* ws_;
   std::string status_blob_;
+  const bool async_;
+  std::shared_ptr<AsyncCollective> handle_;
   const bool gpu_direct_;
+  // If positive, overrides the detection of which ranks share a node for the
+  // hierarchical algorithm: rank r is on node r / ranks_per_node.
+  const int ranks_per_node_;
+  // Fraction of the entries every rank sends with top-k compression.
+  const float topk_ratio_;
+  Mode mode_;
+  Compression compression_;
+
+  // Bytes every rank contributes to a run, before and after compression.
+  size_t bytes_;
+  size_t compressed_bytes_;
+  struct AllreduceStats {
+    CAFFE_STAT_CTOR(AllreduceStats);
+    CAFFE_EXPORTED_STAT(bytes);
+    CAFFE_EXPORTED_STAT(compressed_bytes);
+  } stats_;
 };
 
 } // namespace gloo
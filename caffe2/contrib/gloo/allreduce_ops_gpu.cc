@@ -100,9 +100,30 @@ void AllreduceOp<Context>::initializeRingChunked() {
   }
 }
 
+template <class Context>
+void AllreduceOp<Context>::initializeHierarchical() {
+  // The CUDA algorithms already reduce the GPUs of every process with NCCL
+  // before anything goes over the network, which is the intra-node phase of
+  // a hierarchical allreduce when a process drives all GPUs of its node.
+  LOG(INFO) << "Hierarchical allreduce is not implemented for GPU buffers; "
+            << "using halving doubling";
+  initializeHalvingDoubling();
+}
+
+template <class Context>
+bool AllreduceOp<Context>::initializeCompressed() {
+  LOG(INFO) << "Allreduce compression is not implemented for GPU buffers; "
+            << "sending them as they are";
+  return false;
+}
+
 namespace {
 
 REGISTER_CUDA_OPERATOR_WITH_ENGINE(Allreduce, GLOO, AllreduceOp<CUDAContext>);
+REGISTER_CUDA_OPERATOR_WITH_ENGINE(
+    AllreduceAsync,
+    GLOO,
+    AllreduceOp<CUDAContext>);
 
 } // namespace
 } // namespace gloo
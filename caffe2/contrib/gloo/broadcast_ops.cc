@@ -30,6 +30,10 @@ void BroadcastOp<Context>::initializeAlgorithm() {
 namespace {
 
 REGISTER_CPU_OPERATOR_WITH_ENGINE(Broadcast, GLOO, BroadcastOp<CPUContext>);
+REGISTER_CPU_OPERATOR_WITH_ENGINE(
+    BroadcastAsync,
+    GLOO,
+    BroadcastOp<CPUContext>);
 
 } // namespace
 } // namespace gloo
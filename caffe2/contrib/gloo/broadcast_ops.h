@@ -23,13 +23,25 @@ class BroadcastOp final : public Operator<Context> {
         root_(OperatorBase::template GetSingleArgument<int>("root", 0)),
         ws_(ws),
         status_blob_(
-            OperatorBase::GetSingleArgument<std::string>("status_blob", "")) {
+            OperatorBase::GetSingleArgument<std::string>("status_blob", "")),
+        // The asynchronous variant outputs a handle after the tensors
+        async_(OutputSize() == InputSize()) {
     if (status_blob_ != "") {
       ws_->CreateBlob(status_blob_);
     }
   }
 
-  virtual ~BroadcastOp() {}
+  virtual ~BroadcastOp() {
+    // The algorithm may still be running
+    if (handle_) {
+      try {
+        handle_->Wait();
+      } catch (const std::exception& e) {
+        LOG(ERROR) << "Caught exception while waiting for collective: "
+                   << e.what();
+      }
+    }
+  }
 
   bool RunOnDevice() override {
     std::call_once(once_, [&] { initialize(); });
@@ -39,6 +51,15 @@ class BroadcastOp final : public Operator<Context> {
     update(current_);
     CAFFE_ENFORCE(current_ == init_, "Inputs/outputs have changed");
 
+    if (async_) {
+      startAsync();
+      return true;
+    }
+    return runAlgorithm();
+  }
+
+ protected:
+  bool runAlgorithm() {
     try {
       algorithm_->run();
     } catch (::gloo::IoException& ioe) {
@@ -53,7 +74,19 @@ class BroadcastOp final : public Operator<Context> {
     return true;
   }
 
- protected:
+  // Runs the algorithm on a thread of its own and outputs the handle to wait
+  // for it. The tensors must not be touched until the handle is waited for.
+  void startAsync() {
+    // The algorithm reads the tensors, which may still be computed
+    context_.FinishDeviceComputation();
+    if (!handle_) {
+      handle_ = std::make_shared<AsyncCollective>();
+    }
+    handle_->Start([this] { return runAlgorithm(); });
+    *OperatorBase::Output<std::shared_ptr<AsyncCollective>>(OutputSize() - 1) =
+        handle_;
+  }
+
   void initialize() {
     // Store which inputs/outputs this instance initialized with
     update(init_);
@@ -93,7 +126,7 @@ class BroadcastOp final : public Operator<Context> {
   void update(GlooParameters& params) {
     params.context = OperatorBase::Input<std::shared_ptr<::gloo::Context>>(0);
     params.inputs.resize(InputSize() - 1);
-    params.outputs.resize(OutputSize());
+    params.outputs.resize(InputSize() - 1);
     for (auto i = 0; i < params.inputs.size(); i++) {
       params.inputs[i] = Input(i + 1).template raw_data();
       params.outputs[i] = Output(i)->template raw_mutable_data();
@@ -106,6 +139,8 @@ class BroadcastOp final : public Operator<Context> {
   GlooParameters current_;
   Workspace* ws_;
   std::string status_blob_;
+  const bool async_;
+  std::shared_ptr<AsyncCollective> handle_;
 };
 
 } // namespace gloo
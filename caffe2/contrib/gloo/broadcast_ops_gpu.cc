@@ -32,6 +32,10 @@ void BroadcastOp<Context>::initializeAlgorithm() {
 namespace {
 
 REGISTER_CUDA_OPERATOR_WITH_ENGINE(Broadcast, GLOO, BroadcastOp<CUDAContext>);
+REGISTER_CUDA_OPERATOR_WITH_ENGINE(
+    BroadcastAsync,
+    GLOO,
+    BroadcastOp<CUDAContext>);
 
 } // namespace
 } // namespace gloo
@@ -3,6 +3,12 @@
 #include "caffe2/core/logging.h"
 #include "caffe2/core/tensor.h"
 
+#include <limits.h>
+#include <unistd.h>
+
+#include <functional>
+#include <unordered_map>
+
 #include <gloo/transport/tcp/device.h>
 #if defined(GLOO_USE_IBVERBS) && GLOO_USE_IBVERBS
 #include <gloo/transport/ibverbs/device.h>
@@ -17,6 +23,26 @@ void signalFailure(Blob* status_blob, std::exception& /* unused */) {
   res->template mutable_data<int32_t>()[0] = 1;
 }
 
+AsyncCollective::~AsyncCollective() {
+  if (result_.valid()) {
+    result_.wait();
+  }
+}
+
+void AsyncCollective::Start(std::function<bool()> fn) {
+  if (result_.valid()) {
+    result_.get();
+  }
+  result_ = std::async(std::launch::async, std::move(fn));
+}
+
+bool AsyncCollective::Wait() {
+  if (!result_.valid()) {
+    return true;
+  }
+  return result_.get();
+}
+
 std::shared_ptr<::gloo::transport::Device> createDevice(
     const createDeviceAttr attr) {
   if (attr.transport == "tcp") {
@@ -44,5 +70,51 @@ std::shared_ptr<::gloo::transport::Device> createDevice(
   CAFFE_THROW("Invalid transport: ", attr.transport);
 }
 
+std::vector<int> detectNodes(
+    const std::shared_ptr<::gloo::Context>& context,
+    int ranksPerNode) {
+  std::vector<int> nodes(context->size);
+  if (ranksPerNode > 0) {
+    for (int i = 0; i < context->size; i++) {
+      nodes[i] = i / ranksPerNode;
+    }
+    return nodes;
+  }
+
+  char hostname[HOST_NAME_MAX + 1] = {0};
+  CAFFE_ENFORCE_EQ(gethostname(hostname, HOST_NAME_MAX), 0);
+  uint64_t local = std::hash<std::string>()(hostname);
+  std::vector<uint64_t> hashes(context->size);
+  hashes[context->rank] = local;
+
+  auto slot = context->nextSlot();
+  std::vector<std::unique_ptr<::gloo::transport::Buffer>> sendBufs;
+  std::vector<std::unique_ptr<::gloo::transport::Buffer>> recvBufs;
+  for (int i = 0; i < context->size; i++) {
+    if (i == context->rank) {
+      continue;
+    }
+    auto& pair = context->getPair(i);
+    sendBufs.push_back(pair->createSendBuffer(slot, &local, sizeof(local)));
+    recvBufs.push_back(
+        pair->createRecvBuffer(slot, &hashes[i], sizeof(hashes[i])));
+  }
+  for (auto& buf : sendBufs) {
+    buf->send();
+  }
+  for (auto& buf : recvBufs) {
+    buf->waitRecv();
+  }
+  for (auto& buf : sendBufs) {
+    buf->waitSend();
+  }
+
+  std::unordered_map<uint64_t, int> ids;
+  for (int i = 0; i < context->size; i++) {
+    nodes[i] = ids.emplace(hashes[i], ids.size()).first->second;
+  }
+  return nodes;
+}
+
 } // namespace gloo
 } // namespace caffe2
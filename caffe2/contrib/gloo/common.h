@@ -1,6 +1,10 @@
 #pragma once
 
 #include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
 
 #include "caffe2/core/blob.h"
 
@@ -25,6 +29,34 @@ struct createDeviceAttr {
 std::shared_ptr<::gloo::transport::Device> createDevice(
     const createDeviceAttr attr);
 
+// Returns the node of every rank of the context, numbered in the order of
+// their lowest rank. Ranks on the same machine share a node, which is found by
+// exchanging host names, unless ranksPerNode is positive, in which case rank
+// r is taken to be on node r / ranksPerNode. Has to be called by all ranks.
+std::vector<int> detectNodes(
+    const std::shared_ptr<::gloo::Context>& context,
+    int ranksPerNode = 0);
+
+// A collective that runs on a thread of its own, so that the operators after
+// the one that started it run meanwhile. The asynchronous communication
+// operators output it as a handle, which the Wait operator waits for. The
+// function returns false if it failed and signaled the failure in a status
+// blob; other errors are rethrown by Wait.
+class AsyncCollective {
+ public:
+  ~AsyncCollective();
+
+  // Waits for the previous run before it starts `fn`, and rethrows its error
+  // if nobody waited for it.
+  void Start(std::function<bool()> fn);
+
+  // Returns the result of the last run, or true if nothing is running.
+  bool Wait();
+
+ private:
+  std::future<bool> result_;
+};
+
 // Captures the parameters passed to Gloo.
 struct GlooParameters {
   std::shared_ptr<::gloo::Context> context;
@@ -21,6 +21,7 @@ from gloo.python import IoError
 
 dyndep.InitOpsLibrary("@/caffe2/caffe2/distributed:file_store_handler_ops")
 dyndep.InitOpsLibrary("@/caffe2/caffe2/distributed:redis_store_handler_ops")
+dyndep.InitOpsLibrary("@/caffe2/caffe2/distributed:tcp_store_handler_ops")
 dyndep.InitOpsLibrary("@/caffe2/caffe2/distributed:store_ops")
 dyndep.InitOpsLibrary("@/caffe2/caffe2/contrib/gloo:gloo_ops")
 dyndep.InitOpsLibrary("@/caffe2/caffe2/contrib/gloo:gloo_ops_gpu")
@@ -97,11 +98,24 @@ class TestCase(hu.HypothesisTestCase):
     def create_common_world(self, comm_rank, comm_size, tmpdir=None, existing_cw=None):
         store_handler = "store_handler"
 
-        # If REDIS_HOST is set, use RedisStoreHandler for rendezvous.
+        # If REDIS_HOST is set, use RedisStoreHandler for rendezvous, and if
+        # TCP_STORE_HOST is set, a TcpStoreHandler served by rank 0.
         if existing_cw is None:
             redis_host = os.getenv("REDIS_HOST")
             redis_port = int(os.getenv("REDIS_PORT", 6379))
-            if redis_host is not None:
+            tcp_store_host = os.getenv("TCP_STORE_HOST")
+            tcp_store_port = int(os.getenv("TCP_STORE_PORT", 29500))
+            if tcp_store_host is not None:
+                workspace.RunOperatorOnce(
+                    core.CreateOperator(
+                        "TcpStoreHandlerCreate",
+                        [],
+                        [store_handler],
+                        prefix=str(TestCase.test_counter) + "/",
+                        host=tcp_store_host,
+                        port=tcp_store_port,
+                        server=(comm_rank == 0)))
+            elif redis_host is not None:
                 workspace.RunOperatorOnce(
                     core.CreateOperator(
                         "RedisStoreHandlerCreate",
@@ -238,7 +252,8 @@ class TestCase(hu.HypothesisTestCase):
                         blob_size=None,
                         num_blobs=None,
                         tmpdir=None,
-                        use_float16=False
+                        use_float16=False,
+                        **kwargs
                         ):
         store_handler, common_world = self.create_common_world(
             comm_rank=comm_rank,
@@ -267,7 +282,8 @@ class TestCase(hu.HypothesisTestCase):
         net.Allreduce(
             [common_world] + blobs,
             blobs,
-            engine=op_engine)
+            engine=op_engine,
+            **kwargs)
 
         workspace.CreateNet(net)
         workspace.RunNet(net.Name())
@@ -347,6 +363,162 @@ class TestCase(hu.HypothesisTestCase):
                     tmpdir=tmpdir,
                     use_float16=use_float16)
 
+    @given(comm_size=st.sampled_from([4, 6, 8]),
+           blob_size=st.integers(min_value=1e3, max_value=1e6),
+           num_blobs=st.integers(min_value=1, max_value=4),
+           device_option=st.sampled_from([hu.cpu_do]),
+           use_float16=st.booleans())
+    def test_allreduce_hierarchical(self, comm_size, blob_size, num_blobs,
+                                    device_option, use_float16):
+        TestCase.test_counter += 1
+        # Pretend every pair of ranks shares a node
+        if os.getenv('COMM_RANK') is not None:
+            self.run_test_distributed(
+                self._test_allreduce,
+                blob_size=blob_size,
+                num_blobs=num_blobs,
+                use_float16=use_float16,
+                device_option=device_option,
+                algorithm="hierarchical",
+                ranks_per_node=2)
+        else:
+            with TemporaryDirectory() as tmpdir:
+                self.run_test_locally(
+                    self._test_allreduce,
+                    comm_size=comm_size,
+                    blob_size=blob_size,
+                    num_blobs=num_blobs,
+                    device_option=device_option,
+                    tmpdir=tmpdir,
+                    use_float16=use_float16,
+                    algorithm="hierarchical",
+                    ranks_per_node=2)
+
+    @given(comm_size=st.integers(min_value=2, max_value=8),
+           blob_size=st.integers(min_value=1e3, max_value=1e6),
+           num_blobs=st.integers(min_value=1, max_value=4),
+           device_option=st.sampled_from([hu.cpu_do]),
+           use_float16=st.booleans(),
+           compression=st.sampled_from(["fp16", "topk"]))
+    def test_allreduce_compressed(self, comm_size, blob_size, num_blobs,
+                                  device_option, use_float16, compression):
+        TestCase.test_counter += 1
+        # The sums are small integers, which float16 holds exactly, and a
+        # top-k ratio of 1 sends every entry
+        if os.getenv('COMM_RANK') is not None:
+            self.run_test_distributed(
+                self._test_allreduce,
+                blob_size=blob_size,
+                num_blobs=num_blobs,
+                use_float16=use_float16,
+                device_option=device_option,
+                compression=compression,
+                topk_ratio=1.0)
+        else:
+            with TemporaryDirectory() as tmpdir:
+                self.run_test_locally(
+                    self._test_allreduce,
+                    comm_size=comm_size,
+                    blob_size=blob_size,
+                    num_blobs=num_blobs,
+                    device_option=device_option,
+                    tmpdir=tmpdir,
+                    use_float16=use_float16,
+                    compression=compression,
+                    topk_ratio=1.0)
+
+    def _test_allreduce_async(self,
+                              comm_rank=None,
+                              comm_size=None,
+                              blob_size=None,
+                              num_blobs=None,
+                              tmpdir=None,
+                              ):
+        store_handler, common_world = self.create_common_world(
+            comm_rank=comm_rank,
+            comm_size=comm_size,
+            tmpdir=tmpdir)
+
+        blob_size = self.synchronize(
+            store_handler,
+            blob_size,
+            comm_rank=comm_rank)
+
+        num_blobs = self.synchronize(
+            store_handler,
+            num_blobs,
+            comm_rank=comm_rank)
+
+        blobs = []
+        for i in range(num_blobs):
+            blob = "blob_{}".format(i)
+            value = np.full(blob_size, (comm_rank * num_blobs) + i, np.float32)
+            workspace.FeedBlob(blob, value)
+            blobs.append(blob)
+        workspace.FeedBlob("local", np.full(blob_size, comm_rank, np.float32))
+
+        # The local step runs while the allreduce communicates
+        net = core.Net("allreduce_async")
+        net.AllreduceAsync(
+            [common_world] + blobs,
+            blobs + ["handle"],
+            engine=op_engine)
+        net.Scale("local", "local", scale=2.0)
+        net.Wait(["handle"] + blobs, blobs, engine=op_engine)
+
+        workspace.CreateNet(net)
+        workspace.RunNet(net.Name())
+
+        for i in range(num_blobs):
+            np.testing.assert_array_equal(
+                workspace.FetchBlob(blobs[i]),
+                (num_blobs * comm_size) * (num_blobs * comm_size - 1) / 2)
+        np.testing.assert_array_equal(workspace.FetchBlob("local"), 2 * comm_rank)
+
+        # Run the net a few more times to check the operator
+        # works not just the first time it's called
+        for _tmp in range(4):
+            workspace.RunNet(net.Name())
+
+        # Broadcast the sums of the root, waiting in the next run only
+        net = core.Net("broadcast_async")
+        net.Wait(["handle"] + blobs, blobs, engine=op_engine)
+        net.BroadcastAsync(
+            [common_world] + blobs,
+            blobs + ["handle"],
+            root=1,
+            engine=op_engine)
+        workspace.FeedBlob(blobs[0], np.full(blob_size, comm_rank, np.float32))
+        workspace.CreateNet(net)
+        workspace.RunNet(net.Name())
+        workspace.RunNet(net.Name())
+        workspace.RunOperatorOnce(
+            core.CreateOperator("Wait", ["handle"], [], engine=op_engine))
+        np.testing.assert_array_equal(workspace.FetchBlob(blobs[0]), 1)
+
+    @given(comm_size=st.integers(min_value=2, max_value=8),
+           blob_size=st.integers(min_value=1e3, max_value=1e6),
+           num_blobs=st.integers(min_value=1, max_value=4),
+           device_option=st.sampled_from([hu.cpu_do]))
+    def test_allreduce_async(self, comm_size, blob_size, num_blobs,
+                             device_option):
+        TestCase.test_counter += 1
+        if os.getenv('COMM_RANK') is not None:
+            self.run_test_distributed(
+                self._test_allreduce_async,
+                blob_size=blob_size,
+                num_blobs=num_blobs,
+                device_option=device_option)
+        else:
+            with TemporaryDirectory() as tmpdir:
+                self.run_test_locally(
+                    self._test_allreduce_async,
+                    comm_size=comm_size,
+                    blob_size=blob_size,
+                    num_blobs=num_blobs,
+                    device_option=device_option,
+                    tmpdir=tmpdir)
+
     def _test_reduce_scatter(self,
                              comm_rank=None,
                              comm_size=None,
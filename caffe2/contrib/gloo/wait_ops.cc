@@ -0,0 +1,11 @@
+#include "wait_ops.h"
+
+namespace caffe2 {
+namespace gloo {
+namespace {
+
+REGISTER_CPU_OPERATOR_WITH_ENGINE(Wait, GLOO, WaitOp<CPUContext>);
+
+} // namespace
+} // namespace gloo
+} // namespace caffe2
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "caffe2/contrib/gloo/common.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+namespace gloo {
+
+template <class Context>
+class WaitOp final : public Operator<Context> {
+ public:
+  WaitOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws) {}
+
+  virtual ~WaitOp() {}
+
+  bool RunOnDevice() override {
+    auto& handle = OperatorBase::Input<std::shared_ptr<AsyncCollective>>(0);
+    CAFFE_ENFORCE(handle, "Collective was not started");
+    return handle->Wait();
+  }
+};
+
+} // namespace gloo
+} // namespace caffe2
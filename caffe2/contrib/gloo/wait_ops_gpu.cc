@@ -0,0 +1,13 @@
+#include "wait_ops.h"
+
+#include "caffe2/core/context_gpu.h"
+
+namespace caffe2 {
+namespace gloo {
+namespace {
+
+REGISTER_CUDA_OPERATOR_WITH_ENGINE(Wait, GLOO, WaitOp<CUDAContext>);
+
+} // namespace
+} // namespace gloo
+} // namespace caffe2
@@ -28,6 +28,39 @@ void SetCPUAllocator(CPUAllocator* alloc) {
 
 MemoryAllocationReporter CPUContext::reporter_;
 
+namespace {
+std::atomic<bool> g_has_listener(false);
+std::shared_ptr<MemoryAllocationListener> g_listener;
+} // namespace
+
+void SetMemoryAllocationListener(
+    std::shared_ptr<MemoryAllocationListener> listener) {
+  g_has_listener = listener != nullptr;
+  std::atomic_store(&g_listener, std::move(listener));
+}
+
+bool HasMemoryAllocationListener() {
+  return g_has_listener.load(std::memory_order_relaxed);
+}
+
+void NotifyMemoryAllocation(int device_type, void* ptr, size_t nbytes) {
+  if (!HasMemoryAllocationListener()) {
+    return;
+  }
+  if (auto listener = std::atomic_load(&g_listener)) {
+    listener->OnAllocation(device_type, ptr, nbytes);
+  }
+}
+
+void NotifyMemoryDeallocation(int device_type, void* ptr) {
+  if (!HasMemoryAllocationListener()) {
+    return;
+  }
+  if (auto listener = std::atomic_load(&g_listener)) {
+    listener->OnDeallocation(device_type, ptr);
+  }
+}
+
 void MemoryAllocationReporter::New(void* ptr, size_t nbytes) {
   std::lock_guard<std::mutex> guard(mutex_);
   size_table_[ptr] = nbytes;
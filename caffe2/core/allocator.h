@@ -1,10 +1,13 @@
 #ifndef CAFFE2_CORE_ALLOCATOR_H_
 #define CAFFE2_CORE_ALLOCATOR_H_
 
+#include <atomic>
+#include <memory>
 #include <unordered_map>
 
 #include "caffe2/core/logging.h"
 #include "caffe2/core/numa.h"
+#include "caffe2/core/static_tracepoint.h"
 
 CAFFE2_DECLARE_bool(caffe2_report_cpu_memory_usage);
 CAFFE2_DECLARE_bool(caffe2_cpu_allocator_do_zero_fill);
@@ -14,6 +17,10 @@ namespace caffe2 {
 // Use 32-byte alignment should be enough for computation up to AVX512.
 constexpr size_t gCaffe2Alignment = 32;
 
+// With NUMA enabled, allocations of at least this size are page aligned, so
+// that moving them to a NUMA node doesn't drag other allocations along.
+constexpr size_t gCaffe2NUMAPageSize = 4096;
+
 using MemoryDeleter = void (*)(void*);
 
 // A helper function that is basically doing nothing.
@@ -41,6 +48,27 @@ class MemoryAllocationReporter {
   size_t allocated_;
 };
 
+// Receives the allocations and deallocations of memory for tensors that go
+// through CPUContext and CUDAContext while it is set, e.g. to attribute them
+// to the operators that make them. Called on the allocating thread, so it has
+// to be thread safe. Deallocations of memory allocated before the listener was
+// set are reported as well and have to be ignored.
+class MemoryAllocationListener {
+ public:
+  virtual ~MemoryAllocationListener() {}
+  virtual void OnAllocation(int device_type, void* ptr, size_t nbytes) = 0;
+  virtual void OnDeallocation(int device_type, void* ptr) = 0;
+};
+
+// Sets the listener, or removes it if null. The listener is kept alive until
+// the calls that are in flight when it is replaced return.
+void SetMemoryAllocationListener(
+    std::shared_ptr<MemoryAllocationListener> listener);
+// Cheap check to do before calling the functions below
+bool HasMemoryAllocationListener();
+void NotifyMemoryAllocation(int device_type, void* ptr, size_t nbytes);
+void NotifyMemoryDeallocation(int device_type, void* ptr);
+
 struct DefaultCPUAllocator final : CPUAllocator {
   DefaultCPUAllocator() {}
   ~DefaultCPUAllocator() override {}
@@ -51,14 +79,27 @@ struct DefaultCPUAllocator final : CPUAllocator {
 #elif defined(_MSC_VER)
     data = _aligned_malloc(nbytes, gCaffe2Alignment);
 #else
-    CAFFE_ENFORCE_EQ(posix_memalign(&data, gCaffe2Alignment, nbytes), 0);
+    size_t alignment = IsNUMAEnabled() && nbytes >= gCaffe2NUMAPageSize
+        ? gCaffe2NUMAPageSize
+        : gCaffe2Alignment;
+    CAFFE_ENFORCE_EQ(posix_memalign(&data, alignment, nbytes), 0);
 #endif
     CAFFE_ENFORCE(data);
-    // move data to a thread's NUMA node
-    NUMAMove(data, nbytes, GetCurrentNUMANode());
+    if (IsNUMAEnabled()) {
+      // move data to the node the thread's pool is bound to, or else to the
+      // node the thread happens to be running on
+      int numa_node_id = GetThreadNUMANode();
+      NUMAMove(
+          data,
+          nbytes,
+          numa_node_id >= 0 ? numa_node_id : GetCurrentNUMANode());
+    }
     if (FLAGS_caffe2_cpu_allocator_do_zero_fill) {
       memset(data, 0, nbytes);
     }
+#ifdef CAFFE2_ENABLE_SDT
+    CAFFE_SDT(cpu_alloc, data, nbytes);
+#endif
     return {data, Delete};
   }
 
@@ -68,6 +109,9 @@ struct DefaultCPUAllocator final : CPUAllocator {
   }
 #else
   static void Delete(void* data) {
+#ifdef CAFFE2_ENABLE_SDT
+    CAFFE_SDT(cpu_free, data);
+#endif
     free(data);
   }
 #endif
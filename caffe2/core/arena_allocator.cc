@@ -0,0 +1,390 @@
+#include "caffe2/core/arena_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "caffe2/core/init.h"
+#include "caffe2/core/static_tracepoint.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#define CAFFE2_ARENA_USE_MMAP
+#endif
+
+CAFFE2_DEFINE_string(
+    caffe2_cpu_allocator,
+    "",
+    "The CPU allocator to use: empty or 'default' for the default allocator, "
+    "'arena' for the caching ArenaCPUAllocator.");
+CAFFE2_DEFINE_int(
+    caffe2_cpu_arena_thread_cache_mb,
+    64,
+    "Size of the freed blocks each thread caches in the arena allocator "
+    "before handing them to the shared cache.");
+CAFFE2_DEFINE_int(
+    caffe2_cpu_arena_max_cached_mb,
+    1024,
+    "Size of the freed blocks the shared cache of the arena allocator holds "
+    "before returning them to the system.");
+
+namespace caffe2 {
+
+namespace {
+
+// Every block starts with a header, which the deleter finds right before
+// the data.
+struct BlockHeader {
+  uint32_t magic;
+  // -1 for blocks too large to be cached
+  int32_t size_class;
+  // size of the whole block, header included
+  size_t block_bytes;
+  bool mapped;
+};
+
+constexpr size_t kHeaderBytes = 64;
+static_assert(sizeof(BlockHeader) <= kHeaderBytes, "header too large");
+static_assert(
+    kHeaderBytes % gCaffe2Alignment == 0,
+    "header breaks the alignment of the data");
+
+constexpr uint32_t kBlockMagic = 0xa2e4ab10;
+constexpr size_t kMinClassBytes = 64;
+constexpr size_t kMaxClassBytes = size_t(64) << 20;
+constexpr size_t kHugePageBytes = size_t(2) << 20;
+constexpr size_t kPageBytes = 4096;
+
+inline BlockHeader* HeaderOf(void* data) {
+  return reinterpret_cast<BlockHeader*>(
+      static_cast<char*>(data) - kHeaderBytes);
+}
+
+class Arena {
+ public:
+  Arena() {
+    for (size_t base = kMinClassBytes; base < kMaxClassBytes; base *= 2) {
+      for (size_t step = 0; step < 4; ++step) {
+        class_bytes_.push_back(base + step * (base / 4));
+      }
+    }
+    class_bytes_.push_back(kMaxClassBytes);
+    central_.reset(new CentralList[class_bytes_.size()]);
+  }
+
+  size_t NumClasses() const {
+    return class_bytes_.size();
+  }
+
+  // smallest size class that fits nbytes, or -1 if none does
+  int SizeClass(size_t nbytes) const {
+    auto it =
+        std::lower_bound(class_bytes_.begin(), class_bytes_.end(), nbytes);
+    return it == class_bytes_.end() ? -1 : int(it - class_bytes_.begin());
+  }
+
+  size_t ClassBytes(int size_class) const {
+    return class_bytes_[size_class];
+  }
+
+  void* SystemAlloc(size_t nbytes, int size_class) {
+    size_t block_bytes = kHeaderBytes + nbytes;
+    void* base = nullptr;
+    bool mapped = false;
+#ifdef CAFFE2_ARENA_USE_MMAP
+    if (block_bytes >= kHugePageBytes) {
+      block_bytes = (block_bytes + kPageBytes - 1) / kPageBytes * kPageBytes;
+      base = mmap(
+          nullptr,
+          block_bytes,
+          PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_ANONYMOUS,
+          -1,
+          0);
+      CAFFE_ENFORCE(
+          base != MAP_FAILED, "mmap of ", block_bytes, " bytes failed");
+#ifdef MADV_HUGEPAGE
+      madvise(base, block_bytes, MADV_HUGEPAGE);
+#endif
+      mapped = true;
+      huge_page_bytes_ += block_bytes;
+    }
+#endif
+    if (!base) {
+#ifdef __ANDROID__
+      base = memalign(kHeaderBytes, block_bytes);
+#elif defined(_MSC_VER)
+      base = _aligned_malloc(block_bytes, kHeaderBytes);
+#else
+      CAFFE_ENFORCE_EQ(posix_memalign(&base, kHeaderBytes, block_bytes), 0);
+#endif
+      CAFFE_ENFORCE(base);
+    }
+    auto header = static_cast<BlockHeader*>(base);
+    header->magic = kBlockMagic;
+    header->size_class = size_class;
+    header->block_bytes = block_bytes;
+    header->mapped = mapped;
+    reserved_bytes_ += block_bytes;
+    ++num_system_allocs_;
+    return static_cast<char*>(base) + kHeaderBytes;
+  }
+
+  void SystemFree(void* data) {
+    auto header = HeaderOf(data);
+    size_t block_bytes = header->block_bytes;
+    reserved_bytes_ -= block_bytes;
+#ifdef CAFFE2_ARENA_USE_MMAP
+    if (header->mapped) {
+      huge_page_bytes_ -= block_bytes;
+      munmap(header, block_bytes);
+      return;
+    }
+#endif
+#ifdef _MSC_VER
+    _aligned_free(header);
+#else
+    free(header);
+#endif
+  }
+
+  void* CentralPop(int size_class) {
+    auto& list = central_[size_class];
+    std::lock_guard<std::mutex> lock(list.mutex);
+    if (list.blocks.empty()) {
+      return nullptr;
+    }
+    void* data = list.blocks.back();
+    list.blocks.pop_back();
+    central_bytes_ -= ClassBytes(size_class);
+    return data;
+  }
+
+  // Moves the blocks to the shared cache, returning to the system those
+  // that do not fit in it. Empties blocks.
+  void CentralPush(int size_class, std::vector<void*>* blocks) {
+    size_t max_bytes = size_t(FLAGS_caffe2_cpu_arena_max_cached_mb) << 20;
+    size_t bytes = ClassBytes(size_class);
+    std::vector<void*> released;
+    {
+      auto& list = central_[size_class];
+      std::lock_guard<std::mutex> lock(list.mutex);
+      for (void* data : *blocks) {
+        if (central_bytes_ + bytes <= max_bytes) {
+          list.blocks.push_back(data);
+          central_bytes_ += bytes;
+        } else {
+          released.push_back(data);
+        }
+      }
+    }
+    blocks->clear();
+    for (void* data : released) {
+      SystemFree(data);
+    }
+  }
+
+  void ReleaseCentral() {
+    for (size_t c = 0; c < NumClasses(); ++c) {
+      std::vector<void*> released;
+      {
+        auto& list = central_[c];
+        std::lock_guard<std::mutex> lock(list.mutex);
+        released.swap(list.blocks);
+        central_bytes_ -= released.size() * ClassBytes(c);
+      }
+      for (void* data : released) {
+        SystemFree(data);
+      }
+    }
+  }
+
+  std::atomic<size_t> allocated_bytes_{0};
+  std::atomic<size_t> reserved_bytes_{0};
+  std::atomic<size_t> huge_page_bytes_{0};
+  std::atomic<uint64_t> num_allocs_{0};
+  std::atomic<uint64_t> num_thread_cache_hits_{0};
+  std::atomic<uint64_t> num_central_cache_hits_{0};
+  std::atomic<uint64_t> num_system_allocs_{0};
+
+ private:
+  struct CentralList {
+    std::mutex mutex;
+    std::vector<void*> blocks;
+  };
+
+  std::vector<size_t> class_bytes_;
+  std::unique_ptr<CentralList[]> central_;
+  std::atomic<size_t> central_bytes_{0};
+};
+
+// Never destroyed, so that tensors freed during static destruction can still
+// be returned to it.
+Arena& GetArena() {
+  static Arena* arena = new Arena();
+  return *arena;
+}
+
+class ThreadCache {
+ public:
+  ThreadCache() : blocks_(GetArena().NumClasses()) {}
+
+  void* Pop(int size_class) {
+    auto& blocks = blocks_[size_class];
+    if (blocks.empty()) {
+      return nullptr;
+    }
+    void* data = blocks.back();
+    blocks.pop_back();
+    bytes_ -= GetArena().ClassBytes(size_class);
+    return data;
+  }
+
+  void Push(int size_class, void* data) {
+    blocks_[size_class].push_back(data);
+    bytes_ += GetArena().ClassBytes(size_class);
+    if (bytes_ > size_t(FLAGS_caffe2_cpu_arena_thread_cache_mb) << 20) {
+      Flush(size_class);
+    }
+  }
+
+  void FlushAll() {
+    for (size_t c = 0; c < blocks_.size(); ++c) {
+      Flush(c);
+    }
+  }
+
+ private:
+  void Flush(int size_class) {
+    auto& blocks = blocks_[size_class];
+    bytes_ -= blocks.size() * GetArena().ClassBytes(size_class);
+    GetArena().CentralPush(size_class, &blocks);
+  }
+
+  std::vector<std::vector<void*>> blocks_;
+  size_t bytes_ = 0;
+};
+
+// Blocks freed by a thread after its cache was destroyed at exit go straight
+// to the shared cache.
+thread_local bool thread_cache_destroyed = false;
+
+struct ThreadCacheHolder {
+  ~ThreadCacheHolder() {
+    cache.FlushAll();
+    thread_cache_destroyed = true;
+  }
+  ThreadCache cache;
+};
+
+ThreadCache* GetThreadCache() {
+  if (thread_cache_destroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadCacheHolder holder;
+  return &holder.cache;
+}
+
+} // namespace
+
+std::pair<void*, MemoryDeleter> ArenaCPUAllocator::New(size_t nbytes) {
+  auto& arena = GetArena();
+  int size_class = arena.SizeClass(nbytes);
+  void* data = nullptr;
+  if (size_class >= 0) {
+    auto cache = GetThreadCache();
+    if (cache && (data = cache->Pop(size_class))) {
+      ++arena.num_thread_cache_hits_;
+    } else if ((data = arena.CentralPop(size_class))) {
+      ++arena.num_central_cache_hits_;
+    }
+  }
+  if (!data) {
+    size_t block_nbytes =
+        size_class >= 0 ? arena.ClassBytes(size_class) : nbytes;
+    data = arena.SystemAlloc(block_nbytes, size_class);
+    if (IsNUMAEnabled()) {
+      int numa_node_id = GetThreadNUMANode();
+      NUMAMove(
+          data,
+          block_nbytes,
+          numa_node_id >= 0 ? numa_node_id : GetCurrentNUMANode());
+    }
+  }
+  arena.allocated_bytes_ += HeaderOf(data)->block_bytes;
+  ++arena.num_allocs_;
+  if (FLAGS_caffe2_cpu_allocator_do_zero_fill) {
+    memset(data, 0, nbytes);
+  }
+#ifdef CAFFE2_ENABLE_SDT
+  CAFFE_SDT(cpu_alloc, data, nbytes);
+#endif
+  return {data, Delete};
+}
+
+void ArenaCPUAllocator::Delete(void* data) {
+  if (!data) {
+    return;
+  }
+#ifdef CAFFE2_ENABLE_SDT
+  CAFFE_SDT(cpu_free, data);
+#endif
+  auto& arena = GetArena();
+  auto header = HeaderOf(data);
+  CHECK_EQ(header->magic, kBlockMagic)
+      << "Freeing memory not allocated by ArenaCPUAllocator";
+  arena.allocated_bytes_ -= header->block_bytes;
+  int size_class = header->size_class;
+  if (size_class < 0) {
+    arena.SystemFree(data);
+    return;
+  }
+  auto cache = GetThreadCache();
+  if (cache) {
+    cache->Push(size_class, data);
+  } else {
+    std::vector<void*> blocks{data};
+    arena.CentralPush(size_class, &blocks);
+  }
+}
+
+ArenaCPUAllocatorStats ArenaCPUAllocator::GetStats() {
+  auto& arena = GetArena();
+  ArenaCPUAllocatorStats stats;
+  stats.allocated_bytes = arena.allocated_bytes_;
+  stats.reserved_bytes = arena.reserved_bytes_;
+  stats.huge_page_bytes = arena.huge_page_bytes_;
+  stats.num_allocs = arena.num_allocs_;
+  stats.num_thread_cache_hits = arena.num_thread_cache_hits_;
+  stats.num_central_cache_hits = arena.num_central_cache_hits_;
+  stats.num_system_allocs = arena.num_system_allocs_;
+  return stats;
+}
+
+void ArenaCPUAllocator::ReleaseCachedMemory() {
+  GetArena().ReleaseCentral();
+}
+
+static bool Caffe2SetCPUAllocator(int*, char***) {
+  if (FLAGS_caffe2_cpu_allocator == "" ||
+      FLAGS_caffe2_cpu_allocator == "default") {
+    return true;
+  }
+  if (FLAGS_caffe2_cpu_allocator == "arena") {
+    VLOG(1) << "Caffe2: setting CPUAllocator to ArenaCPUAllocator.";
+    SetCPUAllocator(new ArenaCPUAllocator());
+    return true;
+  }
+  LOG(ERROR) << "Unrecognized cpu allocator: " << FLAGS_caffe2_cpu_allocator;
+  return false;
+}
+
+REGISTER_CAFFE2_INIT_FUNCTION(
+    Caffe2SetCPUAllocator,
+    &Caffe2SetCPUAllocator,
+    "Sets the CPU allocator selected by --caffe2_cpu_allocator");
+
+} // namespace caffe2
@@ -0,0 +1,70 @@
+#ifndef CAFFE2_CORE_ARENA_ALLOCATOR_H_
+#define CAFFE2_CORE_ARENA_ALLOCATOR_H_
+
+#include <cstdint>
+
+#include "caffe2/core/allocator.h"
+
+CAFFE2_DECLARE_string(caffe2_cpu_allocator);
+CAFFE2_DECLARE_int(caffe2_cpu_arena_thread_cache_mb);
+CAFFE2_DECLARE_int(caffe2_cpu_arena_max_cached_mb);
+
+namespace caffe2 {
+
+// Snapshot of the state of the arena allocator. Byte counts are those of
+// whole blocks, so they include the rounding up of the requested sizes to
+// size classes and a small header.
+struct ArenaCPUAllocatorStats {
+  // bytes currently handed out to tensors
+  size_t allocated_bytes = 0;
+  // bytes held from the system, allocated or cached
+  size_t reserved_bytes = 0;
+  // part of reserved_bytes that is backed by huge pages
+  size_t huge_page_bytes = 0;
+  uint64_t num_allocs = 0;
+  // allocations served by the cache of the calling thread
+  uint64_t num_thread_cache_hits = 0;
+  // allocations served by the cache shared by all threads
+  uint64_t num_central_cache_hits = 0;
+  // allocations that had to go to the system
+  uint64_t num_system_allocs = 0;
+};
+
+/**
+ * A CPU allocator that caches freed blocks by size class, so that the same
+ * sized tensors that are allocated and freed over and over in a net are
+ * recycled without going through malloc.
+ *
+ * Sizes are rounded up to one of four classes per power of two. Freed blocks
+ * go to a cache of the freeing thread, which needs no lock; once that cache
+ * holds more than --caffe2_cpu_arena_thread_cache_mb, a size class is moved
+ * to a cache shared by all threads, which in turn returns blocks to the
+ * system beyond --caffe2_cpu_arena_max_cached_mb. Blocks of 2MB or more are
+ * mapped directly and backed by transparent huge pages where available.
+ *
+ * The cached blocks live for the whole program, independently of the
+ * allocator object, so memory from it can be freed after SetCPUAllocator
+ * replaced it. With NUMA enabled, only new blocks are moved to the node of
+ * the allocating thread; recycled ones stay where they are.
+ *
+ * Select it with --caffe2_cpu_allocator=arena.
+ */
+struct ArenaCPUAllocator final : CPUAllocator {
+  ArenaCPUAllocator() {}
+  ~ArenaCPUAllocator() override {}
+  std::pair<void*, MemoryDeleter> New(size_t nbytes) override;
+  MemoryDeleter GetDeleter() override {
+    return Delete;
+  }
+
+  static void Delete(void* data);
+
+  static ArenaCPUAllocatorStats GetStats();
+  // Returns the blocks in the shared cache to the system. The caches of the
+  // threads are flushed when the threads exit.
+  static void ReleaseCachedMemory();
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_ARENA_ALLOCATOR_H_
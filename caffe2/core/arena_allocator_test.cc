@@ -0,0 +1,96 @@
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "caffe2/core/arena_allocator.h"
+
+namespace caffe2 {
+
+TEST(ArenaCPUAllocatorTest, TestAlignment) {
+  ArenaCPUAllocator allocator;
+  for (size_t nbytes : {1, 7, 64, 100, 4096, 100000}) {
+    auto data = allocator.New(nbytes);
+    EXPECT_EQ(reinterpret_cast<size_t>(data.first) % gCaffe2Alignment, 0);
+    data.second(data.first);
+  }
+}
+
+TEST(ArenaCPUAllocatorTest, TestReuse) {
+  ArenaCPUAllocator allocator;
+  auto first = allocator.New(1000);
+  first.second(first.first);
+  auto before = ArenaCPUAllocator::GetStats();
+  // a freed block is recycled for the same size class
+  auto second = allocator.New(1000);
+  EXPECT_EQ(second.first, first.first);
+  auto after = ArenaCPUAllocator::GetStats();
+  EXPECT_EQ(after.num_thread_cache_hits, before.num_thread_cache_hits + 1);
+  EXPECT_EQ(after.num_system_allocs, before.num_system_allocs);
+  second.second(second.first);
+}
+
+TEST(ArenaCPUAllocatorTest, TestZeroFill) {
+  ArenaCPUAllocator allocator;
+  auto first = allocator.New(256);
+  memset(first.first, 0xff, 256);
+  first.second(first.first);
+  auto second = allocator.New(256);
+  ASSERT_EQ(second.first, first.first);
+  for (int i = 0; i < 256; ++i) {
+    EXPECT_EQ(static_cast<char*>(second.first)[i], 0);
+  }
+  second.second(second.first);
+}
+
+TEST(ArenaCPUAllocatorTest, TestCrossThreadFree) {
+  ArenaCPUAllocator allocator;
+  std::vector<void*> blocks;
+  for (int i = 0; i < 16; ++i) {
+    blocks.push_back(allocator.New(5000).first);
+  }
+  // blocks freed by a thread that exits end up in the shared cache
+  std::thread([&] {
+    for (void* data : blocks) {
+      ArenaCPUAllocator::Delete(data);
+    }
+  }).join();
+  auto before = ArenaCPUAllocator::GetStats();
+  auto data = allocator.New(5000);
+  auto after = ArenaCPUAllocator::GetStats();
+  EXPECT_EQ(after.num_central_cache_hits, before.num_central_cache_hits + 1);
+  EXPECT_EQ(after.num_system_allocs, before.num_system_allocs);
+  data.second(data.first);
+}
+
+TEST(ArenaCPUAllocatorTest, TestLargeBlocks) {
+  ArenaCPUAllocator allocator;
+  auto before = ArenaCPUAllocator::GetStats();
+  // too large for any size class, so returned to the system when freed
+  size_t nbytes = size_t(100) << 20;
+  auto data = allocator.New(nbytes);
+  static_cast<char*>(data.first)[nbytes - 1] = 1;
+  auto during = ArenaCPUAllocator::GetStats();
+  EXPECT_GE(during.allocated_bytes, before.allocated_bytes + nbytes);
+#ifdef __linux__
+  EXPECT_GE(during.huge_page_bytes, before.huge_page_bytes + nbytes);
+#endif
+  data.second(data.first);
+  auto after = ArenaCPUAllocator::GetStats();
+  EXPECT_EQ(after.allocated_bytes, before.allocated_bytes);
+  EXPECT_EQ(after.reserved_bytes, before.reserved_bytes);
+}
+
+TEST(ArenaCPUAllocatorTest, TestReleaseCachedMemory) {
+  ArenaCPUAllocator allocator;
+  std::thread([&] {
+    auto data = allocator.New(300000);
+    data.second(data.first);
+  }).join();
+  auto before = ArenaCPUAllocator::GetStats();
+  ArenaCPUAllocator::ReleaseCachedMemory();
+  auto after = ArenaCPUAllocator::GetStats();
+  EXPECT_LT(after.reserved_bytes, before.reserved_bytes);
+  EXPECT_EQ(after.allocated_bytes, before.allocated_bytes);
+}
+
+} // namespace caffe2
@@ -21,7 +21,49 @@ CAFFE2_DEFINE_bool(
     false,
     "Serialize FLOAT16 tensors using byte_data field");
 
+CAFFE2_DEFINE_bool(
+    caffe2_serialize_tensors_as_bytes,
+    false,
+    "Serialize tensors of fixed size types as their raw little-endian bytes "
+    "in the byte_data field, instead of one repeated field item per element");
+
+CAFFE2_DEFINE_string(
+    caffe2_tensor_compression,
+    "",
+    "Compression of the tensors of fixed size types in serialized blobs, one "
+    "frame per chunk: \"zstd\" (needs caffe2 built with USE_ZSTD), or empty "
+    "for none. Compressed tensors are loaded whatever this is set to.");
+
 namespace caffe2 {
+
+CAFFE_DEFINE_TYPED_REGISTRY(
+    TensorCompressorRegistry,
+    int,
+    TensorCompressorBase,
+    std::unique_ptr);
+
+unique_ptr<TensorCompressorBase> CreateTensorCompressor(
+    TensorProto::Compression compression) {
+  auto compressor = TensorCompressorRegistry()->Create(compression);
+  CAFFE_ENFORCE(
+      compressor,
+      "No compressor is registered for tensor compression ",
+      compression,
+      ", caffe2 was probably built without it.");
+  return compressor;
+}
+
+TensorProto::Compression SerializedTensorCompression() {
+  const auto& compression = FLAGS_caffe2_tensor_compression;
+  if (compression.empty()) {
+    return TensorProto_Compression_NO_COMPRESSION;
+  }
+  if (compression == "zstd") {
+    return TensorProto_Compression_ZSTD;
+  }
+  CAFFE_THROW("Unknown tensor compression: ", compression);
+}
+
 /**
  * @brief StringSerializer is the serializer for String.
  *
@@ -106,7 +148,8 @@ void Blob::Deserialize(const string& content) {
   Deserialize(blob_proto);
 }
 
-void Blob::Deserialize(const BlobProto& blob_proto) {
+unique_ptr<BlobDeserializerBase> CreateDeserializerForProto(
+    const BlobProto& blob_proto) {
   if (blob_proto.type() == kTensorBlobType) {
     // This is a tensor object. Depending on the device type, we will
     // use the corresponding TensorDeserializer.
@@ -116,15 +159,18 @@ void Blob::Deserialize(const BlobProto& blob_proto) {
     // Tensor's deserializer should always be registered, but we will double
     // check if it is not null anyway.
     CAFFE_ENFORCE(deserializer.get());
-    deserializer->Deserialize(blob_proto, this);
-  } else {
-    auto deserializer = CreateDeserializer(blob_proto.type());
-    CAFFE_ENFORCE(
-        deserializer.get(),
-        "No registered deserializer for type ",
-        blob_proto.type());
-    deserializer->Deserialize(blob_proto, this);
+    return deserializer;
   }
+  auto deserializer = CreateDeserializer(blob_proto.type());
+  CAFFE_ENFORCE(
+      deserializer.get(),
+      "No registered deserializer for type ",
+      blob_proto.type());
+  return deserializer;
+}
+
+void Blob::Deserialize(const BlobProto& blob_proto) {
+  CreateDeserializerForProto(blob_proto)->Deserialize(blob_proto, this);
 }
 
 namespace {
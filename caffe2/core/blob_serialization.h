@@ -2,6 +2,9 @@
 #define CAFFE2_CORE_BLOB_SERIALIZATION_H_
 
 #include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
 #include <future>
 
 #include <google/protobuf/repeated_field.h>
@@ -16,6 +19,8 @@
 CAFFE2_DECLARE_int(caffe2_tensor_chunk_size);
 CAFFE2_DECLARE_int(caffe2_max_tensor_serializer_threads);
 CAFFE2_DECLARE_bool(caffe2_serialize_fp16_as_bytes);
+CAFFE2_DECLARE_bool(caffe2_serialize_tensors_as_bytes);
+CAFFE2_DECLARE_string(caffe2_tensor_compression);
 
 namespace caffe2 {
 
@@ -70,6 +75,35 @@ class TensorSerializer : public BlobSerializerBase {
   Context context_;
 };
 
+/**
+ * @brief TensorCompressorBase compresses the byte_data of TensorProtos.
+ *
+ * Compressors are registered under their TensorProto::Compression by the
+ * library bringing in the compression library (see caffe2/share/contrib/zstd),
+ * so that core does not depend on any.
+ */
+class TensorCompressorBase {
+ public:
+  virtual ~TensorCompressorBase() {}
+
+  virtual void Compress(const void* src, size_t nbytes, std::string* dst) = 0;
+  // Decompresses src into dst, which holds exactly the nbytes src expands to
+  virtual void Decompress(const std::string& src, void* dst, size_t nbytes) = 0;
+};
+
+CAFFE_DECLARE_TYPED_REGISTRY(
+    TensorCompressorRegistry,
+    int,
+    TensorCompressorBase,
+    std::unique_ptr);
+#define REGISTER_TENSOR_COMPRESSOR(compression, ...) \
+  CAFFE_REGISTER_TYPED_CLASS(TensorCompressorRegistry, compression, __VA_ARGS__)
+// Fails when no compressor is registered for the compression.
+unique_ptr<TensorCompressorBase> CreateTensorCompressor(
+    TensorProto::Compression compression);
+// The compression that --caffe2_tensor_compression asks for.
+TensorProto::Compression SerializedTensorCompression();
+
 /**
  * @brief BlobDeserializerBase is an abstract class that deserializes a blob
  * from a BlobProto or a TensorProto.
@@ -80,6 +114,19 @@ class BlobDeserializerBase {
 
   // Deserializes from a BlobProto object.
   virtual void Deserialize(const BlobProto& proto, Blob* blob) = 0;
+
+  // If this returns true for the chunks of a blob, they can be deserialized
+  // concurrently with DeserializeChunk, after Prepare has been called once
+  // with any one of them. Otherwise every chunk goes through Deserialize.
+  virtual bool SupportsConcurrentChunks(const BlobProto& /*proto*/) const {
+    return false;
+  }
+  virtual void Prepare(const BlobProto& /*proto*/, Blob* /*blob*/) {
+    CAFFE_THROW("Concurrent chunks are not supported");
+  }
+  virtual void DeserializeChunk(const BlobProto& /*proto*/, Blob* /*blob*/) {
+    CAFFE_THROW("Concurrent chunks are not supported");
+  }
 };
 
 CAFFE_DECLARE_REGISTRY(BlobDeserializerRegistry, BlobDeserializerBase);
@@ -89,6 +136,9 @@ CAFFE_DECLARE_REGISTRY(BlobDeserializerRegistry, BlobDeserializerBase);
 inline unique_ptr<BlobDeserializerBase> CreateDeserializer(const string& type) {
   return BlobDeserializerRegistry()->Create(type);
 }
+// Creates the deserializer that Blob::Deserialize uses for the proto.
+unique_ptr<BlobDeserializerBase> CreateDeserializerForProto(
+    const BlobProto& proto);
 
 /**
  * @brief TensorDeserializer is the deserializer for Tensors.
@@ -103,8 +153,44 @@ class TensorDeserializer : public BlobDeserializerBase {
  public:
   void Deserialize(const BlobProto& proto, Blob* blob) override;
   void Deserialize(const TensorProto& proto, Tensor<Context>* tensor);
+
+  // Any type but UNDEFINED, which only knows its type once the first item
+  // is deserialized
+  bool SupportsConcurrentChunks(const BlobProto& proto) const override {
+    return proto.tensor().data_type() != TensorProto_DataType_UNDEFINED;
+  }
+  // Allocates the whole tensor
+  void Prepare(const BlobProto& proto, Blob* blob) override;
+  // Copies the chunk into the tensor that Prepare allocated
+  void DeserializeChunk(const BlobProto& proto, Blob* blob) override;
+
+ private:
+  void CopyChunk(
+      const TensorProto& proto,
+      Tensor<Context>* tensor,
+      Context* context);
 };
 
+// Types whose items are stored in byte_data as they are in memory with
+// --caffe2_serialize_tensors_as_bytes
+inline bool IsFixedSizeDataType(TensorProto::DataType data_type) {
+  switch (data_type) {
+    case TensorProto_DataType_FLOAT:
+    case TensorProto_DataType_INT32:
+    case TensorProto_DataType_BOOL:
+    case TensorProto_DataType_UINT8:
+    case TensorProto_DataType_INT8:
+    case TensorProto_DataType_UINT16:
+    case TensorProto_DataType_INT16:
+    case TensorProto_DataType_INT64:
+    case TensorProto_DataType_FLOAT16:
+    case TensorProto_DataType_DOUBLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Implementations
 ////////////////////////////////////////////////////////////////////////////////
@@ -180,6 +266,41 @@ inline void CopyFromProtoWithCast(
   context->template Copy<DstType, CPUContext, Context>(size, buffer.get(), dst);
 }
 
+inline void EnforceLittleEndian() {
+  const int kValue = 1;
+  CAFFE_ENFORCE_EQ(
+      reinterpret_cast<const char*>(&kValue)[0],
+      1,
+      "Serialization as bytes on big endian platform is not written yet.");
+}
+
+template <class Context>
+inline void CopyToBytes(
+    const size_t nbytes,
+    const void* src,
+    std::string* bytes,
+    Context* context) {
+  EnforceLittleEndian();
+  bytes->resize(nbytes);
+  if (nbytes > 0) {
+    context->template Copy<char, Context, CPUContext>(
+        nbytes, static_cast<const char*>(src), &(*bytes)[0]);
+    context->FinishDeviceComputation();
+  }
+}
+
+template <class Context>
+inline void CopyFromBytes(
+    const size_t nbytes,
+    const std::string& bytes,
+    void* dst,
+    Context* context) {
+  EnforceLittleEndian();
+  CAFFE_ENFORCE_EQ(nbytes, bytes.size(), "Incorrect proto field size.");
+  context->template Copy<char, CPUContext, Context>(
+      nbytes, bytes.data(), static_cast<char*>(dst));
+}
+
 }  // namespace detail
 
 template <class Context>
@@ -297,6 +418,35 @@ void TensorSerializer<Context>::Serialize(
   proto.set_data_type(data_type);
   StoreDeviceDetail(input, &proto);
 
+  const auto compression = SerializedTensorCompression();
+  if (compression != TensorProto_Compression_NO_COMPRESSION &&
+      IsFixedSizeDataType(data_type)) {
+    detail::EnforceLittleEndian();
+    const size_t nbytes = chunkSize * input.itemsize();
+    const char* src = static_cast<const char*>(input.raw_data()) +
+        chunkBegin * input.itemsize();
+    std::string bytes;
+    if (!std::is_same<Context, CPUContext>::value) {
+      detail::CopyToBytes(nbytes, src, &bytes, &this->context_);
+      src = bytes.data();
+    }
+    CreateTensorCompressor(compression)
+        ->Compress(src, nbytes, proto.mutable_byte_data());
+    proto.set_compression(compression);
+    return;
+  }
+
+  if (FLAGS_caffe2_serialize_tensors_as_bytes &&
+      IsFixedSizeDataType(data_type)) {
+    detail::CopyToBytes(
+        chunkSize * input.itemsize(),
+        static_cast<const char*>(input.raw_data()) +
+            chunkBegin * input.itemsize(),
+        proto.mutable_byte_data(),
+        &this->context_);
+    return;
+  }
+
   // A lot of copypaste is error prone. Should we create a macro for this?
   switch (data_type) {
   case TensorProto_DataType_FLOAT:
@@ -370,20 +520,11 @@ void TensorSerializer<Context>::Serialize(
     break;
   case TensorProto_DataType_FLOAT16: {
     if (FLAGS_caffe2_serialize_fp16_as_bytes) {
-      const int kValue = 1;
-      CAFFE_ENFORCE_EQ(
-          reinterpret_cast<const char*>(&kValue)[0],
-          1,
-          "Serialization of FLOAT16 on big endian platform "
-          "is not written yet.");
-      unique_ptr<char[]> buffer(new char[2 * chunkSize]);
-      this->context_.template Copy<char, Context, CPUContext>(
+      detail::CopyToBytes(
           2 * chunkSize,
-          reinterpret_cast<const char*>(
-              input.template data<float16>() + chunkBegin),
-          buffer.get());
-      this->context_.FinishDeviceComputation();
-      proto.set_byte_data(buffer.release(), 2 * chunkSize);
+          input.template data<float16>() + chunkBegin,
+          proto.mutable_byte_data(),
+          &this->context_);
     } else {
       detail::CopyToProtoWithCast(
           chunkSize,
@@ -435,7 +576,51 @@ void TensorDeserializer<Context>::Deserialize(
     dims.push_back(d);
   }
   tensor->Resize(dims);
+  CopyChunk(proto, tensor, &context);
+  context.FinishDeviceComputation();
+}
 
+template <class Context>
+void TensorDeserializer<Context>::Prepare(
+    const BlobProto& blob_proto,
+    Blob* blob) {
+  const auto& proto = blob_proto.tensor();
+  Context context(proto.device_detail());
+  context.SwitchToDevice(0);
+  auto* tensor = blob->GetMutable<Tensor<Context>>();
+  vector<TIndex> dims;
+  for (const TIndex d : proto.dims()) {
+    dims.push_back(d);
+  }
+  tensor->Resize(dims);
+  tensor->raw_mutable_data(DataTypeToTypeMeta(proto.data_type()));
+}
+
+template <class Context>
+void TensorDeserializer<Context>::DeserializeChunk(
+    const BlobProto& blob_proto,
+    Blob* blob) {
+  const auto& proto = blob_proto.tensor();
+  Context context(proto.device_detail());
+  context.SwitchToDevice(0);
+  auto* tensor = blob->GetMutable<Tensor<Context>>();
+  int64_t size = 1;
+  for (const TIndex d : proto.dims()) {
+    size *= d;
+  }
+  CAFFE_ENFORCE_EQ(size, tensor->size(), "Chunks of different shapes");
+  CAFFE_ENFORCE(
+      tensor->meta() == DataTypeToTypeMeta(proto.data_type()),
+      "Chunks of different types");
+  CopyChunk(proto, tensor, &context);
+  context.FinishDeviceComputation();
+}
+
+template <class Context>
+void TensorDeserializer<Context>::CopyChunk(
+    const TensorProto& proto,
+    Tensor<Context>* tensor,
+    Context* context) {
   int64_t chunkBegin = 0;
   auto chunkEnd = tensor->size();
   if (proto.has_segment()) {
@@ -452,27 +637,63 @@ void TensorDeserializer<Context>::Deserialize(
       tensor->size());
   auto chunkSize = chunkEnd - chunkBegin;
 
+  if (proto.compression() != TensorProto_Compression_NO_COMPRESSION) {
+    CAFFE_ENFORCE(
+        IsFixedSizeDataType(proto.data_type()),
+        "Compressed tensor of type ",
+        proto.data_type());
+    detail::EnforceLittleEndian();
+    const auto meta = DataTypeToTypeMeta(proto.data_type());
+    const size_t nbytes = chunkSize * meta.itemsize();
+    char* dst = static_cast<char*>(tensor->raw_mutable_data(meta)) +
+        chunkBegin * meta.itemsize();
+    auto compressor = CreateTensorCompressor(proto.compression());
+    if (std::is_same<Context, CPUContext>::value) {
+      // Straight into the tensor
+      compressor->Decompress(proto.byte_data(), dst, nbytes);
+    } else {
+      std::vector<char> buffer(nbytes);
+      compressor->Decompress(proto.byte_data(), buffer.data(), nbytes);
+      context->template Copy<char, CPUContext, Context>(
+          nbytes, buffer.data(), dst);
+      // the copy may be asynchronous, and the buffer is freed on return
+      context->FinishDeviceComputation();
+    }
+    return;
+  }
+
+  if (proto.has_byte_data() && IsFixedSizeDataType(proto.data_type())) {
+    const auto meta = DataTypeToTypeMeta(proto.data_type());
+    detail::CopyFromBytes(
+        chunkSize * meta.itemsize(),
+        proto.byte_data(),
+        static_cast<char*>(tensor->raw_mutable_data(meta)) +
+            chunkBegin * meta.itemsize(),
+        context);
+    return;
+  }
+
   switch (proto.data_type()) {
     case TensorProto_DataType_FLOAT:
       detail::CopyFromProtoAsIs(
           chunkSize,
           proto.float_data(),
           tensor->template mutable_data<float>() + chunkBegin,
-          &context);
+          context);
       break;
     case TensorProto_DataType_INT32:
       detail::CopyFromProtoAsIs(
           chunkSize,
           proto.int32_data(),
           tensor->template mutable_data<int>() + chunkBegin,
-          &context);
+          context);
       break;
     case TensorProto_DataType_BYTE:
       // Since BYTE stores the data in a string field instead of a repreated
       // field we will have it special cased.
       CAFFE_ENFORCE_EQ(
           chunkSize, proto.byte_data().size(), "Incorrect proto field size.");
-      context.template Copy<uint8_t, Context, CPUContext>(
+      context->template Copy<uint8_t, Context, CPUContext>(
           chunkSize,
           reinterpret_cast<const uint8_t*>(proto.byte_data().data()),
           tensor->template mutable_data<uint8_t>() + chunkBegin);
@@ -491,76 +712,60 @@ void TensorDeserializer<Context>::Deserialize(
           chunkSize,
           proto.int32_data(),
           tensor->template mutable_data<bool>() + chunkBegin,
-          &context);
+          context);
       break;
     case TensorProto_DataType_UINT8:
       detail::CopyFromProtoWithCast(
           chunkSize,
           proto.int32_data(),
           tensor->template mutable_data<uint8_t>() + chunkBegin,
-          &context);
+          context);
       break;
     case TensorProto_DataType_INT8:
       detail::CopyFromProtoWithCast(
           chunkSize,
           proto.int32_data(),
           tensor->template mutable_data<int8_t>() + chunkBegin,
-          &context);
+          context);
       break;
     case TensorProto_DataType_UINT16:
       detail::CopyFromProtoWithCast(
           chunkSize,
           proto.int32_data(),
           tensor->template mutable_data<uint16_t>() + chunkBegin,
-          &context);
+          context);
       break;
     case TensorProto_DataType_INT16:
       detail::CopyFromProtoWithCast(
           chunkSize,
           proto.int32_data(),
           tensor->template mutable_data<int16_t>() + chunkBegin,
-          &context);
+          context);
       break;
     case TensorProto_DataType_INT64:
       detail::CopyFromProtoAsIs(
           chunkSize,
           proto.int64_data(),
           tensor->template mutable_data<int64_t>() + chunkBegin,
-          &context);
+          context);
       break;
     case TensorProto_DataType_FLOAT16:
-      if (proto.has_byte_data()) {
-        const int kValue = 1;
-        CAFFE_ENFORCE_EQ(
-            reinterpret_cast<const char*>(&kValue)[0],
-            1,
-            "Serialization of FLOAT16 on big endian platform "
-            "is not written yet.");
-        CAFFE_ENFORCE_EQ(
-            2 * chunkSize,
-            proto.byte_data().size(),
-            "Incorrect proto field size.");
-        context.template Copy<float16, Context, CPUContext>(
-            chunkSize,
-            reinterpret_cast<const float16*>(proto.byte_data().data()),
-            tensor->template mutable_data<float16>() + chunkBegin);
-      } else {
-        // Backward compatibility with models which used int32_data field
-        detail::CopyFromProtoWithCast(
-            chunkSize,
-            proto.int32_data(),
-            reinterpret_cast<uint16_t*>(
-                tensor->template mutable_data<float16>()) +
-                chunkBegin,
-            &context);
-      }
+      // Serialized as bytes (handled above) unless
+      // --caffe2_serialize_fp16_as_bytes is off
+      detail::CopyFromProtoWithCast(
+          chunkSize,
+          proto.int32_data(),
+          reinterpret_cast<uint16_t*>(
+              tensor->template mutable_data<float16>()) +
+              chunkBegin,
+          context);
       break;
     case TensorProto_DataType_DOUBLE:
       detail::CopyFromProtoAsIs(
           chunkSize,
           proto.double_data(),
           tensor->template mutable_data<double>() + chunkBegin,
-          &context);
+          context);
       break;
     case TensorProto_DataType_UNDEFINED: {
       Blob temp_blob;
@@ -578,7 +783,6 @@ void TensorDeserializer<Context>::Deserialize(
       }
     }
   }
-  context.FinishDeviceComputation();
 }
 
 }  // namespace caffe2
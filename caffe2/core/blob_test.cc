@@ -478,6 +478,36 @@ TYPED_TEST(TensorCPUTest, MaxKeepOnShrink) {
   FLAGS_caffe2_max_keep_on_shrink_memory = LLONG_MAX;
 }
 
+TYPED_TEST(TensorCPUTest, GrowthPolicy) {
+  TensorGrowthPolicy policy;
+  policy.growth_pct = 100;
+  policy.max_retained_bytes = 16 * sizeof(TypeParam);
+  TensorCPU tensor(vector<int>{10});
+  tensor.SetGrowthPolicy(policy);
+  tensor.mutable_data<TypeParam>();
+  EXPECT_EQ(tensor.capacity_nbytes(), 10 * sizeof(TypeParam));
+  // Growing - reallocates with twice the capacity
+  tensor.Resize(11);
+  TypeParam* ptr = tensor.mutable_data<TypeParam>();
+  EXPECT_EQ(tensor.capacity_nbytes(), 20 * sizeof(TypeParam));
+  // Growing within the capacity - does not reallocate
+  tensor.Resize(20);
+  EXPECT_EQ(ptr, tensor.mutable_data<TypeParam>());
+  // Growing past it by more than the growth - reallocates what is needed
+  tensor.Resize(50);
+  tensor.mutable_data<TypeParam>();
+  EXPECT_EQ(tensor.capacity_nbytes(), 50 * sizeof(TypeParam));
+  // Shrinking within the retained bytes - does not reallocate
+  ptr = tensor.mutable_data<TypeParam>();
+  tensor.Resize(34);
+  EXPECT_EQ(ptr, tensor.mutable_data<TypeParam>());
+  EXPECT_EQ(tensor.capacity_nbytes(), 50 * sizeof(TypeParam));
+  // Shrinking by more - reallocates, regardless of caffe2_keep_on_shrink
+  tensor.Resize(33);
+  tensor.mutable_data<TypeParam>();
+  EXPECT_EQ(tensor.capacity_nbytes(), 33 * sizeof(TypeParam));
+}
+
 TYPED_TEST(TensorCPUDeathTest, CannotAccessRawDataWhenEmpty) {
   TensorCPU tensor;
   EXPECT_EQ(tensor.ndim(), 0);
@@ -981,6 +1011,59 @@ TEST(ContentChunks, Serialization) {
   }
 }
 
+TEST(ContentChunks, BytesSerializationWithParallelLoad) {
+  string db_source = (string)std::tmpnam(nullptr);
+  const int kSize = 1000;
+  const bool old_as_bytes = FLAGS_caffe2_serialize_tensors_as_bytes;
+  FLAGS_caffe2_serialize_tensors_as_bytes = true;
+  StringMap data;
+  {
+    Blob blob;
+    TensorCPU* tensor = blob.GetMutable<TensorCPU>();
+    tensor->Resize(kSize);
+    for (int i = 0; i < kSize; ++i) {
+      tensor->mutable_data<float>()[i] = i * 0.5;
+    }
+    std::mutex mutex;
+    auto acceptor = [&](const std::string& key, const std::string& value) {
+      BlobProto proto;
+      CHECK(proto.ParseFromString(value));
+      EXPECT_EQ(proto.tensor().float_data_size(), 0);
+      EXPECT_GT(proto.tensor().byte_data().size(), 0);
+      std::lock_guard<std::mutex> guard(mutex);
+      data.emplace_back(key, value);
+    };
+    blob.Serialize("test", acceptor, 64);
+    EXPECT_EQ(data.size(), (kSize + 63) / 64);
+  }
+  FLAGS_caffe2_serialize_tensors_as_bytes = old_as_bytes;
+
+  for (int num_threads : {1, 4}) {
+    // the db drops its data when it is closed
+    VectorDB::registerData(db_source, StringMap(data));
+    DeviceOption option;
+    option.set_device_type(CPU);
+    auto op_def = CreateOperatorDef(
+        "Load",
+        "",
+        std::vector<string>{},
+        std::vector<string>({"test"}),
+        std::vector<Argument>{MakeArgument<string>("db_type", "vector_db"),
+                              MakeArgument<string>("db", db_source),
+                              MakeArgument<bool>("absolute_path", true),
+                              MakeArgument<int>("num_threads", num_threads)},
+        option);
+    Workspace ws;
+    auto load_op = CreateOperator(op_def, &ws);
+    EXPECT_TRUE(load_op->Run());
+    const auto& tensor = ws.GetBlob("test")->Get<TensorCPU>();
+    EXPECT_EQ(tensor.size(), kSize);
+    for (int i = 0; i < kSize; ++i) {
+      EXPECT_EQ(tensor.data<float>()[i], i * 0.5);
+    }
+  }
+}
+
 TEST(CustomChunkSize, BigTensorSerialization) {
   int64_t d1 = 2;
   int64_t d2 = FLAGS_caffe2_test_big_tensor_size
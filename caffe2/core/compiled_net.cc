@@ -0,0 +1,57 @@
+#include "caffe2/core/compiled_net.h"
+
+#include "caffe2/core/net.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+namespace {
+thread_local const CompiledNetDef* t_compiled_net = nullptr;
+} // namespace
+
+CompiledNetDef::CompiledNetDef(const NetDef& net_def) {
+  auto def = std::make_shared<NetDef>(net_def);
+  // Copy the device option of the net once here, rather than into a
+  // temporary def for every operator when a net is created.
+  if (def->has_device_option()) {
+    for (auto& op : *def->mutable_op()) {
+      if (!op.has_device_option()) {
+        op.mutable_device_option()->CopyFrom(def->device_option());
+      }
+    }
+  }
+  def_ = def;
+  ops_.reserve(def_->op_size());
+  for (const auto& op : def_->op()) {
+    ops_.push_back(
+        PrepareOperatorDef(std::shared_ptr<const OperatorDef>(def_, &op)));
+  }
+}
+
+unique_ptr<NetBase> CompiledNetDef::CreateNet(Workspace* ws) const {
+  Scope scope(*this);
+  return caffe2::CreateNet(def_, ws);
+}
+
+const PreparedOperatorDef* CompiledNetDef::Prepared(
+    const OperatorDef& operator_def,
+    int net_position) {
+  const auto* compiled = t_compiled_net;
+  if (!compiled || net_position < 0 ||
+      net_position >= static_cast<int>(compiled->ops_.size())) {
+    return nullptr;
+  }
+  const auto& prepared = compiled->ops_[net_position];
+  return prepared.def.get() == &operator_def ? &prepared : nullptr;
+}
+
+CompiledNetDef::Scope::Scope(const CompiledNetDef& compiled)
+    : saved_(t_compiled_net) {
+  t_compiled_net = &compiled;
+}
+
+CompiledNetDef::Scope::~Scope() {
+  t_compiled_net = saved_;
+}
+
+} // namespace caffe2
@@ -0,0 +1,67 @@
+#ifndef CAFFE2_CORE_COMPILED_NET_H_
+#define CAFFE2_CORE_COMPILED_NET_H_
+
+#include <memory>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+class NetBase;
+class Workspace;
+
+/**
+ * A NetDef that has been checked and resolved once, so that nets can be
+ * instantiated from it many times, e.g. one per request or per worker
+ * workspace, without paying for the checks each time.
+ *
+ * Compiling a net copies the net's device option into the operators that do
+ * not have one, checks every operator against its schema, parses its
+ * arguments and looks up the creators registered for its engines. Nets
+ * created from it share the def and the parsed arguments with their
+ * operators instead of copying them.
+ *
+ * The engine preferences in effect at compile time are the ones used by the
+ * nets created later on.
+ */
+class CompiledNetDef {
+ public:
+  explicit CompiledNetDef(const NetDef& net_def);
+
+  const std::shared_ptr<const NetDef>& def() const {
+    return def_;
+  }
+
+  // Creates a net that is not owned by a workspace, like caffe2::CreateNet.
+  unique_ptr<NetBase> CreateNet(Workspace* ws) const;
+
+  // Returns the prepared def of the operator at net_position if operator_def
+  // is that operator of the net being created from a CompiledNetDef on this
+  // thread, and nullptr otherwise.
+  static const PreparedOperatorDef* Prepared(
+      const OperatorDef& operator_def,
+      int net_position);
+
+  // Makes the nets created on this thread while it is in scope use the
+  // prepared operators of a compiled def.
+  class Scope {
+   public:
+    explicit Scope(const CompiledNetDef& compiled);
+    ~Scope();
+
+   private:
+    const CompiledNetDef* saved_;
+    DISABLE_COPY_AND_ASSIGN(Scope);
+  };
+
+ private:
+  std::shared_ptr<const NetDef> def_;
+  std::vector<PreparedOperatorDef> ops_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_COMPILED_NET_H_
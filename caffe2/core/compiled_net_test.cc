@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include "caffe2/core/compiled_net.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+namespace {
+
+class CompiledNetTestOp : public OperatorBase {
+ public:
+  CompiledNetTestOp(const OperatorDef& operator_def, Workspace* ws)
+      : OperatorBase(operator_def, ws),
+        value_(GetSingleArgument<int>("value", 0)) {}
+
+  bool Run(int /* unused */ /*stream_id*/) override {
+    *OperatorBase::Output<int>(0) = value_;
+    return true;
+  }
+
+ private:
+  int value_;
+};
+
+class CompiledNetTestNeverConstructsOp : public CompiledNetTestOp {
+ public:
+  CompiledNetTestNeverConstructsOp(const OperatorDef& def, Workspace* ws)
+      : CompiledNetTestOp(def, ws) {
+    throw UnsupportedOperatorFeature("I just don't construct.");
+  }
+};
+
+OPERATOR_SCHEMA(CompiledNetTest).NumInputs(0, 1).NumOutputs(1);
+REGISTER_CPU_OPERATOR(CompiledNetTest, CompiledNetTestOp);
+REGISTER_CPU_OPERATOR_WITH_ENGINE(
+    CompiledNetTest,
+    NEVER,
+    CompiledNetTestNeverConstructsOp);
+REGISTER_CPU_OPERATOR_WITH_ENGINE(CompiledNetTest, WORKS, CompiledNetTestOp);
+
+NetDef CompiledNetTestDef() {
+  NetDef net_def;
+  net_def.set_name("compiled");
+  net_def.mutable_device_option()->set_device_type(CPU);
+  for (int i = 0; i < 3; ++i) {
+    auto* op = net_def.add_op();
+    op->set_type("CompiledNetTest");
+    op->add_output("out" + caffe2::to_string(i));
+    auto* arg = op->add_arg();
+    arg->set_name("value");
+    arg->set_i(i + 1);
+  }
+  return net_def;
+}
+
+} // namespace
+
+TEST(CompiledNetTest, CreatesNets) {
+  CompiledNetDef compiled(CompiledNetTestDef());
+  for (const auto& op : compiled.def()->op()) {
+    EXPECT_TRUE(op.has_device_option());
+  }
+  for (const string& type : {"simple", "dag", "async_scheduling"}) {
+    Workspace ws;
+    NetDef net_def = CompiledNetTestDef();
+    net_def.set_type(type);
+    CompiledNetDef typed(net_def);
+    NetBase* net = ws.CreateNet(typed);
+    ASSERT_TRUE(net != nullptr);
+    ASSERT_TRUE(net->Run());
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(
+          ws.GetBlob("out" + caffe2::to_string(i))->Get<int>(), i + 1);
+    }
+  }
+}
+
+TEST(CompiledNetTest, SharesDefs) {
+  CompiledNetDef compiled(CompiledNetTestDef());
+  Workspace ws;
+  auto first = compiled.CreateNet(&ws);
+  auto second = compiled.CreateNet(&ws);
+  ASSERT_TRUE(first != nullptr);
+  ASSERT_TRUE(second != nullptr);
+  auto first_ops = first->GetOperators();
+  auto second_ops = second->GetOperators();
+  ASSERT_EQ(first_ops.size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(&first_ops[i]->debug_def(), &compiled.def()->op(i));
+    EXPECT_EQ(&second_ops[i]->debug_def(), &compiled.def()->op(i));
+    EXPECT_EQ(first_ops[i]->GetSingleArgument<int>("value", 0), i + 1);
+  }
+}
+
+TEST(CompiledNetTest, TriesEngines) {
+  NetDef net_def = CompiledNetTestDef();
+  net_def.mutable_op(0)->set_engine("NEVER,WORKS");
+  net_def.mutable_op(1)->set_engine("NEVER");
+  CompiledNetDef compiled(net_def);
+  Workspace ws;
+  auto net = compiled.CreateNet(&ws);
+  ASSERT_TRUE(net != nullptr);
+  auto ops = net->GetOperators();
+  EXPECT_EQ(ops[0]->engine(), "WORKS");
+  EXPECT_EQ(ops[1]->engine(), "");
+  EXPECT_TRUE(net->Run());
+}
+
+TEST(CompiledNetTest, ChecksOperators) {
+  NetDef net_def = CompiledNetTestDef();
+  net_def.mutable_op(1)->add_output("too_many_outputs");
+  ASSERT_THROW(CompiledNetDef{net_def}, EnforceNotMet);
+  net_def = CompiledNetTestDef();
+  net_def.mutable_op(2)->set_type("CompiledNetTestNotRegistered");
+  ASSERT_THROW(CompiledNetDef{net_def}, EnforceNotMet);
+}
+
+} // namespace caffe2
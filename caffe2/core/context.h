@@ -105,6 +105,12 @@ class CPUContext final {
       reporter_.New(data_and_deleter.first, nbytes);
       data_and_deleter.second = ReportAndDelete;
     }
+    if (HasMemoryAllocationListener()) {
+      NotifyMemoryAllocation(CPU, data_and_deleter.first, nbytes);
+      data_and_deleter.second = FLAGS_caffe2_report_cpu_memory_usage
+          ? NotifyReportAndDelete
+          : NotifyAndDelete;
+    }
     return data_and_deleter;
   }
 
@@ -162,6 +168,14 @@ class CPUContext final {
     reporter_.Delete(ptr);
     GetCPUAllocator()->GetDeleter()(ptr);
   }
+  static void NotifyAndDelete(void* ptr) {
+    NotifyMemoryDeallocation(CPU, ptr);
+    GetCPUAllocator()->GetDeleter()(ptr);
+  }
+  static void NotifyReportAndDelete(void* ptr) {
+    NotifyMemoryDeallocation(CPU, ptr);
+    ReportAndDelete(ptr);
+  }
 };
 
 template<>
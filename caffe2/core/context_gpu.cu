@@ -11,6 +11,7 @@
 #include "caffe2/core/context_gpu.h"
 #include "caffe2/core/init.h"
 #include "caffe2/core/logging.h"
+#include "caffe2/core/static_tracepoint.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/utils/string_utils.h"
 
@@ -85,6 +86,8 @@ static std::vector<long> g_max_by_gpu_map(CAFFE2_COMPILE_TIME_MAX_GPUS, 0);
 static long g_total_mem = 0;
 static long g_last_rep = 0;
 
+static thread_local int64_t g_num_allocator_calls = 0;
+
 CudaMemoryPoolType GetCudaMemoryPoolType() {
   return g_cuda_memory_pool_type;
 }
@@ -258,11 +261,61 @@ CUDAContext::CUDAContext(const DeviceOption& option)
                                    : CaffeCudaGetDevice()),
       random_seed_(
           option.has_random_seed() ? option.random_seed()
-                                   : RandomNumberSeed()) {
+                                   : RandomNumberSeed()),
+      high_priority_(option.cuda_high_priority()) {
   static Caffe2CudaInitializerHelper g_cuda_initializer_;
   DCHECK_EQ(option.device_type(), CUDA);
 }
 
+namespace {
+
+struct CUDAStreamPool {
+  std::mutex mutex;
+  // indexed by priority (0 low, 1 high), then gpu
+  vector<cudaStream_t> free_streams[2][CAFFE2_COMPILE_TIME_MAX_GPUS];
+};
+
+CUDAStreamPool& GetCUDAStreamPool() {
+  // never destroyed, since threads release their streams when they exit,
+  // which may be after static destructors ran
+  static CUDAStreamPool* pool = new CUDAStreamPool();
+  return *pool;
+}
+
+} // namespace
+
+cudaStream_t AcquireCUDAStream(int gpu, bool high_priority) {
+  CAFFE_ENFORCE(gpu >= 0 && gpu < CAFFE2_COMPILE_TIME_MAX_GPUS);
+  auto& pool = GetCUDAStreamPool();
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    auto& free_streams = pool.free_streams[high_priority][gpu];
+    if (!free_streams.empty()) {
+      cudaStream_t stream = free_streams.back();
+      free_streams.pop_back();
+      return stream;
+    }
+  }
+  DeviceGuard guard(gpu);
+  // greater numbers are lower priorities, and 0 is the default
+  int least_priority = 0;
+  int greatest_priority = 0;
+  CUDA_ENFORCE(
+      cudaDeviceGetStreamPriorityRange(&least_priority, &greatest_priority));
+  cudaStream_t stream;
+  CUDA_ENFORCE(cudaStreamCreateWithPriority(
+      &stream,
+      cudaStreamNonBlocking,
+      high_priority ? greatest_priority : least_priority));
+  return stream;
+}
+
+void ReleaseCUDAStream(int gpu, bool high_priority, cudaStream_t stream) {
+  auto& pool = GetCUDAStreamPool();
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  pool.free_streams[high_priority][gpu].push_back(stream);
+}
+
 // shared mutex to lock out alloc / free during NCCL launches
 std::mutex& CUDAContext::mutex() {
   static std::mutex m;
@@ -285,6 +338,10 @@ std::vector<long> CUDAContext::MaxMemoryByGpu() {
   return g_max_by_gpu_map;
 }
 
+int64_t CUDAContext::NumAllocatorCalls() {
+  return g_num_allocator_calls;
+}
+
 namespace {
 void TrackMemoryAlloc(size_t nbytes) {
   int this_gpu = CaffeCudaGetDevice();
@@ -318,6 +375,7 @@ std::pair<void*, MemoryDeleter> CUDAContext::New(size_t nbytes) {
   // A one-time caffe2 cuda initializer.
   static Caffe2CudaInitializerHelper g_cuda_initializer_;
   void* ptr = nullptr;
+  ++g_num_allocator_calls;
 
   if (FLAGS_caffe2_gpu_memory_tracking) {
     TrackMemoryAlloc(nbytes);
@@ -329,6 +387,12 @@ std::pair<void*, MemoryDeleter> CUDAContext::New(size_t nbytes) {
       g_size_map[ptr] = nbytes;
       g_cuda_device_affiliation[ptr] = CaffeCudaGetDevice();
     }
+#ifdef CAFFE2_ENABLE_SDT
+    CAFFE_SDT(cuda_alloc, ptr, nbytes, CaffeCudaGetDevice());
+#endif
+    if (HasMemoryAllocationListener()) {
+      NotifyMemoryAllocation(CUDA, ptr, nbytes);
+    }
     return {ptr, Delete};
   case CudaMemoryPoolType::CUB:
     CUDA_ENFORCE(g_cub_allocator->DeviceAllocate(&ptr, nbytes));
@@ -338,6 +402,12 @@ std::pair<void*, MemoryDeleter> CUDAContext::New(size_t nbytes) {
     if (FLAGS_caffe2_gpu_memory_tracking) {
       g_size_map[ptr] = nbytes;
     }
+#ifdef CAFFE2_ENABLE_SDT
+    CAFFE_SDT(cuda_alloc, ptr, nbytes, CaffeCudaGetDevice());
+#endif
+    if (HasMemoryAllocationListener()) {
+      NotifyMemoryAllocation(CUDA, ptr, nbytes);
+    }
     return {ptr, Delete};
   }
   return {nullptr, Delete};
@@ -346,6 +416,13 @@ std::pair<void*, MemoryDeleter> CUDAContext::New(size_t nbytes) {
 void CUDAContext::Delete(void* ptr) {
   // lock the mutex
   std::lock_guard<std::mutex> lock(CUDAContext::mutex());
+  ++g_num_allocator_calls;
+#ifdef CAFFE2_ENABLE_SDT
+  CAFFE_SDT(cuda_free, ptr);
+#endif
+  if (HasMemoryAllocationListener()) {
+    NotifyMemoryDeallocation(CUDA, ptr);
+  }
 
   if (FLAGS_caffe2_gpu_memory_tracking) {
     auto sz_it = g_size_map.find(ptr);
@@ -27,13 +27,29 @@ enum class CudaMemoryPoolType {
  */
 CudaMemoryPoolType GetCudaMemoryPoolType();
 
+/**
+ * Gets a non-blocking stream on the given gpu, created with the greatest
+ * priority of the device if high_priority is set, and with the default (and
+ * lowest) priority otherwise. Work queued on high priority streams, e.g.
+ * latency critical inference, is scheduled ahead of pending work of low
+ * priority streams, e.g. background copies, on the same gpu.
+ *
+ * Streams given back by ReleaseCUDAStream are handed out again instead of
+ * creating new ones, so that threads which come and go don't create and
+ * destroy streams every time.
+ */
+cudaStream_t AcquireCUDAStream(int gpu, bool high_priority);
+void ReleaseCUDAStream(int gpu, bool high_priority, cudaStream_t stream);
+
 /**
  * A struct to host thread-local cuda objects.
  *
  * In Caffe2, each thread has its own non-default cuda stream as well as
  * related objects such as cublas and curand handles. This is achieved by
  * having the ThreadLocalCUDAObjects wrapper that takes care of allocating
- * and deallocating these objects at the thread scope. This class is solely
+ * and deallocating these objects at the thread scope. Each thread has two
+ * sets of streams per gpu, of low and of high priority, which it takes from
+ * and gives back to the pool of AcquireCUDAStream. This class is solely
  * used inside CUDAContext and should not be used externally.
  */
 class ThreadLocalCUDAObjects {
@@ -41,29 +57,30 @@ class ThreadLocalCUDAObjects {
 
  private:
   ThreadLocalCUDAObjects() {
-    for (int i = 0; i < CAFFE2_COMPILE_TIME_MAX_GPUS; ++i) {
-      cuda_streams_[i] = vector<cudaStream_t>();
-      cublas_handles_[i] = vector<cublasHandle_t>();
-      cudnn_handles_[i] = vector<cudnnHandle_t>();
+    for (int p = 0; p < 2; ++p) {
+      for (int i = 0; i < CAFFE2_COMPILE_TIME_MAX_GPUS; ++i) {
+        cuda_streams_[p][i] = vector<cudaStream_t>();
+        cublas_handles_[p][i] = vector<cublasHandle_t>();
+        cudnn_handles_[p][i] = vector<cudnnHandle_t>();
+      }
     }
   }
 
-  cudaStream_t GetStream(int gpu, int stream_id) {
-    vector<cudaStream_t>& gpu_streams = cuda_streams_[gpu];
+  cudaStream_t GetStream(int gpu, int stream_id, bool high_priority = false) {
+    vector<cudaStream_t>& gpu_streams = cuda_streams_[high_priority][gpu];
     if (gpu_streams.size() <= stream_id) {
       gpu_streams.resize(stream_id + 1, nullptr);
     }
     if (!gpu_streams[stream_id]) {
-      DeviceGuard guard(gpu);
-      CUDA_ENFORCE(cudaStreamCreateWithFlags(
-          &gpu_streams[stream_id], cudaStreamNonBlocking));
+      gpu_streams[stream_id] = AcquireCUDAStream(gpu, high_priority);
     }
     return gpu_streams[stream_id];
   }
 
-  cublasHandle_t GetHandle(int gpu, int stream_id) {
+  cublasHandle_t
+  GetHandle(int gpu, int stream_id, bool high_priority = false) {
     DeviceGuard guard(gpu);
-    vector<cublasHandle_t>& gpu_handles = cublas_handles_[gpu];
+    vector<cublasHandle_t>& gpu_handles = cublas_handles_[high_priority][gpu];
     if (gpu_handles.size() <= stream_id) {
       gpu_handles.resize(stream_id + 1, nullptr);
     }
@@ -74,48 +91,52 @@ class ThreadLocalCUDAObjects {
       // caution.
       CUBLAS_ENFORCE(cublasSetPointerMode(
           gpu_handles[stream_id], CUBLAS_POINTER_MODE_HOST));
-      CUBLAS_ENFORCE(
-          cublasSetStream(gpu_handles[stream_id], GetStream(gpu, stream_id)));
+      CUBLAS_ENFORCE(cublasSetStream(
+          gpu_handles[stream_id], GetStream(gpu, stream_id, high_priority)));
     }
     return gpu_handles[stream_id];
   }
 
-  cudnnHandle_t GetCudnnHandle(int gpu, int stream_id) {
+  cudnnHandle_t
+  GetCudnnHandle(int gpu, int stream_id, bool high_priority = false) {
     DeviceGuard guard(gpu);
-    vector<cudnnHandle_t>& gpu_handles = cudnn_handles_[gpu];
+    vector<cudnnHandle_t>& gpu_handles = cudnn_handles_[high_priority][gpu];
     if (gpu_handles.size() <= stream_id) {
       gpu_handles.resize(stream_id + 1, nullptr);
     }
     if (!gpu_handles[stream_id]) {
       CUDNN_ENFORCE(cudnnCreate(&gpu_handles[stream_id]));
-      CUDNN_ENFORCE(
-          cudnnSetStream(gpu_handles[stream_id], GetStream(gpu, stream_id)));
+      CUDNN_ENFORCE(cudnnSetStream(
+          gpu_handles[stream_id], GetStream(gpu, stream_id, high_priority)));
     }
     return gpu_handles[stream_id];
   }
 
   ~ThreadLocalCUDAObjects() noexcept {
-    for (int i = 0; i < CAFFE2_COMPILE_TIME_MAX_GPUS; ++i) {
-      for (auto& handle : cublas_handles_[i]) {
-        if (handle) {
-          CUBLAS_CHECK(cublasDestroy(handle));
+    for (int p = 0; p < 2; ++p) {
+      for (int i = 0; i < CAFFE2_COMPILE_TIME_MAX_GPUS; ++i) {
+        for (auto& handle : cublas_handles_[p][i]) {
+          if (handle) {
+            CUBLAS_CHECK(cublasDestroy(handle));
+          }
         }
-      }
-      for (auto& stream : cuda_streams_[i]) {
-        if (stream) {
-          CUDA_CHECK(cudaStreamDestroy(stream));
+        for (auto& stream : cuda_streams_[p][i]) {
+          if (stream) {
+            ReleaseCUDAStream(i, p, stream);
+          }
         }
-      }
-      for (auto& handle : cudnn_handles_[i]) {
-        if (handle) {
-          CUDNN_CHECK(cudnnDestroy(handle));
+        for (auto& handle : cudnn_handles_[p][i]) {
+          if (handle) {
+            CUDNN_CHECK(cudnnDestroy(handle));
+          }
         }
       }
     }
   }
-  vector<cudaStream_t> cuda_streams_[CAFFE2_COMPILE_TIME_MAX_GPUS];
-  vector<cublasHandle_t> cublas_handles_[CAFFE2_COMPILE_TIME_MAX_GPUS];
-  vector<cudnnHandle_t> cudnn_handles_[CAFFE2_COMPILE_TIME_MAX_GPUS];
+  // indexed by priority (0 low, 1 high), then gpu
+  vector<cudaStream_t> cuda_streams_[2][CAFFE2_COMPILE_TIME_MAX_GPUS];
+  vector<cublasHandle_t> cublas_handles_[2][CAFFE2_COMPILE_TIME_MAX_GPUS];
+  vector<cudnnHandle_t> cudnn_handles_[2][CAFFE2_COMPILE_TIME_MAX_GPUS];
 };
 
 class CUDAContext final {
@@ -149,7 +170,7 @@ class CUDAContext final {
   }
 
   void FinishDeviceComputation() {
-    cudaStreamSynchronize(cuda_objects_.GetStream(gpu_id_, stream_id_));
+    cudaStreamSynchronize(cuda_stream());
     cudaError_t error = cudaGetLastError();
     if (error != cudaSuccess) {
       CAFFE_THROW("Encountered CUDA error: ", cudaGetErrorString(error));
@@ -160,24 +181,31 @@ class CUDAContext final {
     return gpu_id_;
   }
 
+  // Whether the context runs on the high priority streams of its gpu, as
+  // set by DeviceOption.cuda_high_priority.
+  inline bool high_priority() const {
+    return high_priority_;
+  }
+
   inline cudaStream_t cuda_stream() {
-    return cuda_stream(gpu_id_, stream_id_);
+    return cuda_stream(gpu_id_, stream_id_, high_priority_);
   }
 
   inline cudaStream_t cuda_stream() const {
-    return cuda_stream(gpu_id_, stream_id_);
+    return cuda_stream(gpu_id_, stream_id_, high_priority_);
   }
 
-  static cudaStream_t cuda_stream(int gpu_id, int stream_id) {
-    return cuda_objects_.GetStream(gpu_id, stream_id);
+  static cudaStream_t
+  cuda_stream(int gpu_id, int stream_id, bool high_priority = false) {
+    return cuda_objects_.GetStream(gpu_id, stream_id, high_priority);
   }
 
   cublasHandle_t cublas_handle() {
-    return cuda_objects_.GetHandle(gpu_id_, stream_id_);
+    return cuda_objects_.GetHandle(gpu_id_, stream_id_, high_priority_);
   }
 
   cudnnHandle_t cudnn_handle() {
-    return cuda_objects_.GetCudnnHandle(gpu_id_, stream_id_);
+    return cuda_objects_.GetCudnnHandle(gpu_id_, stream_id_, high_priority_);
   }
 
   curandGenerator_t& curand_generator() {
@@ -205,6 +233,10 @@ class CUDAContext final {
   static std::vector<long> TotalMemoryByGpu();
   static std::vector<long> MaxMemoryByGpu();
 
+  // Number of calls to New and Delete made so far by the calling thread,
+  // e.g. to check that a piece of code doesn't allocate GPU memory.
+  static int64_t NumAllocatorCalls();
+
   template <class SrcContext, class DstContext>
   inline void CopyBytes(size_t nbytes, const void* src, void* dst) {
     CUDA_ENFORCE(cudaMemcpyAsync(
@@ -212,7 +244,7 @@ class CUDAContext final {
         src,
         nbytes,
         cudaMemcpyDefault,
-        cuda_objects_.GetStream(gpu_id_, stream_id_)));
+        cuda_stream()));
   }
 
   template <typename T, class SrcContext, class DstContext>
@@ -239,7 +271,8 @@ class CUDAContext final {
   }
 
   static bool IsStreamFree(const DeviceOption& option, int stream_id) {
-    auto stream = CUDAContext::cuda_stream(option.cuda_gpu_id(), stream_id);
+    auto stream = CUDAContext::cuda_stream(
+        option.cuda_gpu_id(), stream_id, option.cuda_high_priority());
     return cudaStreamQuery(stream) == cudaSuccess;
   }
 
@@ -251,6 +284,7 @@ class CUDAContext final {
 
   int gpu_id_;
   int stream_id_ = 0;
+  bool high_priority_ = false;
   int random_seed_;
   curandGenerator_t curand_generator_{nullptr};
   static thread_local ThreadLocalCUDAObjects cuda_objects_;
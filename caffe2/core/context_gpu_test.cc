@@ -118,8 +118,8 @@ TEST(CUDAContextTest, TestSameThreadDifferntObjectIfDifferentDevices) {
 
 namespace {
 // A test function to return a stream address from a temp CUDA context. You
-// should not use that stream though, because the actual stream is destroyed
-// after thread exit.
+// should not use that stream though, because the actual stream is handed to
+// another thread after thread exit.
 void TEST_GetStreamAddress(cudaStream_t* ptr) {
   CUDAContext context(0);
   *ptr = context.cuda_stream();
@@ -147,4 +147,40 @@ TEST(CUDAContextTest, TestDifferntThreadDifferentobject) {
   EXPECT_NE(temp[0], temp[1]);
 }
 
+TEST(CUDAContextTest, TestHighPriorityStreams) {
+  if (!HasCudaGPU()) return;
+  DeviceOption option;
+  option.set_device_type(CUDA);
+  CUDAContext low_context(option);
+  option.set_cuda_high_priority(true);
+  CUDAContext high_context(option);
+  EXPECT_FALSE(low_context.high_priority());
+  EXPECT_TRUE(high_context.high_priority());
+  EXPECT_NE(low_context.cuda_stream(), high_context.cuda_stream());
+  EXPECT_EQ(
+      high_context.cuda_stream(),
+      getStreamForHandle(high_context.cublas_handle()));
+
+  int least_priority, greatest_priority, priority;
+  CUDA_ENFORCE(
+      cudaDeviceGetStreamPriorityRange(&least_priority, &greatest_priority));
+  CUDA_ENFORCE(cudaStreamGetPriority(high_context.cuda_stream(), &priority));
+  EXPECT_EQ(priority, greatest_priority);
+  CUDA_ENFORCE(cudaStreamGetPriority(low_context.cuda_stream(), &priority));
+  EXPECT_EQ(priority, least_priority);
+}
+
+TEST(CUDAContextTest, TestStreamsAreReused) {
+  if (!HasCudaGPU()) return;
+  // A thread that exits gives its stream back to the pool, for the next
+  // thread to use.
+  std::array<cudaStream_t, 2> temp = {0};
+  std::thread thread_a(TEST_GetStreamAddress, &temp[0]);
+  thread_a.join();
+  std::thread thread_b(TEST_GetStreamAddress, &temp[1]);
+  thread_b.join();
+  EXPECT_TRUE(temp[0] != nullptr);
+  EXPECT_EQ(temp[0], temp[1]);
+}
+
 }  // namespace caffe2
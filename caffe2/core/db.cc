@@ -169,6 +169,140 @@ class MiniDB : public DB {
 REGISTER_CAFFE2_DB(MiniDB, MiniDB);
 REGISTER_CAFFE2_DB(minidb, MiniDB);
 
+void DBReader::EnableShardedRead(int num_consumers, int read_ahead) {
+  CAFFE_ENFORCE(db_, "Reader not initialized.");
+  CAFFE_ENFORCE_GE(num_consumers, 1);
+  CAFFE_ENFORCE_GE(read_ahead, 0);
+  StopShards();
+  // the cursors of the sub-shards replace the one of the reader
+  cursor_.reset();
+  read_ahead_ = read_ahead;
+  for (int i = 0; i < num_consumers; ++i) {
+    unique_ptr<ReadShard> shard(new ReadShard());
+    shard->cursor = db_->NewCursor();
+    shard->offset = shard_id_ + static_cast<int64_t>(i) * num_shards_;
+    shard->stride = static_cast<int64_t>(num_shards_) * num_consumers;
+    MoveShardToBeginning(shard.get());
+    shards_.push_back(std::move(shard));
+  }
+  if (read_ahead_ > 0) {
+    for (auto& shard : shards_) {
+      shard->prefetcher =
+          std::thread(&DBReader::PrefetchShard, this, shard.get());
+    }
+  }
+}
+
+void DBReader::Read(string* key, string* value, int shard_index) const {
+  if (shard_index < 0 || shards_.empty()) {
+    Read(key, value);
+    return;
+  }
+  CAFFE_ENFORCE_LT(shard_index, shards_.size());
+  auto* shard = shards_[shard_index].get();
+  std::unique_lock<std::mutex> lock(shard->mutex);
+  if (read_ahead_ == 0) {
+    ReadFromShardCursor(shard, key, value);
+    return;
+  }
+  shard->cv.wait(
+      lock, [shard] { return !shard->buffer.empty() || shard->error; });
+  if (shard->buffer.empty()) {
+    std::rethrow_exception(shard->error);
+  }
+  *key = std::move(shard->buffer.front().first);
+  *value = std::move(shard->buffer.front().second);
+  shard->buffer.pop_front();
+  shard->cv.notify_all();
+}
+
+void DBReader::MoveShardToBeginning(ReadShard* shard) {
+  shard->cursor->SeekToFirst();
+  for (int64_t s = 0; s < shard->offset; s++) {
+    shard->cursor->Next();
+    CAFFE_ENFORCE(
+        shard->cursor->Valid(),
+        "Db has less rows than read shard offset: ",
+        s,
+        shard->offset);
+  }
+}
+
+void DBReader::ReadFromShardCursor(
+    ReadShard* shard,
+    string* key,
+    string* value) {
+  *key = shard->cursor->key();
+  *value = shard->cursor->value();
+  for (int64_t s = 0; s < shard->stride; s++) {
+    shard->cursor->Next();
+    if (!shard->cursor->Valid()) {
+      MoveShardToBeginning(shard);
+      break;
+    }
+  }
+}
+
+void DBReader::PrefetchShard(ReadShard* shard) {
+  try {
+    while (true) {
+      string key, value;
+      // Only this thread touches the cursor, so the db is read without
+      // holding the lock.
+      ReadFromShardCursor(shard, &key, &value);
+      std::unique_lock<std::mutex> lock(shard->mutex);
+      shard->cv.wait(lock, [this, shard] {
+        return shard->stop || shard->rewind ||
+            shard->buffer.size() < static_cast<size_t>(read_ahead_);
+      });
+      if (shard->stop) {
+        return;
+      }
+      if (shard->rewind) {
+        shard->rewind = false;
+        MoveShardToBeginning(shard);
+        continue;
+      }
+      shard->buffer.emplace_back(std::move(key), std::move(value));
+      shard->cv.notify_all();
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->error = std::current_exception();
+    shard->cv.notify_all();
+  }
+}
+
+void DBReader::SeekShardsToFirst() const {
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    if (read_ahead_ == 0) {
+      MoveShardToBeginning(shard.get());
+    } else {
+      // the prefetcher seeks the cursor the next time it takes the lock
+      shard->buffer.clear();
+      shard->rewind = true;
+      shard->cv.notify_all();
+    }
+  }
+}
+
+void DBReader::StopShards() {
+  for (auto& shard : shards_) {
+    {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->stop = true;
+    }
+    shard->cv.notify_all();
+  }
+  for (auto& shard : shards_) {
+    if (shard->prefetcher.joinable()) {
+      shard->prefetcher.join();
+    }
+  }
+  shards_.clear();
+}
+
 void DBReaderSerializer::Serialize(
     const Blob& blob,
     const string& name,
@@ -1,7 +1,12 @@
 #ifndef CAFFE2_CORE_DB_H_
 #define CAFFE2_CORE_DB_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <mutex>
+#include <thread>
 
 #include "caffe2/core/blob_serialization.h"
 #include "caffe2/core/registry.h"
@@ -46,6 +51,23 @@ class Cursor {
    * Returns the current value.
    */
   virtual string value() = 0;
+  /**
+   * Returns whether the current value can be read in place through
+   * value_data() and value_size(), without the copy value() makes. In default
+   * this returns false; dbs that keep their content in memory, e.g. mmapdb,
+   * support it so that values can be parsed directly from that memory.
+   */
+  virtual bool SupportsValueView() { return false; }
+  /**
+   * Returns the current value in place. The memory stays valid as long as the
+   * db is open.
+   */
+  virtual const char* value_data() {
+    CAFFE_THROW("This db does not support reading values in place.");
+  }
+  virtual size_t value_size() {
+    CAFFE_THROW("This db does not support reading values in place.");
+  }
   /**
    * Returns whether the current location is valid - for example, if we have
    * reached the end of the database, return false.
@@ -175,6 +197,10 @@ class DBReader {
     cursor_ = db_->NewCursor();
   }
 
+  ~DBReader() {
+    StopShards();
+  }
+
   void Open(
       const string& db_type,
       const string& source,
@@ -182,6 +208,7 @@ class DBReader {
       const int32_t shard_id = 0) {
     // Note(jiayq): resetting is needed when we re-open e.g. leveldb where no
     // concurrent access is allowed.
+    StopShards();
     cursor_.reset();
     db_.reset();
     db_type_ = db_type;
@@ -195,6 +222,7 @@ class DBReader {
       unique_ptr<DB>&& db,
       const int32_t num_shards = 1,
       const int32_t shard_id = 0) {
+    StopShards();
     cursor_.reset();
     db_.reset();
     db_ = std::move(db);
@@ -220,6 +248,10 @@ class DBReader {
    * output blob.
    */
   void Read(string* key, string* value) const {
+    if (!shards_.empty()) {
+      Read(key, value, next_read_shard_++ % shards_.size());
+      return;
+    }
     CAFFE_ENFORCE(cursor_ != nullptr, "Reader not initialized.");
     std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
     *key = cursor_->key();
@@ -235,10 +267,57 @@ class DBReader {
     }
   }
 
+  /**
+   * Splits the records of this reader into num_consumers disjoint sub-shards,
+   * each read through its own cursor, so that consumers reading in parallel
+   * do not serialize on a single cursor. Sub-shard i gets every
+   * num_consumers-th record of this reader's shard, starting with the i-th.
+   *
+   * If read_ahead is positive, a background thread per sub-shard keeps up to
+   * read_ahead records buffered, so that reading the db overlaps with the
+   * work of the consumers.
+   *
+   * Consumers claim a sub-shard with AcquireShard() and pass it to Read();
+   * the plain Read() goes round robin over the sub-shards. Calling Open()
+   * again leaves the sharded mode.
+   *
+   * The db has to support several cursors at once, which e.g. leveldb and
+   * lmdb do but minidb does not.
+   */
+  void EnableShardedRead(int num_consumers, int read_ahead = 0);
+
+  /**
+   * Returns the sub-shard the calling consumer should read from, or -1 if the
+   * reader is not in sharded mode. Sub-shards are handed out round robin, so
+   * that with more consumers than sub-shards some of them share one.
+   */
+  int AcquireShard() const {
+    if (shards_.empty()) {
+      return -1;
+    }
+    return next_consumer_++ % shards_.size();
+  }
+
+  int num_read_shards() const {
+    return shards_.size();
+  }
+
+  /**
+   * Reads the next record of the given sub-shard, as returned by
+   * AcquireShard(). Falls back to the plain Read() if shard is negative or
+   * the reader is not in sharded mode. Thread safe; reads of different
+   * sub-shards do not contend.
+   */
+  void Read(string* key, string* value, int shard) const;
+
   /**
    * @brief Seeks to the first key. Thread safe.
    */
   void SeekToFirst() const {
+    if (!shards_.empty()) {
+      SeekShardsToFirst();
+      return;
+    }
     CAFFE_ENFORCE(cursor_ != nullptr, "Reader not initialized.");
     std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
     MoveToBeginning();
@@ -277,13 +356,37 @@ class DBReader {
     }
   }
 
+  struct ReadShard {
+    unique_ptr<Cursor> cursor;
+    // index of the first record and distance between records of the shard
+    int64_t offset;
+    int64_t stride;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::pair<string, string>> buffer;
+    std::exception_ptr error;
+    bool rewind = false;
+    bool stop = false;
+    std::thread prefetcher;
+  };
+
+  static void MoveShardToBeginning(ReadShard* shard);
+  static void ReadFromShardCursor(ReadShard* shard, string* key, string* value);
+  void PrefetchShard(ReadShard* shard);
+  void SeekShardsToFirst() const;
+  void StopShards();
+
   string db_type_;
   string source_;
   unique_ptr<DB> db_;
   unique_ptr<Cursor> cursor_;
   mutable std::mutex reader_mutex_;
-  uint32_t num_shards_;
-  uint32_t shard_id_;
+  uint32_t num_shards_ = 1;
+  uint32_t shard_id_ = 0;
+  std::vector<unique_ptr<ReadShard>> shards_;
+  int read_ahead_ = 0;
+  mutable std::atomic<uint64_t> next_read_shard_{0};
+  mutable std::atomic<uint64_t> next_consumer_{0};
 
   DISABLE_COPY_AND_ASSIGN(DBReader);
 };
@@ -1,24 +1,85 @@
 #include "caffe2/core/context_gpu.h"
 #include "caffe2/core/event_cpu.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/static_tracepoint.h"
+#include "caffe2/core/stats.h"
 
 #include <atomic>
 
 namespace caffe2 {
 
+namespace {
+
+struct CudaEventStats {
+  CAFFE_STAT_CTOR(CudaEventStats);
+  CAFFE_EXPORTED_STAT(events_created);
+  CAFFE_EXPORTED_STAT(events_reused);
+  CAFFE_EXPORTED_STAT(stream_waits);
+  CAFFE_EXPORTED_STAT(stream_waits_skipped);
+  CAFFE_EXPORTED_STAT(host_syncs);
+  CAFFE_EXPORTED_STAT(host_syncs_skipped);
+};
+
+CudaEventStats& cudaEventStats() {
+  static CudaEventStats stats("cuda_event/stats");
+  return stats;
+}
+
+// Async nets create an event per op and recreate all of them whenever a model
+// is reloaded, and cudaEventCreate/cudaEventDestroy are expensive. Released
+// events are kept in per-device free lists and handed out again. Events are
+// never destroyed: the pool is leaked on purpose, so that events released
+// during static destruction don't touch an already destroyed pool.
+class CudaEventPool {
+ public:
+  cudaEvent_t Acquire(int gpu_id) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto& events = free_events_[gpu_id];
+      if (!events.empty()) {
+        auto event = events.back();
+        events.pop_back();
+        CAFFE_EVENT(cudaEventStats(), events_reused);
+        return event;
+      }
+    }
+    cudaEvent_t event;
+    DeviceGuard g(gpu_id);
+    CUDA_ENFORCE(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+    CAFFE_EVENT(cudaEventStats(), events_created);
+    return event;
+  }
+
+  void Release(int gpu_id, cudaEvent_t event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_events_[gpu_id].push_back(event);
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<cudaEvent_t> free_events_[CAFFE2_COMPILE_TIME_MAX_GPUS];
+};
+
+CudaEventPool& cudaEventPool() {
+  static CudaEventPool* pool = new CudaEventPool();
+  return *pool;
+}
+
+} // namespace
+
 struct CudaEventWrapper {
   explicit CudaEventWrapper(const DeviceOption& option)
       : cuda_stream_(nullptr),
         cuda_gpu_id_(option.cuda_gpu_id()),
         status_(EventStatus::EVENT_INITIALIZED) {
     CAFFE_ENFORCE(option.device_type(), CUDA);
-    DeviceGuard g(cuda_gpu_id_);
-    CUDA_ENFORCE(cudaEventCreate(
-        &cuda_event_, cudaEventDefault | cudaEventDisableTiming));
+    CAFFE_ENFORCE_LT(cuda_gpu_id_, CAFFE2_COMPILE_TIME_MAX_GPUS);
+    cuda_event_ = cudaEventPool().Acquire(cuda_gpu_id_);
   }
   ~CudaEventWrapper() {
-    DeviceGuard g(cuda_gpu_id_);
-    CUDA_CHECK(cudaEventDestroy(cuda_event_));
+    // a recorded event may still be pending on its stream; re-recording it
+    // later is fine, cudaEventRecord just captures the new stream position
+    cudaEventPool().Release(cuda_gpu_id_, cuda_event_);
   }
 
   cudaEvent_t cuda_event_;
@@ -74,6 +135,12 @@ void EventRecordCUDA(Event* event, const void* context, const char* err_msg) {
       CUDA_ENFORCE(cudaEventRecord(
           wrapper->cuda_event_,
           static_cast<const CUDAContext*>(context)->cuda_stream()));
+#ifdef CAFFE2_ENABLE_SDT
+      CAFFE_SDT(
+          cuda_event_record,
+          event,
+          static_cast<const CUDAContext*>(context)->cuda_stream());
+#endif
       wrapper->cuda_stream_ =
           static_cast<const CUDAContext*>(context)->cuda_stream();
       wrapper->status_ = EventStatus::EVENT_SCHEDULED;
@@ -97,7 +164,20 @@ void EventFinishCUDA(const Event* event) {
   if (wrapper->status_ == EventStatus::EVENT_SCHEDULED) {
     // ok, even if event is already completed and status was not yet updated
     DeviceGuard g(wrapper->cuda_gpu_id_);
+    // cheap check first, cudaEventSynchronize may spin or yield the thread
+    if (cudaEventQuery(wrapper->cuda_event_) == cudaSuccess) {
+      wrapper->status_ = EventStatus::EVENT_SUCCESS;
+      CAFFE_EVENT(cudaEventStats(), host_syncs_skipped);
+      return;
+    }
+    CAFFE_EVENT(cudaEventStats(), host_syncs);
+#ifdef CAFFE2_ENABLE_SDT
+    CAFFE_SDT(cuda_event_sync_start, event);
+#endif
     auto cudaResult = cudaEventSynchronize(wrapper->cuda_event_);
+#ifdef CAFFE2_ENABLE_SDT
+    CAFFE_SDT(cuda_event_sync_done, event);
+#endif
     if (cudaResult == cudaSuccess) {
       wrapper->status_ = EventStatus::EVENT_SUCCESS;
     } else {
@@ -129,8 +209,15 @@ void EventWaitCUDACUDA(const Event* event, void* context) {
       //    CaffeCudaGetDevice(),
       //    static_cast<const CUDAContext*>(context)->cuda_gpu_id());
       CUDA_CHECK(cudaStreamWaitEvent(context_stream, wrapper->cuda_event_, 0));
+      CAFFE_EVENT(cudaEventStats(), stream_waits);
+#ifdef CAFFE2_ENABLE_SDT
+      CAFFE_SDT(cuda_event_wait, event, context_stream);
+#endif
+      return;
     }
   }
+  // already completed, or recorded on the waiting stream itself
+  CAFFE_EVENT(cudaEventStats(), stream_waits_skipped);
 }
 
 // Waiter is CPU, event is CUDA
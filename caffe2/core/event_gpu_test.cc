@@ -2,6 +2,7 @@
 #include "caffe2/core/context.h"
 #include "caffe2/core/context_gpu.h"
 #include "caffe2/core/event.h"
+#include "caffe2/core/stats.h"
 
 namespace caffe2 {
 
@@ -47,4 +48,35 @@ TEST(EventCUDATest, EventBasics) {
   context_cuda.WaitEvent(event_cpu);
 }
 
+TEST(EventCUDATest, EventsAreReused) {
+  if (!HasCudaGPU())
+    return;
+  DeviceOption device_cuda;
+  device_cuda.set_device_type(CUDA);
+  CUDAContext context_cuda(device_cuda);
+  context_cuda.SwitchToDevice();
+
+  auto events_reused = [] {
+    for (const auto& stat : StatRegistry::get().publish()) {
+      if (stat.key == "cuda_event/stats/events_reused") {
+        return stat.value;
+      }
+    }
+    return int64_t(0);
+  };
+
+  {
+    Event event_cuda(device_cuda);
+    context_cuda.Record(&event_cuda);
+    event_cuda.Finish();
+  }
+  auto reused_before = events_reused();
+  // takes the event the previous one released
+  Event event_cuda(device_cuda);
+  EXPECT_EQ(events_reused(), reused_before + 1);
+  context_cuda.Record(&event_cuda);
+  event_cuda.Finish();
+  EXPECT_EQ(event_cuda.Query(), EventStatus::EVENT_SUCCESS);
+}
+
 } // namespace caffe2
@@ -1,8 +1,11 @@
 #include "caffe2/core/memonger.h"
 
+#include <algorithm>
 #include <set>
 #include <unordered_set>
 
+#include "caffe2/core/operator.h"
+#include "caffe2/core/types.h"
 #include "caffe2/utils/proto_utils.h"
 
 namespace caffe2 {
@@ -570,6 +573,316 @@ class ComputeBlobRecyclingForDag {
   std::vector<bool> op_visited_;
 };
 
+namespace {
+
+// Ops whose outputs share the memory of their inputs
+const std::unordered_set<string> kAliasingOps = {"Alias"};
+
+size_t alignUp(size_t nbytes) {
+  return (nbytes + gCaffe2Alignment - 1) / gCaffe2Alignment * gCaffe2Alignment;
+}
+
+struct Lifetime {
+  int first;
+  int last;
+};
+
+// The axis a Concat or Split op concatenates or splits along, in the
+// dimensions of the blob that holds all the slices
+int concatSplitAxis(const OperatorDef& op, int ndim) {
+  ArgumentHelper helper(op);
+  int axis = 1;
+  if (helper.HasArgument("axis")) {
+    axis = helper.GetSingleArgument<int>("axis", -1);
+  } else if (
+      helper.HasArgument("order") &&
+      StringToStorageOrder(helper.GetSingleArgument<string>("order", "")) ==
+          StorageOrder::NHWC) {
+    axis = 3;
+  }
+  return axis < 0 ? axis + ndim : axis;
+}
+
+} // namespace
+
+MemoryPlan plan_inference_net_memory(
+    const NetDef& net,
+    const CaffeMap<string, std::vector<TIndex>>& input_shapes,
+    const std::set<string>& static_blobs,
+    bool alias_concat_and_split) {
+  MemoryPlan plan;
+  if (net.type() != "" && net.type() != "simple") {
+    LOG(INFO) << "Cannot plan memory for nets of type: " << net.type();
+    return plan;
+  }
+
+  vector<std::unique_ptr<NetDef>> nets;
+  nets.emplace_back(new NetDef(net));
+  TensorShapes shapes = InferBlobShapesAndTypesFromMap(input_shapes, nets);
+  std::unordered_map<string, const TensorShape*> shape_of;
+  for (const auto& shape : shapes.shapes()) {
+    shape_of[shape.name()] = &shape;
+  }
+
+  std::unordered_set<string> excluded(static_blobs.begin(), static_blobs.end());
+  excluded.insert(net.external_input().begin(), net.external_input().end());
+
+  // Step 1: find for every blob the first op that writes it and the last
+  // one that reads it, or reads anything aliasing it
+  std::unordered_map<string, Lifetime> lifetimes;
+  std::vector<string> order;
+  // the ops writing every blob
+  std::unordered_map<string, std::vector<int>> writers;
+  for (int i = 0; i < net.op_size(); i++) {
+    const auto& op = net.op(i);
+    for (const auto& inp : op.input()) {
+      auto it = lifetimes.find(inp);
+      if (it != lifetimes.end()) {
+        it->second.last = i;
+      }
+    }
+    for (const auto& outp : op.output()) {
+      writers[outp].push_back(i);
+      if (!lifetimes.count(outp)) {
+        lifetimes[outp] = Lifetime{i, i};
+        order.push_back(outp);
+      }
+    }
+  }
+  for (int i = net.op_size() - 1; i >= 0; i--) {
+    const auto& op = net.op(i);
+    if (!kAliasingOps.count(op.type())) {
+      continue;
+    }
+    for (const auto& inp : op.input()) {
+      auto it = lifetimes.find(inp);
+      if (it == lifetimes.end()) {
+        continue;
+      }
+      for (const auto& outp : op.output()) {
+        it->second.last = std::max(it->second.last, lifetimes[outp].last);
+      }
+    }
+  }
+  // outputs have to survive the run
+  for (const auto& outp : net.external_output()) {
+    auto it = lifetimes.find(outp);
+    if (it != lifetimes.end()) {
+      it->second.last = net.op_size();
+    }
+  }
+
+  // Step 2: collect the blobs we know the size of
+  struct Candidate {
+    MemoryPlan::Allocation allocation;
+    Lifetime lifetime;
+  };
+  std::vector<Candidate> candidates;
+  for (const auto& name : order) {
+    auto it = shape_of.find(name);
+    if (excluded.count(name) || it == shape_of.end() ||
+        it->second->unknown_shape() || it->second->unknown_dims_size() > 0) {
+      continue;
+    }
+    const auto& shape = *it->second;
+    TypeMeta meta;
+    try {
+      meta = DataTypeToTypeMeta(shape.data_type());
+    } catch (const std::runtime_error&) {
+      continue;
+    }
+    // types with constructors, like strings, can't live in raw memory
+    if (meta.ctor() ||
+        std::any_of(shape.dims().begin(), shape.dims().end(), [](int64_t d) {
+          return d < 0;
+        })) {
+      continue;
+    }
+    MemoryPlan::Allocation allocation;
+    allocation.blob = name;
+    allocation.dims.assign(shape.dims().begin(), shape.dims().end());
+    allocation.data_type = shape.data_type();
+    allocation.nbytes = meta.itemsize() * size_from_dim_(0, allocation.dims);
+    allocation.offset = 0;
+    if (allocation.nbytes == 0) {
+      continue;
+    }
+    candidates.push_back(Candidate{allocation, lifetimes[name]});
+  }
+
+  // Step 3: find the inputs of Concat and the outputs of Split that can be
+  // slices of the blob they are concatenated into or split from. The slices
+  // are then placed with that blob, which lives as long as all of them.
+  std::unordered_map<string, std::pair<string, size_t>> slices;
+  if (alias_concat_and_split) {
+    std::unordered_map<string, int> candidate_of;
+    for (int i = 0; i < candidates.size(); i++) {
+      candidate_of[candidates[i].allocation.blob] = i;
+    }
+    // blobs already part of a slice group, as the whole or as a slice
+    std::unordered_set<string> grouped;
+    for (int i = 0; i < net.op_size(); i++) {
+      const auto& op = net.op(i);
+      const bool is_concat = op.type() == "Concat";
+      if (!is_concat && op.type() != "Split") {
+        continue;
+      }
+      if (op.has_device_option() &&
+          op.device_option().device_type() != CPU) {
+        continue;
+      }
+      const string& whole = is_concat ? op.output(0) : op.input(0);
+      std::vector<string> parts;
+      if (is_concat) {
+        parts.assign(op.input().begin(), op.input().end());
+      } else {
+        if (op.input_size() > 1) {
+          // the sizes of the outputs are an input, but not their shapes
+          continue;
+        }
+        parts.assign(op.output().begin(), op.output().end());
+      }
+      auto it = candidate_of.find(whole);
+      if (it == candidate_of.end() || grouped.count(whole)) {
+        continue;
+      }
+      auto& whole_candidate = candidates[it->second];
+      const auto& dims = whole_candidate.allocation.dims;
+      const int axis = concatSplitAxis(op, dims.size());
+      if (axis < 0 || axis >= dims.size() ||
+          size_from_dim_(0, dims) != size_from_dim_(axis, dims)) {
+        // the slices aren't contiguous
+        continue;
+      }
+      // Concat must be the only op writing its output, and the last one
+      // writing its inputs. Split must be the only op writing its outputs,
+      // and the last one writing its input.
+      const auto& whole_writers = writers[whole];
+      bool ok = is_concat
+          ? whole_writers.size() == 1
+          : *std::max_element(whole_writers.begin(), whole_writers.end()) < i;
+      std::unordered_set<string> seen;
+      size_t nbytes = 0;
+      for (const auto& part : parts) {
+        auto part_it = candidate_of.find(part);
+        if (!ok || part_it == candidate_of.end() || part == whole ||
+            grouped.count(part) || !seen.insert(part).second) {
+          ok = false;
+          break;
+        }
+        const auto& part_candidate = candidates[part_it->second];
+        const auto& part_writers = writers[part];
+        ok = part_candidate.allocation.data_type ==
+                whole_candidate.allocation.data_type &&
+            (is_concat ? *std::max_element(
+                             part_writers.begin(), part_writers.end()) < i
+                       : part_writers.size() == 1);
+        nbytes += part_candidate.allocation.nbytes;
+      }
+      if (!ok || nbytes != whole_candidate.allocation.nbytes) {
+        continue;
+      }
+      grouped.insert(whole);
+      size_t offset = 0;
+      for (const auto& part : parts) {
+        const auto& part_candidate = candidates[candidate_of[part]];
+        grouped.insert(part);
+        slices[part] = std::make_pair(whole, offset);
+        offset += part_candidate.allocation.nbytes;
+        whole_candidate.lifetime.first = std::min(
+            whole_candidate.lifetime.first, part_candidate.lifetime.first);
+        whole_candidate.lifetime.last = std::max(
+            whole_candidate.lifetime.last, part_candidate.lifetime.last);
+      }
+    }
+  }
+  std::vector<Candidate> slice_candidates;
+  candidates.erase(
+      std::remove_if(
+          candidates.begin(),
+          candidates.end(),
+          [&](const Candidate& c) {
+            if (slices.count(c.allocation.blob)) {
+              slice_candidates.push_back(c);
+              return true;
+            }
+            return false;
+          }),
+      candidates.end());
+
+  // Step 4: place the largest blobs first, each at the lowest offset that
+  // doesn't overlap any blob alive at the same time
+  std::stable_sort(
+      candidates.begin(),
+      candidates.end(),
+      [](const Candidate& a, const Candidate& b) {
+        return a.allocation.nbytes > b.allocation.nbytes;
+      });
+  for (int i = 0; i < candidates.size(); i++) {
+    auto& c = candidates[i];
+    std::vector<std::pair<size_t, size_t>> taken;
+    for (int j = 0; j < i; j++) {
+      const auto& p = candidates[j];
+      if (p.lifetime.first <= c.lifetime.last &&
+          c.lifetime.first <= p.lifetime.last) {
+        taken.emplace_back(
+            p.allocation.offset,
+            p.allocation.offset + alignUp(p.allocation.nbytes));
+      }
+    }
+    std::sort(taken.begin(), taken.end());
+    size_t offset = 0;
+    for (const auto& region : taken) {
+      if (offset + c.allocation.nbytes <= region.first) {
+        break;
+      }
+      offset = std::max(offset, region.second);
+    }
+    c.allocation.offset = offset;
+    plan.arena_size =
+        std::max(plan.arena_size, offset + alignUp(c.allocation.nbytes));
+    plan.total_size += alignUp(c.allocation.nbytes);
+    plan.allocations.push_back(c.allocation);
+  }
+  // the slices go where the blob they are part of was placed
+  std::unordered_map<string, size_t> offsets;
+  for (const auto& allocation : plan.allocations) {
+    offsets[allocation.blob] = allocation.offset;
+  }
+  for (auto& c : slice_candidates) {
+    const auto& slice = slices[c.allocation.blob];
+    c.allocation.alias_of = slice.first;
+    c.allocation.offset = offsets[slice.first] + slice.second;
+    plan.total_size += alignUp(c.allocation.nbytes);
+    plan.allocations.push_back(c.allocation);
+  }
+
+  LOG(INFO) << "planned " << plan.allocations.size() << " blobs into "
+            << plan.arena_size << " bytes (" << plan.total_size
+            << " bytes without sharing), " << slice_candidates.size()
+            << " of them as slices of Concat or Split blobs";
+  return plan;
+}
+
+void apply_memory_plan(const MemoryPlan& plan, Workspace* ws) {
+  if (plan.arena_size == 0) {
+    return;
+  }
+  auto data_and_deleter = CPUContext::New(plan.arena_size);
+  // every planned tensor keeps the buffer alive until it is reallocated
+  std::shared_ptr<void> arena(
+      data_and_deleter.first, data_and_deleter.second);
+  for (const auto& allocation : plan.allocations) {
+    auto* tensor = ws->CreateBlob(allocation.blob)->GetMutable<TensorCPU>();
+    tensor->Resize(allocation.dims);
+    tensor->ShareExternalPointer(
+        static_cast<char*>(arena.get()) + allocation.offset,
+        DataTypeToTypeMeta(allocation.data_type),
+        allocation.nbytes,
+        [arena](void*) {});
+  }
+}
+
 NetDef compute_blob_recycling_for_dag(
     const NetDef& net,
     const std::vector<string>& heads,
@@ -4,6 +4,7 @@
 #include <unordered_set>
 
 #include "caffe2/core/common.h"
+#include "caffe2/core/tensor.h"
 #include "caffe2/core/workspace.h"
 #include "caffe2/proto/caffe2.pb.h"
 
@@ -14,6 +15,52 @@ NetDef optimize_inference_net(
     const NetDef& net,
     const std::set<string>& static_blobs);
 
+// Offsets of the intermediate blobs of an inference net in a single buffer,
+// computed ahead of time from their inferred shapes.
+struct MemoryPlan {
+  struct Allocation {
+    string blob;
+    std::vector<TIndex> dims;
+    TensorProto::DataType data_type;
+    size_t offset;
+    size_t nbytes;
+    // the blob this one is a slice of, when it is an input of a Concat or an
+    // output of a Split, or empty when it has memory of its own
+    string alias_of;
+  };
+  std::vector<Allocation> allocations;
+  // size of the buffer, which is the peak footprint of the planned blobs
+  size_t arena_size = 0;
+  // what the planned blobs would take if each had a buffer of its own
+  size_t total_size = 0;
+};
+
+// Runs shape inference over `net` from `input_shapes` (which must cover
+// all of its external inputs, including the parameters) and packs every
+// blob with a known shape and a POD type, that isn't in `static_blobs` or an
+// external input, into one buffer, sharing memory between blobs that aren't
+// alive at the same time. Only nets whose ops run in order are supported.
+//
+// With `alias_concat_and_split`, the inputs of Concat ops and the outputs of
+// Split ops are also placed at their offsets in the blob they are
+// concatenated into or split from, so that their producers write directly
+// where Concat would copy them (or their consumers read directly what Split
+// would copy), and these ops don't copy anything. This only applies when the
+// slices are contiguous, i.e. when all the dimensions before the axis are 1,
+// and when neither the slices nor the whole blob are written again after
+// being concatenated or split.
+MemoryPlan plan_inference_net_memory(
+    const NetDef& net,
+    const CaffeMap<string, std::vector<TIndex>>& input_shapes,
+    const std::set<string>& static_blobs,
+    bool alias_concat_and_split = false);
+
+// Allocates the buffer of `plan` and makes the planned blobs in `ws` views
+// into it, so that the ops of the net write their outputs there as long as
+// the shapes match the plan. Blobs that end up with other shapes get buffers
+// of their own, as usual.
+void apply_memory_plan(const MemoryPlan& plan, Workspace* ws);
+
 NetDef compute_blob_recycling_for_dag(
     const NetDef& net,
     const std::vector<string>& heads,
@@ -6,6 +6,7 @@
 #include <unordered_set>
 
 #include "caffe2/core/operator.h"
+#include "caffe2/core/sampling_profiler.h"
 #include "caffe2/core/timer.h"
 #include "caffe2/proto/caffe2.pb.h"
 #include "caffe2/utils/proto_utils.h"
@@ -122,6 +123,10 @@ unique_ptr<NetBase> CreateNet(
     for (auto& creator : *observer_creators) {
       net->AttachObserver(creator(net.get()));
     }
+    if (FLAGS_caffe2_sampling_profiler_every_n > 0) {
+      net->AttachObserver(caffe2::make_unique<SamplingProfilerNetObserver>(
+          net.get(), FLAGS_caffe2_sampling_profiler_every_n));
+    }
   }
   return net;
 }
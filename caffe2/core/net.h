@@ -15,12 +15,36 @@
 #include "caffe2/core/observer.h"
 #include "caffe2/core/operator_schema.h"
 #include "caffe2/core/registry.h"
+#include "caffe2/core/static_tracepoint.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/core/workspace.h"
 #include "caffe2/proto/caffe2.pb.h"
 #include "caffe2/utils/simple_queue.h"
 #include "caffe2/utils/thread_pool.h"
 
+// Fires the static tracepoint caffe2:<probe>, e.g. operator_start or
+// operator_done, with the net name, op name, op type and op pointer as
+// arguments. Compiled out unless built with USE_SDT.
+#ifdef CAFFE2_ENABLE_SDT
+#define CAFFE_SDT_OPERATOR(probe, net_name, op)                              \
+  {                                                                          \
+    const auto* __sdt_op = (op);                                             \
+    const char* __sdt_net_name = (net_name).c_str();                         \
+    const char* __sdt_op_name =                                              \
+        __sdt_op->has_debug_def() ? __sdt_op->debug_def().name().c_str()     \
+                                  : "";                                      \
+    const char* __sdt_op_type =                                              \
+        __sdt_op->has_debug_def() ? __sdt_op->debug_def().type().c_str()     \
+                                  : "";                                      \
+    CAFFE_SDT(                                                               \
+        probe, __sdt_net_name, __sdt_op_name, __sdt_op_type, __sdt_op);      \
+  }
+#else
+#define CAFFE_SDT_OPERATOR(probe, net_name, op) \
+  do {                                          \
+  } while (0)
+#endif
+
 namespace caffe2 {
 
 class NetBase;
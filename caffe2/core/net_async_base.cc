@@ -1,6 +1,7 @@
 #include "caffe2/core/net_async_polling.h"
 
 #include "caffe2/core/operator.h"
+#include "caffe2/core/thread_budget.h"
 #include "caffe2/core/timer.h"
 
 CAFFE2_DEFINE_int(
@@ -35,8 +36,34 @@ CAFFE2_DEFINE_bool(
     true,
     "Select next non-busy stream");
 
+CAFFE2_DEFINE_int(
+    caffe2_net_async_lock_free_queue_size,
+    0,
+    "If positive, thread pools use a lock-free task queue of this size "
+    "and spinning workers instead of a mutex-guarded queue");
+
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_fuse_cpu_chains,
+    false,
+    "Run chains of synchronous CPU ops without updating the events of "
+    "all but the last op of a chain");
+
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_intra_op_budget,
+    false,
+    "Share caffe2_cpu_core_budget between the inter-op threads and the "
+    "intra-op threads of the CPU ops, which get more threads the more they "
+    "cost and the fewer tasks are running or queued");
+
 namespace caffe2 {
 
+namespace {
+
+// Weight of the last run in the running average of an op's cost
+constexpr float kOpCostDecay = 0.1f;
+
+} // namespace
+
 thread_local std::vector<int> AsyncNetBase::stream_counters_;
 
 AsyncNetBase::AsyncNetBase(
@@ -65,7 +92,82 @@ AsyncNetBase::AsyncNetBase(
     events_.push_back(&op->event());
   }
 
+  // Nothing waits on the events of ops in the middle of a chain, they are
+  // only set for the sake of uniformity. For chains that finish synchronously
+  // on CPU we skip both setting and resetting them, which is most of the per
+  // op overhead of the async executors for cheap ops.
+  fused_chains_.resize(chains_.size(), false);
+  for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
+    fused_chains_[task_id] =
+        FLAGS_caffe2_net_async_fuse_cpu_chains && isFusableChain(task_id);
+  }
+  event_operators_.reserve(operators_.size());
+  for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
+    const auto& chain = chains_[task_id];
+    if (fused_chains_[task_id]) {
+      event_operators_.push_back(operators_[chain.back()]);
+    } else {
+      for (auto op_id : chain) {
+        event_operators_.push_back(operators_[op_id]);
+      }
+    }
+  }
+
   num_workers_ = net_def->has_num_workers() ? net_def->num_workers() : -1;
+
+  if (IsNUMAEnabled()) {
+    placeInputsOnNUMANodes();
+  }
+
+  if (FLAGS_caffe2_net_preallocate_outputs) {
+    preallocator_ = caffe2::make_unique<NetOutputPreallocator>(operators_);
+  }
+
+  if (FLAGS_caffe2_net_async_intra_op_budget) {
+    // The time of ops with an async part is only the time to schedule them
+    budgeted_ops_.resize(operators_.size(), false);
+    for (size_t op_id = 0; op_id < operators_.size(); ++op_id) {
+      const auto* op = operators_[op_id];
+      budgeted_ops_[op_id] =
+          op->device_option().device_type() == CPU && !op->HasAsyncPart();
+    }
+    op_costs_us_.resize(operators_.size(), 0);
+  }
+}
+
+void AsyncNetBase::placeInputsOnNUMANodes() {
+  // Outputs are allocated by the pool threads running the ops, which are
+  // bound to the ops' nodes; inputs that already exist, like weights filled by
+  // an init net, are wherever the thread that created them ran. Move the
+  // ones whose readers in this net are all on the same node to that node.
+  std::unordered_map<const Blob*, int> blob_nodes;
+  for (auto op : operators_) {
+    const auto& device_option = op->device_option();
+    int numa_node_id = device_option.device_type() == CPU
+        ? device_option.numa_node_id()
+        : -1;
+    for (auto blob : op->Inputs()) {
+      auto it = blob_nodes.find(blob);
+      if (it == blob_nodes.end()) {
+        blob_nodes[blob] = numa_node_id;
+      } else if (it->second != numa_node_id) {
+        it->second = -1;
+      }
+    }
+  }
+  for (const auto& kv : blob_nodes) {
+    const Blob* blob = kv.first;
+    if (kv.second < 0 || !blob->IsType<TensorCPU>()) {
+      continue;
+    }
+    const auto& tensor = blob->Get<TensorCPU>();
+    if (tensor.nbytes() == 0) {
+      continue;
+    }
+    if (!NUMAMovePages(tensor.raw_data(), tensor.nbytes(), kv.second)) {
+      VLOG(1) << "Could not move an input to NUMA node " << kv.second;
+    }
+  }
 }
 
 std::shared_ptr<TaskThreadPool> AsyncNetBase::pool_getter(
@@ -129,6 +231,30 @@ bool AsyncNetBase::isStreamFree(int task_id, int stream_id) const {
   return last_task_op->IsStreamFree(stream_id);
 }
 
+bool AsyncNetBase::isFusableChain(int task_id) const {
+  const auto& chain = chains_[task_id];
+  if (chain.size() < 2) {
+    return false;
+  }
+  for (auto op_id : chain) {
+    const auto& op = operators_[op_id];
+    if (op->device_option().device_type() != CPU || op->HasAsyncPart()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool AsyncNetBase::RunAsync() {
+  for (auto op : event_operators_) {
+    op->ResetEvent();
+  }
+  if (preallocator_) {
+    preallocator_->Preallocate();
+  }
+  return DoRunAsync();
+}
+
 bool AsyncNetBase::canSchedule(
     int task_id,
     const std::vector<EventStatus>* status) {
@@ -193,16 +319,54 @@ void AsyncNetBase::asyncWait(
 }
 
 void AsyncNetBase::run(int task_id, int stream_id) {
-  std::string err_msg;
-  for (auto& op_id : chains_[task_id]) {
+  const auto& chain = chains_[task_id];
+  bool fused = fused_chains_[task_id];
+  std::unique_ptr<InterOpTaskGuard> task_guard;
+  if (!budgeted_ops_.empty()) {
+    task_guard = caffe2::make_unique<InterOpTaskGuard>();
+  }
+  for (auto& op_id : chain) {
     auto& op = operators_[op_id];
     try {
-      CAFFE_ENFORCE(op->RunAsync(stream_id), "Failed to execute an op");
+      CAFFE_SDT_OPERATOR(operator_start, name_, op);
+      std::unique_ptr<IntraOpThreadsGuard> threads_guard;
+      int num_threads = 0;
+      Timer timer;
+      if (!budgeted_ops_.empty() && budgeted_ops_[op_id]) {
+        num_threads = IntraOpThreadsFor(
+            op_costs_us_[op_id],
+            pool(op->device_option())->numQueuedTasks());
+        threads_guard = caffe2::make_unique<IntraOpThreadsGuard>(num_threads);
+        timer.Start();
+      }
+      if (fused && op_id != chain.back()) {
+        // Run doesn't touch the event, the chain's event is set either by
+        // the last op or below if this one fails
+        CAFFE_ENFORCE(op->Run(stream_id), "Failed to execute an op");
+      } else {
+        CAFFE_ENFORCE(op->RunAsync(stream_id), "Failed to execute an op");
+      }
+      if (num_threads == 1) {
+        // Only runs on a single thread measure the CPU time of the op, which
+        // an op that ignores its threads would inflate otherwise
+        float cost_us = timer.MicroSeconds();
+        auto& average = op_costs_us_[op_id];
+        average = average == 0
+            ? cost_us
+            : (1 - kOpCostDecay) * average + kOpCostDecay * cost_us;
+      }
+      CAFFE_SDT_OPERATOR(operator_done, name_, op);
     } catch (const std::exception& e) {
+      if (fused && op_id != chain.back()) {
+        event(task_id).SetFinished(e.what());
+      }
       CAFFE_THROW(
           std::string(e.what()) + ",  op " +
           (op->has_debug_def() ? op->type() : " unknown"));
     } catch (...) {
+      if (fused && op_id != chain.back()) {
+        event(task_id).SetFinished("Failed to execute task: unknown error");
+      }
       CAFFE_THROW(
           "Failed to execute task: unknown error,  op " +
           (op->has_debug_def() ? op->type() : " unknown"));
@@ -255,8 +419,14 @@ std::shared_ptr<TaskThreadPool> GetAsyncNetCPUThreadPool(
       LOG(INFO) << "Using default CPU pool size: " << pool_size
                 << "; NUMA node id: " << numa_node_id;
     } else {
-      auto num_cores = std::thread::hardware_concurrency();
+      // pool threads are bound to their NUMA node, so only count its cores
+      int num_cores = numa_node_id >= 0 && IsNUMAEnabled()
+          ? GetNUMANodeCPUCount(numa_node_id)
+          : std::thread::hardware_concurrency();
       CAFFE_ENFORCE(num_cores > 0, "Failed to get number of CPU cores");
+      if (FLAGS_caffe2_net_async_intra_op_budget) {
+        num_cores = std::min(num_cores, CPUCoreBudget());
+      }
       LOG(INFO) << "Using estimated CPU pool size: " << num_cores
                 << "; NUMA node id: " << numa_node_id;
       pool_size = num_cores;
@@ -270,7 +440,10 @@ std::shared_ptr<TaskThreadPool> GetAsyncNetCPUThreadPool(
   if (!shared_pool) {
     LOG(INFO) << "Created CPU pool, size: " << pool_size
               << "; NUMA node id: " << numa_node_id;
-    shared_pool = std::make_shared<TaskThreadPool>(pool_size, numa_node_id);
+    shared_pool = std::make_shared<TaskThreadPool>(
+        pool_size,
+        numa_node_id,
+        std::max(FLAGS_caffe2_net_async_lock_free_queue_size, 0));
     pools[numa_node_id][pool_size] = shared_pool;
   }
   return shared_pool;
@@ -4,6 +4,7 @@
 #include "caffe2/core/common.h"
 #include "caffe2/core/net.h"
 #include "caffe2/core/net_dag_utils.h"
+#include "caffe2/core/net_preallocation.h"
 #include "caffe2/core/registry.h"
 #include "caffe2/core/stats.h"
 #include "caffe2/core/timer.h"
@@ -29,6 +30,8 @@ class AsyncNetBase : public NetBase {
     return operators_;
   }
 
+  bool RunAsync() override;
+
  protected:
   bool canSchedule(
       int chain_id,
@@ -52,11 +55,24 @@ class AsyncNetBase : public NetBase {
 
   bool isStreamFree(int task_id, int stream_id) const;
 
+  bool isFusableChain(int task_id) const;
+
+  void placeInputsOnNUMANodes();
+
   // Operator/task graph
   std::vector<OperatorBase*> operators_;
   std::vector<dag_utils::OperatorNode> operator_nodes_;
   std::vector<std::vector<int>> chains_;
   std::vector<dag_utils::OpGraphNode> chain_nodes_; // chains' parents/children
+  // chains of synchronous CPU ops that only update the event of their last op
+  std::vector<bool> fused_chains_;
+  // operators whose events are used, reset before every run
+  std::vector<OperatorBase*> event_operators_;
+  std::unique_ptr<NetOutputPreallocator> preallocator_;
+  // With caffe2_net_async_intra_op_budget, the CPU ops whose intra-op
+  // threads are budgeted and the running average of their CPU time
+  std::vector<bool> budgeted_ops_;
+  std::vector<float> op_costs_us_;
 
   // Pools and streams
   std::mutex pools_mutex_;
@@ -171,7 +171,10 @@ bool AsyncDAGNet::RunAt(int chain_id, const std::vector<int>& chain) {
   bool success = true;
   for (auto idx : chain) {
     ProfiledRange r(operator_nodes_[idx].operator_->debug_def(), kRunColor);
-    success &= operator_nodes_[idx].operator_->RunAsync(stream_id);
+    auto* op = operator_nodes_[idx].operator_.get();
+    CAFFE_SDT_OPERATOR(operator_start, name_, op);
+    success &= op->RunAsync(stream_id);
+    CAFFE_SDT_OPERATOR(operator_done, name_, op);
   }
 
   const auto& sink_idx = chain.back();
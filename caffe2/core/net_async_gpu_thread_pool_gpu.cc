@@ -3,6 +3,7 @@
 #include "caffe2/core/context_gpu.h"
 
 CAFFE2_DEFINE_int(caffe2_threads_per_gpu, 1, "Number of CPU threads per GPU");
+CAFFE2_DECLARE_int(caffe2_net_async_lock_free_queue_size);
 
 namespace caffe2 {
 
@@ -25,8 +26,10 @@ std::shared_ptr<TaskThreadPool> GetAsyncNetGPUThreadPool(
     shared_pool = pools.at(gpu_id).lock();
   }
   if (!shared_pool) {
-    shared_pool =
-        std::make_shared<TaskThreadPool>(FLAGS_caffe2_threads_per_gpu);
+    shared_pool = std::make_shared<TaskThreadPool>(
+        FLAGS_caffe2_threads_per_gpu,
+        -1,
+        std::max(FLAGS_caffe2_net_async_lock_free_queue_size, 0));
     pools[gpu_id] = shared_pool;
   }
   return shared_pool;
@@ -3,6 +3,8 @@
 #include "caffe2/core/operator.h"
 #include "caffe2/core/timer.h"
 
+#include <algorithm>
+
 CAFFE2_DECLARE_bool(caffe2_dag_net_collect_stats);
 
 namespace caffe2 {
@@ -39,6 +41,8 @@ bool AsyncPollingNet::DoRunAsync() {
   bool success = pollAndSchedule();
   if (FLAGS_caffe2_dag_net_collect_stats) {
     CAFFE_EVENT(stats_[CPU], poll_time_ms, timer.MilliSeconds());
+    CAFFE_EVENT(stats_[CPU], poll_iterations, num_polls_);
+    CAFFE_EVENT(stats_[CPU], poll_event_queries, num_queries_);
   }
   if (!success) {
     finalizeEvents();
@@ -90,6 +94,8 @@ void AsyncPollingNet::reset() {
   status_.clear();
   status_.resize(tasksNum(), EventStatus::EVENT_INITIALIZED);
   has_chain_failed_ = false;
+  num_polls_ = 0;
+  num_queries_ = 0;
 }
 
 bool AsyncPollingNet::pollAndSchedule() {
@@ -106,6 +112,7 @@ bool AsyncPollingNet::pollAndSchedule() {
 
   Timer timer;
   while (!current_tasks.empty()) {
+    ++num_polls_;
     std::unordered_set<int> updated_tasks;
     std::unordered_set<int> next_tasks;
     updated_tasks.reserve(current_tasks.size());
@@ -120,6 +127,7 @@ bool AsyncPollingNet::pollAndSchedule() {
     for (auto& task_id : current_tasks) {
       auto prev_status = status_[task_id];
       status_[task_id] = query(task_id);
+      ++num_queries_;
       if (status_[task_id] == EventStatus::EVENT_FAILED) {
         finishTasks(current_tasks);
         return false;
@@ -165,10 +173,39 @@ bool AsyncPollingNet::pollAndSchedule() {
     }
 
     current_tasks.swap(next_tasks);
+
+    // Once every task is scheduled and the remaining ones only wait for
+    // their device work, there is nothing left to schedule: block on their
+    // events in one batch instead of spinning on per-event queries
+    if (scheduled_tasks.size() == static_cast<size_t>(tasksNum()) &&
+        std::all_of(
+            current_tasks.begin(), current_tasks.end(), [this](int task_id) {
+              return status_[task_id] == EventStatus::EVENT_SCHEDULED;
+            })) {
+      return finishScheduledTasks(current_tasks);
+    }
   }
   return true;
 }
 
+bool AsyncPollingNet::finishScheduledTasks(
+    const std::unordered_set<int>& task_ids) {
+  if (FLAGS_caffe2_dag_net_collect_stats) {
+    CAFFE_EVENT(stats_[CPU], poll_batch_finished_tasks, task_ids.size());
+  }
+  finishTasks(task_ids);
+  bool success = true;
+  for (auto& task_id : task_ids) {
+    status_[task_id] = query(task_id);
+    if (status_[task_id] == EventStatus::EVENT_FAILED) {
+      success = false;
+    } else if (FLAGS_caffe2_dag_net_collect_stats) {
+      updateTaskStats(task_id);
+    }
+  }
+  return success;
+}
+
 void AsyncPollingNet::updateTaskStats(int task_id) {
   const auto& device_option = event(task_id).GetDeviceOption();
   if (status_[task_id] == EventStatus::EVENT_SCHEDULED) {
@@ -14,6 +14,7 @@ class AsyncPollingNet : public AsyncNetBase {
   bool DoRunAsync() override;
 
   bool pollAndSchedule();
+  bool finishScheduledTasks(const std::unordered_set<int>& task_ids);
   void schedule(int task_id);
 
   // Synchronization
@@ -30,6 +31,9 @@ class AsyncPollingNet : public AsyncNetBase {
     CAFFE_AVG_EXPORTED_STAT(poll_status_update_time_us);
     CAFFE_AVG_EXPORTED_STAT(task_time_to_scheduled_us);
     CAFFE_AVG_EXPORTED_STAT(task_time_to_succeeded_ms);
+    CAFFE_AVG_EXPORTED_STAT(poll_iterations);
+    CAFFE_AVG_EXPORTED_STAT(poll_event_queries);
+    CAFFE_AVG_EXPORTED_STAT(poll_batch_finished_tasks);
   };
   mutable std::vector<AsyncPollingNetStats> stats_;
   std::vector<std::unique_ptr<Timer>> task_timers_;
@@ -39,6 +43,8 @@ class AsyncPollingNet : public AsyncNetBase {
   std::vector<EventStatus> status_;
   void reset();
   std::atomic<bool> has_chain_failed_;
+  int64_t num_polls_;
+  int64_t num_queries_;
 
   DISABLE_COPY_AND_ASSIGN(AsyncPollingNet);
 };
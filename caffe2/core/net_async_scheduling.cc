@@ -1,19 +1,104 @@
 #include "caffe2/core/net_async_scheduling.h"
 
+#include <algorithm>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/proto/prof_dag.pb.h"
+#include "caffe2/utils/proto_utils.h"
+
 CAFFE2_DEFINE_bool(
     caffe2_net_async_always_schedule_child,
     false,
     "Always schedule child chains from parent chain");
 
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_priority_scheduling,
+    false,
+    "Dispatch ready chains in order of their longest remaining path "
+    "instead of the order in which they become ready");
+
+CAFFE2_DEFINE_string(
+    caffe2_net_async_op_costs,
+    "",
+    "File with ProfDAGProtos stats (from prof_dag net) used as op costs "
+    "for priority scheduling; every op costs 1 by default");
+
 namespace caffe2 {
 
 AsyncSchedulingNet::AsyncSchedulingNet(
     const std::shared_ptr<const NetDef>& net_def,
     Workspace* ws)
-    : AsyncNetBase(net_def, ws), running_(false) {
+    : AsyncNetBase(net_def, ws),
+      running_(false),
+      use_priorities_(FLAGS_caffe2_net_async_priority_scheduling) {
+  if (use_priorities_) {
+    computePriorities();
+  }
   reset();
 }
 
+float AsyncSchedulingNet::opCost(
+    int op_id,
+    const std::unordered_map<std::string, float>& costs) const {
+  if (costs.empty()) {
+    return 1;
+  }
+  const auto& op_type = operators_[op_id]->debug_def().type();
+  // per op stats (GetPerOperatorCost) take precedence over per type ones
+  // (GetOperatorStats)
+  auto it = costs.find(
+      name_ + "___" + caffe2::to_string(op_id) + "___" + op_type);
+  if (it == costs.end()) {
+    it = costs.find(op_type);
+  }
+  // ops that weren't profiled are assumed to be free
+  return it != costs.end() ? it->second : 0;
+}
+
+void AsyncSchedulingNet::computePriorities() {
+  std::unordered_map<std::string, float> costs;
+  if (!FLAGS_caffe2_net_async_op_costs.empty()) {
+    ProfDAGProtos stats;
+    CAFFE_ENFORCE(
+        ReadProtoFromFile(FLAGS_caffe2_net_async_op_costs, &stats),
+        "Can't read op costs from ",
+        FLAGS_caffe2_net_async_op_costs);
+    for (const auto& stat : stats.stats()) {
+      costs[stat.name()] = stat.mean();
+    }
+  }
+
+  // visit tasks in reverse topological order, so that the priorities of
+  // children are known before their parents'
+  priorities_.assign(tasksNum(), 0);
+  std::vector<int> pending_children(tasksNum());
+  std::vector<int> ready;
+  for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
+    pending_children[task_id] = children(task_id).size();
+    if (pending_children[task_id] == 0) {
+      ready.push_back(task_id);
+    }
+  }
+  while (!ready.empty()) {
+    auto task_id = ready.back();
+    ready.pop_back();
+    float longest_child = 0;
+    for (auto child_id : children(task_id)) {
+      longest_child = std::max(longest_child, priorities_[child_id]);
+    }
+    float cost = 0;
+    for (auto op_id : chains_[task_id]) {
+      cost += opCost(op_id, costs);
+    }
+    priorities_[task_id] = cost + longest_child;
+    for (auto parent_id : parents(task_id)) {
+      if (--pending_children[parent_id] == 0) {
+        ready.push_back(parent_id);
+      }
+    }
+  }
+}
+
 void AsyncSchedulingNet::reset() {
   processed_tasks_num_ = 0;
   cleanup_ = false;
@@ -36,70 +121,97 @@ void AsyncSchedulingNet::Wait() {
 
 void AsyncSchedulingNet::schedule(int task_id) {
   const auto& device_option = event(task_id).GetDeviceOption();
-  pool(device_option)->run([this, task_id]() {
-    if (success_) {
-      int stream_id = stream(task_id);
-      asyncWait(task_id, stream_id, parents(task_id));
-      try {
-        run(task_id, stream_id);
-      } catch (const std::exception& e) {
-        std::unique_lock<std::mutex> lock(exception_mutex_);
-        exception_messages_.push_back(e.what());
-        success_ = false;
-      }
+  auto task_pool = pool(device_option);
+  if (use_priorities_) {
+    {
+      std::unique_lock<std::mutex> lock(ready_mutex_);
+      ready_tasks_[task_pool.get()].push(
+          ReadyTask{priorities_[task_id], task_id});
     }
+    // Pools run jobs in FIFO order, so instead of the task itself we give the
+    // pool a job that takes the best task that is ready by the time it runs
+    task_pool->run(std::bind(
+        &AsyncSchedulingNet::runHighestPriorityTask, this, task_pool.get()));
+  } else {
+    task_pool->run([this, task_id]() { runTask(task_id); });
+  }
+}
 
-    auto task_count = ++processed_tasks_num_;
+void AsyncSchedulingNet::runHighestPriorityTask(TaskThreadPool* task_pool) {
+  int task_id;
+  {
+    std::unique_lock<std::mutex> lock(ready_mutex_);
+    auto& ready = ready_tasks_[task_pool];
+    CAFFE_ENFORCE(!ready.empty(), "No ready task for scheduled job");
+    task_id = ready.top().task_id;
+    ready.pop();
+  }
+  runTask(task_id);
+}
 
-    for (auto child_id : children(task_id)) {
-      int parent_count = updateParentCount(child_id);
-      if (parent_count == 0) {
-        if (cleanup_ || FLAGS_caffe2_net_async_always_schedule_child ||
-            canSchedule(child_id)) {
-          schedule(child_id);
-        } else {
-          const auto& device_option = event(child_id).GetDeviceOption();
-          pool(device_option)
-              ->run(std::bind(
-                  &AsyncSchedulingNet::pollAndSchedule, this, child_id));
-        }
-      }
+void AsyncSchedulingNet::runTask(int task_id) {
+  if (success_) {
+    int stream_id = stream(task_id);
+    asyncWait(task_id, stream_id, parents(task_id));
+    try {
+      run(task_id, stream_id);
+    } catch (const std::exception& e) {
+      std::unique_lock<std::mutex> lock(exception_mutex_);
+      exception_messages_.push_back(e.what());
+      success_ = false;
     }
+  }
 
-    if (success_) {
-      if (task_count == tasksNum()) {
-        // All tasks are finished, polling thread is sleeping;
-        // only one thread enters here
-        finalizeEvents();
-        finishRun();
-        return;
-      }
-    } else {
-      // Before setting running_ to false and notifying waiters we need to
-      // 1. Ensure that only one thread does the cleanup
-      // 2. Ensure that all other pending tasks in workers and polling threads
-      //    are finished and
-      // 3. Ensure that all tasks that were not scheduled have their events set
-      {
-        std::unique_lock<std::mutex> cleanup_lock(cleanup_mutex_);
-        if (cleanup_) {
-          return;
-        }
-        cleanup_ = true;
-      }
+  auto task_count = ++processed_tasks_num_;
 
-      // Errors are not recoverable and happen in exceptional cases,
-      // ok to busy wait
-      while (processed_tasks_num_ != tasksNum()) {
+  for (auto child_id : children(task_id)) {
+    int parent_count = updateParentCount(child_id);
+    if (parent_count == 0) {
+      if (cleanup_ || FLAGS_caffe2_net_async_always_schedule_child ||
+          canSchedule(child_id)) {
+        schedule(child_id);
+      } else {
+        const auto& device_option = event(child_id).GetDeviceOption();
+        pool(device_option)
+            ->run(std::bind(
+                &AsyncSchedulingNet::pollAndSchedule, this, child_id));
       }
+    }
+  }
 
-      // Make sure all events are set, wait for scheduled events
+  if (success_) {
+    if (task_count == tasksNum()) {
+      // All tasks are finished, polling thread is sleeping;
+      // only one thread enters here
       finalizeEvents();
-
-      // Notify observers and waiters
       finishRun();
+      return;
+    }
+  } else {
+    // Before setting running_ to false and notifying waiters we need to
+    // 1. Ensure that only one thread does the cleanup
+    // 2. Ensure that all other pending tasks in workers and polling threads
+    //    are finished and
+    // 3. Ensure that all tasks that were not scheduled have their events set
+    {
+      std::unique_lock<std::mutex> cleanup_lock(cleanup_mutex_);
+      if (cleanup_) {
+        return;
+      }
+      cleanup_ = true;
+    }
+
+    // Errors are not recoverable and happen in exceptional cases,
+    // ok to busy wait
+    while (processed_tasks_num_ != tasksNum()) {
     }
-  });
+
+    // Make sure all events are set, wait for scheduled events
+    finalizeEvents();
+
+    // Notify observers and waiters
+    finishRun();
+  }
 }
 
 void AsyncSchedulingNet::pollAndSchedule(int task_id) {
@@ -3,6 +3,8 @@
 
 #include "caffe2/core/net_async_base.h"
 
+#include <queue>
+
 namespace caffe2 {
 
 class AsyncSchedulingNet : public AsyncNetBase {
@@ -19,10 +21,36 @@ class AsyncSchedulingNet : public AsyncNetBase {
 
   void pollAndSchedule(int task_id);
   void schedule(int task_id);
+  void runTask(int task_id);
   void reset();
   virtual void finishRun();
   int updateParentCount(int child_id);
 
+  // Priority scheduling: the priority of a task is the cost of the longest
+  // path from its start to the end of the net, so that tasks on the critical
+  // path are dispatched before the others
+  void computePriorities();
+  float opCost(int op_id, const std::unordered_map<std::string, float>& costs)
+      const;
+  void runHighestPriorityTask(TaskThreadPool* task_pool);
+
+  struct ReadyTask {
+    float priority;
+    int task_id;
+    bool operator<(const ReadyTask& other) const {
+      // ties go to the task that comes first in the net
+      return priority < other.priority ||
+          (priority == other.priority && task_id > other.task_id);
+    }
+  };
+
+  bool use_priorities_;
+  std::vector<float> priorities_;
+  std::mutex ready_mutex_;
+  // ready tasks for each pool
+  std::unordered_map<TaskThreadPool*, std::priority_queue<ReadyTask>>
+      ready_tasks_;
+
   std::mutex running_mutex_;
   std::condition_variable running_cv_;
   std::atomic<bool> running_;
@@ -0,0 +1,305 @@
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/core/net_simple.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+CAFFE2_DEFINE_int(
+    caffe2_cuda_graph_warmup_runs,
+    2,
+    "Number of consecutive runs during which the blobs of a cuda_graph net "
+    "keep their shapes and memory, after which the net captures its operators "
+    "into a CUDA graph");
+
+namespace caffe2 {
+
+// CUDA graphs are captured in the thread local mode, in which synchronizing
+// with the host makes the capture fail instead of reading data the captured
+// kernels haven't written yet. It was introduced in CUDA 10.1.
+#if CUDA_VERSION >= 10010
+
+namespace {
+
+// What the kernels captured from a run of the operators depend on: the type,
+// shape and memory of every tensor they read or write.
+struct TensorState {
+  const Blob* blob;
+  TypeMeta meta;
+  vector<TIndex> dims;
+  const void* data;
+
+  bool operator==(const TensorState& other) const {
+    return blob == other.blob && meta == other.meta && dims == other.dims &&
+        data == other.data;
+  }
+};
+
+} // namespace
+
+/**
+ * CUDAGraphNet runs the operators of a net in order, like SimpleNet, until
+ * the tensors they use keep their shapes and memory for
+ * --caffe2_cuda_graph_warmup_runs runs. It then captures the kernels the
+ * operators launch into a CUDA graph, and from then on launches the whole
+ * graph in place of the operators, which saves the launch overhead of every
+ * kernel, e.g. for small batch inference.
+ *
+ * The graph reads and writes the memory the tensors had when it was
+ * captured. Inputs fed in place keep it. An external input replaced by a
+ * tensor of the same type and shape is copied into the captured memory, which
+ * the blob then shares. Any other change, such as an input of another shape,
+ * makes the net drop the graph and run the operators again, until it has been
+ * stable long enough to capture a new one.
+ *
+ * All the operators have to run on the same GPU, and their results may only
+ * depend on the tensors they use, not on host side state. Operators which
+ * synchronize with the host, or allocate or free GPU memory at every run,
+ * can't be captured; the net then keeps running the operators.
+ */
+class CUDAGraphNet : public SimpleNet {
+ public:
+  CUDAGraphNet(const std::shared_ptr<const NetDef>& net_def, Workspace* ws);
+  ~CUDAGraphNet() override;
+
+ protected:
+  bool Run() override;
+
+ private:
+  // Returns false if a blob doesn't hold a CUDA tensor.
+  bool GetTensorStates(vector<TensorState>* states) const;
+  bool Capture();
+  bool PrepareReplay();
+  void DropGraph();
+
+  Workspace* ws_;
+  int gpu_id_ = -1;
+  bool high_priority_ = false;
+  bool capturable_ = true;
+  // the input and output blobs of the operators, and which of them are read
+  // before any operator writes them
+  vector<const Blob*> blobs_;
+  vector<string> blob_names_;
+  vector<bool> is_external_input_;
+
+  vector<TensorState> last_states_;
+  int stable_runs_ = 0;
+
+  cudaGraphExec_t graph_exec_ = nullptr;
+  vector<TensorState> captured_states_;
+  // shares the captured memory of the external inputs, keeping it alive
+  vector<TensorCUDA> captured_inputs_;
+
+  DISABLE_COPY_AND_ASSIGN(CUDAGraphNet);
+};
+
+CUDAGraphNet::CUDAGraphNet(
+    const std::shared_ptr<const NetDef>& net_def,
+    Workspace* ws)
+    : SimpleNet(net_def, ws), ws_(ws) {
+  std::unordered_set<const Blob*> seen;
+  std::unordered_set<const Blob*> written;
+  for (auto& op : operators_) {
+    if (op->device_option().device_type() != CUDA ||
+        (gpu_id_ >= 0 &&
+         !IsSameDevice(op->device_option(), operators_[0]->device_option()))) {
+      LOG(INFO) << "Net " << name_ << " has operators which don't run on "
+                << "the same GPU, it won't be captured into a CUDA graph";
+      capturable_ = false;
+      return;
+    }
+    gpu_id_ = op->device_option().cuda_gpu_id();
+    high_priority_ = op->device_option().cuda_high_priority();
+    const auto& inputs = op->Inputs();
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      if (seen.insert(inputs[i]).second) {
+        blobs_.push_back(inputs[i]);
+        blob_names_.push_back(op->debug_def().input(i));
+        is_external_input_.push_back(!written.count(inputs[i]));
+      }
+    }
+    const auto& outputs = op->Outputs();
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      written.insert(outputs[i]);
+      if (seen.insert(outputs[i]).second) {
+        blobs_.push_back(outputs[i]);
+        blob_names_.push_back(op->debug_def().output(i));
+        is_external_input_.push_back(false);
+      }
+    }
+  }
+  capturable_ = !operators_.empty();
+}
+
+CUDAGraphNet::~CUDAGraphNet() {
+  DropGraph();
+}
+
+bool CUDAGraphNet::GetTensorStates(vector<TensorState>* states) const {
+  states->clear();
+  for (auto* blob : blobs_) {
+    if (!blob->IsType<TensorCUDA>()) {
+      return false;
+    }
+    const auto& tensor = blob->Get<TensorCUDA>();
+    states->push_back(
+        {blob,
+         tensor.meta(),
+         tensor.dims(),
+         tensor.size() > 0 ? tensor.raw_data() : nullptr});
+  }
+  return true;
+}
+
+bool CUDAGraphNet::Run() {
+  if (!capturable_) {
+    return SimpleNet::Run();
+  }
+  if (graph_exec_ && !PrepareReplay()) {
+    VLOG(1) << "The blobs of net " << name_ << " changed, dropping its graph";
+    DropGraph();
+  }
+  if (!graph_exec_ && stable_runs_ >= FLAGS_caffe2_cuda_graph_warmup_runs &&
+      !Capture()) {
+    LOG(WARNING) << "Net " << name_ << " couldn't be captured into a CUDA "
+                 << "graph, running its operators instead";
+    capturable_ = false;
+    return SimpleNet::Run();
+  }
+  if (graph_exec_) {
+    StartAllObservers();
+    DeviceGuard guard(gpu_id_);
+    cudaStream_t stream = CUDAContext::cuda_stream(gpu_id_, 0, high_priority_);
+    CUDA_ENFORCE(cudaGraphLaunch(graph_exec_, stream));
+    CUDA_ENFORCE(cudaStreamSynchronize(stream));
+    StopAllObservers();
+    return true;
+  }
+
+  if (!SimpleNet::Run()) {
+    stable_runs_ = 0;
+    return false;
+  }
+  vector<TensorState> states;
+  if (GetTensorStates(&states) && states == last_states_) {
+    ++stable_runs_;
+  } else {
+    stable_runs_ = 0;
+  }
+  last_states_ = std::move(states);
+  return true;
+}
+
+bool CUDAGraphNet::Capture() {
+  vector<TensorState> states;
+  if (!GetTensorStates(&states)) {
+    return false;
+  }
+  DeviceGuard guard(gpu_id_);
+  cudaStream_t stream = CUDAContext::cuda_stream(gpu_id_, 0, high_priority_);
+  // Nothing may be allocated while capturing: memory freed by then would be
+  // handed out again while the graph still uses it.
+  auto allocator_calls = CUDAContext::NumAllocatorCalls();
+  CUDA_ENFORCE(
+      cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal));
+  bool success = true;
+  try {
+    // RunAsync doesn't wait for the stream, which isn't allowed while
+    // capturing
+    for (auto& op : operators_) {
+      if (!op->RunAsync(0)) {
+        success = false;
+        break;
+      }
+    }
+  } catch (const std::exception& e) {
+    VLOG(1) << "Capture of net " << name_ << " failed: " << e.what();
+    success = false;
+  }
+  cudaGraph_t graph = nullptr;
+  cudaError_t error = cudaStreamEndCapture(stream, &graph);
+  // clear the error state left by kernels which failed to be captured
+  cudaGetLastError();
+  for (auto& op : operators_) {
+    op->ResetEvent();
+  }
+
+  vector<TensorState> captured_states;
+  success = success && error == cudaSuccess &&
+      CUDAContext::NumAllocatorCalls() == allocator_calls &&
+      GetTensorStates(&captured_states) && captured_states == states;
+  if (success) {
+    success = cudaGraphInstantiate(&graph_exec_, graph, nullptr, nullptr, 0) ==
+        cudaSuccess;
+  }
+  if (graph) {
+    cudaGraphDestroy(graph);
+  }
+  if (!success) {
+    graph_exec_ = nullptr;
+    cudaGetLastError();
+    return false;
+  }
+
+  captured_states_ = std::move(states);
+  captured_inputs_.clear();
+  for (size_t i = 0; i < blobs_.size(); ++i) {
+    if (is_external_input_[i]) {
+      const auto& tensor = blobs_[i]->Get<TensorCUDA>();
+      captured_inputs_.emplace_back();
+      captured_inputs_.back().ResizeLike(tensor);
+      captured_inputs_.back().ShareData(tensor);
+    }
+  }
+  return true;
+}
+
+bool CUDAGraphNet::PrepareReplay() {
+  size_t input = 0;
+  for (size_t i = 0; i < captured_states_.size(); ++i) {
+    const auto& state = captured_states_[i];
+    const Blob* blob = state.blob;
+    if (!blob->IsType<TensorCUDA>()) {
+      return false;
+    }
+    const auto& tensor = blob->Get<TensorCUDA>();
+    if (tensor.meta() != state.meta || tensor.dims() != state.dims) {
+      return false;
+    }
+    if (is_external_input_[i]) {
+      auto& captured = captured_inputs_[input++];
+      if (tensor.size() > 0 && tensor.raw_data() != state.data) {
+        CUDA_ENFORCE(cudaMemcpyAsync(
+            captured.raw_mutable_data(state.meta),
+            tensor.raw_data(),
+            tensor.nbytes(),
+            cudaMemcpyDeviceToDevice,
+            CUDAContext::cuda_stream(gpu_id_, 0, high_priority_)));
+        ws_->GetBlob(blob_names_[i])->GetMutable<TensorCUDA>()->ShareData(
+            captured);
+      }
+    } else if (tensor.size() > 0 && tensor.raw_data() != state.data) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void CUDAGraphNet::DropGraph() {
+  if (graph_exec_) {
+    cudaGraphExecDestroy(graph_exec_);
+    graph_exec_ = nullptr;
+  }
+  captured_states_.clear();
+  captured_inputs_.clear();
+  last_states_.clear();
+  stable_runs_ = 0;
+}
+
+REGISTER_NET(cuda_graph, CUDAGraphNet);
+
+#else // CUDA_VERSION >= 10010
+
+REGISTER_NET(cuda_graph, SimpleNet);
+
+#endif // CUDA_VERSION >= 10010
+
+} // namespace caffe2
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include "caffe2/core/common_gpu.h"
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Copies its input to its output on the operator's stream, which is all a
+// test needs from the work captured into a CUDA graph.
+class CUDAGraphTestCopyOp final : public Operator<CUDAContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CUDAContext);
+  using Operator<CUDAContext>::Operator;
+
+  bool RunOnDevice() override {
+    auto& input = Input(0);
+    auto* output = Output(0);
+    output->ResizeLike(input);
+    context_.CopyBytes<CUDAContext, CUDAContext>(
+        input.nbytes(),
+        input.raw_data(),
+        output->raw_mutable_data(input.meta()));
+    return true;
+  }
+};
+
+REGISTER_CUDA_OPERATOR(CUDAGraphTestCopy, CUDAGraphTestCopyOp);
+
+OPERATOR_SCHEMA(CUDAGraphTestCopy).NumInputs(1).NumOutputs(1);
+
+const char kCopyNet[] = R"DOC(
+  name: "copy"
+  type: "cuda_graph"
+  external_input: "in"
+  external_output: "out"
+  device_option {
+    device_type: 1
+  }
+  op {
+    input: "in"
+    output: "mid"
+    type: "CUDAGraphTestCopy"
+  }
+  op {
+    input: "mid"
+    output: "out"
+    type: "CUDAGraphTestCopy"
+  }
+)DOC";
+
+void FeedInput(Workspace* ws, const vector<float>& values) {
+  TensorCPU cpu(vector<TIndex>{static_cast<TIndex>(values.size())});
+  std::copy(values.begin(), values.end(), cpu.mutable_data<float>());
+  // copies into the tensor the blob already holds, if it has the same size
+  ws->GetBlob("in")->GetMutable<TensorCUDA>()->CopyFrom(cpu);
+}
+
+void CheckOutput(Workspace* ws, const vector<float>& expected) {
+  TensorCPU out(ws->GetBlob("out")->Get<TensorCUDA>());
+  ASSERT_EQ(out.size(), expected.size());
+  for (int i = 0; i < out.size(); ++i) {
+    EXPECT_EQ(out.data<float>()[i], expected[i]);
+  }
+}
+
+} // namespace
+
+TEST(CUDAGraphNetTest, RunsLikeSimpleNet) {
+  if (!HasCudaGPU()) {
+    return;
+  }
+  Workspace ws;
+  ws.CreateBlob("in");
+  NetDef net_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(kCopyNet, &net_def));
+  auto net = CreateNet(net_def, &ws);
+  ASSERT_TRUE(net != nullptr);
+
+  // enough runs to capture the net and replay it
+  for (int i = 0; i < 10; ++i) {
+    vector<float> values{1.0f * i, 2.0f * i, 3.0f * i};
+    FeedInput(&ws, values);
+    ASSERT_TRUE(net->Run());
+    CheckOutput(&ws, values);
+  }
+
+  // another shape drops the graph
+  for (int i = 0; i < 10; ++i) {
+    vector<float> values{1.0f * i, 2.0f * i, 3.0f * i, 4.0f * i, 5.0f * i};
+    FeedInput(&ws, values);
+    ASSERT_TRUE(net->Run());
+    CheckOutput(&ws, values);
+  }
+
+  // a new tensor of the same shape is copied into the captured input
+  for (int i = 0; i < 10; ++i) {
+    vector<float> values{-1.0f * i, -2.0f * i, -3.0f * i, -4.0f * i, 5.0f};
+    ws.GetBlob("in")->Reset(new TensorCUDA());
+    FeedInput(&ws, values);
+    ASSERT_TRUE(net->Run());
+    CheckOutput(&ws, values);
+  }
+}
+
+} // namespace caffe2
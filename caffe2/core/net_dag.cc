@@ -335,19 +335,10 @@ vector<float> DAGNetBase::TEST_Benchmark(
 
 bool DAGNet::RunAt(int chain_id, const std::vector<int>& chain) {
   for (const auto i : chain) {
-#ifdef CAFFE2_ENABLE_SDT
-    const auto& op_name =
-        operator_nodes_[i].operator_->debug_def().name().c_str();
-    const auto& op_type =
-        operator_nodes_[i].operator_->debug_def().type().c_str();
-    auto* op_ptr = operator_nodes_[i].operator_.get();
-    const auto& net_name = name_.c_str();
-    CAFFE_SDT(operator_start, net_name, op_name, op_type, op_ptr);
-#endif
-    const auto success = operator_nodes_[i].operator_->Run();
-#ifdef CAFFE2_ENABLE_SDT
-    CAFFE_SDT(operator_done, net_name, op_name, op_type, op_ptr);
-#endif
+    auto* op = operator_nodes_[i].operator_.get();
+    CAFFE_SDT_OPERATOR(operator_start, name_, op);
+    const auto success = op->Run();
+    CAFFE_SDT_OPERATOR(operator_done, name_, op);
     if (!success) {
       return false;
     }
@@ -0,0 +1,474 @@
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace caffe2 {
+
+namespace {
+
+struct PipelineStageStats {
+  CAFFE_STAT_CTOR(PipelineStageStats);
+  // time the stage's GPU spent running the stage's operators in a run
+  CAFFE_AVG_EXPORTED_STAT(busy_time_us);
+  // busy time in percent of the wall time of the run
+  CAFFE_AVG_EXPORTED_STAT(utilization_percent);
+};
+
+// Splits n rows into num micro-batches whose sizes differ by at most one,
+// and returns the [begin, end) rows of micro-batch m.
+std::pair<TIndex, TIndex> MicroBatchRows(TIndex n, int num, int m) {
+  const TIndex size = n / num;
+  const TIndex rest = n % num;
+  const TIndex begin = m * size + std::min<TIndex>(m, rest);
+  return std::make_pair(begin, begin + size + (m < rest ? 1 : 0));
+}
+
+template <class Context>
+void CopyRows(
+    const Tensor<Context>& src,
+    TIndex begin,
+    TIndex end,
+    TensorCUDA* dst,
+    CUDAContext* context) {
+  auto dims = src.dims();
+  dims[0] = end - begin;
+  dst->Resize(dims);
+  const size_t row_bytes = src.size_from_dim(1) * src.itemsize();
+  context->CopyBytes<Context, CUDAContext>(
+      (end - begin) * row_bytes,
+      static_cast<const char*>(src.raw_data()) + begin * row_bytes,
+      dst->raw_mutable_data(src.meta()));
+}
+
+} // namespace
+
+/**
+ * PipelineNet runs a net which is too big for one GPU on several GPUs of the
+ * process, as a pipeline. The operators are split into stages at the cut
+ * points given by the net's arguments, and each stage runs on its own GPU.
+ * The micro-batched inputs are split along their first dimension, and the
+ * micro-batches stream through the stages: while a stage runs micro-batch m,
+ * the previous stage already runs micro-batch m + 1.
+ *
+ * Net arguments:
+ *   pipeline_cut_points (ints) the indices of the operators starting the
+ *     second, third, ... stage, in increasing order.
+ *   pipeline_devices (ints) the GPU of each stage, by default stage i runs
+ *     on GPU i.
+ *   num_micro_batches (int, default 1) how many micro-batches a run is split
+ *     into, at most one per row of the inputs.
+ *   micro_batch_inputs (strings) the external inputs which are split into
+ *     micro-batches, CPU or CUDA tensors with the same first dimension. The
+ *     other external inputs, e.g. the weights, are read from the workspace
+ *     as they are, and have to live on the GPU of the stage which reads them.
+ *
+ * Every stage runs its operators on stream 0 of its GPU. The blobs a stage
+ * reads from an earlier stage, and its micro-batch of the inputs, are copied
+ * to its GPU on stream 1, with peer to peer copies where the GPUs support
+ * them. Each stage and micro-batch has its own child workspace, so the
+ * intermediate blobs of micro-batches in flight don't overwrite each other;
+ * the external outputs are concatenated along their first dimension into the
+ * net's workspace, on the GPU of the stage which produces them.
+ *
+ * All operators have to run on CUDA, and all blobs passed between stages
+ * have to be CUDA tensors. Like any other net, it can be used as the
+ * predict net of a Predictor.
+ *
+ * Exports the GPU busy time and the utilization of every stage as the stats
+ * pipeline_net/stats/<net name>/stage_<i>/...
+ */
+class PipelineNet : public NetBase {
+ public:
+  PipelineNet(const std::shared_ptr<const NetDef>& net_def, Workspace* ws);
+  ~PipelineNet() override;
+
+  bool SupportsAsync() override {
+    return false;
+  }
+
+  vector<OperatorBase*> GetOperators() const override;
+
+ protected:
+  bool Run() override;
+  bool RunAsync() override {
+    return Run();
+  }
+
+ private:
+  struct Stage {
+    explicit Stage(const string& stats_name) : stats(stats_name) {}
+
+    DeviceOption option;
+    // the blobs the stage reads from an earlier stage, and that stage
+    vector<std::pair<string, int>> boundary_inputs;
+    vector<string> micro_batch_inputs;
+    // one per micro-batch; the operators are destroyed before their
+    // workspace
+    vector<unique_ptr<Workspace>> workspaces;
+    vector<vector<unique_ptr<OperatorBase>>> operators;
+    vector<cudaEvent_t> inputs_copied;
+    vector<cudaEvent_t> started;
+    vector<cudaEvent_t> finished;
+    // copies the inputs of the stage to its GPU, on stream 1
+    unique_ptr<CUDAContext> copy_context;
+    PipelineStageStats stats;
+  };
+
+  void CopyInputs(int stage_id, int micro_batch, TIndex rows, int num);
+  bool RunStage(int stage_id, int micro_batch);
+  void GatherOutputs(int num);
+
+  Workspace* ws_;
+  int num_micro_batches_;
+  vector<string> micro_batch_inputs_;
+  // the external outputs, and the stages producing them
+  vector<std::pair<string, int>> outputs_;
+  vector<unique_ptr<Stage>> stages_;
+
+  DISABLE_COPY_AND_ASSIGN(PipelineNet);
+};
+
+PipelineNet::PipelineNet(
+    const std::shared_ptr<const NetDef>& net_def,
+    Workspace* ws)
+    : NetBase(net_def, ws), ws_(ws) {
+  ArgumentHelper helper(*net_def);
+  auto cut_points = helper.GetRepeatedArgument<int>("pipeline_cut_points");
+  auto devices = helper.GetRepeatedArgument<int>("pipeline_devices");
+  num_micro_batches_ = helper.GetSingleArgument<int>("num_micro_batches", 1);
+  micro_batch_inputs_ =
+      helper.GetRepeatedArgument<string>("micro_batch_inputs");
+  CAFFE_ENFORCE_GT(num_micro_batches_, 0);
+
+  const int num_stages = cut_points.size() + 1;
+  if (devices.empty()) {
+    for (int i = 0; i < num_stages; ++i) {
+      devices.push_back(i);
+    }
+  }
+  CAFFE_ENFORCE_EQ(
+      devices.size(),
+      static_cast<size_t>(num_stages),
+      "pipeline_devices needs one GPU per stage of net ",
+      name_);
+  cut_points.push_back(net_def->op_size());
+  for (int i = 0; i < num_stages; ++i) {
+    CAFFE_ENFORCE_LT(
+        i == 0 ? 0 : cut_points[i - 1],
+        cut_points[i],
+        "pipeline_cut_points have to be increasing and leave at least one "
+        "operator in every stage");
+    CAFFE_ENFORCE_LT(devices[i], NumCudaDevices());
+  }
+
+  std::unordered_set<string> batch_inputs(
+      micro_batch_inputs_.begin(), micro_batch_inputs_.end());
+  for (const auto& input : micro_batch_inputs_) {
+    CAFFE_ENFORCE(
+        std::find(external_input_.begin(), external_input_.end(), input) !=
+            external_input_.end(),
+        "Micro-batch input ",
+        input,
+        " is not an external input of net ",
+        name_);
+  }
+
+  // the stage which last wrote each blob
+  std::unordered_map<string, int> producers;
+  int op_idx = 0;
+  for (int stage_id = 0; stage_id < num_stages; ++stage_id) {
+    stages_.emplace_back(caffe2::make_unique<Stage>(
+        "pipeline_net/stats/" + name_ + "/stage_" +
+        caffe2::to_string(stage_id)));
+    auto& stage = *stages_.back();
+    if (net_def->has_device_option()) {
+      stage.option.CopyFrom(net_def->device_option());
+    }
+    stage.option.set_device_type(CUDA);
+    stage.option.set_cuda_gpu_id(devices[stage_id]);
+
+    vector<std::pair<OperatorDef, int>> op_defs;
+    std::unordered_set<string> written;
+    std::unordered_set<string> locals;
+    for (; op_idx < cut_points[stage_id]; ++op_idx) {
+      OperatorDef op_def(net_def->op(op_idx));
+      CAFFE_ENFORCE(
+          !op_def.has_device_option() ||
+              op_def.device_option().device_type() == CUDA,
+          "Operator ",
+          op_def.type(),
+          " of net ",
+          name_,
+          " doesn't run on CUDA, which the pipeline net requires");
+      DeviceOption option(stage.option);
+      option.MergeFrom(op_def.device_option());
+      option.set_cuda_gpu_id(devices[stage_id]);
+      op_def.mutable_device_option()->CopyFrom(option);
+      for (const auto& input : op_def.input()) {
+        if (locals.count(input)) {
+          continue;
+        }
+        auto producer = producers.find(input);
+        if (producer != producers.end()) {
+          stage.boundary_inputs.emplace_back(input, producer->second);
+          locals.insert(input);
+        } else if (batch_inputs.count(input)) {
+          stage.micro_batch_inputs.push_back(input);
+          locals.insert(input);
+        }
+      }
+      for (const auto& output : op_def.output()) {
+        written.insert(output);
+        locals.insert(output);
+      }
+      op_defs.emplace_back(std::move(op_def), op_idx);
+    }
+    for (const auto& output : written) {
+      producers[output] = stage_id;
+    }
+
+    DeviceGuard g(devices[stage_id]);
+    for (int m = 0; m < num_micro_batches_; ++m) {
+      stage.workspaces.emplace_back(new Workspace(ws));
+      auto* stage_ws = stage.workspaces.back().get();
+      // keeps the blobs of the micro-batch apart from the ones of the same
+      // name in the net's workspace
+      for (const auto& blob : locals) {
+        stage_ws->CreateLocalBlob(blob);
+      }
+      stage.operators.emplace_back();
+      for (const auto& op_def : op_defs) {
+        stage.operators.back().push_back(
+            CreateOperator(op_def.first, stage_ws, op_def.second));
+      }
+
+      cudaEvent_t event;
+      CUDA_ENFORCE(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+      stage.inputs_copied.push_back(event);
+      CUDA_ENFORCE(cudaEventCreate(&event));
+      stage.started.push_back(event);
+      CUDA_ENFORCE(cudaEventCreate(&event));
+      stage.finished.push_back(event);
+    }
+    stage.copy_context = caffe2::make_unique<CUDAContext>(stage.option);
+  }
+
+  for (const auto& output : external_output_) {
+    auto producer = producers.find(output);
+    CAFFE_ENFORCE(
+        producer != producers.end(),
+        "External output ",
+        output,
+        " of net ",
+        name_,
+        " isn't written by any operator");
+    outputs_.emplace_back(output, producer->second);
+  }
+}
+
+PipelineNet::~PipelineNet() {
+  for (auto& stage : stages_) {
+    DeviceGuard g(stage->option.cuda_gpu_id());
+    for (auto* events :
+         {&stage->inputs_copied, &stage->started, &stage->finished}) {
+      for (auto event : *events) {
+        CUDA_CHECK(cudaEventDestroy(event));
+      }
+    }
+  }
+}
+
+vector<OperatorBase*> PipelineNet::GetOperators() const {
+  vector<OperatorBase*> op_list;
+  for (const auto& stage : stages_) {
+    for (const auto& ops : stage->operators) {
+      for (const auto& op : ops) {
+        op_list.push_back(op.get());
+      }
+    }
+  }
+  return op_list;
+}
+
+void PipelineNet::CopyInputs(
+    int stage_id,
+    int micro_batch,
+    TIndex rows,
+    int num) {
+  auto& stage = *stages_[stage_id];
+  auto* context = stage.copy_context.get();
+  context->SwitchToDevice(1);
+  auto* stage_ws = stage.workspaces[micro_batch].get();
+
+  for (const auto& input : stage.boundary_inputs) {
+    const auto& producer = *stages_[input.second];
+    CUDA_ENFORCE(cudaStreamWaitEvent(
+        context->cuda_stream(), producer.finished[micro_batch], 0));
+    const auto* src_blob =
+        producer.workspaces[micro_batch]->GetBlob(input.first);
+    CAFFE_ENFORCE(
+        src_blob->IsType<TensorCUDA>(),
+        "Blob ",
+        input.first,
+        " passed between stages of pipeline net ",
+        name_,
+        " is not a CUDA tensor");
+    const auto& src = src_blob->Get<TensorCUDA>();
+    auto* dst = stage_ws->GetBlob(input.first)->GetMutable<TensorCUDA>();
+    dst->ResizeLike(src);
+    context->CopyBytes<CUDAContext, CUDAContext>(
+        src.nbytes(), src.raw_data(), dst->raw_mutable_data(src.meta()));
+  }
+
+  const auto range = MicroBatchRows(rows, num, micro_batch);
+  for (const auto& input : stage.micro_batch_inputs) {
+    const auto* src_blob = ws_->GetBlob(input);
+    auto* dst = stage_ws->GetBlob(input)->GetMutable<TensorCUDA>();
+    if (src_blob->IsType<TensorCPU>()) {
+      CopyRows(
+          src_blob->Get<TensorCPU>(), range.first, range.second, dst, context);
+    } else {
+      CopyRows(
+          src_blob->Get<TensorCUDA>(), range.first, range.second, dst, context);
+    }
+  }
+  CUDA_ENFORCE(cudaEventRecord(
+      stage.inputs_copied[micro_batch], context->cuda_stream()));
+}
+
+bool PipelineNet::RunStage(int stage_id, int micro_batch) {
+  auto& stage = *stages_[stage_id];
+  DeviceGuard g(stage.option.cuda_gpu_id());
+  auto stream = CUDAContext::cuda_stream(
+      stage.option.cuda_gpu_id(), 0, stage.option.cuda_high_priority());
+  CUDA_ENFORCE(
+      cudaStreamWaitEvent(stream, stage.inputs_copied[micro_batch], 0));
+  CUDA_ENFORCE(cudaEventRecord(stage.started[micro_batch], stream));
+  for (auto& op : stage.operators[micro_batch]) {
+    CAFFE_SDT_OPERATOR(operator_start, name_, op.get());
+    // the operator's event was recorded by the previous run
+    op->ResetEvent();
+    bool res = op->RunAsync(0);
+    CAFFE_SDT_OPERATOR(operator_done, name_, op.get());
+    if (!res) {
+      LOG(ERROR) << "Operator failed: " << ProtoDebugString(op->debug_def());
+      return false;
+    }
+  }
+  CUDA_ENFORCE(cudaEventRecord(stage.finished[micro_batch], stream));
+  return true;
+}
+
+void PipelineNet::GatherOutputs(int num) {
+  for (const auto& output : outputs_) {
+    auto& stage = *stages_[output.second];
+    auto* context = stage.copy_context.get();
+    context->SwitchToDevice(1);
+
+    vector<const TensorCUDA*> parts;
+    TIndex rows = 0;
+    for (int m = 0; m < num; ++m) {
+      CUDA_ENFORCE(
+          cudaStreamWaitEvent(context->cuda_stream(), stage.finished[m], 0));
+      parts.push_back(&stage.workspaces[m]
+                           ->GetBlob(output.first)
+                           ->Get<TensorCUDA>());
+      CAFFE_ENFORCE_GT(parts.back()->ndim(), 0);
+      CAFFE_ENFORCE(parts.back()->meta() == parts[0]->meta());
+      CAFFE_ENFORCE_EQ(
+          parts.back()->size_from_dim(1),
+          parts[0]->size_from_dim(1),
+          "The micro-batches of output ",
+          output.first,
+          " have different shapes");
+      rows += parts.back()->dim(0);
+    }
+
+    auto dims = parts[0]->dims();
+    dims[0] = rows;
+    auto* dst = ws_->CreateBlob(output.first)->GetMutable<TensorCUDA>();
+    dst->Resize(dims);
+    auto* data = static_cast<char*>(dst->raw_mutable_data(parts[0]->meta()));
+    for (const auto* part : parts) {
+      context->CopyBytes<CUDAContext, CUDAContext>(
+          part->nbytes(), part->raw_data(), data);
+      data += part->nbytes();
+    }
+  }
+}
+
+bool PipelineNet::Run() {
+  StartAllObservers();
+  VLOG(1) << "Running net " << name_;
+  Timer timer;
+
+  TIndex rows = 0;
+  int num = 1;
+  for (const auto& input : micro_batch_inputs_) {
+    const auto* blob = ws_->GetBlob(input);
+    CAFFE_ENFORCE(blob, "Micro-batch input ", input, " doesn't exist");
+    const auto dim0 = blob->IsType<TensorCPU>()
+        ? blob->Get<TensorCPU>().dim(0)
+        : blob->Get<TensorCUDA>().dim(0);
+    CAFFE_ENFORCE(
+        input == micro_batch_inputs_[0] || dim0 == rows,
+        "Micro-batch inputs of net ",
+        name_,
+        " have different first dimensions");
+    rows = dim0;
+  }
+  if (!micro_batch_inputs_.empty()) {
+    CAFFE_ENFORCE_GT(rows, 0, "Net ", name_, " got an empty batch");
+    num = std::min<TIndex>(num_micro_batches_, rows);
+  }
+
+  // stage i runs micro-batch t - i in step t; the stages only synchronize
+  // through CUDA events, so the host issues the work of all of them ahead
+  const int num_stages = stages_.size();
+  for (int t = 0; t < num + num_stages - 1; ++t) {
+    for (int stage_id = 0; stage_id < num_stages; ++stage_id) {
+      const int m = t - stage_id;
+      if (m < 0 || m >= num) {
+        continue;
+      }
+      CopyInputs(stage_id, m, rows, num);
+      if (!RunStage(stage_id, m)) {
+        return false;
+      }
+    }
+  }
+  GatherOutputs(num);
+
+  for (auto& stage : stages_) {
+    stage->copy_context->FinishDeviceComputation();
+    CUDA_ENFORCE(cudaEventSynchronize(stage->finished[num - 1]));
+  }
+  const float run_time_ms = timer.MilliSeconds();
+  for (auto& stage : stages_) {
+    float busy_ms = 0;
+    for (int m = 0; m < num; ++m) {
+      float ms;
+      CUDA_ENFORCE(
+          cudaEventElapsedTime(&ms, stage->started[m], stage->finished[m]));
+      busy_ms += ms;
+    }
+    CAFFE_EVENT(stage->stats, busy_time_us, busy_ms * 1000);
+    CAFFE_EVENT(
+        stage->stats, utilization_percent, 100 * busy_ms / run_time_ms);
+  }
+
+  StopAllObservers();
+  return true;
+}
+
+REGISTER_NET(pipeline, PipelineNet);
+
+} // namespace caffe2
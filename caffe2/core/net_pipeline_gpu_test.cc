@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include "caffe2/core/common_gpu.h"
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Copies its input to its output on the operator's stream.
+class PipelineTestCopyOp final : public Operator<CUDAContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CUDAContext);
+  using Operator<CUDAContext>::Operator;
+
+  bool RunOnDevice() override {
+    auto& input = Input(0);
+    auto* output = Output(0);
+    output->ResizeLike(input);
+    context_.CopyBytes<CUDAContext, CUDAContext>(
+        input.nbytes(),
+        input.raw_data(),
+        output->raw_mutable_data(input.meta()));
+    return true;
+  }
+};
+
+REGISTER_CUDA_OPERATOR(PipelineTestCopy, PipelineTestCopyOp);
+
+OPERATOR_SCHEMA(PipelineTestCopy).NumInputs(1).NumOutputs(1);
+
+const char kPipelineNet[] = R"DOC(
+  name: "pipeline_test"
+  type: "pipeline"
+  external_input: "in"
+  external_output: "out"
+  arg {
+    name: "pipeline_cut_points"
+    ints: 1
+    ints: 2
+  }
+  arg {
+    name: "num_micro_batches"
+    i: 3
+  }
+  arg {
+    name: "micro_batch_inputs"
+    strings: "in"
+  }
+  op {
+    input: "in"
+    output: "a"
+    type: "PipelineTestCopy"
+  }
+  op {
+    input: "a"
+    output: "b"
+    type: "PipelineTestCopy"
+  }
+  op {
+    input: "b"
+    output: "out"
+    type: "PipelineTestCopy"
+  }
+)DOC";
+
+} // namespace
+
+TEST(PipelineNetTest, RunsLikeSimpleNet) {
+  if (!HasCudaGPU()) {
+    return;
+  }
+  Workspace ws;
+  NetDef net_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(kPipelineNet, &net_def));
+  // spread the stages over the GPUs there are
+  auto* devices = net_def.add_arg();
+  devices->set_name("pipeline_devices");
+  for (int i = 0; i < 3; ++i) {
+    devices->add_ints(i % NumCudaDevices());
+  }
+
+  auto* in = ws.CreateBlob("in")->GetMutable<TensorCPU>();
+  auto net = CreateNet(net_def, &ws);
+  ASSERT_TRUE(net != nullptr);
+
+  // fewer rows than micro-batches, rows which don't split evenly
+  for (int rows : {2, 7, 9}) {
+    in->Resize(rows, 2);
+    for (int i = 0; i < in->size(); ++i) {
+      in->mutable_data<float>()[i] = i;
+    }
+    ASSERT_TRUE(net->Run());
+    TensorCPU out(ws.GetBlob("out")->Get<TensorCUDA>());
+    EXPECT_EQ(out.dims(), in->dims());
+    for (int i = 0; i < out.size(); ++i) {
+      EXPECT_EQ(out.data<float>()[i], i);
+    }
+  }
+
+  bool reported = false;
+  for (const auto& stat : StatRegistry::get().publish()) {
+    if (stat.key ==
+        "pipeline_net/stats/pipeline_test/stage_2/utilization_percent/count") {
+      EXPECT_EQ(stat.value, 3);
+      reported = true;
+    }
+  }
+  EXPECT_TRUE(reported);
+}
+
+} // namespace caffe2
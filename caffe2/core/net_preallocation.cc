@@ -0,0 +1,154 @@
+#include "caffe2/core/net_preallocation.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "caffe2/core/operator_schema.h"
+#include "caffe2/core/types.h"
+
+CAFFE2_DEFINE_bool(
+    caffe2_net_preallocate_outputs,
+    false,
+    "If set, SimpleNet and the async nets reserve the CPU outputs of their "
+    "operators at the sizes inferred from the shapes of their inputs before "
+    "every run");
+CAFFE2_DEFINE_int(
+    caffe2_net_preallocation_max_plans,
+    16,
+    "Maximum number of input shape signatures a net caches the sizes of "
+    "its outputs for");
+
+namespace caffe2 {
+
+NetOutputPreallocator::NetOutputPreallocator(
+    const std::vector<OperatorBase*>& operators)
+    : operators_(operators) {
+  std::unordered_set<const Blob*> seen;
+  for (auto* op : operators_) {
+    for (const auto* blob : op->Inputs()) {
+      if (seen.insert(blob).second) {
+        inputs_.push_back(blob);
+      }
+    }
+    for (const auto* blob : op->Outputs()) {
+      seen.insert(blob);
+    }
+  }
+}
+
+std::vector<TIndex> NetOutputPreallocator::Signature() const {
+  std::vector<TIndex> signature;
+  for (const auto* blob : inputs_) {
+    signature.push_back(blob->meta().id());
+    if (blob->IsType<TensorCPU>()) {
+      const auto& tensor = blob->Get<TensorCPU>();
+      signature.push_back(tensor.meta().id());
+      signature.push_back(tensor.ndim());
+      signature.insert(
+          signature.end(), tensor.dims().begin(), tensor.dims().end());
+    }
+  }
+  return signature;
+}
+
+NetOutputPreallocator::Plan NetOutputPreallocator::MakePlan() const {
+  std::unordered_map<const Blob*, TensorShape> shapes;
+  for (const auto* blob : inputs_) {
+    shapes[blob] = GetTensorShapeOfBlob(blob);
+  }
+  // the largest size every output is going to have during the run
+  std::unordered_map<Blob*, size_t> reservations;
+  Plan plan;
+  for (auto* op : operators_) {
+    const auto& def = op->debug_def();
+    const auto* schema = OpSchemaRegistry::Schema(def.type());
+    std::vector<TensorShape> input_shapes;
+    bool known = schema != nullptr;
+    for (const auto* blob : op->Inputs()) {
+      auto it = shapes.find(blob);
+      if (it == shapes.end() || it->second.unknown_shape()) {
+        known = false;
+        break;
+      }
+      input_shapes.push_back(it->second);
+    }
+    std::vector<TensorShape> output_shapes;
+    if (known) {
+      try {
+        output_shapes = schema->InferTensor(def, input_shapes);
+      } catch (const std::exception& e) {
+        VLOG(1) << "Shape inference failed for " << def.type() << ": "
+                << e.what();
+      }
+    }
+    const bool on_cpu = op->device_option().device_type() == CPU;
+    for (int i = 0; i < op->OutputSize(); ++i) {
+      Blob* blob = op->Outputs()[i];
+      if (i >= static_cast<int>(output_shapes.size())) {
+        TensorShape unknown;
+        unknown.set_unknown_shape(true);
+        shapes[blob] = unknown;
+        continue;
+      }
+      const auto& shape = output_shapes[i];
+      shapes[blob] = shape;
+      if (!on_cpu || shape.unknown_shape() ||
+          shape.data_type() == TensorProto_DataType_UNDEFINED ||
+          shape.data_type() == TensorProto_DataType_STRING) {
+        continue;
+      }
+      Reservation reservation{blob, DataTypeToTypeMeta(shape.data_type()), {}};
+      TIndex size = 1;
+      for (auto d : shape.dims()) {
+        reservation.dims.push_back(d);
+        size *= d;
+      }
+      if (size <= 0) {
+        continue;
+      }
+      const size_t nbytes = size * reservation.meta.itemsize();
+      auto it = reservations.find(blob);
+      if (it == reservations.end()) {
+        reservations[blob] = plan.size();
+        plan.push_back(std::move(reservation));
+      } else {
+        auto& planned = plan[it->second];
+        const size_t planned_nbytes =
+            size_from_dim_(0, planned.dims) * planned.meta.itemsize();
+        if (planned.meta == reservation.meta && nbytes > planned_nbytes) {
+          planned.dims = std::move(reservation.dims);
+        }
+      }
+    }
+  }
+  return plan;
+}
+
+void NetOutputPreallocator::Preallocate() {
+  auto signature = Signature();
+  auto it = plans_.find(signature);
+  if (it == plans_.end()) {
+    if (plans_.size() >=
+        static_cast<size_t>(FLAGS_caffe2_net_preallocation_max_plans)) {
+      plans_.clear();
+    }
+    it = plans_.emplace(std::move(signature), MakePlan()).first;
+  }
+  for (const auto& reservation : it->second) {
+    Blob* blob = reservation.blob;
+    if (!blob->IsType<TensorCPU>() && blob->meta() != TypeMeta()) {
+      continue;
+    }
+    auto* tensor = blob->GetMutable<TensorCPU>();
+    if (tensor->meta() != reservation.meta) {
+      if (tensor->size() > 0) {
+        continue;
+      }
+      tensor->Resize(reservation.dims);
+      tensor->raw_mutable_data(reservation.meta);
+    }
+    tensor->Reserve(reservation.dims, &context_);
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,58 @@
+#ifndef CAFFE2_CORE_NET_PREALLOCATION_H_
+#define CAFFE2_CORE_NET_PREALLOCATION_H_
+
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+
+CAFFE2_DECLARE_bool(caffe2_net_preallocate_outputs);
+CAFFE2_DECLARE_int(caffe2_net_preallocation_max_plans);
+
+namespace caffe2 {
+
+/**
+ * Reserves the CPU outputs of the operators of a net at the sizes they are
+ * going to have before the net runs, so that operators resizing them find
+ * enough memory instead of reallocating it, e.g. when the batch size of the
+ * inputs goes up and down between runs.
+ *
+ * The sizes come from the shape inference functions of the operator schemas,
+ * run once for every signature (types and shapes) of the tensors the net
+ * reads without producing them. The resulting plans are cached, up to
+ * --caffe2_net_preallocation_max_plans of them. Outputs whose shape or type
+ * cannot be inferred are left alone, and so are blobs holding anything but a
+ * CPU tensor, or a tensor of another type with data in it.
+ *
+ * SimpleNet and the async nets use one when --caffe2_net_preallocate_outputs
+ * is set.
+ */
+class NetOutputPreallocator {
+ public:
+  explicit NetOutputPreallocator(const std::vector<OperatorBase*>& operators);
+
+  // Reserves the outputs for the current shapes of the inputs of the net.
+  void Preallocate();
+
+ private:
+  struct Reservation {
+    Blob* blob;
+    TypeMeta meta;
+    std::vector<TIndex> dims;
+  };
+  typedef std::vector<Reservation> Plan;
+
+  std::vector<TIndex> Signature() const;
+  Plan MakePlan() const;
+
+  std::vector<OperatorBase*> operators_;
+  // the blobs read by the net before any of its operators writes them
+  std::vector<const Blob*> inputs_;
+  CaffeMap<std::vector<TIndex>, Plan> plans_;
+  CPUContext context_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_NET_PREALLOCATION_H_
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/net_preallocation.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/scope_guard.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Records whether its output already had the memory it needs when it ran.
+class PreallocationTestOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  using Operator<CPUContext>::Operator;
+
+  bool RunOnDevice() override {
+    const auto& X = Input(0);
+    auto* Y = Output(0);
+    const void* data = Y->raw_data();
+    Y->ResizeLike(X);
+    float* out = Y->mutable_data<float>();
+    reused_ = data != nullptr && out == data;
+    for (int i = 0; i < X.size(); ++i) {
+      out[i] = X.data<float>()[i] + 1;
+    }
+    return true;
+  }
+
+  static bool reused_;
+};
+
+bool PreallocationTestOp::reused_ = false;
+
+OPERATOR_SCHEMA(PreallocationTest)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .IdenticalTypeAndShape();
+REGISTER_CPU_OPERATOR(PreallocationTest, PreallocationTestOp);
+
+void FillInput(Workspace* ws, TIndex batch_size) {
+  auto* X = ws->CreateBlob("X")->GetMutable<TensorCPU>();
+  X->Resize(batch_size, 3);
+  for (int i = 0; i < X->size(); ++i) {
+    X->mutable_data<float>()[i] = i;
+  }
+}
+
+NetDef PreallocationTestNet(const string& type) {
+  NetDef net_def;
+  net_def.set_name("preallocation");
+  net_def.set_type(type);
+  auto* op = net_def.add_op();
+  op->set_type("PreallocationTest");
+  op->add_input("X");
+  op->add_output("Y");
+  return net_def;
+}
+
+} // namespace
+
+TEST(NetPreallocationTest, ReservesOutputs) {
+  auto saved = FLAGS_caffe2_net_preallocate_outputs;
+  auto restore =
+      MakeGuard([saved] { FLAGS_caffe2_net_preallocate_outputs = saved; });
+  FLAGS_caffe2_net_preallocate_outputs = true;
+  for (const string& type : {"simple", "async_scheduling"}) {
+    Workspace ws;
+    FillInput(&ws, 2);
+    auto net = CreateNet(PreallocationTestNet(type), &ws);
+    ASSERT_TRUE(net != nullptr);
+    for (TIndex batch_size : {2, 8, 4, 16}) {
+      FillInput(&ws, batch_size);
+      ASSERT_TRUE(net->Run());
+      EXPECT_TRUE(PreallocationTestOp::reused_) << type << " " << batch_size;
+      const auto& Y = ws.GetBlob("Y")->Get<TensorCPU>();
+      EXPECT_EQ(Y.dim(0), batch_size);
+      EXPECT_EQ(Y.data<float>()[Y.size() - 1], Y.size());
+    }
+  }
+}
+
+TEST(NetPreallocationTest, SkipsOtherBlobs) {
+  Workspace ws;
+  FillInput(&ws, 4);
+  *ws.CreateBlob("Y")->GetMutable<int>() = 5;
+  auto net = CreateNet(PreallocationTestNet("simple"), &ws);
+  ASSERT_TRUE(net != nullptr);
+  NetOutputPreallocator preallocator(net->GetOperators());
+  preallocator.Preallocate();
+  EXPECT_EQ(ws.GetBlob("Y")->Get<int>(), 5);
+
+  ws.GetBlob("Y")->GetMutable<TensorCPU>();
+  preallocator.Preallocate();
+  const auto& Y = ws.GetBlob("Y")->Get<TensorCPU>();
+  EXPECT_GE(Y.capacity_nbytes(), 4 * 3 * sizeof(float));
+}
+
+} // namespace caffe2
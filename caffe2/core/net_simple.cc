@@ -40,25 +40,23 @@ SimpleNet::SimpleNet(
     }
     operators_.emplace_back(std::move(op));
   }
+  if (FLAGS_caffe2_net_preallocate_outputs) {
+    preallocator_ = caffe2::make_unique<NetOutputPreallocator>(GetOperators());
+  }
 }
 
 bool SimpleNet::Run() {
   StartAllObservers();
   VLOG(1) << "Running net " << name_;
+  if (preallocator_) {
+    preallocator_->Preallocate();
+  }
   for (auto& op : operators_) {
     VLOG(1) << "Running operator " << op->debug_def().name() << "("
             << op->debug_def().type() << ").";
-#ifdef CAFFE2_ENABLE_SDT
-    const auto& op_name = op->debug_def().name().c_str();
-    const auto& op_type = op->debug_def().type().c_str();
-    auto* op_ptr = op.get();
-    const auto& net_name = name_.c_str();
-    CAFFE_SDT(operator_start, net_name, op_name, op_type, op_ptr);
-#endif
+    CAFFE_SDT_OPERATOR(operator_start, name_, op.get());
     bool res = op->Run();
-#ifdef CAFFE2_ENABLE_SDT
-    CAFFE_SDT(operator_done, net_name, op_name, op_type, op_ptr);
-#endif
+    CAFFE_SDT_OPERATOR(operator_done, name_, op.get());
     if (!res) {
       LOG(ERROR) << "Operator failed: " << ProtoDebugString(op->debug_def());
       return false;
@@ -6,6 +6,7 @@
 #include "caffe2/core/common.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/net.h"
+#include "caffe2/core/net_preallocation.h"
 #include "caffe2/core/registry.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/core/workspace.h"
@@ -47,6 +48,7 @@ class SimpleNet : public NetBase {
   bool RunAsync() override;
 
   vector<unique_ptr<OperatorBase>> operators_;
+  unique_ptr<NetOutputPreallocator> preallocator_;
 
   DISABLE_COPY_AND_ASSIGN(SimpleNet);
 };
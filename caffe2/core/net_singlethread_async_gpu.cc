@@ -17,6 +17,7 @@ namespace gpu_single_thread {
 
 struct Task {
   std::vector<std::unique_ptr<OperatorBase>>* ops_;
+  const std::string* net_name_;
   std::condition_variable* cv_;
   std::mutex* mtx_;
   int stream_id_;
@@ -124,7 +125,9 @@ void GPUExecutor::WorkerFunction() {
       }
 
       for (auto& op : *task->ops_) {
+        CAFFE_SDT_OPERATOR(operator_start, *task->net_name_, op.get());
         op->RunAsync(task->stream_id_);
+        CAFFE_SDT_OPERATOR(operator_done, *task->net_name_, op.get());
       }
       task_batch.push_back(task);
 
@@ -138,8 +141,10 @@ void GPUExecutor::WorkerFunction() {
 
     // Wait for the currently executing streams
     for (auto& pendtask : task_batch) {
-      cudaStream_t stream =
-          CUDAContext::cuda_stream(gpu_id_, pendtask->stream_id_);
+      bool high_priority = !pendtask->ops_->empty() &&
+          pendtask->ops_->front()->device_option().cuda_high_priority();
+      cudaStream_t stream = CUDAContext::cuda_stream(
+          gpu_id_, pendtask->stream_id_, high_priority);
       CUDA_ENFORCE(cudaStreamSynchronize(stream));
       streams.push(pendtask->stream_id_);
       std::unique_lock<std::mutex> lk(*pendtask->mtx_);
@@ -171,6 +176,7 @@ class SingleThreadAsyncNet : public SimpleNet {
     std::unique_lock<std::mutex> lk(mutex_);
     Task t;
     t.ops_ = &operators_;
+    t.net_name_ = &name_;
     t.cv_ = &cv_;
     t.mtx_ = &mutex_;
     t.done_ = false;
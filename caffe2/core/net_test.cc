@@ -5,6 +5,8 @@
 #include "caffe2/core/scope_guard.h"
 
 CAFFE2_DECLARE_bool(caffe2_disable_chaining);
+CAFFE2_DECLARE_bool(caffe2_net_async_priority_scheduling);
+CAFFE2_DECLARE_bool(caffe2_net_async_fuse_cpu_chains);
 
 namespace caffe2 {
 
@@ -620,4 +622,112 @@ TEST(NetTest, OperatorWithExecutorHelper) {
   ASSERT_TRUE(net->Run());
 }
 
+static std::mutex run_order_mutex;
+static std::vector<std::string> run_order;
+
+class RecordRunOrderOp final : public OperatorBase {
+ public:
+  using OperatorBase::OperatorBase;
+
+  bool Run(int /* unused */ /*stream_id*/) override {
+    std::lock_guard<std::mutex> lock(run_order_mutex);
+    run_order.push_back(debug_def().name());
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(RecordRunOrder, RecordRunOrderOp);
+
+OPERATOR_SCHEMA(RecordRunOrder).NumInputs(0, INT_MAX).NumOutputs(0, INT_MAX);
+
+TEST(NetTest, PrioritySchedulingRunsCriticalPathFirst) {
+  // root fans out to two single-op chains and one three-op chain; with a
+  // single worker the long chain has to start first
+  const auto spec = R"DOC(
+        name: "example"
+        type: "async_scheduling"
+        external_input: "in"
+        op { name: "root" input: "in" output: "a" output: "b" type: "RecordRunOrder" }
+        op { name: "short1" input: "b" output: "s1" type: "RecordRunOrder" }
+        op { name: "short2" input: "b" output: "s2" type: "RecordRunOrder" }
+        op { name: "long1" input: "a" output: "l1" type: "RecordRunOrder" }
+        op { name: "long2" input: "l1" output: "l2" type: "RecordRunOrder" }
+        op { name: "long3" input: "l2" output: "l3" type: "RecordRunOrder" }
+)DOC";
+
+  NetDef net_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(spec, &net_def));
+  net_def.set_num_workers(1);
+
+  Workspace ws;
+  ws.CreateBlob("in");
+  auto old_chaining = FLAGS_caffe2_disable_chaining;
+  auto old_priority = FLAGS_caffe2_net_async_priority_scheduling;
+  auto g = MakeGuard([&]() {
+    FLAGS_caffe2_disable_chaining = old_chaining;
+    FLAGS_caffe2_net_async_priority_scheduling = old_priority;
+  });
+  FLAGS_caffe2_disable_chaining = true;
+  FLAGS_caffe2_net_async_priority_scheduling = true;
+
+  std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  run_order.clear();
+  ASSERT_TRUE(net->Run());
+  ASSERT_EQ(6u, run_order.size());
+  ASSERT_EQ("root", run_order[0]);
+  ASSERT_EQ("long1", run_order[1]);
+}
+
+TEST(NetTest, FusedCPUChain) {
+  const auto spec = R"DOC(
+        name: "example"
+        type: "async_scheduling"
+        external_input: "in"
+        op { input: "in" output: "hidden" type: "NetTestDummy" }
+        op { input: "hidden" output: "hidden2" type: "NetTestDummy" }
+        op { input: "hidden2" output: "out" type: "NetTestDummy" }
+)DOC";
+
+  NetDef net_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(spec, &net_def));
+  net_def.set_num_workers(4);
+
+  Workspace ws;
+  ws.CreateBlob("in");
+  auto old_chaining = FLAGS_caffe2_disable_chaining;
+  auto old_fuse = FLAGS_caffe2_net_async_fuse_cpu_chains;
+  auto g = MakeGuard([&]() {
+    FLAGS_caffe2_disable_chaining = old_chaining;
+    FLAGS_caffe2_net_async_fuse_cpu_chains = old_fuse;
+  });
+  FLAGS_caffe2_disable_chaining = false;
+  FLAGS_caffe2_net_async_fuse_cpu_chains = true;
+
+  {
+    std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+    ASSERT_EQ(1, net->events().size());
+    for (int i = 0; i < 3; i++) {
+      counter.exchange(0);
+      ASSERT_TRUE(net->Run());
+      ASSERT_EQ(3, counter.load());
+      auto ops = net->GetOperators();
+      // only the last op of the chain updates its event
+      ASSERT_EQ(EventStatus::EVENT_INITIALIZED, ops[0]->event().Query());
+      ASSERT_EQ(EventStatus::EVENT_SUCCESS, ops[2]->event().Query());
+    }
+  }
+
+  // a failure in the middle of the chain fails the chain's event
+  auto* arg = net_def.mutable_op(1)->add_arg();
+  arg->set_name("fail");
+  arg->set_i(1);
+  {
+    std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+    counter.exchange(0);
+    ASSERT_THROW(net->Run(), EnforceNotMet);
+    ASSERT_EQ(1, counter.load());
+    ASSERT_EQ(EventStatus::EVENT_FAILED, net->events()[0]->Query());
+  }
+}
+
 } // namespace caffe2
@@ -87,6 +87,32 @@ std::vector<NNGraph::NodeRef> getOutputs(NNGraph::NodeRef n) {
   return out;
 }
 
+void replaceAllUsesWith(NNGraph *g, NNGraph::NodeRef oldTensor,
+                        NNGraph::NodeRef newTensor) {
+  assert(is<NeuralNetData>(oldTensor) && is<NeuralNetData>(newTensor) &&
+         "replaceAllUsesWith only works with NeuralNetData types.");
+  std::unordered_set<NNGraph::NodeRef> rewired;
+  for (auto consumer : getConsumers(oldTensor)) {
+    if (!rewired.insert(consumer).second) {
+      continue;
+    }
+    // The inputs of an operator are the order of its in-edges, so all of
+    // them are recreated.
+    std::vector<NNGraph::NodeRef> inputs;
+    for (auto inEdge : consumer->getInEdges()) {
+      auto tail = inEdge->tail();
+      inputs.emplace_back(tail == oldTensor ? newTensor : tail);
+    }
+    const auto inEdges = consumer->getInEdges();
+    for (auto inEdge : inEdges) {
+      g->deleteEdge(inEdge);
+    }
+    for (auto input : inputs) {
+      g->createEdge(input, consumer);
+    }
+  }
+}
+
 size_t coalesceInsertedDataDependenciesHelper(repr::NNModule* m) {
   // Get all nodes tracked by CF graph
   std::unordered_set<repr::NNGraph::NodeRef> cfTrackedNodes;
@@ -3,6 +3,8 @@
 #include "nomnigraph/Support/Casting.h"
 #include "nomnigraph/Support/Pointer.h"
 
+#include <algorithm>
+
 namespace nom {
 namespace transformations {
 
@@ -66,5 +68,183 @@ bool fuseConvRelu(repr::NNGraph *g) {
   return false;
 }
 
+namespace {
+
+using NodeRef = repr::NNGraph::NodeRef;
+
+repr::BasicBlockType<repr::NNGraph> *findBasicBlock(repr::NNModule *m,
+                                                    NodeRef node) {
+  for (auto bbNode : m->controlFlow.getMutableNodes()) {
+    auto bb = bbNode->mutableData()->get();
+    if (bb->hasInstruction(node)) {
+      return bb;
+    }
+  }
+  return nullptr;
+}
+
+const std::string getTensorName(NodeRef tensor) {
+  return repr::nn::get<repr::NeuralNetData>(tensor)->getName();
+}
+
+} // namespace
+
+bool noWritesBetween(repr::NNModule *m, NodeRef first, NodeRef last,
+                     const std::unordered_set<std::string> &names,
+                     const std::unordered_set<NodeRef> &ignored) {
+  auto bb = findBasicBlock(m, first);
+  if (!bb || !bb->hasInstruction(last)) {
+    return false;
+  }
+  const auto &instructions = bb->getInstructions();
+  auto firstIt = std::find(instructions.begin(), instructions.end(), first);
+  auto lastIt = std::find(instructions.begin(), instructions.end(), last);
+  if (firstIt > lastIt) {
+    return false;
+  }
+  for (auto it = firstIt + 1; it < lastIt; ++it) {
+    if (ignored.count(*it)) {
+      continue;
+    }
+    for (auto output : repr::nn::getOutputs(*it)) {
+      if (names.count(getTensorName(output))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::vector<NodeRef> matchOperatorChain(repr::NNModule *m, NodeRef node,
+                                        const OperatorChainPattern &pattern) {
+  auto isRemovable = [&](NodeRef tensor) {
+    return !pattern.IsRemovable || pattern.IsRemovable(tensor);
+  };
+  // The operator reading the first output of op, if they can be chained.
+  auto next = [&](NodeRef op) -> NodeRef {
+    auto outputs = repr::nn::getOutputs(op);
+    if (outputs.empty() || !isRemovable(outputs.front())) {
+      return nullptr;
+    }
+    auto consumers = repr::nn::getConsumers(outputs.front());
+    return consumers.size() == 1 ? consumers.front() : nullptr;
+  };
+
+  std::vector<NodeRef> chain;
+  NodeRef current = node;
+  for (const auto &element : pattern.Elements) {
+    int count = 0;
+    while (current && (element.MaxCount < 0 || count < element.MaxCount) &&
+           repr::nn::is<repr::NeuralNetOperator>(current) &&
+           element.Matches(current)) {
+      chain.emplace_back(current);
+      current = next(current);
+      ++count;
+    }
+    if (count < element.MinCount) {
+      return {};
+    }
+  }
+  if (chain.empty()) {
+    return {};
+  }
+
+  // Everything written before the last operator goes away.
+  const std::unordered_set<NodeRef> inChain(chain.begin(), chain.end());
+  std::unordered_set<NodeRef> internal;
+  for (size_t i = 0; i + 1 < chain.size(); ++i) {
+    for (auto output : repr::nn::getOutputs(chain[i])) {
+      if (!isRemovable(output)) {
+        return {};
+      }
+      for (auto consumer : repr::nn::getConsumers(output)) {
+        if (!inChain.count(consumer)) {
+          return {};
+        }
+      }
+      internal.insert(output);
+    }
+  }
+
+  // The chain runs where its last operator is, so what it reads from outside
+  // must still be there.
+  std::unordered_set<std::string> names;
+  for (auto op : chain) {
+    for (auto input : repr::nn::getInputs(op)) {
+      if (!internal.count(input)) {
+        names.insert(getTensorName(input));
+      }
+    }
+  }
+  if (!noWritesBetween(m, chain.front(), chain.back(), names, inChain)) {
+    return {};
+  }
+  return chain;
+}
+
+int fuseOperatorChains(repr::NNModule *m,
+                       const std::vector<OperatorChainPattern> &patterns) {
+  int count = 0;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const auto &pattern : patterns) {
+      // Nodes are deleted by the replacements, so the search starts over.
+      for (auto node : m->dataFlow.getMutableNodes()) {
+        if (!repr::nn::is<repr::NeuralNetOperator>(node)) {
+          continue;
+        }
+        auto chain = matchOperatorChain(m, node, pattern);
+        if (!chain.empty() && pattern.Replace(m, chain)) {
+          changed = true;
+          break;
+        }
+      }
+      if (changed) {
+        ++count;
+        break;
+      }
+    }
+  }
+  return count;
+}
+
+NodeRef replaceOperatorChain(repr::NNModule *m,
+                             const std::vector<NodeRef> &chain,
+                             std::unique_ptr<repr::NeuralNetOperator> op) {
+  assert(!chain.empty() && "Cannot replace an empty chain.");
+  auto &g = m->dataFlow;
+  std::unordered_set<NodeRef> internal;
+  for (size_t i = 0; i + 1 < chain.size(); ++i) {
+    for (auto output : repr::nn::getOutputs(chain[i])) {
+      internal.insert(output);
+    }
+  }
+
+  auto *fusedNode = g.createNode(std::unique_ptr<repr::Value>(std::move(op)));
+  for (auto chainOp : chain) {
+    for (auto input : repr::nn::getInputs(chainOp)) {
+      if (!internal.count(input)) {
+        g.createEdge(input, fusedNode);
+      }
+    }
+  }
+  for (auto output : repr::nn::getOutputs(chain.back())) {
+    g.createEdge(fusedNode, output);
+  }
+  auto bb = findBasicBlock(m, chain.back());
+  assert(bb && "Operator chain is not in a basic block.");
+  bb->insertInstructionBefore(fusedNode, chain.back());
+
+  // Deleting the operators also removes them from the basic block.
+  for (auto chainOp : chain) {
+    g.deleteNode(chainOp);
+  }
+  for (auto tensor : internal) {
+    g.deleteNode(tensor);
+  }
+  return fusedNode;
+}
+
 } // namespace transformations
 } // namespace nom
@@ -407,6 +407,11 @@ bool hasInputs(NNGraph::NodeRef n);
 std::vector<NNGraph::NodeRef> getInputs(NNGraph::NodeRef n);
 std::vector<NNGraph::NodeRef> getOutputs(NNGraph::NodeRef n);
 
+/// \brief Makes every consumer of the tensor \p oldTensor read \p newTensor
+/// instead, keeping the order of its inputs.
+void replaceAllUsesWith(NNGraph *g, NNGraph::NodeRef oldTensor,
+                        NNGraph::NodeRef newTensor);
+
 void coalesceInsertedDataDependencies(repr::NNModule* m);
 
 template <NNGraph* G>
@@ -4,11 +4,78 @@
 #include "nomnigraph/Graph/Graph.h"
 #include "nomnigraph/Representations/NeuralNet.h"
 
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
 namespace nom {
 namespace transformations {
 
 bool fuseConvRelu(Graph<std::unique_ptr<repr::Value>, int> *);
 
+/// \brief A declarative pattern of operators to fuse: a chain of operators
+/// in dataflow order, each one reading the first output of the one before
+/// it.  Each element of the pattern matches between MinCount and MaxCount
+/// consecutive operators (MaxCount < 0 is unbounded), greedily.
+///
+/// A chain only matches when fusing it is legal:
+///  - the first output of every operator but the last one is read once, by
+///    the next operator, and the other outputs only by later operators of
+///    the chain;
+///  - every tensor written before the last operator is removable;
+///  - the operators are in one basic block, and no other operator between
+///    the first and the last one overwrites (by name) a tensor that the
+///    chain reads from outside of it, so that the chain can run at the
+///    position of its last operator.
+struct OperatorChainPattern {
+  using NodeRef = repr::NNGraph::NodeRef;
+  using Predicate = std::function<bool(NodeRef)>;
+
+  struct Element {
+    Predicate Matches;
+    int MinCount;
+    int MaxCount;
+  };
+
+  std::vector<Element> Elements;
+  /// \brief Whether a tensor can be removed from the graph, for instance
+  /// because it is not an output of the program.  All of them can if unset.
+  Predicate IsRemovable;
+  /// \brief Rewrites a legal match; returns false to leave it in place.
+  std::function<bool(repr::NNModule *, const std::vector<NodeRef> &)> Replace;
+};
+
+/// \brief Matches \p pattern on the chain of operators starting at \p node.
+/// \return The operators of the chain, or nothing if there is no legal match.
+std::vector<repr::NNGraph::NodeRef>
+matchOperatorChain(repr::NNModule *m, repr::NNGraph::NodeRef node,
+                   const OperatorChainPattern &pattern);
+
+/// \brief Replaces the matches of the patterns, the first pattern first,
+/// until none is left.
+/// \return The number of matches replaced.
+int fuseOperatorChains(repr::NNModule *m,
+                       const std::vector<OperatorChainPattern> &patterns);
+
+/// \brief Replaces a matched chain with \p op, which reads the inputs of the
+/// chain that are not written inside of it, in order, and writes the outputs
+/// of its last operator, at its position.
+/// \return The node of the new operator.
+repr::NNGraph::NodeRef
+replaceOperatorChain(repr::NNModule *m,
+                     const std::vector<repr::NNGraph::NodeRef> &chain,
+                     std::unique_ptr<repr::NeuralNetOperator> op);
+
+/// \brief Whether \p first and \p last are in the same basic block, and no
+/// operator between them, other than those of \p ignored, writes a tensor
+/// named as one of \p names.
+bool noWritesBetween(repr::NNModule *m, repr::NNGraph::NodeRef first,
+                     repr::NNGraph::NodeRef last,
+                     const std::unordered_set<std::string> &names,
+                     const std::unordered_set<repr::NNGraph::NodeRef> &ignored);
+
 } // namespace transformations
 } // namespace nom
 
@@ -688,5 +688,53 @@ int main(int argc, char *argv[]) {
     assert(m.match(nn.dataFlow).size() == 1);
   }
 
+  // Test fusing chains of operators
+  {
+    caffe2::NetDef net;
+    auto addOp = [&](std::string type, std::string input, std::string output) {
+      caffe2::OperatorDef *rdef = net.add_op();
+      rdef->set_type(type);
+      rdef->add_input(input);
+      rdef->add_output(output);
+    };
+    addOp("A", "X", "Y");
+    addOp("B", "Y", "Y");
+    addOp("B", "Y", "Z");
+    addOp("C", "Z", "W");
+    // Not fused: Z is overwritten before the second B.
+    addOp("A", "Z", "V");
+    addOp("C", "W", "Z");
+    addOp("B", "V", "U");
+    auto nn = nom::converters::convertFromCaffe2Proto(net);
+
+    auto isType = [](std::string type) {
+      return [type](nom::repr::NNGraph::NodeRef node) {
+        return nom::repr::nn::get<nom::repr::NeuralNetOperator>(node)
+                   ->getName() == type;
+      };
+    };
+    caffe2::OperatorDef fusedDef;
+    fusedDef.set_type("AB");
+    nom::transformations::OperatorChainPattern pattern;
+    pattern.Elements = {{isType("A"), 1, 1}, {isType("B"), 1, -1}};
+    pattern.Replace = [&](nom::repr::NNModule *m,
+                          const std::vector<nom::repr::NNGraph::NodeRef> &c) {
+      auto op = nom::util::make_unique<nom::repr::GenericOperator>("AB");
+      op->setAnnotation(nom::util::make_unique<nom::repr::Annotation>());
+      op->getMutableAnnotation()->setSaved(&fusedDef);
+      nom::transformations::replaceOperatorChain(m, c, std::move(op));
+      return true;
+    };
+    assert(nom::transformations::fuseOperatorChains(&nn, {pattern}) == 1);
+
+    auto fused = nom::converters::convertToCaffe2Proto(nn);
+    assert(fused.op_size() == 5);
+    assert(fused.op(0).type() == "AB");
+    assert(fused.op(0).input(0) == "X");
+    assert(fused.op(0).output(0) == "Z");
+    assert(fused.op(1).type() == "C");
+    assert(fused.op(4).type() == "B");
+  }
+
   return 0;
 }
@@ -13,6 +13,14 @@ CAFFE2_DEFINE_bool(
 
 namespace caffe2 {
 
+namespace {
+thread_local int thread_numa_node = -1;
+} // namespace
+
+int GetThreadNUMANode() {
+  return thread_numa_node;
+}
+
 #ifdef CAFFE2_NUMA_ENABLED
 bool IsNUMAEnabled() {
   return FLAGS_caffe2_cpu_numa_enabled && numa_available() >= 0;
@@ -36,6 +44,7 @@ void NUMABind(int numa_node_id) {
   numa_bitmask_setbit(bm, numa_node_id);
   numa_bind(bm);
   numa_bitmask_free(bm);
+  thread_numa_node = numa_node_id;
 }
 
 int GetNUMANode(const void* ptr) {
@@ -88,6 +97,29 @@ void NUMAMove(void* ptr, size_t size, int numa_node_id) {
       "Could not move memory to a NUMA node");
 }
 
+bool NUMAMovePages(const void* ptr, size_t size, int numa_node_id) {
+  if (numa_node_id < 0 || !IsNUMAEnabled()) {
+    return false;
+  }
+  CAFFE_ENFORCE(ptr);
+  CAFFE_ENFORCE(numa_node_id < sizeof(unsigned long) * 8);
+
+  size_t page_size = getpagesize();
+  size_t begin = ((size_t)ptr + page_size - 1) & ~(page_size - 1);
+  size_t end = ((size_t)ptr + size) & ~(page_size - 1);
+  if (begin >= end) {
+    return true;
+  }
+  unsigned long mask = 1UL << numa_node_id;
+  return mbind(
+             (void*)begin,
+             end - begin,
+             MPOL_BIND,
+             &mask,
+             sizeof(mask) * 8,
+             MPOL_MF_MOVE) == 0;
+}
+
 int GetCurrentNUMANode() {
   if (!IsNUMAEnabled()) {
     VLOG(1) << "NUMA is not enabled";
@@ -97,6 +129,25 @@ int GetCurrentNUMANode() {
   return numa_node_of_cpu(sched_getcpu());
 }
 
+int GetNUMANodeCPUCount(int numa_node_id) {
+  if (!IsNUMAEnabled()) {
+    VLOG(1) << "NUMA is not enabled";
+    return -1;
+  }
+  CAFFE_ENFORCE(
+      numa_node_id >= 0 && numa_node_id <= numa_max_node(),
+      "NUMA node id " + caffe2::to_string(numa_node_id) + " is unavailable");
+
+  auto cpus = numa_allocate_cpumask();
+  CAFFE_ENFORCE(
+      numa_node_to_cpus(numa_node_id, cpus) == 0,
+      "Unable to get the CPUs of NUMA node " +
+          caffe2::to_string(numa_node_id));
+  int count = numa_bitmask_weight(cpus);
+  numa_bitmask_free(cpus);
+  return count;
+}
+
 #else // CAFFE2_NUMA_ENABLED
 
 bool IsNUMAEnabled() {
@@ -125,11 +176,23 @@ void NUMAMove(void* ptr, size_t size, int numa_node_id) {
   }
 }
 
+bool NUMAMovePages(const void* ptr, size_t size, int numa_node_id) {
+  if (numa_node_id >= 0) {
+    VLOG(1) << "NUMA is not enabled";
+  }
+  return false;
+}
+
 int GetCurrentNUMANode() {
   VLOG(1) << "NUMA is not enabled";
   return -1;
 }
 
+int GetNUMANodeCPUCount(int numa_node_id) {
+  VLOG(1) << "NUMA is not enabled";
+  return -1;
+}
+
 #endif // CAFFE2_NUMA_ENABLED
 
 } // namespace caffe2
@@ -17,8 +17,19 @@ int GetNumNUMANodes();
 
 void NUMAMove(void* ptr, size_t size, int numa_node_id);
 
+// Moves the pages that lie entirely within [ptr, ptr + size) to a NUMA node,
+// leaving alone the partial pages at the ends, which may hold other data.
+// Best effort: returns false if not all pages could be moved.
+bool NUMAMovePages(const void* ptr, size_t size, int numa_node_id);
+
 int GetCurrentNUMANode();
 
+// The node the calling thread was bound to by NUMABind, or -1
+int GetThreadNUMANode();
+
+// Number of CPUs on a NUMA node, or -1 if NUMA is not enabled
+int GetNUMANodeCPUCount(int numa_node_id);
+
 } // namespace caffe2
 
 #endif // CAFFE2_CORE_NUMA_H_
@@ -2,9 +2,11 @@
 
 #include <algorithm>
 
+#include "caffe2/core/compiled_net.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/net.h"
 #include "caffe2/core/operator_gradient.h"
+#include "caffe2/core/scope_guard.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/core/types.h"
 #include "caffe2/core/workspace.h"
@@ -25,9 +27,35 @@ CAFFE2_DEFINE_bool(
 
 namespace caffe2 {
 
+namespace {
+// The prepared def an operator is being created from on this thread, if any,
+// so that its constructor can share the def and the parsed arguments instead
+// of copying and parsing them again.
+thread_local const PreparedOperatorDef* t_prepared_op = nullptr;
+
+bool IsPreparedOp(const OperatorDef& operator_def) {
+  return t_prepared_op && t_prepared_op->def.get() == &operator_def;
+}
+
+std::shared_ptr<const OperatorDef> ShareOperatorDef(
+    const OperatorDef& operator_def) {
+  return IsPreparedOp(operator_def)
+      ? t_prepared_op->def
+      : std::make_shared<const OperatorDef>(operator_def);
+}
+
+std::shared_ptr<const ArgumentHelper> ShareArguments(
+    const OperatorDef& operator_def) {
+  return IsPreparedOp(operator_def)
+      ? t_prepared_op->args
+      : std::make_shared<const ArgumentHelper>(operator_def);
+}
+} // namespace
+
 OperatorBase::OperatorBase(const OperatorDef& operator_def, Workspace* ws)
     : operator_ws_(ws),
-      operator_def_(std::make_shared<OperatorDef>(operator_def)),
+      operator_def_(ShareOperatorDef(operator_def)),
+      arg_helper_(ShareArguments(operator_def)),
       device_option_(
           operator_def.has_device_option() ? operator_def.device_option()
                                            : DeviceOption()),
@@ -71,18 +99,21 @@ GlobalEnginePrefType& g_global_engine_pref() {
   return *g_global_engine_pref_;
 }
 
-unique_ptr<OperatorBase> TryCreateOperator(
-    const string& key, const OperatorDef& operator_def, Workspace* ws) {
-  const auto& type = operator_def.device_option().device_type();
+OperatorRegistry* DeviceOperatorRegistry(int device_type) {
   CAFFE_ENFORCE(
-      gDeviceTypeRegistry()->count(type),
+      gDeviceTypeRegistry()->count(device_type),
       "Device type ",
-      type,
+      device_type,
       " not registered.");
-  OperatorRegistry* registry = gDeviceTypeRegistry()->at(type);
-  VLOG(1) << "Creating operator with device type " << type;
+  return gDeviceTypeRegistry()->at(device_type);
+}
+
+unique_ptr<OperatorBase> TryCreateOperator(
+    const OperatorRegistry::Creator& creator,
+    const OperatorDef& operator_def,
+    Workspace* ws) {
   try {
-    return registry->Create(key, operator_def, ws);
+    return creator(operator_def, ws);
   } catch (const UnsupportedOperatorFeature& err) {
     LOG(WARNING) << "Operator " << operator_def.type()
                  << " does not support the requested feature. Msg: "
@@ -92,15 +123,31 @@ unique_ptr<OperatorBase> TryCreateOperator(
   }
 }
 
-unique_ptr<OperatorBase> _CreateOperator(
-    const OperatorDef& operator_def,
-    Workspace* ws) {
-  static StaticLinkingProtector g_protector;
-  const auto& op_type = operator_def.type();
-  const auto& device_type = operator_def.device_option().device_type();
+unique_ptr<OperatorBase> TryCreateOperator(
+    const string& key, const OperatorDef& operator_def, Workspace* ws) {
+  const auto& type = operator_def.device_option().device_type();
+  OperatorRegistry* registry = DeviceOperatorRegistry(type);
+  VLOG(1) << "Creating operator with device type " << type;
+  auto creator = registry->GetCreator(key);
+  if (!creator) {
+    return nullptr;
+  }
+  return TryCreateOperator(creator, operator_def, ws);
+}
+
+void AnnotateEngine(OperatorBase* op, const std::string& engine) {
+  if (engine.size() <= FLAGS_caffe2_operator_max_engine_name_length) {
+    op->annotate_engine(engine);
+  } else {
+    op->annotate_engine(
+        engine.substr(0, FLAGS_caffe2_operator_max_engine_name_length));
+  }
+}
 
+void VerifyOperatorSchema(const OperatorDef& operator_def) {
 #ifndef CAFFE2_NO_OPERATOR_SCHEMA
   // first, check with OpSchema if the operator is legal.
+  const auto& op_type = operator_def.type();
   auto* schema = OpSchemaRegistry::Schema(op_type);
   if (schema) {
     CAFFE_ENFORCE(
@@ -115,8 +162,13 @@ unique_ptr<OperatorBase> _CreateOperator(
                << ". Will skip schema checking.";
   }
 #endif
+}
 
-  // second try engines specified in the operator_def and preferred engines
+// The engines to try for the operator, in order: the ones specified in the
+// operator_def, then the preferred engines.
+std::vector<std::string> OperatorEngines(const OperatorDef& operator_def) {
+  const auto& op_type = operator_def.type();
+  const auto& device_type = operator_def.device_option().device_type();
   std::vector<std::string> engines{};
   if (operator_def.engine().size()) {
     const auto op_def_engines = split(',', operator_def.engine());
@@ -138,52 +190,110 @@ unique_ptr<OperatorBase> _CreateOperator(
     engines.insert(
         engines.end(), preferred_engines.begin(), preferred_engines.end());
   }
-  for (const auto& engine : engines) {
-    const std::string key = OpRegistryKey(op_type, engine);
-    VLOG(1) << "Trying to create operator " << op_type << " with engine "
-            << engine;
-    auto op = TryCreateOperator(key, operator_def, ws);
-    if (op) {
-      if (engine.size() <= FLAGS_caffe2_operator_max_engine_name_length) {
-        op->annotate_engine(engine);
-      } else {
-        op->annotate_engine(
-            engine.substr(0, FLAGS_caffe2_operator_max_engine_name_length));
-      }
-      return op;
-    } else {
-      // If the above fails, we will just return the normal case with the
-      // default implementation.
-      VLOG(1) << "Engine " << engine
-              << " is not available for operator " << op_type << ".";
-    }
-  }
+  return engines;
+}
+
+void LogEngineNotAvailable(const OperatorDef& operator_def) {
   if (operator_def.engine().size() && !VLOG_IS_ON(1)) {
     static int log_occurrences = 0;
     if (log_occurrences <= 64) {
       ++log_occurrences;
       LOG(INFO) << "Engine " << operator_def.engine()
-                << " is not available for operator " << op_type << ".";
+                << " is not available for operator " << operator_def.type()
+                << ".";
     }
   }
   VLOG(1) << "Using default implementation.";
+}
 
-  // Lastly, if the engine does not work here, try using the default engine.
-  auto op = TryCreateOperator(op_type, operator_def, ws);
+void EnforceOperatorCreated(bool created, const OperatorDef& operator_def) {
   CAFFE_ENFORCE(
-      op,
+      created,
       "Cannot create operator of type '",
-      op_type,
+      operator_def.type(),
       "' on the device '",
-      DeviceTypeName(device_type),
+      DeviceTypeName(operator_def.device_option().device_type()),
       "'. Verify that implementation for the corresponding device exist. It "
       "might also happen if the binary is not linked with the operator "
       "implementation code. If Python frontend is used it might happen if "
       "dyndep.InitOpsLibrary call is missing. Operator def: ",
       ProtoDebugString(operator_def));
+}
+
+unique_ptr<OperatorBase> _CreateOperator(
+    const OperatorDef& operator_def,
+    Workspace* ws) {
+  static StaticLinkingProtector g_protector;
+  const auto& op_type = operator_def.type();
+
+  VerifyOperatorSchema(operator_def);
+
+  // second try engines specified in the operator_def and preferred engines
+  for (const auto& engine : OperatorEngines(operator_def)) {
+    const std::string key = OpRegistryKey(op_type, engine);
+    VLOG(1) << "Trying to create operator " << op_type << " with engine "
+            << engine;
+    auto op = TryCreateOperator(key, operator_def, ws);
+    if (op) {
+      AnnotateEngine(op.get(), engine);
+      return op;
+    } else {
+      // If the above fails, we will just return the normal case with the
+      // default implementation.
+      VLOG(1) << "Engine " << engine
+              << " is not available for operator " << op_type << ".";
+    }
+  }
+  LogEngineNotAvailable(operator_def);
+
+  // Lastly, if the engine does not work here, try using the default engine.
+  auto op = TryCreateOperator(op_type, operator_def, ws);
+  EnforceOperatorCreated(op != nullptr, operator_def);
   return op;
 }
 
+unique_ptr<OperatorBase> _CreateOperator(
+    const PreparedOperatorDef& prepared,
+    Workspace* ws) {
+  const auto* saved_prepared_op = t_prepared_op;
+  t_prepared_op = &prepared;
+  auto restore =
+      MakeGuard([saved_prepared_op] { t_prepared_op = saved_prepared_op; });
+  const auto& operator_def = *prepared.def;
+  for (const auto& creator : prepared.creators) {
+    auto op = TryCreateOperator(creator.second, operator_def, ws);
+    if (op) {
+      if (!creator.first.empty()) {
+        AnnotateEngine(op.get(), creator.first);
+      }
+      return op;
+    }
+  }
+  EnforceOperatorCreated(false, operator_def);
+  return nullptr;
+}
+
+template <typename Def>
+unique_ptr<OperatorBase> CreateOperatorAt(
+    const Def& def,
+    Workspace* ws,
+    int net_position) {
+  try {
+    auto op = _CreateOperator(def, ws);
+    op->set_net_position(net_position);
+    return op;
+  } catch (...) {
+    if (net_position != 0) {
+      VLOG(1) << "Operator constructor with net position " << net_position
+              << " failed";
+      ws->last_failed_op_net_position = net_position;
+    } else {
+      VLOG(1) << "Failed operator constructor doesn't have an id set";
+    }
+    throw;
+  }
+}
+
 } // namespace
 
 const std::string OpRegistryKey(
@@ -260,24 +370,49 @@ void SetOpEnginePref(
   }
 }
 
+PreparedOperatorDef PrepareOperatorDef(
+    const std::shared_ptr<const OperatorDef>& operator_def) {
+  static StaticLinkingProtector g_protector;
+  CAFFE_ENFORCE(operator_def, "operator_def was null!");
+  const auto& op_type = operator_def->type();
+  VerifyOperatorSchema(*operator_def);
+
+  PreparedOperatorDef prepared;
+  prepared.def = operator_def;
+  prepared.args = std::make_shared<const ArgumentHelper>(*operator_def);
+  auto* registry =
+      DeviceOperatorRegistry(operator_def->device_option().device_type());
+  for (const auto& engine : OperatorEngines(*operator_def)) {
+    auto creator = registry->GetCreator(OpRegistryKey(op_type, engine));
+    if (creator) {
+      prepared.creators.emplace_back(engine, std::move(creator));
+    }
+  }
+  auto creator = registry->GetCreator(op_type);
+  if (creator) {
+    prepared.creators.emplace_back("", std::move(creator));
+  }
+  EnforceOperatorCreated(!prepared.creators.empty(), *operator_def);
+  return prepared;
+}
+
+unique_ptr<OperatorBase> CreateOperator(
+    const PreparedOperatorDef& prepared,
+    Workspace* ws,
+    int net_position) {
+  return CreateOperatorAt(prepared, ws, net_position);
+}
+
 unique_ptr<OperatorBase> CreateOperator(
     const OperatorDef& operator_def,
     Workspace* ws,
     int net_position) {
-  try {
-    auto op = _CreateOperator(operator_def, ws);
-    op->set_net_position(net_position);
-    return op;
-  } catch (...) {
-    if (net_position != 0) {
-      VLOG(1) << "Operator constructor with net position " << net_position
-              << " failed";
-      ws->last_failed_op_net_position = net_position;
-    } else {
-      VLOG(1) << "Failed operator constructor doesn't have an id set";
-    }
-    throw;
+  // nets created from a CompiledNetDef pass the defs it has prepared
+  const auto* prepared = CompiledNetDef::Prepared(operator_def, net_position);
+  if (prepared) {
+    return CreateOperatorAt(*prepared, ws, net_position);
   }
+  return CreateOperatorAt(operator_def, ws, net_position);
 }
 
 std::map<int32_t, OperatorRegistry*>* gDeviceTypeRegistry() {
@@ -20,6 +20,7 @@
 #include "caffe2/core/types.h"
 #include "caffe2/core/workspace.h"
 #include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/parallel_for.h"
 #include "caffe2/utils/proto_utils.h"
 
 namespace caffe2 {
@@ -35,31 +36,24 @@ class OperatorBase : public Observable<OperatorBase> {
   /** @brief Checks if the operator has an argument of the given name.
    */
   inline bool HasArgument(const string& name) const {
-    CAFFE_ENFORCE(operator_def_, "operator_def was null!");
-    return ArgumentHelper::HasArgument(*operator_def_, name);
+    return arg_helper().HasArgument(name);
   }
 
   // Functions that deal with arguments. Basically, this allows us to map an
   // argument name to a specific type of argument that we are trying to access.
   template <typename T>
   inline T GetSingleArgument(const string& name, const T& default_value) const {
-    CAFFE_ENFORCE(operator_def_, "operator_def was null!");
-    return ArgumentHelper::GetSingleArgument<OperatorDef, T>(
-        *operator_def_, name, default_value);
+    return arg_helper().template GetSingleArgument<T>(name, default_value);
   }
   template <typename T>
   inline bool HasSingleArgumentOfType(const string& name) const {
-    CAFFE_ENFORCE(operator_def_, "operator_def was null!");
-    return ArgumentHelper::HasSingleArgumentOfType<OperatorDef, T>(
-        *operator_def_, name);
+    return arg_helper().template HasSingleArgumentOfType<T>(name);
   }
   template <typename T>
   inline vector<T> GetRepeatedArgument(
       const string& name,
       const vector<T>& default_value = {}) const {
-    CAFFE_ENFORCE(operator_def_, "operator_def was null!");
-    return ArgumentHelper::GetRepeatedArgument<OperatorDef, T>(
-        *operator_def_, name, default_value);
+    return arg_helper().template GetRepeatedArgument<T>(name, default_value);
   }
 
   // Get the inputs and outputs as specific types.
@@ -240,6 +234,15 @@ class OperatorBase : public Observable<OperatorBase> {
     net_position_ = idx;
   }
 
+  // The thread pool of the workspace, to pass to ParallelFor, or nullptr when
+  // intra-op parallelism is disabled so that no pool is created for nothing
+  ThreadPool* IntraOpThreadPool() const {
+    if (!FLAGS_caffe2_intra_op_parallelism || !operator_ws_) {
+      return nullptr;
+    }
+    return operator_ws_->GetThreadPool();
+  }
+
   const DeviceOption& device_option() const {
     return device_option_;
   }
@@ -300,8 +303,16 @@ class OperatorBase : public Observable<OperatorBase> {
   static constexpr int kNoNetPositionSet = -1;
 
  private:
+  const ArgumentHelper& arg_helper() const {
+    CAFFE_ENFORCE(arg_helper_, "operator_def was null!");
+    return *arg_helper_;
+  }
+
   Workspace* operator_ws_;
   std::shared_ptr<const OperatorDef> operator_def_;
+  // the arguments of operator_def_, parsed once when the operator is created
+  // rather than on every access
+  std::shared_ptr<const ArgumentHelper> arg_helper_;
   DeviceOption device_option_;
   std::string engine_;
   vector<const Blob*> inputs_;
@@ -428,10 +439,16 @@ class Operator : public OperatorBase {
     }
   }
 
+  // For ops with async parts, observers only see the time it takes to
+  // schedule the computation
   bool RunAsync(int stream_id = 0) final {
     try {
+      StartAllObservers();
+
       context_.SwitchToDevice(stream_id);
       auto result = RunOnDevice();
+      // before the event is set, since the net may be gone right after
+      StopAllObservers();
       if (result) {
         if (HasAsyncPart()) {
           RecordEvent();
@@ -822,6 +839,28 @@ unique_ptr<OperatorBase> CreateOperator(
     Workspace* ws,
     int net_position = OperatorBase::kNoNetPositionSet);
 
+/**
+ * An operator def resolved ahead of time, so that operators can be created
+ * from it over and over without checking it against its schema, parsing its
+ * arguments or looking up the registry again. See CompiledNetDef.
+ */
+struct PreparedOperatorDef {
+  std::shared_ptr<const OperatorDef> def;
+  std::shared_ptr<const ArgumentHelper> args;
+  // the registered creators CreateOperator would try, in order, with the
+  // engines they implement
+  std::vector<std::pair<std::string, OperatorRegistry::Creator>> creators;
+};
+
+// Resolves an operator def with the engine preferences currently set.
+PreparedOperatorDef PrepareOperatorDef(
+    const std::shared_ptr<const OperatorDef>& operator_def);
+
+unique_ptr<OperatorBase> CreateOperator(
+    const PreparedOperatorDef& prepared,
+    Workspace* ws,
+    int net_position = OperatorBase::kNoNetPositionSet);
+
 const std::string OpRegistryKey(
     const std::string& op_type,
     const std::string& engine = "");
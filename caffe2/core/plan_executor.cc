@@ -7,6 +7,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "caffe2/core/scope_guard.h"
 #include "caffe2/core/timer.h"
 #include "caffe2/core/workspace.h"
 #include "caffe2/proto/caffe2.pb.h"
@@ -146,6 +147,77 @@ struct WorkspaceIdInjector {
 const string WorkspaceIdInjector::NODE_ID = "NODE_ID";
 const string WorkspaceIdInjector::GLOBAL_WORKSPACE_ID = "GLOBAL_WORKSPACE_ID";
 
+/**
+ * Threads that run the substeps of a concurrent execution step, kept alive
+ * across its iterations instead of being spawned for each one. Thread i
+ * always runs the same substep, so that it finds the caches warm with the
+ * data of that substep.
+ */
+class SubstepWorkers {
+ public:
+  explicit SubstepWorkers(size_t numThreads) {
+    for (size_t i = 0; i < numThreads; ++i) {
+      threads_.emplace_back([this, i]() { loop(i); });
+    }
+  }
+
+  ~SubstepWorkers() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  size_t size() const {
+    return threads_.size();
+  }
+
+  // Runs f(i) on every thread i and waits for all of them to return.
+  void run(const std::function<void(int)>& f) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_ = &f;
+    remaining_ = threads_.size();
+    ++generation_;
+    start_cv_.notify_all();
+    done_cv_.wait(lock, [this]() { return remaining_ == 0; });
+    task_ = nullptr;
+  }
+
+ private:
+  void loop(int i) {
+    int64_t generation = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      start_cv_.wait(
+          lock, [&]() { return stop_ || generation_ != generation; });
+      if (stop_) {
+        return;
+      }
+      generation = generation_;
+      const auto* task = task_;
+      lock.unlock();
+      (*task)(i);
+      lock.lock();
+      if (--remaining_ == 0) {
+        done_cv_.notify_all();
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  const std::function<void(int)>* task_{nullptr};
+  int64_t generation_{0};
+  size_t remaining_{0};
+  bool stop_{false};
+  std::vector<std::thread> threads_;
+};
+
 struct CompiledExecutionStep;
 
 /**
@@ -178,7 +250,12 @@ struct ExecutionStepWrapper {
         externalWorkspace_(externalWorkspace),
         externalShouldContinue_(externalShouldContinue),
         netDefs_(netDefs),
-        ws_id_injector_(ws_id_injector) {
+        ws_id_injector_(ws_id_injector)
+#if !CAFFE2_MOBILE
+        ,
+        stats_(step->name())
+#endif // !CAFFE2_MOBILE
+  {
     // If this execution step does not create a child workspace,
     // then just eagerly-compile it. This will trigger CreateNet on the
     // nets used by this execution step.
@@ -213,6 +290,34 @@ struct ExecutionStepWrapper {
     return *step_;
   }
 
+#if !CAFFE2_MOBILE
+  ExecutionStepTime& stats() {
+    return stats_;
+  }
+#endif // !CAFFE2_MOBILE
+
+  // Takes idle workers for running the concurrent substeps, or starts new
+  // ones if all of them are in use, e.g. when this step runs as several
+  // concurrent instances of a parent step. Unlike the compiled step, the
+  // workers are kept when the step creates a workspace.
+  std::unique_ptr<SubstepWorkers> acquireWorkers(size_t numThreads) {
+    {
+      std::lock_guard<std::mutex> guard(workersMutex_);
+      if (!idleWorkers_.empty()) {
+        auto workers = std::move(idleWorkers_.back());
+        idleWorkers_.pop_back();
+        DCHECK_EQ(workers->size(), numThreads);
+        return workers;
+      }
+    }
+    return caffe2::make_unique<SubstepWorkers>(numThreads);
+  }
+
+  void releaseWorkers(std::unique_ptr<SubstepWorkers> workers) {
+    std::lock_guard<std::mutex> guard(workersMutex_);
+    idleWorkers_.push_back(std::move(workers));
+  }
+
   CompiledGuard compiled() {
     CompiledGuard guard;
     if (compiledStep_) {
@@ -232,6 +337,11 @@ struct ExecutionStepWrapper {
   NetDefMap* netDefs_;
   std::unique_ptr<CompiledExecutionStep> compiledStep_;
   WorkspaceIdInjector* ws_id_injector_;
+  std::mutex workersMutex_;
+  std::vector<std::unique_ptr<SubstepWorkers>> idleWorkers_;
+#if !CAFFE2_MOBILE
+  ExecutionStepTime stats_;
+#endif // !CAFFE2_MOBILE
 };
 
 struct CompiledExecutionStep {
@@ -356,6 +466,15 @@ std::unique_ptr<CompiledExecutionStep> ExecutionStepWrapper::doCompile() {
 bool ExecuteStepRecursive(ExecutionStepWrapper& stepWrapper) {
   const auto& step = stepWrapper.step();
   auto compiledStep = stepWrapper.compiled();
+#if !CAFFE2_MOBILE
+  Timer step_timer;
+  auto report_time = MakeGuard([&]() {
+    CAFFE_EVENT(
+        stepWrapper.stats(),
+        step_execution_time_ns,
+        static_cast<int64_t>(step_timer.NanoSeconds()));
+  });
+#endif // !CAFFE2_MOBILE
 
   VLOG(1) << "Running execution step " << step.name();
 
@@ -388,6 +507,19 @@ bool ExecuteStepRecursive(ExecutionStepWrapper& stepWrapper) {
         (!step.concurrent_substeps() || step.substep().size() <= 1) &&
         (!step.has_num_concurrent_instances() ||
          step.num_concurrent_instances() <= 1);
+    std::unique_ptr<SubstepWorkers> workers;
+    if (!sequential) {
+      auto numThreads = compiledStep->recurringSubsteps.size();
+      if (step.has_num_concurrent_instances()) {
+        numThreads *= step.num_concurrent_instances();
+      }
+      workers = stepWrapper.acquireWorkers(numThreads);
+    }
+    auto release_workers = MakeGuard([&]() {
+      if (workers) {
+        stepWrapper.releaseWorkers(std::move(workers));
+      }
+    });
     for (int64_t iter = 0; compiledStep->shouldContinue(iter); ++iter) {
       if (sequential) {
         VLOG(1) << "Executing step " << step.name() << " iteration " << iter;
@@ -401,12 +533,11 @@ bool ExecuteStepRecursive(ExecutionStepWrapper& stepWrapper) {
         VLOG(1) << "Executing step " << step.name() << " iteration " << iter
                 << " with " << step.substep().size() << " concurrent substeps";
 
-        std::atomic<int> next_substep{0};
         std::mutex exception_mutex;
         string first_exception;
-        auto worker = [&]() {
+        std::function<void(int)> worker = [&](int thread_id) {
           auto num_substeps = compiledStep->recurringSubsteps.size();
-          int substep_id = next_substep++ % num_substeps;
+          int substep_id = thread_id % num_substeps;
           if (compiledStep->gotFailure) {
             return;
           }
@@ -432,17 +563,7 @@ bool ExecuteStepRecursive(ExecutionStepWrapper& stepWrapper) {
           }
         };
 
-        std::vector<std::thread> threads;
-        auto numThreads = compiledStep->recurringSubsteps.size();
-        if (step.has_num_concurrent_instances()) {
-          numThreads *= step.num_concurrent_instances();
-        }
-        for (int64_t i = 0; i < numThreads; ++i) {
-          threads.emplace_back(worker);
-        }
-        for (auto& thread : threads) {
-          thread.join();
-        }
+        workers->run(worker);
         if (compiledStep->gotFailure) {
           LOG(ERROR) << "One of the workers failed.";
           if (first_exception.size()) {
@@ -513,11 +634,11 @@ bool RunPlanOnWorkspace(
   }
   float exec_time = plan_timer.Seconds();
 
-#ifndef CAFFE2_MOBILE
+#if !CAFFE2_MOBILE
   PlanExecutionTime plan_stat(plan.name());
   CAFFE_EVENT(
       plan_stat, plan_execution_time_ns, (long)(exec_time * 1000000000));
-#endif // CAFFE2_MOBILE
+#endif // !CAFFE2_MOBILE
 
   LOG(INFO) << "Total plan took " << exec_time << " seconds.";
   LOG(INFO) << "Plan executed successfully.";
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <functional>
-#ifndef CAFFE2_MOBILE
+
+#include "caffe2/core/common.h"
+#if !CAFFE2_MOBILE
 #include "caffe2/core/stats.h"
-#endif // CAFFE2_MOBILE
+#endif // !CAFFE2_MOBILE
 
 namespace caffe2 {
 
@@ -14,10 +16,17 @@ typedef std::function<bool(int)> ShouldContinue;
 
 bool RunPlanOnWorkspace(Workspace* ws, const PlanDef& plan, ShouldContinue);
 
-#ifndef CAFFE2_MOBILE
+#if !CAFFE2_MOBILE
 struct PlanExecutionTime {
   CAFFE_STAT_CTOR(PlanExecutionTime);
   CAFFE_EXPORTED_STAT(plan_execution_time_ns);
 };
-#endif // CAFFE2_MOBILE
+
+// Time of the executions of the execution steps of a plan, substeps
+// included, with the name of the step as groupName.
+struct ExecutionStepTime {
+  CAFFE_STAT_CTOR(ExecutionStepTime);
+  CAFFE_AVG_EXPORTED_STAT(step_execution_time_ns);
+};
+#endif // !CAFFE2_MOBILE
 }
@@ -0,0 +1,93 @@
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/plan_executor.h"
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+std::mutex gRunsMutex;
+// threads on which the op of each net ran, and how many times
+std::map<std::string, std::set<std::thread::id>> gThreads;
+std::map<std::string, int> gRuns;
+
+class PlanExecutorTestOp final : public OperatorBase {
+ public:
+  using OperatorBase::OperatorBase;
+  bool Run(int /* unused */) override {
+    std::lock_guard<std::mutex> guard(gRunsMutex);
+    gThreads[debug_def().name()].insert(std::this_thread::get_id());
+    ++gRuns[debug_def().name()];
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(PlanExecutorTest, PlanExecutorTestOp);
+OPERATOR_SCHEMA(PlanExecutorTest).NumInputs(0).NumOutputs(0);
+
+PlanDef ConcurrentPlan(int num_iter, int num_instances) {
+  PlanDef plan;
+  plan.set_name("concurrent_plan");
+  auto* step = plan.add_execution_step();
+  step->set_name("concurrent_step");
+  step->set_concurrent_substeps(true);
+  step->set_num_iter(num_iter);
+  if (num_instances > 1) {
+    step->set_num_concurrent_instances(num_instances);
+  }
+  for (const std::string name : {"first", "second"}) {
+    auto* net = plan.add_network();
+    net->set_name(name);
+    auto* op = net->add_op();
+    op->set_type("PlanExecutorTest");
+    op->set_name(name);
+    auto* substep = step->add_substep();
+    substep->set_name(name + "_step");
+    substep->add_network(name);
+  }
+  return plan;
+}
+
+} // namespace
+
+TEST(PlanExecutorTest, ConcurrentSubstepsReuseThreads) {
+  gThreads.clear();
+  gRuns.clear();
+  Workspace ws;
+  ASSERT_TRUE(ws.RunPlan(ConcurrentPlan(20, 1)));
+  for (const std::string name : {"first", "second"}) {
+    EXPECT_EQ(gRuns[name], 20);
+    // every iteration ran the substep on the same thread
+    EXPECT_EQ(gThreads[name].size(), 1);
+  }
+  EXPECT_NE(*gThreads["first"].begin(), *gThreads["second"].begin());
+}
+
+TEST(PlanExecutorTest, ConcurrentInstances) {
+  gThreads.clear();
+  gRuns.clear();
+  Workspace ws;
+  ASSERT_TRUE(ws.RunPlan(ConcurrentPlan(10, 3)));
+  for (const std::string name : {"first", "second"}) {
+    EXPECT_EQ(gRuns[name], 30);
+    EXPECT_EQ(gThreads[name].size(), 3);
+  }
+}
+
+TEST(PlanExecutorTest, StepExecutionTime) {
+  StatRegistry::get().publish(true);
+  Workspace ws;
+  ASSERT_TRUE(ws.RunPlan(ConcurrentPlan(5, 1)));
+  auto stats = toMap(StatRegistry::get().publish());
+  EXPECT_EQ(stats["concurrent_step/step_execution_time_ns/count"], 1);
+  EXPECT_EQ(stats["first_step/step_execution_time_ns/count"], 5);
+  EXPECT_EQ(stats["second_step/step_execution_time_ns/count"], 5);
+  EXPECT_GT(stats["concurrent_step/step_execution_time_ns/sum"], 0);
+}
+
+} // namespace caffe2
@@ -1,35 +1,45 @@
 #include "caffe2/core/predictor.h"
+#include "caffe2/core/flags.h"
+#include "caffe2/core/scope_guard.h"
+#include "caffe2/utils/packed_gemm.h"
 
 #include <unordered_set>
 
+CAFFE2_DEFINE_bool(
+    caffe2_predictor_pack_gemm_weights,
+    false,
+    "Pack the constant weights of the FC and Conv operators of the run net "
+    "for the CPU GEMM backend when creating a Predictor.");
+
 namespace caffe2 {
 
 namespace {
 
-void enforceIsTensor(Workspace* ws, const std::string& name) {
-  auto blob = ws->GetBlob(name);
+TensorCPU* tensorOf(Blob* blob, const std::string& name) {
   CAFFE_ENFORCE(blob, "Blob does not exist: ", name);
   CAFFE_ENFORCE(
       blob->template IsType<TensorCPU>(), "Blob is not a CPU Tensor: ", name);
+  return blob->template GetMutable<TensorCPU>();
+}
+
+void shareInputTensor(TensorCPU* tensor, TensorCPU* input) {
+  tensor->ResizeLike(*input);
+  tensor->ShareData(*input);
 }
 
 void shareInputTensor(
     Workspace* ws,
     const std::string& name,
     TensorCPU* input) {
-  enforceIsTensor(ws, name);
-  auto* blob = ws->GetBlob(name);
-  CAFFE_ENFORCE(blob, "Blob: ", name, " does not exist");
-  auto* tensor = blob->template GetMutable<TensorCPU>();
-  tensor->ResizeLike(*input);
-  tensor->ShareData(*input);
+  shareInputTensor(tensorOf(ws->GetBlob(name), name), input);
 }
 
 TensorCPU* extractOutputTensor(Workspace* ws, const std::string& name) {
-  enforceIsTensor(ws, name);
-  auto* blob = ws->GetBlob(name);
-  CAFFE_ENFORCE(blob, "Blob: ", name, " does not exist");
-  return blob->template GetMutable<TensorCPU>();
+  return tensorOf(ws->GetBlob(name), name);
+}
+
+TensorCPU* extractOutputTensor(Workspace* ws, Workspace::BlobId id) {
+  return tensorOf(ws->GetBlob(id), ws->BlobName(id));
 }
 
 const NetDef& getNet(const MetaNetDef& def, const std::string& name) {
@@ -76,15 +86,24 @@ Predictor::Predictor(
 
   // real model inputs can be fed later in run* functions
   const auto& initialized_vec = ws_.Blobs();
-  const std::unordered_set<std::string> initialized{initialized_vec.begin(),
-                                                    initialized_vec.end()};
+  parameters_.insert(initialized_vec.begin(), initialized_vec.end());
   for (const auto& name : run_net.external_input()) {
-    if (!initialized.count(name)) {
+    if (!parameters_.count(name)) {
       auto* blob = ws_.CreateBlob(name);
       blob->template GetMutable<TensorCPU>();
     }
   }
-  CAFFE_ENFORCE(ws_.CreateNet(run_net));
+  if (FLAGS_caffe2_predictor_pack_gemm_weights) {
+    const int packed = PackGemmWeights(&run_net_, &ws_, &parameters_);
+    VLOG(1) << "Packed " << packed << " GEMM weights of " << run_net_.name();
+  }
+  CAFFE_ENFORCE(ws_.CreateNet(run_net_));
+  for (const auto& name : run_net_.external_input()) {
+    input_ids_.push_back(ws_.GetBlobId(name));
+  }
+  for (const auto& name : run_net_.external_output()) {
+    output_ids_.push_back(ws_.GetBlobId(name));
+  }
 }
 
 Predictor::~Predictor() {}
@@ -92,16 +111,16 @@ Predictor::~Predictor() {}
 bool Predictor::run(const TensorVector& inputs, TensorVector* outputs) {
   CAFFE_ENFORCE(inputs.size() <= run_net_.external_input_size());
   for (auto i = 0; i < inputs.size(); ++i) {
-    shareInputTensor(&ws_, run_net_.external_input(i), inputs[i]);
+    shareInputTensor(extractOutputTensor(&ws_, input_ids_[i]), inputs[i]);
   }
 
   if (!ws_.RunNet(run_net_.name())) {
     return false;
   }
 
-  outputs->resize(run_net_.external_output_size());
+  outputs->resize(output_ids_.size());
   for (auto i = 0; i < outputs->size(); ++i) {
-    (*outputs)[i] = extractOutputTensor(&ws_, run_net_.external_output(i));
+    (*outputs)[i] = extractOutputTensor(&ws_, output_ids_[i]);
   }
   return true;
 }
@@ -121,10 +140,167 @@ bool Predictor::run_map(const TensorMap& inputs, TensorVector* outputs) {
     return false;
   }
 
+  outputs->resize(output_ids_.size());
+  for (auto i = 0; i < outputs->size(); ++i) {
+    (*outputs)[i] = extractOutputTensor(&ws_, output_ids_[i]);
+  }
+  return true;
+}
+
+Predictor::PreparedBinding Predictor::prepare(
+    const std::vector<std::string>& input_names) {
+  PreparedBinding binding;
+  for (const auto& name : input_names) {
+    binding.inputs.push_back(extractOutputTensor(&ws_, name));
+  }
+  for (const auto& name : run_net_.external_output()) {
+    // outputs may not exist until the first run
+    binding.outputs.push_back(
+        ws_.CreateBlob(name)->template GetMutable<TensorCPU>());
+  }
+  binding.net = ws_.GetNet(run_net_.name());
+  CAFFE_ENFORCE(binding.net, "Net not found: ", run_net_.name());
+  return binding;
+}
+
+Predictor::PreparedBinding Predictor::prepare() {
+  std::vector<std::string> input_names;
+  for (const auto& name : run_net_.external_input()) {
+    if (!parameters_.count(name)) {
+      input_names.push_back(name);
+    }
+  }
+  return prepare(input_names);
+}
+
+bool Predictor::run_prepared(
+    const PreparedBinding& binding,
+    const TensorVector& inputs,
+    const TensorVector& outputs) {
+  CAFFE_ENFORCE_EQ(inputs.size(), binding.inputs.size());
+  CAFFE_ENFORCE_EQ(outputs.size(), binding.outputs.size());
+  for (auto i = 0; i < inputs.size(); ++i) {
+    binding.inputs[i]->ResizeLike(*inputs[i]);
+    binding.inputs[i]->ShareData(*inputs[i]);
+  }
+  for (auto i = 0; i < outputs.size(); ++i) {
+    if (outputs[i]->capacity_nbytes() > 0) {
+      binding.outputs[i]->ResizeLike(*outputs[i]);
+      binding.outputs[i]->ShareData(*outputs[i]);
+    }
+  }
+
+  bool success = binding.net->Run();
+
+  for (auto i = 0; i < outputs.size(); ++i) {
+    auto* output = binding.outputs[i];
+    bool supplied = outputs[i]->capacity_nbytes() > 0;
+    if (success &&
+        (!supplied || output->raw_data() != outputs[i]->raw_data() ||
+         output->dims() != outputs[i]->dims())) {
+      outputs[i]->ResizeLike(*output);
+      outputs[i]->ShareData(*output);
+    }
+    if (supplied) {
+      // don't hold on to the caller's buffer until the next run
+      output->FreeMemory();
+    }
+  }
+  return success;
+}
+
+std::unique_ptr<Workspace> Predictor::acquireWorkspace() {
+  {
+    std::lock_guard<std::mutex> lock(workspaces_mutex_);
+    if (!free_workspaces_.empty()) {
+      auto ws = std::move(free_workspaces_.back());
+      free_workspaces_.pop_back();
+      return ws;
+    }
+  }
+
+  auto ws = caffe2::make_unique<Workspace>(&ws_);
+  // Blobs that run_net writes have to be local, or the child workspaces would
+  // share them through the parent
+  for (const auto& name : run_net_.external_input()) {
+    if (!parameters_.count(name)) {
+      ws->CreateLocalBlob(name)->template GetMutable<TensorCPU>();
+    }
+  }
+  for (const auto& op : run_net_.op()) {
+    for (const auto& output : op.output()) {
+      CAFFE_ENFORCE(
+          !parameters_.count(output),
+          "run_net writes to parameter ",
+          output,
+          ", which is shared by concurrent runs");
+      ws->CreateLocalBlob(output);
+    }
+  }
+  for (const auto& output : run_net_.external_output()) {
+    CAFFE_ENFORCE(
+        !parameters_.count(output),
+        "Parameter ",
+        output,
+        " can't be an output of concurrent runs");
+  }
+  CAFFE_ENFORCE(ws->CreateNet(run_net_));
+  return ws;
+}
+
+void Predictor::releaseWorkspace(std::unique_ptr<Workspace> ws) {
+  std::lock_guard<std::mutex> lock(workspaces_mutex_);
+  free_workspaces_.push_back(std::move(ws));
+}
+
+bool Predictor::runInWorkspace(Workspace* ws, OutputTensorVector* outputs) {
+  if (!ws->RunNet(run_net_.name())) {
+    return false;
+  }
+
   outputs->resize(run_net_.external_output_size());
   for (auto i = 0; i < outputs->size(); ++i) {
-    (*outputs)[i] = extractOutputTensor(&ws_, run_net_.external_output(i));
+    (*outputs)[i].swap(
+        *extractOutputTensor(ws, run_net_.external_output(i)));
   }
   return true;
 }
+
+bool Predictor::run_concurrent(
+    const TensorVector& inputs,
+    OutputTensorVector* outputs) {
+  CAFFE_ENFORCE(inputs.size() <= run_net_.external_input_size());
+  auto ws = acquireWorkspace();
+  auto* ws_ptr = ws.get();
+  auto g = MakeGuard([&]() { releaseWorkspace(std::move(ws)); });
+  for (auto i = 0; i < inputs.size(); ++i) {
+    const auto& name = run_net_.external_input(i);
+    CAFFE_ENFORCE(
+        !parameters_.count(name), "Can't feed shared parameter ", name);
+    shareInputTensor(ws_ptr, name, inputs[i]);
+  }
+  return runInWorkspace(ws_ptr, outputs);
+}
+
+bool Predictor::run_map_concurrent(
+    const TensorMap& inputs,
+    OutputTensorVector* outputs) {
+  if (!inputNames_.empty()) {
+    CAFFE_ENFORCE_EQ(inputs.size(), inputNames_.size());
+  }
+  auto ws = acquireWorkspace();
+  auto* ws_ptr = ws.get();
+  auto g = MakeGuard([&]() { releaseWorkspace(std::move(ws)); });
+  for (auto input : inputs) {
+    if (!inputNames_.empty()) {
+      CAFFE_ENFORCE_GT(inputNames_.count(input.first), 0);
+    }
+    CAFFE_ENFORCE(
+        !parameters_.count(input.first),
+        "Can't feed shared parameter ",
+        input.first);
+    shareInputTensor(ws_ptr, input.first, input.second);
+  }
+  return runInWorkspace(ws_ptr, outputs);
+}
 } // namespace caffe2
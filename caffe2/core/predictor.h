@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <unordered_set>
 #include "caffe2/core/net.h"
 #include "caffe2/core/tensor.h"
@@ -12,6 +14,7 @@ class Predictor {
  public:
   using TensorVector = std::vector<TensorCPU*>;
   using TensorMap = std::unordered_map<std::string, TensorCPU*>;
+  using OutputTensorVector = std::vector<TensorCPU>;
 
   // MetaNetDef contains 'init_net', 'run_net', and meta-info
   // The meta-info is used to verify inputs are correctly passed
@@ -41,6 +44,43 @@ class Predictor {
   // Similar to run, but consumes a map of name to tensor as input
   bool run_map(const TensorMap& inputs, TensorVector* outputs);
 
+  // Thread-safe versions of run and run_map. Every call runs `run_net` in a
+  // child workspace of ws() that holds its own activations, while the
+  // parameters created by `init_net` are shared by all of them and must not
+  // be written by `run_net`. Child workspaces are pooled and reused across
+  // calls, so that memory is only allocated for as many of them as there are
+  // concurrent calls. The output tensors are moved into `outputs`, since the
+  // workspace is handed to another call once this one returns.
+  // Calls to run and run_map must not overlap with these ones.
+  bool run_concurrent(const TensorVector& inputs, OutputTensorVector* outputs);
+  bool run_map_concurrent(
+      const TensorMap& inputs,
+      OutputTensorVector* outputs);
+
+  // Inputs and outputs of `run_net` resolved to their tensors in ws(), so
+  // that run_prepared doesn't look up blobs or nets by name.
+  struct PreparedBinding {
+    std::vector<TensorCPU*> inputs;
+    std::vector<TensorCPU*> outputs;
+    NetBase* net = nullptr;
+  };
+
+  // Binds `input_names` and all of run_net's external outputs. Without
+  // names, binds the external inputs that `init_net` doesn't create.
+  PreparedBinding prepare(const std::vector<std::string>& input_names);
+  PreparedBinding prepare();
+
+  // Runs `run_net` with `inputs` in the order of the binding's input names.
+  // An output tensor that comes with a buffer of its own (one it allocated
+  // or shares, e.g. through ShareExternalPointer) is written in place when
+  // run_net produces an output of the same shape; otherwise it is made to
+  // share the workspace's output, which stays valid until the next run.
+  // Either way nothing is copied.
+  bool run_prepared(
+      const PreparedBinding& binding,
+      const TensorVector& inputs,
+      const TensorVector& outputs);
+
   const NetDef& def() const {
     return run_net_;
   };
@@ -50,8 +90,20 @@ class Predictor {
   };
 
  private:
+  std::unique_ptr<Workspace> acquireWorkspace();
+  void releaseWorkspace(std::unique_ptr<Workspace> ws);
+  bool runInWorkspace(Workspace* ws, OutputTensorVector* outputs);
+
   NetDef run_net_;
   Workspace ws_;
+  // external inputs and outputs of run_net, interned in ws_
+  std::vector<Workspace::BlobId> input_ids_;
+  std::vector<Workspace::BlobId> output_ids_;
   std::unordered_set<std::string> inputNames_;
+  // blobs created by `init_net` or inherited from the parent workspace
+  std::unordered_set<std::string> parameters_;
+
+  std::mutex workspaces_mutex_;
+  std::vector<std::unique_ptr<Workspace>> free_workspaces_;
 };
 }
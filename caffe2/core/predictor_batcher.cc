@@ -0,0 +1,270 @@
+#include "caffe2/core/predictor_batcher.h"
+
+#include <chrono>
+
+namespace caffe2 {
+
+namespace {
+
+// Histograms are exported as one counter per power of two bucket, the last
+// one also counting everything above it
+constexpr int kHistogramBuckets = 21;
+
+std::vector<std::string> histogramBucketNames() {
+  std::vector<std::string> names;
+  for (int i = 0; i < kHistogramBuckets; ++i) {
+    names.push_back("le_" + caffe2::to_string(int64_t(1) << i));
+  }
+  return names;
+}
+
+size_t histogramBucket(int64_t value) {
+  size_t bucket = 0;
+  while (bucket + 1 < kHistogramBuckets && (int64_t(1) << bucket) < value) {
+    ++bucket;
+  }
+  return bucket;
+}
+
+// Whether a and b can be stacked along their first dimension
+bool sameItemShape(const TensorCPU& a, const TensorCPU& b) {
+  if (a.meta() != b.meta() || a.ndim() != b.ndim()) {
+    return false;
+  }
+  for (int i = 1; i < a.ndim(); ++i) {
+    if (a.dim(i) != b.dim(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<TIndex> withBatchSize(const TensorCPU& tensor, TIndex rows) {
+  auto dims = tensor.dims();
+  dims[0] = rows;
+  return dims;
+}
+
+} // namespace
+
+PredictorBatcher::PredictorBatcher(
+    Predictor* predictor,
+    const Options& options,
+    const std::string& name)
+    : predictor_(predictor), options_(options), stats_(name) {
+  CAFFE_ENFORCE(predictor_);
+  CAFFE_ENFORCE_GT(options_.max_batch_size, 0);
+  CAFFE_ENFORCE_GE(options_.max_wait_us, 0);
+  CAFFE_ENFORCE_GT(options_.max_queue_size, 0);
+  CAFFE_ENFORCE_GT(options_.num_workers, 0);
+  stats_.batch_size_histogram.setDetails(histogramBucketNames());
+  stats_.request_latency_us_histogram.setDetails(histogramBucketNames());
+  for (int i = 0; i < options_.num_workers; ++i) {
+    workers_.emplace_back(&PredictorBatcher::workerLoop, this);
+  }
+}
+
+PredictorBatcher::~PredictorBatcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+bool PredictorBatcher::run(
+    const Predictor::TensorVector& inputs,
+    Predictor::OutputTensorVector* outputs) {
+  CAFFE_ENFORCE(!inputs.empty(), "Batched requests need inputs");
+  for (const auto* input : inputs) {
+    CAFFE_ENFORCE_GT(input->ndim(), 0, "Inputs need a batch dimension");
+  }
+  auto rows = inputs[0]->dim(0);
+  for (const auto* input : inputs) {
+    CAFFE_ENFORCE_EQ(
+        input->dim(0), rows, "Inputs have different batch sizes");
+  }
+
+  Request request;
+  request.inputs = &inputs;
+  request.outputs = outputs;
+  request.rows = rows;
+  auto done = request.done.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CAFFE_ENFORCE(!stopping_, "Batcher is shutting down");
+    if (queue_.size() >= options_.max_queue_size) {
+      CAFFE_EVENT(stats_, rejected_requests);
+      return false;
+    }
+    queue_.push_back(&request);
+    CAFFE_EVENT(stats_, queue_depth, 1);
+  }
+  cv_.notify_all();
+  return done.get();
+}
+
+bool PredictorBatcher::canJoin(
+    const std::vector<Request*>& batch,
+    TIndex rows,
+    Request* r) const {
+  if (batch.empty()) {
+    return true;
+  }
+  if (rows + r->rows > options_.max_batch_size) {
+    return false;
+  }
+  const auto& first = *batch.front()->inputs;
+  const auto& inputs = *r->inputs;
+  if (first.size() != inputs.size()) {
+    return false;
+  }
+  for (auto i = 0; i < inputs.size(); ++i) {
+    if (!sameItemShape(*first[i], *inputs[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PredictorBatcher::workerLoop() {
+  while (true) {
+    std::vector<Request*> batch;
+    TIndex rows = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() {
+        return !collecting_ && (stopping_ || !queue_.empty());
+      });
+      if (queue_.empty()) {
+        // stopping, and nothing left to run
+        return;
+      }
+      collecting_ = true;
+      auto deadline = std::chrono::steady_clock::now() +
+          std::chrono::microseconds(options_.max_wait_us) -
+          std::chrono::microseconds(
+              static_cast<int64_t>(queue_.front()->timer.MicroSeconds()));
+      while (true) {
+        while (!queue_.empty() && canJoin(batch, rows, queue_.front())) {
+          rows += queue_.front()->rows;
+          batch.push_back(queue_.front());
+          queue_.pop_front();
+        }
+        // a request left in the queue can't join, no point in waiting
+        if (rows >= options_.max_batch_size || !queue_.empty() || stopping_ ||
+            std::chrono::steady_clock::now() >= deadline) {
+          break;
+        }
+        cv_.wait_until(lock, deadline);
+      }
+      collecting_ = false;
+      CAFFE_EVENT(stats_, queue_depth, -static_cast<int64_t>(batch.size()));
+    }
+    // let another worker start on the next batch
+    cv_.notify_all();
+    runBatch(batch, rows);
+  }
+}
+
+void PredictorBatcher::runBatch(
+    const std::vector<Request*>& batch,
+    TIndex rows) {
+  CAFFE_EVENT(stats_, batch_size, rows);
+  CAFFE_EVENT(stats_, batch_size_histogram, 1, histogramBucket(rows));
+  for (auto* r : batch) {
+    CAFFE_EVENT(
+        stats_, queue_time_us, static_cast<int64_t>(r->timer.MicroSeconds()));
+  }
+
+  Timer run_timer;
+  std::exception_ptr exception;
+  bool result = false;
+  try {
+    result = runAndSplit(batch, rows);
+  } catch (...) {
+    exception = std::current_exception();
+  }
+  CAFFE_EVENT(
+      stats_,
+      batch_run_time_us,
+      static_cast<int64_t>(run_timer.MicroSeconds()));
+  if (!result) {
+    CAFFE_EVENT(stats_, failed_batches);
+  }
+
+  for (auto* r : batch) {
+    auto latency = static_cast<int64_t>(r->timer.MicroSeconds());
+    CAFFE_EVENT(stats_, request_latency_us, latency);
+    CAFFE_EVENT(
+        stats_, request_latency_us_histogram, 1, histogramBucket(latency));
+    // the request lives on the stack of its caller, which returns as soon
+    // as it is done, so the promise is moved out before it is fulfilled
+    auto done = std::move(r->done);
+    if (exception) {
+      done.set_exception(exception);
+    } else {
+      done.set_value(result);
+    }
+  }
+}
+
+bool PredictorBatcher::runAndSplit(
+    const std::vector<Request*>& batch,
+    TIndex rows) {
+  if (batch.size() == 1) {
+    return predictor_->run_concurrent(
+        *batch.front()->inputs, batch.front()->outputs);
+  }
+
+  CPUContext context;
+  const auto& first = *batch.front()->inputs;
+  std::vector<TensorCPU> batched(first.size());
+  Predictor::TensorVector batched_ptrs;
+  for (auto i = 0; i < first.size(); ++i) {
+    auto& tensor = batched[i];
+    tensor.Resize(withBatchSize(*first[i], rows));
+    auto* dst = static_cast<char*>(tensor.raw_mutable_data(first[i]->meta()));
+    for (auto* r : batch) {
+      const auto& input = *(*r->inputs)[i];
+      context.CopyItems<CPUContext, CPUContext>(
+          input.meta(), input.size(), input.raw_data(), dst);
+      dst += input.nbytes();
+    }
+    batched_ptrs.push_back(&tensor);
+  }
+
+  Predictor::OutputTensorVector outputs;
+  if (!predictor_->run_concurrent(batched_ptrs, &outputs)) {
+    return false;
+  }
+
+  for (auto* r : batch) {
+    r->outputs->resize(outputs.size());
+  }
+  for (auto i = 0; i < outputs.size(); ++i) {
+    const auto& output = outputs[i];
+    CAFFE_ENFORCE(
+        output.ndim() > 0 && output.dim(0) == rows,
+        "Output ",
+        i,
+        " doesn't have the batch as its first dimension");
+    const auto* src = static_cast<const char*>(output.raw_data());
+    for (auto* r : batch) {
+      auto& tensor = (*r->outputs)[i];
+      tensor.Resize(withBatchSize(output, r->rows));
+      context.CopyItems<CPUContext, CPUContext>(
+          output.meta(),
+          tensor.size(),
+          src,
+          tensor.raw_mutable_data(output.meta()));
+      src += tensor.nbytes();
+    }
+  }
+  return true;
+}
+
+} // namespace caffe2
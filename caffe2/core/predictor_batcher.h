@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "caffe2/core/predictor.h"
+#include "caffe2/core/stats.h"
+#include "caffe2/core/timer.h"
+
+namespace caffe2 {
+
+// Coalesces concurrent requests to a Predictor along the batch dimension.
+//
+// Callers block in run() while worker threads take the requests waiting in
+// the queue, concatenate their inputs along the first dimension until the
+// batch has max_batch_size rows or the oldest request has waited for
+// max_wait_us, run the predictor once, and copy each caller's rows of the
+// outputs back into its own tensors. Only requests whose inputs agree on
+// everything but the first dimension end up in the same batch, and every
+// output of `run_net` has to have the batch as its first dimension.
+//
+// Batches run through Predictor::run_concurrent, so the predictor must not
+// be used through run/run_map while a batcher is running on it.
+class PredictorBatcher {
+ public:
+  struct Options {
+    // a single request with more rows than this still runs, on its own
+    int max_batch_size = 32;
+    int64_t max_wait_us = 1000;
+    // run() fails right away once this many requests are waiting
+    size_t max_queue_size = 1024;
+    int num_workers = 1;
+  };
+
+  PredictorBatcher(
+      Predictor* predictor,
+      const Options& options,
+      const std::string& name = "predictor_batcher");
+  ~PredictorBatcher();
+
+  // Same inputs as Predictor::run; all of them must have the same first
+  // dimension. Returns false if the queue is full or the run failed, and
+  // rethrows the exceptions of the batch the request ran in.
+  bool run(
+      const Predictor::TensorVector& inputs,
+      Predictor::OutputTensorVector* outputs);
+
+ private:
+  struct Request {
+    const Predictor::TensorVector* inputs;
+    Predictor::OutputTensorVector* outputs;
+    TIndex rows;
+    Timer timer;
+    std::promise<bool> done;
+  };
+
+  void workerLoop();
+  bool canJoin(const std::vector<Request*>& batch, TIndex rows, Request* r)
+      const;
+  void runBatch(const std::vector<Request*>& batch, TIndex rows);
+  bool runAndSplit(const std::vector<Request*>& batch, TIndex rows);
+
+  Predictor* predictor_;
+  const Options options_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Request*> queue_;
+  // set while a worker is gathering a batch, so that the others don't take
+  // requests that could have joined it
+  bool collecting_ = false;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+
+  struct BatcherStats {
+    CAFFE_STAT_CTOR(BatcherStats);
+    CAFFE_EXPORTED_STAT(queue_depth);
+    CAFFE_EXPORTED_STAT(rejected_requests);
+    CAFFE_EXPORTED_STAT(failed_batches);
+    CAFFE_AVG_EXPORTED_STAT(batch_size);
+    CAFFE_DETAILED_EXPORTED_STAT(batch_size_histogram);
+    CAFFE_AVG_EXPORTED_STAT(queue_time_us);
+    CAFFE_AVG_EXPORTED_STAT(batch_run_time_us);
+    CAFFE_AVG_EXPORTED_STAT(request_latency_us);
+    CAFFE_DETAILED_EXPORTED_STAT(request_latency_us_histogram);
+  } stats_;
+};
+
+} // namespace caffe2
@@ -0,0 +1,116 @@
+#include "caffe2/core/predictor_batcher.h"
+#include "caffe2/core/operator.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread> // NOLINT
+
+namespace caffe2 {
+
+namespace {
+
+const char* predictSpec = R"DOC(
+        name: "predict"
+        type: "simple"
+        external_input: "data"
+        external_input: "W"
+        external_input: "b"
+        external_output: "y"
+        op {
+          input: "data"
+          input: "W"
+          input: "b"
+          output: "y"
+          type: "FC"
+        }
+)DOC";
+
+const char* initSpec = R"DOC(
+        name: "init"
+        type: "simple"
+        op {
+          type: "ConstantFill"
+          output: "W"
+          arg {
+            name: "shape"
+            ints: 10
+            ints: 4
+          }
+          arg {
+            name: "value"
+            f: 2.0
+          }
+        }
+        op {
+          type: "ConstantFill"
+          output: "b"
+          arg {
+            name: "shape"
+            ints: 10
+          }
+          arg {
+            name: "value"
+            f: 1.0
+          }
+        }
+)DOC";
+
+NetDef parseNetDef(const std::string& value) {
+  NetDef def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(value, &def));
+  return def;
+}
+
+} // namespace
+
+TEST(PredictorBatcherTest, ConcurrentRequests) {
+  Predictor predictor(parseNetDef(initSpec), parseNetDef(predictSpec));
+  PredictorBatcher::Options options;
+  options.max_batch_size = 8;
+  options.max_wait_us = 10000;
+  options.num_workers = 2;
+  PredictorBatcher batcher(&predictor, options);
+
+  constexpr int kThreads = 8;
+  std::atomic<int> failures(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < 20; ++i) {
+        // every row of y is 2 * sum(data) + 1, and the caller's rows have to
+        // come back to it
+        TIndex rows = 1 + (t + i) % 2;
+        TensorCPU input(std::vector<TIndex>{rows, 4});
+        for (int j = 0; j < input.size(); ++j) {
+          input.mutable_data<float>()[j] = t + j / 4;
+        }
+        Predictor::OutputTensorVector output;
+        if (!batcher.run({&input}, &output) || output.size() != 1 ||
+            output[0].dims() != std::vector<TIndex>{rows, 10}) {
+          ++failures;
+          continue;
+        }
+        for (int r = 0; r < rows; ++r) {
+          if (output[0].data<float>()[r * 10] != 2 * 4 * (t + r) + 1) {
+            ++failures;
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(failures, 0);
+}
+
+TEST(PredictorBatcherTest, BadInputs) {
+  Predictor predictor(parseNetDef(initSpec), parseNetDef(predictSpec));
+  PredictorBatcher batcher(&predictor, PredictorBatcher::Options());
+  TensorCPU scalar(std::vector<TIndex>{});
+  scalar.mutable_data<float>();
+  Predictor::OutputTensorVector output;
+  EXPECT_THROW(batcher.run({&scalar}, &output), EnforceNotMet);
+}
+
+} // namespace caffe2
@@ -5,6 +5,9 @@
 #include "caffe2/utils/math.h"
 
 #include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <thread> // NOLINT
 
 namespace caffe2 {
 
@@ -197,6 +200,63 @@ TEST_F(PredictorTest, SimpleBatchSizedMapInput) {
   EXPECT_NEAR(output.front()->data<float>()[4], 0.1209, 1E-4);
 }
 
+TEST_F(PredictorTest, PreparedBinding) {
+  auto binding = p_->prepare();
+  EXPECT_EQ(binding.inputs.size(), 1);
+  EXPECT_EQ(binding.outputs.size(), 1);
+
+  auto inputData = randomTensor({1, 4}, ctx_.get());
+  Predictor::TensorVector input{inputData->template GetMutable<TensorCPU>()};
+  TensorCPU shared;
+  EXPECT_TRUE(p_->run_prepared(binding, input, {&shared}));
+  EXPECT_TRUE(shared.dims() == std::vector<TIndex>({1, 10}));
+  EXPECT_NEAR(shared.data<float>()[4], 0.1209, 1E-4);
+
+  // caller-owned output buffers are written in place
+  std::vector<float> buffer(10);
+  TensorCPU owned(std::vector<TIndex>{1, 10});
+  owned.ShareExternalPointer(buffer.data());
+  EXPECT_TRUE(p_->run_prepared(binding, input, {&owned}));
+  EXPECT_EQ(owned.data<float>(), buffer.data());
+  EXPECT_NEAR(buffer[4], 0.1209, 1E-4);
+}
+
+TEST_F(PredictorTest, ConcurrentRuns) {
+  Predictor::OutputTensorVector expected;
+  auto inputData = randomTensor({1, 4}, ctx_.get());
+  Predictor::TensorVector input{inputData->template GetMutable<TensorCPU>()};
+  EXPECT_TRUE(p_->run_concurrent(input, &expected));
+  EXPECT_EQ(expected.size(), 1);
+  EXPECT_NEAR(expected.front().data<float>()[4], 0.1209, 1E-4);
+
+  std::vector<std::thread> threads;
+  std::atomic<int> failures(0);
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 100; ++i) {
+        Predictor::OutputTensorVector output;
+        if (!p_->run_concurrent(input, &output) || output.size() != 1 ||
+            output.front().size() != expected.front().size() ||
+            memcmp(
+                output.front().data<float>(),
+                expected.front().data<float>(),
+                output.front().nbytes())) {
+          ++failures;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(failures, 0);
+
+  // parameters are shared and can't be fed
+  input.push_back(inputData->template GetMutable<TensorCPU>());
+  Predictor::OutputTensorVector output;
+  EXPECT_THROW(p_->run_concurrent(input, &output), EnforceNotMet);
+}
+
 class PredictorMetaNetDefTest : public testing::Test {
  public:
   void SetUp() override {
@@ -75,6 +75,15 @@ class Registry {
     return registry_[key](args...);
   }
 
+  /**
+   * Returns the creator registered for the key, or an empty function if there
+   * is none, for callers that create objects for the same key many times.
+   */
+  Creator GetCreator(const SrcType& key) {
+    auto it = registry_.find(key);
+    return it == registry_.end() ? Creator() : it->second;
+  }
+
   /**
    * Returns the keys currently registered as a vector.
    */
@@ -0,0 +1,219 @@
+#include "caffe2/core/sampling_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+CAFFE2_DEFINE_int(
+    caffe2_sampling_profiler_every_n,
+    0,
+    "If positive, every net records the times of its operators into an "
+    "in-memory trace on one out of this many runs");
+CAFFE2_DEFINE_int(
+    caffe2_sampling_profiler_buffer_size,
+    16384,
+    "The number of events the sampling profiler keeps");
+
+namespace caffe2 {
+
+namespace {
+
+int32_t currentThreadId() {
+  static std::atomic<int32_t> next_id{0};
+  thread_local int32_t id = next_id++;
+  return id;
+}
+
+void copyTruncated(char* dst, size_t size, const std::string& src) {
+  auto n = std::min(size - 1, src.size());
+  memcpy(dst, src.data(), n);
+  dst[n] = '\0';
+}
+
+size_t roundUpToPowerOfTwo(size_t n) {
+  size_t result = 1;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+void writeJsonString(std::ostringstream& out, const char* s) {
+  out << '"';
+  for (; *s; ++s) {
+    switch (*s) {
+      case '"':
+        out << "\\\"";
+        break;
+      case '\\':
+        out << "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(*s) < 0x20) {
+          out << ' ';
+        } else {
+          out << *s;
+        }
+    }
+  }
+  out << '"';
+}
+
+class SamplingProfilerOperatorObserver final
+    : public ObserverBase<OperatorBase> {
+ public:
+  SamplingProfilerOperatorObserver(
+      OperatorBase* subject,
+      const SamplingProfilerNetObserver* net_observer)
+      : ObserverBase<OperatorBase>(subject), net_observer_(net_observer) {
+    if (subject->has_debug_def()) {
+      const auto& def = subject->debug_def();
+      name_ = def.name().empty() ? def.type()
+                                 : def.type() + " (" + def.name() + ")";
+    } else {
+      name_ = "unknown";
+    }
+  }
+
+ private:
+  void Start() override {
+    active_ = net_observer_->sampled();
+    if (active_) {
+      start_us_ = ProfilerNowMicros();
+    }
+  }
+
+  void Stop() override {
+    if (active_) {
+      ProfileRingBuffer::Global().Record(
+          net_observer_->net_name(), name_, start_us_, ProfilerNowMicros());
+    }
+  }
+
+  const SamplingProfilerNetObserver* net_observer_;
+  std::string name_;
+  bool active_ = false;
+  int64_t start_us_ = 0;
+};
+
+} // namespace
+
+int64_t ProfilerNowMicros() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch())
+      .count();
+}
+
+ProfileRingBuffer::ProfileRingBuffer(size_t capacity)
+    : slots_(roundUpToPowerOfTwo(std::max<size_t>(capacity, 1))),
+      mask_(slots_.size() - 1) {}
+
+void ProfileRingBuffer::Record(
+    const std::string& net,
+    const std::string& name,
+    int64_t start_us,
+    int64_t end_us) {
+  uint64_t index = next_.fetch_add(1, std::memory_order_relaxed);
+  auto& slot = slots_[index & mask_];
+  // odd while being written, 2 * (index + 1) once complete
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  copyTruncated(slot.event.net, sizeof(slot.event.net), net);
+  copyTruncated(slot.event.name, sizeof(slot.event.name), name);
+  slot.event.start_us = start_us;
+  slot.event.duration_us = end_us - start_us;
+  slot.event.thread_id = currentThreadId();
+  slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+std::vector<ProfileEvent> ProfileRingBuffer::Snapshot() const {
+  std::vector<std::pair<uint64_t, ProfileEvent>> events;
+  events.reserve(slots_.size());
+  for (const auto& slot : slots_) {
+    uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before == 0 || before % 2 == 1) {
+      continue;
+    }
+    ProfileEvent event = slot.event;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != before) {
+      // overwritten while we were reading it
+      continue;
+    }
+    events.emplace_back(before, event);
+  }
+  std::sort(
+      events.begin(),
+      events.end(),
+      [](const std::pair<uint64_t, ProfileEvent>& a,
+         const std::pair<uint64_t, ProfileEvent>& b) {
+        return a.first < b.first;
+      });
+  std::vector<ProfileEvent> result;
+  result.reserve(events.size());
+  for (const auto& e : events) {
+    result.push_back(e.second);
+  }
+  return result;
+}
+
+void ProfileRingBuffer::Clear() {
+  for (auto& slot : slots_) {
+    slot.sequence.store(0, std::memory_order_relaxed);
+  }
+}
+
+ProfileRingBuffer& ProfileRingBuffer::Global() {
+  static ProfileRingBuffer buffer(
+      std::max(FLAGS_caffe2_sampling_profiler_buffer_size, 1));
+  return buffer;
+}
+
+SamplingProfilerNetObserver::SamplingProfilerNetObserver(
+    NetBase* subject,
+    int every_n)
+    : ObserverBase<NetBase>(subject),
+      every_n_(every_n),
+      net_name_(subject->Name()) {
+  CAFFE_ENFORCE_GT(every_n_, 0);
+  for (auto* op : subject->GetOperators()) {
+    op->AttachObserver(
+        caffe2::make_unique<SamplingProfilerOperatorObserver>(op, this));
+  }
+}
+
+void SamplingProfilerNetObserver::Start() {
+  bool sampled = iteration_++ % every_n_ == 0;
+  if (sampled) {
+    start_us_ = ProfilerNowMicros();
+  }
+  sampled_.store(sampled, std::memory_order_relaxed);
+}
+
+void SamplingProfilerNetObserver::Stop() {
+  if (sampled()) {
+    ProfileRingBuffer::Global().Record(
+        net_name_, "net", start_us_, ProfilerNowMicros());
+  }
+}
+
+std::string GetSamplingProfileChromeTrace() {
+  std::ostringstream out;
+  out << "{\"traceEvents\":[";
+  bool first = true;
+  for (const auto& event : ProfileRingBuffer::Global().Snapshot()) {
+    out << (first ? "\n" : ",\n") << "{\"name\":";
+    writeJsonString(out, event.name);
+    out << ",\"cat\":";
+    writeJsonString(out, event.net);
+    out << ",\"ph\":\"X\",\"ts\":" << event.start_us
+        << ",\"dur\":" << event.duration_us
+        << ",\"pid\":0,\"tid\":" << event.thread_id << "}";
+    first = false;
+  }
+  out << "\n]}\n";
+  return out.str();
+}
+
+} // namespace caffe2
@@ -0,0 +1,97 @@
+#ifndef CAFFE2_CORE_SAMPLING_PROFILER_H_
+#define CAFFE2_CORE_SAMPLING_PROFILER_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/flags.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+
+CAFFE2_DECLARE_int(caffe2_sampling_profiler_every_n);
+
+namespace caffe2 {
+
+// A net or operator run recorded by the sampling profiler
+struct ProfileEvent {
+  char net[32];
+  char name[96];
+  int64_t start_us;
+  int64_t duration_us;
+  int32_t thread_id;
+};
+
+// A fixed size buffer that keeps the latest events. Writers claim a slot with
+// a single atomic increment and never block each other; every slot carries a
+// sequence number, so that a reader can tell a complete event from one that
+// is being overwritten and skip the latter.
+class ProfileRingBuffer {
+ public:
+  explicit ProfileRingBuffer(size_t capacity);
+
+  void Record(
+      const std::string& net,
+      const std::string& name,
+      int64_t start_us,
+      int64_t end_us);
+
+  // The events currently in the buffer, oldest first
+  std::vector<ProfileEvent> Snapshot() const;
+
+  void Clear();
+
+  // Sized by --caffe2_sampling_profiler_buffer_size on first use
+  static ProfileRingBuffer& Global();
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> sequence{0};
+    ProfileEvent event;
+  };
+
+  std::vector<Slot> slots_;
+  const uint64_t mask_;
+  std::atomic<uint64_t> next_{0};
+};
+
+// Records the run of the net and of all of its operators into the global
+// ProfileRingBuffer on one out of every `every_n` runs, and does nothing but
+// bump a counter on the others. Attached to every net when
+// --caffe2_sampling_profiler_every_n is positive.
+class SamplingProfilerNetObserver final : public ObserverBase<NetBase> {
+ public:
+  SamplingProfilerNetObserver(NetBase* subject, int every_n);
+
+  bool sampled() const {
+    return sampled_.load(std::memory_order_relaxed);
+  }
+
+  const std::string& net_name() const {
+    return net_name_;
+  }
+
+ private:
+  void Start() override;
+  void Stop() override;
+
+  const int every_n_;
+  const std::string net_name_;
+  int64_t iteration_ = 0;
+  int64_t start_us_ = 0;
+  std::atomic<bool> sampled_{false};
+};
+
+// The content of the global buffer in the Chrome trace event format, which
+// chrome://tracing loads
+std::string GetSamplingProfileChromeTrace();
+
+// Monotonic clock shared by all profile events
+int64_t ProfilerNowMicros();
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_SAMPLING_PROFILER_H_
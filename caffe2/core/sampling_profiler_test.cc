@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/sampling_profiler.h"
+#include "caffe2/core/scope_guard.h"
+
+namespace caffe2 {
+
+TEST(SamplingProfilerTest, RingBufferKeepsLatestEvents) {
+  ProfileRingBuffer buffer(3);
+  for (int i = 0; i < 10; ++i) {
+    buffer.Record("net", caffe2::to_string(i), i, i + 1);
+  }
+  auto events = buffer.Snapshot();
+  ASSERT_EQ(events.size(), 4);
+  EXPECT_STREQ(events[0].name, "6");
+  EXPECT_STREQ(events[3].name, "9");
+  EXPECT_EQ(events[3].start_us, 9);
+  EXPECT_EQ(events[3].duration_us, 1);
+
+  buffer.Clear();
+  EXPECT_TRUE(buffer.Snapshot().empty());
+}
+
+TEST(SamplingProfilerTest, SamplesOneInN) {
+  for (const auto* type : {"simple", "dag", "async_scheduling"}) {
+    NetDef net_def;
+    net_def.set_name("sampled");
+    net_def.set_type(type);
+    for (int i = 0; i < 2; ++i) {
+      auto& op = *net_def.add_op();
+      op.set_type("ConstantFill");
+      op.set_name("fill" + caffe2::to_string(i));
+      op.add_output("out" + caffe2::to_string(i));
+      auto* arg = op.add_arg();
+      arg->set_name("shape");
+      arg->add_ints(4);
+    }
+
+    auto old = FLAGS_caffe2_sampling_profiler_every_n;
+    auto g = MakeGuard([&]() { FLAGS_caffe2_sampling_profiler_every_n = old; });
+    FLAGS_caffe2_sampling_profiler_every_n = 2;
+    ProfileRingBuffer::Global().Clear();
+
+    Workspace ws;
+    auto net = CreateNet(net_def, &ws);
+    for (int i = 0; i < 4; ++i) {
+      ASSERT_TRUE(net->Run());
+    }
+    // two sampled runs, with an event per op and one for the net
+    auto events = ProfileRingBuffer::Global().Snapshot();
+    EXPECT_EQ(events.size(), 6) << type;
+    for (const auto& event : events) {
+      EXPECT_STREQ(event.net, "sampled");
+      EXPECT_GE(event.duration_us, 0);
+    }
+
+    auto trace = GetSamplingProfileChromeTrace();
+    EXPECT_NE(trace.find("\"traceEvents\""), std::string::npos);
+    EXPECT_NE(trace.find("\"ConstantFill (fill1)\""), std::string::npos);
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,349 @@
+#include "caffe2/core/shared_weights.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "caffe2/core/blob_serialization.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/scope_guard.h"
+#include "caffe2/core/types.h"
+#include "caffe2/utils/mmap_prefetch.h"
+
+namespace caffe2 {
+
+// The region starts with a 24 byte header (magic, number of entries and
+// where the data starts), followed by one entry per blob: the size of its
+// name, its data type, the number of dims, the offset and size of its data,
+// the dims and the name, padded to 8 bytes. The data of every blob starts at
+// a multiple of kDataAlignment, so that tensors can be used in place.
+
+namespace {
+
+const char kMagic[8] = {'C', '2', 'S', 'H', 'W', 'G', 'T', '1'};
+constexpr uint64_t kHeaderSize = 24;
+constexpr uint64_t kEntryHeaderSize = 32;
+constexpr uint64_t kDataAlignment = 64;
+
+uint64_t align(uint64_t offset, uint64_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+template <typename T>
+void append(std::string* out, T value) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T read(const char* p) {
+  T v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+void writeAll(
+    int fd,
+    const char* data,
+    uint64_t nbytes,
+    uint64_t offset,
+    const std::string& path) {
+  while (nbytes > 0) {
+    ssize_t written = pwrite(fd, data, nbytes, offset);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    CAFFE_ENFORCE_GT(
+        written, 0, "Failed to write ", path, ": ", strerror(errno));
+    data += written;
+    nbytes -= written;
+    offset += written;
+  }
+}
+
+// A blob as it is written to the region
+struct PublishedBlob {
+  std::string name;
+  TensorProto::DataType data_type;
+  std::vector<TIndex> dims;
+  // the data of tensors shared in place
+  const char* data;
+  uint64_t nbytes;
+  // the data of blobs stored serialized
+  std::string serialized;
+
+  const char* bytes() const {
+    return data ? data : serialized.data();
+  }
+};
+
+PublishedBlob publishedBlob(const Workspace& ws, const std::string& name) {
+  const Blob* blob = ws.GetBlob(name);
+  CAFFE_ENFORCE(blob, "Blob does not exist: ", name);
+  PublishedBlob published;
+  published.name = name;
+  published.data_type = TensorProto_DataType_UNDEFINED;
+  published.data = nullptr;
+  if (blob->IsType<TensorCPU>()) {
+    const auto& tensor = blob->Get<TensorCPU>();
+    auto data_type = TypeMetaToDataType(tensor.meta());
+    if (tensor.size() > 0 && IsFixedSizeDataType(data_type)) {
+      published.data_type = data_type;
+      published.dims = tensor.dims();
+      published.data = static_cast<const char*>(tensor.raw_data());
+      published.nbytes = tensor.nbytes();
+      return published;
+    }
+  }
+  published.serialized = blob->Serialize(name);
+  published.nbytes = published.serialized.size();
+  return published;
+}
+
+} // namespace
+
+SharedWeights::SharedWeights(const std::string& path, void* data, size_t size)
+    : path_(path), data_(data), size_(size) {
+  const char* base = static_cast<const char*>(data_);
+  CAFFE_ENFORCE(
+      size_ >= kHeaderSize && memcmp(base, kMagic, sizeof(kMagic)) == 0,
+      "Not a shared weights region: ",
+      path_);
+  auto num_entries = read<uint64_t>(base + 8);
+  auto data_offset = read<uint64_t>(base + 16);
+  CAFFE_ENFORCE_LE(data_offset, size_, "Truncated shared weights: ", path_);
+  uint64_t offset = kHeaderSize;
+  for (uint64_t i = 0; i < num_entries; ++i) {
+    CAFFE_ENFORCE_LE(
+        offset + kEntryHeaderSize,
+        data_offset,
+        "Corrupted shared weights: ",
+        path_);
+    const char* p = base + offset;
+    auto name_size = read<uint32_t>(p);
+    auto ndim = read<uint32_t>(p + 8);
+    Entry entry;
+    entry.data_type = static_cast<TensorProto::DataType>(read<int32_t>(p + 4));
+    entry.offset = read<uint64_t>(p + 16);
+    entry.nbytes = read<uint64_t>(p + 24);
+    uint64_t entry_size = kEntryHeaderSize + ndim * sizeof(int64_t) + name_size;
+    CAFFE_ENFORCE_LE(
+        offset + entry_size, data_offset, "Corrupted shared weights: ", path_);
+    CAFFE_ENFORCE_LE(
+        entry.offset + entry.nbytes,
+        size_,
+        "Truncated shared weights: ",
+        path_);
+    p += kEntryHeaderSize;
+    for (uint32_t d = 0; d < ndim; ++d, p += sizeof(int64_t)) {
+      entry.dims.push_back(read<int64_t>(p));
+    }
+    entry.name.assign(p, name_size);
+    entries_.push_back(std::move(entry));
+    offset = align(offset + entry_size, 8);
+  }
+}
+
+SharedWeights::~SharedWeights() {
+  UnregisterMappedRegion(data_);
+  if (munmap(data_, size_) != 0) {
+    LOG(ERROR) << "Failed to unmap " << path_ << ": " << strerror(errno);
+  }
+}
+
+void SharedWeights::Publish(
+    const std::string& path,
+    const Workspace& ws,
+    const std::vector<std::string>& blobs) {
+  std::vector<PublishedBlob> published;
+  published.reserve(blobs.size());
+  for (const auto& name : blobs) {
+    published.push_back(publishedBlob(ws, name));
+  }
+
+  std::string index;
+  for (const auto& blob : published) {
+    append<uint32_t>(&index, blob.name.size());
+    append<int32_t>(&index, blob.data_type);
+    append<uint32_t>(&index, blob.dims.size());
+    append<uint32_t>(&index, 0);
+    // filled in below, once the size of the index is known
+    append<uint64_t>(&index, 0);
+    append<uint64_t>(&index, blob.nbytes);
+    for (auto d : blob.dims) {
+      append<int64_t>(&index, d);
+    }
+    index.append(blob.name);
+    index.resize(align(index.size(), 8));
+  }
+  uint64_t data_offset = align(kHeaderSize + index.size(), kDataAlignment);
+  std::vector<uint64_t> offsets;
+  uint64_t size = data_offset;
+  uint64_t entry_offset = 0;
+  for (const auto& blob : published) {
+    offsets.push_back(size);
+    uint64_t offset = size;
+    memcpy(&index[entry_offset + 16], &offset, sizeof(offset));
+    entry_offset = align(
+        entry_offset + kEntryHeaderSize + blob.dims.size() * sizeof(int64_t) +
+            blob.name.size(),
+        8);
+    size = align(size + blob.nbytes, kDataAlignment);
+  }
+
+  std::string header(kMagic, sizeof(kMagic));
+  append<uint64_t>(&header, published.size());
+  append<uint64_t>(&header, data_offset);
+  header.append(index);
+
+  std::string tmp_path = path + ".tmp." + caffe2::to_string(getpid());
+  int fd = open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  CAFFE_ENFORCE_GE(fd, 0, "Failed to create ", tmp_path, ": ", strerror(errno));
+  bool renamed = false;
+  auto guard = MakeGuard([&]() {
+    close(fd);
+    if (!renamed) {
+      unlink(tmp_path.c_str());
+    }
+  });
+  // zero fills the padding
+  CAFFE_ENFORCE_EQ(
+      ftruncate(fd, size),
+      0,
+      "Failed to resize ",
+      tmp_path,
+      ": ",
+      strerror(errno));
+  writeAll(fd, header.data(), header.size(), 0, tmp_path);
+  for (size_t i = 0; i < published.size(); ++i) {
+    writeAll(
+        fd, published[i].bytes(), published[i].nbytes, offsets[i], tmp_path);
+  }
+  CAFFE_ENFORCE_EQ(
+      rename(tmp_path.c_str(), path.c_str()),
+      0,
+      "Failed to rename ",
+      tmp_path,
+      " to ",
+      path,
+      ": ",
+      strerror(errno));
+  renamed = true;
+}
+
+std::shared_ptr<SharedWeights> SharedWeights::Attach(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0 && errno == ENOENT) {
+    return nullptr;
+  }
+  CAFFE_ENFORCE_GE(fd, 0, "Failed to open ", path, ": ", strerror(errno));
+  auto guard = MakeGuard([fd]() { close(fd); });
+  struct stat st;
+  CAFFE_ENFORCE_EQ(
+      fstat(fd, &st), 0, "Failed to stat ", path, ": ", strerror(errno));
+  size_t size = st.st_size;
+  CAFFE_ENFORCE_GE(size, kHeaderSize, "Not a shared weights region: ", path);
+  // The pages are the ones of the file in the page cache, shared with every
+  // other process mapping it
+  void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  CAFFE_ENFORCE(
+      data != MAP_FAILED, "Failed to map ", path, ": ", strerror(errno));
+  std::shared_ptr<SharedWeights> weights;
+  try {
+    weights.reset(new SharedWeights(path, data, size));
+  } catch (...) {
+    munmap(data, size);
+    throw;
+  }
+  RegisterMappedRegion(data, size);
+  return weights;
+}
+
+std::shared_ptr<SharedWeights> SharedWeights::AttachOrPublish(
+    const std::string& path,
+    const NetDef& init_net,
+    Workspace* ws) {
+  auto weights = Attach(path);
+  if (!weights) {
+    // Only one of the processes starting at the same time runs init_net,
+    // the others wait for it and attach to what it published
+    std::string lock_path = path + ".lock";
+    int fd = open(lock_path.c_str(), O_RDWR | O_CREAT, 0644);
+    CAFFE_ENFORCE_GE(
+        fd, 0, "Failed to open ", lock_path, ": ", strerror(errno));
+    auto guard = MakeGuard([fd]() { close(fd); });
+    int ret;
+    while ((ret = flock(fd, LOCK_EX)) != 0 && errno == EINTR) {
+    }
+    CAFFE_ENFORCE_EQ(
+        ret, 0, "Failed to lock ", lock_path, ": ", strerror(errno));
+    weights = Attach(path);
+    if (!weights) {
+      Workspace init_ws;
+      CAFFE_ENFORCE(init_ws.RunNetOnce(init_net));
+      Publish(path, init_ws, init_ws.Blobs());
+      weights = Attach(path);
+      CAFFE_ENFORCE(weights, "Failed to attach to ", path);
+    }
+  }
+  weights->ShareInto(ws);
+  return weights;
+}
+
+void SharedWeights::Remove(const std::string& path) {
+  for (const auto& p : {path, path + ".lock"}) {
+    CAFFE_ENFORCE(
+        unlink(p.c_str()) == 0 || errno == ENOENT,
+        "Failed to remove ",
+        p,
+        ": ",
+        strerror(errno));
+  }
+}
+
+void SharedWeights::ShareInto(Workspace* ws) const {
+  for (const auto& entry : entries_) {
+    ShareEntry(entry, ws->CreateBlob(entry.name));
+  }
+}
+
+void SharedWeights::ShareBlob(const std::string& name, Blob* blob) const {
+  for (const auto& entry : entries_) {
+    if (entry.name == name) {
+      ShareEntry(entry, blob);
+      return;
+    }
+  }
+  CAFFE_THROW("Blob ", name, " is not in shared weights ", path_);
+}
+
+void SharedWeights::ShareEntry(const Entry& entry, Blob* blob) const {
+  const char* data = static_cast<const char*>(data_) + entry.offset;
+  if (entry.data_type == TensorProto_DataType_UNDEFINED) {
+    blob->Deserialize(std::string(data, entry.nbytes));
+    return;
+  }
+  auto self = shared_from_this();
+  auto* tensor = blob->GetMutable<TensorCPU>();
+  tensor->Resize(entry.dims);
+  // the mapping is read-only, writing to the tensor faults
+  tensor->ShareExternalPointer(
+      const_cast<char*>(data),
+      DataTypeToTypeMeta(entry.data_type),
+      entry.nbytes,
+      [self](void*) {});
+}
+
+std::vector<std::string> SharedWeights::Blobs() const {
+  std::vector<std::string> names;
+  for (const auto& entry : entries_) {
+    names.push_back(entry.name);
+  }
+  return names;
+}
+
+} // namespace caffe2
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/workspace.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+// Parameters laid out in one file that is written once and then mapped
+// read-only by every process that serves the model, so that a host holds a
+// single copy of the weights in the page cache instead of one per process.
+// A path under /dev/shm gives a POSIX shared memory region, any other path a
+// file-backed one.
+//
+// CPU tensors of the fixed size types are shared in place: the tensors that
+// ShareInto creates point into the mapping, which stays alive as long as any
+// of them does. Writing to them faults, so nets that use them, e.g. the
+// run_net of a Predictor, must treat them as constants. Other blobs are
+// stored serialized and deserialized into memory of the attaching process.
+//
+// The pages of the region are read from disk as they are first touched and
+// may be evicted again, so a region can be larger than memory, e.g. one that
+// holds embedding tables on NVMe. The mapping is registered with
+// RegisterMappedRegion, and lookups into it prefetch the rows they read.
+class SharedWeights : public std::enable_shared_from_this<SharedWeights> {
+ public:
+  ~SharedWeights();
+
+  // Writes `blobs` of `ws` to `path`. The region is written under a
+  // temporary name and renamed into place, so that processes attaching
+  // concurrently never see it partially written.
+  static void Publish(
+      const std::string& path,
+      const Workspace& ws,
+      const std::vector<std::string>& blobs);
+
+  // Maps the region at `path` read-only. Returns nullptr if there is none.
+  static std::shared_ptr<SharedWeights> Attach(const std::string& path);
+
+  // Attaches to `path`, publishing the blobs that `init_net` creates first if
+  // no other process has, and shares them into `ws`. Predictors created
+  // with `ws` as their parent workspace then run on the shared weights:
+  //
+  //   Workspace weights;
+  //   SharedWeights::AttachOrPublish(path, init_net, &weights);
+  //   Predictor predictor(NetDef(), run_net, &weights);
+  static std::shared_ptr<SharedWeights> AttachOrPublish(
+      const std::string& path,
+      const NetDef& init_net,
+      Workspace* ws);
+
+  // Removes the region at `path`. Processes that attached to it keep their
+  // mappings.
+  static void Remove(const std::string& path);
+
+  // Creates a blob in `ws` for each blob of the region.
+  void ShareInto(Workspace* ws) const;
+
+  // Makes `blob` share the blob `name` of the region.
+  void ShareBlob(const std::string& name, Blob* blob) const;
+
+  std::vector<std::string> Blobs() const;
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  struct Entry {
+    std::string name;
+    // UNDEFINED for blobs stored serialized
+    TensorProto::DataType data_type;
+    std::vector<TIndex> dims;
+    uint64_t offset;
+    uint64_t nbytes;
+  };
+
+  SharedWeights(const std::string& path, void* data, size_t size);
+
+  void ShareEntry(const Entry& entry, Blob* blob) const;
+
+  std::string path_;
+  void* data_;
+  size_t size_;
+  std::vector<Entry> entries_;
+};
+
+} // namespace caffe2
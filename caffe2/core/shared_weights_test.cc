@@ -0,0 +1,155 @@
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "caffe2/core/predictor.h"
+#include "caffe2/core/shared_weights.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+namespace {
+
+const char* initSpec = R"DOC(
+        name: "init"
+        op {
+          type: "ConstantFill"
+          output: "W"
+          arg {
+            name: "shape"
+            ints: 10
+            ints: 4
+          }
+          arg {
+            name: "value"
+            f: 2.0
+          }
+        }
+        op {
+          type: "ConstantFill"
+          output: "b"
+          arg {
+            name: "shape"
+            ints: 10
+          }
+          arg {
+            name: "value"
+            f: 2.0
+          }
+        }
+)DOC";
+
+const char* predictSpec = R"DOC(
+        name: "predict"
+        external_input: "data"
+        external_input: "W"
+        external_input: "b"
+        external_output: "y"
+        op {
+          input: "data"
+          input: "W"
+          input: "b"
+          output: "y"
+          type: "FC"
+        }
+)DOC";
+
+NetDef parseNetDef(const std::string& value) {
+  NetDef def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(value, &def));
+  return def;
+}
+
+class SharedWeightsTest : public testing::Test {
+ public:
+  void SetUp() override {
+    path_ = "/tmp/caffe2_shared_weights_test_" + caffe2::to_string(getpid());
+    SharedWeights::Remove(path_);
+  }
+
+  void TearDown() override {
+    SharedWeights::Remove(path_);
+  }
+
+  std::string path_;
+};
+
+} // namespace
+
+TEST_F(SharedWeightsTest, PublishAndAttach) {
+  EXPECT_EQ(SharedWeights::Attach(path_), nullptr);
+
+  Workspace ws;
+  auto* floats = ws.CreateBlob("floats")->GetMutable<TensorCPU>();
+  floats->Resize(3, 5);
+  for (int i = 0; i < floats->size(); ++i) {
+    floats->mutable_data<float>()[i] = i * 0.5;
+  }
+  auto* ints = ws.CreateBlob("ints")->GetMutable<TensorCPU>();
+  ints->Resize(7);
+  for (int i = 0; i < ints->size(); ++i) {
+    ints->mutable_data<int64_t>()[i] = i - 3;
+  }
+  auto* strings = ws.CreateBlob("strings")->GetMutable<TensorCPU>();
+  strings->Resize(2);
+  strings->mutable_data<std::string>()[0] = "shared";
+  strings->mutable_data<std::string>()[1] = "weights";
+  SharedWeights::Publish(path_, ws, {"floats", "ints", "strings"});
+
+  auto weights = SharedWeights::Attach(path_);
+  ASSERT_NE(weights, nullptr);
+  EXPECT_EQ(
+      weights->Blobs(),
+      std::vector<std::string>({"floats", "ints", "strings"}));
+
+  Workspace attached;
+  weights->ShareInto(&attached);
+  // the region outlives the handle as long as its tensors are used
+  weights.reset();
+  const auto& shared_floats = attached.GetBlob("floats")->Get<TensorCPU>();
+  EXPECT_EQ(shared_floats.dims(), floats->dims());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(shared_floats.raw_data()) % 64, 0);
+  for (int i = 0; i < floats->size(); ++i) {
+    EXPECT_EQ(shared_floats.data<float>()[i], floats->data<float>()[i]);
+  }
+  const auto& shared_ints = attached.GetBlob("ints")->Get<TensorCPU>();
+  EXPECT_EQ(shared_ints.dims(), ints->dims());
+  for (int i = 0; i < ints->size(); ++i) {
+    EXPECT_EQ(shared_ints.data<int64_t>()[i], ints->data<int64_t>()[i]);
+  }
+  const auto& shared_strings = attached.GetBlob("strings")->Get<TensorCPU>();
+  EXPECT_EQ(shared_strings.size(), 2);
+  EXPECT_EQ(shared_strings.data<std::string>()[0], "shared");
+  EXPECT_EQ(shared_strings.data<std::string>()[1], "weights");
+}
+
+TEST_F(SharedWeightsTest, PredictorOnSharedWeights) {
+  Workspace first;
+  auto weights =
+      SharedWeights::AttachOrPublish(path_, parseNetDef(initSpec), &first);
+  ASSERT_NE(weights, nullptr);
+
+  // a second attachment maps the same region instead of running init_net
+  Workspace second;
+  SharedWeights::AttachOrPublish(path_, NetDef(), &second);
+  EXPECT_EQ(second.GetBlob("W")->Get<TensorCPU>().size(), 40);
+
+  Predictor predictor(NetDef(), parseNetDef(predictSpec), &second);
+  EXPECT_EQ(
+      predictor.ws()->GetBlob("W")->Get<TensorCPU>().raw_data(),
+      second.GetBlob("W")->Get<TensorCPU>().raw_data());
+
+  TensorCPU data(std::vector<TIndex>{1, 4});
+  for (int i = 0; i < data.size(); ++i) {
+    data.mutable_data<float>()[i] = 1;
+  }
+  Predictor::TensorVector output;
+  ASSERT_TRUE(predictor.run({&data}, &output));
+  ASSERT_EQ(output.size(), 1);
+  EXPECT_EQ(output.front()->size(), 10);
+  for (int i = 0; i < output.front()->size(); ++i) {
+    EXPECT_EQ(output.front()->data<float>()[i], 10);
+  }
+}
+
+} // namespace caffe2
@@ -1,5 +1,22 @@
 #pragma once
 
+#include "caffe2/core/macros.h"
+
+// USDT probes of provider "caffe2", which cost a nop until a tracer such as
+// perf or bpftrace attaches to them, e.g.
+//
+//   bpftrace -e 'usdt:libcaffe2.so:caffe2:operator_start { @[str(arg2)] = count(); }'
+//
+// The probes on the hot paths below are compiled in when built with USE_SDT:
+//   operator_start, operator_done       net name, op name, op type, op
+//   cpu_alloc, cuda_alloc               pointer, bytes (, gpu id)
+//   cpu_free, cuda_free                 pointer
+//   cuda_event_record                   event, stream
+//   cuda_event_wait                     event, waiting stream
+//   cuda_event_sync_start, _done        event
+// BlobsQueue always fires queue_read_start/end, queue_write_start/end and
+// queue_close, with the queue name and pointer.
+
 #if defined(__ELF__) && (defined(__x86_64__) || defined(__i386__))
 #include <caffe2/core/static_tracepoint_elfx86.h>
 
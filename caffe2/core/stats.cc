@@ -1,10 +1,83 @@
 #include "caffe2/core/stats.h"
 
+#include <cmath>
 #include <condition_variable>
 #include <thread>
 
 namespace caffe2 {
 
+namespace {
+
+// Position of the highest set bit of a positive value.
+int highestBit(int64_t value) {
+  uint64_t v = value;
+  int bit = 0;
+  for (int shift = 32; shift > 0; shift /= 2) {
+    if (v >> shift) {
+      v >>= shift;
+      bit += shift;
+    }
+  }
+  return bit;
+}
+
+} // namespace
+
+constexpr int StatHistogram::kSubBucketBits;
+constexpr int StatHistogram::kSubBuckets;
+constexpr int StatHistogram::kNumBuckets;
+
+int StatHistogram::bucketIndex(int64_t value) {
+  if (value < 2 * kSubBuckets) {
+    return value;
+  }
+  int shift = highestBit(value) - kSubBucketBits;
+  return shift * kSubBuckets + (value >> shift);
+}
+
+int64_t StatHistogram::bucketLowest(int index) {
+  if (index < 2 * kSubBuckets) {
+    return index;
+  }
+  int shift = index / kSubBuckets - 1;
+  return static_cast<int64_t>(index % kSubBuckets + kSubBuckets) << shift;
+}
+
+int64_t StatHistogram::bucketHighest(int index) {
+  if (index < 2 * kSubBuckets) {
+    return index;
+  }
+  int shift = index / kSubBuckets - 1;
+  return bucketLowest(index) + (int64_t(1) << shift) - 1;
+}
+
+StatHistogram::Snapshot StatHistogram::snapshot(bool reset) {
+  Snapshot snapshot;
+  snapshot.counts.resize(kNumBuckets);
+  for (int i = 0; i < kNumBuckets; ++i) {
+    snapshot.counts[i] = reset ? buckets_[i].exchange(0) : buckets_[i].load();
+    snapshot.count += snapshot.counts[i];
+  }
+  snapshot.sum = reset ? sum_.exchange(0) : sum_.load();
+  snapshot.max = reset ? max_.exchange(0) : max_.load();
+  return snapshot;
+}
+
+int64_t StatHistogram::Snapshot::percentile(double fraction) const {
+  if (count == 0) {
+    return 0;
+  }
+  auto rank = std::max<int64_t>(1, std::ceil(fraction * count));
+  int64_t seen = 0;
+  for (int i = 0; i < counts.size(); ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return std::min(bucketHighest(i), max);
+    }
+  }
+  return max;
+}
+
 ExportedStatMap toMap(const ExportedStatList& stats) {
   ExportedStatMap statMap;
   for (const auto& stat : stats) {
@@ -26,6 +99,18 @@ StatValue* StatRegistry::add(const std::string& name) {
   return value;
 }
 
+StatHistogram* StatRegistry::addHistogram(const std::string& name) {
+  std::lock_guard<std::mutex> lg(mutex_);
+  auto it = histograms_.find(name);
+  if (it != histograms_.end()) {
+    return it->second.get();
+  }
+  auto h = std::unique_ptr<StatHistogram>(new StatHistogram);
+  auto histogram = h.get();
+  histograms_.insert(std::make_pair(name, std::move(h)));
+  return histogram;
+}
+
 void StatRegistry::publish(ExportedStatList& exported, bool reset) {
   std::lock_guard<std::mutex> lg(mutex_);
   exported.resize(stats_.size());
@@ -36,6 +121,20 @@ void StatRegistry::publish(ExportedStatList& exported, bool reset) {
     out.value = reset ? kv.second->reset() : kv.second->get();
     out.ts = std::chrono::high_resolution_clock::now();
   }
+  for (const auto& kv : histograms_) {
+    auto snapshot = kv.second->snapshot(reset);
+    auto ts = std::chrono::high_resolution_clock::now();
+    auto add = [&](const char* suffix, int64_t value) {
+      exported.push_back({kv.first + "/" + suffix, value, ts});
+    };
+    add("count", snapshot.count);
+    add("sum", snapshot.sum);
+    add("max", snapshot.max);
+    add("p50", snapshot.percentile(0.5));
+    add("p90", snapshot.percentile(0.9));
+    add("p99", snapshot.percentile(0.99));
+    add("p999", snapshot.percentile(0.999));
+  }
 }
 
 void StatRegistry::update(const ExportedStatList& data) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <memory>
 #include <mutex>
@@ -28,6 +30,59 @@ class StatValue {
   }
 };
 
+/**
+ * @brief Histogram of non-negative values, e.g. latencies, that can be
+ * updated from many threads without locking.
+ *
+ * Values below 64 get a bucket each; above, every power of two is split in
+ * 32 buckets, so that any value is known within 1/32 of it, as in
+ * HdrHistogram. Percentiles are reported as the largest value of their
+ * bucket, capped by the largest value recorded.
+ */
+class StatHistogram {
+ public:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kNumBuckets = (64 - kSubBucketBits) * kSubBuckets;
+
+  struct Snapshot {
+    std::vector<int64_t> counts;
+    int64_t count = 0;
+    int64_t sum = 0;
+    int64_t max = 0;
+
+    // Value below which the given fraction of the values fall, or 0 if
+    // there are none.
+    int64_t percentile(double fraction) const;
+  };
+
+  void record(int64_t value) {
+    value = std::max<int64_t>(value, 0);
+    buckets_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    int64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max &&
+           !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * Copies the counts. If `reset` is true, resets them to zero; as with
+   * StatValue, no count is lost, but values recorded concurrently may be
+   * split between this snapshot and the next one.
+   */
+  Snapshot snapshot(bool reset = false);
+
+  static int bucketIndex(int64_t value);
+  static int64_t bucketLowest(int index);
+  static int64_t bucketHighest(int index);
+
+ private:
+  std::array<std::atomic<int64_t>, kNumBuckets> buckets_{};
+  std::atomic<int64_t> sum_{0};
+  std::atomic<int64_t> max_{0};
+};
+
 struct ExportedStatValue {
   std::string key;
   int64_t value;
@@ -117,6 +172,7 @@ ExportedStatMap toMap(const ExportedStatList& stats);
 class StatRegistry {
   std::mutex mutex_;
   std::unordered_map<std::string, std::unique_ptr<StatValue>> stats_;
+  std::unordered_map<std::string, std::unique_ptr<StatHistogram>> histograms_;
 
  public:
   /**
@@ -131,10 +187,20 @@ class StatRegistry {
    */
   StatValue* add(const std::string& name);
 
+  /**
+   * Add a new histogram with given name. If a histogram for this name already
+   * exists, returns a pointer to it.
+   */
+  StatHistogram* addHistogram(const std::string& name);
+
   /**
    * Populate an ExportedStatList with current counter values.
    * If `reset` is true, resets all counters to zero. It is guaranteed that no
    * count is lost.
+   *
+   * A histogram is exported as the counters name/count, name/sum and
+   * name/max, and the percentiles name/p50, name/p90, name/p99 and
+   * name/p999. Unlike counters, percentiles don't add up in update().
    */
   void publish(ExportedStatList& exported, bool reset = false);
 
@@ -234,6 +300,25 @@ class StdDevExportedStat : public ExportedStat {
   }
 };
 
+class HistogramExportedStat : public Stat {
+  StatHistogram* histogram_;
+
+ public:
+  HistogramExportedStat(const std::string& gn, const std::string& n)
+      : Stat(gn, n),
+        histogram_(StatRegistry::get().addHistogram(gn + "/" + n)) {}
+
+  int64_t increment(int64_t value) {
+    histogram_->record(value);
+    return value;
+  }
+
+  template <typename T, typename Unused1, typename... Unused>
+  int64_t increment(T value, Unused1, Unused...) {
+    return increment(value);
+  }
+};
+
 class DetailedExportedStat : public ExportedStat {
  private:
   std::vector<ExportedStat> details_;
@@ -306,6 +391,11 @@ _ScopeGuard<T> ScopeGuard(T f) {
     groupName, #name                     \
   }
 
+#define CAFFE_HISTOGRAM_EXPORTED_STAT(name) \
+  HistogramExportedStat name {              \
+    groupName, #name                        \
+  }
+
 #define CAFFE_DETAILED_EXPORTED_STAT(name) \
   DetailedExportedStat name {              \
     groupName, #name                       \
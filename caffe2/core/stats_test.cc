@@ -117,5 +117,53 @@ TEST(StatsTest, StatsTestSimple) {
       toMap(reg2.publish()), ExportedStatMap({{"i1/s3", 0}, {"i2/s3", 0}}));
 }
 
+TEST(StatsTest, StatsTestHistogramBuckets) {
+  for (int64_t value : {0, 1, 63, 64, 65, 100, 1000, 123456789}) {
+    int index = StatHistogram::bucketIndex(value);
+    EXPECT_LE(StatHistogram::bucketLowest(index), value);
+    EXPECT_GE(StatHistogram::bucketHighest(index), value);
+    // within 1/32 of the value
+    EXPECT_LE(
+        StatHistogram::bucketHighest(index) -
+            StatHistogram::bucketLowest(index),
+        value / StatHistogram::kSubBuckets);
+  }
+  EXPECT_LT(
+      StatHistogram::bucketIndex(std::numeric_limits<int64_t>::max()),
+      StatHistogram::kNumBuckets);
+}
+
+TEST(StatsTest, StatsTestHistogram) {
+  struct TestStats {
+    CAFFE_STAT_CTOR(TestStats);
+    CAFFE_HISTOGRAM_EXPORTED_STAT(latency);
+  };
+  TestStats stats("histogram");
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&stats] {
+      for (int i = 1; i <= 1000; ++i) {
+        CAFFE_EVENT(stats, latency, i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto map = toMap(StatRegistry::get().publish(true));
+  EXPECT_EQ(map["histogram/latency/count"], 4000);
+  EXPECT_EQ(map["histogram/latency/sum"], 4 * 500500);
+  EXPECT_EQ(map["histogram/latency/max"], 1000);
+  EXPECT_NEAR(map["histogram/latency/p50"], 500, 500 / 32);
+  EXPECT_NEAR(map["histogram/latency/p90"], 900, 900 / 32);
+  EXPECT_NEAR(map["histogram/latency/p99"], 990, 990 / 32);
+  EXPECT_EQ(map["histogram/latency/p999"], 1000);
+
+  map = toMap(StatRegistry::get().publish());
+  EXPECT_EQ(map["histogram/latency/count"], 0);
+  EXPECT_EQ(map["histogram/latency/p50"], 0);
+}
+
 } // namespace
 } // namespace caffe2
@@ -80,6 +80,21 @@ inline int canonical_axis_index_(int axis_index, int ndims) {
   return axis_index;
 }
 
+/**
+ * @brief How a tensor manages its memory when it is resized over and over,
+ * e.g. with the batch size of the inputs of a net going up and down.
+ */
+struct TensorGrowthPolicy {
+  // When the tensor grows past its capacity, allocate at least this many
+  // percent more than the capacity it had, so that a sequence of growing
+  // sizes only reallocates a logarithmic number of times.
+  float growth_pct = 0;
+  // When the tensor shrinks, keep its memory as long as the unused part of it
+  // is at most this many bytes. If negative, --caffe2_keep_on_shrink and
+  // --caffe2_max_keep_on_shrink_memory decide.
+  int64_t max_retained_bytes = -1;
+};
+
 /**
  * @brief Tensor is the basic class in Caffe2 that stores a contiguous memory
  * with its shape information.
@@ -296,17 +311,38 @@ class Tensor {
         // If tensor is reserved then don't claim its memeory unless capacity_
         // is smaller than new size
         reset_tensor = capacity_ < new_size;
+      } else if (growth_policy_.max_retained_bytes >= 0) {
+        reset_tensor = capacity_ < new_size ||
+            capacity_ - new_size > growth_policy_.max_retained_bytes;
       } else {
         reset_tensor = capacity_ < new_size || !FLAGS_caffe2_keep_on_shrink ||
             capacity_ - new_size > FLAGS_caffe2_max_keep_on_shrink_memory;
       }
 
       if (reset_tensor) {
+        size_t grown_capacity = 0;
+        if (capacity_ < new_size && capacity_ > 0 &&
+            growth_policy_.growth_pct > 0) {
+          grown_capacity = capacity_ * (100 + growth_policy_.growth_pct) / 100;
+        }
         FreeMemory();
+        growth_capacity_ = grown_capacity;
       }
     }
   }
 
+  /**
+   * Sets how this tensor keeps and grows its memory when it is resized. The
+   * policy stays with the tensor, it is not copied or swapped with its data.
+   */
+  void SetGrowthPolicy(const TensorGrowthPolicy& policy) {
+    growth_policy_ = policy;
+  }
+
+  const TensorGrowthPolicy& growth_policy() const {
+    return growth_policy_;
+  }
+
   /**
    * Resize the tensor like the source tensor. Note that this is just a
    * sugar wrapper that essentially calls Resize(src_tensor.dims()).
@@ -353,6 +389,7 @@ class Tensor {
   inline void FreeMemory() {
     data_.reset();
     capacity_ = 0;
+    growth_capacity_ = 0;
     // If reserved is true and we changed tensor memory then it is fine
     // to switch it to false, if Resize is called from Reserve and it triggers
     // FreeMemory() then reserved_ will be set to true at end of Reserve()
@@ -383,6 +420,7 @@ class Tensor {
     std::swap(shares_data_, other.shares_data_);
     std::swap(capacity_, other.capacity_);
     std::swap(reserved_, other.reserved_);
+    std::swap(growth_capacity_, other.growth_capacity_);
   }
 
   /**
@@ -541,12 +579,15 @@ class Tensor {
               deleter(ptr);
             });
         meta_.ctor()(data_.get(), size_);
+        capacity_ = size_ * meta_.itemsize();
       } else {
         // For fundamental type, new and delete is easier.
-        auto ptr_and_deleter = Context::New(size_ * meta_.itemsize());
+        capacity_ =
+            std::max<size_t>(size_ * meta_.itemsize(), growth_capacity_);
+        auto ptr_and_deleter = Context::New(capacity_);
         data_.reset(ptr_and_deleter.first, ptr_and_deleter.second);
       }
-      capacity_ = size_ * meta_.itemsize();
+      growth_capacity_ = 0;
       return data_.get();
     }
   }
@@ -684,6 +725,10 @@ class Tensor {
   bool shares_data_ = false;
   size_t capacity_ = 0;
   bool reserved_ = false;
+  TensorGrowthPolicy growth_policy_;
+  // what the next allocation grows the capacity to, set when a resize past
+  // the capacity frees the memory
+  size_t growth_capacity_ = 0;
   // In case of chunk load we store how much data was already loaded
 
  private:
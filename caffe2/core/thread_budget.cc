@@ -0,0 +1,101 @@
+#include "caffe2/core/thread_budget.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <thread>
+
+#ifdef _OPENMP
+#include "caffe2/core/common_omp.h"
+#endif // _OPENMP
+
+#ifdef CAFFE2_USE_MKL
+#include <mkl.h>
+#endif // CAFFE2_USE_MKL
+
+CAFFE2_DEFINE_int(
+    caffe2_cpu_core_budget,
+    0,
+    "Number of cores shared by the inter-op and intra-op threads of async "
+    "CPU nets with caffe2_net_async_intra_op_budget; 0 for all cores");
+
+CAFFE2_DEFINE_int(
+    caffe2_intra_op_min_us_per_thread,
+    100,
+    "CPU time in microseconds an operator has to cost for every intra-op "
+    "thread it is given by the core budget");
+
+namespace caffe2 {
+
+namespace {
+
+std::atomic<int> runningInterOpTasks(0);
+// intra-op threads beyond the ones running the operators
+std::atomic<int> claimedIntraOpThreads(0);
+thread_local int intraOpThreadLimit = 0;
+
+} // namespace
+
+int CPUCoreBudget() {
+  if (FLAGS_caffe2_cpu_core_budget > 0) {
+    return FLAGS_caffe2_cpu_core_budget;
+  }
+  static const int num_cores =
+      std::max<int>(std::thread::hardware_concurrency(), 1);
+  return num_cores;
+}
+
+int IntraOpThreadsFor(float cost_us, size_t queued) {
+  // The calling thread runs one of the tasks, its own core is always there
+  int free_cores = CPUCoreBudget() -
+      runningInterOpTasks.load(std::memory_order_relaxed) -
+      claimedIntraOpThreads.load(std::memory_order_relaxed) -
+      static_cast<int>(std::min<size_t>(queued, INT_MAX));
+  int wanted = static_cast<int>(
+      cost_us / std::max(FLAGS_caffe2_intra_op_min_us_per_thread, 1));
+  return std::max(std::min(wanted, 1 + std::max(free_cores, 0)), 1);
+}
+
+InterOpTaskGuard::InterOpTaskGuard() {
+  runningInterOpTasks.fetch_add(1, std::memory_order_relaxed);
+}
+
+InterOpTaskGuard::~InterOpTaskGuard() {
+  runningInterOpTasks.fetch_sub(1, std::memory_order_relaxed);
+}
+
+IntraOpThreadsGuard::IntraOpThreadsGuard(int num_threads)
+    : num_threads_(std::max(num_threads, 1)),
+      previous_limit_(intraOpThreadLimit),
+      previous_omp_threads_(0),
+      previous_mkl_threads_(0) {
+  intraOpThreadLimit = num_threads_;
+  claimedIntraOpThreads.fetch_add(
+      num_threads_ - 1, std::memory_order_relaxed);
+#ifdef _OPENMP
+  previous_omp_threads_ = omp_get_max_threads();
+  omp_set_num_threads(num_threads_);
+#endif // _OPENMP
+#ifdef CAFFE2_USE_MKL
+  // 0 when the thread used the global setting, which restores it
+  previous_mkl_threads_ = mkl_set_num_threads_local(num_threads_);
+#endif // CAFFE2_USE_MKL
+}
+
+IntraOpThreadsGuard::~IntraOpThreadsGuard() {
+#ifdef CAFFE2_USE_MKL
+  mkl_set_num_threads_local(previous_mkl_threads_);
+#endif // CAFFE2_USE_MKL
+#ifdef _OPENMP
+  omp_set_num_threads(previous_omp_threads_);
+#endif // _OPENMP
+  claimedIntraOpThreads.fetch_sub(
+      num_threads_ - 1, std::memory_order_relaxed);
+  intraOpThreadLimit = previous_limit_;
+}
+
+int IntraOpThreadLimit() {
+  return intraOpThreadLimit;
+}
+
+} // namespace caffe2
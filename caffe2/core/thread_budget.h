@@ -0,0 +1,69 @@
+#ifndef CAFFE2_CORE_THREAD_BUDGET_H_
+#define CAFFE2_CORE_THREAD_BUDGET_H_
+
+#include <cstddef>
+
+#include "caffe2/core/flags.h"
+
+CAFFE2_DECLARE_int(caffe2_cpu_core_budget);
+CAFFE2_DECLARE_int(caffe2_intra_op_min_us_per_thread);
+
+namespace caffe2 {
+
+// A budget of CPU cores shared by the tasks that the async net executors run
+// in parallel (inter-op parallelism) and the threads that operators use for
+// themselves (intra-op parallelism: ParallelFor, OpenMP, MKL). An operator
+// gets the cores that neither running nor queued tasks nor other operators'
+// intra-op threads claim, so that a net with many independent ops runs each
+// of them on a single thread and a net that is a chain of big ops runs each
+// of them on all cores, instead of the two kinds of threads oversubscribing
+// the cores or leaving them idle.
+
+// caffe2_cpu_core_budget, or the number of cores if it is not set
+int CPUCoreBudget();
+
+// Number of threads an operator that costs `cost_us` microseconds of CPU time
+// should use, given `queued` tasks waiting for an inter-op thread. Cheap
+// operators get a single thread, since handing off work costs more than it
+// saves; others one thread per caffe2_intra_op_min_us_per_thread, as far as
+// the budget allows. Operators whose cost is not known yet (0) get a single
+// thread, so that it can be measured.
+int IntraOpThreadsFor(float cost_us, size_t queued);
+
+// Counts the calling thread as running an inter-op task while it lives.
+class InterOpTaskGuard {
+ public:
+  InterOpTaskGuard();
+  ~InterOpTaskGuard();
+
+ private:
+  InterOpTaskGuard(const InterOpTaskGuard&) = delete;
+  InterOpTaskGuard& operator=(const InterOpTaskGuard&) = delete;
+};
+
+// Limits the intra-op threads of the operators run by the calling thread to
+// `num_threads` while it lives, and claims the threads beyond the calling one
+// from the budget. Sets the thread count of OpenMP and MKL for the calling
+// thread too, where they are used.
+class IntraOpThreadsGuard {
+ public:
+  explicit IntraOpThreadsGuard(int num_threads);
+  ~IntraOpThreadsGuard();
+
+ private:
+  IntraOpThreadsGuard(const IntraOpThreadsGuard&) = delete;
+  IntraOpThreadsGuard& operator=(const IntraOpThreadsGuard&) = delete;
+
+  const int num_threads_;
+  const int previous_limit_;
+  int previous_omp_threads_;
+  int previous_mkl_threads_;
+};
+
+// The limit set by the innermost IntraOpThreadsGuard of the calling thread,
+// or 0 if there is none
+int IntraOpThreadLimit();
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_THREAD_BUDGET_H_
@@ -0,0 +1,58 @@
+#include "caffe2/core/thread_budget.h"
+
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+namespace {
+
+class ThreadBudgetTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    budget_ = FLAGS_caffe2_cpu_core_budget;
+    min_us_per_thread_ = FLAGS_caffe2_intra_op_min_us_per_thread;
+    FLAGS_caffe2_cpu_core_budget = 8;
+    FLAGS_caffe2_intra_op_min_us_per_thread = 100;
+  }
+
+  void TearDown() override {
+    FLAGS_caffe2_cpu_core_budget = budget_;
+    FLAGS_caffe2_intra_op_min_us_per_thread = min_us_per_thread_;
+  }
+
+ private:
+  int budget_;
+  int min_us_per_thread_;
+};
+
+TEST_F(ThreadBudgetTest, ThreadsFollowCost) {
+  InterOpTaskGuard task;
+  EXPECT_EQ(IntraOpThreadsFor(0, 0), 1);
+  EXPECT_EQ(IntraOpThreadsFor(50, 0), 1);
+  EXPECT_EQ(IntraOpThreadsFor(400, 0), 4);
+  // Capped by the budget: 7 cores besides the one of the task
+  EXPECT_EQ(IntraOpThreadsFor(10000, 0), 8);
+}
+
+TEST_F(ThreadBudgetTest, TasksAndClaimsShareTheBudget) {
+  InterOpTaskGuard task;
+  // Queued tasks will need a core soon
+  EXPECT_EQ(IntraOpThreadsFor(10000, 5), 3);
+  {
+    InterOpTaskGuard other_task;
+    IntraOpThreadsGuard threads(3);
+    EXPECT_EQ(IntraOpThreadLimit(), 3);
+    EXPECT_EQ(IntraOpThreadsFor(10000, 0), 5);
+    {
+      InterOpTaskGuard third_task;
+      IntraOpThreadsGuard more_threads(4);
+      EXPECT_EQ(IntraOpThreadLimit(), 4);
+      EXPECT_EQ(IntraOpThreadsFor(10000, 0), 1);
+    }
+    EXPECT_EQ(IntraOpThreadLimit(), 3);
+  }
+  EXPECT_EQ(IntraOpThreadLimit(), 0);
+  EXPECT_EQ(IntraOpThreadsFor(10000, 0), 8);
+}
+
+} // namespace
+} // namespace caffe2
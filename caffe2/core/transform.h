@@ -38,8 +38,11 @@ class Transform {
   /**
    * Apply a Transform onto a NetDef.
    * Returns the transformed NetDef.
+   *
+   * Transforms that rewrite the whole net rather than matched subgraphs, such
+   * as a dataflow pass over the operators in execution order, override it.
    */
-  NetDef ApplyTo(const NetDef& orig_net_def);
+  virtual NetDef ApplyTo(const NetDef& orig_net_def);
 
   virtual ~Transform() {}
 
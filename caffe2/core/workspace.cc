@@ -4,6 +4,7 @@
 #include <ctime>
 #include <mutex>
 
+#include "caffe2/core/compiled_net.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/net.h"
 #include "caffe2/core/operator.h"
@@ -70,6 +71,34 @@ void Workspace::PrintBlobSizes() {
               << "%";
   }
   LOG(INFO) << "Total;;" << cumtotal << ";100%";
+  LOG(INFO) << "Retained slack bytes: " << RetainedSlackBytes();
+}
+
+size_t Workspace::RetainedSlackBytes() const {
+  size_t slack = 0;
+  for (const auto& entry : blob_map_) {
+    const Blob* b = entry.second.get();
+    TensorInfoCall shape_fun = GetTensorInfoFunction(b->meta().id());
+    TypeCall type_fun = GetTypeCallFunction(b->meta().id());
+    if (!shape_fun || !type_fun) {
+      continue;
+    }
+    bool shares_data = false;
+    size_t capacity;
+    DeviceOption _device;
+    auto shape = shape_fun(b->GetRaw(), &shares_data, &capacity, &_device);
+    if (shares_data) {
+      continue;
+    }
+    size_t nbytes = type_fun(b->GetRaw()).itemsize();
+    for (const auto d : shape) {
+      nbytes *= d;
+    }
+    if (capacity > nbytes) {
+      slack += capacity - nbytes;
+    }
+  }
+  return slack;
 }
 
 vector<string> Workspace::LocalBlobs() const {
@@ -101,28 +130,44 @@ vector<string> Workspace::Blobs() const {
   return names;
 }
 
+Blob* Workspace::NewLocalBlob(const string& name) {
+  VLOG(1) << "Creating blob " << name;
+  auto& blob = blob_map_[name];
+  blob.reset(new Blob());
+  blob_slots_[GetBlobId(name)].blob = blob.get();
+  return blob.get();
+}
+
 Blob* Workspace::CreateBlob(const string& name) {
-  if (HasBlob(name)) {
+  if (auto* blob = FindLocalBlob(name)) {
     VLOG(1) << "Blob " << name << " already exists. Skipping.";
-  } else if (forwarded_blobs_.count(name)) {
-    // possible if parent workspace deletes forwarded blob
-    VLOG(1) << "Blob " << name << " is already forwarded from parent workspace "
-            << "(blob " << forwarded_blobs_[name].second << "). Skipping.";
-  } else {
-    VLOG(1) << "Creating blob " << name;
-    blob_map_[name] = unique_ptr<Blob>(new Blob());
+    return blob;
+  }
+  auto forwarded = forwarded_blobs_.find(name);
+  if (forwarded != forwarded_blobs_.end()) {
+    if (forwarded->second.first->HasBlob(forwarded->second.second)) {
+      VLOG(1) << "Blob " << name << " already exists. Skipping.";
+    } else {
+      // possible if parent workspace deletes forwarded blob
+      VLOG(1) << "Blob " << name
+              << " is already forwarded from parent workspace "
+              << "(blob " << forwarded->second.second << "). Skipping.";
+    }
+    return GetBlob(name);
+  }
+  if (shared_ && shared_->HasBlob(name)) {
+    VLOG(1) << "Blob " << name << " already exists. Skipping.";
+    return GetBlob(name);
   }
-  return GetBlob(name);
+  return NewLocalBlob(name);
 }
 
 Blob* Workspace::CreateLocalBlob(const string& name) {
-  if (blob_map_.count(name)) {
+  if (auto* blob = FindLocalBlob(name)) {
     VLOG(1) << "Blob " << name << " already exists. Skipping.";
-  } else {
-    VLOG(1) << "Creating blob " << name;
-    blob_map_[name] = unique_ptr<Blob>(new Blob());
+    return blob;
   }
-  return GetBlob(name);
+  return NewLocalBlob(name);
 }
 
 Blob* Workspace::RenameBlob(const string& old_name, const string& new_name) {
@@ -142,9 +187,11 @@ Blob* Workspace::RenameBlob(const string& old_name, const string& new_name) {
   // First delete the old record
   auto value = std::move(it->second);
   blob_map_.erase(it);
+  blob_slots_[blob_ids_.at(old_name)].blob = nullptr;
 
   auto* raw_ptr = value.get();
   blob_map_[new_name] = std::move(value);
+  blob_slots_[GetBlobId(new_name)].blob = raw_ptr;
   return raw_ptr;
 }
 
@@ -153,6 +200,7 @@ bool Workspace::RemoveBlob(const string& name) {
   if (it != blob_map_.end()) {
     VLOG(1) << "Removing blob " << name << " from this workspace.";
     blob_map_.erase(it);
+    blob_slots_[blob_ids_.at(name)].blob = nullptr;
     return true;
   }
 
@@ -162,11 +210,13 @@ bool Workspace::RemoveBlob(const string& name) {
 }
 
 const Blob* Workspace::GetBlob(const string& name) const {
-  if (blob_map_.count(name)) {
-    return blob_map_.at(name).get();
-  } else if (forwarded_blobs_.count(name)) {
-    const auto parent_ws = forwarded_blobs_.at(name).first;
-    const auto& parent_name = forwarded_blobs_.at(name).second;
+  if (auto* blob = FindLocalBlob(name)) {
+    return blob;
+  }
+  auto forwarded = forwarded_blobs_.find(name);
+  if (forwarded != forwarded_blobs_.end()) {
+    const auto parent_ws = forwarded->second.first;
+    const auto& parent_name = forwarded->second.second;
     return parent_ws->GetBlob(parent_name);
   } else if (shared_ && shared_->HasBlob(name)) {
     return shared_->GetBlob(name);
@@ -215,6 +265,33 @@ Blob* Workspace::GetBlob(const string& name) {
   return const_cast<Blob*>(static_cast<const Workspace*>(this)->GetBlob(name));
 }
 
+Workspace::BlobId Workspace::GetBlobId(const string& name) {
+  auto it = blob_ids_.find(name);
+  if (it != blob_ids_.end()) {
+    return it->second;
+  }
+  BlobId id = blob_slots_.size();
+  blob_slots_.push_back(BlobSlot{name, nullptr});
+  blob_ids_.emplace(name, id);
+  return id;
+}
+
+const Blob* Workspace::GetBlob(BlobId id) const {
+  const auto& slot = blob_slots_.at(id);
+  // blobs of other workspaces are looked up every time, as they may change
+  // without this one knowing
+  return slot.blob ? slot.blob : GetBlob(slot.name);
+}
+
+Blob* Workspace::GetBlob(BlobId id) {
+  return const_cast<Blob*>(static_cast<const Workspace*>(this)->GetBlob(id));
+}
+
+Blob* Workspace::CreateBlob(BlobId id) {
+  const auto& slot = blob_slots_.at(id);
+  return slot.blob ? slot.blob : CreateBlob(slot.name);
+}
+
 NetBase* Workspace::CreateNet(const NetDef& net_def, bool overwrite) {
   std::shared_ptr<NetDef> tmp_net_def(new NetDef(net_def));
   return CreateNet(tmp_net_def, overwrite);
@@ -252,6 +329,11 @@ NetBase* Workspace::CreateNet(
   return net_map_[net_def->name()].get();
 }
 
+NetBase* Workspace::CreateNet(const CompiledNetDef& compiled, bool overwrite) {
+  CompiledNetDef::Scope scope(compiled);
+  return CreateNet(compiled.def(), overwrite);
+}
+
 NetBase* Workspace::GetNet(const string& name) {
   if (!net_map_.count(name)) {
     return nullptr;
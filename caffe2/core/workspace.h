@@ -8,6 +8,7 @@
 #include <cstddef>
 #include <mutex>
 #include <typeinfo>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -22,6 +23,7 @@ CAFFE2_DECLARE_bool(caffe2_print_blob_sizes_at_exit);
 
 namespace caffe2 {
 
+class CompiledNetDef;
 class NetBase;
 
 struct StopOnSignal {
@@ -49,6 +51,10 @@ class Workspace {
   typedef std::function<bool(int)> ShouldContinue;
   typedef CaffeMap<string, unique_ptr<Blob> > BlobMap;
   typedef CaffeMap<string, unique_ptr<NetBase> > NetMap;
+  /**
+   * Integer handle of an interned blob name, see GetBlobId().
+   */
+  typedef int BlobId;
   /**
    * Initializes an empty workspace.
    */
@@ -171,11 +177,13 @@ class Workspace {
   inline bool HasBlob(const string& name) const {
     // First, check the local workspace,
     // Then, check the forwarding map, then the parent workspace
-    if (blob_map_.count(name)) {
+    if (FindLocalBlob(name)) {
       return true;
-    } else if (forwarded_blobs_.count(name)) {
-      const auto parent_ws = forwarded_blobs_.at(name).first;
-      const auto& parent_name = forwarded_blobs_.at(name).second;
+    }
+    auto forwarded = forwarded_blobs_.find(name);
+    if (forwarded != forwarded_blobs_.end()) {
+      const auto parent_ws = forwarded->second.first;
+      const auto& parent_name = forwarded->second.second;
       return parent_ws->HasBlob(parent_name);
     } else if (shared_) {
       return shared_->HasBlob(name);
@@ -185,6 +193,14 @@ class Workspace {
 
   void PrintBlobSizes();
 
+  /**
+   * Returns the number of bytes the local tensors of the workspace hold
+   * beyond what their current sizes need, e.g. because they were kept on
+   * shrink or grown ahead of time (see TensorGrowthPolicy). Tensors sharing
+   * their data with others are not counted.
+   */
+  size_t RetainedSlackBytes() const;
+
   /**
    * Creates a blob of the given name. The pointer to the blob is returned, but
    * the workspace keeps ownership of the pointer. If a blob of the given name
@@ -223,6 +239,27 @@ class Workspace {
    */
   Blob* RenameBlob(const string& old_name, const string& new_name);
 
+  /**
+   * Interns a blob name and returns its id, which stays valid for the
+   * lifetime of the workspace whether or not the blob exists. Resolving an
+   * id with GetBlob() or CreateBlob() costs an array access instead of a
+   * string lookup when the blob is local to this workspace, so callers that
+   * resolve the same names over and over should keep ids instead.
+   */
+  BlobId GetBlobId(const string& name);
+  /**
+   * Returns the name of an interned blob.
+   */
+  const string& BlobName(BlobId id) const {
+    return blob_slots_.at(id).name;
+  }
+  /**
+   * Same as the versions taking names, for an interned blob name.
+   */
+  const Blob* GetBlob(BlobId id) const;
+  Blob* GetBlob(BlobId id);
+  Blob* CreateBlob(BlobId id);
+
   /**
    * Creates a network with the given NetDef, and returns the pointer to the
    * network. If there is anything wrong during the creation of the network, a
@@ -236,6 +273,9 @@ class Workspace {
   NetBase* CreateNet(
       const std::shared_ptr<const NetDef>& net_def,
       bool overwrite = false);
+  // Creates a network from a def that has been compiled ahead of time, which
+  // is faster when the same net is instantiated many times.
+  NetBase* CreateNet(const CompiledNetDef& compiled, bool overwrite = false);
   /**
    * Gets the pointer to a created net. The workspace keeps ownership of the
    * network.
@@ -288,7 +328,23 @@ class Workspace {
   std::atomic<int> last_failed_op_net_position;
 
  private:
+  // An interned blob name, and the local blob of that name if there is one
+  struct BlobSlot {
+    string name;
+    Blob* blob;
+  };
+
+  // The local blob of the given name, or nullptr
+  inline Blob* FindLocalBlob(const string& name) const {
+    auto it = blob_ids_.find(name);
+    return it == blob_ids_.end() ? nullptr : blob_slots_[it->second].blob;
+  }
+  Blob* NewLocalBlob(const string& name);
+
   BlobMap blob_map_;
+  // Index of blob_map_ by interned name, which also backs the blob ids
+  std::unordered_map<string, BlobId> blob_ids_;
+  std::vector<BlobSlot> blob_slots_;
   NetMap net_map_;
   const string root_folder_;
   const Workspace* shared_;
@@ -54,6 +54,59 @@ TEST(WorkspaceTest, BlobAccess) {
   EXPECT_FALSE(ws.HasBlob("newblob"));
 }
 
+TEST(WorkspaceTest, BlobIds) {
+  Workspace parent;
+  Workspace ws(&parent);
+
+  // ids are stable and can be taken before the blobs exist
+  auto id = ws.GetBlobId("newblob");
+  EXPECT_EQ(id, ws.GetBlobId("newblob"));
+  EXPECT_NE(id, ws.GetBlobId("otherblob"));
+  EXPECT_EQ(ws.BlobName(id), "newblob");
+  EXPECT_EQ(ws.GetBlob(id), nullptr);
+
+  Blob* blob = ws.CreateBlob(id);
+  EXPECT_NE(blob, nullptr);
+  EXPECT_EQ(ws.GetBlob(id), blob);
+  EXPECT_EQ(ws.GetBlob("newblob"), blob);
+  EXPECT_EQ(ws.CreateBlob("newblob"), blob);
+
+  // ids follow removals and renames
+  EXPECT_TRUE(ws.RemoveBlob("newblob"));
+  EXPECT_EQ(ws.GetBlob(id), nullptr);
+  Blob* other = ws.CreateBlob("otherblob");
+  ws.RenameBlob("otherblob", "newblob");
+  EXPECT_EQ(ws.GetBlob(id), other);
+  EXPECT_EQ(ws.GetBlob(ws.GetBlobId("otherblob")), nullptr);
+
+  // blobs of the shared workspace are resolved too
+  auto shared_id = ws.GetBlobId("sharedblob");
+  EXPECT_EQ(ws.GetBlob(shared_id), nullptr);
+  Blob* shared = parent.CreateBlob("sharedblob");
+  EXPECT_EQ(ws.GetBlob(shared_id), shared);
+  EXPECT_EQ(ws.CreateBlob(shared_id), shared);
+  EXPECT_TRUE(parent.RemoveBlob("sharedblob"));
+  EXPECT_EQ(ws.GetBlob(shared_id), nullptr);
+}
+
+TEST(WorkspaceTest, RetainedSlackBytes) {
+  Workspace ws;
+  EXPECT_EQ(ws.RetainedSlackBytes(), 0);
+  *ws.CreateBlob("foo")->GetMutable<int>() = 1;
+  auto* tensor = ws.CreateBlob("tensor")->GetMutable<TensorCPU>();
+  tensor->Resize(10);
+  tensor->mutable_data<float>();
+  EXPECT_EQ(ws.RetainedSlackBytes(), 0);
+  tensor->Resize(4);
+  EXPECT_EQ(ws.RetainedSlackBytes(), 6 * sizeof(float));
+  // tensors sharing their data do not hold any memory of their own
+  auto* shared = ws.CreateBlob("shared")->GetMutable<TensorCPU>();
+  shared->Resize(4);
+  shared->ShareData(*tensor);
+  shared->Resize(1);
+  EXPECT_EQ(ws.RetainedSlackBytes(), 6 * sizeof(float));
+}
+
 TEST(WorkspaceTest, RunEmptyPlan) {
   PlanDef plan_def;
   Workspace ws;
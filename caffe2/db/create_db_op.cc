@@ -3,7 +3,22 @@
 namespace caffe2 {
 REGISTER_CPU_OPERATOR(CreateDB, CreateDBOp<CPUContext>);
 
-OPERATOR_SCHEMA(CreateDB).NumInputs(0).NumOutputs(1);
+OPERATOR_SCHEMA(CreateDB)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .Arg("db_type", "The type of the db, leveldb by default")
+    .Arg("db", "The path of the db")
+    .Arg("num_shards", "The number of shards the db is split into")
+    .Arg("shard_id", "The shard this reader reads")
+    .Arg(
+        "num_consumers",
+        "If greater than 1, the shard is further split into this many "
+        "sub-shards with a cursor each, which input ops reading the reader "
+        "claim one each, so that they read in parallel")
+    .Arg(
+        "read_ahead",
+        "If positive, every sub-shard keeps this many records prefetched by "
+        "a background thread");
 
 NO_GRADIENT(CreateDB);
 }  // namespace caffe2
@@ -19,13 +19,21 @@ class CreateDBOp final : public Operator<Context> {
         num_shards_(
             OperatorBase::template GetSingleArgument<int>("num_shards", 1)),
         shard_id_(
-            OperatorBase::template GetSingleArgument<int>("shard_id", 0)) {
+            OperatorBase::template GetSingleArgument<int>("shard_id", 0)),
+        num_consumers_(
+            OperatorBase::template GetSingleArgument<int>("num_consumers", 1)),
+        read_ahead_(
+            OperatorBase::template GetSingleArgument<int>("read_ahead", 0)) {
     CAFFE_ENFORCE_GT(db_name_.size(), 0, "Must specify a db name.");
   }
 
   bool RunOnDevice() final {
     OperatorBase::Output<db::DBReader>(0)->Open(
         db_type_, db_name_, num_shards_, shard_id_);
+    if (num_consumers_ > 1 || read_ahead_ > 0) {
+      OperatorBase::Output<db::DBReader>(0)->EnableShardedRead(
+          num_consumers_, read_ahead_);
+    }
     return true;
   }
 
@@ -34,6 +42,8 @@ class CreateDBOp final : public Operator<Context> {
   string db_name_;
   uint32_t num_shards_;
   uint32_t shard_id_;
+  int num_consumers_;
+  int read_ahead_;
   DISABLE_COPY_AND_ASSIGN(CreateDBOp);
 };
 
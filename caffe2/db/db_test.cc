@@ -2,6 +2,7 @@
 #include <iomanip>
 #include <sstream>
 #include <thread>
+#include <unistd.h>
 
 #include "caffe2/core/blob_serialization.h"
 #include "caffe2/core/db.h"
@@ -86,6 +87,49 @@ TEST(DBSeekTest, LMDB) {
   DBSeekTestWrapper("lmdb");
 }
 
+TEST(DBSeekTest, MMapDB) {
+  DBSeekTestWrapper("mmapdb");
+}
+
+TEST(MMapDBTest, ValueViewAndAppend) {
+  std::string name = std::tmpnam(nullptr);
+  ASSERT_TRUE(CreateAndFill("mmapdb", name));
+  {
+    std::unique_ptr<DB> db(CreateDB("mmapdb", name, WRITE));
+    std::unique_ptr<Transaction> trans(db->NewTransaction());
+    trans->Put("10", "a longer value");
+    trans->Commit();
+  }
+  std::unique_ptr<DB> db(CreateDB("mmapdb", name, READ));
+  std::unique_ptr<Cursor> cursor(db->NewCursor());
+  ASSERT_TRUE(cursor->SupportsValueView());
+  int count = 0;
+  for (; cursor->Valid(); cursor->Next()) {
+    EXPECT_EQ(
+        string(cursor->value_data(), cursor->value_size()), cursor->value());
+    ++count;
+  }
+  EXPECT_EQ(count, kMaxItems + 1);
+  cursor->Seek("10");
+  EXPECT_EQ(cursor->value(), "a longer value");
+}
+
+TEST(MMapDBTest, RecoversWithoutIndex) {
+  std::string name = std::tmpnam(nullptr);
+  ASSERT_TRUE(CreateAndFill("mmapdb", name));
+  // cut off the index and part of it
+  FILE* f = fopen(name.c_str(), "rb");
+  ASSERT_TRUE(f);
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fclose(f);
+  ASSERT_EQ(truncate(name.c_str(), size - 20), 0);
+
+  std::unique_ptr<DB> db(CreateDB("mmapdb", name, READ));
+  std::unique_ptr<Cursor> cursor(db->NewCursor());
+  TestCursor(cursor.get());
+}
+
 TEST(DBReaderTest, Reader) {
   std::string name = std::tmpnam(nullptr);
   CreateAndFill("leveldb", name);
@@ -196,5 +240,48 @@ TEST(DBReaderShardedTest, Reader) {
   EXPECT_EQ(value, "05");
 }
 
+static void TestShardedRead(const string& db_type, int read_ahead) {
+  std::string name = std::tmpnam(nullptr);
+  CreateAndFill(db_type, name);
+  // shard 1 of 2 holds the odd keys, split again between 2 consumers
+  DBReader reader(db_type, name, 2, 1);
+  reader.EnableShardedRead(2, read_ahead);
+  EXPECT_EQ(reader.num_read_shards(), 2);
+  int first = reader.AcquireShard();
+  int second = reader.AcquireShard();
+  EXPECT_NE(first, second);
+
+  std::vector<string> keys[2];
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 2; ++i) {
+    threads.emplace_back([&reader, &keys, i] {
+      for (int j = 0; j < 4; ++j) {
+        string key, value;
+        reader.Read(&key, &value, i);
+        EXPECT_EQ(key, value);
+        keys[i].push_back(key);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(keys[0], (std::vector<string>{"01", "05", "09", "01"}));
+  EXPECT_EQ(keys[1], (std::vector<string>{"03", "07", "03", "07"}));
+
+  reader.SeekToFirst();
+  string key, value;
+  reader.Read(&key, &value, 1);
+  EXPECT_EQ(key, "03");
+}
+
+TEST(DBReaderShardedTest, ShardedRead) {
+  TestShardedRead("leveldb", 0);
+}
+
+TEST(DBReaderShardedTest, ShardedReadWithReadAhead) {
+  TestShardedRead("leveldb", 3);
+}
+
 }  // namespace db
 }  // namespace caffe2
@@ -0,0 +1,433 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+#include "caffe2/core/db.h"
+#include "caffe2/core/flags.h"
+#include "caffe2/core/logging.h"
+
+CAFFE2_DEFINE_int64(
+    caffe2_mmapdb_read_ahead_bytes,
+    0,
+    "If positive, mmapdb cursors ask the kernel to read this many bytes past "
+    "the current record ahead of time");
+
+namespace caffe2 {
+namespace db {
+
+// An append-only file of records, read through mmap so that values can be
+// parsed in place from the page cache.
+//
+// The file starts with a 16 byte header (magic and version), followed by the
+// records, each a uint32 key size and a uint32 value size followed by the key
+// and the value, padded to 8 bytes. When a writer closes the db it appends an
+// index, a record header with both sizes set to kIndexMarker followed by the
+// offsets of all records, their count and a second magic, which readers use
+// to get to any record in O(1). Writing to an
+// existing db drops the index and appends records after the last one. A file
+// without an index, e.g. because the writer died, is recovered by scanning
+// the records.
+
+namespace {
+
+const char kMagic[8] = {'C', '2', 'M', 'M', 'A', 'P', 'D', 'B'};
+const char kIndexMagic[8] = {'C', '2', 'M', 'M', 'I', 'D', 'X', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kHeaderSize = 16;
+constexpr uint64_t kRecordHeaderSize = 8;
+// record count and index magic
+constexpr uint64_t kFooterSize = 16;
+constexpr uint32_t kIndexMarker = UINT32_MAX;
+
+uint64_t recordSize(uint64_t key_size, uint64_t value_size) {
+  return (kRecordHeaderSize + key_size + value_size + 7) & ~uint64_t(7);
+}
+
+uint32_t readU32(const char* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint64_t readU64(const char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// Fills offsets with the records of the file and returns where they end
+uint64_t parseFile(
+    const string& source,
+    const char* data,
+    uint64_t size,
+    std::vector<uint64_t>* offsets) {
+  CAFFE_ENFORCE_GE(size, kHeaderSize, "Not an mmapdb file: ", source);
+  CAFFE_ENFORCE(
+      memcmp(data, kMagic, sizeof(kMagic)) == 0,
+      "Not an mmapdb file: ",
+      source);
+  CAFFE_ENFORCE_EQ(
+      readU32(data + sizeof(kMagic)),
+      kVersion,
+      "Unsupported mmapdb version in ",
+      source);
+  offsets->clear();
+  if (size >= kHeaderSize + kFooterSize &&
+      memcmp(data + size - sizeof(kIndexMagic), kIndexMagic,
+             sizeof(kIndexMagic)) == 0) {
+    uint64_t count = readU64(data + size - kFooterSize);
+    CAFFE_ENFORCE_LE(
+        count,
+        (size - kHeaderSize - kFooterSize) / sizeof(uint64_t),
+        "Corrupted mmapdb index in ",
+        source);
+    uint64_t index_start = size - kFooterSize - count * sizeof(uint64_t);
+    CAFFE_ENFORCE(
+        index_start >= kHeaderSize + kRecordHeaderSize &&
+            readU32(data + index_start - kRecordHeaderSize) == kIndexMarker,
+        "Corrupted mmapdb index in ",
+        source);
+    uint64_t end = index_start - kRecordHeaderSize;
+    offsets->resize(count);
+    if (count > 0) {
+      memcpy(offsets->data(), data + index_start, count * sizeof(uint64_t));
+    }
+    for (auto offset : *offsets) {
+      CAFFE_ENFORCE(
+          offset >= kHeaderSize && offset + kRecordHeaderSize <= end,
+          "Corrupted mmapdb index in ",
+          source);
+    }
+    return end;
+  }
+  uint64_t pos = kHeaderSize;
+  while (pos + kRecordHeaderSize <= size) {
+    uint32_t key_size = readU32(data + pos);
+    if (key_size == kIndexMarker) {
+      // the index was not written completely
+      break;
+    }
+    uint64_t next =
+        pos + recordSize(key_size, readU32(data + pos + sizeof(uint32_t)));
+    if (next > size) {
+      // the last record was not written completely
+      break;
+    }
+    offsets->push_back(pos);
+    pos = next;
+  }
+  LOG(WARNING) << "mmapdb " << source << " has no index, recovered "
+               << offsets->size() << " records by scanning it";
+  return pos;
+}
+
+} // namespace
+
+class MMapDB : public DB {
+ public:
+  MMapDB(const string& source, Mode mode);
+  ~MMapDB() {
+    Close();
+  }
+
+  void Close() override;
+  unique_ptr<Cursor> NewCursor() override;
+  unique_ptr<Transaction> NewTransaction() override;
+
+  size_t num_records() const {
+    return offsets_.size();
+  }
+  uint64_t offset(size_t index) const {
+    return offsets_[index];
+  }
+  string key(size_t index) const {
+    const char* record = data_ + offsets_[index];
+    return string(record + kRecordHeaderSize, readU32(record));
+  }
+  const char* value_data(size_t index) const {
+    const char* record = data_ + offsets_[index];
+    return record + kRecordHeaderSize + readU32(record);
+  }
+  size_t value_size(size_t index) const {
+    return readU32(data_ + offsets_[index] + sizeof(uint32_t));
+  }
+
+  // The first record in key order whose key is not less than the given one,
+  // or num_records() if there is none
+  size_t LowerBound(const string& key);
+
+  void WillNeed(uint64_t offset, uint64_t size) const;
+
+  void Append(const string& key, const string& value);
+  void Flush();
+
+ private:
+  void Map();
+  void Unmap();
+
+  string source_;
+  // READ mode
+  const char* data_ = nullptr;
+  uint64_t size_ = 0;
+  std::vector<uint64_t> offsets_;
+  std::once_flag sorted_keys_once_;
+  std::vector<std::pair<string, size_t>> sorted_keys_;
+  // NEW and WRITE mode
+  FILE* file_ = nullptr;
+  uint64_t end_ = 0;
+  std::mutex write_mutex_;
+};
+
+class MMapDBCursor : public Cursor {
+ public:
+  explicit MMapDBCursor(MMapDB* db)
+      : db_(db), read_ahead_(FLAGS_caffe2_mmapdb_read_ahead_bytes) {
+    SeekToFirst();
+  }
+
+  void Seek(const string& key) override {
+    index_ = db_->LowerBound(key);
+    ReadAhead();
+  }
+  bool SupportsSeek() override {
+    return true;
+  }
+  void SeekToFirst() override {
+    index_ = 0;
+    ReadAhead();
+  }
+  void Next() override {
+    ++index_;
+    ReadAhead();
+  }
+  string key() override {
+    CAFFE_ENFORCE(Valid(), "Cursor is at invalid location!");
+    return db_->key(index_);
+  }
+  string value() override {
+    return string(value_data(), value_size());
+  }
+  bool SupportsValueView() override {
+    return true;
+  }
+  const char* value_data() override {
+    CAFFE_ENFORCE(Valid(), "Cursor is at invalid location!");
+    return db_->value_data(index_);
+  }
+  size_t value_size() override {
+    CAFFE_ENFORCE(Valid(), "Cursor is at invalid location!");
+    return db_->value_size(index_);
+  }
+  bool Valid() override {
+    return index_ < db_->num_records();
+  }
+
+ private:
+  // Asks for the next read_ahead_ bytes once the cursor is past the middle
+  // of the window it asked for last, or left it
+  void ReadAhead() {
+    if (read_ahead_ <= 0 || !Valid()) {
+      return;
+    }
+    uint64_t offset = db_->offset(index_);
+    if (offset < advised_begin_ || offset + read_ahead_ / 2 > advised_end_) {
+      db_->WillNeed(offset, read_ahead_);
+      advised_begin_ = offset;
+      advised_end_ = offset + read_ahead_;
+    }
+  }
+
+  MMapDB* db_;
+  size_t index_ = 0;
+  const int64_t read_ahead_;
+  uint64_t advised_begin_ = 0;
+  uint64_t advised_end_ = 0;
+};
+
+class MMapDBTransaction : public Transaction {
+ public:
+  explicit MMapDBTransaction(MMapDB* db) : db_(db) {}
+  ~MMapDBTransaction() {
+    Commit();
+  }
+
+  void Put(const string& key, const string& value) override {
+    db_->Append(key, value);
+  }
+
+  void Commit() override {
+    db_->Flush();
+  }
+
+ private:
+  MMapDB* db_;
+
+  DISABLE_COPY_AND_ASSIGN(MMapDBTransaction);
+};
+
+MMapDB::MMapDB(const string& source, Mode mode)
+    : DB(source, mode), source_(source) {
+  if (mode == READ) {
+    Map();
+    try {
+      parseFile(source_, data_, size_, &offsets_);
+    } catch (...) {
+      Unmap();
+      throw;
+    }
+    VLOG(1) << "Opened MMapDB " << source_ << " with " << offsets_.size()
+            << " records";
+    return;
+  }
+  if (mode == WRITE && access(source_.c_str(), F_OK) == 0) {
+    Map();
+    try {
+      end_ = parseFile(source_, data_, size_, &offsets_);
+    } catch (...) {
+      Unmap();
+      throw;
+    }
+    Unmap();
+    // drop the index, it is written again on Close()
+    CAFFE_ENFORCE_EQ(
+        truncate(source_.c_str(), end_), 0, "Cannot truncate ", source_);
+    file_ = fopen(source_.c_str(), "r+b");
+    CAFFE_ENFORCE(file_, "Cannot open file: ", source_);
+    CAFFE_ENFORCE_EQ(fseek(file_, end_, SEEK_SET), 0);
+  } else {
+    file_ = fopen(source_.c_str(), "wb");
+    CAFFE_ENFORCE(file_, "Cannot open file: ", source_);
+    char header[kHeaderSize] = {0};
+    memcpy(header, kMagic, sizeof(kMagic));
+    memcpy(header + sizeof(kMagic), &kVersion, sizeof(kVersion));
+    CAFFE_ENFORCE_EQ(fwrite(header, 1, kHeaderSize, file_), kHeaderSize);
+    end_ = kHeaderSize;
+  }
+  VLOG(1) << "Opened MMapDB " << source_ << " for writing";
+}
+
+void MMapDB::Map() {
+  int fd = open(source_.c_str(), O_RDONLY);
+  CAFFE_ENFORCE_GE(fd, 0, "Cannot open file: ", source_);
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kHeaderSize)) {
+    close(fd);
+    CAFFE_THROW("Not an mmapdb file: ", source_);
+  }
+  size_ = st.st_size;
+  void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  // the mapping stays valid after closing the file
+  close(fd);
+  CAFFE_ENFORCE(data != MAP_FAILED, "Cannot mmap ", source_);
+  data_ = static_cast<const char*>(data);
+  if (FLAGS_caffe2_mmapdb_read_ahead_bytes > 0) {
+    madvise(const_cast<char*>(data_), size_, MADV_SEQUENTIAL);
+  }
+}
+
+void MMapDB::Unmap() {
+  if (data_) {
+    munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+void MMapDB::Close() {
+  Unmap();
+  if (file_) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    uint64_t count = offsets_.size();
+    uint32_t marker[2] = {kIndexMarker, kIndexMarker};
+    bool written = fwrite(marker, sizeof(uint32_t), 2, file_) == 2 &&
+        fwrite(offsets_.data(), sizeof(uint64_t), count, file_) == count &&
+        fwrite(&count, sizeof(count), 1, file_) == 1 &&
+        fwrite(kIndexMagic, 1, sizeof(kIndexMagic), file_) ==
+            sizeof(kIndexMagic);
+    if (fclose(file_) != 0 || !written) {
+      LOG(ERROR) << "Cannot write the index of mmapdb " << source_
+                 << ", it will be recovered by scanning the records";
+    }
+    file_ = nullptr;
+  }
+}
+
+unique_ptr<Cursor> MMapDB::NewCursor() {
+  CAFFE_ENFORCE_EQ(this->mode_, READ);
+  return make_unique<MMapDBCursor>(this);
+}
+
+unique_ptr<Transaction> MMapDB::NewTransaction() {
+  CAFFE_ENFORCE(this->mode_ == NEW || this->mode_ == WRITE);
+  return make_unique<MMapDBTransaction>(this);
+}
+
+size_t MMapDB::LowerBound(const string& key) {
+  std::call_once(sorted_keys_once_, [this]() {
+    sorted_keys_.reserve(offsets_.size());
+    for (size_t i = 0; i < offsets_.size(); ++i) {
+      sorted_keys_.emplace_back(this->key(i), i);
+    }
+    std::stable_sort(
+        sorted_keys_.begin(),
+        sorted_keys_.end(),
+        [](const std::pair<string, size_t>& a,
+           const std::pair<string, size_t>& b) { return a.first < b.first; });
+  });
+  auto it = std::lower_bound(
+      sorted_keys_.begin(),
+      sorted_keys_.end(),
+      key,
+      [](const std::pair<string, size_t>& a, const string& b) {
+        return a.first < b;
+      });
+  return it == sorted_keys_.end() ? offsets_.size() : it->second;
+}
+
+void MMapDB::WillNeed(uint64_t offset, uint64_t size) const {
+  static const uint64_t page_size = sysconf(_SC_PAGESIZE);
+  uint64_t begin = offset & ~(page_size - 1);
+  if (begin >= size_) {
+    return;
+  }
+  uint64_t length = std::min(size + (offset - begin), size_ - begin);
+  madvise(const_cast<char*>(data_ + begin), length, MADV_WILLNEED);
+}
+
+void MMapDB::Append(const string& key, const string& value) {
+  CAFFE_ENFORCE_LT(key.size(), kIndexMarker);
+  CAFFE_ENFORCE_LE(value.size(), UINT32_MAX);
+  uint32_t sizes[2] = {static_cast<uint32_t>(key.size()),
+                       static_cast<uint32_t>(value.size())};
+  auto size = recordSize(key.size(), value.size());
+  const char padding[8] = {0};
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  CAFFE_ENFORCE(file_, "mmapdb ", source_, " is closed");
+  CAFFE_ENFORCE_EQ(fwrite(sizes, sizeof(uint32_t), 2, file_), 2);
+  CAFFE_ENFORCE_EQ(fwrite(key.data(), 1, key.size(), file_), key.size());
+  CAFFE_ENFORCE_EQ(fwrite(value.data(), 1, value.size(), file_), value.size());
+  auto padding_size = size - (kRecordHeaderSize + key.size() + value.size());
+  CAFFE_ENFORCE_EQ(fwrite(padding, 1, padding_size, file_), padding_size);
+  offsets_.push_back(end_);
+  end_ += size;
+}
+
+void MMapDB::Flush() {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  if (file_) {
+    CAFFE_ENFORCE_EQ(fflush(file_), 0);
+  }
+}
+
+REGISTER_CAFFE2_DB(MMapDB, MMapDB);
+REGISTER_CAFFE2_DB(mmapdb, MMapDB);
+
+} // namespace db
+} // namespace caffe2
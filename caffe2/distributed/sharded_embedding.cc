@@ -0,0 +1,653 @@
+#include "sharded_embedding.h"
+
+#include <caffe2/core/logging.h>
+#include <caffe2/core/typeid.h>
+#include <caffe2/operators/partition_ops.h>
+#include <caffe2/sgd/adagrad_op.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+
+namespace caffe2 {
+
+namespace {
+
+/*
+ * Every message is a 32 bit length followed by that many bytes. Requests
+ * start with a command, followed by its arguments:
+ *
+ *   INFO                                  -> shard, num shards, dim
+ *   LOOKUP count, row * count             -> status, value * count * dim
+ *   UPDATE count, row * count, lr,
+ *          grad * count * dim             -> status
+ *
+ * A status other than OK is followed by an error message.
+ */
+enum class Command : uint8_t { INFO, LOOKUP, UPDATE };
+
+enum Status : uint8_t { OK, NOT_OK };
+
+// How long a client waits for any of the shards to make progress
+constexpr std::chrono::milliseconds kTimeout(60000);
+
+template <typename T>
+void append(std::string& out, T value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void appendArray(std::string& out, const T* values, size_t n) {
+  out.append(reinterpret_cast<const char*>(values), n * sizeof(T));
+}
+
+std::string frame(const std::string& payload) {
+  std::string out;
+  append<uint32_t>(out, payload.size());
+  out.append(payload);
+  return out;
+}
+
+struct Reader {
+  explicit Reader(const std::string& data) : data_(data), pos_(0) {}
+
+  template <typename T>
+  T read() {
+    T value;
+    readArray(&value, 1);
+    return value;
+  }
+
+  template <typename T>
+  void readArray(T* values, size_t n) {
+    CAFFE_ENFORCE_LE(pos_ + n * sizeof(T), data_.size(), "Truncated message");
+    memcpy(values, data_.data() + pos_, n * sizeof(T));
+    pos_ += n * sizeof(T);
+  }
+
+  void readStatus() {
+    if (read<uint8_t>() != OK) {
+      CAFFE_THROW("Embedding shard error: ", data_.substr(pos_));
+    }
+  }
+
+ private:
+  const std::string& data_;
+  size_t pos_;
+};
+
+bool sendAll(int fd, const std::string& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    auto rv = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (rv < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    sent += rv;
+  }
+  return true;
+}
+
+bool recvAll(int fd, char* data, size_t size) {
+  size_t received = 0;
+  while (received < size) {
+    auto rv = ::recv(fd, data + received, size - received, 0);
+    if (rv < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rv <= 0) {
+      return false;
+    }
+    received += rv;
+  }
+  return true;
+}
+
+void setNoDelay(int fd) {
+  int flag = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+// Takes one complete message off the front of buffer, if it has one.
+bool takeMessage(std::string& buffer, std::string* message) {
+  uint32_t size;
+  if (buffer.size() < sizeof(size)) {
+    return false;
+  }
+  memcpy(&size, buffer.data(), sizeof(size));
+  if (buffer.size() < sizeof(size) + size) {
+    return false;
+  }
+  *message = buffer.substr(sizeof(size), size);
+  buffer.erase(0, sizeof(size) + size);
+  return true;
+}
+
+std::string errorResponse(const std::string& error) {
+  std::string response;
+  append<uint8_t>(response, NOT_OK);
+  response.append(error);
+  return response;
+}
+
+} // namespace
+
+EmbeddingShardServer::EmbeddingShardServer(
+    int port,
+    int shard,
+    int numShards,
+    const TensorCPU& param,
+    const TensorCPU* moment,
+    float epsilon)
+    : shard_(shard), numShards_(numShards), epsilon_(epsilon) {
+  CAFFE_ENFORCE_GT(numShards_, 0);
+  CAFFE_ENFORCE(shard_ >= 0 && shard_ < numShards_, "Invalid shard ", shard_);
+  CAFFE_ENFORCE_EQ(param.ndim(), 2, "The rows of the shard must be a matrix");
+  rows_ = param.dim(0);
+  dim_ = param.dim(1);
+  param_.assign(param.data<float>(), param.data<float>() + param.size());
+  if (moment) {
+    CAFFE_ENFORCE_EQ(moment->dims(), param.dims());
+    moment_.assign(moment->data<float>(), moment->data<float>() + param.size());
+  } else {
+    moment_.assign(param.size(), 0);
+  }
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  struct addrinfo* res;
+  auto rv =
+      getaddrinfo(nullptr, std::to_string(port).c_str(), &hints, &res);
+  CAFFE_ENFORCE_EQ(rv, 0, "getaddrinfo: ", gai_strerror(rv));
+
+  listenFd_ = -1;
+  for (auto addr = res; addr != nullptr; addr = addr->ai_next) {
+    int fd = ::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+    if (fd == -1) {
+      continue;
+    }
+    int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (::bind(fd, addr->ai_addr, addr->ai_addrlen) == 0 &&
+        ::listen(fd, SOMAXCONN) == 0) {
+      listenFd_ = fd;
+      break;
+    }
+    ::close(fd);
+  }
+  freeaddrinfo(res);
+  CAFFE_ENFORCE_NE(
+      listenFd_, -1, "Could not listen on port ", port, ": ", strerror(errno));
+
+  struct sockaddr_storage addr;
+  socklen_t addrlen = sizeof(addr);
+  CAFFE_ENFORCE_EQ(
+      getsockname(listenFd_, reinterpret_cast<struct sockaddr*>(&addr), &addrlen),
+      0,
+      strerror(errno));
+  if (addr.ss_family == AF_INET) {
+    port_ = ntohs(reinterpret_cast<struct sockaddr_in*>(&addr)->sin_port);
+  } else {
+    port_ = ntohs(reinterpret_cast<struct sockaddr_in6*>(&addr)->sin6_port);
+  }
+
+  CAFFE_ENFORCE_EQ(pipe(stopFds_), 0, strerror(errno));
+  thread_ = std::thread(&EmbeddingShardServer::run, this);
+}
+
+EmbeddingShardServer::~EmbeddingShardServer() {
+  char stop = 0;
+  while (::write(stopFds_[1], &stop, 1) < 0 && errno == EINTR) {
+  }
+  thread_.join();
+  for (auto& client : clients_) {
+    ::close(client.fd);
+  }
+  ::close(listenFd_);
+  ::close(stopFds_[0]);
+  ::close(stopFds_[1]);
+}
+
+void EmbeddingShardServer::fetch(TensorCPU* param, TensorCPU* moment) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  param->Resize(rows_, dim_);
+  std::copy(param_.begin(), param_.end(), param->mutable_data<float>());
+  if (moment) {
+    moment->Resize(rows_, dim_);
+    std::copy(moment_.begin(), moment_.end(), moment->mutable_data<float>());
+  }
+}
+
+void EmbeddingShardServer::run() {
+  std::vector<struct pollfd> fds;
+  std::vector<char> buffer(64 * 1024);
+  std::string message;
+  while (true) {
+    fds.clear();
+    fds.push_back({stopFds_[0], POLLIN, 0});
+    fds.push_back({listenFd_, POLLIN, 0});
+    for (auto& client : clients_) {
+      fds.push_back({client.fd, POLLIN, 0});
+    }
+
+    if (::poll(fds.data(), fds.size(), -1) < 0) {
+      CAFFE_ENFORCE_EQ(errno, EINTR, "poll: ", strerror(errno));
+      continue;
+    }
+    if (fds[0].revents != 0) {
+      return;
+    }
+
+    // Go backwards, so that disconnecting a client doesn't move the ones
+    // still to be served
+    for (size_t i = clients_.size(); i-- > 0;) {
+      if (fds[i + 2].revents == 0) {
+        continue;
+      }
+      auto fd = clients_[i].fd;
+      auto rv = ::recv(fd, buffer.data(), buffer.size(), 0);
+      if (rv < 0 && errno == EINTR) {
+        continue;
+      }
+      bool ok = rv > 0;
+      if (ok) {
+        clients_[i].buffer.append(buffer.data(), rv);
+        while (ok && takeMessage(clients_[i].buffer, &message)) {
+          ok = handle(fd, message);
+        }
+      }
+      if (!ok) {
+        ::close(fd);
+        clients_.erase(clients_.begin() + i);
+      }
+    }
+
+    if (fds[1].revents != 0) {
+      int fd = ::accept(listenFd_, nullptr, nullptr);
+      if (fd >= 0) {
+        setNoDelay(fd);
+        clients_.push_back({fd, std::string()});
+      }
+    }
+  }
+}
+
+bool EmbeddingShardServer::handle(int fd, const std::string& request) {
+  std::string response;
+  try {
+    Reader reader(request);
+    auto command = static_cast<Command>(reader.read<uint8_t>());
+    switch (command) {
+      case Command::INFO: {
+        append<int32_t>(response, shard_);
+        append<int32_t>(response, numShards_);
+        append<int64_t>(response, dim_);
+        break;
+      }
+      case Command::LOOKUP:
+      case Command::UPDATE: {
+        std::vector<int64_t> rows(reader.read<uint32_t>());
+        reader.readArray(rows.data(), rows.size());
+        for (auto row : rows) {
+          if (row < 0 || row >= rows_) {
+            response = errorResponse(
+                "Row " + caffe2::to_string(row) + " is out of range of shard " +
+                caffe2::to_string(shard_) + " with " +
+                caffe2::to_string(rows_) + " rows");
+            break;
+          }
+        }
+        if (!response.empty()) {
+          break;
+        }
+
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (command == Command::LOOKUP) {
+          append<uint8_t>(response, OK);
+          for (auto row : rows) {
+            appendArray(response, &param_[row * dim_], dim_);
+          }
+          break;
+        }
+        auto lr = reader.read<float>();
+        std::vector<float> grad(rows.size() * dim_);
+        reader.readArray(grad.data(), grad.size());
+        // The client sends every row only once per request
+        CPUContext context;
+        for (size_t i = 0; i < rows.size(); i++) {
+          float* param = &param_[rows[i] * dim_];
+          float* moment = &moment_[rows[i] * dim_];
+          adagrad_update(
+              dim_,
+              param,
+              &grad[i * dim_],
+              moment,
+              param,
+              moment,
+              epsilon_,
+              1.0f,
+              &lr,
+              &context);
+        }
+        append<uint8_t>(response, OK);
+        break;
+      }
+      default:
+        LOG(ERROR) << "Unknown embedding shard command "
+                   << static_cast<int>(command);
+        return false;
+    }
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Bad embedding shard request: " << e.what();
+    return false;
+  }
+  return sendAll(fd, frame(response));
+}
+
+ShardedEmbeddingClient::ShardedEmbeddingClient(
+    const std::vector<std::string>& servers,
+    int maxBatch,
+    int maxInFlight)
+    : maxBatch_(maxBatch), maxInFlight_(maxInFlight), dim_(-1) {
+  CAFFE_ENFORCE(!servers.empty(), "No embedding shard servers given");
+  CAFFE_ENFORCE_GT(maxBatch_, 0);
+  CAFFE_ENFORCE_GT(maxInFlight_, 0);
+  for (const auto& server : servers) {
+    auto colon = server.rfind(':');
+    CAFFE_ENFORCE(
+        colon != std::string::npos, "Expected host:port, got ", server);
+    shards_.push_back(
+        {-1, server.substr(0, colon), std::stoi(server.substr(colon + 1))});
+  }
+
+  for (size_t i = 0; i < shards_.size(); i++) {
+    connect(i);
+  }
+}
+
+ShardedEmbeddingClient::~ShardedEmbeddingClient() {
+  for (auto& shard : shards_) {
+    if (shard.fd != -1) {
+      ::close(shard.fd);
+    }
+  }
+}
+
+// Connects to the server of shard i, and checks that it was handed out the
+// way we were told and that its rows have the dimension of the others.
+void ShardedEmbeddingClient::connect(size_t i) {
+  auto& shard = shards_[i];
+  const auto start = std::chrono::steady_clock::now();
+  while (shard.fd == -1) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* res;
+    auto rv = getaddrinfo(
+        shard.host.c_str(), std::to_string(shard.port).c_str(), &hints, &res);
+    if (rv == 0) {
+      for (auto addr = res; addr != nullptr; addr = addr->ai_next) {
+        int fd =
+            ::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if (fd == -1) {
+          continue;
+        }
+        if (::connect(fd, addr->ai_addr, addr->ai_addrlen) == 0) {
+          shard.fd = fd;
+          break;
+        }
+        ::close(fd);
+      }
+      freeaddrinfo(res);
+    }
+    // The server may still be starting, so keep trying for a while
+    if (shard.fd == -1) {
+      CAFFE_ENFORCE(
+          std::chrono::steady_clock::now() - start < kTimeout,
+          "Could not connect to embedding shard at ",
+          shard.host,
+          ":",
+          shard.port);
+      /* sleep override */
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  setNoDelay(shard.fd);
+
+  std::string message;
+  append<uint8_t>(message, static_cast<uint8_t>(Command::INFO));
+  uint32_t size;
+  CAFFE_ENFORCE(sendAll(shard.fd, frame(message)), strerror(errno));
+  CAFFE_ENFORCE(
+      recvAll(shard.fd, reinterpret_cast<char*>(&size), sizeof(size)),
+      "Lost connection to embedding shard at ",
+      shard.host,
+      ":",
+      shard.port);
+  std::string response(size, 0);
+  CAFFE_ENFORCE(
+      recvAll(shard.fd, &response[0], size),
+      "Lost connection to embedding shard at ",
+      shard.host,
+      ":",
+      shard.port);
+  Reader reader(response);
+  auto index = reader.read<int32_t>();
+  auto numShards = reader.read<int32_t>();
+  auto dim = reader.read<int64_t>();
+  CAFFE_ENFORCE_EQ(
+      index, int32_t(i), "Embedding shard ", i, " got shard ", index);
+  CAFFE_ENFORCE_EQ(numShards, int32_t(shards_.size()));
+  CAFFE_ENFORCE(dim_ == -1 || dim_ == dim, "Shards differ in dimension");
+  dim_ = dim;
+
+  // Requests are pipelined from here on
+  auto flags = fcntl(shard.fd, F_GETFL, 0);
+  CAFFE_ENFORCE_NE(flags, -1, strerror(errno));
+  CAFFE_ENFORCE_NE(
+      fcntl(shard.fd, F_SETFL, flags | O_NONBLOCK), -1, strerror(errno));
+}
+
+void ShardedEmbeddingClient::partition(const int64_t* ids, size_t n) {
+  std::unordered_map<int64_t, size_t> index;
+  unique_.clear();
+  inverse_.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    auto it = index.emplace(ids[i], unique_.size());
+    if (it.second) {
+      unique_.push_back(ids[i]);
+    }
+    inverse_[i] = it.first->second;
+  }
+
+  const int numShards = shards_.size();
+  for (auto& shard : shards_) {
+    shard.rows.clear();
+    shard.unique.clear();
+  }
+  for (size_t i = 0; i < unique_.size(); i++) {
+    auto s = moduloPartition(unique_[i], numShards);
+    shards_[s].rows.push_back((unique_[i] - s) / numShards);
+    shards_[s].unique.push_back(i);
+  }
+}
+
+template <typename MakeBody, typename OnResponse>
+void ShardedEmbeddingClient::exchange(
+    uint8_t command,
+    MakeBody makeBody,
+    OnResponse onResponse) {
+  struct State {
+    size_t next = 0;
+    // Offsets of the batches we are waiting for responses to, in order
+    std::deque<size_t> inFlight;
+    std::string out;
+    std::string in;
+  };
+  std::vector<State> states(shards_.size());
+  std::vector<struct pollfd> fds;
+  std::vector<size_t> polled;
+  std::vector<char> buffer(64 * 1024);
+  std::string message;
+
+  try {
+    while (true) {
+      fds.clear();
+      polled.clear();
+      for (size_t s = 0; s < shards_.size(); s++) {
+        auto& shard = shards_[s];
+        auto& state = states[s];
+        if (shard.fd == -1) {
+          connect(s);
+        }
+        while (state.next < shard.rows.size() &&
+               state.inFlight.size() < size_t(maxInFlight_)) {
+          auto end = std::min(state.next + maxBatch_, shard.rows.size());
+          message.clear();
+          append<uint8_t>(message, command);
+          append<uint32_t>(message, end - state.next);
+          appendArray(message, &shard.rows[state.next], end - state.next);
+          makeBody(message, s, state.next, end);
+          state.out.append(frame(message));
+          state.inFlight.push_back(state.next);
+          state.next = end;
+        }
+        short events = (state.inFlight.empty() ? 0 : POLLIN) |
+            (state.out.empty() ? 0 : POLLOUT);
+        if (events != 0) {
+          fds.push_back({shard.fd, events, 0});
+          polled.push_back(s);
+        }
+      }
+      if (fds.empty()) {
+        return;
+      }
+
+      auto rv = ::poll(fds.data(), fds.size(), kTimeout.count());
+      if (rv < 0 && errno == EINTR) {
+        continue;
+      }
+      CAFFE_ENFORCE_GE(rv, 0, "poll: ", strerror(errno));
+      CAFFE_ENFORCE_NE(rv, 0, "Timed out waiting for embedding shards");
+
+      for (size_t i = 0; i < fds.size(); i++) {
+        auto s = polled[i];
+        auto& shard = shards_[s];
+        auto& state = states[s];
+        if (fds[i].revents & POLLOUT) {
+          auto n = ::send(
+              shard.fd, state.out.data(), state.out.size(), MSG_NOSIGNAL);
+          if (n < 0) {
+            CAFFE_ENFORCE(
+                errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK,
+                "send: ",
+                strerror(errno));
+          } else {
+            state.out.erase(0, n);
+          }
+        }
+        if (fds[i].revents & (POLLIN | POLLERR | POLLHUP)) {
+          auto n = ::recv(shard.fd, buffer.data(), buffer.size(), 0);
+          if (n < 0) {
+            CAFFE_ENFORCE(
+                errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK,
+                "recv: ",
+                strerror(errno));
+            continue;
+          }
+          CAFFE_ENFORCE_NE(n, 0, "Lost connection to embedding shard ", s);
+          state.in.append(buffer.data(), n);
+          while (takeMessage(state.in, &message)) {
+            CAFFE_ENFORCE(!state.inFlight.empty(), "Unexpected response");
+            auto begin = state.inFlight.front();
+            state.inFlight.pop_front();
+            auto end = std::min(begin + maxBatch_, shard.rows.size());
+            onResponse(message, s, begin, end);
+          }
+        }
+      }
+    }
+  } catch (...) {
+    // Responses to the requests still in flight would be taken for those of
+    // the next call, so give up on the connections
+    for (auto& shard : shards_) {
+      if (shard.fd != -1) {
+        ::close(shard.fd);
+        shard.fd = -1;
+      }
+    }
+    throw;
+  }
+}
+
+void ShardedEmbeddingClient::lookup(
+    const int64_t* ids,
+    size_t n,
+    float* out) {
+  partition(ids, n);
+  values_.resize(unique_.size() * dim_);
+  exchange(
+      static_cast<uint8_t>(Command::LOOKUP),
+      [](std::string&, size_t, size_t, size_t) {},
+      [this](const std::string& response, size_t s, size_t begin, size_t end) {
+        Reader reader(response);
+        reader.readStatus();
+        for (auto i = begin; i < end; i++) {
+          reader.readArray(&values_[shards_[s].unique[i] * dim_], dim_);
+        }
+      });
+  for (size_t i = 0; i < n; i++) {
+    std::copy_n(&values_[inverse_[i] * dim_], dim_, out + i * dim_);
+  }
+}
+
+void ShardedEmbeddingClient::update(
+    const int64_t* ids,
+    size_t n,
+    const float* grad,
+    float lr) {
+  partition(ids, n);
+  values_.assign(unique_.size() * dim_, 0);
+  for (size_t i = 0; i < n; i++) {
+    float* sum = &values_[inverse_[i] * dim_];
+    for (int64_t j = 0; j < dim_; j++) {
+      sum[j] += grad[i * dim_ + j];
+    }
+  }
+  exchange(
+      static_cast<uint8_t>(Command::UPDATE),
+      [this, lr](std::string& message, size_t s, size_t begin, size_t end) {
+        append<float>(message, lr);
+        for (auto i = begin; i < end; i++) {
+          appendArray(message, &values_[shards_[s].unique[i] * dim_], dim_);
+        }
+      },
+      [](const std::string& response, size_t, size_t, size_t) {
+        Reader(response).readStatus();
+      });
+}
+
+CAFFE_KNOWN_TYPE(std::unique_ptr<EmbeddingShardServer>);
+CAFFE_KNOWN_TYPE(std::unique_ptr<ShardedEmbeddingClient>);
+
+} // namespace caffe2
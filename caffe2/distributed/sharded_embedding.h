@@ -0,0 +1,137 @@
+#pragma once
+
+#include <caffe2/core/tensor.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace caffe2 {
+
+/*
+ * Serves one shard of an embedding table, parameter server style, for
+ * ShardedEmbeddingClient. Ids are assigned to shards the way PartitionOp
+ * with pack_first_input assigns them: id goes to shard id % num_shards,
+ * where it is row (id - shard) / num_shards.
+ *
+ * The shard keeps its rows and their Adagrad moments in memory, and a
+ * single thread serves lookups of rows and sparse Adagrad updates of them,
+ * in the order they arrive on every connection.
+ */
+class EmbeddingShardServer {
+ public:
+  // Listens on all interfaces; port 0 picks a free port. The shard starts
+  // out with a copy of param, and moment if it is given.
+  EmbeddingShardServer(
+      int port,
+      int shard,
+      int numShards,
+      const TensorCPU& param,
+      const TensorCPU* moment,
+      float epsilon);
+  ~EmbeddingShardServer();
+
+  int port() const {
+    return port_;
+  }
+
+  // Copies the current rows and moments of the shard out.
+  void fetch(TensorCPU* param, TensorCPU* moment);
+
+ private:
+  struct Client {
+    int fd;
+    std::string buffer;
+  };
+
+  void run();
+  // Returns false if the client should be disconnected.
+  bool handle(int fd, const std::string& request);
+
+  const int shard_;
+  const int numShards_;
+  const float epsilon_;
+  int64_t rows_;
+  int64_t dim_;
+
+  // Held by the server thread while it reads or updates the rows
+  std::mutex mutex_;
+  std::vector<float> param_;
+  std::vector<float> moment_;
+
+  int port_;
+  int listenFd_;
+  // Written to by the destructor to stop the thread.
+  int stopFds_[2];
+  std::thread thread_;
+  std::vector<Client> clients_;
+};
+
+/*
+ * Client of the EmbeddingShardServers of all shards of an embedding table.
+ *
+ * Every lookup and update is coalesced first: every id is sent only once,
+ * and the gradients of ids that occur more than once are summed before they
+ * are sent, so a batch with repeated ids costs as much as one without. The
+ * ids of every shard are then sent in requests of at most maxBatch ids,
+ * and up to maxInFlight of them are outstanding on every shard at any time,
+ * which overlaps the round trips to all shards without letting a large batch
+ * flood any one of them.
+ */
+class ShardedEmbeddingClient {
+ public:
+  // servers holds host:port of the server of every shard, in order of shard.
+  ShardedEmbeddingClient(
+      const std::vector<std::string>& servers,
+      int maxBatch,
+      int maxInFlight);
+  ~ShardedEmbeddingClient();
+
+  int64_t dim() const {
+    return dim_;
+  }
+
+  // Writes the rows of the n ids to out, which holds n * dim() floats.
+  void lookup(const int64_t* ids, size_t n, float* out);
+
+  // Applies a sparse Adagrad update with learning rate lr to the rows of
+  // the n ids, whose gradients are in grad (n * dim() floats).
+  void update(const int64_t* ids, size_t n, const float* grad, float lr);
+
+ private:
+  struct Shard {
+    int fd;
+    std::string host;
+    int port;
+    // Local rows of the unique ids that go to this shard, and the index of
+    // every one of them among the unique ids.
+    std::vector<int64_t> rows;
+    std::vector<size_t> unique;
+  };
+
+  void connect(size_t shard);
+
+  // Coalesces the ids into unique_ and distributes them over the shards.
+  // inverse_[i] is the index of ids[i] among the unique ids.
+  void partition(const int64_t* ids, size_t n);
+
+  // Sends every shard its rows, in batches, with the body that makeBody
+  // builds for the batch of rows [begin, end) of a shard. Every response is
+  // handed to onResponse along with the shard and the batch.
+  template <typename MakeBody, typename OnResponse>
+  void exchange(uint8_t command, MakeBody makeBody, OnResponse onResponse);
+
+  const int maxBatch_;
+  const int maxInFlight_;
+  int64_t dim_;
+  std::vector<Shard> shards_;
+
+  // Reused between calls
+  std::vector<int64_t> unique_;
+  std::vector<size_t> inverse_;
+  std::vector<float> values_;
+};
+
+} // namespace caffe2
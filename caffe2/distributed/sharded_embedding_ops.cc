@@ -0,0 +1,209 @@
+#include "sharded_embedding_ops.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Copies the int32 or int64 indices into ids.
+void readIndices(const TensorCPU& indices, std::vector<int64_t>* ids) {
+  if (indices.IsType<int32_t>()) {
+    ids->assign(
+        indices.data<int32_t>(), indices.data<int32_t>() + indices.size());
+  } else {
+    CAFFE_ENFORCE(indices.IsType<int64_t>(), "Indices must be int32 or int64");
+    ids->assign(
+        indices.data<int64_t>(), indices.data<int64_t>() + indices.size());
+  }
+}
+
+} // namespace
+
+CreateEmbeddingShardServerOp::CreateEmbeddingShardServerOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws),
+      port_(GetSingleArgument<int>("port", 0)),
+      shardId_(GetSingleArgument<int>("shard_id", -1)),
+      numShards_(GetSingleArgument<int>("num_shards", 0)),
+      epsilon_(GetSingleArgument<float>("epsilon", 1e-5f)) {
+  CAFFE_ENFORCE(HasArgument("shard_id"), "shard_id is a required argument");
+  CAFFE_ENFORCE(HasArgument("num_shards"), "num_shards is a required argument");
+}
+
+bool CreateEmbeddingShardServerOp::RunOnDevice() {
+  auto* server = new EmbeddingShardServer(
+      port_,
+      shardId_,
+      numShards_,
+      Input(PARAM),
+      InputSize() > MOMENT ? &Input(MOMENT) : nullptr,
+      epsilon_);
+  *OperatorBase::Output<std::unique_ptr<EmbeddingShardServer>>(SERVER) =
+      std::unique_ptr<EmbeddingShardServer>(server);
+  if (OutputSize() > PORT) {
+    Output(PORT)->Resize();
+    *Output(PORT)->mutable_data<int32_t>() = server->port();
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(CreateEmbeddingShardServer, CreateEmbeddingShardServerOp);
+OPERATOR_SCHEMA(CreateEmbeddingShardServer)
+    .NumInputs(1, 2)
+    .NumOutputs(1, 2)
+    .SetDoc(R"DOC(
+Serves one shard of an embedding table over TCP, for as long as the server
+blob lives. Ids are partitioned the way Partition with pack_first_input
+partitions them: id belongs to shard `id % num_shards`, where it is row
+`id / num_shards` of `param`. The shard starts out with copies of `param`
+and (optionally) its Adagrad `moment`, and applies the updates of
+ShardedSparseAdagrad to them.
+)DOC")
+    .Arg("port", "port to listen on, or 0 (default) to pick a free one")
+    .Arg("shard_id", "the shard this server holds")
+    .Arg("num_shards", "number of shards of the table")
+    .Arg("epsilon", "Adagrad epsilon (default 1e-5)")
+    .Input(0, "param", "rows of this shard, a matrix")
+    .Input(1, "moment", "Adagrad moments of the rows (optional, default 0)")
+    .Output(0, "server", "unique_ptr<EmbeddingShardServer>")
+    .Output(1, "port", "int32 scalar, the port the server listens on");
+
+NO_GRADIENT(CreateEmbeddingShardServer);
+
+EmbeddingShardServerFetchOp::EmbeddingShardServerFetchOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws) {}
+
+bool EmbeddingShardServerFetchOp::RunOnDevice() {
+  auto& server =
+      OperatorBase::Input<std::unique_ptr<EmbeddingShardServer>>(SERVER);
+  CAFFE_ENFORCE(server, "Embedding shard server is not running");
+  server->fetch(
+      Output(PARAM), OutputSize() > MOMENT ? Output(MOMENT) : nullptr);
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(EmbeddingShardServerFetch, EmbeddingShardServerFetchOp);
+OPERATOR_SCHEMA(EmbeddingShardServerFetch)
+    .NumInputs(1)
+    .NumOutputs(1, 2)
+    .SetDoc(R"DOC(
+Copies the current rows of an embedding shard, and optionally their Adagrad
+moments, out of its server, e.g. to checkpoint them.
+)DOC")
+    .Input(0, "server", "unique_ptr<EmbeddingShardServer>")
+    .Output(0, "param", "rows of the shard")
+    .Output(1, "moment", "Adagrad moments of the rows");
+
+NO_GRADIENT(EmbeddingShardServerFetch);
+
+CreateShardedEmbeddingClientOp::CreateShardedEmbeddingClientOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws),
+      servers_(GetRepeatedArgument<std::string>("servers")),
+      maxBatchSize_(GetSingleArgument<int>("max_batch_size", 1024)),
+      maxInFlight_(GetSingleArgument<int>("max_in_flight", 4)) {
+  CAFFE_ENFORCE(!servers_.empty(), "servers is a required argument");
+}
+
+bool CreateShardedEmbeddingClientOp::RunOnDevice() {
+  *OperatorBase::Output<std::unique_ptr<ShardedEmbeddingClient>>(CLIENT) =
+      std::unique_ptr<ShardedEmbeddingClient>(
+          new ShardedEmbeddingClient(servers_, maxBatchSize_, maxInFlight_));
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(
+    CreateShardedEmbeddingClient,
+    CreateShardedEmbeddingClientOp);
+OPERATOR_SCHEMA(CreateShardedEmbeddingClient)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Creates a client of the CreateEmbeddingShardServer servers of all shards of
+an embedding table, for ShardedEmbeddingLookup and ShardedSparseAdagrad.
+
+Both coalesce their ids, so that every row is requested and updated only
+once per run, send the ids of every shard in requests of at most
+`max_batch_size` ids, and keep up to `max_in_flight` requests outstanding on
+every shard, so that the round trips to all shards overlap.
+)DOC")
+    .Arg("servers", "host:port of the server of every shard, in shard order")
+    .Arg("max_batch_size", "most ids in a single request (default 1024)")
+    .Arg("max_in_flight", "most outstanding requests per shard (default 4)")
+    .Output(0, "client", "unique_ptr<ShardedEmbeddingClient>");
+
+NO_GRADIENT(CreateShardedEmbeddingClient);
+
+ShardedEmbeddingLookupOp::ShardedEmbeddingLookupOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws) {}
+
+bool ShardedEmbeddingLookupOp::RunOnDevice() {
+  auto& client =
+      OperatorBase::Input<std::unique_ptr<ShardedEmbeddingClient>>(CLIENT);
+  auto& indices = Input(INDICES);
+  readIndices(indices, &ids_);
+  auto dims = indices.dims();
+  dims.push_back(client->dim());
+  Output(OUTPUT)->Resize(dims);
+  client->lookup(
+      ids_.data(), ids_.size(), Output(OUTPUT)->mutable_data<float>());
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(ShardedEmbeddingLookup, ShardedEmbeddingLookupOp);
+OPERATOR_SCHEMA(ShardedEmbeddingLookup)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Gathers the rows of the given ids from the shards of an embedding table, like
+Gather on the whole table would.
+)DOC")
+    .Input(0, "client", "unique_ptr<ShardedEmbeddingClient>")
+    .Input(1, "indices", "int32 or int64 ids to look up")
+    .Output(0, "output", "rows of the ids, of shape indices.shape + [dim]");
+
+NO_GRADIENT(ShardedEmbeddingLookup);
+
+ShardedSparseAdagradOp::ShardedSparseAdagradOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws) {}
+
+bool ShardedSparseAdagradOp::RunOnDevice() {
+  auto& client =
+      OperatorBase::Input<std::unique_ptr<ShardedEmbeddingClient>>(CLIENT);
+  auto& grad = Input(GRAD);
+  auto& lr = Input(LR);
+  readIndices(Input(INDICES), &ids_);
+  CAFFE_ENFORCE_EQ(lr.size(), 1);
+  CAFFE_ENFORCE_EQ(
+      grad.size(),
+      ids_.size() * client->dim(),
+      "Expected one gradient row per index");
+  client->update(
+      ids_.data(), ids_.size(), grad.data<float>(), lr.data<float>()[0]);
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(ShardedSparseAdagrad, ShardedSparseAdagradOp);
+OPERATOR_SCHEMA(ShardedSparseAdagrad)
+    .NumInputs(4)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Pushes a sparse Adagrad update to the shards of an embedding table, which
+apply it the way SparseAdagrad would to the whole table, except that the
+gradients of ids that occur more than once are summed and applied together.
+)DOC")
+    .Input(0, "client", "unique_ptr<ShardedEmbeddingClient>")
+    .Input(1, "indices", "int32 or int64 ids of the gradient rows")
+    .Input(2, "grad", "gradient rows, of shape indices.shape + [dim]")
+    .Input(3, "lr", "learning rate");
+
+NO_GRADIENT(ShardedSparseAdagrad);
+
+} // namespace caffe2
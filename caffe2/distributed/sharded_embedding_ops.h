@@ -0,0 +1,76 @@
+#pragma once
+
+#include "sharded_embedding.h"
+
+#include <caffe2/core/operator.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace caffe2 {
+
+class CreateEmbeddingShardServerOp final : public Operator<CPUContext> {
+ public:
+  CreateEmbeddingShardServerOp(const OperatorDef& operator_def, Workspace* ws);
+  bool RunOnDevice() override;
+
+ private:
+  int port_;
+  int shardId_;
+  int numShards_;
+  float epsilon_;
+
+  INPUT_TAGS(PARAM, MOMENT);
+  OUTPUT_TAGS(SERVER, PORT);
+};
+
+class EmbeddingShardServerFetchOp final : public Operator<CPUContext> {
+ public:
+  EmbeddingShardServerFetchOp(const OperatorDef& operator_def, Workspace* ws);
+  bool RunOnDevice() override;
+
+ private:
+  INPUT_TAGS(SERVER);
+  OUTPUT_TAGS(PARAM, MOMENT);
+};
+
+class CreateShardedEmbeddingClientOp final : public Operator<CPUContext> {
+ public:
+  CreateShardedEmbeddingClientOp(
+      const OperatorDef& operator_def,
+      Workspace* ws);
+  bool RunOnDevice() override;
+
+ private:
+  std::vector<std::string> servers_;
+  int maxBatchSize_;
+  int maxInFlight_;
+
+  OUTPUT_TAGS(CLIENT);
+};
+
+class ShardedEmbeddingLookupOp final : public Operator<CPUContext> {
+ public:
+  ShardedEmbeddingLookupOp(const OperatorDef& operator_def, Workspace* ws);
+  bool RunOnDevice() override;
+
+ private:
+  std::vector<int64_t> ids_;
+
+  INPUT_TAGS(CLIENT, INDICES);
+  OUTPUT_TAGS(OUTPUT);
+};
+
+class ShardedSparseAdagradOp final : public Operator<CPUContext> {
+ public:
+  ShardedSparseAdagradOp(const OperatorDef& operator_def, Workspace* ws);
+  bool RunOnDevice() override;
+
+ private:
+  std::vector<int64_t> ids_;
+
+  INPUT_TAGS(CLIENT, INDICES, GRAD, LR);
+};
+
+} // namespace caffe2
@@ -0,0 +1,123 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+
+from caffe2.python import core, workspace, dyndep
+from caffe2.python.test_util import TestCase
+
+dyndep.InitOpsLibrary("@/caffe2/caffe2/distributed:sharded_embedding_ops")
+
+
+class TestShardedEmbeddingOps(TestCase):
+    num_shards = 3
+    rows = 40
+    dim = 5
+    epsilon = 1e-5
+
+    def setUp(self):
+        super(TestShardedEmbeddingOps, self).setUp()
+        np.random.seed(0)
+        self.table = np.random.rand(self.rows, self.dim).astype(np.float32)
+        self.moment = np.zeros_like(self.table)
+        servers = []
+        for shard in range(self.num_shards):
+            # Rows of the shard, laid out the way Partition with
+            # pack_first_input lays them out
+            workspace.FeedBlob(
+                "param_{}".format(shard), self.table[shard::self.num_shards])
+            workspace.RunOperatorOnce(
+                core.CreateOperator(
+                    "CreateEmbeddingShardServer",
+                    ["param_{}".format(shard)],
+                    ["server_{}".format(shard), "port_{}".format(shard)],
+                    shard_id=shard,
+                    num_shards=self.num_shards,
+                    epsilon=self.epsilon))
+            port = workspace.FetchBlob("port_{}".format(shard))
+            servers.append("localhost:{}".format(port))
+        # Small batches, to have several requests in flight on every shard
+        workspace.RunOperatorOnce(
+            core.CreateOperator(
+                "CreateShardedEmbeddingClient",
+                [],
+                ["client"],
+                servers=servers,
+                max_batch_size=3,
+                max_in_flight=2))
+
+    def tearDown(self):
+        workspace.ResetWorkspace()
+        super(TestShardedEmbeddingOps, self).tearDown()
+
+    def test_lookup(self):
+        for dtype in [np.int32, np.int64]:
+            indices = np.random.randint(
+                self.rows, size=(4, 7)).astype(dtype)
+            workspace.FeedBlob("indices", indices)
+            workspace.RunOperatorOnce(
+                core.CreateOperator(
+                    "ShardedEmbeddingLookup",
+                    ["client", "indices"],
+                    ["output"]))
+            np.testing.assert_array_equal(
+                workspace.FetchBlob("output"), self.table[indices])
+
+    def test_sparse_adagrad(self):
+        lr = np.array([-0.1], dtype=np.float32)
+        workspace.FeedBlob("lr", lr)
+        for _ in range(5):
+            # Ids repeat, and have their gradients summed
+            indices = np.random.randint(self.rows, size=20).astype(np.int64)
+            grad = np.random.rand(20, self.dim).astype(np.float32) - 0.5
+            workspace.FeedBlob("indices", indices)
+            workspace.FeedBlob("grad", grad)
+            workspace.RunOperatorOnce(
+                core.CreateOperator(
+                    "ShardedSparseAdagrad",
+                    ["client", "indices", "grad", "lr"],
+                    []))
+
+            summed = np.zeros_like(self.table)
+            np.add.at(summed, indices, grad)
+            for i in np.unique(indices):
+                self.moment[i] += summed[i] * summed[i]
+                self.table[i] += lr[0] * summed[i] / (
+                    np.sqrt(self.moment[i]) + self.epsilon)
+
+        for shard in range(self.num_shards):
+            workspace.RunOperatorOnce(
+                core.CreateOperator(
+                    "EmbeddingShardServerFetch",
+                    ["server_{}".format(shard)],
+                    ["param", "moment"]))
+            np.testing.assert_allclose(
+                workspace.FetchBlob("param"),
+                self.table[shard::self.num_shards],
+                rtol=1e-5, atol=1e-6)
+            np.testing.assert_allclose(
+                workspace.FetchBlob("moment"),
+                self.moment[shard::self.num_shards],
+                rtol=1e-5, atol=1e-6)
+
+    def test_out_of_range(self):
+        workspace.FeedBlob(
+            "indices", np.array([1, self.rows * 10], dtype=np.int64))
+        with self.assertRaises(RuntimeError):
+            workspace.RunOperatorOnce(
+                core.CreateOperator(
+                    "ShardedEmbeddingLookup",
+                    ["client", "indices"],
+                    ["output"]))
+
+        # The client reconnects after an error
+        workspace.FeedBlob("indices", np.array([1, 2], dtype=np.int64))
+        workspace.RunOperatorOnce(
+            core.CreateOperator(
+                "ShardedEmbeddingLookup",
+                ["client", "indices"],
+                ["output"]))
+        np.testing.assert_array_equal(
+            workspace.FetchBlob("output"), self.table[[1, 2]])
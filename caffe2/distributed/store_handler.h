@@ -48,6 +48,22 @@ class StoreHandler {
   virtual void wait(
       const std::vector<std::string>& names,
       const std::chrono::milliseconds& timeout = kDefaultTimeout) = 0;
+
+  /*
+   * Set data for many keys at once, with the semantics of set.
+   * The default implementation calls set for every key; stores that
+   * can do it in a single round trip override it.
+   */
+  virtual void multiSet(
+      const std::vector<std::string>& names,
+      const std::vector<std::string>& data);
+
+  /*
+   * Get the data for many keys at once, with the semantics of get.
+   * The default implementation calls get for every key.
+   */
+  virtual std::vector<std::string> multiGet(
+      const std::vector<std::string>& names);
 };
 
 struct StoreHandlerTimeoutException : public std::runtime_error {
@@ -0,0 +1,573 @@
+#include "tcp_store_handler.h"
+
+#include <caffe2/core/logging.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <set>
+
+namespace caffe2 {
+
+namespace {
+
+/*
+ * Every message is a 32 bit length followed by that many bytes. Requests
+ * start with a command, followed by its arguments, and strings are sent as
+ * a 32 bit length followed by their bytes:
+ *
+ *   SET   count, (name, data) * count  -> status
+ *   GET   count, name * count          -> data * count
+ *   ADD   name, value                  -> new value
+ *   CHECK count, name * count          -> status
+ *   WAIT  count, name * count          -> status
+ *
+ * GET and WAIT are answered once all of their names are set.
+ */
+enum class Command : uint8_t { SET, GET, ADD, CHECK, WAIT };
+
+enum Status : uint8_t { OK, NOT_OK };
+
+template <typename T>
+void append(std::string& out, T value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void appendString(std::string& out, const std::string& str) {
+  append<uint32_t>(out, str.size());
+  out.append(str);
+}
+
+std::string frame(const std::string& payload) {
+  std::string out;
+  append<uint32_t>(out, payload.size());
+  out.append(payload);
+  return out;
+}
+
+struct Reader {
+  explicit Reader(const std::string& data) : data_(data), pos_(0) {}
+
+  template <typename T>
+  T read() {
+    CAFFE_ENFORCE_LE(pos_ + sizeof(T), data_.size(), "Truncated message");
+    T value;
+    memcpy(&value, data_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return value;
+  }
+
+  std::string readString() {
+    auto size = read<uint32_t>();
+    CAFFE_ENFORCE_LE(pos_ + size, data_.size(), "Truncated message");
+    std::string str = data_.substr(pos_, size);
+    pos_ += size;
+    return str;
+  }
+
+  std::vector<std::string> readStrings() {
+    auto count = read<uint32_t>();
+    std::vector<std::string> strs;
+    for (uint32_t i = 0; i < count; i++) {
+      strs.push_back(readString());
+    }
+    return strs;
+  }
+
+ private:
+  const std::string& data_;
+  size_t pos_;
+};
+
+bool sendAll(int fd, const std::string& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    auto rv = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (rv < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    sent += rv;
+  }
+  return true;
+}
+
+void setNoDelay(int fd) {
+  int flag = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+} // namespace
+
+TcpStoreServer::TcpStoreServer(int port) : nextWaiter_(0) {
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  struct addrinfo* res;
+  auto rv =
+      getaddrinfo(nullptr, std::to_string(port).c_str(), &hints, &res);
+  CAFFE_ENFORCE_EQ(rv, 0, "getaddrinfo: ", gai_strerror(rv));
+
+  listenFd_ = -1;
+  for (auto addr = res; addr != nullptr; addr = addr->ai_next) {
+    int fd = ::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+    if (fd == -1) {
+      continue;
+    }
+    int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (::bind(fd, addr->ai_addr, addr->ai_addrlen) == 0 &&
+        ::listen(fd, SOMAXCONN) == 0) {
+      listenFd_ = fd;
+      break;
+    }
+    ::close(fd);
+  }
+  freeaddrinfo(res);
+  CAFFE_ENFORCE_NE(
+      listenFd_, -1, "Could not listen on port ", port, ": ", strerror(errno));
+
+  struct sockaddr_storage addr;
+  socklen_t addrlen = sizeof(addr);
+  CAFFE_ENFORCE_EQ(
+      getsockname(listenFd_, reinterpret_cast<struct sockaddr*>(&addr), &addrlen),
+      0,
+      strerror(errno));
+  if (addr.ss_family == AF_INET) {
+    port_ = ntohs(reinterpret_cast<struct sockaddr_in*>(&addr)->sin_port);
+  } else {
+    port_ = ntohs(reinterpret_cast<struct sockaddr_in6*>(&addr)->sin6_port);
+  }
+
+  CAFFE_ENFORCE_EQ(pipe(stopFds_), 0, strerror(errno));
+  thread_ = std::thread(&TcpStoreServer::run, this);
+}
+
+TcpStoreServer::~TcpStoreServer() {
+  char stop = 0;
+  while (::write(stopFds_[1], &stop, 1) < 0 && errno == EINTR) {
+  }
+  thread_.join();
+  for (auto& client : clients_) {
+    ::close(client.fd);
+  }
+  ::close(listenFd_);
+  ::close(stopFds_[0]);
+  ::close(stopFds_[1]);
+}
+
+void TcpStoreServer::run() {
+  std::vector<struct pollfd> fds;
+  std::vector<char> buffer(64 * 1024);
+  while (true) {
+    fds.clear();
+    fds.push_back({stopFds_[0], POLLIN, 0});
+    fds.push_back({listenFd_, POLLIN, 0});
+    for (auto& client : clients_) {
+      fds.push_back({client.fd, POLLIN, 0});
+    }
+
+    if (::poll(fds.data(), fds.size(), -1) < 0) {
+      CAFFE_ENFORCE_EQ(errno, EINTR, "poll: ", strerror(errno));
+      continue;
+    }
+    if (fds[0].revents != 0) {
+      return;
+    }
+
+    // Go backwards, so that disconnecting a client doesn't move the ones
+    // still to be served
+    for (size_t i = clients_.size(); i-- > 0;) {
+      if (fds[i + 2].revents == 0) {
+        continue;
+      }
+      auto fd = clients_[i].fd;
+      auto rv = ::recv(fd, buffer.data(), buffer.size(), 0);
+      if (rv < 0 && errno == EINTR) {
+        continue;
+      }
+      if (rv <= 0) {
+        disconnect(i);
+        continue;
+      }
+
+      auto& pending = clients_[i].buffer;
+      pending.append(buffer.data(), rv);
+      bool ok = true;
+      while (ok && pending.size() >= sizeof(uint32_t)) {
+        uint32_t size;
+        memcpy(&size, pending.data(), sizeof(size));
+        if (pending.size() < sizeof(size) + size) {
+          break;
+        }
+        ok = handle(fd, pending.substr(sizeof(size), size));
+        pending.erase(0, sizeof(size) + size);
+      }
+      if (!ok) {
+        disconnect(i);
+      }
+    }
+
+    if (fds[1].revents != 0) {
+      int fd = ::accept(listenFd_, nullptr, nullptr);
+      if (fd >= 0) {
+        setNoDelay(fd);
+        clients_.push_back({fd, std::string()});
+      }
+    }
+  }
+}
+
+void TcpStoreServer::disconnect(size_t client) {
+  auto fd = clients_[client].fd;
+  ::close(fd);
+  clients_.erase(clients_.begin() + client);
+  for (auto it = waiters_.begin(); it != waiters_.end();) {
+    if (it->second.fd == fd) {
+      it = waiters_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+bool TcpStoreServer::handle(int fd, const std::string& request) {
+  std::string response;
+  try {
+    Reader reader(request);
+    auto command = static_cast<Command>(reader.read<uint8_t>());
+    switch (command) {
+      case Command::SET: {
+        auto count = reader.read<uint32_t>();
+        std::vector<std::pair<std::string, std::string>> items;
+        for (uint32_t i = 0; i < count; i++) {
+          auto name = reader.readString();
+          items.emplace_back(name, reader.readString());
+        }
+        // A name can only be set again to the same data
+        Status status = OK;
+        for (const auto& item : items) {
+          auto it = data_.find(item.first);
+          if (it != data_.end() && it->second != item.second) {
+            status = NOT_OK;
+          }
+        }
+        if (status == OK) {
+          for (auto& item : items) {
+            if (data_.emplace(item.first, item.second).second) {
+              keySet(item.first);
+            }
+          }
+        }
+        append<uint8_t>(response, status);
+        break;
+      }
+      case Command::GET:
+      case Command::WAIT: {
+        Waiter waiter{fd, command == Command::GET, reader.readStrings(), 0};
+        std::set<std::string> missing;
+        for (const auto& name : waiter.names) {
+          if (data_.count(name) == 0) {
+            missing.insert(name);
+          }
+        }
+        if (missing.empty()) {
+          reply(waiter);
+          return true;
+        }
+        waiter.missing = missing.size();
+        auto id = nextWaiter_++;
+        for (const auto& name : missing) {
+          waiting_[name].push_back(id);
+        }
+        waiters_.emplace(id, std::move(waiter));
+        return true;
+      }
+      case Command::ADD: {
+        auto name = reader.readString();
+        auto value = reader.read<int64_t>();
+        auto it = data_.find(name);
+        if (it != data_.end()) {
+          value += std::stoll(it->second);
+          it->second = std::to_string(value);
+        } else {
+          data_.emplace(name, std::to_string(value));
+          keySet(name);
+        }
+        append<int64_t>(response, value);
+        break;
+      }
+      case Command::CHECK: {
+        Status status = OK;
+        for (const auto& name : reader.readStrings()) {
+          if (data_.count(name) == 0) {
+            status = NOT_OK;
+          }
+        }
+        append<uint8_t>(response, status);
+        break;
+      }
+      default:
+        LOG(ERROR) << "Unknown store command "
+                   << static_cast<int>(command);
+        return false;
+    }
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Bad store request: " << e.what();
+    return false;
+  }
+  return sendAll(fd, frame(response));
+}
+
+void TcpStoreServer::keySet(const std::string& name) {
+  auto it = waiting_.find(name);
+  if (it == waiting_.end()) {
+    return;
+  }
+  auto ids = std::move(it->second);
+  waiting_.erase(it);
+  for (auto id : ids) {
+    auto waiter = waiters_.find(id);
+    // The client may have disconnected in the meantime
+    if (waiter == waiters_.end()) {
+      continue;
+    }
+    if (--waiter->second.missing == 0) {
+      reply(waiter->second);
+      waiters_.erase(waiter);
+    }
+  }
+}
+
+void TcpStoreServer::reply(const Waiter& waiter) {
+  std::string response;
+  if (waiter.isGet) {
+    for (const auto& name : waiter.names) {
+      appendString(response, data_.at(name));
+    }
+  } else {
+    append<uint8_t>(response, OK);
+  }
+  // A client that went away is noticed by the poll loop
+  sendAll(waiter.fd, frame(response));
+}
+
+TcpStoreHandler::TcpStoreHandler(
+    const std::string& host,
+    int port,
+    const std::string& prefix,
+    bool server)
+    : host_(host), port_(port), prefix_(prefix), fd_(-1) {
+  if (server) {
+    server_.reset(new TcpStoreServer(port));
+    port_ = server_->port();
+  }
+  connect();
+}
+
+TcpStoreHandler::~TcpStoreHandler() {
+  if (fd_ != -1) {
+    ::close(fd_);
+  }
+}
+
+void TcpStoreHandler::connect() {
+  // The server may still be starting, so keep trying for a while
+  const auto start = std::chrono::steady_clock::now();
+  while (true) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* res;
+    auto rv = getaddrinfo(
+        host_.c_str(), std::to_string(port_).c_str(), &hints, &res);
+    if (rv == 0) {
+      for (auto addr = res; addr != nullptr; addr = addr->ai_next) {
+        int fd =
+            ::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if (fd == -1) {
+          continue;
+        }
+        if (::connect(fd, addr->ai_addr, addr->ai_addrlen) == 0) {
+          fd_ = fd;
+          break;
+        }
+        ::close(fd);
+      }
+      freeaddrinfo(res);
+    }
+    if (fd_ != -1) {
+      setNoDelay(fd_);
+      return;
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    if (elapsed > kDefaultTimeout) {
+      STORE_HANDLER_TIMEOUT(
+          "Could not connect to store at ", host_, ":", port_);
+    }
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+std::string TcpStoreHandler::request(
+    const std::string& message,
+    const std::chrono::milliseconds& timeout,
+    const std::vector<std::string>& names) {
+  if (fd_ == -1) {
+    connect();
+  }
+  CAFFE_ENFORCE(sendAll(fd_, frame(message)), "send: ", strerror(errno));
+
+  // Read the length of the response, then the response
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  std::string response;
+  size_t expected = sizeof(uint32_t);
+  bool haveLength = false;
+  char buffer[4096];
+  while (response.size() < expected) {
+    int pollTimeout = -1;
+    if (timeout != kNoTimeout) {
+      auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - std::chrono::steady_clock::now());
+      pollTimeout = std::max<int>(0, left.count());
+    }
+    struct pollfd pfd = {fd_, POLLIN, 0};
+    auto rv = ::poll(&pfd, 1, pollTimeout);
+    if (rv < 0 && errno == EINTR) {
+      continue;
+    }
+    CAFFE_ENFORCE_GE(rv, 0, "poll: ", strerror(errno));
+    if (rv == 0) {
+      // The server still has our request; start over with a new connection
+      ::close(fd_);
+      fd_ = -1;
+      STORE_HANDLER_TIMEOUT("Wait timeout for name(s): ", Join(" ", names));
+    }
+
+    auto n = ::recv(
+        fd_,
+        buffer,
+        std::min(sizeof(buffer), expected - response.size()),
+        0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      ::close(fd_);
+      fd_ = -1;
+      CAFFE_THROW("Lost connection to store at ", host_, ":", port_);
+    }
+    response.append(buffer, n);
+    if (!haveLength && response.size() == expected) {
+      uint32_t size;
+      memcpy(&size, response.data(), sizeof(size));
+      response.clear();
+      expected = size;
+      haveLength = true;
+    }
+  }
+  return response;
+}
+
+std::string TcpStoreHandler::compoundKey(const std::string& name) {
+  return prefix_ + name;
+}
+
+void TcpStoreHandler::set(const std::string& name, const std::string& data) {
+  multiSet({name}, {data});
+}
+
+std::string TcpStoreHandler::get(const std::string& name) {
+  return multiGet({name})[0];
+}
+
+int64_t TcpStoreHandler::add(const std::string& name, int64_t value) {
+  std::string message;
+  append<uint8_t>(message, static_cast<uint8_t>(Command::ADD));
+  appendString(message, compoundKey(name));
+  append<int64_t>(message, value);
+  auto response = request(message, kDefaultTimeout, {name});
+  return Reader(response).read<int64_t>();
+}
+
+bool TcpStoreHandler::check(const std::vector<std::string>& names) {
+  std::string message;
+  append<uint8_t>(message, static_cast<uint8_t>(Command::CHECK));
+  append<uint32_t>(message, names.size());
+  for (const auto& name : names) {
+    appendString(message, compoundKey(name));
+  }
+  auto response = request(message, kDefaultTimeout, names);
+  return Reader(response).read<uint8_t>() == OK;
+}
+
+void TcpStoreHandler::wait(
+    const std::vector<std::string>& names,
+    const std::chrono::milliseconds& timeout) {
+  std::string message;
+  append<uint8_t>(message, static_cast<uint8_t>(Command::WAIT));
+  append<uint32_t>(message, names.size());
+  for (const auto& name : names) {
+    appendString(message, compoundKey(name));
+  }
+  request(message, timeout, names);
+}
+
+void TcpStoreHandler::multiSet(
+    const std::vector<std::string>& names,
+    const std::vector<std::string>& data) {
+  CAFFE_ENFORCE_EQ(names.size(), data.size());
+  std::string message;
+  append<uint8_t>(message, static_cast<uint8_t>(Command::SET));
+  append<uint32_t>(message, names.size());
+  for (size_t i = 0; i < names.size(); i++) {
+    appendString(message, compoundKey(names[i]));
+    appendString(message, data[i]);
+  }
+  auto response = request(message, kDefaultTimeout, names);
+  CAFFE_ENFORCE_EQ(
+      Reader(response).read<uint8_t>(),
+      OK,
+      "Value at ",
+      Join(" ", names),
+      " was already set to different data",
+      " (perhaps you reused a run ID you have used before?)");
+}
+
+std::vector<std::string> TcpStoreHandler::multiGet(
+    const std::vector<std::string>& names) {
+  std::string message;
+  append<uint8_t>(message, static_cast<uint8_t>(Command::GET));
+  append<uint32_t>(message, names.size());
+  for (const auto& name : names) {
+    appendString(message, compoundKey(name));
+  }
+  auto response = request(message, kDefaultTimeout, names);
+  Reader reader(response);
+  std::vector<std::string> data;
+  for (size_t i = 0; i < names.size(); i++) {
+    data.push_back(reader.readString());
+  }
+  return data;
+}
+
+} // namespace caffe2
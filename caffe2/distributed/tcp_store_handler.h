@@ -0,0 +1,116 @@
+#pragma once
+
+#include <caffe2/distributed/store_handler.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace caffe2 {
+
+/*
+ * In-memory key/value store served over TCP, for TcpStoreHandler.
+ *
+ * A single thread serves all clients. Requests that need keys which
+ * are not set yet (get and wait) are parked on the server and answered
+ * as soon as the last of their keys is set, so clients never poll.
+ */
+class TcpStoreServer {
+ public:
+  // Listens on all interfaces; port 0 picks a free port.
+  explicit TcpStoreServer(int port);
+  ~TcpStoreServer();
+
+  int port() const {
+    return port_;
+  }
+
+ private:
+  struct Client {
+    int fd;
+    std::string buffer;
+  };
+
+  // A get or wait that is waiting for `missing` more keys to be set.
+  struct Waiter {
+    int fd;
+    bool isGet;
+    std::vector<std::string> names;
+    size_t missing;
+  };
+
+  void run();
+  // Returns false if the client should be disconnected.
+  bool handle(int fd, const std::string& request);
+  void keySet(const std::string& name);
+  void reply(const Waiter& waiter);
+  void disconnect(size_t client);
+
+  int port_;
+  int listenFd_;
+  // Written to by the destructor to stop the thread.
+  int stopFds_[2];
+  std::thread thread_;
+
+  std::vector<Client> clients_;
+  std::unordered_map<std::string, std::string> data_;
+  std::unordered_map<size_t, Waiter> waiters_;
+  size_t nextWaiter_;
+  // Waiters for every key that isn't set yet
+  std::unordered_map<std::string, std::vector<size_t>> waiting_;
+};
+
+/*
+ * Store handler that keeps keys in a TcpStoreServer. Every operation is
+ * one round trip, also for many keys at once (see multiSet and multiGet),
+ * which makes the rendezvous of many processes much faster than with
+ * stores that poll. If `server` is set, the handler runs the server
+ * itself, for the other handlers to connect to. It has to be the last
+ * one to be destroyed.
+ */
+class TcpStoreHandler : public StoreHandler {
+ public:
+  explicit TcpStoreHandler(
+      const std::string& host,
+      int port,
+      const std::string& prefix,
+      bool server = false);
+  virtual ~TcpStoreHandler();
+
+  virtual void set(const std::string& name, const std::string& data) override;
+
+  virtual std::string get(const std::string& name) override;
+
+  virtual int64_t add(const std::string& name, int64_t value) override;
+
+  virtual bool check(const std::vector<std::string>& names) override;
+
+  virtual void wait(
+      const std::vector<std::string>& names,
+      const std::chrono::milliseconds& timeout = kDefaultTimeout) override;
+
+  virtual void multiSet(
+      const std::vector<std::string>& names,
+      const std::vector<std::string>& data) override;
+
+  virtual std::vector<std::string> multiGet(
+      const std::vector<std::string>& names) override;
+
+ private:
+  std::string host_;
+  int port_;
+  std::string prefix_;
+  std::unique_ptr<TcpStoreServer> server_;
+  int fd_;
+
+  void connect();
+  std::string request(
+      const std::string& message,
+      const std::chrono::milliseconds& timeout,
+      const std::vector<std::string>& names);
+  std::string compoundKey(const std::string& name);
+};
+
+} // namespace caffe2
@@ -0,0 +1,28 @@
+#include "tcp_store_handler_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(
+    TcpStoreHandlerCreate,
+    TcpStoreHandlerCreateOp<CPUContext>);
+
+OPERATOR_SCHEMA(TcpStoreHandlerCreate)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Creates a unique_ptr<StoreHandler> that keeps keys in memory on a TCP
+server. Gets and waits are answered by the server as soon as their keys
+are set, instead of being polled for, and many keys can be set or got in
+a single round trip. Exactly one of the processes sharing the store has
+to create its handler with `server` set, which runs the server in that
+process for as long as the handler lives.
+)DOC")
+    .Arg("host", "host name of the store server")
+    .Arg("port", "port number of the store server")
+    .Arg("prefix", "keys used by this instance are prefixed with this string")
+    .Arg("server", "run the store server in this process (default false)")
+    .Output(0, "handler", "unique_ptr<StoreHandler>");
+
+NO_GRADIENT(TcpStoreHandlerCreateOp);
+
+} // namespace caffe2
@@ -0,0 +1,11 @@
+#include "tcp_store_handler_op.h"
+
+#include <caffe2/core/context_gpu.h>
+
+namespace caffe2 {
+
+REGISTER_CUDA_OPERATOR(
+    TcpStoreHandlerCreate,
+    TcpStoreHandlerCreateOp<CUDAContext>);
+
+} // namespace caffe2
@@ -0,0 +1,73 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import socket
+import uuid
+from multiprocessing import Event, Process
+
+from caffe2.distributed.python import StoreHandlerTimeoutError
+from caffe2.distributed.store_ops_test_util import StoreOpsTests
+from caffe2.python import core, workspace, dyndep
+from caffe2.python.test_util import TestCase
+
+dyndep.InitOpsLibrary("@/caffe2/caffe2/distributed:tcp_store_handler_ops")
+dyndep.InitOpsLibrary("@/caffe2/caffe2/distributed:store_ops")
+
+
+def _free_port():
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.bind(("", 0))
+    port = sock.getsockname()[1]
+    sock.close()
+    return port
+
+
+def _run_server(port, stop):
+    workspace.RunOperatorOnce(
+        core.CreateOperator(
+            "TcpStoreHandlerCreate",
+            [],
+            ["server_store_handler"],
+            host="localhost",
+            port=port,
+            server=True))
+    stop.wait()
+    workspace.ResetWorkspace()
+
+
+class TestTcpStoreHandlerOp(TestCase):
+    def setUp(self):
+        super(TestTcpStoreHandlerOp, self).setUp()
+        self.uuid = str(uuid.uuid4()) + "/"
+        # The server runs in its own process, since every process the tests
+        # fork would get a copy of a handler that runs it
+        self.port = _free_port()
+        self.stop = Event()
+        self.server = Process(target=_run_server, args=(self.port, self.stop))
+        self.server.start()
+
+    def tearDown(self):
+        self.stop.set()
+        self.server.join()
+        super(TestTcpStoreHandlerOp, self).tearDown()
+
+    def create_store_handler(self):
+        store_handler = "store_handler"
+        workspace.RunOperatorOnce(
+            core.CreateOperator(
+                "TcpStoreHandlerCreate",
+                [],
+                [store_handler],
+                prefix=self.uuid,
+                host="localhost",
+                port=self.port))
+        return store_handler
+
+    def test_set_get(self):
+        StoreOpsTests.test_set_get(self.create_store_handler)
+
+    def test_get_timeout(self):
+        with self.assertRaises(StoreHandlerTimeoutError):
+            StoreOpsTests.test_get_timeout(self.create_store_handler)
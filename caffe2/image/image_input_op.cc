@@ -84,6 +84,9 @@ The dimension of the output image will always be cropxcrop
     .Arg("bounding_width", "Bounding box coordinate. Defaults to -1 (none)")
     .ArgIsTest("Set to 1 to do deterministic cropping. Defaults to 0")
     .Arg("use_caffe_datum", "1 if the input is in Caffe format. Defaults to 0")
+    .Arg("reduced_scale_decode", "1 to decode JPEGs at 1/2, 1/4 or 1/8 of "
+         "their size when they are scaled down at least that much anyway. "
+         "Needs a fixed scale, no scale jittering and no bounding boxes")
     .Arg("use_gpu_transform", "1 if GPU acceleration should be used."
          " Defaults to 0. Can only be 1 in a CUDAContext")
     .Arg("decode_threads", "Number of CPU decode/transform threads."
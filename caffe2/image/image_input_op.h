@@ -15,10 +15,59 @@
 #include "caffe2/operators/prefetch_op.h"
 #include "caffe2/image/transform_gpu.h"
 
+// cv::IMREAD_REDUCED_* decode JPEGs at 1/2, 1/4 or 1/8 of their size with
+// libjpeg's scaled IDCT
+#if CV_MAJOR_VERSION > 3 || (CV_MAJOR_VERSION == 3 && CV_MINOR_VERSION >= 2)
+#define CAFFE2_IMAGE_HAS_REDUCED_DECODE
+#endif
+
 namespace caffe2 {
 
 class CUDAContext;
 
+// Reads the size of a JPEG image from its frame header without decoding it.
+// Returns false if the data doesn't look like a JPEG.
+inline bool
+ReadJpegSize(const char* data, size_t size, int* height, int* width) {
+  const auto* p = reinterpret_cast<const unsigned char*>(data);
+  if (size < 4 || p[0] != 0xFF || p[1] != 0xD8) {
+    return false;
+  }
+  size_t pos = 2;
+  while (pos + 4 <= size) {
+    if (p[pos] != 0xFF) {
+      return false;
+    }
+    const unsigned char marker = p[pos + 1];
+    if (marker == 0xFF) {
+      // fill byte
+      ++pos;
+      continue;
+    }
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+      // markers without a payload
+      pos += 2;
+      continue;
+    }
+    if (marker == 0xD9 || marker == 0xDA) {
+      // end of image or start of scan before any frame header
+      return false;
+    }
+    // SOF0 - SOF15, except DHT, JPG and DAC
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+        marker != 0xC8 && marker != 0xCC) {
+      if (pos + 9 > size) {
+        return false;
+      }
+      *height = (p[pos + 5] << 8) | p[pos + 6];
+      *width = (p[pos + 7] << 8) | p[pos + 8];
+      return *height > 0 && *width > 0;
+    }
+    pos += 2 + ((p[pos + 2] << 8) | p[pos + 3]);
+  }
+  return false;
+}
+
 template <class Context>
 class ImageInputOp final
     : public PrefetchOperator<Context> {
@@ -73,6 +122,10 @@ class ImageInputOp final
     BoundingBox bounding_params;
   };
 
+  // The cv::imdecode flags for an encoded image, which decode JPEGs at a
+  // reduced scale when reduced_scale_decode is on and the image would be
+  // scaled down at least 2x anyway
+  int DecodeFlags(const char* data, size_t size, const PerImageArg& info);
   bool GetImageAndLabelAndInfoFromDBValue(
       const string& value, cv::Mat* img, PerImageArg& info, int item_id,
       std::mt19937* randgen);
@@ -85,6 +138,9 @@ class ImageInputOp final
 
   unique_ptr<db::DBReader> owned_reader_;
   const db::DBReader* reader_;
+  // sub-shard of a reader in sharded mode, claimed on the first prefetch
+  int reader_shard_ = -1;
+  bool reader_shard_acquired_ = false;
   CPUContext cpu_context_;
   TensorCPU prefetched_image_;
   TensorCPU prefetched_label_;
@@ -123,6 +179,7 @@ class ImageInputOp final
   bool is_test_;
   bool use_caffe_datum_;
   bool gpu_transform_;
+  bool reduced_scale_decode_;
   bool mean_std_copied_ = false;
 
   // thread pool for parse + decode
@@ -190,6 +247,9 @@ ImageInputOp<Context>::ImageInputOp(
       gpu_transform_(OperatorBase::template GetSingleArgument<int>(
           "use_gpu_transform",
           0)),
+      reduced_scale_decode_(OperatorBase::template GetSingleArgument<int>(
+          "reduced_scale_decode",
+          0)),
       num_decode_threads_(
           OperatorBase::template GetSingleArgument<int>("decode_threads", 4)),
       thread_pool_(std::make_shared<TaskThreadPool>(num_decode_threads_)),
@@ -306,11 +366,31 @@ ImageInputOp<Context>::ImageInputOp(
     std_.resize(3, std_[0]);
   }
 
+#ifndef CAFFE2_IMAGE_HAS_REDUCED_DECODE
+  if (reduced_scale_decode_) {
+    LOG(WARNING) << "reduced_scale_decode needs OpenCV 3.2 or later, ignoring";
+    reduced_scale_decode_ = false;
+  }
+#endif
+  // Only a fixed scale resizes every image the same way regardless of its
+  // size, and bounding boxes are in the coordinates of the full image
+  if (reduced_scale_decode_ &&
+      (scale_ <= 0 || random_scaling_ ||
+       scale_jitter_type_ != NO_SCALE_JITTER ||
+       default_arg_.bounding_params.valid)) {
+    LOG(WARNING) << "reduced_scale_decode only works with a fixed scale, "
+                    "without scale jittering and bounding boxes, ignoring";
+    reduced_scale_decode_ = false;
+  }
+
   LOG(INFO) << "Creating an image input op with the following setting: ";
   LOG(INFO) << "    Using " << num_decode_threads_ << " CPU threads;";
   if (gpu_transform_) {
     LOG(INFO) << "    Performing transformation on GPU";
   }
+  if (reduced_scale_decode_) {
+    LOG(INFO) << "    Decoding JPEGs at a reduced scale where possible";
+  }
   LOG(INFO) << "    Outputting in batches of " << batch_size_ << " images;";
   LOG(INFO) << "    Treating input image as "
             << (color_ ? "color " : "grayscale ") << "image;";
@@ -423,6 +503,34 @@ bool RandomSizedCropping(
   return inception_scale_jitter;
 }
 
+template <class Context>
+int ImageInputOp<Context>::DecodeFlags(
+    const char* data,
+    size_t size,
+    const PerImageArg& info) {
+  const int flags = color_ ? CV_LOAD_IMAGE_COLOR : CV_LOAD_IMAGE_GRAYSCALE;
+#ifdef CAFFE2_IMAGE_HAS_REDUCED_DECODE
+  int height, width;
+  if (!reduced_scale_decode_ || info.bounding_params.valid ||
+      !ReadJpegSize(data, size, &height, &width)) {
+    return flags;
+  }
+  // The decoded image still has to be scaled down (or not at all) to scale_,
+  // so the result barely differs from decoding at the full size
+  const int shortest = std::min(height, width);
+  if (shortest / 8 >= scale_) {
+    return color_ ? cv::IMREAD_REDUCED_COLOR_8 : cv::IMREAD_REDUCED_GRAYSCALE_8;
+  }
+  if (shortest / 4 >= scale_) {
+    return color_ ? cv::IMREAD_REDUCED_COLOR_4 : cv::IMREAD_REDUCED_GRAYSCALE_4;
+  }
+  if (shortest / 2 >= scale_) {
+    return color_ ? cv::IMREAD_REDUCED_COLOR_2 : cv::IMREAD_REDUCED_GRAYSCALE_2;
+  }
+#endif
+  return flags;
+}
+
 template <class Context>
 bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
     const string& value,
@@ -453,7 +561,7 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
               datum.data().size(),
               CV_8UC1,
               const_cast<char*>(datum.data().data())),
-          color_ ? CV_LOAD_IMAGE_COLOR : CV_LOAD_IMAGE_GRAYSCALE);
+          DecodeFlags(datum.data().data(), datum.data().size(), info));
     } else {
       // Raw image in datum.
       CAFFE_ENFORCE(datum.channels() == 3 || datum.channels() == 1);
@@ -517,7 +625,8 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
               &encoded_size,
               CV_8UC1,
               const_cast<char*>(encoded_image_str.data())),
-          color_ ? CV_LOAD_IMAGE_COLOR : CV_LOAD_IMAGE_GRAYSCALE);
+          DecodeFlags(
+              encoded_image_str.data(), encoded_image_str.size(), info));
     } else if (image_proto.data_type() == TensorProto::BYTE) {
       // raw image content.
       int src_c = (image_proto.dims_size() == 3) ? image_proto.dims(2) : 1;
@@ -1070,6 +1179,10 @@ bool ImageInputOp<Context>::Prefetch() {
     // pointer.
     reader_ = &OperatorBase::Input<db::DBReader>(0);
   }
+  if (!reader_shard_acquired_) {
+    reader_shard_ = reader_->AcquireShard();
+    reader_shard_acquired_ = true;
+  }
   const int channels = color_ ? 3 : 1;
   // Call mutable_data() once to allocate the underlying memory.
   if (gpu_transform_) {
@@ -1087,7 +1200,7 @@ bool ImageInputOp<Context>::Prefetch() {
     cv::Mat img;
 
     // read data
-    reader_->Read(&key, &value);
+    reader_->Read(&key, &value, reader_shard_);
 
     // determine label type based on first item
     if( item_id == 0 ) {
@@ -1,3 +1,5 @@
+#include <map>
+
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/mkl/mkl_utils.h"
@@ -49,9 +51,12 @@ class MKLConvOp final : public ConvPoolOpBase<MKLContext> {
     const int N = X.dim32(0), C = X.dim32(1), H = X.dim32(2), W = X.dim32(3);
     CAFFE_ENFORCE(4 == filter.ndim());
 
-    bool dims_changed;
-    CHECK_INPUT_FILTER_DIMS(X, filter, dims_changed);
-    if (dims_changed || FLAGS_caffe2_mkl_memonger_in_use) {
+    // Nets that alternate between a few input shapes (e.g. the last, smaller
+    // batch of an epoch) keep one primitive per shape rather than recreating
+    // it on every change.
+    const auto key = std::make_pair(X.dims(), filter.dims());
+    auto it = primitives_.find(key);
+    if (it == primitives_.end() || FLAGS_caffe2_mkl_memonger_in_use) {
       CAFFE_ENFORCE(
           C == filter.dim32(1) * group_,
           "Convolution op: input channels does not match: # of input channels ",
@@ -68,6 +73,15 @@ class MKLConvOp final : public ConvPoolOpBase<MKLContext> {
       CAFFE_ENFORCE(bias.ndim() == 1);
       CAFFE_ENFORCE(bias.dim32(0) == M);
 
+      if (primitives_.size() >= kMaxCachedPrimitives) {
+        primitives_.clear();
+        state_ = nullptr;
+      }
+      std::unique_ptr<PrimitiveState>& state = primitives_[key];
+      if (!state) {
+        state.reset(new PrimitiveState());
+      }
+
       size_t dimension = 4;
       size_t bdata_sizes[4] = {W, H, C, N};
       // We will utilize the SetOutputSize() function int he base class
@@ -85,7 +99,7 @@ class MKLConvOp final : public ConvPoolOpBase<MKLContext> {
       int pads[2] = {-pad_l(), -pad_t()};
 
       if (group_ > 1) {
-        primitive_.Reset(
+        state->primitive.Reset(
             dnnGroupsConvolutionCreateForwardBias<float>,
             nullptr,
             dnnAlgorithmConvolutionDirect,
@@ -98,7 +112,7 @@ class MKLConvOp final : public ConvPoolOpBase<MKLContext> {
             pads,
             dnnBorderZeros);
       } else {
-        primitive_.Reset(
+        state->primitive.Reset(
             dnnConvolutionCreateForwardBias<float>,
             nullptr,
             dnnAlgorithmConvolutionDirect,
@@ -110,22 +124,29 @@ class MKLConvOp final : public ConvPoolOpBase<MKLContext> {
             pads,
             dnnBorderZeros);
       }
-      Y->Reset(dummy_output.dims(), primitive_, dnnResourceDst);
-      buffer_.Reset(dummy_output.dims(), primitive_, dnnResourceDst, true);
-      input_layout_.Reset(primitive_, dnnResourceSrc);
-      filter_layout_.Reset(primitive_, dnnResourceFilter);
-      bias_layout_.Reset(primitive_, dnnResourceBias);
+      state->output_dims = dummy_output.dims();
+      state->buffer.Reset(
+          state->output_dims, state->primitive, dnnResourceDst, true);
+      state->input_layout.Reset(state->primitive, dnnResourceSrc);
+      state->filter_layout.Reset(state->primitive, dnnResourceFilter);
+      state->bias_layout.Reset(state->primitive, dnnResourceBias);
+      Y->Reset(state->output_dims, state->primitive, dnnResourceDst);
+      state_ = state.get();
+    } else if (state_ != it->second.get()) {
+      state_ = it->second.get();
+      // The output still has the layout of the previous primitive
+      Y->Reset(state_->output_dims, state_->primitive, dnnResourceDst);
     }
 
     // Try to share from the output: this allows us to avoid unnecessary copy
     // operations, if the output is already allocated and is having the same
     // layout as the buffer has.
-    bool shared = buffer_.ShareFrom(*Y);
+    bool shared = state_->buffer.ShareFrom(*Y);
 
     std::shared_ptr<void> X_view = X.View(
-        input_layout_, primitive_, dnnResourceSrc);
+        state_->input_layout, state_->primitive, dnnResourceSrc);
     std::shared_ptr<void> bias_view =
-        bias.View(bias_layout_, primitive_, dnnResourceBias);
+        bias.View(state_->bias_layout, state_->primitive, dnnResourceBias);
     std::shared_ptr<void> filter_view;
     if (group_ > 1) {
       // Explicitly reformat the buffer.
@@ -140,22 +161,24 @@ class MKLConvOp final : public ConvPoolOpBase<MKLContext> {
           /*share_memory_if_possible=*/true);
       group_filter.CopyFrom(filter.buffer());
       filter_view =
-          group_filter.View(filter_layout_, primitive_, dnnResourceFilter);
+          group_filter.View(
+              state_->filter_layout, state_->primitive, dnnResourceFilter);
     } else {
-      filter_view = filter.View(filter_layout_, primitive_, dnnResourceFilter);
+      filter_view = filter.View(
+          state_->filter_layout, state_->primitive, dnnResourceFilter);
     }
 
     resources_[dnnResourceSrc] = X_view.get(); // X.buffer();
     resources_[dnnResourceFilter] = filter_view.get();
     resources_[dnnResourceBias] = bias_view.get();
-    resources_[dnnResourceDst] = buffer_.buffer();
+    resources_[dnnResourceDst] = state_->buffer.buffer();
 
-    MKLDNN_SAFE_CALL(mkl::dnnExecute<T>(primitive_, resources_));
-    buffer_.CopyTo(Y, primitive_, dnnResourceDst);
+    MKLDNN_SAFE_CALL(mkl::dnnExecute<T>(state_->primitive, resources_));
+    state_->buffer.CopyTo(Y, state_->primitive, dnnResourceDst);
     if (FLAGS_caffe2_mkl_memonger_in_use && !shared) {
-      // buffer_ is not shared with Y. Free memory since it'll
+      // The buffer is not shared with Y. Free memory since it'll
       // be re-allocated in the next run anyway due to memonger in use.
-      buffer_.Reset();
+      state_->buffer.Reset();
     }
     return true;
   }
@@ -168,13 +191,23 @@ class MKLConvOp final : public ConvPoolOpBase<MKLContext> {
   // Input: X, W, b
   // Output: Y
   std::unique_ptr<MKLMemory<T>> zero_bias_;
-  vector<TIndex> cached_input_dims_;
-  vector<TIndex> cached_filter_dims_;
-  PrimitiveWrapper<T> primitive_;
-  LayoutWrapper<T> input_layout_;
-  LayoutWrapper<T> filter_layout_;
-  LayoutWrapper<T> bias_layout_;
-  MKLMemory<T> buffer_;
+  // The primitive for one pair of input and filter shapes, with the layouts
+  // it expects and the buffer it writes to.
+  struct PrimitiveState {
+    PrimitiveWrapper<T> primitive;
+    LayoutWrapper<T> input_layout;
+    LayoutWrapper<T> filter_layout;
+    LayoutWrapper<T> bias_layout;
+    vector<TIndex> output_dims;
+    MKLMemory<T> buffer;
+  };
+  static constexpr size_t kMaxCachedPrimitives = 8;
+  std::map<
+      std::pair<vector<TIndex>, vector<TIndex>>,
+      std::unique_ptr<PrimitiveState>>
+      primitives_;
+  // The state of the last run, whose layout the output has.
+  PrimitiveState* state_ = nullptr;
   void* resources_[dnnResourceNumber] = {0};
   INPUT_TAGS(INPUT, FILTER, BIAS);
 };
@@ -15,6 +15,7 @@
 
 #include "arm_compute/core/GLES_COMPUTE/OpenGLES.h"
 #include "arm_compute/runtime/GLES_COMPUTE/GCFunctions.h"
+#include "arm_compute/runtime/GLES_COMPUTE/GCMemoryGroup.h"
 #include "arm_compute/runtime/GLES_COMPUTE/GCScheduler.h"
 #include "arm_compute/runtime/GLES_COMPUTE/GCTensor.h"
 
@@ -116,13 +117,16 @@ public:
 
 template <typename T> class GLTensor {
 private:
-  bool allocated_ = false;
+  // the memory of a tensor is allocated once, by its first reader or writer,
+  // or when the lifetime of a managed tensor ends
+  mutable bool allocated_ = false;
 public:
   GLTensor() { tensor_ = make_unique<arm_compute::GCTensor>(); }
   ~GLTensor() { tensor_->allocator()->free(); }
 
   template <typename TensorType> void ResizeLike(TensorType &X) {
     tensor_->allocator()->free();
+    allocated_ = false;
     SetDims(X.dims());
     shape_ = arm_compute::TensorShape();
     for (int i = 0; i < dims_.size(); i++) {
@@ -139,6 +143,7 @@ public:
       // TODO: Make it type generic
       int64_t new_size = size_ * sizeof(T);
       tensor_->allocator()->free();
+      allocated_ = false;
       for (int i = 0; i < dims_.size(); i++) {
         shape_.set(dims_.size() - i - 1, dims_[i]);
       }
@@ -162,7 +167,18 @@ public:
   }
 
   void allocate() const {
-    tensor_->allocator()->allocate();
+    if (!allocated_) {
+      tensor_->allocator()->allocate();
+      allocated_ = true;
+    }
+  }
+
+  // The memory of the tensor comes from the pool of group, and can be shared
+  // with the tensors of the group whose lifetimes do not overlap: the lifetime
+  // starts here, before the tensor is configured, and ends when it is
+  // allocated, after its last reader is configured.
+  void manage(arm_compute::GCMemoryGroup *group) const {
+    group->manage(tensor_.get());
   }
 
   void fillGLTensor(const Blob *b) const {
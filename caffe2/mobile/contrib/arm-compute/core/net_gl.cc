@@ -15,6 +15,52 @@
 
 namespace caffe2 {
 
+std::vector<GLTensorLifetime> planGLTensorLifetimes(const NetDef& net) {
+  auto isOpenGL = [&](const OperatorDef& op) {
+    const auto& option =
+        op.has_device_option() ? op.device_option() : net.device_option();
+    return option.device_type() == OPENGL;
+  };
+  std::unordered_set<string> excluded(
+      net.external_input().begin(), net.external_input().end());
+  excluded.insert(net.external_output().begin(), net.external_output().end());
+
+  std::vector<GLTensorLifetime> lifetimes;
+  std::unordered_map<string, size_t> index;
+  for (int idx = 0; idx < net.op_size(); ++idx) {
+    const auto& op = net.op(idx);
+    const bool opengl = isOpenGL(op);
+    for (const auto& input : op.input()) {
+      auto it = index.find(input);
+      if (it == index.end()) {
+        continue;
+      }
+      if (opengl) {
+        lifetimes[it->second].end = idx;
+      } else {
+        excluded.insert(input);
+      }
+    }
+    for (const auto& output : op.output()) {
+      if (!opengl) {
+        excluded.insert(output);
+      } else if (!index.count(output)) {
+        index[output] = lifetimes.size();
+        lifetimes.push_back({output, idx, idx});
+      }
+    }
+  }
+
+  std::vector<GLTensorLifetime> managed;
+  for (const auto& lifetime : lifetimes) {
+    // A blob that no operator reads is an output, even if undeclared
+    if (!excluded.count(lifetime.blob) && lifetime.end > lifetime.start) {
+      managed.push_back(lifetime);
+    }
+  }
+  return managed;
+}
+
 GLNet::GLNet(
     const std::shared_ptr<const NetDef>& net_def,
     Workspace* ws)
@@ -49,17 +95,59 @@ GLNet::GLNet(
     }
     operators_.emplace_back(std::move(op));
   }
+
+  lifetime_starts_.resize(operators_.size());
+  lifetime_ends_.resize(operators_.size());
+  const auto lifetimes = planGLTensorLifetimes(*net_def);
+  for (const auto& lifetime : lifetimes) {
+    lifetime_starts_[lifetime.start].push_back(lifetime.blob);
+    lifetime_ends_[lifetime.end].push_back(lifetime.blob);
+  }
+  if (lifetimes.empty()) {
+    return;
+  }
+  memory_manager_ = std::make_shared<arm_compute::MemoryManagerOnDemand>(
+      std::make_shared<arm_compute::BlobLifetimeManager>(),
+      std::make_shared<arm_compute::PoolManager>());
+  memory_group_.reset(new arm_compute::GCMemoryGroup(memory_manager_));
+}
+
+GLNet::~GLNet() {
+  if (memory_group_ && !first_run_) {
+    memory_group_->release();
+  }
+}
+
+void GLNet::Configure() {
+  for (int idx = 0; idx < operators_.size(); ++idx) {
+    if (operators_[idx]->device_option().device_type() != OPENGL) {
+      continue;
+    }
+    for (const auto& blob : lifetime_starts_[idx]) {
+      ws_->GetBlob(blob)->GetMutable<GLTensor<half>>()->manage(
+          memory_group_.get());
+    }
+    operators_[idx]->Run();
+    for (const auto& blob : lifetime_ends_[idx]) {
+      ws_->GetBlob(blob)->Get<GLTensor<half>>().allocate();
+    }
+  }
+  if (!memory_group_) {
+    return;
+  }
+  // A single pool holds all the managed tensors, at the offsets found by the
+  // lifetime manager
+  memory_manager_->set_allocator(&allocator_);
+  memory_manager_->set_num_pools(1);
+  memory_manager_->finalize();
+  memory_group_->acquire();
 }
 
 bool GLNet::Run() {
   StartAllObservers();
   if (first_run_) {
     first_run_ = false;
-    for (auto& op: operators_) {
-      if (op->device_option().device_type() == OPENGL) {
-        op->Run();
-      }
-    }
+    Configure();
   }
   VLOG(1) << "Running net " << name_;
   for (auto& op : operators_) {
@@ -11,8 +11,25 @@
 #include "caffe2/core/workspace.h"
 #include "caffe2/proto/caffe2.pb.h"
 
+#include "arm_compute/runtime/GLES_COMPUTE/GCBufferAllocator.h"
+#include "arm_compute/runtime/GLES_COMPUTE/GCMemoryGroup.h"
+#include "arm_compute/runtime/MemoryManagerOnDemand.h"
+
 namespace caffe2 {
 
+// The lifetime of the GLTensor of an intermediate blob: the index of the
+// operator that first writes it and of the last operator that reads it.
+struct GLTensorLifetime {
+  string blob;
+  int start;
+  int end;
+};
+
+// The GLTensors of net whose memory can be shared: those written by OpenGL
+// operators that later OpenGL operators, and only those, read, and that are
+// not outputs of the net. They are in the order their lifetimes start.
+std::vector<GLTensorLifetime> planGLTensorLifetimes(const NetDef& net);
+
 // This is the very basic structure you need to run a network with
 // ARM's compute library
 class GLNet : public NetBase {
@@ -23,8 +40,18 @@ class GLNet : public NetBase {
   std::vector<string> output_blobs_;
   // record operator type and only sync after gpu op
   std::vector<bool> opengl_device_;
+  // the blobs whose lifetime starts and ends at each operator
+  std::vector<std::vector<string>> lifetime_starts_, lifetime_ends_;
+  arm_compute::GCBufferAllocator allocator_;
+  std::shared_ptr<arm_compute::MemoryManagerOnDemand> memory_manager_;
+  // the intermediate GLTensors, which share the memory of a single pool
+  std::unique_ptr<arm_compute::GCMemoryGroup> memory_group_;
+
+  // Configures the OpenGL operators, and plans the memory of the tensors
+  void Configure();
  public:
   GLNet(const std::shared_ptr<const NetDef>& net_def, Workspace* ws);
+  ~GLNet();
   bool SupportsAsync() override {
     return false;
   }
@@ -2,6 +2,7 @@
 #include "rewrite_net.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/utils/proto_utils.h"
+#include <algorithm>
 #include <unordered_map>
 
 namespace caffe2 {
@@ -134,10 +135,15 @@ static NetDef insertInputOutputCopyOps(const NetDef& def, std::unordered_set<std
   return mdef;
 }
 
+static bool isExternalOutput(const NetDef& def, const std::string& blob) {
+  return std::find(def.external_output().begin(), def.external_output().end(), blob) !=
+      def.external_output().end();
+}
+
 static bool tryFuseAdjacentOps(const OperatorDef& currentOp,
                                const OperatorDef& nextOp,
                                OperatorDef* fusedOp,
-                               std::unordered_set<std::string>& glOps) {
+                               const std::unordered_set<std::string>& cpuOps) {
   // Check for possible invalid opportunities.
   if (currentOp.output_size() != 1 || nextOp.output_size() != 1) {
     return false;
@@ -146,18 +152,18 @@ static bool tryFuseAdjacentOps(const OperatorDef& currentOp,
   if (currentOp.output(0) != nextOp.input(0) || currentOp.input(0) == nextOp.output(0)) {
     return false;
   }
+  if (cpuOps.count(currentOp.type()) > 0 || cpuOps.count(nextOp.type()) > 0) {
+    return false;
+  }
 
+  // The activation is computed by the ACL kernel of the first op
   static const std::map<std::pair<std::string, std::string>, std::string> fusionOpportunities = {
-      {{"OpenGLInstanceNorm", "OpenGLPRelu"}, "OpenGLInstanceNormPRelu"},
-      {{"OpenGLConv", "OpenGLPRelu"}, "OpenGLConvPRelu"},
-      {{"OpenGLConv", "OpenGLRelu"}, "OpenGLConvRelu"},
-      {{"OpenGLConvTranspose", "OpenGLPRelu"}, "OpenGLConvTransposePRelu"}};
+      {{"Conv", "Relu"}, "ConvRelu"}};
   auto it = fusionOpportunities.find({currentOp.type(), nextOp.type()});
   if (it == fusionOpportunities.end()) {
     return false;
   }
 
-  glOps.insert(it->second);
   fusedOp->CopyFrom(currentOp);
   fusedOp->set_output(0, nextOp.output(0));
   fusedOp->set_type(it->second);
@@ -167,8 +173,9 @@ static bool tryFuseAdjacentOps(const OperatorDef& currentOp,
   return true;
 }
 
-static NetDef runOpenGLFusion(const NetDef& def, std::unordered_set<std::string>& glOps) {
+static NetDef runOpenGLFusion(const NetDef& def, const std::unordered_set<std::string>& cpuOps) {
   CHECK_GE(def.op_size(), 1);
+  auto analysis = analyzeNet(def);
   NetDef mdef;
   mdef.CopyFrom(def);
   mdef.clear_op();
@@ -186,7 +193,12 @@ static NetDef runOpenGLFusion(const NetDef& def, std::unordered_set<std::string>
     const auto& currentOp = def.op(i);
     const auto& nextOp = def.op(i + 1);
     OperatorDef fusedOp;
-    if (tryFuseAdjacentOps(currentOp, nextOp, &fusedOp, glOps)) {
+    // The intermediate blob disappears, so nothing else may read it.
+    bool intermediate = currentOp.output_size() == 1 &&
+        !isExternalOutput(def, currentOp.output(0)) &&
+        analysis.inUsages[currentOp.output(0)][analysis.ssa[i].outVersions[currentOp.output(0)]] ==
+            std::vector<size_t>{static_cast<size_t>(i + 1)};
+    if (intermediate && tryFuseAdjacentOps(currentOp, nextOp, &fusedOp, cpuOps)) {
       VLOG(2) << "Found an adjacent fusion for: " << currentOp.type() << ", " << nextOp.type();
       // We can fuse.
       auto* op = mdef.add_op();
@@ -203,6 +215,65 @@ static NetDef runOpenGLFusion(const NetDef& def, std::unordered_set<std::string>
   return mdef;
 }
 
+// Makes the activations which are the only readers of the output of an OpenGL
+// op write their result in place, so that they need no GLTensor of their own.
+// The readers of the output of the activation read its input instead.
+static NetDef runInPlaceActivation(const NetDef& def,
+                                   const std::unordered_set<std::string>& cpuOps) {
+  static const std::unordered_set<std::string> activations = {"Relu", "Sigmoid"};
+  auto analysis = analyzeNet(def);
+  // the last version of each blob
+  std::unordered_map<std::string, size_t> lastVersions;
+  for (const auto& ssa : analysis.ssa) {
+    for (const auto& it : ssa.outVersions) {
+      lastVersions[it.first] = it.second;
+    }
+  }
+
+  NetDef mdef;
+  mdef.CopyFrom(def);
+  // the blobs renamed by the activations made in place, by version
+  std::unordered_map<std::string, std::unordered_map<size_t, std::string>> renamed;
+  std::unordered_set<std::string> producedOnGL;
+  for (auto i = 0; i < mdef.op_size(); i++) {
+    auto* op = mdef.mutable_op(i);
+    for (auto j = 0; j < op->input_size(); j++) {
+      const auto& input = def.op(i).input(j);
+      auto it = renamed.find(input);
+      if (it != renamed.end() && it->second.count(analysis.ssa[i].inVersions[input]) > 0) {
+        *op->mutable_input(j) = it->second[analysis.ssa[i].inVersions[input]];
+      }
+    }
+    const auto& currentOp = def.op(i);
+    if (cpuOps.count(currentOp.type()) > 0) {
+      for (const auto& output : op->output()) {
+        producedOnGL.erase(output);
+      }
+      continue;
+    }
+    if (activations.count(currentOp.type()) > 0 && currentOp.input(0) != currentOp.output(0)) {
+      const auto& input = currentOp.input(0);
+      const auto& output = currentOp.output(0);
+      const auto inVersion = analysis.ssa[i].inVersions[input];
+      const auto outVersion = analysis.ssa[i].outVersions[output];
+      // The input is a GLTensor, read only by the activation and not written
+      // again, and the name of the output is not needed after the net
+      if (producedOnGL.count(op->input(0)) > 0 && !isExternalOutput(def, input) &&
+          !isExternalOutput(def, output) &&
+          analysis.inUsages[input][inVersion] == std::vector<size_t>{static_cast<size_t>(i)} &&
+          lastVersions[input] == inVersion) {
+        renamed[output][outVersion] = op->input(0);
+        op->set_output(0, op->input(0));
+        continue;
+      }
+    }
+    for (const auto& output : op->output()) {
+      producedOnGL.insert(output);
+    }
+  }
+  return mdef;
+}
+
 void dumpDefForOpenGL(const NetDef& d) {
   for (const auto& op : d.op()) {
     LOG(INFO) << op.input(0) << " -> " << op.type() << " -> " << op.output(0);
@@ -228,9 +299,10 @@ NetDef rewritePredictNetForOpenGL(const NetDef& predictNet, bool runFusion, std:
   NetDef net;
   net.CopyFrom(predictNet);
 
-  // if (runFusion) {
-  //   net = runOpenGLFusion(net, openGLOps);
-  // }
+  if (runFusion) {
+    net = runOpenGLFusion(net, cpuOps);
+    net = runInPlaceActivation(net, cpuOps);
+  }
 
   net = insertInputOutputCopyOps(net, cpuOps);
   net.set_type("opengl");
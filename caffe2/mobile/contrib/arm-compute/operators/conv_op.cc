@@ -7,7 +7,9 @@
 
 namespace caffe2 {
 
-template <typename T>
+// With fuseRelu, the activation is applied by the convolution kernel itself,
+// which saves the dispatch and the memory of a separate Relu.
+template <typename T, bool fuseRelu = false>
 class GLConvOp final : public ConvPoolOpBase<GLContext> {
  public:
   USE_CONV_POOL_BASE_FUNCTIONS(GLContext);
@@ -28,8 +30,8 @@ private:
   GLContext::deleted_unique_ptr<const GLTensor<T>> X_, filter_, bias_;
 };
 
-template <typename T>
-bool GLConvOp<T>::RunOnDevice() {
+template <typename T, bool fuseRelu>
+bool GLConvOp<T, fuseRelu>::RunOnDevice() {
   auto *Xblob = OperatorBase::Inputs()[0];
   auto *filterblob = OperatorBase::Inputs()[1];
   auto *biasblob = OperatorBase::Inputs()[2];
@@ -81,7 +83,10 @@ bool GLConvOp<T>::RunOnDevice() {
     conv_.configure(
         X_->get_underlying(), filter_->get_underlying(), bias_->get_underlying(),
         Y->get_underlying(),
-        arm_compute::PadStrideInfo(stride_[0], stride_[1], pads_[0], pads_[1]));
+        arm_compute::PadStrideInfo(stride_[0], stride_[1], pads_[0], pads_[1]),
+        fuseRelu ? arm_compute::ActivationLayerInfo(
+                       arm_compute::ActivationLayerInfo::ActivationFunction::RELU)
+                 : arm_compute::ActivationLayerInfo());
 
   } else {
     // Always attempt to copy the CPU to GPU on input
@@ -101,5 +106,6 @@ bool GLConvOp<T>::RunOnDevice() {
 }
 
 REGISTER_GL_OPERATOR(Conv, GLConvOp<DataType>);
+REGISTER_GL_OPERATOR(ConvRelu, GLConvOp<DataType, true>);
 
 } // namespace caffe2
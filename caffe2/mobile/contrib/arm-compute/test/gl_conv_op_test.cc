@@ -1,4 +1,5 @@
 #include "gl_operator_test.h"
+#include "caffe2/mobile/contrib/arm-compute/core/rewrite_net.h"
 #include "caffe2/core/timer.h"
 
 namespace caffe2 {
@@ -109,6 +110,89 @@ TEST(OPENGLOperatorTest, ConvReluConv) {
 
 }
 
+TEST(OPENGLOperatorTest, ConvRelu) {
+
+  Workspace ws;
+  auto channel_in = 16;
+  auto channel_out = 16;
+  auto spatial = 16;
+  auto kern = 3;
+
+  PopulateCPUBlob(&ws, true, "cpu_X", {1, channel_in, spatial, spatial}, 1337);
+  PopulateCPUBlob(&ws, true, "W", {channel_out, channel_in, kern, kern}, 1337);
+  PopulateCPUBlob(&ws, true, "b", {channel_out});
+
+#define ADD_CONV_ARGS                                                          \
+  {                                                                            \
+    ADD_ARG((*def), "kernel", i, kern);                                           \
+    ADD_ARG((*def), "stride", i, 1);                                              \
+    ADD_ARG((*def), "pad", i, 0);                                                 \
+    ADD_ARG((*def), "order", s, "NCHW");                                          \
+  }
+
+  NetDef cpu_net;
+  {
+    OperatorDef* def = AddOp(&cpu_net, "Conv", {"cpu_X", "W", "b"}, {"ref_conv"});
+    ADD_CONV_ARGS;
+  }
+  {
+    AddOp(&cpu_net, "Relu", {"ref_conv"}, {"ref_Y"});
+  }
+
+  NetDef gpu_net;
+  gpu_net.set_type("opengl");
+  {
+    OperatorDef* def = AddOp(&gpu_net, "ConvRelu", {"cpu_X", "W", "b"}, {"gpu_Y"});
+    MAKE_OPENGL_OPERATOR(def);
+    ADD_CONV_ARGS;
+  }
+
+#undef ADD_CONV_ARGS
+
+  compareNetResult4D(ws, cpu_net, gpu_net, "ref_Y", "gpu_Y", tol);
+
+}
+
+TEST(OPENGLOperatorTest, ConvReluRewrite) {
+
+  NetDef net;
+  AddOp(&net, "Conv", {"X", "W", "b"}, {"conv"});
+  AddOp(&net, "Relu", {"conv"}, {"relu"});
+  AddOp(&net, "Conv", {"relu", "W2", "b2"}, {"conv2"});
+  // conv2 has two readers, so it is neither fused nor made in place
+  AddOp(&net, "Relu", {"conv2"}, {"relu2"});
+  AddOp(&net, "Sigmoid", {"relu2"}, {"sigmoid"});
+  AddOp(&net, "Sum", {"sigmoid", "conv2"}, {"Y"});
+  net.add_external_input("X");
+  net.add_external_output("Y");
+
+  NetDef gl_net = rewritePredictNetForOpenGL(net, true, {});
+  std::vector<string> types;
+  for (const auto& op : gl_net.op()) {
+    types.push_back(op.type());
+  }
+  EXPECT_EQ(types, (std::vector<string>{"ConvRelu", "Conv", "Relu", "Sigmoid", "Sum"}));
+  EXPECT_EQ(gl_net.op(1).input(0), "relu_M");
+  // The Sigmoid writes the output of the Relu in place
+  EXPECT_EQ(gl_net.op(3).input(0), "relu2_M");
+  EXPECT_EQ(gl_net.op(3).output(0), "relu2_M");
+  EXPECT_EQ(gl_net.op(4).input(0), "relu2_M");
+  EXPECT_EQ(gl_net.op(4).output(0), "Y");
+
+  // The output of the net, and the blobs no later op reads, are not managed
+  auto lifetimes = planGLTensorLifetimes(gl_net);
+  ASSERT_EQ(lifetimes.size(), 3);
+  EXPECT_EQ(lifetimes[0].blob, "relu_M");
+  EXPECT_EQ(lifetimes[0].start, 0);
+  EXPECT_EQ(lifetimes[0].end, 1);
+  EXPECT_EQ(lifetimes[1].blob, "conv2_M");
+  EXPECT_EQ(lifetimes[1].start, 1);
+  EXPECT_EQ(lifetimes[1].end, 4);
+  EXPECT_EQ(lifetimes[2].blob, "relu2_M");
+  EXPECT_EQ(lifetimes[2].start, 2);
+  EXPECT_EQ(lifetimes[2].end, 4);
+}
+
 TEST(OPENGLOperatorTest, ConvBenchmark) {
 
  Workspace ws;
@@ -16,6 +16,9 @@ bool tryConvertToMPSCNN(const NetDef& initNet, const NetDef& predictNet, NetDef*
 
 // Exposed for testing.
 NetDef annotateDefWithReadCounts(const NetDef& net);
+// Gives static output images to ops after which the command buffer can be
+// committed, about every opsPerCommandBuffer ops, if positive.
+NetDef annotateDefWithCommandBufferBatches(const NetDef& net, int opsPerCommandBuffer);
 NetDef rewriteForMetal(const NetDef& net);
 NetDef runMPSCNNFusion(const NetDef& net);
 void dumpDef(const NetDef& d);
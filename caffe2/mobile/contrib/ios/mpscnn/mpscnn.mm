@@ -1093,6 +1093,9 @@ class MPSCNNSubOp final : public Operator<CPUContext> {
 REGISTER_CPU_OPERATOR(MPSCNNSub, MPSCNNSubOp);
 OPERATOR_SCHEMA(MPSCNNSub).NumInputs(2).NumOutputs(1).AllowInplace({{0, 0}});
 
+// With fuseRelu, applies a ReLU to the sum in the same kernel, so that the
+// sum is never written out (e.g. the end of a residual block).
+template <bool fuseRelu>
 class MPSCNNAddOp final : public Operator<CPUContext> {
  public:
   MPSCNNAddOp(const OperatorDef& operator_def, Workspace* ws)
@@ -1122,7 +1125,9 @@ class MPSCNNAddOp final : public Operator<CPUContext> {
     id<MTLComputeCommandEncoder> encoder =
         [commandBuffer computeCommandEncoder];
     id<MTLComputePipelineState> state = getMPSCNNContext().getPipelineState(
-        kernelFor(X0, @"elementwise_add", @"elementwise_add_nonarray"));
+        fuseRelu ? kernelFor(
+                       X0, @"elementwise_add_relu", @"elementwise_add_relu_nonarray")
+                 : kernelFor(X0, @"elementwise_add", @"elementwise_add_nonarray"));
 
     [encoder setComputePipelineState:state];
     [encoder setTexture:[X0 texture] atIndex:0];
@@ -1142,10 +1147,15 @@ class MPSCNNAddOp final : public Operator<CPUContext> {
   }
 };
 
-REGISTER_CPU_OPERATOR(MPSCNNAdd, MPSCNNAddOp);
+REGISTER_CPU_OPERATOR(MPSCNNAdd, MPSCNNAddOp<false>);
 // Not really in-place per-se, but semantically is valid and preserves
 // compatibility.
 OPERATOR_SCHEMA(MPSCNNAdd).NumInputs(2).NumOutputs(1).AllowInplace({{0, 0}});
+REGISTER_CPU_OPERATOR(MPSCNNAddRelu, MPSCNNAddOp<true>);
+OPERATOR_SCHEMA(MPSCNNAddRelu)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}});
 
 class MPSCNNAveragePoolOp final : public ConvPoolOpBase<CPUContext> {
  public:
@@ -6,6 +6,13 @@
 #import <MetalPerformanceShaders/MetalPerformanceShaders.h>
 #import <UIKit/UIDevice.h>
 
+CAFFE2_DEFINE_int(
+    caffe2_mpscnn_ops_per_command_buffer,
+    0,
+    "If positive, commit the command buffer of a net converted to MPSCNN "
+    "about every this many ops, so that the GPU starts while the rest of the "
+    "net is encoded; 0 encodes the whole net into one command buffer");
+
 namespace caffe2 {
 struct Analysis {
   struct SSA {
@@ -165,6 +172,7 @@ bool tryFuseAdjacentOps(
           {{"MPSCNNConv", "MPSCNNRelu"}, "MPSCNNConvRelu"},
           {{"MPSCNNConv", "MPSCNNSigmoid"}, "MPSCNNConvSigmoid"},
           {{"MPSCNNFC", "MPSCNNRelu"}, "MPSCNNFCRelu"},
+          {{"MPSCNNAdd", "MPSCNNRelu"}, "MPSCNNAddRelu"},
           {{"MPSCNNInstanceNorm", "MPSCNNPRelu"}, "MPSCNNInstanceNormPRelu"},
       }};
   auto it = fusionOpportunities.find({currentOp.type(), nextOp.type()});
@@ -300,6 +308,68 @@ NetDef annotateDefWithReadCounts(const NetDef& net) {
   return annotatedNet;
 }
 
+NetDef annotateDefWithCommandBufferBatches(
+    const NetDef& net,
+    int opsPerCommandBuffer) {
+  NetDef annotatedNet;
+  annotatedNet.CopyFrom(net);
+  if (opsPerCommandBuffer <= 0) {
+    return annotatedNet;
+  }
+  // A command buffer can only be committed after an op whose output is the
+  // only image that is still to be read, by the next op alone: temporary
+  // images don't survive the commit of their command buffer, and the
+  // inputs of an op have to be on the same command buffer. Giving that op a
+  // static output image makes the next op start a new command buffer and
+  // commit the old one.
+  auto analysis = analyzeNet(net);
+  using BlobVersion = std::pair<std::string, size_t>;
+  std::set<BlobVersion> live;
+  auto opsInBatch = 0;
+  for (auto i = 0; i < net.op_size(); ++i) {
+    const auto& op = net.op(i);
+    for (const auto& bv : analysis.ssa[i].outVersions) {
+      live.insert(bv);
+    }
+    for (auto it = live.begin(); it != live.end();) {
+      const auto& usages = analysis.inUsages[it->first][it->second];
+      if (usages.empty() || usages.back() <= static_cast<size_t>(i)) {
+        it = live.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    ++opsInBatch;
+    // the input and output copies handle their command buffers themselves
+    if (i == 0 || i + 2 >= net.op_size() || opsInBatch < opsPerCommandBuffer ||
+        op.output_size() != 1 || live.size() != 1) {
+      continue;
+    }
+    const auto& output = *live.begin();
+    if (output.first != op.output(0) ||
+        analysis.inUsages[output.first][output.second] !=
+            std::vector<size_t>{static_cast<size_t>(i + 1)} ||
+        net.op(i + 1).input(0) != op.output(0)) {
+      continue;
+    }
+    auto* annotatedOp = annotatedNet.mutable_op(i);
+    bool hasTempImageArg = false;
+    for (const auto& arg : annotatedOp->arg()) {
+      hasTempImageArg |= arg.name() == kMPSCNNOutputIsTempImageArg;
+    }
+    if (hasTempImageArg) {
+      continue;
+    }
+    auto* arg = annotatedOp->add_arg();
+    arg->set_name(kMPSCNNOutputIsTempImageArg);
+    arg->set_i(0);
+    VLOG(2) << "Committing the command buffer after op " << i << ", ty: "
+            << op.type();
+    opsInBatch = 0;
+  }
+  return annotatedNet;
+}
+
 bool tryConvertToMPSCNN(
     const NetDef& initNet,
     const NetDef& predictNet,
@@ -331,6 +401,8 @@ bool tryConvertToMPSCNN(
     // Throws if unsupported operators are found.
     *metalPredictNet = rewriteForMetal(predictNet);
     *metalPredictNet = annotateDefWithReadCounts(*metalPredictNet);
+    *metalPredictNet = annotateDefWithCommandBufferBatches(
+        *metalPredictNet, FLAGS_caffe2_mpscnn_ops_per_command_buffer);
     // Throws if unsupported parameters are found.
     ws.CreateNet(*metalPredictNet);
     LOG(INFO) << "MPSCNN is successfully enabled";
@@ -1918,6 +1918,78 @@ void testMPSCNN() {
     }
   }
 
+  {
+    LOG(INFO) << "MPSAddRelu Test";
+    Workspace ws;
+    {
+      auto* t = ws.CreateBlob("X0_cpu")->GetMutable<TensorCPU>();
+      t->Resize(1, 12, 57, 72);
+      CPUContext ctx;
+      math::RandGaussian<float, CPUContext>(
+          t->size(), 0, 1, t->mutable_data<float>(), &ctx);
+    }
+
+    {
+      auto* t = ws.CreateBlob("X1_cpu")->GetMutable<TensorCPU>();
+      t->Resize(1, 12, 57, 72);
+      CPUContext ctx;
+      math::RandGaussian<float, CPUContext>(
+          t->size(), 0, 1, t->mutable_data<float>(), &ctx);
+    }
+
+    NetDef netdef;
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("CopyToMPSCNN");
+      op.add_input("X0_cpu");
+      op.add_output("X0_mtl");
+      op.add_input("X1_cpu");
+      op.add_output("X1_mtl");
+    }
+
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("MPSCNNAddRelu");
+      op.add_input("X0_mtl");
+      op.add_input("X1_mtl");
+      op.add_output("Y_mtl");
+    }
+
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("CopyFromMPSCNN");
+      op.add_input("Y_mtl");
+      op.add_output("Y_cpu");
+    }
+
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("Add");
+      op.add_input("X0_cpu");
+      op.add_input("X1_cpu");
+      op.add_output("Y_ref");
+    }
+
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("Relu");
+      op.add_input("Y_ref");
+      op.add_output("Y_ref");
+    }
+
+    ws.RunNetOnce(netdef);
+    const auto& t2 = ws.GetBlob("Y_cpu")->Get<TensorCPU>();
+    const auto& t1 = ws.GetBlob("Y_ref")->Get<TensorCPU>();
+
+    CAFFE_ENFORCE_EQ(t1.dims(), t2.dims());
+    for (auto i = 0; i < t1.size(); ++i) {
+      // FP16 <-> FP32 round trip, accumulation, etc.
+      const float t1_i = t1.data<float>()[i];
+      const float t2_i = t2.data<float>()[i];
+      CHECK_NEAR(t1_i, t2_i, 0.01);
+    }
+  }
+
   {
     LOG(INFO) << "MPSAdd Test";
     Workspace ws;
@@ -3184,6 +3256,86 @@ void testMPSCNN() {
     CHECK_EQ(o0(3), i0(4));
   }
 
+  {
+    LOG(INFO) << "MPSCNNRewriteForMetal residual AddRelu Fusion Test";
+    NetDef netdef;
+    netdef.add_external_input("X");
+    netdef.add_external_output("Z");
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("Relu");
+      op.add_input("X");
+      op.add_output("A");
+    }
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("Relu");
+      op.add_input("A");
+      op.add_output("B");
+    }
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("Add");
+      op.add_input("B");
+      op.add_input("A");
+      op.add_output("C");
+    }
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("Relu");
+      op.add_input("C");
+      op.add_output("C");
+    }
+    netdef = rewriteForMetal(netdef);
+    CHECK_EQ(netdef.op_size(), 5);
+    auto ty = [&](size_t i) { return netdef.op(i).type(); };
+    CHECK_EQ(ty(3), "MPSCNNAddRelu");
+    CHECK_EQ(netdef.op(3).input(0), "B");
+    CHECK_EQ(netdef.op(3).input(1), "A");
+    CHECK_EQ(netdef.op(3).output(0), "C");
+    // A is read across B, so there is no point where a single image is live
+    netdef = annotateDefWithCommandBufferBatches(netdef, 1);
+    for (const auto& op : netdef.op()) {
+      for (const auto& arg : op.arg()) {
+        CHECK_NE(arg.name(), kMPSCNNOutputIsTempImageArg);
+      }
+    }
+  }
+
+  {
+    LOG(INFO) << "MPSCNNCommandBufferBatches Test";
+    NetDef netdef;
+    netdef.add_external_input("X");
+    netdef.add_external_output("Z");
+    const std::vector<std::string> blobs{"X", "Y1", "Y2", "Y3", "Z"};
+    for (auto i = 0; i + 1 < blobs.size(); ++i) {
+      auto& op = *(netdef.add_op());
+      op.set_type("Relu");
+      op.add_input(blobs[i]);
+      op.add_output(blobs[i + 1]);
+    }
+    netdef = rewriteForMetal(netdef);
+    CHECK_EQ(netdef.op_size(), 6);
+    netdef = annotateDefWithCommandBufferBatches(netdef, 2);
+    auto isStatic = [&](size_t i) {
+      for (const auto& arg : netdef.op(i).arg()) {
+        if (arg.name() == kMPSCNNOutputIsTempImageArg) {
+          CHECK_EQ(arg.i(), 0);
+          return true;
+        }
+      }
+      return false;
+    };
+    // a new command buffer starts after every other op, but not for the last
+    // one, which is copied out anyway
+    CHECK(!isStatic(0));
+    CHECK(isStatic(1));
+    CHECK(!isStatic(2));
+    CHECK(isStatic(3));
+    CHECK(!isStatic(4));
+    CHECK(!isStatic(5));
+  }
+
   {
     LOG(INFO) << "MPSCNNRewriteForMetal PreProcess/Deprocess Test";
     NetDef netdef;
@@ -54,29 +54,142 @@ NNApi::~NNApi() {
 bool NNApi::run(const TensorVector& inputs, TensorVector* outputs) {
   CAFFE_ENFORCE(inputs.size() <= run_net_.external_input_size());
   try {
-    init(inputs, outputs);
+    init(inputs);
   } catch (const std::exception& e) {
     LOG(ERROR) << "Error duing model initialization: " << e.what();
     return false;
   }
 
   try {
-    VLOG(1) << "Start compute";
-    int result_code =
-        libnnapi_.ANeuralNetworksExecution_startCompute(run_, &run_end_);
+    execute(inputs);
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Error during model run: " << e.what();
+    freeExecution();
+    return false;
+  }
+  freeExecution();
+  *outputs = output_tensors_;
+  return true;
+}
+
+bool NNApi::isSupported(const OperatorDef& op, const Workspace& ws) {
+  ArgumentHelper helper(op);
+  if (op.output_size() != 1 || op.input(0) == op.output(0)) {
+    return false;
+  }
+  const auto& type = op.type();
+  if (type == "Relu") {
+    return op.input_size() == 1;
+  }
+  if (type == "Softmax") {
+    return op.input_size() == 1 &&
+        helper.GetSingleArgument<int>("axis", 1) == 1;
+  }
+  if (type != "Conv" && type != "AveragePool" && type != "MaxPool") {
+    return false;
+  }
+  if (StringToStorageOrder(helper.GetSingleArgument<std::string>(
+          "order", "NCHW")) != NHWC ||
+      helper.HasArgument("global_pooling") ||
+      helper.GetRepeatedArgument<int>("kernels").size() > 2) {
+    return false;
+  }
+  ConvPoolArgs args;
+  getConvPoolArgs(helper, args);
+  if (args.stride_x != args.stride_y) {
+    return false;
+  }
+  if (type != "Conv") {
+    return op.input_size() == 1;
+  }
+
+  // Conv reads its weights from the workspace when the model is built
+  if (op.input_size() != 3 || !ws.HasBlob(op.input(1)) ||
+      !ws.HasBlob(op.input(2))) {
+    return false;
+  }
+  for (auto d : helper.GetRepeatedArgument<int>("dilations")) {
+    if (d != 1) {
+      return false;
+    }
+  }
+  if (helper.GetSingleArgument<int>("dilation", 1) != 1) {
+    return false;
+  }
+  const auto* weight = ws.GetBlob(op.input(1));
+  if (!weight->IsType<TensorCPU>() ||
+      weight->Get<TensorCPU>().ndim() != 4) {
+    return false;
+  }
+  // groups are only supported for depthwise convolutions
+  return helper.GetSingleArgument<int>("group", 1) == 1 ||
+      weight->Get<TensorCPU>().dim(0) == 1;
+}
+
+void NNApi::execute(const TensorVector& inputs) {
+  // An execution only runs once, so that the buffers are bound on every run
+  // and follow the tensors if they were reallocated in between.
+  int result_code =
+      libnnapi_.ANeuralNetworksExecution_create(compilation_, &run_);
+  if (result_code != ANEURALNETWORKS_NO_ERROR) {
+    reportError(result_code);
+  }
+
+  // set external input and output
+  for (int i = 0; i < inputs.size(); i++) {
+    const auto& dims = tensor_dims_[run_net_.external_input(i)];
+    CAFFE_ENFORCE_EQ(
+        inputs[i]->dims(),
+        std::vector<TIndex>(dims.begin(), dims.end()),
+        "The model was built for inputs of another shape");
+    result_code = libnnapi_.ANeuralNetworksExecution_setInput(
+        run_, i, NULL, inputs[i]->raw_data(), inputs[i]->nbytes());
     if (result_code != ANEURALNETWORKS_NO_ERROR) {
       reportError(result_code);
     }
-    result_code = libnnapi_.ANeuralNetworksEvent_wait(run_end_);
+
+    VLOG(1) << "Set external input " << i << " at " << inputs[i]->raw_data()
+            << ", size = " << inputs[i]->size();
+  }
+  for (int i = 0; i < output_tensors_.size(); i++) {
+    auto* tensor = output_tensors_[i];
+    const auto& dims = tensor_dims_[run_net_.external_output(i)];
+    tensor->Resize(std::vector<TIndex>(dims.begin(), dims.end()));
+    void* data = tensor_type_ == ANEURALNETWORKS_TENSOR_FLOAT32
+        ? (void*)tensor->template mutable_data<float>()
+        : (void*)tensor->template mutable_data<uint8_t>();
+    result_code = libnnapi_.ANeuralNetworksExecution_setOutput(
+        run_, i, NULL, data, tensor->nbytes());
     if (result_code != ANEURALNETWORKS_NO_ERROR) {
       reportError(result_code);
     }
-    VLOG(1) << "Finish compute";
-  } catch (const std::exception& e) {
-    LOG(ERROR) << "Error during model run: " << e.what();
-    return false;
+
+    VLOG(1) << "Set external output " << i << " at " << tensor->raw_data()
+            << ", size = " << tensor->size();
+  }
+
+  VLOG(1) << "Start compute";
+  result_code =
+      libnnapi_.ANeuralNetworksExecution_startCompute(run_, &run_end_);
+  if (result_code != ANEURALNETWORKS_NO_ERROR) {
+    reportError(result_code);
+  }
+  result_code = libnnapi_.ANeuralNetworksEvent_wait(run_end_);
+  if (result_code != ANEURALNETWORKS_NO_ERROR) {
+    reportError(result_code);
+  }
+  VLOG(1) << "Finish compute";
+}
+
+void NNApi::freeExecution() {
+  if (run_end_) {
+    libnnapi_.ANeuralNetworksEvent_free(run_end_);
+    run_end_ = nullptr;
+  }
+  if (run_) {
+    libnnapi_.ANeuralNetworksExecution_free(run_);
+    run_ = nullptr;
   }
-  return true;
 }
 
 void NNApi::getConvPoolArgs(const ArgumentHelper& helper, ConvPoolArgs& args) {
@@ -532,7 +645,7 @@ uint32_t NNApi::addTensorOperand(
   return operand_map_[blob];
 }
 
-void NNApi::init(const TensorVector& inputs, TensorVector* outputs) {
+void NNApi::init(const TensorVector& inputs) {
   // model
   if (!model_) {
     int result_code = libnnapi_.ANeuralNetworksModel_create(&model_);
@@ -643,71 +756,20 @@ void NNApi::init(const TensorVector& inputs, TensorVector* outputs) {
       LOG(INFO) << "Finish compilation";
     }
 
-    // pre-execution
-    if (!run_) {
-      result_code =
-          libnnapi_.ANeuralNetworksExecution_create(compilation_, &run_);
-      if (result_code != ANEURALNETWORKS_NO_ERROR) {
-        reportError(result_code);
-      }
-      LOG(INFO) << "Created model execution";
-    }
-
-    // set external input and output
-    for (int i = 0; i < inputs.size(); i++) {
-      result_code = libnnapi_.ANeuralNetworksExecution_setInput(
-          run_, i, NULL, inputs[i]->raw_data(), inputs[i]->size());
-      if (result_code != ANEURALNETWORKS_NO_ERROR) {
-        reportError(result_code);
-      }
-
-      VLOG(1) << "Set external input " << i << " at " << inputs[i]->raw_data()
-              << ", size = " << inputs[i]->size();
-    }
     // allocate memory for outputs
     for (int i = 0; i < output_size; i++) {
       const std::string& blob = run_net_.external_output(i);
       if (operand_map_.find(blob) == operand_map_.end()) {
         CAFFE_THROW("Unknown external output, ", blob);
       }
-      uint32_t idx = operand_map_[blob];
       if (tensor_dims_.find(blob) == tensor_dims_.end()) {
         CAFFE_THROW("Operand dimension unknown");
       }
-      std::vector<int> output_dims;
-      for (auto dim : tensor_dims_[blob]) {
-        output_dims.push_back(dim);
-      }
-
-      auto* tensor = ws_.CreateBlob(blob)->GetMutable<TensorCPU>();
-      tensor->Resize(output_dims);
-      outputs->push_back(tensor);
-
-      if (tensor_type_ == ANEURALNETWORKS_TENSOR_FLOAT32) {
-        result_code = libnnapi_.ANeuralNetworksExecution_setOutput(
-            run_,
-            i,
-            NULL,
-            (void*)tensor->template mutable_data<float>(),
-            tensor->size());
-        if (result_code != ANEURALNETWORKS_NO_ERROR) {
-          reportError(result_code);
-        }
-
-      } else {
-        result_code = libnnapi_.ANeuralNetworksExecution_setOutput(
-            run_,
-            i,
-            NULL,
-            (void*)tensor->template mutable_data<uint8_t>(),
-            tensor->size());
-        if (result_code != ANEURALNETWORKS_NO_ERROR) {
-          reportError(result_code);
-        }
-      }
-
-      VLOG(1) << "Set external output " << i << " at " << tensor->raw_data()
-              << ", size = " << tensor->size();
+      // The tensor of an output that the workspace already has, for instance
+      // one read by the CPU operators of a partitioned net, is written in
+      // place.
+      output_tensors_.push_back(
+          ws_.CreateBlob(blob)->GetMutable<TensorCPU>());
     }
   }
 }
@@ -1,3 +1,5 @@
+#pragma once
+
 #include "caffe2/core/operator.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/core/types.h"
@@ -35,8 +37,16 @@ class NNApi {
 
   bool loadNNApiLibrary();
 
+  // Runs the model on inputs, the external inputs of run_net in order, and
+  // returns the tensors of its external outputs. The model is built and
+  // compiled on the first run, for the shapes of those inputs; later runs
+  // bind the buffers of inputs and outputs again, without copying them.
   bool run(const TensorVector& inputs, TensorVector* outputs);
 
+  // Whether the model can run the operator, as far as its arguments and the
+  // weights in ws tell.
+  static bool isSupported(const OperatorDef& op, const Workspace& ws);
+
  private:
   dlnnapi libnnapi_;
   ANeuralNetworksModel* model_{nullptr};
@@ -52,6 +62,8 @@ class NNApi {
   std::unordered_map<std::string, uint32_t> operand_map_;
   // dimensions for the tensors
   std::unordered_map<std::string, std::vector<uint32_t>> tensor_dims_;
+  // the tensors of the external outputs, in the workspace
+  TensorVector output_tensors_;
 
   // mapping of the operator name "Conv" to OperatorType CONV
   enum OperatorType {
@@ -80,7 +92,9 @@ class NNApi {
     int pad_r{0};
   };
 
-  void getConvPoolArgs(const ArgumentHelper& helper, ConvPoolArgs& args);
+  static void getConvPoolArgs(
+      const ArgumentHelper& helper,
+      ConvPoolArgs& args);
 
   uint32_t addScalarOperand(int32_t val);
 
@@ -94,7 +108,12 @@ class NNApi {
       int32_t zero_point = 0);
 
   // lazily initialize model_ in run()
-  void init(const TensorVector& inputs, TensorVector* outputs);
+  void init(const TensorVector& inputs);
+
+  // runs one execution of the compiled model
+  void execute(const TensorVector& inputs);
+
+  void freeExecution();
 
   void addConv(const OperatorDef& op, bool fuse_relu = false);
 
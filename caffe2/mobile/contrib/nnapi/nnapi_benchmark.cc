@@ -21,6 +21,7 @@
 #include "caffe2/utils/math.h"
 #include "caffe2/utils/proto_utils.h"
 #include "nnapi.h"
+#include "nnapi_partition.h"
 
 namespace caffe2 {
 
@@ -336,6 +337,100 @@ static double benchmark_conv_nnapi_int8(
   return double(timer.MilliSeconds()) / run;
 }
 
+// Conv and Relu run on NN API, Sigmoid on the CPU, and MaxPool on NN API
+// again. Returns the latency of each partition, in milliseconds.
+static std::vector<double> benchmark_partitioned_nnapi(
+    Workspace* ws,
+    int N,
+    int C,
+    int H,
+    int W,
+    int K,
+    int kernel,
+    int warmup = 5,
+    int run = 10) {
+  caffe2::Workspace localWs;
+  if (!ws) {
+    ws = &localWs;
+  }
+  {
+    auto* t = ws->CreateBlob("X_cpu")->GetMutable<TensorCPU>();
+    t->Resize(N, H, W, C);
+    CPUContext ctx;
+    math::RandGaussian<float, CPUContext>(
+        t->size(), 0, 30, t->mutable_data<float>(), &ctx);
+  }
+  {
+    auto* t = ws->CreateBlob("W")->GetMutable<TensorCPU>();
+    t->Resize(K, kernel, kernel, C);
+    CPUContext ctx;
+    math::RandGaussian<float, CPUContext>(
+        t->size(), 0, 30, t->mutable_data<float>(), &ctx);
+  }
+  {
+    auto* t = ws->CreateBlob("B")->GetMutable<TensorCPU>();
+    t->Resize(K);
+    CPUContext ctx;
+    math::RandGaussian<float, CPUContext>(
+        t->size(), 0, 30, t->mutable_data<float>(), &ctx);
+  }
+  NetDef netdef;
+  {
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("Conv");
+      op.add_input("X_cpu");
+      op.add_input("W");
+      op.add_input("B");
+      op.add_output("conv");
+      op.add_arg()->CopyFrom(MakeArgument<string>("order", "NHWC"));
+      op.add_arg()->CopyFrom(MakeArgument<int>("kernel", kernel));
+    }
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("Relu");
+      op.add_input("conv");
+      op.add_output("relu");
+    }
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("Sigmoid");
+      op.add_input("relu");
+      op.add_output("sigmoid");
+    }
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("MaxPool");
+      op.add_input("sigmoid");
+      op.add_output("Y_cpu");
+      op.add_arg()->CopyFrom(MakeArgument<string>("order", "NHWC"));
+      op.add_arg()->CopyFrom(MakeArgument<int>("kernel", 2));
+      op.add_arg()->CopyFrom(MakeArgument<int>("stride", 2));
+    }
+    netdef.set_name("partitioned");
+    netdef.add_external_input("X_cpu");
+    netdef.add_external_input("W");
+    netdef.add_external_input("B");
+    netdef.add_external_output("Y_cpu");
+  }
+  NetDef initNet;
+  NNApiPartitionedNet model(initNet, netdef, ws);
+  std::vector<TensorCPU*> inputs, outputs;
+  inputs.push_back(ws->GetBlob("X_cpu")->GetMutable<TensorCPU>());
+  CAFFE_ENFORCE(model.run(inputs, &outputs));
+  for (int i = 0; i < warmup; i++) {
+    model.run(inputs, &outputs);
+  }
+  std::vector<double> latencies(model.partitions().size());
+  for (int i = 0; i < run; i++) {
+    model.run(inputs, &outputs);
+    for (int j = 0; j < latencies.size(); j++) {
+      latencies[j] += model.partitionLatencies()[j] / run;
+    }
+  }
+  return latencies;
+}
+
 } // namespace
 
 } // namespace caffe2
@@ -463,4 +558,17 @@ int main(int argc, char** argv) {
       }
     }
   }
+
+  // partitioned net, with a CPU partition between two NN API partitions
+  for (int space : {14, 26, 52, 104}) {
+    for (int channel : {64, 128, 256}) {
+      const auto latencies = caffe2::benchmark_partitioned_nnapi(
+          &ws, 1, channel, space, space, channel, 3, warmup, mainrun);
+      printf("Partitioned: X: %ix%i  \tC: %i", space, space, channel);
+      for (int i = 0; i < latencies.size(); i++) {
+        printf("\tpartition %i: %.3f ms", i, latencies[i]);
+      }
+      printf("\n");
+    }
+  }
 }
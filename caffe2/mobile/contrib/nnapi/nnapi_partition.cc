@@ -0,0 +1,168 @@
+#include "nnapi_partition.h"
+
+#include <unordered_set>
+
+#include "caffe2/core/timer.h"
+
+namespace caffe2 {
+
+namespace {
+
+// The blobs that the operators of a partition read at run time: the weights
+// of NN API operators are part of the model.
+std::vector<std::string> readBlobs(const OperatorDef& op, bool nnapi) {
+  if (nnapi) {
+    return {op.input(0)};
+  }
+  return {op.input().begin(), op.input().end()};
+}
+
+void addUnique(
+    const std::string& blob,
+    std::unordered_set<std::string>* added,
+    google::protobuf::RepeatedPtrField<std::string>* blobs) {
+  if (added->insert(blob).second) {
+    *blobs->Add() = blob;
+  }
+}
+
+} // namespace
+
+std::vector<NNApiPartition> partitionForNNApi(
+    const NetDef& run_net,
+    const Workspace& ws) {
+  std::vector<NNApiPartition> partitions;
+  // the operands of the last partition, if it runs on NN API
+  std::unordered_set<std::string> operands;
+  for (const auto& op : run_net.op()) {
+    const bool nnapi = NNApi::isSupported(op, ws);
+    // An NN API operand is written once, and not after it is read
+    if (partitions.empty() || partitions.back().nnapi != nnapi ||
+        (nnapi && operands.count(op.output(0)))) {
+      partitions.push_back({NetDef(), nnapi});
+      partitions.back().net.mutable_arg()->CopyFrom(run_net.arg());
+      operands.clear();
+    }
+    if (nnapi) {
+      operands.insert(op.input(0));
+      operands.insert(op.output(0));
+    }
+    partitions.back().net.add_op()->CopyFrom(op);
+  }
+
+  const std::unordered_set<std::string> net_outputs(
+      run_net.external_output().begin(), run_net.external_output().end());
+  for (int i = 0; i < partitions.size(); ++i) {
+    auto& partition = partitions[i];
+    std::unordered_set<std::string> written, inputs, outputs;
+    for (const auto& op : partition.net.op()) {
+      for (const auto& blob : readBlobs(op, partition.nnapi)) {
+        if (!written.count(blob)) {
+          addUnique(blob, &inputs, partition.net.mutable_external_input());
+        }
+      }
+      written.insert(op.output().begin(), op.output().end());
+    }
+    // The blobs read after the partition, in the order they are written
+    std::unordered_set<std::string> read_after;
+    for (int j = i + 1; j < partitions.size(); ++j) {
+      for (const auto& op : partitions[j].net.op()) {
+        for (const auto& blob : readBlobs(op, partitions[j].nnapi)) {
+          read_after.insert(blob);
+        }
+      }
+    }
+    for (const auto& op : partition.net.op()) {
+      for (const auto& blob : op.output()) {
+        if (read_after.count(blob) || net_outputs.count(blob)) {
+          addUnique(blob, &outputs, partition.net.mutable_external_output());
+        }
+      }
+    }
+    // A model without outputs cannot be built, and does nothing anyway
+    if (partition.nnapi && partition.net.external_output_size() == 0) {
+      partition.nnapi = false;
+    }
+  }
+  return partitions;
+}
+
+NNApiPartitionedNet::NNApiPartitionedNet(
+    const NetDef& init_net,
+    const NetDef& run_net,
+    Workspace* ws,
+    const PreferenceCode pref)
+    : run_net_(run_net), ws_(ws) {
+  CAFFE_ENFORCE(ws_.RunNetOnce(init_net));
+  partitions_ = partitionForNNApi(run_net_, ws_);
+
+  // The blobs at the boundaries of the partitions exist before the models
+  // are built, so that they write them in place.
+  for (const auto& blob : run_net_.external_input()) {
+    ws_.CreateBlob(blob);
+  }
+  for (const auto& partition : partitions_) {
+    for (const auto& blob : partition.net.external_output()) {
+      ws_.CreateBlob(blob)->GetMutable<TensorCPU>();
+    }
+  }
+
+  for (int i = 0; i < partitions_.size(); ++i) {
+    auto& partition = partitions_[i];
+    LOG(INFO) << "Partition " << i << " runs "
+              << partition.net.op_size() << " operators on "
+              << (partition.nnapi ? "NN API" : "CPU");
+    if (partition.nnapi) {
+      models_.emplace_back(new NNApi(NetDef(), partition.net, &ws_, pref));
+      nets_.push_back(nullptr);
+    } else {
+      partition.net.set_name(
+          run_net_.name() + "_partition_" + caffe2::to_string(i));
+      models_.emplace_back(nullptr);
+      nets_.push_back(ws_.CreateNet(partition.net, true));
+      CAFFE_ENFORCE(nets_.back(), "Failed to create net for partition ", i);
+    }
+  }
+  latencies_.resize(partitions_.size());
+}
+
+bool NNApiPartitionedNet::run(
+    const TensorVector& inputs,
+    TensorVector* outputs) {
+  CAFFE_ENFORCE(inputs.size() <= run_net_.external_input_size());
+  // The blobs of the inputs share their data
+  for (int i = 0; i < inputs.size(); ++i) {
+    auto* tensor =
+        ws_.GetBlob(run_net_.external_input(i))->GetMutable<TensorCPU>();
+    if (tensor != inputs[i]) {
+      tensor->ResizeLike(*inputs[i]);
+      tensor->ShareData(*inputs[i]);
+    }
+  }
+
+  for (int i = 0; i < partitions_.size(); ++i) {
+    Timer timer;
+    if (models_[i]) {
+      TensorVector partition_inputs, partition_outputs;
+      for (const auto& blob : partitions_[i].net.external_input()) {
+        partition_inputs.push_back(ws_.GetBlob(blob)->GetMutable<TensorCPU>());
+      }
+      if (!models_[i]->run(partition_inputs, &partition_outputs)) {
+        LOG(ERROR) << "Failed to run partition " << i << " on NN API";
+        return false;
+      }
+    } else if (!nets_[i]->Run()) {
+      LOG(ERROR) << "Failed to run partition " << i << " on CPU";
+      return false;
+    }
+    latencies_[i] = timer.MilliSeconds();
+  }
+
+  outputs->clear();
+  for (const auto& blob : run_net_.external_output()) {
+    outputs->push_back(ws_.GetBlob(blob)->GetMutable<TensorCPU>());
+  }
+  return true;
+}
+
+} // namespace caffe2
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/net.h"
+#include "caffe2/core/workspace.h"
+
+#include "nnapi.h"
+
+namespace caffe2 {
+
+// Consecutive operators of a net that all run on NN API, or all on the CPU.
+// The external inputs of net are the blobs it reads from other partitions or
+// from the net, which for NN API are the data inputs only as the weights are
+// read from the workspace, and its external outputs the blobs it writes that
+// other partitions or the net output.
+struct NNApiPartition {
+  NetDef net;
+  bool nnapi;
+};
+
+// Splits run_net in maximal runs of operators that NN API supports, with the
+// weights in ws, and runs of operators that it does not.
+std::vector<NNApiPartition> partitionForNNApi(
+    const NetDef& run_net,
+    const Workspace& ws);
+
+// Runs a net on NN API where it can, and on the CPU engine elsewhere: each
+// NN API partition is built and compiled once, on the first run, and the
+// partitions share the tensors of the blobs at their boundaries, without
+// copies.
+class NNApiPartitionedNet {
+ public:
+  using TensorVector = std::vector<TensorCPU*>;
+
+  NNApiPartitionedNet(
+      const NetDef& init_net,
+      const NetDef& run_net,
+      Workspace* ws = nullptr,
+      const PreferenceCode pref = ANEURALNETWORKS_PREFER_SUSTAINED_SPEED);
+
+  // Same as NNApi::run
+  bool run(const TensorVector& inputs, TensorVector* outputs);
+
+  const std::vector<NNApiPartition>& partitions() const {
+    return partitions_;
+  }
+
+  // The time each partition took in the last run, in milliseconds
+  const std::vector<float>& partitionLatencies() const {
+    return latencies_;
+  }
+
+ private:
+  NetDef run_net_;
+  Workspace ws_;
+  std::vector<NNApiPartition> partitions_;
+  // the model of each NN API partition, or nullptr
+  std::vector<std::unique_ptr<NNApi>> models_;
+  // the net of each CPU partition, or nullptr
+  std::vector<NetBase*> nets_;
+  std::vector<float> latencies_;
+};
+
+} // namespace caffe2
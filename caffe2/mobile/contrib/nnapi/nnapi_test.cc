@@ -8,6 +8,7 @@
 
 #include "NeuralNetworks.h"
 #include "nnapi.h"
+#include "nnapi_partition.h"
 
 namespace caffe2 {
 
@@ -637,6 +638,67 @@ TEST(NNApi, TestSoftmax) {
   // test_softmax(5, 17, 13, 13);
 }
 
+TEST(NNApi, TestPartition) {
+  Workspace ws;
+  {
+    auto* t = ws.CreateBlob("X_cpu")->GetMutable<TensorCPU>();
+    t->Resize(1, 16, 16, 8);
+    CPUContext ctx;
+    math::RandGaussian<float, CPUContext>(
+        t->size(), 0, 30, t->mutable_data<float>(), &ctx);
+  }
+  NetDef netdef;
+  {
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("Relu");
+      op.add_input("X_cpu");
+      op.add_output("relu");
+    }
+    // NN API has no Sigmoid
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("Sigmoid");
+      op.add_input("relu");
+      op.add_output("sigmoid");
+    }
+    {
+      auto& op = *(netdef.add_op());
+      op.set_type("MaxPool");
+      op.add_input("sigmoid");
+      op.add_output("Y");
+      op.add_arg()->CopyFrom(MakeArgument<string>("order", "NHWC"));
+      op.add_arg()->CopyFrom(MakeArgument<int>("kernel", 2));
+      op.add_arg()->CopyFrom(MakeArgument<int>("stride", 2));
+    }
+    netdef.set_name("partitioned");
+    netdef.add_external_input("X_cpu");
+    netdef.add_external_output("Y");
+  }
+  ws.RunNetOnce(netdef);
+  TensorCPU t_cpu(ws.GetBlob("Y")->Get<TensorCPU>());
+
+  const auto partitions = partitionForNNApi(netdef, ws);
+  ASSERT_EQ(partitions.size(), 3);
+  EXPECT_TRUE(partitions[0].nnapi);
+  EXPECT_FALSE(partitions[1].nnapi);
+  EXPECT_TRUE(partitions[2].nnapi);
+  EXPECT_EQ(partitions[1].net.external_input(0), "relu");
+  EXPECT_EQ(partitions[1].net.external_output(0), "sigmoid");
+  EXPECT_EQ(partitions[2].net.external_output(0), "Y");
+
+  NetDef initNet;
+  NNApiPartitionedNet model(initNet, netdef, &ws);
+  std::vector<TensorCPU*> inputs, outputs;
+  inputs.push_back(ws.GetBlob("X_cpu")->GetMutable<TensorCPU>());
+  EXPECT_TRUE(model.run(inputs, &outputs));
+  EXPECT_EQ(model.partitionLatencies().size(), 3);
+  checkError(t_cpu, *outputs[0], 0.01);
+  // Runs again on the buffers bound to the compiled models
+  EXPECT_TRUE(model.run(inputs, &outputs));
+  checkError(t_cpu, *outputs[0], 0.01);
+}
+
 } // namespace
 
 } // namespace caffe2
@@ -2,6 +2,7 @@
 #include "rewrite_net.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/utils/proto_utils.h"
+#include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -56,12 +57,18 @@ static void insertCopyToGPUOp(NetDef& predictNet, const std::string& cpu_blob) {
 }
 
 static void insertCopyFromGPUOp(NetDef& predictNet, const std::string& cpu_blob) {
-  // add argument "is_last" to the last op to signal this is the last operator before the
-  // CopyFromOpenGL op
-  auto* last_op = predictNet.mutable_op(predictNet.op_size() - 1);
-  auto* arg = last_op->add_arg();
-  arg->set_name("is_last");
-  arg->set_i(1);
+  // add argument "is_last" to the op that writes the texture to signal this is the last
+  // operator before the CopyFromOpenGL op
+  for (auto i = predictNet.op_size() - 1; i >= 0; i--) {
+    auto* last_op = predictNet.mutable_op(i);
+    if (std::find(last_op->output().begin(), last_op->output().end(), cpu_blob + "_M") !=
+        last_op->output().end()) {
+      auto* arg = last_op->add_arg();
+      arg->set_name("is_last");
+      arg->set_i(1);
+      break;
+    }
+  }
 
   auto* op = predictNet.add_op();
   op->set_name("CopyFromOpenGL");
@@ -109,10 +116,9 @@ static NetDef insertInputOutputCopyOps(const NetDef& def, std::unordered_set<std
       for (auto j = 0; j < currentOp.input_size(); j++) {
         auto& input = currentOp.input(j);
         auto version = analysis.ssa[i].inVersions[input];
-        if (cpu_blobs[input].count(version) > 0) {
+        if (cpu_blobs[input].count(version) > 0 && gpu_blobs[input].count(version) == 0) {
           insertCopyToGPUOp(mdef, input);
           gpu_blobs[input].insert(version);
-          cpu_blobs[input].erase(version);
         }
         // Only the first input should be OpenGL texture
         // Otherwise, copyToOpenGLOp will be inserted for the weights,
@@ -153,8 +159,10 @@ static NetDef insertInputOutputCopyOps(const NetDef& def, std::unordered_set<std
       for (auto j = 0; j < currentOp.input_size(); j++) {
         auto& input = currentOp.input(j);
         auto version = analysis.ssa[i].inVersions[input];
-        if (gpu_blobs[input].count(version) > 0) {
+        // Read back a texture once, for all the CPU operators that use it
+        if (gpu_blobs[input].count(version) > 0 && cpu_blobs[input].count(version) == 0) {
           insertCopyFromGPUOp(mdef, input);
+          cpu_blobs[input].insert(version);
         }
       }
       auto* op = mdef.add_op();
@@ -186,6 +194,7 @@ static bool tryFuseAdjacentOps(const OperatorDef& currentOp,
       {{"OpenGLInstanceNorm", "OpenGLPRelu"}, "OpenGLInstanceNormPRelu"},
       {{"OpenGLConv", "OpenGLPRelu"}, "OpenGLConvPRelu"},
       {{"OpenGLConv", "OpenGLRelu"}, "OpenGLConvRelu"},
+      {{"OpenGLDepthwiseConv", "OpenGLRelu"}, "OpenGLDepthwiseConvRelu"},
       {{"OpenGLConvTranspose", "OpenGLPRelu"}, "OpenGLConvTransposePRelu"}};
   auto it = fusionOpportunities.find({currentOp.type(), nextOp.type()});
   if (it == fusionOpportunities.end()) {
@@ -238,6 +247,83 @@ static NetDef runOpenGLFusion(const NetDef& def, std::unordered_set<std::string>
   return mdef;
 }
 
+// Reorders the operators so that the OpenGL ones run in as few uninterrupted
+// sequences as possible, since every switch between OpenGL and CPU operators
+// costs a copy of the blobs in between, and a read back is slow. An operator
+// runs after the operators it depends on: the last writer of each blob it
+// reads or writes, and the readers of each blob it writes since the last
+// write. Of the operators that can run, the first one on the same side as the
+// previous operator runs first. The first and the last operators stay in
+// place, as the copy ops for the input and the output expect.
+NetDef reorderNetForOpenGL(const NetDef& def, const std::unordered_set<std::string>& glOps) {
+  const int size = def.op_size();
+  if (size < 3) {
+    return def;
+  }
+  std::vector<std::set<int>> successors(size);
+  std::vector<int> pending(size, 0);
+  std::unordered_map<std::string, int> lastWriter;
+  std::unordered_map<std::string, std::vector<int>> readers;
+  auto addDependency = [&](int from, int to) {
+    if (from != to && successors[from].insert(to).second) {
+      pending[to]++;
+    }
+  };
+  for (int i = 0; i < size; i++) {
+    const auto& op = def.op(i);
+    for (const auto& input : op.input()) {
+      if (lastWriter.count(input)) {
+        addDependency(lastWriter[input], i);
+      }
+    }
+    for (const auto& output : op.output()) {
+      if (lastWriter.count(output)) {
+        addDependency(lastWriter[output], i);
+      }
+      for (int reader : readers[output]) {
+        addDependency(reader, i);
+      }
+    }
+    for (const auto& input : op.input()) {
+      readers[input].push_back(i);
+    }
+    for (const auto& output : op.output()) {
+      lastWriter[output] = i;
+      readers[output].clear();
+    }
+  }
+  for (int i = 1; i < size - 1; i++) {
+    addDependency(0, i);
+    addDependency(i, size - 1);
+  }
+
+  NetDef mdef;
+  mdef.CopyFrom(def);
+  mdef.clear_op();
+  std::set<int> ready({0});
+  bool onOpenGL = glOps.count(def.op(0).type()) > 0;
+  while (!ready.empty()) {
+    auto next = ready.begin();
+    for (auto it = ready.begin(); it != ready.end(); ++it) {
+      if ((glOps.count(def.op(*it).type()) > 0) == onOpenGL) {
+        next = it;
+        break;
+      }
+    }
+    const int i = *next;
+    ready.erase(next);
+    onOpenGL = glOps.count(def.op(i).type()) > 0;
+    mdef.add_op()->CopyFrom(def.op(i));
+    for (int successor : successors[i]) {
+      if (--pending[successor] == 0) {
+        ready.insert(successor);
+      }
+    }
+  }
+  CAFFE_ENFORCE_EQ(mdef.op_size(), size);
+  return mdef;
+}
+
 void dumpDefForOpenGL(const NetDef& d) {
   for (const auto& op : d.op()) {
     LOG(INFO) << op.input(0) << " -> " << op.type() << " -> " << op.output(0);
@@ -291,6 +377,9 @@ NetDef rewritePredictNetForOpenGL(const NetDef& predictNet, bool useTextureInput
     if (replacements.count(openGLOp) > 0) {
       openGLOp = replacements[openGLOp];
     }
+    if (op->type() == "Conv" && ArgumentHelper(*op).GetSingleArgument<int>("group", 1) > 1) {
+      openGLOp = "OpenGLDepthwiseConv";
+    }
 
     if (opKeySet.find(openGLOp) != opKeySet.end()) {
       op->set_type(openGLOp);
@@ -310,6 +399,10 @@ NetDef rewritePredictNetForOpenGL(const NetDef& predictNet, bool useTextureInput
     CAFFE_THROW("OpenGL operator missing");
   }
 
+  if (needCopyOps) {
+    net = reorderNetForOpenGL(net, openGLOps);
+  }
+
   if (runFusion) {
     net = runOpenGLFusion(net, openGLOps);
   }
@@ -3,6 +3,8 @@
 #include "GLPredictor.h"
 #include "caffe2/core/predictor.h"
 
+#include <unordered_set>
+
 namespace caffe2 {
 bool tryConvertToOpenGL(const NetDef& initNet,
                         const NetDef& predictNet,
@@ -16,5 +18,6 @@ NetDef rewritePredictNetForOpenGL(const NetDef& predictNet,
                                   bool useTextureInput = false,
                                   bool useTiling       = false,
                                   bool runFusion       = true);
+NetDef reorderNetForOpenGL(const NetDef& net, const std::unordered_set<std::string>& glOps);
 void dumpDefForOpenGL(const NetDef& net);
 } // namespace caffe2
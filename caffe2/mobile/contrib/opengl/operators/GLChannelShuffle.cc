@@ -0,0 +1,155 @@
+
+#include "../core/GLFilter.h"
+#include "../core/GLImage.h"
+#include "../core/ImageAllocator.h"
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/timer.h"
+#include <iostream>
+#include <vector>
+
+// Output channel g + k * group is input channel g * (channels / group) + k.
+// The 4 channels of an output slice come from up to 4 input slices, which
+// are bound as separate textures.
+class GLChannelShuffle : public GLFilter {
+ public:
+  binding* inputData[4];
+  binding* outputSize;
+  binding* inputChannel;
+
+  GLChannelShuffle()
+      : GLFilter("GLChannelShuffle",
+                 vertex_shader,
+                 fragment_shader,
+                 std::vector<binding*>({BINDING(outputSize),
+                                        BINDING(inputChannel),
+                                        inputData[0] = new binding{"inputData0"},
+                                        inputData[1] = new binding{"inputData1"},
+                                        inputData[2] = new binding{"inputData2"},
+                                        inputData[3] = new binding{"inputData3"}}),
+                 {/* no uniform blocks */},
+                 {/* no attributes */},
+                 {/* no replacements */}) {}
+
+  template <typename T>
+  void shuffle(const GLImageVector<T>& input_images, const GLImageVector<T>& output_images, int group);
+
+  static const char* fragment_shader;
+};
+
+// MARK: GLSL
+
+const char* GLChannelShuffle::fragment_shader = R"GLSL(#version 300 es
+
+precision mediump float;
+precision mediump int;
+
+in highp vec2 v_texCoord;
+
+uniform ivec2 outputSize;
+// the channel in its input slice of each channel of the output slice
+uniform ivec4 inputChannel;
+
+TEXTURE_INPUT(inputData0);
+TEXTURE_INPUT(inputData1);
+TEXTURE_INPUT(inputData2);
+TEXTURE_INPUT(inputData3);
+TEXTURE_OUTPUT(0, outputData);
+
+void main() {
+  ivec2 texelCoord = ivec2(v_texCoord * vec2(outputSize));
+  vec4 value = vec4(TEXTURE_LOAD(inputData0, texelCoord)[inputChannel.x],
+                    TEXTURE_LOAD(inputData1, texelCoord)[inputChannel.y],
+                    TEXTURE_LOAD(inputData2, texelCoord)[inputChannel.z],
+                    TEXTURE_LOAD(inputData3, texelCoord)[inputChannel.w]);
+  outputData = TEXTURE_STORE(value);
+}
+
+)GLSL";
+
+template <typename T>
+void GLChannelShuffle::shuffle(const GLImageVector<T>& input_images,
+                               const GLImageVector<T>& output_images,
+                               int group) {
+  for (int i = 0; i < input_images.size(); i++) {
+    GLImage<T>* input_image = input_images[i];
+    GLImage<T>* output_image = output_images[i];
+    const int channels = input_image->channels;
+    const int channels_per_group = channels / group;
+
+    for (int os = 0; os < output_image->slices; os++) {
+      std::vector<texture_attachment> input_attachments;
+      int input_channel[4];
+      for (int c = 0; c < 4; c++) {
+        // The channels past the end of the output read any valid channel
+        const int output_channel = std::min(4 * os + c, channels - 1);
+        const int channel =
+            (output_channel % group) * channels_per_group + output_channel / group;
+        input_attachments.push_back({input_image->textures[channel / 4], inputData[c]});
+        input_channel[c] = channel % 4;
+      }
+
+      run(input_attachments,
+          {output_image->textures.begin() + os, output_image->textures.begin() + os + 1},
+          [&]() {
+            glUniform2i(outputSize->location, output_image->width, output_image->height);
+            glUniform4i(inputChannel->location,
+                        input_channel[0],
+                        input_channel[1],
+                        input_channel[2],
+                        input_channel[3]);
+          },
+          output_image->width,
+          output_image->height);
+    }
+  }
+}
+
+namespace caffe2 {
+template <typename T>
+class OpenGLChannelShuffleOp final : public Operator<CPUContext>, ImageAllocator<T> {
+ public:
+  OpenGLChannelShuffleOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        order_(StringToStorageOrder(OperatorBase::GetSingleArgument<string>("order", "NCHW"))),
+        group_(OperatorBase::GetSingleArgument<int>("group", 1)) {
+    OPERATOR_NEEDS_FEATURE(this->order_ == StorageOrder::NCHW, "OpenGL only supports NCHW order.");
+    CAFFE_ENFORCE_GT(group_, 0);
+  }
+
+  bool RunOnDevice() override {
+    const GLImageVector<T>& input = Inputs()[0]->template Get<GLImageVector<T>>();
+    const int num_images = input.size();
+    const int channels = input.channels();
+    const int width = input.width();
+    const int height = input.height();
+
+    CAFFE_ENFORCE_EQ(channels % group_, 0);
+    CAFFE_ENFORCE(input.tile_x() == 1 && input.tile_y() == 1,
+                  "OpenGL channel shuffle does not support tiling");
+
+    int is_last = OperatorBase::GetSingleArgument<int>("is_last", 0);
+
+    GLImageVector<T>* output =
+        ImageAllocator<T>::newImage(num_images, width, height, channels, is_last);
+
+    if (!_shuffle) {
+      _shuffle.reset(new GLChannelShuffle());
+    }
+
+    _shuffle->shuffle(input, *output, group_);
+
+    Outputs()[0]->Reset(output);
+
+    return true;
+  }
+
+ private:
+  StorageOrder order_;
+  const int group_;
+  std::unique_ptr<GLChannelShuffle> _shuffle;
+};
+
+REGISTER_CPU_OPERATOR(OpenGLChannelShuffle, OpenGLChannelShuffleOp<float16_t>);
+OPERATOR_SCHEMA(OpenGLChannelShuffle).NumInputs(1).NumOutputs(1).IdenticalTypeAndShape();
+} // namespace caffe2
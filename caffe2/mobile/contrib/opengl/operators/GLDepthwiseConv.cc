@@ -0,0 +1,247 @@
+
+#include "../core/GLFilter.h"
+#include "../core/GLImage.h"
+#include "../core/ImageAllocator.h"
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include <iostream>
+#include <vector>
+
+// Depthwise convolution: each channel of the output is the convolution of the
+// same channel of the input, so that an output slice only reads the input
+// slice at the same index.
+class GLDepthwiseConv : public GLFilter {
+ public:
+  const float* kernel;
+  const float* bias;
+  const int channels;
+  const int kernel_width;
+  const int kernel_height;
+
+  binding* inputData;
+  binding* outputSize;
+  binding* kernel_block;
+  binding* bias_block;
+
+  GLDepthwiseConv(const float* _kernel,
+                  const float* _bias,
+                  const int _channels,
+                  const int _kernel_width,
+                  const int _kernel_height,
+                  const int stride_x,
+                  const int stride_y,
+                  const int pad_l,
+                  const int pad_t,
+                  const bool fuse_relu)
+      : GLFilter("GLDepthwiseConv",
+                 vertex_shader,
+                 fragment_shader,
+                 std::vector<binding*>({BINDING(outputSize), BINDING(inputData)}),
+                 std::vector<binding*>({BINDING(kernel_block), BINDING(bias_block)}),
+                 {/* no attributes */},
+                 {{"KERNEL_WIDTH", caffe2::to_string(_kernel_width)},
+                  {"KERNEL_HEIGHT", caffe2::to_string(_kernel_height)},
+                  {"STRIDE_X", caffe2::to_string(stride_x)},
+                  {"STRIDE_Y", caffe2::to_string(stride_y)},
+                  {"PAD_L", caffe2::to_string(pad_l)},
+                  {"PAD_T", caffe2::to_string(pad_t)},
+                  {"FUSE_RELU", caffe2::to_string(fuse_relu)}}),
+        kernel(_kernel),
+        bias(_bias),
+        channels(_channels),
+        kernel_width(_kernel_width),
+        kernel_height(_kernel_height) {}
+
+  template <typename T>
+  void convolution(const GLImageVector<T>& input_images, const GLImageVector<T>& output_images);
+
+  static const char* fragment_shader;
+};
+
+// MARK: GLSL
+
+const char* GLDepthwiseConv::fragment_shader = R"GLSL(#version 300 es
+#define KERNEL_WIDTH                $(KERNEL_WIDTH)
+#define KERNEL_HEIGHT               $(KERNEL_HEIGHT)
+#define FUSE_RELU                   $(FUSE_RELU)
+
+const ivec2 kernel_size = ivec2(KERNEL_WIDTH, KERNEL_HEIGHT);
+const ivec2 input_stride = ivec2($(STRIDE_X), $(STRIDE_Y));
+const ivec2 input_padding = ivec2($(PAD_L), $(PAD_T));
+
+precision mediump float;
+precision highp int;
+
+in highp vec2 v_texCoord;
+
+uniform ivec2 outputSize;
+
+TEXTURE_INPUT(inputData);
+TEXTURE_OUTPUT(0, outputData);
+
+// the weights of the 4 channels of the slice, two kernel positions per entry
+layout (std140) uniform kernel_block {
+  highp uvec4 kernel_data[(KERNEL_WIDTH * KERNEL_HEIGHT + 1) / 2];
+};
+
+layout (std140) uniform bias_block {
+  highp uvec4 bias;
+};
+
+void main() {
+  ivec2 inputSize = textureSize(inputData, 0);
+  ivec2 texelCoord = ivec2(v_texCoord * vec2(outputSize));
+  ivec2 origin = texelCoord * input_stride - input_padding;
+
+  vec4 sum = unpackHalf4x16(bias.xy);
+  for (int y = 0; y < kernel_size.y; y++) {
+    for (int x = 0; x < kernel_size.x; x++) {
+      ivec2 idx = origin + ivec2(x, y);
+      if (all(greaterThanEqual(idx, ivec2(0))) && all(lessThan(idx, inputSize))) {
+        int k = y * kernel_size.x + x;
+        vec4 weight = (k % 2 == 0) ? unpackHalf4x16(kernel_data[k / 2].xy)
+                                   : unpackHalf4x16(kernel_data[k / 2].zw);
+        sum += weight * TEXTURE_LOAD(inputData, idx);
+      }
+    }
+  }
+#if FUSE_RELU
+  sum = max(sum, vec4(0.0));
+#endif
+  outputData = TEXTURE_STORE(sum);
+}
+
+)GLSL";
+
+template <typename T>
+void GLDepthwiseConv::convolution(const GLImageVector<T>& input_images,
+                                  const GLImageVector<T>& output_images) {
+  const int kernel_size = kernel_width * kernel_height;
+  for (int i = 0; i < input_images.size(); i++) {
+    GLImage<T>* input_image = input_images[i];
+    GLImage<T>* output_image = output_images[i];
+
+    for (int is = 0; is < input_image->slices; is++) {
+      // The binding points are in the order of the uniform blocks in the
+      // constructor
+      attach_uniform_buffer<float16_t>(kernel_block, 0, [&](float16_t* data, size_t size) {
+        CAFFE_ENFORCE_GE(size, 4 * kernel_size * sizeof(float16_t), "Kernel buffer size too small");
+        for (int k = 0; k < kernel_size; k++) {
+          for (int c = 0; c < 4; c++) {
+            const int channel = 4 * is + c;
+            data[4 * k + c] = channel < channels ? kernel[channel * kernel_size + k] : 0;
+          }
+        }
+      });
+      attach_uniform_buffer<float16_t>(bias_block, 1, [&](float16_t* data, size_t size) {
+        for (int c = 0; c < 4; c++) {
+          const int channel = 4 * is + c;
+          data[c] = channel < channels ? bias[channel] : 0;
+        }
+      });
+
+      run(std::vector<texture_attachment>({{input_image->textures[is], inputData}}),
+          {output_image->textures.begin() + is, output_image->textures.begin() + is + 1},
+          [&]() { glUniform2i(outputSize->location, output_image->width, output_image->height); },
+          output_image->width,
+          output_image->height);
+    }
+  }
+}
+
+namespace caffe2 {
+
+template <typename OPBase>
+static void computeOutputHW(OPBase* op, int H, int W, int* OH, int* OW) {
+  Tensor<CPUContext> input, output;
+  input.Resize(1, 1, H, W);
+  op->SetOutputSize(input, &output, 1);
+  CAFFE_ENFORCE_EQ(output.ndim(), 4);
+  *OH = output.dim(2);
+  *OW = output.dim(3);
+}
+
+template <typename T, bool fuseRelu>
+class OpenGLDepthwiseConvOp final : public ConvPoolOpBase<CPUContext>, ImageAllocator<T> {
+ public:
+  USE_OPERATOR_BASE_FUNCTIONS;
+  OpenGLDepthwiseConvOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws) {
+    OPERATOR_NEEDS_FEATURE(this->order_ == StorageOrder::NCHW, "OpenGL only supports NCHW order.");
+    OPERATOR_NEEDS_FEATURE(
+        dilation_h() == 1 && dilation_w() == 1, "OpenGL only supports dialation == 1");
+    // The filter usually comes from the init net, so that a grouped
+    // convolution which is not depthwise is rejected when the net is created
+    if (InputIsType<TensorCPU>(FILTER)) {
+      const auto& filter = Input(FILTER);
+      OPERATOR_NEEDS_FEATURE(filter.ndim() == 4 && filter.dim32(1) == 1 &&
+                                 filter.dim32(0) == group_,
+                             "OpenGL depthwise convolution needs one filter per group "
+                             "with a single input channel");
+    }
+  }
+
+  bool RunOnDeviceWithOrderNCHW() override {
+    const GLImageVector<T>& input = Inputs()[INPUT]->template Get<GLImageVector<T>>();
+    auto& filter = Input(FILTER);
+    auto& bias = Input(BIAS);
+
+    const int num_images = input.size();
+    const int channels = input.channels();
+    const int input_width = input.width();
+    const int input_height = input.height();
+
+    CAFFE_ENFORCE_EQ(channels, group_, "OpenGL only supports depthwise grouped convolutions");
+    CAFFE_ENFORCE_EQ(filter.ndim(), 4);
+    CAFFE_ENFORCE_EQ(filter.dim32(0), channels);
+    CAFFE_ENFORCE_EQ(filter.dim32(1), 1);
+    CAFFE_ENFORCE_EQ(filter.dim32(2), kernel_h());
+    CAFFE_ENFORCE_EQ(filter.dim32(3), kernel_w());
+    CAFFE_ENFORCE_EQ(bias.ndim(), 1);
+    CAFFE_ENFORCE_EQ(bias.dim32(0), channels);
+    CAFFE_ENFORCE(input.tile_x() == 1 && input.tile_y() == 1,
+                  "OpenGL depthwise convolution does not support tiling");
+
+    int output_height;
+    int output_width;
+    computeOutputHW(this, input_height, input_width, &output_height, &output_width);
+
+    int is_last = GetSingleArgument<int>("is_last", 0);
+
+    GLImageVector<T>* output = ImageAllocator<T>::newImage(
+        num_images, output_width, output_height, channels, is_last);
+
+    if (!_conv) {
+      _conv.reset(new GLDepthwiseConv(filter.template data<float>(),
+                                      bias.template data<float>(),
+                                      channels,
+                                      kernel_w(),
+                                      kernel_h(),
+                                      stride_w(),
+                                      stride_h(),
+                                      pad_l(),
+                                      pad_t(),
+                                      fuseRelu));
+    }
+
+    _conv->convolution(input, *output);
+
+    Outputs()[0]->Reset(output);
+
+    return true;
+  }
+
+ private:
+  std::unique_ptr<GLDepthwiseConv> _conv;
+
+  INPUT_TAGS(INPUT, FILTER, BIAS);
+};
+
+REGISTER_CPU_OPERATOR(OpenGLDepthwiseConv, OpenGLDepthwiseConvOp<float16_t, false>);
+OPERATOR_SCHEMA(OpenGLDepthwiseConv).NumInputs(3).NumOutputs(1);
+
+REGISTER_CPU_OPERATOR(OpenGLDepthwiseConvRelu, OpenGLDepthwiseConvOp<float16_t, true>);
+OPERATOR_SCHEMA(OpenGLDepthwiseConvRelu).NumInputs(3).NumOutputs(1);
+} // namespace caffe2
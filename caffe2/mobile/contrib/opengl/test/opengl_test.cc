@@ -1670,6 +1670,175 @@ void testOpenGLResize(int N,
   }
 }
 
+void testOpenGLDepthwiseConv(
+    int N, int C, int H, int W, int kernel, int pad, int stride, float error) {
+  LOG(INFO) << "OpenGL DepthwiseConv Test "
+            << "C: " << C << ", H: " << H << ", W: " << W << ", kernel: " << kernel
+            << ", pad: " << pad << ", stride: " << stride;
+  Workspace ws;
+  {
+    auto* t = ws.CreateBlob("X_cpu")->GetMutable<TensorCPU>();
+    t->Resize(N, C, H, W);
+    CPUContext ctx;
+    math::RandGaussian<float, CPUContext>(t->size(), 0, 1, t->mutable_data<float>(), &ctx);
+  }
+  {
+    auto* t = ws.CreateBlob("W")->GetMutable<TensorCPU>();
+    t->Resize(C, 1, kernel, kernel);
+    CPUContext ctx;
+    math::RandGaussian<float, CPUContext>(t->size(), 0, 1, t->mutable_data<float>(), &ctx);
+  }
+  {
+    auto* t = ws.CreateBlob("b")->GetMutable<TensorCPU>();
+    t->Resize(C);
+    CPUContext ctx;
+    math::RandGaussian<float, CPUContext>(t->size(), 0, 1, t->mutable_data<float>(), &ctx);
+  }
+
+  NetDef netdef;
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("CopyToOpenGL");
+    op.add_input("X_cpu");
+    op.add_output("X_gl");
+  }
+
+  for (const auto& type : {"OpenGLDepthwiseConv", "Conv"}) {
+    auto& op = *(netdef.add_op());
+    op.set_type(type);
+    op.add_input(std::string(type) == "Conv" ? "X_cpu" : "X_gl");
+    op.add_input("W");
+    op.add_input("b");
+    op.add_arg()->CopyFrom(MakeArgument<int>("kernel", kernel));
+    op.add_arg()->CopyFrom(MakeArgument<int>("pad", pad));
+    op.add_arg()->CopyFrom(MakeArgument<int>("stride", stride));
+    op.add_arg()->CopyFrom(MakeArgument<int>("group", C));
+    op.add_arg()->CopyFrom(MakeArgument<string>("order", "NCHW"));
+    if (std::string(type) == "Conv") {
+      op.add_output("Y_ref");
+    } else {
+      op.add_arg()->CopyFrom(MakeArgument<int>("is_last", 1));
+      op.add_output("Y_gl");
+    }
+  }
+
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("CopyFromOpenGL");
+    op.add_input("Y_gl");
+    op.add_output("Y_cpu");
+  }
+
+  ws.RunNetOnce(netdef);
+  checkError(ws.GetBlob("Y_cpu")->Get<TensorCPU>(), ws.GetBlob("Y_ref")->Get<TensorCPU>(), error);
+}
+
+void testOpenGLChannelShuffle(int N, int C, int H, int W, int group) {
+  LOG(INFO) << "OpenGL ChannelShuffle Test "
+            << "C: " << C << ", H: " << H << ", W: " << W << ", group: " << group;
+  Workspace ws;
+  {
+    auto* t = ws.CreateBlob("X_cpu")->GetMutable<TensorCPU>();
+    t->Resize(N, C, H, W);
+    CPUContext ctx;
+    math::RandGaussian<float, CPUContext>(t->size(), 0, 1, t->mutable_data<float>(), &ctx);
+  }
+
+  NetDef netdef;
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("CopyToOpenGL");
+    op.add_input("X_cpu");
+    op.add_output("X_gl");
+  }
+
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("OpenGLChannelShuffle");
+    op.add_input("X_gl");
+    op.add_arg()->CopyFrom(MakeArgument<int>("group", group));
+    op.add_arg()->CopyFrom(MakeArgument<int>("is_last", 1));
+    op.add_output("Y_gl");
+  }
+
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("CopyFromOpenGL");
+    op.add_input("Y_gl");
+    op.add_output("Y_cpu");
+  }
+
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("ChannelShuffle");
+    op.add_input("X_cpu");
+    op.add_arg()->CopyFrom(MakeArgument<int>("group", group));
+    op.add_arg()->CopyFrom(MakeArgument<string>("order", "NCHW"));
+    op.add_output("Y_ref");
+  }
+
+  ws.RunNetOnce(netdef);
+  // A shuffle only moves the values, which are rounded to half precision
+  checkError(ws.GetBlob("Y_cpu")->Get<TensorCPU>(), ws.GetBlob("Y_ref")->Get<TensorCPU>(), 0.01);
+}
+
+void testOpenGLReorder() {
+  LOG(INFO) << "OpenGL Reorder Test";
+  NetDef netdef;
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("Relu");
+    op.add_input("X");
+    op.add_output("a");
+  }
+  // Softsign only runs on the CPU
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("Softsign");
+    op.add_input("a");
+    op.add_output("b");
+  }
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("Relu");
+    op.add_input("a");
+    op.add_output("c");
+  }
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("Softsign");
+    op.add_input("b");
+    op.add_output("d");
+  }
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("Add");
+    op.add_input("c");
+    op.add_input("d");
+    op.add_output("Y");
+  }
+  netdef.add_external_input("X");
+  netdef.add_external_output("Y");
+
+  // Both Relus run before a single read back of a for the two Softsigns
+  const NetDef glNet = rewritePredictNetForOpenGL(netdef);
+  std::vector<std::string> types;
+  for (const auto& op : glNet.op()) {
+    types.push_back(op.type());
+  }
+  CAFFE_ENFORCE_EQ(types,
+                   (std::vector<std::string>{"CopyToOpenGL",
+                                             "OpenGLRelu",
+                                             "OpenGLRelu",
+                                             "CopyFromOpenGL",
+                                             "Softsign",
+                                             "Softsign",
+                                             "CopyToOpenGL",
+                                             "OpenGLAdd",
+                                             "CopyFromOpenGL"}));
+  CAFFE_ENFORCE_EQ(glNet.op(3).output(0), "a");
+}
+
 void testOpenGLPreprocess(int N, int C, int H, int W, float error) {
   LOG(INFO) << "OpenGL Preprocess Test";
   Workspace ws;
@@ -2830,6 +2999,19 @@ void testOpenGL() {
     testOpenGLConv(1, 16, 56, 56, 6, 4, 4, 0, 2, ConvTranspose, 0.5, true, 2, 2);
     testOpenGLConv(1, 6, 112, 112, 3, 4, 4, 0, 2, ConvTranspose, 0.5, true, 2, 1);
 
+    LOG(INFO) << "Test OpenGL DepthwiseConv";
+    testOpenGLDepthwiseConv(1, 8, 16, 16, 3, 1, 1, 0.1);
+    testOpenGLDepthwiseConv(1, 6, 17, 17, 3, 0, 2, 0.1);
+    testOpenGLDepthwiseConv(2, 32, 14, 14, 5, 2, 1, 0.1);
+
+    LOG(INFO) << "Test OpenGL ChannelShuffle";
+    testOpenGLChannelShuffle(1, 8, 16, 16, 2);
+    testOpenGLChannelShuffle(1, 12, 7, 9, 3);
+    testOpenGLChannelShuffle(2, 24, 14, 14, 4);
+
+    LOG(INFO) << "Test OpenGL Reorder";
+    testOpenGLReorder();
+
     LOG(INFO) << "Test OpenGL PadImage";
     testOpenGLPadImage(1, 3, 11, 11, 0, 1, 0, 1, 0.001);
     testOpenGLPadImage(1, 3, 50, 80, 0, 1, 0, 1, 0.001);
@@ -1,5 +1,6 @@
 #include "ulp.h"
 #include "caffe2/operators/conv_pool_op_base.h"
+#include "ulp_avx2.h"
 #include "ulp_neon.h"
 
 namespace caffe2 {
@@ -154,6 +155,23 @@ void signQuantize(const TensorCPU& X, TensorCPU* XQ) {
   }
 }
 
+void signUnquantize(const TensorCPU& XQ, size_t C, TensorCPU* X) {
+  CAFFE_ENFORCE_GT(XQ.ndim(), 1);
+  const auto N = XQ.size_to_dim(XQ.ndim() - 1);
+  const auto QC = XQ.size() / N;
+  CAFFE_ENFORCE_EQ(QC, divRoundUp(C, 8));
+  auto Xs = XQ.dims();
+  Xs[XQ.ndim() - 1] = C;
+  X->Resize(Xs);
+  const uint8_t* XQdata = XQ.data<uint8_t>();
+  float* Xdata = X->mutable_data<float>();
+  for (auto n = 0; n < N; ++n) {
+    for (auto c = 0; c < C; ++c) {
+      Xdata[c + C * n] = (XQdata[c / 8 + QC * n] >> (c % 8)) & 1 ? 1.0 : -1.0;
+    }
+  }
+}
+
 void filterNormalization11(const TensorCPU& WQ, TensorCPU* WQN) {
   const auto F = WQ.dim32(0);
   // In our NEON kernel we read up to TileSize, so align allocation to TileSize elements.
@@ -251,6 +269,49 @@ void qim2col(const ConvArgs& args, const TensorCPU& XQ, const TensorCPU& WQ, Ten
   }
 }
 
+void qgemm_nt(size_t M, size_t N, size_t QK, const uint8_t* A, const uint8_t* B, float* C) {
+#ifdef __AVX2__
+  qgemm_nt_avx2(M, N, QK, A, B, C);
+#else
+  for (size_t m = 0; m < M; ++m) {
+    for (size_t n = 0; n < N; ++n) {
+      int32_t acc = 0;
+      for (size_t qk = 0; qk < QK; ++qk) {
+        acc += __builtin_popcount(A[m * QK + qk] ^ B[n * QK + qk]);
+      }
+      C[m * N + n] = 8 * QK - 2 * acc;
+    }
+  }
+#endif
+}
+
+void qconvGEMM(QConvState* state,
+               const ConvArgs& args,
+               const TensorCPU& XQ,
+               const TensorCPU& WQ,
+               TensorCPU* YQ) {
+  const size_t KH = WQ.dim32(1);
+  const size_t KW = WQ.dim32(2);
+  const size_t F = WQ.dim32(0);
+  YQ->Resize(XQ.dim32(0),
+             (XQ.dim32(1) - KH + args.pad_t + args.pad_b) / args.stride_h + 1,
+             (XQ.dim32(2) - KW + args.pad_l + args.pad_r) / args.stride_w + 1,
+             F);
+  const bool is_1x1 = KH == 1 && KW == 1 && args.pad_l == 0 && args.pad_r == 0 && args.pad_b == 0 &&
+                      args.pad_t == 0 && args.stride_h == 1 && args.stride_w == 1;
+  const TensorCPU* XQcol = &XQ;
+  if (!is_1x1) {
+    qim2col(args, XQ, WQ, state->scratchColBuffer.get());
+    XQcol = state->scratchColBuffer.get();
+  }
+  qgemm_nt(YQ->size() / F,
+           F,
+           WQ.size() / F,
+           XQcol->data<uint8_t>(),
+           WQ.data<uint8_t>(),
+           YQ->mutable_data<float>());
+}
+
 std::unique_ptr<QConvState> create2b1bConvState(Workspace* ws,
                                                 const TensorCPU& W,
                                                 const TensorCPU* b) {
@@ -268,6 +329,7 @@ std::unique_ptr<QConvState> create2b1bConvState(Workspace* ws,
   state->scratchColBuffer = caffe2::make_unique<TensorCPU>();
 
   signQuantize(W, state->WQ.get());
+  state->WBits = W.size() / W.dim(0);
   filterNormalization11(*(state->WQ), state->WQN.get());
   filterNormalizationL1(W, state->WQL1Norm.get());
   // TODO: incorporate center distance normalization.
@@ -299,7 +361,11 @@ void run2b1bConvGeneric(QConvState* state, const ConvArgs& args, const TensorCPU
 #endif
   uniformQuantize2b1b(X, state->XQs, 0.5, 1.0);
   for (auto i = 0; i < k2b1bXBits; ++i) {
+#ifdef __AVX2__
+    qconvGEMM(state, args, *(state->XQs[i]), *(state->WQ), state->YQs[i].get());
+#else
     qconv(args, *(state->XQs[i]), *(state->WQ), nullptr, state->YQs[i].get());
+#endif
   }
   Y->ResizeLike(*(state->YQs[0]));
   const auto F = state->WQ->dim(0);
@@ -316,6 +382,72 @@ void run2b1bConvGeneric(QConvState* state, const ConvArgs& args, const TensorCPU
                      state->bias ? state->bias->data<float>() : nullptr);
 }
 
+// The bits that pad the filters to whole bytes are 0 in the activations too,
+// so they count as +1 products in the result of qgemm_nt or qconv: removes
+// them, and adds the bias.
+static void run1b1bUnification(QConvState* state, TensorCPU* Y) {
+  const auto F = state->WQ->dim(0);
+  const auto N = Y->size() / F;
+  const float padding = 8 * (state->WQ->size() / F) - state->WBits;
+  const float* bias = state->bias ? state->bias->data<float>() : nullptr;
+  float* Ydata = Y->mutable_data<float>();
+  for (auto n = 0; n < N; ++n) {
+    for (auto f = 0; f < F; ++f) {
+      Ydata[f + F * n] += (bias ? bias[f] : 0) - padding;
+    }
+  }
+}
+
+void run1b1bConvGeneric(QConvState* state, const ConvArgs& args, const TensorCPU& XQ, TensorCPU* Y) {
+  CAFFE_ENFORCE_EQ(XQ.ndim(), 4);
+#ifdef __AVX2__
+  qconvGEMM(state, args, XQ, *(state->WQ), Y);
+#else
+  qconv(args, XQ, *(state->WQ), nullptr, Y);
+#endif
+  run1b1bUnification(state, Y);
+}
+
+void run2b1bFCGeneric(QConvState* state, const TensorCPU& X, TensorCPU* Y) {
+  CAFFE_ENFORCE_EQ(X.ndim(), 2);
+  uniformQuantize2b1b(X, state->XQs, 0.5, 1.0);
+  const auto M = X.dim(0);
+  const auto F = state->WQ->dim(0);
+  const auto QK = state->WQ->size() / F;
+  CAFFE_ENFORCE_EQ(state->XQs[0]->dim(1), QK);
+  for (auto i = 0; i < k2b1bXBits; ++i) {
+    state->YQs[i]->Resize(M, F);
+    qgemm_nt(M,
+             F,
+             QK,
+             state->XQs[i]->data<uint8_t>(),
+             state->WQ->data<uint8_t>(),
+             state->YQs[i]->mutable_data<float>());
+  }
+  Y->Resize(M, F);
+  run2b1bUnification(state,
+                     M,
+                     F,
+                     state->WQN->data<float>(),
+                     state->YQs[0]->data<float>(),
+                     state->YQs[1]->data<float>(),
+                     F,
+                     Y->mutable_data<float>(),
+                     F,
+                     state->bias ? state->bias->data<float>() : nullptr);
+}
+
+void run1b1bFCGeneric(QConvState* state, const TensorCPU& XQ, TensorCPU* Y) {
+  CAFFE_ENFORCE_EQ(XQ.ndim(), 2);
+  const auto M = XQ.dim(0);
+  const auto F = state->WQ->dim(0);
+  const auto QK = state->WQ->size() / F;
+  CAFFE_ENFORCE_EQ(XQ.dim(1), QK);
+  Y->Resize(M, F);
+  qgemm_nt(M, F, QK, XQ.data<uint8_t>(), state->WQ->data<uint8_t>(), Y->mutable_data<float>());
+  run1b1bUnification(state, Y);
+}
+
 void run2b1bUnification(QConvState* state,
                         size_t N,
                         size_t C,
@@ -343,10 +475,19 @@ void run2b1bUnification(QConvState* state,
   }
 }
 
+// Activations packed by signQuantize stay packed between consecutive binary
+// layers: a layer with pack_output writes the sign of its output, which the
+// next layer reads without quantizing it again.
+static void packOutput(QConvState* state, TensorCPU* Y) {
+  signQuantize(*(state->scratch), Y);
+}
+
 class QConvOp final : public ConvPoolOpBase<CPUContext> {
  public:
   QConvOp(const OperatorDef& operator_def, Workspace* ws)
-      : ConvPoolOpBase<CPUContext>(operator_def, ws), ws_(ws) {
+      : ConvPoolOpBase<CPUContext>(operator_def, ws),
+        ws_(ws),
+        pack_output_(OperatorBase::GetSingleArgument<bool>("pack_output", false)) {
     OPERATOR_NEEDS_FEATURE(this->order_ == StorageOrder::NHWC, "QConvOp only supports NHWC order");
     OPERATOR_NEEDS_FEATURE(this->dilation_h() == 1, "");
     OPERATOR_NEEDS_FEATURE(this->dilation_w() == 1, "");
@@ -370,15 +511,108 @@ class QConvOp final : public ConvPoolOpBase<CPUContext> {
     args.pad_r = this->pad_r();
     args.stride_h = this->stride_h();
     args.stride_w = this->stride_w();
-    run2b1bConvGeneric(state_.get(), args, X, Y);
+    auto* Yf = pack_output_ ? state_->scratch.get() : Y;
+    if (X.IsType<uint8_t>()) {
+      run1b1bConvGeneric(state_.get(), args, X, Yf);
+    } else {
+      run2b1bConvGeneric(state_.get(), args, X, Yf);
+    }
+    if (pack_output_) {
+      packOutput(state_.get(), Y);
+    }
     return true;
   }
 
  private:
   std::unique_ptr<QConvState> state_;
   Workspace* ws_;
+  bool pack_output_;
 };
 
 REGISTER_CPU_OPERATOR(QConv, QConvOp);
 
+// The FC of the binary weights W, with the 2b1b quantized activations of a
+// float X, or with the packed activations of a uint8 X. X is 2D, or
+// flattened to 2D at axis.
+class QFCOp final : public Operator<CPUContext> {
+ public:
+  QFCOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        ws_(ws),
+        axis_(OperatorBase::GetSingleArgument<int32_t>("axis", 1)),
+        pack_output_(OperatorBase::GetSingleArgument<bool>("pack_output", false)) {}
+
+  bool RunOnDevice() override {
+    auto& X = Input(0);
+    auto& W = Input(1);
+    const auto* bias = InputSize() == 3 ? &Input(2) : nullptr;
+    auto* Y = Output(0);
+
+    CAFFE_ENFORCE_EQ(W.ndim(), 2);
+    if (!state_) {
+      state_ = create2b1bConvState(ws_, W, bias);
+    }
+    const auto canonical_axis = X.canonical_axis_index(axis_);
+    X2D_.Resize(X.size_to_dim(canonical_axis), X.size_from_dim(canonical_axis));
+    X2D_.ShareData(X);
+
+    auto* Yf = pack_output_ ? state_->scratch.get() : Y;
+    if (X.IsType<uint8_t>()) {
+      run1b1bFCGeneric(state_.get(), X2D_, Yf);
+    } else {
+      CAFFE_ENFORCE_EQ(X2D_.dim32(1), W.dim32(1));
+      run2b1bFCGeneric(state_.get(), X2D_, Yf);
+    }
+    if (pack_output_) {
+      packOutput(state_.get(), Y);
+    }
+    return true;
+  }
+
+ private:
+  std::unique_ptr<QConvState> state_;
+  Workspace* ws_;
+  int32_t axis_;
+  bool pack_output_;
+  TensorCPU X2D_;
+};
+
+REGISTER_CPU_OPERATOR(QFC, QFCOp);
+
+// Packs the signs of the last dimension of X, 8 channels per byte, for the
+// binary layers.
+class QPackOp final : public Operator<CPUContext> {
+ public:
+  QPackOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    signQuantize(Input(0), Output(0));
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(QPack, QPackOp);
+
+// The inverse of QPack: the channels of the output are -1 or 1. The number of
+// channels defaults to 8 per byte of the input.
+class QUnpackOp final : public Operator<CPUContext> {
+ public:
+  QUnpackOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        channels_(OperatorBase::GetSingleArgument<int>("channels", 0)) {}
+
+  bool RunOnDevice() override {
+    const auto& XQ = Input(0);
+    const auto QC = XQ.dim(XQ.ndim() - 1);
+    signUnquantize(XQ, channels_ > 0 ? channels_ : 8 * QC, Output(0));
+    return true;
+  }
+
+ private:
+  int channels_;
+};
+
+REGISTER_CPU_OPERATOR(QUnpack, QUnpackOp);
+
 } // namespace caffe2
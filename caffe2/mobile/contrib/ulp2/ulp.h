@@ -32,6 +32,10 @@ struct QConvState {
 
   std::unique_ptr<TensorCPU> bias;
 
+  // The number of weights of a filter, without the bits that pad WQ to whole
+  // bytes.
+  size_t WBits{0};
+
   ParallelFor parallelFor{nullptr};
 };
 
@@ -55,6 +59,26 @@ void qconv(
     const ConvArgs& args, const TensorCPU& X, const TensorCPU& W, const TensorCPU* b, TensorCPU* Y);
 void qim2col(const ConvArgs& args, const TensorCPU& XQ, const TensorCPU& WQ, TensorCPU* XQcol);
 
+// C[m * N + n] = 8 * QK - 2 * popcount(A[m] ^ B[n]) for the rows of A [M, QK]
+// and B [N, QK], i.e. the dot product of the +-1 vectors whose signs they pack.
+void qgemm_nt(size_t M, size_t N, size_t QK, const uint8_t* A, const uint8_t* B, float* C);
+// Same as qconv without bias, as a qgemm_nt of the im2col of XQ and WQ.
+void qconvGEMM(QConvState* state,
+               const ConvArgs& args,
+               const TensorCPU& XQ,
+               const TensorCPU& WQ,
+               TensorCPU* YQ);
+
+// The binary convolution and FC of activations packed by signQuantize, such
+// as the outputs of the ops with pack_output, and the filters of state. Out
+// of the image, the activations are -1.
+void run1b1bConvGeneric(QConvState* state, const ConvArgs& args, const TensorCPU& XQ, TensorCPU* Y);
+void run2b1bFCGeneric(QConvState* state, const TensorCPU& X, TensorCPU* Y);
+void run1b1bFCGeneric(QConvState* state, const TensorCPU& XQ, TensorCPU* Y);
+
+// The inverse of signQuantize: the C channels of X are -1 or 1.
+void signUnquantize(const TensorCPU& XQ, size_t C, TensorCPU* X);
+
 void run2b1bUnification(QConvState* state,
                         size_t N,
                         size_t C,
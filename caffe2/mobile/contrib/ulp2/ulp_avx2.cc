@@ -0,0 +1,82 @@
+#include "ulp_avx2.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace caffe2 {
+
+#ifdef __AVX2__
+
+namespace {
+
+// The number of bits set in each byte of v.
+inline __m256i popcountBytes(__m256i v) {
+  const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  const __m256i lo = _mm256_and_si256(v, low_mask);
+  const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+  return _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+}
+
+inline uint64_t horizontalSum(__m256i v) {
+  return _mm256_extract_epi64(v, 0) + _mm256_extract_epi64(v, 1) +
+         _mm256_extract_epi64(v, 2) + _mm256_extract_epi64(v, 3);
+}
+
+// The popcounts of a ^ b[j] for kUnrollN rows of B, which share the loads of a.
+template <size_t kUnrollN>
+inline void xorPopcount(const uint8_t* __restrict__ a,
+                        const uint8_t* __restrict__ b,
+                        size_t QK,
+                        uint64_t* counts) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc[kUnrollN];
+  for (size_t j = 0; j < kUnrollN; ++j) {
+    acc[j] = zero;
+  }
+  size_t k = 0;
+  for (; k + 32 <= QK; k += 32) {
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + k));
+    for (size_t j = 0; j < kUnrollN; ++j) {
+      const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j * QK + k));
+      // The byte counts are at most 8, and their sums fit in 64 bits lanes.
+      acc[j] = _mm256_add_epi64(
+          acc[j], _mm256_sad_epu8(popcountBytes(_mm256_xor_si256(va, vb)), zero));
+    }
+  }
+  for (size_t j = 0; j < kUnrollN; ++j) {
+    counts[j] = horizontalSum(acc[j]);
+    for (size_t kk = k; kk < QK; ++kk) {
+      counts[j] += __builtin_popcount(a[kk] ^ b[j * QK + kk]);
+    }
+  }
+}
+
+} // namespace
+
+void qgemm_nt_avx2(size_t M, size_t N, size_t QK, const uint8_t* A, const uint8_t* B, float* C) {
+  constexpr size_t kUnrollN = 4;
+  const float K = 8 * QK;
+  for (size_t m = 0; m < M; ++m) {
+    const uint8_t* a = A + m * QK;
+    float* c = C + m * N;
+    uint64_t counts[kUnrollN];
+    size_t n = 0;
+    for (; n + kUnrollN <= N; n += kUnrollN) {
+      xorPopcount<kUnrollN>(a, B + n * QK, QK, counts);
+      for (size_t j = 0; j < kUnrollN; ++j) {
+        c[n + j] = K - 2 * counts[j];
+      }
+    }
+    for (; n < N; ++n) {
+      xorPopcount<1>(a, B + n * QK, QK, counts);
+      c[n] = K - 2 * counts[0];
+    }
+  }
+}
+
+#endif
+
+} // namespace caffe2
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "ulp.h"
+
+namespace caffe2 {
+
+// qgemm_nt, with the popcounts of 32 bytes at a time computed by nibble
+// lookups in AVX2 registers.
+void qgemm_nt_avx2(size_t M, size_t N, size_t QK, const uint8_t* A, const uint8_t* B, float* C);
+}
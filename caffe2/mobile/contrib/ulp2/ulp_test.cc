@@ -200,6 +200,27 @@ TEST(QConv, GemmTest) {
   gemmTest(64, 64, 256);
 }
 
+TEST(QConv, QGemmTest) {
+  for (auto M : {1, 5, 16}) {
+    for (auto N : {1, 3, 4, 9}) {
+      for (auto K : {8, 64, 256, 264}) {
+        auto X = genTensor11({M, K});
+        auto W = genTensor11({N, K});
+        TensorCPU XQ, WQ, YQ, Y;
+        signQuantize(X, &XQ);
+        signQuantize(W, &WQ);
+        YQ.Resize(M, N);
+        qgemm_nt(M, N, K / 8, XQ.data<uint8_t>(), WQ.data<uint8_t>(), YQ.mutable_data<float>());
+        Y.Resize(M, N);
+        gemmNT(M, N, K, X.data<float>(), W.data<float>(), Y.mutable_data<float>());
+        for (auto i = 0; i < Y.size(); ++i) {
+          EXPECT_NEAR(Y.data<float>()[i], YQ.data<float>()[i], 1e-3);
+        }
+      }
+    }
+  }
+}
+
 TEST(QConv, ConvTest) {
   int S = 9;
   int IC = 16;
@@ -368,6 +389,101 @@ TEST(QConv, 2b1bInputPackingTest) {
   ConvTest2b1b(2, 2, 2, 3, 3, 1, 1, ca());
 }
 
+void ConvTest1b1b(int IC, int KH, int KW, int H, int W, int OC, int N, ConvArgs args) {
+  args.stride_h = std::min(args.stride_h, KH);
+  args.stride_w = std::min(args.stride_w, KW);
+  auto X = genTensor11({N, H, W, IC});
+  auto W_ = genTensor11({OC, KH, KW, IC});
+  auto bias = genTensorUniform11({OC});
+  TensorCPU XQ, Y, Y1b1b;
+  signQuantize(X, &XQ);
+  {
+    Workspace ws;
+    auto state = create2b1bConvState(&ws, W_, &bias);
+    run1b1bConvGeneric(state.get(), args, XQ, &Y1b1b);
+  }
+  { conv(args, X, W_, &bias, &Y); }
+  EXPECT_TRUE(Y.dims() == Y1b1b.dims());
+  for (auto i = 0; i < Y.size(); ++i) {
+    EXPECT_NEAR(Y.data<float>()[i], Y1b1b.data<float>()[i], 1e-3);
+  }
+}
+
+TEST(QConv, 1b1bConvTest) {
+  ConvTest1b1b(64, 3, 3, 10, 10, 32, 1, ca());
+  ConvTest1b1b(59, 2, 2, 5, 5, 7, 2, ca());
+  ConvTest1b1b(16, 1, 1, 6, 7, 9, 1, ca());
+  ConvTest1b1b(24, 3, 3, 11, 9, 5, 1, ca(0, 2));
+}
+
+void setBlob(Workspace* ws, const std::string& name, const TensorCPU& t) {
+  ws->CreateBlob(name)->GetMutable<TensorCPU>()->CopyFrom<CPUContext>(t);
+}
+
+TEST(QFC, 2b1bFCTest) {
+  const int M = 5, K = 72, N = 9;
+  auto X = genTensor0123({M, K});
+  auto W = genTensor11({N, K});
+  auto bias = genTensorUniform11({N});
+  Workspace ws;
+  setBlob(&ws, "X", X);
+  setBlob(&ws, "W", W);
+  setBlob(&ws, "b", bias);
+  ws.RunOperatorOnce(CreateOperatorDef("QFC", "", {"X", "W", "b"}, {"Y"}));
+  const auto& YQ = ws.GetBlob("Y")->Get<TensorCPU>();
+
+  TensorCPU Y;
+  Y.Resize(M, N);
+  gemmNT(M, N, K, X.data<float>(), W.data<float>(), Y.mutable_data<float>());
+  EXPECT_TRUE(Y.dims() == YQ.dims());
+  for (auto i = 0; i < Y.size(); ++i) {
+    EXPECT_NEAR(Y.data<float>()[i] + bias.data<float>()[i % N], YQ.data<float>()[i], 1e-3);
+  }
+}
+
+TEST(QFC, PackedActivationsTest) {
+  // The hidden activations of the two layers stay packed.
+  const int M = 3, K = 40, H = 21, N = 6;
+  auto X = genTensor11({M, K});
+  auto W1 = genTensor11({H, K});
+  auto b1 = genTensorUniform11({H});
+  auto W2 = genTensor11({N, H});
+  auto b2 = genTensorUniform11({N});
+  Workspace ws;
+  setBlob(&ws, "X", X);
+  setBlob(&ws, "W1", W1);
+  setBlob(&ws, "b1", b1);
+  setBlob(&ws, "W2", W2);
+  setBlob(&ws, "b2", b2);
+  ws.RunOperatorOnce(CreateOperatorDef("QPack", "", {"X"}, {"XQ"}));
+  ws.RunOperatorOnce(CreateOperatorDef(
+      "QFC", "", {"XQ", "W1", "b1"}, {"HQ"}, {MakeArgument<bool>("pack_output", true)}));
+  ws.RunOperatorOnce(CreateOperatorDef("QFC", "", {"HQ", "W2", "b2"}, {"Y"}));
+  ws.RunOperatorOnce(CreateOperatorDef(
+      "QUnpack", "", {"HQ"}, {"Hsign"}, {MakeArgument<int>("channels", H)}));
+  EXPECT_TRUE(ws.GetBlob("HQ")->Get<TensorCPU>().IsType<uint8_t>());
+
+  TensorCPU Hf, Y;
+  Hf.Resize(M, H);
+  gemmNT(M, H, K, X.data<float>(), W1.data<float>(), Hf.mutable_data<float>());
+  for (auto i = 0; i < Hf.size(); ++i) {
+    Hf.mutable_data<float>()[i] = Hf.data<float>()[i] + b1.data<float>()[i % H] > 0 ? 1.0 : -1.0;
+  }
+  Y.Resize(M, N);
+  gemmNT(M, N, H, Hf.data<float>(), W2.data<float>(), Y.mutable_data<float>());
+
+  const auto& Hsign = ws.GetBlob("Hsign")->Get<TensorCPU>();
+  EXPECT_TRUE(Hf.dims() == Hsign.dims());
+  for (auto i = 0; i < Hf.size(); ++i) {
+    EXPECT_EQ(Hf.data<float>()[i], Hsign.data<float>()[i]);
+  }
+  const auto& YQ = ws.GetBlob("Y")->Get<TensorCPU>();
+  EXPECT_TRUE(Y.dims() == YQ.dims());
+  for (auto i = 0; i < Y.size(); ++i) {
+    EXPECT_NEAR(Y.data<float>()[i] + b2.data<float>()[i % N], YQ.data<float>()[i], 1e-3);
+  }
+}
+
 TEST(QConv, 2b1bConvTestRandomized) {
   auto rca = []() {
     ConvArgs r;
@@ -8,6 +8,7 @@
 namespace caffe2 {
 
 CAFFE_KNOWN_TYPE(MPICommonWorldWrapper);
+CAFFE_KNOWN_TYPE(MPIRequestWrapper);
 
 static std::mutex gCaffe2MPIMutex;
 
@@ -40,6 +41,17 @@ int MPICommRank(MPI_Comm comm) {
   return comm_rank;
 }
 
+void MPIWait(MPI_Request* request) {
+  int done = 0;
+  while (true) {
+    MPI_CHECK(MPI_Test(request, &done, MPI_STATUS_IGNORE));
+    if (done) {
+      return;
+    }
+    std::this_thread::yield();
+  }
+}
+
 /**
  * Helper function used to setup MPI intercommunicator.
  */
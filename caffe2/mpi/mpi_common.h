@@ -3,6 +3,7 @@
 
 #include <mpi.h>
 #include <mutex>
+#include <vector>
 
 #include "caffe2/core/logging.h"
 
@@ -130,6 +131,60 @@ class MPICommonWorldWrapper {
   int rank_;
 };
 
+/**
+ * @brief Waits for a non-blocking MPI call to complete.
+ *
+ * Unlike MPI_Wait, this polls with MPI_Test and only holds the MPI mutex for
+ * every test, so that other threads can issue MPI calls while a collective
+ * is in flight.
+ */
+void MPIWait(MPI_Request* request);
+
+/**
+ * @brief The requests of non-blocking MPI calls an operator started, which
+ * it outputs as a handle for MPIWait.
+ */
+class MPIRequestWrapper {
+ public:
+  MPIRequestWrapper() {}
+  MPIRequestWrapper(const MPIRequestWrapper&) = delete;
+  MPIRequestWrapper& operator=(const MPIRequestWrapper&) = delete;
+
+  ~MPIRequestWrapper() {
+    int ret;
+    MPI_Finalized(&ret);
+    if (!ret) {
+      try {
+        Wait();
+      } catch (const std::exception& e) {
+        LOG(ERROR) << "Caught exception while waiting for MPI requests: "
+                   << e.what();
+      }
+    }
+  }
+
+  /**
+   * @brief Returns a request slot to pass to a non-blocking MPI call.
+   */
+  MPI_Request* Add() {
+    requests_.push_back(MPI_REQUEST_NULL);
+    return &requests_.back();
+  }
+
+  /**
+   * @brief Waits for all requests added so far and forgets them.
+   */
+  void Wait() {
+    for (auto& request : requests_) {
+      MPIWait(&request);
+    }
+    requests_.clear();
+  }
+
+ private:
+  std::vector<MPI_Request> requests_;
+};
+
 /**
  * A function used to perform peer setup so one does not need to use
  * mpirun / mpiexec to run the binary. Note that if you use mpirun or mpiexec
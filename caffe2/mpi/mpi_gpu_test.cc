@@ -267,6 +267,73 @@ TEST(MPITest, TestMPIAllreduce) {
   }
 }
 
+const char kChunkedMPIAllreduceNet[] = R"NET(
+  name: "allreduce"
+  op {
+    output: "comm"
+    type: "MPICreateCommonWorld"
+  }
+  op {
+    output: "X"
+    type: "ConstantFill"
+    arg {
+      name: "shape"
+      ints: 1000
+    }
+    arg {
+      name: "value"
+      f: 0.0
+    }
+  }
+  op {
+    input: "comm"
+    input: "X"
+    output: "X"
+    output: "handle"
+    type: "MPIAllreduceAsync"
+    arg {
+      name: "chunk_bytes"
+      i: 256
+    }
+  }
+  op {
+    input: "handle"
+    input: "X"
+    output: "X"
+    type: "MPIWait"
+  }
+  device_option {
+    device_type: 1
+  }
+)NET";
+
+TEST(MPITest, TestChunkedMPIAllreduce) {
+  NetDef net_def;
+  CHECK(TextFormat::ParseFromString(
+      string(kChunkedMPIAllreduceNet), &net_def));
+  // Let's set the network's constant fill value to be the mpi rank.
+  auto* arg = net_def.mutable_op(1)->mutable_arg(1);
+  CAFFE_ENFORCE_EQ(arg->name(), "value");
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  arg->set_f(rank);
+  int size;
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  Workspace ws;
+  unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  EXPECT_NE(nullptr, net.get());
+  EXPECT_TRUE(net->Run());
+  // Without CUDA-aware MPI, the tensor is reduced in chunks of 64 floats.
+  auto& X_reduced = ws.GetBlob("X")->Get<TensorCUDA>();
+  EXPECT_EQ(X_reduced.size(), 1000);
+  int expected_result = size * (size - 1) / 2;
+  TensorCPU X_reduced_cpu(X_reduced);
+  for (int i = 0; i < X_reduced.size(); ++i) {
+    EXPECT_EQ(X_reduced_cpu.data<float>()[i], expected_result);
+  }
+}
+
 const char kInPlaceMPIAllreduceNet[] = R"NET(
   name: "allreduce"
   op {
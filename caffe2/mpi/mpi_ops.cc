@@ -19,6 +19,15 @@ OPERATOR_SCHEMA(MPIAllreduce)
   .NumInputs(2)
   .NumOutputs(1)
   .AllowInplace({{1, 0}});
+OPERATOR_SCHEMA(MPIAllreduceAsync)
+  .NumInputs(2)
+  .NumOutputs(2)
+  .AllowInplace({{1, 0}});
+OPERATOR_SCHEMA(MPIWait)
+  .NumInputsOutputs([](int in, int out) {
+    return in >= 1 && out == (in - 1);
+  })
+  .EnforceInplace([](int in, int out) { return (in - 1) == out; });
 OPERATOR_SCHEMA(MPISendTensor);
 OPERATOR_SCHEMA(MPIReceiveTensor);
 
@@ -27,6 +36,10 @@ REGISTER_CPU_OPERATOR(MPIBroadcast, MPIBroadcastOp<CPUContext>);
 REGISTER_CPU_OPERATOR(MPIReduce, MPIReduceOp<float, CPUContext>);
 REGISTER_CPU_OPERATOR(MPIAllgather, MPIAllgatherOp<float, CPUContext>);
 REGISTER_CPU_OPERATOR(MPIAllreduce, MPIAllreduceOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    MPIAllreduceAsync,
+    MPIAllreduceAsyncOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(MPIWait, MPIWaitOp<CPUContext>);
 REGISTER_CPU_OPERATOR(MPISendTensor, MPISendTensorOp<CPUContext>);
 REGISTER_CPU_OPERATOR(MPIReceiveTensor, MPIReceiveTensorOp<CPUContext>);
 
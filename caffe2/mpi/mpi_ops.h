@@ -144,6 +144,62 @@ class MPIAllreduceOp final : public Operator<Context> {
   }
 };
 
+// MPIAllreduceAsyncOp starts MPIAllreduce with MPI_Iallreduce and returns
+// without waiting for it, so that the operators after it run while it
+// communicates. Its second output is the handle to pass to MPIWait.
+template <typename T, class Context>
+class MPIAllreduceAsyncOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(MPIAllreduceAsyncOp);
+
+  bool RunOnDevice() override {
+    MPI_Comm comm = OperatorBase::Input<MPICommonWorldWrapper>(0).comm();
+    auto& input = Input(1);
+    auto* output = Output(0);
+    output->ResizeLike(input);
+    auto* handle = OperatorBase::Output<MPIRequestWrapper>(1);
+    // The previous run may still write to the output.
+    handle->Wait();
+    void* source;
+    if (output->template mutable_data<T>() == input.template data<T>()) {
+      source = MPI_IN_PLACE;
+    } else {
+      source = const_cast<T*>(input.template data<T>());
+    }
+    // MPI reads the buffers as soon as the call returns.
+    context_.FinishDeviceComputation();
+    MPI_CHECK(MPI_Iallreduce(
+        source,
+        output->template mutable_data<T>(),
+        input.size(),
+        MPIDataTypeWrapper<T>::type(),
+        MPI_SUM,
+        comm,
+        handle->Add()));
+    return true;
+  }
+};
+
+// MPIWaitOp waits for the calls of the handle of an asynchronous MPI op. The
+// tensors of the call may be passed through in place, so that the ops that
+// read them depend on this one.
+template <class Context>
+class MPIWaitOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(MPIWaitOp);
+
+  bool RunOnDevice() override {
+    // Waiting only forgets the completed requests, the handle stays usable
+    // by the op that outputs it.
+    const_cast<MPIRequestWrapper&>(
+        OperatorBase::Input<MPIRequestWrapper>(0))
+        .Wait();
+    return true;
+  }
+};
+
 template <class Context>
 class MPISendTensorOp final : public Operator<Context> {
  public:
@@ -1,12 +1,24 @@
 #include "caffe2/mpi/mpi_ops.h"
+
+#include <algorithm>
+
 #include "caffe2/core/context_gpu.h"
+#include "caffe2/core/flags.h"
 #include "caffe2/operators/operator_fallback_gpu.h"
 
+CAFFE2_DEFINE_bool(
+    caffe2_mpi_cuda_aware,
+    false,
+    "If set, pass GPU memory to MPI without checking that MPI supports it, "
+    "e.g. for a CUDA-aware MPI other than OpenMPI. Otherwise GPU tensors "
+    "are staged through host memory unless MPI reports CUDA support.");
 
 namespace caffe2 {
 
 // Here is a bunch of MPI macro definitions that allow us to see if the MPI
-// version supports CUDA aware MPI functions or not.
+// version supports CUDA aware MPI functions or not. Where MPI can tell at
+// runtime, CAFFE2_HAS_CUDA_MPI_QUERY is set and the library that is loaded
+// decides, as it may have been built without CUDA support.
 
 #if OPEN_MPI
 #define CAFFE2_OMPI_VERSION \
@@ -14,9 +26,13 @@ namespace caffe2 {
 #if CAFFE2_OMPI_VERSION >= 20000
 // OpenMPI 2.x now supports compile time check whether CUDA is supported.
 #include "mpi-ext.h" /* Needed for CUDA-aware check */
-#if MPIX_CUDA_AWARE_SUPPORT
+#if defined(MPIX_CUDA_AWARE_SUPPORT) && MPIX_CUDA_AWARE_SUPPORT
 #define CAFFE2_HAS_CUDA_MPI_BASICS 1
 #define CAFFE2_HAS_CUDA_MPI_ALLREDUCE 1
+#define CAFFE2_HAS_CUDA_MPI_QUERY 1
+#else // MPIX_CUDA_AWARE_SUPPORT
+#define CAFFE2_HAS_CUDA_MPI_BASICS 0
+#define CAFFE2_HAS_CUDA_MPI_ALLREDUCE 0
 #endif // MPIX_CUDA_AWARE_SUPPORT
 #else // CAFFE2_OMPI_VERSION >= 2000
 // In the case of OpenMPI 1.x, we don't have compile-time flags to
@@ -48,39 +64,204 @@ namespace caffe2 {
 #undef CAFFE2_HAS_CUDA_MPI_ALLREDUCE
 #define CAFFE2_HAS_CUDA_MPI_BASICS 0
 #define CAFFE2_HAS_CUDA_MPI_ALLREDUCE 0
+#undef CAFFE2_HAS_CUDA_MPI_QUERY
 #endif // CAFFE2_FORCE_FALLBACK_CUDA_MPI
 
+#ifndef CAFFE2_HAS_CUDA_MPI_QUERY
+#define CAFFE2_HAS_CUDA_MPI_QUERY 0
+#endif
+
+namespace {
+
+// Whether MPI can be passed GPU memory, for reductions if `reduction`.
+bool CudaAwareMPI(bool reduction) {
+#ifdef CAFFE2_FORCE_FALLBACK_CUDA_MPI
+  return false;
+#else
+  if (FLAGS_caffe2_mpi_cuda_aware) {
+    return true;
+  }
+#if CAFFE2_HAS_CUDA_MPI_QUERY
+  static const bool supported = MPIX_Query_cuda_support() == 1;
+  return supported;
+#else
+  return reduction ? CAFFE2_HAS_CUDA_MPI_ALLREDUCE : CAFFE2_HAS_CUDA_MPI_BASICS;
+#endif
+#endif
+}
+
+// Runs CudaAwareOp if MPI can be passed GPU memory and FallbackOp otherwise,
+// which is decided when the operator is created.
+template <class CudaAwareOp, class FallbackOp, bool kReduction = false>
+class CudaAwareMPIOp final : public Operator<CUDAContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CUDAContext);
+  CudaAwareMPIOp(const OperatorDef& def, Workspace* ws)
+      : Operator<CUDAContext>(def, ws) {
+    if (CudaAwareMPI(kReduction)) {
+      impl_.reset(new CudaAwareOp(def, ws));
+    } else {
+      VLOG(1) << "MPI does not support GPU memory, staging "
+              << def.type() << " through host memory.";
+      impl_.reset(new FallbackOp(def, ws));
+    }
+  }
+
+  bool RunOnDevice() override {
+    // The implementation runs on a context of its own.
+    context_.FinishDeviceComputation();
+    return impl_->Run();
+  }
+
+ private:
+  std::unique_ptr<OperatorBase> impl_;
+};
+
+// Allreduces GPU tensors through pinned host memory, for MPI that can't be
+// passed GPU memory. Large tensors are split into chunks of `chunk_bytes`
+// that are reduced with MPI_Iallreduce, so that copying every chunk to and
+// from the GPU overlaps with reducing the others, instead of the three steps
+// running one after the other for the whole tensor. Also stands in for
+// MPIAllreduceAsync, whose handle then has nothing left to wait for.
+template <typename T>
+class MPIAllreduceStagedOp final : public Operator<CUDAContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CUDAContext);
+  MPIAllreduceStagedOp(const OperatorDef& def, Workspace* ws)
+      : Operator<CUDAContext>(def, ws),
+        OP_SINGLE_ARG(int64_t, "chunk_bytes", chunk_bytes_, 4 << 20),
+        host_(nullptr, nullptr) {
+    CAFFE_ENFORCE_GT(chunk_bytes_, 0);
+  }
+
+  ~MPIAllreduceStagedOp() {
+    for (auto event : events_) {
+      cudaEventDestroy(event);
+    }
+  }
+
+  bool RunOnDevice() override {
+    MPI_Comm comm = OperatorBase::Input<MPICommonWorldWrapper>(0).comm();
+    auto& input = Input(1);
+    auto* output = Output(0);
+    output->ResizeLike(input);
+    if (OutputSize() > 1) {
+      OperatorBase::Output<MPIRequestWrapper>(1)->Wait();
+    }
+    if (input.size() == 0) {
+      return true;
+    }
+    if (capacity_ < input.nbytes()) {
+      auto ptr_and_deleter = allocator_.New(input.nbytes());
+      host_ = std::unique_ptr<void, MemoryDeleter>(
+          ptr_and_deleter.first, ptr_and_deleter.second);
+      capacity_ = input.nbytes();
+    }
+
+    const size_t size = input.size();
+    const size_t chunk =
+        std::max<size_t>(1, static_cast<size_t>(chunk_bytes_) / sizeof(T));
+    const size_t num_chunks = (size + chunk - 1) / chunk;
+    while (events_.size() < num_chunks) {
+      cudaEvent_t event;
+      CUDA_ENFORCE(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+      events_.push_back(event);
+    }
+    const T* src = input.template data<T>();
+    T* dst = output->template mutable_data<T>();
+    T* host = static_cast<T*>(host_.get());
+
+    for (size_t i = 0; i < num_chunks; ++i) {
+      const size_t begin = i * chunk;
+      const size_t count = std::min(chunk, size - begin);
+      CUDA_ENFORCE(cudaMemcpyAsync(
+          host + begin,
+          src + begin,
+          count * sizeof(T),
+          cudaMemcpyDeviceToHost,
+          context_.cuda_stream()));
+      CUDA_ENFORCE(cudaEventRecord(events_[i], context_.cuda_stream()));
+    }
+    // Every chunk is reduced as soon as it arrives.
+    requests_.assign(num_chunks, MPI_REQUEST_NULL);
+    for (size_t i = 0; i < num_chunks; ++i) {
+      const size_t begin = i * chunk;
+      CUDA_ENFORCE(cudaEventSynchronize(events_[i]));
+      MPI_CHECK(MPI_Iallreduce(
+          MPI_IN_PLACE,
+          host + begin,
+          std::min(chunk, size - begin),
+          MPIDataTypeWrapper<T>::type(),
+          MPI_SUM,
+          comm,
+          &requests_[i]));
+    }
+    // And copied back as soon as it is reduced; Run waits for the copies.
+    for (size_t i = 0; i < num_chunks; ++i) {
+      const size_t begin = i * chunk;
+      MPIWait(&requests_[i]);
+      CUDA_ENFORCE(cudaMemcpyAsync(
+          dst + begin,
+          host + begin,
+          std::min(chunk, size - begin) * sizeof(T),
+          cudaMemcpyHostToDevice,
+          context_.cuda_stream()));
+    }
+    return true;
+  }
+
+ private:
+  int64_t chunk_bytes_;
+  PinnedCPUAllocator allocator_;
+  std::unique_ptr<void, MemoryDeleter> host_;
+  size_t capacity_ = 0;
+  std::vector<cudaEvent_t> events_;
+  std::vector<MPI_Request> requests_;
+};
+
+} // namespace
+
 REGISTER_CUDA_OPERATOR(
     MPICreateCommonWorld,
     MPICreateCommonWorldOp<CUDAContext>);
-#if CAFFE2_HAS_CUDA_MPI_BASICS
-REGISTER_CUDA_OPERATOR(MPIBroadcast, MPIBroadcastOp<CUDAContext>);
-REGISTER_CUDA_OPERATOR(MPIReduce, MPIReduceOp<float, CUDAContext>);
-REGISTER_CUDA_OPERATOR(MPIAllgather, MPIAllgatherOp<float, CUDAContext>);
-REGISTER_CUDA_OPERATOR(MPISendTensor, MPISendTensorOp<CUDAContext>);
-REGISTER_CUDA_OPERATOR(MPIReceiveTensor, MPIReceiveTensorOp<CUDAContext>);
-#else
-REGISTER_CUDA_OPERATOR(MPIBroadcast, GPUFallbackOp<MPIBroadcastOp<CPUContext>>);
+REGISTER_CUDA_OPERATOR(
+    MPIBroadcast,
+    CudaAwareMPIOp<
+        MPIBroadcastOp<CUDAContext>,
+        GPUFallbackOp<MPIBroadcastOp<CPUContext>>>);
 REGISTER_CUDA_OPERATOR(
     MPIReduce,
-    GPUFallbackOp<MPIReduceOp<float, CPUContext>>);
+    CudaAwareMPIOp<
+        MPIReduceOp<float, CUDAContext>,
+        GPUFallbackOp<MPIReduceOp<float, CPUContext>>>);
 REGISTER_CUDA_OPERATOR(
     MPIAllgather,
-    GPUFallbackOp<MPIAllgatherOp<float, CPUContext>>);
+    CudaAwareMPIOp<
+        MPIAllgatherOp<float, CUDAContext>,
+        GPUFallbackOp<MPIAllgatherOp<float, CPUContext>>>);
 REGISTER_CUDA_OPERATOR(
     MPISendTensor,
-    GPUFallbackOp<MPISendTensorOp<CPUContext>>);
+    CudaAwareMPIOp<
+        MPISendTensorOp<CUDAContext>,
+        GPUFallbackOp<MPISendTensorOp<CPUContext>>>);
 REGISTER_CUDA_OPERATOR(
     MPIReceiveTensor,
-    GPUFallbackOp<MPIReceiveTensorOp<CPUContext>, SkipIndices<1, 2>>);
-#endif
+    CudaAwareMPIOp<
+        MPIReceiveTensorOp<CUDAContext>,
+        GPUFallbackOp<MPIReceiveTensorOp<CPUContext>, SkipIndices<1, 2>>>);
 
-#if CAFFE2_HAS_CUDA_MPI_ALLREDUCE
-REGISTER_CUDA_OPERATOR(MPIAllreduce, MPIAllreduceOp<float, CUDAContext>);
-#else
 REGISTER_CUDA_OPERATOR(
     MPIAllreduce,
-    GPUFallbackOp<MPIAllreduceOp<float, CPUContext>>);
-#endif
+    CudaAwareMPIOp<
+        MPIAllreduceOp<float, CUDAContext>,
+        MPIAllreduceStagedOp<float>,
+        true>);
+REGISTER_CUDA_OPERATOR(
+    MPIAllreduceAsync,
+    CudaAwareMPIOp<
+        MPIAllreduceAsyncOp<float, CUDAContext>,
+        MPIAllreduceStagedOp<float>,
+        true>);
+REGISTER_CUDA_OPERATOR(MPIWait, MPIWaitOp<CUDAContext>);
 
 }  // namespace caffe2
@@ -299,6 +299,67 @@ TEST(MPITest, TestInPlaceMPIAllreduce) {
   }
 }
 
+const char kMPIAllreduceAsyncNet[] = R"NET(
+  name: "allreduce_async"
+  op {
+    output: "comm"
+    type: "MPICreateCommonWorld"
+  }
+  op {
+    output: "X"
+    type: "ConstantFill"
+    arg {
+      name: "shape"
+      ints: 10
+    }
+    arg {
+      name: "value"
+      f: 0.0
+    }
+  }
+  op {
+    input: "comm"
+    input: "X"
+    output: "X_reduced"
+    output: "handle"
+    type: "MPIAllreduceAsync"
+  }
+  op {
+    input: "handle"
+    input: "X_reduced"
+    output: "X_reduced"
+    type: "MPIWait"
+  }
+)NET";
+
+TEST(MPITest, TestMPIAllreduceAsync) {
+  NetDef net_def;
+  CHECK(TextFormat::ParseFromString(
+      string(kMPIAllreduceAsyncNet), &net_def));
+  // Let's set the network's constant fill value to be the mpi rank.
+  auto* arg = net_def.mutable_op(1)->mutable_arg(1);
+  CAFFE_ENFORCE_EQ(arg->name(), "value");
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  arg->set_f(rank);
+  int size;
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  Workspace ws;
+  unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  EXPECT_NE(nullptr, net.get());
+  // Run twice to check that a new run can reuse the handle.
+  for (int run = 0; run < 2; ++run) {
+    EXPECT_TRUE(net->Run());
+    auto& X_reduced = ws.GetBlob("X_reduced")->Get<TensorCPU>();
+    EXPECT_EQ(X_reduced.size(), 10);
+    int expected_result = size * (size - 1) / 2;
+    for (int i = 0; i < X_reduced.size(); ++i) {
+      EXPECT_EQ(X_reduced.data<float>()[i], expected_result);
+    }
+  }
+}
+
 }  // namespace caffe2
 
 
@@ -0,0 +1,118 @@
+#include "cost_observer.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace caffe2 {
+
+namespace {
+
+uint64_t blobBytes(const Blob* blob) {
+  if (blob->IsType<TensorCPU>()) {
+    return blob->Get<TensorCPU>().nbytes();
+  }
+  return 0;
+}
+
+} // namespace
+
+CostOperatorObserver::CostOperatorObserver(
+    OperatorBase* op,
+    CostNetObserver* netObserver)
+    : RNNCapableOperatorObserver(op),
+      netObserver_(netObserver),
+      schema_(
+          op->has_debug_def() ? OpSchemaRegistry::Schema(op->type())
+                              : nullptr) {
+  CAFFE_ENFORCE(netObserver_, "Observers can't operate outside of the net");
+}
+
+void CostOperatorObserver::Start() {
+  timer_.Start();
+}
+
+void CostOperatorObserver::Stop() {
+  float time_ms = timer_.MilliSeconds();
+  const auto& inputs = subject_->Inputs();
+  uint64_t flops = 0;
+  uint64_t bytes_moved = 0;
+  bool estimated = true;
+  if (schema_ && schema_->HasCostInferenceFunction()) {
+    vector<TensorShape> shapes;
+    shapes.reserve(inputs.size());
+    for (const auto* blob : inputs) {
+      shapes.push_back(GetTensorShapeOfBlob(blob));
+    }
+    try {
+      auto cost = schema_->InferCost(subject_->debug_def(), shapes);
+      flops = cost.flops;
+      bytes_moved = cost.bytes_moved;
+      estimated = false;
+    } catch (const std::exception& e) {
+      VLOG(1) << "Cost inference failed for " << subject_->type() << ": "
+              << e.what();
+    }
+  }
+  if (estimated) {
+    for (const auto* blob : inputs) {
+      bytes_moved += blobBytes(blob);
+    }
+    for (const auto* blob : subject_->Outputs()) {
+      bytes_moved += blobBytes(blob);
+    }
+  }
+  netObserver_->record(
+      subject_->has_debug_def() ? subject_->type() : "unknown",
+      time_ms,
+      flops,
+      bytes_moved,
+      estimated);
+}
+
+std::unique_ptr<ObserverBase<OperatorBase>> CostOperatorObserver::rnnCopy(
+    OperatorBase* subject,
+    int rnn_order) const {
+  return std::unique_ptr<ObserverBase<OperatorBase>>(
+      new CostOperatorObserver(subject, netObserver_));
+}
+
+void CostNetObserver::record(
+    const std::string& type,
+    float time_ms,
+    uint64_t flops,
+    uint64_t bytes_moved,
+    bool estimated) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& cost = costs_[type];
+  ++cost.runs;
+  cost.time_ms += time_ms;
+  cost.flops += flops;
+  cost.bytes_moved += bytes_moved;
+  if (estimated) {
+    ++cost.estimated_runs;
+  }
+}
+
+std::map<std::string, OpTypeCost> CostNetObserver::costs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return costs_;
+}
+
+std::string CostNetObserver::debugInfo() {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(3);
+  for (const auto& kv : costs()) {
+    const auto& cost = kv.second;
+    out << kv.first << ": " << cost.runs << " runs, " << cost.time_ms
+        << " ms, " << cost.gflops_per_second() << " GFLOP/s, "
+        << cost.gbytes_per_second() << " GB/s, "
+        << cost.arithmetic_intensity() << " flops/byte";
+    if (cost.estimated_runs > 0) {
+      out << " (" << cost.estimated_runs << " runs without cost inference)";
+    }
+    out << "\n";
+  }
+  return out.str();
+}
+
+} // namespace caffe2
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/observers/operator_attaching_net_observer.h"
+#include "caffe2/operators/rnn/rnn_capable_operator_observer.h"
+
+namespace caffe2 {
+
+// Totals over all the runs of the ops of one type
+struct OpTypeCost {
+  int64_t runs = 0;
+  double time_ms = 0;
+  uint64_t flops = 0;
+  uint64_t bytes_moved = 0;
+  // runs of ops without a cost inference function, for which only the
+  // bytes of their inputs and outputs are counted
+  int64_t estimated_runs = 0;
+
+  double gflops_per_second() const {
+    return time_ms > 0 ? flops / (time_ms * 1e6) : 0;
+  }
+  double gbytes_per_second() const {
+    return time_ms > 0 ? bytes_moved / (time_ms * 1e6) : 0;
+  }
+  // flops per byte; ops below the machine's balance point are memory bound
+  double arithmetic_intensity() const {
+    return bytes_moved > 0 ? static_cast<double>(flops) / bytes_moved : 0;
+  }
+};
+
+class CostNetObserver;
+class CostOperatorObserver final : public RNNCapableOperatorObserver {
+ public:
+  explicit CostOperatorObserver(OperatorBase* op) = delete;
+  CostOperatorObserver(OperatorBase* op, CostNetObserver* netObserver);
+  std::unique_ptr<ObserverBase<OperatorBase>> rnnCopy(
+      OperatorBase* subject,
+      int rnn_order) const override;
+
+ private:
+  void Start() override;
+  void Stop() override;
+
+  CostNetObserver* netObserver_;
+  const OpSchema* schema_;
+  Timer timer_;
+};
+
+// Records time, flops and bytes moved for every op of the net, using the
+// cost inference functions of their schemas on the shapes of the inputs of
+// each run, and aggregates them per op type.
+class CostNetObserver final : public OperatorAttachingNetObserver<
+                                  CostOperatorObserver,
+                                  CostNetObserver> {
+ public:
+  explicit CostNetObserver(NetBase* subject_)
+      : OperatorAttachingNetObserver<CostOperatorObserver, CostNetObserver>(
+            subject_,
+            this) {}
+
+  std::map<std::string, OpTypeCost> costs() const;
+
+  // One line per op type with the achieved GFLOP/s and GB/s
+  std::string debugInfo() override;
+
+  friend class CostOperatorObserver;
+
+ private:
+  void Start() override {}
+  void Stop() override {}
+
+  void record(
+      const std::string& type,
+      float time_ms,
+      uint64_t flops,
+      uint64_t bytes_moved,
+      bool estimated);
+
+  mutable std::mutex mutex_;
+  std::map<std::string, OpTypeCost> costs_;
+};
+
+} // namespace caffe2
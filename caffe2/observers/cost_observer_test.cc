@@ -0,0 +1,70 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "cost_observer.h"
+
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+void fill(Workspace* ws, const std::string& name, std::vector<TIndex> dims) {
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(dims);
+  auto* data = tensor->mutable_data<float>();
+  for (int i = 0; i < tensor->size(); ++i) {
+    data[i] = 1.0f;
+  }
+}
+
+} // namespace
+
+TEST(CostObserverTest, FlopsAndBytesPerOpType) {
+  Workspace ws;
+  fill(&ws, "X", {2, 4});
+  fill(&ws, "W", {3, 4});
+  fill(&ws, "b", {3});
+
+  NetDef net_def;
+  net_def.set_name("cost");
+  {
+    auto& op = *(net_def.add_op());
+    op.set_type("FC");
+    op.add_input("X");
+    op.add_input("W");
+    op.add_input("b");
+    op.add_output("Y");
+  }
+  {
+    // no cost inference function
+    auto& op = *(net_def.add_op());
+    op.set_type("Copy");
+    op.add_input("Y");
+    op.add_output("Z");
+  }
+  unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  auto net_ob = caffe2::make_unique<CostNetObserver>(net.get());
+  auto* ob = net_ob.get();
+  net->AttachObserver(std::move(net_ob));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(net->Run());
+  }
+
+  auto costs = ob->costs();
+  ASSERT_EQ(costs.size(), 2);
+  const auto& fc = costs.at("FC");
+  EXPECT_EQ(fc.runs, 3);
+  EXPECT_EQ(fc.estimated_runs, 0);
+  EXPECT_GT(fc.flops, 0);
+  EXPECT_GT(fc.bytes_moved, 0);
+  const auto& copy = costs.at("Copy");
+  EXPECT_EQ(copy.runs, 3);
+  EXPECT_EQ(copy.estimated_runs, 3);
+  EXPECT_EQ(copy.flops, 0);
+  // inputs and outputs, 2 x 3 floats each
+  EXPECT_EQ(copy.bytes_moved, 3 * 2 * 6 * sizeof(float));
+  LOG(INFO) << ob->debugInfo();
+}
+
+} // namespace caffe2
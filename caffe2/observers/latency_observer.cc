@@ -0,0 +1,45 @@
+#include "latency_observer.h"
+
+namespace caffe2 {
+
+LatencyOperatorObserver::LatencyOperatorObserver(
+    OperatorBase* op,
+    LatencyNetObserver* netObserver)
+    : RNNCapableOperatorObserver(op),
+      netObserver_(netObserver),
+      latency_(
+          "latency/op/" + (op->has_debug_def() ? op->type() : "unknown"),
+          "latency_us") {
+  CAFFE_ENFORCE(netObserver_, "Observers can't operate outside of the net");
+}
+
+void LatencyOperatorObserver::Start() {
+  timer_.Start();
+}
+
+void LatencyOperatorObserver::Stop() {
+  latency_.increment(timer_.MicroSeconds());
+}
+
+std::unique_ptr<ObserverBase<OperatorBase>> LatencyOperatorObserver::rnnCopy(
+    OperatorBase* subject,
+    int rnn_order) const {
+  return std::unique_ptr<ObserverBase<OperatorBase>>(
+      new LatencyOperatorObserver(subject, netObserver_));
+}
+
+LatencyNetObserver::LatencyNetObserver(NetBase* subject_)
+    : OperatorAttachingNetObserver<LatencyOperatorObserver, LatencyNetObserver>(
+          subject_,
+          this),
+      latency_("latency/net/" + subject_->Name(), "latency_us") {}
+
+void LatencyNetObserver::Start() {
+  timer_.Start();
+}
+
+void LatencyNetObserver::Stop() {
+  latency_.increment(timer_.MicroSeconds());
+}
+
+} // namespace caffe2
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/observers/operator_attaching_net_observer.h"
+#include "caffe2/operators/rnn/rnn_capable_operator_observer.h"
+
+namespace caffe2 {
+
+class LatencyNetObserver;
+class LatencyOperatorObserver final : public RNNCapableOperatorObserver {
+ public:
+  explicit LatencyOperatorObserver(OperatorBase* op) = delete;
+  LatencyOperatorObserver(OperatorBase* op, LatencyNetObserver* netObserver);
+  std::unique_ptr<ObserverBase<OperatorBase>> rnnCopy(
+      OperatorBase* subject,
+      int rnn_order) const override;
+
+ private:
+  void Start() override;
+  void Stop() override;
+
+  LatencyNetObserver* netObserver_;
+  HistogramExportedStat latency_;
+  Timer timer_;
+};
+
+// Records the latency of every run of the net, in microseconds, in the
+// StatRegistry histogram latency/net/<net name>/latency_us, and that of its
+// ops in latency/op/<op type>/latency_us, which is shared with the ops of the
+// same type in other nets. The histograms are exported by
+// StatRegistry::publish() with their p50, p90, p99 and p999.
+//
+// Ops that run asynchronously, e.g. on GPU, are timed until they are
+// scheduled, not until they complete.
+class LatencyNetObserver final : public OperatorAttachingNetObserver<
+                                     LatencyOperatorObserver,
+                                     LatencyNetObserver> {
+ public:
+  explicit LatencyNetObserver(NetBase* subject_);
+
+ private:
+  void Start() override;
+  void Stop() override;
+
+  HistogramExportedStat latency_;
+  Timer timer_;
+};
+
+} // namespace caffe2
@@ -0,0 +1,49 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
+#include "latency_observer.h"
+
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+class LatencyTestOp final : public Operator<CPUContext> {
+ public:
+  using Operator<CPUContext>::Operator;
+  bool RunOnDevice() override {
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(LatencyTest, LatencyTestOp);
+OPERATOR_SCHEMA(LatencyTest).NumInputs(0).NumOutputs(0);
+
+} // namespace
+
+TEST(LatencyObserverTest, HistogramsPerNetAndOpType) {
+  Workspace ws;
+  NetDef net_def;
+  net_def.set_name("latency_test_net");
+  net_def.add_op()->set_type("LatencyTest");
+  net_def.add_op()->set_type("LatencyTest");
+  unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  net->AttachObserver(caffe2::make_unique<LatencyNetObserver>(net.get()));
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(net->Run());
+  }
+
+  auto stats = toMap(StatRegistry::get().publish(true));
+  EXPECT_EQ(stats["latency/net/latency_test_net/latency_us/count"], 10);
+  EXPECT_EQ(stats["latency/op/LatencyTest/latency_us/count"], 20);
+  EXPECT_LE(
+      stats["latency/net/latency_test_net/latency_us/p50"],
+      stats["latency/net/latency_test_net/latency_us/p999"]);
+  EXPECT_LE(
+      stats["latency/net/latency_test_net/latency_us/p999"],
+      stats["latency/net/latency_test_net/latency_us/max"]);
+}
+
+} // namespace caffe2
@@ -0,0 +1,337 @@
+#include "memory_observer.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace caffe2 {
+
+namespace {
+
+// the most allocations kept for the peak of a device
+constexpr size_t kPeakAllocations = 10;
+
+// The op whose allocations the thread makes, and the allocations it made in
+// the current run, innermost op last
+thread_local int currentOp = -1;
+thread_local std::vector<std::shared_ptr<MemoryAllocation>> runAllocations;
+
+std::string deviceName(int device_type) {
+  switch (device_type) {
+    case CPU:
+      return "CPU";
+    case CUDA:
+      return "CUDA";
+    default:
+      return "device " + caffe2::to_string(device_type);
+  }
+}
+
+std::string quote(const std::string& s) {
+  std::ostringstream out;
+  out << '"';
+  for (char c : s) {
+    switch (c) {
+      case '"':
+        out << "\\\"";
+        break;
+      case '\\':
+        out << "\\\\";
+        break;
+      case '\n':
+        out << "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+              << static_cast<int>(c) << std::dec;
+        } else {
+          out << c;
+        }
+    }
+  }
+  out << '"';
+  return out.str();
+}
+
+} // namespace
+
+MemoryProfile::MemoryProfile(size_t max_samples)
+    : max_samples_(max_samples), start_(std::chrono::steady_clock::now()) {}
+
+void MemoryProfile::OnAllocation(int device_type, void* ptr, size_t nbytes) {
+  auto allocation = std::make_shared<MemoryAllocation>();
+  allocation->device_type = device_type;
+  allocation->nbytes = nbytes;
+  allocation->op = currentOp;
+  if (currentOp >= 0) {
+    runAllocations.push_back(allocation);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (currentOp >= 0 && static_cast<size_t>(currentOp) < ops_.size()) {
+    auto& op = ops_[currentOp];
+    ++op.allocations;
+    op.allocated_bytes += nbytes;
+  }
+  auto& device = devices_[device_type];
+  device.live_bytes += nbytes;
+  if (device.live_bytes > device.peak.live_bytes) {
+    device.peak.live_bytes = device.live_bytes;
+    device.peak.time_us = nowUs();
+    device.peak_pending = true;
+  }
+  live_[ptr] = std::move(allocation);
+  sample(device_type, device);
+}
+
+void MemoryProfile::OnDeallocation(int device_type, void* ptr) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = live_.find(ptr);
+  if (it == live_.end()) {
+    // allocated before the profile was set
+    return;
+  }
+  auto& device = devices_[device_type];
+  if (device.peak_pending) {
+    // the first deallocation after the peak, so the live allocations are
+    // the ones of the peak
+    snapshotPeak(device_type, &device);
+  }
+  if (currentOp >= 0 && static_cast<size_t>(currentOp) < ops_.size()) {
+    ops_[currentOp].freed_bytes += it->second->nbytes;
+  }
+  device.live_bytes -= it->second->nbytes;
+  live_.erase(it);
+  sample(device_type, device);
+}
+
+MemoryProfile::OpRun MemoryProfile::beginOp(const OperatorBase* op) {
+  OpRun run;
+  run.op = opIndex(op);
+  run.previous_op = currentOp;
+  run.start_us = nowUs();
+  run.first_allocation = runAllocations.size();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    run.allocated_at_start = ops_[run.op].allocated_bytes;
+  }
+  currentOp = run.op;
+  return run;
+}
+
+void MemoryProfile::endOp(OperatorBase* op, const OpRun& run) {
+  currentOp = run.previous_op;
+  // this run's allocations follow the ones of the ops it is nested in
+  auto first = runAllocations.begin() +
+      std::min(run.first_allocation, runAllocations.size());
+  std::vector<std::shared_ptr<MemoryAllocation>> allocations(
+      first, runAllocations.end());
+  runAllocations.erase(first, runAllocations.end());
+
+  double end_us = nowUs();
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& stats = ops_[run.op];
+  ++stats.runs;
+  uint64_t run_bytes = stats.allocated_bytes - run.allocated_at_start;
+  stats.max_run_bytes = std::max(stats.max_run_bytes, run_bytes);
+  if (op_events_.size() < max_samples_) {
+    op_events_.push_back(
+        OpEvent{run.op, run.start_us, end_us - run.start_us, run_bytes});
+  }
+
+  const auto& outputs = op->Outputs();
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    auto info = GetTensorInfoFunction(outputs[i]->meta().id());
+    if (!info) {
+      continue;
+    }
+    bool shares_data = false;
+    size_t capacity = 0;
+    DeviceOption device;
+    info(outputs[i]->GetRaw(), &shares_data, &capacity, &device);
+    for (auto& allocation : allocations) {
+      if (allocation->blob.empty() &&
+          allocation->device_type == device.device_type() &&
+          allocation->nbytes == capacity) {
+        allocation->blob = op->has_debug_def() ? op->debug_def().output(i)
+                                               : caffe2::to_string(i);
+        break;
+      }
+    }
+  }
+}
+
+int MemoryProfile::opIndex(const OperatorBase* op) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = op_index_.find(op);
+  if (it != op_index_.end()) {
+    return it->second;
+  }
+  OpMemory stats;
+  if (op->has_debug_def()) {
+    stats.type = op->debug_def().type();
+    if (op->debug_def().output_size() > 0) {
+      stats.output = op->debug_def().output(0);
+    }
+  } else {
+    stats.type = "unknown";
+  }
+  ops_.push_back(stats);
+  op_index_[op] = ops_.size() - 1;
+  return ops_.size() - 1;
+}
+
+void MemoryProfile::sample(int device_type, const DeviceMemory& device) {
+  if (samples_.size() < max_samples_) {
+    samples_.push_back(
+        Sample{nowUs(), device_type, device.live_bytes});
+  } else {
+    ++dropped_samples_;
+  }
+}
+
+void MemoryProfile::snapshotPeak(int device_type, DeviceMemory* device)
+    const {
+  auto& allocations = device->peak.allocations;
+  allocations.clear();
+  for (const auto& kv : live_) {
+    if (kv.second->device_type == device_type) {
+      allocations.push_back(kv.second);
+    }
+  }
+  auto largest = [](const std::shared_ptr<const MemoryAllocation>& a,
+                    const std::shared_ptr<const MemoryAllocation>& b) {
+    return a->nbytes > b->nbytes;
+  };
+  size_t kept = std::min(allocations.size(), kPeakAllocations);
+  std::partial_sort(
+      allocations.begin(),
+      allocations.begin() + kept,
+      allocations.end(),
+      largest);
+  allocations.resize(kept);
+  device->peak_pending = false;
+}
+
+std::vector<OpMemory> MemoryProfile::ops() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return ops_;
+}
+
+std::map<int, uint64_t> MemoryProfile::liveBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<int, uint64_t> live_bytes;
+  for (const auto& kv : devices_) {
+    live_bytes[kv.first] = kv.second.live_bytes;
+  }
+  return live_bytes;
+}
+
+std::map<int, MemoryPeak> MemoryProfile::peaks() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<int, MemoryPeak> peaks;
+  for (const auto& kv : devices_) {
+    auto device = kv.second;
+    if (device.peak_pending) {
+      // still at the peak
+      snapshotPeak(kv.first, &device);
+    }
+    peaks[kv.first] = device.peak;
+  }
+  return peaks;
+}
+
+std::string MemoryProfile::toJSON() const {
+  auto peaks = this->peaks();
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(3);
+  out << "{\"ops\": [";
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    const auto& op = ops_[i];
+    out << (i ? ", " : "") << "{\"type\": " << quote(op.type)
+        << ", \"output\": " << quote(op.output) << ", \"runs\": " << op.runs
+        << ", \"allocations\": " << op.allocations
+        << ", \"allocated_bytes\": " << op.allocated_bytes
+        << ", \"freed_bytes\": " << op.freed_bytes
+        << ", \"max_run_bytes\": " << op.max_run_bytes << "}";
+  }
+  out << "], \"peaks\": {";
+  bool first = true;
+  for (const auto& kv : peaks) {
+    out << (first ? "" : ", ") << quote(deviceName(kv.first))
+        << ": {\"live_bytes\": " << kv.second.live_bytes
+        << ", \"time_us\": " << kv.second.time_us << ", \"allocations\": [";
+    first = false;
+    const auto& allocations = kv.second.allocations;
+    for (size_t i = 0; i < allocations.size(); ++i) {
+      const auto& allocation = *allocations[i];
+      out << (i ? ", " : "") << "{\"bytes\": " << allocation.nbytes
+          << ", \"blob\": " << quote(allocation.blob) << ", \"op\": "
+          << quote(allocation.op >= 0 ? ops_[allocation.op].type : "")
+          << "}";
+    }
+    out << "]}";
+  }
+  out << "}, \"dropped_samples\": " << dropped_samples_;
+  out << ", \"traceEvents\": [";
+  first = true;
+  for (const auto& event : op_events_) {
+    const auto& op = ops_[event.op];
+    out << (first ? "" : ", ") << "{\"name\": " << quote(op.type)
+        << ", \"cat\": \"op\", \"ph\": \"X\", \"pid\": 0, \"tid\": 0"
+        << ", \"ts\": " << event.start_us << ", \"dur\": " << event.duration_us
+        << ", \"args\": {\"output\": " << quote(op.output)
+        << ", \"allocated_bytes\": " << event.allocated_bytes << "}}";
+    first = false;
+  }
+  for (const auto& sample : samples_) {
+    out << (first ? "" : ", ") << "{\"name\": "
+        << quote(deviceName(sample.device_type) + " memory")
+        << ", \"ph\": \"C\", \"pid\": 0, \"ts\": " << sample.time_us
+        << ", \"args\": {\"live_bytes\": " << sample.live_bytes << "}}";
+    first = false;
+  }
+  out << "]}";
+  return out.str();
+}
+
+MemoryOperatorObserver::MemoryOperatorObserver(
+    OperatorBase* op,
+    MemoryNetObserver* netObserver)
+    : RNNCapableOperatorObserver(op), netObserver_(netObserver) {
+  CAFFE_ENFORCE(netObserver_, "Observers can't operate outside of the net");
+}
+
+void MemoryOperatorObserver::Start() {
+  run_ = netObserver_->profile_->beginOp(subject_);
+}
+
+void MemoryOperatorObserver::Stop() {
+  netObserver_->profile_->endOp(subject_, run_);
+}
+
+std::unique_ptr<ObserverBase<OperatorBase>> MemoryOperatorObserver::rnnCopy(
+    OperatorBase* subject,
+    int rnn_order) const {
+  return std::unique_ptr<ObserverBase<OperatorBase>>(
+      new MemoryOperatorObserver(subject, netObserver_));
+}
+
+MemoryNetObserver::MemoryNetObserver(NetBase* subject_, size_t max_samples)
+    : OperatorAttachingNetObserver<MemoryOperatorObserver, MemoryNetObserver>(
+          subject_,
+          this),
+      profile_(std::make_shared<MemoryProfile>(max_samples)) {
+  SetMemoryAllocationListener(profile_);
+}
+
+MemoryNetObserver::~MemoryNetObserver() {
+  SetMemoryAllocationListener(nullptr);
+}
+
+std::string MemoryNetObserver::debugInfo() {
+  return profile_->toJSON();
+}
+
+} // namespace caffe2
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "caffe2/core/allocator.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/observers/operator_attaching_net_observer.h"
+#include "caffe2/operators/rnn/rnn_capable_operator_observer.h"
+
+namespace caffe2 {
+
+// Totals over all the runs of one op
+struct OpMemory {
+  std::string type;
+  std::string output;
+  int64_t runs = 0;
+  int64_t allocations = 0;
+  uint64_t allocated_bytes = 0;
+  uint64_t freed_bytes = 0;
+  // the most the op allocated in one run
+  uint64_t max_run_bytes = 0;
+};
+
+// A live allocation, with the op that made it and the output it backs, if
+// it could be matched to one
+struct MemoryAllocation {
+  int device_type;
+  size_t nbytes;
+  // index into the ops of the profile, -1 if not made by an op
+  int op;
+  std::string blob;
+};
+
+// The allocations that were live when the memory of a device peaked
+struct MemoryPeak {
+  uint64_t live_bytes = 0;
+  double time_us = 0;
+  std::vector<std::shared_ptr<const MemoryAllocation>> allocations;
+};
+
+// Attributes the allocations made while it is the memory allocation
+// listener to the op that runs on the allocating thread, and records the
+// live memory of every device over time. Only memory allocated after it
+// was set counts as live.
+class MemoryProfile final : public MemoryAllocationListener {
+ public:
+  explicit MemoryProfile(size_t max_samples);
+
+  void OnAllocation(int device_type, void* ptr, size_t nbytes) override;
+  void OnDeallocation(int device_type, void* ptr) override;
+
+  // The op the allocations of the calling thread are made for; the previous
+  // one is restored by endOp, so that ops can be nested.
+  struct OpRun {
+    int op;
+    int previous_op;
+    double start_us;
+    uint64_t allocated_at_start;
+    size_t first_allocation;
+  };
+  OpRun beginOp(const OperatorBase* op);
+  // Matches the outputs of the op to the allocations it made in this run,
+  // by device and size, to tell which blobs the memory belongs to
+  void endOp(OperatorBase* op, const OpRun& run);
+
+  std::vector<OpMemory> ops() const;
+  std::map<int, uint64_t> liveBytes() const;
+  std::map<int, MemoryPeak> peaks() const;
+
+  // Per op totals, the peaks of the devices with their 10 largest
+  // allocations, and "traceEvents" in the Chrome trace format: a complete
+  // event for every op run and a counter of the live memory of every
+  // device, to be loaded in chrome://tracing.
+  std::string toJSON() const;
+
+ private:
+  struct DeviceMemory {
+    uint64_t live_bytes = 0;
+    MemoryPeak peak;
+    // the live memory went over the peak since the last snapshot
+    bool peak_pending = false;
+  };
+  struct Sample {
+    double time_us;
+    int device_type;
+    uint64_t live_bytes;
+  };
+  struct OpEvent {
+    int op;
+    double start_us;
+    double duration_us;
+    uint64_t allocated_bytes;
+  };
+
+  // since the profile was created; Timer is not precise enough in float
+  // after a few seconds
+  double nowUs() const {
+    return std::chrono::duration<double, std::micro>(
+               std::chrono::steady_clock::now() - start_)
+        .count();
+  }
+  int opIndex(const OperatorBase* op);
+  void sample(int device_type, const DeviceMemory& device);
+  void snapshotPeak(int device_type, DeviceMemory* device) const;
+
+  const size_t max_samples_;
+  const std::chrono::steady_clock::time_point start_;
+  mutable std::mutex mutex_;
+  std::unordered_map<const OperatorBase*, int> op_index_;
+  std::vector<OpMemory> ops_;
+  std::unordered_map<void*, std::shared_ptr<MemoryAllocation>> live_;
+  std::map<int, DeviceMemory> devices_;
+  std::vector<Sample> samples_;
+  std::vector<OpEvent> op_events_;
+  size_t dropped_samples_ = 0;
+};
+
+class MemoryNetObserver;
+class MemoryOperatorObserver final : public RNNCapableOperatorObserver {
+ public:
+  explicit MemoryOperatorObserver(OperatorBase* op) = delete;
+  MemoryOperatorObserver(OperatorBase* op, MemoryNetObserver* netObserver);
+  std::unique_ptr<ObserverBase<OperatorBase>> rnnCopy(
+      OperatorBase* subject,
+      int rnn_order) const override;
+
+ private:
+  void Start() override;
+  void Stop() override;
+
+  MemoryNetObserver* netObserver_;
+  MemoryProfile::OpRun run_;
+};
+
+// Profiles the memory that the ops of the net allocate, see MemoryProfile.
+// While it is attached, it is the memory allocation listener of the
+// process, so only one net can be profiled at a time.
+class MemoryNetObserver final : public OperatorAttachingNetObserver<
+                                    MemoryOperatorObserver,
+                                    MemoryNetObserver> {
+ public:
+  explicit MemoryNetObserver(NetBase* subject_, size_t max_samples = 1000000);
+  ~MemoryNetObserver();
+
+  const MemoryProfile& profile() const {
+    return *profile_;
+  }
+
+  // MemoryProfile::toJSON
+  std::string debugInfo() override;
+
+  friend class MemoryOperatorObserver;
+
+ private:
+  void Start() override {}
+  void Stop() override {}
+
+  std::shared_ptr<MemoryProfile> profile_;
+};
+
+} // namespace caffe2
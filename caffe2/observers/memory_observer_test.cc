@@ -0,0 +1,70 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "memory_observer.h"
+
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+TEST(MemoryObserverTest, AllocationsPerOpAndPeak) {
+  Workspace ws;
+  NetDef net_def;
+  net_def.set_name("memory");
+  {
+    auto& op = *(net_def.add_op());
+    op.set_type("ConstantFill");
+    op.add_output("X");
+    auto& shape = *(op.add_arg());
+    shape.set_name("shape");
+    shape.add_ints(1000);
+  }
+  {
+    auto& op = *(net_def.add_op());
+    op.set_type("Copy");
+    op.add_input("X");
+    op.add_output("Y");
+  }
+  unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  auto net_ob = caffe2::make_unique<MemoryNetObserver>(net.get());
+  auto* ob = net_ob.get();
+  net->AttachObserver(std::move(net_ob));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(net->Run());
+  }
+
+  const size_t nbytes = 1000 * sizeof(float);
+  auto ops = ob->profile().ops();
+  ASSERT_EQ(ops.size(), 2);
+  EXPECT_EQ(ops[0].type, "ConstantFill");
+  EXPECT_EQ(ops[0].output, "X");
+  EXPECT_EQ(ops[0].runs, 3);
+  // the outputs are allocated in the first run and reused after
+  EXPECT_EQ(ops[0].allocations, 1);
+  EXPECT_EQ(ops[0].allocated_bytes, nbytes);
+  EXPECT_EQ(ops[0].max_run_bytes, nbytes);
+  EXPECT_EQ(ops[1].type, "Copy");
+  EXPECT_EQ(ops[1].allocated_bytes, nbytes);
+  EXPECT_EQ(ob->profile().liveBytes().at(CPU), 2 * nbytes);
+
+  auto peak = ob->profile().peaks().at(CPU);
+  EXPECT_EQ(peak.live_bytes, 2 * nbytes);
+  ASSERT_EQ(peak.allocations.size(), 2);
+  std::set<std::string> blobs;
+  for (const auto& allocation : peak.allocations) {
+    EXPECT_EQ(allocation->nbytes, nbytes);
+    blobs.insert(allocation->blob);
+  }
+  EXPECT_EQ(blobs, (std::set<std::string>{"X", "Y"}));
+
+  // freeing the output of the first op doesn't move the peak
+  ws.GetBlob("X")->Reset();
+  EXPECT_EQ(ob->profile().liveBytes().at(CPU), nbytes);
+  EXPECT_EQ(ob->profile().peaks().at(CPU).live_bytes, 2 * nbytes);
+
+  auto json = ob->debugInfo();
+  EXPECT_NE(json.find("\"traceEvents\""), std::string::npos);
+  EXPECT_NE(json.find("\"CPU memory\""), std::string::npos);
+}
+
+} // namespace caffe2
@@ -1,3 +1,4 @@
+#include "caffe2/core/flags.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/onnx/backend.h"
@@ -14,12 +15,24 @@
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 
+#include <atomic>
 #include <cmath>
+#include <exception>
 #include <iostream>
+#include <list>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
+CAFFE2_DEFINE_int(
+    caffe2_onnx_prepare_cache_size,
+    8,
+    "Number of converted models Caffe2Backend::Prepare keeps, so that "
+    "preparing a model of the same graph again, e.g. when it is reloaded, "
+    "skips checking, optimizing and converting it. 0 disables the cache.");
+
 namespace caffe2 {
 namespace onnx {
 
@@ -27,6 +40,276 @@ namespace {
 
 constexpr static int kKnownOpsetVersion = 6;
 
+// What Prepare converts from the graph of a model, which doesn't depend on
+// the values of its initializers.
+struct ConvertedModel {
+  caffe2::NetDef init_net;
+  caffe2::NetDef pred_net;
+  std::vector<std::string> uninitialized_inputs;
+};
+
+// The models converted last, most recently used first, keyed on everything
+// their conversion depends on: the graph without the data of the
+// initializers, the opset, the device and the preconverted RNN ops.
+class ConversionCache {
+ public:
+  std::shared_ptr<const ConvertedModel> Get(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->first == key) {
+        entries_.splice(entries_.begin(), entries_, it);
+        return it->second;
+      }
+    }
+    return nullptr;
+  }
+
+  void Put(
+      const std::string& key,
+      std::shared_ptr<const ConvertedModel> model) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.emplace_front(key, std::move(model));
+    while (entries_.size() >
+           static_cast<size_t>(FLAGS_caffe2_onnx_prepare_cache_size)) {
+      entries_.pop_back();
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::list<std::pair<std::string, std::shared_ptr<const ConvertedModel>>>
+      entries_;
+};
+
+ConversionCache& GetConversionCache() {
+  static ConversionCache cache;
+  return cache;
+}
+
+std::string ConversionKey(
+    const ModelProto& onnx_model,
+    const std::string& device,
+    int opset_version,
+    const std::vector<Caffe2Ops>& extras) {
+  const auto& graph = onnx_model.graph();
+  std::string key = device + "/" + caffe2::to_string(opset_version) + "/" +
+      graph.name() + "/";
+  for (const auto& node : graph.node()) {
+    key += node.SerializeAsString();
+  }
+  for (const auto& value : graph.input()) {
+    key += value.SerializeAsString();
+  }
+  for (const auto& value : graph.output()) {
+    key += value.SerializeAsString();
+  }
+  for (const auto& value : graph.value_info()) {
+    key += value.SerializeAsString();
+  }
+  for (const auto& tp : graph.initializer()) {
+    TensorProto meta;
+    meta.set_name(tp.name());
+    meta.set_data_type(tp.data_type());
+    meta.mutable_dims()->CopyFrom(tp.dims());
+    key += meta.SerializeAsString();
+  }
+  for (const auto& c2ops : extras) {
+    for (const auto& op : c2ops.init_ops) {
+      key += op.SerializeAsString();
+    }
+    for (const auto& op : c2ops.ops) {
+      key += op.SerializeAsString();
+    }
+    for (const auto& blob : c2ops.interface_blobs) {
+      key += blob + "/";
+    }
+  }
+  return key;
+}
+
+// Makes `tensor` share `data`, which lives in `model`, and keeps the model
+// alive as long as the tensor uses it.
+void ShareInitializerData(
+    const std::shared_ptr<const ModelProto>& model,
+    const TensorProto& onnx_tensor,
+    const void* data,
+    size_t nbytes,
+    const TypeMeta& meta,
+    caffe2::TensorCPU* tensor) {
+  CAFFE_ENFORCE_EQ(
+      nbytes,
+      tensor->size() * meta.itemsize(),
+      "Initializer ",
+      onnx_tensor.name(),
+      " doesn't have the amount of data its shape needs");
+  tensor->ShareExternalPointer(
+      const_cast<void*>(data), meta, nbytes, [model](void*) {});
+}
+
+// Copies the values of `onnx_tensor`, of ONNX type Src, stored in its raw
+// data or in `field`, into `tensor` as values of type Dst.
+template <typename Src, typename Dst, typename Field>
+void CopyInitializerData(
+    const TensorProto& onnx_tensor,
+    const Field& field,
+    caffe2::TensorCPU* tensor) {
+  auto* dst = tensor->mutable_data<Dst>();
+  if (onnx_tensor.has_raw_data()) {
+    const auto& raw = onnx_tensor.raw_data();
+    CAFFE_ENFORCE_EQ(
+        raw.size(),
+        tensor->size() * sizeof(Src),
+        "Initializer ",
+        onnx_tensor.name(),
+        " doesn't have the amount of data its shape needs");
+    const auto* src = reinterpret_cast<const Src*>(raw.data());
+    std::copy(src, src + tensor->size(), dst);
+  } else {
+    CAFFE_ENFORCE_EQ(
+        field.size(),
+        tensor->size(),
+        "Initializer ",
+        onnx_tensor.name(),
+        " doesn't have the amount of data its shape needs");
+    std::copy(field.begin(), field.end(), dst);
+  }
+}
+
+template <typename T, typename Field>
+void ShareOrCopyInitializerData(
+    const std::shared_ptr<const ModelProto>& model,
+    const TensorProto& onnx_tensor,
+    const Field& field,
+    caffe2::TensorCPU* tensor) {
+  if (onnx_tensor.has_raw_data()) {
+    const auto& raw = onnx_tensor.raw_data();
+    // ONNX raw data is little endian, like the hosts we run on; the string
+    // holding it comes from the allocator, aligned for any T
+    ShareInitializerData(
+        model,
+        onnx_tensor,
+        raw.data(),
+        raw.size(),
+        TypeMeta::Make<T>(),
+        tensor);
+  } else if (std::is_same<T, typename Field::value_type>::value) {
+    ShareInitializerData(
+        model,
+        onnx_tensor,
+        field.data(),
+        field.size() * sizeof(T),
+        TypeMeta::Make<T>(),
+        tensor);
+  } else {
+    CopyInitializerData<T, T>(onnx_tensor, field, tensor);
+  }
+}
+
+// Builds the tensor of an initializer like the fill op
+// Caffe2Backend::BuildTensorFillingOp would create, without copying the data
+// where the types allow it.
+void BuildInitializerTensor(
+    const std::shared_ptr<const ModelProto>& model,
+    const TensorProto& onnx_tensor,
+    caffe2::TensorCPU* tensor) {
+  CAFFE_ENFORCE(!onnx_tensor.name().empty());
+  if (onnx_tensor.has_segment()) {
+    CAFFE_THROW("Currently not supporting loading segments.");
+  }
+  tensor->Resize(std::vector<TIndex>(
+      onnx_tensor.dims().begin(), onnx_tensor.dims().end()));
+
+  switch (onnx_tensor.data_type()) {
+    case TensorProto::FLOAT:
+      ShareOrCopyInitializerData<float>(
+          model, onnx_tensor, onnx_tensor.float_data(), tensor);
+      break;
+    case TensorProto::DOUBLE:
+      ShareOrCopyInitializerData<double>(
+          model, onnx_tensor, onnx_tensor.double_data(), tensor);
+      break;
+    case TensorProto::INT64:
+      ShareOrCopyInitializerData<int64_t>(
+          model, onnx_tensor, onnx_tensor.int64_data(), tensor);
+      break;
+    case TensorProto::INT32:
+      ShareOrCopyInitializerData<int32_t>(
+          model, onnx_tensor, onnx_tensor.int32_data(), tensor);
+      break;
+    case TensorProto::BOOL:
+      ShareOrCopyInitializerData<bool>(
+          model, onnx_tensor, onnx_tensor.int32_data(), tensor);
+      break;
+    // like the fill ops, which take these as int32 and uint32 as int64
+    case TensorProto::UINT8:
+      CopyInitializerData<uint8_t, int32_t>(
+          onnx_tensor, onnx_tensor.int32_data(), tensor);
+      break;
+    case TensorProto::INT8:
+      CopyInitializerData<int8_t, int32_t>(
+          onnx_tensor, onnx_tensor.int32_data(), tensor);
+      break;
+    case TensorProto::UINT16:
+      CopyInitializerData<uint16_t, int32_t>(
+          onnx_tensor, onnx_tensor.int32_data(), tensor);
+      break;
+    case TensorProto::INT16:
+      CopyInitializerData<int16_t, int32_t>(
+          onnx_tensor, onnx_tensor.int32_data(), tensor);
+      break;
+    case TensorProto::UINT32:
+      CopyInitializerData<uint32_t, int64_t>(
+          onnx_tensor, onnx_tensor.uint64_data(), tensor);
+      break;
+    case TensorProto::STRING:
+      CopyInitializerData<std::string, std::string>(
+          onnx_tensor, onnx_tensor.string_data(), tensor);
+      break;
+    default:
+      CAFFE_THROW(
+          "unrecognized tensor type: ",
+          TensorProto::DataType_Name(onnx_tensor.data_type()));
+  }
+}
+
+// Builds the tensors of all initializers of `model`, the ones which need
+// their data converted on several threads.
+void BuildInitializerTensors(
+    const std::shared_ptr<const ModelProto>& model,
+    std::vector<std::pair<std::string, caffe2::TensorCPU>>* tensors) {
+  const auto& initializers = model->graph().initializer();
+  tensors->resize(initializers.size());
+  std::atomic<int> next(0);
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  const int size = initializers.size();
+  auto worker = [&]() {
+    for (int i = next++; i < size; i = next++) {
+      try {
+        (*tensors)[i].first = initializers.Get(i).name();
+        BuildInitializerTensor(
+            model, initializers.Get(i), &(*tensors)[i].second);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        error = std::current_exception();
+      }
+    }
+  };
+  const int num_threads =
+      std::min<int>(size, std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
 bool AlmostEqual(double a, double b) {
   constexpr static double kEps = 1e-15;
   return (fabs(a - b) < kEps);
@@ -925,14 +1208,6 @@ void Caffe2Backend::OnnxToCaffe2(
   init_net->set_name(onnx_model.graph().name() + "_init");
   pred_net->set_name(onnx_model.graph().name() + "_predict");
 
-  // Convert initializer if necessary
-  if (include_initializers) {
-    for (const auto& tp : onnx_model.graph().initializer()) {
-      auto* c2_op = init_net->add_op();
-      BuildTensorFillingOp(c2_op, tp);
-    }
-  }
-
   auto name_set = AllNamesInGraph(init_model.graph());
   auto name_set_pred = AllNamesInGraph(pred_model.graph());
   name_set.insert(name_set_pred.begin(), name_set_pred.end());
@@ -996,15 +1271,12 @@ Caffe2BackendRep* Caffe2Backend::Prepare(
     const std::string& device,
     const std::vector<Caffe2Ops>& extras) {
   Caffe2BackendRep* rep = new Caffe2BackendRep();
-  ModelProto onnx_model;
-  ParseProtoFromLargeString(onnx_model_str, &onnx_model);
-
-#if !CAFFE2_MOBILE
-  ::ONNX_NAMESPACE::checker::check_model(onnx_model);
-#endif
+  // shared by the tensors bound to its initializers
+  auto onnx_model = std::make_shared<ModelProto>();
+  ParseProtoFromLargeString(onnx_model_str, onnx_model.get());
 
   int opset_version = -1;
-  for (const auto& imp : onnx_model.opset_import()) {
+  for (const auto& imp : onnx_model->opset_import()) {
     if ((!imp.has_domain()) || imp.domain().empty()) {
       opset_version = imp.version();
       if (opset_version > kKnownOpsetVersion) {
@@ -1022,7 +1294,7 @@ Caffe2BackendRep* Caffe2Backend::Prepare(
     }
   }
   if (opset_version < 0) {
-    if (onnx_model.ir_version() >= 0x00000003) {
+    if (onnx_model->ir_version() >= 0x00000003) {
       CAFFE_THROW(
           "Model with IR version >= 3 did not specify ONNX operator set "
           "version (onnx-caffe2 requires it)");
@@ -1031,27 +1303,65 @@ Caffe2BackendRep* Caffe2Backend::Prepare(
     }
   }
 
-  // TODO: avoid extra copy by directly feed initialiers to backend blobs
-  OnnxToCaffe2(
-      &rep->init_net(),
-      &rep->pred_net(),
-      onnx_model,
-      device,
-      opset_version,
-      true,
-      extras);
-
-  // Get a list of uninitialized inputs to help with the inference setup
-  auto& uninitialized_inputs = rep->uninitialized_inputs();
-  std::unordered_set<std::string> initialized_inputs;
-  for (const auto& tp : onnx_model.graph().initializer()) {
-    initialized_inputs.emplace(tp.name());
-  }
-  for (const auto& input : onnx_model.graph().input()) {
-    if (!initialized_inputs.count(input.name())) {
-      uninitialized_inputs.emplace_back(input.name());
+  // Checking, optimizing and converting the graph is what takes long for a
+  // big model, and doesn't depend on the values of the initializers
+  std::shared_ptr<const ConvertedModel> converted;
+  std::string key;
+  if (FLAGS_caffe2_onnx_prepare_cache_size > 0) {
+    key = ConversionKey(*onnx_model, device, opset_version, extras);
+    converted = GetConversionCache().Get(key);
+  }
+  if (!converted) {
+#if !CAFFE2_MOBILE
+    ::ONNX_NAMESPACE::checker::check_model(*onnx_model);
+#endif
+    auto model = std::make_shared<ConvertedModel>();
+    OnnxToCaffe2(
+        &model->init_net,
+        &model->pred_net,
+        *onnx_model,
+        device,
+        opset_version,
+        true,
+        extras);
+
+    // Get a list of uninitialized inputs to help with the inference setup
+    std::unordered_set<std::string> initialized_inputs;
+    for (const auto& tp : onnx_model->graph().initializer()) {
+      initialized_inputs.emplace(tp.name());
+    }
+    for (const auto& input : onnx_model->graph().input()) {
+      if (!initialized_inputs.count(input.name())) {
+        model->uninitialized_inputs.emplace_back(input.name());
+      }
+    }
+    converted = model;
+    if (FLAGS_caffe2_onnx_prepare_cache_size > 0) {
+      GetConversionCache().Put(key, converted);
+    }
+  }
+
+  // The predictor runs on CPU, where the initializers are bound to tensors
+  // sharing the raw data of the model instead of being filled by init_net;
+  // other devices fill them from the init_net ops
+  if (Device(device).type == DeviceType::CPU) {
+    BuildInitializerTensors(onnx_model, &rep->initializers());
+  } else {
+    for (const auto& tp : onnx_model->graph().initializer()) {
+      auto* c2_op = rep->init_net().add_op();
+      BuildTensorFillingOp(c2_op, tp);
     }
   }
+  rep->init_net().set_name(converted->init_net.name());
+  rep->init_net().mutable_device_option()->CopyFrom(
+      converted->init_net.device_option());
+  rep->init_net().mutable_op()->MergeFrom(converted->init_net.op());
+  rep->init_net().mutable_external_input()->MergeFrom(
+      converted->init_net.external_input());
+  rep->init_net().mutable_external_output()->MergeFrom(
+      converted->init_net.external_output());
+  rep->pred_net().CopyFrom(converted->pred_net);
+  rep->uninitialized_inputs() = converted->uninitialized_inputs;
 
   return rep;
 }
@@ -7,7 +7,14 @@ namespace caffe2 { namespace onnx {
 
 void Caffe2BackendRep::CheckInit() {
   if (!predictor_) {
-    predictor_ = caffe2::make_unique<caffe2::Predictor>(init_net_, pred_net_);
+    for (auto& initializer : initializers_) {
+      initializers_ws_.CreateBlob(initializer.first)
+          ->GetMutable<caffe2::TensorCPU>()
+          ->ShareData(initializer.second);
+    }
+    initializers_.clear();
+    predictor_ = caffe2::make_unique<caffe2::Predictor>(
+        init_net_, pred_net_, &initializers_ws_);
     init_net_.Clear();
     pred_net_.Clear();
   }
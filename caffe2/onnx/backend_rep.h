@@ -5,6 +5,7 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace caffe2 { namespace onnx {
@@ -26,6 +27,12 @@ class Caffe2BackendRep {
   std::vector<std::string>& uninitialized_inputs() {
     return uninitialized_inputs_;
   }
+  // The initializers Caffe2Backend::Prepare bound to tensors directly, which
+  // init_net() doesn't fill. They are moved into the predictor's parent
+  // workspace when it is created.
+  std::vector<std::pair<std::string, caffe2::TensorCPU>>& initializers() {
+    return initializers_;
+  }
 
   const caffe2::NetDef& init_net() const {
     return init_net_;
@@ -43,6 +50,9 @@ class Caffe2BackendRep {
   caffe2::NetDef init_net_;
   caffe2::NetDef pred_net_;
   std::vector<std::string> uninitialized_inputs_;
+  std::vector<std::pair<std::string, caffe2::TensorCPU>> initializers_;
+  // holds the initializers, outlives the predictor
+  caffe2::Workspace initializers_ws_;
   std::unique_ptr<caffe2::Predictor> predictor_{nullptr};
 };
 }}
@@ -0,0 +1,194 @@
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "caffe2/core/flags.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+namespace {
+
+class BatchCopyOpsTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    enabled_ = FLAGS_caffe2_intra_op_parallelism;
+  }
+  void TearDown() override {
+    FLAGS_caffe2_intra_op_parallelism = enabled_;
+  }
+
+ private:
+  bool enabled_;
+};
+
+template <typename T>
+void AddInput(
+    const string& name,
+    const vector<TIndex>& shape,
+    const vector<T>& values,
+    Workspace* ws) {
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(shape);
+  CHECK_EQ(tensor->size(), values.size());
+  std::copy(values.begin(), values.end(), tensor->mutable_data<T>());
+}
+
+vector<float> RandomFloats(int size, std::mt19937* gen) {
+  std::uniform_real_distribution<float> dist(-1, 1);
+  vector<float> values(size);
+  for (auto& value : values) {
+    value = dist(*gen);
+  }
+  return values;
+}
+
+template <typename T>
+vector<T> RandomInts(int size, T max, std::mt19937* gen) {
+  std::uniform_int_distribution<T> dist(0, max);
+  vector<T> values(size);
+  for (auto& value : values) {
+    value = dist(*gen);
+  }
+  return values;
+}
+
+// Runs the operator on the inputs of ws, and returns the bytes of its outputs
+vector<string> RunOp(const OperatorDef& def, const Workspace& ws, bool parallel) {
+  FLAGS_caffe2_intra_op_parallelism = parallel;
+  Workspace child(&ws);
+  EXPECT_TRUE(CreateOperator(def, &child)->Run());
+  vector<string> outputs;
+  for (const auto& output : def.output()) {
+    const auto& tensor = child.GetBlob(output)->Get<TensorCPU>();
+    outputs.emplace_back(
+        static_cast<const char*>(tensor.raw_data()), tensor.nbytes());
+  }
+  return outputs;
+}
+
+void ExpectMatchesSequential(const OperatorDef& def, const Workspace& ws) {
+  const auto expected = RunOp(def, ws, false);
+  const auto actual = RunOp(def, ws, true);
+  EXPECT_EQ(expected, actual) << def.type();
+}
+
+OperatorDef MakeOpDef(
+    const string& type,
+    const vector<string>& inputs,
+    const vector<string>& outputs) {
+  OperatorDef def;
+  def.set_type(type);
+  for (const auto& input : inputs) {
+    def.add_input(input);
+  }
+  for (const auto& output : outputs) {
+    def.add_output(output);
+  }
+  return def;
+}
+
+} // namespace
+
+TEST_F(BatchCopyOpsTest, BooleanMask) {
+  const int kRows = 20000;
+  const int kCols = 8;
+  Workspace ws;
+  std::mt19937 gen(0);
+  AddInput("data", {kRows, kCols}, RandomFloats(kRows * kCols, &gen), &ws);
+  vector<bool> mask(kRows);
+  std::bernoulli_distribution dist(0.7);
+  for (int i = 0; i < kRows; ++i) {
+    mask[i] = dist(gen);
+  }
+  AddInput<bool>("mask", {kRows}, mask, &ws);
+  ExpectMatchesSequential(
+      MakeOpDef("BooleanMask", {"data", "mask"}, {"masked", "indices"}), ws);
+}
+
+TEST_F(BatchCopyOpsTest, PackAndUnpackSegments) {
+  const int kSegments = 500;
+  const int kBlock = 4;
+  Workspace ws;
+  std::mt19937 gen(0);
+  const auto lengths = RandomInts<int>(kSegments, 50, &gen);
+  int total = 0;
+  for (auto length : lengths) {
+    total += length;
+  }
+  AddInput("lengths", {kSegments}, lengths, &ws);
+  AddInput("data", {total, kBlock}, RandomFloats(total * kBlock, &gen), &ws);
+  auto def = MakeOpDef(
+      "PackSegments", {"lengths", "data"}, {"packed", "presence_mask"});
+  def.add_arg()->CopyFrom(MakeArgument("return_presence_mask", true));
+  def.add_arg()->CopyFrom(MakeArgument("pad_minf", true));
+  ExpectMatchesSequential(def, ws);
+
+  EXPECT_TRUE(CreateOperator(def, &ws)->Run());
+  ExpectMatchesSequential(
+      MakeOpDef("UnpackSegments", {"lengths", "packed"}, {"unpacked"}), ws);
+}
+
+TEST_F(BatchCopyOpsTest, SparseToDense) {
+  const int kValues = 20000;
+  const int kRows = 10000;
+  const int kBlock = 8;
+  Workspace ws;
+  std::mt19937 gen(0);
+  // Many indices are duplicated, and summed in the order of the values
+  AddInput(
+      "indices", {kValues}, RandomInts<int>(kValues, kRows - 1, &gen), &ws);
+  AddInput(
+      "values", {kValues, kBlock}, RandomFloats(kValues * kBlock, &gen), &ws);
+  ExpectMatchesSequential(
+      MakeOpDef("SparseToDense", {"indices", "values"}, {"dense"}), ws);
+}
+
+TEST_F(BatchCopyOpsTest, BatchSparseToDense) {
+  const int kBatch = 5000;
+  const TIndex kDenseDim = 100;
+  Workspace ws;
+  std::mt19937 gen(0);
+  const auto lengths = RandomInts<TIndex>(kBatch, 10, &gen);
+  TIndex total = 0;
+  for (auto length : lengths) {
+    total += length;
+  }
+  AddInput("lengths", {kBatch}, lengths, &ws);
+  AddInput(
+      "indices", {total}, RandomInts<TIndex>(total, kDenseDim - 1, &gen), &ws);
+  AddInput("values", {total}, RandomFloats(total, &gen), &ws);
+  auto def = MakeOpDef(
+      "BatchSparseToDense", {"lengths", "indices", "values"}, {"dense"});
+  def.add_arg()->CopyFrom(MakeArgument<int>("dense_last_dim", kDenseDim));
+  ExpectMatchesSequential(def, ws);
+}
+
+TEST_F(BatchCopyOpsTest, GatherRangesToDense) {
+  const int kBatch = 3000;
+  const int kData = 1000;
+  const vector<int> kLengths{30, 20};
+  Workspace ws;
+  std::mt19937 gen(0);
+  AddInput("data", {kData}, RandomFloats(kData, &gen), &ws);
+  vector<int> ranges;
+  for (int i = 0; i < kBatch; ++i) {
+    for (auto length : kLengths) {
+      // Every fourth range is empty
+      const bool empty = gen() % 4 == 0;
+      ranges.push_back(gen() % (kData - length));
+      ranges.push_back(empty ? 0 : length);
+    }
+  }
+  AddInput("ranges", {kBatch, 2, 2}, ranges, &ws);
+  AddInput("key", {kData}, RandomInts<int64_t>(kData, 1 << 20, &gen), &ws);
+  auto def = MakeOpDef("GatherRangesToDense", {"data", "ranges"}, {"a", "b"});
+  def.add_arg()->CopyFrom(MakeArgument("lengths", kLengths));
+  ExpectMatchesSequential(def, ws);
+
+  def.add_input("key");
+  ExpectMatchesSequential(def, ws);
+}
+
+} // namespace caffe2
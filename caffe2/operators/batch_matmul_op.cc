@@ -3,6 +3,59 @@
 
 namespace caffe2 {
 
+namespace {
+
+// The number of multiply-adds worth a thread handoff
+constexpr size_t kBatchMatMulParallelGrain = 1 << 16;
+
+} // namespace
+
+bool BatchMatMulParallel<CPUContext, DefaultEngine, float>::Run(
+    ThreadPool* pool,
+    bool trans_a,
+    bool trans_b,
+    size_t num_outer_batches,
+    size_t num_sub_batches,
+    int M,
+    int N,
+    int K,
+    const float* A,
+    size_t A_stride,
+    const float* B,
+    size_t B_stride,
+    float* Y,
+    size_t Y_stride,
+    CPUContext* context) {
+  const size_t num_batches = num_outer_batches * num_sub_batches;
+  const size_t batch_work = static_cast<size_t>(M) * N * K;
+  if (!pool || pool->getNumThreads() <= 1 || num_batches < 2 ||
+      num_batches * batch_work < 2 * kBatchMatMulParallelGrain) {
+    return false;
+  }
+  const auto transA = trans_a ? CblasTrans : CblasNoTrans;
+  const auto transB = trans_b ? CblasTrans : CblasNoTrans;
+  const size_t grain = kBatchMatMulParallelGrain / (batch_work + 1) + 1;
+  ParallelFor(pool, num_batches, grain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const size_t p = i / num_sub_batches;
+      const size_t s = i % num_sub_batches;
+      math::Gemm<float, CPUContext>(
+          transA,
+          transB,
+          M,
+          N,
+          K,
+          1.0f,
+          A + p * A_stride + s * M * K,
+          B + p * B_stride + s * K * N,
+          0.0f,
+          Y + p * Y_stride + s * M * N,
+          context);
+    }
+  });
+  return true;
+}
+
 REGISTER_CPU_OPERATOR(BatchMatMul, BatchMatMulOp<CPUContext>);
 
 vector<TensorShape> TensorInferenceForBatchMatMul(
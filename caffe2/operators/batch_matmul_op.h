@@ -9,6 +9,52 @@
 
 namespace caffe2 {
 
+// Computes the num_outer_batches x num_sub_batches GEMMs of BatchMatMulOp,
+// with the matrices split between the threads of pool. Returns false for the contexts, engines and
+// types it does not cover, and for too little work, in which case the
+// operator runs its batched GEMMs.
+template <class Context, class Engine, typename T>
+struct BatchMatMulParallel {
+  static bool Run(
+      ThreadPool* /*pool*/,
+      bool /*trans_a*/,
+      bool /*trans_b*/,
+      size_t /*num_outer_batches*/,
+      size_t /*num_sub_batches*/,
+      int /*M*/,
+      int /*N*/,
+      int /*K*/,
+      const T* /*A*/,
+      size_t /*A_stride*/,
+      const T* /*B*/,
+      size_t /*B_stride*/,
+      T* /*Y*/,
+      size_t /*Y_stride*/,
+      Context* /*context*/) {
+    return false;
+  }
+};
+
+template <>
+struct BatchMatMulParallel<CPUContext, DefaultEngine, float> {
+  static bool Run(
+      ThreadPool* pool,
+      bool trans_a,
+      bool trans_b,
+      size_t num_outer_batches,
+      size_t num_sub_batches,
+      int M,
+      int N,
+      int K,
+      const float* A,
+      size_t A_stride,
+      const float* B,
+      size_t B_stride,
+      float* Y,
+      size_t Y_stride,
+      CPUContext* context);
+};
+
 template <class Context, class Engine = DefaultEngine>
 class BatchMatMulOp final : public Operator<Context> {
  public:
@@ -253,22 +299,85 @@ class BatchMatMulOp final : public Operator<Context> {
         return true;
       }
 
-      // TODO(T23893772): doing this in a loop is likely going to be slow on GPU
-      for (size_t p = 0; p < num_outer_batches; ++p) {
-        math::GemmBatched<T, Context, Engine>(
-            trans_a_ ? CblasTrans : CblasNoTrans,
-            trans_b_ ? CblasTrans : CblasNoTrans,
-            num_sub_batches,
-            M,
-            N,
-            K,
-            1.0f,
-            data_A + p * A_stride,
-            data_B + p * B_stride,
-            0.0f,
-            Y_data + p * Y_stride,
-            &context_,
-            use_scratch_ ? scratch_.get() : nullptr);
+      if (BatchMatMulParallel<Context, Engine, T>::Run(
+              this->IntraOpThreadPool(),
+              trans_a_,
+              trans_b_,
+              num_outer_batches,
+              num_sub_batches,
+              M,
+              N,
+              K,
+              data_A,
+              A_stride,
+              data_B,
+              B_stride,
+              Y_data,
+              Y_stride,
+              &context_)) {
+        return true;
+      }
+
+      const auto trans_a = trans_a_ ? CblasTrans : CblasNoTrans;
+      const auto trans_b = trans_b_ ? CblasTrans : CblasNoTrans;
+      if (use_scratch_) {
+        for (size_t p = 0; p < num_outer_batches; ++p) {
+          math::GemmBatched<T, Context, Engine>(
+              trans_a,
+              trans_b,
+              num_sub_batches,
+              M,
+              N,
+              K,
+              1.0f,
+              data_A + p * A_stride,
+              data_B + p * B_stride,
+              0.0f,
+              Y_data + p * Y_stride,
+              &context_,
+              scratch_.get());
+        }
+      } else if (num_outer_batches <= num_sub_batches) {
+        // One batched GEMM over the inner batches of every outer batch
+        for (size_t p = 0; p < num_outer_batches; ++p) {
+          math::GemmStridedBatched<T, Context, Engine>(
+              trans_a,
+              trans_b,
+              num_sub_batches,
+              M,
+              N,
+              K,
+              1.0f,
+              data_A + p * A_stride,
+              M * K,
+              data_B + p * B_stride,
+              K * N,
+              0.0f,
+              Y_data + p * Y_stride,
+              M * N,
+              &context_);
+        }
+      } else {
+        // One batched GEMM over the outer batches of every inner batch, in
+        // which the matrix of the operand that is broadcast has a stride of 0
+        for (size_t s = 0; s < num_sub_batches; ++s) {
+          math::GemmStridedBatched<T, Context, Engine>(
+              trans_a,
+              trans_b,
+              num_outer_batches,
+              M,
+              N,
+              K,
+              1.0f,
+              data_A + s * M * K,
+              A_stride,
+              data_B + s * K * N,
+              B_stride,
+              0.0f,
+              Y_data + s * M * N,
+              Y_stride,
+              &context_);
+        }
       }
     }
     return true;
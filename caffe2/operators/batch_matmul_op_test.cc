@@ -1,4 +1,5 @@
 #include <memory>
+#include <random>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -33,6 +34,43 @@ class BatchMatMulOpTest : public testing::Test {
         cpu_context_.get());
   }
 
+  void AddRandomInput(
+      const std::vector<TIndex>& dims,
+      const string& name,
+      std::mt19937* gen) {
+    auto* tensor = ws_.CreateBlob(name)->GetMutable<TensorCPU>();
+    tensor->Resize(dims);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    for (int i = 0; i < tensor->size(); ++i) {
+      tensor->mutable_data<float>()[i] = dist(*gen);
+    }
+  }
+
+  // Checks Y against the products of the [M, K] matrices of A and the
+  // [K, N] matrices of B, where B has the batch dimensions of A or none
+  void VerifyProducts(int M, int N, int K) const {
+    const auto& A = ws_.GetBlob("A")->Get<TensorCPU>();
+    const auto& B = ws_.GetBlob("B")->Get<TensorCPU>();
+    const auto& Y = ws_.GetBlob("Y")->Get<TensorCPU>();
+    const int num_batches = A.size() / (M * K);
+    const int B_batches = B.size() / (K * N);
+    ASSERT_EQ(num_batches * M * N, Y.size());
+    for (int b = 0; b < num_batches; ++b) {
+      const float* A_data = A.data<float>() + b * M * K;
+      const float* B_data = B.data<float>() + (b % B_batches) * K * N;
+      const float* Y_data = Y.data<float>() + b * M * N;
+      for (int i = 0; i < M; ++i) {
+        for (int j = 0; j < N; ++j) {
+          float expected = 0;
+          for (int k = 0; k < K; ++k) {
+            expected += A_data[i * K + k] * B_data[k * N + j];
+          }
+          EXPECT_NEAR(expected, Y_data[i * N + j], 1e-4);
+        }
+      }
+    }
+  }
+
   void VerifyOutput(const std::vector<TIndex>& dims, const float value) const {
     const Blob* Y_blob = ws_.GetBlob("Y");
     ASSERT_NE(nullptr, Y_blob);
@@ -74,5 +112,35 @@ TEST_F(BatchMatMulOpTest, BatchMatMulOpBroadcastTest) {
   VerifyOutput(std::vector<TIndex>{2, 3, 5, 6}, 10.0f);
 }
 
+TEST_F(BatchMatMulOpTest, BatchMatMulOpBroadcastMatrixTest) {
+  // More outer batches than inner ones, B is reused for all of them
+  auto* arg = def_.add_arg();
+  arg->set_name("broadcast");
+  arg->set_i(1);
+  std::mt19937 gen(0);
+  AddRandomInput(std::vector<TIndex>{2, 3, 5, 10}, "A", &gen);
+  AddRandomInput(std::vector<TIndex>{10, 6}, "B", &gen);
+  std::unique_ptr<OperatorBase> op(CreateOperator(def_, &ws_));
+  ASSERT_NE(nullptr, op);
+  ASSERT_TRUE(op->Run());
+  VerifyProducts(5, 6, 10);
+}
+
+TEST_F(BatchMatMulOpTest, BatchMatMulOpParallelTest) {
+  const bool enabled = FLAGS_caffe2_intra_op_parallelism;
+  FLAGS_caffe2_intra_op_parallelism = true;
+  auto* arg = def_.add_arg();
+  arg->set_name("broadcast");
+  arg->set_i(1);
+  std::mt19937 gen(0);
+  AddRandomInput(std::vector<TIndex>{8, 4, 16, 32}, "A", &gen);
+  AddRandomInput(std::vector<TIndex>{4, 32, 16}, "B", &gen);
+  std::unique_ptr<OperatorBase> op(CreateOperator(def_, &ws_));
+  ASSERT_NE(nullptr, op);
+  ASSERT_TRUE(op->Run());
+  FLAGS_caffe2_intra_op_parallelism = enabled;
+  VerifyProducts(16, 16, 32);
+}
+
 } // namespace
 } // namespace caffe2
@@ -1,9 +1,18 @@
 #include "batch_sparse_to_dense_op.h"
 
+#include <numeric>
+
 #include "caffe2/core/context.h"
 
 namespace caffe2 {
 
+namespace {
+
+// The number of dense values worth a thread handoff
+constexpr TIndex kBatchSparseToDenseParallelGrain = 1 << 14;
+
+} // namespace
+
 template <typename T, class Context>
 bool BatchSparseToDenseOp<T, Context>::RunOnDevice() {
   auto& lengths = Input(LENGTHS);
@@ -42,20 +51,30 @@ bool BatchSparseToDenseOp<T, Context>::RunOnDevice() {
   math::Set(
       output->size(), static_cast<T>(default_value_), output_data, &context_);
 
-  TIndex k = 0;
-  for (TIndex i = 0; i < batch_size; ++i) {
-    for (TIndex j = 0; j < lengths_data[i]; ++j) {
-      CAFFE_ENFORCE(
-          indices_data[k] < dense_last_dim_,
-          "An indice (",
-          indices_data[k],
-          ") is larger then last dim of dense (",
-          dense_last_dim_,
-          ").");
-      output_data[i * dense_last_dim_ + indices_data[k]] = values_data[k];
-      k += 1;
-    }
-  }
+  // The rows are independent once their first value is known
+  vector<TIndex> offsets(batch_size + 1);
+  offsets[0] = 0;
+  std::partial_sum(
+      lengths_data, lengths_data + batch_size, offsets.begin() + 1);
+  ParallelFor(
+      this->IntraOpThreadPool(),
+      batch_size,
+      kBatchSparseToDenseParallelGrain / dense_last_dim_ + 1,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          T* row = output_data + i * dense_last_dim_;
+          for (TIndex k = offsets[i]; k < offsets[i + 1]; ++k) {
+            CAFFE_ENFORCE(
+                indices_data[k] < dense_last_dim_,
+                "An indice (",
+                indices_data[k],
+                ") is larger then last dim of dense (",
+                dense_last_dim_,
+                ").");
+            row[indices_data[k]] = values_data[k];
+          }
+        }
+      });
 
   return true;
 }
@@ -84,20 +103,30 @@ bool BatchDenseToSparseOp<T, Context>::RunOnDevice() {
   output->Resize(output_shape);
   T* output_data = output->template mutable_data<T>();
 
-  TIndex k = 0;
-  for (TIndex i = 0; i < batch_size; ++i) {
-    for (TIndex j = 0; j < lengths_data[i]; ++j) {
-      CAFFE_ENFORCE(
-          indices_data[k] < dense.dim(1),
-          "An indice (",
-          indices_data[k],
-          ") is larger then last dim of dense (",
-          dense.dim(1),
-          ").");
-      output_data[k] = dense_data[i * dense.dim(1) + indices_data[k]];
-      k += 1;
-    }
-  }
+  vector<TIndex> offsets(batch_size + 1);
+  offsets[0] = 0;
+  std::partial_sum(
+      lengths_data, lengths_data + batch_size, offsets.begin() + 1);
+  ParallelFor(
+      this->IntraOpThreadPool(),
+      batch_size,
+      kBatchSparseToDenseParallelGrain / std::max<TIndex>(dense.dim(1), 1) +
+          1,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const T* row = dense_data + i * dense.dim(1);
+          for (TIndex k = offsets[i]; k < offsets[i + 1]; ++k) {
+            CAFFE_ENFORCE(
+                indices_data[k] < dense.dim(1),
+                "An indice (",
+                indices_data[k],
+                ") is larger then last dim of dense (",
+                dense.dim(1),
+                ").");
+            output_data[k] = row[indices_data[k]];
+          }
+        }
+      });
   return true;
 }
 
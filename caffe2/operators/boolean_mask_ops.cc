@@ -5,6 +5,9 @@
 namespace caffe2 {
 namespace {
 
+// The number of bytes worth a thread handoff
+constexpr TIndex kBooleanMaskParallelGrain = 1 << 16;
+
 template <class Context>
 class BooleanMaskLengthsOp final : public Operator<Context> {
  public:
@@ -54,14 +57,16 @@ bool BooleanMaskOp<CPUContext>::RunOnDevice() {
   CAFFE_ENFORCE_EQ(mask.ndim(), 1);
   CAFFE_ENFORCE(data.dims()[0] == mask.dims()[0]);
 
+  // The output row of each input row is the number of true values before it,
+  // so that chunks of rows are copied independently of each other
   const auto* maskPtr = mask.template data<bool>();
-  int numOutputs = 0;
-  int outerSize = mask.size();
-  for (int i = 0; i < outerSize; ++i) {
-    if (maskPtr[i]) {
-      ++numOutputs;
-    }
+  const TIndex outerSize = mask.size();
+  std::vector<TIndex> outOffsets(outerSize + 1);
+  outOffsets[0] = 0;
+  for (TIndex i = 0; i < outerSize; ++i) {
+    outOffsets[i + 1] = outOffsets[i] + maskPtr[i];
   }
+  const TIndex numOutputs = outOffsets[outerSize];
   std::vector<TIndex> outShape;
   outShape.push_back(numOutputs);
   outShape.insert(outShape.end(), data.dims().begin() + 1, data.dims().end());
@@ -80,33 +85,37 @@ bool BooleanMaskOp<CPUContext>::RunOnDevice() {
   }
   const auto innerSize = data.size_from_dim(1);
   const auto innerSizeBytes = innerSize * data.meta().itemsize();
-
-  TIndex lastStart = -1;
   const auto* inPtr = (char*)data.raw_data();
-  TIndex outStart = 0;
-
-  for (TIndex i = 0;; ++i) {
-    // mask was true and either a) became false, or b) sequence finished
-    if (lastStart != -1 && ((i >= outerSize) || !maskPtr[i])) {
-      const auto* src = inPtr + lastStart * innerSizeBytes;
-      auto* dst = outPtr + outStart * innerSizeBytes;
-      int numItems = i - lastStart;
-      context_.template CopyItems<CPUContext, CPUContext>(
-          data.meta(), numItems * innerSize, src, dst);
-      outStart += numItems;
-      lastStart = -1;
-    }
-    if (i >= outerSize) {
-      break;
-    }
-    // mask was false and became true
-    if (lastStart == -1 && maskPtr[i]) {
-      lastStart = i;
-    }
-    if (maskPtr[i] && OutputSize() == 2) {
-      *(out_vec++) = i;
-    }
-  }
+
+  // Each run of true values is copied at once
+  ParallelFor(
+      IntraOpThreadPool(),
+      outerSize,
+      kBooleanMaskParallelGrain / std::max<TIndex>(innerSizeBytes, 1) + 1,
+      [&](size_t begin, size_t end) {
+        size_t runStart = begin;
+        while (runStart < end) {
+          if (!maskPtr[runStart]) {
+            ++runStart;
+            continue;
+          }
+          size_t runEnd = runStart + 1;
+          while (runEnd < end && maskPtr[runEnd]) {
+            ++runEnd;
+          }
+          context_.template CopyItems<CPUContext, CPUContext>(
+              data.meta(),
+              (runEnd - runStart) * innerSize,
+              inPtr + runStart * innerSizeBytes,
+              outPtr + outOffsets[runStart] * innerSizeBytes);
+          if (out_vec) {
+            for (size_t i = runStart; i < runEnd; ++i) {
+              out_vec[outOffsets[i]] = i;
+            }
+          }
+          runStart = runEnd;
+        }
+      });
   return true;
 }
 
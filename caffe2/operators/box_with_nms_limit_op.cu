@@ -0,0 +1,494 @@
+#include <cfloat>
+
+#include <cub/cub.cuh>
+
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/operators/box_with_nms_limit_op.h"
+#include "caffe2/operators/generate_proposals_op_util_nms_gpu.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Sort key of the boxes below the score threshold, which sorts them after
+// all the others since scores are probabilities.
+constexpr float kFilteredScore = -FLT_MAX;
+
+// The boxes of every (image, class) pair, excluding the background class,
+// form a set of max_boxes entries, set b * (num_classes - 1) + j - 1 holding
+// those of class j of image b. Writes the score of each box as its sort key,
+// or kFilteredScore if it is below the threshold or past the end of the
+// image, and its index within the image as its sort value.
+__global__ void BoxesSortKeysKernel(
+    const int nthreads,
+    const int num_classes,
+    const int max_boxes,
+    const int* image_offsets,
+    const float* scores,
+    const float score_thresh,
+    float* sort_keys,
+    int* sort_values) {
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    const int set = index / max_boxes;
+    const int i = index % max_boxes;
+    const int b = set / (num_classes - 1);
+    const int j = set % (num_classes - 1) + 1;
+    const int start = image_offsets[b];
+    float key = kFilteredScore;
+    if (start + i < image_offsets[b + 1]) {
+      const float score = scores[(start + i) * num_classes + j];
+      if (score > score_thresh) {
+        key = score;
+      }
+    }
+    sort_keys[index] = key;
+    sort_values[index] = i;
+  }
+}
+
+__global__ void SegmentOffsetsKernel(
+    const int nthreads,
+    const int segment_size,
+    int* offsets) {
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    offsets[index] = index * segment_size;
+  }
+}
+
+// Gathers the boxes of every set, sorted by score, for NMS, and counts those
+// above the score threshold.
+__global__ void SelectBoxesKernel(
+    const int nthreads,
+    const int num_classes,
+    const int max_boxes,
+    const int* image_offsets,
+    const float* boxes,
+    const float* sorted_keys,
+    const int* sorted_values,
+    float* nms_boxes,
+    int* nms_num_boxes) {
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    const int set = index / max_boxes;
+    const int i = index % max_boxes;
+    const bool valid = sorted_keys[index] != kFilteredScore;
+    if (valid) {
+      const int b = set / (num_classes - 1);
+      const int j = set % (num_classes - 1) + 1;
+      const int row = image_offsets[b] + sorted_values[index];
+      const float* box = boxes + (row * num_classes + j) * 4;
+      float* nms_box = nms_boxes + index * 4;
+      for (int k = 0; k < 4; ++k) {
+        nms_box[k] = box[k];
+      }
+    }
+    // The valid boxes come first, so their count is the position of the last
+    // one plus one.
+    const bool next_valid =
+        i + 1 < max_boxes && sorted_keys[index + 1] != kFilteredScore;
+    if (valid && !next_valid) {
+      nms_num_boxes[set] = i + 1;
+    } else if (!valid && i == 0) {
+      nms_num_boxes[set] = 0;
+    }
+  }
+}
+
+// Writes the scores of the boxes kept by NMS, so that those of an image can
+// be sorted together to find the score of its detections_per_im-th box.
+__global__ void KeptScoresKernel(
+    const int nthreads,
+    const int max_boxes,
+    const float* sorted_keys,
+    const int* nms_keep,
+    const int* nms_num_keep,
+    float* kept_scores) {
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    const int set = index / max_boxes;
+    const int i = index % max_boxes;
+    kept_scores[index] = i < nms_num_keep[set]
+        ? sorted_keys[set * max_boxes + nms_keep[index]]
+        : kFilteredScore;
+  }
+}
+
+// Counts the boxes of every set that are kept after limiting the detections
+// of each image to detections_per_im over all classes. NMS keeps the boxes in
+// order of decreasing score, so those above the score of the
+// detections_per_im-th box of the image are a prefix of them.
+__global__ void LimitDetectionsKernel(
+    const int nthreads,
+    const int num_classes,
+    const int max_boxes,
+    const int detections_per_im,
+    const float* sorted_image_scores,
+    const float* sorted_keys,
+    const int* nms_keep,
+    const int* nms_num_keep,
+    int* num_out) {
+  CUDA_1D_KERNEL_LOOP(set, nthreads) {
+    const int num_keep = nms_num_keep[set];
+    if (detections_per_im <= 0) {
+      num_out[set] = num_keep;
+      continue;
+    }
+    const int b = set / (num_classes - 1);
+    int image_keep = 0;
+    for (int s = b * (num_classes - 1); s < (b + 1) * (num_classes - 1); ++s) {
+      image_keep += nms_num_keep[s];
+    }
+    if (image_keep <= detections_per_im) {
+      num_out[set] = num_keep;
+      continue;
+    }
+    const float image_thresh = sorted_image_scores
+        [b * (num_classes - 1) * max_boxes + detections_per_im - 1];
+    int count = 0;
+    while (count < num_keep &&
+           sorted_keys[set * max_boxes + nms_keep[set * max_boxes + count]] >=
+               image_thresh) {
+      ++count;
+    }
+    num_out[set] = count;
+  }
+}
+
+__global__ void WriteDetectionsKernel(
+    const int nthreads,
+    const int num_classes,
+    const int max_boxes,
+    const float* sorted_keys,
+    const int* sorted_values,
+    const float* nms_boxes,
+    const int* nms_keep,
+    const int* num_out,
+    const int* out_offsets,
+    float* out_scores,
+    float* out_boxes,
+    float* out_classes,
+    int* out_keeps) {
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    const int set = index / max_boxes;
+    const int i = index % max_boxes;
+    if (i >= num_out[set]) {
+      continue;
+    }
+    const int o = out_offsets[set] + i;
+    const int pos = set * max_boxes + nms_keep[index];
+    out_scores[o] = sorted_keys[pos];
+    for (int k = 0; k < 4; ++k) {
+      out_boxes[o * 4 + k] = nms_boxes[pos * 4 + k];
+    }
+    out_classes[o] = set % (num_classes - 1) + 1;
+    if (out_keeps) {
+      out_keeps[o] = sorted_values[pos];
+    }
+  }
+}
+
+} // namespace
+
+// Applies NMS to the boxes of all classes of all images at once on the
+// device. The copies to the host are those of the batch splits, to lay out
+// the sets of boxes, and of the number of boxes kept per set, to size the
+// outputs.
+template <>
+bool BoxWithNMSLimitOp<CUDAContext>::RunOnDevice() {
+  const auto& tscores = Input(0);
+  const auto& tboxes = Input(1);
+  auto* out_scores = Output(0);
+  auto* out_boxes = Output(1);
+  auto* out_classes = Output(2);
+
+  CAFFE_ENFORCE(!soft_nms_enabled_, "Soft NMS is only supported on the CPU");
+
+  // tscores: (num_boxes, num_classes), 0 for background
+  if (tscores.ndim() == 4) {
+    CAFFE_ENFORCE_EQ(tscores.dim(2), 1, tscores.dim(2));
+    CAFFE_ENFORCE_EQ(tscores.dim(3), 1, tscores.dim(3));
+  } else {
+    CAFFE_ENFORCE_EQ(tscores.ndim(), 2, tscores.ndim());
+  }
+  CAFFE_ENFORCE(tscores.template IsType<float>(), tscores.meta().name());
+  // tboxes: (num_boxes, num_classes * 4)
+  if (tboxes.ndim() == 4) {
+    CAFFE_ENFORCE_EQ(tboxes.dim(2), 1, tboxes.dim(2));
+    CAFFE_ENFORCE_EQ(tboxes.dim(3), 1, tboxes.dim(3));
+  } else {
+    CAFFE_ENFORCE_EQ(tboxes.ndim(), 2, tboxes.ndim());
+  }
+  CAFFE_ENFORCE(tboxes.template IsType<float>(), tboxes.meta().name());
+
+  int N = tscores.dim(0);
+  int num_classes = tscores.dim(1);
+
+  CAFFE_ENFORCE_EQ(N, tboxes.dim(0));
+  CAFFE_ENFORCE_EQ(num_classes * 4, tboxes.dim(1));
+
+  int batch_size = 1;
+  vector<float> batch_splits(1, N);
+  if (InputSize() > 2) {
+    // tscores and tboxes have items from multiple images in a batch. Get the
+    // corresponding batch splits from input.
+    const auto& tbatch_splits = Input(2);
+    CAFFE_ENFORCE_EQ(tbatch_splits.ndim(), 1);
+    batch_size = tbatch_splits.dim(0);
+    batch_splits.resize(batch_size);
+    context_.Copy<float, CUDAContext, CPUContext>(
+        batch_size, tbatch_splits.data<float>(), batch_splits.data());
+  }
+  vector<int> image_offsets(batch_size + 1, 0);
+  int max_boxes = 0;
+  for (int b = 0; b < batch_size; ++b) {
+    const int num_boxes = batch_splits[b];
+    image_offsets[b + 1] = image_offsets[b] + num_boxes;
+    max_boxes = std::max(max_boxes, num_boxes);
+  }
+  CAFFE_ENFORCE_EQ(image_offsets[batch_size], N);
+
+  const int num_sets = batch_size * std::max(num_classes - 1, 0);
+  vector<int> num_out(num_sets, 0);
+  if (num_sets > 0 && max_boxes > 0) {
+    const int total = num_sets * max_boxes;
+    image_offsets_.Resize(batch_size + 1);
+    context_.Copy<int, CPUContext, CUDAContext>(
+        batch_size + 1,
+        image_offsets.data(),
+        image_offsets_.mutable_data<int>());
+    sort_keys_.Resize(total);
+    sort_values_.Resize(total);
+    sorted_keys_.Resize(total);
+    sorted_values_.Resize(total);
+    sort_offsets_.Resize(num_sets + 1);
+
+    BoxesSortKeysKernel<<<
+        CAFFE_GET_BLOCKS(total),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        total,
+        num_classes,
+        max_boxes,
+        image_offsets_.data<int>(),
+        tscores.data<float>(),
+        score_thres_,
+        sort_keys_.mutable_data<float>(),
+        sort_values_.mutable_data<int>());
+    SegmentOffsetsKernel<<<
+        CAFFE_GET_BLOCKS(num_sets + 1),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        num_sets + 1, max_boxes, sort_offsets_.mutable_data<int>());
+
+    // Sort the boxes of each set by score
+    const int* offsets = sort_offsets_.data<int>();
+    size_t sort_bytes = 0;
+    cub::DeviceSegmentedRadixSort::SortPairsDescending(
+        nullptr,
+        sort_bytes,
+        sort_keys_.data<float>(),
+        sorted_keys_.mutable_data<float>(),
+        sort_values_.data<int>(),
+        sorted_values_.mutable_data<int>(),
+        total,
+        num_sets,
+        offsets,
+        offsets + 1,
+        0,
+        sizeof(float) * 8,
+        context_.cuda_stream());
+    sort_scratch_.Resize(sort_bytes);
+    cub::DeviceSegmentedRadixSort::SortPairsDescending(
+        static_cast<void*>(sort_scratch_.mutable_data<uint8_t>()),
+        sort_bytes,
+        sort_keys_.data<float>(),
+        sorted_keys_.mutable_data<float>(),
+        sort_values_.data<int>(),
+        sorted_values_.mutable_data<int>(),
+        total,
+        num_sets,
+        offsets,
+        offsets + 1,
+        0,
+        sizeof(float) * 8,
+        context_.cuda_stream());
+
+    nms_boxes_.Resize(num_sets, max_boxes, 4);
+    nms_num_boxes_.Resize(num_sets);
+    SelectBoxesKernel<<<
+        CAFFE_GET_BLOCKS(total),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        total,
+        num_classes,
+        max_boxes,
+        image_offsets_.data<int>(),
+        tboxes.data<float>(),
+        sorted_keys_.data<float>(),
+        sorted_values_.data<int>(),
+        nms_boxes_.mutable_data<float>(),
+        nms_num_boxes_.mutable_data<int>());
+
+    nms_keep_.Resize(num_sets, max_boxes);
+    nms_num_keep_.Resize(num_sets);
+    utils::nms_gpu_batched(
+        nms_boxes_.data<float>(),
+        nms_num_boxes_.data<int>(),
+        num_sets,
+        max_boxes,
+        nms_thres_,
+        -1,
+        nms_keep_.mutable_data<int>(),
+        nms_num_keep_.mutable_data<int>(),
+        &nms_mask_,
+        &context_);
+
+    // Limit to max_per_image detections *over all classes*
+    const float* sorted_image_scores = nullptr;
+    if (detections_per_im_ > 0) {
+      // the scores to sort replace the sort keys, which are no longer needed
+      KeptScoresKernel<<<
+          CAFFE_GET_BLOCKS(total),
+          CAFFE_CUDA_NUM_THREADS,
+          0,
+          context_.cuda_stream()>>>(
+          total,
+          max_boxes,
+          sorted_keys_.data<float>(),
+          nms_keep_.data<int>(),
+          nms_num_keep_.data<int>(),
+          sort_keys_.mutable_data<float>());
+      image_sort_offsets_.Resize(batch_size + 1);
+      SegmentOffsetsKernel<<<
+          CAFFE_GET_BLOCKS(batch_size + 1),
+          CAFFE_CUDA_NUM_THREADS,
+          0,
+          context_.cuda_stream()>>>(
+          batch_size + 1,
+          (num_classes - 1) * max_boxes,
+          image_sort_offsets_.mutable_data<int>());
+      sorted_image_scores_.Resize(total);
+      const int* image_sort_offsets = image_sort_offsets_.data<int>();
+      size_t image_sort_bytes = 0;
+      cub::DeviceSegmentedRadixSort::SortKeysDescending(
+          nullptr,
+          image_sort_bytes,
+          sort_keys_.data<float>(),
+          sorted_image_scores_.mutable_data<float>(),
+          total,
+          batch_size,
+          image_sort_offsets,
+          image_sort_offsets + 1,
+          0,
+          sizeof(float) * 8,
+          context_.cuda_stream());
+      image_sort_scratch_.Resize(image_sort_bytes);
+      cub::DeviceSegmentedRadixSort::SortKeysDescending(
+          static_cast<void*>(image_sort_scratch_.mutable_data<uint8_t>()),
+          image_sort_bytes,
+          sort_keys_.data<float>(),
+          sorted_image_scores_.mutable_data<float>(),
+          total,
+          batch_size,
+          image_sort_offsets,
+          image_sort_offsets + 1,
+          0,
+          sizeof(float) * 8,
+          context_.cuda_stream());
+      sorted_image_scores = sorted_image_scores_.data<float>();
+    }
+    num_out_.Resize(num_sets);
+    LimitDetectionsKernel<<<
+        CAFFE_GET_BLOCKS(num_sets),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        num_sets,
+        num_classes,
+        max_boxes,
+        detections_per_im_,
+        sorted_image_scores,
+        sorted_keys_.data<float>(),
+        nms_keep_.data<int>(),
+        nms_num_keep_.data<int>(),
+        num_out_.mutable_data<int>());
+
+    context_.Copy<int, CUDAContext, CPUContext>(
+        num_sets, num_out_.data<int>(), num_out.data());
+  }
+
+  // Lay out the outputs of all sets, image by image and class by class
+  vector<int> out_offsets(num_sets);
+  vector<float> total_keep_per_batch(batch_size, 0);
+  vector<int> keeps_size(batch_size * num_classes, 0);
+  int total_keep_count = 0;
+  for (int set = 0; set < num_sets; ++set) {
+    const int b = set / (num_classes - 1);
+    const int j = set % (num_classes - 1) + 1;
+    out_offsets[set] = total_keep_count;
+    total_keep_count += num_out[set];
+    total_keep_per_batch[b] += num_out[set];
+    keeps_size[b * num_classes + j] = num_out[set];
+  }
+
+  out_scores->Resize(total_keep_count);
+  out_boxes->Resize(total_keep_count, 4);
+  out_classes->Resize(total_keep_count);
+  auto* out_scores_data = out_scores->mutable_data<float>();
+  auto* out_boxes_data = out_boxes->mutable_data<float>();
+  auto* out_classes_data = out_classes->mutable_data<float>();
+  int* out_keeps_data = nullptr;
+  if (OutputSize() > 4) {
+    auto* out_keeps = Output(4);
+    auto* out_keeps_size = Output(5);
+    out_keeps->Resize(total_keep_count);
+    out_keeps_data = out_keeps->mutable_data<int>();
+    out_keeps_size->Resize(batch_size, num_classes);
+    context_.Copy<int, CPUContext, CUDAContext>(
+        keeps_size.size(),
+        keeps_size.data(),
+        out_keeps_size->mutable_data<int>());
+  }
+  if (OutputSize() > 3) {
+    auto* batch_splits_out = Output(3);
+    batch_splits_out->Resize(batch_size);
+    context_.Copy<float, CPUContext, CUDAContext>(
+        batch_size,
+        total_keep_per_batch.data(),
+        batch_splits_out->mutable_data<float>());
+  }
+
+  if (total_keep_count > 0) {
+    out_offsets_.Resize(num_sets);
+    context_.Copy<int, CPUContext, CUDAContext>(
+        num_sets, out_offsets.data(), out_offsets_.mutable_data<int>());
+    WriteDetectionsKernel<<<
+        CAFFE_GET_BLOCKS(num_sets * max_boxes),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        num_sets * max_boxes,
+        num_classes,
+        max_boxes,
+        sorted_keys_.data<float>(),
+        sorted_values_.data<int>(),
+        nms_boxes_.data<float>(),
+        nms_keep_.data<int>(),
+        num_out_.data<int>(),
+        out_offsets_.data<int>(),
+        out_scores_data,
+        out_boxes_data,
+        out_classes_data,
+        out_keeps_data);
+  }
+
+  return true;
+}
+
+namespace {
+
+REGISTER_CUDA_OPERATOR(BoxWithNMSLimit, BoxWithNMSLimitOp<CUDAContext>);
+
+} // namespace
+} // namespace caffe2
@@ -56,6 +56,25 @@ class BoxWithNMSLimitOp final : public Operator<Context> {
   float soft_nms_sigma_ = 0.5;
   // Lower-bound on updated scores to discard boxes
   float soft_nms_min_score_thres_ = 0.001;
+
+  // Scratch space of the CUDA implementation
+  Tensor<Context> sort_keys_;
+  Tensor<Context> sort_values_;
+  Tensor<Context> sorted_keys_;
+  Tensor<Context> sorted_values_;
+  Tensor<Context> sort_offsets_;
+  Tensor<Context> sort_scratch_;
+  Tensor<Context> nms_boxes_;
+  Tensor<Context> nms_num_boxes_;
+  Tensor<Context> nms_mask_;
+  Tensor<Context> nms_keep_;
+  Tensor<Context> nms_num_keep_;
+  Tensor<Context> image_offsets_;
+  Tensor<Context> image_sort_offsets_;
+  Tensor<Context> image_sort_scratch_;
+  Tensor<Context> sorted_image_scores_;
+  Tensor<Context> num_out_;
+  Tensor<Context> out_offsets_;
 };
 
 } // namespace caffe2
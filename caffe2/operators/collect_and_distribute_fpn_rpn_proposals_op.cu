@@ -0,0 +1,253 @@
+#include <cub/cub.cuh>
+
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/operators/collect_and_distribute_fpn_rpn_proposals_op.h"
+
+namespace caffe2 {
+
+namespace {
+
+__global__ void IotaKernel(const int nthreads, int* values) {
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    values[index] = index;
+  }
+}
+
+// Gathers the top scoring RoIs and maps each of them to its FPN level, see
+// utils::MapRoIsToFpnLevels(). Also counts the RoIs of each level.
+__global__ void MapRoIsToFpnLevelsKernel(
+    const int nthreads,
+    const float* rois,
+    const int* sorted_values,
+    const int lvl_min,
+    const int lvl_max,
+    const float s0,
+    const float lvl0,
+    float* rois_out,
+    int* lvls,
+    int* lvl_values,
+    int* lvl_counts) {
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    const float* roi = rois + sorted_values[index] * 5;
+    float* roi_out = rois_out + index * 5;
+    for (int k = 0; k < 5; ++k) {
+      roi_out[k] = roi[k];
+    }
+    const float w = roi[3] - roi[1] + 1;
+    const float h = roi[4] - roi[2] + 1;
+    const float s = sqrtf(w * h);
+    float lvl = floorf(lvl0 + logf(s / s0 + 1e-6f) / logf(2.0f));
+    lvl = fmaxf(fminf(lvl, lvl_max), lvl_min);
+    const int lvl_index = static_cast<int>(lvl) - lvl_min;
+    lvls[index] = lvl_index;
+    lvl_values[index] = index;
+    atomicAdd(lvl_counts + lvl_index, 1);
+  }
+}
+
+__global__ void GatherRoIsKernel(
+    const int nthreads,
+    const float* rois,
+    const int* order,
+    float* rois_out) {
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    const float* roi = rois + order[index] * 5;
+    for (int k = 0; k < 5; ++k) {
+      rois_out[index * 5 + k] = roi[k];
+    }
+  }
+}
+
+__global__ void InversePermutationKernel(
+    const int nthreads,
+    const int* order,
+    int* restore) {
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    restore[order[index]] = index;
+  }
+}
+
+} // namespace
+
+// Sorts the RoIs by score with a radix sort and groups them by level with a
+// stable one, so that the RoIs of a level keep their order as on the CPU. The
+// only copy to the host is that of the number of RoIs of each level, which
+// is needed to size the outputs.
+template <>
+bool CollectAndDistributeFpnRpnProposalsOp<CUDAContext>::RunOnDevice() {
+  int num_rpn_lvls = rpn_max_level_ - rpn_min_level_ + 1;
+  CAFFE_ENFORCE_EQ(InputSize(), 2 * num_rpn_lvls);
+
+  // roi_in: (N, 5)
+  const auto& first_roi_in = Input(0);
+  const auto N = first_roi_in.dim(0);
+  CAFFE_ENFORCE_EQ(first_roi_in.dims(), (vector<TIndex>{N, 5}));
+
+  int num_roi_lvls = roi_max_level_ - roi_min_level_ + 1;
+  CAFFE_ENFORCE_EQ(OutputSize(), num_roi_lvls + 2);
+
+  // Collect rois and scores of all levels
+  const int total = N * num_rpn_lvls;
+  rois_.Resize(total, 5);
+  scores_.Resize(total);
+  for (int i = 0; i < num_rpn_lvls; i++) {
+    const auto& roi_in = Input(i);
+    CAFFE_ENFORCE_EQ(roi_in.dims(), (vector<TIndex>{N, 5}));
+    context_.Copy<float, CUDAContext, CUDAContext>(
+        N * 5,
+        roi_in.data<float>(),
+        rois_.mutable_data<float>() + i * N * 5);
+
+    const auto& score_in = Input(num_rpn_lvls + i);
+    CAFFE_ENFORCE_EQ(score_in.dims(), (vector<TIndex>{N}));
+    context_.Copy<float, CUDAContext, CUDAContext>(
+        N, score_in.data<float>(), scores_.mutable_data<float>() + i * N);
+  }
+
+  auto* rois_out = Output(0);
+  auto* rois_idx_restore_out = Output(OutputSize() - 1);
+  if (total == 0) {
+    rois_out->Resize(0, 5);
+    rois_out->mutable_data<float>();
+    for (int i = 0; i < num_roi_lvls; i++) {
+      Output(i + 1)->Resize(0, 5);
+      Output(i + 1)->mutable_data<float>();
+    }
+    rois_idx_restore_out->Resize(0);
+    rois_idx_restore_out->mutable_data<int>();
+    return true;
+  }
+
+  // Grab only top rpn_post_nms_topN rois
+  sort_values_.Resize(total);
+  sorted_scores_.Resize(total);
+  sorted_values_.Resize(total);
+  IotaKernel<<<
+      CAFFE_GET_BLOCKS(total),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context_.cuda_stream()>>>(total, sort_values_.mutable_data<int>());
+  size_t sort_bytes = 0;
+  cub::DeviceRadixSort::SortPairsDescending(
+      nullptr,
+      sort_bytes,
+      scores_.data<float>(),
+      sorted_scores_.mutable_data<float>(),
+      sort_values_.data<int>(),
+      sorted_values_.mutable_data<int>(),
+      total,
+      0,
+      sizeof(float) * 8,
+      context_.cuda_stream());
+  sort_scratch_.Resize(sort_bytes);
+  cub::DeviceRadixSort::SortPairsDescending(
+      static_cast<void*>(sort_scratch_.mutable_data<uint8_t>()),
+      sort_bytes,
+      scores_.data<float>(),
+      sorted_scores_.mutable_data<float>(),
+      sort_values_.data<int>(),
+      sorted_values_.mutable_data<int>(),
+      total,
+      0,
+      sizeof(float) * 8,
+      context_.cuda_stream());
+  const int n = (rpn_post_nms_topN_ > 0 && rpn_post_nms_topN_ < total)
+      ? rpn_post_nms_topN_
+      : total;
+
+  // Distribute
+  rois_out->Resize(n, 5);
+  lvls_.Resize(n);
+  sorted_lvls_.Resize(n);
+  lvl_order_.Resize(n);
+  lvl_counts_.Resize(num_roi_lvls);
+  math::Set<int, CUDAContext>(
+      num_roi_lvls, 0, lvl_counts_.mutable_data<int>(), &context_);
+  // the values to sort by level replace those sorted by score, which are no
+  // longer needed
+  MapRoIsToFpnLevelsKernel<<<
+      CAFFE_GET_BLOCKS(n),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context_.cuda_stream()>>>(
+      n,
+      rois_.data<float>(),
+      sorted_values_.data<int>(),
+      roi_min_level_,
+      roi_max_level_,
+      roi_canonical_scale_,
+      roi_canonical_level_,
+      rois_out->mutable_data<float>(),
+      lvls_.mutable_data<int>(),
+      sort_values_.mutable_data<int>(),
+      lvl_counts_.mutable_data<int>());
+  size_t lvl_sort_bytes = 0;
+  cub::DeviceRadixSort::SortPairs(
+      nullptr,
+      lvl_sort_bytes,
+      lvls_.data<int>(),
+      sorted_lvls_.mutable_data<int>(),
+      sort_values_.data<int>(),
+      lvl_order_.mutable_data<int>(),
+      n,
+      0,
+      sizeof(int) * 8,
+      context_.cuda_stream());
+  lvl_sort_scratch_.Resize(lvl_sort_bytes);
+  cub::DeviceRadixSort::SortPairs(
+      static_cast<void*>(lvl_sort_scratch_.mutable_data<uint8_t>()),
+      lvl_sort_bytes,
+      lvls_.data<int>(),
+      sorted_lvls_.mutable_data<int>(),
+      sort_values_.data<int>(),
+      lvl_order_.mutable_data<int>(),
+      n,
+      0,
+      sizeof(int) * 8,
+      context_.cuda_stream());
+
+  // The RoIs sorted by level are those of all levels concatenated, so the
+  // inverse of this order restores the original one.
+  rois_idx_restore_out->Resize(n);
+  InversePermutationKernel<<<
+      CAFFE_GET_BLOCKS(n),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context_.cuda_stream()>>>(
+      n,
+      lvl_order_.data<int>(),
+      rois_idx_restore_out->mutable_data<int>());
+
+  std::vector<int> lvl_counts(num_roi_lvls);
+  context_.Copy<int, CUDAContext, CPUContext>(
+      num_roi_lvls, lvl_counts_.data<int>(), lvl_counts.data());
+  int lvl_start = 0;
+  for (int i = 0; i < num_roi_lvls; i++) {
+    auto* roi_out = Output(i + 1);
+    roi_out->Resize(lvl_counts[i], 5);
+    auto* roi_out_data = roi_out->mutable_data<float>();
+    if (lvl_counts[i] > 0) {
+      GatherRoIsKernel<<<
+          CAFFE_GET_BLOCKS(lvl_counts[i]),
+          CAFFE_CUDA_NUM_THREADS,
+          0,
+          context_.cuda_stream()>>>(
+          lvl_counts[i],
+          rois_out->data<float>(),
+          lvl_order_.data<int>() + lvl_start,
+          roi_out_data);
+    }
+    lvl_start += lvl_counts[i];
+  }
+
+  return true;
+}
+
+namespace {
+
+REGISTER_CUDA_OPERATOR(
+    CollectAndDistributeFpnRpnProposals,
+    CollectAndDistributeFpnRpnProposalsOp<CUDAContext>);
+
+} // namespace
+} // namespace caffe2
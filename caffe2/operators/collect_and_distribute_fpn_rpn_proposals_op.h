@@ -95,6 +95,19 @@ class CollectAndDistributeFpnRpnProposalsOp final : public Operator<Context> {
   int rpn_min_level_{2};
   // RPN_POST_NMS_TOP_N
   int rpn_post_nms_topN_{2000};
+
+  // Scratch space of the CUDA implementation
+  Tensor<Context> rois_;
+  Tensor<Context> scores_;
+  Tensor<Context> sort_values_;
+  Tensor<Context> sorted_scores_;
+  Tensor<Context> sorted_values_;
+  Tensor<Context> sort_scratch_;
+  Tensor<Context> lvls_;
+  Tensor<Context> sorted_lvls_;
+  Tensor<Context> lvl_order_;
+  Tensor<Context> lvl_sort_scratch_;
+  Tensor<Context> lvl_counts_;
 };
 
 } // namespace caffe2
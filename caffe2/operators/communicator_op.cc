@@ -74,6 +74,56 @@ Does an allreduce operation among the nodes. Currently only Sum is supported.
     .Input(1, "X", "A tensor to be allreduced.")
     .Output(0, "Y", "The allreduced tensor, same on all nodes.");
 
+OPERATOR_SCHEMA(AllreduceAsync)
+    .NumInputsOutputs([](int in, int out) {
+      return in >= 2 && out == in;
+    })
+    .EnforceInplace([](int in, int out) { return (in - 1) == out; })
+    .InputsCanCrossDevices()
+    .SetDoc(R"DOC(
+Starts an allreduce operation among the nodes like Allreduce, but returns
+without waiting for it to finish, so that the operators after it run while
+it communicates. The tensors must not be read or written until the handle
+output is passed to Wait.
+)DOC")
+    .Input(0, "comm_world", "The common world.")
+    .Input(1, "X", "A tensor to be allreduced.")
+    .Output(0, "Y", "The allreduced tensor, same on all nodes after Wait.")
+    .Output(1, "handle", "The handle to wait for, after the tensors.");
+
+OPERATOR_SCHEMA(BroadcastAsync)
+    .NumInputsOutputs([](int in, int out) {
+      return in >= 2 && out == in;
+    })
+    .EnforceInplace([](int in, int out) { return (in - 1) == out; })
+    .InputsCanCrossDevices()
+    .SetDoc(R"DOC(
+Starts a broadcast operation like Broadcast, but returns without waiting for
+it to finish, so that the operators after it run while it communicates. The
+tensors must not be read or written until the handle output is passed to
+Wait.
+)DOC")
+    .Input(0, "comm_world", "The common world.")
+    .Input(1, "X", "A tensor to be broadcasted.")
+    .Output(0, "X", "In-place as input 1, broadcasted after Wait.")
+    .Output(1, "handle", "The handle to wait for, after the tensors.")
+    .Arg("root", "(int, default 0) the root to run broadcast from.");
+
+OPERATOR_SCHEMA(Wait)
+    .NumInputsOutputs([](int in, int out) {
+      return in >= 1 && out == (in - 1);
+    })
+    .EnforceInplace([](int in, int out) { return (in - 1) == out; })
+    .InputsCanCrossDevices()
+    .SetDoc(R"DOC(
+Waits for a collective started by AllreduceAsync or BroadcastAsync to finish
+and rethrows its error. The tensors of the collective may be passed through in
+place, so that the operators that read them depend on this one.
+)DOC")
+    .Input(0, "handle", "The handle of the collective.")
+    .Input(1, "X", "A tensor of the collective (optional).")
+    .Output(0, "X", "In-place as input 1.");
+
 OPERATOR_SCHEMA(ReduceScatter)
     .NumInputsOutputs([](int in, int out) {
       return in >= 2 && out == (in - 1);
@@ -182,6 +232,9 @@ SHOULD_NOT_DO_GRADIENT(Broadcast);
 SHOULD_NOT_DO_GRADIENT(Reduce);
 SHOULD_NOT_DO_GRADIENT(Allgather);
 SHOULD_NOT_DO_GRADIENT(Allreduce);
+SHOULD_NOT_DO_GRADIENT(AllreduceAsync);
+SHOULD_NOT_DO_GRADIENT(BroadcastAsync);
+SHOULD_NOT_DO_GRADIENT(Wait);
 SHOULD_NOT_DO_GRADIENT(ReduceScatter);
 SHOULD_NOT_DO_GRADIENT(Barrier);
 SHOULD_NOT_DO_GRADIENT(SendTensor);
@@ -195,6 +248,9 @@ REGISTER_CPU_OPERATOR(Broadcast, NoDefaultEngineOp<CPUContext>);
 REGISTER_CPU_OPERATOR(Reduce, NoDefaultEngineOp<CPUContext>);
 REGISTER_CPU_OPERATOR(Allgather, NoDefaultEngineOp<CPUContext>);
 REGISTER_CPU_OPERATOR(Allreduce, NoDefaultEngineOp<CPUContext>);
+REGISTER_CPU_OPERATOR(AllreduceAsync, NoDefaultEngineOp<CPUContext>);
+REGISTER_CPU_OPERATOR(BroadcastAsync, NoDefaultEngineOp<CPUContext>);
+REGISTER_CPU_OPERATOR(Wait, NoDefaultEngineOp<CPUContext>);
 REGISTER_CPU_OPERATOR(ReduceScatter, NoDefaultEngineOp<CPUContext>);
 REGISTER_CPU_OPERATOR(Barrier, NoDefaultEngineOp<CPUContext>);
 REGISTER_CPU_OPERATOR(SendTensor, NoDefaultEngineOp<CPUContext>);
@@ -10,6 +10,9 @@ REGISTER_CUDA_OPERATOR(Broadcast, NoDefaultEngineOp<CUDAContext>);
 REGISTER_CUDA_OPERATOR(Reduce, NoDefaultEngineOp<CUDAContext>);
 REGISTER_CUDA_OPERATOR(Allgather, NoDefaultEngineOp<CUDAContext>);
 REGISTER_CUDA_OPERATOR(Allreduce, NoDefaultEngineOp<CUDAContext>);
+REGISTER_CUDA_OPERATOR(AllreduceAsync, NoDefaultEngineOp<CUDAContext>);
+REGISTER_CUDA_OPERATOR(BroadcastAsync, NoDefaultEngineOp<CUDAContext>);
+REGISTER_CUDA_OPERATOR(Wait, NoDefaultEngineOp<CUDAContext>);
 REGISTER_CUDA_OPERATOR(SendTensor, NoDefaultEngineOp<CUDAContext>);
 REGISTER_CUDA_OPERATOR(ReceiveTensor, NoDefaultEngineOp<CUDAContext>);
 
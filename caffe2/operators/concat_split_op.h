@@ -151,17 +151,24 @@ bool SplitOp<Context>::RunOnDevice() {
       output_dims[canonical_axis] = axis_data[i];
     }
     output->Resize(output_dims);
+    const char* src = static_cast<const char*>(input.raw_data()) + input_offset;
+    void* dst = output->raw_mutable_data(input.meta());
+    input_offset += axis_dim * after * input.itemsize();
+    // The output may already be this slice of the input, see
+    // memonger::plan_inference_net_memory
+    if (before == 1 && dst == src) {
+      continue;
+    }
     math::CopyMatrix<Context>(
         input.itemsize(),
         before,
         axis_dim * after,
-        static_cast<const char*>(input.raw_data()) + input_offset,
+        src,
         input.dim32(canonical_axis) * after,
-        output->raw_mutable_data(input.meta()),
+        dst,
         axis_dim * after,
         &context_,
         input.meta().copy());
-    input_offset += axis_dim * after * input.itemsize();
   }
   return true;
 }
@@ -238,18 +245,25 @@ bool ConcatOp<Context>::RunOnDevice() {
   for (int i = 0; i < InputSize(); ++i) {
     auto& input = Input(i);
     auto axis_dim = add_axis_ ? 1 : input.dim32(canonical_axis);
+    char* dst =
+        static_cast<char*>(output->raw_mutable_data(input_zero.meta())) +
+        output_offset;
+    output_offset += axis_dim * after * input.itemsize();
+    // The input may already be this slice of the output, see
+    // memonger::plan_inference_net_memory
+    if (before == 1 && input.raw_data() == dst) {
+      continue;
+    }
     math::CopyMatrix<Context>(
         input.itemsize(),
         before,
         axis_dim * after,
         input.raw_data(),
         axis_dim * after,
-        static_cast<char*>(output->raw_mutable_data(input_zero.meta())) +
-            output_offset,
+        dst,
         output_channels * after,
         &context_,
         input_zero.meta().copy());
-    output_offset += axis_dim * after * input.itemsize();
   }
   return true;
 }
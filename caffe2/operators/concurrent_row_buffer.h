@@ -0,0 +1,81 @@
+#ifndef CAFFE2_OPERATORS_CONCURRENT_ROW_BUFFER_H_
+#define CAFFE2_OPERATORS_CONCURRENT_ROW_BUFFER_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "caffe2/core/logging.h"
+#include "caffe2/core/tensor.h"
+
+namespace caffe2 {
+
+// A fixed number of rows of the same type and dims that many threads write
+// and read at the same time, e.g. a replay buffer fed by several net
+// instances. There is no lock shared by all the threads: writers reserve
+// positions in the stream of rows with an atomic counter and only contend
+// when they write the same slots.
+//
+// Every slot has a version, odd while the slot is being written and 0 while
+// it was never written. Writers take the slots of a range in ascending order
+// by making their versions odd and copy the whole range with one memcpy;
+// readers copy without taking anything and keep the rows whose version did
+// not change meanwhile, so that they never see a torn row.
+//
+// The type and dims of the rows are set by the first write. Only types that
+// can be copied with memcpy are supported.
+class ConcurrentRowBuffer {
+ public:
+  explicit ConcurrentRowBuffer(TIndex capacity);
+
+  TIndex capacity() const {
+    return capacity_;
+  }
+
+  // Sets the type and the dims of the rows to the ones of `data` on the first
+  // call, and checks that they match afterwards
+  void initialize(const TensorCPU& data);
+
+  bool initialized() const {
+    return initialized_.load(std::memory_order_acquire);
+  }
+
+  // Reserves `n` consecutive positions in the stream of rows written to the
+  // buffer and returns the first one
+  int64_t reserve(int64_t n) {
+    return numReserved_.fetch_add(n);
+  }
+
+  // Number of rows reserved so far
+  int64_t numReserved() const {
+    return numReserved_.load();
+  }
+
+  // Writes `n` rows from `src` to the slots [slot, slot + n), which must not
+  // wrap around the end of the buffer
+  void write(TIndex slot, TIndex n, const char* src);
+
+  // Copies the rows that are not being written to `output`, in slot order.
+  // Slots that were never written are skipped.
+  void read(TensorCPU* output) const;
+
+ private:
+  // Copies the row in `slot` to `dst` once no writer holds it, returns false
+  // if the slot was never written
+  bool readRow(TIndex slot, char* dst) const;
+
+  const TIndex capacity_;
+  std::once_flag initializeOnce_;
+  std::atomic<bool> initialized_{false};
+  TypeMeta meta_;
+  std::vector<TIndex> rowDims_;
+  size_t rowBytes_ = 0;
+  std::vector<char> data_;
+  std::unique_ptr<std::atomic<uint64_t>[]> versions_;
+  std::atomic<int64_t> numReserved_{0};
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_CONCURRENT_ROW_BUFFER_H_
@@ -0,0 +1,332 @@
+#include "caffe2/operators/concurrent_row_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <thread>
+
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+ConcurrentRowBuffer::ConcurrentRowBuffer(TIndex capacity)
+    : capacity_(capacity),
+      versions_(new std::atomic<uint64_t>[capacity]()) {
+  CAFFE_ENFORCE_GT(capacity_, 0);
+}
+
+void ConcurrentRowBuffer::initialize(const TensorCPU& data) {
+  CAFFE_ENFORCE_GE(data.ndim(), 1);
+  std::call_once(initializeOnce_, [&]() {
+    CAFFE_ENFORCE(
+        !data.meta().copy(),
+        "Rows of type ",
+        data.meta().name(),
+        " can't be copied with memcpy");
+    meta_ = data.meta();
+    rowDims_.assign(data.dims().begin() + 1, data.dims().end());
+    rowBytes_ = data.size_from_dim(1) * data.itemsize();
+    data_.resize(capacity_ * rowBytes_);
+    initialized_.store(true, std::memory_order_release);
+  });
+  CAFFE_ENFORCE(
+      data.meta() == meta_,
+      "Expected rows of type ",
+      meta_.name(),
+      ", got ",
+      data.meta().name());
+  CAFFE_ENFORCE_EQ(data.ndim(), static_cast<int>(rowDims_.size()) + 1);
+  for (size_t i = 0; i < rowDims_.size(); ++i) {
+    CAFFE_ENFORCE_EQ(data.dim(i + 1), rowDims_[i]);
+  }
+}
+
+void ConcurrentRowBuffer::write(TIndex slot, TIndex n, const char* src) {
+  CAFFE_ENFORCE(initialized());
+  if (n == 0) {
+    return;
+  }
+  CAFFE_ENFORCE(slot >= 0 && n > 0 && slot + n <= capacity_);
+  // Ascending order, so that writers of overlapping ranges can't deadlock
+  for (TIndex i = slot; i < slot + n; ++i) {
+    auto& version = versions_[i];
+    while (true) {
+      auto current = version.load(std::memory_order_relaxed);
+      if (current % 2 == 0 &&
+          version.compare_exchange_weak(
+              current, current + 1, std::memory_order_acquire)) {
+        break;
+      }
+      std::this_thread::yield();
+    }
+  }
+  // Orders the copy after the versions are odd, for the readers
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(data_.data() + slot * rowBytes_, src, n * rowBytes_);
+  for (TIndex i = slot; i < slot + n; ++i) {
+    versions_[i].fetch_add(1, std::memory_order_release);
+  }
+}
+
+bool ConcurrentRowBuffer::readRow(TIndex slot, char* dst) const {
+  const auto& version = versions_[slot];
+  while (true) {
+    auto before = version.load(std::memory_order_acquire);
+    if (before == 0) {
+      return false;
+    }
+    if (before % 2 == 0) {
+      std::memcpy(dst, data_.data() + slot * rowBytes_, rowBytes_);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (version.load(std::memory_order_relaxed) == before) {
+        return true;
+      }
+    }
+    std::this_thread::yield();
+  }
+}
+
+void ConcurrentRowBuffer::read(TensorCPU* output) const {
+  CAFFE_ENFORCE(initialized(), "Nothing has been written to the buffer yet");
+  std::vector<TIndex> dims(1, capacity_);
+  dims.insert(dims.end(), rowDims_.begin(), rowDims_.end());
+  output->Resize(dims);
+  auto* dst = static_cast<char*>(output->raw_mutable_data(meta_));
+
+  // Copy everything at once, then fix up the rows that were written meanwhile
+  std::vector<uint64_t> before(capacity_);
+  for (TIndex i = 0; i < capacity_; ++i) {
+    before[i] = versions_[i].load(std::memory_order_acquire);
+  }
+  std::memcpy(dst, data_.data(), capacity_ * rowBytes_);
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  TIndex numRows = 0;
+  for (TIndex i = 0; i < capacity_; ++i) {
+    auto* row = dst + numRows * rowBytes_;
+    bool intact = before[i] != 0 && before[i] % 2 == 0 &&
+        versions_[i].load(std::memory_order_relaxed) == before[i];
+    if (intact) {
+      if (numRows != i) {
+        std::memmove(row, dst + i * rowBytes_, rowBytes_);
+      }
+    } else if (before[i] == 0 || !readRow(i, row)) {
+      continue;
+    }
+    ++numRows;
+  }
+  output->Shrink(numRows);
+}
+
+CAFFE_KNOWN_TYPE(std::unique_ptr<ConcurrentRowBuffer>);
+
+namespace {
+
+using ConcurrentRowBufferPtr = std::unique_ptr<ConcurrentRowBuffer>;
+
+class CreateConcurrentRowBufferOp final : public Operator<CPUContext> {
+ public:
+  CreateConcurrentRowBufferOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        numToCollect_(
+            OperatorBase::GetSingleArgument<int64_t>("num_to_collect", -1)) {
+    CAFFE_ENFORCE_GT(numToCollect_, 0);
+  }
+
+  bool RunOnDevice() override {
+    *OperatorBase::Output<ConcurrentRowBufferPtr>(0) =
+        ConcurrentRowBufferPtr(new ConcurrentRowBuffer(numToCollect_));
+    return true;
+  }
+
+ private:
+  const int64_t numToCollect_;
+};
+
+class ConcurrentLastNWindowCollectorOp final : public Operator<CPUContext> {
+ public:
+  ConcurrentLastNWindowCollectorOp(
+      const OperatorDef& operator_def,
+      Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    auto& buffer = OperatorBase::Input<ConcurrentRowBufferPtr>(BUFFER);
+    CAFFE_ENFORCE(buffer);
+    const auto& input = Input(DATA);
+    buffer->initialize(input);
+
+    auto numEntries = input.dim(0);
+    if (numEntries == 0) {
+      return true;
+    }
+    auto first = buffer->reserve(numEntries);
+    // Only the last rows of the batch survive it
+    auto capacity = buffer->capacity();
+    auto numToCopy = std::min<int64_t>(numEntries, capacity);
+    auto skipped = numEntries - numToCopy;
+    auto rowBytes = input.size_from_dim(1) * input.itemsize();
+    const auto* src =
+        static_cast<const char*>(input.raw_data()) + skipped * rowBytes;
+
+    auto slot = (first + skipped) % capacity;
+    auto firstChunk = std::min<int64_t>(numToCopy, capacity - slot);
+    buffer->write(slot, firstChunk, src);
+    buffer->write(0, numToCopy - firstChunk, src + firstChunk * rowBytes);
+    return true;
+  }
+
+ private:
+  INPUT_TAGS(BUFFER, DATA);
+};
+
+class ConcurrentReservoirSamplingOp final : public Operator<CPUContext> {
+ public:
+  ConcurrentReservoirSamplingOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    auto& buffer = OperatorBase::Input<ConcurrentRowBufferPtr>(BUFFER);
+    CAFFE_ENFORCE(buffer);
+    const auto& input = Input(DATA);
+    buffer->initialize(input);
+
+    auto numEntries = input.dim(0);
+    if (numEntries == 0) {
+      return true;
+    }
+    auto first = buffer->reserve(numEntries);
+    auto capacity = buffer->capacity();
+    auto rowBytes = input.size_from_dim(1) * input.itemsize();
+    const auto* src = static_cast<const char*>(input.raw_data());
+
+    // The rows that fit before the buffer is full are appended in one go
+    int64_t numAppended =
+        std::max<int64_t>(0, std::min<int64_t>(numEntries, capacity - first));
+    buffer->write(first, numAppended, src);
+
+    // The i-th row seen replaces a random slot with probability
+    // capacity / (i + 1). Draw the slots of the whole batch first; when
+    // several rows land on the same slot only the last one is written.
+    slotRows_.clear();
+    auto& gen = context_.RandGenerator();
+    for (int64_t i = numAppended; i < numEntries; ++i) {
+      std::uniform_int_distribution<int64_t> uniformDist(0, first + i);
+      auto pos = uniformDist(gen);
+      if (pos < capacity) {
+        slotRows_.emplace_back(pos, i);
+      }
+    }
+    std::stable_sort(
+        slotRows_.begin(),
+        slotRows_.end(),
+        [](const std::pair<int64_t, int64_t>& a,
+           const std::pair<int64_t, int64_t>& b) { return a.first < b.first; });
+    for (size_t j = 0; j < slotRows_.size(); ++j) {
+      if (j + 1 < slotRows_.size() &&
+          slotRows_[j + 1].first == slotRows_[j].first) {
+        continue;
+      }
+      buffer->write(slotRows_[j].first, 1, src + slotRows_[j].second * rowBytes);
+    }
+    return true;
+  }
+
+ private:
+  // (slot, row of the batch)
+  std::vector<std::pair<int64_t, int64_t>> slotRows_;
+
+  INPUT_TAGS(BUFFER, DATA);
+};
+
+class ReadConcurrentRowBufferOp final : public Operator<CPUContext> {
+ public:
+  ReadConcurrentRowBufferOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    auto& buffer = OperatorBase::Input<ConcurrentRowBufferPtr>(0);
+    CAFFE_ENFORCE(buffer);
+    if (OutputSize() > NUM_VISITED) {
+      auto* numVisited = Output(NUM_VISITED);
+      numVisited->Resize();
+      *numVisited->template mutable_data<int64_t>() = buffer->numReserved();
+    }
+    buffer->read(Output(DATA));
+    return true;
+  }
+
+ private:
+  OUTPUT_TAGS(DATA, NUM_VISITED);
+};
+
+REGISTER_CPU_OPERATOR(CreateConcurrentRowBuffer, CreateConcurrentRowBufferOp);
+REGISTER_CPU_OPERATOR(
+    ConcurrentLastNWindowCollector,
+    ConcurrentLastNWindowCollectorOp);
+REGISTER_CPU_OPERATOR(
+    ConcurrentReservoirSampling,
+    ConcurrentReservoirSamplingOp);
+REGISTER_CPU_OPERATOR(ReadConcurrentRowBuffer, ReadConcurrentRowBufferOp);
+
+OPERATOR_SCHEMA(CreateConcurrentRowBuffer)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Creates a buffer of `num_to_collect` rows that ConcurrentLastNWindowCollector
+and ConcurrentReservoirSampling ops of many nets can write to, and
+ReadConcurrentRowBuffer read from, at the same time and without a mutex.
+The type and the shape of the rows are taken from the first rows written.
+)DOC")
+    .Arg("num_to_collect", "The number of rows the buffer holds")
+    .Output(0, "buffer", "The buffer");
+
+OPERATOR_SCHEMA(ConcurrentLastNWindowCollector)
+    .NumInputs(2)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Like LastNWindowCollector, keeps the last N rows of the input data, but in a
+buffer created by CreateConcurrentRowBuffer that any number of ops can write
+to concurrently. Each op reserves the positions of its rows with an atomic
+counter and copies them into the buffer in at most two contiguous ranges.
+
+The buffer should be large compared to the rows written at the same time: a
+writer may overwrite rows of a later batch if other writers wrap around the
+whole buffer while it copies.
+)DOC")
+    .Input(0, "buffer", "Buffer created by CreateConcurrentRowBuffer")
+    .Input(1, "DATA", "Tensor to collect from");
+
+OPERATOR_SCHEMA(ConcurrentReservoirSampling)
+    .NumInputs(2)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Like ReservoirSampling, keeps a uniform random sample of N of the rows seen,
+but in a buffer created by CreateConcurrentRowBuffer that any number of ops
+can write to concurrently. The positions of the rows in the stream are
+reserved with an atomic counter, and the slots the rows of a batch replace
+are drawn before any of them is written, so that each slot is written at most
+once per batch. Does not support deduplication by object ID.
+)DOC")
+    .Input(0, "buffer", "Buffer created by CreateConcurrentRowBuffer")
+    .Input(1, "DATA", "Tensor to sample from");
+
+OPERATOR_SCHEMA(ReadConcurrentRowBuffer)
+    .NumInputs(1)
+    .NumOutputs(1, 2)
+    .SetDoc(R"DOC(
+Copies the rows of a buffer created by CreateConcurrentRowBuffer. Rows that
+are being written while they are read are read again once the writer is done,
+so that no row is torn. Fails if nothing was written to the buffer yet.
+)DOC")
+    .Input(0, "buffer", "Buffer created by CreateConcurrentRowBuffer")
+    .Output(0, "DATA", "The rows written to the buffer, at most N")
+    .Output(1, "NUM_VISITED", "(optional) number of rows seen so far");
+
+SHOULD_NOT_DO_GRADIENT(CreateConcurrentRowBuffer);
+SHOULD_NOT_DO_GRADIENT(ConcurrentLastNWindowCollector);
+SHOULD_NOT_DO_GRADIENT(ConcurrentReservoirSampling);
+SHOULD_NOT_DO_GRADIENT(ReadConcurrentRowBuffer);
+
+} // namespace
+} // namespace caffe2
@@ -0,0 +1,178 @@
+#include <algorithm>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Conv followed by Relu, or by Add of another tensor and Relu, in the 2D NCHW
+// im2col path of ConvOp. The bias, the sum and the Relu are applied to the
+// output of each image right after its GEMMs, while it is still in cache,
+// instead of as full passes over the activations.
+template <bool kSum>
+class ConvFusedOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  ConvFusedOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws) {
+    CAFFE_ENFORCE(
+        order_ == StorageOrder::NCHW,
+        "Fused convolutions only support NCHW order right now.");
+    CAFFE_ENFORCE_EQ(
+        kernel_.size(), 2, "Fused convolutions only support 2D kernels.");
+  }
+
+  bool RunOnDeviceWithOrderNCHW() override {
+    const auto& X = Input(0);
+    const auto& filter = Input(1);
+    auto* Y = Output(0);
+    // The tensor added is the last input, after the optional bias
+    const int num_parameters = InputSize() - (kSum ? 1 : 0);
+    const float* bias = nullptr;
+    const int N = X.dim32(0), C = X.dim32(1);
+    CAFFE_ENFORCE_EQ(X.ndim(), 4);
+    CAFFE_ENFORCE_EQ(filter.ndim(), 4);
+    const int M = filter.dim32(0);
+    CAFFE_ENFORCE_EQ(C, filter.dim32(1) * group_);
+    CAFFE_ENFORCE_EQ(M % group_, 0);
+    CAFFE_ENFORCE_EQ(filter.dim32(2), kernel_h());
+    CAFFE_ENFORCE_EQ(filter.dim32(3), kernel_w());
+    if (num_parameters == 3) {
+      CAFFE_ENFORCE_EQ(Input(2).size(), M);
+      bias = Input(2).data<float>();
+    }
+
+    ConvPoolOpBase<CPUContext>::SetOutputSize(X, Y, M);
+    const float* sum = nullptr;
+    if (kSum) {
+      const auto& S = Input(InputSize() - 1);
+      CAFFE_ENFORCE(
+          S.dims() == Y->dims(),
+          "The tensor added has shape ",
+          S.dims(),
+          " instead of the output shape ",
+          Y->dims());
+      CAFFE_ENFORCE(&S != Y, "The tensor added cannot be the output.");
+      sum = S.data<float>();
+    }
+
+    const int H = X.dim32(2), W = X.dim32(3);
+    const int output_image_size = Y->dim32(2) * Y->dim32(3);
+    const int kernel_dim = C / group_ * kernel_h() * kernel_w();
+    const int input_offset = C / group_ * H * W;
+    const int output_offset = M / group_ * output_image_size;
+    const int filter_offset = filter.size() / group_;
+    col_buffer_.Resize(kernel_dim, output_image_size);
+    float* col_buffer_data = col_buffer_.mutable_data<float>();
+
+    const float* Xdata = X.data<float>();
+    float* Ydata = Y->mutable_data<float>();
+    for (int image_id = 0; image_id < N; ++image_id) {
+      for (int group_id = 0; group_id < group_; ++group_id) {
+        math::Im2col<float, CPUContext, StorageOrder::NCHW>(
+            Xdata + group_id * input_offset,
+            C / group_,
+            H,
+            W,
+            kernel_h(),
+            kernel_w(),
+            dilation_h(),
+            dilation_w(),
+            pad_t(),
+            pad_l(),
+            pad_b(),
+            pad_r(),
+            stride_h(),
+            stride_w(),
+            col_buffer_data,
+            &context_);
+        math::Gemm<float, CPUContext>(
+            CblasNoTrans,
+            CblasNoTrans,
+            M / group_,
+            output_image_size,
+            kernel_dim,
+            1,
+            filter.data<float>() + group_id * filter_offset,
+            col_buffer_data,
+            0,
+            Ydata + group_id * output_offset,
+            &context_);
+      }
+      for (int m = 0; m < M; ++m) {
+        float* y = Ydata + m * output_image_size;
+        const float b = bias ? bias[m] : 0.f;
+        if (kSum) {
+          const float* s = sum + m * output_image_size;
+          for (int i = 0; i < output_image_size; ++i) {
+            y[i] = std::max(y[i] + b + s[i], 0.f);
+          }
+        } else {
+          for (int i = 0; i < output_image_size; ++i) {
+            y[i] = std::max(y[i] + b, 0.f);
+          }
+        }
+      }
+      Xdata += input_offset * group_;
+      Ydata += output_offset * group_;
+      if (kSum) {
+        sum += output_offset * group_;
+      }
+    }
+    return true;
+  }
+
+ private:
+  TensorCPU col_buffer_;
+};
+
+std::function<void(OpSchema&)> ConvFusedDocGenerator(const char* sum) {
+  return [=](OpSchema& schema) {
+    string doc = R"DOC(
+Conv fused with the operators that follow it, for inference: computes
+Relu(Conv(X, filter, bias){sum}) in one pass over the output. Takes the
+arguments of Conv; only order "NCHW" and 2-D kernels are supported. The
+ConvFusion transform rewrites the nets to it.
+)DOC";
+    ReplaceAll(doc, "{sum}", sum);
+    schema.SetDoc(doc);
+    schema.Input(0, "X", "Input data blob, in NCHW order.");
+    schema.Input(1, "filter", "The filter blob, M x C/group x kH x kW.");
+    schema.Input(2, "bias", "The optional 1D bias blob, of size M.");
+    if (*sum) {
+      schema.Input(
+          3, "S", "The tensor added, of the output shape, the last input.");
+    }
+    schema.Output(0, "Y", "Output data blob, in NCHW order.");
+  };
+}
+
+} // namespace
+
+REGISTER_CPU_OPERATOR(ConvRelu, ConvFusedOp<false>);
+REGISTER_CPU_OPERATOR(ConvSumRelu, ConvFusedOp<true>);
+
+OPERATOR_SCHEMA(ConvRelu)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForConv)
+    .CostInferenceFunction(OpSchema::CostInferenceFunctionType(
+        ConvPoolOpBase<CPUContext>::CostInferenceForConv))
+    .FillUsing(ConvFusedDocGenerator(""));
+
+OPERATOR_SCHEMA(ConvSumRelu)
+    .NumInputs(3, 4)
+    .NumOutputs(1)
+    .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForConv)
+    .CostInferenceFunction(OpSchema::CostInferenceFunctionType(
+        ConvPoolOpBase<CPUContext>::CostInferenceForConv))
+    .FillUsing(ConvFusedDocGenerator(" + S"));
+
+NO_GRADIENT(ConvRelu);
+NO_GRADIENT(ConvSumRelu);
+
+} // namespace caffe2
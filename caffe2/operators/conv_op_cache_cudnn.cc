@@ -1,14 +1,130 @@
 #include "caffe2/operators/conv_op_cache_cudnn.h"
 
 #include <cudnn.h>
+#include <unistd.h>
 
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "caffe2/core/flags.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/tensor.h"
 
+CAFFE2_DEFINE_string(
+    caffe2_cudnn_algo_cache_file,
+    "",
+    "File that keeps the algorithms found by exhaustive cuDNN search across "
+    "processes. Defaults to the CUDNN_ALGO_CACHE_FILE environment variable.");
+
 namespace caffe2 {
 
 template class AlgorithmsCache<cudnnConvolutionFwdAlgo_t>;
 template class AlgorithmsCache<cudnnConvolutionBwdFilterAlgo_t>;
 template class AlgorithmsCache<cudnnConvolutionBwdDataAlgo_t>;
 template class AlgorithmsCache<int>; // For testing.
+
+namespace {
+
+void ReadEntries(
+    const std::string& path,
+    std::unordered_map<std::string, std::pair<int, float>>* entries) {
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream fields(line);
+    std::string key;
+    int algorithm;
+    float time;
+    if (fields >> key >> algorithm >> time) {
+      (*entries)[key] = std::make_pair(algorithm, time);
+    } else if (!line.empty()) {
+      LOG(WARNING) << "Skipping malformed line in " << path << ": " << line;
+    }
+  }
+}
+
+} // namespace
+
+PersistentAlgorithmsCache& PersistentAlgorithmsCache::Instance() {
+  static PersistentAlgorithmsCache cache;
+  return cache;
+}
+
+PersistentAlgorithmsCache::PersistentAlgorithmsCache()
+    : path_(FLAGS_caffe2_cudnn_algo_cache_file) {
+  if (path_.empty()) {
+    const char* env = std::getenv("CUDNN_ALGO_CACHE_FILE");
+    path_ = env ? env : "";
+  }
+  if (!path_.empty()) {
+    ReadEntries(path_, &entries_);
+    VLOG(1) << "Loaded " << entries_.size() << " cuDNN algorithms from "
+            << path_;
+  }
+}
+
+PersistentAlgorithmsCache::~PersistentAlgorithmsCache() {
+  Flush();
+}
+
+bool PersistentAlgorithmsCache::Find(
+    const std::string& key,
+    int* algorithm,
+    float* time) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return false;
+  }
+  *algorithm = it->second.first;
+  *time = it->second.second;
+  return true;
+}
+
+void PersistentAlgorithmsCache::Insert(
+    const std::string& key,
+    int algorithm,
+    float time) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  entries_[key] = std::make_pair(algorithm, time);
+  dirty_ = true;
+}
+
+void PersistentAlgorithmsCache::Flush() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (path_.empty() || !dirty_) {
+    return;
+  }
+  // Keep what other processes added since we loaded the file; our own
+  // entries win
+  std::unordered_map<std::string, std::pair<int, float>> merged;
+  ReadEntries(path_, &merged);
+  for (const auto& entry : entries_) {
+    merged[entry.first] = entry.second;
+  }
+  // Write a private file and rename it over the cache, so that readers
+  // never see a partial file
+  const std::string tmp_path = path_ + ".tmp." + std::to_string(getpid());
+  {
+    std::ofstream file(tmp_path);
+    for (const auto& entry : merged) {
+      file << entry.first << " " << entry.second.first << " "
+           << entry.second.second << "\n";
+    }
+    if (!file) {
+      LOG(WARNING) << "Could not write the cuDNN algorithm cache " << tmp_path;
+      std::remove(tmp_path.c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path_.c_str()) != 0) {
+    LOG(WARNING) << "Could not replace the cuDNN algorithm cache " << path_;
+    std::remove(tmp_path.c_str());
+    return;
+  }
+  dirty_ = false;
+}
+
 } // namespace caffe2
@@ -2,7 +2,11 @@
 #define CAFFE2_OPERATORS_CONV_OP_CACHE_H_
 
 #include <functional>
+#include <mutex>
+#include <string>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "caffe2/core/logging.h"
@@ -61,6 +65,58 @@ TAlgorithm AlgorithmsCache<TAlgorithm>::getAlgorithm(
 
   return hash_[seed];
 }
+
+/*
+ * Algorithms found by exhaustive search, kept across processes in the file
+ * named by --caffe2_cudnn_algo_cache_file, or else by the
+ * CUDNN_ALGO_CACHE_FILE environment variable. The file is read on first use
+ * and written back at exit, merged with whatever other processes wrote to it
+ * meanwhile. It has one entry per line,
+ *
+ *   <key> <algorithm> <time in ms>
+ *
+ * where the key spells out every input of the search and has no whitespace.
+ * ATen's cudnn_convolution uses the same format, so the two can share a file.
+ */
+class PersistentAlgorithmsCache {
+ public:
+  static PersistentAlgorithmsCache& Instance();
+
+  ~PersistentAlgorithmsCache();
+
+  bool Find(const std::string& key, int* algorithm, float* time);
+  void Insert(const std::string& key, int algorithm, float time);
+  // Writes the new entries out, a no-op without a cache file
+  void Flush();
+
+ private:
+  PersistentAlgorithmsCache();
+
+  std::mutex mutex_;
+  std::string path_;
+  std::unordered_map<std::string, std::pair<int, float>> entries_;
+  bool dirty_{false};
+};
+
+// Returns the algorithm and cost stored under key, or runs generatingFunc and
+// stores its result. An empty key skips the persistent cache.
+template <typename TAlgorithm>
+std::tuple<TAlgorithm, float> GetPersistentAlgorithm(
+    const std::string& key,
+    std::function<std::tuple<TAlgorithm, float>()> generatingFunc) {
+  auto& cache = PersistentAlgorithmsCache::Instance();
+  int algorithm;
+  float time;
+  if (!key.empty() && cache.Find(key, &algorithm, &time)) {
+    return std::make_tuple(static_cast<TAlgorithm>(algorithm), time);
+  }
+  auto result = generatingFunc();
+  if (!key.empty()) {
+    cache.Insert(
+        key, static_cast<int>(std::get<0>(result)), std::get<1>(result));
+  }
+  return result;
+}
 } // namespace caffe2
 
 #endif
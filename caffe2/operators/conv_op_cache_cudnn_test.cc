@@ -58,4 +58,27 @@ TEST(AlgorithmsCacheTest, KeysDifferIfFlagsAreDifferent) {
   EXPECT_EQ(res3, 10);
 }
 
+TEST(PersistentAlgorithmsCacheTest, CachesByKey) {
+  auto result = GetPersistentAlgorithm<int>("test;key=1", []() {
+    return std::make_tuple(5, 1.5f);
+  });
+  EXPECT_EQ(std::get<0>(result), 5);
+
+  auto res2 = GetPersistentAlgorithm<int>("test;key=1", []() {
+    return std::make_tuple(10, 0.5f);
+  });
+  EXPECT_EQ(std::get<0>(res2), 5);
+  EXPECT_EQ(std::get<1>(res2), 1.5f);
+
+  auto res3 = GetPersistentAlgorithm<int>("test;key=2", []() {
+    return std::make_tuple(10, 0.5f);
+  });
+  EXPECT_EQ(std::get<0>(res3), 10);
+
+  // An empty key always runs the search
+  auto res4 = GetPersistentAlgorithm<int>(
+      "", []() { return std::make_tuple(15, 0.5f); });
+  EXPECT_EQ(std::get<0>(res4), 15);
+}
+
 } // namespace caffe2
@@ -1,3 +1,5 @@
+#include <sstream>
+
 #include "caffe2/core/context_gpu.h"
 
 #include "caffe2/core/common_gpu.h"
@@ -402,6 +404,39 @@ class CudnnConvOpBase : public ConvPoolOpBase<CUDAContext> {
     }
   }
 
+  // The key of an exhaustive search in PersistentAlgorithmsCache: the GPU
+  // architecture, the cuDNN version and everything the search is given.
+  template <typename T>
+  std::string AlgorithmCacheKey(
+      const char* pass,
+      const Tensor<CUDAContext>& X,
+      const Tensor<CUDAContext>& filter,
+      const Tensor<CUDAContext>& Y,
+      cudnnDataType_t compute_type) {
+    const cudaDeviceProp& prop = GetDeviceProperty(context_.cuda_gpu_id());
+    std::ostringstream key;
+    auto join = [&key](const char* name, const std::vector<TIndex>& values) {
+      key << ";" << name << "=";
+      for (int i = 0; i < values.size(); ++i) {
+        key << (i ? "x" : "") << values[i];
+      }
+    };
+    key << "caffe2;" << pass << ";sm" << prop.major << prop.minor << ";cudnn"
+        << cudnnGetVersion() << ";order=" << order_
+        << ";type=" << cudnnTypeWrapper<T>::type
+        << ";compute=" << compute_type;
+    join("x", X.dims());
+    join("w", filter.dims());
+    join("y", Y.dims());
+    join("kernel", std::vector<TIndex>(kernel_.begin(), kernel_.end()));
+    join("stride", std::vector<TIndex>(stride_.begin(), stride_.end()));
+    join("pad", std::vector<TIndex>(pads_.begin(), pads_.end()));
+    join("dilation", std::vector<TIndex>(dilation_.begin(), dilation_.end()));
+    key << ";group=" << group_ << ";ws=" << cudnn_ws_nbytes_limit_
+        << ";tensor_op=" << enable_tensor_core_;
+    return key.str();
+  }
+
   vector<TIndex> cudnn_input_dims_;
   vector<TIndex> cudnn_filter_dims_;
 
@@ -682,41 +717,47 @@ bool CudnnConvOp::DoRunWithType() {
       for (int i = 0; i < 2; i++) {
         SetConvDescComputeType(conv_desc_, kComputeTypesToTry[i]);
 
+        auto search = [&]() {
+          VLOG(1) << "CUDNN Convolution fwd: doing exhaustive "
+                  << "search for " << kComputePassNames[i];
+          // When we do an exhaustive search, we will ignore the workspace
+          // size limit and simply go for the fastest algorithm. If you
+          // happen to run out of memory later, you will be on your own...
+          int returned_algo_count;
+          std::array<cudnnConvolutionFwdAlgoPerf_t, kNUM_CUDNN_FWD_ALGS>
+              fwd_perf_stat;
+
+          // no need to clean up workspace,
+          cudnn_wrapper_.with_cudnn_state(
+              cudnn_state_, [&](CuDNNState* state) {
+                // Actually run the search.
+                CUDNN_ENFORCE(cudnnFindConvolutionForwardAlgorithmEx(
+                    state->cudnn_handle(),
+                    bottom_desc_,
+                    X.template data<T_X>(),
+                    filter_desc_,
+                    filter.template data<T_W>(),
+                    conv_desc_,
+                    top_desc_,
+                    Y->template mutable_data<T_Y>(),
+                    kNUM_CUDNN_FWD_ALGS,
+                    &returned_algo_count,
+                    fwd_perf_stat.data(),
+                    state->workspace().get(cudnn_ws_nbytes_limit_),
+                    cudnn_ws_nbytes_limit_));
+              });
+          LogCuDNNPerfStats(fwd_perf_stat, returned_algo_count);
+          float algo_time = fwd_perf_stat[0].status == CUDNN_STATUS_SUCCESS
+              ? fwd_perf_stat[0].time
+              : 1e10;
+          return ConvFwdAlgorithmWithCost(fwd_perf_stat[0].algo, algo_time);
+        };
         algosToCompare[i] = algo_cache_.getAlgorithm(
             X.dims(), filter.dims(), kComputeTypesToTry[i], [&]() {
-              VLOG(1) << "CUDNN Convolution fwd: doing exhaustive "
-                      << "search for " << kComputePassNames[i];
-              // When we do an exhaustive search, we will ignore the workspace
-              // size limit and simply go for the fastest algorithm. If you
-              // happen to run out of memory later, you will be on your own...
-              int returned_algo_count;
-              std::array<cudnnConvolutionFwdAlgoPerf_t, kNUM_CUDNN_FWD_ALGS>
-                  fwd_perf_stat;
-
-              // no need to clean up workspace,
-              cudnn_wrapper_.with_cudnn_state(
-                  cudnn_state_, [&](CuDNNState* state) {
-                    // Actually run the search.
-                    CUDNN_ENFORCE(cudnnFindConvolutionForwardAlgorithmEx(
-                        state->cudnn_handle(),
-                        bottom_desc_,
-                        X.template data<T_X>(),
-                        filter_desc_,
-                        filter.template data<T_W>(),
-                        conv_desc_,
-                        top_desc_,
-                        Y->template mutable_data<T_Y>(),
-                        kNUM_CUDNN_FWD_ALGS,
-                        &returned_algo_count,
-                        fwd_perf_stat.data(),
-                        state->workspace().get(cudnn_ws_nbytes_limit_),
-                        cudnn_ws_nbytes_limit_));
-                  });
-              LogCuDNNPerfStats(fwd_perf_stat, returned_algo_count);
-              float algo_time = fwd_perf_stat[0].status == CUDNN_STATUS_SUCCESS
-                  ? fwd_perf_stat[0].time
-                  : 1e10;
-              return ConvFwdAlgorithmWithCost(fwd_perf_stat[0].algo, algo_time);
+              return GetPersistentAlgorithm<cudnnConvolutionFwdAlgo_t>(
+                  AlgorithmCacheKey<T_X>(
+                      "fwd", X, filter, *Y, kComputeTypesToTry[i]),
+                  search);
             });
 
         // When set to fp32 compute, don't try fp16
@@ -1047,46 +1088,52 @@ bool CudnnConvGradientOp::DoRunWithType() {
       for (int i = 0; i < 2; i++) {
         SetConvDescComputeType(bwd_filter_conv_desc_, kComputeTypesToTry[i]);
 
+        auto search = [&]() {
+          VLOG(1) << "CUDNN Convolution bwd: doing filter exhaustive"
+                  << "search for " << kComputePassNames[i];
+          // When we do an exhaustive search, we will ignore the workspace
+          // size limit and simply go for the fastest algorithm. If you
+          // happen to run out of memory later, you will be on your own...
+          int returned_algo_count;
+          // We clean up the current workspace memory so that the forward
+          // algorithm is free to allocate memory.
+          // Actually run the search.
+          std::array<
+              cudnnConvolutionBwdFilterAlgoPerf_t,
+              kNUM_CUDNN_BWD_FILTER_ALGS>
+              filter_perf_stat;
+
+          cudnn_wrapper_.with_cudnn_state(
+              cudnn_state_, [&](CuDNNState* state) {
+                CUDNN_ENFORCE(cudnnFindConvolutionBackwardFilterAlgorithmEx(
+                    state->cudnn_handle(),
+                    bottom_desc_,
+                    X.template data<T_X>(),
+                    top_desc_,
+                    dY.template data<T_DY>(),
+                    bwd_filter_conv_desc_,
+                    filter_desc_,
+                    dfilter->template mutable_data<T_DW>(),
+                    kNUM_CUDNN_BWD_FILTER_ALGS,
+                    &returned_algo_count,
+                    filter_perf_stat.data(),
+                    state->workspace().get(cudnn_ws_nbytes_limit_),
+                    cudnn_ws_nbytes_limit_));
+              });
+          LogCuDNNPerfStats(filter_perf_stat, returned_algo_count);
+          float algo_time =
+              filter_perf_stat[0].status == CUDNN_STATUS_SUCCESS
+              ? filter_perf_stat[0].time
+              : 1e10;
+          return ConvBwdFilterAlgorithmWithCost(
+              filter_perf_stat[0].algo, algo_time);
+        };
         algosToCompare[i] = filter_algo_cache_.getAlgorithm(
             X.dims(), filter.dims(), kComputeTypesToTry[i], [&]() {
-              VLOG(1) << "CUDNN Convolution bwd: doing filter exhaustive"
-                      << "search for " << kComputePassNames[i];
-              // When we do an exhaustive search, we will ignore the workspace
-              // size limit and simply go for the fastest algorithm. If you
-              // happen to run out of memory later, you will be on your own...
-              int returned_algo_count;
-              // We clean up the current workspace memory so that the forward
-              // algorithm is free to allocate memory.
-              // Actually run the search.
-              std::array<
-                  cudnnConvolutionBwdFilterAlgoPerf_t,
-                  kNUM_CUDNN_BWD_FILTER_ALGS>
-                  filter_perf_stat;
-
-              cudnn_wrapper_.with_cudnn_state(
-                  cudnn_state_, [&](CuDNNState* state) {
-                    CUDNN_ENFORCE(cudnnFindConvolutionBackwardFilterAlgorithmEx(
-                        state->cudnn_handle(),
-                        bottom_desc_,
-                        X.template data<T_X>(),
-                        top_desc_,
-                        dY.template data<T_DY>(),
-                        bwd_filter_conv_desc_,
-                        filter_desc_,
-                        dfilter->template mutable_data<T_DW>(),
-                        kNUM_CUDNN_BWD_FILTER_ALGS,
-                        &returned_algo_count,
-                        filter_perf_stat.data(),
-                        state->workspace().get(cudnn_ws_nbytes_limit_),
-                        cudnn_ws_nbytes_limit_));
-                  });
-              LogCuDNNPerfStats(filter_perf_stat, returned_algo_count);
-              float algo_time =
-                  filter_perf_stat[0].status == CUDNN_STATUS_SUCCESS
-                  ? filter_perf_stat[0].time
-                  : 1e10;
-              return ConvBwdFilterAlgorithmWithCost(
-                  filter_perf_stat[0].algo, algo_time);
+              return GetPersistentAlgorithm<cudnnConvolutionBwdFilterAlgo_t>(
+                  AlgorithmCacheKey<T_X>(
+                      "bwd_filter", X, filter, dY, kComputeTypesToTry[i]),
+                  search);
             });
 
         // When set to fp32 compute, don't try fp16
@@ -1134,47 +1181,53 @@ bool CudnnConvGradientOp::DoRunWithType() {
         for (int i = 0; i < 2; i++) {
           SetConvDescComputeType(bwd_data_conv_desc_, kComputeTypesToTry[i]);
 
+          auto search = [&]() {
+            VLOG(1) << "CUDNN Convolution bwd: doing data exhaustive"
+                    << "search for " << kComputePassNames[i];
+            int returned_algo_count;
+
+            std::array<
+                cudnnConvolutionBwdDataAlgoPerf_t,
+                kNUM_CUDNN_BWD_DATA_ALGS>
+                data_perf_stat;
+            cudnn_wrapper_.with_cudnn_state(
+                cudnn_state_, [&](CuDNNState* state) {
+                  auto* dX =
+                      Output(no_bias_ ? BIAS_OR_INPUT_GRAD : INPUT_GRAD);
+                  dX->ResizeLike(X);
+                  const T_W* filter_data = filter.template data<T_W>();
+                  const T_DY* dYdata = dY.template data<T_DY>();
+                  T_DX* dXdata = dX->template mutable_data<T_DX>();
+                  CUDNN_ENFORCE(cudnnFindConvolutionBackwardDataAlgorithmEx(
+                      state->cudnn_handle(),
+                      filter_desc_,
+                      filter_data,
+                      top_desc_,
+                      dYdata,
+                      bwd_data_conv_desc_,
+                      bottom_desc_,
+                      dXdata,
+                      kNUM_CUDNN_BWD_DATA_ALGS,
+                      &returned_algo_count,
+                      data_perf_stat.data(),
+                      state->workspace().get(cudnn_ws_nbytes_limit_),
+                      cudnn_ws_nbytes_limit_));
+                });
+
+            LogCuDNNPerfStats(data_perf_stat, returned_algo_count);
+            float algo_time =
+                data_perf_stat[0].status == CUDNN_STATUS_SUCCESS
+                ? data_perf_stat[0].time
+                : 1e10;
+            return ConvBwdDataAlgorithmWithCost(
+                data_perf_stat[0].algo, algo_time);
+          };
           algosToCompare[i] = data_algo_cache_.getAlgorithm(
               X.dims(), filter.dims(), kComputeTypesToTry[i], [&]() {
-                VLOG(1) << "CUDNN Convolution bwd: doing data exhaustive"
-                        << "search for " << kComputePassNames[i];
-                int returned_algo_count;
-
-                std::array<
-                    cudnnConvolutionBwdDataAlgoPerf_t,
-                    kNUM_CUDNN_BWD_DATA_ALGS>
-                    data_perf_stat;
-                cudnn_wrapper_.with_cudnn_state(
-                    cudnn_state_, [&](CuDNNState* state) {
-                      auto* dX =
-                          Output(no_bias_ ? BIAS_OR_INPUT_GRAD : INPUT_GRAD);
-                      dX->ResizeLike(X);
-                      const T_W* filter_data = filter.template data<T_W>();
-                      const T_DY* dYdata = dY.template data<T_DY>();
-                      T_DX* dXdata = dX->template mutable_data<T_DX>();
-                      CUDNN_ENFORCE(cudnnFindConvolutionBackwardDataAlgorithmEx(
-                          state->cudnn_handle(),
-                          filter_desc_,
-                          filter_data,
-                          top_desc_,
-                          dYdata,
-                          bwd_data_conv_desc_,
-                          bottom_desc_,
-                          dXdata,
-                          kNUM_CUDNN_BWD_DATA_ALGS,
-                          &returned_algo_count,
-                          data_perf_stat.data(),
-                          state->workspace().get(cudnn_ws_nbytes_limit_),
-                          cudnn_ws_nbytes_limit_));
-                    });
-
-                LogCuDNNPerfStats(data_perf_stat, returned_algo_count);
-                float algo_time =
-                    data_perf_stat[0].status == CUDNN_STATUS_SUCCESS
-                    ? data_perf_stat[0].time
-                    : 1e10;
-                return ConvBwdDataAlgorithmWithCost(
-                    data_perf_stat[0].algo, algo_time);
+                return GetPersistentAlgorithm<cudnnConvolutionBwdDataAlgo_t>(
+                    AlgorithmCacheKey<T_X>(
+                        "bwd_data", X, filter, dY, kComputeTypesToTry[i]),
+                    search);
               });
 
           // When set to fp32 compute, don't try fp16
@@ -0,0 +1,508 @@
+#include <algorithm>
+#include <memory>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/conv_op.h"
+#include "caffe2/operators/conv_op_impl.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+inline int DivUp(int a, int b) {
+  return (a + b - 1) / b;
+}
+
+// Y = bias per channel, for the kernels that accumulate into Y
+void FillBias(int M, int size, const float* bias, float* Y) {
+  for (int m = 0; m < M; ++m) {
+    std::fill(Y + m * size, Y + (m + 1) * size, bias ? bias[m] : 0.f);
+  }
+}
+
+// Depthwise convolution of one image: output channel m reads input channel
+// m / multiplier. Y is filled with the bias, then every filter tap adds a
+// shifted input row to a whole output row, so that the inner loop runs over
+// contiguous outputs and vectorizes.
+void DepthwiseConv(
+    int C,
+    int H,
+    int W,
+    int multiplier,
+    int kernel_h,
+    int kernel_w,
+    int dilation_h,
+    int dilation_w,
+    int stride_h,
+    int stride_w,
+    int pad_t,
+    int pad_l,
+    int OH,
+    int OW,
+    const float* X,
+    const float* filter,
+    const float* bias,
+    float* Y) {
+  const int M = C * multiplier;
+  FillBias(M, OH * OW, bias, Y);
+  for (int m = 0; m < M; ++m) {
+    const float* x = X + static_cast<size_t>(m / multiplier) * H * W;
+    const float* w = filter + m * kernel_h * kernel_w;
+    float* y = Y + static_cast<size_t>(m) * OH * OW;
+    for (int oh = 0; oh < OH; ++oh) {
+      float* y_row = y + oh * OW;
+      for (int i = 0; i < kernel_h; ++i) {
+        const int ih = oh * stride_h - pad_t + i * dilation_h;
+        if (ih < 0 || ih >= H) {
+          continue;
+        }
+        const float* x_row = x + ih * W;
+        for (int j = 0; j < kernel_w; ++j) {
+          const float w_ij = w[i * kernel_w + j];
+          // Outputs whose input column ow * stride_w + offset is in [0, W)
+          const int offset = j * dilation_w - pad_l;
+          const int ow_begin = offset >= 0 ? 0 : DivUp(-offset, stride_w);
+          const int ow_end =
+              offset >= W ? 0 : std::min(OW, DivUp(W - offset, stride_w));
+          if (stride_w == 1) {
+            const float* x_shifted = x_row + offset;
+            for (int ow = ow_begin; ow < ow_end; ++ow) {
+              y_row[ow] += w_ij * x_shifted[ow];
+            }
+          } else {
+            for (int ow = ow_begin; ow < ow_end; ++ow) {
+              y_row[ow] += w_ij * x_row[ow * stride_w + offset];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// r = a * b for small row-major matrices, a is R x K and b is K x C
+template <int R, int K, int C>
+inline void SmallMatMul(const float* a, const float* b, float* r) {
+  for (int i = 0; i < R; ++i) {
+    for (int j = 0; j < C; ++j) {
+      float sum = 0;
+      for (int k = 0; k < K; ++k) {
+        sum += a[i * K + k] * b[k * C + j];
+      }
+      r[i * C + j] = sum;
+    }
+  }
+}
+
+// r = a * b^T, a is R x K and b is C x K
+template <int R, int K, int C>
+inline void SmallMatMulTransposed(const float* a, const float* b, float* r) {
+  for (int i = 0; i < R; ++i) {
+    for (int j = 0; j < C; ++j) {
+      float sum = 0;
+      for (int k = 0; k < K; ++k) {
+        sum += a[i * K + k] * b[j * K + k];
+      }
+      r[i * C + j] = sum;
+    }
+  }
+}
+
+/**
+ * Winograd F(m x m, 3 x 3) (Lavin and Gray, "Fast Algorithms for
+ * Convolutional Neural Networks"): every m x m output tile is
+ * A^T [(G g G^T) . (B^T d B)] A, with d the (m + 2) x (m + 2) input tile. The
+ * elementwise products summed over the input channels are alpha^2 GEMMs of
+ * M x C by C x tiles.
+ */
+template <int m>
+struct Winograd;
+
+template <>
+struct Winograd<2> {
+  static constexpr int kAlpha = 4;
+  static const float BT[4 * 4];
+  static const float G[4 * 3];
+  static const float AT[2 * 4];
+};
+
+const float Winograd<2>::BT[4 * 4] = {
+    1, 0, -1, 0, //
+    0, 1, 1, 0, //
+    0, -1, 1, 0, //
+    0, 1, 0, -1};
+const float Winograd<2>::G[4 * 3] = {
+    1, 0, 0, //
+    0.5f, 0.5f, 0.5f, //
+    0.5f, -0.5f, 0.5f, //
+    0, 0, 1};
+const float Winograd<2>::AT[2 * 4] = {
+    1, 1, 1, 0, //
+    0, 1, -1, -1};
+
+template <>
+struct Winograd<4> {
+  static constexpr int kAlpha = 6;
+  static const float BT[6 * 6];
+  static const float G[6 * 3];
+  static const float AT[4 * 6];
+};
+
+const float Winograd<4>::BT[6 * 6] = {
+    4, 0, -5, 0, 1, 0, //
+    0, -4, -4, 1, 1, 0, //
+    0, 4, -4, -1, 1, 0, //
+    0, -2, -1, 2, 1, 0, //
+    0, 2, -1, -2, 1, 0, //
+    0, 4, 0, -5, 0, 1};
+const float Winograd<4>::G[6 * 3] = {
+    1.f / 4, 0, 0, //
+    -1.f / 6, -1.f / 6, -1.f / 6, //
+    -1.f / 6, 1.f / 6, -1.f / 6, //
+    1.f / 24, 1.f / 12, 1.f / 6, //
+    1.f / 24, -1.f / 12, 1.f / 6, //
+    0, 0, 1};
+const float Winograd<4>::AT[4 * 6] = {
+    1, 1, 1, 1, 1, 0, //
+    0, 1, -1, 2, -2, 0, //
+    0, 1, 1, 4, 4, 0, //
+    0, 1, -1, 8, -8, 1};
+
+// U[xi][m][c] = (G g_mc G^T)[xi]
+template <int m>
+void WinogradTransformFilter(int M, int C, const float* filter, float* U) {
+  constexpr int alpha = Winograd<m>::kAlpha;
+  float tmp[alpha * 3];
+  float u[alpha * alpha];
+  for (int i = 0; i < M * C; ++i) {
+    SmallMatMul<alpha, 3, 3>(Winograd<m>::G, filter + i * 9, tmp);
+    SmallMatMulTransposed<alpha, 3, alpha>(tmp, Winograd<m>::G, u);
+    for (int xi = 0; xi < alpha * alpha; ++xi) {
+      U[static_cast<size_t>(xi) * M * C + i] = u[xi];
+    }
+  }
+}
+
+// V[xi][c][p] = (B^T d_cp B)[xi] for the input tile d_cp of every tile p
+template <int m>
+void WinogradTransformInput(
+    int C,
+    int H,
+    int W,
+    int pad_t,
+    int pad_l,
+    int tiles_h,
+    int tiles_w,
+    const float* X,
+    float* V) {
+  constexpr int alpha = Winograd<m>::kAlpha;
+  const int P = tiles_h * tiles_w;
+  float d[alpha * alpha];
+  float tmp[alpha * alpha];
+  float v[alpha * alpha];
+  for (int c = 0; c < C; ++c) {
+    const float* x = X + static_cast<size_t>(c) * H * W;
+    for (int th = 0; th < tiles_h; ++th) {
+      for (int tw = 0; tw < tiles_w; ++tw) {
+        const int h0 = th * m - pad_t;
+        const int w0 = tw * m - pad_l;
+        for (int i = 0; i < alpha; ++i) {
+          const int h = h0 + i;
+          for (int j = 0; j < alpha; ++j) {
+            const int w = w0 + j;
+            d[i * alpha + j] =
+                (h >= 0 && h < H && w >= 0 && w < W) ? x[h * W + w] : 0.f;
+          }
+        }
+        SmallMatMul<alpha, alpha, alpha>(Winograd<m>::BT, d, tmp);
+        SmallMatMulTransposed<alpha, alpha, alpha>(tmp, Winograd<m>::BT, v);
+        const int p = th * tiles_w + tw;
+        for (int xi = 0; xi < alpha * alpha; ++xi) {
+          V[(static_cast<size_t>(xi) * C + c) * P + p] = v[xi];
+        }
+      }
+    }
+  }
+}
+
+// Y tile = A^T Z_mp A + bias, cropped to the output
+template <int m>
+void WinogradTransformOutput(
+    int M,
+    int OH,
+    int OW,
+    int tiles_h,
+    int tiles_w,
+    const float* Z,
+    const float* bias,
+    float* Y) {
+  constexpr int alpha = Winograd<m>::kAlpha;
+  const int P = tiles_h * tiles_w;
+  float z[alpha * alpha];
+  float tmp[m * alpha];
+  float y[m * m];
+  for (int k = 0; k < M; ++k) {
+    float* y_k = Y + static_cast<size_t>(k) * OH * OW;
+    const float b = bias ? bias[k] : 0.f;
+    for (int p = 0; p < P; ++p) {
+      for (int xi = 0; xi < alpha * alpha; ++xi) {
+        z[xi] = Z[(static_cast<size_t>(xi) * M + k) * P + p];
+      }
+      SmallMatMul<m, alpha, alpha>(Winograd<m>::AT, z, tmp);
+      SmallMatMulTransposed<m, alpha, m>(tmp, Winograd<m>::AT, y);
+      const int h0 = (p / tiles_w) * m;
+      const int w0 = (p % tiles_w) * m;
+      for (int i = 0; i < m && h0 + i < OH; ++i) {
+        for (int j = 0; j < m && w0 + j < OW; ++j) {
+          y_k[(h0 + i) * OW + w0 + j] = y[i * m + j] + b;
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+/**
+ * Conv engine with fast paths for the common CPU shapes, in NCHW order:
+ *
+ * - depthwise convolutions run a direct kernel, without im2col;
+ * - 1x1 convolutions without padding are a single GEMM on the input;
+ * - 3x3 convolutions with stride 1 use Winograd F(4x4, 3x3), or F(2x2, 3x3)
+ *   for outputs smaller than 8x8 whose tiles would be mostly padding. The
+ *   transformed input is 2.25x (F(4x4)) or 4x (F(2x2)) the input, instead of
+ *   9x for im2col.
+ *
+ * Anything else, and NHWC, runs the default im2col implementation.
+ */
+class FastConvOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  FastConvOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws),
+        fallback_(new ConvOp<float, CPUContext>(operator_def, ws)) {}
+  ~FastConvOp() {}
+
+  bool RunOnDeviceWithOrderNCHW() override;
+  bool RunOnDeviceWithOrderNHWC() override {
+    return fallback_->RunOnDeviceWithOrderNHWC();
+  }
+
+ private:
+  enum class Algorithm {
+    IM2COL,
+    DEPTHWISE,
+    DIRECT_1X1,
+    WINOGRAD_2X2,
+    WINOGRAD_4X4,
+  };
+
+  Algorithm ChooseAlgorithm(int C, int M, int filter_channels, int OH, int OW);
+
+  template <int m>
+  void RunWinograd(
+      const TensorCPU& X,
+      const TensorCPU& filter,
+      const float* bias,
+      TensorCPU* Y);
+
+  std::unique_ptr<ConvOp<float, CPUContext>> fallback_;
+  TensorCPU transformed_filter_;
+  TensorCPU transformed_input_;
+  TensorCPU transformed_output_;
+  TensorCPU buffer_;
+  INPUT_TAGS(INPUT, FILTER, BIAS);
+};
+
+FastConvOp::Algorithm FastConvOp::ChooseAlgorithm(
+    int C,
+    int M,
+    int filter_channels,
+    int OH,
+    int OW) {
+  if (kernel_.size() != 2) {
+    return Algorithm::IM2COL;
+  }
+  if (group_ > 1 && group_ == C && filter_channels == 1) {
+    return Algorithm::DEPTHWISE;
+  }
+  if (group_ != 1) {
+    return Algorithm::IM2COL;
+  }
+  if (kernel_h() == 1 && kernel_w() == 1 && pad_t() == 0 && pad_l() == 0 &&
+      pad_b() == 0 && pad_r() == 0) {
+    return Algorithm::DIRECT_1X1;
+  }
+  // Below 8 channels the transforms cost more than the GEMMs save
+  if (kernel_h() == 3 && kernel_w() == 3 && stride_h() == 1 &&
+      stride_w() == 1 && dilation_h() == 1 && dilation_w() == 1 && C >= 8 &&
+      M >= 8) {
+    return OH >= 8 && OW >= 8 ? Algorithm::WINOGRAD_4X4
+                              : Algorithm::WINOGRAD_2X2;
+  }
+  return Algorithm::IM2COL;
+}
+
+bool FastConvOp::RunOnDeviceWithOrderNCHW() {
+  const auto& X = Input(INPUT);
+  const auto& filter = Input(FILTER);
+  auto* Y = Output(0);
+  if (X.ndim() != 4) {
+    return fallback_->RunOnDeviceWithOrderNCHW();
+  }
+  const int N = X.dim32(0), C = X.dim32(1), H = X.dim32(2), W = X.dim32(3);
+  CAFFE_ENFORCE_EQ(filter.ndim(), 4);
+  const int M = filter.dim32(0);
+  CAFFE_ENFORCE_EQ(C, filter.dim32(1) * group_);
+  CAFFE_ENFORCE_EQ(M % group_, 0);
+  CAFFE_ENFORCE_EQ(filter.dim32(2), kernel_h());
+  CAFFE_ENFORCE_EQ(filter.dim32(3), kernel_w());
+  const float* bias = nullptr;
+  if (InputSize() == 3) {
+    const auto& b = Input(BIAS);
+    CAFFE_ENFORCE_EQ(b.ndim(), 1);
+    CAFFE_ENFORCE_EQ(b.dim32(0), M);
+    bias = b.data<float>();
+  }
+  ConvPoolOpBase<CPUContext>::SetOutputSize(X, Y, M);
+  const int OH = Y->dim32(2), OW = Y->dim32(3);
+
+  switch (ChooseAlgorithm(C, M, filter.dim32(1), OH, OW)) {
+    case Algorithm::DEPTHWISE: {
+      for (int n = 0; n < N; ++n) {
+        DepthwiseConv(
+            C,
+            H,
+            W,
+            M / C,
+            kernel_h(),
+            kernel_w(),
+            dilation_h(),
+            dilation_w(),
+            stride_h(),
+            stride_w(),
+            pad_t(),
+            pad_l(),
+            OH,
+            OW,
+            X.data<float>() + static_cast<size_t>(n) * C * H * W,
+            filter.data<float>(),
+            bias,
+            Y->mutable_data<float>() + static_cast<size_t>(n) * M * OH * OW);
+      }
+      return true;
+    }
+    case Algorithm::DIRECT_1X1: {
+      const bool strided = stride_h() != 1 || stride_w() != 1;
+      if (strided) {
+        buffer_.Resize(C, OH * OW);
+      }
+      for (int n = 0; n < N; ++n) {
+        const float* x = X.data<float>() + static_cast<size_t>(n) * C * H * W;
+        float* y =
+            Y->mutable_data<float>() + static_cast<size_t>(n) * M * OH * OW;
+        if (strided) {
+          // Only the subsampled pixels, the copy is smaller than the input
+          float* b = buffer_.mutable_data<float>();
+          for (int c = 0; c < C; ++c) {
+            for (int oh = 0; oh < OH; ++oh) {
+              for (int ow = 0; ow < OW; ++ow) {
+                *b++ = x[(c * H + oh * stride_h()) * W + ow * stride_w()];
+              }
+            }
+          }
+          x = buffer_.data<float>();
+        }
+        FillBias(M, OH * OW, bias, y);
+        math::Gemm<float, CPUContext>(
+            CblasNoTrans,
+            CblasNoTrans,
+            M,
+            OH * OW,
+            C,
+            1,
+            filter.data<float>(),
+            x,
+            1,
+            y,
+            &context_);
+      }
+      return true;
+    }
+    case Algorithm::WINOGRAD_2X2:
+      RunWinograd<2>(X, filter, bias, Y);
+      return true;
+    case Algorithm::WINOGRAD_4X4:
+      RunWinograd<4>(X, filter, bias, Y);
+      return true;
+    case Algorithm::IM2COL:
+      break;
+  }
+  return fallback_->RunOnDeviceWithOrderNCHW();
+}
+
+template <int m>
+void FastConvOp::RunWinograd(
+    const TensorCPU& X,
+    const TensorCPU& filter,
+    const float* bias,
+    TensorCPU* Y) {
+  constexpr int alpha = Winograd<m>::kAlpha;
+  const int N = X.dim32(0), C = X.dim32(1), H = X.dim32(2), W = X.dim32(3);
+  const int M = Y->dim32(1), OH = Y->dim32(2), OW = Y->dim32(3);
+  const int tiles_h = DivUp(OH, m);
+  const int tiles_w = DivUp(OW, m);
+  const int P = tiles_h * tiles_w;
+
+  transformed_filter_.Resize(alpha * alpha, M, C);
+  transformed_input_.Resize(alpha * alpha, C, P);
+  transformed_output_.Resize(alpha * alpha, M, P);
+  float* U = transformed_filter_.mutable_data<float>();
+  float* V = transformed_input_.mutable_data<float>();
+  float* Z = transformed_output_.mutable_data<float>();
+  WinogradTransformFilter<m>(M, C, filter.data<float>(), U);
+
+  for (int n = 0; n < N; ++n) {
+    WinogradTransformInput<m>(
+        C,
+        H,
+        W,
+        pad_t(),
+        pad_l(),
+        tiles_h,
+        tiles_w,
+        X.data<float>() + static_cast<size_t>(n) * C * H * W,
+        V);
+    for (int xi = 0; xi < alpha * alpha; ++xi) {
+      math::Gemm<float, CPUContext>(
+          CblasNoTrans,
+          CblasNoTrans,
+          M,
+          P,
+          C,
+          1,
+          U + static_cast<size_t>(xi) * M * C,
+          V + static_cast<size_t>(xi) * C * P,
+          0,
+          Z + static_cast<size_t>(xi) * M * P,
+          &context_);
+    }
+    WinogradTransformOutput<m>(
+        M,
+        OH,
+        OW,
+        tiles_h,
+        tiles_w,
+        Z,
+        bias,
+        Y->mutable_data<float>() + static_cast<size_t>(n) * M * OH * OW);
+  }
+}
+
+REGISTER_CPU_OPERATOR_WITH_ENGINE(Conv, FAST, FastConvOp);
+REGISTER_CPU_OPERATOR_WITH_ENGINE(Conv2D, FAST, FastConvOp);
+
+} // namespace caffe2
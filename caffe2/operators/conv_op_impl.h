@@ -9,23 +9,30 @@
 #include "caffe2/operators/conv_op.h"
 #include "caffe2/operators/conv_pool_op_base.h"
 #include "caffe2/utils/math.h"
+#include "caffe2/utils/packed_gemm.h"
 
 namespace caffe2 {
 
 template <typename T, class Context>
 bool ConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   const Tensor<Context>& X = Input(INPUT);
-  auto& filter = Input(FILTER);
+  // The filter is a tensor, or was packed ahead of time by PackGemmWeights
+  const PackedGemmMatrixFP32* packed_filter =
+      OperatorBase::InputIsType<PackedGemmMatrixFP32>(FILTER)
+      ? &OperatorBase::Input<PackedGemmMatrixFP32>(FILTER)
+      : nullptr;
+  const auto& filter_dims =
+      packed_filter ? packed_filter->dims() : Input(FILTER).dims();
   Tensor<Context>* Y = Output(0);
   const int N = X.dim32(0), C = X.dim32(1);
-  CAFFE_ENFORCE_EQ(X.ndim(), filter.ndim());
-  const int M = filter.dim32(0);
+  CAFFE_ENFORCE_EQ(X.ndim(), filter_dims.size());
+  const int M = filter_dims[0];
   CAFFE_ENFORCE(
-      C == filter.dim32(1) * group_,
+      C == filter_dims[1] * group_,
       "Convolution op: input channels does not match: # of input channels ",
       C,
       " is not equal to kernel channels * group:",
-      filter.dim32(1),
+      filter_dims[1],
       "*",
       group_);
   CAFFE_ENFORCE(
@@ -34,11 +41,11 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
 
   int kernel_dims_size = 1;
   for (int i = 0; i < kernel_.size(); ++i) {
-    CAFFE_ENFORCE(filter.dim32(i + 2) == kernel_[i]);
+    CAFFE_ENFORCE(filter_dims[i + 2] == kernel_[i]);
     kernel_dims_size *= kernel_[i];
   }
 
-  ConvPoolOpBase<Context>::SetOutputSize(X, Y, filter.dim32(0));
+  ConvPoolOpBase<Context>::SetOutputSize(X, Y, M);
 
   const vector<int> input_dims = GetDims(X);
   const vector<int> output_dims = GetDims(*Y);
@@ -67,7 +74,14 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   // image.
   const int input_offset = C / group_ * input_image_size;
   const int output_offset = Y->size() / Y->dim32(0) / group_;
-  const int filter_offset = filter.size() / group_;
+  const int filter_offset = size_from_dim_(0, filter_dims) / group_;
+  if (packed_filter) {
+    CAFFE_ENFORCE(
+        packed_filter->operand() == PackedGemmMatrixFP32::A &&
+            packed_filter->groups() == group_ &&
+            packed_filter->cols() == kernel_dim,
+        "Filter packed for another operator");
+  }
 
   // The col buffer is stored in CHW order as well - kernel_dim, and the height
   // and width.
@@ -121,18 +135,29 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
               &context_);
         }
         // Weight term
-        math::Gemm<T, Context>(
-            CblasNoTrans,
-            CblasNoTrans,
-            M / group_,
-            output_image_size,
-            kernel_dim,
-            1,
-            filter.template data<T>() + group_id * filter_offset,
-            col_buffer_data,
-            0,
-            Ydata + group_id * output_offset,
-            &context_);
+        if (packed_filter) {
+          PackedGemm(
+              *packed_filter,
+              group_id,
+              output_image_size,
+              col_buffer_data,
+              0,
+              Ydata + group_id * output_offset,
+              &context_);
+        } else {
+          math::Gemm<T, Context>(
+              CblasNoTrans,
+              CblasNoTrans,
+              M / group_,
+              output_image_size,
+              kernel_dim,
+              1,
+              Input(FILTER).template data<T>() + group_id * filter_offset,
+              col_buffer_data,
+              0,
+              Ydata + group_id * output_offset,
+              &context_);
+        }
       }
       if (InputSize() == 3) {
         // Bias term can be carried out outside the group definition
@@ -168,7 +193,13 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
 template <typename T, class Context>
 bool ConvOp<T, Context>::RunOnDeviceWithOrderNHWC() {
   const Tensor<Context>& X = Input(INPUT);
-  auto& filter = Input(FILTER);
+  // The filter is a tensor, or was packed ahead of time by PackGemmWeights
+  const PackedGemmMatrixFP32* packed_filter =
+      OperatorBase::InputIsType<PackedGemmMatrixFP32>(FILTER)
+      ? &OperatorBase::Input<PackedGemmMatrixFP32>(FILTER)
+      : nullptr;
+  const auto& filter_dims =
+      packed_filter ? packed_filter->dims() : Input(FILTER).dims();
   Tensor<Context>* Y = Output(0);
   const int N = X.dim32(0), H = X.dim32(1), W = X.dim32(2), C = X.dim32(3);
 
@@ -177,15 +208,40 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNHWC() {
       2,
       "Only 2d convolution is supported for NHWC storage type");
 
-  CAFFE_ENFORCE(X.ndim(), filter.ndim());
-  const int M = filter.dim32(0);
-  CAFFE_ENFORCE(filter.dim32(1) == kernel_h());
-  CAFFE_ENFORCE(filter.dim32(2) == kernel_w());
-  CAFFE_ENFORCE(filter.dim32(3) == C);
+  CAFFE_ENFORCE(X.ndim(), filter_dims.size());
+  const int M = filter_dims[0];
+  CAFFE_ENFORCE(filter_dims[1] == kernel_h());
+  CAFFE_ENFORCE(filter_dims[2] == kernel_w());
+  CAFFE_ENFORCE(filter_dims[3] == C);
 
-  ConvPoolOpBase<Context>::SetOutputSize(X, Y, filter.dim32(0));
+  ConvPoolOpBase<Context>::SetOutputSize(X, Y, M);
   // The dimension of each kernel
   const int kernel_dim = kernel_h() * kernel_w() * C;
+  if (packed_filter) {
+    CAFFE_ENFORCE(
+        packed_filter->operand() == PackedGemmMatrixFP32::B &&
+            packed_filter->rows() == kernel_dim,
+        "Filter packed for another operator");
+  }
+  // Y = X * filter^T, X being rows of kernel_dim values
+  auto filter_gemm = [&](int rows, const T* X_rows, T* Y_rows) {
+    if (packed_filter) {
+      PackedGemm(*packed_filter, 0, rows, X_rows, 0, Y_rows, &context_);
+    } else {
+      math::Gemm<T, Context>(
+          CblasNoTrans,
+          CblasTrans,
+          rows,
+          M,
+          kernel_dim,
+          1,
+          X_rows,
+          Input(FILTER).template data<T>(),
+          0,
+          Y_rows,
+          &context_);
+    }
+  };
   // The offset corresponding to a single input image, and a single output
   // image.
   const int input_offset = H * W * C;
@@ -201,18 +257,7 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNHWC() {
   if (kernel_dim == C && Y->dim32(1) == X.dim32(1) &&
       Y->dim32(2) == X.dim32(2) && stride_h() == 1 && stride_w() == 1 &&
       pad_t() == 0 && pad_b() == 0 && pad_l() == 0 && pad_r() == 0) {
-    math::Gemm<T, Context>(
-        CblasNoTrans,
-        CblasTrans,
-        N * H * W,
-        M,
-        C,
-        1,
-        Xdata,
-        filter.template data<T>(),
-        0,
-        Ydata,
-        &context_);
+    filter_gemm(N * H * W, Xdata, Ydata);
     if (InputSize() == 3) {
       auto& bias = Input(BIAS);
       CAFFE_ENFORCE(1 == bias.ndim());
@@ -271,18 +316,7 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNHWC() {
             col_buffer_data,
             &context_);
         // Weight term
-        math::Gemm<T, Context>(
-            CblasNoTrans,
-            CblasTrans,
-            output_image_size,
-            M,
-            kernel_dim,
-            1,
-            col_buffer_data,
-            filter.template data<T>(),
-            0,
-            Ydata,
-            &context_);
+        filter_gemm(output_image_size, col_buffer_data, Ydata);
         if (InputSize() == 3) {
           // Bias term
           math::Gemm<T, Context>(
@@ -4,6 +4,9 @@
 
 namespace caffe2 {
 
+REGISTER_CPU_OPERATOR(
+    DeformConvGradient,
+    DeformConvGradientOp<float, CPUContext>);
 OPERATOR_SCHEMA(DeformConvGradient).NumInputs(4, 4).NumOutputs(2, 4);
 
 namespace {
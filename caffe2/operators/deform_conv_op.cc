@@ -2,8 +2,290 @@
 #include "caffe2/operators/conv_pool_op_base.h"
 #include "caffe2/operators/deform_conv_op_impl.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace caffe2 {
 
+namespace {
+
+// The bilinear interpolation of the sampling points of one kernel element at
+// all the output pixels of an image: the four neighbours of every point, top
+// left, top right, bottom left and bottom right, and their weights. The points
+// only depend on the offsets, so they are shared by all the channels of a
+// deformable group. Points outside of the image have zero weights.
+struct SamplingPoints {
+  explicit SamplingPoints(int size) : lh(size), lw(size) {
+    for (int k = 0; k < 4; ++k) {
+      index[k].resize(size);
+      weight[k].resize(size);
+    }
+  }
+
+  std::vector<int> index[4];
+  std::vector<float> weight[4];
+  // The fractional parts of the coordinates, 0 at the bottom and right
+  // borders of the image
+  std::vector<float> lh;
+  std::vector<float> lw;
+};
+
+// h_base and w_base are the coordinates of the kernel element in the input
+// for the output pixel (0, 0), without offset.
+void ComputeSamplingPoints(
+    const float* offset_h,
+    const float* offset_w,
+    const int height,
+    const int width,
+    const int height_col,
+    const int width_col,
+    const int h_base,
+    const int w_base,
+    const int stride_h,
+    const int stride_w,
+    SamplingPoints* points) {
+  for (int h_col = 0; h_col < height_col; ++h_col) {
+    for (int w_col = 0; w_col < width_col; ++w_col) {
+      const int p = h_col * width_col + w_col;
+      const float h_im = h_col * stride_h + h_base + offset_h[p];
+      const float w_im = w_col * stride_w + w_base + offset_w[p];
+      if (!(h_im >= 0 && w_im >= 0 && h_im < height && w_im < width)) {
+        for (int k = 0; k < 4; ++k) {
+          points->index[k][p] = 0;
+          points->weight[k][p] = 0;
+        }
+        points->lh[p] = 0;
+        points->lw[p] = 0;
+        continue;
+      }
+      int h_low = static_cast<int>(h_im);
+      int w_low = static_cast<int>(w_im);
+      int h_high = h_low + 1;
+      int w_high = w_low + 1;
+      float lh = h_im - h_low;
+      float lw = w_im - w_low;
+      if (h_low >= height - 1) {
+        h_high = h_low = height - 1;
+        lh = 0;
+      }
+      if (w_low >= width - 1) {
+        w_high = w_low = width - 1;
+        lw = 0;
+      }
+      points->index[0][p] = h_low * width + w_low;
+      points->index[1][p] = h_low * width + w_high;
+      points->index[2][p] = h_high * width + w_low;
+      points->index[3][p] = h_high * width + w_high;
+      points->weight[0][p] = (1 - lh) * (1 - lw);
+      points->weight[1][p] = (1 - lh) * lw;
+      points->weight[2][p] = lh * (1 - lw);
+      points->weight[3][p] = lh * lw;
+      points->lh[p] = lh;
+      points->lw[p] = lw;
+    }
+  }
+}
+
+} // namespace
+
+// The CPU helpers go over the output pixels of one kernel element and one
+// channel at a time, so that the inner loops run over contiguous rows of the
+// column buffer and vectorize, and the interpolation is computed once per
+// deformable group instead of once per channel.
+template <>
+void DeformConvOpBase<float, CPUContext>::DeformableIm2col(
+    const float* data_im,
+    const float* data_offset,
+    const std::vector<TIndex>& im_shape,
+    const std::vector<TIndex>& col_shape,
+    float* data_col) {
+  CAFFE_ENFORCE_EQ(pad_t(), pad_b());
+  CAFFE_ENFORCE_EQ(pad_l(), pad_r());
+  const int num_images = im_shape[0];
+  const int channels = im_shape[1];
+  const int height = im_shape[2];
+  const int width = im_shape[3];
+  const int height_col = col_shape[1];
+  const int width_col = col_shape[2];
+  const int image_size = height * width;
+  const int col_image_size = height_col * width_col;
+  const int kernel_size = kernel_h() * kernel_w();
+  const int channel_per_deformable_group = channels / deformable_group_;
+
+  SamplingPoints points(col_image_size);
+  for (int b = 0; b < num_images; ++b) {
+    for (int g = 0; g < deformable_group_; ++g) {
+      const float* offset = data_offset +
+          (b * deformable_group_ + g) * 2 * kernel_size * col_image_size;
+      for (int k = 0; k < kernel_size; ++k) {
+        ComputeSamplingPoints(
+            offset + 2 * k * col_image_size,
+            offset + (2 * k + 1) * col_image_size,
+            height,
+            width,
+            height_col,
+            width_col,
+            k / kernel_w() * dilation_h() - pad_t(),
+            k % kernel_w() * dilation_w() - pad_l(),
+            stride_h(),
+            stride_w(),
+            &points);
+        const int* i0 = points.index[0].data();
+        const int* i1 = points.index[1].data();
+        const int* i2 = points.index[2].data();
+        const int* i3 = points.index[3].data();
+        const float* w0 = points.weight[0].data();
+        const float* w1 = points.weight[1].data();
+        const float* w2 = points.weight[2].data();
+        const float* w3 = points.weight[3].data();
+        for (int c = g * channel_per_deformable_group;
+             c < (g + 1) * channel_per_deformable_group;
+             ++c) {
+          const float* im = data_im + (b * channels + c) * image_size;
+          float* col = data_col +
+              ((b * channels + c) * kernel_size + k) * col_image_size;
+          for (int p = 0; p < col_image_size; ++p) {
+            col[p] = w0[p] * im[i0[p]] + w1[p] * im[i1[p]] +
+                w2[p] * im[i2[p]] + w3[p] * im[i3[p]];
+          }
+        }
+      }
+    }
+  }
+}
+
+template <>
+void DeformConvOpBase<float, CPUContext>::DeformableCol2im(
+    const float* data_col,
+    const float* data_offset,
+    const std::vector<TIndex>& im_shape,
+    const std::vector<TIndex>& col_shape,
+    float* grad_im) {
+  CAFFE_ENFORCE_EQ(pad_t(), pad_b());
+  CAFFE_ENFORCE_EQ(pad_l(), pad_r());
+  const int num_images = im_shape[0];
+  const int channels = im_shape[1];
+  const int height = im_shape[2];
+  const int width = im_shape[3];
+  const int height_col = col_shape[1];
+  const int width_col = col_shape[2];
+  const int image_size = height * width;
+  const int col_image_size = height_col * width_col;
+  const int kernel_size = kernel_h() * kernel_w();
+  const int channel_per_deformable_group = channels / deformable_group_;
+
+  SamplingPoints points(col_image_size);
+  for (int b = 0; b < num_images; ++b) {
+    for (int g = 0; g < deformable_group_; ++g) {
+      const float* offset = data_offset +
+          (b * deformable_group_ + g) * 2 * kernel_size * col_image_size;
+      for (int k = 0; k < kernel_size; ++k) {
+        ComputeSamplingPoints(
+            offset + 2 * k * col_image_size,
+            offset + (2 * k + 1) * col_image_size,
+            height,
+            width,
+            height_col,
+            width_col,
+            k / kernel_w() * dilation_h() - pad_t(),
+            k % kernel_w() * dilation_w() - pad_l(),
+            stride_h(),
+            stride_w(),
+            &points);
+        for (int c = g * channel_per_deformable_group;
+             c < (g + 1) * channel_per_deformable_group;
+             ++c) {
+          float* im = grad_im + (b * channels + c) * image_size;
+          const float* col = data_col +
+              ((b * channels + c) * kernel_size + k) * col_image_size;
+          for (int n = 0; n < 4; ++n) {
+            const int* index = points.index[n].data();
+            const float* weight = points.weight[n].data();
+            for (int p = 0; p < col_image_size; ++p) {
+              im[index[p]] += weight[p] * col[p];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+template <>
+void DeformConvOpBase<float, CPUContext>::DeformableCol2imCoord(
+    const float* data_col,
+    const float* data_im,
+    const float* data_offset,
+    const std::vector<TIndex>& im_shape,
+    const std::vector<TIndex>& col_shape,
+    float* grad_offset) {
+  CAFFE_ENFORCE_EQ(pad_t(), pad_b());
+  CAFFE_ENFORCE_EQ(pad_l(), pad_r());
+  const int num_images = im_shape[0];
+  const int channels = im_shape[1];
+  const int height = im_shape[2];
+  const int width = im_shape[3];
+  const int height_col = col_shape[1];
+  const int width_col = col_shape[2];
+  const int image_size = height * width;
+  const int col_image_size = height_col * width_col;
+  const int kernel_size = kernel_h() * kernel_w();
+  const int channel_per_deformable_group = channels / deformable_group_;
+
+  SamplingPoints points(col_image_size);
+  for (int b = 0; b < num_images; ++b) {
+    for (int g = 0; g < deformable_group_; ++g) {
+      const int offset_index =
+          (b * deformable_group_ + g) * 2 * kernel_size * col_image_size;
+      const float* offset = data_offset + offset_index;
+      for (int k = 0; k < kernel_size; ++k) {
+        ComputeSamplingPoints(
+            offset + 2 * k * col_image_size,
+            offset + (2 * k + 1) * col_image_size,
+            height,
+            width,
+            height_col,
+            width_col,
+            k / kernel_w() * dilation_h() - pad_t(),
+            k % kernel_w() * dilation_w() - pad_l(),
+            stride_h(),
+            stride_w(),
+            &points);
+        const int* i0 = points.index[0].data();
+        const int* i1 = points.index[1].data();
+        const int* i2 = points.index[2].data();
+        const int* i3 = points.index[3].data();
+        const float* lh = points.lh.data();
+        const float* lw = points.lw.data();
+        float* grad_h = grad_offset + offset_index + 2 * k * col_image_size;
+        float* grad_w = grad_h + col_image_size;
+        std::fill(grad_h, grad_h + 2 * col_image_size, 0.f);
+        // Outside of the image, all the neighbours are the same pixel, and
+        // the derivatives of the interpolation vanish.
+        for (int c = g * channel_per_deformable_group;
+             c < (g + 1) * channel_per_deformable_group;
+             ++c) {
+          const float* im = data_im + (b * channels + c) * image_size;
+          const float* col = data_col +
+              ((b * channels + c) * kernel_size + k) * col_image_size;
+          for (int p = 0; p < col_image_size; ++p) {
+            const float v0 = im[i0[p]];
+            const float v1 = im[i1[p]];
+            const float v2 = im[i2[p]];
+            const float v3 = im[i3[p]];
+            grad_h[p] +=
+                col[p] * ((1 - lw[p]) * (v2 - v0) + lw[p] * (v3 - v1));
+            grad_w[p] +=
+                col[p] * ((1 - lh[p]) * (v1 - v0) + lh[p] * (v3 - v2));
+          }
+        }
+      }
+    }
+  }
+}
+
+REGISTER_CPU_OPERATOR(DeformConv, DeformConvOp<float, CPUContext>);
+
 OPERATOR_SCHEMA(DeformConv)
     .NumInputs(3, 4)
     .NumOutputs(1)
@@ -18,6 +300,10 @@ sizes are specified in the Input docs for this operator. As is expected, the
 filter is convolved with a subset of the image using the deformed kernel as
 specified by offsets blob and the bias is added; this is done throughout the
 image data and the output is computed.
+
+The columns of several images are computed together and multiplied with the
+filter in one batched GEMM: as many images as the im2col_batch_size argument,
+or by default as many as fit in a 64 MB column buffer.
   )DOC")
     .Input(
         0,
@@ -53,4 +339,14 @@ image data and the output is computed.
         "stride size, and pad lengths."
         "");
 
+OPERATOR_SCHEMA(DeformConvFp16)
+    .NumInputs(3, 4)
+    .NumOutputs(1)
+    .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForConv)
+    .SetDoc(R"DOC(
+DeformConv on float16 data, for inference on CUDA: the sampling is interpolated
+in float, and the GEMMs accumulate in float.
+  )DOC");
+NO_GRADIENT(DeformConvFp16);
+
 } // namespace caffe2
@@ -64,49 +64,50 @@
 #include "caffe2/core/context_gpu.h"
 #include "caffe2/operators/deform_conv_op.h"
 #include "caffe2/operators/deform_conv_op_impl.h"
+#include "caffe2/utils/conversions.h"
 
 namespace caffe2 {
 
 typedef TIndex index_t;
 typedef std::vector<TIndex> TShape;
 
-template <typename DType>
-__device__ DType deformable_im2col_bilinear(
-    const DType* bottom_data,
+template <typename T>
+__device__ float deformable_im2col_bilinear(
+    const T* bottom_data,
     const int data_width,
     const int height,
     const int width,
-    DType h,
-    DType w) {
+    float h,
+    float w) {
   int h_low = floor(h);
   int w_low = floor(w);
   int h_high;
   int w_high;
   if (h_low >= height - 1) {
     h_high = h_low = height - 1;
-    h = (DType)h_low;
+    h = (float)h_low;
   } else {
     h_high = h_low + 1;
   }
 
   if (w_low >= width - 1) {
     w_high = w_low = width - 1;
-    w = (DType)w_low;
+    w = (float)w_low;
   } else {
     w_high = w_low + 1;
   }
 
-  DType lh = h - h_low;
-  DType lw = w - w_low;
-  DType hh = 1 - lh, hw = 1 - lw;
+  float lh = h - h_low;
+  float lw = w - w_low;
+  float hh = 1 - lh, hw = 1 - lw;
 
-  DType v1 = bottom_data[h_low * data_width + w_low];
-  DType v2 = bottom_data[h_low * data_width + w_high];
-  DType v3 = bottom_data[h_high * data_width + w_low];
-  DType v4 = bottom_data[h_high * data_width + w_high];
-  DType w1 = hh * hw, w2 = hh * lw, w3 = lh * hw, w4 = lh * lw;
+  float v1 = convert::To<T, float>(bottom_data[h_low * data_width + w_low]);
+  float v2 = convert::To<T, float>(bottom_data[h_low * data_width + w_high]);
+  float v3 = convert::To<T, float>(bottom_data[h_high * data_width + w_low]);
+  float v4 = convert::To<T, float>(bottom_data[h_high * data_width + w_high]);
+  float w1 = hh * hw, w2 = hh * lw, w3 = lh * hw, w4 = lh * lw;
 
-  DType val = (w1 * v1 + w2 * v2 + w3 * v3 + w4 * v4);
+  float val = (w1 * v1 + w2 * v2 + w3 * v3 + w4 * v4);
   return val;
 }
 
@@ -222,12 +223,14 @@ __device__ DType get_coordinate_weight(
 /*!
  * \brief deformable_im2col gpu kernel.
  * DO NOT call this directly. Use wrapper function im2col() instead;
+ * Interpolates in float, so that it also serves float16 data.
  */
-template <typename DType>
+template <typename T>
 __global__ void deformable_im2col_gpu_kernel(
     const int n,
-    const DType* data_im,
-    const DType* data_offset,
+    const T* data_im,
+    const T* data_offset,
+    const int channels,
     const int height,
     const int width,
     const int kernel_h,
@@ -239,14 +242,17 @@ __global__ void deformable_im2col_gpu_kernel(
     const int dilation_h,
     const int dilation_w,
     const int channel_per_deformable_group,
+    const int deformable_group,
     const int height_col,
     const int width_col,
-    DType* data_col) {
+    T* data_col) {
   CUDA_1D_KERNEL_LOOP(index, n) {
     // index index of output matrix
     const int w_col = index % width_col;
     const int h_col = (index / width_col) % height_col;
-    const int c_im = (index / width_col) / height_col;
+    const int c_im = (index / width_col / height_col) % channels;
+    // image of the batch
+    const int b = index / width_col / height_col / channels;
     const int c_col = c_im * kernel_h * kernel_w;
 
     // compute deformable group index
@@ -254,12 +260,15 @@ __global__ void deformable_im2col_gpu_kernel(
 
     const int h_in = h_col * stride_h - pad_h;
     const int w_in = w_col * stride_w - pad_w;
-    DType* data_col_ptr =
-        data_col + (c_col * height_col + h_col) * width_col + w_col;
-    const DType* data_im_ptr = data_im + (c_im * height + h_in) * width + w_in;
-    const DType* data_offset_ptr = data_offset +
-        deformable_group_index * 2 * kernel_h * kernel_w * height_col *
-            width_col;
+    T* data_col_ptr = data_col +
+        ((b * channels * kernel_h * kernel_w + c_col) * height_col + h_col) *
+            width_col +
+        w_col;
+    const T* data_im_ptr =
+        data_im + ((b * channels + c_im) * height + h_in) * width + w_in;
+    const T* data_offset_ptr = data_offset +
+        (b * deformable_group + deformable_group_index) * 2 * kernel_h *
+            kernel_w * height_col * width_col;
 
     for (int i = 0; i < kernel_h; ++i) {
       for (int j = 0; j < kernel_w; ++j) {
@@ -268,20 +277,22 @@ __global__ void deformable_im2col_gpu_kernel(
         const int data_offset_w_ptr =
             ((2 * (i * kernel_w + j) + 1) * height_col + h_col) * width_col +
             w_col;
-        const DType offset_h = data_offset_ptr[data_offset_h_ptr];
-        const DType offset_w = data_offset_ptr[data_offset_w_ptr];
-        DType val = static_cast<DType>(0);
-        const DType h_im = h_in + i * dilation_h + offset_h;
-        const DType w_im = w_in + j * dilation_w + offset_w;
+        const float offset_h =
+            convert::To<T, float>(data_offset_ptr[data_offset_h_ptr]);
+        const float offset_w =
+            convert::To<T, float>(data_offset_ptr[data_offset_w_ptr]);
+        float val = 0.f;
+        const float h_im = h_in + i * dilation_h + offset_h;
+        const float w_im = w_in + j * dilation_w + offset_w;
         if (h_im >= 0 && w_im >= 0 && h_im < height && w_im < width) {
-          const DType map_h = i * dilation_h + offset_h;
-          const DType map_w = j * dilation_w + offset_w;
+          const float map_h = i * dilation_h + offset_h;
+          const float map_w = j * dilation_w + offset_w;
           const int cur_height = height - h_in;
           const int cur_width = width - w_in;
           val = deformable_im2col_bilinear(
               data_im_ptr, width, cur_height, cur_width, map_h, map_w);
         }
-        *data_col_ptr = val;
+        *data_col_ptr = convert::To<float, T>(val);
         data_col_ptr += height_col * width_col;
       }
     }
@@ -291,10 +302,12 @@ __global__ void deformable_im2col_gpu_kernel(
 /*!\brief
  * cpu function of deformable_im2col algorithm
  * \param s device stream
- * \param data_im pointer of an image (C, H, W, ...) in the image batch
- * \param data_offset pointer of offset (C, H, W, ...) in the offset batch
- * \param im_shape input image shape in dimensions (N, C, H, W,)
- * \param col_shape column buffer shape (#channels, output_im_height,
+ * \param data_im pointer of the first of im_shape[0] images (C, H, W, ...)
+ * \param data_offset pointer of the offsets (C, H, W, ...) of the first image
+ * \param im_shape input image shape in dimensions (N, C, H, W,), where N is
+ * the number of images to convert
+ * \param col_shape column buffer shape of one image (#channels,
+ * output_im_height,
  * output_im_width, ...) \param kernel_shape kernel filter shape \param pad pad
  * shape \param stride stride shape \param dilation dilation shape \param
  * deformable_group #offset group that deformable convolution use \param
@@ -313,7 +326,8 @@ void DeformConvOpBase<DType, Context>::DeformableIm2col(
   const int pad_h = pad_t();
   const int pad_w = pad_l();
   index_t channel_per_deformable_group = im_shape[1] / deformable_group_;
-  index_t num_kernels = im_shape[1] * size_from_dim_(1, col_shape);
+  index_t num_kernels =
+      im_shape[0] * im_shape[1] * size_from_dim_(1, col_shape);
   deformable_im2col_gpu_kernel<DType>
       <<<CAFFE_GET_BLOCKS(num_kernels),
          CAFFE_CUDA_NUM_THREADS,
@@ -322,6 +336,7 @@ void DeformConvOpBase<DType, Context>::DeformableIm2col(
           num_kernels,
           data_im,
           data_offset,
+          im_shape[1],
           im_shape[2],
           im_shape[3],
           kernel_h(),
@@ -333,6 +348,7 @@ void DeformConvOpBase<DType, Context>::DeformableIm2col(
           dilation_h(),
           dilation_w(),
           channel_per_deformable_group,
+          deformable_group_,
           col_shape[1],
           col_shape[2],
           data_col);
@@ -360,13 +376,18 @@ __global__ void deformable_col2im_gpu_kernel(
     const int dilation_h,
     const int dilation_w,
     const int channel_per_deformable_group,
+    const int deformable_group,
     const int height_col,
     const int width_col,
     DType* grad_im) {
   CUDA_1D_KERNEL_LOOP(index, n) {
     const int j = (index / width_col / height_col) % kernel_w;
     const int i = (index / width_col / height_col / kernel_w) % kernel_h;
-    const int c = index / width_col / height_col / kernel_w / kernel_h;
+    const int c =
+        (index / width_col / height_col / kernel_w / kernel_h) % channels;
+    // image of the batch
+    const int b =
+        index / width_col / height_col / kernel_w / kernel_h / channels;
     // compute the start and end of the output
 
     const int deformable_group_index = c / channel_per_deformable_group;
@@ -377,8 +398,8 @@ __global__ void deformable_col2im_gpu_kernel(
     int h_in = h_out * stride_h - pad_h;
 
     const DType* data_offset_ptr = data_offset +
-        deformable_group_index * 2 * kernel_h * kernel_w * height_col *
-            width_col;
+        (b * deformable_group + deformable_group_index) * 2 * kernel_h *
+            kernel_w * height_col * width_col;
     const int data_offset_h_ptr =
         ((2 * (i * kernel_w + j)) * height_col + h_out) * width_col + w_out;
     const int data_offset_w_ptr =
@@ -397,7 +418,7 @@ __global__ void deformable_col2im_gpu_kernel(
             cur_w + dx < width && abs(cur_inv_h_data - (cur_h + dy)) < 1 &&
             abs(cur_inv_w_data - (cur_w + dx)) < 1) {
           int cur_bottom_grad_pos =
-              (c * height + cur_h + dy) * width + cur_w + dx;
+              ((b * channels + c) * height + cur_h + dy) * width + cur_w + dx;
           DType weight = get_gradient_weight(
               cur_inv_h_data,
               cur_inv_w_data,
@@ -416,9 +437,10 @@ __global__ void deformable_col2im_gpu_kernel(
  * gpu function of deformable_col2im algorithm
  * \param s device stream
  * \param data_col start pointer of the column buffer to be filled
- * \param data_offset pointer of offset (C, H, W, ...) in the offset batch
- * \param im_shape input image shape in dimensions (N, C, H, W,)
- * \param col_shape column buffer shape
+ * \param data_offset pointer of the offsets (C, H, W, ...) of the first image
+ * \param im_shape input image shape in dimensions (N, C, H, W,), where N is
+ * the number of images to convert
+ * \param col_shape column buffer shape of one image
  * \param kernel_shape kernel filter shape
  * \param pad pad shape
  * \param stride stride shape
@@ -439,7 +461,7 @@ void DeformConvOpBase<DType, Context>::DeformableCol2im(
   const int pad_w = pad_l();
   index_t im_size = size_from_dim_(1, im_shape);
   index_t channel_per_deformable_group = im_shape[1] / deformable_group_;
-  index_t num_kernels = size_from_dim_(0, col_shape);
+  index_t num_kernels = im_shape[0] * size_from_dim_(0, col_shape);
   // num_axes should be smaller than block size
   CHECK_LT(2, CAFFE_CUDA_NUM_THREADS);
   // To avoid involving atomic operations, we will launch one kernel per
@@ -465,6 +487,7 @@ void DeformConvOpBase<DType, Context>::DeformableCol2im(
           dilation_h(),
           dilation_w(),
           channel_per_deformable_group,
+          deformable_group_,
           col_shape[1],
           col_shape[2],
           grad_im);
@@ -493,6 +516,7 @@ __global__ void deformable_col2im_coord_gpu_kernel(
     const int dilation_h,
     const int dilation_w,
     const int channel_per_deformable_group,
+    const int deformable_group,
     const int height_col,
     const int width_col,
     DType* grad_offset) {
@@ -500,21 +524,27 @@ __global__ void deformable_col2im_coord_gpu_kernel(
     DType val = 0;
     int w = index % width_col;
     int h = (index / width_col) % height_col;
-    int c = index / width_col / height_col;
+    int c = (index / width_col / height_col) %
+        (2 * kernel_h * kernel_w * deformable_group);
+    // image of the batch
+    int b = index / width_col / height_col /
+        (2 * kernel_h * kernel_w * deformable_group);
     // compute the start and end of the output
 
     const int deformable_group_index = c / (2 * kernel_h * kernel_w);
     const int col_step = kernel_h * kernel_w;
     int cnt = 0;
     const DType* data_col_ptr = data_col +
-        deformable_group_index * channel_per_deformable_group * width_col *
-            height_col;
+        (b * deformable_group + deformable_group_index) *
+            channel_per_deformable_group * width_col * height_col;
     const DType* data_im_ptr = data_im +
-        deformable_group_index * channel_per_deformable_group / kernel_h /
-            kernel_w * height * width;
+        (b * channels +
+         deformable_group_index * channel_per_deformable_group / kernel_h /
+             kernel_w) *
+            height * width;
     const DType* data_offset_ptr = data_offset +
-        deformable_group_index * 2 * kernel_h * kernel_w * height_col *
-            width_col;
+        (b * deformable_group + deformable_group_index) * 2 * kernel_h *
+            kernel_w * height_col * width_col;
 
     const int offset_c = c - deformable_group_index * 2 * kernel_h * kernel_w;
 
@@ -561,10 +591,11 @@ __global__ void deformable_col2im_coord_gpu_kernel(
  * gpu function of deformable_col2im_coord algorithm
  * \param s device stream
  * \param data_col start pointer of the column buffer to be filled
- * \param data_im pointer of an image (C, H, W, ...) in the image batch
- * \param data_offset pointer of offset (C, H, W, ...) in the offset batch
- * \param im_shape input image shape in dimensions (N, C, H, W,)
- * \param col_shape column buffer shape
+ * \param data_im pointer of the first of im_shape[0] images (C, H, W, ...)
+ * \param data_offset pointer of the offsets (C, H, W, ...) of the first image
+ * \param im_shape input image shape in dimensions (N, C, H, W,), where N is
+ * the number of images to convert
+ * \param col_shape column buffer shape of one image
  * \param kernel_shape kernel filter shape
  * \param pad pad shape
  * \param stride stride shape
@@ -584,8 +615,8 @@ void DeformConvOpBase<DType, Context>::DeformableCol2imCoord(
   CAFFE_ENFORCE_EQ(pad_l(), pad_r());
   const int pad_h = pad_t();
   const int pad_w = pad_l();
-  index_t num_kernels = col_shape[1] * col_shape[2] * 2 * kernel_h() *
-      kernel_w() * deformable_group_;
+  index_t num_kernels = im_shape[0] * col_shape[1] * col_shape[2] * 2 *
+      kernel_h() * kernel_w() * deformable_group_;
   index_t channel_per_deformable_group = col_shape[0] / deformable_group_;
   // num_axes should be smaller than block size
   CHECK_LT(2, CAFFE_CUDA_NUM_THREADS);
@@ -613,12 +644,14 @@ void DeformConvOpBase<DType, Context>::DeformableCol2imCoord(
           dilation_h(),
           dilation_w(),
           channel_per_deformable_group,
+          deformable_group_,
           col_shape[1],
           col_shape[2],
           grad_offset);
 }
 
 REGISTER_CUDA_OPERATOR(DeformConv, DeformConvOp<float, CUDAContext>);
+REGISTER_CUDA_OPERATOR(DeformConvFp16, DeformConvOp<float16, CUDAContext>);
 REGISTER_CUDA_OPERATOR(
     DeformConvGradient,
     DeformConvGradientOp<float, CUDAContext>);
@@ -1,6 +1,8 @@
 #ifndef CAFFE2_OPERATORS_DEFORM_CONV_OP_H_
 #define CAFFE2_OPERATORS_DEFORM_CONV_OP_H_
 
+#include <algorithm>
+
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/operators/conv_op_shared.h"
@@ -17,10 +19,17 @@ class DeformConvOpBase : public ConvPoolOpBase<Context> {
   DeformConvOpBase(const OperatorDef& operator_def, Workspace* ws)
       : ConvPoolOpBase<Context>(operator_def, ws),
         deformable_group_(
-            OperatorBase::GetSingleArgument<int>("deformable_group", 1)) {}
+            OperatorBase::GetSingleArgument<int>("deformable_group", 1)),
+        im2col_batch_size_(
+            OperatorBase::GetSingleArgument<int>("im2col_batch_size", 0)) {
+    CAFFE_ENFORCE_GE(im2col_batch_size_, 0);
+  }
   ~DeformConvOpBase() {}
 
  protected:
+  // The helpers below convert im_shape[0] images at once: data_im and
+  // data_offset point to the first one, and the column buffers of the images
+  // follow each other, each of col_shape.
   void DeformableIm2col(
       const T* data_im,
       const T* data_offset,
@@ -41,13 +50,30 @@ class DeformConvOpBase : public ConvPoolOpBase<Context> {
       const std::vector<TIndex>& col_shape,
       T* grad_offset);
 
+  // The number of images whose column buffers are computed together and
+  // multiplied with the filter by a single batched GEMM. Unless set with
+  // im2col_batch_size, as many as fit in kMaxColBufferBytes.
+  int ImagesPerGemm(int num_images, size_t col_bytes_per_image) const {
+    if (im2col_batch_size_ > 0) {
+      return std::min(im2col_batch_size_, num_images);
+    }
+    const size_t fit =
+        kMaxColBufferBytes / std::max<size_t>(col_bytes_per_image, 1);
+    return static_cast<int>(
+        std::max<size_t>(1, std::min<size_t>(fit, num_images)));
+  }
+
  protected:
+  static constexpr size_t kMaxColBufferBytes = 64 << 20;
+
   int deformable_group_;
+  int im2col_batch_size_;
 
 #define USE_DEFORMABLE_CONV_BASE_FUNCTIONS(T, Context)   \
   USE_CONV_POOL_BASE_FUNCTIONS(Context);                 \
   using DeformConvOpBase<T, Context>::deformable_group_; \
   using DeformConvOpBase<T, Context>::DeformableIm2col;  \
+  using DeformConvOpBase<T, Context>::ImagesPerGemm;     \
   using DeformConvOpBase<T, Context>::DeformableCol2im;  \
   using DeformConvOpBase<T, Context>::DeformableCol2imCoord
 };
@@ -107,6 +133,30 @@ class DeformConvGradientOp final : public DeformConvOpBase<T, Context> {
   OUTPUT_TAGS(OFFSET_GRAD, FILTER_GRAD, BIAS_OR_INPUT_GRAD, INPUT_GRAD);
 };
 
+// The CPU versions of the helpers, in deform_conv_op.cc
+template <>
+void DeformConvOpBase<float, CPUContext>::DeformableIm2col(
+    const float* data_im,
+    const float* data_offset,
+    const std::vector<TIndex>& im_shape,
+    const std::vector<TIndex>& col_shape,
+    float* data_col);
+template <>
+void DeformConvOpBase<float, CPUContext>::DeformableCol2im(
+    const float* data_col,
+    const float* data_offset,
+    const std::vector<TIndex>& im_shape,
+    const std::vector<TIndex>& col_shape,
+    float* grad_im);
+template <>
+void DeformConvOpBase<float, CPUContext>::DeformableCol2imCoord(
+    const float* data_col,
+    const float* data_im,
+    const float* data_offset,
+    const std::vector<TIndex>& im_shape,
+    const std::vector<TIndex>& col_shape,
+    float* grad_offset);
+
 } // namespace caffe2
 
 #endif // CAFFE2_OPERATORS_DEFORM_CONV_OP_H_
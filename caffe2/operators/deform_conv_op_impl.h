@@ -2,12 +2,15 @@
 #ifndef CAFFE2_OPERATORS_DEFORM_CONV_OP_IMPL_H_
 #define CAFFE2_OPERATORS_DEFORM_CONV_OP_IMPL_H_
 
+#include <algorithm>
+
 #include "caffe2/core/context.h"
 #include "caffe2/core/flags.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/operators/conv_pool_op_base.h"
 #include "caffe2/operators/deform_conv_op.h"
+#include "caffe2/utils/conversions.h"
 #include "caffe2/utils/math.h"
 
 namespace caffe2 {
@@ -89,13 +92,18 @@ bool DeformConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   const int input_image_size = this->GetDimsSize(X);
   const int output_image_size = this->GetDimsSize(*Y);
 
-  vector<int> img_shape;
-  img_shape.assign(X.dims().begin() + 1, X.dims().end());
+  // The col buffer of an image is stored in CHW order as well - the kernel_dim
+  // of every group, and the height and width. The col buffers of the images
+  // converted together follow each other.
+  vector<TIndex> col_shape;
+  col_shape.push_back(C * kernel_dims_size);
+  col_shape.insert(col_shape.end(), output_dims.begin(), output_dims.end());
+  const int col_size = C * kernel_dims_size * output_image_size;
+  const int images_per_gemm = ImagesPerGemm(N, col_size * sizeof(T));
 
-  vector<int> buffer_shape;
-  buffer_shape.push_back(C / group_ * kernel_dims_size);
-  buffer_shape.insert(
-      buffer_shape.end(), output_dims.begin(), output_dims.end());
+  vector<TIndex> im_shape(X.dims());
+  vector<TIndex> buffer_shape(col_shape);
+  buffer_shape.insert(buffer_shape.begin(), images_per_gemm);
 
   // The dimension of each kernel
   const int kernel_dim = C / group_ * kernel_dims_size;
@@ -106,8 +114,6 @@ bool DeformConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   const int offset_offset = offset.size() / offset.dim32(0);
   const int filter_offset = filter.size() / group_;
 
-  // The col buffer is stored in CHW order as well - kernel_dim, and the height
-  // and width.
   const T* Xdata = X.template data<T>();
   const T* offset_data = offset.template data<T>();
 
@@ -122,7 +128,7 @@ bool DeformConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
       bias_multiplier_.Resize(vector<TIndex>(1, output_image_size));
       math::Set<T, Context>(
           output_image_size,
-          static_cast<T>(1),
+          convert::To<float, T>(1),
           bias_multiplier_.template mutable_data<T>(),
           &context_);
     }
@@ -136,46 +142,53 @@ bool DeformConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   auto f = [&](Tensor<Context>* col_buffer) {
     col_buffer->Resize(buffer_shape);
     T* col_buffer_data = col_buffer->template mutable_data<T>();
-    // Im2col, followed by gemm.
-    for (int image_id = 0; image_id < N; ++image_id) {
+    // Im2col of several images, followed by one gemm per group for all of
+    // them, with the filter broadcast over the images.
+    for (int image_id = 0; image_id < N; image_id += images_per_gemm) {
+      const int num_images = std::min(images_per_gemm, N - image_id);
+      im_shape[0] = num_images;
+      DeformableIm2col(
+          Xdata, offset_data, im_shape, col_shape, col_buffer_data);
       for (int group_id = 0; group_id < group_; ++group_id) {
-        DeformableIm2col(
-            Xdata + group_id * input_offset,
-            offset_data,
-            X.dims(),
-            col_buffer->dims(),
-            col_buffer_data);
         // Weight term
-        math::Gemm<T, Context>(
+        math::GemmStridedBatched<T, Context>(
             CblasNoTrans,
             CblasNoTrans,
+            num_images,
             M / group_,
             output_image_size,
             kernel_dim,
             1,
             filter.template data<T>() + group_id * filter_offset,
-            col_buffer_data,
+            0,
+            col_buffer_data + group_id * kernel_dim * output_image_size,
+            col_size,
             0,
             Ydata + group_id * output_offset,
+            M * output_image_size,
             &context_);
       }
       if (bias_data) {
-        math::Gemm<T, Context>(
+        math::GemmStridedBatched<T, Context>(
             CblasNoTrans,
             CblasNoTrans,
+            num_images,
             M,
             output_image_size,
             1,
             1,
             bias_data,
+            0,
             bias_multiplier_.template data<T>(),
+            0,
             1,
             Ydata,
+            M * output_image_size,
             &context_);
       }
-      Xdata += input_offset * group_;
-      Ydata += output_offset * group_;
-      offset_data += offset_offset;
+      Xdata += input_offset * group_ * num_images;
+      Ydata += output_offset * group_ * num_images;
+      offset_data += offset_offset * num_images;
     }
   };
 
@@ -272,17 +285,21 @@ bool DeformConvGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   const int offset_offset = offset.size() / offset.dim32(0);
   const int filter_offset = filter.size() / group_;
 
-  // The col buffer is stored in CHW order as well - kernel_dim, and the
-  // height and width.
-  vector<TIndex> img_shape;
-  img_shape.assign(X.dims().begin() + 1, X.dims().end());
-  vector<TIndex> col_buffer_shape;
-  col_buffer_shape.push_back(C * kernel_dims_size);
-  col_buffer_shape.insert(
-      col_buffer_shape.end(), output_dims.begin(), output_dims.end());
-  col_buffer_.Resize(col_buffer_shape);
+  // The col buffer of an image is stored in CHW order as well - the
+  // kernel_dim of every group, and the height and width. The col buffers of
+  // the images converted together follow each other.
+  vector<TIndex> col_shape;
+  col_shape.push_back(C * kernel_dims_size);
+  col_shape.insert(col_shape.end(), output_dims.begin(), output_dims.end());
+  const int col_size = C * kernel_dims_size * output_image_size;
+  const int images_per_gemm = ImagesPerGemm(N, col_size * sizeof(T));
+
+  vector<TIndex> im_shape(X.dims());
+  vector<TIndex> buffer_shape(col_shape);
+  buffer_shape.insert(buffer_shape.begin(), images_per_gemm);
+  col_buffer_.Resize(buffer_shape);
 
-  const int col_buffer_offset = col_buffer_.size() / group_;
+  const int col_buffer_offset = kernel_dim * output_image_size;
 
   const T* Xdata = X.template data<T>();
   const T* filter_data = filter.template data<T>();
@@ -320,75 +337,77 @@ bool DeformConvGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
     math::Set<T, Context>(dX->size(), 0, dXdata, &context_);
   }
 
-  for (int image_id = 0; image_id < N; ++image_id) {
+  for (int image_id = 0; image_id < N; image_id += images_per_gemm) {
+    const int num_images = std::min(images_per_gemm, N - image_id);
+    im_shape[0] = num_images;
     for (int group_id = 0; group_id < group_; ++group_id) {
-      math::Gemm<T, Context>(
+      math::GemmStridedBatched<T, Context>(
           CblasTrans,
           CblasNoTrans,
+          num_images,
           kernel_dim,
           output_image_size,
           M / group_,
           1,
           filter_data + group_id * filter_offset,
+          0,
           dYdata + group_id * output_offset,
+          M * output_image_size,
           0,
           col_buffer_data + group_id * col_buffer_offset,
+          col_size,
           &context_);
     }
 
     // Gradient with respect to offsets
     DeformableCol2imCoord(
-        col_buffer_data,
-        Xdata,
-        offset_data,
-        X.dims(),
-        col_buffer_shape,
-        doffset_data);
+        col_buffer_data, Xdata, offset_data, im_shape, col_shape, doffset_data);
 
     // Gradient with respect to input data
     if (dXdata) {
       DeformableCol2im(
-          col_buffer_data, offset_data, X.dims(), col_buffer_shape, dXdata);
-      dXdata += input_offset * group_;
+          col_buffer_data, offset_data, im_shape, col_shape, dXdata);
+      dXdata += input_offset * group_ * num_images;
     }
 
     // Gradient with respect to filter
-    DeformableIm2col(
-        Xdata, offset_data, X.dims(), col_buffer_shape, col_buffer_data);
+    DeformableIm2col(Xdata, offset_data, im_shape, col_shape, col_buffer_data);
 
-    for (int group_id = 0; group_id < group_; ++group_id) {
-      math::Gemm<T, Context>(
-          CblasNoTrans,
-          CblasTrans,
-          M / group_,
-          kernel_dim,
-          output_image_size,
-          1,
-          dYdata + group_id * output_offset,
-          col_buffer_data + group_id * col_buffer_offset,
-          1,
-          dfilter_data + group_id * filter_offset,
-          &context_);
-    }
+    for (int i = 0; i < num_images; ++i) {
+      for (int group_id = 0; group_id < group_; ++group_id) {
+        math::Gemm<T, Context>(
+            CblasNoTrans,
+            CblasTrans,
+            M / group_,
+            kernel_dim,
+            output_image_size,
+            1,
+            dYdata + i * M * output_image_size + group_id * output_offset,
+            col_buffer_data + i * col_size + group_id * col_buffer_offset,
+            1,
+            dfilter_data + group_id * filter_offset,
+            &context_);
+      }
 
-    // Gradient with respect to bias
-    if (dbias_data) {
-      math::Gemv<T, Context>(
-          CblasNoTrans,
-          M,
-          output_image_size,
-          1,
-          dYdata,
-          bias_multiplier_.template data<T>(),
-          1,
-          dbias_data,
-          &context_);
+      // Gradient with respect to bias
+      if (dbias_data) {
+        math::Gemv<T, Context>(
+            CblasNoTrans,
+            M,
+            output_image_size,
+            1,
+            dYdata + i * M * output_image_size,
+            bias_multiplier_.template data<T>(),
+            1,
+            dbias_data,
+            &context_);
+      }
     }
 
-    Xdata += input_offset * group_;
-    dYdata += output_offset * group_;
-    offset_data += offset_offset;
-    doffset_data += offset_offset;
+    Xdata += input_offset * group_ * num_images;
+    dYdata += output_offset * group_ * num_images;
+    offset_data += offset_offset * num_images;
+    doffset_data += offset_offset * num_images;
   }
 
   return true;
@@ -21,9 +21,24 @@ bool DropoutOp<float, CPUContext>::RunOnDevice() {
     const float* Xdata = X.data<float>();
     float* Ydata = Y->mutable_data<float>();
     auto mask = Output(1);
+    auto& gen = context_.RandGenerator();
+    if (pack_mask_) {
+      const TIndex N = X.size();
+      mask->Resize((N + 7) / 8);
+      uint8_t* mask_data = mask->mutable_data<uint8_t>();
+      for (TIndex i = 0; i < N; i += 8) {
+        uint8_t bits = 0;
+        for (TIndex j = i; j < std::min(i + 8, N); ++j) {
+          const bool keep = dist(gen);
+          bits |= keep << (j - i);
+          Ydata[j] = keep ? Xdata[j] * scale : 0;
+        }
+        mask_data[i / 8] = bits;
+      }
+      return true;
+    }
     mask->Resize(X.dims());
     bool* mask_data = mask->mutable_data<bool>();
-    auto& gen = context_.RandGenerator();
     for (int i = 0; i < X.size(); ++i) {
       mask_data[i] = dist(gen);
       Ydata[i] = Xdata[i] * scale * mask_data[i];
@@ -45,11 +60,21 @@ bool DropoutGradientOp<float, CPUContext>::RunOnDevice() {
     return true;
   } else {
     auto& mask = Input(1);
-    CAFFE_ENFORCE_EQ(dY.size(), mask.size());
     const float* dYdata = dY.data<float>();
-    const bool* mask_data = mask.data<bool>();
     float* dXdata = dX->mutable_data<float>();
     float scale = 1. / (1. - ratio_);
+    if (mask.IsType<uint8_t>()) {
+      // A packed mask, see DropoutOp
+      CAFFE_ENFORCE_EQ((dY.size() + 7) / 8, mask.size());
+      const uint8_t* mask_data = mask.data<uint8_t>();
+      for (TIndex i = 0; i < dY.size(); ++i) {
+        const bool keep = (mask_data[i / 8] >> (i % 8)) & 1;
+        dXdata[i] = keep ? dYdata[i] * scale : 0;
+      }
+      return true;
+    }
+    CAFFE_ENFORCE_EQ(dY.size(), mask.size());
+    const bool* mask_data = mask.data<bool>();
     for (int i = 0; i < dY.size(); ++i) {
       dXdata[i] = dYdata[i] * mask_data[i] * scale;
     }
@@ -71,7 +96,16 @@ OPERATOR_SCHEMA(Dropout)
       ArgumentHelper argsHelper(def);
       out.push_back(in[0]);
       auto output_mask = !argsHelper.GetSingleArgument<bool>("is_test", 0);
-      if (output_mask) {
+      if (output_mask &&
+          argsHelper.GetSingleArgument<bool>("pack_mask", false)) {
+        int64_t size = 1;
+        for (auto d : in[0].dims()) {
+          size *= d;
+        }
+        out.push_back(
+            CreateTensorShape(vector<int64_t>{(size + 7) / 8},
+                              TensorProto_DataType_UINT8));
+      } else if (output_mask) {
         out.push_back(in[0]);
         out[1].set_data_type(TensorProto_DataType_BOOL);
       }
@@ -85,6 +119,12 @@ copy of the input. Note that our implementation of Dropout does scaling in
 the training phase, so during testing nothing needs to be done.
 )DOC")
     .Arg("ratio", "(float, default 0.5) the ratio of random dropout")
+    .Arg(
+        "pack_mask",
+        "(bool, default false) if set, the mask is a uint8 tensor holding one "
+        "bit per element of the input, bit i % 8 of byte i / 8 being set if "
+        "element i is kept, which takes an eighth of the memory of the bool "
+        "mask.")
     .ArgIsTest(
         "(int) if nonzero, run dropout in test mode where "
         "the output is simply Y = X.")
@@ -99,7 +139,11 @@ the training phase, so during testing nothing needs to be done.
 OPERATOR_SCHEMA(DropoutGrad)
     .NumInputs(1, 2)
     .NumOutputs(1)
-    .AllowInplace({{0, 0}});
+    .AllowInplace({{0, 0}})
+    .SetDoc(R"DOC(
+Computes the gradient of Dropout from the gradient of its output and the mask
+it produced, either a bool mask or a packed uint8 one.
+)DOC");
 
 class GetDropoutGradient : public GradientMakerBase {
   using GradientMakerBase::GradientMakerBase;
@@ -1,3 +1,5 @@
+#include <curand_kernel.h>
+
 #include "caffe2/core/context_gpu.h"
 #include "caffe2/operators/dropout_op.h"
 
@@ -16,6 +18,33 @@ __global__ void DropoutKernel(
     Ydata[i] = Xdata[i] * scale * maskdata[i];
   }
 }
+
+// Each thread handles the 8 elements of one byte of the mask, sampling them
+// from its own Philox subsequence, so that X is read and Y and the mask
+// written in a single pass, and in-place dropout works.
+__global__ void PackedDropoutKernel(
+    const int N,
+    const float ratio,
+    const unsigned long long seed,
+    const unsigned long long offset,
+    const float* Xdata,
+    float* Ydata,
+    uint8_t* maskdata) {
+  const float scale = 1. / (1. - ratio);
+  CUDA_1D_KERNEL_LOOP(i, (N + 7) / 8) {
+    curandStatePhilox4_32_10_t state;
+    curand_init(seed, i, offset, &state);
+    const float4 r[2] = {curand_uniform4(&state), curand_uniform4(&state)};
+    const float* u = reinterpret_cast<const float*>(r);
+    uint8_t bits = 0;
+    for (int j = 0; j < 8 && i * 8 + j < N; ++j) {
+      const bool keep = u[j] > ratio;
+      bits |= keep << j;
+      Ydata[i * 8 + j] = keep ? Xdata[i * 8 + j] * scale : 0;
+    }
+    maskdata[i] = bits;
+  }
+}
 } // namespace
 
 template <>
@@ -29,6 +58,24 @@ bool DropoutOp<float, CUDAContext>::RunOnDevice() {
           X.size(), X.data<float>(), Y->mutable_data<float>());
     }
     return true;
+  } else if (pack_mask_) {
+    auto* mask = Output(1);
+    mask->Resize((X.size() + 7) / 8);
+    PackedDropoutKernel<<<
+        CAFFE_GET_BLOCKS(mask->size()),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        X.size(),
+        ratio_,
+        seed_,
+        offset_,
+        X.data<float>(),
+        Y->mutable_data<float>(),
+        mask->mutable_data<uint8_t>());
+    // Every thread drew 8 numbers of its subsequence
+    offset_ += 8;
+    return true;
   } else {
     // We do a simple trick here: since curand cannot generate random
     // boolean numbers, we will generate into dY and write the result to
@@ -60,6 +107,18 @@ __global__ void DropoutGradientKernel(
     dXdata[i] = dYdata[i] * maskdata[i] * scale;
   }
 }
+
+__global__ void PackedDropoutGradientKernel(
+    const int N,
+    const float* dYdata,
+    const uint8_t* maskdata,
+    const float scale,
+    float* dXdata) {
+  CUDA_1D_KERNEL_LOOP(i, N) {
+    const bool keep = (maskdata[i / 8] >> (i % 8)) & 1;
+    dXdata[i] = keep ? dYdata[i] * scale : 0;
+  }
+}
 } // namespace
 
 template <>
@@ -75,8 +134,22 @@ bool DropoutGradientOp<float, CUDAContext>::RunOnDevice() {
     return true;
   } else {
     auto& mask = Input(1);
-    CAFFE_ENFORCE_EQ(dY.size(), mask.size());
     const float scale = 1. / (1. - ratio_);
+    if (mask.IsType<uint8_t>()) {
+      CAFFE_ENFORCE_EQ((dY.size() + 7) / 8, mask.size());
+      PackedDropoutGradientKernel<<<
+          CAFFE_GET_BLOCKS(dY.size()),
+          CAFFE_CUDA_NUM_THREADS,
+          0,
+          context_.cuda_stream()>>>(
+          dY.size(),
+          dY.data<float>(),
+          mask.data<uint8_t>(),
+          scale,
+          dX->mutable_data<float>());
+      return true;
+    }
+    CAFFE_ENFORCE_EQ(dY.size(), mask.size());
     DropoutGradientKernel<<<
         CAFFE_GET_BLOCKS(dY.size()),
         CAFFE_CUDA_NUM_THREADS,
@@ -16,7 +16,12 @@ class DropoutOp final : public Operator<Context> {
       : Operator<Context>(operator_def, ws),
         ratio_(OperatorBase::GetSingleArgument<float>("ratio", 0.5)),
         is_test_(
-            OperatorBase::GetSingleArgument<int>(OpSchema::Arg_IsTest, 0)) {
+            OperatorBase::GetSingleArgument<int>(OpSchema::Arg_IsTest, 0)),
+        pack_mask_(OperatorBase::GetSingleArgument<bool>("pack_mask", false)),
+        seed_(
+            operator_def.device_option().has_random_seed()
+                ? operator_def.device_option().random_seed()
+                : RandomNumberSeed()) {
     CAFFE_ENFORCE_GE(ratio_, 0);
     CAFFE_ENFORCE_LT(ratio_, 1);
   }
@@ -26,6 +31,13 @@ class DropoutOp final : public Operator<Context> {
  protected:
   float ratio_;
   bool is_test_;
+  // If set, the mask is a uint8 tensor with one bit per element of X, the
+  // bit i % 8 of byte i / 8 being set if element i is kept.
+  bool pack_mask_;
+  // Key and counter of the Philox stream the GPU kernel samples from, so that
+  // each run draws a fresh sample without a separate pass through curand.
+  uint64_t seed_;
+  uint64_t offset_ = 0;
   // Input: X; Output: Y, mask.
 };
 
@@ -9,6 +9,7 @@
 #include "caffe2/utils/math.h"
 
 #include <tuple>
+#include <type_traits>
 
 namespace caffe2 {
 
@@ -17,6 +18,10 @@ using IntTypes = TensorTypes<int32_t, int64_t>;
 using BoolTypes = TensorTypes<bool>;
 using IntBoolTypes = TensorTypes<int32_t, int64_t, bool>; // discrete types
 
+// The smallest number of elements that the elementwise operators hand to a
+// thread of the pool when they run on the CPU
+constexpr size_t kElementwiseParallelGrain = 16384;
+
 struct SameTypeAsInput {
   template <typename T>
   using type = T;
@@ -49,11 +54,19 @@ class UnaryElementwiseWithArgsOp : public Operator<Context> {
     auto* output = Output(0);
     output->ResizeLike(input);
     using R = typename TypeMap::template type<T>;
-    functor_(
-        input.size(),
-        input.template data<T>(),
-        output->template mutable_data<R>(),
-        &context_);
+    const T* in = input.template data<T>();
+    R* out = output->template mutable_data<R>();
+    if (std::is_same<Context, CPUContext>::value) {
+      ParallelFor(
+          this->IntraOpThreadPool(),
+          input.size(),
+          kElementwiseParallelGrain,
+          [&](size_t begin, size_t end) {
+            functor_(end - begin, in + begin, out + begin, &context_);
+          });
+    } else {
+      functor_(input.size(), in, out, &context_);
+    }
     return true;
   }
 
@@ -218,9 +231,9 @@ class BinaryElementwiseOp : public Operator<Context> {
           A.dims(),
           B.dims(),
           "Dimension mismatch - did you forget to set broadcast=1?");
-      functor_.template Run<false>(A.size(), Adata, Bdata, Cdata, &context_);
+      RunElementwise<false>(A.size(), Adata, Bdata, Cdata);
     } else if (B.size() == 1) {
-      functor_.template Run<true>(A.size(), Adata, Bdata, Cdata, &context_);
+      RunElementwise<true>(A.size(), Adata, Bdata, Cdata);
     } else {
       size_t pre, n, post;
       std::tie(pre, n, post) = calculate_broadcast_sizes(A, B, axis_);
@@ -235,6 +248,24 @@ class BinaryElementwiseOp : public Operator<Context> {
   }
 
  private:
+  // The elementwise cases, split between the threads of the pool on the CPU
+  template <bool b_is_scalar, typename T, typename R>
+  void RunElementwise(size_t n, const T* a, const T* b, R* c) {
+    if (!std::is_same<Context, CPUContext>::value) {
+      functor_.template Run<b_is_scalar>(n, a, b, c, &context_);
+      return;
+    }
+    ParallelFor(
+        this->IntraOpThreadPool(),
+        n,
+        kElementwiseParallelGrain,
+        [&](size_t begin, size_t end) {
+          functor_.template Run<b_is_scalar>(
+              end - begin, a + begin, b_is_scalar ? b : b + begin, c + begin,
+              &context_);
+        });
+  }
+
   bool enable_broadcast_;
   int axis_;
   string axis_str_;
@@ -0,0 +1,72 @@
+#include "caffe2/operators/embedding_hot_row_cache.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace caffe2 {
+
+EmbeddingHotRowCache::EmbeddingHotRowCache(
+    const std::string& name,
+    TIndex capacity,
+    TIndex refresh_interval)
+    : capacity_(capacity),
+      refresh_interval_(refresh_interval),
+      stats_(name) {
+  CAFFE_ENFORCE_GT(capacity_, 0, "The cache must hold at least one row");
+  CAFFE_ENFORCE_LE(capacity_, std::numeric_limits<int32_t>::max());
+  CAFFE_ENFORCE_GT(refresh_interval_, 0);
+}
+
+void EmbeddingHotRowCache::Reset(const TensorCPU& data) {
+  table_ = data.raw_data();
+  table_rows_ = data.dim(0);
+  meta_ = data.meta();
+  row_bytes_ = data.size_from_dim(1) * data.itemsize();
+  counts_.assign(table_rows_, 0);
+  slots_.assign(table_rows_, -1);
+  cached_rows_.clear();
+  rows_.clear();
+  lookups_since_refresh_ = 0;
+}
+
+void EmbeddingHotRowCache::Refresh(const TensorCPU& data) {
+  lookups_since_refresh_ = 0;
+  std::vector<TIndex> hot;
+  for (TIndex row = 0; row < table_rows_; ++row) {
+    if (counts_[row] > 0) {
+      hot.push_back(row);
+    }
+  }
+  if (static_cast<TIndex>(hot.size()) > capacity_) {
+    std::nth_element(
+        hot.begin(),
+        hot.begin() + capacity_,
+        hot.end(),
+        [this](TIndex a, TIndex b) { return counts_[a] > counts_[b]; });
+    hot.resize(capacity_);
+  }
+  // Keep the cached rows in table order, which makes the cache layout
+  // independent of the order nth_element leaves them in.
+  std::sort(hot.begin(), hot.end());
+
+  for (TIndex row : cached_rows_) {
+    slots_[row] = -1;
+  }
+  rows_.resize(hot.size() * row_bytes_);
+  const char* table = static_cast<const char*>(data.raw_data());
+  for (size_t slot = 0; slot < hot.size(); ++slot) {
+    memcpy(
+        rows_.data() + slot * row_bytes_,
+        table + hot[slot] * row_bytes_,
+        row_bytes_);
+    slots_[hot[slot]] = slot;
+  }
+  cached_rows_.swap(hot);
+
+  for (auto& count : counts_) {
+    count >>= 1;
+  }
+  CAFFE_EVENT(stats_, refreshes);
+}
+
+} // namespace caffe2
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/stats.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/perfkernels/typed_axpy.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+// Keeps copies of the most frequently looked up rows of an embedding table in
+// one contiguous buffer, so that with a skewed access distribution the hot
+// working set stays in L2/L3 instead of being scattered across the table.
+//
+// Accesses are counted per row. Every `refresh_interval` looked up indices the
+// `capacity` most frequent rows are copied into the cache and all counts are
+// halved, so that the cache follows a drifting distribution. Cached rows are
+// copies taken at refresh time, hence the cache is meant for tables that are
+// not updated while it is used, e.g. in inference nets. Bookkeeping takes 8
+// bytes per table row on top of the cached rows.
+//
+// Hits, misses and refreshes are exported to the StatRegistry as
+// `<name>/hits`, `<name>/misses` and `<name>/refreshes`.
+class EmbeddingHotRowCache {
+ public:
+  EmbeddingHotRowCache(
+      const std::string& name,
+      TIndex capacity,
+      TIndex refresh_interval);
+
+  // Same semantics as EmbeddingLookup for a table of float or float16 rows,
+  // with rows served from the cache when they are in it.
+  template <
+      typename IndexType,
+      typename InType,
+      typename OutType,
+      bool IS_WEIGHT_POSITIONAL = false>
+  void Lookup(
+      const TensorCPU& data,
+      const TIndex output_size,
+      const TIndex index_size,
+      const IndexType* indices,
+      const int* lengths,
+      const float* weights,
+      bool normalize_by_lengths,
+      OutType* out);
+
+  int64_t hits() const {
+    return hits_;
+  }
+
+  int64_t misses() const {
+    return misses_;
+  }
+
+  // Number of rows currently cached.
+  TIndex size() const {
+    return cached_rows_.size();
+  }
+
+ private:
+  // Drops all state and starts tracking `data`.
+  void Reset(const TensorCPU& data);
+  // Copies the currently most frequent rows of `data` into the cache.
+  void Refresh(const TensorCPU& data);
+
+  std::mutex mutex_; // protects everything below
+  const TIndex capacity_;
+  const TIndex refresh_interval_;
+  // The table the cache was built for.
+  const void* table_{nullptr};
+  TIndex table_rows_{0};
+  size_t row_bytes_{0};
+  TypeMeta meta_;
+  // Access count of every table row, halved at each refresh.
+  std::vector<uint32_t> counts_;
+  // Cache slot of every table row, -1 for rows that are not cached.
+  std::vector<int32_t> slots_;
+  // Table row held by every cache slot.
+  std::vector<TIndex> cached_rows_;
+  std::vector<char> rows_;
+  TIndex lookups_since_refresh_{0};
+  int64_t hits_{0};
+  int64_t misses_{0};
+
+  struct HotRowCacheStats {
+    CAFFE_STAT_CTOR(HotRowCacheStats);
+    CAFFE_EXPORTED_STAT(hits);
+    CAFFE_EXPORTED_STAT(misses);
+    CAFFE_EXPORTED_STAT(refreshes);
+  } stats_;
+};
+
+template <
+    typename IndexType,
+    typename InType,
+    typename OutType,
+    bool IS_WEIGHT_POSITIONAL>
+void EmbeddingHotRowCache::Lookup(
+    const TensorCPU& data,
+    const TIndex output_size,
+    const TIndex index_size,
+    const IndexType* indices,
+    const int* lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    OutType* out) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  const TIndex data_size = data.dim(0);
+  const TIndex block_size = data.size_from_dim(1);
+  if (data.raw_data() != table_ || data_size != table_rows_ ||
+      data.meta() != meta_ || block_size * data.itemsize() != row_bytes_) {
+    Reset(data);
+  }
+  const InType* input = data.template data<InType>();
+  const InType* cached = reinterpret_cast<const InType*>(rows_.data());
+
+  int64_t hits = 0;
+  TIndex current = 0;
+  for (TIndex m = 0; m < output_size; ++m) {
+    memset(out, 0, sizeof(OutType) * block_size);
+    for (int i = 0; i < lengths[m]; ++i) {
+      CAFFE_ENFORCE_LT(
+          current,
+          index_size,
+          "The sum of lengths should be the size of the indices tensor");
+      const TIndex idx = indices[current];
+      CAFFE_ENFORCE(
+          0 <= idx && idx < data_size,
+          "Index ",
+          current,
+          " is out of bounds: ",
+          idx,
+          ", range 0 to ",
+          data_size);
+#ifdef __GNUC__
+      if (current + 1 < index_size) {
+        const TIndex next = indices[current + 1];
+        if (0 <= next && next < data_size && slots_[next] < 0) {
+          __builtin_prefetch(input + block_size * next, 0, 1);
+        }
+      }
+#endif // __GNUC__
+
+      ++counts_[idx];
+      const InType* row;
+      if (slots_[idx] >= 0) {
+        row = cached + block_size * slots_[idx];
+        ++hits;
+      } else {
+        row = input + block_size * idx;
+      }
+      float w = 1.f;
+      if (weights) {
+        w = weights[IS_WEIGHT_POSITIONAL ? i : current];
+      }
+      TypedAxpy<InType, OutType>(block_size, w, row, out);
+      ++current;
+    }
+    if (normalize_by_lengths && lengths[m]) {
+      // hack: context is not really used
+      math::Scale<OutType, CPUContext>(
+          block_size, 1.f / lengths[m], out, out, nullptr);
+    }
+    out += block_size;
+  }
+  CAFFE_ENFORCE_EQ(
+      current,
+      index_size,
+      "Your input seems to be incorrect: the sum of lengths values should be "
+      "the size of the indices tensor, but it appears not.");
+
+  hits_ += hits;
+  misses_ += index_size - hits;
+  CAFFE_EVENT(stats_, hits, hits);
+  CAFFE_EVENT(stats_, misses, index_size - hits);
+  lookups_since_refresh_ += index_size;
+  if (lookups_since_refresh_ >= refresh_interval_) {
+    Refresh(data);
+  }
+}
+
+} // namespace caffe2
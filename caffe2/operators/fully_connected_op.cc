@@ -1,9 +1,103 @@
 #include <functional>
 
 #include "caffe2/operators/fully_connected_op.h"
+#include "caffe2/operators/fused_elementwise_op.h"
 
 namespace caffe2 {
 
+namespace {
+
+// The smallest number of multiply-adds of the FC that are handed to a thread
+constexpr size_t kFCParallelGrain = 1 << 16;
+
+// FC followed by unary operators, run on the output in place right after it
+// is computed, without an intermediate blob.
+class FCActivationOp final : public FullyConnectedOp<CPUContext> {
+ public:
+  FCActivationOp(const OperatorDef& operator_def, Workspace* ws)
+      : FullyConnectedOp<CPUContext>(operator_def, ws),
+        functions_(GetFusedUnaryFunctions(
+            OperatorBase::GetRepeatedArgument<string>("ops"))) {}
+
+  bool RunOnDevice() override {
+    if (!FullyConnectedOp<CPUContext>::RunOnDevice()) {
+      return false;
+    }
+    auto* Y = Output(0);
+    float* Ydata = Y->mutable_data<float>();
+    RunFusedUnaryFunctions(functions_, Y->size(), Ydata, Ydata);
+    return true;
+  }
+
+ private:
+  std::vector<FusedUnaryFunction> functions_;
+};
+
+} // namespace
+
+bool FullyConnectedParallel<
+    CPUContext,
+    DefaultEngine,
+    float,
+    float,
+    float,
+    float>::
+    Run(ThreadPool* pool,
+        bool transposeWeight,
+        int M,
+        int N,
+        int K,
+        const float* X,
+        const float* W,
+        const float* b,
+        float* Y,
+        CPUContext* context) {
+  if (!pool || pool->getNumThreads() <= 1 ||
+      static_cast<size_t>(M) * N * K < 2 * kFCParallelGrain) {
+    return false;
+  }
+  const auto transW = transposeWeight ? CblasTrans : CblasNoTrans;
+  if (M >= pool->getNumThreads()) {
+    // Whole rows of Y, from the same rows of X
+    const size_t grain = kFCParallelGrain / (static_cast<size_t>(N) * K) + 1;
+    ParallelFor(pool, M, grain, [&](size_t begin, size_t end) {
+      const int rows = end - begin;
+      float* Yrows = Y + begin * N;
+      math::Gemm<float, CPUContext>(
+          CblasNoTrans, transW, rows, N, K, 1, X + begin * K, W, 0, Yrows,
+          context);
+      EigenMatrixMap<float>(Yrows, N, rows).colwise() +=
+          ConstEigenVectorMap<float>(b, N);
+    });
+  } else {
+    // Columns of Y, from the rows of W, or its columns if it is not
+    // transposed
+    const size_t grain = kFCParallelGrain / (static_cast<size_t>(M) * K) + 1;
+    ParallelFor(pool, N, grain, [&](size_t begin, size_t end) {
+      const int cols = end - begin;
+      math::GemmEx<float, CPUContext>(
+          CblasNoTrans,
+          transW,
+          M,
+          cols,
+          K,
+          1,
+          X,
+          K,
+          transposeWeight ? W + begin * K : W + begin,
+          transposeWeight ? K : N,
+          0,
+          Y + begin,
+          N,
+          context);
+      Eigen::Map<Eigen::MatrixXf, 0, Eigen::OuterStride<>>(
+          Y + begin, cols, M, Eigen::OuterStride<>(N))
+          .colwise() += ConstEigenVectorMap<float>(b + begin, cols);
+    });
+  }
+  return true;
+}
+
 REGISTER_CPU_OPERATOR(FC, FullyConnectedOp<CPUContext>);
 REGISTER_CPU_OPERATOR(FCGradient, FullyConnectedGradientOp<CPUContext>);
 
@@ -19,6 +113,7 @@ REGISTER_CPU_OPERATOR(
         CPUContext,
         DefaultEngine,
         false /* don't transpose weight */>);
+REGISTER_CPU_OPERATOR(FCActivation, FCActivationOp);
 
 namespace {
 std::vector<TensorShape> FCShapeInference(
@@ -209,6 +304,22 @@ will throw errors.
     .Output(0, "Y", "2D output tensor")
     .InheritOnnxSchema("Gemm");
 
+OPERATOR_SCHEMA(FCActivation)
+    .NumInputs(3)
+    .NumOutputs(1)
+    .TensorInferenceFunction(std::bind(FCShapeInference, _1, _2, false))
+    .CostInferenceFunction(std::bind(CostInferenceForFC, _1, _2, false))
+    .SetDoc(R"DOC(
+FC followed by a chain of float unary elementwise operators, which run on the
+output right after the FC. Takes the arguments of FC. The PatternFusion
+transform rewrites FC followed by Relu, Sigmoid, Tanh, etc. to it.
+)DOC")
+    .Arg("ops", "(list of strings) The operator types to run, in order.")
+    .Input(0, "X", "Input tensor, coerced into a 2D matrix as in FC")
+    .Input(1, "W", "The weight matrix, as in FC")
+    .Input(2, "b", "1D blob containing bias vector")
+    .Output(0, "Y", "2D output tensor");
+
 OPERATOR_SCHEMA(FCGradient)
     .NumInputs(3)
     .NumOutputs(2, 3)
@@ -240,6 +351,7 @@ class GetFCGradient : public GradientMakerBase {
 
 REGISTER_GRADIENT(FC, GetFCGradient);
 REGISTER_GRADIENT(FCTransposed, GetFCGradient);
+NO_GRADIENT(FCActivation);
 
 } // namespace
 
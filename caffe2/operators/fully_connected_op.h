@@ -5,15 +5,64 @@
 #include "caffe2/core/operator.h"
 #include "caffe2/utils/conversions.h"
 #include "caffe2/utils/math.h"
+#include "caffe2/utils/packed_gemm.h"
 
 namespace caffe2 {
 
+// Computes Y = X * op(W) + b for FullyConnectedOp with the rows of Y, or its
+// columns when there are fewer rows than threads, split between the threads
+// of pool. Returns false for the contexts, engines and types it does not
+// cover, and for too little work, in which case the operator runs its GEMMs.
+template <
+    class Context,
+    class Engine,
+    typename T_X,
+    typename T_W,
+    typename T_B,
+    typename T_Y>
+struct FullyConnectedParallel {
+  static bool Run(
+      ThreadPool* /*pool*/,
+      bool /*transposeWeight*/,
+      int /*M*/,
+      int /*N*/,
+      int /*K*/,
+      const T_X* /*X*/,
+      const T_W* /*W*/,
+      const T_B* /*b*/,
+      T_Y* /*Y*/,
+      Context* /*context*/) {
+    return false;
+  }
+};
+
+template <>
+struct FullyConnectedParallel<
+    CPUContext,
+    DefaultEngine,
+    float,
+    float,
+    float,
+    float> {
+  static bool Run(
+      ThreadPool* pool,
+      bool transposeWeight,
+      int M,
+      int N,
+      int K,
+      const float* X,
+      const float* W,
+      const float* b,
+      float* Y,
+      CPUContext* context);
+};
+
 // This is Caffe's InnerProductOp, with a name that fits its purpose better.
 template <
     class Context,
     class Engine = DefaultEngine,
     bool TransposeWeight = true>
-class FullyConnectedOp final : public Operator<Context> {
+class FullyConnectedOp : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   FullyConnectedOp(const OperatorDef& operator_def, Workspace* ws)
@@ -32,7 +81,13 @@ class FullyConnectedOp final : public Operator<Context> {
       typename MATH>
   bool DoRunWithType() {
     const auto& X = Input(0);
-    const auto& W = Input(1);
+    // The weight is a tensor, or was packed ahead of time by PackGemmWeights
+    const PackedGemmMatrixFP32* packed_W =
+        OperatorBase::InputIsType<PackedGemmMatrixFP32>(1)
+        ? &OperatorBase::Input<PackedGemmMatrixFP32>(1)
+        : nullptr;
+    const auto& W_dims = packed_W ? packed_W->dims() : Input(1).dims();
+    const TIndex W_size = size_from_dim_(0, W_dims);
     const auto& b = Input(2);
     auto* Y = Output(0);
     CAFFE_ENFORCE(b.ndim() == 1, b.ndim());
@@ -40,9 +95,9 @@ class FullyConnectedOp final : public Operator<Context> {
     const auto canonical_axis = X.canonical_axis_index(axis_);
     const auto M = X.size_to_dim(canonical_axis);
     const auto K = X.size_from_dim(canonical_axis);
-    const auto canonical_axis_w = W.canonical_axis_index(axis_w_);
-    const int N = TransposeWeight ? W.size_to_dim(canonical_axis_w)
-                                  : W.size_from_dim(canonical_axis_w);
+    const auto canonical_axis_w = canonical_axis_index_(axis_w_, W_dims.size());
+    const int N = TransposeWeight ? size_to_dim_(canonical_axis_w, W_dims)
+                                  : size_from_dim_(canonical_axis_w, W_dims);
 
     auto dimErrorString = [&]() {
       return MakeString(
@@ -50,7 +105,7 @@ class FullyConnectedOp final : public Operator<Context> {
           "X: ",
           X.dims(),
           ", W: ",
-          W.dims(),
+          W_dims,
           ", b: ",
           b.dims(),
           ", axis: ",
@@ -65,7 +120,7 @@ class FullyConnectedOp final : public Operator<Context> {
 
     // Error checking
     CAFFE_ENFORCE(M == X.size() / K, dimErrorString());
-    CAFFE_ENFORCE(K == W.size() / N, dimErrorString());
+    CAFFE_ENFORCE(K == W_size / N, dimErrorString());
     CAFFE_ENFORCE(N == b.dim32(0), dimErrorString());
     CAFFE_ENFORCE(N == b.size(), dimErrorString());
 
@@ -89,20 +144,50 @@ class FullyConnectedOp final : public Operator<Context> {
       math_type = TensorProto_DataType_FLOAT16;
     }
 
+    if (!packed_W && !fp16_type<MATH>() &&
+        FullyConnectedParallel<Context, Engine, T_X, T_W, T_B, T_Y>::Run(
+            this->IntraOpThreadPool(),
+            TransposeWeight,
+            M,
+            N,
+            K,
+            X.template data<T_X>(),
+            Input(1).template data<T_W>(),
+            b.template data<T_B>(),
+            Y->template mutable_data<T_Y>(),
+            &context_)) {
+      return true;
+    }
+
     // W * x
-    math::Gemm<T_X, Context, Engine>(
-        CblasNoTrans,
-        TransposeWeight ? CblasTrans : CblasNoTrans,
-        M,
-        N,
-        K,
-        1,
-        X.template data<T_X>(),
-        W.template data<T_W>(),
-        0,
-        Y->template mutable_data<T_Y>(),
-        &context_,
-        math_type);
+    if (packed_W) {
+      CAFFE_ENFORCE(
+          packed_W->operand() == PackedGemmMatrixFP32::B &&
+              packed_W->rows() == K && packed_W->cols() == N,
+          "Weight packed for another operator");
+      PackedGemm(
+          *packed_W,
+          0,
+          M,
+          X.template data<T_X>(),
+          0,
+          Y->template mutable_data<T_Y>(),
+          &context_);
+    } else {
+      math::Gemm<T_X, Context, Engine>(
+          CblasNoTrans,
+          TransposeWeight ? CblasTrans : CblasNoTrans,
+          M,
+          N,
+          K,
+          1,
+          X.template data<T_X>(),
+          Input(1).template data<T_W>(),
+          0,
+          Y->template mutable_data<T_Y>(),
+          &context_,
+          math_type);
+    }
     // Add bias term
     if (bias_multiplier_.size() != M) {
       // If the helper bias multiplier is not M, reshape and fill it with one.
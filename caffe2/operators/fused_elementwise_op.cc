@@ -0,0 +1,150 @@
+#include "caffe2/operators/fused_elementwise_op.h"
+
+#include <algorithm>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Floats of the input run through all the functions at a time
+constexpr int kFusedBlockSize = 1024;
+
+void FusedRelu(const int n, const float* x, float* y) {
+  EigenVectorArrayMap<float>(y, n) =
+      ConstEigenVectorArrayMap<float>(x, n).cwiseMax(0.f);
+}
+
+void FusedSigmoid(const int n, const float* x, float* y) {
+  EigenVectorArrayMap<float>(y, n) =
+      1.f / (1.f + (-ConstEigenVectorArrayMap<float>(x, n)).exp());
+}
+
+void FusedTanh(const int n, const float* x, float* y) {
+  EigenVectorArrayMap<float>(y, n) =
+      1.f - 2.f * ((ConstEigenVectorArrayMap<float>(x, n) * 2.f).exp() + 1.f)
+                      .inverse();
+}
+
+void FusedExp(const int n, const float* x, float* y) {
+  EigenVectorArrayMap<float>(y, n) =
+      ConstEigenVectorArrayMap<float>(x, n).exp();
+}
+
+void FusedLog(const int n, const float* x, float* y) {
+  EigenVectorArrayMap<float>(y, n) =
+      ConstEigenVectorArrayMap<float>(x, n).log();
+}
+
+void FusedSqr(const int n, const float* x, float* y) {
+  EigenVectorArrayMap<float>(y, n) =
+      ConstEigenVectorArrayMap<float>(x, n).square();
+}
+
+void FusedSqrt(const int n, const float* x, float* y) {
+  EigenVectorArrayMap<float>(y, n) =
+      ConstEigenVectorArrayMap<float>(x, n).sqrt();
+}
+
+void FusedAbs(const int n, const float* x, float* y) {
+  EigenVectorArrayMap<float>(y, n) =
+      ConstEigenVectorArrayMap<float>(x, n).abs();
+}
+
+void FusedSoftsign(const int n, const float* x, float* y) {
+  ConstEigenVectorArrayMap<float> x_arr(x, n);
+  EigenVectorArrayMap<float>(y, n) = x_arr / (1.f + x_arr.abs());
+}
+
+} // namespace
+
+const CaffeMap<string, FusedUnaryFunction>& FusedUnaryFunctions() {
+  static const CaffeMap<string, FusedUnaryFunction> functions{
+      {"Relu", FusedRelu},
+      {"Sigmoid", FusedSigmoid},
+      {"Tanh", FusedTanh},
+      {"Exp", FusedExp},
+      {"Log", FusedLog},
+      {"Sqr", FusedSqr},
+      {"Sqrt", FusedSqrt},
+      {"Abs", FusedAbs},
+      {"Softsign", FusedSoftsign},
+  };
+  return functions;
+}
+
+std::vector<FusedUnaryFunction> GetFusedUnaryFunctions(
+    const std::vector<string>& types) {
+  CAFFE_ENFORCE(!types.empty(), "No operators to fuse.");
+  std::vector<FusedUnaryFunction> functions;
+  for (const auto& type : types) {
+    auto it = FusedUnaryFunctions().find(type);
+    CAFFE_ENFORCE(
+        it != FusedUnaryFunctions().end(), "Cannot fuse operator ", type);
+    functions.push_back(it->second);
+  }
+  return functions;
+}
+
+void RunFusedUnaryFunctions(
+    const std::vector<FusedUnaryFunction>& functions,
+    const int n,
+    const float* x,
+    float* y) {
+  for (int i = 0; i < n; i += kFusedBlockSize) {
+    const int block = std::min(kFusedBlockSize, n - i);
+    functions[0](block, x + i, y + i);
+    for (int j = 1; j < functions.size(); ++j) {
+      functions[j](block, y + i, y + i);
+    }
+  }
+}
+
+namespace {
+
+class FusedElementwiseOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  FusedElementwiseOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        functions_(GetFusedUnaryFunctions(
+            OperatorBase::GetRepeatedArgument<string>("ops"))) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Input(0);
+    auto* Y = Output(0);
+    Y->ResizeLike(X);
+    RunFusedUnaryFunctions(
+        functions_, X.size(), X.data<float>(), Y->mutable_data<float>());
+    return true;
+  }
+
+ private:
+  std::vector<FusedUnaryFunction> functions_;
+};
+
+} // namespace
+
+REGISTER_CPU_OPERATOR(FusedElementwise, FusedElementwiseOp);
+
+OPERATOR_SCHEMA(FusedElementwise)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}})
+    .IdenticalTypeAndShape()
+    .SetDoc(R"DOC(
+Runs a chain of float unary elementwise operators in one pass over the data:
+each block of the input goes through all of them while it is in cache. The
+PatternFusion transform rewrites chains of Relu, Sigmoid, Tanh, Exp, Log, Sqr,
+Sqrt, Abs and Softsign to it.
+)DOC")
+    .Arg("ops", "(list of strings) The operator types to run, in order.")
+    .Input(0, "X", "Input tensor")
+    .Output(0, "Y", "Output tensor");
+
+NO_GRADIENT(FusedElementwise);
+
+} // namespace caffe2
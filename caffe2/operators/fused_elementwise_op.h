@@ -0,0 +1,30 @@
+#ifndef CAFFE2_OPERATORS_FUSED_ELEMENTWISE_OP_H_
+#define CAFFE2_OPERATORS_FUSED_ELEMENTWISE_OP_H_
+
+#include "caffe2/core/common.h"
+
+namespace caffe2 {
+
+// A float unary elementwise operator that can run fused with others. y may
+// be x.
+using FusedUnaryFunction = void (*)(const int n, const float* x, float* y);
+
+// The unary operators FusedElementwise and FCActivation can run, by operator
+// type: Relu, Sigmoid, Tanh, Exp, Log, Sqr, Sqrt, Abs and Softsign.
+const CaffeMap<string, FusedUnaryFunction>& FusedUnaryFunctions();
+
+// The functions of the operator types, which must be known.
+std::vector<FusedUnaryFunction> GetFusedUnaryFunctions(
+    const std::vector<string>& types);
+
+// Runs the functions one after the other, a block of the input at a time so
+// that the intermediate results stay in cache.
+void RunFusedUnaryFunctions(
+    const std::vector<FusedUnaryFunction>& functions,
+    const int n,
+    const float* x,
+    float* y);
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_FUSED_ELEMENTWISE_OP_H_
@@ -0,0 +1,82 @@
+#include "caffe2/operators/fused_rowwise_nbit_conversion_ops.h"
+#include "caffe2/core/registry.h"
+
+namespace caffe2 {
+REGISTER_CPU_OPERATOR(
+    FloatToFused4BitRowwiseQuantized,
+    FloatToFusedNBitRowwiseQuantizedOp<4, CPUContext>);
+OPERATOR_SCHEMA(FloatToFused4BitRowwiseQuantized)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Applies 4-bit row-wise quantization by determining the range
+(maximum - minimum) and offset (minimum value) of each row in the input
+matrix, and then scaling each element to a 4-bit number between 0 and
+15. Two quantized values are packed into each byte, the first one in the
+lower 4 bits. To later de-quantize values, the scale (range / 15) and
+offset (bias) are stored alongside the data: the last 8 bytes of each row
+in the output matrix are a 32-bit float storing the scale followed by a
+32-bit float storing the bias. Rows with an odd number of columns are padded
+with one zero value.
+)DOC")
+    .Input(0, "input", "Float32 input data")
+    .Output(0, "output", "Fused scale, bias and quantized data");
+NO_GRADIENT(FloatToFused4BitRowwiseQuantized);
+
+REGISTER_CPU_OPERATOR(
+    FloatToFused2BitRowwiseQuantized,
+    FloatToFusedNBitRowwiseQuantizedOp<2, CPUContext>);
+OPERATOR_SCHEMA(FloatToFused2BitRowwiseQuantized)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Applies 2-bit row-wise quantization, the same way as
+FloatToFused4BitRowwiseQuantized does with 4 bits: each element is scaled to
+a number between 0 and 3, four of them are packed into each byte starting
+from the lowest bits, and the scale (range / 3) and bias of the row are
+stored as 32-bit floats in the last 8 bytes of each row. Rows are padded with
+zero values to a multiple of 4 columns.
+)DOC")
+    .Input(0, "input", "Float32 input data")
+    .Output(0, "output", "Fused scale, bias and quantized data");
+NO_GRADIENT(FloatToFused2BitRowwiseQuantized);
+
+REGISTER_CPU_OPERATOR(
+    Fused4BitRowwiseQuantizedToFloat,
+    FusedNBitRowwiseQuantizedToFloatOp<4, CPUContext>);
+OPERATOR_SCHEMA(Fused4BitRowwiseQuantizedToFloat)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+De-quantizes the result of the FloatToFused4BitRowwiseQuantized operator.
+The input is expected to encode the scale as a 32-bit float in the second to
+the last 4 bytes of each row, followed by the bias as a 32-bit float in the
+next 4 bytes, and two quantized values packed in each of the preceding bytes.
+The output is a matrix with two columns per packed byte, including the
+padding of rows with an odd number of columns.
+)DOC")
+    .Input(
+        0,
+        "scale_bias_quantized_input",
+        "Fused scale, bias and quantized data")
+    .Output(0, "float_output", "Float32 data");
+NO_GRADIENT(Fused4BitRowwiseQuantizedToFloat);
+
+REGISTER_CPU_OPERATOR(
+    Fused2BitRowwiseQuantizedToFloat,
+    FusedNBitRowwiseQuantizedToFloatOp<2, CPUContext>);
+OPERATOR_SCHEMA(Fused2BitRowwiseQuantizedToFloat)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+De-quantizes the result of the FloatToFused2BitRowwiseQuantized operator,
+producing four columns per packed byte. See Fused4BitRowwiseQuantizedToFloat
+for the layout of the input.
+)DOC")
+    .Input(
+        0,
+        "scale_bias_quantized_input",
+        "Fused scale, bias and quantized data")
+    .Output(0, "float_output", "Float32 data");
+NO_GRADIENT(Fused2BitRowwiseQuantizedToFloat);
+} // namespace caffe2
@@ -0,0 +1,152 @@
+#ifndef CAFFE2_OPERATORS_FUSED_ROWWISE_NBIT_CONVERSION_OPS_H_
+#define CAFFE2_OPERATORS_FUSED_ROWWISE_NBIT_CONVERSION_OPS_H_
+
+#include <algorithm>
+#include <cmath>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+#define IS_LITTLE_ENDIAN                                      \
+  [] {                                                        \
+    const int32_t kValue = 1;                                 \
+    return reinterpret_cast<const uint8_t*>(&kValue)[0] == 1; \
+  }()
+
+// The "fused" representation for BIT_RATE (2 or 4) bits packs 8 / BIT_RATE
+// quantized values into each byte, lowest bits first, and then stores the
+// scale and bias of the row as 32-bit floats, like the 8-bit variant does:
+// | ... packed data ... | scale | bias |
+// | ceil(columns / n)   |  4B   |  4B  |
+// Rows whose number of columns is not a multiple of 8 / BIT_RATE are padded
+// with zeros, which is why de-quantizing yields that many columns.
+template <int BIT_RATE, class Context>
+class FloatToFusedNBitRowwiseQuantizedOp : public Operator<Context> {
+ public:
+  static_assert(BIT_RATE == 2 || BIT_RATE == 4, "Unsupported bit rate");
+  static constexpr int kNumElemPerByte = 8 / BIT_RATE;
+  static constexpr float kEpsilon = 1e-8f;
+
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(FloatToFusedNBitRowwiseQuantizedOp)
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE(IS_LITTLE_ENDIAN, "Unsupported endianness");
+
+    const auto& input = Input(DATA_FLOAT);
+    auto* output = Output(DATA_FUSED_SCALE_BIAS);
+    CAFFE_ENFORCE_EQ(input.ndim(), 2, "Expect input to be a matrix");
+
+    const auto input_rows = input.dim(0);
+    const auto input_columns = input.dim(1);
+    const auto packed_columns =
+        (input_columns + kNumElemPerByte - 1) / kNumElemPerByte;
+    const std::vector<TIndex> output_dimensions = {input_rows,
+                                                   packed_columns + 8};
+    output->Resize(output_dimensions);
+
+    const auto* input_data = input.template data<float>();
+    auto* output_data = output->template mutable_data<uint8_t>();
+    const auto output_columns = output->dim(1);
+    const float max_quantized = (1 << BIT_RATE) - 1;
+
+    for (TIndex row = 0; row < input_rows; ++row) {
+      const float* input_row = input_data + row * input_columns;
+      uint8_t* output_row = output_data + row * output_columns;
+      float* output_row_scale_bias =
+          reinterpret_cast<float*>(output_row + packed_columns);
+
+      float minimum_element = 0;
+      float maximum_element = 0;
+      if (input_columns > 0) {
+        const auto minmax =
+            std::minmax_element(input_row, input_row + input_columns);
+        minimum_element = *minmax.first;
+        maximum_element = *minmax.second;
+      }
+      const float range = maximum_element - minimum_element;
+
+      output_row_scale_bias[0] = range / max_quantized;
+      output_row_scale_bias[1] = minimum_element;
+      const float inverse_scale = max_quantized / (range + kEpsilon);
+
+      memset(output_row, 0, packed_columns);
+      for (TIndex col = 0; col < input_columns; ++col) {
+        const float scaled = (input_row[col] - minimum_element) * inverse_scale;
+        const uint8_t quantized = static_cast<uint8_t>(std::min(
+            std::max(std::round(scaled), 0.0f), max_quantized));
+        output_row[col / kNumElemPerByte] |=
+            quantized << ((col % kNumElemPerByte) * BIT_RATE);
+      }
+    }
+
+    return true;
+  }
+
+ private:
+  INPUT_TAGS(DATA_FLOAT);
+  OUTPUT_TAGS(DATA_FUSED_SCALE_BIAS);
+};
+
+template <int BIT_RATE, class Context>
+class FusedNBitRowwiseQuantizedToFloatOp : public Operator<Context> {
+ public:
+  static_assert(BIT_RATE == 2 || BIT_RATE == 4, "Unsupported bit rate");
+  static constexpr int kNumElemPerByte = 8 / BIT_RATE;
+
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(FusedNBitRowwiseQuantizedToFloatOp)
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE(IS_LITTLE_ENDIAN, "Unsupported endianness");
+
+    const auto& input = Input(DATA_FUSED_SCALE_BIAS);
+    auto* output = Output(DATA_FLOAT);
+    CAFFE_ENFORCE_EQ(input.ndim(), 2, "Expect input to be a matrix");
+    CAFFE_ENFORCE_GE(input.dim(1), 8, "Expect the scale and bias per row");
+
+    // The last 8 bytes per row are the scale and the bias. The rest of
+    // input_columns holds the packed values of the original row.
+    const auto input_rows = input.dim(0);
+    const auto input_columns = input.dim(1);
+    const auto packed_columns = input_columns - 8;
+    const std::vector<TIndex> output_dimensions = {
+        input_rows, packed_columns * kNumElemPerByte};
+    output->Resize(output_dimensions);
+    const auto output_columns = output->dim(1);
+
+    const auto* input_data = input.template data<uint8_t>();
+    auto* output_data = output->template mutable_data<float>();
+    const uint8_t mask = (1 << BIT_RATE) - 1;
+
+    for (TIndex row = 0; row < input_rows; ++row) {
+      const uint8_t* input_row = input_data + row * input_columns;
+      const float* input_row_scale_bias =
+          reinterpret_cast<const float*>(input_row + packed_columns);
+      float* output_row = output_data + row * output_columns;
+
+      for (TIndex col = 0; col < output_columns; ++col) {
+        const int shift = (col % kNumElemPerByte) * BIT_RATE;
+        const uint8_t quantized = (input_row[col / kNumElemPerByte] >> shift) &
+            mask;
+        output_row[col] =
+            quantized * input_row_scale_bias[0] + input_row_scale_bias[1];
+      }
+    }
+    return true;
+  }
+
+ private:
+  INPUT_TAGS(DATA_FUSED_SCALE_BIAS);
+  OUTPUT_TAGS(DATA_FLOAT);
+};
+
+#undef IS_LITTLE_ENDIAN
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_FUSED_ROWWISE_NBIT_CONVERSION_OPS_H_
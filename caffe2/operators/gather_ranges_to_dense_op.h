@@ -14,6 +14,10 @@
 #include <utility>
 
 namespace caffe2 {
+
+// The number of output bytes worth a thread handoff
+constexpr TIndex kGatherRangesToDenseParallelGrain = 1 << 16;
+
 template <class Context>
 class GatherRangesToDenseOp final : public Operator<Context> {
  public:
@@ -57,68 +61,79 @@ class GatherRangesToDenseOp final : public Operator<Context> {
 
     auto* rawData = static_cast<const char*>(data.raw_data());
     auto* rangesData = ranges.template data<Index>();
-    int rangesDataOffset = 0;
     auto itemsize = data.meta().itemsize();
+    const int64_t* key_data = InputSize() == 3
+        ? Input(KEY).template data<int64_t>()
+        : nullptr;
 
     auto batchSize = ranges.dim(0);
     vector<TIndex> outputDims{batchSize, 0};
     vector<char*> outputRawData;
+    TIndex exampleBytes = 0;
     for (int i = 0; i < OutputSize(); ++i) {
       auto* output = Output(i);
       outputDims[1] = lengths_[i];
       output->Resize(outputDims);
       char* ptr = static_cast<char*>(output->raw_mutable_data(data.meta()));
-      memset(ptr, 0, output->nbytes());
       outputRawData.push_back(ptr);
+      exampleBytes += lengths_[i] * itemsize;
     }
 
-    for (int i = 0; i < batchSize; ++i) {
-      for (int j = 0; j < OutputSize(); ++j) {
-        auto rangeStart = rangesData[rangesDataOffset++];
-        auto rangeLength = rangesData[rangesDataOffset++];
-        if (rangeLength == 0) {
-          // empty range, will be filled with zeros
-          continue;
-        }
-        CAFFE_ENFORCE_EQ(
-            rangeLength,
-            lengths_[j],
-            "Range lengths missmatch for output #",
-            j);
-
-        if (InputSize() == 2) {
-          context_.template CopyItems<Context, Context>(
-              data.meta(),
-              rangeLength,
-              rawData + rangeStart * itemsize,
-              outputRawData[j] + i * itemsize * lengths_[j]);
-        } else {
-          auto& key = Input(KEY);
-          auto* key_data = key.template data<int64_t>();
+    // The ranges of an example are at a fixed offset, so that the examples
+    // are split between the threads of the pool
+    ParallelFor(
+        this->IntraOpThreadPool(),
+        batchSize,
+        kGatherRangesToDenseParallelGrain / std::max<TIndex>(exampleBytes, 1) +
+            1,
+        [&](size_t begin, size_t end) {
           vector<std::pair<int64_t, const char*>> buffer;
-          for (int b_i = 0; b_i < rangeLength; ++b_i) {
-            int64_t one_key_item = key_data[rangeStart + b_i];
-            auto* one_data_item = rawData + (rangeStart + b_i) * itemsize;
-            buffer.emplace_back(one_key_item, one_data_item);
-          }
-          std::sort(
-              buffer.begin(),
-              buffer.end(),
-              [](const std::pair<int64_t, const char*>& left,
-                 const std::pair<int64_t, const char*>& right) {
-                return left.first < right.first;
-              });
-          for (int b_i = 0; b_i < rangeLength; ++b_i) {
-            // Since this CPU only, directly copy to the destination.
-            std::memcpy(
-                outputRawData[j] + (i * lengths_[j] + b_i) * itemsize,
-                buffer[b_i].second,
-                itemsize);
+          for (size_t i = begin; i < end; ++i) {
+            for (int j = 0; j < OutputSize(); ++j) {
+              const auto* range = rangesData + (i * OutputSize() + j) * 2;
+              auto rangeStart = range[0];
+              auto rangeLength = range[1];
+              char* dst = outputRawData[j] + i * itemsize * lengths_[j];
+              if (rangeLength == 0) {
+                // empty range, will be filled with zeros
+                memset(dst, 0, itemsize * lengths_[j]);
+                continue;
+              }
+              CAFFE_ENFORCE_EQ(
+                  rangeLength,
+                  lengths_[j],
+                  "Range lengths missmatch for output #",
+                  j);
+
+              if (!key_data) {
+                context_.template CopyItems<Context, Context>(
+                    data.meta(),
+                    rangeLength,
+                    rawData + rangeStart * itemsize,
+                    dst);
+              } else {
+                buffer.clear();
+                for (int b_i = 0; b_i < rangeLength; ++b_i) {
+                  int64_t one_key_item = key_data[rangeStart + b_i];
+                  auto* one_data_item = rawData + (rangeStart + b_i) * itemsize;
+                  buffer.emplace_back(one_key_item, one_data_item);
+                }
+                std::sort(
+                    buffer.begin(),
+                    buffer.end(),
+                    [](const std::pair<int64_t, const char*>& left,
+                       const std::pair<int64_t, const char*>& right) {
+                      return left.first < right.first;
+                    });
+                for (int b_i = 0; b_i < rangeLength; ++b_i) {
+                  // Since this CPU only, directly copy to the destination.
+                  std::memcpy(
+                      dst + b_i * itemsize, buffer[b_i].second, itemsize);
+                }
+              }
+            }
           }
-        }
-      }
-    }
-    CAFFE_ENFORCE_EQ(rangesDataOffset, ranges.size());
+        });
 
     return true;
   }
@@ -0,0 +1,372 @@
+#include <cfloat>
+#include <numeric>
+
+#include <cub/cub.cuh>
+
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/operators/generate_proposals_op.h"
+#include "caffe2/operators/generate_proposals_op_util_boxes.h"
+#include "caffe2/operators/generate_proposals_op_util_nms_gpu.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Sort key of the proposals that are filtered out, which sorts them after
+// all the others since scores are probabilities.
+constexpr float kFilteredScore = -FLT_MAX;
+
+// Decodes the proposals of all images, in the (H, W, A) order of the CPU
+// implementation: shifts the anchors, applies the deltas, clips the boxes to
+// the image and filters out the small ones. Writes the score of each proposal
+// as its sort key, or kFilteredScore if it was filtered out, and its index
+// within the image as its sort value.
+__global__ void GenerateProposalsKernel(
+    const int nthreads,
+    const float* scores,
+    const float* bbox_deltas,
+    const float* im_info,
+    const float* anchors,
+    const int A,
+    const int H,
+    const int W,
+    const float feat_stride,
+    const float bbox_xform_clip,
+    const float min_size,
+    const bool correct_transform_coords,
+    float* proposals,
+    float* sort_keys,
+    int* sort_values) {
+  const int K = H * W;
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    const int n = index / (K * A);
+    const int k = index % (K * A);
+    const int a = k % A;
+    const int hw = k / A;
+    const int w = hw % W;
+    const int h = hw / W;
+
+    const float* anchor = anchors + a * 4;
+    const float shift_x = w * feat_stride;
+    const float shift_y = h * feat_stride;
+    const float x1 = anchor[0] + shift_x;
+    const float y1 = anchor[1] + shift_y;
+    const float x2 = anchor[2] + shift_x;
+    const float y2 = anchor[3] + shift_y;
+
+    // bbox_deltas: (N, A * 4, H, W)
+    const float* delta = bbox_deltas + (n * A + a) * 4 * K + hw;
+    const float dx = delta[0];
+    const float dy = delta[K];
+    const float dw = fminf(delta[2 * K], bbox_xform_clip);
+    const float dh = fminf(delta[3 * K], bbox_xform_clip);
+
+    // See utils::bbox_transform()
+    const float width = x2 - x1 + 1.0f;
+    const float height = y2 - y1 + 1.0f;
+    const float ctr_x = x1 + 0.5f * width;
+    const float ctr_y = y1 + 0.5f * height;
+    const float pred_ctr_x = dx * width + ctr_x;
+    const float pred_ctr_y = dy * height + ctr_y;
+    const float pred_w = expf(dw) * width;
+    const float pred_h = expf(dh) * height;
+    const float offset = correct_transform_coords ? 1.0f : 0.0f;
+
+    // See utils::clip_boxes()
+    const float* info = im_info + n * 3;
+    const int im_height = info[0];
+    const int im_width = info[1];
+    const float box_x1 =
+        fmaxf(fminf(pred_ctr_x - 0.5f * pred_w, im_width - 1), 0.0f);
+    const float box_y1 =
+        fmaxf(fminf(pred_ctr_y - 0.5f * pred_h, im_height - 1), 0.0f);
+    const float box_x2 =
+        fmaxf(fminf(pred_ctr_x + 0.5f * pred_w - offset, im_width - 1), 0.0f);
+    const float box_y2 =
+        fmaxf(fminf(pred_ctr_y + 0.5f * pred_h - offset, im_height - 1), 0.0f);
+
+    float* box = proposals + index * 4;
+    box[0] = box_x1;
+    box[1] = box_y1;
+    box[2] = box_x2;
+    box[3] = box_y2;
+
+    // See utils::filter_boxes()
+    const float scaled_min_size = min_size * info[2];
+    const float ws = box_x2 - box_x1 + 1.0f;
+    const float hs = box_y2 - box_y1 + 1.0f;
+    const bool keep = ws >= scaled_min_size && hs >= scaled_min_size &&
+        box_x1 + ws / 2 < info[1] && box_y1 + hs / 2 < info[0];
+
+    // scores: (N, A, H, W)
+    sort_keys[index] = keep ? scores[(n * A + a) * K + hw] : kFilteredScore;
+    sort_values[index] = k;
+  }
+}
+
+__global__ void SegmentOffsetsKernel(
+    const int nthreads,
+    const int segment_size,
+    int* offsets) {
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    offsets[index] = index * segment_size;
+  }
+}
+
+// Gathers the top pre_nms_topN proposals of every image, sorted by score, for
+// NMS, and counts those that were not filtered out.
+__global__ void SelectTopProposalsKernel(
+    const int nthreads,
+    const int num_proposals,
+    const int pre_nms_topN,
+    const float* proposals,
+    const float* sorted_keys,
+    const int* sorted_values,
+    float* nms_boxes,
+    int* nms_num_boxes) {
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    const int n = index / pre_nms_topN;
+    const int i = index % pre_nms_topN;
+    const float* keys = sorted_keys + n * num_proposals;
+    const bool valid = keys[i] != kFilteredScore;
+    if (valid) {
+      const int idx = sorted_values[n * num_proposals + i];
+      const float* box = proposals + (n * num_proposals + idx) * 4;
+      float* nms_box = nms_boxes + index * 4;
+      for (int k = 0; k < 4; ++k) {
+        nms_box[k] = box[k];
+      }
+    }
+    // The valid proposals come first, so their count is the position of the
+    // last one plus one.
+    const bool next_valid =
+        i + 1 < pre_nms_topN && keys[i + 1] != kFilteredScore;
+    if (valid && !next_valid) {
+      nms_num_boxes[n] = i + 1;
+    } else if (!valid && i == 0) {
+      nms_num_boxes[n] = 0;
+    }
+  }
+}
+
+// Writes the proposals selected by NMS for all images, one after another.
+__global__ void WriteProposalsKernel(
+    const int nthreads,
+    const int num_proposals,
+    const int pre_nms_topN,
+    const int max_keep,
+    const float* sorted_keys,
+    const float* nms_boxes,
+    const int* nms_keep,
+    const int* nms_num_keep,
+    float* out_rois,
+    float* out_rois_probs) {
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    const int n = index / max_keep;
+    const int i = index % max_keep;
+    if (i >= nms_num_keep[n]) {
+      continue;
+    }
+    // the number of images is small
+    int out_index = i;
+    for (int m = 0; m < n; ++m) {
+      out_index += nms_num_keep[m];
+    }
+    const int pos = nms_keep[n * pre_nms_topN + i];
+    const float* box = nms_boxes + (n * pre_nms_topN + pos) * 4;
+    float* roi = out_rois + out_index * 5;
+    roi[0] = n;
+    for (int k = 0; k < 4; ++k) {
+      roi[k + 1] = box[k];
+    }
+    out_rois_probs[out_index] = sorted_keys[n * num_proposals + pos];
+  }
+}
+
+} // namespace
+
+// Runs the whole pipeline for all images at once without leaving the device:
+// proposals are decoded and filtered in one kernel, sorted per image with a
+// segmented radix sort and reduced by the batched NMS. The only copy to the
+// host is that of the number of proposals kept for each image, which is
+// needed to size the outputs.
+template <>
+bool GenerateProposalsOp<CUDAContext>::RunOnDevice() {
+  const auto& scores = Input(0);
+  const auto& bbox_deltas = Input(1);
+  const auto& im_info_tensor = Input(2);
+  const auto& anchors = Input(3);
+  auto* out_rois = Output(0);
+  auto* out_rois_probs = Output(1);
+
+  CAFFE_ENFORCE_EQ(scores.ndim(), 4, scores.ndim());
+  CAFFE_ENFORCE(scores.template IsType<float>(), scores.meta().name());
+  const auto num_images = scores.dim(0);
+  const auto A = scores.dim(1);
+  const auto height = scores.dim(2);
+  const auto width = scores.dim(3);
+  const auto K = height * width;
+
+  CAFFE_ENFORCE_EQ(
+      bbox_deltas.dims(), (vector<TIndex>{num_images, 4 * A, height, width}));
+
+  CAFFE_ENFORCE_EQ(im_info_tensor.dims(), (vector<TIndex>{num_images, 3}));
+  CAFFE_ENFORCE(
+      im_info_tensor.template IsType<float>(), im_info_tensor.meta().name());
+
+  CAFFE_ENFORCE_EQ(anchors.dims(), (vector<TIndex>{A, 4}));
+  CAFFE_ENFORCE(anchors.template IsType<float>(), anchors.meta().name());
+
+  const int num_proposals = K * A;
+  if (num_images == 0 || num_proposals == 0) {
+    out_rois->Resize(0, 5);
+    out_rois->template mutable_data<float>();
+    out_rois_probs->Resize(0);
+    out_rois_probs->template mutable_data<float>();
+    return true;
+  }
+
+  const int total = num_images * num_proposals;
+  proposals_.Resize(total, 4);
+  sort_keys_.Resize(total);
+  sort_values_.Resize(total);
+  sorted_keys_.Resize(total);
+  sorted_values_.Resize(total);
+  sort_offsets_.Resize(num_images + 1);
+
+  GenerateProposalsKernel<<<
+      CAFFE_GET_BLOCKS(total),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context_.cuda_stream()>>>(
+      total,
+      scores.data<float>(),
+      bbox_deltas.data<float>(),
+      im_info_tensor.data<float>(),
+      anchors.data<float>(),
+      A,
+      height,
+      width,
+      feat_stride_,
+      utils::BBOX_XFORM_CLIP_DEFAULT,
+      rpn_min_size_,
+      correct_transform_coords_,
+      proposals_.mutable_data<float>(),
+      sort_keys_.mutable_data<float>(),
+      sort_values_.mutable_data<int>());
+  SegmentOffsetsKernel<<<
+      CAFFE_GET_BLOCKS(num_images + 1),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context_.cuda_stream()>>>(
+      num_images + 1, num_proposals, sort_offsets_.mutable_data<int>());
+
+  // Sort the proposals of each image by score
+  const int* offsets = sort_offsets_.data<int>();
+  size_t sort_bytes = 0;
+  cub::DeviceSegmentedRadixSort::SortPairsDescending(
+      nullptr,
+      sort_bytes,
+      sort_keys_.data<float>(),
+      sorted_keys_.mutable_data<float>(),
+      sort_values_.data<int>(),
+      sorted_values_.mutable_data<int>(),
+      total,
+      num_images,
+      offsets,
+      offsets + 1,
+      0,
+      sizeof(float) * 8,
+      context_.cuda_stream());
+  sort_scratch_.Resize(sort_bytes);
+  cub::DeviceSegmentedRadixSort::SortPairsDescending(
+      static_cast<void*>(sort_scratch_.mutable_data<uint8_t>()),
+      sort_bytes,
+      sort_keys_.data<float>(),
+      sorted_keys_.mutable_data<float>(),
+      sort_values_.data<int>(),
+      sorted_values_.mutable_data<int>(),
+      total,
+      num_images,
+      offsets,
+      offsets + 1,
+      0,
+      sizeof(float) * 8,
+      context_.cuda_stream());
+
+  const int pre_nms_topN =
+      (rpn_pre_nms_topN_ > 0 && rpn_pre_nms_topN_ < num_proposals)
+      ? rpn_pre_nms_topN_
+      : num_proposals;
+  nms_boxes_.Resize(num_images, pre_nms_topN, 4);
+  nms_num_boxes_.Resize(num_images);
+  SelectTopProposalsKernel<<<
+      CAFFE_GET_BLOCKS(num_images * pre_nms_topN),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context_.cuda_stream()>>>(
+      num_images * pre_nms_topN,
+      num_proposals,
+      pre_nms_topN,
+      proposals_.data<float>(),
+      sorted_keys_.data<float>(),
+      sorted_values_.data<int>(),
+      nms_boxes_.mutable_data<float>(),
+      nms_num_boxes_.mutable_data<int>());
+
+  const int post_nms_topN = rpn_post_nms_topN_ > 0 ? rpn_post_nms_topN_ : -1;
+  nms_keep_.Resize(num_images, pre_nms_topN);
+  nms_num_keep_.Resize(num_images);
+  utils::nms_gpu_batched(
+      nms_boxes_.data<float>(),
+      nms_num_boxes_.data<int>(),
+      num_images,
+      pre_nms_topN,
+      rpn_nms_thresh_,
+      post_nms_topN,
+      nms_keep_.mutable_data<int>(),
+      nms_num_keep_.mutable_data<int>(),
+      &nms_mask_,
+      &context_);
+
+  std::vector<int> num_keep(num_images);
+  context_.Copy<int, CUDAContext, CPUContext>(
+      num_images, nms_num_keep_.data<int>(), num_keep.data());
+  const int total_keep = std::accumulate(num_keep.begin(), num_keep.end(), 0);
+
+  out_rois->Resize(total_keep, 5);
+  out_rois_probs->Resize(total_keep);
+  auto* out_rois_data = out_rois->template mutable_data<float>();
+  auto* out_rois_probs_data = out_rois_probs->template mutable_data<float>();
+  if (total_keep == 0) {
+    return true;
+  }
+  const int max_keep = post_nms_topN > 0
+      ? std::min(post_nms_topN, pre_nms_topN)
+      : pre_nms_topN;
+  WriteProposalsKernel<<<
+      CAFFE_GET_BLOCKS(num_images * max_keep),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context_.cuda_stream()>>>(
+      num_images * max_keep,
+      num_proposals,
+      pre_nms_topN,
+      max_keep,
+      sorted_keys_.data<float>(),
+      nms_boxes_.data<float>(),
+      nms_keep_.data<int>(),
+      nms_num_keep_.data<int>(),
+      out_rois_data,
+      out_rois_probs_data);
+
+  return true;
+}
+
+namespace {
+
+REGISTER_CUDA_OPERATOR(GenerateProposals, GenerateProposalsOp<CUDAContext>);
+REGISTER_CUDA_OPERATOR(GenerateProposalsCPP, GenerateProposalsOp<CUDAContext>);
+
+} // namespace
+} // namespace caffe2
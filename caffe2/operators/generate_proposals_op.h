@@ -116,6 +116,20 @@ class GenerateProposalsOp final : public Operator<Context> {
   // Set to true to match the detectron code, set to false for backward
   // compatibility
   bool correct_transform_coords_{false};
+
+  // Scratch space of the CUDA implementation
+  Tensor<Context> proposals_;
+  Tensor<Context> sort_keys_;
+  Tensor<Context> sort_values_;
+  Tensor<Context> sorted_keys_;
+  Tensor<Context> sorted_values_;
+  Tensor<Context> sort_offsets_;
+  Tensor<Context> sort_scratch_;
+  Tensor<Context> nms_boxes_;
+  Tensor<Context> nms_num_boxes_;
+  Tensor<Context> nms_mask_;
+  Tensor<Context> nms_keep_;
+  Tensor<Context> nms_num_keep_;
 };
 
 } // namespace caffe2
@@ -0,0 +1,224 @@
+#include <random>
+
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/core/flags.h"
+#include "caffe2/operators/generate_proposals_op.h"
+#include "caffe2/utils/math.h"
+#include "gtest/gtest.h"
+
+namespace caffe2 {
+namespace {
+
+struct TestInput {
+  string name;
+  vector<TIndex> shape;
+  vector<float> values;
+};
+
+// Runs the operator on the device of the given context and returns its
+// outputs on the CPU.
+template <class Context>
+vector<TensorCPU> RunOnContext(
+    OperatorDef def,
+    DeviceType device_type,
+    const vector<TestInput>& inputs) {
+  Workspace ws;
+  Context context;
+  for (const auto& input : inputs) {
+    TensorCPU tmp(input.shape);
+    std::copy(
+        input.values.begin(),
+        input.values.end(),
+        tmp.mutable_data<float>());
+    auto* tensor = ws.CreateBlob(input.name)->GetMutable<Tensor<Context>>();
+    tensor->CopyFrom(tmp, &context);
+  }
+  def.mutable_device_option()->set_device_type(device_type);
+  auto op = CreateOperator(def, &ws);
+  EXPECT_NE(nullptr, op.get());
+  EXPECT_TRUE(op->Run());
+
+  vector<TensorCPU> outputs;
+  for (const auto& name : def.output()) {
+    outputs.emplace_back();
+    outputs.back().CopyFrom(
+        ws.GetBlob(name)->Get<Tensor<Context>>(), &context);
+  }
+  context.FinishDeviceComputation();
+  return outputs;
+}
+
+void ExpectCPUGPUEqual(
+    const OperatorDef& def,
+    const vector<TestInput>& inputs) {
+  auto cpu_outputs = RunOnContext<CPUContext>(def, CPU, inputs);
+  auto gpu_outputs = RunOnContext<CUDAContext>(def, CUDA, inputs);
+  ASSERT_EQ(cpu_outputs.size(), gpu_outputs.size());
+  for (int i = 0; i < cpu_outputs.size(); ++i) {
+    const auto& expected = cpu_outputs[i];
+    const auto& actual = gpu_outputs[i];
+    ASSERT_EQ(expected.dims(), actual.dims()) << "output " << i;
+    if (expected.IsType<int>()) {
+      for (int k = 0; k < expected.size(); ++k) {
+        EXPECT_EQ(expected.data<int>()[k], actual.data<int>()[k]);
+      }
+    } else {
+      for (int k = 0; k < expected.size(); ++k) {
+        EXPECT_NEAR(expected.data<float>()[k], actual.data<float>()[k], 1e-3);
+      }
+    }
+  }
+}
+
+vector<float> RandomValues(
+    int size,
+    float min_val,
+    float max_val,
+    std::mt19937* gen) {
+  vector<float> values(size);
+  std::uniform_real_distribution<float> dist(min_val, max_val);
+  for (auto& value : values) {
+    value = dist(*gen);
+  }
+  return values;
+}
+
+// Boxes inside a width x height image, in (x1, y1, x2, y2) format.
+vector<float> RandomBoxes(
+    int count,
+    float width,
+    float height,
+    std::mt19937* gen) {
+  vector<float> boxes(count * 4);
+  std::uniform_real_distribution<float> x(0, width - 1);
+  std::uniform_real_distribution<float> y(0, height - 1);
+  for (int i = 0; i < count; ++i) {
+    const float x1 = x(*gen);
+    const float x2 = x(*gen);
+    const float y1 = y(*gen);
+    const float y2 = y(*gen);
+    boxes[i * 4] = std::min(x1, x2);
+    boxes[i * 4 + 1] = std::min(y1, y2);
+    boxes[i * 4 + 2] = std::max(x1, x2);
+    boxes[i * 4 + 3] = std::max(y1, y2);
+  }
+  return boxes;
+}
+
+} // namespace
+
+TEST(GenerateProposalsGPUTest, CheckCPUGPUEqual) {
+  if (!HasCudaGPU()) {
+    return;
+  }
+  std::mt19937 gen(0);
+  const int num_images = 2;
+  const int A = 3;
+  const int H = 20;
+  const int W = 30;
+
+  OperatorDef def;
+  def.set_name("test");
+  def.set_type("GenerateProposals");
+  def.add_input("scores");
+  def.add_input("bbox_deltas");
+  def.add_input("im_info");
+  def.add_input("anchors");
+  def.add_output("rois");
+  def.add_output("rois_probs");
+  def.add_arg()->CopyFrom(MakeArgument("spatial_scale", 1.0f / 16.0f));
+  def.add_arg()->CopyFrom(MakeArgument("pre_nms_topN", 1000));
+  def.add_arg()->CopyFrom(MakeArgument("post_nms_topN", 200));
+  def.add_arg()->CopyFrom(MakeArgument("nms_thresh", 0.7f));
+  def.add_arg()->CopyFrom(MakeArgument("min_size", 4.0f));
+  def.add_arg()->CopyFrom(
+      MakeArgument<bool>("correct_transform_coords", true));
+
+  ExpectCPUGPUEqual(
+      def,
+      {{"scores",
+        {num_images, A, H, W},
+        RandomValues(num_images * A * H * W, 0, 1, &gen)},
+       {"bbox_deltas",
+        {num_images, 4 * A, H, W},
+        RandomValues(num_images * 4 * A * H * W, -0.5, 0.5, &gen)},
+       {"im_info", {num_images, 3}, {320, 480, 1.0, 300, 400, 0.8}},
+       {"anchors",
+        {A, 4},
+        {-38, -16, 53, 31, -84, -40, 99, 55, -176, -88, 191, 103}}});
+}
+
+TEST(BoxWithNMSLimitGPUTest, CheckCPUGPUEqual) {
+  if (!HasCudaGPU()) {
+    return;
+  }
+  std::mt19937 gen(0);
+  const vector<float> batch_splits{150, 250};
+  const int N = 400;
+  const int num_classes = 5;
+
+  OperatorDef def;
+  def.set_name("test");
+  def.set_type("BoxWithNMSLimit");
+  def.add_input("scores");
+  def.add_input("boxes");
+  def.add_input("batch_splits");
+  for (const auto& output :
+       {"out_scores", "out_boxes", "out_classes", "out_batch_splits",
+        "out_keeps", "out_keeps_size"}) {
+    def.add_output(output);
+  }
+  def.add_arg()->CopyFrom(MakeArgument("score_thresh", 0.1f));
+  def.add_arg()->CopyFrom(MakeArgument("nms", 0.5f));
+  def.add_arg()->CopyFrom(MakeArgument("detections_per_im", 100));
+
+  ExpectCPUGPUEqual(
+      def,
+      {{"scores",
+        {N, num_classes},
+        RandomValues(N * num_classes, 0, 1, &gen)},
+       {"boxes",
+        {N, num_classes * 4},
+        RandomBoxes(N * num_classes, 200, 100, &gen)},
+       {"batch_splits", {2}, batch_splits}});
+}
+
+TEST(CollectAndDistributeFpnRpnProposalsGPUTest, CheckCPUGPUEqual) {
+  if (!HasCudaGPU()) {
+    return;
+  }
+  std::mt19937 gen(0);
+  const int N = 300;
+
+  OperatorDef def;
+  def.set_name("test");
+  def.set_type("CollectAndDistributeFpnRpnProposals");
+  vector<TestInput> inputs;
+  for (int lvl = 2; lvl <= 6; ++lvl) {
+    auto boxes = RandomBoxes(N, 800, 600, &gen);
+    vector<float> rois(N * 5);
+    for (int i = 0; i < N; ++i) {
+      rois[i * 5] = i % 2;
+      std::copy(
+          boxes.begin() + i * 4,
+          boxes.begin() + (i + 1) * 4,
+          rois.begin() + i * 5 + 1);
+    }
+    def.add_input("rpn_rois_fpn" + caffe2::to_string(lvl));
+    inputs.push_back({def.input(lvl - 2), {N, 5}, rois});
+  }
+  for (int lvl = 2; lvl <= 6; ++lvl) {
+    def.add_input("rpn_roi_probs_fpn" + caffe2::to_string(lvl));
+    inputs.push_back({def.input(lvl + 3), {N}, RandomValues(N, 0, 1, &gen)});
+  }
+  def.add_output("rois");
+  for (int lvl = 2; lvl <= 5; ++lvl) {
+    def.add_output("rois_fpn" + caffe2::to_string(lvl));
+  }
+  def.add_output("rois_idx_restore");
+  def.add_arg()->CopyFrom(MakeArgument("post_nms_topN", 1000));
+
+  ExpectCPUGPUEqual(def, inputs);
+}
+
+} // namespace caffe2
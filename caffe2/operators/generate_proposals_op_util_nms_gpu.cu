@@ -0,0 +1,165 @@
+#include "caffe2/operators/generate_proposals_op_util_nms_gpu.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+namespace utils {
+
+namespace {
+
+// Number of boxes per word of the bitmask, which is also the number of
+// threads of a block computing it.
+constexpr int kNMSBoxesPerWord = 64;
+// Number of threads reducing the bitmask of a set.
+constexpr int kNMSScanThreads = 128;
+
+__device__ inline float BoxesIoU(const float* a, const float* b) {
+  const float left = fmaxf(a[0], b[0]);
+  const float right = fminf(a[2], b[2]);
+  const float top = fmaxf(a[1], b[1]);
+  const float bottom = fminf(a[3], b[3]);
+  const float w = fmaxf(right - left + 1.0f, 0.0f);
+  const float h = fmaxf(bottom - top + 1.0f, 0.0f);
+  const float inter = w * h;
+  const float area_a = (a[2] - a[0] + 1.0f) * (a[3] - a[1] + 1.0f);
+  const float area_b = (b[2] - b[0] + 1.0f) * (b[3] - b[1] + 1.0f);
+  return inter / (area_a + area_b - inter);
+}
+
+// Sets bit j of mask[set][i][j / 64] if box j of the set overlaps the higher
+// scoring box i, for j > i. Block (x, y, z) compares the 64 boxes of word y
+// with the 64 boxes of word x of set z; the words below the diagonal are
+// never read and are not computed.
+__global__ void NMSMaskKernel(
+    const float* sorted_boxes,
+    const int* num_boxes,
+    const int max_boxes,
+    const int mask_words,
+    const float thresh,
+    unsigned long long* mask) {
+  const int set = blockIdx.z;
+  const int row_word = blockIdx.y;
+  const int col_word = blockIdx.x;
+  if (col_word < row_word) {
+    return;
+  }
+  const int n = num_boxes[set];
+  const int row_size = min(n - row_word * kNMSBoxesPerWord, kNMSBoxesPerWord);
+  const int col_size = min(n - col_word * kNMSBoxesPerWord, kNMSBoxesPerWord);
+  if (row_size <= 0 || col_size <= 0) {
+    return;
+  }
+
+  const float* boxes = sorted_boxes + set * max_boxes * 4;
+  __shared__ float col_boxes[kNMSBoxesPerWord * 4];
+  if (threadIdx.x < col_size) {
+    const float* box = boxes + (col_word * kNMSBoxesPerWord + threadIdx.x) * 4;
+    for (int k = 0; k < 4; ++k) {
+      col_boxes[threadIdx.x * 4 + k] = box[k];
+    }
+  }
+  __syncthreads();
+
+  if (threadIdx.x < row_size) {
+    const int i = row_word * kNMSBoxesPerWord + threadIdx.x;
+    const float* box = boxes + i * 4;
+    unsigned long long bits = 0;
+    const int start = (row_word == col_word) ? threadIdx.x + 1 : 0;
+    for (int j = start; j < col_size; ++j) {
+      if (BoxesIoU(box, col_boxes + j * 4) > thresh) {
+        bits |= 1ULL << j;
+      }
+    }
+    mask[(static_cast<size_t>(set) * max_boxes + i) * mask_words + col_word] =
+        bits;
+  }
+}
+
+// Greedily selects the boxes of a set from its bitmask, one block per set.
+// The boxes removed so far are kept as a bitmask in shared memory, which the
+// threads of the block update together for every selected box.
+__global__ void NMSScanKernel(
+    const unsigned long long* mask,
+    const int* num_boxes,
+    const int max_boxes,
+    const int mask_words,
+    const int topN,
+    int* keep,
+    int* num_keep) {
+  extern __shared__ unsigned long long removed[];
+  const int set = blockIdx.x;
+  const int n = num_boxes[set];
+  const int words = (n + kNMSBoxesPerWord - 1) / kNMSBoxesPerWord;
+  for (int w = threadIdx.x; w < words; w += blockDim.x) {
+    removed[w] = 0;
+  }
+  __syncthreads();
+
+  const unsigned long long* set_mask =
+      mask + static_cast<size_t>(set) * max_boxes * mask_words;
+  int* set_keep = keep + set * max_boxes;
+  int count = 0;
+  for (int i = 0; i < n && (topN < 0 || count < topN); ++i) {
+    // Box i only suppresses boxes after it, so bit i is final here and all
+    // threads take the same branch.
+    const int word = i / kNMSBoxesPerWord;
+    if (!(removed[word] & (1ULL << (i % kNMSBoxesPerWord)))) {
+      if (threadIdx.x == 0) {
+        set_keep[count] = i;
+      }
+      ++count;
+      const unsigned long long* row =
+          set_mask + static_cast<size_t>(i) * mask_words;
+      for (int w = word + threadIdx.x; w < words; w += blockDim.x) {
+        removed[w] |= row[w];
+      }
+    }
+    __syncthreads();
+  }
+  if (threadIdx.x == 0) {
+    num_keep[set] = count;
+  }
+}
+
+} // namespace
+
+void nms_gpu_batched(
+    const float* sorted_boxes,
+    const int* num_boxes,
+    int num_sets,
+    int max_boxes,
+    float thresh,
+    int topN,
+    int* keep,
+    int* num_keep,
+    TensorCUDA* mask,
+    CUDAContext* context) {
+  if (num_sets == 0) {
+    return;
+  }
+  if (max_boxes == 0) {
+    math::Set<int, CUDAContext>(num_sets, 0, num_keep, context);
+    return;
+  }
+  const int mask_words = (max_boxes + kNMSBoxesPerWord - 1) / kNMSBoxesPerWord;
+  CAFFE_ENFORCE_LE(
+      mask_words * sizeof(unsigned long long),
+      48 * 1024,
+      "Too many boxes for NMS on the GPU: ",
+      max_boxes);
+  mask->Resize(num_sets, max_boxes, mask_words);
+  auto* mask_data =
+      reinterpret_cast<unsigned long long*>(mask->mutable_data<int64_t>());
+
+  const dim3 blocks(mask_words, mask_words, num_sets);
+  NMSMaskKernel<<<blocks, kNMSBoxesPerWord, 0, context->cuda_stream()>>>(
+      sorted_boxes, num_boxes, max_boxes, mask_words, thresh, mask_data);
+  NMSScanKernel<<<
+      num_sets,
+      kNMSScanThreads,
+      mask_words * sizeof(unsigned long long),
+      context->cuda_stream()>>>(
+      mask_data, num_boxes, max_boxes, mask_words, topN, keep, num_keep);
+}
+
+} // namespace utils
+} // namespace caffe2
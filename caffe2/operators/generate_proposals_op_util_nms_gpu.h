@@ -0,0 +1,40 @@
+#ifndef CAFFE2_OPERATORS_UTILS_NMS_GPU_H_
+#define CAFFE2_OPERATORS_UTILS_NMS_GPU_H_
+
+#include "caffe2/core/context_gpu.h"
+
+namespace caffe2 {
+namespace utils {
+
+// Greedy non-maximum suppression on the GPU for a batch of independent sets
+//    of boxes, e.g. the proposals of every image, or the detections of every
+//    (image, class) pair. Gives the same result as nms_cpu() for each set.
+// The IoU of every pair of boxes of a set is computed in parallel into a
+//    bitmask, which is then reduced greedily by one thread block per set, so
+//    that no data goes through the host.
+// sorted_boxes: pixel coordinates of the boxes of each set, sorted by score
+//    from high to low, size: (num_sets, max_boxes, 4),
+//    format: [x1; y1; x2; y2]
+// num_boxes: number of valid boxes at the start of each set, size: (num_sets)
+// thresh: suppress a box if its IoU with a selected box is larger than this
+// topN: maximum number of boxes to select per set, -1 for no limit
+// keep: positions in 'sorted_boxes' of the selected boxes of each set, in
+//    order of selection, size: (num_sets, max_boxes)
+// num_keep: number of selected boxes of each set, size: (num_sets)
+// mask: scratch buffer for the bitmask
+void nms_gpu_batched(
+    const float* sorted_boxes,
+    const int* num_boxes,
+    int num_sets,
+    int max_boxes,
+    float thresh,
+    int topN,
+    int* keep,
+    int* num_keep,
+    TensorCUDA* mask,
+    CUDAContext* context);
+
+} // namespace utils
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_UTILS_NMS_GPU_H_
@@ -1,6 +1,29 @@
 #include "caffe2/operators/half_float_ops.h"
+#include "caffe2/perfkernels/half_float_conversion.h"
 
 namespace caffe2 {
+
+template <>
+bool FloatToHalfOp<CPUContext>::RunOnDevice() {
+  auto& X = Input(0);
+  auto* Y = Output(0);
+  Y->ResizeLike(X);
+  FloatToFloat16(X.size(), X.data<float>(), Y->mutable_data<float16>());
+  return true;
+}
+
+template <>
+bool HalfToFloatOp<CPUContext>::RunOnDevice() {
+  auto& X = Input(0);
+  auto* Y = Output(0);
+  Y->ResizeLike(X);
+  Float16ToFloat(X.size(), X.data<float16>(), Y->mutable_data<float>());
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(FloatToHalf, FloatToHalfOp<CPUContext>);
+REGISTER_CPU_OPERATOR(HalfToFloat, HalfToFloatOp<CPUContext>);
+
 OPERATOR_SCHEMA(FloatToHalf)
     .NumInputs(1)
     .NumOutputs(1)
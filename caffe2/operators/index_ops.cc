@@ -1,6 +1,7 @@
 #include <atomic>
 #include <limits>
 #include <mutex>
+#include <numeric>
 #include <sstream>
 #include <unordered_map>
 #include <vector>
@@ -36,18 +37,31 @@ struct IndexBase {
   const TypeMeta& Type() const { return meta_; }
 
   TIndexValue Size() {
-    std::lock_guard<std::mutex> guard(dictMutex_);
     return nextId_;
   }
 
  protected:
+  // Reserves the next index value, failing if the index is full
+  TIndexValue NextId() {
+    auto id = nextId_.load();
+    do {
+      if (id >= maxElements_) {
+        CAFFE_THROW("Dict max size reached");
+      }
+    } while (!nextId_.compare_exchange_weak(id, id + 1));
+    return id;
+  }
+
   int64_t maxElements_;
   TypeMeta meta_;
-  TIndexValue nextId_{1}; // guarded by dictMutex_
+  std::atomic<TIndexValue> nextId_{1};
   std::atomic<bool> frozen_{false};
-  std::mutex dictMutex_;
 };
 
+// The keys are split between shards by hash, each with its own lock, so that
+// IndexGet calls from concurrent nets rarely wait for each other. A call locks
+// each shard once to look up all of its keys, and only locks again for the
+// keys that were missing.
 template<typename T>
 struct Index: IndexBase {
   explicit Index(TIndexValue maxElements)
@@ -58,61 +72,137 @@ struct Index: IndexBase {
       FrozenGet(keys, values, numKeys);
       return;
     }
-    std::lock_guard<std::mutex> lock(dictMutex_);
-    for (int i = 0; i < numKeys; ++i) {
-      auto it = dict_.find(keys[i]);
-      if (it != dict_.end()) {
+    std::vector<size_t> order;
+    std::vector<size_t> shardStarts;
+    GroupByShard(keys, numKeys, &order, &shardStarts);
+    std::vector<size_t> missing;
+    for (int s = 0; s < kNumShards; ++s) {
+      if (shardStarts[s] == shardStarts[s + 1]) {
+        continue;
+      }
+      auto& shard = shards_[s];
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for (auto k = shardStarts[s]; k < shardStarts[s + 1]; ++k) {
+        const auto i = order[k];
+        auto it = shard.dict.find(keys[i]);
+        if (it != shard.dict.end()) {
+          values[i] = it->second;
+        } else {
+          missing.push_back(i);
+        }
+      }
+    }
+    // New keys get their values in the order they appear in
+    std::sort(missing.begin(), missing.end());
+    for (auto i : missing) {
+      auto& shard = shards_[ShardOf(keys[i])];
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto it = shard.dict.find(keys[i]);
+      if (it != shard.dict.end()) {
         values[i] = it->second;
-      } else if (nextId_ < maxElements_) {
-        auto newValue = nextId_++;
-        dict_.insert({keys[i], newValue});
-        values[i] = newValue;
       } else {
-        CAFFE_THROW("Dict max size reached");
+        auto newValue = NextId();
+        shard.dict.insert({keys[i], newValue});
+        values[i] = newValue;
       }
     }
   }
 
-  bool Load(const T* keys, size_t numKeys) {
+  bool Load(const T* keys, size_t numKeys, ThreadPool* pool = nullptr) {
     CAFFE_ENFORCE(
         numKeys <= maxElements_,
         "Cannot load index: Tensor is larger than max_elements.");
-    decltype(dict_) dict;
-    for (int i = 0; i < numKeys; ++i) {
-      CAFFE_ENFORCE(
-          dict.insert({keys[i], i + 1}).second,
-          "Repeated elements found: cannot load into dictionary.");
-    }
+    std::vector<size_t> order;
+    std::vector<size_t> shardStarts;
+    GroupByShard(keys, numKeys, &order, &shardStarts);
+    std::vector<Dict> dicts(kNumShards);
+    ParallelFor(pool, kNumShards, 1, [&](size_t begin, size_t end) {
+      for (auto s = begin; s < end; ++s) {
+        dicts[s].reserve(shardStarts[s + 1] - shardStarts[s]);
+        for (auto k = shardStarts[s]; k < shardStarts[s + 1]; ++k) {
+          const auto i = order[k];
+          CAFFE_ENFORCE(
+              dicts[s].insert({keys[i], i + 1}).second,
+              "Repeated elements found: cannot load into dictionary.");
+        }
+      }
+    });
     // assume no `get` is inflight while this happens
-    {
-      std::lock_guard<std::mutex> lock(dictMutex_);
+    for (int s = 0; s < kNumShards; ++s) {
+      std::lock_guard<std::mutex> lock(shards_[s].mutex);
       // let the old dict get destructed outside of the lock
-      dict_.swap(dict);
-      nextId_ = numKeys + 1;
+      shards_[s].dict.swap(dicts[s]);
     }
+    nextId_ = numKeys + 1;
     return true;
   }
 
   template<typename Ctx>
-  bool Store(Tensor<Ctx>* out) {
-    std::lock_guard<std::mutex> lock(dictMutex_);
+  bool Store(Tensor<Ctx>* out, ThreadPool* pool = nullptr) {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (auto& shard : shards_) {
+      locks.emplace_back(shard.mutex);
+    }
     out->Resize(nextId_ - 1);
     auto outData = out->template mutable_data<T>();
-    for (const auto& entry : dict_) {
-      outData[entry.second - 1] = entry.first;
-    }
+    ParallelFor(pool, kNumShards, 1, [&](size_t begin, size_t end) {
+      for (auto s = begin; s < end; ++s) {
+        for (const auto& entry : shards_[s].dict) {
+          outData[entry.second - 1] = entry.first;
+        }
+      }
+    });
     return true;
   }
 
  private:
+  using Dict = std::unordered_map<T, TIndexValue>;
+
+  static constexpr int kNumShards = 64;
+
+  struct Shard {
+    std::mutex mutex;
+    Dict dict;
+  };
+
+  static int ShardOf(const T& key) {
+    // The top bits of a multiplicative hash, as the low bits of std::hash are
+    // the ones the unordered_map of each shard uses
+    const uint64_t hash = std::hash<T>()(key);
+    return (hash * 0x9E3779B97F4A7C15ULL) >> 58;
+  }
+
+  // Sorts the positions of the keys by shard, keeping their order within a
+  // shard; the keys of shard s are at order[shardStarts[s]:shardStarts[s + 1]]
+  static void GroupByShard(
+      const T* keys,
+      size_t numKeys,
+      std::vector<size_t>* order,
+      std::vector<size_t>* shardStarts) {
+    std::vector<int> shardOfKey(numKeys);
+    shardStarts->assign(kNumShards + 1, 0);
+    for (size_t i = 0; i < numKeys; ++i) {
+      shardOfKey[i] = ShardOf(keys[i]);
+      ++(*shardStarts)[shardOfKey[i] + 1];
+    }
+    std::partial_sum(
+        shardStarts->begin(), shardStarts->end(), shardStarts->begin());
+    std::vector<size_t> next(shardStarts->begin(), shardStarts->end() - 1);
+    order->resize(numKeys);
+    for (size_t i = 0; i < numKeys; ++i) {
+      (*order)[next[shardOfKey[i]]++] = i;
+    }
+  }
+
   void FrozenGet(const T* keys, TIndexValue* values, size_t numKeys) {
     for (int i = 0; i < numKeys; ++i) {
-      auto it = dict_.find(keys[i]);
-      values[i] = it != dict_.end() ? it->second : 0;
+      const auto& dict = shards_[ShardOf(keys[i])].dict;
+      auto it = dict.find(keys[i]);
+      values[i] = it != dict.end() ? it->second : 0;
     }
   }
 
-  std::unordered_map<T, TIndexValue> dict_;
+  Shard shards_[kNumShards];
 };
 
 // TODO(azzolini): support sizes larger than int32
@@ -179,7 +269,7 @@ class IndexLoadOp: public Operator<CPUContext> {
       ++keys_data;
       --keys_size;
     }
-    return dict->Load(keys_data, keys_size);
+    return dict->Load(keys_data, keys_size, IntraOpThreadPool());
   }
 
  private:
@@ -201,7 +291,7 @@ class IndexStoreOp: public Operator<CPUContext> {
     auto& base = OperatorBase::Input<std::unique_ptr<IndexBase>>(0);
     auto* dict = dynamic_cast_if_rtti<Index<T>*>(base.get());
     CAFFE_ENFORCE(dict);
-    return dict->Store(Output(0));
+    return dict->Store(Output(0), IntraOpThreadPool());
   }
 };
 
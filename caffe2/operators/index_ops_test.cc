@@ -0,0 +1,101 @@
+#include <set>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+namespace {
+
+void RunOp(
+    const string& type,
+    const vector<string>& inputs,
+    const vector<string>& outputs,
+    Workspace* ws) {
+  OperatorDef def;
+  def.set_type(type);
+  for (const auto& input : inputs) {
+    def.add_input(input);
+  }
+  for (const auto& output : outputs) {
+    def.add_output(output);
+  }
+  ASSERT_TRUE(CreateOperator(def, ws)->Run());
+}
+
+void FeedKeys(const string& name, const vector<int64_t>& keys, Workspace* ws) {
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(keys.size());
+  std::copy(keys.begin(), keys.end(), tensor->mutable_data<int64_t>());
+}
+
+vector<int64_t> Fetch(const Workspace& ws, const string& name) {
+  const auto& tensor = ws.GetBlob(name)->Get<TensorCPU>();
+  return vector<int64_t>(
+      tensor.data<int64_t>(), tensor.data<int64_t>() + tensor.size());
+}
+
+} // namespace
+
+// Nets of several threads add overlapping keys to the same index, which has to
+// give every key a single value, with no gaps.
+TEST(IndexOpsTest, ConcurrentGet) {
+  const int kThreads = 4;
+  const int kKeys = 10000;
+  Workspace ws;
+  RunOp("LongIndexCreate", {}, {"index"}, &ws);
+
+  vector<std::unique_ptr<Workspace>> workspaces;
+  for (int t = 0; t < kThreads; ++t) {
+    workspaces.emplace_back(new Workspace(&ws));
+    vector<int64_t> keys;
+    for (int i = 0; i < kKeys; ++i) {
+      // Every thread has the even keys, and keys of its own
+      keys.push_back(i % 2 == 0 ? i * 1000003 : i * 1000003 + t);
+    }
+    FeedKeys("keys", keys, workspaces.back().get());
+  }
+  vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&workspaces, t]() {
+      RunOp("IndexGet", {"index", "keys"}, {"values"}, workspaces[t].get());
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::map<int64_t, int64_t> valueOfKey;
+  std::set<int64_t> values;
+  for (int t = 0; t < kThreads; ++t) {
+    const auto keys = Fetch(*workspaces[t], "keys");
+    const auto result = Fetch(*workspaces[t], "values");
+    for (int i = 0; i < kKeys; ++i) {
+      auto it = valueOfKey.emplace(keys[i], result[i]).first;
+      EXPECT_EQ(it->second, result[i]);
+      values.insert(result[i]);
+    }
+  }
+  EXPECT_EQ(valueOfKey.size(), values.size());
+  EXPECT_EQ(1, *values.begin());
+  EXPECT_EQ(values.size(), *values.rbegin());
+
+  // Storing and loading the index keeps the values of all keys
+  RunOp("IndexStore", {"index"}, {"stored"}, &ws);
+  RunOp("LongIndexCreate", {}, {"index2"}, &ws);
+  RunOp("IndexLoad", {"index2", "stored"}, {"index2"}, &ws);
+  const auto stored = Fetch(ws, "stored");
+  ASSERT_EQ(values.size(), stored.size());
+  FeedKeys("stored_keys", stored, &ws);
+  RunOp("IndexGet", {"index2", "stored_keys"}, {"stored_values"}, &ws);
+  const auto storedValues = Fetch(ws, "stored_values");
+  for (int i = 0; i < stored.size(); ++i) {
+    EXPECT_EQ(i + 1, storedValues[i]);
+    EXPECT_EQ(i + 1, valueOfKey[stored[i]]);
+  }
+}
+
+} // namespace caffe2
@@ -3,15 +3,20 @@
 namespace caffe2 {
 
 namespace {
-template <typename T>
-using EigenMatrixMapRowMajor = Eigen::Map<
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>;
 
-template <typename T>
-using ConstEigenMatrixMapRowMajor = Eigen::Map<
-    const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>;
+// The number of elements worth a thread handoff
+constexpr size_t kLayerNormParallelGrain = 1 << 14;
+
+size_t LayerNormGrain(int right) {
+  return kLayerNormParallelGrain / std::max(right, 1) + 1;
+}
+
 } // namespace
 
+// Each row is normalized by one thread while it is in its cache: its moments
+// are computed with a pass for the mean and one for the variance around it,
+// which is as cheap as E[x^2] - E[x]^2 there and doesn't lose precision when
+// the mean is large.
 template <>
 template <>
 bool LayerNormOp<CPUContext>::DoRunWithType<float>() {
@@ -33,37 +38,38 @@ bool LayerNormOp<CPUContext>::DoRunWithType<float>() {
   mean->Resize(stats_dims);
   stdev->Resize(stats_dims);
 
-  auto input_map = ConstEigenMatrixMapRowMajor<float>(
-      input.template data<float>(), left, right);
-  auto mean_map = EigenMatrixMapRowMajor<float>(
-      mean->template mutable_data<float>(), left, 1);
-  auto stdev_map = EigenMatrixMapRowMajor<float>(
-      stdev->template mutable_data<float>(), left, 1);
-  auto output_map = EigenMatrixMapRowMajor<float>(
-      output->template mutable_data<float>(), left, right);
-
-  auto sqr = [](float f) { return f * f; };
-  auto add_ep = [this](float f) { return f + epsilon_; };
-  auto fsqrt = [](float f) { return std::sqrt(f); };
-  // Calculate row-wise statistics
-  mean_map = input_map.rowwise().mean();
-  stdev_map =
-      (input_map.unaryExpr(sqr).rowwise().mean() - mean_map.unaryExpr(sqr))
-          .unaryExpr(add_ep)
-          .unaryExpr(fsqrt);
-  output_map = (input_map - mean_map.replicate(1, right))
-                   .cwiseQuotient(stdev_map.replicate(1, right));
+  const float* X = input.data<float>();
+  float* Y = output->mutable_data<float>();
+  float* mean_data = mean->mutable_data<float>();
+  float* stdev_data = stdev->mutable_data<float>();
+  ParallelFor(
+      IntraOpThreadPool(),
+      left,
+      LayerNormGrain(right),
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          ConstEigenVectorArrayMap<float> x(X + i * right, right);
+          const float mu = x.mean();
+          const float sigma = std::sqrt((x - mu).square().mean() + epsilon_);
+          EigenVectorArrayMap<float>(Y + i * right, right) =
+              (x - mu) * (1.0f / sigma);
+          mean_data[i] = mu;
+          stdev_data[i] = sigma;
+        }
+      });
 
   return true;
 }
 
 REGISTER_CPU_OPERATOR(LayerNorm, LayerNormOp<CPUContext>);
 
+// With y = (x - mean) / stdev and stdev^2 = var(x) + epsilon, for each row:
+// dx = (dy - mean(dy) - (x - mean) * mean((x - mean) * dy) / stdev^2) / stdev
+// which needs two sums over the row and a pass to write dx.
 template <>
 template <>
 bool LayerNormGradientOp<CPUContext>::DoRunWithType<float>() {
   const auto& dout = Input(0);
-  const auto& norm_outputs = Input(1);
   const auto& means = Input(2);
   const auto& stdev = Input(3);
   const auto& norm_inputs = Input(4);
@@ -75,58 +81,27 @@ bool LayerNormGradientOp<CPUContext>::DoRunWithType<float>() {
 
   ginput->ResizeLike(norm_inputs);
 
-  auto dout_map = ConstEigenMatrixMapRowMajor<float>(
-      dout.template data<float>(), left, right);
-  auto means_map =
-      ConstEigenMatrixMapRowMajor<float>(means.template data<float>(), left, 1);
-  auto stdev_map =
-      ConstEigenMatrixMapRowMajor<float>(stdev.template data<float>(), left, 1);
-  auto norm_inputs_map = ConstEigenMatrixMapRowMajor<float>(
-      norm_inputs.template data<float>(), left, right);
-  auto ginput_map = EigenMatrixMapRowMajor<float>(
-      ginput->template mutable_data<float>(), left, right);
-
-  // Helper functors
-  auto sqr = [](float f) { return f * f; };
-  auto recip = [](float f) { return 1.0f / f; };
-  auto neg_recip = [](float f) { return -1.0f / f; };
-
-  // Gradients - output block
-  // -1 / (stdev + epsilon)^2 * \sum_j^D x_ij - mean * dout
-  // First part: -1 / (stdev + epsilon)^2
-  auto dstdev_end_0 = stdev_map.unaryExpr(sqr).unaryExpr(neg_recip);
-  // Second part: \sum_j^D x_ij - mean * dout
-  auto dstdev_end_1 = (norm_inputs_map - means_map.replicate(1, right))
-                          .cwiseProduct(dout_map)
-                          .rowwise()
-                          .sum();
-  auto dstdev_end = dstdev_end_0.cwiseProduct(dstdev_end_1);
-  // \sum_j^D -dout * 1/(std+epsilon)
-  auto dmean_end = stdev_map.unaryExpr(neg_recip)
-                       .replicate(1, right)
-                       .cwiseProduct(dout_map)
-                       .rowwise()
-                       .sum();
-  // 1.0 / (stdev + epsilon) * dout
-  auto dx_end =
-      stdev_map.unaryExpr(recip).replicate(1, right).cwiseProduct(dout_map);
-
-  // Gradients - standard deviation block
-  // -1.0*(mean / stdev) * dstdev_end
-  auto dmean_stdev = stdev_map.unaryExpr(neg_recip)
-                         .cwiseProduct(means_map)
-                         .replicate(1, right)
-                         .cwiseProduct(dstdev_end);
-  // (mean / (D*stdev)) * dstdev
-  auto dx_stdev = (1.0f / right) *
-      norm_inputs_map.cwiseQuotient(stdev_map.replicate(1, right))
-          .cwiseProduct(dstdev_end.replicate(1, right));
-
-  // Gradients - mean block
-  auto dmean = dmean_end + dmean_stdev;
-  auto dx_mean = (1.0f / right) * dmean.replicate(1, right);
-
-  ginput_map = dx_end + dx_stdev + dx_mean;
+  const float* dY = dout.data<float>();
+  const float* X = norm_inputs.data<float>();
+  const float* mean_data = means.data<float>();
+  const float* stdev_data = stdev.data<float>();
+  float* dX = ginput->mutable_data<float>();
+  ParallelFor(
+      IntraOpThreadPool(),
+      left,
+      LayerNormGrain(right),
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          ConstEigenVectorArrayMap<float> dy(dY + i * right, right);
+          ConstEigenVectorArrayMap<float> x(X + i * right, right);
+          const float mu = mean_data[i];
+          const float rsigma = 1.0f / stdev_data[i];
+          const float dy_mean = dy.mean();
+          const float xdy_mean = ((x - mu) * dy).mean() * rsigma * rsigma;
+          EigenVectorArrayMap<float>(dX + i * right, right) =
+              (dy - dy_mean - (x - mu) * xdy_mean) * rsigma;
+        }
+      });
 
   return true;
 }
@@ -1,78 +1,227 @@
 #include "caffe2/operators/layer_norm_op.h"
 
-#include <cub/cub.cuh>
+#include <cub/block/block_reduce.cuh>
 
 #include "caffe2/core/context_gpu.h"
-#include "caffe2/utils/math.h"
+#include "caffe2/utils/GpuDefs.cuh"
 
 namespace caffe2 {
 
 namespace {
-template <typename T>
-struct SqrTransform {
-  inline __host__ __device__ T operator()(const T v) const {
-    return v * v;
+
+// Rows up to this size are reduced by a warp, larger ones by a block
+constexpr int kWarpRowMaxSize = 1024;
+constexpr int kWarpsPerBlock = CAFFE_CUDA_NUM_THREADS / kWarpSize;
+
+__device__ inline float WarpShflXor(float val, int mask) {
+#if CUDA_VERSION >= 9000
+  return __shfl_xor_sync(0xffffffff, val, mask);
+#else
+  return __shfl_xor(val, mask);
+#endif
+}
+
+__device__ inline float WarpShfl(float val, int lane) {
+#if CUDA_VERSION >= 9000
+  return __shfl_sync(0xffffffff, val, lane);
+#else
+  return __shfl(val, lane);
+#endif
+}
+
+// Running mean and sum of squared deviations from it (Welford), which can be
+// merged with those of another part of the row (Chan et al.)
+struct WelfordData {
+  float mean;
+  float m2;
+  float count;
+};
+
+__device__ inline WelfordData WelfordUpdate(WelfordData d, const float x) {
+  d.count += 1;
+  const float delta = x - d.mean;
+  d.mean += delta / d.count;
+  d.m2 += delta * (x - d.mean);
+  return d;
+}
+
+struct WelfordMerge {
+  __device__ inline WelfordData operator()(
+      const WelfordData& a,
+      const WelfordData& b) const {
+    const float count = a.count + b.count;
+    if (count == 0) {
+      return a;
+    }
+    const float delta = b.mean - a.mean;
+    const float b_ratio = b.count / count;
+    return WelfordData{a.mean + delta * b_ratio,
+                       a.m2 + b.m2 + delta * delta * a.count * b_ratio,
+                       count};
   }
 };
 
-// X = X - Y^2
-__global__ void sqrtXMinusYSquaredKernel(
-    const int N,
-    float* x,
-    const float* y,
-    const float epsilon) {
-  CUDA_1D_KERNEL_LOOP(i, N) {
-    x[i] = sqrtf(x[i] - y[i] * y[i] + epsilon);
+// Merges the data of all the lanes of a warp, and gives that of lane 0 to
+// all of them so that they agree on it exactly
+__device__ inline WelfordData WarpAllReduce(WelfordData d) {
+  for (int mask = kWarpSize / 2; mask > 0; mask /= 2) {
+    WelfordData other{WarpShflXor(d.mean, mask),
+                      WarpShflXor(d.m2, mask),
+                      WarpShflXor(d.count, mask)};
+    d = WelfordMerge()(d, other);
+  }
+  return WelfordData{WarpShfl(d.mean, 0), WarpShfl(d.m2, 0), d.count};
+}
+
+__device__ inline float WarpAllSum(float val) {
+  for (int mask = kWarpSize / 2; mask > 0; mask /= 2) {
+    val += WarpShflXor(val, mask);
+  }
+  return WarpShfl(val, 0);
+}
+
+// Normalizes each row with a single read for its moments, and one to write
+// the output, while it is in the cache. A warp handles each row.
+__global__ void LayerNormForwardWarpKernel(
+    const int left,
+    const int right,
+    const float epsilon,
+    const float* X,
+    float* mean,
+    float* stdev,
+    float* Y) {
+  const int lane = threadIdx.x % kWarpSize;
+  for (int i = blockIdx.x * kWarpsPerBlock + threadIdx.x / kWarpSize;
+       i < left;
+       i += gridDim.x * kWarpsPerBlock) {
+    const float* x = X + i * right;
+    WelfordData d{0, 0, 0};
+    for (int j = lane; j < right; j += kWarpSize) {
+      d = WelfordUpdate(d, x[j]);
+    }
+    d = WarpAllReduce(d);
+    const float sigma = sqrtf(d.m2 / right + epsilon);
+    if (lane == 0) {
+      mean[i] = d.mean;
+      stdev[i] = sigma;
+    }
+    const float rsigma = 1.0f / sigma;
+    for (int j = lane; j < right; j += kWarpSize) {
+      Y[i * right + j] = (x[j] - d.mean) * rsigma;
+    }
+  }
+}
+
+// Same as LayerNormForwardWarpKernel, with a block for each row
+__global__ void LayerNormForwardBlockKernel(
+    const int left,
+    const int right,
+    const float epsilon,
+    const float* X,
+    float* mean,
+    float* stdev,
+    float* Y) {
+  typedef cub::BlockReduce<WelfordData, CAFFE_CUDA_NUM_THREADS> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+  __shared__ float row_mean;
+  __shared__ float row_rsigma;
+  for (int i = blockIdx.x; i < left; i += gridDim.x) {
+    const float* x = X + i * right;
+    WelfordData d{0, 0, 0};
+    for (int j = threadIdx.x; j < right; j += blockDim.x) {
+      d = WelfordUpdate(d, x[j]);
+    }
+    d = BlockReduce(temp_storage).Reduce(d, WelfordMerge());
+    if (threadIdx.x == 0) {
+      const float sigma = sqrtf(d.m2 / right + epsilon);
+      mean[i] = d.mean;
+      stdev[i] = sigma;
+      row_mean = d.mean;
+      row_rsigma = 1.0f / sigma;
+    }
+    __syncthreads();
+    for (int j = threadIdx.x; j < right; j += blockDim.x) {
+      Y[i * right + j] = (x[j] - row_mean) * row_rsigma;
+    }
+    __syncthreads();
+  }
+}
+
+// dx = (dy - mean(dy) - (x - mean) * mean((x - mean) * dy) / stdev^2) / stdev
+// for each row, see the CPU operator. A warp handles each row.
+__global__ void LayerNormBackwardWarpKernel(
+    const int left,
+    const int right,
+    const float* dY,
+    const float* X,
+    const float* mean,
+    const float* stdev,
+    float* dX) {
+  const int lane = threadIdx.x % kWarpSize;
+  for (int i = blockIdx.x * kWarpsPerBlock + threadIdx.x / kWarpSize;
+       i < left;
+       i += gridDim.x * kWarpsPerBlock) {
+    const float* dy = dY + i * right;
+    const float* x = X + i * right;
+    const float mu = mean[i];
+    const float rsigma = 1.0f / stdev[i];
+    float dy_sum = 0;
+    float xdy_sum = 0;
+    for (int j = lane; j < right; j += kWarpSize) {
+      dy_sum += dy[j];
+      xdy_sum += (x[j] - mu) * dy[j];
+    }
+    const float dy_mean = WarpAllSum(dy_sum) / right;
+    const float xdy_mean = WarpAllSum(xdy_sum) / right * rsigma * rsigma;
+    for (int j = lane; j < right; j += kWarpSize) {
+      dX[i * right + j] = (dy[j] - dy_mean - (x[j] - mu) * xdy_mean) * rsigma;
+    }
   }
 }
 
-// out[i, j] = (X[i, j] - mu[i]) / sigma[i]
-__global__ void normalizeKernel(
-    const int row_dim,
-    const int N,
-    const float* x,
-    const float* mu,
-    const float* sigma,
-    float* out) {
-  CUDA_1D_KERNEL_LOOP(i, N) {
-    out[i] = (x[i] - mu[i / row_dim]) / (sigma[i / row_dim]);
+// Same as LayerNormBackwardWarpKernel, with a block for each row
+__global__ void LayerNormBackwardBlockKernel(
+    const int left,
+    const int right,
+    const float* dY,
+    const float* X,
+    const float* mean,
+    const float* stdev,
+    float* dX) {
+  typedef cub::BlockReduce<float, CAFFE_CUDA_NUM_THREADS> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage dy_storage;
+  __shared__ typename BlockReduce::TempStorage xdy_storage;
+  __shared__ float row_dy_mean;
+  __shared__ float row_xdy_mean;
+  for (int i = blockIdx.x; i < left; i += gridDim.x) {
+    const float* dy = dY + i * right;
+    const float* x = X + i * right;
+    const float mu = mean[i];
+    const float rsigma = 1.0f / stdev[i];
+    float dy_sum = 0;
+    float xdy_sum = 0;
+    for (int j = threadIdx.x; j < right; j += blockDim.x) {
+      dy_sum += dy[j];
+      xdy_sum += (x[j] - mu) * dy[j];
+    }
+    dy_sum = BlockReduce(dy_storage).Sum(dy_sum);
+    xdy_sum = BlockReduce(xdy_storage).Sum(xdy_sum);
+    if (threadIdx.x == 0) {
+      row_dy_mean = dy_sum / right;
+      row_xdy_mean = xdy_sum / right * rsigma * rsigma;
+    }
+    __syncthreads();
+    for (int j = threadIdx.x; j < right; j += blockDim.x) {
+      dX[i * right + j] =
+          (dy[j] - row_dy_mean - (x[j] - mu) * row_xdy_mean) * rsigma;
+    }
+    __syncthreads();
   }
 }
 
-template <typename InputIterator_t>
-void allocScratchAndReduce(
-    InputIterator_t input,
-    float* output,
-    int num_segments,
-    int* seg_indices,
-    Tensor<CUDAContext>* scratch,
-    cudaStream_t stream) {
-  size_t temp_storage_bytes;
-  cub::DeviceSegmentedReduce::Sum(
-      nullptr, // To retrieve required temporary storage size
-      temp_storage_bytes, // size_t &temp_storage_bytes
-      input, // InputIteratorT d_i
-      output, // OutputIteratorT d_out
-      num_segments, // int num_segments
-      seg_indices, // int *d_begin_offsets
-      seg_indices + 1, // int *d_end_offsets
-      stream // cudaStream_t stream=0
-      );
-  size_t temp_storage_floats = temp_storage_bytes / sizeof(float) +
-      (temp_storage_bytes % sizeof(float) ? 1 : 0);
-  scratch->Resize(vector<size_t>{temp_storage_floats});
-
-  cub::DeviceSegmentedReduce::Sum(
-      scratch->mutable_data<float>(), // To retrieve required temporary storage
-                                      // size
-      temp_storage_bytes, // size_t &temp_storage_bytes
-      input, // InputIteratorT d_i
-      output, // OutputIteratorT d_out
-      num_segments, // int num_segments
-      seg_indices, // int *d_begin_offsets
-      seg_indices + 1, // int *d_end_offsets
-      stream // cudaStream_t stream=0
-      );
+int WarpKernelBlocks(const int left) {
+  return std::min(
+      (left + kWarpsPerBlock - 1) / kWarpsPerBlock, CAFFE_MAXIMUM_NUM_BLOCKS);
 }
 
 } //  namespace
@@ -97,270 +246,92 @@ bool LayerNormOp<CUDAContext>::DoRunWithType<float>() {
   stats_dims.push_back(1);
   mean->Resize(stats_dims);
   stdev->Resize(stats_dims);
+  if (left == 0) {
+    output->mutable_data<float>();
+    mean->mutable_data<float>();
+    stdev->mutable_data<float>();
+    return true;
+  }
 
-  std::vector<int> segs(left + 1);
-  std::iota(segs.begin(), segs.end(), 0);
-  std::transform(
-      segs.begin(),
-      segs.end(),
-      segs.begin(),
-      std::bind1st(std::multiplies<int>(), right));
-
-  seg_indices_.Resize(vector<size_t>{segs.size()});
-  context_.CopyBytes<CPUContext, CUDAContext>(
-      sizeof(int) * segs.size(),
-      static_cast<void*>(segs.data()),
-      static_cast<void*>(seg_indices_.mutable_data<int>()));
-
-  if (right == 1) {
-    mean->CopyFrom(input);
-    mean->Resize(stats_dims);
-    math::Set<float, CUDAContext>(
-        left, std::sqrt(epsilon_), stdev->mutable_data<float>(), &context_);
-  } else {
-    // Calculate row-wise means
-    // First stage: sum up feature vectors
-    allocScratchAndReduce(
-        input.data<float>(),
-        mean->mutable_data<float>(),
-        left,
-        seg_indices_.mutable_data<int>(),
-        &scratch_,
-        context_.cuda_stream());
-
-    // Second stage: Normalize by feature vector dim
-    math::Scale<float, CUDAContext>(
+  if (right <= kWarpRowMaxSize) {
+    LayerNormForwardWarpKernel<<<
+        WarpKernelBlocks(left),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
         left,
-        1.0f / right,
-        mean->mutable_data<float>(),
+        right,
+        epsilon_,
+        input.data<float>(),
         mean->mutable_data<float>(),
-        &context_);
-
-    // Calculate row-wise standard deviation
-
-    // First stage: sum up row-wise squared values
-    SqrTransform<float> transform;
-    cub::TransformInputIterator<float, SqrTransform<float>, const float*> it(
-        input.data<float>(), transform);
-    allocScratchAndReduce(
-        it,
-        stdev->mutable_data<float>(),
-        left,
-        seg_indices_.mutable_data<int>(),
-        &scratch_,
-        context_.cuda_stream());
-
-    // Second stage: Normalize by feature vector dim
-    math::Scale<float, CUDAContext>(
-        left,
-        1.0f / right,
         stdev->mutable_data<float>(),
-        stdev->mutable_data<float>(),
-        &context_);
-
-    // stddev = sqrt(E(x^2) - E(x)^2 + epsilon)
-    sqrtXMinusYSquaredKernel<<<
-        CAFFE_GET_BLOCKS(left),
+        output->mutable_data<float>());
+  } else {
+    LayerNormForwardBlockKernel<<<
+        std::min(left, CAFFE_MAXIMUM_NUM_BLOCKS),
         CAFFE_CUDA_NUM_THREADS,
         0,
         context_.cuda_stream()>>>(
         left,
-        stdev->mutable_data<float>(),
+        right,
+        epsilon_,
+        input.data<float>(),
         mean->mutable_data<float>(),
-        epsilon_);
+        stdev->mutable_data<float>(),
+        output->mutable_data<float>());
   }
 
-  // out[i, j] = (in[i,j] - mu[i]) / (sigma[i])
-  normalizeKernel<<<
-      CAFFE_GET_BLOCKS(left),
-      CAFFE_CUDA_NUM_THREADS,
-      0,
-      context_.cuda_stream()>>>(
-      right,
-      left * right,
-      input.data<float>(),
-      mean->data<float>(),
-      stdev->data<float>(),
-      output->mutable_data<float>());
-
   return true;
 }
 
 REGISTER_CUDA_OPERATOR(LayerNorm, LayerNormOp<CUDAContext>);
 
-namespace {
-// x : [N, D]
-// y : [N, 1]
-// z : [N, D]
-// (x - broadcast(y)) * z
-__global__ void zTimesXminusYbroadcast(
-    int N,
-    int D,
-    const float* x,
-    const float* y,
-    const float* z,
-    float* out) {
-  CUDA_1D_KERNEL_LOOP(i, N * D) {
-    out[i] = (x[i] - y[i / D]) * z[i];
-  }
-}
-
-__global__ void normalizeByNegStdev(
-    int N,
-    bool var,
-    const float* x,
-    const float* stdev,
-    float* out) {
-  if (var) {
-    CUDA_1D_KERNEL_LOOP(i, N) {
-      out[i] = (-1.0f * x[i]) / (stdev[i] * stdev[i]);
-    }
-  } else {
-    CUDA_1D_KERNEL_LOOP(i, N) {
-      out[i] = (-1.0f * x[i]) / (stdev[i]);
-    }
-  }
-}
-
-__global__ void gradientMegaKernel(
-    int N,
-    int D,
-    const float* stdev,
-    const float* X,
-    const float* dstdev,
-    const float* dmean,
-    const float* dout,
-    float* out) {
-  CUDA_1D_KERNEL_LOOP(i, N * D) {
-    out[i] = 1.0f / stdev[i / D] * dout[i] +
-        X[i] / (D * stdev[i / D]) * dstdev[i / D] + 1.0f / D * dmean[i / D];
-  }
-}
-
-#define PRINT(X, N, D) printTensor<<<1, 1, 0, context_.cuda_stream()>>>(X, N, D)
-
-} // namespace
-
 template <>
 template <>
 bool LayerNormGradientOp<CUDAContext>::DoRunWithType<float>() {
   const auto& dout = Input(0);
-  const auto& norm_outputs = Input(1);
   const auto& means = Input(2);
   const auto& stdev = Input(3);
   const auto& norm_inputs = Input(4);
   auto* ginput = Output(0);
 
   const auto canonical_axis = norm_inputs.canonical_axis_index(axis_);
-  const unsigned long left = norm_inputs.size_to_dim(canonical_axis);
-  const unsigned long right = norm_inputs.size_from_dim(canonical_axis);
+  const int left = norm_inputs.size_to_dim(canonical_axis);
+  const int right = norm_inputs.size_from_dim(canonical_axis);
 
   ginput->ResizeLike(norm_inputs);
-  std::vector<TIndex> stats_dims(
-      norm_inputs.dims().begin(), norm_inputs.dims().begin() + canonical_axis);
-  stats_dims.push_back(1);
-  dmean_.Resize(stats_dims);
-  dstdev_.Resize(stats_dims);
-  gscratch_.Resize(std::vector<size_t>{left, right});
-
-  std::vector<int> segs(left + 1);
-  std::iota(segs.begin(), segs.end(), 0);
-  std::transform(
-      segs.begin(),
-      segs.end(),
-      segs.begin(),
-      std::bind1st(std::multiplies<int>(), right));
-
-  seg_indices_.Resize(vector<size_t>{segs.size()});
-  context_.CopyBytes<CPUContext, CUDAContext>(
-      sizeof(int) * segs.size(),
-      static_cast<void*>(segs.data()),
-      static_cast<void*>(seg_indices_.mutable_data<int>()));
-
-  // Calculate gradient of the standard deviation
-  // temp1 = (x - mean) * dout
-  zTimesXminusYbroadcast<<<
-      CAFFE_GET_BLOCKS(left * right),
-      CAFFE_CUDA_NUM_THREADS,
-      0,
-      context_.cuda_stream()>>>(
-      left,
-      right,
-      norm_inputs.data<float>(),
-      means.data<float>(),
-      dout.data<float>(),
-      gscratch_.mutable_data<float>());
-
-  dstdev_.Resize(vector<size_t>{left, 1});
-  // dstdev = reduce(temp1)
-  allocScratchAndReduce(
-      gscratch_.data<float>(),
-      dstdev_.mutable_data<float>(),
-      left,
-      seg_indices_.mutable_data<int>(),
-      &scratch_,
-      context_.cuda_stream());
-  // dstdev = -dstdev / sqrt(stdev)
-  normalizeByNegStdev<<<
-      CAFFE_GET_BLOCKS(left),
-      CAFFE_CUDA_NUM_THREADS,
-      0,
-      context_.cuda_stream()>>>(
-      left,
-      true,
-      dstdev_.data<float>(),
-      stdev.data<float>(),
-      dstdev_.mutable_data<float>());
-
-  // Calculate gradient of the mean
-  // dmean = reduce(dout)
-  allocScratchAndReduce(
-      dout.data<float>(),
-      dmean_.mutable_data<float>(),
-      left,
-      seg_indices_.mutable_data<int>(),
-      &scratch_,
-      context_.cuda_stream());
-  // mean * stdev
-  math::Mul(
-      left,
-      means.data<float>(),
-      dstdev_.data<float>(),
-      gscratch_.mutable_data<float>(),
-      &context_);
-  // [\sum dout] + mean * stdev
-  math::Add(
-      left,
-      dmean_.data<float>(),
-      gscratch_.data<float>(),
-      dmean_.mutable_data<float>(),
-      &context_);
-  // -1 / std * [[\sum dout] + mean * stdev]
-  normalizeByNegStdev<<<
-      CAFFE_GET_BLOCKS(left),
-      CAFFE_CUDA_NUM_THREADS,
-      0,
-      context_.cuda_stream()>>>(
-      left,
-      false,
-      dmean_.data<float>(),
-      stdev.data<float>(),
-      dmean_.mutable_data<float>());
-
-  // Calculate gradient of input
-  gradientMegaKernel<<<
-      CAFFE_GET_BLOCKS(left),
-      CAFFE_CUDA_NUM_THREADS,
-      0,
-      context_.cuda_stream()>>>(
-      left,
-      right,
-      stdev.data<float>(),
-      norm_inputs.data<float>(),
-      dstdev_.data<float>(),
-      dmean_.data<float>(),
-      dout.data<float>(),
-      ginput->mutable_data<float>());
+  if (left == 0) {
+    ginput->mutable_data<float>();
+    return true;
+  }
+
+  if (right <= kWarpRowMaxSize) {
+    LayerNormBackwardWarpKernel<<<
+        WarpKernelBlocks(left),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        left,
+        right,
+        dout.data<float>(),
+        norm_inputs.data<float>(),
+        means.data<float>(),
+        stdev.data<float>(),
+        ginput->mutable_data<float>());
+  } else {
+    LayerNormBackwardBlockKernel<<<
+        std::min(left, CAFFE_MAXIMUM_NUM_BLOCKS),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        left,
+        right,
+        dout.data<float>(),
+        norm_inputs.data<float>(),
+        means.data<float>(),
+        stdev.data<float>(),
+        ginput->mutable_data<float>());
+  }
 
   return true;
 }
@@ -0,0 +1,129 @@
+#include <cmath>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "caffe2/core/flags.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+namespace {
+
+class LayerNormOpTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    enabled_ = FLAGS_caffe2_intra_op_parallelism;
+  }
+  void TearDown() override {
+    FLAGS_caffe2_intra_op_parallelism = enabled_;
+  }
+
+ private:
+  bool enabled_;
+};
+
+const int kRows = 300;
+const int kCols = 200;
+const float kEpsilon = 1e-4f;
+
+void AddInput(
+    const string& name,
+    float offset,
+    std::mt19937* gen,
+    Workspace* ws) {
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(kRows, kCols);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  for (int i = 0; i < tensor->size(); ++i) {
+    tensor->mutable_data<float>()[i] = offset + dist(*gen);
+  }
+}
+
+vector<float> Fetch(const Workspace& ws, const string& name) {
+  const auto& tensor = ws.GetBlob(name)->Get<TensorCPU>();
+  return vector<float>(
+      tensor.data<float>(), tensor.data<float>() + tensor.size());
+}
+
+// Runs LayerNorm and its gradient on rows with a large mean, and returns
+// their outputs
+vector<vector<float>> RunOps(bool parallel) {
+  FLAGS_caffe2_intra_op_parallelism = parallel;
+  Workspace ws;
+  std::mt19937 gen(0);
+  AddInput("X", 100, &gen, &ws);
+  AddInput("dY", 0, &gen, &ws);
+
+  OperatorDef def;
+  def.set_type("LayerNorm");
+  def.add_input("X");
+  def.add_output("Y");
+  def.add_output("mean");
+  def.add_output("stdev");
+  def.add_arg()->CopyFrom(MakeArgument("epsilon", kEpsilon));
+  EXPECT_TRUE(CreateOperator(def, &ws)->Run());
+
+  OperatorDef grad_def;
+  grad_def.set_type("LayerNormGradient");
+  for (const auto& input : {"dY", "Y", "mean", "stdev", "X"}) {
+    grad_def.add_input(input);
+  }
+  grad_def.add_output("dX");
+  EXPECT_TRUE(CreateOperator(grad_def, &ws)->Run());
+
+  return {Fetch(ws, "Y"),
+          Fetch(ws, "mean"),
+          Fetch(ws, "stdev"),
+          Fetch(ws, "dX"),
+          Fetch(ws, "X"),
+          Fetch(ws, "dY")};
+}
+
+} // namespace
+
+TEST_F(LayerNormOpTest, MatchesReference) {
+  const auto outputs = RunOps(true);
+  const auto& Y = outputs[0];
+  const auto& dX = outputs[3];
+  const auto& X = outputs[4];
+  const auto& dY = outputs[5];
+  for (int i = 0; i < kRows; ++i) {
+    double mean = 0;
+    for (int j = 0; j < kCols; ++j) {
+      mean += X[i * kCols + j];
+    }
+    mean /= kCols;
+    double var = 0;
+    double dy_mean = 0;
+    double xdy_mean = 0;
+    for (int j = 0; j < kCols; ++j) {
+      const double x = X[i * kCols + j] - mean;
+      var += x * x;
+      dy_mean += dY[i * kCols + j];
+      xdy_mean += x * dY[i * kCols + j];
+    }
+    const double stdev = std::sqrt(var / kCols + kEpsilon);
+    dy_mean /= kCols;
+    xdy_mean /= kCols * stdev * stdev;
+    EXPECT_NEAR(mean, outputs[1][i], 1e-4);
+    EXPECT_NEAR(stdev, outputs[2][i], 1e-4);
+    for (int j = 0; j < kCols; ++j) {
+      const double x = X[i * kCols + j] - mean;
+      EXPECT_NEAR(x / stdev, Y[i * kCols + j], 1e-3);
+      EXPECT_NEAR(
+          (dY[i * kCols + j] - dy_mean - x * xdy_mean) / stdev,
+          dX[i * kCols + j],
+          1e-3);
+    }
+  }
+}
+
+TEST_F(LayerNormOpTest, MatchesSequential) {
+  const auto expected = RunOps(false);
+  const auto actual = RunOps(true);
+  EXPECT_EQ(expected, actual);
+}
+
+} // namespace caffe2
@@ -8,6 +8,7 @@
 #include "caffe2/operators/reducer_functors.h"
 #include "caffe2/perfkernels/fused_8bit_rowwise_embedding_lookup.h"
 #include "caffe2/utils/math.h"
+#include "caffe2/utils/mmap_prefetch.h"
 
 namespace caffe2 {
 
@@ -53,6 +54,13 @@ class SparseLengthsFused8BitRowwiseOp : public Operator<Context> {
     const std::vector<TIndex> shape = {lengths.dim(0), data.dim(1) - 8};
     output->Resize(shape);
 
+    // tables mapped from disk have the rows of the whole batch read ahead
+    PrefetchMappedRows(
+        data.raw_data(),
+        data.size_from_dim(1),
+        indices.template data<IndexType>(),
+        indices.size());
+
     Fused8BitRowwiseEmbeddingLookup(
         /*block_size=*/output->dim(1),
         /*output_size=*/output->dim(0),
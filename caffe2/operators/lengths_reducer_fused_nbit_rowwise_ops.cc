@@ -0,0 +1,194 @@
+#include "caffe2/operators/lengths_reducer_fused_nbit_rowwise_ops.h"
+#include "caffe2/core/registry.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(
+    SparseLengthsSumFused4BitRowwise,
+    SparseLengthsFusedNBitRowwiseOp<4, CPUContext>);
+OPERATOR_SCHEMA(SparseLengthsSumFused4BitRowwise)
+    .NumInputs(3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Performs the same operation as SparseLengthsSum, but operating on
+4-bit rowwise quantized matrices with fused storage (where each row
+stores packed quantized values, and then 4-byte scale and 4-byte bias).
+)DOC")
+    .Input(
+        0,
+        "DATA",
+        "uint8 tensor obtained with "
+        "operator FloatToFused4BitRowwiseQuantized")
+    .Input(
+        1,
+        "INDICES",
+        "Integer vector containing indices of the first "
+        "dimension of DATA for the slices that are being aggregated")
+    .Input(
+        2,
+        "LENGTHS",
+        "Vector with the same sum of elements as the first dimension of DATA")
+    .Output(0, "output", "output");
+NO_GRADIENT(SparseLengthsSumFused4BitRowwise);
+
+REGISTER_CPU_OPERATOR(
+    SparseLengthsWeightedSumFused4BitRowwise,
+    SparseLengthsFusedNBitRowwiseOp<4, CPUContext, /*with_weights=*/true>);
+OPERATOR_SCHEMA(SparseLengthsWeightedSumFused4BitRowwise)
+    .NumInputs(4)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Performs the same operation as SparseLengthsWeightedSum,
+but operating on 4-bit rowwise quantized matrices with fused storage
+(where each row stores packed quantized values, and then 4-byte scale and
+4-byte bias).
+)DOC")
+    .Input(
+        0,
+        "DATA",
+        "uint8 tensor obtained with "
+        "operator FloatToFused4BitRowwiseQuantized")
+    .Input(
+        1,
+        "INDICES",
+        "Integer vector containing indices of the first "
+        "dimension of DATA for the slices that are being aggregated")
+    .Input(
+        2,
+        "LENGTHS",
+        "Vector with the same sum of elements as the first dimension of DATA")
+    .Input(
+        3,
+        "WEIGHTS",
+        "Vector of weights to scale rows of DATA with before reduction")
+    .Output(0, "output", "output");
+NO_GRADIENT(SparseLengthsWeightedSumFused4BitRowwise);
+
+REGISTER_CPU_OPERATOR(
+    SparseLengthsMeanFused4BitRowwise,
+    SparseLengthsFusedNBitRowwiseOp<
+        4,
+        CPUContext,
+        /*with_weights=*/false,
+        /*is_mean=*/true>);
+OPERATOR_SCHEMA(SparseLengthsMeanFused4BitRowwise)
+    .NumInputs(3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Performs the same operation as SparseLengthsMean, but
+operating on 4-bit rowwise quantized matrices with fused storage
+(where each row stores packed quantized values, and then 4-byte scale and
+4-byte bias).
+)DOC")
+    .Input(
+        0,
+        "DATA",
+        "uint8 tensor obtained with "
+        "operator FloatToFused4BitRowwiseQuantized")
+    .Input(
+        1,
+        "INDICES",
+        "Integer vector containing indices of the first "
+        "dimension of DATA for the slices that are being aggregated")
+    .Input(
+        2,
+        "LENGTHS",
+        "Vector with the same sum of elements as the first dimension of DATA")
+    .Output(0, "output", "output");
+NO_GRADIENT(SparseLengthsMeanFused4BitRowwise);
+
+REGISTER_CPU_OPERATOR(
+    SparseLengthsSumFused2BitRowwise,
+    SparseLengthsFusedNBitRowwiseOp<2, CPUContext>);
+OPERATOR_SCHEMA(SparseLengthsSumFused2BitRowwise)
+    .NumInputs(3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Performs the same operation as SparseLengthsSum, but operating on
+2-bit rowwise quantized matrices with fused storage (where each row
+stores packed quantized values, and then 4-byte scale and 4-byte bias).
+)DOC")
+    .Input(
+        0,
+        "DATA",
+        "uint8 tensor obtained with "
+        "operator FloatToFused2BitRowwiseQuantized")
+    .Input(
+        1,
+        "INDICES",
+        "Integer vector containing indices of the first "
+        "dimension of DATA for the slices that are being aggregated")
+    .Input(
+        2,
+        "LENGTHS",
+        "Vector with the same sum of elements as the first dimension of DATA")
+    .Output(0, "output", "output");
+NO_GRADIENT(SparseLengthsSumFused2BitRowwise);
+
+REGISTER_CPU_OPERATOR(
+    SparseLengthsWeightedSumFused2BitRowwise,
+    SparseLengthsFusedNBitRowwiseOp<2, CPUContext, /*with_weights=*/true>);
+OPERATOR_SCHEMA(SparseLengthsWeightedSumFused2BitRowwise)
+    .NumInputs(4)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Performs the same operation as SparseLengthsWeightedSum,
+but operating on 2-bit rowwise quantized matrices with fused storage
+(where each row stores packed quantized values, and then 4-byte scale and
+4-byte bias).
+)DOC")
+    .Input(
+        0,
+        "DATA",
+        "uint8 tensor obtained with "
+        "operator FloatToFused2BitRowwiseQuantized")
+    .Input(
+        1,
+        "INDICES",
+        "Integer vector containing indices of the first "
+        "dimension of DATA for the slices that are being aggregated")
+    .Input(
+        2,
+        "LENGTHS",
+        "Vector with the same sum of elements as the first dimension of DATA")
+    .Input(
+        3,
+        "WEIGHTS",
+        "Vector of weights to scale rows of DATA with before reduction")
+    .Output(0, "output", "output");
+NO_GRADIENT(SparseLengthsWeightedSumFused2BitRowwise);
+
+REGISTER_CPU_OPERATOR(
+    SparseLengthsMeanFused2BitRowwise,
+    SparseLengthsFusedNBitRowwiseOp<
+        2,
+        CPUContext,
+        /*with_weights=*/false,
+        /*is_mean=*/true>);
+OPERATOR_SCHEMA(SparseLengthsMeanFused2BitRowwise)
+    .NumInputs(3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Performs the same operation as SparseLengthsMean, but
+operating on 2-bit rowwise quantized matrices with fused storage
+(where each row stores packed quantized values, and then 4-byte scale and
+4-byte bias).
+)DOC")
+    .Input(
+        0,
+        "DATA",
+        "uint8 tensor obtained with "
+        "operator FloatToFused2BitRowwiseQuantized")
+    .Input(
+        1,
+        "INDICES",
+        "Integer vector containing indices of the first "
+        "dimension of DATA for the slices that are being aggregated")
+    .Input(
+        2,
+        "LENGTHS",
+        "Vector with the same sum of elements as the first dimension of DATA")
+    .Output(0, "output", "output");
+NO_GRADIENT(SparseLengthsMeanFused2BitRowwise);
+
+} // namespace caffe2
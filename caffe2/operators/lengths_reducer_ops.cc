@@ -1,7 +1,10 @@
 #include "caffe2/operators/lengths_reducer_ops.h"
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
 #include "caffe2/utils/math.h"
+#include "caffe2/utils/mmap_prefetch.h"
+#include "caffe2/utils/threadpool/ThreadPool.h"
 
 namespace caffe2 {
 
@@ -53,4 +56,252 @@ REGISTER_CPU_OPERATOR_STR(
     "SparseLengthsPositionalWeightedSum",
     CPUSparseLengthsReductionOp<float, TensorTypes<float, float16>, 1, 0, 1>);
 
+namespace {
+
+// Number of rows at the start of the next chunk that are prefetched before a
+// chunk is reduced, so that the first lookups of the next table do not stall.
+constexpr int kPrefetchRows = 16;
+
+struct LookupTable {
+  const Tensor<CPUContext>* data;
+  const Tensor<CPUContext>* indices;
+  const int* lengths;
+  float* out;
+  TIndex block_size;
+  void (*lookup)(const LookupTable&, TIndex, TIndex, TIndex, TIndex);
+  void (*prefetch)(const LookupTable&, TIndex, TIndex);
+};
+
+// A run of consecutive segments of one table.
+struct LookupChunk {
+  int table;
+  TIndex segment_begin;
+  TIndex segment_end;
+  TIndex index_begin;
+  TIndex index_end;
+};
+
+template <typename InputType, typename IndexType>
+void LookupSegments(
+    const LookupTable& table,
+    TIndex segment_begin,
+    TIndex segment_end,
+    TIndex index_begin,
+    TIndex index_end) {
+  EmbeddingLookup<IndexType, InputType, float, false>(
+      table.block_size,
+      segment_end - segment_begin,
+      index_end - index_begin,
+      table.data->dim(0),
+      table.data->template data<InputType>(),
+      table.indices->template data<IndexType>() + index_begin,
+      table.lengths + segment_begin,
+      nullptr,
+      nullptr,
+      false,
+      table.out + segment_begin * table.block_size);
+}
+
+template <typename InputType, typename IndexType>
+void PrefetchRows(
+    const LookupTable& table,
+    TIndex index_begin,
+    TIndex index_end) {
+#ifdef __GNUC__
+  const auto* data = table.data->template data<InputType>();
+  const auto* indices = table.indices->template data<IndexType>();
+  const TIndex rows = table.data->dim(0);
+  const size_t row_bytes = table.block_size * sizeof(InputType);
+  for (TIndex i = index_begin; i < index_end; ++i) {
+    if (indices[i] < 0 || indices[i] >= rows) {
+      continue;
+    }
+    const char* row =
+        reinterpret_cast<const char*>(data + indices[i] * table.block_size);
+    for (size_t offset = 0; offset < row_bytes; offset += 64) {
+      __builtin_prefetch(row + offset, 0, 3);
+    }
+  }
+#endif // __GNUC__
+}
+
+template <typename InputType>
+void SetLookupFunctions(LookupTable* table) {
+  if (table->indices->template IsType<int32_t>()) {
+    table->lookup = &LookupSegments<InputType, int32_t>;
+    table->prefetch = &PrefetchRows<InputType, int32_t>;
+  } else {
+    CAFFE_ENFORCE(
+        table->indices->template IsType<int64_t>(),
+        "INDICES must be int32 or int64, got ",
+        table->indices->meta().name());
+    table->lookup = &LookupSegments<InputType, int64_t>;
+    table->prefetch = &PrefetchRows<InputType, int64_t>;
+  }
+}
+
+} // namespace
+
+MultiTableSparseLengthsSumOp::MultiTableSparseLengthsSumOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws),
+      ws_(ws),
+      min_chunk_size_(
+          OperatorBase::GetSingleArgument<int>("min_chunk_size", 1024)),
+      chunks_per_thread_(
+          OperatorBase::GetSingleArgument<int>("chunks_per_thread", 4)) {
+  CAFFE_ENFORCE_EQ(
+      InputSize() % 3, 0, "Inputs must be (DATA, INDICES, LENGTHS) triples");
+  CAFFE_ENFORCE_EQ(InputSize() / 3, OutputSize());
+  CAFFE_ENFORCE_GT(min_chunk_size_, 0);
+  CAFFE_ENFORCE_GT(chunks_per_thread_, 0);
+}
+
+bool MultiTableSparseLengthsSumOp::RunOnDevice() {
+  const int num_tables = OutputSize();
+  std::vector<LookupTable> tables(num_tables);
+  TIndex total_indices = 0;
+  for (int k = 0; k < num_tables; ++k) {
+    const auto& data = Input(3 * k);
+    const auto& indices = Input(3 * k + 1);
+    const auto& lengths = Input(3 * k + 2);
+    CAFFE_ENFORCE_GE(data.ndim(), 1, "DATA must be at least 1-D");
+    CAFFE_ENFORCE_EQ(1, indices.ndim(), "INDICES must be a vector");
+    CAFFE_ENFORCE_EQ(1, lengths.ndim(), "LENGTHS must be a vector");
+
+    const int* lengths_data = lengths.template data<int>();
+    TIndex lengths_sum = 0;
+    for (TIndex i = 0; i < lengths.size(); ++i) {
+      CAFFE_ENFORCE_GE(lengths_data[i], 0);
+      lengths_sum += lengths_data[i];
+    }
+    CAFFE_ENFORCE_EQ(
+        lengths_sum,
+        indices.size(),
+        "The sum of LENGTHS of table ",
+        k,
+        " must be the size of its INDICES");
+
+    auto* output = Output(k);
+    auto shape = data.dims();
+    shape[0] = lengths.dim(0);
+    output->Resize(shape);
+
+    auto& table = tables[k];
+    table.data = &data;
+    table.indices = &indices;
+    table.lengths = lengths_data;
+    table.out = output->template mutable_data<float>();
+    table.block_size = data.size_from_dim(1);
+    if (data.template IsType<float>()) {
+      SetLookupFunctions<float>(&table);
+    } else {
+      CAFFE_ENFORCE(
+          data.template IsType<float16>(),
+          "DATA must be float or float16, got ",
+          data.meta().name());
+      SetLookupFunctions<float16>(&table);
+    }
+    // tables mapped from disk have the rows of the whole batch read ahead
+    const size_t row_bytes = table.block_size * data.itemsize();
+    if (indices.template IsType<int32_t>()) {
+      PrefetchMappedRows(
+          data.raw_data(),
+          row_bytes,
+          indices.template data<int32_t>(),
+          indices.size());
+    } else {
+      PrefetchMappedRows(
+          data.raw_data(),
+          row_bytes,
+          indices.template data<int64_t>(),
+          indices.size());
+    }
+    total_indices += indices.size();
+  }
+
+  auto* pool = ws_->GetThreadPool();
+  const TIndex num_chunks_wanted =
+      static_cast<TIndex>(pool->getNumThreads()) * chunks_per_thread_;
+  const TIndex chunk_size = std::max<TIndex>(
+      min_chunk_size_,
+      (total_indices + num_chunks_wanted - 1) / num_chunks_wanted);
+
+  // Cut the segments of every table into chunks of about chunk_size indices.
+  // A segment is never split, so a chunk may be larger when a single segment
+  // is, and empty segments ride along with their neighbours.
+  std::vector<LookupChunk> chunks;
+  for (int k = 0; k < num_tables; ++k) {
+    const auto& table = tables[k];
+    const TIndex num_segments = Output(k)->dim(0);
+    LookupChunk chunk{k, 0, 0, 0, 0};
+    for (TIndex s = 0; s < num_segments; ++s) {
+      chunk.segment_end = s + 1;
+      chunk.index_end += table.lengths[s];
+      if (chunk.index_end - chunk.index_begin >= chunk_size) {
+        chunks.push_back(chunk);
+        chunk = LookupChunk{k, s + 1, s + 1, chunk.index_end, chunk.index_end};
+      }
+    }
+    if (chunk.segment_end > chunk.segment_begin) {
+      chunks.push_back(chunk);
+    }
+  }
+
+  auto run_chunk = [&](int /* unused */, size_t c) {
+    if (c + 1 < chunks.size()) {
+      const auto& next = chunks[c + 1];
+      const auto& next_table = tables[next.table];
+      next_table.prefetch(
+          next_table,
+          next.index_begin,
+          std::min<TIndex>(next.index_end, next.index_begin + kPrefetchRows));
+    }
+    const auto& chunk = chunks[c];
+    const auto& table = tables[chunk.table];
+    table.lookup(
+        table,
+        chunk.segment_begin,
+        chunk.segment_end,
+        chunk.index_begin,
+        chunk.index_end);
+  };
+  if (chunks.size() > 1) {
+    pool->run(run_chunk, chunks.size());
+  } else if (chunks.size() == 1) {
+    run_chunk(0, 0);
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(MultiTableSparseLengthsSum, MultiTableSparseLengthsSumOp);
+
+OPERATOR_SCHEMA(MultiTableSparseLengthsSum)
+    .NumInputs([](int n) { return n > 0 && n % 3 == 0; })
+    .NumOutputs(1, INT_MAX)
+    .OutputCalculator([](int n) { return n / 3; })
+    .SetDoc(R"DOC(
+Performs SparseLengthsSum for several tables in one operator. The inputs are
+K triples (DATA_k, INDICES_k, LENGTHS_k) and output k is the
+SparseLengthsSum of triple k. Tables may have different shapes and data
+(float or float16) and index (int32 or int64) types.
+
+Instead of K operators each doing a small lookup, the segments of all tables
+are cut into chunks of about the same number of indices which are reduced in
+parallel on the workspace thread pool; the rows at the start of the next chunk
+are prefetched while a chunk is being reduced.
+)DOC")
+    .Arg(
+        "min_chunk_size",
+        "Minimum number of indices reduced by one task (default 1024)")
+    .Arg(
+        "chunks_per_thread",
+        "Number of chunks the work is cut into per pool thread (default 4)")
+    .Input(0, "DATA_0", "First table")
+    .Input(1, "INDICES_0", "Indices into the first dimension of DATA_0")
+    .Input(2, "LENGTHS_0", "Segment lengths for INDICES_0")
+    .Output(0, "OUTPUT_0", "SparseLengthsSum of the first triple");
+NO_GRADIENT(MultiTableSparseLengthsSum);
+
 } // namespace caffe2
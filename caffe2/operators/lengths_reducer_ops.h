@@ -1,11 +1,15 @@
 #pragma once
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/operators/embedding_hot_row_cache.h"
 #include "caffe2/perfkernels/embedding_lookup.h"
+#include "caffe2/utils/mmap_prefetch.h"
 
 namespace caffe2 {
 
 // A templated class that implements SparseLengths[Sum,WeightedSum,Mean].
+// With a positive `hot_row_cache_size` argument the op keeps an
+// EmbeddingHotRowCache of the most frequently looked up rows of DATA.
 template <
     typename T, // output type
     class InputTypes, // supported input types, such as TensorTypes<float>
@@ -22,6 +26,15 @@ class CPUSparseLengthsReductionOp : public Operator<CPUContext> {
       : Operator<CPUContext>(operator_def, ws) {
     static_assert(
         !(USE_WEIGHT & USE_MEAN), "Cannot both specify weight and mean.");
+    const auto hot_row_cache_size =
+        OperatorBase::GetSingleArgument<int64_t>("hot_row_cache_size", 0);
+    if (hot_row_cache_size > 0) {
+      hot_row_cache_.reset(new EmbeddingHotRowCache(
+          "hot_row_cache/" + operator_def.output(0),
+          hot_row_cache_size,
+          OperatorBase::GetSingleArgument<int64_t>(
+              "hot_row_cache_refresh_interval", 1 << 20)));
+    }
   }
 
   ~CPUSparseLengthsReductionOp() {}
@@ -76,6 +89,22 @@ class CPUSparseLengthsReductionOp : public Operator<CPUContext> {
       in_weight = weightInput.template data<T>();
     }
 
+    // tables mapped from disk have the rows of the whole batch read ahead
+    PrefetchMappedRows(in_data, D * sizeof(InputType), indices, indices_size);
+
+    if (hot_row_cache_) {
+      hot_row_cache_->Lookup<IndexType, InputType, T, USE_POSITIONAL_WEIGHT>(
+          dataInput,
+          M,
+          indices_size,
+          indices,
+          lengths,
+          in_weight,
+          USE_MEAN,
+          out_data);
+      return true;
+    }
+
     // delegate work to perfkernel that branches based on architecture
     EmbeddingLookup<IndexType, InputType, T, USE_POSITIONAL_WEIGHT>(
         D,
@@ -101,6 +130,27 @@ class CPUSparseLengthsReductionOp : public Operator<CPUContext> {
     LENGTHS = 2 + USE_WEIGHT, // 2 in SparseLengths[Sum, Mean],
                               // 3 in SparseLengthsWeightedSum
   };
+
+  std::unique_ptr<EmbeddingHotRowCache> hot_row_cache_;
+};
+
+// SparseLengthsSum over several tables at once. Inputs are K triples
+// (DATA_k, INDICES_k, LENGTHS_k) and there is one output per triple. The
+// segments of all tables are cut into chunks of roughly equal index counts
+// that are run on the workspace thread pool.
+class MultiTableSparseLengthsSumOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  MultiTableSparseLengthsSumOp(const OperatorDef& operator_def, Workspace* ws);
+
+  bool RunOnDevice() override;
+
+ private:
+  Workspace* ws_;
+  // Minimum number of indices handled by one chunk.
+  int min_chunk_size_;
+  // Chunks per thread of the pool, to even out tables of different costs.
+  int chunks_per_thread_;
 };
 
 } // namespace caffe2
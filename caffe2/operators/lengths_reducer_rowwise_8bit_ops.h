@@ -9,6 +9,7 @@
 #include "caffe2/operators/reducer_functors.h"
 #include "caffe2/perfkernels/embedding_lookup.h"
 #include "caffe2/utils/math.h"
+#include "caffe2/utils/mmap_prefetch.h"
 
 namespace caffe2 {
 
@@ -70,6 +71,8 @@ class SparseLengths8BitsRowwiseOp : public Operator<Context> {
     // delegate work to perfkernel that branches based on architecture
     const TIndex indices_size = indicesInput.size();
     const TIndex N = dataInput.dim(0);
+    // tables mapped from disk have the rows of the whole batch read ahead
+    PrefetchMappedRows(input_data, in_block_size, indices, indices_size);
     EmbeddingLookup(
         in_block_size,
         outputSize,
@@ -0,0 +1,104 @@
+#include "caffe2/core/operator.h"
+#include "caffe2/core/shared_weights.h"
+#include "caffe2/utils/mmap_prefetch.h"
+
+namespace caffe2 {
+
+namespace {
+
+class SaveMappedOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  SaveMappedOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        ws_(ws),
+        path_(OperatorBase::GetSingleArgument<string>("path", "")) {
+    CAFFE_ENFORCE(!path_.empty(), "Must specify the path to save to");
+  }
+
+  bool RunOnDevice() override {
+    const auto& inputs = def().input();
+    SharedWeights::Publish(
+        path_, *ws_, std::vector<string>(inputs.begin(), inputs.end()));
+    return true;
+  }
+
+ private:
+  Workspace* ws_;
+  string path_;
+};
+
+class LoadMappedOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  LoadMappedOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        path_(OperatorBase::GetSingleArgument<string>("path", "")),
+        random_access_(
+            OperatorBase::GetSingleArgument<int>("random_access", 1)) {
+    CAFFE_ENFORCE(!path_.empty(), "Must specify the path to load from");
+  }
+
+  bool RunOnDevice() override {
+    auto weights = SharedWeights::Attach(path_);
+    CAFFE_ENFORCE(weights, "Shared weights not found: ", path_);
+    for (int i = 0; i < OutputSize(); ++i) {
+      auto* blob = OperatorBase::OutputBlob(i);
+      weights->ShareBlob(def().output(i), blob);
+      if (random_access_ && blob->IsType<TensorCPU>()) {
+        const auto& tensor = blob->Get<TensorCPU>();
+        if (IsMappedRegion(tensor.raw_data())) {
+          AdviseRandomAccess(tensor.raw_data(), tensor.nbytes());
+        }
+      }
+    }
+    return true;
+  }
+
+ private:
+  string path_;
+  bool random_access_;
+};
+
+} // namespace
+
+REGISTER_CPU_OPERATOR(SaveMapped, SaveMappedOp);
+REGISTER_CPU_OPERATOR(LoadMapped, LoadMappedOp);
+
+OPERATOR_SCHEMA(SaveMapped)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Writes the input blobs to a file that LoadMapped maps into memory instead of
+reading it. CPU tensors of the fixed size types are laid out so that they can
+be used in place; other blobs are stored serialized. The file is written
+under a temporary name and renamed into place when it is complete.
+)DOC")
+    .Arg("path", "(string) the file to write, e.g. on NVMe or under /dev/shm.")
+    .Input(0, "X, ...", "The blobs to save, stored under their names.");
+
+OPERATOR_SCHEMA(LoadMapped)
+    .NumInputs(0)
+    .NumOutputs(1, INT_MAX)
+    .SetDoc(R"DOC(
+Maps a file written by SaveMapped read-only and makes the outputs, matched by
+name, share its tensors instead of loading them into memory. Their pages are
+read from disk as they are first touched and may be evicted again, so tables
+larger than memory can be served with bounded memory. SparseLengthsSum and
+its variants and Gather read the rows that a batch looks up ahead of time.
+Every process that maps the same file shares one copy of its pages.
+
+The outputs are read-only: an operator that writes to them crashes.
+)DOC")
+    .Arg("path", "(string) the file to map.")
+    .Arg(
+        "random_access",
+        "(int, default 1) if set, tell the kernel that the tensors are read "
+        "at random, e.g. embedding tables, so that faults don't read ahead "
+        "pages that are unlikely to be used.")
+    .Output(0, "Y, ...", "The blobs of the file named like the outputs.");
+
+SHOULD_NOT_DO_GRADIENT(SaveMapped);
+NO_GRADIENT(LoadMapped);
+
+} // namespace caffe2
@@ -1,7 +1,65 @@
 #include "caffe2/operators/load_save_op.h"
 
+CAFFE2_DEFINE_int(
+    caffe2_async_save_staging_mb,
+    4096,
+    "The memory that async Saves may hold for the blobs they have not "
+    "written yet; a Save that needs more waits for the others to finish.");
+
 namespace caffe2 {
 
+CAFFE_KNOWN_TYPE(TouchedRows);
+CAFFE_KNOWN_TYPE(SaveHandle);
+
+SaveStagingBudget& SaveStagingBudget::Global() {
+  static SaveStagingBudget budget;
+  return budget;
+}
+
+void SaveStagingBudget::Acquire(size_t bytes, size_t held) {
+  const size_t limit =
+      static_cast<size_t>(FLAGS_caffe2_async_save_staging_mb) << 20;
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [&] { return used_ + bytes <= limit || used_ == held; });
+  used_ += bytes;
+}
+
+void SaveStagingBudget::Release(size_t bytes) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  used_ -= bytes;
+  cv_.notify_all();
+}
+
+SaveStaging::~SaveStaging() {
+  SaveStagingBudget::Global().Release(bytes_);
+}
+
+void SaveStaging::Stage(const string& key, const string& data) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  SaveStagingBudget::Global().Acquire(data.size(), bytes_);
+  bytes_ += data.size();
+  records_.emplace_back(key, data);
+}
+
+void SaveStaging::Snapshot(const string& name, const TensorCPU& tensor) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  SaveStagingBudget::Global().Acquire(tensor.nbytes(), bytes_);
+  bytes_ += tensor.nbytes();
+  std::unique_ptr<Blob> blob(new Blob());
+  blob->GetMutable<TensorCPU>()->CopyFrom(tensor);
+  snapshots_.emplace_back(name, std::move(blob));
+}
+
+void SaveStaging::WriteTo(
+    const BlobSerializerBase::SerializationAcceptor& acceptor) {
+  for (const auto& record : records_) {
+    acceptor(record.first, record.second);
+  }
+  for (const auto& snapshot : snapshots_) {
+    snapshot.second->Serialize(snapshot.first, acceptor);
+  }
+}
+
 template <>
 void LoadOp<CPUContext>::SetCurrentDevice(BlobProto* proto) {
   if (proto->has_tensor()) {
@@ -9,6 +67,107 @@ void LoadOp<CPUContext>::SetCurrentDevice(BlobProto* proto) {
   }
 }
 
+string SerializeRowDelta(
+    const TensorCPU& tensor,
+    const string& name,
+    const std::vector<int64_t>& rows) {
+  CAFFE_ENFORCE_GT(
+      tensor.ndim(), 0, "Row deltas need at least one dimension: ", name);
+  TensorCPU indices(vector<TIndex>{static_cast<TIndex>(rows.size())});
+  auto dims = tensor.dims();
+  dims[0] = rows.size();
+  TensorCPU values(dims);
+  const auto row_items = tensor.size_from_dim(1);
+  const auto row_bytes = row_items * tensor.itemsize();
+  const auto* src = static_cast<const char*>(tensor.raw_data());
+  auto* dst = static_cast<char*>(values.raw_mutable_data(tensor.meta()));
+  auto* indices_data = indices.mutable_data<int64_t>();
+  CPUContext context;
+  for (int i = 0; i < rows.size(); ++i) {
+    CAFFE_ENFORCE(
+        rows[i] >= 0 && rows[i] < tensor.dim(0),
+        "Touched row ",
+        rows[i],
+        " is out of range for ",
+        name);
+    indices_data[i] = rows[i];
+    context.CopyItems<CPUContext, CPUContext>(
+        tensor.meta(),
+        row_items,
+        src + rows[i] * row_bytes,
+        dst + i * row_bytes);
+  }
+
+  TensorProtos protos;
+  TensorSerializer<CPUContext> serializer;
+  serializer.Serialize(
+      indices, "indices", protos.add_protos(), 0, indices.size());
+  serializer.Serialize(
+      values, "values", protos.add_protos(), 0, values.size());
+  BlobProto proto;
+  proto.set_name(name);
+  proto.set_type(kRowDeltaBlobType);
+  proto.set_content(protos.SerializeAsString());
+  return proto.SerializeAsString();
+}
+
+void ApplyRowDelta(const BlobProto& proto, TensorCPU* tensor) {
+  const auto& name = proto.name();
+  TensorProtos protos;
+  CAFFE_ENFORCE(
+      protos.ParseFromString(proto.content()),
+      "Couldn't parse the row delta of ",
+      name);
+  CAFFE_ENFORCE_EQ(protos.protos_size(), 2, "Malformed row delta: ", name);
+  TensorCPU indices;
+  TensorCPU values;
+  TensorDeserializer<CPUContext> deserializer;
+  deserializer.Deserialize(protos.protos(0), &indices);
+  deserializer.Deserialize(protos.protos(1), &values);
+  CAFFE_ENFORCE(
+      values.meta() == tensor->meta(), "Row delta type mismatch for ", name);
+  CAFFE_ENFORCE_EQ(values.ndim(), tensor->ndim(), "Row delta of ", name);
+  for (int i = 1; i < values.ndim(); ++i) {
+    CAFFE_ENFORCE_EQ(values.dim(i), tensor->dim(i), "Row delta of ", name);
+  }
+  CAFFE_ENFORCE_EQ(values.dim(0), indices.size(), "Row delta of ", name);
+
+  const auto row_items = tensor->size_from_dim(1);
+  const auto row_bytes = row_items * tensor->itemsize();
+  const auto* src = static_cast<const char*>(values.raw_data());
+  auto* dst = static_cast<char*>(tensor->raw_mutable_data());
+  const auto* indices_data = indices.data<int64_t>();
+  CPUContext context;
+  for (int i = 0; i < indices.size(); ++i) {
+    CAFFE_ENFORCE(
+        indices_data[i] >= 0 && indices_data[i] < tensor->dim(0),
+        "Row ",
+        indices_data[i],
+        " of the delta is out of range for ",
+        name);
+    context.CopyItems<CPUContext, CPUContext>(
+        tensor->meta(),
+        row_items,
+        src + i * row_bytes,
+        dst + indices_data[i] * row_bytes);
+  }
+}
+
+int64_t DeltaManifestVersion(const string& serialized) {
+  Blob blob;
+  blob.Deserialize(serialized);
+  std::istringstream manifest(blob.Get<std::string>());
+  string tag;
+  int64_t version = 0;
+  manifest >> tag >> version;
+  CAFFE_ENFORCE(
+      manifest && tag == "version", "Malformed delta checkpoint manifest");
+  return version;
+}
+
+REGISTER_CPU_OPERATOR(TrackTouchedRows, TrackTouchedRowsOp);
+REGISTER_CPU_OPERATOR(WaitForSave, WaitForSaveOp<CPUContext>);
+
 REGISTER_CPU_OPERATOR(DBExists, DBExistsOp<CPUContext>);
 REGISTER_CPU_OPERATOR(Load, LoadOp<CPUContext>);
 REGISTER_CPU_OPERATOR(Save, SaveOp<CPUContext>);
@@ -30,6 +189,28 @@ Checks if the DB exists.
     .Arg("db_name", "(string) the path to the db to load.")
     .Arg("db_type", "(string) the type of the db.");
 
+OPERATOR_SCHEMA(TrackTouchedRows)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Adds the given row ids to the set of touched rows kept in the output blob,
+which is created empty on first use. Giving it the indices that a sparse
+optimizer such as SparseAdagrad is run with, and passing the blob to Save as
+one of its touched_rows, makes Save write only the rows that were updated
+since the last checkpoint.
+)DOC")
+    .Input(0, "indices", "int32 or int64 tensor of row ids")
+    .Output(0, "touched_rows", "The set of touched rows to add them to");
+
+OPERATOR_SCHEMA(WaitForSave)
+    .NumInputs(1)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Blocks until the async Save that produced the handle has written its db, and
+fails if that save failed.
+)DOC")
+    .Input(0, "handle", "The output of a Save with async_write set");
+
 OPERATOR_SCHEMA(Load)
     .NumInputs(0, INT_MAX)
     .NumOutputs(0, INT_MAX)
@@ -65,6 +246,11 @@ to specify the type of the input db/dbs.
         " blobs from multiple databases. If it is set, argument in \"db\" will be"
         " ignored.")
     .Arg("db_type", "(string) the type of the db.")
+    .Arg(
+        "num_threads",
+        "(int, default 1) if more than 1, the blobs are parsed and "
+        "deserialized on this many threads while the db is read, and the "
+        "chunks of a tensor are copied into it concurrently.")
     .Arg(
         "keep_device",
         "(int, default 0) if nonzero, the blobs are loaded into the device that "
@@ -82,16 +268,29 @@ to specify the type of the input db/dbs.
         "source_blob_names",
         "(list of strings) if set, used instead of output "
         "blob names, to specify which blobs in the db shall be loaded. Must be "
-        "the same length as number of output blobs.");
+        "the same length as number of output blobs.")
+    .Arg(
+        "deltas",
+        "(list of strings) the paths of delta checkpoints written by Save "
+        "with touched_rows, in the order they were saved in. They are "
+        "replayed over the blobs loaded from db or dbs.");
 
 OPERATOR_SCHEMA(Save)
     .NumInputs(1, INT_MAX)
-    .NumOutputs(0)
+    .NumOutputs(0, 1)
     .SetDoc(R"DOC(
 The Save operator saves a set of blobs to a db. It takes [1, infinity) number
-of inputs and has no output. The contents of the inputs are written into the
-db specified by the arguments.
+of inputs. The contents of the inputs are written into the db specified by the
+arguments.
+
+With async_write set, the CPU tensors are copied and the other blobs
+serialized, and the operator returns while a background thread writes them to
+the db. The memory held for this is bounded by --caffe2_async_save_staging_mb.
+A save waits for the previous one of the same operator to finish, and its
+optional output can be passed to WaitForSave.
 )DOC")
+    .Output(
+        0, "handle", "(optional) With async_write, a handle for WaitForSave")
     .Arg(
         "absolute_path",
         "(int, default 0) if set, use the db path directly and do not prepend "
@@ -106,6 +305,25 @@ db specified by the arguments.
         "blob_name_overrides",
         "(list of strings) if set, used instead of original "
         "blob names. Must be the same length as number of blobs.")
+    .Arg(
+        "touched_rows",
+        "(list of strings) if set, a delta checkpoint is written: for each "
+        "input with a non-empty name here, only the rows in that "
+        "TrackTouchedRows blob are saved. Must be the same length as number "
+        "of blobs.")
+    .Arg(
+        "reset_touched_rows",
+        "(int, default 1) if nonzero, the touched rows are cleared once a "
+        "delta checkpoint is written, so that the next one only has the rows "
+        "touched after it.")
+    .Arg(
+        "checkpoint_version",
+        "(int, default 0) the version recorded in a delta checkpoint. Load "
+        "enforces that deltas are replayed in increasing version.")
+    .Arg(
+        "async_write",
+        "(int, default 0) if nonzero, the blobs are written to the db in the "
+        "background after the operator returns.")
     .Arg("db", "(string) the path to the db to load.")
     .Arg("db_type", "(string) the type of the db.");
 
@@ -136,6 +354,8 @@ counter). This is determined whether we need to do checkpointing.
 
 OPERATOR_SCHEMA(Snapshot);
 
+SHOULD_NOT_DO_GRADIENT(TrackTouchedRows);
+SHOULD_NOT_DO_GRADIENT(WaitForSave);
 NO_GRADIENT(Load);
 SHOULD_NOT_DO_GRADIENT(DBExists);
 SHOULD_NOT_DO_GRADIENT(Save);
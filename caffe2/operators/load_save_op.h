@@ -1,8 +1,15 @@
 #ifndef CAFFE2_OPERATORS_LOAD_SAVE_OP_H_
 #define CAFFE2_OPERATORS_LOAD_SAVE_OP_H_
 
+#include <algorithm>
+#include <condition_variable>
 #include <cstdio>
+#include <exception>
+#include <future>
+#include <limits>
 #include <map>
+#include <mutex>
+#include <sstream>
 #include <unordered_set>
 
 #include "caffe2/core/blob_serialization.h"
@@ -12,6 +19,9 @@
 #include "caffe2/core/operator.h"
 #include "caffe2/utils/math.h"
 #include "caffe2/utils/proto_utils.h"
+#include "caffe2/utils/thread_pool.h"
+
+CAFFE2_DECLARE_int(caffe2_async_save_staging_mb);
 
 namespace caffe2 {
 
@@ -36,6 +46,109 @@ using db::Cursor;
 using db::DB;
 using db::Transaction;
 
+// The rows of a tensor that have been written to since the last delta
+// checkpoint, as recorded by TrackTouchedRows.
+struct TouchedRows {
+  std::unordered_set<int64_t> rows;
+};
+
+// The blob type of the records that hold only some rows of a tensor, and the
+// key of the record that describes a delta checkpoint.
+constexpr auto kRowDeltaBlobType = "TensorRowDelta";
+constexpr auto kDeltaManifestKey = "__delta_manifest__";
+
+// Serializes the given rows of the tensor, which must be sorted, into a
+// kRowDeltaBlobType BlobProto.
+string SerializeRowDelta(
+    const TensorCPU& tensor,
+    const string& name,
+    const std::vector<int64_t>& rows);
+// Overwrites the rows of the tensor with the ones stored in the proto.
+void ApplyRowDelta(const BlobProto& proto, TensorCPU* tensor);
+// Returns the version stored in a serialized delta manifest.
+int64_t DeltaManifestVersion(const string& serialized);
+
+// Bounds the memory held by async Saves for what they haven't written yet to
+// --caffe2_async_save_staging_mb.
+class SaveStagingBudget {
+ public:
+  static SaveStagingBudget& Global();
+
+  // Blocks until the bytes fit, or until all the staged bytes are the ones
+  // the caller already holds, so that a single save bigger than the budget
+  // still goes through on its own.
+  void Acquire(size_t bytes, size_t held);
+  void Release(size_t bytes);
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  size_t used_{0};
+};
+
+// What an async Save writes to the db after it has returned: snapshots of its
+// CPU tensors and the records of the blobs it serialized right away.
+class SaveStaging {
+ public:
+  SaveStaging() {}
+  ~SaveStaging();
+
+  // A serialization acceptor for the records to write later
+  void Stage(const string& key, const string& data);
+  // Copies the tensor, to be serialized when it is written
+  void Snapshot(const string& name, const TensorCPU& tensor);
+  void WriteTo(const BlobSerializerBase::SerializationAcceptor& acceptor);
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::pair<string, string>> records_;
+  std::vector<std::pair<string, std::unique_ptr<Blob>>> snapshots_;
+  size_t bytes_{0};
+
+  DISABLE_COPY_AND_ASSIGN(SaveStaging);
+};
+
+// The output of an async Save, which WaitForSave waits on.
+struct SaveHandle {
+  std::shared_future<void> done;
+};
+
+template <class Context>
+class WaitForSaveOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(WaitForSaveOp);
+
+  bool RunOnDevice() override {
+    const auto& handle = OperatorBase::Input<SaveHandle>(0);
+    if (handle.done.valid()) {
+      // rethrows the error of the save, if any
+      handle.done.get();
+    }
+    return true;
+  }
+};
+
+class TrackTouchedRowsOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  TrackTouchedRowsOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(0));
+  }
+
+  template <typename SIndex>
+  bool DoRunWithType() {
+    const auto& indices = Input(0);
+    const auto* data = indices.template data<SIndex>();
+    OperatorBase::Output<TouchedRows>(0)->rows.insert(
+        data, data + indices.size());
+    return true;
+  }
+};
+
 template <class Context>
 class DBExistsOp final : public Operator<Context> {
  public:
@@ -86,7 +199,13 @@ class LoadOp final : public Operator<Context> {
         allow_incomplete_(
             OperatorBase::GetSingleArgument<bool>("allow_incomplete", false)),
         blob_names_(
-            OperatorBase::GetRepeatedArgument<string>("source_blob_names")) {
+            OperatorBase::GetRepeatedArgument<string>("source_blob_names")),
+        num_threads_(OperatorBase::GetSingleArgument<int>("num_threads", 1)),
+        delta_db_names_(OperatorBase::GetRepeatedArgument<string>("deltas")) {
+    CAFFE_ENFORCE_GT(num_threads_, 0);
+    if (num_threads_ > 1) {
+      pool_.reset(new TaskThreadPool(num_threads_));
+    }
     if (InputSize() == 0) {
       CAFFE_ENFORCE_GT(db_type_.size(), 0, "Must specify a db type.");
       if (db_names_.empty()) {
@@ -105,6 +224,9 @@ class LoadOp final : public Operator<Context> {
         db_name_ = "";
       }
     }
+    CAFFE_ENFORCE(
+        delta_db_names_.empty() || db_type_.size() > 0,
+        "Must specify a db type for the deltas.");
     CAFFE_ENFORCE(blob_names_.empty() || blob_names_.size() == OutputSize(),
       "Number of output blobs and source_blob_names mismatch.");
     CAFFE_ENFORCE(blob_names_.empty() || strip_prefix_.empty(),
@@ -135,6 +257,14 @@ class LoadOp final : public Operator<Context> {
   bool RunOnDevice() override {
     int total_loaded_blobs = 0;
     std::unordered_map<string, BlobState> blob_states;
+    if (pool_) {
+      // SetCurrentDevice looks at the device of the calling thread, so the
+      // pool threads take it from here
+      BlobProto proto;
+      proto.mutable_tensor();
+      SetCurrentDevice(&proto);
+      current_device_ = proto.tensor().device_detail();
+    }
     if (InputSize() > 0) {
       for (int i = 0; i < InputSize(); ++i) {
         const db::DBReader& reader = OperatorBase::Input<db::DBReader>(i);
@@ -154,6 +284,22 @@ class LoadOp final : public Operator<Context> {
     }
 
     validateBlobStates(blob_states);
+    int64_t delta_version = std::numeric_limits<int64_t>::min();
+    for (const string& delta_db_name : delta_db_names_) {
+      string full_db_name = absolute_path_
+          ? delta_db_name
+          : (ws_->RootFolder() + "/" + delta_db_name);
+      std::unique_ptr<DB> in_db(
+          caffe2::db::CreateDB(db_type_, full_db_name, caffe2::db::READ));
+      CAFFE_ENFORCE(in_db.get(), "Cannot open db: ", full_db_name);
+      std::unique_ptr<Cursor> cursor(in_db->NewCursor());
+      extractDelta(
+          full_db_name,
+          cursor.get(),
+          &blob_states,
+          &total_loaded_blobs,
+          &delta_version);
+    }
     // Loaded all the needed blobs.
     if (load_all_ || total_loaded_blobs == OutputSize()) {
       VLOG(1) << "Loaded " << total_loaded_blobs << " blobs fully from db(s)";
@@ -214,6 +360,12 @@ class LoadOp final : public Operator<Context> {
         key_to_dbid_[key] = db_id;
       }
 
+      Blob* blob = ws_->CreateBlob(key);
+      if (pool_) {
+        ProcessBlobAsync(
+            blob, cursor->value(), blob_states, key, &loaded_blobs);
+        continue;
+      }
       BlobProto proto;
       CAFFE_ENFORCE(
           proto.ParseFromString(cursor->value()), "Couldn't parse Proto");
@@ -222,9 +374,9 @@ class LoadOp final : public Operator<Context> {
         // proto, we will set the current device.
         SetCurrentDevice(&proto);
       }
-      Blob* blob = ws_->CreateBlob(key);
       ProcessBlob(blob, proto, blob_states, key, &loaded_blobs);
     }
+    WaitForAsyncBlobs();
     *total_loaded_blobs += loaded_blobs;
   }
 
@@ -248,6 +400,17 @@ class LoadOp final : public Operator<Context> {
         }
 
         VLOG(2) << "Deserializing blob " << key;
+        auto blobIndex = output_indices_[key];
+        Blob* blob = outputs.at(blobIndex);
+        if (pool_) {
+          ProcessBlobAsync(
+              blob, cursor->value(), blob_states, key, &loaded_blobs);
+          std::lock_guard<std::mutex> guard(mutex_);
+          if (*total_loaded_blobs + loaded_blobs == OutputSize()) {
+            break;
+          }
+          continue;
+        }
         BlobProto proto;
         CAFFE_ENFORCE(proto.ParseFromString(cursor->value()));
         if (!keep_device_) {
@@ -255,8 +418,6 @@ class LoadOp final : public Operator<Context> {
           // proto, we will set the current device.
           SetCurrentDevice(&proto);
         }
-        auto blobIndex = output_indices_[key];
-        Blob* blob = outputs.at(blobIndex);
         ProcessBlob(blob, proto, blob_states, key, &loaded_blobs);
 
         if (*total_loaded_blobs + loaded_blobs == OutputSize()) {
@@ -265,9 +426,73 @@ class LoadOp final : public Operator<Context> {
       }
     }
 
+    WaitForAsyncBlobs();
     *total_loaded_blobs += loaded_blobs;
   }
 
+  // Replays a delta checkpoint written by Save with touched_rows over the
+  // blobs loaded so far. Row deltas overwrite rows of the loaded tensors in
+  // place, and blobs that were saved whole replace the loaded ones.
+  void extractDelta(
+      const string& db_name,
+      Cursor* cursor,
+      std::unordered_map<string, BlobState>* blob_states,
+      int* total_loaded_blobs,
+      int64_t* version) {
+    CAFFE_ENFORCE(cursor);
+    std::unordered_map<string, BlobState> delta_states;
+    int replaced_blobs = 0;
+    bool has_manifest = false;
+    for (; cursor->Valid(); cursor->Next()) {
+      if (cursor->key() == kDeltaManifestKey) {
+        const auto delta_version = DeltaManifestVersion(cursor->value());
+        CAFFE_ENFORCE_GT(
+            delta_version,
+            *version,
+            "Deltas must be given in the order they were saved in: ",
+            db_name);
+        *version = delta_version;
+        has_manifest = true;
+        continue;
+      }
+      const auto key = buildBlobNameFromDbKey(cursor->key());
+      Blob* blob = nullptr;
+      if (load_all_) {
+        blob = ws_->CreateBlob(key);
+      } else if (output_indices_.count(key)) {
+        blob = OperatorBase::Outputs().at(output_indices_[key]);
+      } else {
+        VLOG(1) << "Key " << key << " not used. Skipping.";
+        continue;
+      }
+      BlobProto proto;
+      CAFFE_ENFORCE(proto.ParseFromString(cursor->value()));
+      if (proto.type() == kRowDeltaBlobType) {
+        CAFFE_ENFORCE(
+            blob_states->count(key),
+            "Found a row delta for a blob that was not loaded: ",
+            key);
+        CAFFE_ENFORCE(
+            blob->IsType<TensorCPU>(),
+            "Row deltas can only be applied to CPU tensors: ",
+            key);
+        ApplyRowDelta(proto, blob->GetMutable<TensorCPU>());
+        continue;
+      }
+      if (!keep_device_) {
+        SetCurrentDevice(&proto);
+      }
+      ProcessBlob(blob, proto, &delta_states, key, &replaced_blobs);
+    }
+    CAFFE_ENFORCE(has_manifest, "Not a delta checkpoint: ", db_name);
+    validateBlobStates(delta_states);
+    for (const auto& iter : delta_states) {
+      if (blob_states->emplace(iter.first, iter.second).second) {
+        (*total_loaded_blobs)++;
+      }
+    }
+  }
+
   string buildBlobNameFromDbKey(const string& dbKey) {
     string key = dbKey.substr(0, dbKey.find(kChunkIdSeparator));
     if (!strip_prefix_.empty()) {
@@ -299,6 +524,83 @@ class LoadOp final : public Operator<Context> {
       blob->Reset();
     }
     blob->Deserialize(proto);
+    UpdateBlobState(proto, blob_states_ptr, key, loaded_blobs);
+  }
+
+  // With num_threads > 1, the records are parsed and deserialized on the
+  // pool. The chunks of a tensor are copied into it concurrently once the
+  // first one to arrive has allocated it; anything else is deserialized under
+  // mutex_, one record at a time. At most two records per thread are in
+  // flight, so that the reads from the db don't run ahead of them.
+  void ProcessBlobAsync(
+      Blob* blob,
+      const string& value,
+      std::unordered_map<string, BlobState>* blob_states,
+      const string& key,
+      int* loaded_blobs) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return in_flight_ < 2 * num_threads_; });
+      ++in_flight_;
+    }
+    auto content = std::make_shared<string>(value);
+    pool_->run([this, blob, content, blob_states, key, loaded_blobs]() {
+      try {
+        BlobProto proto;
+        CAFFE_ENFORCE(proto.ParseFromString(*content), "Couldn't parse Proto");
+        content->clear();
+        if (!keep_device_ && proto.has_tensor()) {
+          proto.mutable_tensor()->mutable_device_detail()->MergeFrom(
+              current_device_);
+        }
+        auto deserializer = CreateDeserializerForProto(proto);
+        const bool concurrent = deserializer->SupportsConcurrentChunks(proto);
+        {
+          std::lock_guard<std::mutex> guard(mutex_);
+          if (!concurrent) {
+            ProcessBlob(blob, proto, blob_states, key, loaded_blobs);
+          } else {
+            if (blob_states->count(key) == 0) {
+              blob->Reset();
+              deserializer->Prepare(proto, blob);
+            }
+            UpdateBlobState(proto, blob_states, key, loaded_blobs);
+          }
+        }
+        if (concurrent) {
+          deserializer->DeserializeChunk(proto, blob);
+        }
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (!error_) {
+          error_ = std::current_exception();
+        }
+      }
+      std::lock_guard<std::mutex> guard(mutex_);
+      --in_flight_;
+      cv_.notify_all();
+    });
+  }
+
+  void WaitForAsyncBlobs() {
+    if (!pool_) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return in_flight_ == 0; });
+    if (error_) {
+      auto error = error_;
+      error_ = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+  void UpdateBlobState(
+      const BlobProto& proto,
+      std::unordered_map<string, BlobState>* blob_states_ptr,
+      const string& key,
+      int* loaded_blobs) {
+    auto& blob_states = *blob_states_ptr;
     if (proto.has_content_num_chunks()) {
       if (!blob_states.count(key)) {
         blob_states[key] = BlobState(proto.content_num_chunks());
@@ -402,6 +704,16 @@ class LoadOp final : public Operator<Context> {
   std::map<string, int> output_indices_;
   std::map<string, int> key_to_dbid_;
   std::vector<std::string> blob_names_;
+  int num_threads_;
+  std::vector<std::string> delta_db_names_;
+
+  DeviceOption current_device_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int in_flight_{0};
+  std::exception_ptr error_;
+  // last, so that its threads are joined before anything they use goes away
+  std::unique_ptr<TaskThreadPool> pool_;
 };
 
 template <class Context>
@@ -418,13 +730,24 @@ class SaveOp final : public Operator<Context> {
         db_name_(OperatorBase::GetSingleArgument<string>("db", "")),
         db_type_(OperatorBase::GetSingleArgument<string>("db_type", "")),
         blob_names_(
-            OperatorBase::GetRepeatedArgument<string>("blob_name_overrides")) {
+            OperatorBase::GetRepeatedArgument<string>("blob_name_overrides")),
+        touched_rows_(
+            OperatorBase::GetRepeatedArgument<string>("touched_rows")),
+        reset_touched_rows_(
+            OperatorBase::GetSingleArgument<int>("reset_touched_rows", 1)),
+        version_(
+            OperatorBase::GetSingleArgument<int64_t>("checkpoint_version", 0)),
+        async_(OperatorBase::GetSingleArgument<int>("async_write", 0)) {
     CAFFE_ENFORCE_GT(db_name_.size(), 0, "Must specify a db name.");
     CAFFE_ENFORCE_GT(db_type_.size(), 0, "Must specify a db type.");
     CAFFE_ENFORCE(
         blob_names_.empty() ||
             blob_names_.size() == OperatorBase::Inputs().size(),
         "Number of blobs and blob_name_overrides mismatch.");
+    CAFFE_ENFORCE(
+        touched_rows_.empty() ||
+            touched_rows_.size() == OperatorBase::Inputs().size(),
+        "Number of blobs and touched_rows mismatch.");
     CAFFE_ENFORCE(
         blob_names_.empty() || strip_prefix_.empty(),
         "strip_prefix and blob_name_overrides are mutually exclusive.");
@@ -452,38 +775,137 @@ class SaveOp final : public Operator<Context> {
     }
   }
 
+  ~SaveOp() {
+    if (pending_.valid()) {
+      try {
+        pending_.get();
+      } catch (const std::exception& e) {
+        LOG(ERROR) << "Async save to " << db_name_ << " failed: " << e.what();
+      }
+    }
+  }
+
+  // Waits until the last async save is written, and rethrows its error.
+  void Wait() {
+    if (pending_.valid()) {
+      auto pending = std::move(pending_);
+      pending_ = std::shared_future<void>();
+      pending.get();
+    }
+  }
+
   bool RunOnDevice() override {
+    if (async_) {
+      // One async save in flight per op, so that they don't write the same db
+      // at the same time.
+      Wait();
+    }
     string full_db_name =
         absolute_path_ ? db_name_ : (ws_->RootFolder() + "/" + db_name_);
-    std::unique_ptr<DB> out_db(
+    std::shared_ptr<DB> out_db(
         caffe2::db::CreateDB(db_type_, full_db_name, caffe2::db::NEW));
     CAFFE_ENFORCE(out_db.get(), "Cannot open db for writing: ", full_db_name);
 
-    BlobSerializerBase::SerializationAcceptor acceptor = [&](
+    // With async, everything is staged instead, and written once this returns
+    std::shared_ptr<SaveStaging> staging;
+    BlobSerializerBase::SerializationAcceptor write = [&out_db](
         const std::string& blobName, const std::string& data) {
-      // transaction should take care of locking
-      VLOG(2) << "Sending " << blobName << " blob's data of size "
-              << data.size() << " to db";
-      auto transaction = out_db->NewTransaction();
-      transaction->Put(blobName, data);
-      transaction->Commit();
+      PutRecord(out_db.get(), blobName, data);
     };
+    if (async_) {
+      staging = std::make_shared<SaveStaging>();
+      write = [staging](const std::string& blobName, const std::string& data) {
+        staging->Stage(blobName, data);
+      };
+    }
 
     const vector<const Blob*>& inputs = OperatorBase::Inputs();
+    const bool delta = !touched_rows_.empty();
+    // A delta checkpoint: the tensors with touched rows only get those rows
+    // written, and a manifest tells Load to replay the db over a checkpoint
+    // it has already loaded.
+    std::ostringstream manifest;
+    manifest << "version " << version_ << "\n";
+    std::unordered_set<TouchedRows*> trackers;
     for (int i = 0; i < inputs.size(); ++i) {
-      inputs[i]->Serialize(blob_names_[i], acceptor);
+      if (!delta || touched_rows_[i].empty()) {
+        if (async_ && inputs[i]->IsType<TensorCPU>()) {
+          staging->Snapshot(blob_names_[i], inputs[i]->Get<TensorCPU>());
+        } else {
+          inputs[i]->Serialize(blob_names_[i], write);
+        }
+        continue;
+      }
+      Blob* tracker_blob = ws_->GetBlob(touched_rows_[i]);
+      CAFFE_ENFORCE(
+          tracker_blob, "Cannot find touched rows blob: ", touched_rows_[i]);
+      CAFFE_ENFORCE(
+          inputs[i]->IsType<TensorCPU>(),
+          "Only CPU tensors can be saved as row deltas: ",
+          blob_names_[i]);
+      auto* tracker = tracker_blob->GetMutable<TouchedRows>();
+      trackers.insert(tracker);
+      std::vector<int64_t> rows(tracker->rows.begin(), tracker->rows.end());
+      std::sort(rows.begin(), rows.end());
+      const auto& tensor = inputs[i]->Get<TensorCPU>();
+      write(blob_names_[i], SerializeRowDelta(tensor, blob_names_[i], rows));
+      manifest << blob_names_[i] << " " << rows.size() << " "
+               << tensor.dim(0) << "\n";
+    }
+    if (delta) {
+      Blob manifest_blob;
+      *manifest_blob.GetMutable<std::string>() = manifest.str();
+      manifest_blob.Serialize(kDeltaManifestKey, write);
+    }
+    if (!async_) {
+      out_db->Close();
+    }
+    if (reset_touched_rows_) {
+      for (auto* tracker : trackers) {
+        tracker->rows.clear();
+      }
+    }
+    if (async_) {
+      pending_ = std::async(std::launch::async, [out_db, staging]() mutable {
+                   // The handle keeps the task alive, so it lets go of the
+                   // staged blobs and the db as soon as they are written.
+                   auto db = std::move(out_db);
+                   auto staged = std::move(staging);
+                   staged->WriteTo(
+                       [&db](const std::string& key, const std::string& data) {
+                         PutRecord(db.get(), key, data);
+                       });
+                   db->Close();
+                 }).share();
+      if (OutputSize() > 0) {
+        OperatorBase::Output<SaveHandle>(0)->done = pending_;
+      }
     }
-    out_db->Close();
     return true;
   }
 
  private:
+  static void
+  PutRecord(DB* db, const std::string& blobName, const std::string& data) {
+    // transaction should take care of locking
+    VLOG(2) << "Sending " << blobName << " blob's data of size "
+            << data.size() << " to db";
+    auto transaction = db->NewTransaction();
+    transaction->Put(blobName, data);
+    transaction->Commit();
+  }
+
   Workspace* ws_;
   bool absolute_path_;
   string strip_prefix_;
   string db_name_;
   string db_type_;
   std::vector<std::string> blob_names_;
+  std::vector<std::string> touched_rows_;
+  bool reset_touched_rows_;
+  int64_t version_;
+  bool async_;
+  std::shared_future<void> pending_;
 };
 
 template <typename... Ts>
@@ -540,8 +962,12 @@ class CheckpointOp final : public Operator<Context> {
     if (iter % every_ == 0) {
       GetMutableArgument("db", true, &save_op_def_)
           ->set_s(FormatString(db_pattern_, iter));
-      SaveOp<Context> sub_op(save_op_def_, ws_);
-      return sub_op.Run();
+      // kept until the next checkpoint so that an async save can finish
+      if (save_op_) {
+        save_op_->Wait();
+      }
+      save_op_.reset(new SaveOp<Context>(save_op_def_, ws_));
+      return save_op_->Run();
     } else {
       return true;
     }
@@ -552,6 +978,7 @@ class CheckpointOp final : public Operator<Context> {
   int every_;
   Workspace* ws_;
   OperatorDef save_op_def_;
+  std::unique_ptr<SaveOp<Context>> save_op_;
 };
 
 } // namespace caffe2
@@ -15,4 +15,5 @@ void LoadOp<CUDAContext>::SetCurrentDevice(BlobProto* proto) {
 REGISTER_CUDA_OPERATOR(Load, LoadOp<CUDAContext>);
 REGISTER_CUDA_OPERATOR(Save, SaveOp<CUDAContext>);
 REGISTER_CUDA_OPERATOR(Checkpoint, CheckpointOp<CUDAContext>);
+REGISTER_CUDA_OPERATOR(WaitForSave, WaitForSaveOp<CUDAContext>);
 }  // namespace caffe2
@@ -0,0 +1,369 @@
+#include "caffe2/operators/nchwc_ops.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+inline int DivUp(int a, int b) {
+  return (a + b - 1) / b;
+}
+
+struct MaxPoolNCHWc {
+  static float initialize() {
+    return -FLT_MAX;
+  }
+  static void process(float x, float* y) {
+    *y = std::max(*y, x);
+  }
+  static void finalize(int /*size*/, float* /*y*/) {}
+};
+
+struct AveragePoolNCHWc {
+  static float initialize() {
+    return 0.f;
+  }
+  static void process(float x, float* y) {
+    *y += x;
+  }
+  static void finalize(int size, float* y) {
+    *y /= size;
+  }
+};
+
+} // namespace
+
+void NCHWcOpBase::ComputeOutputSize(int H, int W, int* OH, int* OW) {
+  if (global_pooling_) {
+    kernel_.assign({H, W});
+    *OH = 1;
+    *OW = 1;
+    return;
+  }
+  ComputeSizeAndPad(
+      H, stride_[0], kernel_[0], dilation_[0], legacy_pad_, &pads_[0],
+      &pads_[2], OH);
+  ComputeSizeAndPad(
+      W, stride_[1], kernel_[1], dilation_[1], legacy_pad_, &pads_[1],
+      &pads_[3], OW);
+}
+
+bool ConvNCHWcOp::RunOnDeviceWithOrderNCHW() {
+  const auto& X = Input(INPUT);
+  const auto& filter = Input(FILTER);
+  auto* Y = Output(0);
+  const int B = block_;
+  CAFFE_ENFORCE(X.ndim() == 4 || X.ndim() == 5);
+  CAFFE_ENFORCE_EQ(filter.ndim(), 4);
+  const int N = X.dim32(0);
+  const int H = X.dim32(2);
+  const int W = X.dim32(3);
+  const bool blocked = X.ndim() == 5;
+  if (blocked) {
+    CAFFE_ENFORCE_EQ(X.dim32(4), B, "The input is not blocked by ", B);
+  }
+  const int C = blocked ? X.dim32(1) * B : X.dim32(1);
+  const int CB = DivUp(C, B);
+  const int M = filter.dim32(0);
+  CAFFE_ENFORCE_EQ(filter.dim32(1), C);
+  CAFFE_ENFORCE_EQ(filter.dim32(2), kernel_h());
+  CAFFE_ENFORCE_EQ(filter.dim32(3), kernel_w());
+  CAFFE_ENFORCE_EQ(
+      M % B, 0, "The output channels ", M, " are not a multiple of ", B);
+  const int MB = M / B;
+  const float* bias = nullptr;
+  if (InputSize() == 3) {
+    CAFFE_ENFORCE_EQ(Input(BIAS).size(), M);
+    bias = Input(BIAS).data<float>();
+  }
+
+  int OH = 0;
+  int OW = 0;
+  ComputeOutputSize(H, W, &OH, &OW);
+  Y->Resize(vector<TIndex>{N, MB, OH, OW, B});
+
+  // An NCHW input is blocked here, with the last block padded with zeros
+  const float* X_data = X.data<float>();
+  if (!blocked) {
+    input_buffer_.Resize(vector<TIndex>{N, CB, H, W, B});
+    float* buffer = input_buffer_.mutable_data<float>();
+    std::fill(buffer, buffer + input_buffer_.size(), 0.f);
+    for (int n = 0; n < N; ++n) {
+      for (int c = 0; c < C; ++c) {
+        const float* x = X_data + (static_cast<size_t>(n) * C + c) * H * W;
+        float* x_blocked = buffer +
+            ((static_cast<size_t>(n) * CB + c / B) * H * W) * B + c % B;
+        for (int hw = 0; hw < H * W; ++hw) {
+          x_blocked[hw * B] = x[hw];
+        }
+      }
+    }
+    X_data = buffer;
+  }
+
+  // filter_buffer_[mb][cb][i][j][ci][co] =
+  //     filter[mb * B + co][cb * B + ci][i][j]
+  const int kernel_size = kernel_h() * kernel_w();
+  filter_buffer_.Resize(vector<TIndex>{MB, CB, kernel_size, B, B});
+  float* packed = filter_buffer_.mutable_data<float>();
+  std::fill(packed, packed + filter_buffer_.size(), 0.f);
+  const float* filter_data = filter.data<float>();
+  for (int m = 0; m < M; ++m) {
+    for (int c = 0; c < C; ++c) {
+      const float* f =
+          filter_data + (static_cast<size_t>(m) * C + c) * kernel_size;
+      float* p = packed +
+          (static_cast<size_t>(m / B) * CB + c / B) * kernel_size * B * B +
+          c % B * B + m % B;
+      for (int k = 0; k < kernel_size; ++k) {
+        p[k * B * B] = f[k];
+      }
+    }
+  }
+
+  float* Y_data = Y->mutable_data<float>();
+  if (B == 8) {
+    RunBlocked<8>(N, CB, H, W, MB, OH, OW, X_data, packed, bias, Y_data);
+  } else {
+    RunBlocked<16>(N, CB, H, W, MB, OH, OW, X_data, packed, bias, Y_data);
+  }
+  return true;
+}
+
+// Direct convolution: every output pixel accumulates the kBlock output
+// channels of its block in registers, as rank-1 updates of the input
+// channels and the filter rows, both contiguous.
+template <int kBlock>
+void ConvNCHWcOp::RunBlocked(
+    int N,
+    int CB,
+    int H,
+    int W,
+    int MB,
+    int OH,
+    int OW,
+    const float* X,
+    const float* filter,
+    const float* bias,
+    float* Y) {
+  const int KH = kernel_h();
+  const int KW = kernel_w();
+  for (int n = 0; n < N; ++n) {
+    for (int mb = 0; mb < MB; ++mb) {
+      for (int oh = 0; oh < OH; ++oh) {
+        float* y_row = Y +
+            ((static_cast<size_t>(n) * MB + mb) * OH + oh) * OW * kBlock;
+        for (int ow = 0; ow < OW; ++ow) {
+          for (int k = 0; k < kBlock; ++k) {
+            y_row[ow * kBlock + k] = bias ? bias[mb * kBlock + k] : 0.f;
+          }
+        }
+        for (int cb = 0; cb < CB; ++cb) {
+          for (int i = 0; i < KH; ++i) {
+            const int ih = oh * stride_h() - pad_t() + i * dilation_h();
+            if (ih < 0 || ih >= H) {
+              continue;
+            }
+            const float* x_row = X +
+                ((static_cast<size_t>(n) * CB + cb) * H + ih) * W * kBlock;
+            for (int j = 0; j < KW; ++j) {
+              const float* w = filter +
+                  (((static_cast<size_t>(mb) * CB + cb) * KH + i) * KW + j) *
+                      kBlock * kBlock;
+              // Outputs whose input column ow * stride + offset is in [0, W)
+              const int offset = j * dilation_w() - pad_l();
+              const int ow_begin =
+                  offset >= 0 ? 0 : DivUp(-offset, stride_w());
+              const int ow_end = offset >= W
+                  ? 0
+                  : std::min(OW, DivUp(W - offset, stride_w()));
+              for (int ow = ow_begin; ow < ow_end; ++ow) {
+                const float* x = x_row + (ow * stride_w() + offset) * kBlock;
+                float* y = y_row + ow * kBlock;
+                float acc[kBlock];
+                for (int k = 0; k < kBlock; ++k) {
+                  acc[k] = y[k];
+                }
+                for (int c = 0; c < kBlock; ++c) {
+                  const float x_c = x[c];
+                  const float* w_c = w + c * kBlock;
+                  for (int k = 0; k < kBlock; ++k) {
+                    acc[k] += x_c * w_c[k];
+                  }
+                }
+                for (int k = 0; k < kBlock; ++k) {
+                  y[k] = acc[k];
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename PoolType>
+bool PoolNCHWcOp<PoolType>::RunOnDeviceWithOrderNCHW() {
+  const auto& X = Input(0);
+  auto* Y = Output(0);
+  CAFFE_ENFORCE_EQ(X.ndim(), 5, "The input is not in the NCHWc order.");
+  const int N = X.dim32(0);
+  const int CB = X.dim32(1);
+  const int H = X.dim32(2);
+  const int W = X.dim32(3);
+  const int B = X.dim32(4);
+  int OH = 0;
+  int OW = 0;
+  ComputeOutputSize(H, W, &OH, &OW);
+  Y->Resize(vector<TIndex>{N, CB, OH, OW, B});
+
+  const float* X_data = X.data<float>();
+  float* Y_data = Y->mutable_data<float>();
+  for (int ncb = 0; ncb < N * CB; ++ncb) {
+    const float* x = X_data + static_cast<size_t>(ncb) * H * W * B;
+    for (int oh = 0; oh < OH; ++oh) {
+      int h_start = oh * stride_h() - pad_t();
+      const int h_end = std::min(h_start + kernel_h(), H);
+      h_start = std::max(h_start, 0);
+      for (int ow = 0; ow < OW; ++ow) {
+        int w_start = ow * stride_w() - pad_l();
+        const int w_end = std::min(w_start + kernel_w(), W);
+        w_start = std::max(w_start, 0);
+        float* y =
+            Y_data + ((static_cast<size_t>(ncb) * OH + oh) * OW + ow) * B;
+        std::fill(y, y + B, PoolType::initialize());
+        for (int h = h_start; h < h_end; ++h) {
+          for (int w = w_start; w < w_end; ++w) {
+            const float* x_hw = x + (h * W + w) * B;
+            for (int k = 0; k < B; ++k) {
+              PoolType::process(x_hw[k], y + k);
+            }
+          }
+        }
+        const int size = (h_end - h_start) * (w_end - w_start);
+        for (int k = 0; k < B; ++k) {
+          PoolType::finalize(size, y + k);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool SpatialBNNCHWcOp::RunOnDevice() {
+  const auto& X = Input(INPUT);
+  const auto& scale = Input(SCALE);
+  const auto& bias = Input(BIAS);
+  const auto& mean = Input(EST_MEAN);
+  const auto& var = Input(EST_VAR);
+  auto* Y = Output(0);
+  CAFFE_ENFORCE_EQ(X.ndim(), 5, "The input is not in the NCHWc order.");
+  const int N = X.dim32(0);
+  const int CB = X.dim32(1);
+  const int HW = X.dim32(2) * X.dim32(3);
+  const int B = X.dim32(4);
+  const int C = CB * B;
+  CAFFE_ENFORCE_EQ(scale.size(), C);
+  CAFFE_ENFORCE_EQ(bias.size(), C);
+  CAFFE_ENFORCE_EQ(mean.size(), C);
+  CAFFE_ENFORCE_EQ(var.size(), C);
+
+  // Y = X * alpha + beta per channel
+  scale_buffer_.Resize(C);
+  bias_buffer_.Resize(C);
+  float* alpha = scale_buffer_.mutable_data<float>();
+  float* beta = bias_buffer_.mutable_data<float>();
+  for (int c = 0; c < C; ++c) {
+    alpha[c] = scale.data<float>()[c] /
+        std::sqrt(var.data<float>()[c] + epsilon_);
+    beta[c] = bias.data<float>()[c] - mean.data<float>()[c] * alpha[c];
+  }
+
+  Y->ResizeLike(X);
+  const float* X_data = X.data<float>();
+  float* Y_data = Y->mutable_data<float>();
+  for (int n = 0; n < N; ++n) {
+    for (int cb = 0; cb < CB; ++cb) {
+      const float* a = alpha + cb * B;
+      const float* b = beta + cb * B;
+      const size_t offset = (static_cast<size_t>(n) * CB + cb) * HW * B;
+      for (int hw = 0; hw < HW; ++hw) {
+        const float* x = X_data + offset + hw * B;
+        float* y = Y_data + offset + hw * B;
+        for (int k = 0; k < B; ++k) {
+          y[k] = x[k] * a[k] + b[k];
+        }
+      }
+    }
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(ConvNCHWc, ConvNCHWcOp);
+REGISTER_CPU_OPERATOR(MaxPoolNCHWc, PoolNCHWcOp<MaxPoolNCHWc>);
+REGISTER_CPU_OPERATOR(AveragePoolNCHWc, PoolNCHWcOp<AveragePoolNCHWc>);
+REGISTER_CPU_OPERATOR(SpatialBNNCHWc, SpatialBNNCHWcOp);
+
+OPERATOR_SCHEMA(ConvNCHWc)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+2D convolution on the blocked NCHW[x]c layout (see NCHW2NCHWc), with the
+arguments of Conv. The input is either blocked, or an NCHW tensor with any
+number of channels; the output is blocked and its channels must be a multiple
+of the block. The filter and the bias are those of Conv. Group convolution is
+not supported.
+)DOC")
+    .Arg("block", "The number x of channels in a block, 8 or 16.")
+    .Input(0, "X", "Input data blob, blocked or in the NCHW order.")
+    .Input(1, "filter", "The filter blob, M x C x kH x kW.")
+    .Input(2, "bias", "The 1D bias blob, of size M.")
+    .Output(0, "Y", "Output data blob, in the NCHW[x]c order.");
+
+OPERATOR_SCHEMA(MaxPoolNCHWc)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+2D MaxPool on the blocked NCHW[x]c layout, with the arguments of MaxPool.
+)DOC")
+    .Input(0, "X", "Input data blob, in the NCHW[x]c order.")
+    .Output(0, "Y", "Output data blob, in the NCHW[x]c order.");
+
+OPERATOR_SCHEMA(AveragePoolNCHWc)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+2D AveragePool on the blocked NCHW[x]c layout, with the arguments of
+AveragePool.
+)DOC")
+    .Input(0, "X", "Input data blob, in the NCHW[x]c order.")
+    .Output(0, "Y", "Output data blob, in the NCHW[x]c order.");
+
+OPERATOR_SCHEMA(SpatialBNNCHWc)
+    .NumInputs(5)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}})
+    .SetDoc(R"DOC(
+SpatialBN in test mode on the blocked NCHW[x]c layout, with the inputs of
+SpatialBN.
+)DOC")
+    .Arg("epsilon", "The epsilon value to use to avoid division by zero.")
+    .Input(0, "X", "Input data blob, in the NCHW[x]c order.")
+    .Input(1, "scale", "The scale as a 1-dimensional tensor of size C.")
+    .Input(2, "bias", "The bias as a 1-dimensional tensor of size C.")
+    .Input(3, "mean", "The running mean of size C.")
+    .Input(4, "var", "The running variance of size C.")
+    .Output(0, "Y", "Output data blob, in the NCHW[x]c order.");
+
+NO_GRADIENT(ConvNCHWc);
+NO_GRADIENT(MaxPoolNCHWc);
+NO_GRADIENT(AveragePoolNCHWc);
+NO_GRADIENT(SpatialBNNCHWc);
+
+} // namespace caffe2
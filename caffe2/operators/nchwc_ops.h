@@ -0,0 +1,103 @@
+#ifndef CAFFE2_OPERATORS_NCHWC_OPS_H_
+#define CAFFE2_OPERATORS_NCHWC_OPS_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+
+namespace caffe2 {
+
+// Operators on the blocked NCHW[x]c layout of NCHW2NCHWc: a 4D NCHW tensor
+// is stored as the 5D tensor N x C/x x H x W x x, and the kernels vectorize
+// over the x channels of a block. They are inference only, and the
+// NCHWcLayout transforms rewrite the 2D CPU operators of a net to them.
+// Elementwise operators (Relu, Add, Concat along the channels) run on the
+// blocked tensors unchanged.
+
+class NCHWcOpBase : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  NCHWcOpBase(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws),
+        block_(OperatorBase::GetSingleArgument<int>("block", 8)) {
+    CAFFE_ENFORCE(
+        block_ == 8 || block_ == 16, "block must be 8 or 16, got ", block_);
+    CAFFE_ENFORCE(
+        order_ == StorageOrder::NCHW, "NCHWc operators take no NHWC order.");
+    CAFFE_ENFORCE_EQ(kernel_.size(), 2, "NCHWc operators are 2D only.");
+  }
+
+ protected:
+  // Output spatial size for an input of H x W, updating the pads for the
+  // legacy padding and the kernel for global pooling
+  void ComputeOutputSize(int H, int W, int* OH, int* OW);
+
+  int block_;
+};
+
+// Conv on the blocked layout. X is either blocked, or NCHW with any number of
+// channels (the first convolution of a net, on the image), and the output
+// channels must be a multiple of the block. The filter is the NCHW Conv
+// filter, which is reordered to the blocked layout on every run.
+class ConvNCHWcOp final : public NCHWcOpBase {
+ public:
+  ConvNCHWcOp(const OperatorDef& operator_def, Workspace* ws)
+      : NCHWcOpBase(operator_def, ws) {
+    CAFFE_ENFORCE_EQ(group_, 1, "ConvNCHWc does not support groups.");
+  }
+
+  bool RunOnDeviceWithOrderNCHW() override;
+
+ private:
+  template <int kBlock>
+  void RunBlocked(
+      int N,
+      int CB,
+      int H,
+      int W,
+      int MB,
+      int OH,
+      int OW,
+      const float* X,
+      const float* filter,
+      const float* bias,
+      float* Y);
+
+  TensorCPU input_buffer_;
+  TensorCPU filter_buffer_;
+  INPUT_TAGS(INPUT, FILTER, BIAS);
+};
+
+template <typename PoolType>
+class PoolNCHWcOp final : public NCHWcOpBase {
+ public:
+  PoolNCHWcOp(const OperatorDef& operator_def, Workspace* ws)
+      : NCHWcOpBase(operator_def, ws) {
+    CAFFE_ENFORCE(
+        dilation_h() == 1 && dilation_w() == 1,
+        "Pooling does not support dilation.");
+  }
+
+  bool RunOnDeviceWithOrderNCHW() override;
+};
+
+// SpatialBN in test mode: X, scale, bias, mean, var -> Y
+class SpatialBNNCHWcOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  SpatialBNNCHWcOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)) {}
+
+  bool RunOnDevice() override;
+
+ private:
+  float epsilon_;
+  TensorCPU scale_buffer_;
+  TensorCPU bias_buffer_;
+  INPUT_TAGS(INPUT, SCALE, BIAS, EST_MEAN, EST_VAR);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_NCHWC_OPS_H_
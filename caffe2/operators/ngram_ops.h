@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <map>
 #include <vector>
 
 #include "caffe2/core/context.h"
@@ -7,6 +9,10 @@
 #include "caffe2/utils/math.h"
 
 namespace caffe2 {
+
+// The smallest number of column lookups handed to a thread of the pool
+constexpr size_t kNGramParallelGrain = 16384;
+
 template <typename F, typename T, class Context>
 class NGramFromCategoricalOp : public Operator<Context> {
  public:
@@ -55,19 +61,24 @@ class NGramFromCategoricalOp : public Operator<Context> {
     math::Set<T, Context>(output->size(), 0, output_data, &context_);
 
     CAFFE_ENFORCE_GT(D, max_col_id_);
-    for (int i = 0; i < N; i++) {
-      for (int k = 0; k < col_num_; k++) {
-        int j = col_ids_[k];
-        int v = round(floats_data[i * D + j]);
-        // for out-of-vocabulary values, we always treat them the same as the
-        // first value specified in vals; if we want to mimic the behavior as
-        // sigrid NGram transform, just push front a random/impossible value at
-        // each segments of vals
-        output_data[i] += ngram_maps_[k].find(v) == ngram_maps_[k].end()
-            ? 0
-            : ngram_maps_[k][v];
-      }
-    }
+    ParallelFor(
+        this->IntraOpThreadPool(),
+        N,
+        std::max<size_t>(1, kNGramParallelGrain / col_num_),
+        [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; i++) {
+            for (int k = 0; k < col_num_; k++) {
+              int j = col_ids_[k];
+              int v = round(floats_data[i * D + j]);
+              // for out-of-vocabulary values, we always treat them the same as
+              // the first value specified in vals; if we want to mimic the
+              // behavior as sigrid NGram transform, just push front a
+              // random/impossible value at each segments of vals
+              const auto it = ngram_maps_[k].find(v);
+              output_data[i] += it == ngram_maps_[k].end() ? 0 : it->second;
+            }
+          }
+        });
     return true;
   }
 
@@ -44,9 +44,61 @@ bool NCHW2NHWCOp<float, CPUContext>::RunOnDevice() {
   return true;
 }
 
+template <>
+bool NCHW2NCHWcOp<float, CPUContext>::RunOnDevice() {
+  auto& X = Input(0);
+  auto* Y = Output(0);
+  CAFFE_ENFORCE(X.ndim() == 4);
+  CAFFE_ENFORCE(&X != Y, "NCHW2NCHWc cannot run in place.");
+  const int N = X.dim32(0), C = X.dim32(1), H = X.dim32(2), W = X.dim32(3);
+  const int B = block_;
+  CAFFE_ENFORCE_EQ(
+      C % B, 0, "The channels ", C, " are not a multiple of the block ", B);
+  Y->Resize(vector<TIndex>{N, C / B, H, W, B});
+  const float* Xdata = X.data<float>();
+  float* Ydata = Y->mutable_data<float>();
+  for (int n = 0; n < N; ++n) {
+    for (int c = 0; c < C; ++c) {
+      float* y = Ydata + (n * C + c / B * B) * H * W + c % B;
+      for (int hw = 0; hw < H * W; ++hw) {
+        y[hw * B] = *(Xdata++);
+      }
+    }
+  }
+  return true;
+}
+
+template <>
+bool NCHWc2NCHWOp<float, CPUContext>::RunOnDevice() {
+  auto& X = Input(0);
+  auto* Y = Output(0);
+  CAFFE_ENFORCE(X.ndim() == 5);
+  const int N = X.dim32(0), CB = X.dim32(1), H = X.dim32(2), W = X.dim32(3),
+            B = X.dim32(4);
+  const int C = CB * B;
+  // The inserted reorders at the end of a net write the blob they read
+  auto* out = &X == Y ? &buffer_ : Y;
+  out->Resize(N, C, H, W);
+  const float* Xdata = X.data<float>();
+  float* Ydata = out->mutable_data<float>();
+  for (int n = 0; n < N; ++n) {
+    for (int c = 0; c < C; ++c) {
+      const float* x = Xdata + (n * C + c / B * B) * H * W + c % B;
+      for (int hw = 0; hw < H * W; ++hw) {
+        *(Ydata++) = x[hw * B];
+      }
+    }
+  }
+  if (out != Y) {
+    Y->swap(buffer_);
+  }
+  return true;
+}
 
 REGISTER_CPU_OPERATOR(NHWC2NCHW, NHWC2NCHWOp<float, CPUContext>);
 REGISTER_CPU_OPERATOR(NCHW2NHWC, NCHW2NHWCOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(NCHW2NCHWc, NCHW2NCHWcOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(NCHWc2NCHW, NCHWc2NCHWOp<float, CPUContext>);
 
 OPERATOR_SCHEMA(NHWC2NCHW)
     .NumInputs(1)
@@ -80,6 +132,59 @@ channels C, height H and width W, to the NHWC order.
   .Input(0, "data", "The input data (Tensor<float>) in the NCHW order.")
   .Output(0, "output", "The output tensor (Tensor<float>) in the NHWC order.");
 
+OPERATOR_SCHEMA(NCHW2NCHWc)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .TensorInferenceFunction([](const OperatorDef& def,
+                                const vector<TensorShape>& in) {
+      CAFFE_ENFORCE_EQ(
+          in[0].dims_size(), 4, "Input for NCHW2NCHWc must be 4 dimensional");
+      const int block = ArgumentHelper(def).GetSingleArgument<int>("block", 8);
+      vector<TensorShape> out(1);
+      out[0].add_dims(in[0].dims(0));
+      out[0].add_dims(in[0].dims(1) / block);
+      out[0].add_dims(in[0].dims(2));
+      out[0].add_dims(in[0].dims(3));
+      out[0].add_dims(block);
+      return out;
+    })
+    .SetDoc(R"DOC(
+The operator switches the order of data in a tensor from NCHW to the blocked
+NCHW[x]c order used by the NCHWc operators: the channels are split in C / x
+blocks of x channels, and the tensor is stored as N x C/x x H x W x x so that
+the channels of a block are contiguous. C must be a multiple of x.
+)DOC")
+    .Arg("block", "The number x of channels in a block, 8 by default.")
+    .Input(0, "data", "The input data (Tensor<float>) in the NCHW order.")
+    .Output(
+        0,
+        "output",
+        "The output tensor (Tensor<float>) in the NCHW[x]c order.");
+
+OPERATOR_SCHEMA(NCHWc2NCHW)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}})
+    .TensorInferenceFunction([](const OperatorDef& /*unused*/ /*def*/,
+                                const vector<TensorShape>& in) {
+      CAFFE_ENFORCE_EQ(
+          in[0].dims_size(), 5, "Input for NCHWc2NCHW must be 5 dimensional");
+      vector<TensorShape> out(1);
+      out[0].add_dims(in[0].dims(0));
+      out[0].add_dims(in[0].dims(1) * in[0].dims(4));
+      out[0].add_dims(in[0].dims(2));
+      out[0].add_dims(in[0].dims(3));
+      return out;
+    })
+    .SetDoc(R"DOC(
+The operator switches the order of data in a tensor from the blocked NCHW[x]c
+order back to NCHW, the inverse of NCHW2NCHWc.
+)DOC")
+    .Input(0, "data", "The input data (Tensor<float>) in the NCHW[x]c order.")
+    .Output(
+        0,
+        "output",
+        "The output tensor (Tensor<float>) in the NCHW order.");
 
 class GetNHWC2NCHWGradient : public GradientMakerBase {
   using GradientMakerBase::GradientMakerBase;
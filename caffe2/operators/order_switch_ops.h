@@ -29,6 +29,35 @@ class NCHW2NHWCOp final : public Operator<Context> {
  protected:
 };
 
+// Blocked NCHW[x]c layout: a NCHW tensor whose C is a multiple of the block x
+// is stored as N x C/x x H x W x x, so that the x channels of a pixel are
+// contiguous and the NCHWc operators vectorize over them.
+template <typename T, class Context>
+class NCHW2NCHWcOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  NCHW2NCHWcOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        block_(OperatorBase::GetSingleArgument<int>("block", 8)) {
+    CAFFE_ENFORCE_GT(block_, 0);
+  }
+  bool RunOnDevice() override;
+
+ protected:
+  int block_;
+};
+
+template <typename T, class Context>
+class NCHWc2NCHWOp final : public Operator<Context> {
+ public:
+  USE_SIMPLE_CTOR_DTOR(NCHWc2NCHWOp);
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  bool RunOnDevice() override;
+
+ protected:
+  Tensor<Context> buffer_;
+};
+
 } // namespace caffe2
 
 #endif // CAFFE2_OPERATORS_ORDER_SWITCH_OPS_H_
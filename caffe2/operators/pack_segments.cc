@@ -2,6 +2,13 @@
 
 namespace caffe2 {
 
+namespace {
+
+// The number of bytes worth a thread handoff
+constexpr TIndex kPackSegmentsParallelGrain = 1 << 16;
+
+} // namespace
+
 template <>
 template <typename T>
 bool PackSegmentsOp<CPUContext>::DoRunWithType() {
@@ -24,14 +31,16 @@ bool PackSegmentsOp<CPUContext>::DoRunWithType2() {
   CAFFE_ENFORCE(data.ndim() >= 1, "DATA should be at least 1-D");
   CAFFE_ENFORCE(lengths.ndim() == 1, "LENGTH should be 1-D");
 
-  // Find the length of the longest sequence.
+  // Find the length of the longest sequence, and where each sequence starts.
   const T* l = lengths.template data<T>();
   T max_length = 0;
-  TIndex total_length = 0;
-  for (T i = 0; i < lengths.dim(0); ++i) {
+  std::vector<TIndex> starts(lengths.dim(0) + 1);
+  starts[0] = 0;
+  for (TIndex i = 0; i < lengths.dim(0); ++i) {
     max_length = std::max(max_length, l[i]);
-    total_length += l[i];
+    starts[i + 1] = starts[i] + l[i];
   }
+  const TIndex total_length = starts[lengths.dim(0)];
 
   // Total lengths must be the same as data.dims(0)
   CAFFE_ENFORCE_EQ(
@@ -63,33 +72,39 @@ bool PackSegmentsOp<CPUContext>::DoRunWithType2() {
     return true;
   }
 
-  // Do padding
-  if (output->template IsType<float>()) {
-    math::Set<float, CPUContext>(
-        output->size(),
-        padding_,
-        output->template mutable_data<float>(),
-        &context_);
-  }
-  if (return_presence_mask_) {
-    memset(presence_mask_data, (int)false, presence_mask->size());
-  }
-
+  // Each sequence is copied and padded independently of the others
   auto block_size = data.size_from_dim(1);
   auto block_bytesize = data.itemsize() * block_size;
   const auto* d = static_cast<const char*>(data.raw_data());
-  TIndex start = 0;
-  for (TIndex i = 0; i < lengths.dim(0); ++i) {
-    context_.template CopyItems<CPUContext, CPUContext>(
-        data.meta(),
-        l[i] * block_size,
-        d + block_bytesize * start,
-        out + block_bytesize * max_length * i);
-    if (return_presence_mask_) {
-      memset(presence_mask_data + max_length * i, (int)true, l[i]);
-    }
-    start += l[i];
-  }
+  float* padded = output->template IsType<float>()
+      ? output->template mutable_data<float>()
+      : nullptr;
+  ParallelFor(
+      IntraOpThreadPool(),
+      lengths.dim(0),
+      kPackSegmentsParallelGrain /
+              std::max<TIndex>(block_bytesize * max_length, 1) +
+          1,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          context_.template CopyItems<CPUContext, CPUContext>(
+              data.meta(),
+              l[i] * block_size,
+              d + block_bytesize * starts[i],
+              out + block_bytesize * max_length * i);
+          if (padded) {
+            std::fill(
+                padded + block_size * (max_length * i + l[i]),
+                padded + block_size * max_length * (i + 1),
+                padding_);
+          }
+          if (return_presence_mask_) {
+            bool* mask = presence_mask_data + max_length * i;
+            std::fill(mask, mask + l[i], true);
+            std::fill(mask + l[i], mask + max_length, false);
+          }
+        }
+      });
 
   return true;
 }
@@ -130,15 +145,26 @@ bool UnpackSegmentsOp<CPUContext>::DoRunWithType2() {
   auto block_size = data.size_from_dim(2);
   auto block_bytesize = data.itemsize() * block_size;
   const auto* d = static_cast<const char*>(data.raw_data());
-  TIndex start = 0;
+  std::vector<TIndex> starts(lengths.dim(0) + 1);
+  starts[0] = 0;
   for (TIndex i = 0; i < lengths.dim(0); ++i) {
-    context_.template CopyItems<CPUContext, CPUContext>(
-        data.meta(),
-        l[i] * block_size,
-        d + block_bytesize * data.dim(1) * i,
-        out + block_bytesize * start);
-    start += l[i];
+    starts[i + 1] = starts[i] + l[i];
   }
+  ParallelFor(
+      IntraOpThreadPool(),
+      lengths.dim(0),
+      kPackSegmentsParallelGrain /
+              std::max<TIndex>(block_bytesize * data.dim(1), 1) +
+          1,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          context_.template CopyItems<CPUContext, CPUContext>(
+              data.meta(),
+              l[i] * block_size,
+              d + block_bytesize * data.dim(1) * i,
+              out + block_bytesize * starts[i]);
+        }
+      });
   return true;
 }
 
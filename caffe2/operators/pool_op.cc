@@ -9,6 +9,10 @@ using std::min;
 
 namespace {
 
+// The smallest number of input elements of the pooling operators that are
+// handed to a thread
+constexpr int kPoolParallelGrain = 16384;
+
 #ifdef __ARM_NEON__
 
 bool isNeon4x4p0s0Eligible(
@@ -532,98 +536,97 @@ bool PoolOp<T, Context, PoolType>::RunOnDeviceWithOrderNCHW() {
     return true;
   }
 
-  switch (kernel_.size()) {
-    case 1:
-      for (int n = 0; n < X.dim32(0); ++n) {
-        for (int c = 0; c < channels; ++c) {
-          for (int ph = 0; ph < pooled_height; ++ph) {
-            int hstart = ph * stride_h() - pad_t();
-            int hend = min(hstart + kernel_h(), height);
-            hstart = max(hstart, 0);
-            T Yh = PoolType::initialize();
-            for (int h = hstart; h < hend; ++h) {
-              PoolType::process(Xdata[h], Yh);
-            }
-            PoolType::finalize(hend - hstart, Yh);
-            Ydata[ph] = Yh;
-          }
-          // Do offset.
-          Xdata += height;
-          Ydata += pooled_height;
-        }
-      }
-      break;
-    case 2:
-      for (int n = 0; n < X.dim32(0); ++n) {
-        for (int c = 0; c < channels; ++c) {
-          for (int ph = 0; ph < pooled_height; ++ph) {
-            int hstart = ph * stride_h() - pad_t();
-            int hend = min(hstart + kernel_h(), height);
-            hstart = max(hstart, 0);
-            for (int pw = 0; pw < pooled_width; ++pw) {
-              int wstart = pw * stride_w() - pad_l();
-              int wend = min(wstart + kernel_w(), width);
-              wstart = max(wstart, 0);
-              const int pool_index = ph * pooled_width + pw;
-              T Yh = PoolType::initialize();
-              for (int h = hstart; h < hend; ++h) {
-                for (int w = wstart; w < wend; ++w) {
-                  const int input_index = h * width + w;
-                  PoolType::process(Xdata[input_index], Yh);
-                }
-              }
-              PoolType::finalize((hend - hstart) * (wend - wstart), Yh);
-              Ydata[pool_index] = Yh;
-            }
-          }
-          // Do offset.
-          Xdata += height * width;
-          Ydata += pooled_height * pooled_width;
-        }
-      }
-      break;
-    case 3:
-      for (int n = 0; n < X.dim32(0); ++n) {
-        for (int c = 0; c < channels; ++c) {
-          for (int ph = 0; ph < pooled_height; ++ph) {
-            int hstart = ph * stride_h() - pad_t();
-            int hend = min(hstart + kernel_h(), height);
-            hstart = max(hstart, 0);
-            for (int pw = 0; pw < pooled_width; ++pw) {
-              int wstart = pw * stride_w() - pad_l();
-              int wend = min(wstart + kernel_w(), width);
-              wstart = max(wstart, 0);
-              for (int pd = 0; pd < pooled_depth; ++pd) {
-                int dstart = pd * stride_[2] - pads_[2];
-                int dend = min(dstart + kernel_[2], depth);
-                dstart = max(dstart, 0);
-                const int pool_index =
-                    ph * pooled_width * pooled_depth + pw * pooled_depth + pd;
+  if (kernel_.size() < 1 || kernel_.size() > 3) {
+    CAFFE_THROW("Unsupported pooling size : ", kernel_.size());
+    return false;
+  }
+  // The planes of the (image, channel) pairs are split between the threads of
+  // the pool
+  const int input_plane = height * width * depth;
+  const int output_plane = pooled_height * pooled_width * pooled_depth;
+  ParallelFor(
+      this->IntraOpThreadPool(),
+      X.dim32(0) * channels,
+      kPoolParallelGrain / std::max(input_plane, 1) + 1,
+      [&](size_t begin, size_t end) {
+        const float* Xplane = Xdata + begin * input_plane;
+        float* Yplane = Ydata + begin * output_plane;
+        for (size_t plane = begin; plane < end; ++plane) {
+          switch (kernel_.size()) {
+            case 1:
+              for (int ph = 0; ph < pooled_height; ++ph) {
+                int hstart = ph * stride_h() - pad_t();
+                int hend = min(hstart + kernel_h(), height);
+                hstart = max(hstart, 0);
                 T Yh = PoolType::initialize();
                 for (int h = hstart; h < hend; ++h) {
-                  for (int w = wstart; w < wend; ++w) {
-                    for (int d = dstart; d < dend; ++d) {
-                      const int input_index = h * width * depth + w * depth + d;
-                      PoolType::process(Xdata[input_index], Yh);
+                  PoolType::process(Xplane[h], Yh);
+                }
+                PoolType::finalize(hend - hstart, Yh);
+                Yplane[ph] = Yh;
+              }
+              break;
+            case 2:
+              for (int ph = 0; ph < pooled_height; ++ph) {
+                int hstart = ph * stride_h() - pad_t();
+                int hend = min(hstart + kernel_h(), height);
+                hstart = max(hstart, 0);
+                for (int pw = 0; pw < pooled_width; ++pw) {
+                  int wstart = pw * stride_w() - pad_l();
+                  int wend = min(wstart + kernel_w(), width);
+                  wstart = max(wstart, 0);
+                  const int pool_index = ph * pooled_width + pw;
+                  T Yh = PoolType::initialize();
+                  for (int h = hstart; h < hend; ++h) {
+                    for (int w = wstart; w < wend; ++w) {
+                      const int input_index = h * width + w;
+                      PoolType::process(Xplane[input_index], Yh);
                     }
                   }
+                  PoolType::finalize((hend - hstart) * (wend - wstart), Yh);
+                  Yplane[pool_index] = Yh;
                 }
-                PoolType::finalize(
-                    (hend - hstart) * (wend - wstart) * (dend - dstart), Yh);
-                Ydata[pool_index] = Yh;
               }
-            }
+              break;
+            case 3:
+              for (int ph = 0; ph < pooled_height; ++ph) {
+                int hstart = ph * stride_h() - pad_t();
+                int hend = min(hstart + kernel_h(), height);
+                hstart = max(hstart, 0);
+                for (int pw = 0; pw < pooled_width; ++pw) {
+                  int wstart = pw * stride_w() - pad_l();
+                  int wend = min(wstart + kernel_w(), width);
+                  wstart = max(wstart, 0);
+                  for (int pd = 0; pd < pooled_depth; ++pd) {
+                    int dstart = pd * stride_[2] - pads_[2];
+                    int dend = min(dstart + kernel_[2], depth);
+                    dstart = max(dstart, 0);
+                    const int pool_index = ph * pooled_width * pooled_depth +
+                        pw * pooled_depth + pd;
+                    T Yh = PoolType::initialize();
+                    for (int h = hstart; h < hend; ++h) {
+                      for (int w = wstart; w < wend; ++w) {
+                        for (int d = dstart; d < dend; ++d) {
+                          const int input_index =
+                              h * width * depth + w * depth + d;
+                          PoolType::process(Xplane[input_index], Yh);
+                        }
+                      }
+                    }
+                    PoolType::finalize(
+                        (hend - hstart) * (wend - wstart) * (dend - dstart),
+                        Yh);
+                    Yplane[pool_index] = Yh;
+                  }
+                }
+              }
+              break;
           }
           // Do offset.
-          Xdata += height * width * depth;
-          Ydata += pooled_height * pooled_width * pooled_depth;
+          Xplane += input_plane;
+          Yplane += output_plane;
         }
-      }
-      break;
-    default:
-      CAFFE_THROW("Unsupported pooling size : ", kernel_.size());
-      return false;
-  }
+      });
   return true;
 }
 
@@ -0,0 +1,40 @@
+#include "caffe2/operators/quantized/int8_add_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Add, int8::Int8AddOp<int8::Activation::NONE>);
+REGISTER_CPU_OPERATOR(Int8AddRelu, int8::Int8AddOp<int8::Activation::RELU>);
+
+OPERATOR_SCHEMA(Int8Add)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}, {1, 0}})
+    .IdenticalTypeAndShapeOfInput(0)
+    .SetDoc(R"DOC(
+Elementwise sum of two uint8 Int8TensorCPU of the same shape, requantized to
+Y_scale and Y_zero_point. There is no broadcasting.
+)DOC")
+    .Arg("Y_scale", "Output tensor quantization scale")
+    .Arg("Y_zero_point", "Output tensor quantization offset")
+    .Input(0, "A", "First int8 operand")
+    .Input(1, "B", "Second int8 operand, of the shape of A")
+    .Output(0, "C", "Int8 sum");
+
+OPERATOR_SCHEMA(Int8AddRelu)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}, {1, 0}})
+    .IdenticalTypeAndShapeOfInput(0)
+    .SetDoc(R"DOC(
+Int8Add followed by Relu.
+)DOC")
+    .Arg("Y_scale", "Output tensor quantization scale")
+    .Arg("Y_zero_point", "Output tensor quantization offset")
+    .Input(0, "A", "First int8 operand")
+    .Input(1, "B", "Second int8 operand, of the shape of A")
+    .Output(0, "C", "Int8 sum, clamped below at the real value 0");
+
+NO_GRADIENT(Int8Add);
+NO_GRADIENT(Int8AddRelu);
+
+} // namespace caffe2
@@ -0,0 +1,63 @@
+#ifndef CAFFE2_OPERATORS_INT8_ADD_OP_H_
+#define CAFFE2_OPERATORS_INT8_ADD_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+// Elementwise sum of two uint8 tensors of the same shape, e.g. the shortcut
+// of a residual block, requantized to Y_scale and Y_zero_point.
+template <Activation Ac>
+class Int8AddOp final : public Operator<CPUContext> {
+ public:
+  Int8AddOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        Y_scale_(OperatorBase::GetSingleArgument<float>("Y_scale", 1.0f)),
+        Y_zero_point_(
+            OperatorBase::GetSingleArgument<int>("Y_zero_point", 0)) {}
+
+  bool RunOnDevice() override {
+    const auto& A = Inputs()[0]->Get<Int8TensorCPU>();
+    const auto& B = Inputs()[1]->Get<Int8TensorCPU>();
+    auto* Y = Outputs()[0]->GetMutable<Int8TensorCPU>();
+    CAFFE_ENFORCE(A.t.IsType<uint8_t>() && B.t.IsType<uint8_t>());
+    CAFFE_ENFORCE(
+        A.t.dims() == B.t.dims(), "Int8Add does not support broadcasting");
+    // Read everything from the inputs first, Y may be either of them
+    const float a_multiplier = A.scale / Y_scale_;
+    const float b_multiplier = B.scale / Y_scale_;
+    const int32_t a_zero_point = A.zero_point;
+    const int32_t b_zero_point = B.zero_point;
+    Y->t.ResizeLike(A.t);
+    Y->scale = Y_scale_;
+    Y->zero_point = Y_zero_point_;
+
+    const int32_t min = Ac == Activation::RELU ? Y_zero_point_ : 0;
+    const uint8_t* Adata = A.t.data<uint8_t>();
+    const uint8_t* Bdata = B.t.data<uint8_t>();
+    uint8_t* Ydata = Y->t.mutable_data<uint8_t>();
+    for (TIndex i = 0; i < Y->t.size(); ++i) {
+      Ydata[i] = QuantizeScaled(
+          a_multiplier * (Adata[i] - a_zero_point) +
+              b_multiplier * (Bdata[i] - b_zero_point),
+          Y_zero_point_,
+          min);
+    }
+    return true;
+  }
+
+ private:
+  float Y_scale_;
+  int32_t Y_zero_point_;
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_ADD_OP_H_
@@ -0,0 +1,23 @@
+#include "caffe2/operators/quantized/int8_average_pool_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8AveragePool, int8::Int8AveragePoolOp);
+
+OPERATOR_SCHEMA(Int8AveragePool)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForPool)
+    .SetDoc(R"DOC(
+AveragePool on an NHWC uint8 Int8TensorCPU, with the arguments of
+AveragePool, including global_pooling. The mean is requantized to Y_scale and
+Y_zero_point. Only order "NHWC" and 2-D pooling are supported.
+)DOC")
+    .Arg("Y_scale", "Output tensor quantization scale")
+    .Arg("Y_zero_point", "Output tensor quantization offset")
+    .Input(0, "X", "Int8 input, in NHWC order")
+    .Output(0, "Y", "Int8 output, in NHWC order");
+
+NO_GRADIENT(Int8AveragePool);
+
+} // namespace caffe2
@@ -0,0 +1,20 @@
+#include "caffe2/operators/quantized/int8_concat_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Concat, int8::Int8ConcatOp);
+
+OPERATOR_SCHEMA(Int8Concat)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Concatenates uint8 Int8TensorCPU inputs along axis. All inputs must have the
+same scale and zero point, which Y inherits.
+)DOC")
+    .Arg("axis", "Which axis to concat on, 3 (the NHWC channels) by default")
+    .Input(0, "X", "Int8 inputs")
+    .Output(0, "Y", "Int8 concatenation of the inputs");
+
+NO_GRADIENT(Int8Concat);
+
+} // namespace caffe2
@@ -0,0 +1,73 @@
+#ifndef CAFFE2_OPERATORS_INT8_CONCAT_OP_H_
+#define CAFFE2_OPERATORS_INT8_CONCAT_OP_H_
+
+#include <cstring>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+// Concatenates uint8 tensors that share a scale and zero point, by default
+// along the channels of NHWC tensors.
+class Int8ConcatOp final : public Operator<CPUContext> {
+ public:
+  Int8ConcatOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        axis_(OperatorBase::GetSingleArgument<int>("axis", 3)) {}
+
+  bool RunOnDevice() override {
+    const auto& X0 = Inputs()[0]->Get<Int8TensorCPU>();
+    auto* Y = Outputs()[0]->GetMutable<Int8TensorCPU>();
+    CAFFE_ENFORCE(X0.t.IsType<uint8_t>());
+    const int axis = X0.t.canonical_axis_index(axis_);
+    auto Y_dims = X0.t.dims();
+    for (int i = 1; i < InputSize(); ++i) {
+      const auto& Xi = Inputs()[i]->Get<Int8TensorCPU>();
+      CAFFE_ENFORCE(Xi.t.IsType<uint8_t>());
+      CAFFE_ENFORCE_EQ(
+          Xi.scale, X0.scale, "All inputs must have the same scale");
+      CAFFE_ENFORCE_EQ(
+          Xi.zero_point,
+          X0.zero_point,
+          "All inputs must have the same zero point");
+      CAFFE_ENFORCE_EQ(Xi.t.ndim(), X0.t.ndim());
+      for (int d = 0; d < X0.t.ndim(); ++d) {
+        if (d != axis) {
+          CAFFE_ENFORCE_EQ(Xi.t.dim(d), X0.t.dim(d));
+        }
+      }
+      Y_dims[axis] += Xi.t.dim(axis);
+    }
+    Y->t.Resize(Y_dims);
+    Y->scale = X0.scale;
+    Y->zero_point = X0.zero_point;
+
+    const TIndex before = Y->t.size_to_dim(axis);
+    const TIndex Y_inner = Y->t.size_from_dim(axis);
+    uint8_t* Ydata = Y->t.mutable_data<uint8_t>();
+    TIndex offset = 0;
+    for (int i = 0; i < InputSize(); ++i) {
+      const auto& Xi = Inputs()[i]->Get<Int8TensorCPU>();
+      const TIndex inner = Xi.t.size_from_dim(axis);
+      const uint8_t* Xdata = Xi.t.data<uint8_t>();
+      for (TIndex b = 0; b < before; ++b) {
+        memcpy(Ydata + b * Y_inner + offset, Xdata + b * inner, inner);
+      }
+      offset += inner;
+    }
+    return true;
+  }
+
+ private:
+  int axis_;
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_CONCAT_OP_H_
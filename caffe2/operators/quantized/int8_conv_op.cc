@@ -0,0 +1,47 @@
+#include "caffe2/operators/quantized/int8_conv_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Conv, int8::Int8ConvOp<int8::Activation::NONE>);
+REGISTER_CPU_OPERATOR(Int8ConvRelu, int8::Int8ConvOp<int8::Activation::RELU>);
+
+namespace {
+
+std::function<void(OpSchema&)> Int8ConvDocGenerator(const char* relu) {
+  return [=](OpSchema& schema) {
+    string doc = R"DOC(
+The convolution operator consumes an NHWC uint8 input tensor X, a filter
+W of shape [M, kernel_h, kernel_w, C / group] and an int32 bias of shape [M],
+and computes the output{relu}. The bias has the scale X_scale * W_scale and a
+zero point of 0. The accumulators are requantized to Y_scale and
+Y_zero_point. Only order "NHWC" and 2-D kernels are supported.
+)DOC";
+    ReplaceAll(doc, "{relu}", relu);
+    schema.SetDoc(doc);
+    schema.Arg("Y_scale", "Output tensor quantization scale");
+    schema.Arg("Y_zero_point", "Output tensor quantization offset");
+    schema.Input(0, "X", "Int8 input, in NHWC order");
+    schema.Input(1, "W", "Int8 filter, in MHWC order");
+    schema.Input(2, "b", "int32 bias of shape [M]");
+    schema.Output(0, "Y", "Int8 output, in NHWC order");
+  };
+}
+
+} // namespace
+
+OPERATOR_SCHEMA(Int8Conv)
+    .NumInputs(3)
+    .NumOutputs(1)
+    .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForConv)
+    .FillUsing(Int8ConvDocGenerator(""));
+
+OPERATOR_SCHEMA(Int8ConvRelu)
+    .NumInputs(3)
+    .NumOutputs(1)
+    .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForConv)
+    .FillUsing(Int8ConvDocGenerator(", clamped below at the real value 0"));
+
+NO_GRADIENT(Int8Conv);
+NO_GRADIENT(Int8ConvRelu);
+
+} // namespace caffe2
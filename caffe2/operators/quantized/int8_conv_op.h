@@ -0,0 +1,183 @@
+#ifndef CAFFE2_OPERATORS_INT8_CONV_OP_H_
+#define CAFFE2_OPERATORS_INT8_CONV_OP_H_
+
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/operators/quantized/int8_gemm.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+/*
+ * 2-D convolution of an NHWC uint8 tensor by a filter of shape
+ * [M, kernel_h, kernel_w, C / group], lowered to Int8Gemm over an im2col
+ * buffer. Padding is filled with the zero point of X, which stands for the
+ * real value 0. A 1x1 convolution with unit stride and no padding needs no
+ * im2col and runs on X directly.
+ */
+template <Activation Ac>
+class Int8ConvOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  Int8ConvOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws),
+        Y_scale_(OperatorBase::GetSingleArgument<float>("Y_scale", 1.0f)),
+        Y_zero_point_(
+            OperatorBase::GetSingleArgument<int>("Y_zero_point", 0)) {
+    CAFFE_ENFORCE(
+        order_ == StorageOrder::NHWC,
+        "Int8Conv only supports NHWC order");
+    CAFFE_ENFORCE_EQ(kernel_.size(), 2, "Int8Conv only supports 2-D kernels");
+  }
+
+  bool RunOnDeviceWithOrderNHWC() override {
+    const auto& X = Inputs()[0]->Get<Int8TensorCPU>();
+    const auto& W = Inputs()[1]->Get<Int8TensorCPU>();
+    const auto& B = Inputs()[2]->Get<Int8TensorCPU>();
+    auto* Y = Outputs()[0]->GetMutable<Int8TensorCPU>();
+    CAFFE_ENFORCE(X.t.IsType<uint8_t>() && W.t.IsType<uint8_t>());
+    CAFFE_ENFORCE(B.t.IsType<int32_t>(), "The bias must be int32");
+    CAFFE_ENFORCE_EQ(X.t.ndim(), 4);
+    CAFFE_ENFORCE_EQ(W.t.ndim(), 4);
+
+    const int N = X.t.dim32(0);
+    const int H = X.t.dim32(1);
+    const int W_in = X.t.dim32(2);
+    const int C = X.t.dim32(3);
+    const int M = W.t.dim32(0);
+    CAFFE_ENFORCE_EQ(C % group_, 0);
+    CAFFE_ENFORCE_EQ(M % group_, 0);
+    const int C_per_group = C / group_;
+    const int M_per_group = M / group_;
+    CAFFE_ENFORCE_EQ(W.t.dim32(1), kernel_h());
+    CAFFE_ENFORCE_EQ(W.t.dim32(2), kernel_w());
+    CAFFE_ENFORCE_EQ(W.t.dim32(3), C_per_group);
+    CAFFE_ENFORCE_EQ(B.t.size(), M);
+
+    ConvPoolOpBase<CPUContext>::SetOutputSize(X.t, &(Y->t), M);
+    Y->scale = Y_scale_;
+    Y->zero_point = Y_zero_point_;
+    const int out_h = Y->t.dim32(1);
+    const int out_w = Y->t.dim32(2);
+    const int K = kernel_h() * kernel_w() * C_per_group;
+
+    // The weights are constant in inference, so pack them once
+    if (packed_source_ != W.t.raw_data() || packed_.size() != group_ ||
+        packed_[0].zero_point != W.zero_point || packed_[0].K != K ||
+        packed_[0].N != M_per_group) {
+      packed_.resize(group_);
+      for (int g = 0; g < group_; ++g) {
+        PackInt8Weights(
+            M_per_group,
+            K,
+            W.t.data<uint8_t>() + static_cast<size_t>(g) * M_per_group * K,
+            K,
+            W.zero_point,
+            &packed_[g]);
+      }
+      packed_source_ = W.t.raw_data();
+    }
+
+    const auto requantization = MakeRequantization(
+        static_cast<double>(X.scale) * W.scale / Y_scale_, Y_zero_point_, Ac);
+    const uint8_t* Xdata = X.t.data<uint8_t>();
+    const int32_t* Bdata = B.t.data<int32_t>();
+    uint8_t* Ydata = Y->t.mutable_data<uint8_t>();
+
+    const bool is_1x1 = kernel_h() == 1 && kernel_w() == 1 &&
+        stride_h() == 1 && stride_w() == 1 && pad_t() == 0 && pad_l() == 0 &&
+        pad_b() == 0 && pad_r() == 0 && group_ == 1;
+    if (is_1x1) {
+      Int8Gemm(
+          N * H * W_in,
+          Xdata,
+          C,
+          X.zero_point,
+          packed_[0],
+          Bdata,
+          requantization,
+          Ydata,
+          M);
+      return true;
+    }
+
+    col_buffer_.resize(static_cast<size_t>(out_h) * out_w * K);
+    for (int n = 0; n < N; ++n) {
+      const uint8_t* Xn = Xdata + static_cast<size_t>(n) * H * W_in * C;
+      uint8_t* Yn = Ydata + static_cast<size_t>(n) * out_h * out_w * M;
+      for (int g = 0; g < group_; ++g) {
+        Im2Col(Xn, H, W_in, C, g * C_per_group, C_per_group, X.zero_point);
+        Int8Gemm(
+            out_h * out_w,
+            col_buffer_.data(),
+            K,
+            X.zero_point,
+            packed_[g],
+            Bdata + g * M_per_group,
+            requantization,
+            Yn + g * M_per_group,
+            M);
+      }
+    }
+    return true;
+  }
+
+ private:
+  // Lays the receptive field of every output pixel out as a row of
+  // kernel_h * kernel_w * channels values, for the channels of one group.
+  void Im2Col(
+      const uint8_t* X,
+      int H,
+      int W,
+      int C,
+      int channel_offset,
+      int channels,
+      uint8_t zero_point) {
+    const int out_h = (H + pad_t() + pad_b() -
+                       (dilation_h() * (kernel_h() - 1) + 1)) /
+            stride_h() +
+        1;
+    const int out_w = (W + pad_l() + pad_r() -
+                       (dilation_w() * (kernel_w() - 1) + 1)) /
+            stride_w() +
+        1;
+    uint8_t* col = col_buffer_.data();
+    for (int oh = 0; oh < out_h; ++oh) {
+      for (int ow = 0; ow < out_w; ++ow) {
+        for (int kh = 0; kh < kernel_h(); ++kh) {
+          const int h = oh * stride_h() - pad_t() + kh * dilation_h();
+          for (int kw = 0; kw < kernel_w(); ++kw) {
+            const int w = ow * stride_w() - pad_l() + kw * dilation_w();
+            if (h < 0 || h >= H || w < 0 || w >= W) {
+              std::fill(col, col + channels, zero_point);
+            } else {
+              const uint8_t* x =
+                  X + (static_cast<size_t>(h) * W + w) * C + channel_offset;
+              std::copy(x, x + channels, col);
+            }
+            col += channels;
+          }
+        }
+      }
+    }
+  }
+
+  float Y_scale_;
+  int32_t Y_zero_point_;
+
+  std::vector<PackedInt8Weights> packed_;
+  const void* packed_source_{nullptr};
+  std::vector<uint8_t> col_buffer_;
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_CONV_OP_H_
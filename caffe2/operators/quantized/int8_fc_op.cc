@@ -0,0 +1,31 @@
+#include "caffe2/operators/quantized/int8_fc_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8FC, int8::Int8FCOp);
+
+OPERATOR_SCHEMA(Int8FC)
+    .NumInputs(3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Computes the result of passing an input vector X into a fully connected
+layer with 2D weight matrix W and 1D bias vector b, like FC, on uint8
+Int8TensorCPU inputs:
+
+    Y = X * W^T + b
+
+The bias is int32 with the scale X_scale * W_scale and a zero point of 0.
+The int32 accumulators are requantized to Y_scale and Y_zero_point as they
+are written out.
+)DOC")
+    .Arg("axis", "Dimension from which X is flattened (default 1)")
+    .Arg("Y_scale", "Output tensor quantization scale")
+    .Arg("Y_zero_point", "Output tensor quantization offset")
+    .Input(0, "X", "Int8 input, flattened to a matrix at axis")
+    .Input(1, "W", "Int8 weights of shape [N, K]")
+    .Input(2, "b", "int32 bias of shape [N]")
+    .Output(0, "Y", "Int8 output");
+
+NO_GRADIENT(Int8FC);
+
+} // namespace caffe2
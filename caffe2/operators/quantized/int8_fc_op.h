@@ -0,0 +1,84 @@
+#ifndef CAFFE2_OPERATORS_INT8_FC_OP_H_
+#define CAFFE2_OPERATORS_INT8_FC_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/quantized/int8_gemm.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+class Int8FCOp final : public Operator<CPUContext> {
+ public:
+  Int8FCOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        axis_(OperatorBase::GetSingleArgument<int>("axis", 1)),
+        Y_scale_(OperatorBase::GetSingleArgument<float>("Y_scale", 1.0f)),
+        Y_zero_point_(
+            OperatorBase::GetSingleArgument<int>("Y_zero_point", 0)) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Inputs()[0]->Get<Int8TensorCPU>();
+    const auto& W = Inputs()[1]->Get<Int8TensorCPU>();
+    const auto& B = Inputs()[2]->Get<Int8TensorCPU>();
+    auto* Y = Outputs()[0]->GetMutable<Int8TensorCPU>();
+    CAFFE_ENFORCE(X.t.IsType<uint8_t>() && W.t.IsType<uint8_t>());
+    CAFFE_ENFORCE(B.t.IsType<int32_t>(), "The bias must be int32");
+    CAFFE_ENFORCE_EQ(W.t.ndim(), 2);
+
+    const auto canonical_axis = X.t.canonical_axis_index(axis_);
+    const int M = X.t.size_to_dim(canonical_axis);
+    const int K = X.t.size_from_dim(canonical_axis);
+    const int N = W.t.dim32(0);
+    CAFFE_ENFORCE_EQ(K, W.t.dim32(1), "X and W do not match in size");
+    CAFFE_ENFORCE_EQ(N, B.t.size());
+
+    auto Y_shape = X.t.dims();
+    Y_shape.resize(canonical_axis + 1);
+    Y_shape[canonical_axis] = N;
+    Y->t.Resize(Y_shape);
+    Y->scale = Y_scale_;
+    Y->zero_point = Y_zero_point_;
+
+    // The weights are constant in inference, so pack them once
+    if (packed_source_ != W.t.raw_data() ||
+        packed_.zero_point != W.zero_point || packed_.N != N ||
+        packed_.K != K) {
+      PackInt8Weights(
+          N, K, W.t.data<uint8_t>(), K, W.zero_point, &packed_);
+      packed_source_ = W.t.raw_data();
+    }
+
+    Int8Gemm(
+        M,
+        X.t.data<uint8_t>(),
+        K,
+        X.zero_point,
+        packed_,
+        B.t.data<int32_t>(),
+        MakeRequantization(
+            static_cast<double>(X.scale) * W.scale / Y_scale_,
+            Y_zero_point_,
+            Activation::NONE),
+        Y->t.mutable_data<uint8_t>(),
+        N);
+    return true;
+  }
+
+ private:
+  int axis_;
+  float Y_scale_;
+  int32_t Y_zero_point_;
+
+  PackedInt8Weights packed_;
+  const void* packed_source_{nullptr};
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_FC_OP_H_
@@ -0,0 +1,131 @@
+#include "caffe2/operators/quantized/int8_gemm.h"
+
+namespace caffe2 {
+namespace int8 {
+
+constexpr int PackedInt8Weights::kPanelRows;
+
+namespace {
+
+constexpr int kNR = PackedInt8Weights::kPanelRows;
+// Rows of A per micro kernel
+constexpr int kMR = 4;
+
+// Computes MR rows of C against one panel of B. The accumulators fit in
+// registers, and the loop over the panel vectorizes.
+template <int MR>
+void Int8GemmKernel(
+    const uint8_t* A,
+    int lda,
+    int32_t a_zero_point,
+    const PackedInt8Weights& B,
+    int panel,
+    const int32_t* bias,
+    const Requantization& requantization,
+    uint8_t* C,
+    int ldc) {
+  const int K = B.K;
+  const int n0 = panel * kNR;
+  const int nr = std::min(kNR, B.N - n0);
+  const uint8_t* packed = B.data.data() + static_cast<size_t>(n0) * K;
+
+  int32_t acc[MR][kNR] = {};
+  int32_t a_sums[MR] = {};
+  for (int k = 0; k < K; ++k) {
+    const uint8_t* b = packed + k * kNR;
+    for (int i = 0; i < MR; ++i) {
+      const int32_t a = A[i * lda + k];
+      a_sums[i] += a;
+      for (int j = 0; j < kNR; ++j) {
+        acc[i][j] += a * static_cast<int32_t>(b[j]);
+      }
+    }
+  }
+
+  // sum (a - za)(b - zb) = sum ab - za sum b - zb sum a + K za zb
+  const int32_t b_zero_point = B.zero_point;
+  for (int i = 0; i < MR; ++i) {
+    const int32_t row_term =
+        K * a_zero_point * b_zero_point - b_zero_point * a_sums[i];
+    for (int j = 0; j < nr; ++j) {
+      int32_t v = acc[i][j] - a_zero_point * B.row_sums[n0 + j] + row_term;
+      if (bias) {
+        v += bias[n0 + j];
+      }
+      C[i * ldc + n0 + j] = Requantize(v, requantization);
+    }
+  }
+}
+
+} // namespace
+
+void PackInt8Weights(
+    int N,
+    int K,
+    const uint8_t* B,
+    int ldb,
+    int32_t zero_point,
+    PackedInt8Weights* packed) {
+  const int panels = (N + kNR - 1) / kNR;
+  packed->N = N;
+  packed->K = K;
+  packed->zero_point = zero_point;
+  packed->data.assign(static_cast<size_t>(panels) * kNR * K, 0);
+  packed->row_sums.assign(panels * kNR, 0);
+  for (int n = 0; n < N; ++n) {
+    const uint8_t* row = B + static_cast<size_t>(n) * ldb;
+    uint8_t* panel =
+        packed->data.data() + static_cast<size_t>(n / kNR) * kNR * K;
+    int32_t sum = 0;
+    for (int k = 0; k < K; ++k) {
+      panel[k * kNR + n % kNR] = row[k];
+      sum += row[k];
+    }
+    packed->row_sums[n] = sum;
+  }
+}
+
+void Int8Gemm(
+    int M,
+    const uint8_t* A,
+    int lda,
+    int32_t a_zero_point,
+    const PackedInt8Weights& B,
+    const int32_t* bias,
+    const Requantization& requantization,
+    uint8_t* C,
+    int ldc) {
+  const int panels = (B.N + kNR - 1) / kNR;
+  int m = 0;
+  for (; m + kMR <= M; m += kMR) {
+    for (int p = 0; p < panels; ++p) {
+      Int8GemmKernel<kMR>(
+          A + static_cast<size_t>(m) * lda,
+          lda,
+          a_zero_point,
+          B,
+          p,
+          bias,
+          requantization,
+          C + static_cast<size_t>(m) * ldc,
+          ldc);
+    }
+  }
+  for (; m < M; ++m) {
+    for (int p = 0; p < panels; ++p) {
+      Int8GemmKernel<1>(
+          A + static_cast<size_t>(m) * lda,
+          lda,
+          a_zero_point,
+          B,
+          p,
+          bias,
+          requantization,
+          C + static_cast<size_t>(m) * ldc,
+          ldc);
+    }
+  }
+}
+
+} // namespace int8
+} // namespace caffe2
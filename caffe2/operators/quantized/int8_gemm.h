@@ -0,0 +1,56 @@
+#ifndef CAFFE2_INT8_GEMM_H_
+#define CAFFE2_INT8_GEMM_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+namespace int8 {
+
+// A uint8 weight matrix B of N rows of K values, packed for Int8Gemm: panels
+// of kPanelRows rows, interleaved along K, and the sum of every row.
+struct PackedInt8Weights {
+  static constexpr int kPanelRows = 8;
+
+  int N = 0;
+  int K = 0;
+  int32_t zero_point = 0;
+  std::vector<uint8_t> data;
+  std::vector<int32_t> row_sums;
+};
+
+// Packs the N x K matrix B, whose rows are ldb apart.
+void PackInt8Weights(
+    int N,
+    int K,
+    const uint8_t* B,
+    int ldb,
+    int32_t zero_point,
+    PackedInt8Weights* packed);
+
+/*
+ * C = requantize((A - a_zero_point) * (B - B.zero_point)^T + bias)
+ *
+ * A is M x B.K with rows lda apart, C is M x B.N with rows ldc apart. bias
+ * holds B.N int32 values, or is nullptr. The zero points are not subtracted
+ * element by element: the products of the raw uint8 values are corrected with
+ * the row sums of A and B afterwards. The accumulators are int32, which is
+ * exact for K up to 33025.
+ */
+void Int8Gemm(
+    int M,
+    const uint8_t* A,
+    int lda,
+    int32_t a_zero_point,
+    const PackedInt8Weights& B,
+    const int32_t* bias,
+    const Requantization& requantization,
+    uint8_t* C,
+    int ldc);
+
+} // namespace int8
+} // namespace caffe2
+
+#endif // CAFFE2_INT8_GEMM_H_
@@ -0,0 +1,35 @@
+#include "caffe2/operators/quantized/int8_given_tensor_fill_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8GivenTensorFill, int8::Int8GivenTensorFillOp);
+REGISTER_CPU_OPERATOR(Int8GivenIntTensorFill, int8::Int8GivenIntTensorFillOp);
+
+OPERATOR_SCHEMA(Int8GivenTensorFill)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Creates a uint8 Int8TensorCPU of the given shape, scale and zero point, whose
+values are the bytes of the `values` string.
+)DOC")
+    .Arg("values", "Input array of type char(byte)")
+    .Arg("shape", "Input tensor shape")
+    .Arg("Y_scale", "Output tensor quantization scale")
+    .Arg("Y_zero_point", "Output tensor quantization offset");
+
+OPERATOR_SCHEMA(Int8GivenIntTensorFill)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Creates an int32 Int8TensorCPU of the given shape, scale and zero point, such
+as the bias of Int8Conv or Int8FC.
+)DOC")
+    .Arg("values", "Input array of type int32")
+    .Arg("shape", "Input tensor shape")
+    .Arg("Y_scale", "Output tensor quantization scale")
+    .Arg("Y_zero_point", "Output tensor quantization offset");
+
+NO_GRADIENT(Int8GivenTensorFill);
+NO_GRADIENT(Int8GivenIntTensorFill);
+
+} // namespace caffe2
@@ -0,0 +1,82 @@
+#ifndef CAFFE2_OPERATORS_INT8_GIVEN_TENSOR_FILL_OP_H_
+#define CAFFE2_OPERATORS_INT8_GIVEN_TENSOR_FILL_OP_H_
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+// Base of the ops that fill an Int8TensorCPU with values given as an
+// argument, e.g. weights in an init net.
+class Int8GivenFillOpBase : public Operator<CPUContext> {
+ public:
+  Int8GivenFillOpBase(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        shape_(OperatorBase::GetRepeatedArgument<TIndex>("shape")),
+        scale_(OperatorBase::GetSingleArgument<float>("Y_scale", 1.0f)),
+        zero_point_(OperatorBase::GetSingleArgument<int>("Y_zero_point", 0)) {
+  }
+
+ protected:
+  Int8TensorCPU* PrepareOutput() {
+    auto* Y = Outputs()[0]->GetMutable<Int8TensorCPU>();
+    Y->t.Resize(shape_);
+    Y->scale = scale_;
+    Y->zero_point = zero_point_;
+    return Y;
+  }
+
+  std::vector<TIndex> shape_;
+  float scale_;
+  int32_t zero_point_;
+};
+
+// uint8 values, given as the bytes of a string
+class Int8GivenTensorFillOp final : public Int8GivenFillOpBase {
+ public:
+  Int8GivenTensorFillOp(const OperatorDef& operator_def, Workspace* ws)
+      : Int8GivenFillOpBase(operator_def, ws),
+        values_(OperatorBase::GetSingleArgument<std::string>("values", "")) {}
+
+  bool RunOnDevice() override {
+    auto* Y = PrepareOutput();
+    CAFFE_ENFORCE_EQ(
+        values_.size(), Y->t.size(), "values must have one byte per element");
+    memcpy(Y->t.mutable_data<uint8_t>(), values_.data(), values_.size());
+    return true;
+  }
+
+ private:
+  std::string values_;
+};
+
+// int32 values, e.g. of biases
+class Int8GivenIntTensorFillOp final : public Int8GivenFillOpBase {
+ public:
+  Int8GivenIntTensorFillOp(const OperatorDef& operator_def, Workspace* ws)
+      : Int8GivenFillOpBase(operator_def, ws),
+        values_(OperatorBase::GetRepeatedArgument<int>("values")) {}
+
+  bool RunOnDevice() override {
+    auto* Y = PrepareOutput();
+    CAFFE_ENFORCE_EQ(values_.size(), Y->t.size());
+    std::copy(values_.begin(), values_.end(), Y->t.mutable_data<int32_t>());
+    return true;
+  }
+
+ private:
+  std::vector<int> values_;
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_GIVEN_TENSOR_FILL_OP_H_
@@ -0,0 +1,21 @@
+#include "caffe2/operators/quantized/int8_max_pool_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8MaxPool, int8::Int8MaxPoolOp);
+
+OPERATOR_SCHEMA(Int8MaxPool)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForPool)
+    .SetDoc(R"DOC(
+MaxPool on an NHWC uint8 Int8TensorCPU, with the arguments of MaxPool. Y has
+the scale and zero point of X. Only order "NHWC" and 2-D pooling are
+supported.
+)DOC")
+    .Input(0, "X", "Int8 input, in NHWC order")
+    .Output(0, "Y", "Int8 output, with the scale and zero point of X");
+
+NO_GRADIENT(Int8MaxPool);
+
+} // namespace caffe2
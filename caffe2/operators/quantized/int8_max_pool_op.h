@@ -0,0 +1,73 @@
+#ifndef CAFFE2_OPERATORS_INT8_MAX_POOL_OP_H_
+#define CAFFE2_OPERATORS_INT8_MAX_POOL_OP_H_
+
+#include <algorithm>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+// Max pooling commutes with the quantization, so Y keeps the scale and zero
+// point of X. Padding is ignored, as in MaxPool.
+class Int8MaxPoolOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  Int8MaxPoolOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws) {
+    CAFFE_ENFORCE(
+        order_ == StorageOrder::NHWC, "Int8MaxPool only supports NHWC order");
+  }
+
+  bool RunOnDeviceWithOrderNHWC() override {
+    const auto& X = Inputs()[0]->Get<Int8TensorCPU>();
+    auto* Y = Outputs()[0]->GetMutable<Int8TensorCPU>();
+    CAFFE_ENFORCE(X.t.IsType<uint8_t>());
+    CAFFE_ENFORCE_EQ(X.t.ndim(), 4, "Int8MaxPool only supports 2-D pooling");
+    const int N = X.t.dim32(0);
+    const int H = X.t.dim32(1);
+    const int W = X.t.dim32(2);
+    const int C = X.t.dim32(3);
+    ConvPoolOpBase<CPUContext>::SetOutputSize(X.t, &(Y->t), C);
+    Y->scale = X.scale;
+    Y->zero_point = X.zero_point;
+    const int out_h = Y->t.dim32(1);
+    const int out_w = Y->t.dim32(2);
+
+    const uint8_t* Xdata = X.t.data<uint8_t>();
+    uint8_t* Ydata = Y->t.mutable_data<uint8_t>();
+    for (int n = 0; n < N; ++n) {
+      const uint8_t* Xn = Xdata + static_cast<size_t>(n) * H * W * C;
+      for (int oh = 0; oh < out_h; ++oh) {
+        const int h_start = std::max(oh * stride_h() - pad_t(), 0);
+        const int h_end = std::min(oh * stride_h() - pad_t() + kernel_h(), H);
+        for (int ow = 0; ow < out_w; ++ow) {
+          const int w_start = std::max(ow * stride_w() - pad_l(), 0);
+          const int w_end =
+              std::min(ow * stride_w() - pad_l() + kernel_w(), W);
+          std::fill(Ydata, Ydata + C, 0);
+          for (int h = h_start; h < h_end; ++h) {
+            for (int w = w_start; w < w_end; ++w) {
+              const uint8_t* x = Xn + (static_cast<size_t>(h) * W + w) * C;
+              for (int c = 0; c < C; ++c) {
+                Ydata[c] = std::max(Ydata[c], x[c]);
+              }
+            }
+          }
+          Ydata += C;
+        }
+      }
+    }
+    return true;
+  }
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_MAX_POOL_OP_H_
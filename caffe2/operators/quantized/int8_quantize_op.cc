@@ -0,0 +1,35 @@
+#include "caffe2/operators/quantized/int8_quantize_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Quantize, int8::Int8QuantizeOp);
+REGISTER_CPU_OPERATOR(Int8Dequantize, int8::Int8DequantizeOp);
+
+OPERATOR_SCHEMA(Int8Quantize)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .IdenticalTypeAndShape()
+    .SetDoc(R"DOC(
+Quantizes a float tensor to an Int8TensorCPU: every value x becomes
+`clamp(round(x / Y_scale) + Y_zero_point, 0, 255)`.
+)DOC")
+    .Arg("Y_scale", "Output tensor quantization scale")
+    .Arg("Y_zero_point", "Output tensor quantization offset")
+    .Input(0, "X", "FP32 Tensor X.")
+    .Output(0, "Y", "Int8 Tensor qX representing X with linear quantization.");
+
+OPERATOR_SCHEMA(Int8Dequantize)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .IdenticalTypeAndShape()
+    .SetDoc(R"DOC(
+Turns an Int8TensorCPU back into a float tensor: every value q becomes
+`scale * (q - zero_point)`.
+)DOC")
+    .Input(0, "qX", "Int8 Tensor qX.")
+    .Output(0, "Y", "FP32 Tensor that represents mapped real value of qX.");
+
+NO_GRADIENT(Int8Quantize);
+NO_GRADIENT(Int8Dequantize);
+
+} // namespace caffe2
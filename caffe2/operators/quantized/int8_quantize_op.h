@@ -0,0 +1,65 @@
+#ifndef CAFFE2_OPERATORS_INT8_QUANTIZE_OP_H_
+#define CAFFE2_OPERATORS_INT8_QUANTIZE_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+class Int8QuantizeOp final : public Operator<CPUContext> {
+ public:
+  Int8QuantizeOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        Y_scale_(OperatorBase::GetSingleArgument<float>("Y_scale", 1.0f)),
+        Y_zero_point_(
+            OperatorBase::GetSingleArgument<int>("Y_zero_point", 0)) {
+    CAFFE_ENFORCE_GT(Y_scale_, 0);
+  }
+
+  bool RunOnDevice() override {
+    const auto& X = Input(0);
+    auto* Y = Outputs()[0]->GetMutable<Int8TensorCPU>();
+    Y->t.ResizeLike(X);
+    Y->scale = Y_scale_;
+    Y->zero_point = Y_zero_point_;
+    const float* x = X.data<float>();
+    uint8_t* y = Y->t.mutable_data<uint8_t>();
+    const float inverse_scale = 1.0f / Y_scale_;
+    for (TIndex i = 0; i < X.size(); ++i) {
+      y[i] = QuantizeScaled(x[i] * inverse_scale, Y_zero_point_, 0);
+    }
+    return true;
+  }
+
+ private:
+  float Y_scale_;
+  int32_t Y_zero_point_;
+};
+
+class Int8DequantizeOp final : public Operator<CPUContext> {
+ public:
+  Int8DequantizeOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Inputs()[0]->Get<Int8TensorCPU>();
+    auto* Y = Output(0);
+    Y->ResizeLike(X.t);
+    const uint8_t* x = X.t.data<uint8_t>();
+    float* y = Y->mutable_data<float>();
+    for (TIndex i = 0; i < X.t.size(); ++i) {
+      y[i] = X.scale * (static_cast<int32_t>(x[i]) - X.zero_point);
+    }
+    return true;
+  }
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_QUANTIZE_OP_H_
@@ -0,0 +1,20 @@
+#include "caffe2/operators/quantized/int8_relu_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Relu, int8::Int8ReluOp);
+
+OPERATOR_SCHEMA(Int8Relu)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}})
+    .IdenticalTypeAndShape()
+    .SetDoc(R"DOC(
+Relu on a uint8 Int8TensorCPU. Y has the scale and zero point of X.
+)DOC")
+    .Input(0, "X", "Int8 input")
+    .Output(0, "Y", "Int8 output, with the scale and zero point of X");
+
+NO_GRADIENT(Int8Relu);
+
+} // namespace caffe2
@@ -0,0 +1,42 @@
+#ifndef CAFFE2_OPERATORS_INT8_RELU_OP_H_
+#define CAFFE2_OPERATORS_INT8_RELU_OP_H_
+
+#include <algorithm>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+// The output keeps the scale and zero point of X, so the real value 0 is
+// X.zero_point and Relu is a clamp from below.
+class Int8ReluOp final : public Operator<CPUContext> {
+ public:
+  Int8ReluOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Inputs()[0]->Get<Int8TensorCPU>();
+    auto* Y = Outputs()[0]->GetMutable<Int8TensorCPU>();
+    CAFFE_ENFORCE(X.t.IsType<uint8_t>());
+    Y->t.ResizeLike(X.t);
+    Y->scale = X.scale;
+    Y->zero_point = X.zero_point;
+    const uint8_t zero = static_cast<uint8_t>(X.zero_point);
+    const uint8_t* Xdata = X.t.data<uint8_t>();
+    uint8_t* Ydata = Y->t.mutable_data<uint8_t>();
+    for (TIndex i = 0; i < X.t.size(); ++i) {
+      Ydata[i] = std::max(Xdata[i], zero);
+    }
+    return true;
+  }
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_RELU_OP_H_
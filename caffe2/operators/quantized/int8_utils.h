@@ -0,0 +1,120 @@
+#ifndef CAFFE2_INT8_UTILS_H_
+#define CAFFE2_INT8_UTILS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "caffe2/core/logging.h"
+
+namespace caffe2 {
+namespace int8 {
+
+/*
+ * The int8 operators work on Int8TensorCPU with uint8 data, which stands for
+ * the real values scale * (q - zero_point). Biases are int32 with a scale of
+ * input scale * weight scale and a zero point of 0, so that they add straight
+ * to the int32 accumulators of a GEMM. 4-D tensors are in NHWC order.
+ *
+ * Rescaling from the accumulators to the output is done in fixed point, the
+ * way gemmlowp does it: the real multiplier is turned into a 31 bit
+ * mantissa and a power of two exponent.
+ */
+
+enum class Activation : uint8_t { NONE = 0, RELU = 1 };
+
+// Splits real_multiplier into multiplier * 2^(shift - 31), with multiplier in
+// [2^30, 2^31).
+inline void QuantizeMultiplier(
+    double real_multiplier,
+    int32_t* multiplier,
+    int* shift) {
+  CAFFE_ENFORCE_GT(real_multiplier, 0, "Multipliers must be positive");
+  const double q = std::frexp(real_multiplier, shift);
+  auto q_fixed = static_cast<int64_t>(std::round(q * (1ll << 31)));
+  if (q_fixed == (1ll << 31)) {
+    q_fixed /= 2;
+    ++*shift;
+  }
+  CAFFE_ENFORCE_LE(*shift, 30, "Multiplier ", real_multiplier, " is too large");
+  *multiplier = static_cast<int32_t>(q_fixed);
+}
+
+// Returns round(a * b / 2^31), saturated
+inline int32_t SaturatingRoundingDoublingHighMul(int32_t a, int32_t b) {
+  if (a == b && a == std::numeric_limits<int32_t>::min()) {
+    return std::numeric_limits<int32_t>::max();
+  }
+  const int64_t ab = static_cast<int64_t>(a) * b;
+  const int32_t nudge = ab >= 0 ? (1 << 30) : (1 - (1 << 30));
+  return static_cast<int32_t>((ab + nudge) / (1ll << 31));
+}
+
+// Returns round(x / 2^exponent), rounding half away from zero
+inline int32_t RoundingDivideByPOT(int32_t x, int exponent) {
+  const int32_t mask = static_cast<int32_t>((1ll << exponent) - 1);
+  const int32_t remainder = x & mask;
+  const int32_t threshold = (mask >> 1) + (x < 0 ? 1 : 0);
+  return (x >> exponent) + (remainder > threshold ? 1 : 0);
+}
+
+inline int32_t MultiplyByQuantizedMultiplier(
+    int32_t x,
+    int32_t multiplier,
+    int shift) {
+  const int left_shift = shift > 0 ? shift : 0;
+  const int right_shift = shift > 0 ? 0 : -shift;
+  return RoundingDivideByPOT(
+      SaturatingRoundingDoublingHighMul(x * (1 << left_shift), multiplier),
+      right_shift);
+}
+
+// How int32 accumulators become uint8 outputs
+struct Requantization {
+  int32_t multiplier;
+  int shift;
+  int32_t zero_point;
+  int32_t min;
+  int32_t max;
+};
+
+inline Requantization MakeRequantization(
+    double real_multiplier,
+    int32_t zero_point,
+    Activation activation) {
+  CAFFE_ENFORCE(
+      0 <= zero_point && zero_point <= 255,
+      "Zero points must be in [0, 255], got ",
+      zero_point);
+  Requantization r;
+  QuantizeMultiplier(real_multiplier, &r.multiplier, &r.shift);
+  r.zero_point = zero_point;
+  r.min = activation == Activation::RELU ? zero_point : 0;
+  r.max = 255;
+  return r;
+}
+
+inline uint8_t Requantize(int32_t acc, const Requantization& r) {
+  const int32_t q =
+      MultiplyByQuantizedMultiplier(acc, r.multiplier, r.shift) + r.zero_point;
+  return static_cast<uint8_t>(std::min(std::max(q, r.min), r.max));
+}
+
+inline uint8_t QuantizeUint8(float scale, int32_t zero_point, float value) {
+  const float q = std::nearbyint(value / scale) + zero_point;
+  return static_cast<uint8_t>(std::min(std::max(q, 0.0f), 255.0f));
+}
+
+// For ops that rescale in floating point: rounds value, which is already in
+// units of the output scale, and shifts it by zero_point.
+inline uint8_t QuantizeScaled(float value, int32_t zero_point, int32_t min) {
+  const float q = std::nearbyint(value) + zero_point;
+  return static_cast<uint8_t>(
+      std::min(std::max(q, static_cast<float>(min)), 255.0f));
+}
+
+} // namespace int8
+} // namespace caffe2
+
+#endif // CAFFE2_INT8_UTILS_H_
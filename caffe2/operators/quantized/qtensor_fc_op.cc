@@ -0,0 +1,35 @@
+#include "caffe2/operators/quantized/qtensor_fc_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(QuantizedFC, QuantizedFCOp);
+
+OPERATOR_SCHEMA(QuantizedFC)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Computes the result of passing an input vector X into a fully connected
+layer with 2D weight matrix W and 1D bias vector b, like FC, with low-bit
+QTensor weights:
+
+    Y = X * W^T + b
+
+The products of X and W are computed bit-serially on the bit planes of the
+QTensors, as popcounts of the ANDs of 64 bits of a row of X and a row of W at
+a time, which are exact; the scales and offsets of X and W are applied to
+the integer results. X can be a QTensor too, or a float tensor that is
+quantized to `precision` bits with the scale from its range, as
+QTensorQuantize does. The cost grows with the product of the precisions of
+X and W, so it pays off for a few bits.
+)DOC")
+    .Arg("axis", "Dimension from which X is flattened (default 1)")
+    .Arg("precision", "Bits of a float X once quantized (default 8)")
+    .Arg("signed", "Whether a float X is quantized with a sign (default true)")
+    .Input(0, "X", "QTensor or float input, flattened to a matrix at axis")
+    .Input(1, "W", "QTensor weights of shape [N, K]")
+    .Input(2, "b", "Optional float bias of shape [N]")
+    .Output(0, "Y", "Float output");
+
+NO_GRADIENT(QuantizedFC);
+
+} // namespace caffe2
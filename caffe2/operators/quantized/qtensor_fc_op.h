@@ -0,0 +1,79 @@
+#ifndef CAFFE2_OPERATORS_QTENSOR_FC_OP_H_
+#define CAFFE2_OPERATORS_QTENSOR_FC_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/qtensor.h"
+#include "caffe2/operators/quantized/qtensor_gemm.h"
+#include "caffe2/operators/quantized/qtensor_quantize_op.h"
+
+namespace caffe2 {
+
+class QuantizedFCOp final : public Operator<CPUContext> {
+ public:
+  QuantizedFCOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        axis_(OperatorBase::GetSingleArgument<int>("axis", 1)),
+        precision_(OperatorBase::GetSingleArgument<int>("precision", 8)),
+        signed_(OperatorBase::GetSingleArgument<bool>("signed", true)) {}
+
+  bool RunOnDevice() override {
+    const auto& W = Inputs()[1]->Get<QTensor<CPUContext>>();
+    const float* bias = nullptr;
+    auto* Y = Output(0);
+    CAFFE_ENFORCE_EQ(W.ndim(), 2);
+    const int N = W.dim32(0);
+    const int K = W.dim32(1);
+    if (InputSize() == 3) {
+      CAFFE_ENFORCE_EQ(Input(2).size(), N);
+      bias = Input(2).data<float>();
+    }
+
+    // Float activations are quantized here
+    const QTensor<CPUContext>* X;
+    if (Inputs()[0]->IsType<QTensor<CPUContext>>()) {
+      X = &Inputs()[0]->Get<QTensor<CPUContext>>();
+    } else {
+      const auto& Xf = Input(0);
+      std::vector<int> dims(Xf.dims().begin(), Xf.dims().end());
+      QuantizeToQTensor(
+          Xf.data<float>(), dims, precision_, signed_, 0, 0, &X_quantized_);
+      X = &X_quantized_;
+    }
+    const auto canonical_axis = X->canonical_axis_index(axis_);
+    const int M = X->size_to_dim(canonical_axis);
+    CAFFE_ENFORCE_EQ(
+        K, X->size_from_dim(canonical_axis), "X and W do not match in size");
+
+    auto Y_shape = X->dims();
+    Y_shape.resize(canonical_axis + 1);
+    Y_shape[canonical_axis] = N;
+    Y->Resize(Y_shape);
+
+    // The weights are constant in inference, so pack them once
+    if (packed_source_ != W.data() || packed_W_.rows != N ||
+        packed_W_.cols != K || packed_W_.precision != W.precision() ||
+        packed_W_.is_signed != W.is_signed()) {
+      PackQTensor(W, N, K, &packed_W_);
+      packed_source_ = W.data();
+    }
+    PackQTensor(*X, M, K, &packed_X_);
+
+    QTensorGemm(packed_X_, packed_W_, bias, Y->mutable_data<float>(), N);
+    return true;
+  }
+
+ private:
+  int axis_;
+  int precision_;
+  bool signed_;
+
+  QTensor<CPUContext> X_quantized_;
+  PackedQTensor packed_X_;
+  PackedQTensor packed_W_;
+  const void* packed_source_{nullptr};
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_QTENSOR_FC_OP_H_
@@ -0,0 +1,286 @@
+#include "caffe2/operators/quantized/qtensor_gemm.h"
+
+#include <climits>
+#include <cstring>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
+
+namespace caffe2 {
+
+namespace {
+
+constexpr int kWordBits = 64;
+
+// Copies the cols bits of a row that start at bit off of the QTensor data, in
+// the order of the QTensor: the first element is the most significant bit of
+// the first byte.
+void PackRowPlane(
+    const uint8_t* data,
+    size_t nbytes,
+    size_t off,
+    int cols,
+    uint8_t* out) {
+  const size_t row_bytes = (cols + CHAR_BIT - 1) / CHAR_BIT;
+  const size_t first = off / CHAR_BIT;
+  const int shift = off % CHAR_BIT;
+  if (shift == 0) {
+    std::memcpy(out, data + first, row_bytes);
+  } else {
+    for (size_t j = 0; j < row_bytes; ++j) {
+      const size_t i = first + j;
+      const uint8_t hi = data[i] << shift;
+      const uint8_t lo =
+          i + 1 < nbytes ? data[i + 1] >> (CHAR_BIT - shift) : 0;
+      out[j] = hi | lo;
+    }
+  }
+  if (cols % CHAR_BIT) {
+    out[row_bytes - 1] &= 0xff << (CHAR_BIT - cols % CHAR_BIT);
+  }
+}
+
+// count = sum popcount(a & b), and if kMasked, masked = sum popcount(a & b & t)
+// over the words.
+#if defined(__AVX2__)
+
+// The number of bits set in each byte of v.
+inline __m256i PopcountBytes(__m256i v) {
+  const __m256i lookup = _mm256_setr_epi8(
+      0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+      0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  const __m256i lo = _mm256_and_si256(v, low_mask);
+  const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+  return _mm256_add_epi8(
+      _mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+}
+
+inline int64_t HorizontalSum(__m256i v) {
+  return _mm256_extract_epi64(v, 0) + _mm256_extract_epi64(v, 1) +
+      _mm256_extract_epi64(v, 2) + _mm256_extract_epi64(v, 3);
+}
+
+template <bool kMasked>
+void AndPopcount(
+    const uint64_t* a,
+    const uint64_t* b,
+    const uint64_t* t,
+    int words,
+    int64_t* count,
+    int64_t* masked) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc = zero;
+  __m256i acc_masked = zero;
+  int w = 0;
+  for (; w + 4 <= words; w += 4) {
+    const __m256i ab = _mm256_and_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + w)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + w)));
+    // The byte counts are at most 8, and their sums fit in 64 bits lanes.
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(PopcountBytes(ab), zero));
+    if (kMasked) {
+      const __m256i abt = _mm256_and_si256(
+          ab, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t + w)));
+      acc_masked = _mm256_add_epi64(
+          acc_masked, _mm256_sad_epu8(PopcountBytes(abt), zero));
+    }
+  }
+  *count = HorizontalSum(acc);
+  *masked = HorizontalSum(acc_masked);
+  for (; w < words; ++w) {
+    const uint64_t ab = a[w] & b[w];
+    *count += __builtin_popcountll(ab);
+    if (kMasked) {
+      *masked += __builtin_popcountll(ab & t[w]);
+    }
+  }
+}
+
+#elif defined(__ARM_NEON__)
+
+inline uint64x2_t AccumulatePopcount(uint64x2_t acc, uint64x2_t v) {
+  return vpadalq_u32(
+      acc, vpaddlq_u16(vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u64(v)))));
+}
+
+template <bool kMasked>
+void AndPopcount(
+    const uint64_t* a,
+    const uint64_t* b,
+    const uint64_t* t,
+    int words,
+    int64_t* count,
+    int64_t* masked) {
+  uint64x2_t acc = vdupq_n_u64(0);
+  uint64x2_t acc_masked = vdupq_n_u64(0);
+  int w = 0;
+  for (; w + 2 <= words; w += 2) {
+    const uint64x2_t ab = vandq_u64(vld1q_u64(a + w), vld1q_u64(b + w));
+    acc = AccumulatePopcount(acc, ab);
+    if (kMasked) {
+      acc_masked =
+          AccumulatePopcount(acc_masked, vandq_u64(ab, vld1q_u64(t + w)));
+    }
+  }
+  *count = vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+  *masked = vgetq_lane_u64(acc_masked, 0) + vgetq_lane_u64(acc_masked, 1);
+  for (; w < words; ++w) {
+    const uint64_t ab = a[w] & b[w];
+    *count += __builtin_popcountll(ab);
+    if (kMasked) {
+      *masked += __builtin_popcountll(ab & t[w]);
+    }
+  }
+}
+
+#else
+
+template <bool kMasked>
+void AndPopcount(
+    const uint64_t* a,
+    const uint64_t* b,
+    const uint64_t* t,
+    int words,
+    int64_t* count,
+    int64_t* masked) {
+  *count = 0;
+  *masked = 0;
+  for (int w = 0; w < words; ++w) {
+    const uint64_t ab = a[w] & b[w];
+    *count += __builtin_popcountll(ab);
+    if (kMasked) {
+      *masked += __builtin_popcountll(ab & t[w]);
+    }
+  }
+}
+
+#endif
+
+// The integer dot product of a row of A and a row of B. t holds the signs
+// that differ, or is nullptr if both are unsigned.
+template <bool kMasked>
+int64_t BitSerialDot(
+    const uint64_t* a,
+    int a_precision,
+    const uint64_t* b,
+    int b_precision,
+    const uint64_t* t,
+    int words) {
+  int64_t dot = 0;
+  for (int i = 0; i < a_precision; ++i) {
+    for (int j = 0; j < b_precision; ++j) {
+      int64_t count, masked;
+      AndPopcount<kMasked>(
+          a + i * words, b + j * words, t, words, &count, &masked);
+      dot += (count - 2 * masked) * (int64_t(1) << (i + j));
+    }
+  }
+  return dot;
+}
+
+} // namespace
+
+void PackQTensor(
+    const QTensor<CPUContext>& X,
+    int rows,
+    int cols,
+    PackedQTensor* packed) {
+  CAFFE_ENFORCE_EQ(
+      static_cast<size_t>(rows) * cols, X.size(), "QTensor size mismatch");
+  CAFFE_ENFORCE_GT(cols, 0);
+  CAFFE_ENFORCE(X.data() || X.size() == 0, "The QTensor holds no data");
+  packed->rows = rows;
+  packed->cols = cols;
+  packed->precision = X.precision();
+  packed->is_signed = X.is_signed();
+  packed->scale = X.scale();
+  packed->bias = X.bias();
+  packed->words = (cols + kWordBits - 1) / kWordBits;
+  const int planes = packed->planes();
+  const int words = packed->words;
+  packed->data.assign(static_cast<size_t>(rows) * planes * words, 0);
+  packed->row_sums.assign(rows, 0);
+
+  const uint8_t* data = X.data();
+  const size_t nbytes = X.nbytes();
+  for (int r = 0; r < rows; ++r) {
+    uint64_t* row =
+        packed->data.data() + static_cast<size_t>(r) * planes * words;
+    for (int p = 0; p < planes; ++p) {
+      PackRowPlane(
+          data,
+          nbytes,
+          p * X.aligned_size() + static_cast<size_t>(r) * cols,
+          cols,
+          reinterpret_cast<uint8_t*>(row + p * words));
+    }
+
+    // sum x = sum_i 2^i (popcount(x_i) - 2 popcount(x_i & sign))
+    const uint64_t* sign =
+        packed->is_signed ? row + packed->precision * words : nullptr;
+    int64_t sum = 0;
+    for (int i = 0; i < packed->precision; ++i) {
+      for (int w = 0; w < words; ++w) {
+        const uint64_t bits = row[i * words + w];
+        int64_t count = __builtin_popcountll(bits);
+        if (sign) {
+          count -= 2 * __builtin_popcountll(bits & sign[w]);
+        }
+        sum += count * (int64_t(1) << i);
+      }
+    }
+    packed->row_sums[r] = sum;
+  }
+}
+
+void QTensorGemm(
+    const PackedQTensor& A,
+    const PackedQTensor& B,
+    const float* bias,
+    float* C,
+    int ldc) {
+  CAFFE_ENFORCE_EQ(A.cols, B.cols, "A and B do not match in size");
+  const int words = A.words;
+  const double K = A.cols;
+  const double scale = A.scale * B.scale;
+  // The part of the result that only depends on the row of B
+  std::vector<double> col_terms(B.rows);
+  for (int n = 0; n < B.rows; ++n) {
+    col_terms[n] = A.bias * B.row_sums[n] + K * A.bias * B.bias;
+  }
+  std::vector<uint64_t> signs(A.is_signed && B.is_signed ? words : 0);
+
+  for (int m = 0; m < A.rows; ++m) {
+    const uint64_t* a = A.row(m);
+    const uint64_t* a_sign = A.is_signed ? a + A.precision * words : nullptr;
+    const double row_term = B.bias * A.row_sums[m];
+    float* c = C + static_cast<size_t>(m) * ldc;
+    for (int n = 0; n < B.rows; ++n) {
+      const uint64_t* b = B.row(n);
+      const uint64_t* b_sign =
+          B.is_signed ? b + B.precision * words : nullptr;
+      const uint64_t* t = a_sign ? a_sign : b_sign;
+      if (a_sign && b_sign) {
+        for (int w = 0; w < words; ++w) {
+          signs[w] = a_sign[w] ^ b_sign[w];
+        }
+        t = signs.data();
+      }
+      const int64_t dot = t
+          ? BitSerialDot<true>(a, A.precision, b, B.precision, t, words)
+          : BitSerialDot<false>(a, A.precision, b, B.precision, t, words);
+      double v = scale * (dot + row_term + col_terms[n]);
+      if (bias) {
+        v += bias[n];
+      }
+      c[n] = static_cast<float>(v);
+    }
+  }
+}
+
+} // namespace caffe2
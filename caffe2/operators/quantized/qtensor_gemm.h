@@ -0,0 +1,68 @@
+#ifndef CAFFE2_QTENSOR_GEMM_H_
+#define CAFFE2_QTENSOR_GEMM_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/qtensor.h"
+
+namespace caffe2 {
+
+/*
+ * A QTensor holds the bits of its elements plane by plane over the whole
+ * tensor, so the rows of a matrix start at any bit. For the GEMM, every row
+ * is copied to its own 64 bit words: the planes of the magnitude bits, least
+ * significant first, then the plane of the sign bits if the QTensor is
+ * signed, each of `words` words padded with 0 bits.
+ *
+ * The elements stand for scale * (x + bias), with x = +-magnitude.
+ */
+struct PackedQTensor {
+  int rows = 0;
+  int cols = 0;
+  int precision = 0;
+  bool is_signed = false;
+  double scale = 1;
+  double bias = 0;
+  // 64 bit words per plane of a row
+  int words = 0;
+  std::vector<uint64_t> data;
+  // The sum of the x of every row
+  std::vector<int64_t> row_sums;
+
+  int planes() const {
+    return precision + is_signed;
+  }
+
+  const uint64_t* row(int r) const {
+    return data.data() + static_cast<size_t>(r) * planes() * words;
+  }
+};
+
+// Packs the QTensor X as a matrix of rows x cols elements.
+void PackQTensor(
+    const QTensor<CPUContext>& X,
+    int rows,
+    int cols,
+    PackedQTensor* packed);
+
+/*
+ * C = A * B^T + bias, in float, for the M x K A and N x K B.
+ *
+ * The integer products are computed bit-serially, as the sum over the pairs
+ * of magnitude planes (i, j) of 2^(i + j) * popcount(a_i & b_j), minus twice
+ * the same popcounts masked by the signs that differ. The scales and biases
+ * of A and B are applied to the exact integer results, with the row sums.
+ * bias holds B.rows values, or is nullptr. C has rows ldc apart.
+ */
+void QTensorGemm(
+    const PackedQTensor& A,
+    const PackedQTensor& B,
+    const float* bias,
+    float* C,
+    int ldc);
+
+} // namespace caffe2
+
+#endif // CAFFE2_QTENSOR_GEMM_H_
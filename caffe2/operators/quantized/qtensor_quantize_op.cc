@@ -0,0 +1,132 @@
+#include "caffe2/operators/quantized/qtensor_quantize_op.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace caffe2 {
+
+void QuantizeToQTensor(
+    const float* x,
+    const std::vector<int>& dims,
+    int precision,
+    bool is_signed,
+    double scale,
+    double bias,
+    QTensor<CPUContext>* Y) {
+  CAFFE_ENFORCE(
+      precision >= 1 && precision <= 16,
+      "The precision must be between 1 and 16 bits, not ",
+      precision);
+  // Resizing a QTensor to fewer elements keeps its allocation, which
+  // mutable_data() then refuses, so the data is reset on any change.
+  if (Y->dims() != dims || Y->precision() != precision ||
+      Y->is_signed() != is_signed) {
+    Y->Resize(dims);
+    Y->SetPrecision(precision);
+    Y->SetSigned(is_signed);
+  }
+  const size_t size = Y->size();
+  const int32_t q_max = (1 << precision) - 1;
+
+  if (scale <= 0) {
+    if (is_signed) {
+      float abs_max = 0;
+      for (size_t e = 0; e < size; ++e) {
+        abs_max = std::max(abs_max, std::abs(x[e]));
+      }
+      scale = abs_max > 0 ? static_cast<double>(abs_max) / q_max : 1;
+      bias = 0;
+    } else {
+      const auto range = std::minmax_element(x, x + size);
+      const double lo = size ? *range.first : 0;
+      const double hi = size ? *range.second : 0;
+      scale = hi > lo ? (hi - lo) / q_max : 1;
+      bias = lo / scale;
+    }
+  }
+  Y->SetScale(scale);
+  Y->SetBias(bias);
+
+  uint8_t* data = Y->mutable_data();
+  std::memset(data, 0, Y->nbytes());
+  const size_t plane_bytes = Y->aligned_size() / CHAR_BIT;
+  const double inverse_scale = 1 / scale;
+  for (size_t e = 0; e < size; ++e) {
+    const double v = x[e] * inverse_scale - bias;
+    int32_t magnitude = static_cast<int32_t>(
+        std::min<double>(std::round(std::abs(v)), q_max));
+    if (!is_signed && v < 0) {
+      magnitude = 0;
+    }
+    uint8_t* byte = data + e / CHAR_BIT;
+    const uint8_t bit = 0x80 >> (e % CHAR_BIT);
+    for (int p = 0; p < precision; ++p) {
+      if ((magnitude >> p) & 1) {
+        byte[p * plane_bytes] |= bit;
+      }
+    }
+    if (is_signed && v < 0 && magnitude > 0) {
+      byte[precision * plane_bytes] |= bit;
+    }
+  }
+}
+
+void DequantizeQTensor(const QTensor<CPUContext>& X, float* y) {
+  CAFFE_ENFORCE(X.data() || X.size() == 0, "The QTensor holds no data");
+  const uint8_t* data = X.data();
+  const size_t plane_bytes = X.aligned_size() / CHAR_BIT;
+  const int precision = X.precision();
+  for (size_t e = 0; e < X.size(); ++e) {
+    const uint8_t* byte = data + e / CHAR_BIT;
+    const uint8_t bit = 0x80 >> (e % CHAR_BIT);
+    int32_t q = 0;
+    for (int p = 0; p < precision; ++p) {
+      if (byte[p * plane_bytes] & bit) {
+        q |= 1 << p;
+      }
+    }
+    if (X.is_signed() && (byte[precision * plane_bytes] & bit)) {
+      q = -q;
+    }
+    y[e] = static_cast<float>(X.scale() * (q + X.bias()));
+  }
+}
+
+REGISTER_CPU_OPERATOR(QTensorQuantize, QTensorQuantizeOp);
+REGISTER_CPU_OPERATOR(QTensorDequantize, QTensorDequantizeOp);
+
+OPERATOR_SCHEMA(QTensorQuantize)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Quantizes a float tensor to a QTensor, which holds the bits of its elements
+plane by plane for the bit-serial QuantizedFC. Every value x becomes
+`scale * (q + bias)`, with q an integer of `precision` bits, plus a sign bit
+if `signed`.
+
+Without a `scale`, the scale and bias are chosen from the range of X: signed
+QTensors are symmetric around 0, unsigned ones map the minimum of X to q = 0.
+)DOC")
+    .Arg("precision", "Bits of the magnitude of q, from 1 to 16 (default 8)")
+    .Arg("signed", "Whether q has a sign bit (default true)")
+    .Arg("scale", "Quantization scale, chosen from X if not positive")
+    .Arg("bias", "Quantization offset, used with scale (default 0)")
+    .Input(0, "X", "FP32 Tensor X.")
+    .Output(0, "Y", "QTensor representing X.");
+
+OPERATOR_SCHEMA(QTensorDequantize)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Turns a QTensor back into a float tensor: every element q becomes
+`scale * (q + bias)`.
+)DOC")
+    .Input(0, "X", "QTensor X.")
+    .Output(0, "Y", "FP32 Tensor that represents the values of X.");
+
+NO_GRADIENT(QTensorQuantize);
+NO_GRADIENT(QTensorDequantize);
+
+} // namespace caffe2
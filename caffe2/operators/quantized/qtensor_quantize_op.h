@@ -0,0 +1,72 @@
+#ifndef CAFFE2_OPERATORS_QTENSOR_QUANTIZE_OP_H_
+#define CAFFE2_OPERATORS_QTENSOR_QUANTIZE_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/qtensor.h"
+
+namespace caffe2 {
+
+/*
+ * Quantizes the values of x to Y, with the dims of Y set to dims. Every value
+ * becomes scale * (q + bias), with q = +-magnitude if is_signed, q >= 0
+ * otherwise, and magnitudes of precision bits, rounded and clamped.
+ *
+ * With scale <= 0, the scale and bias are chosen from the range of the
+ * values: signed QTensors are symmetric around 0, unsigned ones map the
+ * smallest value to q = 0.
+ */
+void QuantizeToQTensor(
+    const float* x,
+    const std::vector<int>& dims,
+    int precision,
+    bool is_signed,
+    double scale,
+    double bias,
+    QTensor<CPUContext>* Y);
+
+// y = scale * (q + bias) for the elements of X
+void DequantizeQTensor(const QTensor<CPUContext>& X, float* y);
+
+class QTensorQuantizeOp final : public Operator<CPUContext> {
+ public:
+  QTensorQuantizeOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        precision_(OperatorBase::GetSingleArgument<int>("precision", 8)),
+        signed_(OperatorBase::GetSingleArgument<bool>("signed", true)),
+        scale_(OperatorBase::GetSingleArgument<float>("scale", 0)),
+        bias_(OperatorBase::GetSingleArgument<float>("bias", 0)) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Input(0);
+    auto* Y = Outputs()[0]->GetMutable<QTensor<CPUContext>>();
+    std::vector<int> dims(X.dims().begin(), X.dims().end());
+    QuantizeToQTensor(
+        X.data<float>(), dims, precision_, signed_, scale_, bias_, Y);
+    return true;
+  }
+
+ private:
+  int precision_;
+  bool signed_;
+  float scale_;
+  float bias_;
+};
+
+class QTensorDequantizeOp final : public Operator<CPUContext> {
+ public:
+  QTensorDequantizeOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Inputs()[0]->Get<QTensor<CPUContext>>();
+    auto* Y = Output(0);
+    Y->Resize(X.dims());
+    DequantizeQTensor(X, Y->mutable_data<float>());
+    return true;
+  }
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_QTENSOR_QUANTIZE_OP_H_
@@ -322,6 +322,22 @@ struct MaxRangeReducerDef {
 // Incremental reducers: consume elements one by one
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace detail {
+
+// out += in for the rows reduced by the incremental reducers. It is inlined
+// rather than going through math::Axpy, which for the short rows of
+// embeddings costs more in a BLAS call than in the addition itself.
+template <typename T, int FixedSize>
+inline void AddRow(const TIndex size, const T* in, T* out) {
+  if (FixedSize == 1) { // static if
+    *out += *in;
+  } else {
+    EigenVectorMap<T>(out, size) += ConstEigenVectorMap<T>(in, size);
+  }
+}
+
+} // namespace detail
+
 // Base implementation, everything can be overwritten
 class BaseReducer {
  public:
@@ -444,8 +460,7 @@ class SumReducer<T, CPUContext> : public BaseReducer {
       TIndex /*offset*/,
       CPUContext* context) {
     if (meta.first_dim) {
-      math::AxpyFixedSize<T, CPUContext, FixedSize>(
-          meta.block_size, 1, in, out_, context);
+      detail::AddRow<T, FixedSize>(meta.block_size, in, out_);
     } else {
       math::Sum<T, CPUContext>(
           meta.block_size, in, out_ + current_size_++, context);
@@ -675,8 +690,7 @@ class MeanReducer<T, CPUContext> : public BaseReducer {
       TIndex /*offset*/,
       CPUContext* context) {
     if (meta.first_dim) {
-      math::AxpyFixedSize<T, CPUContext, FixedSize>(
-          meta.block_size, 1, in, out_, context);
+      detail::AddRow<T, FixedSize>(meta.block_size, in, out_);
     } else {
       math::Sum<T, CPUContext>(
           meta.block_size, in, out_ + current_size_, context);
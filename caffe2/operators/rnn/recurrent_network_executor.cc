@@ -1,5 +1,6 @@
 #include "caffe2/operators/rnn/recurrent_network_executor.h"
 
+#include "caffe2/core/numa.h"
 #include "caffe2/core/timer.h"
 
 namespace caffe2 {
@@ -19,6 +20,15 @@ std::unique_ptr<RecurrentNetworkExecutorBase> createRNNExecutor<CPUContext>(
       step_net_def, recurrent_input_map, timestep_blob);
   int num_threads =
       rnn_args.GetSingleArgument<int>("rnn_executor.num_threads", 0);
+  int numa_node_id =
+      rnn_args.GetSingleArgument<int>("rnn_executor.numa_node", -1);
+  if (numa_node_id >= 0) {
+    exec->setNUMANode(numa_node_id);
+    // Default to one worker per CPU of the node
+    if (num_threads <= 0) {
+      num_threads = GetNUMANodeCPUCount(numa_node_id);
+    }
+  }
   if (num_threads > 0) {
     exec->setNumThreads(num_threads);
     LOG(INFO) << "Set num threads: " << num_threads;
@@ -145,6 +155,7 @@ void ThreadedRecurrentNetworkExecutor::WorkerFunction() {
   size_t num_jobs = 0;
   static std::atomic<int> seq(0);
   int id = seq.fetch_add(1);
+  NUMABind(numa_node_id_);
 
   while (!failed_) {
     OpTask job;
@@ -510,6 +510,11 @@ class ThreadedRecurrentNetworkExecutor : public RecurrentNetworkExecutorBase {
     num_threads_ = n;
   }
 
+  // Binds the worker threads, and so the memory they allocate, to a NUMA node
+  void setNUMANode(int numa_node_id) {
+    numa_node_id_ = numa_node_id;
+  }
+
  private:
   void _ExecRange(int from, int to);
 
@@ -519,7 +524,7 @@ class ThreadedRecurrentNetworkExecutor : public RecurrentNetworkExecutorBase {
 
   void RunOp(OpTask job, int thread_id);
 
-  SimpleQueue<OpTask> task_queue_;
+  WavefrontTaskQueue task_queue_;
   std::atomic<int> countdown_;
   std::atomic<bool> failed_;
   std::atomic<int> finished_timesteps_;
@@ -528,6 +533,7 @@ class ThreadedRecurrentNetworkExecutor : public RecurrentNetworkExecutorBase {
   std::condition_variable cv_;
   std::vector<std::thread> workers_;
   int num_threads_ = 4;
+  int numa_node_id_ = -1;
 };
 
 } // namespace caffe2
@@ -2,6 +2,9 @@
 #ifndef CAFFE2_OPERATORS_RECURRENT_NETWORK_EXECUTOR_INCL_H_
 #define CAFFE2_OPERATORS_RECURRENT_NETWORK_EXECUTOR_INCL_H_
 
+#include <condition_variable>
+#include <mutex>
+#include <queue>
 #include <vector>
 #include "caffe2/core/operator.h"
 
@@ -67,6 +70,68 @@ struct OpTask {
   inline bool forward() {
     return direction == 1;
   }
+
+  // Position of the timestep in the order of execution
+  inline int step() const {
+    return direction == 1 ? timestep : T - 1 - timestep;
+  }
+};
+
+/**
+ * Queue of ready tasks that hands out the task of the earliest timestep
+ * first, and within a timestep the earliest op of the step net. For stacked
+ * RNNs this runs the ready ops as a wavefront: layer L of timestep t runs
+ * alongside layer L + 1 of timestep t - 1, and the upper layers, which are on
+ * the critical path, are not starved by the lower layers running ahead.
+ * Same interface as SimpleQueue.
+ */
+class WavefrontTaskQueue {
+ public:
+  // Blocks until there is a task, returns false once the queue is closed
+  bool Pop(OpTask* task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !queue_.empty() || no_more_jobs_; });
+    if (queue_.empty()) {
+      return false;
+    }
+    *task = queue_.top();
+    queue_.pop();
+    return true;
+  }
+
+  void Push(const OpTask& task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      CAFFE_ENFORCE(!no_more_jobs_, "Cannot push to a closed queue.");
+      queue_.push(task);
+    }
+    cv_.notify_one();
+  }
+
+  int size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+  }
+
+  void NoMoreJobs() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      no_more_jobs_ = true;
+    }
+    cv_.notify_all();
+  }
+
+ private:
+  struct Later {
+    bool operator()(const OpTask& a, const OpTask& b) const {
+      return a.step() != b.step() ? a.step() > b.step() : a.op_idx > b.op_idx;
+    }
+  };
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::priority_queue<OpTask, std::vector<OpTask>, Later> queue_;
+  bool no_more_jobs_ = false;
 };
 
 } // namespace caffe2
@@ -37,7 +37,11 @@ template <typename T>
 RecurrentBaseOp<T>::RecurrentBaseOp(
     const OperatorDef& operator_def,
     Workspace* ws)
-    : Operator<CUDAContext>(operator_def, ws), cudnn_wrapper_(&context_) {
+    : Operator<CUDAContext>(operator_def, ws),
+      cudnn_wrapper_(&context_),
+      persistentMaxBatchSize_(OperatorBase::GetSingleArgument<int>(
+          "persistent_max_batch_size",
+          8)) {
   CUDNN_ENFORCE(cudnnCreateDropoutDescriptor(&dropoutDesc_));
   CUDNN_ENFORCE(cudnnCreateRNNDescriptor(&rnnDesc_));
   CUDNN_ENFORCE(cudnnCreateFilterDescriptor(&wDesc_));
@@ -58,6 +62,23 @@ RecurrentBaseOp<T>::~RecurrentBaseOp() {
   CUDNN_ENFORCE(cudnnDestroyTensorDescriptor(cyDesc_));
 }
 
+template <typename T>
+bool RecurrentBaseOp<T>::usePersistentAlgo(int batchSize) const {
+#if CUDNN_VERSION_MIN(7, 0, 0)
+  // Inference only, the gradient op builds its descriptor with the standard
+  // algorithm and has to match the reserve space of the forward pass.
+  if (persistentUnsupported_ ||
+      !OperatorBase::GetSingleArgument<int>(OpSchema::Arg_IsTest, 0) ||
+      batchSize > persistentMaxBatchSize_) {
+    return false;
+  }
+  // Needs the register file and shared memory of Pascal or newer
+  return GetDeviceProperty(context_.cuda_gpu_id()).major >= 6;
+#else
+  return false;
+#endif
+}
+
 template <typename T>
 void RecurrentBaseOp<T>::initialize(
     const Tensor<CUDAContext>& input,
@@ -116,6 +137,7 @@ void RecurrentBaseOp<T>::initialize(
   // RNN setup
   {
 #if CUDNN_VERSION_MIN(7, 0, 0)
+    persistent_ = usePersistentAlgo(batchSize);
     CUDNN_ENFORCE(cudnnSetRNNDescriptor(
         cudnn_wrapper_.inline_cudnn_handle(),
         rnnDesc_,
@@ -125,7 +147,7 @@ void RecurrentBaseOp<T>::initialize(
         rnnInput,
         rnnDirection,
         rnnMode,
-        CUDNN_RNN_ALGO_STANDARD, // TODO: verify correctness / efficiency.
+        persistent_ ? CUDNN_RNN_ALGO_PERSIST_STATIC : CUDNN_RNN_ALGO_STANDARD,
         cudnnTypeWrapper<T>::type));
 #else
     CUDNN_ENFORCE(cudnnSetRNNDescriptor(
@@ -257,8 +279,9 @@ bool RecurrentOp<T>::RunOnDevice() {
   };
 
   if (OperatorBase::GetSingleArgument<int>(OpSchema::Arg_IsTest, 0)) {
-    cudnn_wrapper_.with_cudnn_state(0, [&](CuDNNState* state) {
-      CUDNN_ENFORCE(cudnnRNNForwardInference(
+    cudnnStatus_t status;
+    auto forwardInference = [&](CuDNNState* state) {
+      status = cudnnRNNForwardInference(
           state->cudnn_handle(),
           rnnDesc_,
           seqLength,
@@ -277,8 +300,22 @@ bool RecurrentOp<T>::RunOnDevice() {
           cyDesc_,
           OutputData(CELL_OUTPUT), //->template mutable_data<T>(),
           state->workspace().get(cudnnWsNbytes_),
-          cudnnWsNbytes_));
-    });
+          cudnnWsNbytes_);
+    };
+    cudnn_wrapper_.with_cudnn_state(0, forwardInference);
+    if (persistent_ && status == CUDNN_STATUS_NOT_SUPPORTED) {
+      // Hidden size too large for the on-chip weights of this device
+      VLOG(1) << "Persistent RNN not supported, using the standard algorithm";
+      persistentUnsupported_ = true;
+      initialize(
+          Input(INPUT),
+          Output(DROPOUT_STATES),
+          Output(OUTPUT),
+          Output(HIDDEN_OUTPUT),
+          Output(CELL_OUTPUT));
+      cudnn_wrapper_.with_cudnn_state(0, forwardInference);
+    }
+    CUDNN_ENFORCE(status);
   } else {
     cudnn_wrapper_.with_cudnn_state(0, [&](CuDNNState* state) {
       CUDNN_ENFORCE(cudnnRNNForwardTraining(
@@ -531,7 +568,18 @@ minibatches) by multiplying by zero.
 The CuDNN arguments (hidden_size, bidirectional, num_layers, rnn_mode,
 input_mode) are passed directly through to CuDNN.
 
-)DOC");
+For inference (is_test) on batches of at most persistent_max_batch_size,
+the persistent CuDNN algorithm is used on Pascal and newer GPUs: the whole
+sequence runs in one kernel with the recurrent weights kept in registers and
+shared memory, which removes the per-timestep launch latency that dominates
+small batches. It falls back to the standard algorithm when the shape is not
+supported.
+
+)DOC")
+    .Arg(
+        "persistent_max_batch_size",
+        "Largest batch size that uses the persistent algorithm in inference "
+        "(default 8, 0 to disable).");
 REGISTER_CUDNN_OPERATOR(RecurrentGradient, RecurrentGradientOp<float>);
 OPERATOR_SCHEMA(RecurrentGradient)
     .NumInputs(7)
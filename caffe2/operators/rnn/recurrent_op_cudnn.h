@@ -44,6 +44,11 @@ class RecurrentBaseOp : public Operator<CUDAContext> {
       Tensor<CUDAContext>* hiddenOutput = nullptr,
       Tensor<CUDAContext>* cellOutput = nullptr);
 
+  // Inference on small batches uses the persistent cuDNN kernel, which keeps
+  // the recurrent weights on chip across timesteps instead of launching
+  // kernels per timestep. Larger batches use the standard algorithm.
+  bool usePersistentAlgo(int batchSize) const;
+
   CuDNNWrapper cudnn_wrapper_;
   cudnnDropoutDescriptor_t dropoutDesc_;
   cudnnRNNDescriptor_t rnnDesc_;
@@ -60,24 +65,32 @@ class RecurrentBaseOp : public Operator<CUDAContext> {
   size_t reserveNbytes_;
   size_t cudnnWsNbytes_;
 
+  const int persistentMaxBatchSize_;
+  // Set when the device or the shape is not supported by the persistent
+  // kernel
+  bool persistentUnsupported_ = false;
+  bool persistent_ = false;
+
  private:
 };
 
-#define USE_RECURRENT_BASE_FUNCTIONS          \
-  USE_OPERATOR_FUNCTIONS(CUDAContext);        \
-  using RecurrentBaseOp<T>::cudnn_wrapper_;   \
-  using RecurrentBaseOp<T>::dropoutDesc_;     \
-  using RecurrentBaseOp<T>::rnnDesc_;         \
-  using RecurrentBaseOp<T>::wDesc_;           \
-  using RecurrentBaseOp<T>::hxDesc_;          \
-  using RecurrentBaseOp<T>::cxDesc_;          \
-  using RecurrentBaseOp<T>::hyDesc_;          \
-  using RecurrentBaseOp<T>::cyDesc_;          \
-  using RecurrentBaseOp<T>::xDesc_;           \
-  using RecurrentBaseOp<T>::yDesc_;           \
-  using RecurrentBaseOp<T>::cachedInputDims_; \
-  using RecurrentBaseOp<T>::reserveNbytes_;   \
-  using RecurrentBaseOp<T>::cudnnWsNbytes_;   \
+#define USE_RECURRENT_BASE_FUNCTIONS                \
+  USE_OPERATOR_FUNCTIONS(CUDAContext);              \
+  using RecurrentBaseOp<T>::cudnn_wrapper_;         \
+  using RecurrentBaseOp<T>::dropoutDesc_;           \
+  using RecurrentBaseOp<T>::rnnDesc_;               \
+  using RecurrentBaseOp<T>::wDesc_;                 \
+  using RecurrentBaseOp<T>::hxDesc_;                \
+  using RecurrentBaseOp<T>::cxDesc_;                \
+  using RecurrentBaseOp<T>::hyDesc_;                \
+  using RecurrentBaseOp<T>::cyDesc_;                \
+  using RecurrentBaseOp<T>::xDesc_;                 \
+  using RecurrentBaseOp<T>::yDesc_;                 \
+  using RecurrentBaseOp<T>::cachedInputDims_;       \
+  using RecurrentBaseOp<T>::reserveNbytes_;         \
+  using RecurrentBaseOp<T>::cudnnWsNbytes_;         \
+  using RecurrentBaseOp<T>::persistentUnsupported_; \
+  using RecurrentBaseOp<T>::persistent_;            \
   using RecurrentBaseOp<T>::initialize;
 
 template <typename T>
@@ -80,11 +80,21 @@ __device__ void bilinear_interpolate_gradient(
   return;
 }
 
+// Number of threads of a block of RoIAlignBackwardFeature.
+constexpr int kRoIAlignBackwardThreads = 256;
+// Size of the shared memory tile of RoIAlignBackwardFeature, in elements.
+constexpr int kRoIAlignBackwardTileSize = 48 * 48;
+
+// Block i computes the gradient of channel c = i % channels of RoI
+// n = i / channels. The samples of the bins of a RoI overlap a lot (each
+// pixel gets the contributions of up to 4 samples of each bin around it), so
+// they are accumulated in a shared memory tile covering the RoI first, and
+// the tile is then added to bottom_diff with one atomic per pixel. RoIs too
+// large for the tile are accumulated in bottom_diff directly.
 template <typename T>
 __global__ void RoIAlignBackwardFeature(
-    const int nthreads,
-    const T* top_diff,
     const int num_rois,
+    const T* top_diff,
     const T spatial_scale,
     const int channels,
     const int height,
@@ -94,12 +104,11 @@ __global__ void RoIAlignBackwardFeature(
     const int sampling_ratio,
     T* bottom_diff,
     const T* bottom_rois) {
-  CUDA_1D_KERNEL_LOOP(index, nthreads) {
-    // (n, c, ph, pw) is an element in the pooled output
-    int pw = index % pooled_width;
-    int ph = (index / pooled_width) % pooled_height;
-    int c = (index / pooled_width / pooled_height) % channels;
-    int n = index / pooled_width / pooled_height / channels;
+  __shared__ T tile[kRoIAlignBackwardTileSize];
+  for (int block = blockIdx.x; block < num_rois * channels;
+       block += gridDim.x) {
+    int c = block % channels;
+    int n = block / channels;
 
     const T* offset_bottom_rois = bottom_rois + n * 5;
     int roi_batch_ind = offset_bottom_rois[0];
@@ -109,10 +118,6 @@ __global__ void RoIAlignBackwardFeature(
     T roi_start_h = offset_bottom_rois[2] * spatial_scale;
     T roi_end_w = offset_bottom_rois[3] * spatial_scale;
     T roi_end_h = offset_bottom_rois[4] * spatial_scale;
-    // T roi_start_w = round(offset_bottom_rois[1] * spatial_scale);
-    // T roi_start_h = round(offset_bottom_rois[2] * spatial_scale);
-    // T roi_end_w = round(offset_bottom_rois[3] * spatial_scale);
-    // T roi_end_h = round(offset_bottom_rois[4] * spatial_scale);
 
     // Force malformed ROIs to be 1x1
     T roi_width = max(roi_end_w - roi_start_w, (T)1.);
@@ -125,7 +130,6 @@ __global__ void RoIAlignBackwardFeature(
 
     int top_offset = (n * channels + c) * pooled_height * pooled_width;
     const T* offset_top_diff = top_diff + top_offset;
-    const T top_diff_this_bin = offset_top_diff[ph * pooled_width + pw];
 
     // We use roi_bin_grid to sample the grid and mimic integral
     int roi_bin_grid_h = (sampling_ratio > 0)
@@ -137,52 +141,107 @@ __global__ void RoIAlignBackwardFeature(
     // We do average (integral) pooling inside a bin
     const T count = roi_bin_grid_h * roi_bin_grid_w; // e.g. = 4
 
-    for (int iy = 0; iy < roi_bin_grid_h; iy++) // e.g., iy = 0, 1
-    {
-      const T y = roi_start_h + ph * bin_size_h +
-          static_cast<T>(iy + .5f) * bin_size_h /
-              static_cast<T>(roi_bin_grid_h); // e.g., 0.5, 1.5
-      for (int ix = 0; ix < roi_bin_grid_w; ix++) {
-        const T x = roi_start_w + pw * bin_size_w +
-            static_cast<T>(ix + .5f) * bin_size_w /
-                static_cast<T>(roi_bin_grid_w);
-
-        T w1, w2, w3, w4;
-        int x_low, x_high, y_low, y_high;
-
-        bilinear_interpolate_gradient(
-            height,
-            width,
-            y,
-            x,
-            w1,
-            w2,
-            w3,
-            w4,
-            x_low,
-            x_high,
-            y_low,
-            y_high,
-            index);
-
-        T g1 = top_diff_this_bin * w1 / count;
-        T g2 = top_diff_this_bin * w2 / count;
-        T g3 = top_diff_this_bin * w3 / count;
-        T g4 = top_diff_this_bin * w4 / count;
-
-        if (x_low >= 0 && x_high >= 0 && y_low >= 0 && y_high >= 0) {
-          gpu_atomic_add(
-              static_cast<T>(g1), offset_bottom_diff + y_low * width + x_low);
-          gpu_atomic_add(
-              static_cast<T>(g2), offset_bottom_diff + y_low * width + x_high);
+    // Pixels that the samples of the RoI can reach, see
+    // bilinear_interpolate_gradient()
+    int tile_y0 = min(max((int)floor(max(roi_start_h, (T)0.)), 0), height - 1);
+    int tile_y1 =
+        min((int)floor(max(roi_start_h + roi_height, (T)0.)) + 1, height - 1);
+    int tile_x0 = min(max((int)floor(max(roi_start_w, (T)0.)), 0), width - 1);
+    int tile_x1 =
+        min((int)floor(max(roi_start_w + roi_width, (T)0.)) + 1, width - 1);
+    int tile_h = tile_y1 - tile_y0 + 1;
+    int tile_w = tile_x1 - tile_x0 + 1;
+    const bool use_tile = tile_h * tile_w <= kRoIAlignBackwardTileSize;
+
+    if (use_tile) {
+      for (int i = threadIdx.x; i < tile_h * tile_w; i += blockDim.x) {
+        tile[i] = 0.;
+      }
+      __syncthreads();
+    }
+
+    for (int bin = threadIdx.x; bin < pooled_height * pooled_width;
+         bin += blockDim.x) {
+      int pw = bin % pooled_width;
+      int ph = bin / pooled_width;
+      const T top_diff_this_bin = offset_top_diff[bin];
+
+      for (int iy = 0; iy < roi_bin_grid_h; iy++) // e.g., iy = 0, 1
+      {
+        const T y = roi_start_h + ph * bin_size_h +
+            static_cast<T>(iy + .5f) * bin_size_h /
+                static_cast<T>(roi_bin_grid_h); // e.g., 0.5, 1.5
+        for (int ix = 0; ix < roi_bin_grid_w; ix++) {
+          const T x = roi_start_w + pw * bin_size_w +
+              static_cast<T>(ix + .5f) * bin_size_w /
+                  static_cast<T>(roi_bin_grid_w);
+
+          T w1, w2, w3, w4;
+          int x_low, x_high, y_low, y_high;
+
+          bilinear_interpolate_gradient(
+              height,
+              width,
+              y,
+              x,
+              w1,
+              w2,
+              w3,
+              w4,
+              x_low,
+              x_high,
+              y_low,
+              y_high,
+              bin);
+
+          T g1 = top_diff_this_bin * w1 / count;
+          T g2 = top_diff_this_bin * w2 / count;
+          T g3 = top_diff_this_bin * w3 / count;
+          T g4 = top_diff_this_bin * w4 / count;
+
+          if (x_low >= 0 && x_high >= 0 && y_low >= 0 && y_high >= 0) {
+            if (use_tile) {
+              y_low -= tile_y0;
+              y_high -= tile_y0;
+              x_low -= tile_x0;
+              x_high -= tile_x0;
+              atomicAdd(tile + y_low * tile_w + x_low, g1);
+              atomicAdd(tile + y_low * tile_w + x_high, g2);
+              atomicAdd(tile + y_high * tile_w + x_low, g3);
+              atomicAdd(tile + y_high * tile_w + x_high, g4);
+            } else {
+              gpu_atomic_add(
+                  static_cast<T>(g1),
+                  offset_bottom_diff + y_low * width + x_low);
+              gpu_atomic_add(
+                  static_cast<T>(g2),
+                  offset_bottom_diff + y_low * width + x_high);
+              gpu_atomic_add(
+                  static_cast<T>(g3),
+                  offset_bottom_diff + y_high * width + x_low);
+              gpu_atomic_add(
+                  static_cast<T>(g4),
+                  offset_bottom_diff + y_high * width + x_high);
+            }
+          } // if
+        } // ix
+      } // iy
+    } // bin
+
+    if (use_tile) {
+      __syncthreads();
+      for (int i = threadIdx.x; i < tile_h * tile_w; i += blockDim.x) {
+        if (tile[i] != 0) {
           gpu_atomic_add(
-              static_cast<T>(g3), offset_bottom_diff + y_high * width + x_low);
-          gpu_atomic_add(
-              static_cast<T>(g4), offset_bottom_diff + y_high * width + x_high);
-        } // if
-      } // ix
-    } // iy
-  } // CUDA_1D_KERNEL_LOOP
+              tile[i],
+              offset_bottom_diff + (tile_y0 + i / tile_w) * width + tile_x0 +
+                  i % tile_w);
+        }
+      }
+      // The tile is reused by the next RoI of the block
+      __syncthreads();
+    }
+  } // block
 } // RoIAlignBackward
 
 } // namespace
@@ -204,14 +263,12 @@ bool RoIAlignGradientOp<float, CUDAContext>::RunOnDevice() {
       dX->size(), 0.f, dX->mutable_data<float>(), &context_);
 
   if (dY.size() > 0) { // Handle possibly empty gradient if there were no rois
+    const int num_blocks =
+        std::min(R.dim32(0) * X.dim32(1), CAFFE_MAXIMUM_NUM_BLOCKS);
     RoIAlignBackwardFeature<float>
-        <<<CAFFE_GET_BLOCKS(dY.size()),
-           CAFFE_CUDA_NUM_THREADS,
-           0,
-           context_.cuda_stream()>>>(
-            dY.size(),
-            dY.data<float>(),
+        <<<num_blocks, kRoIAlignBackwardThreads, 0, context_.cuda_stream()>>>(
             R.dim32(0),
+            dY.data<float>(),
             spatial_scale_,
             X.dim32(1),
             X.dim32(2),
@@ -3,19 +3,24 @@
 #include <stdio.h>
 #include <cfloat>
 #include "caffe2/core/context_gpu.h"
+#include "caffe2/utils/conversions.h"
 #include "caffe2/utils/math.h"
 
 namespace caffe2 {
 
 namespace {
 
+// T is the type of the features, the interpolation is computed in float.
+// For NHWC features, bottom_data points to the channel to interpolate and
+// stride is the number of channels.
 template <typename T>
-__device__ T bilinear_interpolate(
+__device__ float bilinear_interpolate(
     const T* bottom_data,
     const int height,
     const int width,
-    T y,
-    T x,
+    const int stride,
+    float y,
+    float x,
     const int index /* index for debug only*/) {
   // deal with cases that inverse elements are out of feature map boundary
   if (y < -1.0 || y > height || x < -1.0 || x > width) {
@@ -37,45 +42,106 @@ __device__ T bilinear_interpolate(
 
   if (y_low >= height - 1) {
     y_high = y_low = height - 1;
-    y = (T)y_low;
+    y = (float)y_low;
   } else {
     y_high = y_low + 1;
   }
 
   if (x_low >= width - 1) {
     x_high = x_low = width - 1;
-    x = (T)x_low;
+    x = (float)x_low;
   } else {
     x_high = x_low + 1;
   }
 
-  T ly = y - y_low;
-  T lx = x - x_low;
-  T hy = 1. - ly, hx = 1. - lx;
+  float ly = y - y_low;
+  float lx = x - x_low;
+  float hy = 1. - ly, hx = 1. - lx;
   // do bilinear interpolation
-  T v1 = bottom_data[y_low * width + x_low];
-  T v2 = bottom_data[y_low * width + x_high];
-  T v3 = bottom_data[y_high * width + x_low];
-  T v4 = bottom_data[y_high * width + x_high];
-  T w1 = hy * hx, w2 = hy * lx, w3 = ly * hx, w4 = ly * lx;
+  float v1 =
+      convert::To<T, float>(bottom_data[(y_low * width + x_low) * stride]);
+  float v2 =
+      convert::To<T, float>(bottom_data[(y_low * width + x_high) * stride]);
+  float v3 =
+      convert::To<T, float>(bottom_data[(y_high * width + x_low) * stride]);
+  float v4 =
+      convert::To<T, float>(bottom_data[(y_high * width + x_high) * stride]);
+  float w1 = hy * hx, w2 = hy * lx, w3 = ly * hx, w4 = ly * lx;
 
-  T val = (w1 * v1 + w2 * v2 + w3 * v3 + w4 * v4);
+  float val = (w1 * v1 + w2 * v2 + w3 * v3 + w4 * v4);
 
   return val;
 }
 
+// Average of the samples of bin (ph, pw) of a RoI, for one channel of the
+// features of its image.
+template <typename T>
+__device__ float roi_align_bin(
+    const T* offset_bottom_data,
+    const int stride,
+    const float* offset_bottom_rois,
+    const float spatial_scale,
+    const int height,
+    const int width,
+    const int pooled_height,
+    const int pooled_width,
+    const int sampling_ratio,
+    const int ph,
+    const int pw,
+    const int index) {
+  // Do not using rounding; this implementation detail is critical
+  float roi_start_w = offset_bottom_rois[1] * spatial_scale;
+  float roi_start_h = offset_bottom_rois[2] * spatial_scale;
+  float roi_end_w = offset_bottom_rois[3] * spatial_scale;
+  float roi_end_h = offset_bottom_rois[4] * spatial_scale;
+
+  // Force malformed ROIs to be 1x1
+  float roi_width = max(roi_end_w - roi_start_w, 1.f);
+  float roi_height = max(roi_end_h - roi_start_h, 1.f);
+  float bin_size_h = roi_height / static_cast<float>(pooled_height);
+  float bin_size_w = roi_width / static_cast<float>(pooled_width);
+
+  // We use roi_bin_grid to sample the grid and mimic integral
+  int roi_bin_grid_h = (sampling_ratio > 0)
+      ? sampling_ratio
+      : ceil(roi_height / pooled_height); // e.g., = 2
+  int roi_bin_grid_w =
+      (sampling_ratio > 0) ? sampling_ratio : ceil(roi_width / pooled_width);
+
+  // We do average (integral) pooling inside a bin
+  const float count = roi_bin_grid_h * roi_bin_grid_w; // e.g. = 4
+
+  float output_val = 0.;
+  for (int iy = 0; iy < roi_bin_grid_h; iy++) // e.g., iy = 0, 1
+  {
+    const float y = roi_start_h + ph * bin_size_h +
+        static_cast<float>(iy + .5f) * bin_size_h /
+            static_cast<float>(roi_bin_grid_h); // e.g., 0.5, 1.5
+    for (int ix = 0; ix < roi_bin_grid_w; ix++) {
+      const float x = roi_start_w + pw * bin_size_w +
+          static_cast<float>(ix + .5f) * bin_size_w /
+              static_cast<float>(roi_bin_grid_w);
+
+      float val = bilinear_interpolate(
+          offset_bottom_data, height, width, stride, y, x, index);
+      output_val += val;
+    }
+  }
+  return output_val / count;
+}
+
 template <typename T>
 __global__ void RoIAlignForward(
     const int nthreads,
     const T* bottom_data,
-    const T spatial_scale,
+    const float spatial_scale,
     const int channels,
     const int height,
     const int width,
     const int pooled_height,
     const int pooled_width,
     const int sampling_ratio,
-    const T* bottom_rois,
+    const float* bottom_rois,
     T* top_data) {
   CUDA_1D_KERNEL_LOOP(index, nthreads) {
     // (n, c, ph, pw) is an element in the pooled output
@@ -84,96 +150,177 @@ __global__ void RoIAlignForward(
     int c = (index / pooled_width / pooled_height) % channels;
     int n = index / pooled_width / pooled_height / channels;
 
-    const T* offset_bottom_rois = bottom_rois + n * 5;
+    const float* offset_bottom_rois = bottom_rois + n * 5;
     int roi_batch_ind = offset_bottom_rois[0];
 
-    // Do not using rounding; this implementation detail is critical
-    T roi_start_w = offset_bottom_rois[1] * spatial_scale;
-    T roi_start_h = offset_bottom_rois[2] * spatial_scale;
-    T roi_end_w = offset_bottom_rois[3] * spatial_scale;
-    T roi_end_h = offset_bottom_rois[4] * spatial_scale;
-    // T roi_start_w = round(offset_bottom_rois[1] * spatial_scale);
-    // T roi_start_h = round(offset_bottom_rois[2] * spatial_scale);
-    // T roi_end_w = round(offset_bottom_rois[3] * spatial_scale);
-    // T roi_end_h = round(offset_bottom_rois[4] * spatial_scale);
-
-    // Force malformed ROIs to be 1x1
-    T roi_width = max(roi_end_w - roi_start_w, (T)1.);
-    T roi_height = max(roi_end_h - roi_start_h, (T)1.);
-    T bin_size_h = static_cast<T>(roi_height) / static_cast<T>(pooled_height);
-    T bin_size_w = static_cast<T>(roi_width) / static_cast<T>(pooled_width);
-
     const T* offset_bottom_data =
         bottom_data + (roi_batch_ind * channels + c) * height * width;
 
-    // We use roi_bin_grid to sample the grid and mimic integral
-    int roi_bin_grid_h = (sampling_ratio > 0)
-        ? sampling_ratio
-        : ceil(roi_height / pooled_height); // e.g., = 2
-    int roi_bin_grid_w =
-        (sampling_ratio > 0) ? sampling_ratio : ceil(roi_width / pooled_width);
-
-    // We do average (integral) pooling inside a bin
-    const T count = roi_bin_grid_h * roi_bin_grid_w; // e.g. = 4
-
-    T output_val = 0.;
-    for (int iy = 0; iy < roi_bin_grid_h; iy++) // e.g., iy = 0, 1
-    {
-      const T y = roi_start_h + ph * bin_size_h +
-          static_cast<T>(iy + .5f) * bin_size_h /
-              static_cast<T>(roi_bin_grid_h); // e.g., 0.5, 1.5
-      for (int ix = 0; ix < roi_bin_grid_w; ix++) {
-        const T x = roi_start_w + pw * bin_size_w +
-            static_cast<T>(ix + .5f) * bin_size_w /
-                static_cast<T>(roi_bin_grid_w);
-
-        T val = bilinear_interpolate(
-            offset_bottom_data, height, width, y, x, index);
-        output_val += val;
-      }
-    }
-    output_val /= count;
+    top_data[index] = convert::To<float, T>(roi_align_bin(
+        offset_bottom_data,
+        1,
+        offset_bottom_rois,
+        spatial_scale,
+        height,
+        width,
+        pooled_height,
+        pooled_width,
+        sampling_ratio,
+        ph,
+        pw,
+        index));
+  }
+}
+
+// Same as RoIAlignForward for NHWC features and output. Consecutive threads
+// compute consecutive channels of the same bin, so their loads of the
+// features are coalesced.
+template <typename T>
+__global__ void RoIAlignForwardNHWC(
+    const int nthreads,
+    const T* bottom_data,
+    const float spatial_scale,
+    const int channels,
+    const int height,
+    const int width,
+    const int pooled_height,
+    const int pooled_width,
+    const int sampling_ratio,
+    const float* bottom_rois,
+    T* top_data) {
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    // (n, ph, pw, c) is an element in the pooled output
+    int c = index % channels;
+    int pw = (index / channels) % pooled_width;
+    int ph = (index / channels / pooled_width) % pooled_height;
+    int n = index / channels / pooled_width / pooled_height;
 
-    top_data[index] = output_val;
+    const float* offset_bottom_rois = bottom_rois + n * 5;
+    int roi_batch_ind = offset_bottom_rois[0];
+
+    const T* offset_bottom_data =
+        bottom_data + roi_batch_ind * height * width * channels + c;
+
+    top_data[index] = convert::To<float, T>(roi_align_bin(
+        offset_bottom_data,
+        channels,
+        offset_bottom_rois,
+        spatial_scale,
+        height,
+        width,
+        pooled_height,
+        pooled_width,
+        sampling_ratio,
+        ph,
+        pw,
+        index));
+  }
+}
+
+template <typename T>
+void RoIAlignForwardWithType(
+    const TensorCUDA& X,
+    const TensorCUDA& R,
+    const StorageOrder order,
+    const float spatial_scale,
+    const int pooled_height,
+    const int pooled_width,
+    const int sampling_ratio,
+    TensorCUDA* Y,
+    CUDAContext* context) {
+  int output_size = Y->size();
+  if (order == StorageOrder::NCHW) {
+    RoIAlignForward<T>
+        <<<CAFFE_GET_BLOCKS(output_size),
+           CAFFE_CUDA_NUM_THREADS,
+           0,
+           context->cuda_stream()>>>(
+            output_size,
+            X.data<T>(),
+            spatial_scale,
+            X.dim32(1),
+            X.dim32(2),
+            X.dim32(3),
+            pooled_height,
+            pooled_width,
+            sampling_ratio,
+            R.data<float>(),
+            Y->mutable_data<T>());
+  } else {
+    RoIAlignForwardNHWC<T>
+        <<<CAFFE_GET_BLOCKS(output_size),
+           CAFFE_CUDA_NUM_THREADS,
+           0,
+           context->cuda_stream()>>>(
+            output_size,
+            X.data<T>(),
+            spatial_scale,
+            X.dim32(3),
+            X.dim32(1),
+            X.dim32(2),
+            pooled_height,
+            pooled_width,
+            sampling_ratio,
+            R.data<float>(),
+            Y->mutable_data<T>());
   }
 }
 
 } // namespace
 
+// The features may be float or float16, the RoIs are always float.
 template <>
 bool RoIAlignOp<float, CUDAContext>::RunOnDevice() {
   auto& X = Input(0); // Input data to pool
   auto& R = Input(1); // RoIs
   auto* Y = Output(0); // RoI pooled data
 
+  const int channels = order_ == StorageOrder::NCHW ? X.dim32(1) : X.dim32(3);
   if (R.size() == 0) {
     // Handle empty rois
-    Y->Resize(0, X.dim32(1), pooled_height_, pooled_width_);
+    if (order_ == StorageOrder::NCHW) {
+      Y->Resize(0, channels, pooled_height_, pooled_width_);
+    } else {
+      Y->Resize(0, pooled_height_, pooled_width_, channels);
+    }
     // The following mutable_data calls are needed to allocate the tensors
-    Y->mutable_data<float>();
+    Y->raw_mutable_data(X.meta());
     return true;
   }
 
+  CAFFE_ENFORCE(R.IsType<float>(), "RoIs must be float: ", R.meta().name());
   assert(sampling_ratio_ >= 0);
 
-  Y->Resize(R.dim32(0), X.dim32(1), pooled_height_, pooled_width_);
-  int output_size = Y->size();
-  RoIAlignForward<float>
-      <<<CAFFE_GET_BLOCKS(output_size),
-         CAFFE_CUDA_NUM_THREADS,
-         0,
-         context_.cuda_stream()>>>(
-          output_size,
-          X.data<float>(),
-          spatial_scale_,
-          X.dim32(1),
-          X.dim32(2),
-          X.dim32(3),
-          pooled_height_,
-          pooled_width_,
-          sampling_ratio_,
-          R.data<float>(),
-          Y->mutable_data<float>());
+  if (order_ == StorageOrder::NCHW) {
+    Y->Resize(R.dim32(0), channels, pooled_height_, pooled_width_);
+  } else {
+    Y->Resize(R.dim32(0), pooled_height_, pooled_width_, channels);
+  }
+  if (X.IsType<float>()) {
+    RoIAlignForwardWithType<float>(
+        X,
+        R,
+        order_,
+        spatial_scale_,
+        pooled_height_,
+        pooled_width_,
+        sampling_ratio_,
+        Y,
+        &context_);
+  } else if (X.IsType<float16>()) {
+    RoIAlignForwardWithType<float16>(
+        X,
+        R,
+        order_,
+        spatial_scale_,
+        pooled_height_,
+        pooled_width_,
+        sampling_ratio_,
+        Y,
+        &context_);
+  } else {
+    CAFFE_THROW("Unsupported input type: ", X.meta().name());
+  }
   return true;
 }
 
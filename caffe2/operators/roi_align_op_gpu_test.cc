@@ -198,6 +198,7 @@ TEST(RoiAlignTest, CheckCPUGPUEqual) {
   TensorCPU y_cpu;
   TensorCPU y_gpu;
   TensorCPU y_cpu_nhwc;
+  TensorCPU y_gpu_nhwc;
 
   // tests using FAIR example
   {
@@ -205,13 +206,17 @@ TEST(RoiAlignTest, CheckCPUGPUEqual) {
     CreateAndRun<CPUContext>(&y_cpu, "NCHW", test_params, false);
     CreateAndRun<CUDAContext>(&y_gpu, "NCHW", test_params, false);
     CreateAndRun<CPUContext>(&y_cpu_nhwc, "NHWC", test_params, false);
+    CreateAndRun<CUDAContext>(&y_gpu_nhwc, "NHWC", test_params, false);
 
     EXPECT_EQ(y_cpu.dims(), y_gpu.dims());
     EXPECT_EQ(y_cpu.dims(), y_cpu_nhwc.dims());
+    EXPECT_EQ(y_cpu.dims(), y_gpu_nhwc.dims());
     ConstEigenVectorMap<float> y_cpu_vec(y_cpu.data<float>(), y_cpu.size());
     ConstEigenVectorMap<float> y_gpu_vec(y_gpu.data<float>(), y_gpu.size());
     ConstEigenVectorMap<float> y_cpu_nhwc_vec(
         y_cpu_nhwc.data<float>(), y_cpu_nhwc.size());
+    ConstEigenVectorMap<float> y_gpu_nhwc_vec(
+        y_gpu_nhwc.data<float>(), y_gpu_nhwc.size());
     int max_diff_idx = -1;
     (y_cpu_vec - y_gpu_vec).cwiseAbs().maxCoeff(&max_diff_idx);
     EXPECT_FLOAT_EQ(y_cpu_vec[max_diff_idx], y_gpu_vec[max_diff_idx]);
@@ -219,6 +224,10 @@ TEST(RoiAlignTest, CheckCPUGPUEqual) {
     max_diff_idx = -1;
     (y_cpu_vec - y_cpu_nhwc_vec).cwiseAbs().maxCoeff(&max_diff_idx);
     EXPECT_FLOAT_EQ(y_cpu_vec[max_diff_idx], y_cpu_nhwc_vec[max_diff_idx]);
+
+    max_diff_idx = -1;
+    (y_cpu_vec - y_gpu_nhwc_vec).cwiseAbs().maxCoeff(&max_diff_idx);
+    EXPECT_FLOAT_EQ(y_cpu_vec[max_diff_idx], y_gpu_nhwc_vec[max_diff_idx]);
   }
 
   // random tests
@@ -246,13 +255,17 @@ TEST(RoiAlignTest, CheckCPUGPUEqual) {
     CreateAndRun<CPUContext>(&y_cpu, "NCHW", test_params, true);
     CreateAndRun<CUDAContext>(&y_gpu, "NCHW", test_params, true);
     CreateAndRun<CPUContext>(&y_cpu_nhwc, "NHWC", test_params, true);
+    CreateAndRun<CUDAContext>(&y_gpu_nhwc, "NHWC", test_params, true);
 
     EXPECT_EQ(y_cpu.dims(), y_gpu.dims());
     EXPECT_EQ(y_cpu.dims(), y_cpu_nhwc.dims());
+    EXPECT_EQ(y_cpu.dims(), y_gpu_nhwc.dims());
     ConstEigenVectorMap<float> y_cpu_vec(y_cpu.data<float>(), y_cpu.size());
     ConstEigenVectorMap<float> y_gpu_vec(y_gpu.data<float>(), y_gpu.size());
     ConstEigenVectorMap<float> y_cpu_nhwc_vec(
         y_cpu_nhwc.data<float>(), y_cpu_nhwc.size());
+    ConstEigenVectorMap<float> y_gpu_nhwc_vec(
+        y_gpu_nhwc.data<float>(), y_gpu_nhwc.size());
     int max_diff_idx = -1;
     (y_cpu_vec - y_gpu_vec).cwiseAbs().maxCoeff(&max_diff_idx);
     EXPECT_FLOAT_EQ(y_cpu_vec[max_diff_idx], y_gpu_vec[max_diff_idx]);
@@ -260,6 +273,10 @@ TEST(RoiAlignTest, CheckCPUGPUEqual) {
     max_diff_idx = -1;
     (y_cpu_vec - y_cpu_nhwc_vec).cwiseAbs().maxCoeff(&max_diff_idx);
     EXPECT_FLOAT_EQ(y_cpu_vec[max_diff_idx], y_cpu_nhwc_vec[max_diff_idx]);
+
+    max_diff_idx = -1;
+    (y_cpu_vec - y_gpu_nhwc_vec).cwiseAbs().maxCoeff(&max_diff_idx);
+    EXPECT_FLOAT_EQ(y_cpu_vec[max_diff_idx], y_gpu_nhwc_vec[max_diff_idx]);
   }
 }
 
@@ -1,6 +1,8 @@
 #ifndef CAFFE2_OPERATORS_SEGMENT_REDUCTION_OP_H_
 #define CAFFE2_OPERATORS_SEGMENT_REDUCTION_OP_H_
 
+#include <numeric>
+
 #include "caffe2/core/context.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/operator.h"
@@ -8,6 +10,25 @@
 
 namespace caffe2 {
 
+namespace detail {
+
+// The smallest number of input elements that are reduced by a thread
+constexpr TIndex kSegmentReductionParallelGrain = 16384;
+
+// The number of segments of a chunk of ParallelFor, so that a chunk reduces
+// about kSegmentReductionParallelGrain input elements on average
+inline size_t SegmentReductionGrain(
+    TIndex num_segments,
+    TIndex num_rows,
+    TIndex block_size) {
+  const TIndex segment_size = std::max<TIndex>(num_rows, 1) *
+      std::max<TIndex>(block_size, 1) / std::max<TIndex>(num_segments, 1);
+  return kSegmentReductionParallelGrain / std::max<TIndex>(segment_size, 1) +
+      1;
+}
+
+} // namespace detail
+
 template <typename TData>
 class BaseInputAccessor {
  public:
@@ -676,36 +697,51 @@ class AbstractSortedSegmentOp : public Operator<Context> {
 
     // Assume the segments are sorted and there are no gaps
     CAFFE_ENFORCE_EQ(0, s_ids[0], "Indices must be sorted and not have gaps");
-    for (TIndex i = 0; i < N;) {
-      TIndex start = i;
-
-      Reducer r(ctx, out + out_block_size * s_ids[start], &context_);
-      for (; i < N && s_ids[start] == s_ids[i]; ++i) {
-        IndexType idx;
-        if (SparseFused) { // static if
-          CAFFE_ENFORCE(
-              0 <= idxs[i] && idxs[i] < M,
-              "Index out of bounds: ",
-              idxs[i],
-              ", range 0 to ",
-              M);
-          idx = idxs[i];
-        } else {
-          idx = i;
-        }
-        r.template process<FixedSize>(
-            ctx, inputAccessor_.getBlockPtr(in_block_size, idx), i, &context_);
-      }
-
-      r.template finish<FixedSize>(ctx, &context_);
-      // check correctness of the next segment
-      if (i < N) {
+    // Find where each segment starts, so that the segments can be reduced
+    // independently
+    offsets_.clear();
+    offsets_.push_back(0);
+    for (TIndex i = 1; i < N; ++i) {
+      if (s_ids[i] != s_ids[i - 1]) {
+        // check correctness of the next segment
         CAFFE_ENFORCE_EQ(
-            s_ids[start] + 1,
+            s_ids[i - 1] + 1,
             s_ids[i],
             "Indices must be sorted and not have gaps");
+        offsets_.push_back(i);
       }
     }
+    offsets_.push_back(N);
+
+    ParallelFor(
+        this->IntraOpThreadPool(),
+        K,
+        detail::SegmentReductionGrain(K, N, in_block_size),
+        [&](size_t begin, size_t end) {
+          for (TIndex s_id = begin; s_id < end; ++s_id) {
+            Reducer r(ctx, out + out_block_size * s_id, &context_);
+            for (TIndex i = offsets_[s_id]; i < offsets_[s_id + 1]; ++i) {
+              IndexType idx;
+              if (SparseFused) { // static if
+                CAFFE_ENFORCE(
+                    0 <= idxs[i] && idxs[i] < M,
+                    "Index out of bounds: ",
+                    idxs[i],
+                    ", range 0 to ",
+                    M);
+                idx = idxs[i];
+              } else {
+                idx = i;
+              }
+              r.template process<FixedSize>(
+                  ctx,
+                  inputAccessor_.getBlockPtr(in_block_size, idx),
+                  i,
+                  &context_);
+            }
+            r.template finish<FixedSize>(ctx, &context_);
+          }
+        });
     return true;
   }
 
@@ -718,6 +754,8 @@ class AbstractSortedSegmentOp : public Operator<Context> {
 
  private:
   InputAccessor inputAccessor_;
+  // member field to reuse memory
+  vector<TIndex> offsets_;
 };
 
 // Gradient actually doesn't depend on whether sparse lookup is fused or not
@@ -1084,12 +1122,10 @@ class AbstractUnsortedSegmentOp : public Operator<Context> {
     TIndex out_block_size = output->size_from_dim(1);
     T* out = output->template mutable_data<T>();
 
-    reducers_.clear();
-    reducers_.reserve(K);
-    for (TIndex i = 0; i < K; ++i) {
-      reducers_.emplace_back(ctx, out + out_block_size * i, &context_);
-    }
-
+    // Group the rows by segment with a counting sort, so that each segment is
+    // reduced by a single thread and in the order of its rows, as when
+    // reducing them sequentially
+    offsets_.assign(K + 1, 0);
     for (TIndex i = 0; i < N; ++i) {
       auto s_id = s_ids[i];
       CAFFE_ENFORCE(
@@ -1098,27 +1134,49 @@ class AbstractUnsortedSegmentOp : public Operator<Context> {
           s_id,
           ", range 0 to ",
           K);
-      IndexType idx;
-      if (SparseFused) { // static if
-        CAFFE_ENFORCE(
-            0 <= idxs[i] && idxs[i] < M,
-            "Index out of bounds: ",
-            idxs[i],
-            ", range 0 to ",
-            M);
-        idx = idxs[i];
-      } else {
-        idx = i;
-      }
-      reducers_[s_id].template process<FixedSize>(
-          ctx, inputAccessor_.getBlockPtr(in_block_size, idx), i, &context_);
+      ++offsets_[s_id + 1];
     }
-
-    for (TIndex i = 0; i < K; ++i) {
-      reducers_[i].template finish<FixedSize>(ctx, &context_);
+    std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+    rows_.resize(N);
+    for (TIndex i = 0; i < N; ++i) {
+      rows_[offsets_[s_ids[i]]++] = i;
     }
-    // call reducers destructors (if there is any)
-    reducers_.clear();
+    // offsets_[k] is now the end of segment k, shift it back to its start
+    for (TIndex k = K; k > 0; --k) {
+      offsets_[k] = offsets_[k - 1];
+    }
+    offsets_[0] = 0;
+
+    ParallelFor(
+        this->IntraOpThreadPool(),
+        K,
+        detail::SegmentReductionGrain(K, N, in_block_size),
+        [&](size_t begin, size_t end) {
+          for (TIndex s_id = begin; s_id < end; ++s_id) {
+            Reducer r(ctx, out + out_block_size * s_id, &context_);
+            for (TIndex j = offsets_[s_id]; j < offsets_[s_id + 1]; ++j) {
+              const TIndex i = rows_[j];
+              IndexType idx;
+              if (SparseFused) { // static if
+                CAFFE_ENFORCE(
+                    0 <= idxs[i] && idxs[i] < M,
+                    "Index out of bounds: ",
+                    idxs[i],
+                    ", range 0 to ",
+                    M);
+                idx = idxs[i];
+              } else {
+                idx = i;
+              }
+              r.template process<FixedSize>(
+                  ctx,
+                  inputAccessor_.getBlockPtr(in_block_size, idx),
+                  i,
+                  &context_);
+            }
+            r.template finish<FixedSize>(ctx, &context_);
+          }
+        });
     return true;
   }
 
@@ -1131,8 +1189,9 @@ class AbstractUnsortedSegmentOp : public Operator<Context> {
 
  private:
   TIndex num_segments_;
-  // member field to reuse memory
-  vector<Reducer> reducers_;
+  // member fields to reuse memory
+  vector<TIndex> offsets_;
+  vector<TIndex> rows_;
   InputAccessor inputAccessor_;
 };
 
@@ -1462,43 +1521,69 @@ class AbstractLengthsOp : public Operator<Context> {
     TIndex out_block_size = output->size_from_dim(1);
     TData* out = output->template mutable_data<TData>();
 
-    TIndex dataIndex = 0;
+    // Where each range starts in the data to reduce, so that the ranges can
+    // be reduced independently
+    offsets_.resize(outputSize + 1);
+    offsets_[0] = 0;
     for (TIndex rangeIndex = 0; rangeIndex < outputSize; ++rangeIndex) {
-      Reducer reducer(ctx, out + out_block_size * rangeIndex, &context_);
-      for (TIndex start = dataIndex; dataIndex < start + lengths[rangeIndex];
-           ++dataIndex) {
-        IndexType idx;
-        if (SparseFused) { // static if
-          idx = indices[dataIndex];
-          CAFFE_ENFORCE(
-              0 <= idx && idx < dataSize,
-              "The ",
-              dataIndex,
-              "th index from the input indices is out of bounds: ",
-              idx,
-              " vs. valid range 0 to ",
-              dataSize);
-        } else {
-          idx = dataIndex;
-          CAFFE_ENFORCE(
-              0 <= idx && idx < dataSize,
-              "When calculating the ",
-              rangeIndex,
-              "th output with length=",
-              lengths[rangeIndex],
-              ", the index is out of bounds: ",
-              idx,
-              " vs. valid range 0 to ",
-              dataSize);
-        }
-
-        const TData* input = inputAccessor_.getBlockPtr(in_block_size, idx);
-        reducer.template process<FixedSize>(ctx, input, dataIndex, &context_);
-      }
-      reducer.template finish<FixedSize>(ctx, &context_);
+      CAFFE_ENFORCE_GE(
+          lengths[rangeIndex],
+          0,
+          "The ",
+          rangeIndex,
+          "th length is negative");
+      offsets_[rangeIndex + 1] = offsets_[rangeIndex] + lengths[rangeIndex];
     }
     CAFFE_ENFORCE(
-        dataIndex == dataToReduceSize, dataIndex, " != ", dataToReduceSize);
+        offsets_[outputSize] == dataToReduceSize,
+        offsets_[outputSize],
+        " != ",
+        dataToReduceSize);
+
+    ParallelFor(
+        this->IntraOpThreadPool(),
+        outputSize,
+        detail::SegmentReductionGrain(
+            outputSize, dataToReduceSize, in_block_size),
+        [&](size_t begin, size_t end) {
+          for (TIndex rangeIndex = begin; rangeIndex < end; ++rangeIndex) {
+            Reducer reducer(ctx, out + out_block_size * rangeIndex, &context_);
+            for (TIndex dataIndex = offsets_[rangeIndex];
+                 dataIndex < offsets_[rangeIndex + 1];
+                 ++dataIndex) {
+              IndexType idx;
+              if (SparseFused) { // static if
+                idx = indices[dataIndex];
+                CAFFE_ENFORCE(
+                    0 <= idx && idx < dataSize,
+                    "The ",
+                    dataIndex,
+                    "th index from the input indices is out of bounds: ",
+                    idx,
+                    " vs. valid range 0 to ",
+                    dataSize);
+              } else {
+                idx = dataIndex;
+                CAFFE_ENFORCE(
+                    0 <= idx && idx < dataSize,
+                    "When calculating the ",
+                    rangeIndex,
+                    "th output with length=",
+                    lengths[rangeIndex],
+                    ", the index is out of bounds: ",
+                    idx,
+                    " vs. valid range 0 to ",
+                    dataSize);
+              }
+
+              const TData* input =
+                  inputAccessor_.getBlockPtr(in_block_size, idx);
+              reducer.template process<FixedSize>(
+                  ctx, input, dataIndex, &context_);
+            }
+            reducer.template finish<FixedSize>(ctx, &context_);
+          }
+        });
 
     return true;
   }
@@ -1512,6 +1597,8 @@ class AbstractLengthsOp : public Operator<Context> {
 
  private:
   InputAccessor inputAccessor_;
+  // member field to reuse memory
+  vector<TIndex> offsets_;
 };
 
 /*
@@ -2006,6 +2093,16 @@ i.e. `len(LENGTHS)`. Other dimensions are inherited from the input tensor.
         "OUTPUT",
         "Aggregated output tensor. Has the first dimension of K "
         "(the number of segments).");
+    schema.Arg(
+        "hot_row_cache_size",
+        "(CPU only) If positive, the number of most frequently looked up rows "
+        "of DATA to keep in a contiguous cache, for skewed lookups. Hits and "
+        "misses are exported as hot_row_cache/<OUTPUT>/{hits,misses} stats. "
+        "Only for tables that are not updated while the op runs.");
+    schema.Arg(
+        "hot_row_cache_refresh_interval",
+        "(CPU only) Number of looked up indices after which the cached rows "
+        "are recomputed from the access counts (default 2^20)");
     ReducerDef::PopulateSchema(schema);
   }
   using Reducer = typename ReducerDef::template Reducer<T, Context>;
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "caffe2/core/flags.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+namespace {
+
+class SegmentReductionOpTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    enabled_ = FLAGS_caffe2_intra_op_parallelism;
+  }
+  void TearDown() override {
+    FLAGS_caffe2_intra_op_parallelism = enabled_;
+  }
+
+ private:
+  bool enabled_;
+};
+
+template <typename T>
+void AddInput(
+    const vector<TIndex>& shape,
+    const vector<T>& values,
+    const string& name,
+    Workspace* ws) {
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(shape);
+  std::copy(values.begin(), values.end(), tensor->mutable_data<T>());
+}
+
+// Fills the inputs of a segment reduction of 1000 rows of 64 elements, which
+// is enough work for every thread of the pool
+void AddInputs(Workspace* ws) {
+  const int kRows = 1000;
+  const int kBlockSize = 64;
+  const int kSegments = 37;
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> value(-1, 1);
+  std::uniform_int_distribution<int> segment(0, kSegments - 1);
+
+  vector<float> data(kRows * kBlockSize);
+  for (auto& v : data) {
+    v = value(gen);
+  }
+  AddInput<float>({kRows, kBlockSize}, data, "DATA", ws);
+
+  vector<float> weights(kRows);
+  for (auto& v : weights) {
+    v = value(gen);
+  }
+  AddInput<float>({kRows}, weights, "WEIGHTS", ws);
+
+  vector<int> segment_ids(kRows);
+  for (auto& v : segment_ids) {
+    v = segment(gen);
+  }
+  AddInput<int>({kRows}, segment_ids, "UNSORTED_IDS", ws);
+  std::sort(segment_ids.begin(), segment_ids.end());
+  AddInput<int>({kRows}, segment_ids, "SORTED_IDS", ws);
+
+  vector<int> lengths(kSegments, 0);
+  for (auto v : segment_ids) {
+    ++lengths[v];
+  }
+  AddInput<int>({kSegments}, lengths, "LENGTHS", ws);
+
+  vector<int64_t> indices(kRows);
+  std::uniform_int_distribution<int64_t> index(0, kRows - 1);
+  for (auto& v : indices) {
+    v = index(gen);
+  }
+  AddInput<int64_t>({kRows}, indices, "INDICES", ws);
+}
+
+vector<float> RunOp(
+    const string& type,
+    const vector<string>& inputs,
+    bool parallel) {
+  FLAGS_caffe2_intra_op_parallelism = parallel;
+  Workspace ws;
+  AddInputs(&ws);
+  OperatorDef def;
+  def.set_type(type);
+  for (const auto& input : inputs) {
+    def.add_input(input);
+  }
+  def.add_output("OUT");
+  auto op = CreateOperator(def, &ws);
+  EXPECT_NE(nullptr, op.get());
+  EXPECT_TRUE(op->Run());
+  const auto& out = ws.GetBlob("OUT")->Get<TensorCPU>();
+  return vector<float>(out.data<float>(), out.data<float>() + out.size());
+}
+
+// The segments are reduced in the same order whatever the number of threads,
+// so the results are exactly the same
+void ExpectSameAsSequential(const string& type, const vector<string>& inputs) {
+  auto expected = RunOp(type, inputs, false);
+  auto actual = RunOp(type, inputs, true);
+  EXPECT_FALSE(expected.empty()) << type;
+  EXPECT_EQ(expected, actual) << type;
+}
+
+} // namespace
+
+TEST_F(SegmentReductionOpTest, UnsortedSegmentSum) {
+  Workspace ws;
+  AddInputs(&ws);
+  const auto& data = ws.GetBlob("DATA")->Get<TensorCPU>();
+  const auto& ids = ws.GetBlob("UNSORTED_IDS")->Get<TensorCPU>();
+  const int block_size = data.dim32(1);
+  vector<float> expected;
+  for (int i = 0; i < ids.size(); ++i) {
+    const int id = ids.data<int>()[i];
+    expected.resize(std::max<size_t>(expected.size(), (id + 1) * block_size));
+    for (int j = 0; j < block_size; ++j) {
+      expected[id * block_size + j] += data.data<float>()[i * block_size + j];
+    }
+  }
+
+  const auto actual =
+      RunOp("UnsortedSegmentSum", {"DATA", "UNSORTED_IDS"}, true);
+  ASSERT_EQ(expected.size(), actual.size());
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(expected[i], actual[i], 1e-4);
+  }
+}
+
+TEST_F(SegmentReductionOpTest, LengthsMatchSequential) {
+  ExpectSameAsSequential("LengthsSum", {"DATA", "LENGTHS"});
+  ExpectSameAsSequential("LengthsMean", {"DATA", "LENGTHS"});
+  ExpectSameAsSequential("LengthsMax", {"DATA", "LENGTHS"});
+  ExpectSameAsSequential(
+      "LengthsWeightedSum", {"DATA", "WEIGHTS", "LENGTHS"});
+}
+
+TEST_F(SegmentReductionOpTest, SortedSegmentsMatchSequential) {
+  ExpectSameAsSequential("SortedSegmentSum", {"DATA", "SORTED_IDS"});
+  ExpectSameAsSequential("SortedSegmentMean", {"DATA", "SORTED_IDS"});
+  ExpectSameAsSequential(
+      "SparseSortedSegmentSum", {"DATA", "INDICES", "SORTED_IDS"});
+}
+
+TEST_F(SegmentReductionOpTest, UnsortedSegmentsMatchSequential) {
+  ExpectSameAsSequential("UnsortedSegmentSum", {"DATA", "UNSORTED_IDS"});
+  ExpectSameAsSequential("UnsortedSegmentMean", {"DATA", "UNSORTED_IDS"});
+  ExpectSameAsSequential(
+      "UnsortedSegmentWeightedSum", {"DATA", "WEIGHTS", "UNSORTED_IDS"});
+  ExpectSameAsSequential(
+      "SparseUnsortedSegmentMean", {"DATA", "INDICES", "UNSORTED_IDS"});
+}
+
+} // namespace caffe2
@@ -3,6 +3,13 @@
 
 namespace caffe2 {
 
+namespace {
+
+// The smallest number of elements that are handed to a thread
+constexpr int kSoftmaxParallelGrain = 16384;
+
+} // namespace
+
 // Implementation for the CPU context.
 template <>
 bool SoftmaxOp<float, CPUContext>::RunOnDevice() {
@@ -26,16 +33,27 @@ bool SoftmaxOp<float, CPUContext>::RunOnDevice() {
                                  &context_);
   }
 
-  SoftmaxCPU(
-      context_,
+  // The rows are independent, and split between the threads of the pool
+  const float* Xdata = X.data<float>();
+  float* scale = scale_.mutable_data<float>();
+  float* rowmax = rowmax_.mutable_data<float>();
+  const float* sum_multiplier = sum_multiplier_.data<float>();
+  ParallelFor(
+      IntraOpThreadPool(),
       N,
-      D,
-      X.data<float>(),
-      Ydata,
-      scale_.mutable_data<float>(),
-      sum_multiplier_.data<float>(),
-      false,
-      rowmax_.mutable_data<float>());
+      kSoftmaxParallelGrain / std::max(D, 1) + 1,
+      [&](size_t begin, size_t end) {
+        SoftmaxCPU(
+            context_,
+            end - begin,
+            D,
+            Xdata + begin * D,
+            Ydata + begin * D,
+            scale + begin,
+            sum_multiplier,
+            false,
+            rowmax + begin);
+      });
   return true;
 }
 
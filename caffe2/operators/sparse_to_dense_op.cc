@@ -1,9 +1,80 @@
 #include "sparse_to_dense_op.h"
 
+#include <numeric>
+
 #include "caffe2/core/context.h"
 
 namespace caffe2 {
 
+namespace {
+
+// The number of output values worth a thread handoff
+constexpr int kSparseToDenseParallelGrain = 1 << 14;
+
+} // namespace
+
+template <>
+template <typename TInd, typename TData>
+bool SparseToDenseOp<CPUContext>::DoRunWithType2() {
+  auto& sparse_indices = Input(INDICES);
+  CAFFE_ENFORCE_EQ(sparse_indices.ndim(), 1);
+  auto& sparse_values = Input(VALUES);
+  CAFFE_ENFORCE_GE(sparse_values.ndim(), 1);
+  CAFFE_ENFORCE_EQ(sparse_indices.size(), sparse_values.dim(0));
+
+  const TInd* sparse_indices_vec = sparse_indices.template data<TInd>();
+  const int32_t sparse_indices_len = sparse_indices.dim32(0);
+  const int output_first_dim =
+      GetOutputFirstDim(sparse_indices_vec, sparse_indices_len);
+
+  auto shape = sparse_values.dims();
+  shape[0] = output_first_dim;
+  auto* output = Output(0);
+  output->Resize(shape);
+
+  TData* output_data = output->template mutable_data<TData>();
+  const auto block_nitems = sparse_values.size_from_dim(1);
+  const TData* sparse_values_vec = sparse_values.template data<TData>();
+
+  // Sorts the values by output row with a counting sort, which keeps the
+  // order of duplicated indices, so that every output row is summed by one
+  // thread in the same order as a sequential pass.
+  std::vector<int32_t> row_offsets(output_first_dim + 1, 0);
+  for (int32_t i = 0; i < sparse_indices_len; i++) {
+    const TInd idx = sparse_indices_vec[i];
+    CAFFE_ENFORCE_GE(idx, 0);
+    CAFFE_ENFORCE_LT(idx, output_first_dim);
+    ++row_offsets[idx + 1];
+  }
+  std::partial_sum(
+      row_offsets.begin(), row_offsets.end(), row_offsets.begin());
+  std::vector<int32_t> row_values(sparse_indices_len);
+  std::vector<int32_t> next(row_offsets.begin(), row_offsets.end() - 1);
+  for (int32_t i = 0; i < sparse_indices_len; i++) {
+    row_values[next[sparse_indices_vec[i]]++] = i;
+  }
+
+  ParallelFor(
+      IntraOpThreadPool(),
+      output_first_dim,
+      kSparseToDenseParallelGrain / std::max<TIndex>(block_nitems, 1) + 1,
+      [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row) {
+          TData* dst = output_data + row * block_nitems;
+          std::fill(dst, dst + block_nitems, TData(0));
+          for (int32_t k = row_offsets[row]; k < row_offsets[row + 1]; ++k) {
+            math::Add(
+                block_nitems,
+                dst,
+                sparse_values_vec + row_values[k] * block_nitems,
+                dst,
+                &context_);
+          }
+        }
+      });
+  return true;
+}
+
 REGISTER_CPU_OPERATOR(SparseToDense, SparseToDenseOp<CPUContext>);
 
 OPERATOR_SCHEMA(SparseToDense)
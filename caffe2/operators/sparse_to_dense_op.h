@@ -63,41 +63,7 @@ class SparseToDenseOp final : public Operator<Context> {
   }
 
   template <typename TInd, typename TData>
-  bool DoRunWithType2() {
-    auto& sparse_indices = Input(INDICES);
-    CAFFE_ENFORCE_EQ(sparse_indices.ndim(), 1);
-    auto& sparse_values = Input(VALUES);
-    CAFFE_ENFORCE_GE(sparse_values.ndim(), 1);
-    CAFFE_ENFORCE_EQ(sparse_indices.size(), sparse_values.dim(0));
-
-    const TInd* sparse_indices_vec = sparse_indices.template data<TInd>();
-    const int32_t sparse_indices_len = sparse_indices.dim32(0);
-    const int output_first_dim =
-        GetOutputFirstDim(sparse_indices_vec, sparse_indices_len);
-
-    auto shape = sparse_values.dims();
-    shape[0] = output_first_dim;
-    auto* output = Output(0);
-    output->Resize(shape);
-
-    TData* output_data = output->template mutable_data<TData>();
-    memset(output_data, 0, output->nbytes());
-    const auto block_nitems = sparse_values.size_from_dim(1);
-    const TData* sparse_values_vec = sparse_values.template data<TData>();
-
-    for (int32_t i = 0; i < sparse_indices_len; i++) {
-      const TInd idx = sparse_indices_vec[i];
-      CAFFE_ENFORCE_GE(idx, 0);
-      CAFFE_ENFORCE_LT(idx, output_first_dim);
-      math::Add(
-          block_nitems,
-          output_data + idx * block_nitems,
-          sparse_values_vec + i * block_nitems,
-          output_data + idx * block_nitems,
-          &context_);
-    }
-    return true;
-  }
+  bool DoRunWithType2();
 
   template <typename TInd>
   bool DoRunWithOtherType2() {
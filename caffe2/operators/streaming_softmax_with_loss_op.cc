@@ -0,0 +1,218 @@
+#include "caffe2/operators/streaming_softmax_with_loss_op.h"
+
+#include <cmath>
+#include <limits>
+
+namespace caffe2 {
+
+namespace {
+
+// The logits of a row are read in chunks that fit in the L1 cache, so that
+// the exponentials of a chunk are summed right after its max is known
+constexpr int kLogitsChunkSize = 2048;
+
+// The number of logits worth a thread handoff
+constexpr size_t kStreamingSoftmaxParallelGrain = 1 << 14;
+
+float RowLogSumExp(const float* x, const int D) {
+  float max = -std::numeric_limits<float>::infinity();
+  float sum = 0;
+  for (int begin = 0; begin < D; begin += kLogitsChunkSize) {
+    ConstEigenVectorArrayMap<float> chunk(
+        x + begin, std::min(kLogitsChunkSize, D - begin));
+    const float chunk_max = chunk.maxCoeff();
+    if (chunk_max > max) {
+      sum *= std::exp(max - chunk_max);
+      max = chunk_max;
+    }
+    sum += (chunk - max).exp().sum();
+  }
+  return max + std::log(sum);
+}
+
+void ValidateLabels(const int N, const int D, const int* labels) {
+  for (int i = 0; i < N; ++i) {
+    CAFFE_ENFORCE(
+        labels[i] < D && labels[i] >= 0,
+        "Label seems incorrect: label value larger than number of classes: ",
+        labels[i],
+        " vs ",
+        D);
+  }
+}
+
+} // namespace
+
+template <>
+bool StreamingSoftmaxWithLossOp<float, CPUContext>::RunOnDevice() {
+  const auto& X = Input(0); // Logits
+  const auto& T = Input(1); // Labels
+  auto* log_normalizer = Output(0);
+  auto* avg_loss = Output(1);
+
+  const auto canonical_axis = X.canonical_axis_index(axis_);
+  const int N = X.size_to_dim(canonical_axis);
+  const int D = X.size_from_dim(canonical_axis);
+  CAFFE_ENFORCE_GT(D, 0);
+  CAFFE_ENFORCE_EQ(T.size(), N);
+  const float* weights = InputSize() > 2 ? Input(2).data<float>() : nullptr;
+  if (weights) {
+    CAFFE_ENFORCE_EQ(Input(2).size(), N);
+  }
+  const int* labels = T.data<int>();
+  ValidateLabels(N, D, labels);
+
+  log_normalizer->Resize(N);
+  losses_.Resize(N);
+  const float* Xdata = X.data<float>();
+  float* log_normalizer_data = log_normalizer->mutable_data<float>();
+  float* losses = losses_.mutable_data<float>();
+  ParallelFor(
+      IntraOpThreadPool(),
+      N,
+      kStreamingSoftmaxParallelGrain / D + 1,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const float* x = Xdata + i * D;
+          log_normalizer_data[i] = RowLogSumExp(x, D);
+          losses[i] = (log_normalizer_data[i] - x[labels[i]]) *
+              (weights ? weights[i] : 1.0f);
+        }
+      });
+
+  float loss_sum = 0;
+  float weight_sum = 0;
+  for (int i = 0; i < N; ++i) {
+    loss_sum += losses[i];
+    weight_sum += weights ? weights[i] : 1.0f;
+  }
+  avg_loss->Resize(vector<TIndex>());
+  avg_loss->mutable_data<float>()[0] =
+      weight_sum != 0 ? loss_sum * scale_ / weight_sum : 0;
+  return true;
+}
+
+template <>
+bool StreamingSoftmaxWithLossGradientOp<float, CPUContext>::RunOnDevice() {
+  const auto& X = Input(0); // Logits
+  const auto& T = Input(1); // Labels
+  // Input(2) is weights if given
+  const auto& log_normalizer = Input(InputSize() - 2);
+  const auto& d_avg_loss = Input(InputSize() - 1);
+  auto* dX = Output(0);
+
+  const auto canonical_axis = X.canonical_axis_index(axis_);
+  const int N = X.size_to_dim(canonical_axis);
+  const int D = X.size_from_dim(canonical_axis);
+  CAFFE_ENFORCE_EQ(T.size(), N);
+  CAFFE_ENFORCE_EQ(log_normalizer.size(), N);
+  const float* weights = InputSize() > 4 ? Input(2).data<float>() : nullptr;
+  const int* labels = T.data<int>();
+  dX->ResizeLike(X);
+
+  float total_weight = N;
+  if (weights) {
+    total_weight = 0;
+    for (int i = 0; i < N; ++i) {
+      total_weight += weights[i];
+    }
+  }
+  const float scale = total_weight > 0
+      ? scale_ / total_weight * d_avg_loss.data<float>()[0]
+      : 0;
+
+  const float* Xdata = X.data<float>();
+  const float* log_normalizer_data = log_normalizer.data<float>();
+  float* dX_data = dX->mutable_data<float>();
+  ParallelFor(
+      IntraOpThreadPool(),
+      N,
+      kStreamingSoftmaxParallelGrain / std::max(D, 1) + 1,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const float row_scale = weights ? scale * weights[i] : scale;
+          EigenVectorArrayMap<float>(dX_data + i * D, D) =
+              (ConstEigenVectorArrayMap<float>(Xdata + i * D, D) -
+               log_normalizer_data[i])
+                  .exp() *
+              row_scale;
+          dX_data[i * D + labels[i]] -= row_scale;
+        }
+      });
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(
+    StreamingSoftmaxWithLoss,
+    StreamingSoftmaxWithLossOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    StreamingSoftmaxWithLossGradient,
+    StreamingSoftmaxWithLossGradientOp<float, CPUContext>);
+
+OPERATOR_SCHEMA(StreamingSoftmaxWithLoss)
+    .NumInputs(2, 3)
+    .NumOutputs(2)
+    .TensorInferenceFunction(
+        [](const OperatorDef& def, const vector<TensorShape>& in) {
+          ArgumentHelper helper(def);
+          auto axis = helper.GetSingleArgument<int32_t>("axis", 1);
+          const auto canonical_axis =
+              canonical_axis_index_(axis, in[0].dims().size());
+          vector<TensorShape> out(2);
+          out[0].set_data_type(in[0].data_type());
+          out[0].add_dims(size_to_dim_(canonical_axis, GetDimsVector(in[0])));
+          out[1].set_data_type(in[0].data_type());
+          return out;
+        })
+    .SetDoc(R"DOC(
+Same loss as SoftmaxWithLoss with integer labels, for a large number of
+classes: instead of the N x D softmax probabilities, the operator only outputs
+the log of the softmax normalizer of each example, log(sum_j exp(logits_ij)),
+which it computes in a single pass over the logits. The gradient operator
+recomputes the probabilities from it, so that the logits are read once in each
+direction and the probabilities never take memory.
+)DOC")
+    .Arg("scale", "Scale of the average loss, default 1")
+    .Arg("axis", "The first dimension of the classes, default 1")
+    .Input(0, "logits", "Unscaled log probabilities")
+    .Input(1, "labels", "Class of each example, as an int")
+    .Input(
+        2,
+        "weight_tensor",
+        "Optional blob to be used to weight the samples for the loss.")
+    .Output(
+        0,
+        "log_normalizer",
+        "Log of the softmax normalizer of each example")
+    .Output(1, "loss", "Average loss");
+
+// Input: X, T, [weights,] log_normalizer, dY; Output: dX
+OPERATOR_SCHEMA(StreamingSoftmaxWithLossGradient)
+    .NumInputs(4, 5)
+    .NumOutputs(1);
+
+namespace {
+
+class GetStreamingSoftmaxWithLossGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    vector<string> blob_names{I(0), I(1), O(0), GO(1)};
+    // Add weight blob, if given
+    if (def_.input_size() == 3) {
+      blob_names.emplace(blob_names.begin() + 2, I(2));
+    }
+    return SingleGradientDef(
+        "StreamingSoftmaxWithLossGradient",
+        "",
+        blob_names,
+        vector<string>{GI(0)});
+  }
+};
+
+} // namespace
+
+REGISTER_GRADIENT(
+    StreamingSoftmaxWithLoss,
+    GetStreamingSoftmaxWithLossGradient);
+
+} // namespace caffe2
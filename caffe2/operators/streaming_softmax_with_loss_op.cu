@@ -0,0 +1,221 @@
+#include <cfloat>
+
+#include <cub/block/block_reduce.cuh>
+
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/operators/streaming_softmax_with_loss_op.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Running max of a part of a row, and sum of the exponentials of that part
+// relative to it
+struct LogSumExpData {
+  float max;
+  float sum;
+};
+
+struct LogSumExpMerge {
+  __device__ inline LogSumExpData operator()(
+      const LogSumExpData& a,
+      const LogSumExpData& b) const {
+    const float max = fmaxf(a.max, b.max);
+    return LogSumExpData{
+        a.sum * expf(a.max - max) + b.sum * expf(b.max - max), max};
+  }
+};
+
+// A block reads each row once, each thread keeping the running max and sum of
+// the logits it reads, before they are merged
+__global__ void RowLogSumExpKernel(
+    const int N,
+    const int D,
+    const float* X,
+    const int* labels,
+    const float* weights,
+    float* log_normalizer,
+    float* losses) {
+  typedef cub::BlockReduce<LogSumExpData, CAFFE_CUDA_NUM_THREADS> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+  for (int i = blockIdx.x; i < N; i += gridDim.x) {
+    const float* x = X + static_cast<size_t>(i) * D;
+    LogSumExpData data{-FLT_MAX, 0};
+    for (int j = threadIdx.x; j < D; j += blockDim.x) {
+      const float value = x[j];
+      if (value > data.max) {
+        data.sum = data.sum * expf(data.max - value) + 1;
+        data.max = value;
+      } else {
+        data.sum += expf(value - data.max);
+      }
+    }
+    data = BlockReduce(temp_storage).Reduce(data, LogSumExpMerge());
+    if (threadIdx.x == 0) {
+      const int label = labels[i];
+      CUDA_KERNEL_ASSERT(label >= 0 && label < D);
+      const float lse = data.max + logf(data.sum);
+      log_normalizer[i] = lse;
+      losses[i] = (lse - x[label]) * (weights ? weights[i] : 1.0f);
+    }
+    __syncthreads();
+  }
+}
+
+// Sums the N losses and weights in a single block, into the average loss
+__global__ void AverageLossKernel(
+    const int N,
+    const float* losses,
+    const float* weights,
+    const float scale,
+    float* avg_loss) {
+  typedef cub::BlockReduce<float, CAFFE_CUDA_NUM_THREADS> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage loss_storage;
+  __shared__ typename BlockReduce::TempStorage weight_storage;
+  float loss_sum = 0;
+  float weight_sum = 0;
+  for (int i = threadIdx.x; i < N; i += blockDim.x) {
+    loss_sum += losses[i];
+    weight_sum += weights ? weights[i] : 1.0f;
+  }
+  loss_sum = BlockReduce(loss_storage).Sum(loss_sum);
+  weight_sum = BlockReduce(weight_storage).Sum(weight_sum);
+  if (threadIdx.x == 0) {
+    *avg_loss = weight_sum != 0 ? loss_sum * scale / weight_sum : 0;
+  }
+}
+
+// The scale of the gradient of every example, before its weight
+__global__ void GradientScaleKernel(
+    const int N,
+    const float* weights,
+    const float scale,
+    const float* d_avg_loss,
+    float* grad_scale) {
+  typedef cub::BlockReduce<float, CAFFE_CUDA_NUM_THREADS> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+  float weight_sum = 0;
+  for (int i = threadIdx.x; i < N; i += blockDim.x) {
+    weight_sum += weights ? weights[i] : 1.0f;
+  }
+  weight_sum = BlockReduce(temp_storage).Sum(weight_sum);
+  if (threadIdx.x == 0) {
+    *grad_scale = weight_sum > 0 ? scale / weight_sum * *d_avg_loss : 0;
+  }
+}
+
+__global__ void StreamingSoftmaxGradientKernel(
+    const int N,
+    const int D,
+    const float* X,
+    const int* labels,
+    const float* weights,
+    const float* log_normalizer,
+    const float* grad_scale,
+    float* dX) {
+  CUDA_1D_KERNEL_LOOP(index, N * D) {
+    const int i = index / D;
+    const int j = index % D;
+    const float scale = weights ? *grad_scale * weights[i] : *grad_scale;
+    dX[index] =
+        (expf(X[index] - log_normalizer[i]) - (j == labels[i])) * scale;
+  }
+}
+
+} // namespace
+
+template <>
+bool StreamingSoftmaxWithLossOp<float, CUDAContext>::RunOnDevice() {
+  const auto& X = Input(0); // Logits
+  const auto& T = Input(1); // Labels
+  auto* log_normalizer = Output(0);
+  auto* avg_loss = Output(1);
+
+  const auto canonical_axis = X.canonical_axis_index(axis_);
+  const int N = X.size_to_dim(canonical_axis);
+  const int D = X.size_from_dim(canonical_axis);
+  CAFFE_ENFORCE_GT(D, 0);
+  CAFFE_ENFORCE_EQ(T.size(), N);
+  const float* weights = InputSize() > 2 ? Input(2).data<float>() : nullptr;
+  if (weights) {
+    CAFFE_ENFORCE_EQ(Input(2).size(), N);
+  }
+
+  log_normalizer->Resize(N);
+  losses_.Resize(N);
+  avg_loss->Resize(vector<TIndex>());
+  if (N > 0) {
+    RowLogSumExpKernel<<<
+        std::min(N, CAFFE_MAXIMUM_NUM_BLOCKS),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        N,
+        D,
+        X.data<float>(),
+        T.data<int>(),
+        weights,
+        log_normalizer->mutable_data<float>(),
+        losses_.mutable_data<float>());
+  }
+  AverageLossKernel<<<1, CAFFE_CUDA_NUM_THREADS, 0, context_.cuda_stream()>>>(
+      N,
+      losses_.mutable_data<float>(),
+      weights,
+      scale_,
+      avg_loss->mutable_data<float>());
+  return true;
+}
+
+template <>
+bool StreamingSoftmaxWithLossGradientOp<float, CUDAContext>::RunOnDevice() {
+  const auto& X = Input(0); // Logits
+  const auto& T = Input(1); // Labels
+  // Input(2) is weights if given
+  const auto& log_normalizer = Input(InputSize() - 2);
+  const auto& d_avg_loss = Input(InputSize() - 1);
+  auto* dX = Output(0);
+
+  const auto canonical_axis = X.canonical_axis_index(axis_);
+  const int N = X.size_to_dim(canonical_axis);
+  const int D = X.size_from_dim(canonical_axis);
+  CAFFE_ENFORCE_EQ(T.size(), N);
+  CAFFE_ENFORCE_EQ(log_normalizer.size(), N);
+  const float* weights = InputSize() > 4 ? Input(2).data<float>() : nullptr;
+  dX->ResizeLike(X);
+  if (X.size() == 0) {
+    dX->mutable_data<float>();
+    return true;
+  }
+
+  grad_scale_.Resize(1);
+  GradientScaleKernel<<<1, CAFFE_CUDA_NUM_THREADS, 0, context_.cuda_stream()>>>(
+      N,
+      weights,
+      scale_,
+      d_avg_loss.data<float>(),
+      grad_scale_.mutable_data<float>());
+  StreamingSoftmaxGradientKernel<<<
+      CAFFE_GET_BLOCKS(N * D),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context_.cuda_stream()>>>(
+      N,
+      D,
+      X.data<float>(),
+      T.data<int>(),
+      weights,
+      log_normalizer.data<float>(),
+      grad_scale_.data<float>(),
+      dX->mutable_data<float>());
+  return true;
+}
+
+REGISTER_CUDA_OPERATOR(
+    StreamingSoftmaxWithLoss,
+    StreamingSoftmaxWithLossOp<float, CUDAContext>);
+REGISTER_CUDA_OPERATOR(
+    StreamingSoftmaxWithLossGradient,
+    StreamingSoftmaxWithLossGradientOp<float, CUDAContext>);
+
+} // namespace caffe2
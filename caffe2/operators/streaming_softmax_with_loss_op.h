@@ -0,0 +1,56 @@
+#ifndef CAFFE2_OPERATORS_STREAMING_SOFTMAX_WITH_LOSS_OP_H_
+#define CAFFE2_OPERATORS_STREAMING_SOFTMAX_WITH_LOSS_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+// SoftmaxWithLoss for integer labels that never materializes the softmax.
+// The forward pass reads each row of logits once, keeping a running max and
+// sum of exponentials, and only keeps the log of the normalizer of each row.
+// The gradient recomputes the probabilities from it while it writes dX.
+template <typename T, class Context>
+class StreamingSoftmaxWithLossOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  StreamingSoftmaxWithLossOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        scale_(OperatorBase::GetSingleArgument<float>("scale", 1.)),
+        axis_(OperatorBase::GetSingleArgument<int>("axis", 1)) {
+    CAFFE_ENFORCE(scale_ >= 0);
+  }
+
+  bool RunOnDevice() override;
+
+ protected:
+  float scale_;
+  int axis_;
+
+  Tensor<Context> losses_; // Per example weighted loss
+};
+
+template <typename T, class Context>
+class StreamingSoftmaxWithLossGradientOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  StreamingSoftmaxWithLossGradientOp(const OperatorDef& def, Workspace* ws)
+      : Operator<Context>(def, ws),
+        scale_(OperatorBase::GetSingleArgument<float>("scale", 1.)),
+        axis_(OperatorBase::GetSingleArgument<int>("axis", 1)) {
+    CAFFE_ENFORCE(scale_ >= 0);
+  }
+
+  bool RunOnDevice() override;
+
+ protected:
+  float scale_;
+  int axis_;
+
+  Tensor<Context> grad_scale_; // Scale of the gradient before the weights
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_STREAMING_SOFTMAX_WITH_LOSS_OP_H_
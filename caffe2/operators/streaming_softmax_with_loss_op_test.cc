@@ -0,0 +1,95 @@
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+namespace {
+
+// More classes than a chunk of logits, so that the running max changes
+// between chunks
+const int kExamples = 7;
+const int kClasses = 5000;
+
+void AddInputs(Workspace* ws) {
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> logit(-10, 10);
+  std::uniform_int_distribution<int> label(0, kClasses - 1);
+  std::uniform_real_distribution<float> weight(0, 2);
+
+  auto* X = ws->CreateBlob("X")->GetMutable<TensorCPU>();
+  X->Resize(kExamples, kClasses);
+  for (int i = 0; i < X->size(); ++i) {
+    X->mutable_data<float>()[i] = logit(gen);
+  }
+  auto* T = ws->CreateBlob("T")->GetMutable<TensorCPU>();
+  T->Resize(kExamples);
+  auto* W = ws->CreateBlob("W")->GetMutable<TensorCPU>();
+  W->Resize(kExamples);
+  for (int i = 0; i < kExamples; ++i) {
+    T->mutable_data<int>()[i] = label(gen);
+    W->mutable_data<float>()[i] = weight(gen);
+  }
+  auto* dY = ws->CreateBlob("dY")->GetMutable<TensorCPU>();
+  dY->Resize(vector<TIndex>());
+  dY->mutable_data<float>()[0] = 0.5f;
+}
+
+void RunOp(
+    const string& type,
+    const vector<string>& inputs,
+    const vector<string>& outputs,
+    Workspace* ws) {
+  OperatorDef def;
+  def.set_type(type);
+  for (const auto& input : inputs) {
+    def.add_input(input);
+  }
+  for (const auto& output : outputs) {
+    def.add_output(output);
+  }
+  def.add_arg()->CopyFrom(MakeArgument("scale", 2.0f));
+  auto op = CreateOperator(def, ws);
+  ASSERT_NE(nullptr, op.get());
+  ASSERT_TRUE(op->Run());
+}
+
+void ExpectNear(const Workspace& ws, const string& a, const string& b) {
+  const auto& A = ws.GetBlob(a)->Get<TensorCPU>();
+  const auto& B = ws.GetBlob(b)->Get<TensorCPU>();
+  ASSERT_EQ(A.dims(), B.dims());
+  for (int i = 0; i < A.size(); ++i) {
+    EXPECT_NEAR(A.data<float>()[i], B.data<float>()[i], 1e-5) << a;
+  }
+}
+
+} // namespace
+
+TEST(StreamingSoftmaxWithLossTest, MatchesSoftmaxWithLoss) {
+  Workspace ws;
+  AddInputs(&ws);
+  RunOp("SoftmaxWithLoss", {"X", "T", "W"}, {"P", "loss"}, &ws);
+  RunOp(
+      "SoftmaxWithLossGradient",
+      {"X", "T", "W", "P", "dY"},
+      {"dX"},
+      &ws);
+  RunOp(
+      "StreamingSoftmaxWithLoss",
+      {"X", "T", "W"},
+      {"log_normalizer", "streaming_loss"},
+      &ws);
+  RunOp(
+      "StreamingSoftmaxWithLossGradient",
+      {"X", "T", "W", "log_normalizer", "dY"},
+      {"streaming_dX"},
+      &ws);
+
+  ExpectNear(ws, "loss", "streaming_loss");
+  ExpectNear(ws, "dX", "streaming_dX");
+}
+
+} // namespace caffe2
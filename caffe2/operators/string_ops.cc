@@ -1,5 +1,11 @@
 #include "caffe2/operators/string_ops.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/utils/murmur_hash3.h"
+
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <sstream>
 
 namespace caffe2 {
 
@@ -17,27 +23,37 @@ bool StringJoinOp<CPUContext>::DoRunWithType() {
     output->Resize(input.dim(0));
     auto* outputData = output->mutable_data<std::string>();
 
-    int offset = 0;
-    for (int i = 0; i < input.dim(0); ++i) {
-      std::stringstream stream;
-      std::copy(
-          inputData + offset,
-          inputData + offset + rowSize,
-          std::ostream_iterator<T>(stream, delimiter_.c_str()));
-      outputData[i] = stream.str();
-      offset += rowSize;
-    }
+    ParallelFor(
+        IntraOpThreadPool(),
+        input.dim(0),
+        std::max<size_t>(1, kStringParallelGrain / rowSize),
+        [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            std::stringstream stream;
+            std::copy(
+                inputData + i * rowSize,
+                inputData + (i + 1) * rowSize,
+                std::ostream_iterator<T>(stream, delimiter_.c_str()));
+            outputData[i] = stream.str();
+          }
+        });
   } else if (this->axis_ == 1) {
     output->Resize(input.dim(1));
     auto* outputData = output->mutable_data<std::string>();
 
-    for (int j = 0; j < input.dim(1); ++j) {
-      std::stringstream stream;
-      for (int i = 0; i < input.dim(0); ++i) {
-        stream << inputData[i * rowSize + j] << delimiter_;
-      }
-      outputData[j] = stream.str();
-    }
+    ParallelFor(
+        IntraOpThreadPool(),
+        input.dim(1),
+        std::max<size_t>(1, kStringParallelGrain / input.dim(0)),
+        [&](size_t begin, size_t end) {
+          for (size_t j = begin; j < end; ++j) {
+            std::stringstream stream;
+            for (int i = 0; i < input.dim(0); ++i) {
+              stream << inputData[i * rowSize + j] << delimiter_;
+            }
+            outputData[j] = stream.str();
+          }
+        });
   } else {
     CAFFE_ENFORCE(false, "Not supported");
   }
@@ -45,14 +61,206 @@ bool StringJoinOp<CPUContext>::DoRunWithType() {
   return true;
 }
 
+PackedStrings::PackedStrings(const TensorCPU& lengths, const TensorCPU& bytes)
+    : bytes_(reinterpret_cast<const char*>(bytes.data<uint8_t>())),
+      offsets_(lengths.size() + 1) {
+  const auto* lengthsData = lengths.data<int>();
+  offsets_[0] = 0;
+  for (TIndex i = 0; i < lengths.size(); ++i) {
+    CAFFE_ENFORCE_GE(lengthsData[i], 0);
+    offsets_[i + 1] = offsets_[i] + lengthsData[i];
+  }
+  CAFFE_ENFORCE_EQ(
+      offsets_.back(),
+      bytes.size(),
+      "The lengths of the packed strings don't add up to their bytes.");
+}
+
+template <typename Functor>
+bool StringPredicateOp<Functor>::RunOnDevice() {
+  auto* output = Output(0);
+  if (InputSize() == 1) {
+    const auto& input = Input(0);
+    const auto* in = input.data<std::string>();
+    output->ResizeLike(input);
+    auto* out = output->mutable_data<bool>();
+    ParallelFor(
+        IntraOpThreadPool(),
+        input.size(),
+        kStringParallelGrain,
+        [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            out[i] = functor_(in[i].data(), in[i].size());
+          }
+        });
+    return true;
+  }
+  const auto& lengths = Input(0);
+  PackedStrings in(lengths, Input(1));
+  output->ResizeLike(lengths);
+  auto* out = output->mutable_data<bool>();
+  ParallelFor(
+      IntraOpThreadPool(),
+      in.size(),
+      kStringParallelGrain,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          out[i] = functor_(in.data(i), in.length(i));
+        }
+      });
+  return true;
+}
+
+template <typename Functor>
+bool StringSubstringOp<Functor>::RunOnDevice() {
+  if (InputSize() == 1) {
+    const auto& input = Input(0);
+    const auto* in = input.data<std::string>();
+    auto* output = Output(0);
+    output->ResizeLike(input);
+    auto* out = output->mutable_data<std::string>();
+    ParallelFor(
+        IntraOpThreadPool(),
+        input.size(),
+        kStringParallelGrain,
+        [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            const auto range = functor_(in[i].data(), in[i].size());
+            out[i].assign(in[i].data() + range.first, range.second);
+          }
+        });
+    return true;
+  }
+
+  const auto& lengths = Input(0);
+  PackedStrings in(lengths, Input(1));
+  auto* outputLengths = Output(0);
+  auto* outputBytes = Output(1);
+  outputLengths->ResizeLike(lengths);
+  auto* outLengths = outputLengths->mutable_data<int>();
+  std::vector<std::pair<size_t, size_t>> ranges(in.size());
+  ParallelFor(
+      IntraOpThreadPool(),
+      in.size(),
+      kStringParallelGrain,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          ranges[i] = functor_(in.data(i), in.length(i));
+          outLengths[i] = ranges[i].second;
+        }
+      });
+  std::vector<TIndex> offsets(in.size() + 1, 0);
+  for (TIndex i = 0; i < in.size(); ++i) {
+    offsets[i + 1] = offsets[i] + ranges[i].second;
+  }
+  outputBytes->Resize(offsets.back());
+  auto* outBytes =
+      reinterpret_cast<char*>(outputBytes->mutable_data<uint8_t>());
+  ParallelFor(
+      IntraOpThreadPool(),
+      in.size(),
+      kStringParallelGrain,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          std::memcpy(
+              outBytes + offsets[i],
+              in.data(i) + ranges[i].first,
+              ranges[i].second);
+        }
+      });
+  return true;
+}
+
+StringTokenizeHashOp::StringTokenizeHashOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws),
+      num_buckets_(GetSingleArgument<int64_t>("num_buckets", 0)),
+      seed_(GetSingleArgument<int>("seed", 0)) {
+  CAFFE_ENFORCE_GE(num_buckets_, 0);
+  is_delimiter_.fill(false);
+  for (char c : GetSingleArgument<std::string>("delimiters", " \t\n\r")) {
+    is_delimiter_[static_cast<uint8_t>(c)] = true;
+  }
+}
+
+bool StringTokenizeHashOp::RunOnDevice() {
+  if (InputSize() == 1) {
+    const auto& input = Input(0);
+    const auto* in = input.data<std::string>();
+    TokenizeAndHash(input.size(), [in](TIndex i) {
+      return std::make_pair(in[i].data(), in[i].size());
+    });
+  } else {
+    PackedStrings in(Input(0), Input(1));
+    TokenizeAndHash(in.size(), [&in](TIndex i) {
+      return std::make_pair(in.data(i), in.length(i));
+    });
+  }
+  return true;
+}
+
+template <typename GetString>
+void StringTokenizeHashOp::TokenizeAndHash(TIndex n, GetString get) {
+  auto* lengths = Output(0);
+  auto* ids = Output(1);
+  lengths->Resize(n);
+  auto* lengthsData = lengths->mutable_data<int>();
+  // Counts the tokens first, so that the ids of each string are then written
+  // straight to their place in the output
+  ParallelFor(
+      IntraOpThreadPool(),
+      n,
+      kStringParallelGrain,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const auto str = get(i);
+          int count = 0;
+          ForEachToken(str.first, str.second, [&count](const char*, size_t) {
+            ++count;
+          });
+          lengthsData[i] = count;
+        }
+      });
+  std::vector<TIndex> offsets(n + 1, 0);
+  for (TIndex i = 0; i < n; ++i) {
+    offsets[i + 1] = offsets[i] + lengthsData[i];
+  }
+  ids->Resize(offsets.back());
+  auto* idsData = ids->mutable_data<int64_t>();
+  ParallelFor(
+      IntraOpThreadPool(),
+      n,
+      kStringParallelGrain,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const auto str = get(i);
+          auto* out = idsData + offsets[i];
+          ForEachToken(
+              str.first,
+              str.second,
+              [this, &out](const char* token, size_t length) {
+                *out++ = Hash(token, length);
+              });
+        }
+      });
+}
+
+int64_t StringTokenizeHashOp::Hash(const char* token, size_t length) const {
+  uint64_t hash[2];
+  MurmurHash3_x64_128(token, length, seed_, hash);
+  return num_buckets_ > 0 ? static_cast<int64_t>(hash[0] % num_buckets_)
+                          : static_cast<int64_t>(hash[0]);
+}
+
 namespace {
 
 struct StartsWith {
   explicit StartsWith(OperatorBase& op)
       : prefix_(op.GetSingleArgument<std::string>("prefix", "")) {}
-  bool operator()(const std::string& str) {
-    return std::mismatch(prefix_.begin(), prefix_.end(), str.begin()).first ==
-        prefix_.end();
+  bool operator()(const char* str, size_t length) const {
+    return length >= prefix_.size() &&
+        std::equal(prefix_.begin(), prefix_.end(), str);
   }
 
  private:
@@ -62,9 +270,10 @@ struct StartsWith {
 struct EndsWith {
   explicit EndsWith(OperatorBase& op)
       : suffix_(op.GetSingleArgument<std::string>("suffix", "")) {}
-  bool operator()(const std::string& str) {
-    return std::mismatch(suffix_.rbegin(), suffix_.rend(), str.rbegin())
-               .first == suffix_.rend();
+  bool operator()(const char* str, size_t length) const {
+    return length >= suffix_.size() &&
+        std::equal(
+               suffix_.begin(), suffix_.end(), str + length - suffix_.size());
   }
 
  private:
@@ -73,9 +282,12 @@ struct EndsWith {
 
 struct Prefix {
   explicit Prefix(OperatorBase& op)
-      : length_(op.GetSingleArgument<int>("length", 3)) {}
-  std::string operator()(const std::string& str) {
-    return std::string(str.begin(), std::min(str.end(), str.begin() + length_));
+      : length_(op.GetSingleArgument<int>("length", 3)) {
+    CAFFE_ENFORCE_GE(length_, 0);
+  }
+  std::pair<size_t, size_t> operator()(const char* /*str*/, size_t length)
+      const {
+    return std::make_pair(size_t(0), std::min<size_t>(length, length_));
   }
 
  private:
@@ -84,40 +296,98 @@ struct Prefix {
 
 struct Suffix {
   explicit Suffix(OperatorBase& op)
-      : length_(op.GetSingleArgument<int>("length", 3)) {}
-  std::string operator()(const std::string& str) {
-    return std::string(std::max(str.begin(), str.end() - length_), str.end());
+      : length_(op.GetSingleArgument<int>("length", 3)) {
+    CAFFE_ENFORCE_GE(length_, 0);
+  }
+  std::pair<size_t, size_t> operator()(const char* /*str*/, size_t length)
+      const {
+    const size_t n = std::min<size_t>(length, length_);
+    return std::make_pair(length - n, n);
   }
 
  private:
   int length_;
 };
 
-template <typename ScalarFunctor, typename TypeMap = FixedType<std::string>>
-using StringElementwiseOp = UnaryElementwiseWithArgsOp<
-    TensorTypes<std::string>,
-    CPUContext,
-    ForEach<ScalarFunctor>,
-    TypeMap>;
-
-REGISTER_CPU_OPERATOR(StringPrefix, StringElementwiseOp<Prefix>);
-REGISTER_CPU_OPERATOR(StringSuffix, StringElementwiseOp<Suffix>);
-REGISTER_CPU_OPERATOR(
-    StringStartsWith,
-    StringElementwiseOp<StartsWith, FixedType<bool>>);
-REGISTER_CPU_OPERATOR(
-    StringEndsWith,
-    StringElementwiseOp<EndsWith, FixedType<bool>>);
+class StringPackOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  using Operator<CPUContext>::Operator;
+
+  bool RunOnDevice() override {
+    const auto& input = Input(0);
+    const auto* in = input.data<std::string>();
+    auto* lengths = Output(0);
+    auto* bytes = Output(1);
+    lengths->ResizeLike(input);
+    auto* lengthsData = lengths->mutable_data<int>();
+    std::vector<TIndex> offsets(input.size() + 1, 0);
+    for (TIndex i = 0; i < input.size(); ++i) {
+      CAFFE_ENFORCE_LE(in[i].size(), std::numeric_limits<int>::max());
+      lengthsData[i] = in[i].size();
+      offsets[i + 1] = offsets[i] + in[i].size();
+    }
+    bytes->Resize(offsets.back());
+    auto* out = reinterpret_cast<char*>(bytes->mutable_data<uint8_t>());
+    ParallelFor(
+        IntraOpThreadPool(),
+        input.size(),
+        kStringParallelGrain,
+        [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            std::memcpy(out + offsets[i], in[i].data(), in[i].size());
+          }
+        });
+    return true;
+  }
+};
+
+class StringUnpackOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  using Operator<CPUContext>::Operator;
+
+  bool RunOnDevice() override {
+    const auto& lengths = Input(0);
+    PackedStrings in(lengths, Input(1));
+    auto* output = Output(0);
+    output->ResizeLike(lengths);
+    auto* out = output->mutable_data<std::string>();
+    ParallelFor(
+        IntraOpThreadPool(),
+        in.size(),
+        kStringParallelGrain,
+        [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            out[i].assign(in.data(i), in.length(i));
+          }
+        });
+    return true;
+  }
+};
+
+bool OneOrTwoInputsAsOutputs(int in, int out) {
+  return (in == 1 || in == 2) && out == in;
+}
+
+REGISTER_CPU_OPERATOR(StringPrefix, StringSubstringOp<Prefix>);
+REGISTER_CPU_OPERATOR(StringSuffix, StringSubstringOp<Suffix>);
+REGISTER_CPU_OPERATOR(StringStartsWith, StringPredicateOp<StartsWith>);
+REGISTER_CPU_OPERATOR(StringEndsWith, StringPredicateOp<EndsWith>);
 REGISTER_CPU_OPERATOR(StringJoin, StringJoinOp<CPUContext>);
+REGISTER_CPU_OPERATOR(StringPack, StringPackOp);
+REGISTER_CPU_OPERATOR(StringUnpack, StringUnpackOp);
+REGISTER_CPU_OPERATOR(StringTokenizeHash, StringTokenizeHashOp);
 
 OPERATOR_SCHEMA(StringPrefix)
-    .NumInputs(1)
-    .NumOutputs(1)
+    .NumInputsOutputs(OneOrTwoInputsAsOutputs)
     .SetDoc(R"DOC(
 Computes the element-wise string prefix of the string tensor.
 Input strings that are shorter than prefix length will be returned unchanged.
 NOTE: Prefix is computed on number of bytes, which may lead to wrong behavior
 and potentially invalid strings for variable-length encodings such as utf-8.
+The strings may also be given packed, as the `lengths` and `bytes` produced by
+StringPack, in which case the prefixes are output packed the same way.
 )DOC")
     .Arg("length", "Maximum size of the prefix, in bytes.")
     .Input(0, "strings", "Tensor of std::string.")
@@ -127,13 +397,14 @@ and potentially invalid strings for variable-length encodings such as utf-8.
         "Tensor of std::string containing prefixes for each input.");
 
 OPERATOR_SCHEMA(StringSuffix)
-    .NumInputs(1)
-    .NumOutputs(1)
+    .NumInputsOutputs(OneOrTwoInputsAsOutputs)
     .SetDoc(R"DOC(
 Computes the element-wise string suffix of the string tensor.
 Input strings that are shorter than suffix length will be returned unchanged.
 NOTE: Prefix is computed on number of bytes, which may lead to wrong behavior
 and potentially invalid strings for variable-length encodings such as utf-8.
+The strings may also be given packed, as the `lengths` and `bytes` produced by
+StringPack, in which case the suffixes are output packed the same way.
 )DOC")
     .Input(0, "strings", "Tensor of std::string.")
     .Output(
@@ -143,22 +414,26 @@ and potentially invalid strings for variable-length encodings such as utf-8.
     .Arg("length", "Maximum size of the suffix, in bytes.");
 
 OPERATOR_SCHEMA(StringStartsWith)
-    .NumInputs(1)
+    .NumInputs(1, 2)
     .NumOutputs(1)
     .SetDoc(R"DOC(
 Performs the starts-with check on each string in the input tensor.
 Returns tensor of boolean of the same dimension of input.
+The strings may also be given packed, as the `lengths` and `bytes` produced by
+StringPack.
 )DOC")
     .Arg("prefix", "The prefix to check input strings against.")
     .Input(0, "strings", "Tensor of std::string.")
     .Output(0, "bools", "Tensor of bools of same shape as input.");
 
 OPERATOR_SCHEMA(StringEndsWith)
-    .NumInputs(1)
+    .NumInputs(1, 2)
     .NumOutputs(1)
     .SetDoc(R"DOC(
 Performs the ends-with check on each string in the input tensor.
 Returns tensor of boolean of the same dimension of input.
+The strings may also be given packed, as the `lengths` and `bytes` produced by
+StringPack.
 )DOC")
     .Arg("suffix", "The suffix to check input strings against.")
     .Input(0, "strings", "Tensor of std::string.")
@@ -183,10 +458,54 @@ element is treated as a row.
         "1-D tensor of strings created by joining row elements from the "
         "input tensor.");
 
+OPERATOR_SCHEMA(StringPack)
+    .NumInputs(1)
+    .NumOutputs(2)
+    .SetDoc(R"DOC(
+Packs a tensor of strings into the lengths of the strings and a single buffer
+with their bytes back to back, which the string operators accept in place of
+a tensor of std::string.
+)DOC")
+    .Input(0, "strings", "Tensor of std::string.")
+    .Output(0, "lengths", "int32 tensor of the same shape as strings.")
+    .Output(1, "bytes", "1-D uint8 tensor of the bytes of all the strings.");
+
+OPERATOR_SCHEMA(StringUnpack)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Unpacks the strings packed by StringPack into a tensor of std::string.
+)DOC")
+    .Input(0, "lengths", "int32 tensor of the lengths of the strings.")
+    .Input(1, "bytes", "1-D uint8 tensor of the bytes of all the strings.")
+    .Output(0, "strings", "Tensor of std::string of the shape of lengths.");
+
+OPERATOR_SCHEMA(StringTokenizeHash)
+    .NumInputs(1, 2)
+    .NumOutputs(2)
+    .SetDoc(R"DOC(
+Splits each string into tokens, the runs of bytes that aren't delimiters, and
+hashes each token to an id with MurmurHash3. The ids of all the tokens are
+output in a single tensor, along with the number of tokens of each string.
+The strings may also be given packed, as the `lengths` and `bytes` produced by
+StringPack.
+)DOC")
+    .Arg("delimiters", "Bytes separating tokens (Default: whitespace).")
+    .Arg(
+        "num_buckets",
+        "If positive, the ids are the hashes modulo num_buckets (Default: 0).")
+    .Arg("seed", "Seed of the hash (Default: 0).")
+    .Input(0, "strings", "Tensor of std::string.")
+    .Output(0, "lengths", "1-D int32 tensor of the number of tokens per string.")
+    .Output(1, "ids", "1-D int64 tensor of the ids of all the tokens.");
+
 SHOULD_NOT_DO_GRADIENT(StringPrefix);
 SHOULD_NOT_DO_GRADIENT(StringSuffix);
 SHOULD_NOT_DO_GRADIENT(StringStartsWith);
 SHOULD_NOT_DO_GRADIENT(StringEndsWith);
 SHOULD_NOT_DO_GRADIENT(StringJoin);
+SHOULD_NOT_DO_GRADIENT(StringPack);
+SHOULD_NOT_DO_GRADIENT(StringUnpack);
+SHOULD_NOT_DO_GRADIENT(StringTokenizeHash);
 }
 } // namespace caffe2
@@ -1,6 +1,9 @@
 #ifndef CAFFE2_OPERATORS_STRING_OPS_H_
 #define CAFFE2_OPERATORS_STRING_OPS_H_
 
+#include <array>
+#include <vector>
+
 #include "caffe2/core/operator.h"
 #include "caffe2/operators/elementwise_op.h"
 
@@ -34,6 +37,71 @@ using StringElementwiseOp = UnaryElementwiseWithArgsOp<
     ForEach<ScalarFunctor>,
     TypeMap>;
 
+// The smallest number of strings that the string operators hand to a thread
+// of the pool
+constexpr size_t kStringParallelGrain = 1024;
+
+/**
+ * The string operators below take either a tensor of std::string, or the
+ * same strings packed as a pair of tensors: the int32 lengths of the strings,
+ * and a uint8 tensor with their bytes back to back (see StringPack). The
+ * packed form holds any number of strings in two allocations.
+ */
+class PackedStrings {
+ public:
+  PackedStrings(const TensorCPU& lengths, const TensorCPU& bytes);
+
+  TIndex size() const {
+    return offsets_.size() - 1;
+  }
+  const char* data(TIndex i) const {
+    return bytes_ + offsets_[i];
+  }
+  size_t length(TIndex i) const {
+    return offsets_[i + 1] - offsets_[i];
+  }
+
+ private:
+  const char* bytes_;
+  std::vector<TIndex> offsets_;
+};
+
+/**
+ * StringPredicateOp outputs a bool for each input string, the result of
+ * calling Functor(const char* str, size_t length).
+ */
+template <typename Functor>
+class StringPredicateOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  StringPredicateOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws), functor_(*this) {}
+
+  bool RunOnDevice() override;
+
+ private:
+  Functor functor_;
+};
+
+/**
+ * StringSubstringOp outputs a substring of each input string, given by the
+ * (begin, length) pair that Functor(const char* str, size_t length) returns.
+ * Packed strings give packed outputs. The output strings reuse the memory of
+ * the previous run's, so that they aren't reallocated for every batch.
+ */
+template <typename Functor>
+class StringSubstringOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  StringSubstringOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws), functor_(*this) {}
+
+  bool RunOnDevice() override;
+
+ private:
+  Functor functor_;
+};
+
 template <class Context>
 class StringJoinOp final : public Operator<Context> {
  public:
@@ -69,6 +137,48 @@ class StringJoinOp final : public Operator<Context> {
   int axis_;
 };
 
+/**
+ * StringTokenizeHashOp splits each input string into the runs of
+ * non-delimiter bytes, and outputs the number of tokens of each string and
+ * the hashes of all the tokens.
+ */
+class StringTokenizeHashOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+
+  StringTokenizeHashOp(const OperatorDef& operator_def, Workspace* ws);
+
+  bool RunOnDevice() override;
+
+ private:
+  // get(i) returns the (data, length) pair of the i-th of the n strings
+  template <typename GetString>
+  void TokenizeAndHash(TIndex n, GetString get);
+
+  template <typename F>
+  void ForEachToken(const char* str, size_t length, F f) const {
+    size_t i = 0;
+    while (i < length) {
+      while (i < length && is_delimiter_[static_cast<uint8_t>(str[i])]) {
+        ++i;
+      }
+      const size_t begin = i;
+      while (i < length && !is_delimiter_[static_cast<uint8_t>(str[i])]) {
+        ++i;
+      }
+      if (i > begin) {
+        f(str + begin, i - begin);
+      }
+    }
+  }
+
+  int64_t Hash(const char* token, size_t length) const;
+
+  std::array<bool, 256> is_delimiter_;
+  int64_t num_buckets_;
+  uint32_t seed_;
+};
+
 } // namespace caffe2
 
 #endif // CAFFE2_OPERATORS_STRING_OPS_H_
@@ -1,19 +1,246 @@
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
 #include "caffe2/core/tensor.h"
+#include "caffe2/core/timer.h"
 #include "caffe2/core/types.h"
 #include "caffe2/operators/text_file_reader_utils.h"
 #include "caffe2/utils/string_utils.h"
+#include "caffe2/utils/thread_pool.h"
+
+#include <condition_variable>
+#include <deque>
 
 namespace caffe2 {
 
+inline void convert(
+    TensorProto_DataType dst_type,
+    const char* src_start,
+    const char* src_end,
+    void* dst) {
+  switch (dst_type) {
+    case TensorProto_DataType_STRING: {
+      static_cast<std::string*>(dst)->assign(src_start, src_end);
+    } break;
+    case TensorProto_DataType_FLOAT: {
+      // TODO(azzolini): avoid copy, use faster convertion
+      std::string str_copy(src_start, src_end);
+      const char* src_copy = str_copy.c_str();
+      char* src_copy_end;
+      float val = strtof(src_copy, &src_copy_end);
+      if (src_copy == src_copy_end) {
+        throw std::runtime_error("Invalid float: " + str_copy);
+      }
+      *static_cast<float*>(dst) = val;
+    } break;
+    default:
+      throw std::runtime_error("Unsupported type.");
+  }
+}
+
+// Reads a memory-mapped file in chunks of whole rows, which a thread pool
+// tokenizes and converts into one tensor per field ahead of the reader.
+// Chunks are handed out in file order, so rows come out in the same order as
+// from the sequential reader.
+class ChunkedTextFileReader {
+ public:
+  ChunkedTextFileReader(
+      const std::vector<char>& delims,
+      char escape,
+      const std::string& filename,
+      int numPasses,
+      const std::vector<int>& fieldTypes,
+      const std::vector<TypeMeta>& fieldMetas,
+      int numThreads,
+      size_t chunkSize)
+      : tokenizer_(delims, escape),
+        filename_(filename),
+        file_(filename),
+        chunkEnds_(SplitIntoRowChunks(
+            file_.data(),
+            file_.size(),
+            chunkSize,
+            delims.at(0),
+            escape)),
+        numChunks_(chunkEnds_.size() * numPasses),
+        maxChunksInFlight_(2 * numThreads),
+        fieldTypes_(fieldTypes),
+        fieldMetas_(fieldMetas),
+        stats_("text_file_reader/" + filename),
+        pool_(numThreads) {}
+
+  // Writes up to batchSize rows into datas, one pointer per field, and
+  // returns how many it wrote. Not thread safe.
+  int read(int batchSize, std::vector<char*>& datas) {
+    int rowsRead = 0;
+    while (rowsRead < batchSize) {
+      schedule();
+      if (chunks_.empty()) {
+        break;
+      }
+      auto chunk = chunks_.front();
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&chunk] { return chunk->done; });
+      }
+      if (!chunk->error.empty()) {
+        CAFFE_THROW(chunk->error);
+      }
+      const size_t n =
+          std::min<size_t>(batchSize - rowsRead, chunk->rows - rowInChunk_);
+      for (int i = 0; i < fieldMetas_.size(); ++i) {
+        const auto& meta = fieldMetas_[i];
+        const char* src =
+            static_cast<const char*>(chunk->fields[i].raw_data()) +
+            rowInChunk_ * meta.itemsize();
+        if (meta.copy()) {
+          meta.copy()(src, datas[i], n);
+        } else {
+          memcpy(datas[i], src, n * meta.itemsize());
+        }
+        datas[i] += n * meta.itemsize();
+      }
+      rowsRead += n;
+      rowInChunk_ += n;
+      rowsInPass_ += n;
+      if (rowInChunk_ == chunk->rows) {
+        chunks_.pop_front();
+        rowInChunk_ = 0;
+        ++chunksRead_;
+        if (chunksRead_ % chunkEnds_.size() == 0) {
+          logPassThroughput();
+        }
+      }
+    }
+    return rowsRead;
+  }
+
+ private:
+  struct Chunk {
+    std::vector<TensorCPU> fields;
+    size_t rows{0};
+    std::string error;
+    bool done{false};
+  };
+
+  // Queues the next chunks until maxChunksInFlight_ are parsed or being
+  // parsed ahead of the reader
+  void schedule() {
+    while (chunks_.size() < maxChunksInFlight_ &&
+           chunksScheduled_ < numChunks_) {
+      const size_t index = chunksScheduled_++ % chunkEnds_.size();
+      const size_t begin = index == 0 ? 0 : chunkEnds_[index - 1];
+      const size_t end = chunkEnds_[index];
+      auto chunk = std::make_shared<Chunk>();
+      chunks_.push_back(chunk);
+      pool_.runTask([this, chunk, begin, end]() {
+        parse(chunk.get(), file_.data() + begin, file_.data() + end);
+        std::lock_guard<std::mutex> guard(mutex_);
+        chunk->done = true;
+        cv_.notify_all();
+      });
+    }
+  }
+
+  void parse(Chunk* chunk, char* start, char* end) {
+    Timer timer;
+    const int numFields = fieldTypes_.size();
+    Tokenizer tokenizer(tokenizer_);
+    tokenizer.reset();
+    TokenizedString tokenized;
+    tokenizer.next(start, end, tokenized);
+    const auto& tokens = tokenized.tokens();
+    if (tokens.size() % numFields != 0) {
+      chunk->error = "Invalid number of fields in the rows at byte " +
+          to_string(start - file_.data()) + " of " + filename_;
+      return;
+    }
+    chunk->rows = tokens.size() / numFields;
+    chunk->fields.resize(numFields);
+    std::vector<char*> datas(numFields);
+    for (int i = 0; i < numFields; ++i) {
+      chunk->fields[i].Resize(chunk->rows);
+      datas[i] = static_cast<char*>(
+          chunk->fields[i].raw_mutable_data(fieldMetas_[i]));
+    }
+    try {
+      for (size_t row = 0; row < chunk->rows; ++row) {
+        for (int field = 0; field < numFields; ++field) {
+          const auto& token = tokens[row * numFields + field];
+          if ((field == 0) != (token.startDelimId == 0)) {
+            throw std::runtime_error(
+                "Invalid number of columns at row " + to_string(row + 1) +
+                " of the rows at byte " + to_string(start - file_.data()) +
+                " of " + filename_);
+          }
+          convert(
+              static_cast<TensorProto_DataType>(fieldTypes_[field]),
+              token.start,
+              token.end,
+              datas[field]);
+          datas[field] += fieldMetas_[field].itemsize();
+        }
+      }
+    } catch (const std::exception& e) {
+      chunk->error = e.what();
+      return;
+    }
+    CAFFE_EVENT(stats_, bytes_parsed, end - start);
+    CAFFE_EVENT(stats_, rows_parsed, chunk->rows);
+    CAFFE_EVENT(stats_, chunk_parse_time_ns, timer.NanoSeconds());
+  }
+
+  void logPassThroughput() {
+    const float seconds = passTimer_.Seconds();
+    const float megabytes = file_.size() / (1024.0 * 1024.0);
+    LOG(INFO) << "TextFileReader read pass "
+              << chunksRead_ / chunkEnds_.size() << " of " << filename_ << ": "
+              << rowsInPass_ << " rows, " << megabytes << " MB in " << seconds
+              << " s, " << megabytes / seconds << " MB/s, "
+              << rowsInPass_ / seconds << " rows/s";
+    rowsInPass_ = 0;
+    passTimer_.Start();
+  }
+
+  const Tokenizer tokenizer_;
+  const std::string filename_;
+  const MappedFile file_;
+  const std::vector<size_t> chunkEnds_;
+  const size_t numChunks_;
+  const size_t maxChunksInFlight_;
+  const std::vector<int> fieldTypes_;
+  const std::vector<TypeMeta> fieldMetas_;
+
+  std::deque<std::shared_ptr<Chunk>> chunks_;
+  size_t chunksScheduled_{0};
+  size_t chunksRead_{0};
+  size_t rowInChunk_{0};
+  size_t rowsInPass_{0};
+  Timer passTimer_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+
+  struct TextFileReaderStats {
+    CAFFE_STAT_CTOR(TextFileReaderStats);
+    CAFFE_EXPORTED_STAT(bytes_parsed);
+    CAFFE_EXPORTED_STAT(rows_parsed);
+    CAFFE_AVG_EXPORTED_STAT(chunk_parse_time_ns);
+  } stats_;
+
+  // last, so that its threads are joined before anything they use goes away
+  TaskThreadPool pool_;
+};
+
 struct TextFileReaderInstance {
   TextFileReaderInstance(
       const std::vector<char>& delims,
       char escape,
       const std::string& filename,
       int numPasses,
-      const std::vector<int>& types)
+      const std::vector<int>& types,
+      int numThreads = 0,
+      size_t chunkSize = 0)
       : fileReader(filename),
         tokenizer(Tokenizer(delims, escape), &fileReader, numPasses),
         fieldTypes(types) {
@@ -22,10 +249,23 @@ struct TextFileReaderInstance {
           DataTypeToTypeMeta(static_cast<TensorProto_DataType>(dt)));
       fieldByteSizes.push_back(fieldMetas.back().itemsize());
     }
+    if (numThreads > 0) {
+      chunkedReader.reset(new ChunkedTextFileReader(
+          delims,
+          escape,
+          filename,
+          numPasses,
+          fieldTypes,
+          fieldMetas,
+          numThreads,
+          chunkSize));
+    }
   }
 
   FileReader fileReader;
   BufferedTokenizer tokenizer;
+  // reads instead of the tokenizer if num_threads is positive
+  std::unique_ptr<ChunkedTextFileReader> chunkedReader;
   std::vector<int> fieldTypes;
   std::vector<TypeMeta> fieldMetas;
   std::vector<size_t> fieldByteSizes;
@@ -42,14 +282,24 @@ class CreateTextFileReaderOp : public Operator<CPUContext> {
       : Operator<CPUContext>(operator_def, ws),
         filename_(GetSingleArgument<string>("filename", "")),
         numPasses_(GetSingleArgument<int>("num_passes", 1)),
-        fieldTypes_(GetRepeatedArgument<int>("field_types")) {
+        fieldTypes_(GetRepeatedArgument<int>("field_types")),
+        numThreads_(GetSingleArgument<int>("num_threads", 0)),
+        chunkSize_(GetSingleArgument<int64_t>("chunk_size", 4 << 20)) {
     CAFFE_ENFORCE(fieldTypes_.size() > 0, "field_types arg must be non-empty");
+    CAFFE_ENFORCE_GE(numThreads_, 0);
+    CAFFE_ENFORCE_GT(chunkSize_, 0);
   }
 
   bool RunOnDevice() override {
     *OperatorBase::Output<std::unique_ptr<TextFileReaderInstance>>(0) =
         std::unique_ptr<TextFileReaderInstance>(new TextFileReaderInstance(
-            {'\n', '\t'}, '\0', filename_, numPasses_, fieldTypes_));
+            {'\n', '\t'},
+            '\0',
+            filename_,
+            numPasses_,
+            fieldTypes_,
+            numThreads_,
+            chunkSize_));
     return true;
   }
 
@@ -57,33 +307,10 @@ class CreateTextFileReaderOp : public Operator<CPUContext> {
   std::string filename_;
   int numPasses_;
   std::vector<int> fieldTypes_;
+  int numThreads_;
+  int64_t chunkSize_;
 };
 
-inline void convert(
-    TensorProto_DataType dst_type,
-    const char* src_start,
-    const char* src_end,
-    void* dst) {
-  switch (dst_type) {
-    case TensorProto_DataType_STRING: {
-      static_cast<std::string*>(dst)->assign(src_start, src_end);
-    } break;
-    case TensorProto_DataType_FLOAT: {
-      // TODO(azzolini): avoid copy, use faster convertion
-      std::string str_copy(src_start, src_end);
-      const char* src_copy = str_copy.c_str();
-      char* src_copy_end;
-      float val = strtof(src_copy, &src_copy_end);
-      if (src_copy == src_copy_end) {
-        throw std::runtime_error("Invalid float: " + str_copy);
-      }
-      *static_cast<float*>(dst) = val;
-    } break;
-    default:
-      throw std::runtime_error("Unsupported type.");
-  }
-}
-
 class TextFileReaderReadOp : public Operator<CPUContext> {
  public:
   TextFileReaderReadOp(const OperatorDef& operator_def, Workspace* ws)
@@ -113,7 +340,11 @@ class TextFileReaderReadOp : public Operator<CPUContext> {
     }
 
     int rowsRead = 0;
-    {
+    if (instance->chunkedReader) {
+      std::lock_guard<std::mutex> guard(instance->globalMutex_);
+      rowsRead = instance->chunkedReader->read(batchSize_, datas);
+      instance->rowsRead += rowsRead;
+    } else {
       // TODO(azzolini): support multi-threaded reading
       std::lock_guard<std::mutex> guard(instance->globalMutex_);
 
@@ -170,6 +401,13 @@ OPERATOR_SCHEMA(CreateTextFileReader)
     .SetDoc("Create a text file reader. Fields are delimited by <TAB>.")
     .Arg("filename", "Path to the file.")
     .Arg("num_passes", "Number of passes over the file.")
+    .Arg(
+        "num_threads",
+        "If positive, the file is memory-mapped and split into chunks of "
+        "whole rows that this many threads parse ahead of the reads, which "
+        "still return the rows in file order. Defaults to 0, reading and "
+        "parsing on the calling thread.")
+    .Arg("chunk_size", "Size in bytes of the chunks with num_threads.")
     .Arg(
         "field_types",
         "List with type of each field. Type enum is found at core.DataType.")
@@ -1,6 +1,9 @@
 #include "caffe2/operators/text_file_reader_utils.h"
 
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <sstream>
@@ -116,4 +119,83 @@ void FileReader::operator()(CharRange& range) {
   range.start = buffer;
   range.end = buffer + numRead;
 }
+
+MappedFile::MappedFile(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(
+        "Error opening file for reading: " + std::string(std::strerror(errno)) +
+        " Path=" + path);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error(
+        "Error reading file size: " + std::string(std::strerror(errno)) +
+        " Path=" + path);
+  }
+  size_ = st.st_size;
+  if (size_ > 0) {
+    void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error(
+          "Error mapping file: " + std::string(std::strerror(errno)) +
+          " Path=" + path);
+    }
+    data_ = static_cast<char*>(addr);
+    // the chunks are tokenized front to back
+    madvise(addr, size_, MADV_SEQUENTIAL);
+  }
+  // the mapping stays valid after the file is closed
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_) {
+    munmap(data_, size_);
+  }
+}
+
+std::vector<size_t> SplitIntoRowChunks(
+    const char* data,
+    size_t size,
+    size_t chunkSize,
+    char rowDelim,
+    char escape) {
+  std::vector<size_t> ends;
+  size_t pos = 0;
+  while (pos < size) {
+    size_t end = pos + std::max<size_t>(chunkSize, 1);
+    if (end >= size) {
+      ends.push_back(size);
+      break;
+    }
+    // the first row delimiter at or after end - 1 that isn't escaped, i.e.
+    // that a run of an even number of escape characters precedes
+    const char* ch = data + end - 1;
+    const char* last = data + size;
+    while (true) {
+      ch = static_cast<const char*>(std::memchr(ch, rowDelim, last - ch));
+      if (ch == nullptr) {
+        break;
+      }
+      size_t numEscapes = 0;
+      while (ch - numEscapes > data + pos && *(ch - numEscapes - 1) == escape) {
+        ++numEscapes;
+      }
+      if (numEscapes % 2 == 0) {
+        break;
+      }
+      ++ch;
+    }
+    if (ch == nullptr) {
+      ends.push_back(size);
+      break;
+    }
+    pos = ch - data + 1;
+    ends.push_back(pos);
+  }
+  return ends;
 }
+} // namespace caffe2
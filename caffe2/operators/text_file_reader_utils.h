@@ -117,6 +117,37 @@ class FileReader : public StringProvider {
   std::unique_ptr<char[]> buffer_;
 };
 
+// A whole file mapped read-only into memory
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+
+  // The mapping is read-only: the Tokenizer doesn't write through the
+  // pointers it gets, it only needs them to be non-const
+  char* data() const {
+    return data_;
+  }
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  char* data_{nullptr};
+  size_t size_{0};
+};
+
+// Splits [data, data + size) into chunks of about chunkSize bytes that end
+// right after an unescaped row delimiter, so that every chunk can be
+// tokenized on its own. Returns the end offset of every chunk, the last one
+// being size.
+std::vector<size_t> SplitIntoRowChunks(
+    const char* data,
+    size_t size,
+    size_t chunkSize,
+    char rowDelim,
+    char escape);
+
 } // namespace caffe2
 
 #endif // CAFFE2_OPERATORS_TEXT_FILE_READER_UTILS_H
@@ -119,4 +119,43 @@ TEST(TextFileReaderUtilsTest, TokenizeTest) {
   std::remove(tmpname);
 }
 
+TEST(TextFileReaderUtilsTest, SplitIntoRowChunksTest) {
+  std::string ch = "a\tb\nlonger\\\nrow\n\\\\\nc\n\nlast";
+  for (size_t chunkSize = 1; chunkSize <= ch.size() + 1; ++chunkSize) {
+    auto ends =
+        SplitIntoRowChunks(ch.data(), ch.size(), chunkSize, '\n', '\\');
+    ASSERT_FALSE(ends.empty());
+    EXPECT_EQ(ch.size(), ends.back());
+    size_t begin = 0;
+    for (int i = 0; i < ends.size(); ++i) {
+      EXPECT_LT(begin, ends[i]);
+      if (i + 1 < ends.size()) {
+        // ends right after a row delimiter that isn't escaped
+        EXPECT_GE(ends[i] - begin, chunkSize);
+        EXPECT_EQ('\n', ch[ends[i] - 1]);
+        EXPECT_NE(11, ends[i] - 1) << "escaped delimiter";
+      }
+      begin = ends[i];
+    }
+  }
+  auto ends = SplitIntoRowChunks(ch.data(), ch.size(), 6, '\n', '\\');
+  std::vector<size_t> expected = {16, 22, ch.size()};
+  EXPECT_EQ(expected, ends);
+  EXPECT_TRUE(SplitIntoRowChunks(ch.data(), 0, 6, '\n', '\\').empty());
+}
+
+TEST(TextFileReaderUtilsTest, MappedFileTest) {
+  std::string ch = "label\ttext\nlabel2\ttext2\n";
+  char* tmpname = std::tmpnam(nullptr);
+  std::ofstream outFile;
+  outFile.open(tmpname);
+  outFile << ch;
+  outFile.close();
+  {
+    MappedFile file(tmpname);
+    EXPECT_EQ(ch, std::string(file.data(), file.size()));
+  }
+  std::remove(tmpname);
+}
+
 } // namespace caffe2
@@ -9,6 +9,7 @@
 #include "caffe2/core/operator.h"
 #include "caffe2/core/types.h"
 #include "caffe2/utils/math.h"
+#include "caffe2/utils/mmap_prefetch.h"
 
 #include <map>
 #include <utility>
@@ -1019,7 +1020,6 @@ class GatherOp : public Operator<Context> {
   template <typename Index>
   bool DoRunWithType() {
     // If we endup using it on GPU doing O(N) memcpy is probably not best :)
-    // TODO: implement prefetching if it starts mattering (TF does it)
     auto& data = Input(DATA);
     auto& indices = Input(INDICES);
     auto* output = Output(0);
@@ -1037,6 +1037,9 @@ class GatherOp : public Operator<Context> {
     const Index* idxs = indices.template data<Index>();
     auto out = static_cast<char*>(output->raw_mutable_data(data.meta()));
 
+    // tables mapped from disk have all the rows gathered read ahead
+    PrefetchMappedRows(src_base, block_bytesize, idxs, N);
+
     for (int i = 0; i < N; ++i) {
       auto idx = idxs[i];
       CAFFE_ENFORCE(
@@ -0,0 +1,250 @@
+#include "caffe2/opt/fusion.h"
+
+#include <deque>
+#include <unordered_set>
+
+#include "caffe2/operators/concat_split_op.h"
+#include "caffe2/operators/fused_elementwise_op.h"
+#include "caffe2/utils/proto_utils.h"
+#include "nomnigraph/Converters/Caffe2.h"
+#include "nomnigraph/Transformations/OperatorFusion.h"
+
+namespace caffe2 {
+namespace opt {
+
+using nom::repr::NNGraph;
+using nom::transformations::OperatorChainPattern;
+using NodeRef = NNGraph::NodeRef;
+
+namespace {
+
+OperatorDef* getDef(NodeRef node) {
+  auto* nnOp = nom::repr::nn::get<nom::repr::NeuralNetOperator>(node);
+  return static_cast<OperatorDef*>(nnOp->getAnnotation()->getSaved());
+}
+
+const string getName(NodeRef tensor) {
+  return nom::repr::nn::get<nom::repr::NeuralNetData>(tensor)->getName();
+}
+
+bool isDefaultCPU(const OperatorDef& def) {
+  return def.engine().empty() &&
+      (!def.has_device_option() || def.device_option().device_type() == CPU);
+}
+
+// The unary operators that the operator runs, or nothing if it cannot be
+// fused. The operators fused have no arguments.
+std::vector<string> getUnaryTypes(const OperatorDef& def) {
+  if (!isDefaultCPU(def) || def.input_size() != 1 || def.output_size() != 1) {
+    return {};
+  }
+  if (def.type() == "FusedElementwise") {
+    return ArgumentHelper(def).GetRepeatedArgument<string>("ops");
+  }
+  if (FusedUnaryFunctions().count(def.type())) {
+    return {def.type()};
+  }
+  return {};
+}
+
+bool isUnary(NodeRef node) {
+  return !getUnaryTypes(*getDef(node)).empty();
+}
+
+bool isFC(NodeRef node) {
+  const auto& def = *getDef(node);
+  return (def.type() == "FC" || def.type() == "FCActivation") &&
+      isDefaultCPU(def) && def.input_size() == 3 && def.output_size() == 1;
+}
+
+bool isConcat(NodeRef node) {
+  return getDef(node)->type() == "Concat";
+}
+
+bool isSplit(NodeRef node) {
+  return getDef(node)->type() == "Split";
+}
+
+// The axis and add_axis of Concat and Split
+std::pair<int, int> getConcatAxis(const OperatorDef& def) {
+  ArgumentHelper args(def);
+  if (args.HasArgument("axis")) {
+    return std::make_pair(
+        args.GetSingleArgument<int>("axis", -1),
+        args.GetSingleArgument<int>("add_axis", 0));
+  }
+  return std::make_pair(
+      GetDimFromOrderString(args.GetSingleArgument<string>("order", "NCHW")),
+      0);
+}
+
+bool sameDevice(const OperatorDef& a, const OperatorDef& b) {
+  return a.device_option().device_type() == b.device_option().device_type() &&
+      a.device_option().cuda_gpu_id() == b.device_option().cuda_gpu_id();
+}
+
+class PatternFuser {
+ public:
+  explicit PatternFuser(const NetDef& net)
+      : externalOutputs_(
+            net.external_output().begin(),
+            net.external_output().end()) {}
+
+  std::vector<OperatorChainPattern> getPatterns() {
+    auto isRemovable = [this](NodeRef tensor) {
+      return !externalOutputs_.count(getName(tensor));
+    };
+
+    OperatorChainPattern fcActivation;
+    fcActivation.Elements = {{isFC, 1, 1}, {isUnary, 1, -1}};
+    fcActivation.IsRemovable = isRemovable;
+    fcActivation.Replace = [this](
+        nom::repr::NNModule* m, const std::vector<NodeRef>& chain) {
+      OperatorDef def = *getDef(chain.front());
+      std::vector<string> ops;
+      if (def.type() == "FCActivation") {
+        ops = ArgumentHelper(def).GetRepeatedArgument<string>("ops");
+      }
+      def.set_type("FCActivation");
+      replaceChain(m, chain, 1, def, ops);
+      return true;
+    };
+
+    OperatorChainPattern elementwise;
+    elementwise.Elements = {{isUnary, 2, -1}};
+    elementwise.IsRemovable = isRemovable;
+    elementwise.Replace = [this](
+        nom::repr::NNModule* m, const std::vector<NodeRef>& chain) {
+      OperatorDef def = *getDef(chain.front());
+      def.set_type("FusedElementwise");
+      def.clear_arg();
+      replaceChain(m, chain, 0, def, {});
+      return true;
+    };
+
+    OperatorChainPattern concatSplit;
+    concatSplit.Elements = {{isConcat, 1, 1}, {isSplit, 1, 1}};
+    concatSplit.IsRemovable = isRemovable;
+    concatSplit.Replace = [this](
+        nom::repr::NNModule* m, const std::vector<NodeRef>& chain) {
+      return removeConcatSplit(m, chain[0], chain[1]);
+    };
+
+    return {fcActivation, elementwise, concatSplit};
+  }
+
+ private:
+  // Replaces the chain with an operator of definition def, which runs the
+  // unary operators from chain[first] on after ops.
+  void replaceChain(
+      nom::repr::NNModule* m,
+      const std::vector<NodeRef>& chain,
+      int first,
+      OperatorDef def,
+      std::vector<string> ops) {
+    for (int i = first; i < chain.size(); ++i) {
+      for (const auto& type : getUnaryTypes(*getDef(chain[i]))) {
+        ops.push_back(type);
+      }
+    }
+    for (int i = 0; i < def.arg_size(); ++i) {
+      if (def.arg(i).name() == "ops") {
+        def.mutable_arg()->DeleteSubrange(i, 1);
+        break;
+      }
+    }
+    def.add_arg()->CopyFrom(MakeArgument<std::vector<string>>("ops", ops));
+    defs_.push_back(def);
+
+    auto op = nom::util::make_unique<nom::repr::GenericOperator>(def.type());
+    auto annotation = nom::util::make_unique<nom::repr::Annotation>();
+    annotation->setSaved(&defs_.back());
+    op->setAnnotation(std::move(annotation));
+    nom::transformations::replaceOperatorChain(m, chain, std::move(op));
+  }
+
+  // The outputs of a Split of the output of a Concat, with its split_info,
+  // are the inputs of the Concat.
+  bool
+  removeConcatSplit(nom::repr::NNModule* m, NodeRef concat, NodeRef split) {
+    const auto& concatDef = *getDef(concat);
+    const auto& splitDef = *getDef(split);
+    const auto inputs = nom::repr::nn::getInputs(concat);
+    const auto concatOutputs = nom::repr::nn::getOutputs(concat);
+    const auto splitInputs = nom::repr::nn::getInputs(split);
+    const auto outputs = nom::repr::nn::getOutputs(split);
+    if (concatOutputs.size() != 2 || splitInputs.size() != 2 ||
+        splitInputs[1] != concatOutputs[1] ||
+        outputs.size() != inputs.size() ||
+        getConcatAxis(concatDef) != getConcatAxis(splitDef) ||
+        ArgumentHelper(splitDef).HasArgument("split") ||
+        !sameDevice(concatDef, splitDef)) {
+      return false;
+    }
+    // The readers of the outputs must still see the inputs of the Concat.
+    const std::unordered_set<NodeRef> ignored{concat, split};
+    for (int i = 0; i < outputs.size(); ++i) {
+      if (externalOutputs_.count(getName(outputs[i]))) {
+        return false;
+      }
+      for (auto consumer : nom::repr::nn::getConsumers(outputs[i])) {
+        if (!nom::transformations::noWritesBetween(
+                m, concat, consumer, {getName(inputs[i])}, ignored)) {
+          return false;
+        }
+      }
+    }
+
+    auto& g = m->dataFlow;
+    for (int i = 0; i < outputs.size(); ++i) {
+      nom::repr::nn::replaceAllUsesWith(&g, outputs[i], inputs[i]);
+    }
+    g.deleteNode(concat);
+    g.deleteNode(split);
+    for (auto tensor : concatOutputs) {
+      g.deleteNode(tensor);
+    }
+    for (auto tensor : outputs) {
+      g.deleteNode(tensor);
+    }
+    return true;
+  }
+
+  std::unordered_set<string> externalOutputs_;
+  // The definitions of the fused operators, which the graph points to
+  std::deque<OperatorDef> defs_;
+};
+
+bool hasControlFlow(const NetDef& net) {
+  for (const auto& op : net.op()) {
+    if (op.type() == "While" || op.type() == "If") {
+      return true;
+    }
+    for (const auto& arg : op.arg()) {
+      if (arg.has_n() || arg.nets_size()) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+caffe2::NetDef fusePatterns(caffe2::NetDef net) {
+  if (hasControlFlow(net)) {
+    return net;
+  }
+  auto nn = nom::converters::convertFromCaffe2Proto(net);
+  PatternFuser fuser(net);
+  if (!nom::transformations::fuseOperatorChains(&nn, fuser.getPatterns())) {
+    return net;
+  }
+  auto fused = nom::converters::convertToCaffe2Proto(nn);
+  NetDef out = net;
+  out.mutable_op()->Swap(fused.mutable_op());
+  return out;
+}
+
+} // namespace opt
+} // namespace caffe2
@@ -0,0 +1,24 @@
+#ifndef CAFFE2_OPT_FUSION_H_
+#define CAFFE2_OPT_FUSION_H_
+
+#include "caffe2/core/common.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+namespace opt {
+
+// Fuses the operator patterns of an inference net, with the pattern fusion of
+// nomnigraph:
+//  - chains of float unary elementwise operators become FusedElementwise;
+//  - FC followed by such operators becomes FCActivation;
+//  - Split of the output of a Concat, along the same axis and with the split
+//    Concat outputs, is removed and the readers of its outputs read the
+//    inputs of the Concat.
+// Only CPU operators of the default engine are fused, and the external
+// outputs of the net are kept. Nets with control flow are left as they are.
+caffe2::NetDef fusePatterns(caffe2::NetDef net);
+
+} // namespace opt
+} // namespace caffe2
+
+#endif // CAFFE2_OPT_FUSION_H_
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/transform.h"
+#include "caffe2/opt/fusion.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+void AddRandomInput(
+    const std::vector<TIndex>& shape,
+    const string& name,
+    Workspace* ws) {
+  CPUContext context;
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(shape);
+  math::RandUniform<float, CPUContext>(
+      tensor->size(), 0.1f, 1.0f, tensor->mutable_data<float>(), &context);
+}
+
+std::vector<string> OpTypes(const NetDef& netdef) {
+  std::vector<string> types;
+  for (const auto& op : netdef.op()) {
+    types.push_back(op.type());
+  }
+  return types;
+}
+
+std::vector<string> FusedOps(const OperatorDef& op) {
+  return ArgumentHelper(op).GetRepeatedArgument<string>("ops");
+}
+
+NetDef CreateNet() {
+  NetDef netdef;
+  AddOp(&netdef, "FC", {"X", "W", "b"}, {"fc"});
+  AddOp(&netdef, "Relu", {"fc"}, {"fc"});
+  AddOp(&netdef, "Sigmoid", {"fc"}, {"s"});
+  AddOp(&netdef, "Concat", {"s", "X"}, {"cat", "cat_info"});
+  AddOp(&netdef, "Split", {"cat", "cat_info"}, {"s2", "X2"});
+  AddOp(&netdef, "Mul", {"s2", "s2"}, {"m"});
+  AddOp(&netdef, "Tanh", {"m"}, {"t"});
+  AddOp(&netdef, "Exp", {"t"}, {"t"});
+  AddOp(&netdef, "Sqrt", {"t"}, {"out"});
+  AddOp(&netdef, "Add", {"X2", "X"}, {"x_out"});
+  netdef.add_external_output("out");
+  netdef.add_external_output("x_out");
+  return netdef;
+}
+
+TEST(FusionTest, TestPatterns) {
+  NetDef fused = opt::fusePatterns(CreateNet());
+  EXPECT_EQ(
+      OpTypes(fused),
+      (std::vector<string>{"FCActivation", "Mul", "FusedElementwise", "Add"}));
+  EXPECT_EQ(FusedOps(fused.op(0)), (std::vector<string>{"Relu", "Sigmoid"}));
+  EXPECT_EQ(fused.op(0).output(0), "s");
+  // The readers of the split blobs read the inputs of the Concat
+  EXPECT_EQ(fused.op(1).input(0), "s");
+  EXPECT_EQ(fused.op(1).input(1), "s");
+  EXPECT_EQ(
+      FusedOps(fused.op(2)), (std::vector<string>{"Tanh", "Exp", "Sqrt"}));
+  EXPECT_EQ(fused.op(2).output(0), "out");
+  EXPECT_EQ(fused.op(3).input(0), "X");
+  EXPECT_EQ(fused.external_output_size(), 2);
+}
+
+TEST(FusionTest, TestLegality) {
+  NetDef netdef;
+  // An external output is not removed
+  AddOp(&netdef, "Relu", {"X"}, {"r"});
+  AddOp(&netdef, "Sigmoid", {"r"}, {"s"});
+  // Neither is a blob with two readers
+  AddOp(&netdef, "FC", {"s", "W", "b"}, {"fc"});
+  AddOp(&netdef, "Relu", {"fc"}, {"r2"});
+  AddOp(&netdef, "Tanh", {"fc"}, {"t2"});
+  // The input of the Tanh is overwritten before the Relu
+  AddOp(&netdef, "Tanh", {"Y"}, {"t3"});
+  AddOp(&netdef, "Copy", {"X"}, {"Y"});
+  AddOp(&netdef, "Relu", {"t3"}, {"r3"});
+  // Split does not undo a Concat along another axis
+  auto* op = AddOp(&netdef, "Concat", {"X", "Y"}, {"cat", "cat_info"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("axis", 0));
+  AddOp(&netdef, "Split", {"cat", "cat_info"}, {"X2", "Y2"});
+  netdef.add_external_output("r");
+
+  NetDef fused = opt::fusePatterns(netdef);
+  EXPECT_EQ(OpTypes(fused), OpTypes(netdef));
+}
+
+TEST(FusionTest, TestSameOutputs) {
+  Workspace ws;
+  AddRandomInput({4, 6}, "X", &ws);
+  AddRandomInput({6, 6}, "W", &ws);
+  AddRandomInput({6}, "b", &ws);
+  NetDef netdef = CreateNet();
+  ASSERT_TRUE(ws.RunNetOnce(netdef));
+  std::vector<TensorCPU> expected;
+  for (const auto& output : netdef.external_output()) {
+    expected.emplace_back(ws.GetBlob(output)->Get<TensorCPU>());
+  }
+
+  NetDef fused = ApplyTransform("PatternFusion", netdef);
+  ASSERT_EQ(fused.op_size(), 4);
+  ASSERT_TRUE(ws.RunNetOnce(fused));
+  for (int i = 0; i < netdef.external_output_size(); ++i) {
+    const auto& actual =
+        ws.GetBlob(netdef.external_output(i))->Get<TensorCPU>();
+    ASSERT_EQ(actual.dims(), expected[i].dims());
+    for (int j = 0; j < actual.size(); ++j) {
+      EXPECT_NEAR(actual.data<float>()[j], expected[i].data<float>()[j], 1e-4);
+    }
+  }
+}
+
+} // namespace
+
+} // namespace caffe2
@@ -0,0 +1,236 @@
+#include "caffe2/perfkernels/adagrad.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "caffe2/core/types.h"
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+namespace {
+
+// How many updates ahead the rows are prefetched
+constexpr TIndex kPrefetchDistance = 8;
+
+template <typename IndexType>
+inline void PrefetchRow(
+    TIndex u,
+    TIndex num_updates,
+    const int* positions,
+    const IndexType* indices,
+    const void* data,
+    TIndex row_bytes) {
+#ifdef __GNUC__
+  if (u + kPrefetchDistance < num_updates) {
+    const TIndex next = positions ? positions[u + kPrefetchDistance]
+                                  : u + kPrefetchDistance;
+    __builtin_prefetch(
+        static_cast<const char*>(data) + indices[next] * row_bytes, 1, 1);
+  }
+#endif // __GNUC__
+}
+
+} // namespace
+
+template <typename IndexType>
+static void SparseAdagradUpdateGenericSlow(
+    const TIndex block_size,
+    const TIndex num_updates,
+    const int* positions,
+    const IndexType* indices,
+    const float* grad,
+    float* param,
+    float* moment,
+    float epsilon,
+    float lr) {
+  for (TIndex u = 0; u < num_updates; ++u) {
+    PrefetchRow(
+        u,
+        num_updates,
+        positions,
+        indices,
+        param,
+        block_size * sizeof(float));
+    PrefetchRow(
+        u,
+        num_updates,
+        positions,
+        indices,
+        moment,
+        block_size * sizeof(float));
+    const TIndex i = positions ? positions[u] : u;
+    const float* g = grad + i * block_size;
+    float* w = param + indices[i] * block_size;
+    float* h = moment + indices[i] * block_size;
+    for (TIndex j = 0; j < block_size; ++j) {
+      const float gj = g[j];
+      const float hj = h[j] = h[j] + gj * gj;
+      w[j] += lr * gj / (std::sqrt(hj) + epsilon);
+    }
+  }
+}
+
+template <typename IndexType>
+static void RowWiseSparseAdagradUpdateGenericSlow(
+    const TIndex block_size,
+    const TIndex num_updates,
+    const int* positions,
+    const IndexType* indices,
+    const float* grad,
+    float* param,
+    float* moment,
+    float epsilon,
+    float lr) {
+  for (TIndex u = 0; u < num_updates; ++u) {
+    PrefetchRow(
+        u,
+        num_updates,
+        positions,
+        indices,
+        param,
+        block_size * sizeof(float));
+    const TIndex i = positions ? positions[u] : u;
+    const float* g = grad + i * block_size;
+    float* w = param + indices[i] * block_size;
+    float* h = moment + indices[i];
+    float hs = 0.;
+    for (TIndex j = 0; j < block_size; ++j) {
+      hs += g[j] * g[j];
+    }
+    const float hi = h[0] = h[0] + hs / block_size;
+    const float step = lr / (std::sqrt(hi) + epsilon);
+    for (TIndex j = 0; j < block_size; ++j) {
+      w[j] += g[j] * step;
+    }
+  }
+}
+
+template <typename IndexType>
+static void SparseAdagradFused8BitRowwiseMomentUpdateGenericSlow(
+    const TIndex block_size,
+    const TIndex num_updates,
+    const int* positions,
+    const IndexType* indices,
+    const float* grad,
+    float* param,
+    uint8_t* moment,
+    float epsilon,
+    float lr) {
+  // Same as in FloatToFused8BitRowwiseQuantized
+  constexpr float kEpsilon = 1e-8f;
+  const TIndex fused_block_size = block_size + 8;
+  std::vector<float> h(block_size);
+  for (TIndex u = 0; u < num_updates; ++u) {
+    PrefetchRow(
+        u,
+        num_updates,
+        positions,
+        indices,
+        param,
+        block_size * sizeof(float));
+    PrefetchRow(
+        u, num_updates, positions, indices, moment, fused_block_size);
+    const TIndex i = positions ? positions[u] : u;
+    const float* g = grad + i * block_size;
+    float* w = param + indices[i] * block_size;
+    uint8_t* row = moment + indices[i] * fused_block_size;
+    float* scale_bias = reinterpret_cast<float*>(row + block_size);
+
+    float minimum = std::numeric_limits<float>::max();
+    float maximum = std::numeric_limits<float>::lowest();
+    for (TIndex j = 0; j < block_size; ++j) {
+      const float gj = g[j];
+      const float hj = h[j] = row[j] * scale_bias[0] + scale_bias[1] + gj * gj;
+      w[j] += lr * gj / (std::sqrt(hj) + epsilon);
+      minimum = std::min(minimum, hj);
+      maximum = std::max(maximum, hj);
+    }
+
+    const float range = maximum - minimum;
+    const float inverse_scale = 255.0f / (range + kEpsilon);
+    scale_bias[0] = range / 255.0f;
+    scale_bias[1] = minimum;
+    for (TIndex j = 0; j < block_size; ++j) {
+      row[j] = std::floor((h[j] - minimum) * inverse_scale + 0.5f);
+    }
+  }
+}
+
+// Proxy back to generic implementation
+#define ADAGRAD_SPECIALIZATION(Name, IndexType, MomentType)                \
+  void Name##_##IndexType##__base(                                         \
+      const TIndex block_size,                                             \
+      const TIndex num_updates,                                            \
+      const int* positions,                                                \
+      const IndexType* indices,                                            \
+      const float* grad,                                                   \
+      float* param,                                                        \
+      MomentType* moment,                                                  \
+      float epsilon,                                                       \
+      float lr) {                                                          \
+    Name##GenericSlow<IndexType>(                                          \
+        block_size,                                                        \
+        num_updates,                                                       \
+        positions,                                                         \
+        indices,                                                           \
+        grad,                                                              \
+        param,                                                             \
+        moment,                                                            \
+        epsilon,                                                           \
+        lr);                                                               \
+  }                                                                        \
+  template <>                                                              \
+  void Name<IndexType>(                                                    \
+      const TIndex block_size,                                             \
+      const TIndex num_updates,                                            \
+      const int* positions,                                                \
+      const IndexType* indices,                                            \
+      const float* grad,                                                   \
+      float* param,                                                        \
+      MomentType* moment,                                                  \
+      float epsilon,                                                       \
+      float lr) {                                                          \
+    AVX2_FMA_DO(                                                           \
+        Name##_##IndexType,                                                \
+        block_size,                                                        \
+        num_updates,                                                       \
+        positions,                                                         \
+        indices,                                                           \
+        grad,                                                              \
+        param,                                                             \
+        moment,                                                            \
+        epsilon,                                                           \
+        lr);                                                               \
+    BASE_DO(                                                               \
+        Name##_##IndexType,                                                \
+        block_size,                                                        \
+        num_updates,                                                       \
+        positions,                                                         \
+        indices,                                                           \
+        grad,                                                              \
+        param,                                                             \
+        moment,                                                            \
+        epsilon,                                                           \
+        lr);                                                               \
+  }
+
+ADAGRAD_SPECIALIZATION(SparseAdagradUpdate, int32_t, float);
+ADAGRAD_SPECIALIZATION(SparseAdagradUpdate, int64_t, float);
+ADAGRAD_SPECIALIZATION(RowWiseSparseAdagradUpdate, int32_t, float);
+ADAGRAD_SPECIALIZATION(RowWiseSparseAdagradUpdate, int64_t, float);
+ADAGRAD_SPECIALIZATION(
+    SparseAdagradFused8BitRowwiseMomentUpdate,
+    int32_t,
+    uint8_t);
+ADAGRAD_SPECIALIZATION(
+    SparseAdagradFused8BitRowwiseMomentUpdate,
+    int64_t,
+    uint8_t);
+
+#undef ADAGRAD_SPECIALIZATION
+
+} // namespace caffe2
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "caffe2/core/common.h"
+
+namespace caffe2 {
+
+/**
+ * Sparse Adagrad updates of the rows of an embedding table.
+ *
+ * Every kernel applies num_updates gradient rows in order. Update u applies
+ * gradient row i = positions[u], or i = u if positions is nullptr, to row
+ * indices[i] of param and moment. The indices must be in range; they are not
+ * checked. The gradient rows are block_size floats each.
+ *
+ * Rows are prefetched a few updates ahead. A row that occurs more than once
+ * is updated once per occurrence, in order, so several kernels may run in
+ * parallel as long as no row is in the updates of two of them.
+ */
+
+/**
+ * moment has the shape of param.
+ *
+ *   moment[row] += grad[i]^2
+ *   param[row] += lr * grad[i] / (sqrt(moment[row]) + epsilon)
+ */
+template <typename IndexType>
+void SparseAdagradUpdate(
+    const TIndex block_size,
+    const TIndex num_updates,
+    const int* positions, // optional
+    const IndexType* indices,
+    const float* grad,
+    float* param,
+    float* moment,
+    float epsilon,
+    float lr);
+
+/**
+ * moment holds one float per row of param.
+ *
+ *   moment[row] += mean(grad[i]^2)
+ *   param[row] += lr * grad[i] / (sqrt(moment[row]) + epsilon)
+ */
+template <typename IndexType>
+void RowWiseSparseAdagradUpdate(
+    const TIndex block_size,
+    const TIndex num_updates,
+    const int* positions, // optional
+    const IndexType* indices,
+    const float* grad,
+    float* param,
+    float* moment,
+    float epsilon,
+    float lr);
+
+/**
+ * Like SparseAdagradUpdate, but moment is quantized rowwise to 8 bits in the
+ * format of FloatToFused8BitRowwiseQuantized: every row is block_size bytes
+ * followed by a 4 byte float scale and a 4 byte float bias. A row is
+ * de-quantized, updated and quantized again, to the range of its new values.
+ */
+template <typename IndexType>
+void SparseAdagradFused8BitRowwiseMomentUpdate(
+    const TIndex block_size,
+    const TIndex num_updates,
+    const int* positions, // optional
+    const IndexType* indices,
+    const float* grad,
+    float* param,
+    uint8_t* moment,
+    float epsilon,
+    float lr);
+
+} // namespace caffe2
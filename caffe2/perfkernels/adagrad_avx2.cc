@@ -0,0 +1,279 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/types.h"
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace caffe2 {
+
+namespace {
+
+// How many updates ahead the rows are prefetched
+constexpr TIndex kPrefetchDistance = 8;
+
+template <typename IndexType>
+inline void PrefetchRow(
+    TIndex u,
+    TIndex num_updates,
+    const int* positions,
+    const IndexType* indices,
+    const void* data,
+    TIndex row_bytes) {
+  if (u + kPrefetchDistance < num_updates) {
+    const TIndex next = positions ? positions[u + kPrefetchDistance]
+                                  : u + kPrefetchDistance;
+    const char* row =
+        static_cast<const char*>(data) + indices[next] * row_bytes;
+    for (TIndex offset = 0; offset < row_bytes; offset += 64) {
+      _mm_prefetch(row + offset, _MM_HINT_T0);
+    }
+  }
+}
+
+inline float HorizontalSum(__m256 v) {
+  const __m128 sum4 =
+      _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  const __m128 sum2 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+  return _mm_cvtss_f32(_mm_add_ss(sum2, _mm_movehdup_ps(sum2)));
+}
+
+template <typename IndexType>
+void SparseAdagradUpdateKernel(
+    const TIndex block_size,
+    const TIndex num_updates,
+    const int* positions,
+    const IndexType* indices,
+    const float* grad,
+    float* param,
+    float* moment,
+    float epsilon,
+    float lr) {
+  const __m256 vlr = _mm256_set1_ps(lr);
+  const __m256 vepsilon = _mm256_set1_ps(epsilon);
+  for (TIndex u = 0; u < num_updates; ++u) {
+    PrefetchRow(
+        u,
+        num_updates,
+        positions,
+        indices,
+        param,
+        block_size * sizeof(float));
+    PrefetchRow(
+        u,
+        num_updates,
+        positions,
+        indices,
+        moment,
+        block_size * sizeof(float));
+    const TIndex i = positions ? positions[u] : u;
+    const float* g = grad + i * block_size;
+    float* w = param + indices[i] * block_size;
+    float* h = moment + indices[i] * block_size;
+    TIndex j = 0;
+    for (; j + 8 <= block_size; j += 8) {
+      const __m256 gj = _mm256_loadu_ps(&g[j]);
+      const __m256 hj = _mm256_fmadd_ps(gj, gj, _mm256_loadu_ps(&h[j]));
+      _mm256_storeu_ps(&h[j], hj);
+      _mm256_storeu_ps(
+          &w[j],
+          _mm256_add_ps(
+              _mm256_loadu_ps(&w[j]),
+              _mm256_div_ps(
+                  _mm256_mul_ps(vlr, gj),
+                  _mm256_add_ps(_mm256_sqrt_ps(hj), vepsilon))));
+    }
+    for (; j < block_size; ++j) {
+      const float gj = g[j];
+      const float hj = h[j] = h[j] + gj * gj;
+      w[j] += lr * gj / (std::sqrt(hj) + epsilon);
+    }
+  }
+}
+
+template <typename IndexType>
+void RowWiseSparseAdagradUpdateKernel(
+    const TIndex block_size,
+    const TIndex num_updates,
+    const int* positions,
+    const IndexType* indices,
+    const float* grad,
+    float* param,
+    float* moment,
+    float epsilon,
+    float lr) {
+  for (TIndex u = 0; u < num_updates; ++u) {
+    PrefetchRow(
+        u,
+        num_updates,
+        positions,
+        indices,
+        param,
+        block_size * sizeof(float));
+    const TIndex i = positions ? positions[u] : u;
+    const float* g = grad + i * block_size;
+    float* w = param + indices[i] * block_size;
+    float* h = moment + indices[i];
+
+    __m256 vsum = _mm256_setzero_ps();
+    TIndex j = 0;
+    for (; j + 8 <= block_size; j += 8) {
+      const __m256 gj = _mm256_loadu_ps(&g[j]);
+      vsum = _mm256_fmadd_ps(gj, gj, vsum);
+    }
+    float hs = HorizontalSum(vsum);
+    for (; j < block_size; ++j) {
+      hs += g[j] * g[j];
+    }
+    const float hi = h[0] = h[0] + hs / block_size;
+    const float step = lr / (std::sqrt(hi) + epsilon);
+
+    const __m256 vstep = _mm256_set1_ps(step);
+    j = 0;
+    for (; j + 8 <= block_size; j += 8) {
+      _mm256_storeu_ps(
+          &w[j],
+          _mm256_fmadd_ps(
+              _mm256_loadu_ps(&g[j]), vstep, _mm256_loadu_ps(&w[j])));
+    }
+    for (; j < block_size; ++j) {
+      w[j] += g[j] * step;
+    }
+  }
+}
+
+template <typename IndexType>
+void SparseAdagradFused8BitRowwiseMomentUpdateKernel(
+    const TIndex block_size,
+    const TIndex num_updates,
+    const int* positions,
+    const IndexType* indices,
+    const float* grad,
+    float* param,
+    uint8_t* moment,
+    float epsilon,
+    float lr) {
+  // Same as in FloatToFused8BitRowwiseQuantized
+  constexpr float kEpsilon = 1e-8f;
+  const TIndex fused_block_size = block_size + 8;
+  const __m256 vlr = _mm256_set1_ps(lr);
+  const __m256 vepsilon = _mm256_set1_ps(epsilon);
+  const __m256 vhalf = _mm256_set1_ps(0.5f);
+  std::vector<float> h(block_size);
+  for (TIndex u = 0; u < num_updates; ++u) {
+    PrefetchRow(
+        u,
+        num_updates,
+        positions,
+        indices,
+        param,
+        block_size * sizeof(float));
+    PrefetchRow(
+        u, num_updates, positions, indices, moment, fused_block_size);
+    const TIndex i = positions ? positions[u] : u;
+    const float* g = grad + i * block_size;
+    float* w = param + indices[i] * block_size;
+    uint8_t* row = moment + indices[i] * fused_block_size;
+    float* scale_bias = reinterpret_cast<float*>(row + block_size);
+
+    // De-quantize, update and find the new range
+    const float scale = scale_bias[0];
+    const float bias = scale_bias[1];
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 vbias = _mm256_set1_ps(bias);
+    __m256 vmin = _mm256_set1_ps(std::numeric_limits<float>::max());
+    __m256 vmax = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+    TIndex j = 0;
+    for (; j + 8 <= block_size; j += 8) {
+      const __m256 q = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&row[j]))));
+      const __m256 gj = _mm256_loadu_ps(&g[j]);
+      const __m256 hj =
+          _mm256_fmadd_ps(gj, gj, _mm256_fmadd_ps(q, vscale, vbias));
+      _mm256_storeu_ps(&h[j], hj);
+      _mm256_storeu_ps(
+          &w[j],
+          _mm256_add_ps(
+              _mm256_loadu_ps(&w[j]),
+              _mm256_div_ps(
+                  _mm256_mul_ps(vlr, gj),
+                  _mm256_add_ps(_mm256_sqrt_ps(hj), vepsilon))));
+      vmin = _mm256_min_ps(vmin, hj);
+      vmax = _mm256_max_ps(vmax, hj);
+    }
+    float mins[8], maxs[8];
+    _mm256_storeu_ps(mins, vmin);
+    _mm256_storeu_ps(maxs, vmax);
+    float minimum = *std::min_element(mins, mins + 8);
+    float maximum = *std::max_element(maxs, maxs + 8);
+    for (; j < block_size; ++j) {
+      const float gj = g[j];
+      const float hj = h[j] = row[j] * scale + bias + gj * gj;
+      w[j] += lr * gj / (std::sqrt(hj) + epsilon);
+      minimum = std::min(minimum, hj);
+      maximum = std::max(maximum, hj);
+    }
+
+    // Quantize again, to the new range
+    const float range = maximum - minimum;
+    const float inverse_scale = 255.0f / (range + kEpsilon);
+    scale_bias[0] = range / 255.0f;
+    scale_bias[1] = minimum;
+    const __m256 vinverse_scale = _mm256_set1_ps(inverse_scale);
+    const __m256 vminimum = _mm256_set1_ps(minimum);
+    j = 0;
+    for (; j + 8 <= block_size; j += 8) {
+      const __m256 q = _mm256_floor_ps(_mm256_fmadd_ps(
+          _mm256_sub_ps(_mm256_loadu_ps(&h[j]), vminimum),
+          vinverse_scale,
+          vhalf));
+      // Pack the 8 int32 down to 8 bytes
+      const __m256i q32 = _mm256_cvtps_epi32(q);
+      const __m128i q16 = _mm_packus_epi32(
+          _mm256_castsi256_si128(q32), _mm256_extracti128_si256(q32, 1));
+      _mm_storel_epi64(
+          reinterpret_cast<__m128i*>(&row[j]), _mm_packus_epi16(q16, q16));
+    }
+    for (; j < block_size; ++j) {
+      row[j] = std::floor((h[j] - minimum) * inverse_scale + 0.5f);
+    }
+  }
+}
+
+} // namespace
+
+#define ADAGRAD_AVX2(Name, IndexType, MomentType) \
+  void Name##_##IndexType##__avx2_fma(            \
+      const TIndex block_size,                    \
+      const TIndex num_updates,                   \
+      const int* positions,                       \
+      const IndexType* indices,                   \
+      const float* grad,                          \
+      float* param,                               \
+      MomentType* moment,                         \
+      float epsilon,                              \
+      float lr) {                                 \
+    Name##Kernel<IndexType>(                      \
+        block_size,                               \
+        num_updates,                              \
+        positions,                                \
+        indices,                                  \
+        grad,                                     \
+        param,                                    \
+        moment,                                   \
+        epsilon,                                  \
+        lr);                                      \
+  }
+
+ADAGRAD_AVX2(SparseAdagradUpdate, int32_t, float);
+ADAGRAD_AVX2(SparseAdagradUpdate, int64_t, float);
+ADAGRAD_AVX2(RowWiseSparseAdagradUpdate, int32_t, float);
+ADAGRAD_AVX2(RowWiseSparseAdagradUpdate, int64_t, float);
+ADAGRAD_AVX2(SparseAdagradFused8BitRowwiseMomentUpdate, int32_t, uint8_t);
+ADAGRAD_AVX2(SparseAdagradFused8BitRowwiseMomentUpdate, int64_t, uint8_t);
+
+#undef ADAGRAD_AVX2
+
+} // namespace caffe2
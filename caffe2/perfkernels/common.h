@@ -25,6 +25,7 @@ In foo.cc, do:
    void foo(int a, float b) {
      // You should always order things by their preference, faster
      // implementations earlier in the function.
+     AVX512_DO(foo, a, b);
      AVX2_DO(foo, a, b);
      AVX_DO(foo, a, b);
      BASE_DO(foo, a, b);
@@ -35,11 +36,12 @@ In foo.cc, do:
 // and run time architecture support.
 //
 // During build time:
-//    The build system should provide flags CAFFE2_PERF_WITH_AVX2 and
-//    CAFFE2_PERF_WITH_AVX that corresponds to the __AVX__ and __AVX2__ flags
-//    the compiler provides. Note that we do not use the compiler flags but
-//    rely on the build system flags, because the common files (like foo.cc
-//    above) will always be built without __AVX__ and __AVX2__.
+//    The build system should provide flags CAFFE2_PERF_WITH_AVX512,
+//    CAFFE2_PERF_WITH_AVX2 and CAFFE2_PERF_WITH_AVX that corresponds to the
+//    __AVX512F__, __AVX2__ and __AVX__ flags the compiler provides. Note that
+//    we do not use the compiler flags but rely on the build system flags,
+//    because the common files (like foo.cc above) will always be built
+//    without __AVX__ and __AVX2__.
 // During run time:
 //    we use cpuid to identify cpu support and run the proper functions.
 
@@ -50,6 +52,19 @@ In foo.cc, do:
 
 #define BASE_DO(funcname, ...) return funcname##__base(__VA_ARGS__);
 
+// The avx512 kernels use the F, BW and VL subsets (masked loads and stores of
+// 8 and 16 bit elements), so all three need to be present at run time.
+#ifdef CAFFE2_PERF_WITH_AVX512
+#define AVX512_DO(funcname, ...)                       \
+  decltype(funcname##__base) funcname##__avx512;       \
+  if (GetCpuId().avx512f() && GetCpuId().avx512bw() && \
+      GetCpuId().avx512vl()) {                         \
+    return funcname##__avx512(__VA_ARGS__);            \
+  }
+#else // CAFFE2_PERF_WITH_AVX512
+#define AVX512_DO(funcname, ...)
+#endif // CAFFE2_PERF_WITH_AVX512
+
 #ifdef CAFFE2_PERF_WITH_AVX2
 #define AVX2_DO(funcname, ...)                 \
   decltype(funcname##__base) funcname##__avx2; \
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "caffe2/core/common.h"
+
+namespace caffe2 {
+
+/**
+ * Embedding lookup with reduction over tables quantized rowwise to bit_rate
+ * (2 or 4) bits per value.
+ *
+ * `input` of size data_size * (ceil(block_size * bit_rate / 8) + 8B)
+ * `indices` of size index_size
+ * `lengths` of size output_size
+ * `weights` nullptr or array of size index_size
+ * `out` of size output_size * block_size
+ * sum(lengths[i]) == index_size
+ *
+ * Each row stores block_size values packed 8 / bit_rate to a byte, lowest bits
+ * first, followed by a 4 byte float scale and a 4 byte float bias. A value q
+ * of a row is de-quantized as q * scale + bias.
+ *
+ * Behavior is roughly equivalent to pseudocode:
+ *
+ * pos = 0
+ * fused_block_size = ceil(block_size * bit_rate / 8) + 8B
+ * for (i = 0..index_size-1)
+ *   for (k = 0..block_size-1)
+ *     out[i*block_size + k] = 0
+ *   for (j = 0..lengths[i]-1)
+ *     row = input + indices[pos] * fused_block_size
+ *     for (k = 0..block_size-1)
+ *       out[i*block_size + k] += (unpack(row, k) * scale(row) + bias(row)) *
+ *           (weights ? weights[IS_WEIGHT_POSITIONAL ? j : pos] : 1.0)
+ *     pos += 1
+ *   if (normalize_weights && lengths[i] > 0)
+ *     for (k = 0..block_size-1)
+ *       out[i*block_size + k] /= lengths[i]
+ *
+ */
+
+template <
+    typename IndexType,
+    typename OutType,
+    bool IS_WEIGHT_POSITIONAL = false>
+void FusedNBitRowwiseEmbeddingLookup(
+    const int bit_rate,
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const uint8_t* input,
+    const IndexType* indices,
+    const int* lengths,
+    const float* weights, // optional, can be null for non-weighted sum
+    bool normalize_by_lengths,
+    OutType* out);
+} // namespace caffe2
@@ -0,0 +1,193 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/types.h"
+
+#include <immintrin.h>
+#include <cstring>
+#include <type_traits>
+
+namespace caffe2 {
+
+namespace {
+
+// Expands 16 packed 4-bit values (8 bytes) into 16 bytes, in order.
+inline __m128i Unpack16Values(
+    const uint8_t* packed,
+    std::integral_constant<int, 4>) {
+  const __m128i bytes =
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(packed));
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i low = _mm_and_si128(bytes, mask);
+  const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+  return _mm_unpacklo_epi8(low, high);
+}
+
+// Expands 16 packed 2-bit values (4 bytes) into 16 bytes, in order.
+inline __m128i Unpack16Values(
+    const uint8_t* packed,
+    std::integral_constant<int, 2>) {
+  int32_t word;
+  memcpy(&word, packed, sizeof(word));
+  const __m128i bytes = _mm_cvtsi32_si128(word);
+  const __m128i mask = _mm_set1_epi8(0x03);
+  const __m128i v0 = _mm_and_si128(bytes, mask);
+  const __m128i v1 = _mm_and_si128(_mm_srli_epi16(bytes, 2), mask);
+  const __m128i v2 = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+  const __m128i v3 = _mm_and_si128(_mm_srli_epi16(bytes, 6), mask);
+  return _mm_unpacklo_epi16(
+      _mm_unpacklo_epi8(v0, v1), _mm_unpacklo_epi8(v2, v3));
+}
+
+template <int BIT_RATE, typename IndexType, bool IS_WEIGHT_POSITIONAL>
+void FusedNBitRowwiseEmbeddingLookupKernel(
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const uint8_t* input,
+    const IndexType* indices,
+    const int* lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    float* out) {
+  constexpr int kNumElemPerByte = 8 / BIT_RATE;
+  constexpr uint8_t kMask = (1 << BIT_RATE) - 1;
+  const IndexType prefdist_T0 = 16;
+  // block_size is the number of elements and fused_block_size is the size of
+  // an entire row, including scale and bias.
+  const TIndex fused_block_size =
+      (block_size + kNumElemPerByte - 1) / kNumElemPerByte + 8;
+  IndexType dataInd = 0;
+  for (IndexType rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+    float* op = &out[rangeIndex * block_size];
+    TIndex j = 0;
+    for (; j + 8 <= block_size; j += 8) {
+      _mm256_storeu_ps(op + j, _mm256_setzero_ps());
+    }
+    for (; j < block_size; j++) {
+      op[j] = 0.0f;
+    }
+    CAFFE_ENFORCE_LE(
+        dataInd + lengths[rangeIndex],
+        index_size,
+        "The sum of lengths should be the size of the indices tensor");
+    for (IndexType start = dataInd; dataInd < start + lengths[rangeIndex];
+         ++dataInd) {
+      const IndexType idx = indices[dataInd];
+      CAFFE_ENFORCE(
+          idx >= 0 && idx < data_size,
+          "Index ",
+          dataInd,
+          " is out of bounds: ",
+          idx,
+          ", range 0 to ",
+          data_size);
+      float wgt = 1.f;
+      if (weights) {
+        wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+      }
+      const uint8_t* ip = &input[idx * fused_block_size];
+      const float* scale_bias =
+          reinterpret_cast<const float*>(ip + fused_block_size - 8);
+      const float scale = wgt * scale_bias[0];
+      const float bias = wgt * scale_bias[1];
+      __m256 vscale = _mm256_set1_ps(scale);
+      __m256 vbias = _mm256_set1_ps(bias);
+
+      const IndexType next_T0 = (dataInd < index_size - prefdist_T0)
+          ? (dataInd + prefdist_T0)
+          : dataInd;
+      const IndexType idx_pref_T0 = indices[next_T0];
+      CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+      const uint8_t* ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+      for (TIndex offset = 0; offset < fused_block_size; offset += 64) {
+        _mm_prefetch(
+            reinterpret_cast<const char*>(&ip_next_T0[offset]), _MM_HINT_T0);
+      }
+
+      j = 0;
+      for (; j + 16 <= block_size; j += 16) {
+        const __m128i values = Unpack16Values(
+            ip + j / kNumElemPerByte, std::integral_constant<int, BIT_RATE>());
+        const __m256 low = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(values));
+        const __m256 high = _mm256_cvtepi32_ps(
+            _mm256_cvtepu8_epi32(_mm_srli_si128(values, 8)));
+        _mm256_storeu_ps(
+            &op[j],
+            _mm256_fmadd_ps(
+                vscale, low, _mm256_add_ps(_mm256_loadu_ps(&op[j]), vbias)));
+        _mm256_storeu_ps(
+            &op[j + 8],
+            _mm256_fmadd_ps(
+                vscale,
+                high,
+                _mm256_add_ps(_mm256_loadu_ps(&op[j + 8]), vbias)));
+      }
+      for (; j < block_size; j++) {
+        const int shift = (j % kNumElemPerByte) * BIT_RATE;
+        const uint8_t quantized = (ip[j / kNumElemPerByte] >> shift) & kMask;
+        op[j] += scale * quantized + bias;
+      }
+    }
+    if (normalize_by_lengths && lengths[rangeIndex]) {
+      float len_inv = 1.0f / lengths[rangeIndex];
+      __m256 vlen_inv = _mm256_set1_ps(len_inv);
+      j = 0;
+      for (; j + 8 <= block_size; j += 8) {
+        _mm256_storeu_ps(
+            &op[j], _mm256_mul_ps(_mm256_loadu_ps(&op[j]), vlen_inv));
+      }
+      for (; j < block_size; j++) {
+        op[j] = len_inv * op[j];
+      }
+    }
+  }
+}
+
+} // namespace
+
+#define FUSED_NBIT_ROWWISE_EMBEDDING_AVX2(IndexType)                        \
+  void FusedNBitRowwiseEmbeddingLookup_##IndexType##_float_false__avx2_fma( \
+      const int bit_rate,                                                   \
+      const TIndex block_size,                                              \
+      const TIndex output_size,                                             \
+      const TIndex index_size,                                              \
+      const TIndex data_size,                                               \
+      const uint8_t* input,                                                 \
+      const IndexType* indices,                                             \
+      const int* lengths,                                                   \
+      const float* weights,                                                 \
+      bool normalize_by_lengths,                                            \
+      float* out) {                                                         \
+    if (bit_rate == 4) {                                                    \
+      FusedNBitRowwiseEmbeddingLookupKernel<4, IndexType, false>(           \
+          block_size,                                                       \
+          output_size,                                                      \
+          index_size,                                                       \
+          data_size,                                                        \
+          input,                                                            \
+          indices,                                                          \
+          lengths,                                                          \
+          weights,                                                          \
+          normalize_by_lengths,                                             \
+          out);                                                             \
+    } else {                                                                \
+      FusedNBitRowwiseEmbeddingLookupKernel<2, IndexType, false>(           \
+          block_size,                                                       \
+          output_size,                                                      \
+          index_size,                                                       \
+          data_size,                                                        \
+          input,                                                            \
+          indices,                                                          \
+          lengths,                                                          \
+          weights,                                                          \
+          normalize_by_lengths,                                             \
+          out);                                                             \
+    }                                                                       \
+  }
+
+FUSED_NBIT_ROWWISE_EMBEDDING_AVX2(int32_t);
+FUSED_NBIT_ROWWISE_EMBEDDING_AVX2(int64_t);
+
+#undef FUSED_NBIT_ROWWISE_EMBEDDING_AVX2
+
+} // namespace caffe2
@@ -0,0 +1,30 @@
+#include "caffe2/perfkernels/half_float_conversion.h"
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/conversions.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void FloatToFloat16__base(int N, const float* x, float16* y) {
+  for (int i = 0; i < N; ++i) {
+    y[i] = convert::cpu_float2half_rn(x[i]);
+  }
+}
+
+void FloatToFloat16(int N, const float* x, float16* y) {
+  AVX_F16C_DO(FloatToFloat16, N, x, y);
+  BASE_DO(FloatToFloat16, N, x, y);
+}
+
+void Float16ToFloat__base(int N, const float16* x, float* y) {
+  for (int i = 0; i < N; ++i) {
+    y[i] = convert::cpu_half2float(x[i]);
+  }
+}
+
+void Float16ToFloat(int N, const float16* x, float* y) {
+  AVX_F16C_DO(Float16ToFloat, N, x, y);
+  BASE_DO(Float16ToFloat, N, x, y);
+}
+
+} // namespace caffe2
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "caffe2/core/types.h"
+
+namespace caffe2 {
+
+// Converts N values between float and float16, rounding to nearest even.
+// On CPUs with F16C this uses the vector conversion instructions, which
+// convert eight values at a time.
+void FloatToFloat16(int N, const float* x, float16* y);
+void Float16ToFloat(int N, const float16* x, float* y);
+
+} // namespace caffe2
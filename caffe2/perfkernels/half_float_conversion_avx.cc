@@ -0,0 +1,53 @@
+#include "caffe2/core/types.h"
+#include "caffe2/perfkernels/half_float_conversion.h"
+
+#include <cstring>
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+namespace caffe2 {
+
+// The last N % 8 values are converted through a zero-padded buffer rather
+// than with _cvtsh_ss/_cvtss_sh, which are missing from some compilers (see
+// cvtsh_ss_bugfix.h).
+
+void FloatToFloat16__avx_f16c(int N, const float* x, float16* y) {
+  int current = 0;
+  for (; current + 8 <= N; current += 8) {
+    __m256 mmx = _mm256_loadu_ps(x + current);
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(y + current),
+        _mm256_cvtps_ph(mmx, _MM_FROUND_TO_NEAREST_INT));
+  }
+  if (current < N) {
+    float buffer[8] = {0};
+    float16 result[8];
+    std::memcpy(buffer, x + current, (N - current) * sizeof(float));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(result),
+        _mm256_cvtps_ph(_mm256_loadu_ps(buffer), _MM_FROUND_TO_NEAREST_INT));
+    std::memcpy(y + current, result, (N - current) * sizeof(float16));
+  }
+}
+
+void Float16ToFloat__avx_f16c(int N, const float16* x, float* y) {
+  int current = 0;
+  for (; current + 8 <= N; current += 8) {
+    __m128i mmx =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + current));
+    _mm256_storeu_ps(y + current, _mm256_cvtph_ps(mmx));
+  }
+  if (current < N) {
+    float16 buffer[8] = {};
+    float result[8];
+    std::memcpy(buffer, x + current, (N - current) * sizeof(float16));
+    _mm256_storeu_ps(
+        result,
+        _mm256_cvtph_ps(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer))));
+    std::memcpy(y + current, result, (N - current) * sizeof(float));
+  }
+}
+
+} // namespace caffe2
@@ -7,12 +7,40 @@ import sys
 
 sizeof = {'float': 4, 'float16': 2, 'uint8_t': 1}
 
+# vector register type, intrinsic prefix and number of floats per register
+simd = {'avx2': ('__m256', '_mm256', 8), 'avx512': ('__m512', '_mm512', 16)}
+
 
 def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused):
     def compute(regid, InType, use_weights, isa, prefetch):
         code = []
 
-        if InType == "float":
+        if isa == "avx512":
+            if InType == "float":
+                code.append(
+                    "vop%d = _mm512_fmadd_ps(vwgt, \
+                      _mm512_loadu_ps(ip + (%d)), vop%d);"
+                    % (regid, regid, regid)
+                )
+            elif InType == "float16":
+                code.append(
+                    "vop%d = _mm512_fmadd_ps(vwgt, \
+                       _mm512_cvtph_ps(_mm256_loadu_si256( \
+                         reinterpret_cast<const __m256i*>(ip + (%d)))), \
+                       vop%d);"
+                    % (regid, regid, regid)
+                )
+            elif InType == "uint8_t":
+                code.append(
+                    "vop%d = _mm512_fmadd_ps(vwgt, \
+                       _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128( \
+                         reinterpret_cast<const __m128i*>(ip + (%d))))), \
+                       _mm512_add_ps(vop%d, vbio));"
+                    % (regid, regid, regid)
+                )
+            else:
+                assert False
+        elif InType == "float":
             code.append(
                 "vop%d = _mm256_fmadd_ps(vwgt,  \
                   _mm256_loadu_ps(ip + (%d)), vop%d);"
@@ -42,6 +70,7 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused):
 
         return code
 
+    vtype, vp, width = simd[isa]
     code = []
     code.append("// unrolling " + str(uf) + " times")
     code.append(IndexType + " dataInd = 0;")
@@ -49,8 +78,9 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused):
                 " rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {")
     code.append(OutType + " *op = &out[rangeIndex * block_size];")
     for i in range(0, uf):
-        j = 8 * i
-        code.append("__m256 vop" + str(j) + " = _mm256_setzero_ps();")
+        j = width * i
+        code.append(
+            "{} vop{} = {}_setzero_ps();".format(vtype, j, vp))
 
     # inner loop
     code.append("for (" + IndexType +
@@ -77,14 +107,14 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused):
         else:
             code.append("bio = wgt * scale_bias[2 * idx + 1];")
             code.append("wgt = wgt * scale_bias[2 * idx];")
-        code.append("__m256 vbio = _mm256_set1_ps(bio);")
+        code.append("{} vbio = {}_set1_ps(bio);".format(vtype, vp))
     else:
         code.append(OutType + " wgt = 1.f;")
         code.append("if (weights) {")
         code.append(
             "wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];")
         code.append("}")
-    code.append("__m256 vwgt = _mm256_set1_ps(wgt);")
+    code.append("{} vwgt = {}_set1_ps(wgt);".format(vtype, vp))
 
     code.append("const {} *ip = &input[idx * fused_block_size];".format(InType))
     code.append(
@@ -101,7 +131,7 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused):
     )
 
     for i in range(0, uf):
-        j = 8 * i
+        j = width * i
         cachelinesize = 64
         byteoffset = sizeof[InType] * j
         prefetch = (byteoffset % cachelinesize) == 0
@@ -110,17 +140,19 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused):
 
     code.append("if (normalize_by_lengths == false) {")
     for i in range(0, uf):
-        j = 8 * i
+        j = width * i
         code.append(
-            "_mm256_storeu_ps(&op[" + str(j) + "], vop" + str(j) + ");")
+            "{}_storeu_ps(&op[{}], vop{});".format(vp, j, j))
     code.append("} else if (lengths[rangeIndex]) {")
     # inv of length
     code.append(
-        "__m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);")
+        "{} vlen_inv = {}_set1_ps(1.0f / lengths[rangeIndex]);".format(
+            vtype, vp))
     for i in range(0, uf):
-        j = 8 * i
+        j = width * i
         code.append(
-            "_mm256_storeu_ps(&op[" + str(j) + "], _mm256_mul_ps(" + "vop" + str(j) + ", vlen_inv));")
+            "{}_storeu_ps(&op[{}], {}_mul_ps(vop{}, vlen_inv));".format(
+                vp, j, vp, j))
     code.append("}")
 
     code.append("}")
@@ -159,7 +191,48 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused):
 
         return code
 
+    def compute_avx512(InType, masked):
+        # the masked variant handles the last block_size % 16 elements of a
+        # row without touching memory past its end
+        if masked:
+            loadu_ps = "_mm512_maskz_loadu_ps(mask, {})"
+        else:
+            loadu_ps = "_mm512_loadu_ps({})"
+        if InType == "float":
+            vin = loadu_ps.format("&ip[j]")
+        elif InType == "float16":
+            if masked:
+                vin = "_mm512_cvtph_ps(_mm256_maskz_loadu_epi16(mask, &ip[j]))"
+            else:
+                vin = "_mm512_cvtph_ps(_mm256_loadu_si256( \
+                       reinterpret_cast<const __m256i*>(&ip[j])))"
+        elif InType == "uint8_t":
+            if masked:
+                vin = "_mm512_cvtepi32_ps(_mm512_cvtepu8_epi32( \
+                       _mm_maskz_loadu_epi8(mask, &ip[j])))"
+            else:
+                vin = "_mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128( \
+                       reinterpret_cast<const __m128i*>(&ip[j]))))"
+        else:
+            assert False
+        vout = loadu_ps.format("&op[j]")
+        if InType == "uint8_t":
+            vout = "_mm512_add_ps({}, vbio)".format(vout)
+        result = "_mm512_fmadd_ps(vwgt, {}, {})".format(vin, vout)
+
+        code = []
+        if masked:
+            code.append("_mm512_mask_storeu_ps(&op[j], mask, {});".format(result))
+        else:
+            code.append("_mm512_storeu_ps(&op[j], {});".format(result))
+            code.append("_mm_prefetch((&ip_next_T0[j]), _MM_HINT_T0);")
+        return code
+
+    vtype, vp, width = simd[isa]
     code = []
+    if isa == "avx512":
+        code.append(
+            "const __mmask16 mask = (1 << (block_size % 16)) - 1;")
     code.append(IndexType + " dataInd = 0;")
     code.append("for (" + IndexType +
                 " rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {")
@@ -167,11 +240,16 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused):
 
     # initialize to 0
     code.append("TIndex j = 0;")
-    code.append("for(; j + 8 <= block_size; j += 8) {")
-    code.append("_mm256_storeu_ps(op + j, _mm256_setzero_ps());")
+    code.append(
+        "for(; j + {} <= block_size; j += {}) {{".format(width, width))
+    code.append("{}_storeu_ps(op + j, {}_setzero_ps());".format(vp, vp))
     code.append("}")
-    code.append("for(; j < block_size; j++) {")
-    code.append("op[j] = 0.0f;")
+    if isa == "avx512":
+        code.append("if (j < block_size) {")
+        code.append("_mm512_mask_storeu_ps(op + j, mask, _mm512_setzero_ps());")
+    else:
+        code.append("for(; j < block_size; j++) {")
+        code.append("op[j] = 0.0f;")
     code.append("}")
 
     # inner loop
@@ -200,14 +278,14 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused):
             code.append("assert (scale_bias);")
             code.append("bio = wgt * scale_bias[2 * idx + 1];")
             code.append("wgt = wgt * scale_bias[2 * idx];")
-        code.append("__m256 vbio = _mm256_set1_ps(bio);")
+        code.append("{} vbio = {}_set1_ps(bio);".format(vtype, vp))
     else:
         code.append(OutType + " wgt = 1.f;")
         code.append("if (weights) {")
         code.append(
             "wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];")
         code.append("}")
-    code.append("__m256 vwgt = _mm256_set1_ps(wgt);")
+    code.append("{} vwgt = {}_set1_ps(wgt);".format(vtype, vp))
 
     code.append("const {} *ip = &input[idx * fused_block_size];".format(InType))
     code.append(
@@ -224,10 +302,50 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused):
 
     # compute and store main loop
     code.append("j = 0;")
-    code.append("for(; j + 8 <= block_size; j += 8) {")
-    code.extend(compute(InType, use_weights, isa))
+    code.append(
+        "for(; j + {} <= block_size; j += {}) {{".format(width, width))
+    if isa == "avx512":
+        code.extend(compute_avx512(InType, False))
+        code.append("}")
+        # leftover
+        code.append("if (j < block_size) {")
+        code.extend(compute_avx512(InType, True))
+        code.append("}")
+    else:
+        code.extend(compute(InType, use_weights, isa))
+        code.append("}")
+        code.extend(leftover(InType))
+
+    code.append("}")
+
+    code.append("if (normalize_by_lengths && lengths[rangeIndex]) {")
+    code.append("float len_inv = 1.0f / lengths[rangeIndex];")
+    code.append("{} vlen_inv = {}_set1_ps(len_inv);".format(vtype, vp))
+    code.append("j = 0;")
+    code.append(
+        "for(; j + {} <= block_size; j += {}) {{".format(width, width))
+    code.append(
+        "{}_storeu_ps(&op[j], {}_mul_ps({}_loadu_ps(&op[j]), vlen_inv));".
+        format(vp, vp, vp))
+    code.append("}")
+    if isa == "avx512":
+        code.append("if (j < block_size) {")
+        code.append(
+            "_mm512_mask_storeu_ps(&op[j], mask, \
+               _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, &op[j]), vlen_inv));")
+    else:
+        code.append("for(; j < block_size; j++) {")
+        code.append("op[j] = len_inv * op[j];")
+    code.append("}")
+
+    code.append("}")
+
     code.append("}")
-    # leftover
+    return code
+
+
+def leftover(InType):
+    code = []
     if InType == "float16":
         code.append("float16 vtmp1[8] CAFFE2_ALIGNED(64);")
     code.append("for(; j < block_size; j++) {")
@@ -242,24 +360,6 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused):
     else:
         assert False
 
-    code.append("}")
-
-    code.append("}")
-
-    code.append("if (normalize_by_lengths && lengths[rangeIndex]) {")
-    code.append("float len_inv = 1.0f / lengths[rangeIndex];")
-    code.append("__m256 vlen_inv = _mm256_set1_ps(len_inv);")
-    code.append("j = 0;")
-    code.append("for(; j + 8 <= block_size; j += 8) {")
-    code.append(
-        "_mm256_storeu_ps(&op[j], _mm256_mul_ps(_mm256_loadu_ps(&op[j]), vlen_inv));")
-    code.append("}")
-    code.append("for(; j < block_size; j++) {")
-    code.append("op[j] = len_inv * op[j];")
-    code.append("}")
-
-    code.append("}")
-
     code.append("}")
     return code
 
@@ -268,13 +368,14 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused):
 parser = argparse.ArgumentParser()
 parser.add_argument('-f', '--filename', help="file name")
 parser.add_argument('--fused', action='store_true')
+parser.add_argument('--isa', choices=sorted(simd.keys()), default='avx2')
 opts = parser.parse_args()
 if opts.filename:
     filename = opts.filename
 elif opts.fused:
-    filename = "embedding_lookup_fused_8bit_rowwise_avx2.cc"
+    filename = "embedding_lookup_fused_8bit_rowwise_{}.cc".format(opts.isa)
 else:
-    filename = "embedding_lookup_avx2.cc"
+    filename = "embedding_lookup_{}.cc".format(opts.isa)
 fout = open(filename, 'w')
 
 options = [["int32_t", "float", "float"],
@@ -307,7 +408,7 @@ for o in options:
     fn_base = '{}EmbeddingLookup_{}_{}_{}'.format(
         prefix, IndexType, InType, OutType
     )
-    suffix = '__avx2_fma'
+    suffix = '__avx512' if opts.isa == 'avx512' else '__avx2_fma'
     fn = "static void " + fn_base + suffix
     code.append(fn + "(")
 
@@ -349,17 +450,22 @@ for o in options:
                 ' "scale_bias must not be nullptr");'
             )
 
+    width = simd[opts.isa][2]
     code.append("if (block_size == 128) {")
-    code += unroll(16, IndexType, InType, OutType, True, "AVX2", opts.fused)
+    code += unroll(
+        128 // width, IndexType, InType, OutType, True, opts.isa, opts.fused)
     code.append("} else if (block_size == 64) {")
-    code += unroll(8, IndexType, InType, OutType, True, "AVX2", opts.fused)
+    code += unroll(
+        64 // width, IndexType, InType, OutType, True, opts.isa, opts.fused)
     code.append("} else if (block_size == 32) {")
-    code += unroll(4, IndexType, InType, OutType, True, "AVX2", opts.fused)
+    code += unroll(
+        32 // width, IndexType, InType, OutType, True, opts.isa, opts.fused)
     code.append("} else if (block_size == 16) {")
-    code += unroll(2, IndexType, InType, OutType, True, "AVX2", opts.fused)
+    code += unroll(
+        16 // width, IndexType, InType, OutType, True, opts.isa, opts.fused)
     code.append("} else {")
     code.append("// generic code")
-    code += generic(IndexType, InType, OutType, True, "AVX2", opts.fused)
+    code += generic(IndexType, InType, OutType, True, opts.isa, opts.fused)
     code.append("}")
 
     code.append("}")
@@ -0,0 +1,65 @@
+#include "caffe2/core/types.h"
+#include "caffe2/perfkernels/typed_axpy.h"
+#include "caffe2/utils/math.h"
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+void TypedAxpy_float16_float__avx512(
+    int N,
+    const float a,
+    const float16* x,
+    float* y) {
+  // __m512 holds 16 floats, so we vectorize every 16 elements and finish the
+  // remaining ones with masked loads and stores instead of a scalar loop.
+  __m512 mma = _mm512_set1_ps(a);
+  int current = 0;
+
+  for (; current + 16 <= N; current += 16) {
+    __m256i mmx_16 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + current));
+    __m512 mmx_32 = _mm512_cvtph_ps(mmx_16);
+    __m512 mmy = _mm512_loadu_ps(y + current);
+    mmy = _mm512_fmadd_ps(mmx_32, mma, mmy);
+    _mm512_storeu_ps(y + current, mmy);
+  }
+
+  if (current < N) {
+    const __mmask16 mask = (1 << (N - current)) - 1;
+    __m512 mmx_32 =
+        _mm512_cvtph_ps(_mm256_maskz_loadu_epi16(mask, x + current));
+    __m512 mmy = _mm512_maskz_loadu_ps(mask, y + current);
+    mmy = _mm512_fmadd_ps(mmx_32, mma, mmy);
+    _mm512_mask_storeu_ps(y + current, mask, mmy);
+  }
+}
+
+void TypedAxpy_uint8_float__avx512(
+    int N,
+    const float a,
+    const std::uint8_t* x,
+    float* y) {
+  __m512 mma = _mm512_set1_ps(a);
+  int current = 0;
+
+  for (; current + 16 <= N; current += 16) {
+    __m512i mmx_int32 = _mm512_cvtepu8_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + current)));
+    __m512 mmx_fp32 = _mm512_cvtepi32_ps(mmx_int32);
+    __m512 mmy = _mm512_loadu_ps(y + current);
+    mmy = _mm512_fmadd_ps(mmx_fp32, mma, mmy);
+    _mm512_storeu_ps(y + current, mmy);
+  }
+
+  if (current < N) {
+    const __mmask16 mask = (1 << (N - current)) - 1;
+    __m512 mmx_fp32 = _mm512_cvtepi32_ps(
+        _mm512_cvtepu8_epi32(_mm_maskz_loadu_epi8(mask, x + current)));
+    __m512 mmy = _mm512_maskz_loadu_ps(mask, y + current);
+    mmy = _mm512_fmadd_ps(mmx_fp32, mma, mmy);
+    _mm512_mask_storeu_ps(y + current, mask, mmy);
+  }
+}
+
+} // namespace caffe2
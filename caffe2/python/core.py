@@ -80,7 +80,8 @@ def IsOperatorWithEngine(op_type, engine):
     return C.op_registry_key(op_type, engine) in _REGISTERED_OPERATORS
 
 
-def DeviceOption(device_type, cuda_gpu_id=0, random_seed=None, node_name=None):
+def DeviceOption(device_type, cuda_gpu_id=0, random_seed=None, node_name=None,
+                 cuda_high_priority=False):
     option = caffe2_pb2.DeviceOption()
     option.device_type = device_type
     option.cuda_gpu_id = cuda_gpu_id
@@ -88,6 +89,8 @@ def DeviceOption(device_type, cuda_gpu_id=0, random_seed=None, node_name=None):
         option.node_name = node_name
     if random_seed is not None:
         option.random_seed = random_seed
+    if cuda_high_priority:
+        option.cuda_high_priority = True
     return option
 
 
@@ -1349,6 +1352,18 @@ def _recover_record_by_prefix(names, prefix=''):
         col_blobs=[_get_blob_ref(prefix + name) for name in column_names])
 
 
+# Ops that have a TENSORCORE engine, and ops that take enable_tensor_core,
+# see Net.UseTensorCoreMath
+_TENSOR_CORE_GEMM_OPS = {
+    "FC", "FCGradient", "FCTransposed", "FCTransposedGradient", "BatchMatMul",
+}
+_TENSOR_CORE_CONV_OPS = {
+    "Conv", "Conv1D", "Conv2D", "Conv3D",
+    "ConvGradient", "Conv1DGradient", "Conv2DGradient", "Conv3DGradient",
+    "ConvTranspose", "ConvTransposeGradient",
+}
+
+
 class Net(object):
     _net_names_used = set()
     operator_registry_ = {}
@@ -1990,6 +2005,31 @@ class Net(object):
         if use_cudnn:
             for op in self._net.op:
                 op.engine = "CUDNN"
+
+    def UseTensorCoreMath(self, enable=True):
+        """Makes the GEMMs and convolutions of the net use TensorCore math
+        on the GPUs that have it: the FC and BatchMatMul ops (including the
+        gradient ones) without an engine run with the TENSORCORE engine,
+        which multiplies float16 inputs with float32 accumulation, and the
+        cuDNN convolutions get enable_tensor_core. With enable=False, these
+        ops are reverted to the default math.
+
+        Together with float16 storage and float32 master weights in the
+        optimizer (see optimizer.build_multi_precision_sgd), this is the
+        mixed precision mode of a net."""
+        for op in self._net.op:
+            if op.type in _TENSOR_CORE_GEMM_OPS:
+                if enable and op.engine == "":
+                    op.engine = "TENSORCORE"
+                elif not enable and op.engine == "TENSORCORE":
+                    op.engine = ""
+            elif op.type in _TENSOR_CORE_CONV_OPS:
+                args = [a for a in op.arg if a.name != "enable_tensor_core"]
+                del op.arg[:]
+                op.arg.extend(args)
+                op.arg.add().CopyFrom(
+                    utils.MakeArgument("enable_tensor_core", int(enable)))
+
     def RunAllOnMKL(self):
         """A convenient function to run everything using MKLDNN."""
         device_option = caffe2_pb2.DeviceOption()
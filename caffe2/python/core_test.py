@@ -343,6 +343,34 @@ class TestAppendNet(test_util.TestCase):
         self.assertTrue("in1" in netA.external_inputs)
 
 
+class TestTensorCoreMath(test_util.TestCase):
+
+    def test_use_tensor_core_math(self):
+        net = core.Net("net")
+        net.FC(["x", "w", "b"], "fc")
+        net.FC(["x", "w", "b"], "fc_other", engine="OTHER")
+        net.BatchMatMul(["fc", "fc"], "bmm")
+        net.Conv(["x", "cw", "cb"], "conv", kernel=3, enable_tensor_core=0)
+        net.Relu("conv", "relu")
+
+        net.UseTensorCoreMath()
+        ops = net.Proto().op
+        self.assertEqual(
+            [op.engine for op in ops],
+            ["TENSORCORE", "OTHER", "TENSORCORE", "", ""])
+        args = [a for a in ops[3].arg if a.name == "enable_tensor_core"]
+        self.assertEqual(len(args), 1)
+        self.assertEqual(args[0].i, 1)
+        self.assertEqual(len(ops[4].arg), 0)
+
+        net.UseTensorCoreMath(False)
+        self.assertEqual(
+            [op.engine for op in ops], ["", "OTHER", "", "", ""])
+        args = [a for a in ops[3].arg if a.name == "enable_tensor_core"]
+        self.assertEqual(len(args), 1)
+        self.assertEqual(args[0].i, 0)
+
+
 class TestExtractPredictorNet(test_util.TestCase):
 
     def test_extract_simple(self):
@@ -46,6 +46,10 @@ for each of the inputs. Default is 0 for all iputs.
 'timeout' is the timeout in seconds after which if no data is available, the
 net will fail (default 600s = 10 mins).
 
+If 'prefetch_to_device' is set and the device scope is a GPU, batches are
+queued on the CPU and the net dequeues them with PrefetchDequeueBlobs, which
+copies the next batch to the GPU while the current iteration runs.
+
 This function returns a list of numpy arrays corresponding to the different
 input blobs. In the example above, it would return two arrays, one for the
 data blob and another for the labels. These arrays can have arbitrary number
@@ -99,7 +103,8 @@ def init_data_input_workers(
     external_loggers=None,
     dont_rebatch=False,
     batch_columns=None,
-    timeout=600
+    timeout=600,
+    prefetch_to_device=False
 ):
     global global_coordinator
     device_option = scope.CurrentDeviceScope()
@@ -118,7 +123,8 @@ def init_data_input_workers(
         metrics,
         dont_rebatch,
         batch_columns,
-        timeout=timeout
+        timeout=timeout,
+        prefetch_to_device=prefetch_to_device,
     )
 
     # Create coordinator object
@@ -153,13 +159,23 @@ def init_data_input_workers(
 class BatchFeeder(State):
     def __init__(self, net, input_blob_names, batch_size,
                  device_option, namescope, input_source_name, queue,
-                 metrics, dont_rebatch, batch_columns, timeout=600):
+                 metrics, dont_rebatch, batch_columns, timeout=600,
+                 prefetch_to_device=False):
         self._counter = 0
         self._input_blob_names = input_blob_names
         self._batch_size = batch_size
         self._internal_queue = queue
         self._queues = []
         self._device_option = device_option
+        # Batches for the GPU are fed to the CPU and copied by the net
+        self._prefetch_to_device = (
+            prefetch_to_device and
+            device_option.device_type == caffe2_pb2.CUDA
+        )
+        self._feed_device_option = (
+            caffe2_pb2.DeviceOption(device_type=caffe2_pb2.CPU)
+            if self._prefetch_to_device else device_option
+        )
         self._namescope = namescope
         self._timeout = timeout
         self._input_source_name = input_source_name
@@ -338,7 +354,7 @@ class BatchFeeder(State):
             workspace.FeedBlob(
                 b,
                 np.array([]).astype(np.float32),
-                device_option=self._device_option,
+                device_option=self._feed_device_option,
             )
 
     def _enqueue(self, blob_name, queue, data_arr):
@@ -348,14 +364,14 @@ class BatchFeeder(State):
         workspace.FeedBlob(
             self._scratch_blob[blob_name],
             data_arr,
-            device_option=self._device_option
+            device_option=self._feed_device_option
         )
 
         op = core.CreateOperator(
             "SafeEnqueueBlobs",
             [queue, self._scratch_blob[blob_name]],
             [self._scratch_blob[blob_name], self._scratch_status[blob_name]],
-            device_option=self._device_option
+            device_option=self._feed_device_option
         )
         workspace.RunOperatorOnce(op)
 
@@ -385,7 +401,13 @@ class BatchFeeder(State):
         '''
         for q, blob_name in zip(self._queues, self._input_blob_names):
             # Add operator to the Caffe2 network to dequeue
-            net.DequeueBlobs(q, blob_name, timeout_secs=float(self._timeout))
+            if self._prefetch_to_device:
+                net.PrefetchDequeueBlobs(
+                    q, blob_name, timeout_secs=float(self._timeout),
+                    device_option=self._device_option)
+            else:
+                net.DequeueBlobs(
+                    q, blob_name, timeout_secs=float(self._timeout))
 
     def _log_inputs_per_interval(self, inputs, force=False):
         self._inputs += inputs
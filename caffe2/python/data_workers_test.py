@@ -7,7 +7,8 @@ import numpy as np
 import unittest
 import time
 
-from caffe2.python import workspace, model_helper
+from caffe2.proto import caffe2_pb2
+from caffe2.python import core, workspace, model_helper
 from caffe2.python import timeout_guard
 import caffe2.python.data_workers as data_workers
 
@@ -76,6 +77,42 @@ class DataWorkersTest(unittest.TestCase):
         coordinator.stop_coordinator("unittest")
         self.assertEqual(coordinator._coordinators, [])
 
+    @unittest.skipIf(not workspace.has_gpu_support, "No gpu support.")
+    def testPrefetchToDevice(self):
+        workspace.ResetWorkspace()
+
+        model = model_helper.ModelHelper(name="test_prefetch")
+        with core.DeviceScope(core.DeviceOption(caffe2_pb2.CUDA, 0)):
+            coordinator = data_workers.init_data_input_workers(
+                model,
+                ["data", "label"],
+                dummy_fetcher,
+                32,
+                2,
+                input_source_name="unittest_prefetch",
+                prefetch_to_device=True,
+            )
+        self.assertEqual(
+            [op.type for op in model.net.Proto().op],
+            ["PrefetchDequeueBlobs", "PrefetchDequeueBlobs"])
+
+        coordinator.start()
+        workspace.RunNetOnce(model.param_init_net)
+        workspace.CreateNet(model.net)
+
+        for _i in range(100):
+            with timeout_guard.CompleteInTimeOrDie(5):
+                workspace.RunNet(model.net.Proto().name)
+
+            data = workspace.FetchBlob("data")
+            labels = workspace.FetchBlob("label")
+            self.assertEqual(data.shape[0], 32)
+            self.assertEqual(labels.shape[0], 32)
+            for j in range(32):
+                self.assertEqual(labels[j], data[j, 0])
+
+        coordinator.stop_coordinator("unittest_prefetch")
+
     def testRNNInput(self):
         workspace.ResetWorkspace()
         model = model_helper.ModelHelper(name="rnn_test")
@@ -33,9 +33,11 @@ shard_id = a unique integer in the set [0, M-1].
 
 For rendezvous (the trainer processes have to know about each other),
 you can either use a directory path that is visible to all processes
-(e.g. NFS directory), or use a Redis instance. Use the former by
-passing the `file_store_path` argument. Use the latter by passing the
-`redis_host` and `redis_port` arguments.
+(e.g. NFS directory), a Redis instance, or a TCP store served by shard
+0. Use the first by passing the `file_store_path` argument, the second by
+passing the `redis_host` and `redis_port` arguments, and the last by
+passing the `tcp_store_host` (the host of shard 0) and `tcp_store_port`
+arguments.
 '''
 
 logging.basicConfig()
@@ -44,6 +46,7 @@ log.setLevel(logging.DEBUG)
 
 dyndep.InitOpsLibrary('@/caffe2/caffe2/distributed:file_store_handler_ops')
 dyndep.InitOpsLibrary('@/caffe2/caffe2/distributed:redis_store_handler_ops')
+dyndep.InitOpsLibrary('@/caffe2/caffe2/distributed:tcp_store_handler_ops')
 
 
 def AddImageInput(model, reader, batch_size, img_size, dtype, is_test):
@@ -301,6 +304,17 @@ def Train(args):
                     prefix=args.run_id,
                 )
             )
+        elif args.tcp_store_host is not None:
+            # Shard 0 serves the store the other shards connect to
+            workspace.RunOperatorOnce(
+                core.CreateOperator(
+                    "TcpStoreHandlerCreate", [], [store_handler],
+                    host=args.tcp_store_host,
+                    port=args.tcp_store_port,
+                    prefix=args.run_id,
+                    server=(shard_id == 0),
+                )
+            )
         else:
             # Use filesystem for rendezvous otherwise
             workspace.RunOperatorOnce(
@@ -586,6 +600,11 @@ def main():
                         help="Host of Redis server (for rendezvous)")
     parser.add_argument("--redis_port", type=int, default=6379,
                         help="Port of Redis server (for rendezvous)")
+    parser.add_argument("--tcp_store_host", type=str,
+                        help="Host of shard 0, which serves a TCP store "
+                        "(for rendezvous)")
+    parser.add_argument("--tcp_store_port", type=int, default=29500,
+                        help="Port of the TCP store (for rendezvous)")
     parser.add_argument("--file_store_path", type=str, default="/tmp",
                         help="Path to directory to use for rendezvous")
     parser.add_argument("--save_model_name", type=str, default="resnet50_model",
@@ -0,0 +1,67 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core, workspace
+import caffe2.python.hypothesis_test_util as hu
+
+import numpy as np
+from hypothesis import given
+import hypothesis.strategies as st
+
+# Eigen/Python round 0.5 away from 0, Numpy rounds to even
+round_to_nearest = np.vectorize(round)
+
+
+def fused_rowwise_nbit_quantize_dequantize_reference(data, bit_rate):
+    num_elem_per_byte = 8 // bit_rate
+    columns = data.shape[1]
+    padded_columns = -(-columns // num_elem_per_byte) * num_elem_per_byte
+    minimum = np.min(data, axis=1, keepdims=True)
+    maximum = np.max(data, axis=1, keepdims=True)
+    span = maximum - minimum
+    max_quantized = (1 << bit_rate) - 1
+    scale = (span / max_quantized).astype(np.float32)
+    inverse_scale = max_quantized / (span + 1e-8)
+    quantized_data = np.clip(
+        round_to_nearest((data - minimum) * inverse_scale), 0, max_quantized)
+    padded = np.zeros([data.shape[0], padded_columns], dtype=np.float32)
+    padded[:, :columns] = quantized_data
+    return padded * scale + minimum
+
+
+class TestFusedNBitRowwiseQuantizationConversion(hu.HypothesisTestCase):
+    @given(
+        input_data=hu.tensor(min_dim=2, max_dim=2),
+        bit_rate=st.sampled_from([2, 4]),
+    )
+    def test_quantize_and_dequantize_op(self, input_data, bit_rate):
+        num_elem_per_byte = 8 // bit_rate
+        quantize = core.CreateOperator(
+            'FloatToFused{}BitRowwiseQuantized'.format(bit_rate),
+            ['input_data'],
+            ['quantized_data'],
+        )
+        workspace.FeedBlob('input_data', input_data)
+        workspace.RunOperatorOnce(quantize)
+
+        quantized_data = workspace.FetchBlob('quantized_data')
+        packed_columns = -(-input_data.shape[1] // num_elem_per_byte)
+        self.assertEqual(quantized_data.dtype, np.uint8)
+        self.assertEqual(
+            quantized_data.shape, (input_data.shape[0], packed_columns + 8))
+
+        dequantize = core.CreateOperator(
+            'Fused{}BitRowwiseQuantizedToFloat'.format(bit_rate),
+            ['quantized_data'],
+            ['dequantized_data'],
+        )
+        workspace.RunOperatorOnce(dequantize)
+
+        dequantized_data = workspace.FetchBlob('dequantized_data')
+
+        reference = fused_rowwise_nbit_quantize_dequantize_reference(
+            input_data.astype(np.float32), bit_rate)
+        np.testing.assert_array_almost_equal(
+            dequantized_data, reference, decimal=4)
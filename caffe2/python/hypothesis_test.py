@@ -386,6 +386,50 @@ class TestOperators(hu.HypothesisTestCase):
                 hu.gpu_do, op, inputs, input_idx, [0],
                 stepsize=0.01, threshold=0.01)
 
+    @unittest.skipIf(not workspace.has_gpu_support,
+                     "Skipping test due to no gpu present.")
+    @given(hidden_size=st.integers(min_value=1, max_value=32),
+           num_layers=st.integers(min_value=1, max_value=3),
+           T=st.integers(min_value=2, max_value=6),
+           N=st.integers(min_value=1, max_value=12),
+           D=st.integers(min_value=1, max_value=4))
+    def test_recurrent_inference(self, hidden_size, num_layers, T, N, D):
+        # Small batches run the persistent algorithm in inference, which has
+        # to match the standard algorithm used in training
+        first_layer_sz = hidden_size * (D + hidden_size + 2)
+        upper_layer_sz = hidden_size * (2 * hidden_size + 2)
+        total_sz = 4 * (first_layer_sz + (num_layers - 1) * upper_layer_sz)
+        inputs = [
+            np.random.randn(T, N, D).astype(np.float32),
+            np.random.randn(num_layers, N, hidden_size).astype(np.float32),
+            np.random.randn(num_layers, N, hidden_size).astype(np.float32),
+            (np.random.rand(total_sz).astype(np.float32) - 0.5) * 0.2,
+        ]
+        outputs = []
+        for is_test in [0, 1]:
+            for name, value in zip(
+                    ["INPUT", "HIDDEN_INPUT", "CELL_INPUT", "WEIGHT"], inputs):
+                self.ws.create_blob(name).feed(value, device_option=hu.gpu_do)
+            op = core.CreateOperator(
+                "Recurrent",
+                ["INPUT", "HIDDEN_INPUT", "CELL_INPUT", "WEIGHT"],
+                ["OUTPUT", "HIDDEN_OUTPUT", "CELL_OUTPUT",
+                 "RNN_SCRATCH", "DROPOUT_STATES"],
+                hidden_size=hidden_size,
+                bidirectional=False,
+                rnn_mode="lstm",
+                dropout=1.0,
+                input_mode="linear",
+                num_layers=num_layers,
+                is_test=is_test,
+                engine="CUDNN",
+                device_option=hu.gpu_do)
+            self.ws.run(op)
+            outputs.append([self.ws.blobs[name].fetch() for name in
+                            ["OUTPUT", "HIDDEN_OUTPUT", "CELL_OUTPUT"]])
+        for training, inference in zip(*outputs):
+            np.testing.assert_allclose(training, inference, atol=1e-4)
+
     @given(ndim=st.integers(1, 4),
            axis=st.integers(0, 3),
            add_axis=st.integers(0, 1),
@@ -1120,6 +1164,28 @@ class TestOperators(hu.HypothesisTestCase):
         t = time.time() - t
         self.assertGreater(t, 0.19)
 
+    def test_safe_dequeue_blobs_many(self):
+        self.ws.run(core.CreateOperator(
+            "CreateBlobsQueue", [], ["queue"], capacity=5, num_blobs=1))
+        for i in range(5):
+            self.ws.create_blob("x").feed(np.array([i], dtype=np.float32))
+            self.ws.run(core.CreateOperator(
+                "EnqueueBlobs", ["queue", "x"], ["x"]))
+        self.ws.run(core.CreateOperator("CloseBlobsQueue", ["queue"], []))
+        dequeue = core.CreateOperator(
+            "SafeDequeueBlobs", ["queue"], ["y", "status"], num_records=3)
+        self.ws.run(dequeue)
+        np.testing.assert_array_equal(
+            self.ws.blobs["y"].fetch(), np.array([0, 1, 2], dtype=np.float32))
+        self.assertFalse(self.ws.blobs["status"].fetch())
+        # the queue is closed, so the remaining records are returned
+        self.ws.run(dequeue)
+        np.testing.assert_array_equal(
+            self.ws.blobs["y"].fetch(), np.array([3, 4], dtype=np.float32))
+        self.assertFalse(self.ws.blobs["status"].fetch())
+        self.ws.run(dequeue)
+        self.assertTrue(self.ws.blobs["status"].fetch())
+
     @given(num_threads=st.integers(1, 10),  # noqa
            num_elements=st.integers(1, 100),
            capacity=st.integers(1, 5),
@@ -0,0 +1,352 @@
+## @package int8_transform
+# Module caffe2.python.int8_transform
+"""
+Rewrites fp32 inference nets into nets of the int8 operators in
+caffe2/operators/quantized, using value ranges collected by running the fp32
+net on calibration data:
+
+    stats = int8_transform.calibrate(init_net, predict_net, batches)
+    int8_init_net, int8_predict_net = int8_transform.quantize_net(
+        predict_net, stats)
+
+int8 blobs hold uint8 values q for the real values scale * (q - zero_point),
+with 4-D blobs in NHWC order. The float inputs of the net are quantized where
+an int8 op first needs them, and blobs are dequantized back to NCHW floats for
+the external outputs and for the ops that have no int8 version.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from collections import defaultdict, namedtuple
+
+import numpy as np
+
+from caffe2.proto import caffe2_pb2
+from caffe2.python import core, utils, workspace
+
+BlobStats = namedtuple('BlobStats', ['min', 'max', 'shape'])
+
+
+def calibrate(init_net, predict_net, batches):
+    """Runs init_net once and predict_net on every batch, a dict from input
+    blob names to arrays, and returns the BlobStats of every float blob of
+    predict_net. The parameters stay in the workspace, for quantize_net."""
+    workspace.RunNetOnce(init_net)
+    blobs = set(predict_net.external_input)
+    for op in predict_net.op:
+        blobs.update(op.input)
+        blobs.update(op.output)
+    stats = {}
+    for batch in batches:
+        for name, value in batch.items():
+            workspace.FeedBlob(name, value)
+        workspace.RunNetOnce(predict_net)
+        for name in blobs:
+            value = workspace.FetchBlob(name)
+            if (not isinstance(value, np.ndarray) or
+                    value.dtype != np.float32 or value.size == 0):
+                continue
+            lo, hi = float(value.min()), float(value.max())
+            if name in stats:
+                lo = min(lo, stats[name].min)
+                hi = max(hi, stats[name].max)
+            stats[name] = BlobStats(lo, hi, value.shape)
+    return stats
+
+
+def choose_quantization_params(lo, hi):
+    """Returns the scale and zero point that cover [lo, hi], widened to hold
+    0 exactly."""
+    lo = min(lo, 0.0)
+    hi = max(hi, 0.0)
+    scale = (hi - lo) / 255.0 if hi > lo else 1.0
+    zero_point = int(np.clip(np.round(-lo / scale), 0, 255))
+    return float(scale), zero_point
+
+
+def quantize(values, scale, zero_point):
+    return np.clip(
+        np.round(values / scale) + zero_point, 0, 255).astype(np.uint8)
+
+
+def _get_arg(op, name, default):
+    for arg in op.arg:
+        if arg.name == name:
+            if arg.HasField('i'):
+                return arg.i
+            if arg.HasField('s'):
+                return arg.s.decode('utf-8')
+            return arg.f
+    return default
+
+
+class _Int8NetRewriter(object):
+    def __init__(self, predict_net, stats):
+        self.stats = stats
+        self.params = {}
+        self.init_net = caffe2_pb2.NetDef()
+        self.init_net.name = predict_net.name + '_int8_init'
+        self.net = caffe2_pb2.NetDef()
+        self.net.name = predict_net.name + '_int8'
+        self.net.external_input.extend(predict_net.external_input)
+        self.net.external_output.extend(predict_net.external_output)
+        self.float_blobs = set(predict_net.external_input)
+        self.int8_blobs = set()
+        self.uses = defaultdict(int)
+        for op in predict_net.op:
+            for name in op.input:
+                self.uses[name] += 1
+        for name in predict_net.external_output:
+            self.uses[name] += 1
+
+    def _is_4d(self, name):
+        return name in self.stats and len(self.stats[name].shape) == 4
+
+    def _params(self, name):
+        if name not in self.params:
+            if name not in self.stats:
+                raise ValueError('No calibration stats for ' + name)
+            self.params[name] = choose_quantization_params(
+                self.stats[name].min, self.stats[name].max)
+        return self.params[name]
+
+    def _emit(self, *args, **kwargs):
+        op = core.CreateOperator(*args, **kwargs)
+        self.net.op.extend([op])
+        return op
+
+    def _int8(self, name):
+        """Returns the int8 version of blob name, quantizing it if needed."""
+        int8_name = name + '_int8'
+        if name in self.int8_blobs:
+            return int8_name
+        scale, zero_point = self._params(name)
+        source = name
+        if self._is_4d(name):
+            source = name + '_nhwc'
+            self._emit('NCHW2NHWC', [name], [source])
+        self._emit(
+            'Int8Quantize', [source], [int8_name],
+            Y_scale=scale, Y_zero_point=zero_point)
+        self.int8_blobs.add(name)
+        return int8_name
+
+    def _float(self, name):
+        """Makes sure the float version of blob name is computed."""
+        if name in self.float_blobs or name not in self.int8_blobs:
+            return
+        if self._is_4d(name):
+            self._emit('Int8Dequantize', [name + '_int8'], [name + '_nhwc'])
+            self._emit('NHWC2NCHW', [name + '_nhwc'], [name])
+        else:
+            self._emit('Int8Dequantize', [name + '_int8'], [name])
+        self.float_blobs.add(name)
+
+    def _int8_output(self, name, params):
+        self.params[name] = params
+        self.int8_blobs.add(name)
+        self.float_blobs.discard(name)
+        return name + '_int8'
+
+    def _with_params(self, name, params):
+        """Returns the int8 version of blob name requantized to params."""
+        int8_name = self._int8(name)
+        if self._params(name) == params:
+            return int8_name
+        requantized = '{}_int8_{}_{}'.format(name, params[0], params[1])
+        self._emit('Int8Dequantize', [int8_name], [requantized + '_float'])
+        self._emit(
+            'Int8Quantize', [requantized + '_float'], [requantized],
+            Y_scale=params[0], Y_zero_point=params[1])
+        return requantized
+
+    def _weights(self, name, values):
+        scale, zero_point = choose_quantization_params(
+            float(values.min()), float(values.max()))
+        self.init_net.op.extend([core.CreateOperator(
+            'Int8GivenTensorFill', [], [name + '_int8'],
+            values=quantize(values, scale, zero_point).tobytes(),
+            shape=list(values.shape),
+            Y_scale=scale, Y_zero_point=zero_point)])
+        return name + '_int8', scale
+
+    def _bias(self, name, values, scale):
+        self.init_net.op.extend([core.CreateOperator(
+            'Int8GivenIntTensorFill', [], [name + '_int8'],
+            values=np.round(values / scale).astype(np.int32),
+            shape=list(values.shape),
+            Y_scale=scale, Y_zero_point=0)])
+        return name + '_int8'
+
+    def _copy_args(self, op, new_op, skip=('order',)):
+        new_op.arg.extend(a for a in op.arg if a.name not in skip)
+
+    def _conv(self, op, output):
+        W = workspace.FetchBlob(op.input[1])
+        if W.ndim != 4 or _get_arg(op, 'order', 'NCHW') != 'NCHW':
+            return False
+        # MCHW to MHWC
+        w_int8, w_scale = self._weights(
+            op.input[1], np.ascontiguousarray(W.transpose(0, 2, 3, 1)))
+        x_scale, _ = self._params(op.input[0])
+        if len(op.input) > 2:
+            b_name, B = op.input[2], workspace.FetchBlob(op.input[2])
+        else:
+            b_name, B = output + '_bias', np.zeros(W.shape[0], np.float32)
+        b_int8 = self._bias(b_name, B, x_scale * w_scale)
+        x_int8 = self._int8(op.input[0])
+        y_scale, y_zero_point = self._params(output)
+        relu = output != op.output[0]
+        new_op = self._emit(
+            'Int8ConvRelu' if relu else 'Int8Conv',
+            [x_int8, w_int8, b_int8],
+            [self._int8_output(output, (y_scale, y_zero_point))],
+            order='NHWC', Y_scale=y_scale, Y_zero_point=y_zero_point)
+        self._copy_args(op, new_op)
+        return True
+
+    def _fc(self, op):
+        x = op.input[0]
+        W = workspace.FetchBlob(op.input[1])
+        if _get_arg(op, 'axis_w', 1) != 1 or x not in self.stats:
+            return False
+        if self._is_4d(x):
+            if _get_arg(op, 'axis', 1) != 1:
+                return False
+            # X is flattened from NHWC rather than NCHW, so the columns of W
+            # follow suit
+            _, C, H, W_in = self.stats[x].shape
+            W = W.reshape(W.shape[0], C, H, W_in).transpose(0, 2, 3, 1)
+            W = np.ascontiguousarray(W.reshape(W.shape[0], -1))
+        w_int8, w_scale = self._weights(op.input[1], W)
+        x_scale, _ = self._params(x)
+        b_int8 = self._bias(
+            op.input[2], workspace.FetchBlob(op.input[2]), x_scale * w_scale)
+        x_int8 = self._int8(x)
+        y_scale, y_zero_point = self._params(op.output[0])
+        new_op = self._emit(
+            'Int8FC', [x_int8, w_int8, b_int8],
+            [self._int8_output(op.output[0], (y_scale, y_zero_point))],
+            Y_scale=y_scale, Y_zero_point=y_zero_point)
+        self._copy_args(op, new_op, skip=('axis_w',))
+        return True
+
+    def _same_params(self, op, int8_type):
+        """For ops whose output keeps the scale and zero point of X."""
+        if _get_arg(op, 'order', 'NCHW') != 'NCHW':
+            return False
+        x_int8 = self._int8(op.input[0])
+        new_op = self._emit(
+            int8_type, [x_int8],
+            [self._int8_output(op.output[0], self._params(op.input[0]))])
+        if int8_type != 'Int8Relu':
+            new_op.arg.extend([utils.MakeArgument('order', 'NHWC')])
+            self._copy_args(op, new_op)
+        return True
+
+    def _average_pool(self, op):
+        if (_get_arg(op, 'order', 'NCHW') != 'NCHW' or
+                not self._is_4d(op.input[0])):
+            return False
+        x_int8 = self._int8(op.input[0])
+        y_scale, y_zero_point = self._params(op.output[0])
+        new_op = self._emit(
+            'Int8AveragePool', [x_int8],
+            [self._int8_output(op.output[0], (y_scale, y_zero_point))],
+            order='NHWC', Y_scale=y_scale, Y_zero_point=y_zero_point)
+        self._copy_args(op, new_op)
+        return True
+
+    def _add(self, op, output):
+        a, b = op.input
+        if (a not in self.stats or b not in self.stats or
+                self.stats[a].shape != self.stats[b].shape):
+            return False
+        a_int8, b_int8 = self._int8(a), self._int8(b)
+        y_scale, y_zero_point = self._params(output)
+        self._emit(
+            'Int8AddRelu' if output != op.output[0] else 'Int8Add',
+            [a_int8, b_int8],
+            [self._int8_output(output, (y_scale, y_zero_point))],
+            Y_scale=y_scale, Y_zero_point=y_zero_point)
+        return True
+
+    def _concat(self, op):
+        if len(op.output) > 1 and self.uses[op.output[1]] > 0:
+            return False
+        axis = _get_arg(op, 'axis', 1)
+        if _get_arg(op, 'order', 'NCHW') != 'NCHW' or axis != 1:
+            return False
+        if not all(self._is_4d(x) for x in op.input):
+            return False
+        params = self._params(op.output[0])
+        inputs = [self._with_params(x, params) for x in op.input]
+        self._emit(
+            'Int8Concat', inputs,
+            [self._int8_output(op.output[0], params)], axis=3)
+        return True
+
+    def _fallback(self, op):
+        for name in op.input:
+            self._float(name)
+        self.net.op.extend([op])
+        for name in op.output:
+            self.float_blobs.add(name)
+            self.int8_blobs.discard(name)
+
+    def _fused_relu(self, ops, i):
+        """Returns the Relu that follows ops[i], if nothing else can see the
+        output of ops[i] before the Relu, or None."""
+        if i + 1 >= len(ops):
+            return None
+        relu = ops[i + 1]
+        output = ops[i].output[0]
+        if (relu.type == 'Relu' and relu.input[0] == output and
+                (relu.output[0] == output or self.uses[output] == 1)):
+            return relu
+        return None
+
+    def rewrite(self, predict_net):
+        ops = list(predict_net.op)
+        i = 0
+        while i < len(ops):
+            op = ops[i]
+            relu = None
+            if op.type in ('Conv', 'Add', 'Sum'):
+                relu = self._fused_relu(ops, i)
+            output = relu.output[0] if relu else None
+            if op.type == 'Conv':
+                done = self._conv(op, output or op.output[0])
+            elif op.type == 'FC' and len(op.input) == 3:
+                done = self._fc(op)
+            elif op.type == 'Relu':
+                done = self._same_params(op, 'Int8Relu')
+            elif op.type == 'MaxPool':
+                done = (self._is_4d(op.input[0]) and
+                        self._same_params(op, 'Int8MaxPool'))
+            elif op.type == 'AveragePool':
+                done = self._average_pool(op)
+            elif (op.type in ('Add', 'Sum') and len(op.input) == 2 and
+                    not _get_arg(op, 'broadcast', 0)):
+                done = self._add(op, output or op.output[0])
+            elif op.type == 'Concat':
+                done = self._concat(op)
+            else:
+                done = False
+            if not done:
+                self._fallback(op)
+                relu = None
+            i += 2 if relu else 1
+        for name in predict_net.external_output:
+            self._float(name)
+        return self.init_net, self.net
+
+
+def quantize_net(predict_net, stats):
+    """Returns an init net with the int8 weights, and the int8 version of
+    predict_net. The fp32 weights are read from the workspace, where calibrate
+    left them."""
+    return _Int8NetRewriter(predict_net, stats).rewrite(predict_net)
@@ -0,0 +1,61 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import unittest
+
+import numpy as np
+
+from caffe2.python import brew, int8_transform, model_helper, workspace
+
+
+class TestInt8Transform(unittest.TestCase):
+    def setUp(self):
+        workspace.ResetWorkspace()
+        np.random.seed(0)
+
+    def _build_model(self):
+        model = model_helper.ModelHelper(name='int8_test')
+        conv1 = brew.conv(model, 'data', 'conv1', 3, 8, 3, pad=1)
+        relu1 = brew.relu(model, conv1, conv1)
+        conv2 = brew.conv(model, relu1, 'conv2', 8, 8, 1)
+        res = brew.sum(model, [conv2, relu1], 'res')
+        pool = brew.max_pool(model, res, 'pool', kernel=2, stride=2)
+        cat = brew.concat(model, [pool, pool], 'cat')
+        # Softmax has no int8 version, the transform falls back to fp32
+        soft = model.net.Softmax(cat, 'soft')
+        avg = brew.average_pool(model, soft, 'avg', kernel=2, stride=2)
+        fc = brew.fc(model, avg, 'fc', 16 * 2 * 2, 10)
+        model.net.AddExternalOutput(fc)
+        return model
+
+    def test_quantize_net(self):
+        model = self._build_model()
+        batches = [{'data': np.random.rand(2, 3, 8, 8).astype(np.float32)}
+                   for _ in range(3)]
+        stats = int8_transform.calibrate(
+            model.param_init_net.Proto(), model.net.Proto(), batches)
+        workspace.RunNetOnce(model.net.Proto())
+        expected = workspace.FetchBlob('fc')
+
+        init_net, predict_net = int8_transform.quantize_net(
+            model.net.Proto(), stats)
+        types = [op.type for op in predict_net.op]
+        for op_type in ['Int8ConvRelu', 'Int8Conv', 'Int8Add', 'Int8MaxPool',
+                        'Int8Concat', 'Softmax', 'Int8AveragePool', 'Int8FC']:
+            self.assertIn(op_type, types)
+        self.assertNotIn('Relu', types)
+
+        workspace.ResetWorkspace()
+        workspace.RunNetOnce(init_net)
+        workspace.FeedBlob('data', batches[-1]['data'])
+        workspace.RunNetOnce(predict_net)
+        actual = workspace.FetchBlob('fc')
+        self.assertEqual(actual.shape, expected.shape)
+        tolerance = 0.1 * (np.abs(expected).max() + 1e-3)
+        np.testing.assert_allclose(actual, expected, atol=tolerance)
+
+
+if __name__ == "__main__":
+    unittest.main()
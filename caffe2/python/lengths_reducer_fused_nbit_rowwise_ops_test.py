@@ -0,0 +1,71 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core, workspace
+import caffe2.python.hypothesis_test_util as hu
+
+import numpy as np
+from hypothesis import given
+import hypothesis.strategies as st
+
+
+class TestLengthsReducerOpsFusedNBitRowwise(hu.HypothesisTestCase):
+    @given(
+        input_data=hu.tensor(min_dim=2, max_dim=2),
+        bit_rate=st.sampled_from([2, 4]),
+        reducer=st.sampled_from(['Sum', 'WeightedSum', 'Mean']),
+        seed=st.integers(0, 2**32 - 1),
+    )
+    def test_sparse_lengths_reducer(self, input_data, bit_rate, reducer, seed):
+        net = core.Net("bench")
+
+        np.random.seed(seed)
+
+        input_data = input_data.astype(np.float32)
+        indices = np.random.randint(
+            low=0,
+            high=len(input_data),
+            size=[np.random.randint(len(input_data))],
+            dtype=np.int32
+        )
+        weights = np.random.uniform(size=[len(indices)]).astype(np.float32)
+        lengths_split = np.clip(1, len(indices) // 2, 10)
+        lengths = np.ones(
+            [len(indices) // lengths_split], dtype=np.int32
+        ) * lengths_split
+
+        quantized_data = net.__getattr__(
+            'FloatToFused{}BitRowwiseQuantized'.format(bit_rate)
+        )('input_data', 'quantized_data')
+        dequantized_data = net.__getattr__(
+            'Fused{}BitRowwiseQuantizedToFloat'.format(bit_rate)
+        )(quantized_data, 'dequantized_data')
+
+        if reducer == 'WeightedSum':
+            reference_inputs = [
+                dequantized_data, 'weights', 'indices', 'lengths']
+            quantized_inputs = [
+                quantized_data, 'weights', 'indices', 'lengths']
+        else:
+            reference_inputs = [dequantized_data, 'indices', 'lengths']
+            quantized_inputs = [quantized_data, 'indices', 'lengths']
+        net.__getattr__('SparseLengths' + reducer)(
+            reference_inputs, 'reference')
+        net.__getattr__(
+            'SparseLengths{}Fused{}BitRowwise'.format(reducer, bit_rate)
+        )(quantized_inputs, 'quantized')
+
+        workspace.FeedBlob('input_data', input_data)
+        workspace.FeedBlob('weights', weights)
+        workspace.FeedBlob('indices', indices)
+        workspace.FeedBlob('lengths', lengths)
+
+        workspace.GlobalInit(['caffe2', '--caffe2_log_level=0'])
+        workspace.CreateNet(net)
+        workspace.RunNetOnce(net)
+
+        reference = workspace.FetchBlob('reference')
+        quantized = workspace.FetchBlob('quantized')
+        np.testing.assert_array_almost_equal(reference, quantized, decimal=4)
@@ -279,6 +279,159 @@ def release_blobs_when_used(netproto, dont_free_blobs, selector_fun=None):
     return netproto
 
 
+# Ops whose outputs are cheap enough to compute a second time in the backward
+# pass that it beats keeping them in memory or copying them to the host
+RECOMPUTE_OP_TYPES = frozenset([
+    'Relu', 'LeakyRelu', 'Elu', 'Sigmoid', 'Tanh', 'Softsign', 'Scale',
+    'Add', 'Sub', 'Mul', 'Sum', 'Copy',
+])
+
+
+def optimize_training_memory(
+    netproto,
+    losses,
+    memory_budget,
+    blob_sizes,
+    recompute_op_types=RECOMPUTE_OP_TYPES,
+    offload=True,
+    prefetch_ops=2,
+    dont_drop_blobs=None,
+):
+    '''
+    Reduces the memory taken by the activations of a training net that are
+    kept from the forward pass until the backward pass uses them, which peaks
+    where the forward pass ends. Activations are dropped until the ones that
+    are kept fit into @memory_budget bytes, largest first:
+
+    - An activation produced by an op of @recompute_op_types whose inputs are
+      kept is freed after its last forward use, and the op is run again right
+      before its first backward use.
+    - Otherwise, an activation produced on a GPU is copied to host memory
+      right after it is produced, freed after its last forward use, and
+      copied back @prefetch_ops backward ops before its first backward use.
+      CPU tensors are allocated pinned once a GPU is used, so the copies are
+      asynchronous; run the net as async_dag or async_scheduling so that they
+      go on streams of their own and overlap the compute. Control inputs keep
+      the copy back from running before the backward pass gets near it.
+
+    Only blobs that are written by a single op are considered. The backward
+    ops themselves are not changed. Ops that draw random numbers must not be
+    in @recompute_op_types.
+
+    @losses:           the losses the gradient ops were added for; the
+                       forward pass ends with the last op producing one
+    @blob_sizes:       size in bytes of each blob, e.g. collect_blob_sizes()
+                       after a run
+    @dont_drop_blobs:  set of blobs to keep in any case
+
+    Returns a new protobuffer. To use with a model, use:
+        model.net._net = memonger.optimize_training_memory(..)
+    '''
+    ops = list(netproto.op)
+    losses = set(str(l) for l in losses)
+    dont_drop_blobs = set(dont_drop_blobs or [])
+    fwd_end = max(
+        [i + 1 for i, op in enumerate(ops) if losses.intersection(op.output)]
+        or [0])
+    assert fwd_end > 0, "None of the losses is produced by the net"
+
+    producers = collections.defaultdict(list)
+    fwd_uses = collections.defaultdict(list)
+    bwd_uses = collections.defaultdict(list)
+    for i, op in enumerate(ops):
+        for b in op.output:
+            producers[b].append(i)
+        for b in op.input:
+            (fwd_uses if i < fwd_end else bwd_uses)[b].append(i)
+
+    def single_definition(b):
+        return len(producers[b]) == 1 and b not in ops[producers[b][0]].input
+
+    def unchanged_until_backward(b):
+        # external inputs, e.g. parameters, or activations written once
+        return not producers[b] or (single_definition(b) and
+                                    producers[b][0] < fwd_end)
+
+    external = set(netproto.external_input) | set(netproto.external_output)
+    activations = [
+        b for b in producers
+        if single_definition(b) and producers[b][0] < fwd_end and
+        bwd_uses[b] and b not in external and b not in losses and
+        b not in dont_drop_blobs
+    ]
+    held = sum(blob_sizes[b] for b in activations)
+    log.info("Activations kept for the backward pass: {} bytes".format(held))
+
+    recompute = []
+    offloaded = []
+    # recompute ops read their inputs in the backward pass
+    read_by_recompute = set()
+    for b in sorted(activations, key=lambda b: -blob_sizes[b]):
+        if held <= memory_budget:
+            break
+        if b in read_by_recompute:
+            continue
+        producer = ops[producers[b][0]]
+        if (producer.type in recompute_op_types and
+                len(producer.output) == 1 and
+                all(unchanged_until_backward(inp) and
+                    inp not in offloaded and inp not in recompute
+                    for inp in producer.input)):
+            recompute.append(b)
+            read_by_recompute.update(producer.input)
+        elif (offload and producer.device_option.device_type ==
+                caffe2_pb2.CUDA):
+            offloaded.append(b)
+        else:
+            continue
+        held -= blob_sizes[b]
+    if held > memory_budget:
+        log.warning(
+            "Activations take {} bytes, more than the budget of {} bytes, "
+            "after dropping what can be dropped".format(held, memory_budget))
+
+    # ops to insert after / before the op with a given index
+    after = collections.defaultdict(list)
+    before = collections.defaultdict(list)
+
+    def free_op(b, control_input=None):
+        return core.CreateOperator(
+            "Free", [b], [b], control_input=control_input,
+            device_option=ops[producers[b][0]].device_option)
+
+    for b in recompute:
+        last_fwd_use = max(fwd_uses[b] or producers[b])
+        after[last_fwd_use].append(free_op(b))
+        before[min(bwd_uses[b])].append(copy.deepcopy(ops[producers[b][0]]))
+
+    for b in offloaded:
+        producer = ops[producers[b][0]]
+        host = b + "_host"
+        after[producers[b][0]].append(core.CreateOperator(
+            "CopyGPUToCPU", [b], [host],
+            device_option=producer.device_option))
+        last_fwd_use = max(fwd_uses[b] or producers[b])
+        after[last_fwd_use].append(free_op(b, control_input=[host]))
+        first_bwd_use = min(bwd_uses[b])
+        reload_at = max(first_bwd_use - prefetch_ops, fwd_end)
+        # don't start before the backward pass got to it
+        trigger = ops[reload_at - 1].output[:1]
+        before[reload_at].append(core.CreateOperator(
+            "CopyCPUToGPU", [host], [b], control_input=trigger,
+            device_option=producer.device_option))
+
+    optim = copy.deepcopy(netproto)
+    del optim.op[:]
+    for i, op in enumerate(ops):
+        optim.op.extend(before[i])
+        optim.op.extend([op])
+        optim.op.extend(after[i])
+
+    log.info("Recomputing {} and offloading {} activations".format(
+        len(recompute), len(offloaded)))
+    return optim
+
+
 def _find_source_nodes(g):
     ''' Return nodes without predecessors '''
     ret = []
@@ -832,6 +985,32 @@ def optimize_inference_fast(net, static_blobs):
     return optim
 
 
+def plan_inference_memory(net, input_shapes, static_blobs, apply=False,
+                          alias_concat_and_split=False):
+    """
+    Places the intermediate blobs of an inference net in a single buffer,
+    using shape inference from input_shapes (a dict from every external input
+    of the net, parameters included, to its shape). Returns a dict with the
+    size of the buffer ("arena_size"), the memory the planned blobs would
+    take without sharing ("total_size"), and the (offset, size) of every
+    planned blob ("offsets"). With apply=True, also allocates the buffer and
+    places the blobs of the current workspace in it.
+
+    With alias_concat_and_split=True, the inputs of Concat and the outputs of
+    Split are placed inside the blob they are concatenated into or split
+    from, when they are contiguous slices of it, so that these ops don't
+    copy anything. "aliases" maps every such blob to the one it is a slice
+    of.
+    """
+    return C.memonger_plan_inference_net_memory(
+        net.SerializeToString(),
+        {str(k): [int(d) for d in v] for k, v in viewitems(input_shapes)},
+        [str(s).encode('utf-8') for s in static_blobs],
+        apply,
+        alias_concat_and_split,
+    )
+
+
 def optimize_interference(net, static_blobs,
                           ordering_function=topological_sort_traversal,
                           blob_sizes=None,
@@ -3,6 +3,7 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
+import collections
 import numpy as np
 
 from caffe2.python import workspace, memonger, core, model_helper, brew
@@ -152,6 +153,77 @@ class MemongerTest(hu.HypothesisTestCase):
         for op in optimized_net.op:
             self.assertEqual(len(op.output), len(set(op.output)), str(op))
 
+    def test_plan_inference_memory(self):
+        m = model_helper.ModelHelper()
+        fc1 = brew.fc(m, "data", "fc1", dim_in=4, dim_out=8)
+        r1 = brew.relu(m, fc1, "r1")
+        fc2 = brew.fc(m, r1, "fc2", dim_in=8, dim_out=8)
+        r2 = brew.relu(m, fc2, "r2")
+        brew.fc(m, r2, "out", dim_in=8, dim_out=2)
+        m.net.AddExternalOutput("out")
+
+        workspace.RunNetOnce(m.param_init_net)
+        data = np.random.rand(3, 4).astype(np.float32)
+        workspace.FeedBlob("data", data)
+        workspace.RunNetOnce(m.net)
+        expected = workspace.FetchBlob("out")
+
+        input_shapes = {"data": [3, 4]}
+        for op in m.param_init_net.Proto().op:
+            input_shapes[op.output[0]] = \
+                workspace.FetchBlob(op.output[0]).shape
+        workspace.ResetWorkspace()
+        workspace.RunNetOnce(m.param_init_net)
+        workspace.FeedBlob("data", data)
+        plan = memonger.plan_inference_memory(
+            m.net.Proto(), input_shapes, [], apply=True)
+
+        self.assertEqual(
+            set(plan["offsets"]), {"fc1", "r1", "fc2", "r2", "out"})
+        self.assertLess(plan["arena_size"], plan["total_size"])
+        # blobs alive at the same time don't overlap, the others can
+        self.assertNotEqual(
+            plan["offsets"]["fc1"][0], plan["offsets"]["r1"][0])
+        self.assertEqual(
+            plan["offsets"]["fc1"][0], plan["offsets"]["fc2"][0])
+        workspace.RunNetOnce(m.net)
+        np.testing.assert_almost_equal(workspace.FetchBlob("out"), expected)
+
+    def test_plan_inference_memory_alias_concat(self):
+        m = model_helper.ModelHelper()
+        fc1 = brew.fc(m, "data", "fc1", dim_in=4, dim_out=8)
+        fc2 = brew.fc(m, "data", "fc2", dim_in=4, dim_out=8)
+        m.net.Concat([fc1, fc2], ["cat", "cat_dims"], axis=0)
+        r = brew.relu(m, "cat", "r")
+        brew.fc(m, r, "out", dim_in=8, dim_out=2)
+        m.net.AddExternalOutput("out")
+
+        workspace.RunNetOnce(m.param_init_net)
+        data = np.random.rand(3, 4).astype(np.float32)
+        workspace.FeedBlob("data", data)
+        workspace.RunNetOnce(m.net)
+        expected = workspace.FetchBlob("out")
+
+        input_shapes = {"data": [3, 4]}
+        for op in m.param_init_net.Proto().op:
+            input_shapes[op.output[0]] = \
+                workspace.FetchBlob(op.output[0]).shape
+        workspace.ResetWorkspace()
+        workspace.RunNetOnce(m.param_init_net)
+        workspace.FeedBlob("data", data)
+        plan = memonger.plan_inference_memory(
+            m.net.Proto(), input_shapes, [], apply=True,
+            alias_concat_and_split=True)
+
+        # the inputs of Concat are the two halves of its output
+        self.assertEqual(plan["aliases"], {"fc1": "cat", "fc2": "cat"})
+        offsets = plan["offsets"]
+        self.assertEqual(offsets["fc1"][0], offsets["cat"][0])
+        self.assertEqual(
+            offsets["fc2"][0], offsets["cat"][0] + offsets["fc1"][1])
+        workspace.RunNetOnce(m.net)
+        np.testing.assert_almost_equal(workspace.FetchBlob("out"), expected)
+
     @given(input_dim=st.integers(min_value=1, max_value=4),
            output_dim=st.integers(min_value=1, max_value=4),
            batch_size=st.integers(min_value=1, max_value=4))
@@ -757,5 +829,79 @@ class MemongerTest(hu.HypothesisTestCase):
         self.assertEqual(expect_frees, found_frees)
 
 
+    def test_optimize_training_memory_recompute(self):
+        m = model_helper.ModelHelper()
+        fc1 = brew.fc(m, "data", "fc1", dim_in=4, dim_out=4)
+        relu1 = brew.relu(m, fc1, "relu1")
+        fc2 = brew.fc(m, relu1, "fc2", dim_in=4, dim_out=4)
+        relu2 = brew.relu(m, fc2, "relu2")
+        relu2.SquaredL2Distance(["label"], "dist").AveragedLoss([], "loss")
+        input_to_grad = m.AddGradientOperators(["loss"])
+
+        data = np.random.randn(3, 4).astype(np.float32)
+        label = np.random.randn(3, 4).astype(np.float32)
+        workspace.RunNetOnce(m.param_init_net)
+        workspace.FeedBlob("data", data)
+        workspace.FeedBlob("label", label)
+        workspace.RunNetOnce(m.net)
+        grad = workspace.FetchBlob(str(input_to_grad["fc1_w"]))
+        blob_sizes = memonger.collect_blob_sizes(m.net.Proto())
+
+        optim_proto = memonger.optimize_training_memory(
+            m.net.Proto(), ["loss"], 0, blob_sizes)
+        recomputed = [op.output[0] for op in optim_proto.op
+                      if op.type == "Relu"]
+        self.assertEqual(sorted(recomputed),
+                         ["relu1", "relu1", "relu2", "relu2"])
+        # a recomputed blob is freed before the backward pass
+        loss_idx = [op.output[0] for op in optim_proto.op].index("loss")
+        freed = [op.input[0] for op in optim_proto.op[:loss_idx]
+                 if op.type == "Free"]
+        self.assertEqual(sorted(freed), ["relu1", "relu2"])
+
+        workspace.FeedBlob(str(input_to_grad["fc1_w"]), np.array([0.0]))
+        workspace.RunNetOnce(optim_proto)
+        np.testing.assert_almost_equal(
+            grad, workspace.FetchBlob(str(input_to_grad["fc1_w"])))
+
+        # nothing to drop within the budget
+        optim_proto = memonger.optimize_training_memory(
+            m.net.Proto(), ["loss"], sum(blob_sizes.values()), blob_sizes)
+        self.assertEqual(len(optim_proto.op), len(m.net.Proto().op))
+
+    def test_optimize_training_memory_offload(self):
+        m = model_helper.ModelHelper()
+        with core.DeviceScope(core.DeviceOption(caffe2_pb2.CUDA, 0)):
+            fc1 = brew.fc(m, "data", "fc1", dim_in=4, dim_out=4)
+            fc2 = brew.fc(m, fc1, "fc2", dim_in=4, dim_out=4)
+            fc2.SquaredL2Distance(["label"], "dist").AveragedLoss([], "loss")
+            m.AddGradientOperators(["loss"])
+        blob_sizes = collections.defaultdict(lambda: 64)
+
+        optim_proto = memonger.optimize_training_memory(
+            m.net.Proto(), ["loss"], 0, blob_sizes, recompute_op_types=(),
+            dont_drop_blobs={"fc2", "dist"})
+        ops = list(optim_proto.op)
+        types = [op.type for op in ops]
+        self.assertEqual(types.count("CopyGPUToCPU"), 1)
+        self.assertEqual(types.count("CopyCPUToGPU"), 1)
+        to_host = types.index("CopyGPUToCPU")
+        to_device = types.index("CopyCPUToGPU")
+        self.assertEqual(ops[to_host].input[0], "fc1")
+        self.assertEqual(ops[to_device].output[0], "fc1")
+        self.assertEqual(
+            ops[to_device].device_option.device_type, caffe2_pb2.CUDA)
+        # freed after its last forward use, once the copy is done
+        free = types.index("Free")
+        self.assertEqual(ops[free].input[0], "fc1")
+        self.assertEqual(list(ops[free].control_input), ["fc1_host"])
+        self.assertLess(free, types.index("AveragedLoss"))
+        # copied back before the backward pass uses it
+        first_use = min(
+            i for i, op in enumerate(ops) if i > to_device and "fc1" in op.input)
+        self.assertLess(to_device, first_use)
+        self.assertGreater(to_device, types.index("AveragedLoss"))
+        self.assertEqual(len(ops[to_device].control_input), 1)
+
 if __name__ == '__main__':
     unittest.main()
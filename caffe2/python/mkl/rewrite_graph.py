@@ -4,10 +4,21 @@ from __future__ import print_function
 from __future__ import unicode_literals
 
 import copy
+from collections import defaultdict
 from caffe2.proto import caffe2_pb2
 from caffe2.python import core
 
 
+# Ops with a native MKL implementation. Any other op of an MKLDNN net runs
+# through MKLFallbackOp, which converts its inputs out of and its outputs back
+# into MKLMemory on every run.
+MKL_NATIVE_OPS = {
+    "Add", "AveragePool", "Concat", "Conv", "CopyCPUToMKL", "CopyMKLToCPU",
+    "FC", "LRN", "MaxPool", "Relu", "ReluGradient", "SpatialBN", "Squeeze",
+    "Sum",
+}
+
+
 def rewrite_init_net_simple(net):
     for op in net.op:
         op.device_option.device_type = caffe2_pb2.MKLDNN
@@ -60,6 +71,68 @@ def rewrite_run_net_simple(net):
         op.engine = ""
 
 
+def op_dependencies(ops):
+    """Returns, for each op, the indices of the earlier ops it has to run
+    after: the last writer of each blob it reads or writes, and the readers
+    of each blob it overwrites since that blob was last written."""
+    deps = [set() for _ in ops]
+    last_writer = {}
+    readers = defaultdict(list)
+    for i, op in enumerate(ops):
+        for blob in op.input:
+            if blob in last_writer:
+                deps[i].add(last_writer[blob])
+        for blob in op.output:
+            if blob in last_writer:
+                deps[i].add(last_writer[blob])
+            deps[i].update(readers[blob])
+        for blob in op.input:
+            readers[blob].append(i)
+        for blob in op.output:
+            last_writer[blob] = i
+            readers[blob] = []
+        deps[i].discard(i)
+    return deps
+
+
+def group_mkl_ops(net, is_mkl_op=None):
+    """Reorders the ops of net so that ops with a native MKL implementation
+    and fallback ops form runs that are as long as possible, which lets MKL
+    ops pass MKLMemory in their own layouts to each other instead of through a
+    fallback op in between. Every pair of ops that touch a common blob, one of
+    them writing it, keeps its order, so the net computes the same outputs.
+    """
+    if is_mkl_op is None:
+        def is_mkl_op(op):
+            return op.type in MKL_NATIVE_OPS
+    ops = list(net.op)
+    deps = op_dependencies(ops)
+    users = [[] for _ in ops]
+    for i, op_deps in enumerate(deps):
+        for j in op_deps:
+            users[j].append(i)
+    pending = [len(op_deps) for op_deps in deps]
+    ready = [i for i in range(len(ops)) if not pending[i]]
+    order = []
+    kind = None
+    while ready:
+        # Stay on the kind of the last op while any is ready, and otherwise
+        # keep the original order.
+        same_kind = [i for i in ready if is_mkl_op(ops[i]) == kind]
+        i = min(same_kind) if same_kind else min(ready)
+        ready.remove(i)
+        order.append(i)
+        kind = is_mkl_op(ops[i])
+        for j in users[i]:
+            pending[j] -= 1
+            if not pending[j]:
+                ready.append(j)
+    assert len(order) == len(ops)
+    del net.op[:]
+    net.op.extend([ops[i] for i in order])
+    return net
+
+
 def rewrite_model_helper_simple(model):
     model = copy.deepcopy(model)
     # All parameter initialization should run on MKL
@@ -11,7 +11,7 @@ import hypothesis.strategies as st
 
 from caffe2.python.model_helper import ModelHelper
 from caffe2.python.models import resnet
-from caffe2.python import workspace, brew
+from caffe2.python import core, workspace, brew
 import caffe2.python.hypothesis_test_util as hu
 import caffe2.python.mkl.rewrite_graph as rewrite_graph
 
@@ -180,6 +180,16 @@ def complex_resnet():
     return model, [(1, 1, 224, 224)]
 
 
+def interleaved_fallback():
+    model = ModelHelper(name="r")
+    branches = []
+    for i in range(3):
+        fc = brew.fc(model, "data", "fc{}".format(i), 10, 10)
+        branches.append(model.net.Sigmoid(fc, "sigmoid{}".format(i)))
+    brew.relu(model, model.net.Sum(branches, "sum"), "out")
+    return model, [(1, 10)]
+
+
 @unittest.skipIf(not workspace.C.has_mkldnn,
                  "Skipping as we do not have mkldnn.")
 class MKLRewriteTest(hu.HypothesisTestCase):
@@ -251,6 +261,53 @@ class MKLRewriteTest(hu.HypothesisTestCase):
         np.testing.assert_allclose(run(cpu_model), run(mkl_model),
                                    atol=1e-4, rtol=1e-4)
 
+    def test_mkl_grouped_rewrite(self):
+        cpu_model, (shape,) = interleaved_fallback()
+        cpu_model = deterministic_io(cpu_model)
+        mkl_model = copy.deepcopy(cpu_model)
+        rewrite_graph.group_mkl_ops(mkl_model.Proto())
+        mkl_model = rewrite_graph.rewrite_model_helper_simple(mkl_model)
+        np.random.seed(1701)
+        X = np.random.randn(*shape).astype(np.float32)
+
+        def run(model):
+            self.ws.run(model.InitProto())
+            self.ws.create_blob(model.Proto().external_input[0]).feed(X)
+            self.ws.run(model.Proto())
+            return self.ws.blobs[model.Proto().external_output[0]].fetch()
+        np.testing.assert_allclose(run(cpu_model), run(mkl_model),
+                                   atol=1e-4, rtol=1e-4)
+
+
+class MKLGroupOpsTest(unittest.TestCase):
+    def test_groups_independent_ops(self):
+        net = core.Net("net").Proto()
+        net.op.extend([
+            core.CreateOperator("FC", ["data", "w0", "b0"], "fc0"),
+            core.CreateOperator("Sigmoid", "fc0", "s0"),
+            core.CreateOperator("FC", ["data", "w1", "b1"], "fc1"),
+            core.CreateOperator("Sigmoid", "fc1", "s1"),
+            core.CreateOperator("Sum", ["s0", "s1"], "out"),
+        ])
+        rewrite_graph.group_mkl_ops(net)
+        self.assertEqual(
+            [op.output[0] for op in net.op],
+            ["fc0", "fc1", "s0", "s1", "out"])
+
+    def test_keeps_dependencies(self):
+        net = core.Net("net").Proto()
+        net.op.extend([
+            core.CreateOperator("Relu", "x", "y"),
+            core.CreateOperator("Sigmoid", "y", "z"),
+            # Overwrites y after the Sigmoid read it
+            core.CreateOperator("Relu", "x2", "y"),
+            core.CreateOperator("Relu", "z", "z"),
+        ])
+        rewrite_graph.group_mkl_ops(net)
+        self.assertEqual(
+            [(op.type, op.input[0]) for op in net.op],
+            [("Relu", "x"), ("Sigmoid", "y"), ("Relu", "x2"), ("Relu", "z")])
+
 if __name__ == "__main__":
     import unittest
     unittest.main()
@@ -50,5 +50,26 @@ class NUMATest(TestCase):
         self.assertEqual(workspace.GetBlobNUMANode("output_blob_1"), 1)
 
 
+
+@unittest.skipIf(not workspace.IsNUMAEnabled(), "NUMA is not enabled")
+@unittest.skipIf(workspace.GetNumNUMANodes() < 2, "Not enough NUMA nodes")
+class NUMAInputPlacementTest(TestCase):
+    def test_inputs_moved_to_consumer_node(self):
+        import numpy as np
+        workspace.FeedBlob("numa_input", np.ones((1024, 1024), dtype=np.float32))
+
+        net = core.Net("test_numa_input_placement")
+        net.Proto().type = "async_scheduling"
+        numa_device_option = caffe2_pb2.DeviceOption()
+        numa_device_option.device_type = caffe2_pb2.CPU
+        numa_device_option.numa_node_id = 1
+        net.Copy("numa_input", "numa_output", device_option=numa_device_option)
+
+        workspace.CreateNet(net)
+        self.assertEqual(workspace.GetBlobNUMANode("numa_input"), 1)
+        workspace.RunNet(net.Proto().name)
+        self.assertEqual(workspace.GetBlobNUMANode("numa_output"), 1)
+
+
 if __name__ == '__main__':
     unittest.main()
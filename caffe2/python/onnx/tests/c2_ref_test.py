@@ -12,6 +12,7 @@ import unittest
 
 from caffe2.python import core
 from caffe2.proto import caffe2_pb2
+import caffe2.python._import_c_extension as C
 
 import onnx
 from onnx.helper import make_node, make_graph, make_tensor, make_tensor_value_info, make_model
@@ -24,6 +25,7 @@ import caffe2.python.onnx.backend as c2
 import numpy as np
 from caffe2.python.models.download import downloadFromURLToFile, getURLFromName, deleteDirectory
 
+from caffe2.python.onnx.backend_cpp_rep import Caffe2CppRep
 from caffe2.python.onnx.helper import dummy_name
 from caffe2.python.onnx.tests.test_utils import TestCase
 
@@ -87,6 +89,44 @@ class TestCaffe2Basic(TestCase):
         output = c2_rep.run({"X": X, "Y": Y})
         np.testing.assert_almost_equal(output["W3"], W_ref)
 
+    def test_cpp_backend_initializers(self):
+        X = np.random.randn(2, 3).astype(np.float32)
+
+        def make_weight_model(weight, shift, raw):
+            graph_def = make_graph(
+                [make_node("Mul", ["X", "weight"], ["Y0"]),
+                 make_node("Add", ["Y0", "shift"], ["Y"])],
+                name="test_cpp_backend_initializers",
+                inputs=[
+                    make_tensor_value_info("X", onnx.TensorProto.FLOAT, (2, 3)),
+                    make_tensor_value_info("weight", onnx.TensorProto.FLOAT, (2, 3)),
+                    make_tensor_value_info("shift", onnx.TensorProto.FLOAT, (2, 3)),
+                ],
+                outputs=[
+                    make_tensor_value_info("Y", onnx.TensorProto.FLOAT, (2, 3))
+                ],
+                initializer=[
+                    make_tensor("weight", onnx.TensorProto.FLOAT, [2, 3],
+                                weight.tobytes() if raw else weight.flatten(),
+                                raw=raw),
+                    make_tensor("shift", onnx.TensorProto.FLOAT, [2, 3],
+                                shift.tobytes() if raw else shift.flatten(),
+                                raw=raw),
+                ])
+            return make_model(graph_def, producer_name='caffe2-ref-test')
+
+        # the second preparation of the graph reuses the converted nets, but
+        # has to bind the initializers of its own model
+        for raw in [True, False, True]:
+            weight = np.random.randn(2, 3).astype(np.float32)
+            shift = np.random.randn(2, 3).astype(np.float32)
+            model = make_weight_model(weight, shift, raw)
+            rep = Caffe2CppRep(C.Caffe2Backend().prepare(
+                model.SerializeToString(), 'CPU', []))
+            output = rep.run({"X": X})
+            np.testing.assert_almost_equal(
+                output.Y, X * weight + shift)
+
     def test_gemm(self):
         # simple
         A = np.random.randn(3, 2).astype(np.float32)
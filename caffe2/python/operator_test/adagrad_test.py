@@ -10,7 +10,7 @@ from hypothesis import given, settings, HealthCheck
 import hypothesis.strategies as st
 import numpy as np
 
-from caffe2.python import core
+from caffe2.python import core, workspace
 import caffe2.python.hypothesis_test_util as hu
 
 
@@ -283,3 +283,95 @@ class TestAdagrad(hu.HypothesisTestCase):
             gc, op,
             [param, momentum, indices, grad, lr],
             ref_row_wise_sparse)
+
+    @given(num_rows=st.integers(1, 20),
+           block_size=st.integers(1, 20),
+           num_indices=st.integers(1, 200),
+           row_wise=st.booleans(),
+           **hu.gcs_cpu_only)
+    def test_sparse_adagrad_parallel(self, num_rows, block_size, num_indices,
+                                     row_wise, gc, dc):
+        param = np.random.rand(num_rows, block_size).astype(np.float32)
+        if row_wise:
+            momentum = np.random.rand(num_rows).astype(np.float32)
+        else:
+            momentum = np.random.rand(
+                num_rows, block_size).astype(np.float32)
+        # Indices repeat, and are applied one after the other
+        indices = np.random.randint(num_rows, size=num_indices)
+        grad = np.random.rand(num_indices, block_size).astype(np.float32)
+        lr = np.array([0.1], dtype=np.float32)
+        epsilon = 1e-5
+
+        op = core.CreateOperator(
+            "RowWiseSparseAdagrad" if row_wise else "SparseAdagrad",
+            ["param", "momentum", "indices", "grad", "lr"],
+            ["param", "momentum"],
+            epsilon=epsilon,
+            min_chunk_size=1,
+            device_option=gc)
+
+        def ref_sparse(param, momentum, indices, grad, lr):
+            param_out = np.copy(param)
+            momentum_out = np.copy(momentum)
+            ref = self.ref_row_wise_adagrad if row_wise else self.ref_adagrad
+            for i, index in enumerate(indices):
+                param_out[index], momentum_out[index] = ref(
+                    param_out[index], momentum_out[index], grad[i], lr,
+                    epsilon)
+            return (param_out, momentum_out)
+
+        for dtype in [np.int32, np.int64]:
+            self.assertReferenceChecks(
+                gc, op,
+                [param, momentum, indices.astype(dtype), grad, lr],
+                ref_sparse)
+
+    @given(num_rows=st.integers(1, 20),
+           block_size=st.integers(1, 40),
+           num_indices=st.integers(0, 100),
+           **hu.gcs_cpu_only)
+    def test_sparse_adagrad_fused_8bit_rowwise_moment(
+            self, num_rows, block_size, num_indices, gc, dc):
+        param = np.random.rand(num_rows, block_size).astype(np.float32)
+        momentum = np.random.rand(num_rows, block_size).astype(np.float32)
+        indices = np.random.randint(num_rows, size=num_indices)
+        grad = np.random.rand(num_indices, block_size).astype(np.float32)
+        lr = np.array([0.1], dtype=np.float32)
+        epsilon = 1e-5
+
+        workspace.FeedBlob("momentum", momentum)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "FloatToFused8BitRowwiseQuantized", ["momentum"], ["momentum_q"]))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "Fused8BitRowwiseQuantizedToFloat",
+            ["momentum_q"], ["momentum_dq"]))
+        momentum_dq = workspace.FetchBlob("momentum_dq")
+
+        workspace.FeedBlob("param", param)
+        workspace.FeedBlob("indices", indices)
+        workspace.FeedBlob("grad", grad)
+        workspace.FeedBlob("lr", lr)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "SparseAdagradFused8BitRowwiseMoment",
+            ["param", "momentum_q", "indices", "grad", "lr"],
+            ["param", "momentum_q"],
+            epsilon=epsilon,
+            min_chunk_size=1))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "Fused8BitRowwiseQuantizedToFloat",
+            ["momentum_q"], ["momentum_out"]))
+
+        # Every occurrence of a row re-quantizes it, so compare against the
+        # float update with a tolerance of a few quantization steps
+        param_ref = np.copy(param)
+        momentum_ref = np.copy(momentum_dq)
+        for i, index in enumerate(indices):
+            param_ref[index], momentum_ref[index] = self.ref_adagrad(
+                param_ref[index], momentum_ref[index], grad[i], lr, epsilon)
+        steps = len(indices) + 1
+        atol = steps * (momentum_ref.max() - momentum_ref.min() + 1) / 255
+        np.testing.assert_allclose(
+            workspace.FetchBlob("momentum_out"), momentum_ref, atol=atol)
+        np.testing.assert_allclose(
+            workspace.FetchBlob("param"), param_ref, atol=atol)
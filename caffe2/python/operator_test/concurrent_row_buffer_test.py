@@ -0,0 +1,110 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core, workspace
+from caffe2.python.test_util import TestCase
+import numpy as np
+import numpy.testing as npt
+
+
+class TestConcurrentRowBuffer(TestCase):
+
+    def _write(self, op_type, data):
+        workspace.FeedBlob('data', data)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            op_type, ['buffer', 'data'], []))
+
+    def _read(self):
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'ReadConcurrentRowBuffer', ['buffer'], ['rows', 'num_visited']))
+        return workspace.FetchBlob('rows'), workspace.FetchBlob('num_visited')
+
+    def test_last_n_window(self):
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'CreateConcurrentRowBuffer', [], ['buffer'], num_to_collect=5))
+        data = np.arange(16, dtype=np.float32).reshape(8, 2)
+
+        self._write('ConcurrentLastNWindowCollector', data[:3])
+        rows, num_visited = self._read()
+        npt.assert_array_equal(rows, data[:3])
+        self.assertEqual(num_visited, 3)
+
+        # wraps around
+        self._write('ConcurrentLastNWindowCollector', data[3:7])
+        rows, num_visited = self._read()
+        npt.assert_array_equal(rows, data[[5, 6, 2, 3, 4]])
+        self.assertEqual(num_visited, 7)
+
+        # more rows than the buffer holds
+        self._write('ConcurrentLastNWindowCollector', np.vstack([data, data]))
+        rows, _ = self._read()
+        self.assertEqual(
+            sorted(rows[:, 0].tolist()), sorted(data[3:, 0].tolist()))
+
+        with self.assertRaises(RuntimeError):
+            self._write('ConcurrentLastNWindowCollector', data[:, :1])
+
+    def test_reservoir_sampling(self):
+        np.random.seed(0)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'CreateConcurrentRowBuffer', [], ['buffer'], num_to_collect=10))
+        data = np.arange(100, dtype=np.int64)
+
+        self._write('ConcurrentReservoirSampling', data[:4])
+        rows, _ = self._read()
+        npt.assert_array_equal(rows, data[:4])
+
+        for i in range(4, 100, 16):
+            self._write('ConcurrentReservoirSampling', data[i:i + 16])
+        rows, num_visited = self._read()
+        self.assertEqual(num_visited, 100)
+        self.assertEqual(len(rows), 10)
+        self.assertEqual(len(set(rows.tolist())), 10)
+        self.assertTrue(set(rows.tolist()) <= set(data.tolist()))
+
+    def test_concurrent_writers(self):
+        num_nets = 8
+        num_iter = 50
+        batch_size = 7
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'CreateConcurrentRowBuffer', [], ['lastn'], num_to_collect=64))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'CreateConcurrentRowBuffer', [], ['reservoir'], num_to_collect=16))
+
+        steps = []
+        for i in range(num_nets):
+            # every row has all its values equal, so that torn rows show
+            data = np.full([batch_size, 32], i, dtype=np.float32)
+            workspace.FeedBlob('data_{}'.format(i), data)
+            net = core.Net('writer_{}'.format(i))
+            net.ConcurrentLastNWindowCollector(
+                ['lastn', 'data_{}'.format(i)], [])
+            net.ConcurrentReservoirSampling(
+                ['reservoir', 'data_{}'.format(i)], [])
+            net.ReadConcurrentRowBuffer(['lastn'], ['rows_{}'.format(i)])
+            steps.append(core.execution_step(
+                'writer_{}'.format(i), net, num_iter=num_iter))
+        plan = core.Plan('concurrent_writers')
+        plan.AddStep(core.execution_step(
+            'writers', steps, concurrent_substeps=True))
+        workspace.RunPlan(plan)
+
+        for buffer, capacity in [('lastn', 64), ('reservoir', 16)]:
+            workspace.RunOperatorOnce(core.CreateOperator(
+                'ReadConcurrentRowBuffer', [buffer], ['rows', 'num_visited']))
+            rows = workspace.FetchBlob('rows')
+            self.assertEqual(rows.shape, (capacity, 32))
+            self.assertEqual(
+                workspace.FetchBlob('num_visited'),
+                num_nets * num_iter * batch_size)
+            npt.assert_array_equal(rows, rows[:, :1].repeat(32, axis=1))
+        for i in range(num_nets):
+            rows = workspace.FetchBlob('rows_{}'.format(i))
+            npt.assert_array_equal(rows, rows[:, :1].repeat(32, axis=1))
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
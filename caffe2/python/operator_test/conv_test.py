@@ -507,6 +507,60 @@ class TestConvolution(hu.HypothesisTestCase):
                 1763719461732352.0,
                 rtol=1e-5)
 
+    # (input_channels, output_channels, group, kernel, stride, pad, dilation)
+    # covering the depthwise, 1x1, Winograd and im2col paths of FAST
+    @given(shape=st.sampled_from([
+               (4, 4, 4, 3, 1, 1, 1),
+               (3, 6, 3, 5, 2, 2, 2),
+               (5, 7, 1, 1, 1, 0, 1),
+               (5, 7, 1, 1, 2, 0, 1),
+               (8, 9, 1, 3, 1, 1, 1),
+               (9, 8, 1, 3, 1, 0, 1),
+               (4, 6, 2, 3, 2, 1, 1),
+           ]),
+           size=st.integers(5, 14),
+           batch_size=st.integers(1, 3),
+           use_bias=st.booleans(),
+           **hu.gcs_cpu_only)
+    def test_convolution_fast_engine(self, shape, size, batch_size, use_bias,
+                                     gc, dc):
+        (input_channels, output_channels, group, kernel, stride, pad,
+         dilation) = shape
+        assume(size + 2 * pad >= dilation * (kernel - 1) + 1)
+        X = np.random.rand(
+            batch_size, input_channels, size, size).astype(np.float32) - 0.5
+        w = np.random.rand(
+            output_channels, input_channels // group, kernel, kernel
+        ).astype(np.float32) - 0.5
+        b = np.random.rand(output_channels).astype(np.float32) - 0.5
+        inputs = [X, w, b] if use_bias else [X, w]
+
+        outputs = {}
+        for engine in ["", "FAST"]:
+            op = core.CreateOperator(
+                "Conv",
+                ["X", "w", "b"] if use_bias else ["X", "w"],
+                ["Y"],
+                kernel=kernel,
+                stride=stride,
+                pad=pad,
+                dilation=dilation,
+                group=group,
+                order="NCHW",
+                engine=engine,
+                device_option=gc,
+            )
+            self.ws.create_blob("X").feed(X, device_option=gc)
+            self.ws.create_blob("w").feed(w, device_option=gc)
+            if use_bias:
+                self.ws.create_blob("b").feed(b, device_option=gc)
+            self.ws.run(op)
+            outputs[engine] = self.ws.blobs["Y"].fetch()
+        # Winograd F(4x4, 3x3) trades a few bits of precision for speed
+        np.testing.assert_allclose(
+            outputs["FAST"], outputs[""], atol=1e-3, rtol=1e-3)
+        self.assertDeviceChecks(dc, op, inputs, [0])
+
     def test_use_cudnn_engine_interactions(self):
         """Make sure the use_cudnn and engine kwargs work as expected."""
         for model_default in [None, True, False]:
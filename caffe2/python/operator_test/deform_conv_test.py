@@ -10,8 +10,6 @@ from caffe2.proto import caffe2_pb2
 from caffe2.python import core, workspace
 import caffe2.python.hypothesis_test_util as hu
 
-import unittest
-
 
 def _cudnn_supports(
         dilation=False,
@@ -112,7 +110,6 @@ def _conv_2d_shuffle_offsets(
 
 class TestConvolution(hu.HypothesisTestCase):
 
-    @unittest.skipIf(not workspace.has_gpu_support, "No gpu support")
     @given(stride=st.integers(1, 3),
            pad=st.integers(0, 3),
            kernel=st.integers(1, 5),
@@ -125,7 +122,7 @@ class TestConvolution(hu.HypothesisTestCase):
            engine=st.sampled_from(["", "CUDNN", "MKLDNN"]),
            use_bias=st.booleans(),
            deformable_group=st.integers(1, 3),
-           **hu.gcs_gpu_only)
+           **hu.gcs)
     def test_null_offset_convolution(self, stride, pad, kernel, dilation, size,
                                      input_channels, output_channels, batch_size,
                                      order, engine, use_bias, deformable_group,
@@ -199,7 +196,6 @@ class TestConvolution(hu.HypothesisTestCase):
 
         self.assertReferenceChecks(gc, op, inputs, reference_conv_op)
 
-    @unittest.skipIf(not workspace.has_gpu_support, "No gpu support")
     @given(stride=st.integers(1, 3),
            pad=st.integers(0, 0),
            kernel=st.integers(1, 5),
@@ -212,7 +208,7 @@ class TestConvolution(hu.HypothesisTestCase):
            engine=st.sampled_from(["", "CUDNN", "MKLDNN"]),
            use_bias=st.booleans(),
            deformable_group=st.integers(1, 4),
-           **hu.gcs_gpu_only)
+           **hu.gcs)
     def test_flat_input_convolution(self, stride, pad, kernel, dilation, size,
                                     input_channels, output_channels, batch_size,
                                     order, engine, use_bias,
@@ -283,7 +279,6 @@ class TestConvolution(hu.HypothesisTestCase):
 
         self.assertReferenceChecks(gc, op, inputs, reference_conv_op)
 
-    @unittest.skipIf(not workspace.has_gpu_support, "No gpu support")
     @given(stride=st.integers(1, 1),
            pad=st.integers(0, 0),
            kernel=st.integers(1, 5),
@@ -296,7 +291,7 @@ class TestConvolution(hu.HypothesisTestCase):
            engine=st.sampled_from(["", "CUDNN", "MKLDNN"]),
            use_bias=st.booleans(),
            deformable_group=st.integers(1, 4),
-           **hu.gcs_gpu_only)
+           **hu.gcs)
     def test_shuffle_input_convolution(self, stride, pad, kernel, dilation, size,
                                        input_channels, output_channels, batch_size,
                                        order, engine, use_bias,
@@ -374,7 +369,6 @@ class TestConvolution(hu.HypothesisTestCase):
         self.assertReferenceChecks(gc, op, inputs, reference_conv_op)
 
     # CUDNN does NOT support different padding values and we skip it
-    @unittest.skipIf(not workspace.has_gpu_support, "No gpu support")
     @given(stride_h=st.integers(1, 3),
            stride_w=st.integers(1, 3),
            pad_h=st.integers(0, 3),
@@ -389,7 +383,7 @@ class TestConvolution(hu.HypothesisTestCase):
            shared_buffer=st.booleans(),
            use_bias=st.booleans(),
            deformable_group=st.integers(1, 3),
-           **hu.gcs_gpu_only)
+           **hu.gcs)
     def test_conv_separate_stride_pad_gradients(self, stride_h, stride_w,
                                                 pad_h, pad_w, kernel, size,
                                                 input_channels, output_channels,
@@ -446,7 +440,6 @@ class TestConvolution(hu.HypothesisTestCase):
         for i in range(len(inputs)):
             self.assertGradientChecks(gc, op, inputs, i, [0])
 
-    @unittest.skipIf(not workspace.has_gpu_support, "No gpu support")
     @given(stride=st.integers(1, 3),
            pad=st.integers(0, 3),
            kernel=st.integers(1, 5),
@@ -459,7 +452,7 @@ class TestConvolution(hu.HypothesisTestCase):
            engine=st.sampled_from(["", "CUDNN", "MKLDNN"]),
            use_bias=st.booleans(),
            deformable_group=st.integers(1, 3),
-           **hu.gcs_gpu_only)
+           **hu.gcs)
     def test_conv_gradients(self, stride, pad, kernel, dilation, size,
                             input_channels, output_channels, batch_size, order,
                             engine, use_bias, deformable_group, gc, dc):
@@ -515,6 +508,50 @@ class TestConvolution(hu.HypothesisTestCase):
         for i in range(len(inputs)):
             self.assertGradientChecks(gc, op, inputs, i, [0])
 
+    @given(kernel=st.integers(1, 3),
+           size=st.integers(5, 8),
+           input_channels=st.integers(1, 4),
+           output_channels=st.integers(1, 4),
+           batch_size=st.integers(1, 5),
+           group=st.integers(1, 2),
+           im2col_batch_size=st.integers(0, 4),
+           **hu.gcs)
+    def test_im2col_batch_size(self, kernel, size, input_channels,
+                               output_channels, batch_size, group,
+                               im2col_batch_size, gc, dc):
+        input_channels *= group
+        output_channels *= group
+        X = np.random.rand(
+            batch_size, input_channels, size, size).astype(np.float32) - 0.5
+        output_size = _conv_2d_output_size(size, kernel, 1, 1, 1, 1, 1)
+        o = _conv_2d_random_offsets(batch_size, kernel, output_size, 1)
+        w = np.random.rand(output_channels, input_channels // group, kernel,
+                           kernel).astype(np.float32) - 0.5
+        b = np.random.rand(output_channels).astype(np.float32) - 0.5
+        inputs = [X, o, w, b]
+
+        def conv_op(**kwargs):
+            return core.CreateOperator(
+                "DeformConv",
+                ["X", "o", "w", "b"],
+                ["Y"],
+                kernel=kernel,
+                pad=1,
+                group=group,
+                device_option=gc,
+                **kwargs
+            )
+
+        def reference_conv_op(*args):
+            # one image per GEMM
+            workspace.RunOperatorOnce(conv_op(im2col_batch_size=1))
+            return (workspace.FetchBlob("Y"),)
+
+        op = conv_op(im2col_batch_size=im2col_batch_size)
+        self.assertReferenceChecks(gc, op, inputs, reference_conv_op)
+        self.assertDeviceChecks(dc, op, inputs, [0])
+        self.assertGradientChecks(gc, op, inputs, 1, [0])
+
 
 if __name__ == "__main__":
     import unittest
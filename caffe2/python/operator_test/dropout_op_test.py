@@ -72,3 +72,32 @@ class TestDropout(hu.HypothesisTestCase):
             gc, op, [X], reference_dropout_ratio0,
             # Don't check the mask with cuDNN because it's packed data
             outputs_to_check=None if engine != 'CUDNN' else [0])
+
+    @given(X=hu.tensor(),
+           in_place=st.booleans(),
+           ratio=st.floats(0, 0.999),
+           **hu.gcs)
+    def test_dropout_packed_mask(self, X, in_place, ratio, gc, dc):
+        """The packed mask holds the bits of the elements that are kept."""
+        op = core.CreateOperator("Dropout", ["X"],
+                                 ["X" if in_place else "Y", "mask"],
+                                 ratio=ratio, pack_mask=True, is_test=False,
+                                 device_option=gc)
+        self.ws.create_blob("X").feed(X, device_option=gc)
+        self.ws.run(op)
+        Y = self.ws.blobs["X" if in_place else "Y"].fetch()
+        mask = self.ws.blobs["mask"].fetch()
+        self.assertEqual(mask.dtype, np.uint8)
+        self.assertEqual(mask.shape, ((X.size + 7) // 8,))
+        keep = np.unpackbits(mask[:, np.newaxis], axis=1)[:, ::-1]
+        keep = keep.flatten()[:X.size].reshape(X.shape).astype(np.bool)
+        scale = 1. / (1. - ratio)
+        np.testing.assert_allclose(Y, np.where(keep, X * scale, 0), rtol=1e-5)
+
+        grad_op = core.CreateOperator("DropoutGrad", ["dY", "mask"], ["dX"],
+                                      ratio=ratio, device_option=gc)
+        self.ws.create_blob("dY").feed(X, device_option=gc)
+        self.ws.run(grad_op)
+        np.testing.assert_allclose(
+            self.ws.blobs["dX"].fetch(), np.where(keep, X * scale, 0),
+            rtol=1e-5)
@@ -0,0 +1,61 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core
+from hypothesis import given
+import hypothesis.strategies as st
+import caffe2.python.hypothesis_test_util as hu
+import numpy as np
+
+import unittest
+
+
+class TestHalfFloatOps(hu.HypothesisTestCase):
+
+    # Sizes which aren't multiples of 8 exercise the tails of the vectorized
+    # conversions.
+    @given(n=st.integers(0, 100), **hu.gcs)
+    def test_float_to_half(self, n, gc, dc):
+        X = (np.random.randn(n) * 1000).astype(np.float32)
+        op = core.CreateOperator("FloatToHalf", ["X"], ["Y"])
+
+        def float_to_half_ref(X):
+            return (X.astype(np.float16),)
+
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X],
+            reference=float_to_half_ref)
+        self.assertDeviceChecks(dc, op, [X], [0])
+
+    @given(n=st.integers(0, 100), **hu.gcs)
+    def test_half_to_float(self, n, gc, dc):
+        X = np.random.randn(n).astype(np.float16)
+        op = core.CreateOperator("HalfToFloat", ["X"], ["Y"])
+
+        def half_to_float_ref(X):
+            return (X.astype(np.float32),)
+
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X],
+            reference=half_to_float_ref)
+        self.assertDeviceChecks(dc, op, [X], [0])
+
+    def test_all_half_values(self):
+        X = np.arange(1 << 16, dtype=np.uint16).view(np.float16)
+        X = X[np.isfinite(X)]
+        self.ws.create_blob("X").feed(X)
+        self.ws.run(core.CreateOperator("HalfToFloat", ["X"], ["Y"]))
+        self.ws.run(core.CreateOperator("FloatToHalf", ["Y"], ["Z"]))
+        np.testing.assert_array_equal(self.ws.blobs["Y"].fetch(), X.astype(np.float32))
+        np.testing.assert_array_equal(
+            self.ws.blobs["Z"].fetch().view(np.uint16), X.view(np.uint16))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,200 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from hypothesis import given, settings
+import hypothesis.strategies as st
+import numpy as np
+
+from caffe2.python import core, workspace
+import caffe2.python.hypothesis_test_util as hu
+
+
+def quantize(x, scale, zero_point):
+    return np.clip(np.round(x / scale) + zero_point, 0, 255).astype(np.uint8)
+
+
+def dequantize(q, scale, zero_point):
+    return scale * (q.astype(np.float32) - zero_point)
+
+
+class TestInt8Ops(hu.HypothesisTestCase):
+    def feed_int8(self, name, q, scale, zero_point):
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'Int8GivenTensorFill', [], [name],
+            values=q.tobytes(), shape=list(q.shape),
+            Y_scale=scale, Y_zero_point=zero_point))
+
+    def feed_bias(self, name, b):
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'Int8GivenIntTensorFill', [], [name],
+            values=b, shape=list(b.shape)))
+
+    def assert_close_to(self, name, expected, scale, zero_point):
+        """The fixed point requantization may round differently than numpy,
+        by at most one step."""
+        q, Y_scale, Y_zero_point = workspace.FetchBlob(name)
+        self.assertAlmostEqual(Y_scale, scale, places=6)
+        self.assertEqual(Y_zero_point, zero_point)
+        self.assertEqual(q.shape, expected.shape)
+        np.testing.assert_array_less(
+            np.abs(q.astype(np.int32) - expected.astype(np.int32)), 2)
+
+    @given(n=st.integers(1, 4), c=st.integers(1, 8),
+           zero_point=st.integers(0, 255), **hu.gcs_cpu_only)
+    @settings(max_examples=10)
+    def test_quantize_dequantize(self, n, c, zero_point, gc, dc):
+        X = np.random.randn(n, c).astype(np.float32)
+        scale = 0.05
+        workspace.FeedBlob('X', X)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'Int8Quantize', ['X'], ['X_int8'],
+            Y_scale=scale, Y_zero_point=zero_point))
+        q, q_scale, q_zero_point = workspace.FetchBlob('X_int8')
+        np.testing.assert_array_equal(q, quantize(X, scale, zero_point))
+        self.assertEqual(q_zero_point, zero_point)
+
+        workspace.RunOperatorOnce(
+            core.CreateOperator('Int8Dequantize', ['X_int8'], ['Y']))
+        np.testing.assert_allclose(
+            workspace.FetchBlob('Y'), dequantize(q, scale, zero_point),
+            atol=1e-6)
+
+    @given(m=st.integers(1, 9), k=st.integers(1, 40), n=st.integers(1, 20),
+           x_zero_point=st.integers(0, 255), w_zero_point=st.integers(0, 255),
+           **hu.gcs_cpu_only)
+    @settings(max_examples=20)
+    def test_int8_fc(self, m, k, n, x_zero_point, w_zero_point, gc, dc):
+        X = np.random.randint(0, 256, (m, k)).astype(np.uint8)
+        W = np.random.randint(0, 256, (n, k)).astype(np.uint8)
+        B = np.random.randint(-1000, 1000, n).astype(np.int32)
+        x_scale, w_scale, y_scale, y_zero_point = 0.02, 0.01, 0.5, 100
+        self.feed_int8('X', X, x_scale, x_zero_point)
+        self.feed_int8('W', W, w_scale, w_zero_point)
+        self.feed_bias('B', B)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'Int8FC', ['X', 'W', 'B'], ['Y'],
+            Y_scale=y_scale, Y_zero_point=y_zero_point))
+
+        acc = (X.astype(np.int64) - x_zero_point).dot(
+            (W.astype(np.int64) - w_zero_point).T) + B
+        expected = quantize(
+            acc * (x_scale * w_scale), y_scale, y_zero_point)
+        self.assert_close_to('Y', expected, y_scale, y_zero_point)
+
+    @given(stride=st.integers(1, 2), pad=st.integers(0, 1),
+           kernel=st.integers(1, 3), group=st.sampled_from([1, 2]),
+           relu=st.booleans(), **hu.gcs_cpu_only)
+    @settings(max_examples=20)
+    def test_int8_conv(self, stride, pad, kernel, group, relu, gc, dc):
+        n, h, w, c, m = 2, 6, 5, 4, 6
+        X = np.random.randint(0, 256, (n, h, w, c)).astype(np.uint8)
+        W = np.random.randint(
+            0, 256, (m, kernel, kernel, c // group)).astype(np.uint8)
+        B = np.random.randint(-1000, 1000, m).astype(np.int32)
+        x_scale, x_zero_point = 0.02, 120
+        w_scale, w_zero_point = 0.01, 130
+        y_scale, y_zero_point = 0.25, 110
+        self.feed_int8('X', X, x_scale, x_zero_point)
+        self.feed_int8('W', W, w_scale, w_zero_point)
+        self.feed_bias('B', B)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'Int8ConvRelu' if relu else 'Int8Conv', ['X', 'W', 'B'], ['Y'],
+            kernel=kernel, stride=stride, pad=pad, group=group, order='NHWC',
+            Y_scale=y_scale, Y_zero_point=y_zero_point))
+
+        # Reference: the fp32 Conv on the real values, in NCHW
+        workspace.FeedBlob('Xf', dequantize(
+            X, x_scale, x_zero_point).transpose(0, 3, 1, 2).copy())
+        workspace.FeedBlob('Wf', dequantize(
+            W, w_scale, w_zero_point).transpose(0, 3, 1, 2).copy())
+        workspace.FeedBlob('Bf', (B * x_scale * w_scale).astype(np.float32))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'Conv', ['Xf', 'Wf', 'Bf'], ['Yf'],
+            kernel=kernel, stride=stride, pad=pad, group=group))
+        Yf = workspace.FetchBlob('Yf').transpose(0, 2, 3, 1)
+        if relu:
+            Yf = np.maximum(Yf, 0)
+        self.assert_close_to(
+            'Y', quantize(Yf, y_scale, y_zero_point), y_scale, y_zero_point)
+
+    @given(zero_point=st.integers(0, 255), **hu.gcs_cpu_only)
+    @settings(max_examples=10)
+    def test_int8_relu(self, zero_point, gc, dc):
+        X = np.random.randint(0, 256, (2, 3, 4, 5)).astype(np.uint8)
+        self.feed_int8('X', X, 0.1, zero_point)
+        workspace.RunOperatorOnce(
+            core.CreateOperator('Int8Relu', ['X'], ['Y']))
+        q, scale, Y_zero_point = workspace.FetchBlob('Y')
+        np.testing.assert_array_equal(q, np.maximum(X, zero_point))
+        self.assertEqual(Y_zero_point, zero_point)
+
+    @given(kernel=st.integers(1, 3), stride=st.integers(1, 2),
+           pad=st.integers(0, 1), **hu.gcs_cpu_only)
+    @settings(max_examples=20)
+    def test_int8_pool(self, kernel, stride, pad, gc, dc):
+        X = np.random.randint(0, 256, (2, 5, 6, 3)).astype(np.uint8)
+        x_scale, x_zero_point = 0.1, 50
+        y_scale, y_zero_point = 0.2, 30
+        self.feed_int8('X', X, x_scale, x_zero_point)
+        workspace.FeedBlob('Xf', dequantize(
+            X, x_scale, x_zero_point).transpose(0, 3, 1, 2).copy())
+        for op_type in ['MaxPool', 'AveragePool']:
+            workspace.RunOperatorOnce(core.CreateOperator(
+                op_type, ['Xf'], ['Yf'],
+                kernel=kernel, stride=stride, pad=pad))
+            Yf = workspace.FetchBlob('Yf').transpose(0, 2, 3, 1)
+            if op_type == 'MaxPool':
+                workspace.RunOperatorOnce(core.CreateOperator(
+                    'Int8MaxPool', ['X'], ['Y'],
+                    kernel=kernel, stride=stride, pad=pad, order='NHWC'))
+                q, _, _ = workspace.FetchBlob('Y')
+                np.testing.assert_array_equal(
+                    q, quantize(Yf, x_scale, x_zero_point))
+            else:
+                workspace.RunOperatorOnce(core.CreateOperator(
+                    'Int8AveragePool', ['X'], ['Y'],
+                    kernel=kernel, stride=stride, pad=pad, order='NHWC',
+                    Y_scale=y_scale, Y_zero_point=y_zero_point))
+                self.assert_close_to(
+                    'Y', quantize(Yf, y_scale, y_zero_point),
+                    y_scale, y_zero_point)
+
+    @given(relu=st.booleans(), **hu.gcs_cpu_only)
+    @settings(max_examples=10)
+    def test_int8_add(self, relu, gc, dc):
+        A = np.random.randint(0, 256, (3, 4, 5)).astype(np.uint8)
+        B = np.random.randint(0, 256, (3, 4, 5)).astype(np.uint8)
+        self.feed_int8('A', A, 0.1, 100)
+        self.feed_int8('B', B, 0.05, 20)
+        y_scale, y_zero_point = 0.2, 90
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'Int8AddRelu' if relu else 'Int8Add', ['A', 'B'], ['Y'],
+            Y_scale=y_scale, Y_zero_point=y_zero_point))
+        Yf = dequantize(A, 0.1, 100) + dequantize(B, 0.05, 20)
+        if relu:
+            Yf = np.maximum(Yf, 0)
+        self.assert_close_to(
+            'Y', quantize(Yf, y_scale, y_zero_point), y_scale, y_zero_point)
+
+    def test_int8_concat(self):
+        A = np.random.randint(0, 256, (2, 3, 4, 5)).astype(np.uint8)
+        B = np.random.randint(0, 256, (2, 3, 4, 2)).astype(np.uint8)
+        self.feed_int8('A', A, 0.1, 7)
+        self.feed_int8('B', B, 0.1, 7)
+        workspace.RunOperatorOnce(
+            core.CreateOperator('Int8Concat', ['A', 'B'], ['Y']))
+        q, scale, zero_point = workspace.FetchBlob('Y')
+        np.testing.assert_array_equal(q, np.concatenate([A, B], axis=3))
+        self.assertEqual(zero_point, 7)
+
+        self.feed_int8('B', B, 0.2, 7)
+        with self.assertRaises(RuntimeError):
+            workspace.RunOperatorOnce(
+                core.CreateOperator('Int8Concat', ['A', 'B'], ['Y']))
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
@@ -0,0 +1,74 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+import os
+import shutil
+import tempfile
+import unittest
+
+from caffe2.python import core, test_util, workspace
+
+
+class TestLoadMapped(test_util.TestCase):
+    def setUp(self):
+        super(TestLoadMapped, self).setUp()
+        self.tmp_folder = tempfile.mkdtemp()
+        self.path = os.path.join(self.tmp_folder, "weights")
+
+    def tearDown(self):
+        shutil.rmtree(self.tmp_folder)
+        super(TestLoadMapped, self).tearDown()
+
+    def test_save_load_mapped(self):
+        table = np.random.rand(1000, 16).astype(np.float32)
+        ids = np.arange(10).astype(np.int64)
+        names = np.array([b"a", b"bc"], dtype=np.object)
+        workspace.FeedBlob("table", table)
+        workspace.FeedBlob("ids", ids)
+        workspace.FeedBlob("names", names)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "SaveMapped", ["table", "ids", "names"], [], path=self.path))
+
+        workspace.ResetWorkspace()
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "LoadMapped", [], ["table", "names"], path=self.path))
+        np.testing.assert_array_equal(workspace.FetchBlob("table"), table)
+        np.testing.assert_array_equal(workspace.FetchBlob("names"), names)
+        self.assertFalse(workspace.HasBlob("ids"))
+
+        with self.assertRaises(RuntimeError):
+            workspace.RunOperatorOnce(core.CreateOperator(
+                "LoadMapped", [], ["missing"], path=self.path))
+
+    def test_lookups_into_mapped_table(self):
+        table = np.random.rand(5000, 32).astype(np.float32)
+        workspace.FeedBlob("table", table)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "SaveMapped", ["table"], [], path=self.path))
+        workspace.ResetWorkspace()
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "LoadMapped", [], ["table"], path=self.path))
+
+        indices = np.random.randint(0, 5000, size=300).astype(np.int32)
+        lengths = np.array([100, 0, 150, 50], dtype=np.int32)
+        workspace.FeedBlob("indices", indices)
+        workspace.FeedBlob("lengths", lengths)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "SparseLengthsSum", ["table", "indices", "lengths"], ["sums"]))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "Gather", ["table", "indices"], ["rows"]))
+
+        rows = table[indices]
+        np.testing.assert_array_equal(workspace.FetchBlob("rows"), rows)
+        offsets = np.cumsum(np.concatenate([[0], lengths]))
+        sums = np.array([rows[offsets[i]:offsets[i + 1]].sum(axis=0)
+                         for i in range(len(lengths))])
+        np.testing.assert_allclose(
+            workspace.FetchBlob("sums"), sums, rtol=1e-5, atol=1e-5)
+
+
+if __name__ == "__main__":
+    unittest.main()
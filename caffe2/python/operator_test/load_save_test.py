@@ -455,6 +455,85 @@ class TestLoadSave(TestLoadSaveBase):
             if e.errno != errno.ENOENT:
                 raise
 
+    def testDeltaCheckpoint(self):
+        tmp_folder = tempfile.mkdtemp()
+        base_db, delta_db_1, delta_db_2 = [
+            os.path.join(tmp_folder, name) for name in ["base", "d1", "d2"]]
+        workspace.ResetWorkspace()
+        param = np.random.rand(10, 3).astype(np.float32)
+        dense = np.random.rand(4).astype(np.float32)
+        workspace.FeedBlob("param", param)
+        workspace.FeedBlob("dense", dense)
+
+        def _Save(db, **kwargs):
+            self.assertTrue(workspace.RunOperatorOnce(core.CreateOperator(
+                "Save", ["param", "dense"], [], absolute_path=1, db=db,
+                db_type=self._db_type, **kwargs)))
+
+        def _Touch(rows):
+            workspace.FeedBlob("indices", np.array(rows, dtype=np.int64))
+            self.assertTrue(workspace.RunOperatorOnce(core.CreateOperator(
+                "TrackTouchedRows", ["indices"], ["touched"])))
+            param[rows] = np.random.rand(len(rows), 3)
+            workspace.FeedBlob("param", param)
+
+        _Save(base_db)
+        _Touch([7, 2, 7])
+        dense[0] = 100
+        workspace.FeedBlob("dense", dense)
+        _Save(delta_db_1, touched_rows=["touched", ""], checkpoint_version=1)
+        _Touch([9])
+        _Save(delta_db_2, touched_rows=["touched", ""], checkpoint_version=2)
+
+        for load_all in [False, True]:
+            workspace.ResetWorkspace()
+            self.assertTrue(workspace.RunOperatorOnce(core.CreateOperator(
+                "Load", [], [] if load_all else ["param", "dense"],
+                absolute_path=1, db=base_db, db_type=self._db_type,
+                deltas=[delta_db_1, delta_db_2], load_all=load_all)))
+            np.testing.assert_array_equal(workspace.FetchBlob("param"), param)
+            np.testing.assert_array_equal(workspace.FetchBlob("dense"), dense)
+
+        # deltas have to be replayed in the order they were saved in
+        workspace.ResetWorkspace()
+        with self.assertRaises(RuntimeError):
+            workspace.RunOperatorOnce(core.CreateOperator(
+                "Load", [], ["param", "dense"],
+                absolute_path=1, db=base_db, db_type=self._db_type,
+                deltas=[delta_db_2, delta_db_1]))
+        try:
+            shutil.rmtree(tmp_folder)
+        except OSError as e:
+            if e.errno != errno.ENOENT:
+                raise
+
+    def testAsyncSave(self):
+        tmp_folder = tempfile.mkdtemp()
+        db_file = os.path.join(tmp_folder, "db")
+        workspace.ResetWorkspace()
+        arr = np.random.rand(100, 10).astype(np.float32)
+        workspace.FeedBlob("arr", arr)
+        workspace.FeedBlob("str", np.array(["foo", "bar"], dtype=np.object))
+        self.assertTrue(workspace.RunOperatorOnce(core.CreateOperator(
+            "Save", ["arr", "str"], ["handle"], absolute_path=1, db=db_file,
+            db_type=self._db_type, async_write=1)))
+        # the save has its own copy, so the blob is free to change
+        workspace.FeedBlob("arr", np.zeros_like(arr))
+        self.assertTrue(workspace.RunOperatorOnce(core.CreateOperator(
+            "WaitForSave", ["handle"], [])))
+
+        workspace.ResetWorkspace()
+        self.assertTrue(workspace.RunOperatorOnce(core.CreateOperator(
+            "Load", [], ["arr", "str"], absolute_path=1, db=db_file,
+            db_type=self._db_type)))
+        np.testing.assert_array_equal(workspace.FetchBlob("arr"), arr)
+        self.assertEqual(list(workspace.FetchBlob("str")), [b"foo", b"bar"])
+        try:
+            shutil.rmtree(tmp_folder)
+        except OSError as e:
+            if e.errno != errno.ENOENT:
+                raise
+
 
 if __name__ == '__main__':
     unittest.main()
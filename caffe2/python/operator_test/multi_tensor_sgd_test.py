@@ -0,0 +1,129 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core
+import caffe2.python.hypothesis_test_util as hu
+
+from hypothesis import given
+import hypothesis.strategies as st
+import numpy as np
+import unittest
+
+
+def _tensors(sizes, n):
+    return [[np.random.rand(size).astype(np.float32) for _ in range(n)]
+            for size in sizes]
+
+
+def _names(count, names):
+    return ["{}_{}".format(name, i) for i in range(count) for name in names]
+
+
+class TestMultiTensorSGD(hu.HypothesisTestCase):
+    @given(sizes=st.lists(st.integers(0, 40), min_size=1, max_size=5),
+           nesterov=st.booleans(), **hu.gcs)
+    def test_multi_tensor_momentum_sgd(self, sizes, nesterov, gc, dc):
+        lr = np.random.rand(1).astype(np.float32)
+        momentum = 0.9
+        groups = _tensors(sizes, 3)
+
+        def momentum_sgd(lr, *inputs):
+            outputs = []
+            for i in range(0, len(inputs), 3):
+                m, param, grad = inputs[i:i + 3]
+                if not nesterov:
+                    grad_new = lr * grad + momentum * m
+                    m_new = grad_new
+                else:
+                    m_new = momentum * m + lr * grad
+                    grad_new = (1 + momentum) * m_new - momentum * m
+                outputs += [m_new, param - grad_new, grad_new]
+            return outputs
+
+        names = _names(len(sizes), ["moment", "param", "grad"])
+        op = core.CreateOperator(
+            "MultiTensorMomentumSGDUpdate",
+            ["lr"] + names,
+            names,
+            momentum=momentum,
+            nesterov=int(nesterov),
+        )
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[lr] + [x for group in groups for x in group],
+            reference=momentum_sgd,
+        )
+
+    @given(sizes=st.lists(st.integers(0, 40), min_size=1, max_size=5),
+           **hu.gcs)
+    def test_multi_tensor_adagrad(self, sizes, gc, dc):
+        lr = np.random.rand(1).astype(np.float32)
+        epsilon = 1e-4
+        groups = _tensors(sizes, 3)
+
+        def adagrad(lr, *inputs):
+            outputs = []
+            for i in range(0, len(inputs), 3):
+                param, h, grad = inputs[i:i + 3]
+                h_new = h + grad * grad
+                outputs += [
+                    param + lr * grad / (np.sqrt(h_new) + epsilon), h_new]
+            return outputs
+
+        op = core.CreateOperator(
+            "MultiTensorAdagrad",
+            ["lr"] + _names(len(sizes), ["param", "moment", "grad"]),
+            _names(len(sizes), ["param", "moment"]),
+            epsilon=epsilon,
+        )
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[lr] + [x for group in groups for x in group],
+            reference=adagrad,
+        )
+
+    @given(sizes=st.lists(st.integers(0, 40), min_size=1, max_size=5),
+           iteration=st.integers(0, 1000), **hu.gcs)
+    def test_multi_tensor_adam(self, sizes, iteration, gc, dc):
+        lr = np.random.rand(1).astype(np.float32)
+        it = np.array([iteration], dtype=np.int64)
+        beta1, beta2, epsilon = 0.9, 0.999, 1e-4
+        groups = _tensors(sizes, 4)
+
+        def adam(lr, it, *inputs):
+            t = it + 1
+            rate = lr * np.sqrt(1 - np.power(beta2, t)) / \
+                (1 - np.power(beta1, t))
+            outputs = []
+            for i in range(0, len(inputs), 4):
+                param, m1, m2, grad = inputs[i:i + 4]
+                m1_new = beta1 * m1 + (1 - beta1) * grad
+                m2_new = beta2 * m2 + (1 - beta2) * np.square(grad)
+                outputs += [
+                    param + rate * m1_new / (np.sqrt(m2_new) + epsilon),
+                    m1_new, m2_new]
+            return outputs
+
+        op = core.CreateOperator(
+            "MultiTensorAdam",
+            ["lr", "iter"] +
+            _names(len(sizes), ["param", "moment_1", "moment_2", "grad"]),
+            _names(len(sizes), ["param", "moment_1", "moment_2"]),
+            beta1=beta1, beta2=beta2, epsilon=epsilon,
+        )
+        # Iter lives on the CPU
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[lr, it] + [x for group in groups for x in group],
+            reference=adam,
+            input_device_options={"iter": hu.cpu_do},
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
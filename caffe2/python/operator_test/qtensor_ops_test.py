@@ -0,0 +1,110 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from hypothesis import given, settings
+import hypothesis.strategies as st
+import numpy as np
+
+from caffe2.python import core, workspace
+import caffe2.python.hypothesis_test_util as hu
+
+
+def quantize(x, precision, signed):
+    """Returns the values QTensorQuantize maps x to, and its scale."""
+    x = x.astype(np.float64)
+    q_max = 2 ** precision - 1
+    if signed:
+        scale = np.abs(x).max() / q_max or 1.0
+        v = x / scale
+        return np.sign(v) * np.minimum(np.round(np.abs(v)), q_max) * scale, \
+            scale
+    lo, hi = x.min(), x.max()
+    scale = (hi - lo) / q_max if hi > lo else 1.0
+    bias = lo / scale
+    return scale * (np.clip(np.round(x / scale - bias), 0, q_max) + bias), \
+        scale
+
+
+class TestQTensorOps(hu.HypothesisTestCase):
+    def dequantize(self, name):
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'QTensorDequantize', [name], [name + '_float']))
+        return workspace.FetchBlob(name + '_float')
+
+    @given(n=st.integers(1, 5), c=st.integers(1, 70),
+           precision=st.integers(1, 8), signed=st.booleans(),
+           **hu.gcs_cpu_only)
+    @settings(max_examples=20)
+    def test_quantize_dequantize(self, n, c, precision, signed, gc, dc):
+        X = np.random.randn(n, c).astype(np.float32)
+        workspace.FeedBlob('X', X)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'QTensorQuantize', ['X'], ['X_q'],
+            precision=precision, signed=signed))
+        Y = self.dequantize('X_q')
+        expected, scale = quantize(X, precision, signed)
+        self.assertEqual(Y.shape, X.shape)
+        # Rounding may differ by one step at the ties
+        np.testing.assert_allclose(Y, expected, atol=scale * 1.001 + 1e-5)
+
+    @given(m=st.integers(1, 6), k=st.integers(1, 200), n=st.integers(1, 12),
+           x_precision=st.integers(1, 8), x_signed=st.booleans(),
+           w_precision=st.integers(1, 8), w_signed=st.booleans(),
+           quantized_input=st.booleans(), with_bias=st.booleans(),
+           **hu.gcs_cpu_only)
+    @settings(max_examples=30)
+    def test_quantized_fc(self, m, k, n, x_precision, x_signed, w_precision,
+                          w_signed, quantized_input, with_bias, gc, dc):
+        X = np.random.randn(m, k).astype(np.float32)
+        W = np.random.randn(n, k).astype(np.float32)
+        B = np.random.randn(n).astype(np.float32)
+        workspace.FeedBlob('X', X)
+        workspace.FeedBlob('W', W)
+        workspace.FeedBlob('B', B)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'QTensorQuantize', ['W'], ['W_q'],
+            precision=w_precision, signed=w_signed))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'QTensorQuantize', ['X'], ['X_q'],
+            precision=x_precision, signed=x_signed))
+        inputs = ['X_q' if quantized_input else 'X', 'W_q']
+        if with_bias:
+            inputs.append('B')
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'QuantizedFC', inputs, ['Y'],
+            precision=x_precision, signed=x_signed))
+
+        # The bit-serial products are exact
+        expected = self.dequantize('X_q').astype(np.float64).dot(
+            self.dequantize('W_q').astype(np.float64).T)
+        if with_bias:
+            expected += B
+        np.testing.assert_allclose(
+            workspace.FetchBlob('Y'), expected, rtol=1e-4, atol=1e-4)
+
+    def test_quantized_fc_axis(self):
+        X = np.random.randn(2, 3, 4, 5).astype(np.float32)
+        W = np.random.randn(6, 20).astype(np.float32)
+        workspace.FeedBlob('X', X)
+        workspace.FeedBlob('W', W)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'QTensorQuantize', ['W'], ['W_q'], precision=8))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'QuantizedFC', ['X', 'W_q'], ['Y'], axis=2, precision=8))
+        Y = workspace.FetchBlob('Y')
+        self.assertEqual(Y.shape, (2, 3, 6))
+        expected = X.reshape(6, 20).dot(W.T).reshape(2, 3, 6)
+        # 8 bits are close to float
+        np.testing.assert_allclose(
+            Y, expected, atol=0.02 * np.abs(expected).max())
+
+        with self.assertRaises(RuntimeError):
+            workspace.RunOperatorOnce(core.CreateOperator(
+                'QuantizedFC', ['X', 'W_q'], ['Y'], axis=3))
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
@@ -77,6 +77,33 @@ class TestReBatchingQueue(TestCase):
             workspace.FetchBlob(results[1]), workspace.FetchBlob("tensors")[5:]
         )
 
+    def test_rebatching_queue_streaming(self):
+        net = core.Net('net')
+        workspace.FeedBlob(
+            "tensors", np.array([[x, x] for x in range(10)], np.int32)
+        )
+
+        queue = net.CreateRebatchingQueue(
+            [], 1, capacity=8, num_blobs=1, batch_size=4
+        )
+
+        net.EnqueueRebatchingQueue([queue, "tensors"], [], enqueue_batch=True)
+        net.CloseRebatchingQueue([queue], 0)
+
+        results = [
+            net.DequeueRebatchingQueue([queue], 1, num_elements=4),
+            net.DequeueRebatchingQueue([queue], 1, num_elements=4),
+            # the last batch is cut short by closing the queue
+            net.DequeueRebatchingQueue([queue], 1, num_elements=4),
+        ]
+
+        workspace.RunNetOnce(net)
+
+        tensors = workspace.FetchBlob("tensors")
+        npt.assert_array_equal(workspace.FetchBlob(results[0]), tensors[:4])
+        npt.assert_array_equal(workspace.FetchBlob(results[1]), tensors[4:8])
+        npt.assert_array_equal(workspace.FetchBlob(results[2]), tensors[8:])
+
     def test_rebatching_queue_closes_properly(self):
         net = core.Net('net')
         workspace.FeedBlob(
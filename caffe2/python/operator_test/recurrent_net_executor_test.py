@@ -3,7 +3,7 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
-from caffe2.python import model_helper, workspace, core, rnn_cell
+from caffe2.python import model_helper, workspace, core, rnn_cell, recurrent
 from caffe2.python.attention import AttentionType
 
 import numpy as np
@@ -178,6 +178,59 @@ class TestRNNExecutor(unittest.TestCase):
 
             self._compare(model, forward_only)
 
+    @given(
+        num_layers=st.integers(2, 6),
+        T=st.integers(4, 50),
+        num_threads=st.integers(1, 8),
+        forward_only=st.booleans(),
+        **hu.gcs_cpu_only)
+    def test_stacked_lstm_wavefront(
+            self, num_layers, T, num_threads, forward_only, gc, dc):
+        '''
+        Stacked LSTM on CPU with the executor thread pool configured: layers
+        run as a wavefront over the timesteps and must match the sequential
+        results.
+        '''
+        self.Tseq = [T, T // 2, T]
+        workspace.ResetWorkspace()
+        workspace.FeedBlob(
+            "seq_lengths", np.array([T] * self.batch_size, dtype=np.int32))
+
+        model = model_helper.ModelHelper(name="stacked_lstm")
+        model.net.AddExternalInputs(["input"])
+        init_blobs = []
+        for i in range(num_layers):
+            init_blobs.extend(model.net.AddExternalInputs(
+                "hidden_init_{}".format(i), "cell_init_{}".format(i)))
+
+        output, _, _, _ = rnn_cell.LSTM(
+            model=model,
+            input_blob="input",
+            seq_lengths="seq_lengths",
+            initial_states=init_blobs,
+            dim_in=self.input_dim,
+            dim_out=[self.hidden_dim] * num_layers,
+            scope="",
+            drop_states=True,
+            forward_only=forward_only,
+            return_last_layer_only=True,
+        )
+        loss = model.AveragedLoss(
+            model.SquaredL2Distance([output, "target"], "dist"), "loss")
+        if not forward_only:
+            model.AddGradientOperators([loss])
+
+        for op in model.net.Proto().op:
+            if op.type.startswith("RecurrentNetwork"):
+                recurrent.set_rnn_executor_config(
+                    op, num_threads=num_threads, numa_node=0)
+
+        for init_blob in init_blobs:
+            workspace.FeedBlob(init_blob, np.zeros(
+                [1, self.batch_size, self.hidden_dim], dtype=np.float32))
+
+        self._compare(model, forward_only)
+
     def _compare(self, model, forward_only):
         # Store list of blobs that exist in the beginning
         workspace.RunNetOnce(model.param_init_net)
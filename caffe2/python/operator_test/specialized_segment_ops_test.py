@@ -265,6 +265,88 @@ class TestSpecializedSegmentOps(hu.HypothesisTestCase):
         with self.assertRaises(RuntimeError):
             self.ws.run(op)
 
+    @given(num_tables=st.integers(1, 6),
+           min_chunk_size=st.sampled_from([1, 7, 1024]),
+           seed=st.integers(0, 1000),
+           **hu.gcs_cpu_only)
+    def test_multi_table_sparse_lengths_sum_cpu(
+            self, num_tables, min_chunk_size, seed, gc, dc):
+        np.random.seed(seed)
+        inputs = []
+        for k in range(num_tables):
+            tblsize = np.random.randint(1, 100)
+            blocksize = np.random.choice([1, 8, 17, 64, 163])
+            fptype = np.random.choice([np.float16, np.float32])
+            Tbl = np.random.rand(tblsize, blocksize).astype(fptype)
+            Lengths = np.random.randint(0, 30, size=np.random.randint(0, 20))
+            Indices = np.random.randint(0, tblsize, size=sum(Lengths)).astype(
+                np.random.choice([np.int32, np.int64]))
+            names = ["Tbl%d" % k, "Indices%d" % k, "Lengths%d" % k]
+            for name, value in zip(
+                    names, [Tbl, Indices, Lengths.astype(np.int32)]):
+                self.ws.create_blob(name).feed(value)
+            inputs += names
+            self.ws.run(core.CreateOperator(
+                "SparseLengthsSum", names, "ref%d" % k))
+
+        op = core.CreateOperator(
+            "MultiTableSparseLengthsSum",
+            inputs,
+            ["out%d" % k for k in range(num_tables)],
+            min_chunk_size=min_chunk_size)
+        self.ws.run(op)
+        for k in range(num_tables):
+            np.testing.assert_array_equal(
+                self.ws.blobs["out%d" % k].fetch(),
+                self.ws.blobs["ref%d" % k].fetch())
+
+    @given(op_type=st.sampled_from(
+               ["SparseLengthsSum", "SparseLengthsWeightedSum",
+                "SparseLengthsMean"]),
+           fptype=st.sampled_from([np.float16, np.float32]),
+           blocksize=st.sampled_from([1, 8, 17, 64]),
+           seed=st.integers(0, 1000),
+           **hu.gcs_cpu_only)
+    def test_sparse_lengths_hot_row_cache_cpu(
+            self, op_type, fptype, blocksize, seed, gc, dc):
+        np.random.seed(seed)
+        tblsize = 100
+        self.ws.create_blob("Tbl").feed(
+            np.random.rand(tblsize, blocksize).astype(fptype))
+        inputs = ["Tbl", "Indices", "Lengths"]
+        if op_type == "SparseLengthsWeightedSum":
+            inputs = ["Tbl", "Weights", "Indices", "Lengths"]
+        ref_op = core.CreateOperator(op_type, inputs, "ref")
+        op = core.CreateOperator(
+            op_type, inputs, "cached_" + op_type,
+            hot_row_cache_size=4, hot_row_cache_refresh_interval=50)
+
+        for _ in range(10):
+            # most lookups go to a handful of rows
+            Lengths = np.random.randint(1, 10, size=8).astype(np.int32)
+            Indices = np.where(
+                np.random.rand(sum(Lengths)) < 0.8,
+                np.random.randint(0, 4, size=sum(Lengths)),
+                np.random.randint(0, tblsize, size=sum(Lengths)))
+            self.ws.create_blob("Indices").feed(Indices.astype(np.int64))
+            self.ws.create_blob("Lengths").feed(Lengths)
+            self.ws.create_blob("Weights").feed(
+                np.random.rand(sum(Lengths)).astype(np.float32))
+            self.ws.run(ref_op)
+            self.ws.run(op)
+            np.testing.assert_allclose(
+                self.ws.blobs["cached_" + op_type].fetch(),
+                self.ws.blobs["ref"].fetch(), rtol=1e-5, atol=1e-5)
+
+        self.ws.run(core.CreateOperator(
+            "StatRegistryExport", [], ["keys", "values", "ts"]))
+        stats = dict(zip(self.ws.blobs["keys"].fetch(),
+                         self.ws.blobs["values"].fetch()))
+        prefix = "hot_row_cache/cached_" + op_type
+        hits = stats[(prefix + "/hits").encode()]
+        misses = stats[(prefix + "/misses").encode()]
+        self.assertGreater(hits, misses)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -2,7 +2,7 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
-from caffe2.python import core
+from caffe2.python import core, workspace
 from hypothesis import given
 import caffe2.python.hypothesis_test_util as hu
 import hypothesis.strategies as st
@@ -113,6 +113,95 @@ class TestStringOps(hu.HypothesisTestCase):
             [strings],
             string_ends_with_ref)
 
+    @given(strings=_string_lists())
+    def test_string_pack_unpack(self, strings):
+        strings = np.array(
+            [a.encode('utf-8') for a in strings], dtype=np.object
+        )
+
+        def string_pack_ref(strings):
+            return (
+                np.array([len(a) for a in strings], dtype=np.int32),
+                np.frombuffer(b''.join(strings), dtype=np.uint8),
+            )
+
+        op = core.CreateOperator(
+            'StringPack',
+            ['strings'],
+            ['lengths', 'bytes'])
+        self.assertReferenceChecks(
+            hu.cpu_do,
+            op,
+            [strings],
+            string_pack_ref)
+
+        lengths, data = string_pack_ref(strings)
+        op = core.CreateOperator(
+            'StringUnpack',
+            ['lengths', 'bytes'],
+            ['strings'])
+        self.assertReferenceChecks(
+            hu.cpu_do,
+            op,
+            [lengths, data],
+            lambda lengths, data: (strings,))
+
+    @given(strings=_string_lists())
+    def test_string_prefix_packed(self, strings):
+        length = 3
+        strings = [a.encode('utf-8') for a in strings]
+
+        def string_prefix_ref(lengths, data):
+            prefixes = [a[:length] for a in strings]
+            return (
+                np.array([len(a) for a in prefixes], dtype=np.int32),
+                np.frombuffer(b''.join(prefixes), dtype=np.uint8),
+            )
+
+        op = core.CreateOperator(
+            'StringPrefix',
+            ['lengths', 'bytes'],
+            ['prefix_lengths', 'prefix_bytes'],
+            length=length)
+        self.assertReferenceChecks(
+            hu.cpu_do,
+            op,
+            [np.array([len(a) for a in strings], dtype=np.int32),
+             np.frombuffer(b''.join(strings), dtype=np.uint8)],
+            string_prefix_ref)
+
+    @given(strings=st.lists(
+        st.text(alphabet=['a', 'b', ' '], average_size=5), max_size=5))
+    def test_string_tokenize_hash(self, strings):
+        strings = np.array(
+            [a.encode('utf-8') for a in strings], dtype=np.object
+        )
+        workspace.FeedBlob('strings', strings)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'StringPack', ['strings'], ['lengths', 'bytes']))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'StringTokenizeHash', ['strings'], ['num_tokens', 'ids'],
+            num_buckets=1000))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'StringTokenizeHash', ['lengths', 'bytes'],
+            ['packed_num_tokens', 'packed_ids'], num_buckets=1000))
+
+        tokens = [t for a in strings for t in a.split()]
+        num_tokens = workspace.FetchBlob('num_tokens')
+        ids = workspace.FetchBlob('ids')
+        np.testing.assert_array_equal(
+            num_tokens, [len(a.split()) for a in strings])
+        self.assertEqual(len(ids), len(tokens))
+        self.assertTrue(np.all((ids >= 0) & (ids < 1000)))
+        # equal tokens get equal ids
+        for i in range(len(tokens)):
+            for j in range(len(tokens)):
+                if tokens[i] == tokens[j]:
+                    self.assertEqual(ids[i], ids[j])
+        np.testing.assert_array_equal(
+            workspace.FetchBlob('packed_num_tokens'), num_tokens)
+        np.testing.assert_array_equal(workspace.FetchBlob('packed_ids'), ids)
+
 if __name__ == "__main__":
     import unittest
     unittest.main()
@@ -6,6 +6,7 @@ from caffe2.python import core, workspace
 from caffe2.python.text_file_reader import TextFileReader
 from caffe2.python.test_util import TestCase
 from caffe2.python.schema import Struct, Scalar, FetchRecord
+import itertools
 import tempfile
 import numpy as np
 
@@ -32,35 +33,37 @@ class TestTextFileReader(TestCase):
             )
             txt_file.flush()
 
-            for num_passes in range(1, 3):
-                for batch_size in range(1, len(row_data) + 2):
-                    init_net = core.Net('init_net')
-                    reader = TextFileReader(
-                        init_net,
-                        filename=txt_file.name,
-                        schema=schema,
-                        batch_size=batch_size,
-                        num_passes=num_passes)
-                    workspace.RunNetOnce(init_net)
+            for num_passes, batch_size, num_threads in itertools.product(
+                    range(1, 3), range(1, len(row_data) + 2), range(3)):
+                init_net = core.Net('init_net')
+                reader = TextFileReader(
+                    init_net,
+                    filename=txt_file.name,
+                    schema=schema,
+                    batch_size=batch_size,
+                    num_passes=num_passes,
+                    num_threads=num_threads,
+                    chunk_size=8)
+                workspace.RunNetOnce(init_net)
 
-                    net = core.Net('read_net')
-                    should_stop, record = reader.read_record(net)
+                net = core.Net('read_net')
+                should_stop, record = reader.read_record(net)
 
-                    results = [np.array([])] * num_fields
-                    while True:
-                        workspace.RunNetOnce(net)
-                        arrays = FetchRecord(record).field_blobs()
-                        for i in range(num_fields):
-                            results[i] = np.append(results[i], arrays[i])
-                        if workspace.FetchBlob(should_stop):
-                            break
+                results = [np.array([])] * num_fields
+                while True:
+                    workspace.RunNetOnce(net)
+                    arrays = FetchRecord(record).field_blobs()
                     for i in range(num_fields):
-                        col_batch = np.tile(col_data[i], num_passes)
-                        if col_batch.dtype in (np.float32, np.float64):
-                            np.testing.assert_array_almost_equal(
-                                col_batch, results[i], decimal=3)
-                        else:
-                            np.testing.assert_array_equal(col_batch, results[i])
+                        results[i] = np.append(results[i], arrays[i])
+                    if workspace.FetchBlob(should_stop):
+                        break
+                for i in range(num_fields):
+                    col_batch = np.tile(col_data[i], num_passes)
+                    if col_batch.dtype in (np.float32, np.float64):
+                        np.testing.assert_array_almost_equal(
+                            col_batch, results[i], decimal=3)
+                    else:
+                        np.testing.assert_array_equal(col_batch, results[i])
 
 if __name__ == "__main__":
     import unittest
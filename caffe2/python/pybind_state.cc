@@ -9,9 +9,13 @@
 #include "caffe2/core/numa.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/predictor.h"
+#include "caffe2/core/sampling_profiler.h"
 #include "caffe2/core/stats.h"
 #include "caffe2/core/transform.h"
 #include "caffe2/mkl/mkl_utils.h"
+#include "caffe2/observers/cost_observer.h"
+#include "caffe2/observers/latency_observer.h"
+#include "caffe2/observers/memory_observer.h"
 #include "caffe2/observers/runcnt_observer.h"
 #include "caffe2/observers/time_observer.h"
 #include "caffe2/onnx/backend.h"
@@ -156,9 +160,17 @@ const Func& getGradientFunc(const std::string& token) {
   return getOpFunc(token + "_gradient");
 }
 
-py::object fetchBlob(Workspace* ws, const std::string& name) {
+py::object
+fetchBlob(Workspace* ws, const std::string& name, bool zero_copy) {
   CAFFE_ENFORCE(ws->HasBlob(name), "Can't find blob: ", name);
   const caffe2::Blob& blob = *(ws->GetBlob(name));
+  if (zero_copy && blob.IsType<TensorCPU>()) {
+    // Returns a view of the tensor's data where possible, which is only
+    // valid until the tensor is next written to.
+    return TensorFetcher<CPUContext>()
+        .FetchTensor(blob.Get<TensorCPU>(), false)
+        .obj;
+  }
   auto fetcher = CreateFetcher(blob.meta().id());
   if (fetcher) {
     return fetcher->Fetch(blob);
@@ -331,16 +343,41 @@ void addObjectMethods(py::module& m) {
             return t->data();
           },
           "Return DLPack tensor with tensor's data.")
+      .def(
+          "to_dlpack",
+          [](DLPackWrapper<CPUContext>* t, py::object stream) -> py::object {
+            CAFFE_ENFORCE_EQ(
+                t->device_option.device_type(),
+                CPU,
+                "Expected CPU device option for CPU tensor");
+            return t->data(stream);
+          },
+          "Return DLPack tensor with tensor's data. The work queued from now "
+          "on on the given consumer stream (a cudaStream_t handle) waits for "
+          "the work queued so far on the stream of the tensor.",
+          py::arg("stream") = py::none())
       .def(
           "feed",
-          [](DLPackWrapper<CPUContext>* t, py::object obj) {
+          [](DLPackWrapper<CPUContext>* t, py::object obj, py::object stream) {
             CAFFE_ENFORCE_EQ(
                 t->device_option.device_type(),
                 CPU,
                 "Expected CPU device option for CPU tensor");
-            t->feed(obj);
+            t->feed(obj, stream);
+          },
+          "Share the memory of the given DLPack tensor with this tensor. The "
+          "work queued from now on on the stream of the tensor waits for the "
+          "work queued so far on the given producer stream (a cudaStream_t "
+          "handle).",
+          py::arg("obj"),
+          py::arg("stream") = py::none())
+      .def_property_readonly(
+          "stream",
+          [](const DLPackWrapper<CPUContext>& t) {
+            return reinterpret_cast<uintptr_t>(t.stream);
           },
-          "Copy data from given DLPack tensor into this tensor.")
+          "The cudaStream_t handle the tensor is used on, 0 for the default "
+          "stream.")
       .def_property_readonly(
           "_shape",
           [](const DLPackWrapper<CPUContext>& t) {
@@ -449,7 +486,11 @@ void addObjectMethods(py::module& m) {
             return py::cast(self->CreateBlob(name));
           },
           py::return_value_policy::reference_internal)
-      .def("fetch_blob", &python_detail::fetchBlob)
+      .def(
+          "fetch_blob",
+          &python_detail::fetchBlob,
+          py::arg("name"),
+          py::arg("zero_copy") = kPyBindFalse)
       .def(
           "has_blob",
           [](Workspace* self, const std::string& name) {
@@ -1036,6 +1077,24 @@ void addGlobalMethods(py::module& m) {
           observer = net->AttachObserver(std::move(net_ob));
         }
 
+        if (observer_type.compare("CostObserver") == 0) {
+          unique_ptr<CostNetObserver> net_ob =
+              make_unique<CostNetObserver>(net);
+          observer = net->AttachObserver(std::move(net_ob));
+        }
+
+        if (observer_type.compare("LatencyObserver") == 0) {
+          unique_ptr<LatencyNetObserver> net_ob =
+              make_unique<LatencyNetObserver>(net);
+          observer = net->AttachObserver(std::move(net_ob));
+        }
+
+        if (observer_type.compare("MemoryObserver") == 0) {
+          unique_ptr<MemoryNetObserver> net_ob =
+              make_unique<MemoryNetObserver>(net);
+          observer = net->AttachObserver(std::move(net_ob));
+        }
+
         CAFFE_ENFORCE(observer != nullptr);
         return py::cast(observer);
       });
@@ -1212,6 +1271,52 @@ void addGlobalMethods(py::module& m) {
         CAFFE_ENFORCE(optimized.SerializeToString(&protob));
         return py::bytes(protob);
       });
+  m.def(
+      "memonger_plan_inference_net_memory",
+      [](const py::bytes& net_def,
+         const std::map<std::string, std::vector<TIndex>>& input_shapes,
+         const std::vector<std::string>& static_blobs,
+         bool apply,
+         bool alias_concat_and_split) {
+        NetDef def;
+        CAFFE_ENFORCE(
+            ParseProtoFromLargeString(net_def.cast<std::string>(), &def));
+        if (apply) {
+          CAFFE_ENFORCE(gWorkspace);
+        }
+        memonger::MemoryPlan plan;
+        {
+          py::gil_scoped_release g;
+          CaffeMap<std::string, std::vector<TIndex>> shapes(
+              input_shapes.begin(), input_shapes.end());
+          std::set<string> static_blobs_set(
+              static_blobs.begin(), static_blobs.end());
+          plan = memonger::plan_inference_net_memory(
+              def, shapes, static_blobs_set, alias_concat_and_split);
+          if (apply) {
+            memonger::apply_memory_plan(plan, gWorkspace);
+          }
+        }
+        py::dict offsets;
+        py::dict aliases;
+        for (const auto& allocation : plan.allocations) {
+          offsets[py::str(allocation.blob)] =
+              py::make_tuple(allocation.offset, allocation.nbytes);
+          if (!allocation.alias_of.empty()) {
+            aliases[py::str(allocation.blob)] = py::str(allocation.alias_of);
+          }
+        }
+        py::dict result;
+        result["arena_size"] = plan.arena_size;
+        result["total_size"] = plan.total_size;
+        result["offsets"] = offsets;
+        result["aliases"] = aliases;
+        return result;
+      });
+  m.def("sampling_profile_chrome_trace", []() {
+    return GetSamplingProfileChromeTrace();
+  });
+  m.def("clear_sampling_profile", []() { ProfileRingBuffer::Global().Clear(); });
   m.def(
       "infer_shapes_and_types_from_workspace",
       [](const std::vector<py::bytes>& net_protos) {
@@ -1254,12 +1359,20 @@ void addGlobalMethods(py::module& m) {
     CAFFE_ENFORCE(gWorkspace->CreateBlob(name));
     return true;
   });
-  m.def("fetch_blob", [](const std::string& name) -> py::object {
-    return python_detail::fetchBlob(gWorkspace, name);
-  });
+  m.def(
+      "fetch_blob",
+      [](const std::string& name, bool zero_copy) -> py::object {
+        return python_detail::fetchBlob(gWorkspace, name, zero_copy);
+      },
+      "",
+      py::arg("name"),
+      py::arg("zero_copy") = kPyBindFalse);
   m.def(
       "feed_blob",
-      [](const std::string& name, py::object arg, py::object device_option) {
+      [](const std::string& name,
+         py::object arg,
+         py::object device_option,
+         bool zero_copy) {
         DeviceOption option;
         if (!device_option.is(py::none())) {
           // If we have a device option passed in, read it.
@@ -1269,6 +1382,11 @@ void addGlobalMethods(py::module& m) {
         auto* blob = gWorkspace->CreateBlob(name);
         if (PyArray_Check(arg.ptr())) { // numpy array
           PyArrayObject* array = reinterpret_cast<PyArrayObject*>(arg.ptr());
+          if (zero_copy && option.device_type() == CPU) {
+            TensorFeeder<CPUContext>().ShareTensor(
+                option, array, blob->GetMutable<TensorCPU>());
+            return true;
+          }
           auto feeder = CreateFeeder(option.device_type());
           CAFFE_ENFORCE(feeder, "Unknown device type encountered in FeedBlob.");
           feeder->Feed(option, array, blob);
@@ -1286,7 +1404,8 @@ void addGlobalMethods(py::module& m) {
       "",
       py::arg("name"),
       py::arg("arg"),
-      py::arg("device_option") = py::none());
+      py::arg("device_option") = py::none(),
+      py::arg("zero_copy") = kPyBindFalse);
   m.def("serialize_blob", [](const std::string& name) {
     CAFFE_ENFORCE(gWorkspace);
     auto* blob = gWorkspace->GetBlob(name);
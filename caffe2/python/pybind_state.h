@@ -123,6 +123,20 @@ class TensorFetcher : public BlobFetcherBase {
       outPtr = const_cast<Tensor<Context>&>(tensor).raw_mutable_data();
       result.obj = py::reinterpret_steal<py::object>(PyArray_SimpleNewFromData(
           tensor.ndim(), npy_dims.data(), numpy_type, outPtr));
+      // The array holds on to a tensor sharing the data, so that it stays
+      // valid after the tensor is freed or reallocated.
+      auto* owner = new Tensor<Context>(tensor.dims());
+      owner->ShareData(tensor);
+      PyObject* base = PyCapsule_New(owner, nullptr, [](PyObject* capsule) {
+        delete static_cast<Tensor<Context>*>(
+            PyCapsule_GetPointer(capsule, nullptr));
+      });
+      if (base == nullptr) {
+        delete owner;
+        CAFFE_THROW("Failed to allocate the base object for a numpy view.");
+      }
+      PyArray_SetBaseObject(
+          reinterpret_cast<PyArrayObject*>(result.obj.ptr()), base);
     }
 
     if (numpy_type == NPY_OBJECT) {
@@ -225,6 +239,37 @@ class TensorFeeder : public BlobFeederBase {
     context.FinishDeviceComputation();
   }
 
+  // Like FeedTensor, but lets the tensor use the array's buffer instead of
+  // copying it. The tensor keeps a reference to the array for as long as it
+  // uses the buffer, and ops writing into the tensor in place write into the
+  // array. Arrays which can't be shared (not C-contiguous, aligned and
+  // writeable, or holding strings) and devices other than the CPU are
+  // copied as usual.
+  void ShareTensor(
+      const DeviceOption& option,
+      PyArrayObject* array,
+      Tensor<Context>* tensor) {
+    const auto npy_type = PyArray_TYPE(array);
+    const TypeMeta& meta = NumpyTypeToCaffe(npy_type);
+    if (!std::is_same<Context, CPUContext>::value || !PyArray_ISCARRAY(array) ||
+        meta.id() == 0 || meta.id() == TypeMeta::Id<std::string>()) {
+      FeedTensor(option, array, tensor);
+      return;
+    }
+    std::vector<TIndex> dims(
+        PyArray_DIMS(array), PyArray_DIMS(array) + PyArray_NDIM(array));
+    tensor->Resize(dims);
+    Py_INCREF(array);
+    tensor->ShareExternalPointer(
+        PyArray_DATA(array), meta, PyArray_NBYTES(array), [array](void*) {
+          // The tensor may outlive the interpreter, e.g. in gWorkspace
+          if (Py_IsInitialized()) {
+            py::gil_scoped_acquire g;
+            Py_DECREF(array);
+          }
+        });
+  }
+
   virtual void
   Feed(const DeviceOption& option, PyArrayObject* original_array, Blob* blob) {
     FeedTensor(option, original_array, blob->GetMutable<Tensor<Context>>());
@@ -332,6 +377,7 @@ class PythonOpBase : public Operator<Context> {
                 const_cast<Tensor<Context>*>(
                     &blob->template Get<Tensor<Context>>()),
                 this->device_option());
+            wrapper.stream = DLPackContextStream(&this->context_);
             py_obj = py::cast(wrapper, py::return_value_policy::copy);
           } else {
             py_obj = py::cast(
@@ -383,6 +429,7 @@ class PythonOpBase : public Operator<Context> {
             DLPackWrapper<Context> wrapper(
                 blob->template GetMutable<Tensor<Context>>(),
                 this->device_option());
+            wrapper.stream = DLPackContextStream(&this->context_);
             py_obj = py::cast(wrapper, py::return_value_policy::copy);
           } else {
             py_obj = py::cast(
@@ -69,5 +69,16 @@ const TypeMeta& DLTypeToCaffe(const DLDataType& dl_type) {
   }
 }
 
+void DLPackCapsuleDestructor(PyObject* capsule) {
+  if (!PyCapsule_IsValid(capsule, "dltensor")) {
+    return;
+  }
+  auto* dlMTensor =
+      (DLManagedTensor*)PyCapsule_GetPointer(capsule, "dltensor");
+  if (dlMTensor->destructor) {
+    dlMTensor->destructor(dlMTensor);
+  }
+}
+
 } // namespace python
 } // namespace caffe2
@@ -9,6 +9,8 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <memory>
+
 namespace caffe2 {
 namespace python {
 
@@ -20,13 +22,47 @@ const DLDataType* CaffeToDLType(const TypeMeta& meta);
 
 const TypeMeta& DLTypeToCaffe(const DLDataType& dl_type);
 
+class CUDAContext;
+
+// Makes the work queued on stream waiting from now on wait for the work
+// queued so far on stream, without blocking the host. Streams are
+// cudaStream_t handles of the given device; this is a no-op for CPU tensors.
+template <class Context>
+void DLPackStreamWait(int /* device_id */, void* /* waiting */, void* /* stream */) {}
+template <>
+void DLPackStreamWait<CUDAContext>(int device_id, void* waiting, void* stream);
+
+// The cudaStream_t operators running in context use, nullptr for CPU
+template <class Context>
+void* DLPackContextStream(Context* /* context */) {
+  return nullptr;
+}
+template <>
+void* DLPackContextStream<CUDAContext>(CUDAContext* context);
+
+// Keeps the data of an exported tensor alive until the consumer of the
+// DLPack tensor is done with it, even if the blob is resized or freed
+template <class Context>
+struct DLPackExportedTensor {
+  Tensor<Context> tensor;
+  std::vector<int64_t> shape;
+  DLManagedTensor managed_tensor;
+};
+
+// Frees the tensor of a capsule that was never consumed; consumers rename
+// the capsule to "used_dltensor" and take over the tensor
+void DLPackCapsuleDestructor(PyObject* capsule);
+
 template <class Context>
 class DLPackWrapper {
  public:
   DLPackWrapper(Tensor<Context>* tensor, DeviceOption device_option)
       : tensor(tensor), device_option(device_option) {}
 
-  py::object data() {
+  // Returns a DLPack capsule sharing the memory of the tensor. If consumer is
+  // given (a cudaStream_t handle), the work it queues from now on waits for
+  // the work queued so far on the stream of the tensor.
+  py::object data(py::object consumer = py::none()) {
     DLContext tensor_context;
     auto device_type_ptr = CaffeToDLDeviceType(device_option.device_type());
     CAFFE_ENFORCE(
@@ -52,29 +88,54 @@ class DLPackWrapper {
         tensor->meta().name());
     DLDataType tensor_type = *type_ptr;
 
+    std::unique_ptr<DLPackExportedTensor<Context>> exported(
+        new DLPackExportedTensor<Context>());
+    exported->tensor.Resize(tensor->dims());
+    exported->tensor.ShareData(*tensor);
+    exported->shape.assign(tensor->dims().begin(), tensor->dims().end());
+
     DLTensor dlTensor;
-    dlTensor.data = const_cast<void*>(tensor->raw_data());
+    dlTensor.data = const_cast<void*>(exported->tensor.raw_data());
     dlTensor.ctx = tensor_context;
-    dlTensor.ndim = tensor->ndim();
+    dlTensor.ndim = exported->shape.size();
     dlTensor.dtype = tensor_type;
-    dlTensor.shape = const_cast<int64_t*>(&(tensor->dims()[0]));
+    dlTensor.shape = exported->shape.data();
     dlTensor.strides = nullptr;
     dlTensor.byte_offset = 0;
 
-    managed_tensor.dlTensor = dlTensor;
-    // C2 Tensor memory is managed by C2
-    managed_tensor.ctx = nullptr;
-    managed_tensor.destructor = [](DLManagedTensor*) {};
-
-    return py::reinterpret_steal<py::object>(
-        PyCapsule_New(&managed_tensor, "dltensor", nullptr));
+    exported->managed_tensor.dlTensor = dlTensor;
+    exported->managed_tensor.ctx = exported.get();
+    exported->managed_tensor.destructor = [](DLManagedTensor* self) {
+      delete static_cast<DLPackExportedTensor<Context>*>(self->ctx);
+    };
+
+    if (!consumer.is_none()) {
+      DLPackStreamWait<Context>(
+          device_option.cuda_gpu_id(),
+          reinterpret_cast<void*>(consumer.cast<uintptr_t>()),
+          stream);
+    }
+    auto capsule = py::reinterpret_steal<py::object>(PyCapsule_New(
+        &exported->managed_tensor, "dltensor", DLPackCapsuleDestructor));
+    if (!capsule) {
+      throw py::error_already_set();
+    }
+    exported.release();
+    return capsule;
   }
 
-  void feed(py::object obj) {
+  // Makes the tensor share the memory of a DLPack capsule, which can't be
+  // consumed again. If producer is given (a cudaStream_t handle), the work
+  // queued from now on on the stream of the tensor waits for the work queued
+  // so far on it.
+  void feed(py::object obj, py::object producer = py::none()) {
     CAFFE_ENFORCE(PyCapsule_CheckExact(obj.ptr()), "Expected DLPack capsule");
     DLManagedTensor* dlMTensor =
         (DLManagedTensor*)PyCapsule_GetPointer(obj.ptr(), "dltensor");
-    CAFFE_ENFORCE(dlMTensor, "Invalid DLPack capsule");
+    CAFFE_ENFORCE(
+        dlMTensor,
+        "Invalid DLPack capsule, note that a capsule can only be consumed "
+        "once");
     DLTensor* dlTensor = &dlMTensor->dlTensor;
     auto device_type_ptr = CaffeToDLDeviceType(device_option.device_type());
     CAFFE_ENFORCE(
@@ -99,10 +160,11 @@ class DLPackWrapper {
     if (dlTensor->strides) {
       int64_t stride = 1;
       for (int idx = dims.size() - 1; idx >= 0; --idx) {
-        CAFFE_ENFORCE_EQ(
-            stride,
-            dlTensor->strides[idx],
-            "Tensors with non-standard strides are not supported");
+        // strides of dimensions of size 1 don't matter
+        CAFFE_ENFORCE(
+            dims[idx] == 1 || stride == dlTensor->strides[idx],
+            "Tensors with non-standard strides are not supported, the "
+            "memory can't be shared");
         stride *= dims[idx];
       }
     }
@@ -118,11 +180,21 @@ class DLPackWrapper {
             dlMTensor->destructor(dlMTensor);
           }
         });
+    // the tensor owns the DLPack tensor now
+    PyCapsule_SetName(obj.ptr(), "used_dltensor");
+
+    if (!producer.is_none()) {
+      DLPackStreamWait<Context>(
+          device_option.cuda_gpu_id(),
+          stream,
+          reinterpret_cast<void*>(producer.cast<uintptr_t>()));
+    }
   }
 
   Tensor<Context>* tensor;
   DeviceOption device_option;
-  DLManagedTensor managed_tensor;
+  // the cudaStream_t the tensor is used on, the default one if unset
+  void* stream = nullptr;
 };
 
 } // namespace python
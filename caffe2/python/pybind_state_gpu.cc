@@ -17,6 +17,22 @@
 namespace caffe2 {
 namespace python {
 
+template <>
+void DLPackStreamWait<CUDAContext>(int device_id, void* waiting, void* stream) {
+  DeviceGuard guard(device_id);
+  cudaEvent_t event;
+  CUDA_ENFORCE(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+  CUDA_ENFORCE(cudaEventRecord(event, static_cast<cudaStream_t>(stream)));
+  CUDA_ENFORCE(
+      cudaStreamWaitEvent(static_cast<cudaStream_t>(waiting), event, 0));
+  CUDA_ENFORCE(cudaEventDestroy(event));
+}
+
+template <>
+void* DLPackContextStream<CUDAContext>(CUDAContext* context) {
+  return context->cuda_stream();
+}
+
 REGISTER_CUDA_OPERATOR(Python, GPUFallbackOp<PythonOp<CPUContext, false>>);
 REGISTER_CUDA_OPERATOR(
     PythonGradient,
@@ -65,16 +81,41 @@ void addCUDAObjectMethods(py::module& m) {
             return t->data();
           },
           "Return DLPack tensor with tensor's data.")
+      .def(
+          "to_dlpack",
+          [](DLPackWrapper<CUDAContext>* t, py::object stream) -> py::object {
+            CAFFE_ENFORCE_EQ(
+                t->device_option.device_type(),
+                CUDA,
+                "Expected CUDA device option for CUDA tensor");
+            return t->data(stream);
+          },
+          "Return DLPack tensor with tensor's data. The work queued from now "
+          "on on the given consumer stream (a cudaStream_t handle) waits for "
+          "the work queued so far on the stream of the tensor.",
+          py::arg("stream") = py::none())
       .def(
           "feed",
-          [](DLPackWrapper<CUDAContext>* t, py::object obj) {
+          [](DLPackWrapper<CUDAContext>* t, py::object obj, py::object stream) {
             CAFFE_ENFORCE_EQ(
                 t->device_option.device_type(),
                 CUDA,
                 "Expected CUDA device option for CUDA tensor");
-            t->feed(obj);
+            t->feed(obj, stream);
+          },
+          "Share the memory of the given DLPack tensor with this tensor. The "
+          "work queued from now on on the stream of the tensor waits for the "
+          "work queued so far on the given producer stream (a cudaStream_t "
+          "handle).",
+          py::arg("obj"),
+          py::arg("stream") = py::none())
+      .def_property_readonly(
+          "stream",
+          [](const DLPackWrapper<CUDAContext>& t) {
+            return reinterpret_cast<uintptr_t>(t.stream);
           },
-          "Copy data from given DLPack tensor into this tensor.")
+          "The cudaStream_t handle the tensor is used on, 0 for the default "
+          "stream.")
       .def_property_readonly(
           "_shape",
           [](const DLPackWrapper<CUDAContext>& t) { return t.tensor->dims(); })
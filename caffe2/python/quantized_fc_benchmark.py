@@ -0,0 +1,91 @@
+## @package quantized_fc_benchmark
+# Module caffe2.python.quantized_fc_benchmark
+"""Compares the accuracy and latency of the bit-serial QuantizedFC with FC.
+
+The weights are quantized once with QTensorQuantize, the float activations
+inside QuantizedFC on every run, as in inference. The error is the relative
+Frobenius norm of the difference with the float FC output.
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core, workspace
+
+import argparse
+import numpy as np
+import time
+
+
+def run_timed(net, iterations):
+    workspace.CreateNet(net)
+    workspace.RunNet(net.Proto().name)
+    start_time = time.time()
+    workspace.RunNet(net.Proto().name, iterations)
+    return (time.time() - start_time) / iterations * 1000
+
+
+def Benchmark(args):
+    np.random.seed(1701)
+    X = np.random.randn(args.batch_size, args.input_dim).astype(np.float32)
+    if args.relu_input:
+        X = np.maximum(X, 0)
+    W = (np.random.randn(args.output_dim, args.input_dim) /
+         np.sqrt(args.input_dim)).astype(np.float32)
+    b = np.random.randn(args.output_dim).astype(np.float32)
+    workspace.FeedBlob('X', X)
+    workspace.FeedBlob('W', W)
+    workspace.FeedBlob('b', b)
+
+    float_net = core.Net('float_fc')
+    float_net.FC(['X', 'W', 'b'], ['Y_float'])
+    float_ms = run_timed(float_net, args.iterations)
+    Y_float = workspace.FetchBlob('Y_float')
+    print('{:>8} {:>8} {:>12} {:>10} {:>8}'.format(
+        'W bits', 'X bits', 'latency ms', 'rel error', 'speedup'))
+    print('{:>8} {:>8} {:>12.3f} {:>10} {:>8}'.format(
+        'float', 'float', float_ms, '-', '1.00'))
+
+    for w_bits, x_bits in zip(args.weight_precisions, args.input_precisions):
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'QTensorQuantize', ['W'], ['W_q'], precision=w_bits, signed=True))
+        net = core.Net('quantized_fc_{}_{}'.format(w_bits, x_bits))
+        net.QuantizedFC(
+            ['X', 'W_q', 'b'], ['Y_quantized'],
+            precision=x_bits, signed=not args.relu_input)
+        ms = run_timed(net, args.iterations)
+        Y = workspace.FetchBlob('Y_quantized')
+        error = np.linalg.norm(Y - Y_float) / np.linalg.norm(Y_float)
+        print('{:>8} {:>8} {:>12.3f} {:>10.4f} {:>8.2f}'.format(
+            w_bits, x_bits, ms, error, float_ms / ms))
+
+
+def GetArgumentParser():
+    parser = argparse.ArgumentParser(
+        description="QuantizedFC against FC benchmark.")
+    parser.add_argument("--batch_size", type=int, default=1,
+                        help="Rows of X.")
+    parser.add_argument("--input_dim", type=int, default=4096,
+                        help="Columns of X and W.")
+    parser.add_argument("--output_dim", type=int, default=1024,
+                        help="Rows of W.")
+    parser.add_argument("--weight_precisions", type=int, nargs='+',
+                        default=[1, 2, 4, 8],
+                        help="Bits of the weights, one per run.")
+    parser.add_argument("--input_precisions", type=int, nargs='+',
+                        default=[1, 2, 4, 8],
+                        help="Bits of the activations, one per run.")
+    parser.add_argument("--relu_input", action="store_true",
+                        help="Makes X non-negative and quantizes it unsigned.")
+    parser.add_argument("--iterations", type=int, default=100,
+                        help="Runs of every net to average.")
+    return parser
+
+
+if __name__ == '__main__':
+    args, extra_args = GetArgumentParser().parse_known_args()
+    assert len(args.weight_precisions) == len(args.input_precisions), \
+        "Give as many input precisions as weight precisions"
+    workspace.GlobalInit(['caffe2', '--caffe2_log_level=0'] + extra_args)
+    Benchmark(args)
@@ -286,7 +286,8 @@ def recurrent_net(
     return results[:-1]
 
 
-def set_rnn_executor_config(rnn_op, num_threads=None, max_cuda_streams=None):
+def set_rnn_executor_config(rnn_op, num_threads=None, max_cuda_streams=None,
+                            numa_node=None):
     from caffe2.proto import caffe2_pb2
     assert rnn_op.type in {'RecurrentNetwork', 'RecurrentNetworkGradient'}
 
@@ -300,6 +301,10 @@ def set_rnn_executor_config(rnn_op, num_threads=None, max_cuda_streams=None):
         add_arg('num_threads', num_threads)
     if max_cuda_streams is not None:
         add_arg('max_cuda_streams', max_cuda_streams)
+    if numa_node is not None:
+        # CPU only: binds the executor threads to the node, and uses one
+        # thread per CPU of the node unless num_threads is given
+        add_arg('numa_node', numa_node)
 
 
 def retrieve_step_blobs(net, prefix='rnn'):
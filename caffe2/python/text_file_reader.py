@@ -13,7 +13,8 @@ class TextFileReader(Reader):
     """
     Wrapper around operators for reading from text files.
     """
-    def __init__(self, init_net, filename, schema, num_passes=1, batch_size=1):
+    def __init__(self, init_net, filename, schema, num_passes=1, batch_size=1,
+                 num_threads=0, chunk_size=4 << 20):
         """
         Create op for building a TextFileReader instance in the workspace.
 
@@ -24,6 +25,9 @@ class TextFileReader(Reader):
                          Currently, only support Struct of strings.
             num_passes : Number of passes over the data.
             batch_size : Number of rows to read at a time.
+            num_threads: If positive, the file is memory-mapped and parsed in
+                         chunks of chunk_size bytes by this many threads.
+            chunk_size : Size in bytes of the chunks parsed in parallel.
         """
         assert isinstance(schema, Struct), 'Schema must be a schema.Struct'
         for name, child in schema.get_children():
@@ -36,7 +40,9 @@ class TextFileReader(Reader):
             [],
             filename=filename,
             num_passes=num_passes,
-            field_types=field_types)
+            field_types=field_types,
+            num_threads=num_threads,
+            chunk_size=chunk_size)
         self._batch_size = batch_size
 
     def read(self, net):
@@ -281,7 +281,7 @@ def GetNetName(net):
     raise Exception("Not a Net object: {}".format(str(net)))
 
 
-def FeedBlob(name, arr, device_option=None):
+def FeedBlob(name, arr, device_option=None, zero_copy=False):
     """Feeds a blob into the workspace.
 
     Inputs:
@@ -289,6 +289,10 @@ def FeedBlob(name, arr, device_option=None):
       arr: either a TensorProto object or a numpy array object to be fed into
           the workspace.
       device_option (optional): the device option to feed the data with.
+      zero_copy (optional): when feeding a contiguous numpy array to the CPU,
+          let the blob use the array's memory instead of a copy of it. The
+          blob keeps the array alive, and ops writing the blob in place
+          write into the array.
     Returns:
       True or False, stating whether the feed is successful.
     """
@@ -312,9 +316,10 @@ def FeedBlob(name, arr, device_option=None):
 
     name = StringifyBlobName(name)
     if device_option is not None:
-        return C.feed_blob(name, arr, StringifyProto(device_option))
+        return C.feed_blob(
+            name, arr, StringifyProto(device_option), zero_copy=zero_copy)
     else:
-        return C.feed_blob(name, arr)
+        return C.feed_blob(name, arr, zero_copy=zero_copy)
 
 
 def FetchBlobs(names):
@@ -328,15 +333,19 @@ def FetchBlobs(names):
     return [FetchBlob(name) for name in names]
 
 
-def FetchBlob(name):
+def FetchBlob(name, zero_copy=False):
     """Fetches a blob from the workspace.
 
     Inputs:
       name: the name of the blob - a string or a BlobReference
+      zero_copy (optional): return a numpy view of a CPU tensor's memory
+          instead of a copy of it. The view keeps the memory alive, but its
+          contents change when the blob is next written in place, e.g. by
+          the next run of the net producing it.
     Returns:
       Fetched blob (numpy array or string) if successful
     """
-    result = C.fetch_blob(StringifyBlobName(name))
+    result = C.fetch_blob(StringifyBlobName(name), zero_copy=zero_copy)
     if isinstance(result, tuple):
         raise TypeError(
             "Use FetchInt8Blob to fetch Int8 Blob {}".format(
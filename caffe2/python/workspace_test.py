@@ -164,6 +164,27 @@ class TestWorkspace(unittest.TestCase):
         self.assertEqual(fetched_again.shape, (1, 2, 3, 4))
         np.testing.assert_array_equal(fetched_again, 2.0)
 
+    def testFetchFeedBlobZeroCopy(self):
+        arr = np.random.rand(3, 4).astype(np.float32)
+        self.assertEqual(workspace.FeedBlob("zc", arr, zero_copy=True), True)
+        # the blob uses the array's memory
+        arr[0, 0] = 7.0
+        fetched = workspace.FetchBlob("zc", zero_copy=True)
+        np.testing.assert_array_equal(fetched, arr)
+        # and the view uses the blob's
+        fetched[1, 1] = 8.0
+        self.assertEqual(arr[1, 1], 8.0)
+        # the view stays valid after the blob is gone
+        workspace.ResetWorkspace()
+        del arr
+        self.assertEqual(fetched[0, 0], 7.0)
+        # arrays which can't be shared are copied
+        arr = np.arange(12, dtype=np.float32).reshape(3, 4).T
+        workspace.FeedBlob("zc", arr, zero_copy=True)
+        arr[0, 0] = 100.0
+        np.testing.assert_array_equal(
+            workspace.FetchBlob("zc"), np.arange(12).reshape(3, 4).T)
+
     def testFetchFeedBlobTypes(self):
         for dtype in [np.float16, np.float32, np.float64, np.bool,
                       np.int8, np.int16, np.int32, np.int64,
@@ -1,6 +1,7 @@
 #include "caffe2/queue/blobs_queue.h"
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -22,6 +23,12 @@ static constexpr uint64_t SDT_TIMEOUT = (uint64_t)-1;
 static constexpr uint64_t SDT_ABORT = (uint64_t)-2;
 static constexpr uint64_t SDT_CANCEL = (uint64_t)-3;
 
+static int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
 BlobsQueue::BlobsQueue(
     Workspace* ws,
     const std::string& queueName,
@@ -36,6 +43,7 @@ BlobsQueue::BlobsQueue(
     stats_.queue_dequeued_bytes.setDetails(fieldNames);
   }
   queue_.reserve(capacity);
+  writeTimeNs_.resize(capacity);
   for (auto i = 0; i < capacity; ++i) {
     std::vector<Blob*> blobs;
     blobs.reserve(numBlobs);
@@ -62,19 +70,14 @@ bool BlobsQueue::blockingRead(
   const auto& name = name_.c_str();
   CAFFE_SDT(queue_read_start, name, (void*)this, SDT_BLOCKING_OP);
   std::unique_lock<std::mutex> g(mutex_);
-  auto canRead = [this]() {
-    CAFFE_ENFORCE_LE(reader_, writer_);
-    return reader_ != writer_;
-  };
   // Decrease queue balance before reading to indicate queue read pressure
   // is being increased (-ve queue balance indicates more reads than writes)
   CAFFE_EVENT(stats_, queue_balance, -1);
   if (timeout_secs > 0) {
     std::chrono::milliseconds timeout_ms(int(timeout_secs * 1000));
-    cv_.wait_for(
-        g, timeout_ms, [this, canRead]() { return closing_ || canRead(); });
+    cv_.wait_for(g, timeout_ms, [this]() { return closing_ || canRead(); });
   } else {
-    cv_.wait(g, [this, canRead]() { return closing_ || canRead(); });
+    cv_.wait(g, [this]() { return closing_ || canRead(); });
   }
   if (!canRead()) {
     if (timeout_secs > 0 && !closing_) {
@@ -86,22 +89,53 @@ bool BlobsQueue::blockingRead(
     return false;
   }
   DCHECK(canRead());
-  auto& result = queue_[reader_ % queue_.size()];
-  CAFFE_ENFORCE(inputs.size() >= result.size());
-  for (auto i = 0; i < result.size(); ++i) {
-    auto bytes = BlobStat::sizeBytes(*result[i]);
-    CAFFE_EVENT(stats_, queue_dequeued_bytes, bytes, i);
-    using std::swap;
-    swap(*(inputs[i]), *(result[i]));
-  }
+  doRead(inputs);
   CAFFE_SDT(queue_read_end, name, (void*)this, writer_ - reader_);
-  CAFFE_EVENT(stats_, queue_dequeued_records);
-  ++reader_;
   cv_.notify_all();
   CAFFE_EVENT(stats_, read_time_ns, readTimer.NanoSeconds());
   return true;
 }
 
+size_t BlobsQueue::blockingReadMany(
+    const std::vector<std::vector<Blob*>>& records,
+    float timeout_secs) {
+  Timer readTimer;
+  auto keeper = this->shared_from_this();
+  const auto& name = name_.c_str();
+  CAFFE_SDT(queue_read_start, name, (void*)this, SDT_BLOCKING_OP);
+  std::unique_lock<std::mutex> g(mutex_);
+  CAFFE_EVENT(stats_, queue_balance, -static_cast<int64_t>(records.size()));
+  auto deadline = std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(int(timeout_secs * 1000));
+  size_t read = 0;
+  while (read < records.size()) {
+    if (timeout_secs > 0) {
+      cv_.wait_until(g, deadline, [this]() { return closing_ || canRead(); });
+    } else {
+      cv_.wait(g, [this]() { return closing_ || canRead(); });
+    }
+    if (!canRead()) {
+      break;
+    }
+    while (read < records.size() && canRead()) {
+      doRead(records[read++]);
+    }
+    cv_.notify_all();
+  }
+  if (read < records.size()) {
+    if (timeout_secs > 0 && !closing_) {
+      LOG(ERROR) << "DequeueBlobs timed out in " << timeout_secs << " secs";
+      CAFFE_SDT(queue_read_end, name, (void*)this, SDT_TIMEOUT);
+    } else {
+      CAFFE_SDT(queue_read_end, name, (void*)this, SDT_CANCEL);
+    }
+  } else {
+    CAFFE_SDT(queue_read_end, name, (void*)this, writer_ - reader_);
+  }
+  CAFFE_EVENT(stats_, read_time_ns, readTimer.NanoSeconds());
+  return read;
+}
+
 bool BlobsQueue::tryWrite(const std::vector<Blob*>& inputs) {
   Timer writeTimer;
   auto keeper = this->shared_from_this();
@@ -141,13 +175,43 @@ bool BlobsQueue::blockingWrite(const std::vector<Blob*>& inputs) {
   return true;
 }
 
+bool BlobsQueue::blockingWriteMany(
+    const std::vector<std::vector<Blob*>>& records) {
+  Timer writeTimer;
+  auto keeper = this->shared_from_this();
+  const auto& name = name_.c_str();
+  CAFFE_SDT(queue_write_start, name, (void*)this, SDT_BLOCKING_OP);
+  std::unique_lock<std::mutex> g(mutex_);
+  CAFFE_EVENT(stats_, queue_balance, static_cast<int64_t>(records.size()));
+  size_t written = 0;
+  while (written < records.size()) {
+    cv_.wait(g, [this]() { return closing_ || canWrite(); });
+    if (!canWrite()) {
+      CAFFE_SDT(queue_write_end, name, (void*)this, SDT_ABORT);
+      return false;
+    }
+    while (written < records.size() && canWrite()) {
+      doWrite(records[written++]);
+    }
+  }
+  CAFFE_EVENT(stats_, write_time_ns, writeTimer.NanoSeconds());
+  return true;
+}
+
 void BlobsQueue::close() {
   closing_ = true;
+  const auto& name = name_.c_str();
+  CAFFE_SDT(queue_close, name, (void*)this);
 
   std::lock_guard<std::mutex> g(mutex_);
   cv_.notify_all();
 }
 
+bool BlobsQueue::canRead() {
+  CAFFE_ENFORCE_LE(reader_, writer_);
+  return reader_ != writer_;
+}
+
 bool BlobsQueue::canWrite() {
   // writer is always within [reader, reader + size)
   // we can write if reader is within [reader, reader + size)
@@ -156,14 +220,32 @@ bool BlobsQueue::canWrite() {
   return writer_ != reader_ + queue_.size();
 }
 
+void BlobsQueue::doRead(const std::vector<Blob*>& inputs) {
+  auto slot = reader_ % queue_.size();
+  auto& result = queue_[slot];
+  CAFFE_ENFORCE(inputs.size() >= result.size());
+  CAFFE_EVENT(stats_, queue_occupancy, writer_ - reader_);
+  for (auto i = 0; i < result.size(); ++i) {
+    auto bytes = BlobStat::sizeBytes(*result[i]);
+    CAFFE_EVENT(stats_, queue_dequeued_bytes, bytes, i);
+    using std::swap;
+    swap(*(inputs[i]), *(result[i]));
+  }
+  CAFFE_EVENT(stats_, queue_latency_ns, nowNs() - writeTimeNs_[slot]);
+  CAFFE_EVENT(stats_, queue_dequeued_records);
+  ++reader_;
+}
+
 void BlobsQueue::doWrite(const std::vector<Blob*>& inputs) {
-  auto& result = queue_[writer_ % queue_.size()];
+  auto slot = writer_ % queue_.size();
+  auto& result = queue_[slot];
   CAFFE_ENFORCE(inputs.size() >= result.size());
   const auto& name = name_.c_str();
   for (auto i = 0; i < result.size(); ++i) {
     using std::swap;
     swap(*(inputs[i]), *(result[i]));
   }
+  writeTimeNs_[slot] = nowNs();
   CAFFE_SDT(
       queue_write_end, name, (void*)this, reader_ + queue_.size() - writer_);
   ++writer_;
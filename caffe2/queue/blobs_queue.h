@@ -37,15 +37,28 @@ class BlobsQueue : public std::enable_shared_from_this<BlobsQueue> {
   bool blockingRead(
       const std::vector<Blob*>& inputs,
       float timeout_secs = 0.0f);
+  // Reads up to records.size() records, taking all the records available
+  // under a single lock acquisition every time it wakes up. Blocks until all
+  // of them are read, the queue is closed or the timeout expires, and returns
+  // the number of records read.
+  size_t blockingReadMany(
+      const std::vector<std::vector<Blob*>>& records,
+      float timeout_secs = 0.0f);
   bool tryWrite(const std::vector<Blob*>& inputs);
   bool blockingWrite(const std::vector<Blob*>& inputs);
+  // Writes all the records, as many as there is room for under a single lock
+  // acquisition every time it wakes up. Returns false if the queue is closed
+  // before all of them are written.
+  bool blockingWriteMany(const std::vector<std::vector<Blob*>>& records);
   void close();
   size_t getNumBlobs() const {
     return numBlobs_;
   }
 
  private:
+  bool canRead();
   bool canWrite();
+  void doRead(const std::vector<Blob*>& inputs);
   void doWrite(const std::vector<Blob*>& inputs);
 
   std::atomic<bool> closing_{false};
@@ -56,6 +69,8 @@ class BlobsQueue : public std::enable_shared_from_this<BlobsQueue> {
   int64_t reader_{0};
   int64_t writer_{0};
   std::vector<std::vector<Blob*>> queue_;
+  // when each slot was written, for queue_latency_ns
+  std::vector<int64_t> writeTimeNs_;
   const std::string name_;
 
   struct QueueStats {
@@ -65,6 +80,10 @@ class BlobsQueue : public std::enable_shared_from_this<BlobsQueue> {
     CAFFE_DETAILED_EXPORTED_STAT(queue_dequeued_bytes);
     CAFFE_AVG_EXPORTED_STAT(read_time_ns);
     CAFFE_AVG_EXPORTED_STAT(write_time_ns);
+    // records in the queue, sampled on every read
+    CAFFE_AVG_EXPORTED_STAT(queue_occupancy);
+    // time records spend in the queue
+    CAFFE_AVG_EXPORTED_STAT(queue_latency_ns);
   } stats_;
 };
 } // namespace caffe2
@@ -34,6 +34,25 @@ OPERATOR_SCHEMA(DequeueBlobs)
     .Input(0, "queue", "The shared pointer for the BlobsQueue")
     .Output(0, "blob", "The blob to store the dequeued data");
 
+OPERATOR_SCHEMA(PrefetchDequeueBlobs)
+    .NumInputsOutputs([](int inputs, int outputs) {
+      return inputs == 1 && outputs >= 1;
+    })
+    .SetDoc(R"DOC(
+Dequeue CPU tensors from the queue into tensors on the GPU of the operator.
+The next record is dequeued and copied to the GPU on a background thread with
+a CUDA stream of its own, through pinned buffers, while the current iteration
+runs, so that the transfer of the inputs overlaps the computation. The
+outputs are valid until the next run of the operator. CUDA only.
+)DOC")
+    .Arg("timeout_secs", "Timeout in secs, default: no timeout")
+    .Arg(
+        "no_prefetch",
+        "(bool, default false) dequeue and copy when the operator runs "
+        "instead of ahead of time")
+    .Input(0, "queue", "The shared pointer for the BlobsQueue")
+    .Output(0, "blob", "The blob on the GPU to store the dequeued data");
+
 OPERATOR_SCHEMA(CloseBlobsQueue).NumInputs(1).NumOutputs(0);
 
 OPERATOR_SCHEMA(SafeEnqueueBlobs)
@@ -90,6 +109,7 @@ data blobs.
 NO_GRADIENT(CreateBlobsQueue);
 NO_GRADIENT(EnqueueBlobs);
 NO_GRADIENT(DequeueBlobs);
+NO_GRADIENT(PrefetchDequeueBlobs);
 NO_GRADIENT(CloseBlobsQueue);
 
 NO_GRADIENT(SafeEnqueueBlobs);
@@ -130,23 +130,24 @@ class SafeDequeueBlobsOp final : public Operator<Context> {
   bool dequeueMany(std::shared_ptr<BlobsQueue>& queue) {
     auto size = queue->getNumBlobs();
 
-    if (blobs_.size() != size) {
-      blobs_.resize(size);
-      blobPtrs_.resize(size);
-      for (int col = 0; col < size; ++col) {
-        blobPtrs_.at(col) = &blobs_.at(col);
+    if (blobs_.size() != numRecords_ * size) {
+      blobs_.resize(numRecords_ * size);
+      records_.assign(numRecords_, std::vector<Blob*>(size));
+      for (int i = 0; i < numRecords_; ++i) {
+        for (int col = 0; col < size; ++col) {
+          records_[i][col] = &blobs_.at(i * size + col);
+        }
       }
     }
 
+    // The records are swapped out of the queue, all the available ones under
+    // one lock acquisition, and only copied into the outputs afterwards.
+    auto numRead = queue->blockingReadMany(records_);
     const int kTensorGrowthPct = 40;
-    for (int i = 0; i < numRecords_; ++i) {
-      if (!queue->blockingRead(blobPtrs_)) {
-        // if we read at least one record, status is still true
-        return i > 0;
-      }
+    for (int i = 0; i < numRead; ++i) {
       for (int col = 0; col < size; ++col) {
         auto* out = this->Output(col);
-        const auto& in = blobPtrs_.at(col)->template Get<Tensor<Context>>();
+        const auto& in = records_[i][col]->template Get<Tensor<Context>>();
         if (i == 0) {
           out->CopyFrom(in);
         } else {
@@ -168,7 +169,8 @@ class SafeDequeueBlobsOp final : public Operator<Context> {
         }
       }
     }
-    return true;
+    // if we read at least one record, status is still true
+    return numRead > 0;
   }
 
   bool dequeueOne(std::shared_ptr<BlobsQueue>& queue) {
@@ -195,7 +197,7 @@ class SafeDequeueBlobsOp final : public Operator<Context> {
  private:
   int numRecords_;
   std::vector<Blob> blobs_;
-  std::vector<Blob*> blobPtrs_;
+  std::vector<std::vector<Blob*>> records_;
 };
 
 template <typename Context>
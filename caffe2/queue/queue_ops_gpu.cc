@@ -1,10 +1,95 @@
+#include <cstring>
+
 #include "caffe2/utils/math.h"
 #include "queue_ops.h"
 
 #include "caffe2/core/context_gpu.h"
+#include "caffe2/operators/prefetch_op.h"
 
 namespace caffe2 {
 
+namespace {
+
+// Dequeues CPU tensors from a BlobsQueue and copies them to the GPU of the
+// operator on the prefetching thread, whose CUDA stream is its own, so that
+// the next batch is transferred while the current iteration computes. The
+// records are staged in pinned buffers so that the copies of all columns are
+// asynchronous and overlap the staging of the columns after them. The
+// outputs are swapped with the buffers the batch was copied into, which
+// makes the two of them a double buffer: the outputs are valid until the
+// next run.
+class PrefetchDequeueBlobsOp final : public PrefetchOperator<CUDAContext> {
+ public:
+  PrefetchDequeueBlobsOp(const OperatorDef& operator_def, Workspace* ws)
+      : PrefetchOperator<CUDAContext>(operator_def, ws),
+        timeout_secs_(GetSingleArgument<float>("timeout_secs", 0)),
+        records_(OutputSize()),
+        staging_(OutputSize()),
+        device_(OutputSize()) {
+    CAFFE_ENFORCE_EQ(InputSize(), 1);
+    for (auto& record : records_) {
+      record_ptrs_.push_back(&record);
+    }
+  }
+
+  ~PrefetchDequeueBlobsOp() {
+    PrefetchOperator<CUDAContext>::Finalize();
+  }
+
+  bool Prefetch() override {
+    auto queue = Inputs()[0]->Get<std::shared_ptr<BlobsQueue>>();
+    CAFFE_ENFORCE(queue && OutputSize() == queue->getNumBlobs());
+    if (!queue->blockingRead(record_ptrs_, timeout_secs_)) {
+      return false;
+    }
+    for (int i = 0; i < OutputSize(); ++i) {
+      CAFFE_ENFORCE(
+          records_[i].IsType<TensorCPU>(),
+          "PrefetchDequeueBlobs expects CPU tensors in the queue, got ",
+          records_[i].TypeName());
+      const auto& in = records_[i].Get<TensorCPU>();
+      auto& staging = staging_[i];
+      if (staging.capacity < in.nbytes()) {
+        auto ptr_and_deleter = pinned_allocator_.New(in.nbytes());
+        staging.data = std::unique_ptr<void, MemoryDeleter>(
+            ptr_and_deleter.first, ptr_and_deleter.second);
+        staging.capacity = in.nbytes();
+      }
+      // the copies of the columns before this one are running meanwhile
+      memcpy(staging.data.get(), in.raw_data(), in.nbytes());
+      device_[i].Resize(in.dims());
+      context_.CopyBytes<CPUContext, CUDAContext>(
+          in.nbytes(),
+          staging.data.get(),
+          device_[i].raw_mutable_data(in.meta()));
+    }
+    // PrefetchOperator waits for the copies before the batch is handed out
+    return true;
+  }
+
+  bool CopyPrefetched() override {
+    for (int i = 0; i < OutputSize(); ++i) {
+      Output<TensorCUDA>(i)->swap(device_[i]);
+    }
+    return true;
+  }
+
+ private:
+  struct PinnedBuffer {
+    std::unique_ptr<void, MemoryDeleter> data{nullptr, nullptr};
+    size_t capacity = 0;
+  };
+
+  float timeout_secs_;
+  std::vector<Blob> records_;
+  std::vector<Blob*> record_ptrs_;
+  PinnedCPUAllocator pinned_allocator_;
+  std::vector<PinnedBuffer> staging_;
+  std::vector<TensorCUDA> device_;
+};
+
+} // namespace
+
 REGISTER_CUDA_OPERATOR(CreateBlobsQueue, CreateBlobsQueueOp<CUDAContext>);
 REGISTER_CUDA_OPERATOR(EnqueueBlobs, EnqueueBlobsOp<CUDAContext>);
 REGISTER_CUDA_OPERATOR(DequeueBlobs, DequeueBlobsOp<CUDAContext>);
@@ -13,4 +98,6 @@ REGISTER_CUDA_OPERATOR(CloseBlobsQueue, CloseBlobsQueueOp<CUDAContext>);
 REGISTER_CUDA_OPERATOR(SafeEnqueueBlobs, SafeEnqueueBlobsOp<CUDAContext>);
 REGISTER_CUDA_OPERATOR(SafeDequeueBlobs, SafeDequeueBlobsOp<CUDAContext>);
 
+REGISTER_CUDA_OPERATOR(PrefetchDequeueBlobs, PrefetchDequeueBlobsOp);
+
 }
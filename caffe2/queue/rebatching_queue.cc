@@ -97,8 +97,22 @@ std::vector<std::vector<TensorCPU>> split(
 }
 } // anonymous namespace
 
-RebatchingQueue::RebatchingQueue(size_t capacity, size_t numBlobs)
-    : capacity_(capacity), numBlobs_(numBlobs), queue_(capacity) {}
+RebatchingQueue::RebatchingQueue(
+    size_t capacity,
+    size_t numBlobs,
+    size_t batchSize)
+    : capacity_(capacity),
+      numBlobs_(numBlobs),
+      queue_(batchSize > 0 ? 0 : capacity),
+      batchSize_(batchSize) {
+  if (batchSize_ > 0) {
+    const auto numBatches = std::max<size_t>(2, capacity_ / batchSize_);
+    for (size_t i = 0; i < numBatches; ++i) {
+      freeBatches_.emplace_back(new Batch());
+      freeBatches_.back()->tensors.resize(numBlobs_);
+    }
+  }
+}
 
 RebatchingQueue::~RebatchingQueue() {
   close();
@@ -112,6 +126,9 @@ bool RebatchingQueue::dequeue(
     CPUContext& context,
     size_t numElements,
     const std::vector<TensorCPU*>& outputs) {
+  if (batchSize_ > 0) {
+    return dequeueBatch(numElements, outputs);
+  }
   std::vector<std::vector<TensorCPU>> results;
   results.reserve(numElements);
 
@@ -156,8 +173,11 @@ bool RebatchingQueue::canWrite() const {
 }
 
 bool RebatchingQueue::enqueueOne(
-    CPUContext& /*context*/,
+    CPUContext& context,
     const std::vector<const TensorCPU*>& inputs) {
+  if (batchSize_ > 0) {
+    return streamRows(context, inputs, false);
+  }
   std::vector<std::vector<TensorCPU>> splittedInputs;
   splittedInputs.emplace_back();
   auto& tensorVector = splittedInputs.back();
@@ -173,6 +193,9 @@ bool RebatchingQueue::enqueueMany(
     CPUContext& context,
     const std::vector<const TensorCPU*>& inputs) {
   CAFFE_ENFORCE_EQ(numBlobs_, inputs.size());
+  if (batchSize_ > 0) {
+    return streamRows(context, inputs, true);
+  }
 
   std::vector<std::vector<TensorCPU>> splittedInputs;
   splittedInputs = split(context, inputs);
@@ -209,6 +232,155 @@ bool RebatchingQueue::enqueue(
   return true;
 }
 
+void RebatchingQueue::openBatch(
+    Batch* batch,
+    const std::vector<const TensorCPU*>& inputs,
+    bool hasBatchDim) {
+  batch->data.resize(numBlobs_);
+  batch->rowItems.resize(numBlobs_);
+  for (int j = 0; j < numBlobs_; ++j) {
+    auto dims = inputs[j]->dims();
+    if (hasBatchDim) {
+      CAFFE_ENFORCE(!dims.empty());
+      dims[0] = batchSize_;
+    } else {
+      dims.insert(dims.begin(), batchSize_);
+    }
+    // a no-op once the batch holds storage from an earlier dequeue
+    batch->tensors[j].Resize(dims);
+    batch->data[j] =
+        (char*)batch->tensors[j].raw_mutable_data(inputs[j]->meta());
+    batch->rowItems[j] = batch->tensors[j].size_from_dim(1);
+  }
+  batch->reserved = 0;
+  batch->committed = 0;
+}
+
+bool RebatchingQueue::streamRows(
+    CPUContext& context,
+    const std::vector<const TensorCPU*>& inputs,
+    bool hasBatchDim) {
+  CAFFE_ENFORCE_EQ(numBlobs_, inputs.size());
+  TIndex numRows = 1;
+  if (hasBatchDim) {
+    CAFFE_ENFORCE(!inputs.empty() && inputs[0]->ndim() > 0);
+    numRows = inputs[0]->dim(0);
+  }
+
+  TIndex row = 0;
+  while (row < numRows) {
+    Batch* batch;
+    size_t begin;
+    size_t count;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cvOverflow_.wait(lock, [this] {
+        return isClosed_ || filling_ || !freeBatches_.empty();
+      });
+      if (isClosed_) {
+        return false;
+      }
+      if (!filling_) {
+        filling_ = std::move(freeBatches_.back());
+        freeBatches_.pop_back();
+        openBatch(filling_.get(), inputs, hasBatchDim);
+      }
+      batch = filling_.get();
+      for (int j = 0; j < numBlobs_; ++j) {
+        const auto& input = *inputs[j];
+        const auto& tensor = batch->tensors[j];
+        CAFFE_ENFORCE(input.meta() == tensor.meta());
+        CAFFE_ENFORCE_EQ(input.ndim() + (hasBatchDim ? 0 : 1), tensor.ndim());
+        for (int k = hasBatchDim ? 1 : 0; k < input.ndim(); ++k) {
+          CAFFE_ENFORCE_EQ(
+              input.dim(k), tensor.dim(k + (hasBatchDim ? 0 : 1)));
+        }
+        if (hasBatchDim) {
+          CAFFE_ENFORCE_EQ(input.dim(0), numRows);
+        }
+      }
+      begin = batch->reserved;
+      count = std::min<size_t>(batchSize_ - begin, numRows - row);
+      batch->reserved += count;
+      if (batch->reserved == batchSize_) {
+        pendingBatches_.push_back(std::move(filling_));
+      }
+    }
+
+    // Writers copy their rows without holding the lock
+    for (int j = 0; j < numBlobs_; ++j) {
+      const auto& input = *inputs[j];
+      const auto rowBytes = batch->rowItems[j] * input.itemsize();
+      context.CopyItems<CPUContext, CPUContext>(
+          input.meta(),
+          count * batch->rowItems[j],
+          (const char*)input.raw_data() + row * rowBytes /* src */,
+          batch->data[j] + begin * rowBytes /* dst */);
+    }
+    row += count;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      batch->committed += count;
+      while (!pendingBatches_.empty() &&
+             pendingBatches_.front()->committed == batchSize_) {
+        readyBatches_.push_back(std::move(pendingBatches_.front()));
+        pendingBatches_.pop_front();
+      }
+    }
+    cvEmpty_.notify_all();
+  }
+  return true;
+}
+
+bool RebatchingQueue::writesInFlight() const {
+  return !pendingBatches_.empty() ||
+      (filling_ && filling_->reserved != filling_->committed);
+}
+
+bool RebatchingQueue::dequeueBatch(
+    size_t numElements,
+    const std::vector<TensorCPU*>& outputs) {
+  CAFFE_ENFORCE_EQ(
+      numElements,
+      batchSize_,
+      "A streaming queue hands out batches of the size it was created with");
+  CAFFE_ENFORCE_EQ(outputs.size(), numBlobs_);
+  std::unique_ptr<Batch> batch;
+  size_t rows;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cvEmpty_.wait(lock, [this] {
+      return !readyBatches_.empty() || (isClosed_ && !writesInFlight());
+    });
+    if (!readyBatches_.empty()) {
+      batch = std::move(readyBatches_.front());
+      readyBatches_.pop_front();
+      rows = batchSize_;
+    } else if (filling_ && filling_->committed > 0) {
+      // The queue is closed, hand out what is left
+      batch = std::move(filling_);
+      rows = batch->committed;
+    } else {
+      return false;
+    }
+  }
+
+  for (int j = 0; j < numBlobs_; ++j) {
+    outputs[j]->swap(batch->tensors[j]);
+    if (rows < batchSize_) {
+      outputs[j]->Shrink(rows);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    freeBatches_.push_back(std::move(batch));
+  }
+  cvOverflow_.notify_all();
+  return true;
+}
+
 size_t RebatchingQueue::capacity() const {
   return capacity_;
 }
@@ -217,6 +389,10 @@ size_t RebatchingQueue::numBlobs() const {
   return numBlobs_;
 }
 
+size_t RebatchingQueue::batchSize() const {
+  return batchSize_;
+}
+
 bool RebatchingQueue::isClosed() const {
   std::lock_guard<std::mutex> g(mutex_);
   return isClosed_;
@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -17,9 +18,17 @@ namespace caffe2 {
 // atomic index + circular queue optimizations or pull something more
 // heavy-weight later
 
+// With a positive batchSize the queue runs in streaming mode: enqueued rows
+// are copied straight into preallocated batches of batchSize rows, and
+// dequeue hands out complete batches by swapping them into the outputs, whose
+// previous storage goes back to the queue to be filled again. There are at
+// least two batches (one being filled while the other is handed out), so that
+// in a steady state nothing is allocated and every row is copied once. This
+// means that a dequeued batch must not be aliased past the next dequeue into
+// the same outputs.
 class RebatchingQueue {
  public:
-  RebatchingQueue(size_t capacity, size_t numBlobs);
+  RebatchingQueue(size_t capacity, size_t numBlobs, size_t batchSize = 0);
 
   ~RebatchingQueue();
 
@@ -40,6 +49,8 @@ class RebatchingQueue {
 
   size_t numBlobs() const;
 
+  size_t batchSize() const;
+
   bool isClosed() const;
 
   void close();
@@ -50,6 +61,27 @@ class RebatchingQueue {
   bool canWrite() const;
   bool canRead() const;
 
+  struct Batch {
+    std::vector<TensorCPU> tensors;
+    // start of the data and items per row of every tensor
+    std::vector<char*> data;
+    std::vector<TIndex> rowItems;
+    // rows handed out to writers and rows they finished copying
+    size_t reserved{0};
+    size_t committed{0};
+  };
+
+  bool streamRows(
+      CPUContext& context,
+      const std::vector<const TensorCPU*>& inputs,
+      bool hasBatchDim);
+  void openBatch(
+      Batch* batch,
+      const std::vector<const TensorCPU*>& inputs,
+      bool hasBatchDim);
+  bool dequeueBatch(size_t numElements, const std::vector<TensorCPU*>& outputs);
+  bool writesInFlight() const;
+
   const size_t capacity_;
   const size_t numBlobs_;
 
@@ -64,5 +96,14 @@ class RebatchingQueue {
   std::condition_variable cvOverflow_;
 
   std::vector<std::vector<TensorCPU>> queue_;
+
+  // Streaming mode. Batches move from free to filling, where writers reserve
+  // rows, to pending once all of their rows are reserved, and to ready once
+  // all of them are written.
+  const size_t batchSize_;
+  std::vector<std::unique_ptr<Batch>> freeBatches_;
+  std::unique_ptr<Batch> filling_;
+  std::deque<std::unique_ptr<Batch>> pendingBatches_;
+  std::deque<std::unique_ptr<Batch>> readyBatches_;
 };
 } // caffe2
@@ -26,7 +26,13 @@ Creates the Queue.
     .Arg("num_blobs", "Number of input tensors the queue will support")
     .Arg(
         "capacity",
-        "Maximal number of elements the queue can hold at any given point");
+        "Maximal number of elements the queue can hold at any given point")
+    .Arg(
+        "batch_size",
+        "If positive, rows are copied into preallocated batches of this size "
+        "as they are enqueued, and dequeues (whose num_elements must match) "
+        "hand these batches out without another copy. The storage of the "
+        "previous output goes back to the queue on every dequeue.");
 
 OPERATOR_SCHEMA(CloseRebatchingQueue)
     .NumInputs(1)
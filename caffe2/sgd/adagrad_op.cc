@@ -1,7 +1,174 @@
 #include "adagrad_op.h"
 
+#include "caffe2/perfkernels/adagrad.h"
+#include "caffe2/utils/threadpool/ThreadPool.h"
+
 namespace caffe2 {
 
+namespace {
+
+// Checks the indices and runs update(positions, count) over all gradient
+// rows. When there are enough of them they are split into chunks by row
+// modulo the number of chunks, which run in parallel on the workspace thread
+// pool. Every row of the parameters is thus updated by one chunk only, once
+// per occurrence and in order, like the sequential update would.
+template <typename SIndex, typename Update>
+void RunSparseAdagrad(
+    Workspace* ws,
+    const SIndex* indices,
+    TIndex n,
+    TIndex num_rows,
+    int min_chunk_size,
+    int chunks_per_thread,
+    Update update) {
+  for (TIndex i = 0; i < n; ++i) {
+    CAFFE_ENFORCE(
+        0 <= indices[i] && indices[i] < num_rows,
+        "Index ",
+        i,
+        " is out of bounds: ",
+        indices[i],
+        ", range 0 to ",
+        num_rows);
+  }
+
+  auto* pool = ws->GetThreadPool();
+  const TIndex num_chunks = std::min<TIndex>(
+      static_cast<TIndex>(pool->getNumThreads()) * chunks_per_thread,
+      n / std::max(min_chunk_size, 1));
+  if (num_chunks <= 1) {
+    update(nullptr, n);
+    return;
+  }
+
+  // Counting sort of the gradient rows by chunk, stable so that repeated
+  // rows keep their order
+  std::vector<int> offsets(num_chunks + 1, 0);
+  for (TIndex i = 0; i < n; ++i) {
+    ++offsets[indices[i] % num_chunks + 1];
+  }
+  for (TIndex c = 0; c < num_chunks; ++c) {
+    offsets[c + 1] += offsets[c];
+  }
+  std::vector<int> positions(n);
+  std::vector<int> next(offsets.begin(), offsets.end() - 1);
+  for (TIndex i = 0; i < n; ++i) {
+    positions[next[indices[i] % num_chunks]++] = i;
+  }
+
+  pool->run(
+      [&](int /* unused */, size_t c) {
+        update(positions.data() + offsets[c], offsets[c + 1] - offsets[c]);
+      },
+      num_chunks);
+}
+
+} // namespace
+
+template <>
+template <typename SIndex>
+bool SparseAdagradOp<float, CPUContext>::DoRunWithType() {
+  const auto n = Input(INDICES).size();
+  if (n == 0) {
+    return true;
+  }
+  const auto block_size = Input(GRAD).size() / n;
+  const auto* indices = Input(INDICES).template data<SIndex>();
+  const auto* grad = Input(GRAD).template data<float>();
+  const float lr = Input(LR).template data<float>()[0];
+  auto* param = Output(OUTPUT_PARAM)->template mutable_data<float>();
+  auto* moment = Output(OUTPUT_MOMENT_1)->template mutable_data<float>();
+  RunSparseAdagrad(
+      ws_,
+      indices,
+      n,
+      Input(PARAM).size() / block_size,
+      min_chunk_size_,
+      chunks_per_thread_,
+      [&](const int* positions, TIndex count) {
+        SparseAdagradUpdate<SIndex>(
+            block_size,
+            count,
+            positions,
+            indices,
+            grad,
+            param,
+            moment,
+            epsilon_,
+            lr);
+      });
+  return true;
+}
+
+template <>
+template <typename SIndex>
+bool RowWiseSparseAdagradOp<float, CPUContext>::DoRunWithType() {
+  const auto n = Input(INDICES).size();
+  if (n == 0) {
+    return true;
+  }
+  const auto block_size = Input(GRAD).size() / n;
+  const auto* indices = Input(INDICES).template data<SIndex>();
+  const auto* grad = Input(GRAD).template data<float>();
+  const float lr = Input(LR).template data<float>()[0];
+  auto* param = Output(OUTPUT_PARAM)->template mutable_data<float>();
+  auto* moment = Output(OUTPUT_MOMENT_1)->template mutable_data<float>();
+  RunSparseAdagrad(
+      ws_,
+      indices,
+      n,
+      Input(PARAM).dim(0),
+      min_chunk_size_,
+      chunks_per_thread_,
+      [&](const int* positions, TIndex count) {
+        RowWiseSparseAdagradUpdate<SIndex>(
+            block_size,
+            count,
+            positions,
+            indices,
+            grad,
+            param,
+            moment,
+            epsilon_,
+            lr);
+      });
+  return true;
+}
+
+template <typename SIndex>
+bool SparseAdagradFused8BitRowwiseMomentOp::DoRunWithType() {
+  const auto n = Input(INDICES).size();
+  if (n == 0) {
+    return true;
+  }
+  const auto block_size = Input(GRAD).size() / n;
+  const auto* indices = Input(INDICES).template data<SIndex>();
+  const auto* grad = Input(GRAD).template data<float>();
+  const float lr = Input(LR).template data<float>()[0];
+  auto* param = Output(OUTPUT_PARAM)->template mutable_data<float>();
+  auto* moment = Output(OUTPUT_MOMENT_1)->template mutable_data<uint8_t>();
+  RunSparseAdagrad(
+      ws_,
+      indices,
+      n,
+      Input(PARAM).dim(0),
+      min_chunk_size_,
+      chunks_per_thread_,
+      [&](const int* positions, TIndex count) {
+        SparseAdagradFused8BitRowwiseMomentUpdate<SIndex>(
+            block_size,
+            count,
+            positions,
+            indices,
+            grad,
+            param,
+            moment,
+            epsilon_,
+            lr);
+      });
+  return true;
+}
+
 REGISTER_CPU_OPERATOR(Adagrad, AdagradOp<float, CPUContext>);
 OPERATOR_SCHEMA(Adagrad)
     .NumInputs(4)
@@ -42,6 +209,10 @@ Given inputs (param, moment, indices, grad, lr), runs the dense AdaGrad
 update on (param, grad, moment[indices], lr), and returns (new_param,
 new_moment) as in the dense case.
 
+On CPU, when there are at least 2 * min_chunk_size indices, disjoint sets of
+rows are updated in parallel on the workspace thread pool. Repeated indices
+are applied one after the other, as in the sequential update.
+
 )DOC")
     .Input(0, "param", "Parameters to be updated")
     .Input(1, "moment", "Moment history")
@@ -50,7 +221,13 @@ new_moment) as in the dense case.
     .Input(4, "lr", "learning rate")
     .Output(0, "output_param", "Updated parameters")
     .Output(1, "output_moment_1", "Updated moment")
-    .Arg("epsilon", "Default 1e-5");
+    .Arg("epsilon", "Default 1e-5")
+    .Arg(
+        "min_chunk_size",
+        "Minimum number of indices updated by one task (default 1024)")
+    .Arg(
+        "chunks_per_thread",
+        "Number of chunks the work is cut into per pool thread (default 4)");
 
 REGISTER_CPU_OPERATOR(
     RowWiseSparseAdagrad,
@@ -69,6 +246,9 @@ applied to an entire row of param, and the new moment is calculated by adding
 the average squared sum of gradients across each row. Note that indices must
 also be a 1D tensor indexing into the rows of param.
 
+On CPU, large updates run in parallel over disjoint sets of rows, as in
+SparseAdagrad.
+
 )DOC")
     .Input(0, "param", "Parameters to be updated")
     .Input(1, "moment", "Moment history")
@@ -77,9 +257,48 @@ also be a 1D tensor indexing into the rows of param.
     .Input(4, "lr", "learning rate")
     .Output(0, "output_param", "Updated parameters")
     .Output(1, "output_moment_1", "Updated moment")
-    .Arg("epsilon", "Default 1e-5");
+    .Arg("epsilon", "Default 1e-5")
+    .Arg(
+        "min_chunk_size",
+        "Minimum number of indices updated by one task (default 1024)")
+    .Arg(
+        "chunks_per_thread",
+        "Number of chunks the work is cut into per pool thread (default 4)");
+
+REGISTER_CPU_OPERATOR(
+    SparseAdagradFused8BitRowwiseMoment,
+    SparseAdagradFused8BitRowwiseMomentOp);
+OPERATOR_SCHEMA(SparseAdagradFused8BitRowwiseMoment)
+    .NumInputs(5)
+    .NumOutputs(2)
+    .EnforceOneToOneInplace()
+    .SetDoc(R"DOC(
+
+Runs the update of SparseAdagrad with the moment history quantized rowwise to
+8 bits, which takes a quarter of the memory of a float moment. The moment is
+in the format of FloatToFused8BitRowwiseQuantized: every row holds the 8 bit
+values of a row of param followed by a float scale and a float bias. Every
+updated row is de-quantized, updated and quantized again to its new range.
+Rows that were never updated can be all zeros.
+
+)DOC")
+    .Input(0, "param", "Parameters to be updated")
+    .Input(1, "moment", "Fused 8 bit rowwise quantized moment history")
+    .Input(2, "indices", "Sparse indices")
+    .Input(3, "grad", "Gradient computed")
+    .Input(4, "lr", "learning rate")
+    .Output(0, "output_param", "Updated parameters")
+    .Output(1, "output_moment_1", "Updated moment")
+    .Arg("epsilon", "Default 1e-5")
+    .Arg(
+        "min_chunk_size",
+        "Minimum number of indices updated by one task (default 1024)")
+    .Arg(
+        "chunks_per_thread",
+        "Number of chunks the work is cut into per pool thread (default 4)");
 
 SHOULD_NOT_DO_GRADIENT(Adagrad);
 SHOULD_NOT_DO_GRADIENT(SparseAdagrad);
 SHOULD_NOT_DO_GRADIENT(RowWiseSparseAdagrad);
+SHOULD_NOT_DO_GRADIENT(SparseAdagradFused8BitRowwiseMoment);
 }
@@ -64,7 +64,12 @@ class SparseAdagradOp final : public Operator<Context> {
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   SparseAdagradOp(const OperatorDef& operator_def, Workspace* ws)
       : Operator<Context>(operator_def, ws),
-        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)) {}
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)),
+        ws_(ws),
+        min_chunk_size_(
+            OperatorBase::GetSingleArgument<int>("min_chunk_size", 1024)),
+        chunks_per_thread_(
+            OperatorBase::GetSingleArgument<int>("chunks_per_thread", 4)) {}
 
   bool RunOnDevice() override {
     // Enforce shapes
@@ -142,6 +147,11 @@ class SparseAdagradOp final : public Operator<Context> {
 
  protected:
   T epsilon_;
+  // The CPU ops update disjoint sets of rows in parallel on the workspace
+  // thread pool, in chunks of at least min_chunk_size_ indices.
+  Workspace* ws_;
+  int min_chunk_size_;
+  int chunks_per_thread_;
   INPUT_TAGS(PARAM, MOMENT_1, INDICES, GRAD, LR);
   OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1);
 };
@@ -152,7 +162,12 @@ class RowWiseSparseAdagradOp final : public Operator<Context> {
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   RowWiseSparseAdagradOp(const OperatorDef& operator_def, Workspace* ws)
       : Operator<Context>(operator_def, ws),
-        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)) {}
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)),
+        ws_(ws),
+        min_chunk_size_(
+            OperatorBase::GetSingleArgument<int>("min_chunk_size", 1024)),
+        chunks_per_thread_(
+            OperatorBase::GetSingleArgument<int>("chunks_per_thread", 4)) {}
 
   bool RunOnDevice() override {
     // Enforce shapes
@@ -236,6 +251,58 @@ class RowWiseSparseAdagradOp final : public Operator<Context> {
 
  protected:
   T epsilon_;
+  // The CPU ops update disjoint sets of rows in parallel on the workspace
+  // thread pool, in chunks of at least min_chunk_size_ indices.
+  Workspace* ws_;
+  int min_chunk_size_;
+  int chunks_per_thread_;
+  INPUT_TAGS(PARAM, MOMENT_1, INDICES, GRAD, LR);
+  OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1);
+};
+
+// SparseAdagrad with the moment quantized rowwise to 8 bits, in the fused
+// format of FloatToFused8BitRowwiseQuantized. CPU only.
+class SparseAdagradFused8BitRowwiseMomentOp final
+    : public Operator<CPUContext> {
+ public:
+  SparseAdagradFused8BitRowwiseMomentOp(
+      const OperatorDef& operator_def,
+      Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)),
+        ws_(ws),
+        min_chunk_size_(
+            OperatorBase::GetSingleArgument<int>("min_chunk_size", 1024)),
+        chunks_per_thread_(
+            OperatorBase::GetSingleArgument<int>("chunks_per_thread", 4)) {}
+
+  bool RunOnDevice() override {
+    // Enforce shapes
+    CAFFE_ENFORCE_EQ(Input(MOMENT_1).ndim(), 2);
+    CAFFE_ENFORCE_EQ(Input(PARAM).dim(0), Input(MOMENT_1).dim(0));
+    CAFFE_ENFORCE_EQ(
+        Input(PARAM).size_from_dim(1) + 8,
+        Input(MOMENT_1).dim(1),
+        "Every row of moment must hold a row of param and 8 bytes for its "
+        "scale and bias");
+    CAFFE_ENFORCE(Input(MOMENT_1).IsType<uint8_t>());
+    CAFFE_ENFORCE_EQ(Input(LR).size(), 1);
+    CAFFE_ENFORCE_EQ(
+        Input(PARAM).size_from_dim(1),
+        Input(GRAD).size_from_dim(Input(INDICES).ndim()));
+
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+        this, Input(INDICES));
+  }
+
+  template <typename SIndex>
+  bool DoRunWithType();
+
+ protected:
+  float epsilon_;
+  Workspace* ws_;
+  int min_chunk_size_;
+  int chunks_per_thread_;
   INPUT_TAGS(PARAM, MOMENT_1, INDICES, GRAD, LR);
   OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1);
 };
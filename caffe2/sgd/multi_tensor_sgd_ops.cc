@@ -0,0 +1,88 @@
+#include "multi_tensor_sgd_ops.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(
+    MultiTensorMomentumSGDUpdate,
+    MultiTensorMomentumSGDUpdateOp<CPUContext>);
+OPERATOR_SCHEMA(MultiTensorMomentumSGDUpdate)
+    .NumInputs([](int n) { return n > 1 && (n - 1) % 3 == 0; })
+    .NumInputsOutputs([](int in, int out) { return out == in - 1; })
+    .EnforceInplace(
+        MultiTensorMomentumSGDUpdateOp<CPUContext>::IsInplace)
+    .SetDoc(R"DOC(
+
+Performs the update of MomentumSGDUpdate on a list of parameters at once.
+Given inputs (lr, moment_0, param_0, grad_0, moment_1, param_1, grad_1, ...)
+it updates every (moment, param, grad) triple in place the way
+MomentumSGDUpdate(grad, moment, lr, param) would.
+
+On GPU the whole list is updated by a single kernel launch for every few
+dozen tensors, instead of one launch per tensor, which matters for models
+with many small parameters.
+)DOC")
+    .Arg("momentum", "Momentum hyperparameter.")
+    .Arg("nesterov", "(boolean) Whether to use Nesterov Accelerated Gradient.")
+    .Input(0, "lr", "Learning rate, shared by all tensors.")
+    .Input(1, "moment_0", "Momentum history of the first parameter.")
+    .Input(2, "param_0", "The first parameter.")
+    .Input(3, "grad_0", "Gradient of the first parameter.")
+    .Output(0, "moment_0", "Updated momentum history (in place).")
+    .Output(1, "param_0", "Updated parameter (in place).")
+    .Output(2, "grad_0", "Adjusted gradient (in place).");
+SHOULD_NOT_DO_GRADIENT(MultiTensorMomentumSGDUpdate);
+
+REGISTER_CPU_OPERATOR(MultiTensorAdagrad, MultiTensorAdagradOp<CPUContext>);
+OPERATOR_SCHEMA(MultiTensorAdagrad)
+    .NumInputs([](int n) { return n > 1 && (n - 1) % 3 == 0; })
+    .NumInputsOutputs(
+        [](int in, int out) { return out == (in - 1) / 3 * 2; })
+    .EnforceInplace(MultiTensorAdagradOp<CPUContext>::IsInplace)
+    .SetDoc(R"DOC(
+
+Performs the update of Adagrad on a list of parameters at once. Given inputs
+(lr, param_0, moment_0, grad_0, param_1, moment_1, grad_1, ...) it updates
+every (param, moment) pair in place the way Adagrad(param, moment, grad, lr)
+would. On GPU the whole list is updated by a single kernel launch for every
+few dozen tensors.
+)DOC")
+    .Arg("epsilon", "Default 1e-5")
+    .Arg("decay", "Default 1. If it is in (0, 1), the gradient square sum "
+         "is decayed by this factor.")
+    .Input(0, "lr", "Learning rate, shared by all tensors.")
+    .Input(1, "param_0", "The first parameter.")
+    .Input(2, "moment_0", "Moment history of the first parameter.")
+    .Input(3, "grad_0", "Gradient of the first parameter.")
+    .Output(0, "param_0", "Updated parameter (in place).")
+    .Output(1, "moment_0", "Updated moment (in place).");
+SHOULD_NOT_DO_GRADIENT(MultiTensorAdagrad);
+
+REGISTER_CPU_OPERATOR(MultiTensorAdam, MultiTensorAdamOp<CPUContext>);
+OPERATOR_SCHEMA(MultiTensorAdam)
+    .NumInputs([](int n) { return n > 2 && (n - 2) % 4 == 0; })
+    .NumInputsOutputs(
+        [](int in, int out) { return out == (in - 2) / 4 * 3; })
+    .EnforceInplace(MultiTensorAdamOp<CPUContext>::IsInplace)
+    .SetDoc(R"DOC(
+
+Performs the update of Adam on a list of parameters at once. Given inputs
+(lr, iter, param_0, moment_1_0, moment_2_0, grad_0, param_1, ...) it updates
+every (param, moment_1, moment_2) triple in place the way
+Adam(param, moment_1, moment_2, grad, lr, iter) would. On GPU the whole list
+is updated by a single kernel launch for every few dozen tensors.
+)DOC")
+    .Arg("beta1", "Default 0.9")
+    .Arg("beta2", "Default 0.999")
+    .Arg("epsilon", "Default 1e-5")
+    .Input(0, "lr", "Learning rate, shared by all tensors.")
+    .Input(1, "iter", "Iteration number, on the CPU.")
+    .Input(2, "param_0", "The first parameter.")
+    .Input(3, "moment_1_0", "First moment history of the first parameter.")
+    .Input(4, "moment_2_0", "Second moment history of the first parameter.")
+    .Input(5, "grad_0", "Gradient of the first parameter.")
+    .Output(0, "param_0", "Updated parameter (in place).")
+    .Output(1, "moment_1_0", "Updated first moment (in place).")
+    .Output(2, "moment_2_0", "Updated second moment (in place).");
+SHOULD_NOT_DO_GRADIENT(MultiTensorAdam);
+
+} // namespace caffe2
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+// The tensors a multi-tensor optimizer op updates. Tensor t has sizes[t]
+// elements, its gradient is at grad[t], and its Depth pieces of state
+// (parameter, moments, ...) at state[0][t] ... state[Depth - 1][t].
+template <int Depth>
+struct MultiTensorList {
+  std::vector<int> sizes;
+  std::vector<const float*> grad;
+  std::vector<float*> state[Depth];
+};
+
+// state: moment, param, output grad
+template <typename Context>
+void multi_tensor_momentum_sgd_update(
+    const MultiTensorList<3>& tensors,
+    const float* lr,
+    const float momentum,
+    const bool nesterov,
+    Context* /*context*/) {
+  const float LR = lr[0];
+  for (size_t t = 0; t < tensors.sizes.size(); ++t) {
+    const int N = tensors.sizes[t];
+    const float* g = tensors.grad[t];
+    float* m = tensors.state[0][t];
+    float* param = tensors.state[1][t];
+    float* ng = tensors.state[2][t];
+    // The branch is out of the loops so that they vectorize
+    if (!nesterov) {
+      for (auto i = 0; i < N; ++i) {
+        const float adjusted_gradient = LR * g[i] + momentum * m[i];
+        m[i] = adjusted_gradient;
+        ng[i] = adjusted_gradient;
+        param[i] -= adjusted_gradient;
+      }
+    } else {
+      for (auto i = 0; i < N; ++i) {
+        const float mi = m[i];
+        const float mi_new = momentum * mi + LR * g[i];
+        const float ngi = (1 + momentum) * mi_new - momentum * mi;
+        m[i] = mi_new;
+        ng[i] = ngi;
+        param[i] -= ngi;
+      }
+    }
+  }
+}
+
+// state: param, moment
+template <typename Context>
+void multi_tensor_adagrad_update(
+    const MultiTensorList<2>& tensors,
+    const float* lr,
+    float epsilon,
+    float decay,
+    Context* /*context*/) {
+  const float LR = lr[0];
+  for (size_t t = 0; t < tensors.sizes.size(); ++t) {
+    const int N = tensors.sizes[t];
+    const float* g = tensors.grad[t];
+    float* w = tensors.state[0][t];
+    float* h = tensors.state[1][t];
+    for (auto i = 0; i < N; ++i) {
+      const float gi = g[i];
+      const float hi = h[i] = decay * h[i] + gi * gi;
+      w[i] += LR * gi / (std::sqrt(hi) + epsilon);
+    }
+  }
+}
+
+// state: param, moment_1, moment_2
+template <typename Context>
+void multi_tensor_adam_update(
+    const MultiTensorList<3>& tensors,
+    const float* lr,
+    float beta1,
+    float beta2,
+    float eps_hat,
+    float correction,
+    Context* /*context*/) {
+  const float LR = lr[0];
+  for (size_t t = 0; t < tensors.sizes.size(); ++t) {
+    const int N = tensors.sizes[t];
+    const float* g = tensors.grad[t];
+    float* w = tensors.state[0][t];
+    float* m = tensors.state[1][t];
+    float* v = tensors.state[2][t];
+    for (auto i = 0; i < N; ++i) {
+      const float gi = g[i];
+      const float mi = m[i] = m[i] * beta1 + gi * (1 - beta1);
+      const float vi = v[i] = v[i] * beta2 + gi * gi * (1 - beta2);
+      w[i] += LR * correction * mi / (std::sqrt(vi) + eps_hat);
+    }
+  }
+}
+
+/*
+ * Base of the ops that update a list of tensors at once. Their inputs are
+ * NumShared inputs that all tensors share (learning rate, ...), followed by
+ * one group of GroupSize inputs per tensor. The first Depth inputs of a
+ * group are its state, which is updated in place: they are outputs
+ * Depth * k ... Depth * k + Depth - 1 of group k. The last input of a group
+ * is its gradient.
+ */
+template <int NumShared, int GroupSize, int Depth, class Context>
+class MultiTensorSGDOpBase : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  MultiTensorSGDOpBase(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws) {}
+
+  static bool IsInplace(int in, int out) {
+    const int group = (in - NumShared) / GroupSize;
+    const int offset = (in - NumShared) % GroupSize;
+    return in >= NumShared && offset < Depth && out == group * Depth + offset;
+  }
+
+ protected:
+  int NumTensors() const {
+    return (InputSize() - NumShared) / GroupSize;
+  }
+
+  void GatherTensors() {
+    CAFFE_ENFORCE_EQ((InputSize() - NumShared) % GroupSize, 0);
+    CAFFE_ENFORCE_EQ(OutputSize(), NumTensors() * Depth);
+    tensors_.sizes.clear();
+    tensors_.grad.clear();
+    for (int d = 0; d < Depth; ++d) {
+      tensors_.state[d].clear();
+    }
+    for (int k = 0; k < NumTensors(); ++k) {
+      const int first = NumShared + k * GroupSize;
+      const auto& grad = Input(first + GroupSize - 1);
+      tensors_.sizes.push_back(grad.size());
+      tensors_.grad.push_back(grad.template data<float>());
+      for (int d = 0; d < Depth; ++d) {
+        CAFFE_ENFORCE_EQ(
+            Input(first + d).size(),
+            grad.size(),
+            "Tensor ",
+            k,
+            " differs in size from its gradient");
+        auto* output = Output(k * Depth + d);
+        output->ResizeLike(Input(first + d));
+        tensors_.state[d].push_back(output->template mutable_data<float>());
+      }
+    }
+  }
+
+  MultiTensorList<Depth> tensors_;
+};
+
+template <class Context>
+class MultiTensorMomentumSGDUpdateOp final
+    : public MultiTensorSGDOpBase<1, 3, 3, Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  MultiTensorMomentumSGDUpdateOp(const OperatorDef& operator_def, Workspace* ws)
+      : MultiTensorSGDOpBase<1, 3, 3, Context>(operator_def, ws),
+        momentum_(OperatorBase::GetSingleArgument<float>("momentum", 0.0)),
+        nesterov_(OperatorBase::GetSingleArgument<int>("nesterov", 0)) {}
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE_EQ(Input(LR).size(), 1);
+    this->GatherTensors();
+    multi_tensor_momentum_sgd_update<Context>(
+        this->tensors_,
+        Input(LR).template data<float>(),
+        momentum_,
+        nesterov_,
+        &context_);
+    return true;
+  }
+
+ protected:
+  float momentum_;
+  bool nesterov_;
+  INPUT_TAGS(LR);
+};
+
+template <class Context>
+class MultiTensorAdagradOp final
+    : public MultiTensorSGDOpBase<1, 3, 2, Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  MultiTensorAdagradOp(const OperatorDef& operator_def, Workspace* ws)
+      : MultiTensorSGDOpBase<1, 3, 2, Context>(operator_def, ws),
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)),
+        decay_(OperatorBase::GetSingleArgument<float>("decay", 1.0f)) {}
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE_EQ(Input(LR).size(), 1);
+    this->GatherTensors();
+    multi_tensor_adagrad_update<Context>(
+        this->tensors_,
+        Input(LR).template data<float>(),
+        epsilon_,
+        decay_,
+        &context_);
+    return true;
+  }
+
+ protected:
+  float epsilon_;
+  float decay_;
+  INPUT_TAGS(LR);
+};
+
+template <class Context>
+class MultiTensorAdamOp final : public MultiTensorSGDOpBase<2, 4, 3, Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  MultiTensorAdamOp(const OperatorDef& operator_def, Workspace* ws)
+      : MultiTensorSGDOpBase<2, 4, 3, Context>(operator_def, ws),
+        beta1_(OperatorBase::GetSingleArgument<float>("beta1", 0.9f)),
+        beta2_(OperatorBase::GetSingleArgument<float>("beta2", 0.999f)),
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)) {}
+
+  bool RunOnDevice() override {
+    // Iter live on the CPU
+    CAFFE_ENFORCE(OperatorBase::InputIsType<TensorCPU>(ITER));
+    CAFFE_ENFORCE_EQ(Input(LR).size(), 1);
+    this->GatherTensors();
+
+    const auto iter =
+        OperatorBase::Input<TensorCPU>(ITER).template data<int64_t>()[0];
+    const auto t = iter + 1;
+    const auto correction =
+        std::sqrt(1.0f - std::pow(beta2_, t)) / (1.0f - std::pow(beta1_, t));
+    multi_tensor_adam_update<Context>(
+        this->tensors_,
+        Input(LR).template data<float>(),
+        beta1_,
+        beta2_,
+        epsilon_,
+        correction,
+        &context_);
+    return true;
+  }
+
+ protected:
+  float beta1_;
+  float beta2_;
+  float epsilon_;
+  INPUT_TAGS(LR, ITER);
+};
+
+} // namespace caffe2
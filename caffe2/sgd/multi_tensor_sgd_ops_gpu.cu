@@ -0,0 +1,203 @@
+#include "multi_tensor_sgd_ops.h"
+#include "caffe2/core/common_gpu.h"
+#include "caffe2/core/context_gpu.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Every launch updates up to kMaxTensors tensors, split into chunks of
+// kChunkSize elements, one chunk per block. The pointers and sizes of the
+// tensors travel as kernel arguments, which are limited to 4KB.
+constexpr int kMaxTensors = 36;
+constexpr int kMaxChunks = 192;
+constexpr int kChunkSize = 16 * 1024;
+
+template <int Depth>
+struct MultiTensorChunks {
+  const float* grad[kMaxTensors];
+  float* state[Depth][kMaxTensors];
+  int sizes[kMaxTensors];
+  // Tensor and index within the tensor of the chunk of every block
+  unsigned char tensor[kMaxChunks];
+  int chunk[kMaxChunks];
+};
+
+template <int Depth, typename Functor>
+__global__ void MultiTensorKernel(MultiTensorChunks<Depth> chunks, Functor f) {
+  const int t = chunks.tensor[blockIdx.x];
+  const int begin = chunks.chunk[blockIdx.x] * kChunkSize;
+  const int end = min(begin + kChunkSize, chunks.sizes[t]);
+  float* state[Depth];
+  for (int d = 0; d < Depth; ++d) {
+    state[d] = chunks.state[d][t];
+  }
+  const float* grad = chunks.grad[t];
+  for (int i = begin + threadIdx.x; i < end; i += blockDim.x) {
+    f(i, grad, state);
+  }
+}
+
+// Updates all tensors with f, in as few launches as the argument size
+// allows.
+template <int Depth, typename Functor>
+void MultiTensorApply(
+    const MultiTensorList<Depth>& tensors,
+    Functor f,
+    CUDAContext* context) {
+  MultiTensorChunks<Depth> chunks;
+  int numTensors = 0;
+  int numChunks = 0;
+  auto launch = [&]() {
+    MultiTensorKernel<Depth, Functor>
+        <<<numChunks, CAFFE_CUDA_NUM_THREADS, 0, context->cuda_stream()>>>(
+            chunks, f);
+    numChunks = 0;
+  };
+
+  for (size_t t = 0; t < tensors.sizes.size(); ++t) {
+    const int size = tensors.sizes[t];
+    if (size == 0) {
+      continue;
+    }
+    chunks.grad[numTensors] = tensors.grad[t];
+    for (int d = 0; d < Depth; ++d) {
+      chunks.state[d][numTensors] = tensors.state[d][t];
+    }
+    chunks.sizes[numTensors] = size;
+    const int tensorChunks = (size + kChunkSize - 1) / kChunkSize;
+    for (int c = 0; c < tensorChunks; ++c) {
+      chunks.tensor[numChunks] = numTensors;
+      chunks.chunk[numChunks] = c;
+      ++numChunks;
+      if (numChunks == kMaxChunks) {
+        launch();
+        // The rest of the chunks of this tensor go to the next launch
+        if (c + 1 < tensorChunks) {
+          chunks.grad[0] = chunks.grad[numTensors];
+          for (int d = 0; d < Depth; ++d) {
+            chunks.state[d][0] = chunks.state[d][numTensors];
+          }
+          chunks.sizes[0] = size;
+          numTensors = 0;
+        } else {
+          numTensors = -1;
+        }
+      }
+    }
+    ++numTensors;
+    if (numTensors == kMaxTensors) {
+      if (numChunks > 0) {
+        launch();
+      }
+      numTensors = 0;
+    }
+  }
+  if (numChunks > 0) {
+    launch();
+  }
+}
+
+struct MomentumSGDFunctor {
+  const float* lr;
+  float momentum;
+  bool nesterov;
+
+  __device__ void operator()(int i, const float* g, float** state) const {
+    float* m = state[0];
+    float* param = state[1];
+    float* ng = state[2];
+    const float LR = lr[0];
+    if (!nesterov) {
+      const float adjusted_gradient = LR * g[i] + momentum * m[i];
+      m[i] = adjusted_gradient;
+      ng[i] = adjusted_gradient;
+      param[i] -= adjusted_gradient;
+    } else {
+      const float mi = m[i];
+      const float mi_new = momentum * mi + LR * g[i];
+      const float ngi = (1 + momentum) * mi_new - momentum * mi;
+      m[i] = mi_new;
+      ng[i] = ngi;
+      param[i] -= ngi;
+    }
+  }
+};
+
+struct AdagradFunctor {
+  const float* lr;
+  float epsilon;
+  float decay;
+
+  __device__ void operator()(int i, const float* g, float** state) const {
+    float* w = state[0];
+    float* h = state[1];
+    const float gi = g[i];
+    const float hi = h[i] = decay * h[i] + gi * gi;
+    w[i] += lr[0] * gi / (sqrtf(hi) + epsilon);
+  }
+};
+
+struct AdamFunctor {
+  const float* lr;
+  float beta1;
+  float beta2;
+  float eps_hat;
+  float correction;
+
+  __device__ void operator()(int i, const float* g, float** state) const {
+    float* w = state[0];
+    float* m = state[1];
+    float* v = state[2];
+    const float gi = g[i];
+    const float mi = m[i] = m[i] * beta1 + gi * (1 - beta1);
+    const float vi = v[i] = v[i] * beta2 + gi * gi * (1 - beta2);
+    w[i] += lr[0] * correction * mi / (sqrtf(vi) + eps_hat);
+  }
+};
+
+} // namespace
+
+template <>
+void multi_tensor_momentum_sgd_update<CUDAContext>(
+    const MultiTensorList<3>& tensors,
+    const float* lr,
+    const float momentum,
+    const bool nesterov,
+    CUDAContext* context) {
+  MultiTensorApply(
+      tensors, MomentumSGDFunctor{lr, momentum, nesterov}, context);
+}
+
+template <>
+void multi_tensor_adagrad_update<CUDAContext>(
+    const MultiTensorList<2>& tensors,
+    const float* lr,
+    float epsilon,
+    float decay,
+    CUDAContext* context) {
+  MultiTensorApply(tensors, AdagradFunctor{lr, epsilon, decay}, context);
+}
+
+template <>
+void multi_tensor_adam_update<CUDAContext>(
+    const MultiTensorList<3>& tensors,
+    const float* lr,
+    float beta1,
+    float beta2,
+    float eps_hat,
+    float correction,
+    CUDAContext* context) {
+  MultiTensorApply(
+      tensors,
+      AdamFunctor{lr, beta1, beta2, eps_hat, correction},
+      context);
+}
+
+REGISTER_CUDA_OPERATOR(
+    MultiTensorMomentumSGDUpdate,
+    MultiTensorMomentumSGDUpdateOp<CUDAContext>);
+REGISTER_CUDA_OPERATOR(MultiTensorAdagrad, MultiTensorAdagradOp<CUDAContext>);
+REGISTER_CUDA_OPERATOR(MultiTensorAdam, MultiTensorAdamOp<CUDAContext>);
+
+} // namespace caffe2
@@ -1,6 +1,7 @@
 #include "quant_decomp_zstd_op.h"
 #include <stdint.h>
 #include <zstd.h>
+#include <vector>
 #include "caffe2/core/tensor.h"
 #include "caffe2/proto/caffe2.pb.h"
 
@@ -62,14 +63,19 @@ TensorProtos GetTensorsProto(const TensorCPU& compressed) {
   return tensors;
 }
 
-// Decompress tensor stored in compressed format
-// It is compressed using mutils.compress_data_list()
-void Decompress(const TensorProto& compressed, TensorCPU* outDecomp) {
+// Allocates the tensor that Decompress decompresses into
+void Prepare(const TensorProto& compressed, TensorCPU* outDecomp) {
   vector<TIndex> shape(compressed.dims().begin(), compressed.dims().end());
   // shape stores the dimensions of data before compression,
   //   see _compress_data_single() in mutils.py
   outDecomp->Resize(shape);
-  auto* out_ptr = GetMutableData(compressed.data_type(), outDecomp);
+  GetMutableData(compressed.data_type(), outDecomp);
+}
+
+// Decompress tensor stored in compressed format
+// It is compressed using mutils.compress_data_list()
+void Decompress(const TensorProto& compressed, TensorCPU* outDecomp) {
+  auto* out_ptr = static_cast<uint8_t*>(outDecomp->raw_mutable_data());
 
   auto* src = reinterpret_cast<const uint8_t*>(compressed.byte_data().data());
   size_t comp_size = compressed.byte_data().size();
@@ -105,9 +111,18 @@ bool QuantDecompZstdOp::RunOnDevice() {
   auto tensors = GetTensorsProto(op_compressed);
   CAFFE_ENFORCE_EQ(tensors.protos_size(), OutputSize());
 
+  std::vector<TensorCPU*> outputs(OutputSize());
   for (int i = 0; i < OutputSize(); i++) {
-    Decompress(tensors.protos(i), Output(i));
+    outputs[i] = Output(i);
+    Prepare(tensors.protos(i), outputs[i]);
   }
+  // The tensors are independent zstd frames
+  ParallelFor(
+      IntraOpThreadPool(), OutputSize(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          Decompress(tensors.protos(i), outputs[i]);
+        }
+      });
 
   return true;
 }
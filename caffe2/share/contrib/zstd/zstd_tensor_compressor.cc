@@ -0,0 +1,43 @@
+#include <zstd.h>
+
+#include "caffe2/core/blob_serialization.h"
+#include "caffe2/core/flags.h"
+#include "caffe2/core/logging.h"
+
+CAFFE2_DEFINE_int(
+    caffe2_zstd_compression_level,
+    3,
+    "zstd compression level of the tensors serialized with "
+    "--caffe2_tensor_compression=zstd");
+
+namespace caffe2 {
+
+namespace {
+
+// Compresses each chunk of a serialized tensor into one zstd frame
+class ZstdTensorCompressor final : public TensorCompressorBase {
+ public:
+  void Compress(const void* src, size_t nbytes, std::string* dst) override {
+    dst->resize(ZSTD_compressBound(nbytes));
+    size_t size = ZSTD_compress(
+        &(*dst)[0],
+        dst->size(),
+        src,
+        nbytes,
+        FLAGS_caffe2_zstd_compression_level);
+    CAFFE_ENFORCE(!ZSTD_isError(size), ZSTD_getErrorName(size));
+    dst->resize(size);
+  }
+
+  void Decompress(const std::string& src, void* dst, size_t nbytes) override {
+    size_t size = ZSTD_decompress(dst, nbytes, src.data(), src.size());
+    CAFFE_ENFORCE(!ZSTD_isError(size), ZSTD_getErrorName(size));
+    CAFFE_ENFORCE_EQ(size, nbytes, "Compressed tensor chunk of the wrong size");
+  }
+};
+
+} // namespace
+
+REGISTER_TENSOR_COMPRESSOR(TensorProto::ZSTD, ZstdTensorCompressor);
+
+} // namespace caffe2
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "caffe2/core/blob.h"
+#include "caffe2/core/blob_serialization.h"
+#include "caffe2/core/tensor.h"
+
+namespace caffe2 {
+
+TEST(ZstdTensorCompressorTest, ChunksRoundTrip) {
+  const int kSize = 1000;
+  const auto old_compression = FLAGS_caffe2_tensor_compression;
+  FLAGS_caffe2_tensor_compression = "zstd";
+  std::vector<BlobProto> chunks;
+  {
+    Blob blob;
+    auto* tensor = blob.GetMutable<TensorCPU>();
+    tensor->Resize(kSize);
+    for (int i = 0; i < kSize; ++i) {
+      tensor->mutable_data<float>()[i] = i % 10;
+    }
+    std::mutex mutex;
+    blob.Serialize(
+        "test",
+        [&](const std::string& /*key*/, const std::string& value) {
+          BlobProto proto;
+          CHECK(proto.ParseFromString(value));
+          std::lock_guard<std::mutex> guard(mutex);
+          chunks.push_back(proto);
+        },
+        100);
+  }
+  FLAGS_caffe2_tensor_compression = old_compression;
+
+  ASSERT_EQ(chunks.size(), 10);
+  for (const auto& chunk : chunks) {
+    EXPECT_EQ(chunk.tensor().compression(), TensorProto::ZSTD);
+    EXPECT_EQ(chunk.tensor().float_data_size(), 0);
+    EXPECT_LT(chunk.tensor().byte_data().size(), 100 * sizeof(float));
+  }
+
+  // each chunk decompresses into its own part of the tensor
+  Blob blob;
+  auto deserializer = CreateDeserializerForProto(chunks[0]);
+  ASSERT_TRUE(deserializer->SupportsConcurrentChunks(chunks[0]));
+  deserializer->Prepare(chunks[0], &blob);
+  std::vector<std::thread> threads;
+  for (const auto& chunk : chunks) {
+    threads.emplace_back(
+        [&]() { deserializer->DeserializeChunk(chunk, &blob); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto& tensor = blob.Get<TensorCPU>();
+  ASSERT_EQ(tensor.size(), kSize);
+  for (int i = 0; i < kSize; ++i) {
+    EXPECT_EQ(tensor.data<float>()[i], i % 10);
+  }
+}
+
+} // namespace caffe2
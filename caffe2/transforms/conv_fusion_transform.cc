@@ -0,0 +1,311 @@
+#include "caffe2/transforms/conv_fusion_transform.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+namespace {
+
+bool IsCPU(const OperatorDef& op) {
+  return !op.has_device_option() || op.device_option().device_type() == CPU;
+}
+
+bool IsConv(const OperatorDef& op) {
+  return op.type() == "Conv" || op.type() == "Conv1D" ||
+      op.type() == "Conv2D" || op.type() == "Conv3D";
+}
+
+bool Is2DConv(const OperatorDef& op) {
+  ArgumentHelper args(op);
+  if (args.HasArgument("kernels")) {
+    return args.GetRepeatedArgument<int>("kernels").size() == 2;
+  }
+  return op.type() != "Conv1D" && op.type() != "Conv3D" &&
+      (args.HasArgument("kernel") || args.HasArgument("kernel_h"));
+}
+
+int CountWriters(const NetDef& net, const string& name) {
+  int count = 0;
+  for (const auto& op : net.op()) {
+    count += std::count(op.output().begin(), op.output().end(), name);
+  }
+  return count;
+}
+
+// The only operator that reads the value operator idx writes to `name`, or
+// -1 when it is read more than once, or is an external output. An operator
+// can write the blob it reads, such as an in-place Relu.
+int OnlyReader(const NetDef& net, int idx, const string& name) {
+  int reader = -1;
+  for (int i = idx + 1; i < net.op_size(); ++i) {
+    const auto& op = net.op(i);
+    const int reads = std::count(op.input().begin(), op.input().end(), name);
+    if (reads > 1 || (reads == 1 && reader >= 0)) {
+      return -1;
+    }
+    if (reads == 1) {
+      reader = i;
+    }
+    if (std::count(op.output().begin(), op.output().end(), name)) {
+      return reader;
+    }
+  }
+  const auto& outputs = net.external_output();
+  return std::count(outputs.begin(), outputs.end(), name) ? -1 : reader;
+}
+
+// Whether no operator strictly between begin and end writes, or also reads,
+// one of the blobs
+bool Untouched(
+    const NetDef& net,
+    int begin,
+    int end,
+    const std::vector<string>& names,
+    bool reads) {
+  for (int i = begin + 1; i < end; ++i) {
+    const auto& op = net.op(i);
+    for (const auto& name : names) {
+      if (std::find(op.output().begin(), op.output().end(), name) !=
+              op.output().end() ||
+          (reads &&
+           std::find(op.input().begin(), op.input().end(), name) !=
+               op.input().end())) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void AddExternalInput(NetDef* net, const string& name) {
+  const auto& inputs = net->external_input();
+  if (std::find(inputs.begin(), inputs.end(), name) == inputs.end()) {
+    net->add_external_input(name);
+  }
+}
+
+} // namespace
+
+NetDef ConvFusionTransform::ApplyTo(const NetDef& orig_net) {
+  NetDef net = orig_net;
+  folded_.clear();
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int i = 0; i < net.op_size() && !changed; ++i) {
+      const auto& op = net.op(i);
+      if (!IsConv(op) || !IsCPU(op) || op.output_size() != 1 ||
+          op.input_size() < 2) {
+        continue;
+      }
+      const int next = OnlyReader(net, i, op.output(0));
+      if (next < 0 || !IsCPU(net.op(next))) {
+        continue;
+      }
+      changed = (ws_ && FoldIntoConv(&net, i, next)) ||
+          FuseWithConv(&net, i, next);
+    }
+  }
+  return net;
+}
+
+bool ConvFusionTransform::FoldIntoConv(
+    NetDef* net,
+    int conv_idx,
+    int next_idx) {
+  // A constant float parameter of the workspace
+  auto get_parameter = [&](const string& name, int size) -> const TensorCPU* {
+    const Blob* blob = ws_->GetBlob(name);
+    if (!blob || !blob->IsType<TensorCPU>() || CountWriters(*net, name)) {
+      return nullptr;
+    }
+    const auto& tensor = blob->Get<TensorCPU>();
+    if (!tensor.IsType<float>() || (size >= 0 && tensor.size() != size)) {
+      return nullptr;
+    }
+    return &tensor;
+  };
+
+  OperatorDef* conv = net->mutable_op(conv_idx);
+  const OperatorDef& next = net->op(next_idx);
+  const string order =
+      ArgumentHelper(*conv).GetSingleArgument<string>("order", "NCHW");
+  const TensorCPU* filter = get_parameter(conv->input(1), -1);
+  if (!filter || filter->ndim() < 3) {
+    return false;
+  }
+  const int M = filter->dim32(0);
+  const TensorCPU* bias = nullptr;
+  if (conv->input_size() > 2) {
+    bias = get_parameter(conv->input(2), M);
+    if (!bias) {
+      return false;
+    }
+  }
+
+  // filter' = filter * scale, bias' = bias * scale + shift per output channel
+  std::vector<float> scale(M, 1.f);
+  std::vector<float> shift(M, 0.f);
+  ArgumentHelper args(next);
+  if (next.type() == "SpatialBN") {
+    if (!args.GetSingleArgument<int>(OpSchema::Arg_IsTest, 0) ||
+        next.input_size() != 5 || next.output_size() != 1 ||
+        next.input(0) != conv->output(0) ||
+        args.GetSingleArgument<string>("order", "NCHW") != order) {
+      return false;
+    }
+    const TensorCPU* bn_scale = get_parameter(next.input(1), M);
+    const TensorCPU* bn_bias = get_parameter(next.input(2), M);
+    const TensorCPU* mean = get_parameter(next.input(3), M);
+    const TensorCPU* var = get_parameter(next.input(4), M);
+    if (!bn_scale || !bn_bias || !mean || !var) {
+      return false;
+    }
+    const float epsilon = args.GetSingleArgument<float>("epsilon", 1e-5f);
+    for (int m = 0; m < M; ++m) {
+      scale[m] = bn_scale->data<float>()[m] /
+          std::sqrt(var->data<float>()[m] + epsilon);
+      shift[m] = bn_bias->data<float>()[m] - mean->data<float>()[m] * scale[m];
+    }
+  } else if (next.type() == "Add") {
+    // Only the broadcast of a bias along the channels
+    const int axis = args.GetSingleArgument<int>("axis", -1);
+    const bool channel_axis = order == "NCHW"
+        ? axis == 1
+        : axis == -1 || axis == filter->ndim() - 1;
+    if (!args.GetSingleArgument<int>("broadcast", 0) || !channel_axis ||
+        next.input_size() != 2 || next.input(0) != conv->output(0)) {
+      return false;
+    }
+    const TensorCPU* add_bias = get_parameter(next.input(1), M);
+    if (!add_bias || add_bias->ndim() != 1) {
+      return false;
+    }
+    std::copy(
+        add_bias->data<float>(), add_bias->data<float>() + M, shift.begin());
+  } else {
+    return false;
+  }
+
+  // The Conv now writes the output of the folded operator
+  const string& output = next.output(0);
+  for (const auto& input : conv->input()) {
+    if (input == output) {
+      return false;
+    }
+  }
+  if (!Untouched(*net, conv_idx, next_idx, {output}, true)) {
+    return false;
+  }
+
+  const int kernel_size = filter->size() / M;
+  TensorCPU folded_filter(filter->dims());
+  TensorCPU folded_bias(std::vector<TIndex>{M});
+  float* filter_data = folded_filter.mutable_data<float>();
+  float* bias_data = folded_bias.mutable_data<float>();
+  for (int m = 0; m < M; ++m) {
+    for (int k = 0; k < kernel_size; ++k) {
+      filter_data[m * kernel_size + k] =
+          filter->data<float>()[m * kernel_size + k] * scale[m];
+    }
+    bias_data[m] = (bias ? bias->data<float>()[m] : 0.f) * scale[m] + shift[m];
+  }
+  // Parameters folded before are updated in place
+  const string filter_name = folded_.count(conv->input(1))
+      ? conv->input(1)
+      : output + "_folded_w";
+  const string bias_name = bias && folded_.count(conv->input(2))
+      ? conv->input(2)
+      : output + "_folded_b";
+  ws_->CreateBlob(filter_name)->GetMutable<TensorCPU>()->swap(folded_filter);
+  ws_->CreateBlob(bias_name)->GetMutable<TensorCPU>()->swap(folded_bias);
+  folded_.insert(filter_name);
+  folded_.insert(bias_name);
+  AddExternalInput(net, filter_name);
+  AddExternalInput(net, bias_name);
+
+  conv->set_input(1, filter_name);
+  if (bias) {
+    conv->set_input(2, bias_name);
+  } else {
+    conv->add_input(bias_name);
+  }
+  conv->set_output(0, output);
+  net->mutable_op()->DeleteSubrange(next_idx, 1);
+  return true;
+}
+
+bool ConvFusionTransform::FuseWithConv(
+    NetDef* net,
+    int conv_idx,
+    int next_idx) {
+  const OperatorDef& conv = net->op(conv_idx);
+  const OperatorDef& next = net->op(next_idx);
+  if ((conv.type() != "Conv" && conv.type() != "Conv2D") ||
+      !conv.engine().empty() || !Is2DConv(conv) ||
+      ArgumentHelper(conv).GetSingleArgument<string>("order", "NCHW") !=
+          "NCHW") {
+    return false;
+  }
+  const std::vector<string> conv_inputs(
+      conv.input().begin(), conv.input().end());
+  auto is_relu = [&](const OperatorDef& op) {
+    return op.type() == "Relu" && op.engine().empty() && IsCPU(op) &&
+        op.output_size() == 1 &&
+        std::find(conv_inputs.begin(), conv_inputs.end(), op.output(0)) ==
+        conv_inputs.end();
+  };
+
+  if (is_relu(next)) {
+    const string& output = next.output(0);
+    if (!Untouched(*net, conv_idx, next_idx, {output}, true)) {
+      return false;
+    }
+    OperatorDef fused = conv;
+    fused.set_type("ConvRelu");
+    fused.set_output(0, output);
+    *net->mutable_op(conv_idx) = fused;
+    net->mutable_op()->DeleteSubrange(next_idx, 1);
+    return true;
+  }
+
+  // Conv -> Add -> Relu runs where the Add was, once the tensor added is known.
+  // Sum of two tensors is an Add without broadcast.
+  if ((next.type() != "Add" && next.type() != "Sum") ||
+      !next.engine().empty() || next.input_size() != 2 ||
+      next.output_size() != 1 ||
+      ArgumentHelper(next).GetSingleArgument<int>("broadcast", 0)) {
+    return false;
+  }
+  const string& sum = next.input(next.input(0) == conv.output(0) ? 1 : 0);
+  const string& add_output = next.output(0);
+  if (sum == conv.output(0)) {
+    return false;
+  }
+  const int relu_idx = OnlyReader(*net, next_idx, add_output);
+  if (relu_idx < 0 || !is_relu(net->op(relu_idx))) {
+    return false;
+  }
+  const string& output = net->op(relu_idx).output(0);
+  if (output == sum ||
+      !Untouched(*net, conv_idx, next_idx, conv_inputs, false) ||
+      !Untouched(*net, next_idx, relu_idx, {output}, true)) {
+    return false;
+  }
+  OperatorDef fused = conv;
+  fused.set_type("ConvSumRelu");
+  fused.add_input(sum);
+  fused.set_output(0, output);
+  *net->mutable_op(next_idx) = fused;
+  net->mutable_op()->DeleteSubrange(relu_idx, 1);
+  net->mutable_op()->DeleteSubrange(conv_idx, 1);
+  return true;
+}
+
+REGISTER_TRANSFORM(ConvFusion, ConvFusionTransform);
+
+} // namespace caffe2
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/transform.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+/**
+ * Conv Fusion Transform
+ *
+ * Removes the passes over the activations that follow the convolutions of an
+ * inference net:
+ *
+ * 1) With a workspace holding the parameters, a test-mode SpatialBN or a
+ *    broadcast Add of a per-channel constant that reads the output of a Conv
+ *    is folded into the filter and the bias of the Conv. The folded
+ *    parameters are new blobs of the workspace, <output>_folded_w and
+ *    <output>_folded_b, as the original ones may be shared.
+ * 2) Conv followed by Relu becomes ConvRelu, and Conv followed by an Add (or
+ *    a Sum) of a tensor of the same shape and Relu becomes ConvSumRelu, for
+ *    the 2D NCHW CPU Convs of the default engine.
+ *
+ * An intermediate output is only removed when the next operator is its only
+ * reader and it is not an external output. The registered ConvFusion
+ * transform has no workspace and only does 2).
+ */
+class ConvFusionTransform : public Transform {
+ public:
+  explicit ConvFusionTransform(Workspace* ws = nullptr) : ws_(ws) {}
+
+  NetDef ApplyTo(const NetDef& orig_net_def) override;
+
+ private:
+  bool FoldIntoConv(NetDef* net, int conv_idx, int next_idx);
+  bool FuseWithConv(NetDef* net, int conv_idx, int next_idx);
+
+  Workspace* ws_;
+  // The folded parameters created, which can be folded into again
+  std::set<string> folded_;
+};
+
+} // namespace caffe2
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/transforms/conv_fusion_transform.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+void AddRandomInput(
+    const std::vector<TIndex>& shape,
+    const string& name,
+    Workspace* ws) {
+  CPUContext context;
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(shape);
+  math::RandUniform<float, CPUContext>(
+      tensor->size(), 0.1f, 1.0f, tensor->mutable_data<float>(), &context);
+}
+
+std::vector<string> OpTypes(const NetDef& netdef) {
+  std::vector<string> types;
+  for (const auto& op : netdef.op()) {
+    types.push_back(op.type());
+  }
+  return types;
+}
+
+TEST(ConvFusionTest, TestFuse) {
+  NetDef netdef;
+  OperatorDef* op;
+  op = AddOp(&netdef, "Conv", {"X", "W1", "b1"}, {"c1"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("kernel", 3));
+  op = AddOp(&netdef, "Relu", {"c1"}, {"c1"});
+  op = AddOp(&netdef, "Conv", {"c1", "W2"}, {"c2"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("kernel", 1));
+  op = AddOp(&netdef, "Sum", {"c2", "c1"}, {"s"});
+  op = AddOp(&netdef, "Relu", {"s"}, {"s"});
+  // An external output is not removed
+  op = AddOp(&netdef, "Conv", {"s", "W3"}, {"c3"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("kernel", 1));
+  op = AddOp(&netdef, "Relu", {"c3"}, {"r3"});
+  // Neither is an output with two readers
+  op = AddOp(&netdef, "Conv", {"r3", "W4"}, {"c4"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("kernel", 1));
+  op = AddOp(&netdef, "Relu", {"c4"}, {"r4"});
+  op = AddOp(&netdef, "Sigmoid", {"c4"}, {"s4"});
+  netdef.add_external_output("c3");
+
+  auto t = TransformRegistry()->Create("ConvFusion");
+  NetDef transformed = t->ApplyTo(netdef);
+  EXPECT_EQ(
+      OpTypes(transformed),
+      (std::vector<string>{"ConvRelu",
+                           "ConvSumRelu",
+                           "Conv",
+                           "Relu",
+                           "Conv",
+                           "Relu",
+                           "Sigmoid"}));
+  EXPECT_EQ(transformed.op(0).output(0), "c1");
+  const auto& fused = transformed.op(1);
+  EXPECT_EQ(fused.input_size(), 3);
+  EXPECT_EQ(fused.input(0), "c1");
+  EXPECT_EQ(fused.input(2), "c1");
+  EXPECT_EQ(fused.output(0), "s");
+}
+
+TEST(ConvFusionTest, TestFoldAndFuse) {
+  Workspace ws;
+  AddRandomInput({2, 4, 7, 6}, "X", &ws);
+  AddRandomInput({8, 4, 3, 3}, "W1", &ws);
+  AddRandomInput({8}, "b1", &ws);
+  for (const auto* name : {"scale", "bias", "mean", "var", "b2"}) {
+    AddRandomInput({8}, name, &ws);
+  }
+  AddRandomInput({8, 8, 1, 1}, "W2", &ws);
+
+  NetDef netdef;
+  OperatorDef* op;
+  op = AddOp(&netdef, "Conv", {"X", "W1", "b1"}, {"c1"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("kernel", 3));
+  op->add_arg()->CopyFrom(MakeArgument<int>("pad", 1));
+  op = AddOp(
+      &netdef, "SpatialBN", {"c1", "scale", "bias", "mean", "var"}, {"c1"});
+  op->add_arg()->CopyFrom(MakeArgument<int>(OpSchema::Arg_IsTest, 1));
+  op = AddOp(&netdef, "Relu", {"c1"}, {"c1"});
+  op = AddOp(&netdef, "Conv", {"c1", "W2"}, {"c2"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("kernel", 1));
+  op = AddOp(&netdef, "Add", {"c2", "b2"}, {"c2"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("broadcast", 1));
+  op->add_arg()->CopyFrom(MakeArgument<int>("axis", 1));
+  op = AddOp(&netdef, "Add", {"c2", "c1"}, {"c2"});
+  op = AddOp(&netdef, "Relu", {"c2"}, {"out"});
+  netdef.add_external_output("out");
+
+  ASSERT_TRUE(ws.RunNetOnce(netdef));
+  const TensorCPU expected = ws.GetBlob("out")->Get<TensorCPU>();
+
+  NetDef transformed = ConvFusionTransform(&ws).ApplyTo(netdef);
+  EXPECT_EQ(
+      OpTypes(transformed), (std::vector<string>{"ConvRelu", "ConvSumRelu"}));
+  // The original parameters are left untouched
+  EXPECT_EQ(transformed.op(0).input(1), "c1_folded_w");
+  EXPECT_EQ(transformed.op(1).input(2), "c2_folded_b");
+  ASSERT_TRUE(ws.RunNetOnce(transformed));
+  const auto& actual = ws.GetBlob("out")->Get<TensorCPU>();
+  ASSERT_EQ(actual.dims(), expected.dims());
+  for (int i = 0; i < actual.size(); ++i) {
+    EXPECT_NEAR(actual.data<float>()[i], expected.data<float>()[i], 1e-4);
+  }
+}
+
+} // namespace
+
+} // namespace caffe2
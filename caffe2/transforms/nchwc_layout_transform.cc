@@ -0,0 +1,209 @@
+#include "caffe2/transforms/nchwc_layout_transform.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "caffe2/core/logging.h"
+
+namespace caffe2 {
+
+namespace {
+
+const std::unordered_map<string, string> kNCHWcTypes = {
+    {"Conv", "ConvNCHWc"},
+    {"Conv2D", "ConvNCHWc"},
+    {"MaxPool", "MaxPoolNCHWc"},
+    {"MaxPool2D", "MaxPoolNCHWc"},
+    {"AveragePool", "AveragePoolNCHWc"},
+    {"AveragePool2D", "AveragePoolNCHWc"},
+    {"SpatialBN", "SpatialBNNCHWc"},
+};
+
+enum class Conversion {
+  NONE,
+  // Always converted, reads an NCHW or blocked input
+  CONV,
+  // Converted when the input is blocked
+  BLOCKED_INPUT,
+  // Unchanged, runs on blocked inputs when one of them is blocked
+  LAYOUT_AGNOSTIC,
+};
+
+bool IsNCHW2D(const ArgumentHelper& args) {
+  if (args.GetSingleArgument<string>("order", "NCHW") != "NCHW") {
+    return false;
+  }
+  for (const auto* name : {"kernels", "strides", "pads", "dilations"}) {
+    if (args.HasArgument(name) &&
+        args.GetRepeatedArgument<int>(name).size() !=
+            (string(name) == "pads" ? 4 : 2)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Conversion GetConversion(
+    const OperatorDef& op,
+    const std::unordered_set<string>& reads) {
+  if ((op.has_device_option() && op.device_option().device_type() != CPU) ||
+      !op.engine().empty()) {
+    return Conversion::NONE;
+  }
+  ArgumentHelper args(op);
+  const string& type = op.type();
+  if (type == "Conv" || type == "Conv2D") {
+    return op.input_size() >= 2 && IsNCHW2D(args) &&
+            args.GetSingleArgument<int>("group", 1) == 1
+        ? Conversion::CONV
+        : Conversion::NONE;
+  }
+  if (type == "MaxPool" || type == "MaxPool2D" || type == "AveragePool" ||
+      type == "AveragePool2D") {
+    return IsNCHW2D(args) && !args.HasArgument("dilation") &&
+            !args.HasArgument("dilations") && !args.HasArgument("dilation_h")
+        ? Conversion::BLOCKED_INPUT
+        : Conversion::NONE;
+  }
+  if (type == "SpatialBN") {
+    return op.input_size() == 5 && op.output_size() == 1 &&
+            args.GetSingleArgument<int>(OpSchema::Arg_IsTest, 0) &&
+            args.GetSingleArgument<string>("order", "NCHW") == "NCHW"
+        ? Conversion::BLOCKED_INPUT
+        : Conversion::NONE;
+  }
+  if (type == "Relu" || type == "Sum") {
+    return Conversion::LAYOUT_AGNOSTIC;
+  }
+  if (type == "Add") {
+    return args.GetSingleArgument<int>("broadcast", 0)
+        ? Conversion::NONE
+        : Conversion::LAYOUT_AGNOSTIC;
+  }
+  if (type == "Concat") {
+    // The split info counts blocks instead of channels on blocked inputs
+    const bool split_info_read =
+        op.output_size() > 1 && reads.count(op.output(1));
+    return args.GetSingleArgument<string>("order", "NCHW") == "NCHW" &&
+            args.GetSingleArgument<int>("axis", 1) == 1 &&
+            !args.GetSingleArgument<int>("add_axis", 0) && !split_info_read
+        ? Conversion::LAYOUT_AGNOSTIC
+        : Conversion::NONE;
+  }
+  return Conversion::NONE;
+}
+
+// The data inputs, the other inputs of Conv and SpatialBN being parameters
+int NumDataInputs(const OperatorDef& op, Conversion conversion) {
+  return conversion == Conversion::LAYOUT_AGNOSTIC ? op.input_size() : 1;
+}
+
+} // namespace
+
+NetDef NCHWcLayoutTransform::ApplyTo(const NetDef& orig_net) {
+  std::unordered_set<string> reads(
+      orig_net.external_output().begin(), orig_net.external_output().end());
+  for (const auto& op : orig_net.op()) {
+    reads.insert(op.input().begin(), op.input().end());
+  }
+
+  NetDef net = orig_net;
+  net.clear_op();
+  // The blobs that hold a blocked tensor at this point of the net, and the
+  // reordered copies of the blobs that are still valid
+  std::unordered_set<string> blocked;
+  std::unordered_map<string, string> nchw_copies;
+  std::unordered_map<string, string> nchwc_copies;
+  auto reorder = [&](const string& name, bool to_nchwc) -> const string& {
+    auto& copies = to_nchwc ? nchwc_copies : nchw_copies;
+    auto it = copies.find(name);
+    if (it != copies.end()) {
+      return it->second;
+    }
+    const string copy = name + (to_nchwc ? "_nchwc" : "_nchw");
+    auto* op = AddOp(
+        &net, to_nchwc ? "NCHW2NCHWc" : "NCHWc2NCHW", {name}, {copy});
+    if (to_nchwc) {
+      op->add_arg()->CopyFrom(MakeArgument<int>("block", block_));
+    }
+    return copies[name] = copy;
+  };
+
+  for (const auto& orig_op : orig_net.op()) {
+    OperatorDef op = orig_op;
+    const Conversion conversion = GetConversion(op, reads);
+    const int num_data_inputs = NumDataInputs(op, conversion);
+    bool any_blocked = false;
+    for (int i = 0; i < num_data_inputs; ++i) {
+      any_blocked |= blocked.count(op.input(i)) > 0;
+    }
+    const bool convert = conversion == Conversion::CONV ||
+        (conversion != Conversion::NONE && any_blocked);
+
+    if (convert) {
+      // Every data input of a layout-agnostic operator has to be blocked
+      if (conversion == Conversion::LAYOUT_AGNOSTIC) {
+        for (int i = 0; i < op.input_size(); ++i) {
+          if (!blocked.count(op.input(i))) {
+            op.set_input(i, reorder(op.input(i), true));
+          }
+        }
+      }
+      for (int i = num_data_inputs; i < op.input_size(); ++i) {
+        CAFFE_ENFORCE(
+            !blocked.count(op.input(i)),
+            "The parameter ",
+            op.input(i),
+            " of ",
+            op.type(),
+            " is blocked");
+      }
+      if (conversion != Conversion::LAYOUT_AGNOSTIC) {
+        op.set_type(kNCHWcTypes.at(op.type()));
+        if (op.type() != "SpatialBNNCHWc") {
+          op.add_arg()->CopyFrom(MakeArgument<int>("block", block_));
+        }
+      }
+    } else {
+      for (int i = 0; i < op.input_size(); ++i) {
+        if (blocked.count(op.input(i))) {
+          op.set_input(i, reorder(op.input(i), false));
+        }
+      }
+    }
+
+    for (int i = 0; i < op.output_size(); ++i) {
+      const string& output = op.output(i);
+      nchw_copies.erase(output);
+      nchwc_copies.erase(output);
+      // The split info of Concat stays a plain tensor
+      if (convert && !(op.type() == "Concat" && i > 0)) {
+        blocked.insert(output);
+      } else {
+        blocked.erase(output);
+      }
+    }
+    net.add_op()->CopyFrom(op);
+  }
+
+  for (const auto& output : net.external_output()) {
+    if (blocked.count(output)) {
+      AddOp(&net, "NCHWc2NCHW", {output}, {output});
+    }
+  }
+  return net;
+}
+
+namespace {
+
+class NCHW16cLayoutTransform : public NCHWcLayoutTransform {
+ public:
+  NCHW16cLayoutTransform() : NCHWcLayoutTransform(16) {}
+};
+
+} // namespace
+
+REGISTER_TRANSFORM(NCHWcLayout, NCHWcLayoutTransform);
+REGISTER_TRANSFORM(NCHW16cLayout, NCHW16cLayoutTransform);
+
+} // namespace caffe2
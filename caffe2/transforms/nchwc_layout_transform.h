@@ -0,0 +1,41 @@
+#pragma once
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/transform.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+/**
+ * NCHWc Layout Transform
+ *
+ * Runs the 2D CPU convolutional part of an NCHW inference net on the blocked
+ * NCHW[x]c layout (see the NCHW2NCHWc operator). Conv becomes ConvNCHWc,
+ * which writes a blocked output from a blocked or NCHW input. The blocked
+ * layout then propagates forward through the operators that have a blocked
+ * version (MaxPool, AveragePool, SpatialBN in test mode) or that don't depend
+ * on the layout (Relu, Add, Sum, Concat along the channels). Reorders are
+ * inserted only at the boundaries: NCHWc2NCHW before any other operator that
+ * reads a blocked blob and for the blocked external outputs, NCHW2NCHWc for
+ * the NCHW inputs of a layout-agnostic operator that also reads a blocked
+ * blob. A reordered copy is shared by all its readers until the blob is
+ * written again.
+ *
+ * The output channels of the converted Conv operators have to be a multiple
+ * of the block, which ConvNCHWc checks when it runs.
+ *
+ * Registered as NCHWcLayout (8 channels per block, AVX2) and NCHW16cLayout
+ * (16 channels per block, AVX-512).
+ */
+class NCHWcLayoutTransform : public Transform {
+ public:
+  explicit NCHWcLayoutTransform(int block = 8) : block_(block) {}
+
+  NetDef ApplyTo(const NetDef& orig_net_def) override;
+
+ private:
+  int block_;
+};
+
+} // namespace caffe2
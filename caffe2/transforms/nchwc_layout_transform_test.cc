@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/transforms/nchwc_layout_transform.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+void AddRandomInput(
+    const std::vector<TIndex>& shape,
+    const string& name,
+    Workspace* ws) {
+  CPUContext context;
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(shape);
+  math::RandUniform<float, CPUContext>(
+      tensor->size(), 0.1f, 1.0f, tensor->mutable_data<float>(), &context);
+}
+
+// data -> Conv -> Relu -> MaxPool -> Conv -> SpatialBN -> Add -> Concat ->
+// AveragePool, with an NCHW reader in the middle
+NetDef CreateNet() {
+  NetDef netdef;
+  OperatorDef* op;
+  op = AddOp(&netdef, "Conv", {"data", "w1", "b1"}, {"c1"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("kernel", 3));
+  op->add_arg()->CopyFrom(MakeArgument<int>("pad", 1));
+  op = AddOp(&netdef, "Relu", {"c1"}, {"c1"});
+  op = AddOp(&netdef, "Sigmoid", {"c1"}, {"sig"});
+  op = AddOp(&netdef, "MaxPool", {"c1"}, {"p1"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("kernel", 2));
+  op->add_arg()->CopyFrom(MakeArgument<int>("stride", 2));
+  op = AddOp(&netdef, "Conv", {"p1", "w2"}, {"c2"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("kernel", 3));
+  op->add_arg()->CopyFrom(MakeArgument<int>("stride", 1));
+  op->add_arg()->CopyFrom(MakeArgument<int>("pad", 1));
+  op = AddOp(&netdef, "SpatialBN", {"c2", "s", "b", "m", "v"}, {"bn"});
+  op->add_arg()->CopyFrom(MakeArgument<int>(OpSchema::Arg_IsTest, 1));
+  op = AddOp(&netdef, "Add", {"bn", "p1"}, {"sum"});
+  op = AddOp(&netdef, "Concat", {"sum", "p1"}, {"cat", "cat_info"});
+  op = AddOp(&netdef, "AveragePool", {"cat"}, {"avg"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("global_pooling", 1));
+  netdef.add_external_output("sig");
+  netdef.add_external_output("sum");
+  netdef.add_external_output("avg");
+  return netdef;
+}
+
+TEST(NCHWcLayoutTest, TestPropagation) {
+  NetDef netdef = CreateNet();
+  auto t = TransformRegistry()->Create("NCHWcLayout");
+  NetDef transformed = t->ApplyTo(netdef);
+
+  std::vector<string> types;
+  for (const auto& op : transformed.op()) {
+    types.push_back(op.type());
+  }
+  EXPECT_EQ(
+      types,
+      (std::vector<string>{"ConvNCHWc",
+                           "Relu",
+                           "NCHWc2NCHW",
+                           "Sigmoid",
+                           "MaxPoolNCHWc",
+                           "ConvNCHWc",
+                           "SpatialBNNCHWc",
+                           "Add",
+                           "Concat",
+                           "AveragePoolNCHWc",
+                           "NCHWc2NCHW",
+                           "NCHWc2NCHW"}));
+  // The NCHW reader reads a reordered copy, the external outputs are
+  // reordered in place at the end
+  EXPECT_EQ(transformed.op(3).input(0), transformed.op(2).output(0));
+  EXPECT_EQ(transformed.op(10).input(0), "sum");
+  EXPECT_EQ(transformed.op(10).output(0), "sum");
+  EXPECT_EQ(transformed.op(11).input(0), "avg");
+}
+
+TEST(NCHWcLayoutTest, TestBoundaries) {
+  NetDef netdef;
+  OperatorDef* op;
+  op = AddOp(&netdef, "Conv", {"x", "w"}, {"y"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("kernel", 1));
+  // Not converted: CUDA, NHWC and grouped convolutions
+  op = AddOp(&netdef, "Conv", {"x", "w"}, {"y_cuda"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("kernel", 1));
+  op->mutable_device_option()->set_device_type(CUDA);
+  op = AddOp(&netdef, "Conv", {"x", "w"}, {"y_nhwc"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("kernel", 1));
+  op->add_arg()->CopyFrom(MakeArgument<string>("order", "NHWC"));
+  op = AddOp(&netdef, "Conv", {"x", "w"}, {"y_group"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("kernel", 1));
+  op->add_arg()->CopyFrom(MakeArgument<int>("group", 2));
+  // A pooling of an NCHW input stays NCHW
+  op = AddOp(&netdef, "MaxPool", {"x"}, {"x_pool"});
+  op->add_arg()->CopyFrom(MakeArgument<int>("kernel", 2));
+  // Both readers share one reordered copy
+  op = AddOp(&netdef, "Sigmoid", {"y"}, {"z1"});
+  op = AddOp(&netdef, "Tanh", {"y"}, {"z2"});
+  // The NCHW input of Add is reordered to the blocked layout
+  op = AddOp(&netdef, "Add", {"y", "x_pool"}, {"y"});
+
+  auto t = TransformRegistry()->Create("NCHW16cLayout");
+  NetDef transformed = t->ApplyTo(netdef);
+  ASSERT_EQ(transformed.op_size(), 10);
+  EXPECT_EQ(transformed.op(0).type(), "ConvNCHWc");
+  EXPECT_EQ(
+      ArgumentHelper(transformed.op(0)).GetSingleArgument<int>("block", 0),
+      16);
+  for (int i = 1; i <= 4; ++i) {
+    EXPECT_EQ(transformed.op(i).type(), netdef.op(i).type());
+  }
+  EXPECT_EQ(transformed.op(5).type(), "NCHWc2NCHW");
+  EXPECT_EQ(transformed.op(6).input(0), transformed.op(5).output(0));
+  EXPECT_EQ(transformed.op(7).input(0), transformed.op(5).output(0));
+  EXPECT_EQ(transformed.op(8).type(), "NCHW2NCHWc");
+  EXPECT_EQ(transformed.op(8).input(0), "x_pool");
+  EXPECT_EQ(transformed.op(9).type(), "Add");
+  EXPECT_EQ(transformed.op(9).input(1), transformed.op(8).output(0));
+}
+
+TEST(NCHWcLayoutTest, TestSameOutputs) {
+  for (const string& transform : {"NCHWcLayout", "NCHW16cLayout"}) {
+    Workspace ws;
+    AddRandomInput({2, 3, 10, 9}, "data", &ws);
+    AddRandomInput({16, 3, 3, 3}, "w1", &ws);
+    AddRandomInput({16}, "b1", &ws);
+    AddRandomInput({16, 16, 3, 3}, "w2", &ws);
+    for (const auto* name : {"s", "b", "m", "v"}) {
+      AddRandomInput({16}, name, &ws);
+    }
+    NetDef netdef = CreateNet();
+    ASSERT_TRUE(ws.RunNetOnce(netdef));
+    std::vector<TensorCPU> expected;
+    for (const auto& output : netdef.external_output()) {
+      expected.emplace_back(ws.GetBlob(output)->Get<TensorCPU>());
+    }
+
+    ASSERT_TRUE(ws.RunNetOnce(ApplyTransform(transform, netdef)));
+    for (int i = 0; i < netdef.external_output_size(); ++i) {
+      const auto& actual =
+          ws.GetBlob(netdef.external_output(i))->Get<TensorCPU>();
+      ASSERT_EQ(actual.dims(), expected[i].dims());
+      for (int j = 0; j < actual.size(); ++j) {
+        EXPECT_NEAR(
+            actual.data<float>()[j], expected[i].data<float>()[j], 1e-3);
+      }
+    }
+  }
+}
+
+} // namespace
+
+} // namespace caffe2
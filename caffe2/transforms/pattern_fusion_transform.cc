@@ -0,0 +1,13 @@
+#include "caffe2/transforms/pattern_fusion_transform.h"
+
+#include "caffe2/opt/fusion.h"
+
+namespace caffe2 {
+
+NetDef PatternFusionTransform::ApplyTo(const NetDef& orig_net_def) {
+  return opt::fusePatterns(orig_net_def);
+}
+
+REGISTER_TRANSFORM(PatternFusion, PatternFusionTransform);
+
+} // namespace caffe2
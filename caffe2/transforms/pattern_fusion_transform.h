@@ -0,0 +1,24 @@
+#pragma once
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/transform.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+/**
+ * Pattern Fusion Transform
+ *
+ * Runs the nomnigraph pattern fusion of caffe2/opt/fusion.h on the net:
+ * chains of unary elementwise operators become FusedElementwise, FC followed
+ * by them becomes FCActivation, and Split undoing a Concat is removed. The
+ * patterns are declared with nom::transformations::OperatorChainPattern,
+ * which checks that fusing them is legal, rather than with the subgraph
+ * matching of Transform.
+ */
+class PatternFusionTransform : public Transform {
+ public:
+  NetDef ApplyTo(const NetDef& orig_net_def) override;
+};
+
+} // namespace caffe2
@@ -249,6 +249,28 @@ void GemmBatched(
     Tensor<Context>* scratch = nullptr,
     TensorProto::DataType math_type = TensorProto_DataType_FLOAT);
 
+// GemmStridedBatched computes batch_size GEMMs whose i-th matrices start at
+// A + i * a_stride, B + i * b_stride and C + i * c_stride. A stride of 0 uses
+// the same matrix for the whole batch, which broadcasts it without copying it.
+template <typename T, class Context, class Engine = DefaultEngine>
+void GemmStridedBatched(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const T* A,
+    const int a_stride,
+    const T* B,
+    const int b_stride,
+    const float beta,
+    T* C,
+    const int c_stride,
+    Context* context,
+    TensorProto::DataType math_type = TensorProto_DataType_FLOAT);
+
 // Gemv always takes in a M*N matrix A, and depending on whether we set TransA
 // to Trans, the output is:
 // CblasNoTrans: x is an N dim vector and y is an M dim vector.
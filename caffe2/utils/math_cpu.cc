@@ -407,7 +407,7 @@ CAFFE2_SPECIALIZED_AXPBY(float, s)
 #endif  // CAFFE2_USE_EIGEN_FOR_BLAS
 
 template <>
-void GemmBatched<float, CPUContext>(
+void GemmStridedBatched<float, CPUContext>(
     const CBLAS_TRANSPOSE TransA,
     const CBLAS_TRANSPOSE TransB,
     const int batch_size,
@@ -416,16 +416,14 @@ void GemmBatched<float, CPUContext>(
     const int K,
     const float alpha,
     const float* A,
+    const int a_stride,
     const float* B,
+    const int b_stride,
     const float beta,
     float* C,
+    const int c_stride,
     CPUContext* context,
-    Tensor<CPUContext>*, /* scratch */
     TensorProto::DataType /* math_type */) {
-  const int a_stride = M * K;
-  const int b_stride = K * N;
-  const int c_stride = M * N;
-
 #ifdef CAFFE2_USE_MKL
   (void)context;
 
@@ -475,6 +473,41 @@ void GemmBatched<float, CPUContext>(
 #endif
 }
 
+template <>
+void GemmBatched<float, CPUContext>(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float* A,
+    const float* B,
+    const float beta,
+    float* C,
+    CPUContext* context,
+    Tensor<CPUContext>*, /* scratch */
+    TensorProto::DataType math_type) {
+  GemmStridedBatched<float, CPUContext>(
+      TransA,
+      TransB,
+      batch_size,
+      M,
+      N,
+      K,
+      alpha,
+      A,
+      M * K,
+      B,
+      K * N,
+      beta,
+      C,
+      M * N,
+      context,
+      math_type);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // MKL VML alternatives.
 // Depending on whether we are using MKL, we will delegate the Caffe math
@@ -263,7 +263,7 @@ void Gemm<float16, CUDAContext>(
 }
 
 template <>
-void GemmBatched<float, CUDAContext>(
+void GemmStridedBatched<float, CUDAContext>(
     const CBLAS_TRANSPOSE TransA,
     const CBLAS_TRANSPOSE TransB,
     const int batch_size,
@@ -272,15 +272,14 @@ void GemmBatched<float, CUDAContext>(
     const int K,
     const float alpha,
     const float* A,
+    const int a_stride,
     const float* B,
+    const int b_stride,
     const float beta,
     float* C,
+    const int c_stride,
     CUDAContext* context,
-    Tensor<CUDAContext>* scratch,
     TensorProto::DataType math_type) {
-  const int a_stride = M * K;
-  const int b_stride = K * N;
-  const int c_stride = M * N;
 #if __CUDACC_VER_MAJOR__ < 8
   // loop over matrices in the batch
   for (int i = 0; i < batch_size; ++i) {
@@ -328,6 +327,159 @@ void GemmBatched<float, CUDAContext>(
 #endif
 }
 
+template <>
+void GemmBatched<float, CUDAContext>(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float* A,
+    const float* B,
+    const float beta,
+    float* C,
+    CUDAContext* context,
+    Tensor<CUDAContext>* scratch,
+    TensorProto::DataType math_type) {
+  GemmStridedBatched<float, CUDAContext>(
+      TransA,
+      TransB,
+      batch_size,
+      M,
+      N,
+      K,
+      alpha,
+      A,
+      M * K,
+      B,
+      K * N,
+      beta,
+      C,
+      M * N,
+      context,
+      math_type);
+}
+
+template <>
+void GemmStridedBatched<float16, CUDAContext>(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float16* A,
+    const int a_stride,
+    const float16* B,
+    const int b_stride,
+    const float beta,
+    float16* C,
+    const int c_stride,
+    CUDAContext* context,
+    TensorProto::DataType math_type) {
+  // Note that cublas follows fortran order, so the order is different from
+  // the cblas convention.
+  const int lda = (TransA == CblasNoTrans) ? K : M;
+  const int ldb = (TransB == CblasNoTrans) ? N : K;
+  cublasOperation_t cuTransA =
+      (TransA == CblasNoTrans) ? CUBLAS_OP_N : CUBLAS_OP_T;
+  cublasOperation_t cuTransB =
+      (TransB == CblasNoTrans) ? CUBLAS_OP_N : CUBLAS_OP_T;
+  if (math_type == TensorProto_DataType_FLOAT) {
+#if CUDA_VERSION >= 9010
+    // fp16 storage with fp32 accumulation, in a single call
+    CUBLAS_ENFORCE(cublasGemmStridedBatchedEx(
+        context->cublas_handle(),
+        cuTransB,
+        cuTransA,
+        N,
+        M,
+        K,
+        &alpha,
+        B,
+        CUDA_R_16F,
+        ldb,
+        b_stride,
+        A,
+        CUDA_R_16F,
+        lda,
+        a_stride,
+        &beta,
+        C,
+        CUDA_R_16F,
+        N,
+        c_stride,
+        batch_size,
+        CUDA_R_32F,
+        CUBLAS_GEMM_DFALT));
+#else
+    // loop over matrices in the batch
+    for (int i = 0; i < batch_size; ++i) {
+      math::Gemm<float16, CUDAContext>(
+          TransA,
+          TransB,
+          M,
+          N,
+          K,
+          alpha,
+          A + a_stride * i,
+          B + b_stride * i,
+          beta,
+          C + c_stride * i,
+          context);
+    }
+#endif
+  } else if (math_type == TensorProto_DataType_FLOAT16) {
+#if __CUDACC_VER_MAJOR__ < 8
+    // loop over matrices in the batch
+    for (int i = 0; i < batch_size; ++i) {
+      math::Gemm<float16, CUDAContext>(
+          TransA,
+          TransB,
+          M,
+          N,
+          K,
+          alpha,
+          A + a_stride * i,
+          B + b_stride * i,
+          beta,
+          C + c_stride * i,
+          context,
+          math_type);
+    }
+#else
+    // convert alpha, beta from float -> __half
+    auto alpha_fp16 = convert::floatToHalf(alpha);
+    auto beta_fp16 = convert::floatToHalf(beta);
+    CUBLAS_ENFORCE(cublasHgemmStridedBatched(
+        context->cublas_handle(),
+        cuTransB,
+        cuTransA,
+        N,
+        M,
+        K,
+        &alpha_fp16,
+        (const __half*)B,
+        ldb,
+        b_stride,
+        (const __half*)A,
+        lda,
+        a_stride,
+        &beta_fp16,
+        (__half*)C,
+        N,
+        c_stride,
+        batch_size));
+#endif
+  } else {
+    // fail
+    CAFFE_THROW("Unsupported math type");
+  }
+}
+
 namespace {
 
 __global__ void FloatToHalfKernel(const int N, const float* X, half* Y) {
@@ -380,10 +532,10 @@ void GemmBatched<float16, CUDAContext>(
         context);
   }
 #else
-  // 3 options:
+  // 2 options:
   // 1) scratch != null = cast to fp32, SgemmStridedBatched, cast result to fp16
-  // 2) math_type == FLOAT, scratch == nullptr = looped SgemmEx
-  // 3) math_type == FLOAT16, scratch == nullptr = batched Hgemm
+  // 2) scratch == nullptr = GemmStridedBatched with fp16 storage, which
+  //    accumulates in fp32 or fp16 depending on math_type
 
   if (scratch != nullptr) {
     const int A_size = a_stride * batch_size;
@@ -431,55 +583,23 @@ void GemmBatched<float16, CUDAContext>(
         0,
         context->cuda_stream()>>>(batch_size * M * N, C_fp32, (half*)C);
   } else {
-    if (math_type == TensorProto_DataType_FLOAT) {
-      // loop over matrices in the batch
-      for (int i = 0; i < batch_size; ++i) {
-        math::Gemm<float16, CUDAContext>(
-            TransA,
-            TransB,
-            M,
-            N,
-            K,
-            alpha,
-            A + a_stride * i,
-            B + b_stride * i,
-            beta,
-            C + c_stride * i,
-            context);
-      }
-    } else if (math_type == TensorProto_DataType_FLOAT16) {
-      // Note that cublas follows fortran order, so the order is different from
-      // the cblas convention.
-      const int lda = (TransA == CblasNoTrans) ? K : M;
-      const int ldb = (TransB == CblasNoTrans) ? N : K;
-      cublasOperation_t cuTransA =
-          (TransA == CblasNoTrans) ? CUBLAS_OP_N : CUBLAS_OP_T;
-      cublasOperation_t cuTransB =
-          (TransB == CblasNoTrans) ? CUBLAS_OP_N : CUBLAS_OP_T;
-
-      // convert alpha, beta from float -> __half
-      auto alpha_fp16 = convert::floatToHalf(alpha);
-      auto beta_fp16 = convert::floatToHalf(beta);
-      CUBLAS_ENFORCE(cublasHgemmStridedBatched(
-          context->cublas_handle(),
-          cuTransB,
-          cuTransA,
-          N,
-          M,
-          K,
-          &alpha_fp16,
-          (const __half*)B,
-          ldb,
-          b_stride,
-          (const __half*)A,
-          lda,
-          a_stride,
-          &beta_fp16,
-          (__half*)C,
-          N,
-          c_stride,
-          batch_size));
-    }
+    GemmStridedBatched<float16, CUDAContext>(
+        TransA,
+        TransB,
+        batch_size,
+        M,
+        N,
+        K,
+        alpha,
+        A,
+        a_stride,
+        B,
+        b_stride,
+        beta,
+        C,
+        c_stride,
+        context,
+        math_type);
   }
 #endif
 }
@@ -623,6 +743,25 @@ void GemmBatched<float16, CUDAContext, TensorCoreEngine>(
     CUDAContext* context,
     Tensor<CUDAContext>* scratch,
     TensorProto::DataType math_type) {
+  if (scratch == nullptr) {
+    return GemmStridedBatched<float16, CUDAContext, TensorCoreEngine>(
+        TransA,
+        TransB,
+        batch_size,
+        M,
+        N,
+        K,
+        alpha,
+        A,
+        M * K,
+        B,
+        K * N,
+        beta,
+        C,
+        M * N,
+        context,
+        math_type);
+  }
   return GemmBatched<float16, CUDAContext, DefaultEngine>(
       TransA,
       TransB,
@@ -640,6 +779,132 @@ void GemmBatched<float16, CUDAContext, TensorCoreEngine>(
       math_type);
 }
 
+// No change, but required. Defer to default CUDA engine
+template <>
+void GemmStridedBatched<float, CUDAContext, TensorCoreEngine>(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float* A,
+    const int a_stride,
+    const float* B,
+    const int b_stride,
+    const float beta,
+    float* C,
+    const int c_stride,
+    CUDAContext* context,
+    TensorProto::DataType math_type) {
+  return GemmStridedBatched<float, CUDAContext, DefaultEngine>(
+      TransA,
+      TransB,
+      batch_size,
+      M,
+      N,
+      K,
+      alpha,
+      A,
+      a_stride,
+      B,
+      b_stride,
+      beta,
+      C,
+      c_stride,
+      context,
+      math_type);
+}
+
+template <>
+void GemmStridedBatched<float16, CUDAContext, TensorCoreEngine>(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float16* A,
+    const int a_stride,
+    const float16* B,
+    const int b_stride,
+    const float beta,
+    float16* C,
+    const int c_stride,
+    CUDAContext* context,
+    TensorProto::DataType math_type) {
+#if CUDA_VERSION >= 9010
+  // Note that cublas follows fortran order, so the order is different from
+  // the cblas convention.
+  const int lda = (TransA == CblasNoTrans) ? K : M;
+  const int ldb = (TransB == CblasNoTrans) ? N : K;
+  cublasOperation_t cuTransA =
+      (TransA == CblasNoTrans) ? CUBLAS_OP_N : CUBLAS_OP_T;
+  cublasOperation_t cuTransB =
+      (TransB == CblasNoTrans) ? CUBLAS_OP_N : CUBLAS_OP_T;
+
+  // enable TensorCore for this call on this handle
+  if (TensorCoreAvailable()) {
+    CUBLAS_ENFORCE(cublasSetMathMode(
+        context->cublas_handle(),
+        CUBLAS_TENSOR_OP_MATH));
+  }
+
+  CUBLAS_CHECK(cublasGemmStridedBatchedEx(
+      context->cublas_handle(),
+      cuTransB,
+      cuTransA,
+      N,
+      M,
+      K,
+      &alpha,
+      B,
+      CUDA_R_16F,
+      ldb,
+      b_stride,
+      A,
+      CUDA_R_16F,
+      lda,
+      a_stride,
+      &beta,
+      C,
+      CUDA_R_16F,
+      N,
+      c_stride,
+      batch_size,
+      CUDA_R_32F,
+      CUBLAS_GEMM_DFALT_TENSOR_OP));
+
+  // Now disable TensorCore math for subsequent calls to this handle
+  if (TensorCoreAvailable()) {
+    CUBLAS_ENFORCE(cublasSetMathMode(
+        context->cublas_handle(),
+        CUBLAS_DEFAULT_MATH));
+  }
+#else
+  // cublasGemmStridedBatchedEx needs CUDA 9.1
+  return GemmStridedBatched<float16, CUDAContext, DefaultEngine>(
+      TransA,
+      TransB,
+      batch_size,
+      M,
+      N,
+      K,
+      alpha,
+      A,
+      a_stride,
+      B,
+      b_stride,
+      beta,
+      C,
+      c_stride,
+      context,
+      math_type);
+#endif
+}
+
 #endif // CUDA_VERSION >= 9000
 
 template <>
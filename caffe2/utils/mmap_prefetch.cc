@@ -0,0 +1,153 @@
+#include "caffe2/utils/mmap_prefetch.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "caffe2/core/logging.h"
+
+namespace caffe2 {
+
+namespace {
+
+struct MappedRegions {
+  std::mutex mutex;
+  // start -> end of every region
+  std::map<uintptr_t, uintptr_t> regions;
+  // checked without the lock, so that lookups into memory that isn't
+  // mapped don't contend
+  std::atomic<int> count{0};
+};
+
+MappedRegions& mappedRegions() {
+  static MappedRegions regions;
+  return regions;
+}
+
+// End of the region that contains `data`, or 0
+uintptr_t regionEnd(const void* data) {
+  auto& mapped = mappedRegions();
+  if (mapped.count.load(std::memory_order_relaxed) == 0) {
+    return 0;
+  }
+  auto address = reinterpret_cast<uintptr_t>(data);
+  std::lock_guard<std::mutex> guard(mapped.mutex);
+  auto it = mapped.regions.upper_bound(address);
+  if (it == mapped.regions.begin()) {
+    return 0;
+  }
+  --it;
+  return address < it->second ? it->second : 0;
+}
+
+template <typename Index>
+void prefetchMappedRows(
+    const void* table,
+    size_t row_bytes,
+    const Index* indices,
+    size_t n) {
+#ifndef _WIN32
+  if (n == 0 || row_bytes == 0) {
+    return;
+  }
+  uintptr_t end = regionEnd(table);
+  if (!end) {
+    return;
+  }
+  const uintptr_t page_size = getpagesize();
+  const uintptr_t base = reinterpret_cast<uintptr_t>(table);
+  const uintptr_t num_rows = (end - base) / row_bytes;
+  std::vector<uintptr_t> pages;
+  pages.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    if (indices[i] < 0 || static_cast<uintptr_t>(indices[i]) >= num_rows) {
+      continue;
+    }
+    uintptr_t row = base + static_cast<uintptr_t>(indices[i]) * row_bytes;
+    for (uintptr_t page = row & ~(page_size - 1); page < row + row_bytes;
+         page += page_size) {
+      pages.push_back(page);
+    }
+  }
+  std::sort(pages.begin(), pages.end());
+  pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+  for (size_t i = 0; i < pages.size();) {
+    size_t j = i + 1;
+    while (j < pages.size() && pages[j] == pages[j - 1] + page_size) {
+      ++j;
+    }
+    if (madvise(
+            reinterpret_cast<void*>(pages[i]),
+            (j - i) * page_size,
+            MADV_WILLNEED) != 0) {
+      VLOG(1) << "madvise(MADV_WILLNEED) failed: " << errno;
+      return;
+    }
+    i = j;
+  }
+#endif
+}
+
+} // namespace
+
+void RegisterMappedRegion(const void* data, size_t nbytes) {
+  auto& mapped = mappedRegions();
+  auto start = reinterpret_cast<uintptr_t>(data);
+  std::lock_guard<std::mutex> guard(mapped.mutex);
+  CAFFE_ENFORCE(
+      mapped.regions.emplace(start, start + nbytes).second,
+      "Mapped region registered twice");
+  mapped.count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void UnregisterMappedRegion(const void* data) {
+  auto& mapped = mappedRegions();
+  std::lock_guard<std::mutex> guard(mapped.mutex);
+  if (mapped.regions.erase(reinterpret_cast<uintptr_t>(data))) {
+    mapped.count.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+bool IsMappedRegion(const void* data) {
+  return regionEnd(data) != 0;
+}
+
+void PrefetchMappedRows(
+    const void* table,
+    size_t row_bytes,
+    const int32_t* indices,
+    size_t n) {
+  prefetchMappedRows(table, row_bytes, indices, n);
+}
+
+void PrefetchMappedRows(
+    const void* table,
+    size_t row_bytes,
+    const int64_t* indices,
+    size_t n) {
+  prefetchMappedRows(table, row_bytes, indices, n);
+}
+
+void AdviseRandomAccess(const void* data, size_t nbytes) {
+#ifndef _WIN32
+  if (nbytes == 0) {
+    return;
+  }
+  const uintptr_t page_size = getpagesize();
+  auto start = reinterpret_cast<uintptr_t>(data) & ~(page_size - 1);
+  auto end = reinterpret_cast<uintptr_t>(data) + nbytes;
+  if (madvise(reinterpret_cast<void*>(start), end - start, MADV_RANDOM) != 0) {
+    VLOG(1) << "madvise(MADV_RANDOM) failed: " << errno;
+  }
+#endif
+}
+
+} // namespace caffe2
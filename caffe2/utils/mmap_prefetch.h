@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace caffe2 {
+
+// Memory mapped from files, e.g. the tensors of SharedWeights, whose pages
+// are only read from disk when they are first touched and can be evicted
+// again under memory pressure. Lookups into such tables register here so
+// that operators can fetch the rows they are about to read ahead of time.
+void RegisterMappedRegion(const void* data, size_t nbytes);
+void UnregisterMappedRegion(const void* data);
+bool IsMappedRegion(const void* data);
+
+// Asks the kernel to read the rows `indices[0..n)` of `table`, whose rows
+// are `row_bytes` apart, when `table` lies in a registered region, so that
+// their faults are served concurrently in the background instead of one
+// after the other as a lookup touches them. The pages are sorted and
+// coalesced into as few requests as possible. Indices out of the region are
+// skipped and left for the caller to reject. Does nothing for other memory.
+void PrefetchMappedRows(
+    const void* table,
+    size_t row_bytes,
+    const int32_t* indices,
+    size_t n);
+void PrefetchMappedRows(
+    const void* table,
+    size_t row_bytes,
+    const int64_t* indices,
+    size_t n);
+
+// Tells the kernel that `data` is read at random, e.g. an embedding table,
+// so that a fault doesn't read ahead pages that are unlikely to be used.
+void AdviseRandomAccess(const void* data, size_t nbytes);
+
+} // namespace caffe2
@@ -0,0 +1,121 @@
+#ifndef CAFFE2_UTILS_MPMC_QUEUE_H_
+#define CAFFE2_UTILS_MPMC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "caffe2/core/logging.h"
+
+namespace caffe2 {
+
+// A bounded multi-producer multi-consumer queue that doesn't take locks,
+// based on Dmitry Vyukov's algorithm: every cell carries a sequence number
+// that tells producers and consumers whether it is theirs to fill or empty,
+// so the only contention is a compare-and-swap on the head or the tail.
+//
+// TryPush and TryPop never block and return false when the queue is full or
+// empty respectively; callers decide how to wait. The capacity is rounded up
+// to a power of two. T must be default constructible and movable.
+template <typename T>
+class MPMCQueue {
+ public:
+  explicit MPMCQueue(size_t capacity)
+      : cells_(RoundUpToPowerOfTwo(capacity)),
+        mask_(cells_.size() - 1),
+        head_(0),
+        tail_(0) {
+    CAFFE_ENFORCE_GT(capacity, 0);
+    for (size_t i = 0; i < cells_.size(); ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  bool TryPush(T&& value) {
+    Cell* cell;
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq) -
+          static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // the consumer of the previous lap hasn't emptied this cell yet
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = std::move(value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool TryPop(T* value) {
+    Cell* cell;
+    size_t pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq) -
+          static_cast<std::ptrdiff_t>(pos + 1);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // the producer for this cell hasn't filled it yet
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+    *value = std::move(cell->value);
+    // leave nothing behind that could keep resources alive
+    cell->value = T();
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t capacity() const {
+    return cells_.size();
+  }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t result = 1;
+    while (result < n) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  std::vector<Cell> cells_;
+  const size_t mask_;
+  // head and tail are padded onto their own cache lines, so that producers
+  // and consumers don't invalidate each other's (alignas would need C++17
+  // aligned new)
+  char head_padding_[kCacheLineSize];
+  std::atomic<size_t> head_;
+  char tail_padding_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> tail_;
+  char end_padding_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_UTILS_MPMC_QUEUE_H_
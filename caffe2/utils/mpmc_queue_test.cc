@@ -0,0 +1,87 @@
+#include <atomic>
+#include <thread> // NOLINT
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "caffe2/utils/mpmc_queue.h"
+#include "caffe2/utils/thread_pool.h"
+
+namespace caffe2 {
+
+TEST(MPMCQueueTest, Bounded) {
+  MPMCQueue<int> queue(3);
+  EXPECT_EQ(queue.capacity(), 4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.TryPush(std::move(i)));
+  }
+  EXPECT_FALSE(queue.TryPush(4));
+  int value;
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.TryPop(&value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.TryPop(&value));
+}
+
+TEST(MPMCQueueTest, MultipleProducersMultipleConsumers) {
+  constexpr int kThreads = 4;
+  constexpr int kValuesPerThread = 10000;
+  MPMCQueue<int> queue(64);
+  std::atomic<long> sum(0);
+  std::atomic<int> popped(0);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&queue, t]() {
+      for (int i = 0; i < kValuesPerThread; ++i) {
+        int value = t * kValuesPerThread + i;
+        while (!queue.TryPush(std::move(value))) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&]() {
+      int value;
+      while (popped < kThreads * kValuesPerThread) {
+        if (queue.TryPop(&value)) {
+          sum += value;
+          ++popped;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  long n = kThreads * kValuesPerThread;
+  EXPECT_EQ(sum, n * (n - 1) / 2);
+}
+
+TEST(TaskThreadPoolTest, LockFree) {
+  // a tiny queue, so that most tasks spill over
+  TaskThreadPool pool(4, -1, 2);
+  EXPECT_TRUE(pool.isLockFree());
+  std::atomic<int> count(0);
+  for (int i = 0; i < 1000; ++i) {
+    pool.run([&count]() { ++count; });
+  }
+  pool.waitWorkComplete();
+  EXPECT_EQ(count, 1000);
+
+  // tasks that schedule more tasks, and workers that went to sleep
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  std::function<void(int)> spawn = [&](int depth) {
+    ++count;
+    if (depth > 0) {
+      pool.run([&spawn, depth]() { spawn(depth - 1); });
+      pool.run([&spawn, depth]() { spawn(depth - 1); });
+    }
+  };
+  pool.run([&spawn]() { spawn(9); });
+  pool.waitWorkComplete();
+  EXPECT_EQ(count, 1000 + 1023);
+}
+
+} // namespace caffe2
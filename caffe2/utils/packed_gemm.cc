@@ -0,0 +1,301 @@
+#include "caffe2/utils/packed_gemm.h"
+
+#include <algorithm>
+
+#include "caffe2/core/macros.h"
+#include "caffe2/core/operator.h"
+
+#ifdef CAFFE2_USE_MKL
+#include <mkl.h>
+#include "caffe2/mkl/utils/mkl_version_check.h"
+#endif // CAFFE2_USE_MKL
+
+namespace caffe2 {
+
+CAFFE_KNOWN_TYPE(PackedGemmMatrixFP32);
+
+PackedGemmMatrixFP32::PackedGemmMatrixFP32(
+    Operand operand,
+    CBLAS_TRANSPOSE trans,
+    int groups,
+    int rows,
+    int cols,
+    const TensorCPU& W)
+    : operand_(operand), groups_(groups), dims_(W.dims()) {
+  CAFFE_ENFORCE_GT(groups, 0);
+  CAFFE_ENFORCE_EQ(
+      static_cast<TIndex>(groups) * rows * cols,
+      W.size(),
+      "Weight of shape ",
+      W.dims(),
+      " is not ",
+      groups,
+      " matrices of ",
+      rows,
+      " x ",
+      cols);
+  rows_ = trans == CblasTrans ? cols : rows;
+  cols_ = trans == CblasTrans ? rows : cols;
+  data_.resize(W.size());
+  const float* W_data = W.data<float>();
+  for (int g = 0; g < groups; ++g) {
+    const float* src = W_data + static_cast<size_t>(g) * rows * cols;
+    float* dst = data_.data() + static_cast<size_t>(g) * rows * cols;
+    if (trans == CblasTrans) {
+      // Row-major dst is the column-major view of W_g
+      EigenMatrixMap<float>(dst, rows, cols) =
+          ConstEigenMatrixMap<float>(src, cols, rows).transpose();
+    } else {
+      std::copy(src, src + rows * cols, dst);
+    }
+  }
+}
+
+PackedGemmMatrixFP32::~PackedGemmMatrixFP32() {
+#ifdef CAFFE2_HAS_MKL_SGEMM_PACK
+  for (auto& packed : mkl_packed_) {
+    cblas_sgemm_free(packed.second);
+  }
+#endif // CAFFE2_HAS_MKL_SGEMM_PACK
+}
+
+void PackedGemmMatrixFP32::Gemm(
+    int group,
+    int size,
+    const float* X,
+    float beta,
+    float* C) const {
+  DCHECK_LT(group, groups_);
+#ifdef CAFFE2_HAS_MKL_SGEMM_PACK
+  const CBLAS_IDENTIFIER identifier =
+      operand_ == A ? CblasAMatrix : CblasBMatrix;
+  const int M = operand_ == A ? rows_ : size;
+  const int N = operand_ == A ? size : cols_;
+  const int K = operand_ == A ? cols_ : rows_;
+  float* packed = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = mkl_packed_[std::make_pair(group, size)];
+    if (!entry) {
+      entry = cblas_sgemm_alloc(identifier, M, N, K);
+      CAFFE_ENFORCE(entry, "MKL runtime error: cannot allocate sgemm memory.");
+      cblas_sgemm_pack(
+          CblasRowMajor,
+          identifier,
+          CblasNoTrans,
+          M,
+          N,
+          K,
+          1.f,
+          group_data(group),
+          operand_ == A ? K : N,
+          entry);
+    }
+    packed = entry;
+  }
+  if (operand_ == A) {
+    cblas_sgemm_compute(
+        CblasRowMajor,
+        CblasPacked,
+        CblasNoTrans,
+        M,
+        N,
+        K,
+        packed,
+        K,
+        X,
+        N,
+        beta,
+        C,
+        N);
+  } else {
+    cblas_sgemm_compute(
+        CblasRowMajor,
+        CblasNoTrans,
+        CblasPacked,
+        M,
+        N,
+        K,
+        X,
+        K,
+        packed,
+        N,
+        beta,
+        C,
+        N);
+  }
+#else
+  CPUContext context;
+  if (operand_ == A) {
+    math::Gemm<float, CPUContext>(
+        CblasNoTrans,
+        CblasNoTrans,
+        rows_,
+        size,
+        cols_,
+        1,
+        group_data(group),
+        X,
+        beta,
+        C,
+        &context);
+  } else {
+    math::Gemm<float, CPUContext>(
+        CblasNoTrans,
+        CblasNoTrans,
+        size,
+        cols_,
+        rows_,
+        1,
+        X,
+        group_data(group),
+        beta,
+        C,
+        &context);
+  }
+#endif // CAFFE2_HAS_MKL_SGEMM_PACK
+}
+
+namespace {
+
+struct Packing {
+  PackedGemmMatrixFP32::Operand operand;
+  CBLAS_TRANSPOSE trans;
+  int groups;
+  int rows;
+  int cols;
+};
+
+// How the operator multiplies by its weight, input 1. Returns false for the
+// operators and configurations that don't accept packed weights.
+bool GetPacking(
+    const OperatorDef& op,
+    const std::vector<TIndex>& dims,
+    Packing* packing) {
+  ArgumentHelper args(op);
+  if (op.type() == "FC" || op.type() == "FCTransposed") {
+    const int axis_w = canonical_axis_index_(
+        args.GetSingleArgument<int32_t>("axis_w", 1), dims.size());
+    const bool transposed = op.type() == "FCTransposed";
+    *packing = {PackedGemmMatrixFP32::B,
+                transposed ? CblasNoTrans : CblasTrans,
+                1,
+                static_cast<int>(size_to_dim_(axis_w, dims)),
+                static_cast<int>(size_from_dim_(axis_w, dims))};
+    return true;
+  }
+  if (op.type() == "Conv" && dims.size() >= 3) {
+    const int groups = args.GetSingleArgument<int>("group", 1);
+    const int M = dims[0];
+    const int kernel_dim = size_from_dim_(1, dims);
+    if (M % groups != 0) {
+      return false;
+    }
+    if (args.GetSingleArgument<string>("order", "NCHW") == "NCHW") {
+      *packing = {
+          PackedGemmMatrixFP32::A, CblasNoTrans, groups, M / groups, kernel_dim};
+      return true;
+    }
+    // The NHWC path has no groups and is 2D only
+    if (groups == 1 && dims.size() == 4) {
+      *packing = {PackedGemmMatrixFP32::B, CblasTrans, 1, M, kernel_dim};
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+int PackGemmWeights(
+    NetDef* net,
+    Workspace* ws,
+    std::unordered_set<std::string>* constants) {
+  // A blob written by the net is not constant, whatever the init net did
+  std::unordered_set<std::string> written;
+  std::map<std::string, int> reads;
+  for (const auto& op : net->op()) {
+    for (const auto& output : op.output()) {
+      written.insert(output);
+    }
+    for (const auto& input : op.input()) {
+      ++reads[input];
+    }
+  }
+  for (const auto& output : net->external_output()) {
+    ++reads[output];
+  }
+
+  int num_packed = 0;
+  std::map<std::string, int> rewritten;
+  for (auto& op : *net->mutable_op()) {
+    if (op.input_size() < 2 || !op.engine().empty() ||
+        (op.has_device_option() && op.device_option().device_type() != CPU)) {
+      continue;
+    }
+    const std::string name = op.input(1);
+    if (!constants->count(name) || written.count(name)) {
+      continue;
+    }
+    const Blob* blob = ws->GetBlob(name);
+    if (!blob || !blob->IsType<TensorCPU>()) {
+      continue;
+    }
+    const auto& W = blob->Get<TensorCPU>();
+    Packing packing;
+    if (!W.IsType<float>() || W.size() == 0 ||
+        !GetPacking(op, W.dims(), &packing)) {
+      continue;
+    }
+
+    const std::string packed_name = name + "_packed";
+    if (!ws->HasBlob(packed_name)) {
+      ws->CreateBlob(packed_name)
+          ->Reset(new PackedGemmMatrixFP32(
+              packing.operand,
+              packing.trans,
+              packing.groups,
+              packing.rows,
+              packing.cols,
+              W));
+      ++num_packed;
+    } else {
+      // Already packed for another operator, which has to agree on the layout
+      const Blob* packed_blob = ws->GetBlob(packed_name);
+      if (!packed_blob->IsType<PackedGemmMatrixFP32>()) {
+        continue;
+      }
+      const auto& packed = packed_blob->Get<PackedGemmMatrixFP32>();
+      const bool trans = packing.trans == CblasTrans;
+      if (packed.operand() != packing.operand ||
+          packed.groups() != packing.groups ||
+          packed.rows() != (trans ? packing.cols : packing.rows) ||
+          packed.cols() != (trans ? packing.rows : packing.cols)) {
+        continue;
+      }
+    }
+    op.set_input(1, packed_name);
+    ++rewritten[name];
+  }
+
+  for (const auto& it : rewritten) {
+    const std::string& name = it.first;
+    const std::string packed_name = name + "_packed";
+    constants->insert(packed_name);
+    auto* inputs = net->mutable_external_input();
+    if (it.second == reads[name]) {
+      // Nothing reads the unpacked weight anymore
+      ws->RemoveBlob(name);
+      constants->erase(name);
+      inputs->erase(
+          std::remove(inputs->begin(), inputs->end(), name), inputs->end());
+    }
+    if (std::find(inputs->begin(), inputs->end(), packed_name) ==
+        inputs->end()) {
+      net->add_external_input(packed_name);
+    }
+  }
+  return num_packed;
+}
+
+} // namespace caffe2
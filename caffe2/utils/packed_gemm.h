@@ -0,0 +1,125 @@
+#ifndef CAFFE2_UTILS_PACKED_GEMM_H_
+#define CAFFE2_UTILS_PACKED_GEMM_H_
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+/**
+ * A constant float weight packed once for the CPU GEMM backend, which the FC
+ * and Conv operators accept in place of their weight tensor.
+ *
+ * The weight holds `groups` matrices stacked along its first dimension, and
+ * op(W_g) is one operand of the product: the left one (A) for Conv in NCHW
+ * order, the right one (B) for FC and Conv in NHWC order. op(W_g) is stored
+ * untransposed, so that the GEMM never reads the weight through a transpose.
+ * With MKL it is also packed with cblas_sgemm_pack the first time it is used
+ * with a given size of the other operand, as MKL packs for one shape.
+ */
+class PackedGemmMatrixFP32 {
+ public:
+  enum Operand { A, B };
+
+  PackedGemmMatrixFP32() {}
+  // W is read as `groups` row-major matrices W_g of rows x cols, and op(W_g)
+  // is their transpose when trans is CblasTrans
+  PackedGemmMatrixFP32(
+      Operand operand,
+      CBLAS_TRANSPOSE trans,
+      int groups,
+      int rows,
+      int cols,
+      const TensorCPU& W);
+  ~PackedGemmMatrixFP32();
+
+  // Dimensions of the weight tensor that was packed
+  const std::vector<TIndex>& dims() const {
+    return dims_;
+  }
+  Operand operand() const {
+    return operand_;
+  }
+  int groups() const {
+    return groups_;
+  }
+  // op(W_g) is rows() x cols()
+  int rows() const {
+    return rows_;
+  }
+  int cols() const {
+    return cols_;
+  }
+
+  // Operand A: C = op(W_g) * X + beta * C, X is cols() x size
+  // Operand B: C = X * op(W_g) + beta * C, X is size x rows()
+  void Gemm(int group, int size, const float* X, float beta, float* C) const;
+
+ private:
+  const float* group_data(int group) const {
+    return data_.data() + static_cast<size_t>(group) * rows_ * cols_;
+  }
+
+  Operand operand_ = B;
+  int groups_ = 0;
+  int rows_ = 0;
+  int cols_ = 0;
+  std::vector<TIndex> dims_;
+  std::vector<float> data_;
+  // MKL packed matrices by (group, size of the other operand)
+  mutable std::mutex mutex_;
+  mutable std::map<std::pair<int, int>, float*> mkl_packed_;
+
+  DISABLE_COPY_AND_ASSIGN(PackedGemmMatrixFP32);
+};
+
+// Called by the operators that accept packed weights, only CPUContext has it.
+inline void PackedGemm(
+    const PackedGemmMatrixFP32& W,
+    int group,
+    int size,
+    const float* X,
+    float beta,
+    float* C,
+    CPUContext* /*context*/) {
+  W.Gemm(group, size, X, beta, C);
+}
+
+template <typename T_X, typename T_C, class Context>
+void PackedGemm(
+    const PackedGemmMatrixFP32& /*W*/,
+    int /*group*/,
+    int /*size*/,
+    const T_X* /*X*/,
+    float /*beta*/,
+    T_C* /*C*/,
+    Context* /*context*/) {
+  CAFFE_THROW("Packed GEMM weights are only supported for float on CPU.");
+}
+
+/**
+ * Predictor-time transform: packs the weights of the CPU FC, FCTransposed and
+ * Conv operators of `net` that are blobs of `constants` (the parameters the
+ * init net created) and rewrites the operators to read the packed blob
+ * `<weight>_packed`. A weight that no other operator reads is removed from
+ * `ws`. `constants` is updated with the blobs added and removed. Returns the
+ * number of weights packed.
+ */
+int PackGemmWeights(
+    NetDef* net,
+    Workspace* ws,
+    std::unordered_set<std::string>* constants);
+
+} // namespace caffe2
+
+#endif // CAFFE2_UTILS_PACKED_GEMM_H_
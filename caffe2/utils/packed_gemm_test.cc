@@ -0,0 +1,162 @@
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/utils/math.h"
+#include "caffe2/utils/packed_gemm.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+namespace {
+
+void AddRandomInput(
+    const std::vector<TIndex>& shape,
+    const std::string& name,
+    Workspace* ws) {
+  CPUContext context;
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(shape);
+  math::RandGaussian<float, CPUContext>(
+      tensor->size(), 0.0f, 1.0f, tensor->mutable_data<float>(), &context);
+}
+
+// Runs `net` twice, with the weights as tensors and packed by
+// PackGemmWeights, and checks that the outputs match.
+void ExpectSameOutputsWhenPacked(
+    const NetDef& net,
+    Workspace* ws,
+    const std::unordered_set<std::string>& constants,
+    int expected_packed) {
+  ASSERT_TRUE(ws->RunNetOnce(net));
+  std::vector<TensorCPU> expected;
+  for (const auto& output : net.external_output()) {
+    expected.emplace_back(ws->GetBlob(output)->Get<TensorCPU>());
+  }
+
+  NetDef packed_net = net;
+  auto packed_constants = constants;
+  EXPECT_EQ(
+      PackGemmWeights(&packed_net, ws, &packed_constants), expected_packed);
+  for (const auto& op : packed_net.op()) {
+    const Blob* weight = ws->GetBlob(op.input(1));
+    ASSERT_NE(weight, nullptr);
+    EXPECT_TRUE(weight->IsType<PackedGemmMatrixFP32>());
+  }
+  ASSERT_TRUE(ws->RunNetOnce(packed_net));
+  for (int i = 0; i < net.external_output_size(); ++i) {
+    const auto& actual = ws->GetBlob(net.external_output(i))->Get<TensorCPU>();
+    ASSERT_EQ(actual.dims(), expected[i].dims());
+    for (int j = 0; j < actual.size(); ++j) {
+      EXPECT_NEAR(
+          actual.data<float>()[j], expected[i].data<float>()[j], 1e-4);
+    }
+  }
+}
+
+} // namespace
+
+TEST(PackedGemmTest, FC) {
+  Workspace ws;
+  AddRandomInput({5, 3, 4}, "X", &ws);
+  AddRandomInput({7, 12}, "W", &ws);
+  AddRandomInput({7}, "b", &ws);
+  AddRandomInput({12, 7}, "W_t", &ws);
+
+  NetDef net;
+  *net.add_op() = CreateOperatorDef("FC", "", {"X", "W", "b"}, {"Y"});
+  *net.add_op() =
+      CreateOperatorDef("FCTransposed", "", {"X", "W_t", "b"}, {"Y_t"});
+  net.add_external_input("X");
+  net.add_external_input("W");
+  net.add_external_input("b");
+  net.add_external_input("W_t");
+  net.add_external_output("Y");
+  net.add_external_output("Y_t");
+  ExpectSameOutputsWhenPacked(net, &ws, {"W", "b", "W_t"}, 2);
+}
+
+TEST(PackedGemmTest, Conv) {
+  Workspace ws;
+  AddRandomInput({2, 4, 6, 5}, "X", &ws);
+  AddRandomInput({6, 2, 3, 3}, "W", &ws);
+  AddRandomInput({6}, "b", &ws);
+  AddRandomInput({2, 6, 5, 4}, "X_nhwc", &ws);
+  AddRandomInput({3, 3, 3, 4}, "W_nhwc", &ws);
+  AddRandomInput({3, 1, 1, 4}, "W_1x1", &ws);
+
+  NetDef net;
+  *net.add_op() = CreateOperatorDef(
+      "Conv",
+      "",
+      {"X", "W", "b"},
+      {"Y"},
+      {MakeArgument<int>("kernel", 3),
+       MakeArgument<int>("pad", 1),
+       MakeArgument<int>("group", 2)});
+  *net.add_op() = CreateOperatorDef(
+      "Conv",
+      "",
+      {"X_nhwc", "W_nhwc"},
+      {"Y_nhwc"},
+      {MakeArgument<int>("kernel", 3),
+       MakeArgument<int>("stride", 2),
+       MakeArgument<std::string>("order", "NHWC")});
+  *net.add_op() = CreateOperatorDef(
+      "Conv",
+      "",
+      {"X_nhwc", "W_1x1"},
+      {"Y_1x1"},
+      {MakeArgument<int>("kernel", 1),
+       MakeArgument<std::string>("order", "NHWC")});
+  net.add_external_output("Y");
+  net.add_external_output("Y_nhwc");
+  net.add_external_output("Y_1x1");
+  ExpectSameOutputsWhenPacked(net, &ws, {"W", "b", "W_nhwc", "W_1x1"}, 3);
+}
+
+TEST(PackedGemmTest, OnlyConstantWeightsArePacked) {
+  Workspace ws;
+  AddRandomInput({4, 8}, "X", &ws);
+  AddRandomInput({3, 8}, "W", &ws);
+  AddRandomInput({3}, "b", &ws);
+  AddRandomInput({3, 8}, "W_input", &ws);
+
+  NetDef net;
+  *net.add_op() = CreateOperatorDef("FC", "", {"X", "W", "b"}, {"Y"});
+  *net.add_op() = CreateOperatorDef("FC", "", {"X", "W_input", "b"}, {"Z"});
+  // W is read by another operator, so it has to stay
+  *net.add_op() = CreateOperatorDef("Copy", "", {"W"}, {"W_copy"});
+  net.add_external_input("X");
+  net.add_external_input("W");
+  net.add_external_input("b");
+  net.add_external_input("W_input");
+
+  std::unordered_set<std::string> constants{"W", "b"};
+  EXPECT_EQ(PackGemmWeights(&net, &ws, &constants), 1);
+  EXPECT_EQ(net.op(0).input(1), "W_packed");
+  EXPECT_EQ(net.op(1).input(1), "W_input");
+  EXPECT_TRUE(ws.HasBlob("W"));
+  EXPECT_TRUE(constants.count("W_packed"));
+  ASSERT_TRUE(ws.RunNetOnce(net));
+
+  // Without the Copy the unpacked weight is freed
+  net.mutable_op()->RemoveLast();
+  net.mutable_op(0)->set_input(1, "W");
+  ws.RemoveBlob("W_packed");
+  EXPECT_EQ(PackGemmWeights(&net, &ws, &constants), 1);
+  EXPECT_FALSE(ws.HasBlob("W"));
+  EXPECT_FALSE(constants.count("W"));
+  for (const auto& input : net.external_input()) {
+    EXPECT_NE(input, "W");
+  }
+  ASSERT_TRUE(ws.RunNetOnce(net));
+}
+
+} // namespace caffe2
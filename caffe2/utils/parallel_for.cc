@@ -0,0 +1,90 @@
+#include "caffe2/utils/parallel_for.h"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/thread_budget.h"
+
+// Off by default on servers, where inter-op parallelism of the net executors
+// and multithreaded BLAS already keep the cores busy.
+CAFFE2_DEFINE_bool(
+    caffe2_intra_op_parallelism,
+#if CAFFE2_MOBILE
+    true,
+#else
+    false,
+#endif
+    "Split the work of CPU operators between the threads of the workspace "
+    "thread pool");
+
+namespace caffe2 {
+
+namespace {
+
+thread_local bool inParallelRegion = false;
+
+class ParallelRegionGuard {
+ public:
+  ParallelRegionGuard() : previous_(inParallelRegion) {
+    inParallelRegion = true;
+  }
+  ~ParallelRegionGuard() {
+    inParallelRegion = previous_;
+  }
+
+ private:
+  const bool previous_;
+};
+
+} // namespace
+
+void ParallelFor(
+    ThreadPool* pool,
+    size_t range,
+    size_t grain,
+    const std::function<void(size_t, size_t)>& fn) {
+  if (range == 0) {
+    return;
+  }
+  size_t numChunks = 1;
+  if (pool && FLAGS_caffe2_intra_op_parallelism && !inParallelRegion) {
+    numChunks = std::min<size_t>(
+        pool->getNumThreads(), range / std::max<size_t>(grain, 1));
+    // The async net executors may have given the operator fewer threads
+    if (IntraOpThreadLimit() > 0) {
+      numChunks = std::min<size_t>(numChunks, IntraOpThreadLimit());
+    }
+  }
+  if (numChunks <= 1) {
+    fn(0, range);
+    return;
+  }
+
+  const size_t chunkSize = (range + numChunks - 1) / numChunks;
+  numChunks = (range + chunkSize - 1) / chunkSize;
+  // An exception thrown on a worker thread is rethrown on the calling one
+  std::mutex exceptionMutex;
+  std::exception_ptr exception;
+  pool->run(
+      [&](int /* threadId */, size_t chunk) {
+        ParallelRegionGuard guard;
+        const size_t begin = chunk * chunkSize;
+        try {
+          fn(begin, std::min(range, begin + chunkSize));
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(exceptionMutex);
+          if (!exception) {
+            exception = std::current_exception();
+          }
+        }
+      },
+      numChunks,
+      /* minWorkSize */ 2);
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+} // namespace caffe2
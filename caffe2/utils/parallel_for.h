@@ -0,0 +1,36 @@
+#ifndef CAFFE2_UTILS_PARALLEL_FOR_H_
+#define CAFFE2_UTILS_PARALLEL_FOR_H_
+
+#include <cstddef>
+#include <functional>
+
+#include "caffe2/core/flags.h"
+#include "caffe2/utils/threadpool/ThreadPool.h"
+
+CAFFE2_DECLARE_bool(caffe2_intra_op_parallelism);
+
+namespace caffe2 {
+
+/**
+ * Runs fn(begin, end) over disjoint chunks that cover [0, range), on the
+ * threads of pool. The range is split in at most one chunk per thread, each of
+ * at least `grain` iterations, so that an operator passes the smallest amount
+ * of work worth a thread handoff rather than a number of threads. The number
+ * of chunks is also capped by the limit of an IntraOpThreadsGuard, which the
+ * async net executors set to share the cores between operators that run in
+ * parallel.
+ *
+ * Everything runs on the calling thread, as a single chunk, when pool is null,
+ * when there is too little work for two chunks, when intra-op parallelism is
+ * disabled with --caffe2_intra_op_parallelism, or when called from within
+ * another ParallelFor (the pool runs one job at a time).
+ */
+void ParallelFor(
+    ThreadPool* pool,
+    size_t range,
+    size_t grain,
+    const std::function<void(size_t, size_t)>& fn);
+
+} // namespace caffe2
+
+#endif // CAFFE2_UTILS_PARALLEL_FOR_H_
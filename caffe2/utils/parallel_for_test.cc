@@ -0,0 +1,104 @@
+#include <atomic>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "caffe2/core/flags.h"
+#include "caffe2/utils/parallel_for.h"
+#include "caffe2/utils/threadpool/ThreadPool.h"
+
+namespace caffe2 {
+
+namespace {
+
+class ParallelForTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    enabled_ = FLAGS_caffe2_intra_op_parallelism;
+    FLAGS_caffe2_intra_op_parallelism = true;
+  }
+  void TearDown() override {
+    FLAGS_caffe2_intra_op_parallelism = enabled_;
+  }
+
+ private:
+  bool enabled_;
+};
+
+// Counts how many times each index of [0, range) is visited
+std::vector<int> visitCounts(ThreadPool* pool, size_t range, size_t grain) {
+  std::vector<std::atomic<int>> counts(range);
+  for (auto& count : counts) {
+    count = 0;
+  }
+  ParallelFor(pool, range, grain, [&](size_t begin, size_t end) {
+    EXPECT_LT(begin, end);
+    EXPECT_LE(end, range);
+    for (size_t i = begin; i < end; ++i) {
+      ++counts[i];
+    }
+  });
+  return std::vector<int>(counts.begin(), counts.end());
+}
+
+} // namespace
+
+TEST_F(ParallelForTest, CoversRangeOnce) {
+  ThreadPool pool(4);
+  for (size_t range : {1, 3, 7, 64, 1000, 1001}) {
+    for (size_t grain : {1, 2, 100}) {
+      EXPECT_EQ(visitCounts(&pool, range, grain), std::vector<int>(range, 1))
+          << "range " << range << " grain " << grain;
+    }
+  }
+  EXPECT_EQ(visitCounts(nullptr, 10, 1), std::vector<int>(10, 1));
+}
+
+TEST_F(ParallelForTest, SplitsByGrain) {
+  ThreadPool pool(4);
+  std::atomic<int> chunks(0);
+  ParallelFor(&pool, 100, 1, [&](size_t, size_t) { ++chunks; });
+  EXPECT_EQ(chunks, 4);
+
+  // Too little work for two chunks
+  chunks = 0;
+  ParallelFor(&pool, 100, 60, [&](size_t, size_t) { ++chunks; });
+  EXPECT_EQ(chunks, 1);
+
+  FLAGS_caffe2_intra_op_parallelism = false;
+  chunks = 0;
+  ParallelFor(&pool, 100, 1, [&](size_t, size_t) { ++chunks; });
+  EXPECT_EQ(chunks, 1);
+}
+
+TEST_F(ParallelForTest, NestedRunsInline) {
+  ThreadPool pool(4);
+  std::atomic<int> inner(0);
+  ParallelFor(&pool, 8, 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      ParallelFor(&pool, 100, 1, [&](size_t b, size_t e) {
+        EXPECT_EQ(b, 0);
+        EXPECT_EQ(e, 100);
+        ++inner;
+      });
+    }
+  });
+  EXPECT_EQ(inner, 8);
+}
+
+TEST_F(ParallelForTest, RethrowsOnCallingThread) {
+  ThreadPool pool(4);
+  EXPECT_THROW(
+      ParallelFor(
+          &pool,
+          100,
+          1,
+          [&](size_t begin, size_t) {
+            if (begin > 0) {
+              throw std::runtime_error("chunk failed");
+            }
+          }),
+      std::runtime_error);
+}
+
+} // namespace caffe2
@@ -69,7 +69,8 @@ bool IsSameDevice(const DeviceOption& lhs, const DeviceOption& rhs) {
       lhs.device_type() == rhs.device_type() &&
       lhs.cuda_gpu_id() == rhs.cuda_gpu_id() &&
       lhs.node_name() == rhs.node_name() &&
-      lhs.numa_node_id() == rhs.numa_node_id());
+      lhs.numa_node_id() == rhs.numa_node_id() &&
+      lhs.cuda_high_priority() == rhs.cuda_high_priority());
 }
 
 bool ReadStringFromFile(const char* filename, string* str) {
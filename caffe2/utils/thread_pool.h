@@ -1,51 +1,86 @@
 #ifndef CAFFE2_UTILS_THREAD_POOL_H_
 #define CAFFE2_UTILS_THREAD_POOL_H_
 
+#include <atomic>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
 #include <utility>
 
 #include "caffe2/core/numa.h"
+#include "caffe2/utils/mpmc_queue.h"
 
 namespace caffe2 {
 
+// By default tasks go through a queue guarded by a mutex, and idle workers
+// sleep on a condition variable. A pool created with a non-zero
+// lock_free_capacity instead uses a bounded lock-free queue of that capacity,
+// and idle workers spin for a while before going to sleep, so that a stream of
+// small tasks doesn't pay for a futex wake-up per task. Tasks that don't fit
+// in the lock-free queue spill over into the mutex-guarded one.
 class TaskThreadPool {
  private:
   struct task_element_t {
     bool run_with_id;
-    const std::function<void()> no_id;
-    const std::function<void(std::size_t)> with_id;
+    std::function<void()> no_id;
+    std::function<void(std::size_t)> with_id;
 
+    task_element_t() : run_with_id(false), no_id(nullptr), with_id(nullptr) {}
     explicit task_element_t(const std::function<void()>& f)
         : run_with_id(false), no_id(f), with_id(nullptr) {}
     explicit task_element_t(const std::function<void(std::size_t)>& f)
         : run_with_id(true), no_id(nullptr), with_id(f) {}
   };
 
+  // Number of times an idle worker polls the lock-free queue before sleeping
+  static constexpr int kSpinIterations = 1000;
+
   std::queue<task_element_t> tasks_;
   std::vector<std::thread> threads_;
   std::mutex mutex_;
   std::condition_variable condition_;
   std::condition_variable completed_;
-  bool running_;
+  std::atomic<bool> running_;
   bool complete_;
   std::size_t available_;
   std::size_t total_;
   int numa_node_id_;
 
+  // Lock-free mode only
+  std::unique_ptr<MPMCQueue<task_element_t>> lock_free_tasks_;
+  // tasks pushed and not yet taken by a worker
+  std::atomic<std::size_t> pending_;
+  // tasks pushed and not yet finished
+  std::atomic<std::size_t> unfinished_;
+  std::atomic<std::size_t> sleeping_;
+
  public:
-  explicit TaskThreadPool(std::size_t pool_size, int numa_node_id = -1)
+  explicit TaskThreadPool(
+      std::size_t pool_size,
+      int numa_node_id = -1,
+      std::size_t lock_free_capacity = 0)
       : threads_(pool_size),
         running_(true),
         complete_(true),
         available_(pool_size),
         total_(pool_size),
-        numa_node_id_(numa_node_id) {
+        numa_node_id_(numa_node_id),
+        pending_(0),
+        unfinished_(0),
+        sleeping_(0) {
+    if (lock_free_capacity > 0) {
+      lock_free_tasks_.reset(
+          new MPMCQueue<task_element_t>(lock_free_capacity));
+    }
     for (std::size_t i = 0; i < pool_size; ++i) {
-      threads_[i] = std::thread(std::bind(&TaskThreadPool::main_loop, this, i));
+      threads_[i] = std::thread(std::bind(
+          lock_free_tasks_ ? &TaskThreadPool::lock_free_main_loop
+                           : &TaskThreadPool::main_loop,
+          this,
+          i));
     }
   }
 
@@ -69,9 +104,27 @@ class TaskThreadPool {
     return threads_.size();
   }
 
+  bool isLockFree() const {
+    return lock_free_tasks_ != nullptr;
+  }
+
+  /// @brief Number of tasks waiting for a worker.
+  std::size_t numQueuedTasks() {
+    if (lock_free_tasks_) {
+      return pending_;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    return tasks_.size();
+  }
+
   /// @brief Add task to the thread pool if a thread is currently available.
   template <typename Task>
   void runTask(Task task) {
+    if (lock_free_tasks_) {
+      lock_free_push(
+          task_element_t(static_cast<std::function<void()>>(task)));
+      return;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
 
     // Set task and signal condition variable so that a worker thread will
@@ -87,6 +140,11 @@ class TaskThreadPool {
 
   template <typename Task>
   void runTaskWithID(Task task) {
+    if (lock_free_tasks_) {
+      lock_free_push(
+          task_element_t(static_cast<std::function<void(std::size_t)>>(task)));
+      return;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
 
     // Set task and signal condition variable so that a worker thread will
@@ -100,12 +158,93 @@ class TaskThreadPool {
   /// @brief Wait for queue to be empty
   void waitWorkComplete() {
     std::unique_lock<std::mutex> lock(mutex_);
+    if (lock_free_tasks_) {
+      while (unfinished_ > 0) {
+        completed_.wait(lock);
+      }
+      return;
+    }
     while (!complete_) {
       completed_.wait(lock);
     }
   }
 
  private:
+  void lock_free_push(task_element_t&& task) {
+    ++unfinished_;
+    // Counted before it is pushed, so that pending_ never underflows. Workers
+    // that see it non-zero keep polling until the task shows up.
+    ++pending_;
+    if (!lock_free_tasks_->TryPush(std::move(task))) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      tasks_.push(std::move(task));
+    }
+    // pending_ and sleeping_ are sequentially consistent: either we see the
+    // worker that is about to sleep, or it sees this task (see
+    // lock_free_main_loop)
+    if (sleeping_ > 0) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.notify_one();
+    }
+  }
+
+  bool lock_free_pop(task_element_t* task) {
+    if (pending_ == 0) {
+      return false;
+    }
+    if (!lock_free_tasks_->TryPop(task)) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (tasks_.empty()) {
+        return false;
+      }
+      *task = std::move(tasks_.front());
+      tasks_.pop();
+    }
+    --pending_;
+    return true;
+  }
+
+  void lock_free_main_loop(std::size_t index) {
+    NUMABind(numa_node_id_);
+
+    task_element_t task;
+    while (running_) {
+      bool found = false;
+      for (int i = 0; i < kSpinIterations && running_; ++i) {
+        if (lock_free_pop(&task)) {
+          found = true;
+          break;
+        }
+        std::this_thread::yield();
+      }
+      if (!found) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++sleeping_;
+        while (pending_ == 0 && running_) {
+          condition_.wait(lock);
+        }
+        --sleeping_;
+        continue;
+      }
+
+      try {
+        if (task.run_with_id) {
+          task.with_id(index);
+        } else {
+          task.no_id();
+        }
+      } catch (const std::exception&) {
+      }
+      // destroy the task's state before reporting it finished
+      task = task_element_t();
+
+      if (--unfinished_ == 0) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        completed_.notify_all();
+      }
+    }
+  }
+
   /// @brief Entry point for pool threads.
   void main_loop(std::size_t index) {
     NUMABind(numa_node_id_);
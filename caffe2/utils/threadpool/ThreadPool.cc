@@ -3,6 +3,7 @@
 #include "caffe2/core/logging.h"
 
 #include <cpuinfo.h>
+#include <stdlib.h>
 
 CAFFE2_DEFINE_bool(caffe2_threadpool_force_inline, false,
                    "Force to always run jobs on the calling thread");
@@ -13,6 +14,9 @@ CAFFE2_DEFINE_int(caffe2_threadpool_android_cap, true, "");
 // Whether or not threadpool caps apply to iOS
 CAFFE2_DEFINE_int(caffe2_threadpool_ios_cap, true, "");
 
+// The process-wide number of intra-op threads, defined in core/init_omp.cc
+CAFFE2_DECLARE_int(caffe2_omp_num_threads);
+
 
 namespace caffe2 {
 
@@ -76,6 +80,14 @@ std::unique_ptr<ThreadPool> ThreadPool::defaultThreadPool() {
         break;
     }
   }
+  // An explicit number of intra-op threads for the process, which OpenMP, MKL
+  // and ATen also use, overrides the heuristics above.
+  const char* ompNumThreads = getenv("OMP_NUM_THREADS");
+  if (caffe2::FLAGS_caffe2_omp_num_threads > 0) {
+    numThreads = caffe2::FLAGS_caffe2_omp_num_threads;
+  } else if (ompNumThreads && atoi(ompNumThreads) > 0) {
+    numThreads = atoi(ompNumThreads);
+  }
   LOG(INFO) << "Constructing thread pool with " << numThreads << " threads";
   return caffe2::make_unique<ThreadPool>(numThreads);
 }
@@ -101,9 +113,24 @@ void ThreadPool::setMinWorkSize(size_t size) {
 
 void ThreadPool::run(const std::function<void(int, size_t)>& fn, size_t range) {
   std::lock_guard<std::mutex> guard(executionMutex_);
+  runLocked(fn, range, minWorkSize_);
+}
+
+void ThreadPool::run(
+    const std::function<void(int, size_t)>& fn,
+    size_t range,
+    size_t minWorkSize) {
+  std::lock_guard<std::mutex> guard(executionMutex_);
+  runLocked(fn, range, minWorkSize);
+}
+
+void ThreadPool::runLocked(
+    const std::function<void(int, size_t)>& fn,
+    size_t range,
+    size_t minWorkSize) {
   // If there are no worker threads, or if the range is too small (too
   // little work), just run locally
-  const bool runLocally = range < minWorkSize_ ||
+  const bool runLocally = range < minWorkSize ||
                           FLAGS_caffe2_threadpool_force_inline ||
                           (numThreads_ == 0);
   if (runLocally) {
@@ -39,12 +39,24 @@ class alignas(kCacheLineSize) ThreadPool {
   void setMinWorkSize(size_t size);
   size_t getMinWorkSize() const { return minWorkSize_; }
   void run(const std::function<void(int, size_t)>& fn, size_t range);
+  // Same as above, with the given minimum work size in place of the one of
+  // the pool, for work that the caller already split in coarse chunks
+  void run(
+      const std::function<void(int, size_t)>& fn,
+      size_t range,
+      size_t minWorkSize);
 
   // Run an arbitrary function in a thread-safe manner accessing the Workers
   // Pool
   void withPool(const std::function<void(WorkersPool*)>& fn);
 
  private:
+  // Requires executionMutex_ to be held
+  void runLocked(
+      const std::function<void(int, size_t)>& fn,
+      size_t range,
+      size_t minWorkSize);
+
   mutable std::mutex executionMutex_;
   size_t minWorkSize_;
   size_t numThreads_;
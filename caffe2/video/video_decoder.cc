@@ -15,6 +15,50 @@ extern "C" {
 
 namespace caffe2 {
 
+namespace {
+
+// Converts a decoded frame to the output pixel format and resolution
+std::unique_ptr<DecodedFrame> convertFrame(
+    SwsContext* scaleContext,
+    const AVFrame* srcFrame,
+    const int srcHeight,
+    const AVPixelFormat pixFormat,
+    const int outWidth,
+    const int outHeight) {
+  AVFrame* rgbFrame = av_frame_alloc();
+  if (!rgbFrame) {
+    LOG(ERROR) << "Error allocating AVframe";
+    return nullptr;
+  }
+  // Determine required buffer size and allocate buffer
+  int numBytes = avpicture_get_size(pixFormat, outWidth, outHeight);
+  DecodedFrame::AvDataPtr buffer(
+      (uint8_t*)av_malloc(numBytes * sizeof(uint8_t)));
+
+  int size = avpicture_fill(
+      (AVPicture*)rgbFrame, buffer.get(), pixFormat, outWidth, outHeight);
+
+  sws_scale(
+      scaleContext,
+      srcFrame->data,
+      srcFrame->linesize,
+      0,
+      srcHeight,
+      rgbFrame->data,
+      rgbFrame->linesize);
+  av_frame_free(&rgbFrame);
+
+  unique_ptr<DecodedFrame> frame = make_unique<DecodedFrame>();
+  frame->width_ = outWidth;
+  frame->height_ = outHeight;
+  frame->data_ = move(buffer);
+  frame->size_ = size;
+  frame->keyFrame_ = srcFrame->key_frame;
+  return frame;
+}
+
+} // namespace
+
 VideoDecoder::VideoDecoder() {
   static bool gInitialized = false;
   static std::mutex gMutex;
@@ -121,11 +165,33 @@ void VideoDecoder::decodeLoop(
     // Initialize codec
     AVDictionary* opts = nullptr;
     videoCodecContext_ = videoStream_->codec;
+    ret = -1;
+    if (!params.decoder_name_.empty()) {
+      AVCodec* codec =
+          avcodec_find_decoder_by_name(params.decoder_name_.c_str());
+      if (codec == nullptr || codec->id != videoCodecContext_->codec_id) {
+        LOG(WARNING) << "Decoder " << params.decoder_name_
+                     << " is not available for " << videoName
+                     << ", using the default decoder";
+      } else {
+        try {
+          ret = avcodec_open2(videoCodecContext_, codec, &opts);
+        } catch (const std::exception&) {
+          ret = -1;
+        }
+        if (ret < 0) {
+          LOG(WARNING) << "Unable to open decoder " << params.decoder_name_
+                       << ", using the default decoder";
+        }
+      }
+    }
     try {
-      ret = avcodec_open2(
-          videoCodecContext_,
-          avcodec_find_decoder(videoCodecContext_->codec_id),
-          &opts);
+      if (ret < 0) {
+        ret = avcodec_open2(
+            videoCodecContext_,
+            avcodec_find_decoder(videoCodecContext_->codec_id),
+            &opts);
+      }
     } catch (const std::exception&) {
       LOG(ERROR) << "Exception during open video codec";
       return;
@@ -298,6 +364,29 @@ void VideoDecoder::decodeLoop(
       mustDecodeAll = true;
     }
 
+    bool clipsDecoded = false;
+    if (params.seek_clips_ &&
+        params.decode_type_ == DecodeType::DO_UNIFORM_SMP &&
+        videoStream_->duration > 0 && videoStream_->nb_frames > 0) {
+      clipsDecoded = decodeClipsBySeeking(
+          inputContext,
+          videoStream_,
+          videoStreamIndex_,
+          videoCodecContext_,
+          videoStreamFrame_,
+          scaleContext_,
+          outWidth,
+          outHeight,
+          params,
+          sampledFrames);
+      if (!clipsDecoded) {
+        VLOG(1) << "Unable to seek to the clips of " << videoName
+                << ", decoding all frames";
+        av_seek_frame(inputContext, videoStreamIndex_, 0, AVSEEK_FLAG_BACKWARD);
+        avcodec_flush_buffers(videoCodecContext_);
+      }
+    }
+
     int gotPicture = 0;
     int eof = 0;
     int selectiveDecodedFrames = 0;
@@ -309,7 +398,7 @@ void VideoDecoder::decodeLoop(
     // transport and getting decoded frames back.
     // Therefore, after EOF, continue going while
     // the decoder is still giving us frames.
-    while ((!eof || gotPicture) &&
+    while (!clipsDecoded && (!eof || gotPicture) &&
            /* either you must decode all frames or decode upto maxFrames
             * based on status of the mustDecodeAll flag */
            (mustDecodeAll ||
@@ -423,48 +512,19 @@ void VideoDecoder::decodeLoop(
               break;
             }
 
-            AVFrame* rgbFrame = av_frame_alloc();
-            if (!rgbFrame) {
-              LOG(ERROR) << "Error allocating AVframe";
-            }
-
-            try {
-              // Determine required buffer size and allocate buffer
-              int numBytes = avpicture_get_size(pixFormat, outWidth, outHeight);
-              DecodedFrame::AvDataPtr buffer(
-                  (uint8_t*)av_malloc(numBytes * sizeof(uint8_t)));
-
-              int size = avpicture_fill(
-                  (AVPicture*)rgbFrame,
-                  buffer.get(),
-                  pixFormat,
-                  outWidth,
-                  outHeight);
-
-              sws_scale(
-                  scaleContext_,
-                  videoStreamFrame_->data,
-                  videoStreamFrame_->linesize,
-                  0,
-                  videoCodecContext_->height,
-                  rgbFrame->data,
-                  rgbFrame->linesize);
-
-              unique_ptr<DecodedFrame> frame = make_unique<DecodedFrame>();
-              frame->width_ = outWidth;
-              frame->height_ = outHeight;
-              frame->data_ = move(buffer);
-              frame->size_ = size;
+            unique_ptr<DecodedFrame> frame = convertFrame(
+                scaleContext_,
+                videoStreamFrame_,
+                videoCodecContext_->height,
+                pixFormat,
+                outWidth,
+                outHeight);
+            if (frame) {
               frame->index_ = frameIndex;
               frame->outputFrameIndex_ = outputFrameIndex;
               frame->timestamp_ = timestamp;
-              frame->keyFrame_ = videoStreamFrame_->key_frame;
-
               sampledFrames.push_back(move(frame));
               selectiveDecodedFrames++;
-              av_frame_free(&rgbFrame);
-            } catch (const std::exception&) {
-              av_frame_free(&rgbFrame);
             }
           }
           av_frame_unref(videoStreamFrame_);
@@ -497,6 +557,109 @@ void VideoDecoder::decodeLoop(
   }
 }
 
+bool VideoDecoder::decodeClipsBySeeking(
+    AVFormatContext* inputContext,
+    AVStream* videoStream,
+    const int videoStreamIndex,
+    AVCodecContext* videoCodecContext,
+    AVFrame* videoStreamFrame,
+    SwsContext* scaleContext,
+    const int outWidth,
+    const int outHeight,
+    const Params& params,
+    std::vector<std::unique_ptr<DecodedFrame>>& sampledFrames) {
+  // Only plain frame by frame sampling maps clips to frame ranges
+  if (params.keyFrames_ || params.intervals_.size() != 1 ||
+      params.intervals_[0].fps != SpecialFps::SAMPLE_ALL_FRAMES) {
+    return false;
+  }
+  const int64_t numFrames = videoStream->nb_frames;
+  const int clipLength = params.num_of_required_frame_;
+  const int numClips = params.clip_per_video_;
+  if (clipLength <= 0 || numClips <= 0 || numFrames < clipLength) {
+    return false;
+  }
+  const int64_t startTime =
+      videoStream->start_time == AV_NOPTS_VALUE ? 0 : videoStream->start_time;
+  // the same clip spacing as DecodeMultipleClipsFromVideo uses on the frames
+  // of the whole video
+  const double clipStep =
+      numClips > 1 ? double(numFrames - clipLength) / (numClips - 1) : 0;
+
+  AVPacket packet;
+  av_init_packet(&packet);
+  int outputFrameIndex = -1;
+  for (int i = 0; i < numClips; i++) {
+    const int64_t clipFrame = int64_t(floor(i * clipStep));
+    const int64_t clipTs = startTime +
+        int64_t(floor(double(videoStream->duration) * clipFrame / numFrames));
+    // lands on the last key frame at or before the clip, so that only the
+    // frames of one GOP are decoded before the clip starts
+    int ret = av_seek_frame(
+        inputContext, videoStreamIndex, clipTs, AVSEEK_FLAG_BACKWARD);
+    if (ret < 0) {
+      VLOG(1) << "Unable to seek: " << ffmpegErrorStr(ret);
+      sampledFrames.clear();
+      return false;
+    }
+    avcodec_flush_buffers(videoCodecContext);
+
+    int clipFrames = 0;
+    int gotPicture = 0;
+    int eof = 0;
+    while ((!eof || gotPicture) && clipFrames < clipLength) {
+      if (!eof) {
+        ret = av_read_frame(inputContext, &packet);
+        if (ret == AVERROR(EAGAIN)) {
+          av_free_packet(&packet);
+          continue;
+        }
+        if (ret < 0) {
+          // flush the frames buffered in the decoder
+          eof = 1;
+          av_free_packet(&packet);
+        } else if (packet.stream_index != videoStreamIndex) {
+          av_free_packet(&packet);
+          continue;
+        }
+      }
+      ret = avcodec_decode_video2(
+          videoCodecContext, videoStreamFrame, &gotPicture, &packet);
+      av_free_packet(&packet);
+      if (ret < 0) {
+        LOG(ERROR) << "Error decoding video frame : " << ffmpegErrorStr(ret);
+      }
+      if (!gotPicture) {
+        continue;
+      }
+      const int64_t frameTs =
+          av_frame_get_best_effort_timestamp(videoStreamFrame);
+      if (frameTs >= clipTs) {
+        unique_ptr<DecodedFrame> frame = convertFrame(
+            scaleContext,
+            videoStreamFrame,
+            videoCodecContext->height,
+            params.pixelFormat_,
+            outWidth,
+            outHeight);
+        if (frame) {
+          frame->index_ = clipFrame + clipFrames;
+          frame->outputFrameIndex_ = ++outputFrameIndex;
+          frame->timestamp_ = frameTs * av_q2d(videoStream->time_base);
+          sampledFrames.push_back(move(frame));
+          clipFrames++;
+        }
+      }
+      av_frame_unref(videoStreamFrame);
+    }
+    if (clipFrames < clipLength) {
+      sampledFrames.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
 void VideoDecoder::decodeMemory(
     const char* buffer,
     const int size,
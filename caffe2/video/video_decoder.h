@@ -12,6 +12,8 @@ extern "C" {
 #include <libavformat/avio.h>
 }
 
+struct SwsContext;
+
 namespace caffe2 {
 
 #define VIO_BUFFER_SZ 32768
@@ -95,6 +97,19 @@ class Params {
   // params for decoding behavior
   int decode_type_ = DecodeType::DO_TMP_JITTER;
   int num_of_required_frame_ = -1;
+  // number of clips sampled with DO_UNIFORM_SMP
+  int clip_per_video_ = 1;
+  // with DO_UNIFORM_SMP, seek to the key frame before every clip and decode
+  // only the clips, instead of decoding the whole video and picking the
+  // clips from it. Needs the stream duration and frame count, and falls back
+  // to decoding everything if they are missing or a clip can't be decoded.
+  // The sampled clips are then clip_per_video_ runs of
+  // num_of_required_frame_ frames.
+  bool seek_clips_ = false;
+  // name of the libavcodec decoder to use instead of the default one for the
+  // codec of the stream, e.g. h264_cuvid or hevc_cuvid for NVDEC. The default
+  // decoder is used if this one is not available or fails to open
+  std::string decoder_name_;
 
   // intervals_ control variable sampling fps between different timestamps
   // intervals_ must be ordered strictly ascending by timestamps
@@ -396,6 +411,20 @@ class VideoDecoder {
       const Params& params,
       const int start_frm,
       std::vector<std::unique_ptr<DecodedFrame>>& sampledFrames);
+
+  // The seek_clips_ path of decodeLoop. Returns false if any clip comes out
+  // short, in which case sampledFrames is left empty
+  bool decodeClipsBySeeking(
+      AVFormatContext* inputContext,
+      AVStream* videoStream,
+      const int videoStreamIndex,
+      AVCodecContext* videoCodecContext,
+      AVFrame* videoStreamFrame,
+      SwsContext* scaleContext,
+      const int outWidth,
+      const int outHeight,
+      const Params& params,
+      std::vector<std::unique_ptr<DecodedFrame>>& sampledFrames);
 };
 } // namespace caffe2
 
@@ -97,6 +97,8 @@ class VideoInputOp final : public PrefetchOperator<Context> {
   int flow_data_type_;
   int flow_alg_type_;
   int decode_type_;
+  bool seek_clips_;
+  std::string video_decoder_;
   int video_res_type_;
   bool do_flow_aggregation_;
   bool get_rgb_;
@@ -237,10 +239,14 @@ void VideoInputOp<Context>::CheckParamsAndPrint() {
   } else if (decode_type_ == DecodeType::USE_START_FRM) {
     LOG(INFO) << "    Use start_frm for decoding";
   } else if (decode_type_ == DecodeType::DO_UNIFORM_SMP) {
-    LOG(INFO) << "    Do uniformly sampling";
+    LOG(INFO) << "    Do uniformly sampling"
+              << (seek_clips_ ? ", seeking to every clip" : "");
   } else {
     LOG(ERROR) << "    Unknown video decoding type";
   }
+  if (!video_decoder_.empty()) {
+    LOG(INFO) << "    Decoding with " << video_decoder_;
+  }
 }
 
 template <class Context>
@@ -328,6 +334,11 @@ VideoInputOp<Context>::VideoInputOp(
           OperatorBase::template GetSingleArgument<int>("flow_alg_type", 0)),
       decode_type_(
           OperatorBase::template GetSingleArgument<int>("decode_type", 0)),
+      seek_clips_(
+          OperatorBase::template GetSingleArgument<bool>("seek_clips", false)),
+      video_decoder_(OperatorBase::template GetSingleArgument<std::string>(
+          "video_decoder",
+          "")),
       video_res_type_(
           OperatorBase::template GetSingleArgument<int>("video_res_type", 0)),
       do_flow_aggregation_(OperatorBase::template GetSingleArgument<bool>(
@@ -555,6 +566,9 @@ bool VideoInputOp<Context>::GetClipsAndLabelsFromDBValue(
   params.scale_h_ = scale_h_;
   params.decode_type_ = decode_type_;
   params.num_of_required_frame_ = num_of_required_frame_;
+  params.clip_per_video_ = clip_per_video_;
+  params.seek_clips_ = seek_clips_;
+  params.decoder_name_ = video_decoder_;
 
   char* video_buffer = nullptr; // for decoding from buffer
   std::string video_filename; // for decoding from file
@@ -142,6 +142,28 @@ if (CAFFE2_COMPILER_SUPPORTS_AVX2_EXTENSIONS)
 endif()
 cmake_pop_check_state()
 
+# ---[ Check if the compiler has AVX-512 support. The perfkernels use the
+# F, BW and VL subsets, which is what Skylake-SP and later provide.
+cmake_push_check_state(RESET)
+if (NOT MSVC)
+  set(CMAKE_REQUIRED_FLAGS "-mavx512f -mavx512bw -mavx512vl")
+  CHECK_CXX_SOURCE_COMPILES(
+      "#include <immintrin.h>
+       int main() {
+         __m512 a = _mm512_set1_ps(1.f);
+         __mmask16 m = 3;
+         a = _mm512_fmadd_ps(a, a, _mm512_maskz_loadu_ps(m, &a));
+         __m256i h = _mm256_maskz_loadu_epi16(m, &a);
+         (void)h;
+         return 0;
+       }" CAFFE2_COMPILER_SUPPORTS_AVX512_EXTENSIONS)
+endif()
+if (CAFFE2_COMPILER_SUPPORTS_AVX512_EXTENSIONS AND CAFFE2_PERF_WITH_AVX2)
+  message(STATUS "Current compiler supports avx512 extention. Will build avx512 perfkernels.")
+  set(CAFFE2_PERF_WITH_AVX512 1)
+endif()
+cmake_pop_check_state()
+
 # ---[ Checks if compiler supports -fvisibility=hidden
 check_cxx_compiler_flag("-fvisibility=hidden" COMPILER_SUPPORTS_HIDDEN_VISIBILITY)
 check_cxx_compiler_flag("-fvisibility-inlines-hidden" COMPILER_SUPPORTS_HIDDEN_INLINE_VISIBILITY)
@@ -251,6 +273,14 @@ if (USE_ASAN)
   set(CMAKE_SHARED_LINKER_FLAGS "${CMAKE_SHARED_LINKER_FLAGS} ${CAFFE2_ASAN_FLAG}")
 endif()
 
+# ---[ Static tracepoints are only implemented for x86 ELF targets.
+if (USE_SDT AND CMAKE_SYSTEM_NAME STREQUAL "Linux" AND
+    CMAKE_SYSTEM_PROCESSOR MATCHES "^(x86_64|AMD64|i.86)$")
+  set(CAFFE2_ENABLE_SDT 1)
+else()
+  set(USE_SDT OFF)
+endif()
+
 # ---[ Create CAFFE2_BUILD_SHARED_LIBS for macros.h.in usage.
 set(CAFFE2_BUILD_SHARED_LIBS ${BUILD_SHARED_LIBS})
 
@@ -73,6 +73,7 @@
 #include <cfloat>
 
 #include "caffe2/core/context_gpu.h"
+#include "caffe2/utils/conversions.h"
 #include "ps_roi_pool_op.h"
 
 namespace caffe2 {
@@ -88,17 +89,18 @@ float gpu_atomic_add(const float val, float* address) {
   return atomicAdd(address, val);
 }
 
+// T is the type of the features, the pooling is computed in float.
 template <typename T>
 __global__ void PSRoIPoolForward(
     const int nthreads,
     const T* bottom_data,
-    const T spatial_scale,
+    const float spatial_scale,
     const int channels,
     const int height,
     const int width,
     const int pooled_height,
     const int pooled_width,
-    const T* bottom_rois,
+    const float* bottom_rois,
     const int output_dim,
     const int group_size,
     T* top_data,
@@ -111,33 +113,33 @@ __global__ void PSRoIPoolForward(
     int n = index / pooled_width / pooled_height / output_dim;
 
     // [start, end) interval for spatial sampling
-    const T* offset_bottom_rois = bottom_rois + n * 5;
+    const float* offset_bottom_rois = bottom_rois + n * 5;
     int roi_batch_ind = offset_bottom_rois[0];
-    T roi_start_w = static_cast<T>(
+    float roi_start_w = static_cast<float>(
       round(offset_bottom_rois[1])) * spatial_scale;
-    T roi_start_h = static_cast<T>(
+    float roi_start_h = static_cast<float>(
       round(offset_bottom_rois[2])) * spatial_scale;
-    T roi_end_w = static_cast<T>(
+    float roi_end_w = static_cast<float>(
       round(offset_bottom_rois[3]) + 1.) * spatial_scale;
-    T roi_end_h = static_cast<T>(
+    float roi_end_h = static_cast<float>(
       round(offset_bottom_rois[4]) + 1.) * spatial_scale;
 
     // Force too small ROIs to be 1x1
-    T roi_width = max(roi_end_w - roi_start_w, 0.1);  // avoid 0
-    T roi_height = max(roi_end_h - roi_start_h, 0.1);
+    float roi_width = max(roi_end_w - roi_start_w, 0.1f);  // avoid 0
+    float roi_height = max(roi_end_h - roi_start_h, 0.1f);
 
     // Compute w and h at bottom
-    T bin_size_h = roi_height / static_cast<T>(pooled_height);
-    T bin_size_w = roi_width / static_cast<T>(pooled_width);
+    float bin_size_h = roi_height / static_cast<float>(pooled_height);
+    float bin_size_w = roi_width / static_cast<float>(pooled_width);
 
     int hstart = floor(
-      static_cast<T>(ph) * bin_size_h + roi_start_h);
+      static_cast<float>(ph) * bin_size_h + roi_start_h);
     int wstart = floor(
-      static_cast<T>(pw)* bin_size_w + roi_start_w);
+      static_cast<float>(pw)* bin_size_w + roi_start_w);
     int hend = ceil(
-      static_cast<T>(ph + 1) * bin_size_h + roi_start_h);
+      static_cast<float>(ph + 1) * bin_size_h + roi_start_h);
     int wend = ceil(
-      static_cast<T>(pw + 1) * bin_size_w + roi_start_w);
+      static_cast<float>(pw + 1) * bin_size_w + roi_start_w);
     // Add roi offsets and clip to input boundaries
     hstart = min(max(hstart, 0), height);
     hend = min(max(hend, 0), height);
@@ -151,16 +153,16 @@ __global__ void PSRoIPoolForward(
 
     const T* offset_bottom_data =
       bottom_data + (roi_batch_ind * channels + c) * height * width;
-    T out_sum = 0;
+    float out_sum = 0;
     for (int h = hstart; h < hend; ++h){
      for (int w = wstart; w < wend; ++w){
        int bottom_index = h*width + w;
-       out_sum += offset_bottom_data[bottom_index];
+       out_sum += convert::To<T, float>(offset_bottom_data[bottom_index]);
      }
     }
 
-    T bin_area = (hend - hstart) * (wend - wstart);
-    top_data[index] = is_empty ? 0. : out_sum / bin_area;
+    float bin_area = (hend - hstart) * (wend - wstart);
+    top_data[index] = convert::To<float, T>(is_empty ? 0.f : out_sum / bin_area);
     mapping_channel[index] = c;
   }
 }
@@ -238,6 +240,7 @@ __global__ void PSRoIPoolBackward(
 
 } // namespace
 
+// The features may be float or float16, the RoIs are always float.
 template<>
 bool PSRoIPoolOp<float, CUDAContext>::RunOnDevice() {
   auto& X = Input(0);  // Input data to pool
@@ -248,12 +251,25 @@ bool PSRoIPoolOp<float, CUDAContext>::RunOnDevice() {
   Y->Resize(R.dim32(0), output_dim_, pooled_height_, pooled_width_);
   A->Resize(Y->dims());
   int output_size = Y->size();
-  PSRoIPoolForward<float><<<CAFFE_GET_BLOCKS(output_size),
-                            CAFFE_CUDA_NUM_THREADS,
-                            0, context_.cuda_stream()>>>(
-      output_size, X.data<float>(), spatial_scale_, X.dim32(1), X.dim32(2),
-      X.dim32(3), pooled_height_, pooled_width_, R.data<float>(), output_dim_,
-      group_size_, Y->mutable_data<float>(), A->mutable_data<int>());
+  if (X.IsType<float>()) {
+    PSRoIPoolForward<float><<<CAFFE_GET_BLOCKS(output_size),
+                              CAFFE_CUDA_NUM_THREADS,
+                              0, context_.cuda_stream()>>>(
+        output_size, X.data<float>(), spatial_scale_, X.dim32(1), X.dim32(2),
+        X.dim32(3), pooled_height_, pooled_width_, R.data<float>(),
+        output_dim_, group_size_, Y->mutable_data<float>(),
+        A->mutable_data<int>());
+  } else if (X.IsType<float16>()) {
+    PSRoIPoolForward<float16><<<CAFFE_GET_BLOCKS(output_size),
+                                CAFFE_CUDA_NUM_THREADS,
+                                0, context_.cuda_stream()>>>(
+        output_size, X.data<float16>(), spatial_scale_, X.dim32(1),
+        X.dim32(2), X.dim32(3), pooled_height_, pooled_width_,
+        R.data<float>(), output_dim_, group_size_,
+        Y->mutable_data<float16>(), A->mutable_data<int>());
+  } else {
+    CAFFE_THROW("Unsupported input type: ", X.meta().name());
+  }
   return true;
 }
 
@@ -17,6 +17,7 @@
 #include <cfloat>
 
 #include "caffe2/core/context_gpu.h"
+#include "caffe2/utils/conversions.h"
 #include "roi_pool_f_op.h"
 
 namespace caffe2 {
@@ -32,11 +33,12 @@ float gpu_atomic_add(const float val, float* address) {
   return atomicAdd(address, val);
 }
 
+// T is the type of the features, the comparisons are done in float.
 template <typename T>
 __global__ void RoIPoolFForward(const int nthreads, const T* bottom_data,
-    const T spatial_scale, const int channels, const int height,
+    const float spatial_scale, const int channels, const int height,
     const int width, const int pooled_height, const int pooled_width,
-    const T* bottom_rois, T* top_data, int* argmax_data) {
+    const float* bottom_rois, T* top_data, int* argmax_data) {
   CUDA_1D_KERNEL_LOOP(index, nthreads) {
     // (n, c, ph, pw) is an element in the pooled output
     int pw = index % pooled_width;
@@ -44,7 +46,7 @@ __global__ void RoIPoolFForward(const int nthreads, const T* bottom_data,
     int c = (index / pooled_width / pooled_height) % channels;
     int n = index / pooled_width / pooled_height / channels;
 
-    const T* offset_bottom_rois = bottom_rois + n * 5;
+    const float* offset_bottom_rois = bottom_rois + n * 5;
     int roi_batch_ind = offset_bottom_rois[0];
     int roi_start_w = round(offset_bottom_rois[1] * spatial_scale);
     int roi_start_h = round(offset_bottom_rois[2] * spatial_scale);
@@ -54,18 +56,18 @@ __global__ void RoIPoolFForward(const int nthreads, const T* bottom_data,
     // Force malformed ROIs to be 1x1
     int roi_width = max(roi_end_w - roi_start_w + 1, 1);
     int roi_height = max(roi_end_h - roi_start_h + 1, 1);
-    T bin_size_h = static_cast<T>(roi_height)
-                       / static_cast<T>(pooled_height);
-    T bin_size_w = static_cast<T>(roi_width)
-                       / static_cast<T>(pooled_width);
+    float bin_size_h = static_cast<float>(roi_height)
+                       / static_cast<float>(pooled_height);
+    float bin_size_w = static_cast<float>(roi_width)
+                       / static_cast<float>(pooled_width);
 
-    int hstart = static_cast<int>(floor(static_cast<T>(ph)
+    int hstart = static_cast<int>(floor(static_cast<float>(ph)
                                         * bin_size_h));
-    int wstart = static_cast<int>(floor(static_cast<T>(pw)
+    int wstart = static_cast<int>(floor(static_cast<float>(pw)
                                         * bin_size_w));
-    int hend = static_cast<int>(ceil(static_cast<T>(ph + 1)
+    int hend = static_cast<int>(ceil(static_cast<float>(ph + 1)
                                      * bin_size_h));
-    int wend = static_cast<int>(ceil(static_cast<T>(pw + 1)
+    int wend = static_cast<int>(ceil(static_cast<float>(pw + 1)
                                      * bin_size_w));
 
     // Add roi offsets and clip to input boundaries
@@ -76,7 +78,7 @@ __global__ void RoIPoolFForward(const int nthreads, const T* bottom_data,
     bool is_empty = (hend <= hstart) || (wend <= wstart);
 
     // Define an empty pooling region to be zero
-    T maxval = is_empty ? 0 : -FLT_MAX;
+    float maxval = is_empty ? 0 : -FLT_MAX;
     // If nothing is pooled, argmax = -1 causes nothing to be backprop'd
     int maxidx = -1;
     const T* offset_bottom_data =
@@ -84,13 +86,14 @@ __global__ void RoIPoolFForward(const int nthreads, const T* bottom_data,
     for (int h = hstart; h < hend; ++h) {
       for (int w = wstart; w < wend; ++w) {
         int bottom_index = h * width + w;
-        if (offset_bottom_data[bottom_index] > maxval) {
-          maxval = offset_bottom_data[bottom_index];
+        float val = convert::To<T, float>(offset_bottom_data[bottom_index]);
+        if (val > maxval) {
+          maxval = val;
           maxidx = bottom_index;
         }
       }
     }
-    top_data[index] = maxval;
+    top_data[index] = convert::To<float, T>(maxval);
     argmax_data[index] = maxidx;
   }
 }
@@ -139,7 +142,7 @@ bool RoIPoolFOp<float, CUDAContext>::RunOnDevice() {
     Y->Resize(0, X.dim32(1), pooled_height_, pooled_width_);
     A->Resize(0, X.dim32(1), pooled_height_, pooled_width_);
     // The following mutable_data calls are needed to allocate the tensors
-    Y->mutable_data<float>();
+    Y->raw_mutable_data(X.meta());
     A->mutable_data<int>();
     return true;
   }
@@ -147,12 +150,23 @@ bool RoIPoolFOp<float, CUDAContext>::RunOnDevice() {
   Y->Resize(R.dim32(0), X.dim32(1), pooled_height_, pooled_width_);
   A->Resize(Y->dims());
   int output_size = Y->size();
-  RoIPoolFForward<float><<<CAFFE_GET_BLOCKS(output_size),
-                          CAFFE_CUDA_NUM_THREADS,
-                          0, context_.cuda_stream()>>>(
-      output_size, X.data<float>(), spatial_scale_, X.dim32(1), X.dim32(2),
-      X.dim32(3), pooled_height_, pooled_width_, R.data<float>(),
-      Y->mutable_data<float>(), A->mutable_data<int>());
+  if (X.IsType<float>()) {
+    RoIPoolFForward<float><<<CAFFE_GET_BLOCKS(output_size),
+                            CAFFE_CUDA_NUM_THREADS,
+                            0, context_.cuda_stream()>>>(
+        output_size, X.data<float>(), spatial_scale_, X.dim32(1), X.dim32(2),
+        X.dim32(3), pooled_height_, pooled_width_, R.data<float>(),
+        Y->mutable_data<float>(), A->mutable_data<int>());
+  } else if (X.IsType<float16>()) {
+    RoIPoolFForward<float16><<<CAFFE_GET_BLOCKS(output_size),
+                              CAFFE_CUDA_NUM_THREADS,
+                              0, context_.cuda_stream()>>>(
+        output_size, X.data<float16>(), spatial_scale_, X.dim32(1),
+        X.dim32(2), X.dim32(3), pooled_height_, pooled_width_,
+        R.data<float>(), Y->mutable_data<float16>(), A->mutable_data<int>());
+  } else {
+    CAFFE_THROW("Unsupported input type: ", X.meta().name());
+  }
   return true;
 }
 
@@ -58,6 +58,7 @@ except ImportError:
     TEST_SCIPY = False
 
 TEST_MKL = torch.backends.mkl.is_available()
+TEST_MKLDNN = torch._C.has_mkldnn
 
 
 def skipIfNoLapack(fn):
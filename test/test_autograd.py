@@ -1,5 +1,7 @@
 import contextlib
 import gc
+import os
+import subprocess
 import sys
 import math
 import torch
@@ -14,7 +16,7 @@ from torch.autograd.gradcheck import gradgradcheck, gradcheck
 from torch.autograd.function import once_differentiable
 from torch.autograd.profiler import profile
 
-from common import TestCase, run_tests, skipIfNoLapack, suppress_warnings
+from common import TestCase, run_tests, skipIfNoLapack, suppress_warnings, TEST_MKL
 from torch.autograd import Variable, Function
 from torch.autograd.function import InplaceFunction
 from torch.testing import make_non_contiguous, randn_like
@@ -393,6 +395,56 @@ class TestAutograd(TestCase):
         self.assertEqual(counter[0], 1, 'bw_hook not called')
         self.assertEqual(x.grad.data, torch.ones(5, 5) * 2)
 
+    def test_native_hooks(self):
+        from torch.autograd import native_hooks
+        x = Variable(torch.ones(5, 5), requires_grad=True)
+        y = x * 4
+
+        # runs before the Python hook, although registered after it
+        y.register_hook(lambda grad: grad + 1)
+        h = y.register_hook(native_hooks.scale(3))
+        x.register_hook(native_hooks.clamp(-10, 10))
+        y.sum().backward()
+        self.assertEqual(x.grad.data, torch.ones(5, 5) * 10)
+
+        x.grad.data.zero_()
+        h.remove()
+        y = x * 4
+        y.register_hook(native_hooks.clip_norm(5))
+        y.sum().backward()
+        self.assertEqual(x.grad.data.norm(), 4 * 5, prec=1e-4)
+
+        x.grad.data.zero_()
+        with x.register_hook(native_hooks.scale(0)):
+            # Python hooks on leaves don't replace native ones
+            x.register_hook(lambda grad: grad * 2)
+            (x * 1).sum().backward()
+        self.assertEqual(x.grad.data, torch.zeros(5, 5))
+
+        self.assertRaises(RuntimeError, lambda: Variable(torch.ones(1)).register_hook(native_hooks.scale(2)))
+
+    def test_native_hooks_grad_bucket(self):
+        import threading
+        from torch.autograd import native_hooks
+        a = Variable(torch.randn(3), requires_grad=True)
+        b = Variable(torch.randn(4), requires_grad=True)
+        bucket = native_hooks.GradBucket([a, b])
+        self.assertEqual(len(bucket), 2)
+
+        for _ in range(2):
+            grads = []
+            waiter = threading.Thread(target=lambda: grads.extend(bucket.wait()))
+            waiter.start()
+            ((a * 2).sum() + (b * 3).sum()).backward()
+            waiter.join()
+            self.assertEqual(grads[0].data, torch.ones(3) * 2)
+            self.assertEqual(grads[1].data, torch.ones(4) * 3)
+
+        bucket.remove()
+        a.grad.data.zero_()
+        (a * 2).sum().backward()
+        self.assertEqual(a.grad.data, torch.ones(3) * 2)
+
     def test_hook_none(self):
         # WARNING: this is a test for autograd internals.
         # You should never have to use such things in your code.
@@ -534,6 +586,12 @@ class TestAutograd(TestCase):
         x = Variable(torch.randn(5, 5), requires_grad=True)
         (sparse_fn1(x) + sparse_fn2(x)).sum().backward()
         self.assertEqual(x.grad, sparse_grad1 + sparse_grad2)
+        # many sparse, summed at once
+        x = Variable(torch.randn(5, 5), requires_grad=True)
+        sparse_fn3 = FixedGradientFunction(sparse_grad1)
+        (sparse_fn1(x) + sparse_fn2(x) + sparse_fn3(x)).sum().backward()
+        self.assertEqual(x.grad, sparse_grad1 + sparse_grad2 + sparse_grad1)
+        self.assertTrue(x.grad.data.is_coalesced())
 
     def test_multi_backward(self):
         x = Variable(torch.randn(5, 5), requires_grad=True)
@@ -759,6 +817,20 @@ class TestAutograd(TestCase):
         expected_grad[1].fill_(3)
         self.assertEqual(y.grad.data, expected_grad)
 
+    def test_index_put_accumulate(self):
+        i = torch.LongTensor([[1, 1], [3, 0]])
+        j = torch.LongTensor([2, 0])
+
+        def fn(x, v):
+            return x.clone().index_put_([i, j], v, True)
+
+        x = Variable(torch.randn(4, 3, 5).double(), requires_grad=True)
+        v = Variable(torch.randn(2, 2, 5).double(), requires_grad=True)
+        gradcheck(fn, [x, v])
+        gradgradcheck(fn, [x, v])
+        gradcheck(lambda x: x[i, :, j], [x])
+        gradgradcheck(lambda x: x[i, :, j], [x])
+
     def test_volatile_deprecated(self):
         v = torch.autograd.Variable(torch.randn(3, 3))
         with warnings.catch_warnings(record=True) as w:
@@ -1210,6 +1282,32 @@ class TestAutograd(TestCase):
         gradcheck(func, [root, values])
         gradgradcheck(func, [root, values])
 
+    @unittest.skipIf(not TEST_MKL, "PyTorch is built without MKL support")
+    def test_fft(self):
+        x = Variable(torch.randn(3, 6, 2).double(), requires_grad=True)
+        r = Variable(torch.randn(3, 7).double(), requires_grad=True)
+        gradcheck(lambda x: x.fft(1), [x])
+        gradcheck(lambda x: x.ifft(2, normalized=True), [x])
+        gradcheck(lambda r: r.rfft(1), [r])
+        gradcheck(lambda r: r.rfft(1, onesided=False), [r])
+        gradcheck(lambda x: x.irfft(1, signal_sizes=(10,)), [x])
+
+    @unittest.skipIf(not TEST_MKL, "PyTorch is built without MKL support")
+    def test_stft(self):
+        x = Variable(torch.randn(2, 20).double(), requires_grad=True)
+        window = Variable(torch.randn(6).double(), requires_grad=True)
+        gradcheck(lambda x, w: torch.stft(x, 6, 3, window=w), [x, window])
+        gradcheck(lambda x: torch.stft(x, 6, 4, fft_size=8, normalized=True, pad_end=2), [x])
+
+    def test_cdist(self):
+        x1 = Variable(torch.randn(5, 4).double(), requires_grad=True)
+        x2 = Variable(torch.randn(3, 4).double(), requires_grad=True)
+        for p in [1, 2, 3.5, float('inf')]:
+            gradcheck(lambda x1, x2: torch.cdist(x1, x2, p), [x1, x2])
+        # large enough for the matrix multiply path of p = 2
+        x1 = Variable(torch.randn(30, 4).double(), requires_grad=True)
+        gradcheck(lambda x1, x2: torch.cdist(x1, x2), [x1, x2])
+
     def test_fill(self):
         root = Variable(torch.randn(4, 5), requires_grad=True)
 
@@ -1773,6 +1871,43 @@ class TestAutograd(TestCase):
         out.sum().backward()
         self.assertEqual(x.grad.data, y_data)
 
+    def test_multithreaded_cpu_backward(self):
+        # the CPU thread pool is created with the engine threads, so it has to
+        # run in a fresh process
+        script = """
+import torch
+from torch.autograd import Function
+
+class Reenter(Function):
+    @staticmethod
+    def forward(ctx, x):
+        with torch.enable_grad():
+            ctx.x = x.detach().requires_grad_()
+            ctx.output_var = ctx.x * 2
+        return ctx.output_var.detach()
+
+    @staticmethod
+    def backward(ctx, grad_output):
+        with torch.enable_grad():
+            ctx.output_var.sum().backward()
+        return ctx.x.grad * grad_output
+
+xs = [torch.randn(5, 5, requires_grad=True) for _ in range(16)]
+shared = torch.randn(5, 5, requires_grad=True)
+for _ in range(20):
+    # many independent branches that all accumulate into one leaf
+    out = sum((x * shared).tanh().sum() + Reenter.apply(x).sum() for x in xs)
+    out.backward()
+for x in xs:
+    expected = (1 - (x * shared).tanh() ** 2) * shared + 2
+    assert (x.grad - expected * 20).abs().max() < 1e-3
+expected = sum((1 - (x * shared).tanh() ** 2) * x for x in xs) * 20
+assert (shared.grad - expected).abs().max() < 1e-3
+"""
+        env = dict(os.environ)
+        env['TORCH_AUTOGRAD_CPU_THREADS'] = '4'
+        subprocess.check_call([sys.executable, '-c', script], env=env)
+
     def test_cat(self):
         f_args_variable = (Variable(torch.randn(1, S, S), requires_grad=True),
                            Variable(torch.randn(2, S, S), requires_grad=True),
@@ -1829,6 +1964,17 @@ class TestAutograd(TestCase):
         run_test(upper=True)
         run_test(upper=False)
 
+    @skipIfNoLapack
+    def test_potrf_batched(self):
+        root = torch.stack([torch.tril(torch.rand(S, S)) + torch.eye(S) for _ in range(2)])
+        root = Variable(root, requires_grad=True)
+
+        def func(root):
+            x = torch.matmul(root, root.transpose(-2, -1))
+            return torch.potrf(x, False)
+
+        gradcheck(func, [root])
+
     @skipIfNoLapack
     def test_trtrs(self):
         def _test_with_size(N, C):
@@ -1890,6 +2036,31 @@ class TestAutograd(TestCase):
             self.assertEqual(info.name, expected_name)
             last_end = info.cpu_interval.end
 
+    def test_profiler_record_shapes(self):
+        x = Variable(torch.randn(10, 10))
+        y = Variable(torch.randn(10))
+
+        with profile(record_shapes=True) as p:
+            x * 2 + y
+
+        self.assertEqual([e.name for e in p.function_events], ['mul', 'add'])
+        self.assertEqual(p.function_events[0].input_shapes, [[10, 10]])
+        self.assertEqual(p.function_events[1].input_shapes, [[10, 10], [10]])
+
+    def test_profiler_sampling(self):
+        x = Variable(torch.randn(10, 10))
+
+        with profile(sample_period=2) as p:
+            for _ in range(8):
+                x.neg()
+        self.assertEqual(len(p.function_events), 4)
+
+        with profile(max_events=8) as p:
+            for _ in range(100):
+                x.neg()
+        self.assertGreater(len(p.function_events), 0)
+        self.assertLessEqual(len(p.function_events), 5)
+
     def test_dir(self):
         x = Variable(torch.randn(10, 10))
         keys = dir(x)
@@ -2626,6 +2797,7 @@ method_tests = [
     ('index_fill', (), (0, torch.tensor([0], dtype=torch.int64), 2), 'scalar_input_dim', [0]),
     ('index_fill', (), (0, torch.tensor(0, dtype=torch.int64), 2), 'scalar_both_dim', [0]),
     ('inverse', (S, S), NO_ARGS, '', NO_ARGS, [skipIfNoLapack]),
+    ('inverse', (2, S, S), NO_ARGS, 'batched', NO_ARGS, [skipIfNoLapack]),
     ('det', (S, S), NO_ARGS, '', NO_ARGS, [skipIfNoLapack]),
     ('det', (1, 1), NO_ARGS, '1x1', NO_ARGS, [skipIfNoLapack]),
     ('det', lambda: random_symmetric_matrix(S), NO_ARGS, 'symmetric', NO_ARGS, [skipIfNoLapack]),
@@ -2662,6 +2834,7 @@ method_tests = [
     ('svd', lambda: random_fullrank_matrix_distinct_singular_value(S), NO_ARGS, '', NO_ARGS, [skipIfNoLapack]),
     ('svd', lambda: random_fullrank_matrix_distinct_singular_value(M), NO_ARGS, 'large', NO_ARGS, [skipIfNoLapack]),
     ('gesv', (S, S), ((S, S),), '', NO_ARGS, [skipIfNoLapack]),
+    ('gesv', (2, S, S), ((2, S, S),), 'batched', NO_ARGS, [skipIfNoLapack]),
     ('fill_', (S, S, S), (1,), 'number'),
     ('fill_', (), (1,), 'number_scalar'),
     # FIXME: we should compute the derivative w.r.t torch.tensor(1)
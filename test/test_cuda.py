@@ -1,4 +1,7 @@
 import math
+import os
+import subprocess
+import sys
 import tempfile
 import re
 import unittest
@@ -691,6 +694,53 @@ class TestCuda(TestCase):
         for _ in self._test_memory_stats_generator(self):
             pass
 
+    def test_memory_fragmentation(self):
+        torch.cuda.empty_cache()
+        info0 = torch.cuda.memory_fragmentation()
+
+        # a live small tensor keeps the rest of its segment cached but split
+        a = torch.cuda.FloatTensor(1024)
+        info = torch.cuda.memory_fragmentation()
+        self.assertGreater(info['segments'], 0)
+        self.assertGreater(info['free_blocks'], 0)
+        self.assertGreaterEqual(info['largest_free_block'], 4096)
+        self.assertGreater(info['inactive_split_bytes'], 0)
+
+        del a
+        torch.cuda.empty_cache()
+        info = torch.cuda.memory_fragmentation()
+        self.assertEqual(info['segments'], info0['segments'])
+        self.assertEqual(info['inactive_split_bytes'], info0['inactive_split_bytes'])
+
+    def test_memory_stats_binned_allocator(self):
+        # the binned mode is selected when the allocator is first constructed,
+        # so it has to run in a fresh process
+        script = '''
+import torch
+import torch.cuda
+from test_cuda import TestCuda
+from common import TestCase
+
+class T(TestCase):
+    def runTest(self):
+        pass
+
+t = T()
+m0 = torch.cuda.memory_allocated()
+streams = [torch.cuda.current_stream(), torch.cuda.Stream()]
+for stream in streams:
+    with torch.cuda.stream(stream):
+        for _ in TestCuda._test_memory_stats_generator(t):
+            pass
+torch.cuda.synchronize()
+torch.cuda.empty_cache()
+assert torch.cuda.memory_allocated() == m0
+'''
+        env = dict(os.environ)
+        env['THC_CACHING_ALLOCATOR_BINNED'] = '1'
+        test_dir = os.path.dirname(os.path.abspath(__file__))
+        subprocess.check_call([sys.executable, '-c', script], env=env, cwd=test_dir)
+
     @unittest.skipIf(torch.cuda.device_count() < 2, "only one GPU detected")
     def test_memory_stats_multigpu(self):
         # advance a generator with a end flag
@@ -1245,6 +1295,48 @@ class TestCuda(TestCase):
             tmp3 = torch.cuda.FloatTensor(t.size())
             self.assertEqual(tmp3.data_ptr(), ptr[0], 'allocation not re-used')
 
+    def test_pool_stream(self):
+        low = [torch.cuda.pool_stream() for _ in range(64)]
+        high = [torch.cuda.pool_stream(high_priority=True) for _ in range(64)]
+        # the pools are shared, and never hand out the current stream
+        self.assertLess(len(set(s.cuda_stream for s in low)), 64)
+        self.assertEqual(set(s.cuda_stream for s in low) & set(s.cuda_stream for s in high), set())
+        self.assertNotIn(torch.cuda.current_stream().cuda_stream, set(s.cuda_stream for s in low + high))
+
+        x = torch.cuda.FloatTensor(100).fill_(1)
+        high[0].wait_stream(torch.cuda.current_stream())
+        with torch.cuda.stream(high[0]):
+            y = x * 2
+        torch.cuda.current_stream().wait_stream(high[0])
+        self.assertEqual(y.sum(), 200)
+
+    def test_copy_stream_async(self):
+        copy_stream = torch.cuda.copy_stream()
+        self.assertNotEqual(copy_stream, torch.cuda.current_stream())
+        self.assertEqual(copy_stream, torch.cuda.copy_stream(torch.cuda.current_device()))
+
+        # the copy waits for the work queued before it on the current stream
+        x = torch.cuda.FloatTensor(1000, 100).fill_(1)
+        torch.cuda._sleep(int(50 * get_cycles_per_ms()))
+        x.mul_(2)
+        x_cpu, done = torch.cuda.to_host_async(x)
+        self.assertTrue(x_cpu.is_pinned())
+        done.synchronize()
+        self.assertEqual(x_cpu, torch.FloatTensor(1000, 100).fill_(2))
+
+        # work queued on the current stream after the copy sees its values
+        y = torch.arange(0, 20).view(4, 5)
+        y_cuda = torch.cuda.to_device_async(y)
+        self.assertEqual(y_cuda.mul(2).cpu(), y * 2)
+
+        # non-contiguous sources and destinations
+        z = torch.cuda.FloatTensor(5, 4).zero_().t()
+        z._copy_from_host_async_(y.t().contiguous().t())
+        self.assertEqual(z.cpu(), y)
+        z_cpu, done = torch.cuda.to_host_async(z)
+        done.synchronize()
+        self.assertEqual(z_cpu, y)
+
     def test_noncontiguous_pinned_memory(self):
         # See issue #3266
         x = torch.arange(0, 10).view((2, 5))
@@ -1269,6 +1361,20 @@ class TestCuda(TestCase):
         self.assertNotEqual(t.data_ptr(), ptr, 'allocation re-used too soon')
         self.assertEqual(list(gpu_tensor), [1])
 
+    def test_host_memory_stats(self):
+        stats0 = torch.cuda.host_memory_stats()
+        t = torch.FloatTensor(1000).pin_memory()
+        stats1 = torch.cuda.host_memory_stats()
+        self.assertGreaterEqual(stats1['bytes_allocated'], stats0['bytes_allocated'] + 4000)
+        self.assertEqual(stats1['hits'] + stats1['misses'], stats0['hits'] + stats0['misses'] + 1)
+        self.assertGreaterEqual(stats1['bytes_pinned'], stats1['bytes_allocated'])
+        del t
+        # a block of the same size class is reused
+        t = torch.FloatTensor(990).pin_memory()
+        stats2 = torch.cuda.host_memory_stats()
+        self.assertEqual(stats2['hits'], stats1['hits'] + 1)
+        self.assertEqual(stats2['bytes_allocated'], stats1['bytes_allocated'])
+
     @unittest.skipIf(torch.cuda.device_count() < 2, "only one GPU detected")
     def test_caching_pinned_memory_multi_gpu(self):
         # checks that the events preventing pinned memory from being re-used
@@ -1302,6 +1408,9 @@ class TestCuda(TestCase):
     def test_det_logdet_slogdet(self):
         TestTorch._test_det_logdet_slogdet(self, lambda t: t.cuda())
 
+    def test_cdist(self):
+        TestTorch._test_cdist(self, lambda t: t.cuda())
+
     def test_view(self):
         TestTorch._test_view(self, lambda t: t.cuda())
 
@@ -1310,6 +1419,32 @@ class TestCuda(TestCase):
             return torch.cuda.DoubleTensor(*sizes).normal_()
         TestTorch._test_fft_ifft_rfft_irfft(self, build_fn=cuda_randn_double)
 
+    def test_cufft_plan_cache(self):
+        x = torch.cuda.FloatTensor(4, 64).normal_()
+        torch.cuda.clear_cufft_plan_cache()
+        info0 = torch.cuda.cufft_plan_cache_info()
+        self.assertEqual(info0['size'], 0)
+        expected = x.rfft(1)
+        for _ in range(3):
+            self.assertEqual(x.rfft(1), expected)
+        info1 = torch.cuda.cufft_plan_cache_info()
+        self.assertEqual(info1['size'], 1)
+        self.assertEqual(info1['misses'] - info0['misses'], 1)
+        self.assertEqual(info1['hits'] - info0['hits'], 3)
+
+        # a smaller cache drops the least recently used plans
+        old_max_size = info1['max_size']
+        try:
+            torch.cuda.set_cufft_plan_cache_max_size(1)
+            x.rfft(1)
+            x[:, :32].contiguous().rfft(1)
+            self.assertEqual(torch.cuda.cufft_plan_cache_info()['size'], 1)
+            torch.cuda.set_cufft_plan_cache_max_size(0)
+            self.assertEqual(x.rfft(1), expected)
+            self.assertEqual(torch.cuda.cufft_plan_cache_info()['size'], 0)
+        finally:
+            torch.cuda.set_cufft_plan_cache_max_size(old_max_size)
+
     def test_stft(self):
         def cuda_randn_double(*sizes):
             return torch.cuda.DoubleTensor(*sizes).normal_()
@@ -1357,6 +1492,12 @@ class TestCuda(TestCase):
     def test_advancedindex(self):
         TestTorch._test_advancedindex(self, lambda t: t.cuda())
 
+    def test_index_put_accumulate(self):
+        TestTorch._test_index_put_accumulate(self, lambda t: t.cuda())
+
+    def test_unique(self):
+        TestTorch._test_unique(self, lambda t: t.cuda())
+
     def test_advancedindex_mixed_cpu_cuda(self):
         def test(x, ia, ib):
             self.assertEqual(x[:, ia, None, ib, 0].cpu(),
@@ -1396,6 +1537,10 @@ class TestCuda(TestCase):
     def test_btrisolve(self):
         TestTorch._test_btrisolve(self, lambda t: t.cuda())
 
+    @unittest.skipIf(not HAS_MAGMA, "no MAGMA library detected")
+    def test_inverse_gesv_batched(self):
+        TestTorch._test_inverse_gesv_batched(self, lambda t: t.cuda())
+
     def test_dim_reduction(self):
         TestTorch._test_dim_reduction(self, lambda t: t.cuda())
 
@@ -1411,6 +1556,32 @@ class TestCuda(TestCase):
     def test_tensor_scatterFill(self):
         TestTorch._test_scatter_base(self, lambda t: t.cuda(), 'scatter_', True, test_bounds=False)
 
+    def test_deterministic_index_add_scatter_add(self):
+        # Many duplicate indices, as in the gradient of an embedding
+        src = torch.randn(2000, 64)
+        index = torch.LongTensor(2000).random_(0, 10)
+        index_add_expected = torch.zeros(10, 64).double().index_add_(0, index, src.double())
+        scatter_index = index.view(1, 2000).expand(64, 2000).contiguous()
+        scatter_add_expected = torch.zeros(64, 10).double().scatter_add_(
+            1, scatter_index, src.t().double())
+
+        deterministic = torch.cuda.is_deterministic()
+        try:
+            for mode in [False, True]:
+                torch.cuda.set_deterministic(mode)
+                self.assertEqual(torch.cuda.is_deterministic(), mode)
+                index_add = [torch.zeros(10, 64).cuda().index_add_(0, index.cuda(), src.cuda())
+                             for _ in range(2)]
+                scatter_add = [torch.zeros(64, 10).cuda().scatter_add_(
+                               1, scatter_index.cuda(), src.t().cuda()) for _ in range(2)]
+                self.assertEqual(index_add[0], index_add_expected.float(), 1e-3)
+                self.assertEqual(scatter_add[0], scatter_add_expected.float(), 1e-3)
+                if mode:
+                    self.assertEqual(index_add[0], index_add[1], 0)
+                    self.assertEqual(scatter_add[0], scatter_add[1], 0)
+        finally:
+            torch.cuda.set_deterministic(deterministic)
+
     def test_min_max_inits(self):
         # Testing if THC_reduceAll received the correct index initialization.
         # This affects the result of THC_reduceAll operations at extreme values
@@ -1444,6 +1615,14 @@ class TestCuda(TestCase):
         gpu_tensor = cpu_tensor.cuda()
         self.assertEqual(gpu_tensor.var(), cpu_tensor.var())
 
+        # Non-contiguous inputs
+        cpu_tensor = torch.randn(5, 4, 3)
+        gpu_tensor = cpu_tensor.cuda().transpose(0, 2)
+        cpu_tensor = cpu_tensor.transpose(0, 2)
+        for dim in range(3):
+            self.assertEqual(gpu_tensor.var(dim), cpu_tensor.var(dim))
+            self.assertEqual(gpu_tensor.std(dim, unbiased=False), cpu_tensor.std(dim, unbiased=False))
+
     def test_var_unbiased(self):
         tensor = torch.randn(100).cuda()
         self.assertEqual(tensor.var(0), tensor.var(0, unbiased=True))
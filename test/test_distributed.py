@@ -843,6 +843,61 @@ class _DistTestBase(object):
 
         self._barrier()
 
+    @unittest.skipIf(BACKEND == 'nccl', "Nccl does not support CPU tensors")
+    def test_DistributedDataParallelCPU(self):
+        # Run a simple end to end DDP model on the CPU, use result of single
+        # process model as baseline
+        group, group_id, rank = self._init_global_test()
+
+        class Net(nn.Module):
+            def __init__(self):
+                super(Net, self).__init__()
+                self.fc1 = nn.Linear(2, 10, bias=False)
+                self.fc2 = nn.Linear(10, 50, bias=False)
+                self.fc3 = nn.Linear(50, 4, bias=False)
+                self.unused = nn.Linear(4, 4)
+                self.relu = nn.ReLU()
+
+            def forward(self, x):
+                x = self.relu(self.fc1(x))
+                x = self.relu(self.fc2(x))
+                x = self.fc3(x)
+                return F.softmax(x, dim=1)
+
+        def model_step(model):
+            for param in model.parameters():
+                if param.grad is not None:
+                    param.data += param.grad
+                    param.grad = None
+
+        model_base = Net()
+        model_DDP = nn.parallel.DistributedDataParallel(copy.deepcopy(model_base))
+        # Small enough to put each parameter in a bucket of its own
+        model_DDP.cpu_reduce_bucket_size = 100
+        model_DDP._register_reducer()
+
+        world_size = int(WORLD_SIZE)
+        input_cpu = torch.randn(world_size * 2, 2)
+        target = torch.randn(world_size * 2, 4)
+        loss = nn.MSELoss()
+
+        for i in range(2):
+            self._test_DDP_helper(model_base, input_cpu, target, loss)
+            self._test_DDP_helper(model_DDP,
+                                  input_cpu[rank * 2:(rank + 1) * 2],
+                                  target[rank * 2:(rank + 1) * 2],
+                                  loss)
+
+            model_step(model_base)
+            model_step(model_DDP)
+
+            for p_base, p_DDP in zip(model_base.parameters(), model_DDP.module.parameters()):
+                self.assertEqual(p_base, p_DDP)
+
+            input_cpu = input_cpu[torch.randperm(world_size * 2)]
+
+        self._barrier()
+
 if BACKEND == 'tcp' or BACKEND == 'gloo' or BACKEND == 'nccl':
     WORLD_SIZE = os.environ['WORLD_SIZE']
 
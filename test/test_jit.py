@@ -9,7 +9,9 @@ from torch.autograd import Variable, Function
 from torch.autograd.function import traceable
 from common import TestCase, run_tests, IS_WINDOWS
 import io
+import os
 import sys
+import subprocess
 import unittest
 import inspect
 import textwrap
@@ -258,6 +260,99 @@ class TestJit(TestCase):
     def test_run_lstm_fusion_cpu(self):
         self.run_lstm_fusion(False)
 
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    def test_fuse_last_dim_reduction_cpu(self):
+        def normalize(x):
+            mean = x.mean(-1, keepdim=True)
+            centered = x - mean
+            var = (centered * centered).mean(-1, keepdim=True)
+            return centered / (var + 1e-5).sqrt(), var
+
+        x = Variable(torch.randn(7, 13).float())
+        trace, _ = torch.jit.get_trace_graph(normalize, (x,))
+        torch._C._jit_pass_lint(trace)
+        torch._C._jit_pass_dce(trace)
+        torch._C._jit_pass_fuse(trace)
+        torch._C._jit_pass_lint(trace)
+        # the reductions and broadcasts all end up in a single kernel
+        self.assertEqual(str(trace).count('prim::FusionGroup_0 = graph'), 1)
+        self.assertNotIn('prim::FusionGroup_1', str(trace))
+
+        compiled = torch.jit.compile(nderivs=0)(normalize)
+        z = compiled(x)
+        with self.assertCompiled(compiled):
+            z2 = compiled(x)
+        self.assertEqual(z, z2)
+        self.assertEqual(z, normalize(x))
+
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    def test_memory_planning_cpu(self):
+        def f(x, w):
+            a = (x * 2).sigmoid() + x
+            b = (a.mm(w) * 2).tanh() + a
+            return (b.mm(w) * 2).sigmoid()
+
+        x = Variable(torch.randn(8, 8).float())
+        w = Variable(torch.randn(8, 8).float())
+        trace, _ = torch.jit.get_trace_graph(f, (x, w))
+        torch._C._jit_pass_dce(trace)
+        torch._C._jit_pass_fuse(trace)
+        torch._C._jit_pass_plan_memory(trace)
+        torch._C._jit_pass_lint(trace)
+        # a and b are both live while b is computed, so they can't share
+        # memory, and the graph output isn't planned at all
+        self.assertEqual(str(trace).count('prim::MemoryArena'), 1)
+        self.assertEqual(str(trace).count('memory_offsets'), 2)
+        self.assertIn('memory_offsets=[0]', str(trace))
+        self.assertIn('memory_offsets=[256]', str(trace))
+
+        script = textwrap.dedent("""
+            import torch
+            from torch.autograd import Variable
+
+            def f(x, w):
+                a = (x * 2).sigmoid() + x
+                b = (a.mm(w) * 2).tanh() + a
+                return (b.mm(w) * 2).sigmoid()
+
+            x = Variable(torch.randn(8, 8))
+            w = Variable(torch.randn(8, 8))
+            ge = torch._C.GraphExecutor(f, (x, w))
+            results = [ge(x, w) for _ in range(3)]
+            for r in results:
+                assert (r - f(x, w)).abs().max() < 1e-6
+        """)
+        env = dict(os.environ, PYTORCH_JIT_MEMORY_PLANNING='1')
+        subprocess.check_call([sys.executable, '-c', script], env=env)
+
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    def test_fusion_cpu_kernel_cache(self):
+        script = textwrap.dedent("""
+            import torch
+            from torch.autograd import Variable
+
+            @torch.jit.compile(nderivs=0)
+            def f(x, y):
+                return (x * y).sigmoid() + y
+
+            x = Variable(torch.randn(4, 4))
+            y = Variable(torch.randn(4, 4))
+            f(x, y)
+            f(x, y)
+        """)
+        cache_dir = tempfile.mkdtemp()
+        try:
+            env = dict(os.environ, PYTORCH_FUSION_CACHE_DIR=cache_dir)
+            subprocess.check_call([sys.executable, '-c', script], env=env)
+            kernels = sorted(os.listdir(cache_dir))
+            self.assertTrue(len(kernels) > 0)
+            self.assertTrue(all(k.endswith('.so') for k in kernels))
+            # a second process finds the kernels instead of compiling them again
+            subprocess.check_call([sys.executable, '-c', script], env=env)
+            self.assertEqual(sorted(os.listdir(cache_dir)), kernels)
+        finally:
+            shutil.rmtree(cache_dir)
+
     @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
     @unittest.skipIf(not RUN_CUDA, "fuser requires CUDA")
     def test_run_lstm_fusion_concat(self):
@@ -377,6 +472,78 @@ class TestJit(TestCase):
         self.assertEqual(z, torch.sigmoid(torch.tanh(x * (x + y))))
         self.assertEqual(z, z2)
 
+    def test_batch_independent_mm(self):
+        x = Variable(torch.randn(4, 5))
+        ws = [Variable(torch.randn(5, n)) for n in (3, 6, 2)]
+        a = Variable(torch.randn(4, 7))
+        b = Variable(torch.randn(4, 7))
+        v = Variable(torch.randn(7, 5))
+        w = Variable(torch.randn(7, 5))
+
+        def fn(x, w0, w1, w2, a, b, v, w):
+            return x.mm(w0), x.mm(w1), x.mm(w2), a.mm(v), b.mm(w)
+
+        compiled = torch.jit.compile(nderivs=0)(fn)
+        args = [x] + ws + [a, b, v, w]
+        expected = fn(*args)
+        compiled(*args)
+        with self.assertCompiled(compiled):
+            outputs = compiled(*args)
+        for out, ref in zip(outputs, expected):
+            self.assertEqual(out, ref)
+        # The projections of x share one mm, the rest is a single bmm
+        graph = str(compiled.graph_for(*args))
+        self.assertEqual(graph.count('aten::mm'), 1)
+        self.assertEqual(graph.count('aten::bmm'), 1)
+
+    def test_parallelize_branches(self):
+        x = Variable(torch.randn(4, 5))
+        w1 = Variable(torch.randn(5, 6))
+        w2 = Variable(torch.randn(5, 6))
+
+        def fn(x, w1, w2):
+            a = x.mm(w1).tanh() * 2
+            b = x.mm(w2).sigmoid() + 1
+            return torch.cat([a, b], 1)
+
+        trace, _ = torch.jit.get_trace_graph(fn, (x, w1, w2), nderivs=0)
+        torch._C._jit_pass_parallelize_branches(trace, 0)
+        torch._C._jit_pass_lint(trace)
+        graph = str(trace)
+        self.assertEqual(graph.count('prim::ParallelBranches'), 1)
+        self.assertIn('aten::cat', graph)
+
+        ge = torch._C.GraphExecutor(trace.graph(), False)
+        self.assertEqual(ge(x, w1, w2), fn(x, w1, w2))
+
+        # cheap branches are left alone
+        trace, _ = torch.jit.get_trace_graph(fn, (x, w1, w2), nderivs=0)
+        torch._C._jit_pass_parallelize_branches(trace, 1 << 20)
+        self.assertNotIn('prim::ParallelBranches', str(trace))
+
+    def test_constant_propagation(self):
+        x = Variable(torch.randn(3, 4))
+        w = Variable(torch.randn(5, 4))
+        b = Variable(torch.randn(5))
+
+        trace, inputs = torch._C._tracer_enter((x, w, b), 0)
+        z = F.relu(F.linear(*inputs))
+        torch._C._tracer_exit((z,))
+        # Treat the weight and bias as constants
+        torch._C._jit_pass_inline_constant_inputs(trace, 1, [w, b])
+        torch._C._jit_pass_constant_propagation(trace)
+        torch._C._jit_pass_lint(trace)
+
+        graph = str(trace)
+        self.assertNotIn('aten::t', graph)
+        self.assertEqual(len(list(trace.graph().inputs())), 1)
+        self.assertEqual(z, F.relu(F.linear(x, w, b)))
+
+        torch._C._jit_pass_prepack_weights(trace)
+        torch._C._jit_pass_lint(trace)
+        if torch._C.has_mkldnn:
+            self.assertIn('aten::mkldnn_linear', str(trace))
+
     @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
     @unittest.skipIf(not RUN_CUDA, "fuser requires CUDA")
     def test_compile_addc(self):
@@ -1310,6 +1477,88 @@ class TestJit(TestCase):
         g2result2 = torch.autograd.grad(l3, [da2, db2])
         self.assertEqual(g2result, g2result2)
 
+    def test_ge_plan_cache(self):
+        def foo(a, b):
+            return a * b + b
+        V = Variable
+        ge = torch._C.GraphExecutor(foo, (V(torch.rand(2, 3)), V(torch.rand(2, 3))))
+        ge(V(torch.rand(2, 3)), V(torch.rand(2, 3)))
+        ge(V(torch.rand(2, 3)), V(torch.rand(2, 3)))
+        ge(V(torch.rand(4, 3)), V(torch.rand(4, 3)))
+        self.assertEqual(ge.plan_cache_stats(),
+                         {'hits': 1, 'misses': 2, 'evictions': 0, 'size': 2})
+
+    def test_ge_run_inference(self):
+        def foo(x, w, b):
+            h = (x.mm(w) + b).tanh()
+            return (h * 2).relu() - h.sigmoid()
+        V = Variable
+        x, w, b = V(torch.rand(4, 3)), V(torch.rand(3, 5), requires_grad=True), V(torch.rand(4, 5))
+        ge = torch._C.GraphExecutor(foo, (x, w, b))
+        r = ge.run_inference(x, w, b)
+        self.assertFalse(r.requires_grad)
+        self.assertEqual(r, foo(x, w, b))
+        # the inputs are left as they were
+        self.assertEqual(ge.run_inference(x, w, b), r)
+        ge(x, w, b)
+        self.assertEqual(ge.plan_cache_stats(),
+                         {'hits': 1, 'misses': 2, 'evictions': 0, 'size': 2})
+
+    def test_ge_plan_cache_bounded(self):
+        script = textwrap.dedent("""
+            import torch
+            from torch.autograd import Variable
+
+            def foo(a, b):
+                return a * b + b
+
+            def run(ge, n):
+                a, b = Variable(torch.rand(n, 3)), Variable(torch.rand(n, 3))
+                assert (ge(a, b) - foo(a, b)).abs().max() < 1e-6
+
+            ge = torch._C.GraphExecutor(foo, (Variable(torch.rand(2, 3)), Variable(torch.rand(2, 3))))
+            run(ge, 3)
+            run(ge, 4)   # same bucket as 3
+            run(ge, 8)   # evicts the plan for 3 and 4
+            run(ge, 4)
+            stats = ge.plan_cache_stats()
+            assert stats == {'hits': 1, 'misses': 3, 'evictions': 2, 'size': 1}, stats
+        """)
+        env = dict(os.environ, PYTORCH_JIT_PLAN_CACHE_SIZE='1', PYTORCH_JIT_BUCKET_BATCH='1')
+        subprocess.check_call([sys.executable, '-c', script], env=env)
+
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    @unittest.skipIf(not RUN_CUDA, "CUDA graphs need a GPU")
+    def test_ge_cuda_graph(self):
+        script = textwrap.dedent("""
+            import torch
+            from torch.autograd import Variable
+
+            def rand(n):
+                return Variable(torch.rand(n, n).cuda())
+
+            def foo(a, b):
+                return (a.mm(b) * 2).sigmoid() + a
+
+            a, b = rand(4), rand(4)
+            ge = torch._C.GraphExecutor(foo, (a, b))
+            # warm up, capture, then replay with new values in the inputs
+            for _ in range(5):
+                a, b = rand(4), rand(4)
+                r = ge.run_inference(a, b)
+                assert (r - foo(a, b)).abs().max() < 1e-5
+            # the outputs of a replay don't change with the next one
+            r = ge.run_inference(a, b)
+            ge.run_inference(b, a)
+            assert (r - foo(a, b)).abs().max() < 1e-5
+            # other sizes fall back to the interpreter
+            a, b = rand(3), rand(3)
+            r = ge.run_inference(a, b)
+            assert (r - foo(a, b)).abs().max() < 1e-5
+        """)
+        env = dict(os.environ, PYTORCH_JIT_CUDA_GRAPHS='1')
+        subprocess.check_call([sys.executable, '-c', script], env=env)
+
     def test_trace_annotation(self):
         @torch.jit.trace(Variable(torch.rand(1)))
         def foo(a):
@@ -2100,6 +2349,23 @@ class TestPytorchExportModes(unittest.TestCase):
                            export_type=torch.onnx.ExportTypes.DIRECTORY)
         shutil.rmtree(d)
 
+    def test_directory_weights(self):
+        torch_model = nn.Linear(3, 4)
+        fake_input = Variable(torch.randn(2, 3), requires_grad=True)
+        d = tempfile.mkdtemp()
+        try:
+            torch.onnx._export(torch_model, (fake_input), d, verbose=False,
+                               export_type=torch.onnx.ExportTypes.DIRECTORY)
+            weights = []
+            for name in os.listdir(d):
+                if name != torch.onnx.ONNX_ARCHIVE_MODEL_PROTO_NAME:
+                    with open(os.path.join(d, name), 'rb') as f:
+                        weights.append(f.read())
+            expected = [p.data.numpy().tobytes() for p in torch_model.parameters()]
+            self.assertEqual(sorted(weights), sorted(expected))
+        finally:
+            shutil.rmtree(d)
+
 
 if __name__ == '__main__':
     run_tests()
@@ -103,6 +103,15 @@ def autograd_sharing(queue, ready, master_modified):
     queue.put(is_ok)
 
 
+def shm_pool_alloc(queue):
+    torch._C._enable_shm_pool()
+    for _ in range(5):
+        torch.FloatStorage._new_shared(100)
+    kept = torch.FloatStorage._new_shared(100)
+    other = torch.FloatStorage._new_shared(200)
+    queue.put(mp.shared_memory_pool_stats())
+
+
 @contextlib.contextmanager
 def fs_sharing():
     prev_strategy = mp.get_sharing_strategy()
@@ -438,6 +447,24 @@ class TestMultiprocessing(TestCase):
         with fs_sharing():
             self._test_is_shared()
 
+    @unittest.skipIf(IS_WINDOWS, "shared memory segments are not pooled on Windows")
+    @unittest.skipIf('TORCH_SHM_POOL_SIZE' in os.environ, "pool size set by the environment")
+    def test_fs_pool_reuse(self):
+        with fs_sharing():
+            q = mp.Queue()
+            p = mp.Process(target=shm_pool_alloc, args=(q,))
+            p.start()
+            stats = q.get(timeout=10)
+            p.join(1)
+        self.assertEqual(stats['allocations'], 7)
+        self.assertEqual(stats['created'], 2)
+        self.assertEqual(stats['reused'], 5)
+        self.assertEqual(stats['fallbacks'], 0)
+        self.assertEqual(stats['pooled_bytes'], 4096 * 2)
+        self.assertAlmostEqual(stats['reuse_rate'], 5 / 7.0)
+        # the parent doesn't pool anything unless asked to
+        self.assertEqual(mp.shared_memory_pool_stats()['allocations'], 0)
+
     @unittest.skipIf(not torch.cuda.is_available(), 'CUDA not available')
     def test_is_shared_cuda(self):
         t = torch.randn(5, 5).cuda()
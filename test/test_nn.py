@@ -31,7 +31,8 @@ from common_nn import NNTestCase, ModuleTest, CriterionTest, TestBase, \
     TEST_CUDNN_VERSION, loss_reference_fns, get_size_average, get_weight, \
     smoothl1loss_reference, kldivloss_reference
 from common import freeze_rng_state, run_tests, TestCase, skipIfNoLapack, \
-    TEST_SCIPY, download_file, PY3, PY34, to_gpu, get_function_arglist
+    TEST_SCIPY, TEST_MKLDNN, download_file, PY3, PY34, to_gpu, \
+    get_function_arglist
 
 if TEST_SCIPY:
     from scipy import stats
@@ -1260,6 +1261,42 @@ class TestNN(NNTestCase):
         self.assertTrue(embedding.weight.grad.is_sparse)
         self.assertEqual(embedding.weight.grad.shape, embedding.weight.shape)
 
+    def test_embedding_sparse_backward(self):
+        # duplicate indices, padding_idx and scale_grad_by_freq against a
+        # reference accumulation
+        indices = torch.LongTensor([[1, 2, 4, 1], [4, 3, 1, 0]])
+        grad = torch.randn(2, 4, 3)
+        for padding_idx in (-1, 0, 1):
+            for scale_grad_by_freq in (False, True):
+                expected = torch.zeros(5, 3)
+                flat = indices.view(-1).tolist()
+                for i, k in enumerate(flat):
+                    if k != padding_idx:
+                        scale = 1. / flat.count(k) if scale_grad_by_freq else 1.
+                        expected[k] += grad.view(-1, 3)[i] * scale
+                dense = torch.embedding_dense_backward(grad, indices, 5, padding_idx, scale_grad_by_freq)
+                self.assertEqual(dense, expected)
+                if not scale_grad_by_freq:
+                    sparse = torch.embedding_sparse_backward(grad, indices, 5, padding_idx, False)
+                    self.assertEqual(sparse.to_dense(), expected)
+
+    def test_embedding_sparse_adagrad(self):
+        weight = torch.randn(10, 4)
+        indices = torch.LongTensor([[1, 2, 4], [4, 3, 1], [0, 9, 1]])
+        grad = torch.randn(3, 3, 4)
+
+        embedding = nn.Embedding(10, 4, sparse=True)
+        embedding.weight.data.copy_(weight)
+        optimizer = torch.optim.Adagrad(embedding.parameters(), lr=0.1)
+        embedding(Variable(indices)).backward(grad)
+        optimizer.step()
+
+        fused = weight.clone()
+        state_sum = torch.zeros(10, 4)
+        torch.embedding_sparse_adagrad_(fused, state_sum, grad, indices, 0.1)
+        self.assertEqual(fused, embedding.weight.data)
+        self.assertEqual(state_sum, optimizer.state[embedding.weight]['sum'])
+
     def test_embedding_padding_idx(self):
         embedding = nn.Embedding(10, 20, padding_idx=0)
         input = Variable(torch.LongTensor([[0, 2, 4, 5], [4, 3, 0, 9]]))
@@ -1496,6 +1533,9 @@ class TestNN(NNTestCase):
         _test_vs_Embedding(N, D, B, L)
         for p in itertools.product([1, 2], repeat=4):
             _test_vs_Embedding(*p)
+        # enough bags for the CPU kernel to split them between threads, and
+        # rows that aren't a multiple of the vector width
+        _test_vs_Embedding(1000, 67, 300, 20)
 
         # check that giving illegal input combos raises error
         es = nn.EmbeddingBag(10, 20, mode=mode, sparse=sparse)
@@ -1560,6 +1600,8 @@ class TestNN(NNTestCase):
         self._test_EmbeddingBag(False, 'mean', False)
         self._test_EmbeddingBag(False, 'sum', True)
         self._test_EmbeddingBag(False, 'mean', True)
+        self._test_EmbeddingBag(False, 'sum', False, torch.FloatTensor)
+        self._test_EmbeddingBag(False, 'mean', False, torch.FloatTensor)
 
     @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
     @repeat_test_for_types(ALL_TENSORTYPES)
@@ -1972,6 +2014,46 @@ class TestNN(NNTestCase):
         dtype = getattr(torch.cuda, dtype.__name__)
         self._test_batchnorm_eval(dtype)
 
+    @unittest.skipIf(not TEST_MKLDNN, "MKL-DNN unavailable")
+    def test_mkldnn_inference_ops(self):
+        x = torch.randn(2, 8, 13, 11)
+        self.assertEqual(torch.mkldnn_relu(x), F.relu(x))
+        for ceil_mode in [False, True]:
+            self.assertEqual(torch.mkldnn_max_pool2d(x, 3, 2, 1, ceil_mode),
+                             F.max_pool2d(x, 3, 2, 1, ceil_mode=ceil_mode))
+            self.assertEqual(
+                torch.mkldnn_avg_pool2d(x, 3, 2, 1, ceil_mode, False),
+                F.avg_pool2d(x, 3, 2, 1, ceil_mode, False))
+        self.assertEqual(torch.mkldnn_avg_pool2d(x, 3, 2, 1, False, True),
+                         F.avg_pool2d(x, 3, 2, 1, False, True))
+        self.assertEqual(torch.mkldnn_local_response_norm(x, 5),
+                         F.local_response_norm(x, 5))
+
+        mean = torch.randn(8)
+        var = torch.rand(8) + 0.5
+        weight = torch.randn(8, requires_grad=True)
+        bias = torch.randn(8, requires_grad=True)
+        channels = (1, 8, 1, 1)
+        expected = ((x - mean.view(channels)) / (var.view(channels) + 1e-5).sqrt() *
+                    weight.view(channels) + bias.view(channels))
+        self.assertEqual(
+            torch.mkldnn_batch_norm(x, weight, bias, mean, var, 1e-5), expected)
+        # Evaluation mode batch norm runs through MKL-DNN
+        self.assertEqual(
+            F.batch_norm(x, mean, var, weight, bias, training=False), expected)
+
+        x = x.view(2, -1).requires_grad_()
+        weight = torch.randn(5, x.size(1), requires_grad=True)
+        bias = torch.randn(5, requires_grad=True)
+        output = torch.mkldnn_linear(x, weight, bias)
+        expected = F.linear(x, weight, bias)
+        self.assertEqual(output, expected)
+        grad = torch.randn(2, 5)
+        grads = torch.autograd.grad(output, (x, weight, bias), grad)
+        expected_grads = torch.autograd.grad(expected, (x, weight, bias), grad)
+        for g, expected_g in zip(grads, expected_grads):
+            self.assertEqual(g, expected_g)
+
     def test_MaxPool1d_indices(self):
         self._test_maxpool_indices(1)
 
@@ -1990,6 +2072,27 @@ class TestNN(NNTestCase):
         dtype = getattr(torch.cuda, dtype.__name__)
         self._test_maxpool_indices(2, dtype=dtype)
 
+    def test_pool2d_batch_matches_frames(self):
+        # batches are pooled as one frame with all the planes of all inputs
+        modules = [
+            nn.MaxPool2d(3, stride=2, padding=1),
+            nn.MaxPool2d(2, stride=2, ceil_mode=True),
+            nn.AvgPool2d(3, stride=1, padding=1),
+            nn.AvgPool2d(3, stride=2, padding=1, ceil_mode=True),
+            nn.AvgPool2d(2, stride=2, padding=1, count_include_pad=False),
+        ]
+        for module in modules:
+            input = torch.randn(3, 4, 9, 7, requires_grad=True)
+            output = module(input)
+            grad_output = torch.randn(output.size())
+            grad_input, = torch.autograd.grad(output, input, grad_output)
+            for i in range(input.size(0)):
+                frame = input[i].detach().requires_grad_()
+                frame_output = module(frame)
+                frame_grad, = torch.autograd.grad(frame_output, frame, grad_output[i])
+                self.assertEqual(output[i], frame_output)
+                self.assertEqual(grad_input[i], frame_grad)
+
     def test_MaxPool3d_indices(self):
         self._test_maxpool_indices(3)
 
@@ -410,6 +410,27 @@ class TestSparse(TestCase):
         test_shape(100, 1000, 200)
         test_shape(64, 10000, 300)
 
+    @cpu_only
+    def test_mm_repeated(self):
+        # the row pointers of x are kept between products, and must follow
+        # the changes to x
+        x = self._gen_sparse(2, 50, [30, 30])[0].coalesce()
+        y = torch.randn(30, 10)
+        self.assertEqual(torch.mm(x, y), torch.mm(self.safeToDense(x), y))
+        self.assertEqual(torch.mm(x, y), torch.mm(self.safeToDense(x), y))
+
+        x.transpose_(0, 1)
+        x = x.coalesce()
+        self.assertEqual(torch.mm(x, y), torch.mm(self.safeToDense(x), y))
+
+        z = self._gen_sparse(2, 20, [30, 30])[0].coalesce()
+        torch.mm(z, y)
+        z.mul_(2)
+        self.assertEqual(torch.mm(z, y), torch.mm(self.safeToDense(z), y))
+        x.add_(z)
+        x = x.coalesce()
+        self.assertEqual(torch.mm(x, y), torch.mm(self.safeToDense(x), y))
+
     @cpu_only
     def test_saddmm(self):
         def test_shape(di, dj, dk):
@@ -787,6 +808,22 @@ class TestSparse(TestCase):
 
         self.assertFalse(z._indices().numel() != 2 and z.is_coalesced())
 
+    @cpu_only
+    def test_sparse_add_stays_coalesced(self):
+        x = self._gen_sparse(2, 20, [10, 10])[0].coalesce()
+        y = self._gen_sparse(2, 20, [10, 10])[0].coalesce()
+        z = x + y
+        self.assertTrue(z.is_coalesced())
+        self.assertEqual(self.safeToDense(z), self.safeToDense(x) + self.safeToDense(y))
+
+        # indices in increasing order are coalesced, even if the flags say
+        # otherwise
+        i = self.IndexTensor([[0, 2]])
+        v = self.ValueTensor([3, 4])
+        x = self.SparseTensor(i, v, torch.Size([4]))
+        y = self.SparseTensor(i + 1, v, torch.Size([4]))
+        self.assertTrue((x + y).is_coalesced())
+
     @cuda_only
     def test_storage_not_null(self):
         x = torch.cuda.sparse.FloatTensor(2)
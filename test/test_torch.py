@@ -994,6 +994,20 @@ class TestTorch(TestCase):
         res2 = matrixmultiply(mat1, mat2)
         self.assertEqual(res, res2)
 
+    def test_mm_integer(self):
+        # integer types use the blocked GEMM of THBlas, test it with sizes
+        # spanning several blocks in every dimension, and partial tiles
+        for n, m, p in [(3, 1, 2), (131, 300, 67), (9, 17, 1030)]:
+            mat1 = torch.randn(n, m).mul(4).round()
+            mat2 = torch.randn(m, p).mul(4).round()
+            expected = torch.mm(mat1.double(), mat2.double())
+            for t in [torch.IntTensor, torch.LongTensor, torch.DoubleTensor]:
+                a, b = mat1.type(t), mat2.type(t)
+                self.assertEqual(torch.mm(a, b).double(), expected)
+                self.assertEqual(torch.mm(a.t().contiguous().t(), b.t().contiguous().t()).double(), expected)
+                c = torch.ones(n, p).type(t)
+                self.assertEqual(torch.addmm(2, c, 3, a, b).double(), expected * 3 + 2)
+
     @staticmethod
     def _test_btrifact(self, cast):
         a = torch.FloatTensor((((1.3722, -0.9020),
@@ -2523,6 +2537,14 @@ class TestTorch(TestCase):
 
         self.assertRaises(RuntimeError, lambda: torch.cat([]))
 
+        # many small contiguous inputs, in every dimension
+        tensors = [torch.rand(2, i % 3 + 1, 3) for i in range(200)]
+        res = torch.cat(tensors, 1)
+        self.assertEqual(res.size(), (2, sum(t.size(1) for t in tensors), 3))
+        self.assertEqual(res.narrow(1, 0, 1), tensors[0], 0)
+        self.assertEqual(res.narrow(1, res.size(1) - tensors[-1].size(1), tensors[-1].size(1)), tensors[-1], 0)
+        self.assertEqual(torch.cat(torch.chunk(x, 7, 2), 2), x, 0)
+
     def test_cat_bad_input_sizes(self):
         x = torch.randn(2, 1)
         y = torch.randn(2, 1, 1)
@@ -2587,6 +2609,22 @@ class TestTorch(TestCase):
             self.assertEqual(res.select(dim, 1), y, 0)
             self.assertEqual(res.select(dim, 2), z, 0)
 
+        # non-contiguous inputs
+        xt, yt, zt = (t.transpose(0, 2) for t in (x, y, z))
+        for dim in range(4):
+            res = torch.stack((xt, yt, zt), dim)
+            self.assertEqual(res.select(dim, 0), xt, 0)
+            self.assertEqual(res.select(dim, 1), yt, 0)
+            self.assertEqual(res.select(dim, 2), zt, 0)
+
+        # many small inputs
+        tensors = [torch.rand(5) for _ in range(300)]
+        res = torch.stack(tensors, 1)
+        self.assertEqual(res.size(), (5, 300))
+        self.assertEqual(res[:, 123], tensors[123], 0)
+
+        self.assertRaises(RuntimeError, lambda: torch.stack((x, torch.rand(2, 4, 4)), 1))
+
     def test_stack_out(self):
         x = torch.rand(2, 3, 4)
         y = torch.rand(2, 3, 4)
@@ -3178,6 +3216,59 @@ class TestTorch(TestCase):
         self.assertFalse(MII.is_contiguous(), 'MII is contiguous')
         self.assertEqual(MII, MI, 0, 'inverse value in-place')
 
+    @staticmethod
+    def _test_inverse_gesv_batched(self, cast):
+        # tiny sizes take the closed-form path on the CPU
+        for n in (1, 2, 3, 7):
+            A = cast(torch.randn(2, 3, n, n)) + cast(torch.eye(n)) * n
+            B = cast(torch.randn(2, 3, n, 4))
+            A_inv = torch.inverse(A)
+            X, LU = torch.gesv(B, A)
+            self.assertEqual(X.size(), B.size())
+            self.assertEqual(LU.size(), A.size())
+            for i in range(2):
+                for j in range(3):
+                    self.assertEqual(A_inv[i, j], torch.inverse(A[i, j]), 1e-5)
+                    X_ij, LU_ij = torch.gesv(B[i, j], A[i, j])
+                    self.assertEqual(X[i, j], X_ij, 1e-5)
+                    self.assertEqual(LU[i, j], LU_ij, 1e-5)
+
+        # non-contiguous batches
+        A = cast(torch.randn(4, 3, 3)).transpose(0, 2)
+        A_inv = torch.inverse(A)
+        for i in range(3):
+            self.assertEqual(A_inv[i], torch.inverse(A[i]), 1e-5)
+
+    @skipIfNoLapack
+    def test_inverse_gesv_batched(self):
+        self._test_inverse_gesv_batched(self, lambda t: t)
+
+    @skipIfNoLapack
+    def test_potrf_potrs_batched(self):
+        X = torch.randn(2, 3, 5, 5)
+        A = torch.matmul(X, X.transpose(-2, -1)) + torch.eye(5)
+        B = torch.randn(2, 3, 5, 2)
+        for upper in (True, False):
+            U = torch.potrf(A, upper)
+            x = torch.potrs(B, U, upper)
+            for i in range(2):
+                for j in range(3):
+                    self.assertEqual(U[i, j], torch.potrf(A[i, j], upper), 1e-12)
+                    self.assertEqual(x[i, j], torch.potrs(B[i, j], U[i, j], upper), 1e-12)
+
+        self.assertRaises(RuntimeError, lambda: torch.potrf(-A))
+
+    @skipIfNoLapack
+    def test_btrifact_batch_dims(self):
+        a = torch.randn(2, 3, 4, 4)
+        a_LU, pivots, info = a.btrifact_with_info()
+        self.assertEqual(a_LU.size(), (2, 3, 4, 4))
+        self.assertEqual(pivots.size(), (2, 3, 4))
+        self.assertEqual(info.size(), (2, 3))
+        a_LU_, pivots_ = a.view(6, 4, 4).btrifact()
+        self.assertEqual(a_LU, a_LU_.view(2, 3, 4, 4))
+        self.assertEqual(pivots, pivots_.view(2, 3, 4))
+
     @staticmethod
     def _test_det_logdet_slogdet(self, conv_fn):
         def reference_det(M):
@@ -4425,6 +4516,35 @@ class TestTorch(TestCase):
     def test_advancedindex_big(self):
         self._test_advancedindex_big(self, lambda x: x)
 
+    @staticmethod
+    def _test_index_put_accumulate(self, conv_fn):
+        # duplicate indices accumulate with accumulate=True
+        x = conv_fn(torch.zeros(5, 4))
+        i = conv_fn(torch.LongTensor([0, 2, 0, 4]))
+        j = conv_fn(torch.LongTensor([1, 3, 1, -1]))
+        x.index_put_([i, j], conv_fn(torch.Tensor([1, 2, 3, 4])), True)
+        expected = torch.zeros(5, 4)
+        expected[0, 1] = 4
+        expected[2, 3] = 2
+        expected[4, 3] = 4
+        self.assertEqual(x, conv_fn(expected))
+
+        # non-contiguous self, indices that are not adjacent, and a
+        # broadcast value
+        reference = conv_fn(torch.randn(6, 3, 7).transpose(0, 2))
+        x = reference.clone()
+        i = conv_fn(torch.LongTensor([[1, 1], [6, 0]]))
+        k = conv_fn(torch.LongTensor([[5], [2]]))
+        x.index_put_([i, None, k], conv_fn(torch.Tensor([1, 2, 3])), True)
+        expected = reference.clone()
+        for a, c in [(1, 5), (1, 5), (6, 2), (0, 2)]:
+            expected[a, :, c] += conv_fn(torch.Tensor([1, 2, 3]))
+        self.assertEqual(x, expected)
+        self.assertEqual(x[i, :, k], expected[i, :, k])
+
+    def test_index_put_accumulate(self):
+        self._test_index_put_accumulate(self, lambda x: x)
+
     @unittest.skipIf(not TEST_NUMPY, "Numpy not found")
     def test_newaxis_numpy_comparison(self):
         def run_test(tensor, *idx):
@@ -4798,6 +4918,35 @@ class TestTorch(TestCase):
         self.assertEqual(tensor.var(dim=0), 0.03125)
         self.assertEqual(tensor.var(), 0.03125)
 
+    @staticmethod
+    def _test_cdist(self, cast):
+        def naive_cdist(x1, x2, p):
+            diff = (x1.unsqueeze(1) - x2.unsqueeze(0)).abs()
+            if p == 0:
+                return (diff != 0).type_as(x1).sum(-1)
+            if p == float('inf'):
+                return diff.max(-1)[0]
+            return diff.pow(p).sum(-1).pow(1. / p)
+
+        for r1, r2, m in [(4, 5, 3), (1, 100, 17), (40, 30, 9)]:
+            x1 = cast(torch.randn(r1, m).double())
+            x2 = cast(torch.randn(r2, m).double())
+            # an exact match, which the matrix multiply path must not turn
+            # into a NaN
+            x2[0] = x1[0]
+            for p in [0, 1, 2, 3.5, 0.5, float('inf')]:
+                result = torch.cdist(x1, x2, p)
+                self.assertEqual(result.size(), (r1, r2))
+                self.assertEqual(result, naive_cdist(x1, x2, p), 1e-6)
+        # non-contiguous inputs
+        x1 = cast(torch.randn(6, 4).double())
+        x2 = cast(torch.randn(4, 5).double()).t()
+        self.assertEqual(torch.cdist(x1, x2, 1), naive_cdist(x1, x2, 1))
+        self.assertRaises(RuntimeError, lambda: torch.cdist(x1, cast(torch.randn(5, 3).double())))
+
+    def test_cdist(self):
+        self._test_cdist(self, lambda t: t)
+
     @staticmethod
     def _test_view(self, cast):
         tensor = cast(torch.rand(15))
@@ -5346,6 +5495,25 @@ class TestTorch(TestCase):
         self.assertEqual(r[:, :50].std(), 4, 0.3)
         self.assertEqual(r[:, 50:].std(), 1, 0.2)
 
+    def test_random_fill_num_threads(self):
+        # Contiguous fills give the same samples for any number of threads
+        num_threads = torch.get_num_threads()
+        fills = [lambda t: t.uniform_(-1, 2),
+                 lambda t: t.normal_(1, 3),
+                 lambda t: t.bernoulli_(0.3),
+                 lambda t: t.bernoulli_(torch.rand(t.size()).type_as(t))]
+        try:
+            for tensor_type in [torch.FloatTensor, torch.DoubleTensor]:
+                for fill in fills:
+                    results = []
+                    for threads in [1, 4]:
+                        torch.set_num_threads(threads)
+                        torch.manual_seed(123)
+                        results.append(fill(tensor_type(300007)))
+                    self.assertEqual(results[0], results[1], 0)
+        finally:
+            torch.set_num_threads(num_threads)
+
     def _test_serialization(self, filecontext_lambda, test_use_filename=True):
         a = [torch.randn(5, 5).float() for i in range(2)]
         b = [a[i % 2] for i in range(4)]
@@ -5413,6 +5581,53 @@ class TestTorch(TestCase):
             self.assertTrue(torch.equal(a, b))
             self.assertEqual(i, j)
 
+    def _test_serialization_aligned(self, mmap):
+        a = torch.randn(5, 5)
+        b = [a, a[1:3], torch.arange(0, 10).long(), torch.IntTensor(0), a.storage()[2:7]]
+        with tempfile.NamedTemporaryFile() as f:
+            torch.save(b, f, align_storages=True)
+            f.seek(0)
+            c = torch.load(f.name, mmap=mmap)
+        self.assertEqual(b, c, 0)
+        self.assertEqual(c[1].storage().data_ptr(), c[0].storage().data_ptr())
+        self.assertEqual(c[4].data_ptr(), c[0].storage().data_ptr() + 2 * c[0].element_size())
+        if mmap:
+            # copy-on-write: the file isn't modified
+            c[0].fill_(1)
+            with open(f.name, 'rb') as g:
+                self.assertEqual(torch.load(g, mmap=True)[0], a, 0)
+
+    def test_serialization_aligned(self):
+        self._test_serialization_aligned(mmap=False)
+
+        buf = io.BytesIO()
+        a = torch.randn(3, 3)
+        torch.save(a, buf, align_storages=True)
+        buf.seek(0)
+        self.assertEqual(torch.load(buf), a, 0)
+
+        buf = io.BytesIO()
+        torch.save(a, buf)
+        buf.seek(0)
+        self.assertRaises(RuntimeError, lambda: torch.load(buf, mmap=True))
+
+    def test_serialization_aligned_many_storages(self):
+        # written in parallel to real files
+        b = [torch.randn(i + 1, 1000).type(t) for i in range(20)
+             for t in ['torch.FloatTensor', 'torch.DoubleTensor', 'torch.ShortTensor']]
+        with tempfile.TemporaryFile() as f:
+            torch.save(b, f, align_storages=True)
+            f.seek(0)
+            self.assertEqual(torch.load(f), b, 0)
+        buf = io.BytesIO()
+        torch.save(b, buf, align_storages=True)
+        buf.seek(0)
+        self.assertEqual(torch.load(buf), b, 0)
+
+    @unittest.skipIf(sys.platform == "win32", "NamedTemporaryFile can't be reopened on Windows")
+    def test_serialization_mmap(self):
+        self._test_serialization_aligned(mmap=True)
+
     def test_serialization_offset(self):
         self._test_serialization_offset(tempfile.TemporaryFile)
 
@@ -5435,6 +5650,28 @@ class TestTorch(TestCase):
             xh2 = torch.load(f)
             self.assertEqual(xh.float(), xh2.float())
 
+    @unittest.skipIf(not TEST_NUMPY, "Numpy not found")
+    def test_half_tensor_conversion(self):
+        def bits(h):
+            return torch.from_numpy(h.view(np.int16))
+
+        # every finite half value; the size isn't a multiple of the vector
+        # width of the bulk conversions
+        h = np.arange(1 << 16, dtype=np.uint16).view(np.float16)
+        h = h[np.isfinite(h)]
+        f = h.astype(np.float32)
+        self.assertEqual(torch.from_numpy(h).float(), torch.from_numpy(f), 0)
+        self.assertEqual(bits(torch.from_numpy(f).half().numpy()), bits(h), 0)
+        # round to nearest even, ties included
+        f = np.random.randn(10007).astype(np.float32) * 1000
+        f[:3] = [1 + 2 ** -11, 1 + 3 * 2 ** -11, 65519]
+        self.assertEqual(bits(torch.from_numpy(f).half().numpy()), bits(f.astype(np.float16)), 0)
+        # strided tensors take the elementwise path
+        self.assertEqual(torch.from_numpy(f).half()[::3].float(),
+                         torch.from_numpy(f.astype(np.float16)[::3].astype(np.float32)), 0)
+        storage = torch.HalfStorage(7).copy_(torch.FloatStorage([0.5, 1, 2, 3, 4, 5, 6]))
+        self.assertEqual(torch.FloatStorage(7).copy_(storage).tolist(), [0.5, 1, 2, 3, 4, 5, 6])
+
     @unittest.skipIf(not torch.cuda.is_available(), 'no CUDA')
     def test_half_tensor_cuda(self):
         x = torch.randn(5, 5).half()
@@ -5657,6 +5894,25 @@ class TestTorch(TestCase):
             t2.fill_(rnum)
             self.assertEqual(t1, t2, 0)
 
+    def test_from_file_readonly(self):
+        size = 10000
+        with tempfile.NamedTemporaryFile() as f:
+            s1 = torch.FloatStorage.from_file(f.name, True, size)
+            t1 = torch.FloatTensor(s1).copy_(torch.randn(size))
+
+            # sees the writes of the shared mapping
+            s2 = torch.FloatStorage.from_file(f.name, size=size, readonly=True)
+            t2 = torch.FloatTensor(s2)
+            self.assertEqual(t1, t2, 0)
+            t1.fill_(random.uniform(-1, 1))
+            self.assertEqual(t1, t2, 0)
+
+            # the file isn't grown
+            self.assertRaises(RuntimeError, lambda: torch.FloatStorage.from_file(
+                f.name, size=2 * size, readonly=True))
+            self.assertRaises(RuntimeError, lambda: torch.FloatStorage.from_file(
+                f.name, True, size, readonly=True))
+
     def test_print(self):
         for t in torch._tensor_classes:
             if t == torch.HalfTensor:
@@ -5889,6 +6145,35 @@ class TestTorch(TestCase):
         z = from_dlpack(to_dlpack(x))
         self.assertEqual(z, x)
 
+    def test_dlpack_capsule_lifetime(self):
+        x = torch.randn(3, 4)
+        capsule = to_dlpack(x)
+        z = from_dlpack(capsule)
+        self.assertEqual(z, x)
+        # a consumed capsule can't be consumed again
+        self.assertRaises(RuntimeError, lambda: from_dlpack(capsule))
+        # and an unconsumed one frees its tensor
+        del capsule
+        to_dlpack(torch.randn(3, 4))
+
+    @unittest.skipIf(not torch.cuda.is_available(), "No CUDA")
+    def test_dlpack_cuda_stream(self):
+        stream = torch.cuda.Stream()
+        x = torch.randn(64, 64).cuda()
+        expected = x.cpu() * 2
+        x.mul_(2)
+        with torch.cuda.stream(stream):
+            z = from_dlpack(to_dlpack(x, stream=stream))
+            y = z + 1
+        torch.cuda.current_stream().wait_stream(stream)
+        self.assertEqual(y.cpu(), expected + 1)
+
+        with torch.cuda.stream(stream):
+            w = x * 3
+            capsule = to_dlpack(w)
+        v = from_dlpack(capsule, stream=stream.cuda_stream)
+        self.assertEqual(v.cpu(), expected * 3)
+
     @unittest.skipIf(not TEST_NUMPY, "Numpy not found")
     def test_from_numpy(self):
         dtypes = [
@@ -6248,10 +6533,12 @@ class TestTorch(TestCase):
         self.assertEqual(double_tensor[2], 0.0, prec=0.0)  # tiny_double to zero
         torch.set_flush_denormal(False)
 
-    def test_unique_cpu(self):
-        x = torch.LongTensor([1, 2, 3, 2, 8, 5, 2, 3])
-        expected_unique = torch.LongTensor([1, 2, 3, 5, 8])
-        expected_inverse = torch.LongTensor([0, 1, 2, 1, 4, 3, 1, 2])
+    @staticmethod
+    def _test_unique(self, conv_fn):
+        x = conv_fn(torch.LongTensor([1, 2, 3, 2, 8, 5, 2, 3]))
+        expected_unique = conv_fn(torch.LongTensor([1, 2, 3, 5, 8]))
+        expected_inverse = conv_fn(torch.LongTensor([0, 1, 2, 1, 4, 3, 1, 2]))
+        expected_counts = conv_fn(torch.LongTensor([1, 3, 2, 1, 1]))
 
         x_unique = torch.unique(x)
         self.assertEqual(
@@ -6278,35 +6565,51 @@ class TestTorch(TestCase):
 
         # Tests unique on other types.
         int_unique, int_inverse = torch.unique(
-            torch.IntTensor([2, 1, 2]), sorted=True, return_inverse=True)
-        self.assertEqual(torch.IntTensor([1, 2]), int_unique)
-        self.assertEqual(torch.LongTensor([1, 0, 1]), int_inverse)
+            conv_fn(torch.IntTensor([2, 1, 2])), sorted=True, return_inverse=True)
+        self.assertEqual(conv_fn(torch.IntTensor([1, 2])), int_unique)
+        self.assertEqual(conv_fn(torch.LongTensor([1, 0, 1])), int_inverse)
 
         double_unique, double_inverse = torch.unique(
-            torch.DoubleTensor([2., 1.5, 2.1, 2.]),
+            conv_fn(torch.DoubleTensor([2., 1.5, 2.1, 2.])),
             sorted=True,
             return_inverse=True,
         )
-        self.assertEqual(torch.DoubleTensor([1.5, 2., 2.1]), double_unique)
-        self.assertEqual(torch.LongTensor([1, 0, 2, 1]), double_inverse)
+        self.assertEqual(conv_fn(torch.DoubleTensor([1.5, 2., 2.1])), double_unique)
+        self.assertEqual(conv_fn(torch.LongTensor([1, 0, 2, 1])), double_inverse)
 
         byte_unique, byte_inverse = torch.unique(
-            torch.ByteTensor([133, 7, 7, 7, 42, 128]),
+            conv_fn(torch.ByteTensor([133, 7, 7, 7, 42, 128])),
             sorted=True,
             return_inverse=True,
         )
-        self.assertEqual(torch.ByteTensor([7, 42, 128, 133]), byte_unique)
-        self.assertEqual(torch.LongTensor([3, 0, 0, 0, 1, 2]), byte_inverse)
+        self.assertEqual(conv_fn(torch.ByteTensor([7, 42, 128, 133])), byte_unique)
+        self.assertEqual(conv_fn(torch.LongTensor([3, 0, 0, 0, 1, 2])), byte_inverse)
 
-    @unittest.skipIf(not torch.cuda.is_available(), 'no CUDA')
-    def test_unique_cuda(self):
-        # unique currently does not support CUDA.
-        self.assertRaises(
-            RuntimeError, lambda: torch.cuda.LongTensor([0, 1]).unique())
-        self.assertRaises(
-            RuntimeError,
-            lambda: torch.unique(torch.cuda.FloatTensor([0., 1.])),
-        )
+        # Tests counts, alone and with the inverse.
+        x_unique, x_counts = x.unique(sorted=True, return_counts=True)
+        self.assertEqual(expected_unique, x_unique)
+        self.assertEqual(expected_counts, x_counts)
+
+        x_unique, x_inverse, x_counts = torch.unique(
+            x, sorted=True, return_inverse=True, return_counts=True)
+        self.assertEqual(expected_unique, x_unique)
+        self.assertEqual(expected_inverse, x_inverse)
+        self.assertEqual(expected_counts, x_counts)
+
+        # Tests an input large enough to be split up.
+        z = conv_fn(torch.LongTensor(200000).random_(0, 5000))
+        z_unique, z_inverse, z_counts = z.unique(return_inverse=True, return_counts=True)
+        self.assertEqual(z_unique[z_inverse], z)
+        self.assertEqual(z_counts.sum(), z.numel())
+        self.assertEqual(sorted(z_unique.tolist()), sorted(set(z.tolist())))
+        for value, count in zip(z_unique.tolist()[:10], z_counts.tolist()[:10]):
+            self.assertEqual(count, (z == value).sum())
+        z_unique_sorted, z_counts_sorted = z.unique(sorted=True, return_counts=True)
+        self.assertEqual(z_unique_sorted, z_unique.sort()[0])
+        self.assertEqual(z_counts_sorted, z_counts[z_unique.sort()[1]])
+
+    def test_unique(self):
+        self._test_unique(self, lambda x: x)
 
 
 # Functions to test negative dimension wrapping
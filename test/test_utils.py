@@ -14,6 +14,7 @@ import torch.cuda
 import warnings
 from torch.autograd import Variable
 from torch.utils.trainer import Trainer
+from torch.utils.checkpoint import checkpoint, checkpoint_sequential
 from torch.utils.trainer.plugins import *
 from torch.utils.trainer.plugins.plugin import Plugin
 from torch.utils.serialization import load_lua
@@ -112,6 +113,65 @@ class DatasetMock(object):
         return 10
 
 
+class TestCheckpoint(TestCase):
+
+    def _check_grads(self, model, module_lists, segments, input):
+        x = Variable(input.clone(), requires_grad=True)
+        out = model(x)
+        out.sum().backward()
+        expected_grads = [p.grad.data.clone() for p in model.parameters()]
+        expected_input_grad = x.grad.data.clone()
+        model.zero_grad()
+
+        x = Variable(input.clone(), requires_grad=True)
+        out_checkpointed = checkpoint_sequential(module_lists, segments, x)
+        self.assertEqual(out, out_checkpointed)
+        out_checkpointed.sum().backward()
+        for p, expected in zip(model.parameters(), expected_grads):
+            self.assertEqual(p.grad.data, expected)
+        self.assertEqual(x.grad.data, expected_input_grad)
+
+    def test_checkpoint_sequential(self):
+        model = torch.nn.Sequential(
+            torch.nn.Linear(100, 50),
+            torch.nn.ReLU(),
+            torch.nn.Linear(50, 20),
+            torch.nn.ReLU(),
+            torch.nn.Linear(20, 5),
+            torch.nn.ReLU(),
+        )
+        input = torch.randn(1, 100)
+        self._check_grads(model, model, 2, input)
+        self._check_grads(model, list(model.children()), 3, input)
+
+    def test_checkpoint_rng_state(self):
+        model = torch.nn.Sequential(
+            torch.nn.Linear(10, 10),
+            torch.nn.Dropout(0.5),
+            torch.nn.Linear(10, 10),
+            torch.nn.Dropout(0.5),
+        )
+        input = torch.randn(4, 10)
+        state = torch.get_rng_state()
+        # the dropout masks of the recomputation are the ones of forward
+        torch.set_rng_state(state)
+        x = Variable(input.clone(), requires_grad=True)
+        model(x).sum().backward()
+        expected = x.grad.data.clone()
+        torch.set_rng_state(state)
+        x = Variable(input.clone(), requires_grad=True)
+        out = checkpoint(model, x)
+        torch.randn(10)
+        out.sum().backward()
+        self.assertEqual(x.grad.data, expected)
+
+    def test_checkpoint_grad_fails(self):
+        linear = torch.nn.Linear(10, 10)
+        x = Variable(torch.randn(2, 10), requires_grad=True)
+        out = checkpoint(linear, x)
+        self.assertRaises(RuntimeError, lambda: torch.autograd.grad(out.sum(), x))
+
+
 class TestDataLoader(TestCase):
     def setUp(self):
         self.dataset = torch.randn(5, 3, 3, 2)
@@ -114,7 +114,7 @@ if (${cond}) {
 """)
 
 RECORD_FUNCTION = CodeTemplate("""\
-profiler::RecordFunction profiler("${name}");""")
+profiler::RecordFunction profiler(${profiler_args});""")
 
 PRE_RECORD_TRACE = CodeTemplate("""\
 jit::tracer::PreTraceInfo trace_info;
@@ -465,7 +465,9 @@ def emit_body(declaration):
 
     body = []
     if base_name not in DONT_PROFILE:
-        body.append(RECORD_FUNCTION.substitute(combined))
+        # the inputs are passed so that the profiler can record their sizes
+        profiled_inputs = [arg['name'] for arg in inputs if arg['simple_type'] in {'Tensor', 'TensorList'}]
+        body.append(RECORD_FUNCTION.substitute(profiler_args=['"{}"'.format(name)] + profiled_inputs))
     if strategy != 'use_type':
         body.extend(unpack_args(env, declaration))
     if requires_derivative:
@@ -9,6 +9,7 @@
 #endif
 #include <math.h>
 #include <algorithm>
+#include <numeric>
 
 // ${generated_comment}
 
@@ -496,6 +497,71 @@ Tensor unfold_backward(const Tensor & grad, IntList input_sizes, int64_t dim, in
   return grad_input.view(input_sizes);
 }
 
+// The adjoint of a DFT is the inverse DFT times the signal size, so this is
+// mostly the transform in the other direction. The real-to-complex and
+// complex-to-real cases need care because grad is not conjugate symmetric.
+Tensor fft_backward(const Tensor& self, const Tensor& grad, int64_t signal_ndim,
+                    bool complex_input, bool complex_output,
+                    bool inverse, IntList checked_signal_sizes,
+                    bool normalized, bool onesided,
+                    IntList output_sizes) {
+  Tensor gI;
+  if (!complex_input && complex_output) {
+    // Forward is R2C. The onesided result is the first half of a C2C
+    // transform of the input with a zero imaginary part, so zero-fill the
+    // missing half of grad, do the inverse C2C transform and keep the real
+    // part.
+    auto full_grad = grad;
+    int64_t zero_length = checked_signal_sizes[signal_ndim - 1] - grad.size(signal_ndim);
+    if (onesided && zero_length > 0) {
+      auto zero_sizes = grad.sizes().vec();
+      zero_sizes[signal_ndim] = zero_length;
+      full_grad = at::cat({grad, at::zeros(grad.type(), zero_sizes)}, signal_ndim);
+    }
+    gI = at::_fft_with_size(full_grad, signal_ndim, /* complex_input */ true,
+                            /* complex_output */ true, !inverse,
+                            checked_signal_sizes, normalized,
+                            /* onesided */ false, full_grad.sizes()).select(-1, 0);
+  } else if (complex_input && !complex_output && onesided) {
+    // Forward is onesided C2R, i.e. fill the other half by conjugate
+    // symmetry, C2C and drop the imaginary part. So the backward is R2C,
+    // where the entries whose reflections fall out of the onesided range
+    // (indices 1 to N - onesided_length of the last dim) are counted twice.
+    gI = at::_fft_with_size(grad, signal_ndim, /* complex_input */ false,
+                            /* complex_output */ true, /* inverse */ false,
+                            checked_signal_sizes, normalized, /* onesided */ true,
+                            self.sizes());
+    int64_t double_length = checked_signal_sizes[signal_ndim - 1] - self.size(signal_ndim);
+    if (double_length > 0) {
+      gI.narrow(signal_ndim, 1, double_length).mul_(2);
+    }
+  } else {
+    gI = at::_fft_with_size(grad, signal_ndim, complex_input, complex_output,
+                            !inverse, checked_signal_sizes, normalized, onesided,
+                            grad.sizes());
+  }
+  if (!normalized) {
+    // unnormalized forward transforms are unscaled, and inverse ones divide
+    // by the signal size
+    auto signal_numel = std::accumulate(checked_signal_sizes.begin(),
+        checked_signal_sizes.end(), 1, std::multiplies<int64_t>());
+    if (!inverse) {
+      gI.mul_(static_cast<double>(signal_numel));
+    } else {
+      gI.div_(static_cast<double>(signal_numel));
+    }
+  }
+  return gI;
+}
+
+Tensor euclidean_dist_backward(const Tensor & grad, const Tensor & x1, const Tensor & x2, const Tensor & dist) {
+  // sum_j grad_ij * (x1_i - x2_j) / dist_ij, as matrix multiplies like the
+  // forward. Coinciding points get no gradient.
+  auto weight = grad / dist;
+  weight.masked_fill_(dist == 0, 0);
+  return x1 * weight.sum(1, true) - weight.mm(x2);
+}
+
 Tensor var_backward(const Tensor & grad, const Tensor & self, bool unbiased) {
   return (2.0 / (self.numel() - unbiased)) * grad * (self - self.mean());
 }
@@ -527,6 +593,17 @@ Tensor masked_scatter_backward(const Tensor & grad, const Tensor & mask, IntList
 }
 
 Tensor potrf_backward(Tensor grad, bool upper, Tensor L) {
+  if (L.dim() > 2) {
+    // a batch of factorizations, whose matrices don't depend on each other
+    auto n = L.size(-1);
+    auto grads = grad.contiguous().view({-1, n, n});
+    auto factors = L.contiguous().view({-1, n, n});
+    std::vector<Tensor> results;
+    for (int64_t i = 0; i < factors.size(0); ++i) {
+      results.push_back(potrf_backward(grads[i], upper, factors[i]));
+    }
+    return at::stack(results).view(L.sizes());
+  }
   // cf. Iain Murray (2016); arXiv 1602.07527
   if (upper) {
     L = L.t();
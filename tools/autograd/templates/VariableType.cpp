@@ -233,6 +233,7 @@ static Tensor as_variable(Tensor tensor) {
 
 static std::vector<Tensor> as_variable(TensorList tl) {
   std::vector<Tensor> variables;
+  variables.reserve(tl.size());
   for (auto& t : tl) {
     variables.emplace_back(make_variable(std::move(t), /*requires_grad=*/false));
   }
@@ -60,10 +60,20 @@ def is_magic_method(api_name):
     return api_name.startswith('__') and api_name.endswith('__')
 
 
+# In-place ops that the inference-mode executor substitutes for their
+# out-of-place versions, to reuse intermediates that have no other uses.
+# Keep in sync with reusable_ops in torch/csrc/jit/passes/inplace_check.cpp
+inplace_reuse_ops = {
+    'add_', 'div_', 'exp_', 'mul_', 'neg_', 'relu_', 'sigmoid_', 'sub_',
+    'tanh_', 'threshold_',
+}
+
+
 def is_jit_op(decl):
     uses_tensors = any(arg['simple_type'] in {'Tensor', 'TensorList'} for arg in decl['arguments']) or \
         'Tensor' in decl['method_of']
-    return ((not decl['api_name'].endswith('_') or is_magic_method(decl['api_name'])) and
+    return ((not decl['api_name'].endswith('_') or is_magic_method(decl['api_name']) or
+             decl['api_name'] in inplace_reuse_ops) and
             not decl['name'].endswith('_out') and
             not any(arg['simple_type'] == 'Generator' for arg in decl['arguments']) and
             not any(arg['simple_type'] == 'SparseTensor' for arg in decl['arguments']) and
@@ -77,6 +87,7 @@ def is_jit_op(decl):
 skip_scalar_overload = {
     'lt-2': [1], 'gt-2': [1], 'le-2': [1], 'ge-2': [1], 'eq-2': [1], 'ne-2': [1],
     'pow-2': [0, 1], 'add-3': [1], 'sub-3': [1], 'mul-2': [1], 'div-2': [1],
+    'add_-3': [1], 'sub_-3': [1], 'mul_-2': [1], 'div_-2': [1],
     'fmod-2': [1], 'remainder-2': [1], '__and__-2': [1], '__or__-2': [1],
     '__iand__-2': [1], '__ior__-2': [1], '__xor__-2': [1], '__ixor__-2': [1],
     '__lshift__-2': [1], '__ilshift__-2': [1], '__rshift__-2': [1], '__irshift__-2': [1],
@@ -121,6 +132,9 @@ def gen_jit_dispatch(declarations, out):
             # the first argument, that is then followed by a number of positional args.
             if arg['simple_type'] == 'TensorList':
                 arguments.append('peekSlice(stack, 0, varargs_length - {}, varargs_length)'.format(static_inputs))
+            elif arg.get('type') == 'Tensor &':
+                # the in-place ops take self by non-const reference
+                arguments.append('peek(stack, {}, {})'.format(next(real_inputs), static_inputs))
             elif is_tensor_arg(arg):
                 arguments.append('std::move(peek(stack, {}, {}))'.format(next(real_inputs), static_inputs))
             elif is_positional_arg[i]:
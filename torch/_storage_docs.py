@@ -26,12 +26,17 @@ def add_docstr_all(method, docstr):
 
 add_docstr_all('from_file',
                """
-from_file(filename, shared=False, size=0) -> Storage
+from_file(filename, shared=False, size=0, readonly=False) -> Storage
 
 If `shared` is `True`, then memory is shared between all processes.
 All changes are written to the file. If `shared` is `False`, then the changes on
 the storage do not affect the file.
 
+If `readonly` is `True`, the file is mapped read-only and shared with all the
+other processes mapping it, e.g. to serve one copy of model weights from
+``/dev/shm`` to many processes. Writing to the storage is an error that
+terminates the process. `readonly` can't be combined with `shared`.
+
 `size` is the number of elements in the storage. If `shared` is `False`,
 then the file must contain at least `size * sizeof(Type)` bytes
 (`Type` is the type of storage). If `shared` is `True` the file will be
@@ -41,4 +46,5 @@ Args:
     filename (str): file name to map
     shared (bool): whether to share memory
     size (int): number of elements in the storage
+    readonly (bool): whether to map the file read-only
 """)
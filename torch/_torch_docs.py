@@ -710,6 +710,38 @@ Example::
 
 """)
 
+add_docstr(torch.cdist,
+           r"""
+cdist(x1, x2, p=2) -> Tensor
+
+Computes the p-norm distance between each pair of rows of :attr:`x1` and
+:attr:`x2`.
+
+:math:`\text{out}_{i,j} = \left\| x1_{i} - x2_{j} \right\|_p`
+
+For :attr:`p` = 2 and more than a few rows, the distances are computed from
+the norms of the rows and a matrix multiply, which is much faster but less
+precise for points that are close compared to their norms.
+
+Args:
+    x1 (Tensor): the first set of points, of size :math:`(P, M)`
+    x2 (Tensor): the second set of points, of size :math:`(R, M)`
+    p (float, optional): the norm to use, between 0 and :math:`\infty`.
+        Default: 2
+
+Returns a tensor of size :math:`(P, R)`.
+
+Example::
+
+    >>> a = torch.Tensor([[0, 0], [3, 4]])
+    >>> b = torch.Tensor([[0, 0], [1, 1], [3, 0]])
+    >>> torch.cdist(a, b)
+
+     0.0000  1.4142  3.0000
+     5.0000  3.6056  4.0000
+    [torch.FloatTensor of size (2,3)]
+""")
+
 add_docstr(torch.ceil,
            r"""
 ceil(input, out=None) -> Tensor
@@ -1976,6 +2008,10 @@ A, in order as a tuple `X, LU`.
 If `A` is an :math:`(m \times m)` matrix and `B` is :math:`(m \times k)`,
 the result `LU` is :math:`(m \times m)` and `X` is :math:`(m \times k)`.
 
+`A` can also be a batch of matrices of size :math:`(*, m, m)`, in which case
+`B` has to be :math:`(*, m, k)` with the same batch dimensions, and each
+system is solved on its own.
+
 .. note::
 
     Irrespective of the original strides, the returned matrices
@@ -2126,13 +2162,18 @@ inverse(input, out=None) -> Tensor
 
 Takes the inverse of the square matrix :attr:`input`.
 
+If :attr:`input` has more than 2 dimensions, it is a batch of square
+matrices in its last two dimensions, and the result holds the inverse of
+each of them. The matrices of a batch are inverted in parallel.
+
 .. note::
 
     Irrespective of the original strides, the returned matrix will be
-    transposed, i.e. with strides `(1, m)` instead of `(m, 1)`
+    transposed, i.e. with strides `(1, m)` instead of `(m, 1)`. This does
+    not apply to batches of matrices.
 
 Args:
-    input (Tensor): the input 2-D square tensor
+    input (Tensor): the input 2-D square tensor, or batch of square matrices
     out (Tensor, optional): the optional output tensor
 
 Example::
@@ -3620,8 +3661,12 @@ the decomposition has the form:
 
     A = LL^T
 
+If :attr:`a` has more than 2 dimensions, it is a batch of matrices in its
+last two dimensions, and each of them is factorized.
+
 Args:
-    a (Tensor): the input 2-D tensor, a symmetric positive-definite matrix
+    a (Tensor): the input 2-D tensor, a symmetric positive-definite matrix,
+        or a batch of such matrices
     upper (bool, optional): flag that indicates whether to return the
                             upper or lower triangular matrix
     out (Tensor, optional): the output matrix
@@ -3726,6 +3771,9 @@ returned such that:
 
 .. note:: :attr:`b` is always a 2-D tensor, use `b.unsqueeze(1)` to convert a vector.
 
+If :attr:`u` is a batch of factors of size :math:`(*, m, m)`, :attr:`b` has to
+be :math:`(*, m, k)` with the same batch dimensions.
+
 Args:
     b (Tensor): the right hand side 2-D tensor
     u (Tensor): the input 2-D tensor, a upper or lower triangular Cholesky factor
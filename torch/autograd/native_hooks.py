@@ -0,0 +1,84 @@
+r"""Gradient hooks implemented in C++.
+
+The autograd engine holds the GIL while it runs Python hooks, so a Python hook
+on a tensor serializes the backward passes of all the threads of a process.
+The hooks in this module are implemented in C++ and run without the GIL. They
+are registered with :meth:`torch.Tensor.register_hook` like Python hooks, and
+run before the Python hooks of the tensor, in the order they were registered.
+
+C++ extensions can define their own native hooks by returning a
+``std::shared_ptr<torch::autograd::NativeGradHook>`` to Python.
+"""
+import torch
+
+
+def clamp(min, max):
+    r"""Returns a hook that clamps every element of the gradient to
+    ``[min, max]``.
+
+    Example::
+
+        >>> w.register_hook(torch.autograd.native_hooks.clamp(-1, 1))
+    """
+    return torch.autograd._clamp_grad_hook(min, max)
+
+
+def scale(factor):
+    r"""Returns a hook that multiplies the gradient by :attr:`factor`."""
+    return torch.autograd._scale_grad_hook(factor)
+
+
+def clip_norm(max_norm, norm_type=2):
+    r"""Returns a hook that scales the gradient down so that its norm is at
+    most :attr:`max_norm`. Unlike :func:`torch.nn.utils.clip_grad_norm_`, the
+    norm is the one of the gradient of a single tensor.
+
+    Arguments:
+        max_norm (float): max norm of the gradient
+        norm_type (float): type of the p-norm. Can be ``'inf'`` for the
+            infinity norm.
+    """
+    return torch.autograd._clip_grad_norm_hook(max_norm, float(norm_type))
+
+
+class GradBucket(object):
+    r"""Collects the gradients of a group of tensors with native hooks, so
+    that another thread can reduce them together, e.g. with a single
+    allreduce, as soon as the last of them is computed, while the backward
+    pass goes on.
+
+    Arguments:
+        tensors (sequence of Tensor): tensors whose gradients are collected
+
+    Example::
+
+        >>> bucket = GradBucket(list(model.fc.parameters()))
+        >>> def reduce():
+        ...     grads = bucket.wait()
+        ...     flat = torch.cat([g.contiguous().view(-1) for g in grads])
+        ...     dist.all_reduce(flat)
+        >>> reducer = threading.Thread(target=reduce)
+        >>> reducer.start()
+        >>> loss.backward()
+        >>> reducer.join()
+    """
+
+    def __init__(self, tensors):
+        self._bucket = torch.autograd._GradBucket(len(tensors))
+        self._handles = [tensor.register_hook(self._bucket.hook(i))
+                         for i, tensor in enumerate(tensors)]
+
+    def __len__(self):
+        return len(self._bucket)
+
+    def wait(self):
+        r"""Blocks until the gradients of all the tensors are computed, then
+        returns them in the order of the tensors and empties the bucket for
+        the next backward pass. The GIL is released while waiting."""
+        return self._bucket.wait()
+
+    def remove(self):
+        r"""Removes the hooks of the bucket from the tensors."""
+        for handle in self._handles:
+            handle.remove()
+        self._handles = []
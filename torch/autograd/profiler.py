@@ -142,6 +142,21 @@ class profile(object):
             Adds approximately 4us of overhead to each tensor operation.
             Default: ``False``
 
+        record_shapes (bool, optional): Records the sizes of the Tensor inputs of
+            each operation, in :attr:`FunctionEvent.input_shapes`. Default: ``False``
+
+        profile_memory (bool, optional): Records the CUDA memory allocated by each
+            operation (net of what it freed), in :attr:`FunctionEvent.cuda_memory_usage`.
+            Default: ``False``
+
+        sample_period (int, optional): Only profiles one in every ``sample_period``
+            top-level operations of each thread, along with everything they call,
+            to reduce the overhead on long runs. Default: ``1``
+
+        max_events (int, optional): If set, only the most recent (approximately)
+            ``max_events`` events of each thread are kept, so that memory use
+            stays bounded. Default: ``None``
+
     .. warning:
         This context managers should not be called recursively, i.e. at most one
         instance should be enabled at any given time.
@@ -166,9 +181,14 @@ class profile(object):
         N5torch8autograd5CloneE                        4.088us          0.000us
     """
 
-    def __init__(self, enabled=True, use_cuda=False):
+    def __init__(self, enabled=True, use_cuda=False, record_shapes=False,
+                 profile_memory=False, sample_period=1, max_events=None):
         self.enabled = enabled
         self.use_cuda = use_cuda
+        self.record_shapes = record_shapes
+        self.profile_memory = profile_memory
+        self.sample_period = sample_period
+        self.max_events = max_events
         self.function_events = None
         if not self.enabled:
             return
@@ -182,7 +202,8 @@ class profile(object):
         self.entered = True
         profiler_kind = torch.autograd.ProfilerState.CUDA if self.use_cuda \
             else torch.autograd.ProfilerState.CPU
-        torch.autograd._enable_profiler(profiler_kind)
+        torch.autograd._enable_profiler(profiler_kind, self.record_shapes, self.profile_memory,
+                                        self.sample_period, self.max_events or 0)
         return self
 
     def __exit__(self, exc_type, exc_val, exc_tb):
@@ -336,13 +357,16 @@ class Kernel(object):
 # TODO: record TID too
 class FunctionEvent(FormattedTimesMixin):
     """Profiling information about a single function."""
-    def __init__(self, id, name, thread, cpu_start, cpu_end):
+    def __init__(self, id, name, thread, cpu_start, cpu_end, input_shapes=None,
+                 cuda_memory_usage=0):
         self.id = id
         self.name = name
         self.cpu_interval = Interval(cpu_start, cpu_end)
         self.thread = thread
         self.kernels = []
         self.count = 1
+        self.input_shapes = input_shapes
+        self.cuda_memory_usage = cuda_memory_usage
 
     def append_kernel(self, name, device, start, end):
         self.kernels.append(Kernel(name, device, Interval(start, end)))
@@ -369,6 +393,7 @@ class FunctionEventAvg(FormattedTimesMixin):
     def __init__(self):
         self.key = None
         self.count = self.cpu_time_total = self.cuda_time_total = 0
+        self.cuda_memory_usage = 0
 
     def __iadd__(self, other):
         if self.key is None:
@@ -377,6 +402,7 @@ class FunctionEventAvg(FormattedTimesMixin):
         assert other.key == self.key
         self.cpu_time_total += other.cpu_time
         self.cuda_time_total += other.cuda_time
+        self.cuda_memory_usage += other.cuda_memory_usage
         self.count += 1
         return self
 
@@ -444,13 +470,23 @@ def parse_cpu_trace(thread_records):
             record_stack.append((next_id, record))
             next_id += 1
         elif record.kind() == 'pop':
+            # The list of a thread may have dropped its oldest events (see
+            # max_events), and with them the start of ranges that were open.
+            # Ranges nest, so those are the pops found with an empty stack.
+            if not record_stack or record_stack[-1][1].thread_id() != record.thread_id():
+                continue
             function_id, start = record_stack.pop()
+            cuda_memory_usage = 0
+            if start.cuda_memory() >= 0 and record.cuda_memory() >= 0:
+                cuda_memory_usage = record.cuda_memory() - start.cuda_memory()
             fe = FunctionEvent(
                 id=function_id,
                 name=string_table[start.name()],
                 thread=start.thread_id(),
                 cpu_start=start_record.cpu_elapsed_us(start),
-                cpu_end=start_record.cpu_elapsed_us(record))
+                cpu_end=start_record.cpu_elapsed_us(record),
+                input_shapes=start.shapes(),
+                cuda_memory_usage=cuda_memory_usage)
             if start.has_cuda():
                 cuda_start = adjusted_time(start)
                 cuda_end = adjusted_time(record)
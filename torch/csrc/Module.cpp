@@ -239,12 +239,24 @@ PyObject *THPModule_hasDistributed(PyObject *_unused)
 #endif
 }
 
+// Frees the tensor of a capsule that was never consumed; consumers rename
+// the capsule to "used_dltensor" and take over the tensor
+static void DLPack_Capsule_Destructor(PyObject* capsule) {
+  if (!PyCapsule_IsValid(capsule, "dltensor")) {
+    return;
+  }
+  DLManagedTensor* dlMTensor = (DLManagedTensor*)PyCapsule_GetPointer(capsule, "dltensor");
+  if (dlMTensor->deleter) {
+    dlMTensor->deleter(dlMTensor);
+  }
+}
+
 PyObject *THPModule_toDLPack(PyObject *_unused, PyObject *data)
 {
   HANDLE_TH_ERRORS
   THPUtils_assert(THPVariable_Check(data), "data must be a Tensor");
   DLManagedTensor* dlMTensor = at::toDLPack(THPVariable_UnpackData(data));
-  return PyCapsule_New(dlMTensor, "dltensor", NULL);
+  return PyCapsule_New(dlMTensor, "dltensor", DLPack_Capsule_Destructor);
   END_HANDLE_TH_ERRORS
 }
 
@@ -337,6 +349,27 @@ PyObject *THPModule_getDefaultDtype(PyObject *_unused, PyObject *arg) {
   END_HANDLE_TH_ERRORS
 }
 
+PyObject *THPModule_enableShmPool(PyObject *_unused) {
+  HANDLE_TH_ERRORS
+  libshm_enable_pool();
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject *THPModule_shmPoolStats(PyObject *_unused) {
+  HANDLE_TH_ERRORS
+  libshm_pool_stats stats;
+  libshm_get_pool_stats(&stats);
+  return Py_BuildValue("{s:K,s:K,s:K,s:K,s:K,s:L}",
+      "allocations", (unsigned long long)stats.allocations,
+      "reused", (unsigned long long)stats.reused,
+      "created", (unsigned long long)stats.created,
+      "fallbacks", (unsigned long long)stats.fallbacks,
+      "oversized", (unsigned long long)stats.oversized,
+      "pooled_bytes", (long long)stats.pooled_bytes);
+  END_HANDLE_TH_ERRORS
+}
+
 static PyMethodDef TorchMethods[] = {
   {"_initExtension",  (PyCFunction)THPModule_initExtension,   METH_O,       NULL},
   {"_autograd_init",  (PyCFunction)THPAutograd_initExtension, METH_NOARGS,  NULL},
@@ -360,6 +393,8 @@ static PyMethodDef TorchMethods[] = {
   {"_set_cudnn_deterministic", (PyCFunction)THPModule_setDeterministicCuDNN, METH_O,  NULL},
   {"_to_dlpack",      (PyCFunction)THPModule_toDLPack,          METH_O,       NULL},
   {"_from_dlpack",    (PyCFunction)THPModule_fromDLPack,        METH_O,       NULL},
+  {"_enable_shm_pool", (PyCFunction)THPModule_enableShmPool,    METH_NOARGS,  NULL},
+  {"_shm_pool_stats", (PyCFunction)THPModule_shmPoolStats,      METH_NOARGS,  NULL},
   {"set_flush_denormal", (PyCFunction)THPModule_setFlushDenormal, METH_O,     NULL},
   {"get_default_dtype", (PyCFunction)THPModule_getDefaultDtype, METH_NOARGS,  NULL},
   {NULL, NULL, 0, NULL}
@@ -524,6 +559,7 @@ static PyObject* initModule() {
   at::init();
 
   ASSERT_TRUE(PyModule_AddObject(module, "has_mkl", at::hasMKL() ? Py_True : Py_False) == 0);
+  ASSERT_TRUE(PyModule_AddObject(module, "has_mkldnn", at::hasMKLDNN() ? Py_True : Py_False) == 0);
 
   auto& defaultGenerator = at::globalContext().defaultGenerator(at::kCPU);
   THPDefaultGenerator = (THPGenerator*)THPGenerator_NewWithGenerator(
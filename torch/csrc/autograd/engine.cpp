@@ -1,14 +1,17 @@
 #include "torch/csrc/autograd/engine.h"
 
 #include "torch/csrc/autograd/function.h"
+#include "torch/csrc/autograd/functions/accumulate_grad.h"
 #include "torch/csrc/autograd/functions/basic_ops.h"
 #include "torch/csrc/autograd/grad_mode.h"
 #include "torch/csrc/autograd/variable.h"
+#include "torch/csrc/utils/arena.h"
 #include "torch/csrc/utils/auto_gpu.h"
 
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -38,12 +41,37 @@ static constexpr int NO_DEVICE = -2;
 // handling reentrant backwards calls; see Note [Reentrant backwards]
 static thread_local int worker_device = NO_DEVICE;
 
+// Index of the CPU worker running on this thread, or -1 if this thread is not
+// part of the CPU thread pool.  See Note [Multithreaded CPU backward]
+static thread_local int cpu_worker_index = -1;
+
+// The graph task whose function is being applied on this thread, or nullptr.
+// Reentrant backward calls replace it while they run.  Used to tell whether
+// a checkpointed function can recompute its segment; see is_checkpoint_valid.
+static thread_local GraphTask* current_graph_task = nullptr;
+
 // XXX: Changes to the way multithreading works in execute should be done with
 // great care. Right now the implementation guarantees that a single function's
 // apply will never be entered concurrently (even if multiple graphs are
 // executed at the same time). Adding multiple threads per-device or removing
 // engine thread affinity to the device can break this invariant, and we depend
 // on it in a few places (e.g. AccumulateGrad function).
+//
+// Note [Multithreaded CPU backward]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Setting TORCH_AUTOGRAD_CPU_THREADS=N (N > 1) replaces the single CPU worker
+// with a CPUThreadPool of N workers, so that independent branches of a
+// backward graph are evaluated concurrently.  Each worker owns a
+// WorkStealingQueue: tasks made ready by a worker are pushed to the back of its
+// own queue and popped from the back again (depth-first), while idle workers
+// steal from the front of the other queues.  Tasks made ready by threads
+// outside the pool (the caller of execute() and the device workers) go to a
+// shared injection queue.
+//
+// This relaxes the invariant above: different functions of a graph may now run
+// at the same time, and a function shared by concurrently executing graphs may
+// be entered concurrently.  The one place that cannot tolerate the latter,
+// AccumulateGrad, is serialized through accumulate_grad_mutex().
 
 struct FunctionTask {
   GraphTask* base;
@@ -74,6 +102,44 @@ struct ReadyQueue {
   FunctionTask pop();
 };
 
+// See Note [Multithreaded CPU backward]
+struct WorkStealingQueue {
+  std::mutex mutex;
+  std::deque<FunctionTask> tasks;
+
+  void push(FunctionTask item);
+  // Used by the owner of the queue
+  bool pop(FunctionTask& task);
+  // Used by all other workers
+  bool steal(FunctionTask& task);
+};
+
+struct CPUThreadPool {
+  explicit CPUThreadPool(int num_threads);
+
+  // Queues a task on the current worker's queue, or on the injection queue if
+  // called from outside the pool.
+  void push(FunctionTask item);
+  // Blocks until a task is available, returning true, or until graph_task (if
+  // given) has no outstanding tasks, returning false.
+  bool pop(FunctionTask& task, GraphTask* graph_task);
+  // Wakes up sleeping workers so that they re-check their graph_task.
+  void notify_all();
+
+  int num_threads() const { return queues.size(); }
+
+private:
+  bool try_pop(FunctionTask& task);
+
+  std::vector<std::unique_ptr<WorkStealingQueue>> queues;
+  WorkStealingQueue injected;
+  // Number of tasks in all queues; tasks are queued before it is incremented
+  // and dequeued before it is decremented.
+  std::atomic<int64_t> pending;
+  std::mutex sleep_mutex;
+  std::condition_variable work_available;
+};
+
 // Note [Reentrant backwards]
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~
 // To understand the reentrant backwards problem, we have to notice two
@@ -125,8 +191,30 @@ struct GraphTask {
   // Notified when a task finishes executing.  Check outstanding_tasks to see
   // if all tasks are done.
   std::condition_variable not_done;
-  std::unordered_map<Function*, InputBuffer> not_ready;
-  std::unordered_map<Function*, int> dependencies;
+
+  // Backs the per-function maps below, which get an entry for every function
+  // in the graph.  Their nodes are released in bulk when the task completes,
+  // instead of with one free per function.  Must be declared before the maps.
+  Arena arena;
+  template<typename T>
+  using FunctionMap = std::unordered_map<Function*, T, std::hash<Function*>,
+      std::equal_to<Function*>, ArenaAllocator<std::pair<Function* const, T>>>;
+  template<typename T>
+  FunctionMap<T> make_function_map() {
+    return FunctionMap<T>(0, std::hash<Function*>(), std::equal_to<Function*>(),
+                          ArenaAllocator<std::pair<Function* const, T>>(&arena));
+  }
+
+  FunctionMap<InputBuffer> not_ready;
+
+  // The set of functions is fixed by compute_dependencies, so the counts can be
+  // decremented without holding the mutex.
+  struct Dependency {
+    Dependency() : remaining(0), total(0) {}
+    std::atomic<int> remaining; // inputs that have not been produced yet
+    int total;                  // number of inputs from this graph
+  };
+  FunctionMap<Dependency> dependencies;
 
   struct ExecInfo {
     struct Capture {
@@ -146,7 +234,7 @@ struct GraphTask {
   // run in a "default" mode, which means that all next_edges we encounter should
   // get executed. If it's not empty, only functions that have an entry and this entry
   // has needed == True should be executed.
-  std::unordered_map<Function*, ExecInfo> exec_info;
+  FunctionMap<ExecInfo> exec_info;
   std::vector<Variable> captured_vars;
 
   void init_to_execute(Function& graph_root, const edge_list& captures);
@@ -163,8 +251,10 @@ struct GraphTask {
     , grad_mode(grad_mode)
     , mutex()
     , not_done()
-    , not_ready()
-    , dependencies()
+    , arena()
+    , not_ready(make_function_map<InputBuffer>())
+    , dependencies(make_function_map<Dependency>())
+    , exec_info(make_function_map<ExecInfo>())
     , owner(NO_DEVICE) {}
 };
 
@@ -184,7 +274,100 @@ auto ReadyQueue::pop() -> FunctionTask {
   return task;
 }
 
-Engine::Engine() : ready_queues() {
+auto WorkStealingQueue::push(FunctionTask item) -> void {
+  std::lock_guard<std::mutex> lock(mutex);
+  tasks.push_back(std::move(item));
+}
+
+auto WorkStealingQueue::pop(FunctionTask& task) -> bool {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (tasks.empty()) return false;
+  task = std::move(tasks.back());
+  tasks.pop_back();
+  return true;
+}
+
+auto WorkStealingQueue::steal(FunctionTask& task) -> bool {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (tasks.empty()) return false;
+  task = std::move(tasks.front());
+  tasks.pop_front();
+  return true;
+}
+
+CPUThreadPool::CPUThreadPool(int num_threads)
+  : queues()
+  , injected()
+  , pending(0) {
+  for (int i = 0; i < num_threads; ++i) {
+    queues.emplace_back(new WorkStealingQueue());
+  }
+}
+
+auto CPUThreadPool::push(FunctionTask item) -> void {
+  ++item.base->outstanding_tasks;
+  if (cpu_worker_index >= 0) {
+    queues[cpu_worker_index]->push(std::move(item));
+  } else {
+    injected.push(std::move(item));
+  }
+  ++pending;
+  {
+    // Synchronize with workers checking pending before they sleep
+    std::lock_guard<std::mutex> lock(sleep_mutex);
+  }
+  work_available.notify_one();
+}
+
+auto CPUThreadPool::try_pop(FunctionTask& task) -> bool {
+  int self = cpu_worker_index;
+  int n = num_threads();
+  if (self >= 0 && queues[self]->pop(task)) return true;
+  if (injected.steal(task)) return true;
+  for (int i = 1; i <= n; ++i) {
+    int victim = (self + i) % n;
+    if (victim != self && queues[victim]->steal(task)) return true;
+  }
+  return false;
+}
+
+auto CPUThreadPool::pop(FunctionTask& task, GraphTask* graph_task) -> bool {
+  auto graph_task_done = [graph_task]{
+    return graph_task && graph_task->outstanding_tasks.load() == 0;
+  };
+  while (true) {
+    if (try_pop(task)) {
+      --pending;
+      return true;
+    }
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    work_available.wait(lock, [&]{ return pending.load() > 0 || graph_task_done(); });
+    if (graph_task_done()) return false;
+  }
+}
+
+auto CPUThreadPool::notify_all() -> void {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex);
+  }
+  work_available.notify_all();
+}
+
+// Serializes AccumulateGrad when CPU functions run on multiple threads.  See
+// Note [Multithreaded CPU backward]
+static std::mutex& accumulate_grad_mutex(Function* fn) {
+  static constexpr size_t num_mutexes = 64;
+  static std::mutex mutexes[num_mutexes];
+  return mutexes[(reinterpret_cast<uintptr_t>(fn) >> 4) % num_mutexes];
+}
+
+static int num_cpu_threads_from_env() {
+  const char* env = std::getenv("TORCH_AUTOGRAD_CPU_THREADS");
+  int num_threads = env ? std::atoi(env) : 1;
+  return num_threads > 1 ? num_threads : 1;
+}
+
+Engine::Engine() : ready_queues(), cpu_pool() {
 }
 
 // This Engine's ReadyQueues and their corresponding threads are leaked here
@@ -213,10 +396,16 @@ auto Engine::thread_init(int device) -> void {
 // in case this code is to be changed.
 auto Engine::thread_main(GraphTask *graph_task) -> void {
   auto queue = ready_queues[worker_device + 1];
+  CPUThreadPool* pool = worker_device == -1 ? cpu_pool.get() : nullptr;
   // Why the test on graph_task->outstanding_tasks?  See
   // Note [Reentrant backwards]
   while (!graph_task || graph_task->outstanding_tasks > 0) {
-    FunctionTask task = queue->pop();
+    FunctionTask task(nullptr, nullptr, InputBuffer(0));
+    if (pool) {
+      if (!pool->pop(task, graph_task)) continue;
+    } else {
+      task = queue->pop();
+    }
     if (task.fn && !task.base->has_error.load()) {
       GradMode::set_enabled(task.base->grad_mode);
       try {
@@ -235,6 +424,12 @@ auto Engine::thread_main(GraphTask *graph_task) -> void {
         std::lock_guard<std::mutex> lock(task.base->mutex);
         task.base->not_done.notify_all();
       }
+    } else if (base_owner == -1 && cpu_pool) {
+      // The owner is one of the CPU workers, which may be sleeping; wake them
+      // all up so that it can leave thread_main.
+      if (--task.base->outstanding_tasks == 0) {
+        cpu_pool->notify_all();
+      }
     } else {
       // If it's a task initiated from this thread, decrease the counter, but
       // don't do anything - loop condition will do all checks for us next.
@@ -303,7 +498,19 @@ auto Engine::evaluate_function(FunctionTask& task) -> void {
     if (!fn_info.needed) return;
   }
 
-  auto outputs = call_function(task);
+  variable_list outputs;
+  GraphTask* const prev_graph_task = current_graph_task;
+  current_graph_task = task.base;
+  struct GraphTaskRestore {
+    GraphTask* prev;
+    ~GraphTaskRestore() { current_graph_task = prev; }
+  } restore_graph_task{prev_graph_task};
+  if (cpu_pool && dynamic_cast<AccumulateGrad*>(task.fn.get())) {
+    std::lock_guard<std::mutex> lock(accumulate_grad_mutex(task.fn.get()));
+    outputs = call_function(task);
+  } else {
+    outputs = call_function(task);
+  }
 
   auto& fn = *task.fn;
   if (!task.base->keep_graph) {
@@ -318,62 +525,67 @@ auto Engine::evaluate_function(FunctionTask& task) -> void {
   }
 
   int num_outputs = outputs.size();
-  if (num_outputs == 0) return; // Don't even acquire the mutex
-  std::lock_guard<std::mutex> lock(task.base->mutex);
+  if (num_outputs == 0) return;
+  auto& dependencies = task.base->dependencies;
+  auto& not_ready = task.base->not_ready;
   for (int i = 0; i < num_outputs; ++i) {
     auto& output = outputs[i];
     const auto& next = fn.next_edge(i);
 
     if (!next.is_valid()) continue;
 
-    // Check if the next function is ready to be computed
-    bool is_ready = false;
-    auto& dependencies = task.base->dependencies;
     auto it = dependencies.find(next.function.get());
     if (it == dependencies.end()) {
       auto name = next.function->name();
       throw std::runtime_error(std::string("dependency not found for ") + name);
-    } else if (--it->second == 0) {
-      dependencies.erase(it);
-      is_ready = true;
     }
-
-    auto& not_ready = task.base->not_ready;
-    auto not_ready_it = not_ready.find(next.function.get());
-    if (not_ready_it == not_ready.end()) {
-      // Skip functions that aren't supposed to be executed
-      if (!exec_info.empty()) {
-        auto it = exec_info.find(next.function.get());
-        if (it == exec_info.end() || !it->second.should_execute()) {
-          continue;
-        }
+    auto& dependency = it->second;
+
+    // Skip functions that aren't supposed to be executed
+    if (!exec_info.empty()) {
+      auto it = exec_info.find(next.function.get());
+      if (it == exec_info.end() || !it->second.should_execute()) {
+        --dependency.remaining;
+        continue;
       }
-      // No buffers have been allocated for the function
+    }
+
+    if (dependency.total == 1) {
+      // This is the only input of the function, so nobody else can touch its
+      // buffer and it is ready right away
+      --dependency.remaining;
       InputBuffer input_buffer(next.function->num_inputs());
       input_buffer.add(next.input_nr, std::move(output));
-      if (is_ready) {
-        auto& queue = ready_queue(input_buffer.device());
-        queue.push(FunctionTask(task.base, next.function, std::move(input_buffer)));
-      } else {
-        not_ready.emplace(next.function.get(), std::move(input_buffer));
-      }
-    } else {
-      // The function already has a buffer
-      auto &input_buffer = not_ready_it->second;
-      input_buffer.add(next.input_nr, std::move(output));
-      if (is_ready) {
-        auto& queue = ready_queue(input_buffer.device());
-        queue.push(FunctionTask(task.base, next.function, std::move(input_buffer)));
-        not_ready.erase(not_ready_it);
+      push_task(input_buffer.device(), FunctionTask(task.base, next.function, std::move(input_buffer)));
+      continue;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(task.base->mutex);
+      auto not_ready_it = not_ready.find(next.function.get());
+      if (not_ready_it == not_ready.end()) {
+        // No buffers have been allocated for the function
+        not_ready_it = not_ready.emplace(
+            next.function.get(), InputBuffer(next.function->num_inputs())).first;
       }
+      not_ready_it->second.add(next.input_nr, std::move(output));
+    }
+
+    // Every producer adds to the buffer before counting its input as done, so
+    // the one that produces the last input sees all the others' additions
+    if (--dependency.remaining == 0) {
+      std::unique_lock<std::mutex> lock(task.base->mutex);
+      auto not_ready_it = not_ready.find(next.function.get());
+      InputBuffer input_buffer = std::move(not_ready_it->second);
+      not_ready.erase(not_ready_it);
+      lock.unlock();
+      push_task(input_buffer.device(), FunctionTask(task.base, next.function, std::move(input_buffer)));
     }
   }
 }
 
 /* Computes the number of dependencies for each function which requires grad */
 auto Engine::compute_dependencies(Function* root, GraphTask& task) -> void {
-  // Just to make sure that they will never be added to the queue again
-  std::unordered_set<Function*> seen;
   std::vector<Function*> queue { root };
 
   // Queue contains all nodes that will start propagating gradients.
@@ -383,9 +595,11 @@ auto Engine::compute_dependencies(Function* root, GraphTask& task) -> void {
     auto fn = queue.back(); queue.pop_back();
     for (const auto& edge : fn->next_edges()) {
       if (auto next_ptr = edge.function.get()) {
-        dependencies[next_ptr] += 1;
-        const bool was_inserted = seen.insert(next_ptr).second;
-        if (was_inserted) queue.push_back(next_ptr);
+        auto& dependency = dependencies[next_ptr];
+        ++dependency.remaining;
+        // A function is expanded only the first time it is reached, so that
+        // it will never be added to the queue again
+        if (++dependency.total == 1) queue.push_back(next_ptr);
       }
     }
   }
@@ -425,7 +639,10 @@ auto Engine::execute(const edge_list& input_roots,
   if (!outputs.empty()) {
     graph_task.init_to_execute(*graph_root, outputs);
   }
-  ready_queue(-1).push(FunctionTask(&graph_task, std::move(graph_root), InputBuffer(0)));
+  // Set the owner before queueing the root, since another CPU worker may steal
+  // it and finish the whole graph right away.  See Note [Reentrant backwards]
+  graph_task.owner = worker_device;
+  push_task(-1, FunctionTask(&graph_task, std::move(graph_root), InputBuffer(0)));
 
   // Not a worker
   if (worker_device == NO_DEVICE) {
@@ -437,7 +654,6 @@ auto Engine::execute(const edge_list& input_roots,
     // Get back to work while we wait for our new graph_task to
     // complete!
     // See Note [Reentrant backwards]
-    graph_task.owner = worker_device;
     lock.unlock();
     thread_main(&graph_task);
   }
@@ -471,6 +687,13 @@ Engine& Engine::getDefaultEngine() {
 }
 #endif
 
+bool Engine::is_checkpoint_valid() {
+  // Recomputing a segment runs a nested backward through the whole segment,
+  // which would ignore the inputs a call to autograd.grad restricts the
+  // execution to.
+  return !current_graph_task || current_graph_task->exec_info.empty();
+}
+
 void Engine::queue_callback(std::function<void()> callback) {
   std::lock_guard<std::mutex> lock(post_callbacks_lock);
   final_callbacks.emplace_back(std::move(callback));
@@ -480,6 +703,14 @@ auto Engine::ready_queue(int device) -> ReadyQueue& {
   return *ready_queues.at(device + 1);
 }
 
+auto Engine::push_task(int device, FunctionTask task) -> void {
+  if (device == -1 && cpu_pool) {
+    cpu_pool->push(std::move(task));
+  } else {
+    ready_queue(device).push(std::move(task));
+  }
+}
+
 auto Engine::start_threads() -> void {
   int num_devices = 0;
 #ifdef WITH_CUDA
@@ -494,7 +725,19 @@ auto Engine::start_threads() -> void {
   ready_queues = std::vector<std::shared_ptr<ReadyQueue>>(num_threads);
   for (auto& queue : ready_queues)
     queue.reset(new ReadyQueue());
-  for (int i = 0; i < num_threads; ++i) {
+  // See Note [Multithreaded CPU backward]
+  int num_cpu_threads = num_cpu_threads_from_env();
+  if (num_cpu_threads > 1) {
+    cpu_pool = std::make_shared<CPUThreadPool>(num_cpu_threads);
+    for (int i = 0; i < num_cpu_threads; ++i) {
+      std::thread t([this, i] {
+        cpu_worker_index = i;
+        thread_init(-1);
+      });
+      t.detach();
+    }
+  }
+  for (int i = cpu_pool ? 1 : 0; i < num_threads; ++i) {
     std::thread t(&Engine::thread_init, this, i - 1);
     t.detach();
   }
@@ -16,6 +16,7 @@
 namespace torch { namespace autograd {
 
 struct ReadyQueue;
+struct CPUThreadPool;
 struct FunctionTask;
 struct GraphTask;
 
@@ -39,12 +40,18 @@ struct Engine {
 
   void queue_callback(std::function<void()> callback);
 
+  // False if the calling function runs as part of a backward pass that only
+  // computes the gradients of some inputs (autograd.grad), in which case
+  // activation checkpointing cannot recompute its segment.
+  bool is_checkpoint_valid();
+
   static Engine& getDefaultEngine();
 
 protected:
   void compute_dependencies(Function* root, GraphTask& task);
   void evaluate_function(FunctionTask& task);
   ReadyQueue& ready_queue(int device);
+  void push_task(int device, FunctionTask task);
   void start_threads();
   virtual void thread_init(int device);
   virtual void thread_main(GraphTask *task);
@@ -52,6 +59,9 @@ protected:
 
   std::once_flag start_threads_flag;
   std::vector<std::shared_ptr<ReadyQueue>> ready_queues;
+  // Only set if CPU functions run on multiple threads.
+  // See Note [Multithreaded CPU backward]
+  std::shared_ptr<CPUThreadPool> cpu_pool;
   std::vector<std::function<void()>> final_callbacks;
   std::mutex post_callbacks_lock;
 };
@@ -42,9 +42,7 @@ variable_list Function::traced_apply(variable_list inputs) {
   }
   auto* this_node = graph->createCppOp(get_shared_ptr(), std::move(var_flags));
 #ifndef NO_PYTHON
-  this_node->setSourceLocation(std::make_shared<StringSourceLocation>(
-        jit::tracer::getPythonInterpreterStackTrace()
-  ));
+  this_node->setSourceLocation(jit::tracer::getPythonSourceLocation(*state));
 #endif
   for (auto& input: inputs) {
     this_node->addInput(tracer::getValueTrace(state, input));
@@ -323,10 +323,24 @@ struct TraceableFunction : public Function {
 
 namespace detail {
 // Implementation of `collect_next_edges` (see below).
+// NB: these take at::Tensor rather than Variable, since generated code passes
+// the former and the implicit conversion would copy every argument.
+struct CountNextEdges : IterArgs<CountNextEdges> {
+  size_t out = 0;
+  using IterArgs<CountNextEdges>::operator();
+  void operator()(const at::Tensor&) {
+    out++;
+  }
+  void operator()(at::ArrayRef<at::Tensor> tensors) {
+    out += tensors.size();
+  }
+};
+
 struct MakeNextFunctionList : IterArgs<MakeNextFunctionList> {
   edge_list next_edges;
   using IterArgs<MakeNextFunctionList>::operator();
-  void operator()(const Variable& variable) {
+  void operator()(const at::Tensor& tensor) {
+    const auto& variable = static_cast<const Variable&>(tensor);
     if (variable.defined()) {
       next_edges.push_back(variable.gradient_edge());
     } else {
@@ -368,6 +382,7 @@ edge_list collect_next_edges(Variables&&... variables) {
   if (!GradMode::is_enabled())
     return {};
   detail::MakeNextFunctionList make;
+  make.next_edges.reserve(detail::CountNextEdges().apply(variables...).out);
   make.apply(std::forward<Variables>(variables)...);
   return std::move(make.next_edges);
 }
@@ -3,6 +3,7 @@
 #include "torch/csrc/Exceptions.h"
 #include "torch/csrc/utils/pybind.h"
 #include "torch/csrc/autograd/grad_mode.h"
+#include "torch/csrc/autograd/native_hook.h"
 #include "torch/csrc/autograd/profiler.h"
 #include "torch/csrc/autograd/python_function.h"
 
@@ -31,16 +32,45 @@ PyObject * THPAutograd_initExtension(PyObject *_unused)
   .def("device",&torch::autograd::profiler::Event::device)
   .def("cpu_elapsed_us",&torch::autograd::profiler::Event::cpu_elapsed_us)
   .def("cuda_elapsed_us",&torch::autograd::profiler::Event::cuda_elapsed_us)
-  .def("has_cuda",&torch::autograd::profiler::Event::has_cuda);
+  .def("has_cuda",&torch::autograd::profiler::Event::has_cuda)
+  .def("shapes",&torch::autograd::profiler::Event::shapes)
+  .def("cuda_memory",&torch::autograd::profiler::Event::cuda_memory);
   py::enum_<torch::autograd::profiler::ProfilerState>(m,"ProfilerState")
   .value("Disabled", torch::autograd::profiler::ProfilerState::Disabled)
   .value("CPU", torch::autograd::profiler::ProfilerState::CPU)
   .value("CUDA", torch::autograd::profiler::ProfilerState::CUDA)
   .value("NVTX", torch::autograd::profiler::ProfilerState::NVTX);
 
-  m.def("_enable_profiler", torch::autograd::profiler::enableProfiler);
+  m.def("_enable_profiler", torch::autograd::profiler::enableProfiler,
+        py::arg("state"), py::arg("record_shapes") = false, py::arg("profile_memory") = false,
+        py::arg("sample_period") = 1, py::arg("max_events") = 0);
   m.def("_disable_profiler", torch::autograd::profiler::disableProfiler);
 
+  using torch::autograd::NativeGradHook;
+  using torch::autograd::NativeHookHandle;
+  using torch::autograd::GradBucket;
+  py::class_<NativeGradHook, std::shared_ptr<NativeGradHook>>(m, "NativeGradHook")
+  .def_readonly("name", &NativeGradHook::name)
+  .def("__repr__", [](const NativeGradHook& hook) {
+    return "<NativeGradHook " + hook.name + ">";
+  });
+  py::class_<NativeHookHandle>(m, "_NativeHookHandle")
+  .def("remove", &NativeHookHandle::remove)
+  .def("__enter__", [](py::object self) { return self; })
+  .def("__exit__", [](NativeHookHandle& self, py::args) { self.remove(); });
+  py::class_<GradBucket, std::shared_ptr<GradBucket>>(m, "_GradBucket")
+  .def(py::init<size_t>())
+  .def("__len__", &GradBucket::size)
+  .def("hook", &GradBucket::hook)
+  .def("wait", &GradBucket::wait, py::call_guard<py::gil_scoped_release>());
+
+  m.def("_register_native_hook", [](torch::autograd::Variable var, std::shared_ptr<NativeGradHook> hook) {
+    return torch::autograd::add_native_hook(var, std::move(hook));
+  });
+  m.def("_clamp_grad_hook", &torch::autograd::clamp_grad_hook);
+  m.def("_scale_grad_hook", &torch::autograd::scale_grad_hook);
+  m.def("_clip_grad_norm_hook", &torch::autograd::clip_grad_norm_hook);
+
   m.def("_push_range", [](const char *name) {
     using namespace torch::autograd::profiler;
     if (state  == ProfilerState::Disabled) return;
@@ -15,7 +15,15 @@ void InputBuffer::add(size_t pos, Variable var) {
   auto& old_var = buffer[pos];
   if (!old_var.defined()) {
     buffer[pos] = std::move(var);
+  } else if (old_var.type().is_sparse() && var.type() == old_var.type() &&
+             !old_var.requires_grad() && !var.requires_grad()) {
+    // The sum is not differentiated (no create_graph), so it can wait
+    if (sparse_buffer.empty()) {
+      sparse_buffer.resize(buffer.size());
+    }
+    sparse_buffer[pos].push_back(std::move(var));
   } else {
+    merge_sparse(pos);
     // ATen doesn't route sparse additions correctly...
     if (old_var.type().is_sparse()) {
       buffer[pos] = var + old_var;
@@ -25,6 +33,33 @@ void InputBuffer::add(size_t pos, Variable var) {
   }
 }
 
+void InputBuffer::merge_sparse(size_t pos) {
+  if (sparse_buffer.empty() || sparse_buffer[pos].empty()) {
+    return;
+  }
+  auto& parts = sparse_buffer[pos];
+  parts.push_back(std::move(buffer[pos]));
+  std::vector<at::Tensor> indices;
+  std::vector<at::Tensor> values;
+  for (auto& part : parts) {
+    // The indices and values of an empty sparse tensor have no dimensions
+    auto part_indices = part.data()._indices();
+    if (part_indices.dim() != 0) {
+      indices.push_back(part_indices);
+      values.push_back(part.data()._values());
+    }
+  }
+  if (indices.empty()) {
+    buffer[pos] = std::move(parts.back());
+  } else {
+    const auto& first = parts.back().data();
+    auto sum = first.type().sparse_coo_tensor(
+        at::cat(indices, 1), at::cat(values, 0), first.sizes());
+    buffer[pos] = make_variable(sum.coalesce());
+  }
+  parts.clear();
+}
+
 auto InputBuffer::device() const -> int {
   for (auto& var : buffer) {
     if (var.defined() && var.type().is_cuda()) {
@@ -35,6 +70,9 @@ auto InputBuffer::device() const -> int {
 }
 
 auto InputBuffer::variables(InputBuffer&& g) -> std::vector<Variable> {
+  for (size_t pos = 0; pos < g.sparse_buffer.size(); ++pos) {
+    g.merge_sparse(pos);
+  }
   std::vector<Variable> result = std::move(g.buffer);
   return result;
 }
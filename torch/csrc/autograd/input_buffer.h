@@ -26,13 +26,24 @@ struct InputBuffer {
 
   int device() const;
 
-  Variable operator[](std::size_t pos) { return buffer[pos]; }
+  Variable operator[](std::size_t pos) {
+    merge_sparse(pos);
+    return buffer[pos];
+  }
 
   // Returns the inputs as a list of variables. Destroys given InputBuffer.
   static std::vector<Variable> variables(InputBuffer&& buffer);
 
 private:
+  // Sums the sparse gradients held back for the given index into buffer.
+  void merge_sparse(size_t pos);
+
   std::vector<Variable> buffer;
+  // Sparse gradients (e.g. of an embedding used several times) are not
+  // added one at a time, which would concatenate the COO indices and values
+  // again for every gradient. They are kept here, and concatenated and
+  // coalesced once when the input is read.
+  std::vector<std::vector<Variable>> sparse_buffer;
 };
 
 }}  // namespace torch::autograd
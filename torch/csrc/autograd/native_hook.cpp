@@ -0,0 +1,177 @@
+#include "torch/csrc/autograd/native_hook.h"
+
+#include "torch/csrc/autograd/function.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace torch { namespace autograd {
+
+int64_t NativeHookList::add(std::shared_ptr<NativeGradHook> hook) {
+  static std::atomic<int64_t> next_id(0);
+  auto id = next_id++;
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto hooks = std::make_shared<hook_list>(*hooks_);
+  hooks->emplace_back(id, std::move(hook));
+  std::atomic_store(&hooks_, std::shared_ptr<const hook_list>(std::move(hooks)));
+  return id;
+}
+
+void NativeHookList::remove(int64_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto hooks = std::make_shared<hook_list>(*hooks_);
+  hooks->erase(
+      std::remove_if(hooks->begin(), hooks->end(),
+                     [id](const hook_list::value_type& entry) { return entry.first == id; }),
+      hooks->end());
+  std::atomic_store(&hooks_, std::shared_ptr<const hook_list>(std::move(hooks)));
+}
+
+Variable NativeHookList::operator()(Variable grad) const {
+  auto hooks = std::atomic_load(&hooks_);
+  for (const auto& entry : *hooks) {
+    auto new_grad = entry.second->fn(grad);
+    if (new_grad.defined()) {
+      grad = std::move(new_grad);
+    }
+  }
+  return grad;
+}
+
+variable_list NativeFunctionPreHook::operator()(const variable_list& values) {
+  if (!values.at(value_idx).defined()) {
+    return values;
+  }
+  variable_list results(values);
+  results[value_idx] = (*hooks)(values[value_idx]);
+  return results;
+}
+
+void NativeHookHandle::remove() {
+  if (auto list = hooks.lock()) {
+    list->remove(id);
+  }
+}
+
+NativeHookHandle add_native_hook(Variable& var, std::shared_ptr<NativeGradHook> hook) {
+  if (!var.requires_grad()) {
+    throw std::runtime_error("cannot register a hook on a tensor that doesn't require gradient");
+  }
+  std::shared_ptr<NativeHookList> list;
+  if (const auto& grad_fn = var.grad_fn()) {
+    auto& pre_hooks = grad_fn->pre_hooks();
+    for (const auto& pre_hook : pre_hooks) {
+      auto native = dynamic_cast<NativeFunctionPreHook*>(pre_hook.get());
+      if (native && native->value_idx == static_cast<int>(var.output_nr())) {
+        list = native->hooks;
+        break;
+      }
+    }
+    if (!list) {
+      list = std::make_shared<NativeHookList>();
+      pre_hooks.insert(
+          pre_hooks.begin(),
+          std::unique_ptr<FunctionPreHook>(new NativeFunctionPreHook(list, var.output_nr())));
+    }
+  } else {
+    // AccumulateGrad runs the hooks of the Variable itself
+    for (const auto& var_hook : var.hooks()) {
+      if (auto native = dynamic_cast<NativeFunctionPreHook*>(var_hook.get())) {
+        list = native->hooks;
+        break;
+      }
+    }
+    if (!list) {
+      list = std::make_shared<NativeHookList>();
+      auto var_hooks = var.hooks();
+      var.clear_hooks();
+      var.add_hook(std::make_shared<NativeFunctionPreHook>(list, 0));
+      for (auto& var_hook : var_hooks) {
+        var.add_hook(std::move(var_hook));
+      }
+    }
+  }
+  NativeHookHandle handle;
+  handle.hooks = list;
+  handle.id = list->add(std::move(hook));
+  return handle;
+}
+
+std::shared_ptr<NativeGradHook> clamp_grad_hook(double min, double max) {
+  if (min > max) {
+    throw std::runtime_error("clamp_grad_hook: min must not be greater than max");
+  }
+  std::ostringstream name;
+  name << "clamp(min=" << min << ", max=" << max << ")";
+  return std::make_shared<NativeGradHook>(name.str(), [min, max](const Variable& grad) -> Variable {
+    return grad.clamp(min, max);
+  });
+}
+
+std::shared_ptr<NativeGradHook> scale_grad_hook(double factor) {
+  std::ostringstream name;
+  name << "scale(" << factor << ")";
+  return std::make_shared<NativeGradHook>(name.str(), [factor](const Variable& grad) -> Variable {
+    return grad * factor;
+  });
+}
+
+std::shared_ptr<NativeGradHook> clip_grad_norm_hook(double max_norm, double norm_type) {
+  if (max_norm < 0) {
+    throw std::runtime_error("clip_grad_norm_hook: max_norm must be non-negative");
+  }
+  std::ostringstream name;
+  name << "clip_norm(max_norm=" << max_norm << ", norm_type=" << norm_type << ")";
+  return std::make_shared<NativeGradHook>(name.str(), [max_norm, norm_type](const Variable& grad) -> Variable {
+    double norm = std::isinf(norm_type)
+        ? grad.abs().max().toCDouble()
+        : grad.norm(norm_type).toCDouble();
+    double clip_coef = max_norm / (norm + 1e-6);
+    if (clip_coef >= 1) {
+      return Variable();
+    }
+    return grad * clip_coef;
+  });
+}
+
+std::shared_ptr<NativeGradHook> GradBucket::hook(size_t index) {
+  if (index >= grads_.size()) {
+    std::ostringstream msg;
+    msg << "GradBucket: index " << index << " out of range for a bucket of size " << grads_.size();
+    throw std::out_of_range(msg.str());
+  }
+  std::weak_ptr<GradBucket> weak_self = shared_from_this();
+  std::ostringstream name;
+  name << "bucket[" << index << "]";
+  return std::make_shared<NativeGradHook>(name.str(), [weak_self, index](const Variable& grad) -> Variable {
+    if (auto self = weak_self.lock()) {
+      self->put(index, grad);
+    }
+    return Variable();
+  });
+}
+
+void GradBucket::put(size_t index, const Variable& grad) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!grads_[index].defined()) {
+    ++num_ready_;
+  }
+  grads_[index] = grad;
+  if (num_ready_ == grads_.size()) {
+    ready_.notify_all();
+  }
+}
+
+variable_list GradBucket::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  ready_.wait(lock, [this] { return num_ready_ == grads_.size(); });
+  variable_list grads(grads_.size());
+  grads.swap(grads_);
+  num_ready_ = 0;
+  return grads;
+}
+
+}} // namespace torch::autograd
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "torch/csrc/autograd/function_hook.h"
+#include "torch/csrc/autograd/variable.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace torch { namespace autograd {
+
+// A hook on the gradient of a Variable that is implemented in C++. Unlike
+// Python hooks, the engine runs it without taking the GIL, so that it doesn't
+// serialize the backward passes of the threads of a process. It returns the
+// new gradient, or an undefined Variable to leave the gradient unchanged.
+//
+// C++ extensions can create their own and hand them to Python, where
+// Tensor.register_hook accepts them like Python hooks.
+struct NativeGradHook {
+  using hook_fn = std::function<Variable(const Variable& grad)>;
+
+  NativeGradHook(std::string name, hook_fn fn)
+    : name(std::move(name)), fn(std::move(fn)) {}
+
+  std::string name;
+  hook_fn fn;
+};
+
+// The native hooks of the gradient of one Variable, in the order they were
+// added. Hooks can be added and removed while the engine runs them from other
+// threads: every change replaces the list instead of modifying it.
+struct NativeHookList {
+  NativeHookList() : hooks_(std::make_shared<hook_list>()) {}
+
+  // Returns the id to remove the hook with
+  int64_t add(std::shared_ptr<NativeGradHook> hook);
+  void remove(int64_t id);
+
+  Variable operator()(Variable grad) const;
+
+private:
+  using hook_list = std::vector<std::pair<int64_t, std::shared_ptr<NativeGradHook>>>;
+
+  // read with std::atomic_load, replaced under mutex_
+  std::shared_ptr<const hook_list> hooks_;
+  std::mutex mutex_;
+};
+
+struct NativeFunctionPreHook : public FunctionPreHook {
+  NativeFunctionPreHook(std::shared_ptr<NativeHookList> hooks, int value_idx)
+    : hooks(std::move(hooks)), value_idx(value_idx) {}
+
+  variable_list operator()(const variable_list& values) override;
+
+  std::shared_ptr<NativeHookList> hooks;
+  int value_idx;
+};
+
+struct NativeHookHandle {
+  // Does nothing if the hook or the Variable is gone
+  void remove();
+
+  std::weak_ptr<NativeHookList> hooks;
+  int64_t id;
+};
+
+// Adds `hook` to the native hooks of the gradient of `var`. They run before
+// the Python hooks of `var`, in the order they were added.
+NativeHookHandle add_native_hook(Variable& var, std::shared_ptr<NativeGradHook> hook);
+
+// Built-in native hooks
+std::shared_ptr<NativeGradHook> clamp_grad_hook(double min, double max);
+std::shared_ptr<NativeGradHook> scale_grad_hook(double factor);
+// Scales the gradient down to a norm of at most `max_norm`
+std::shared_ptr<NativeGradHook> clip_grad_norm_hook(double max_norm, double norm_type);
+
+// Collects the gradients of a group of Variables from native hooks, so that a
+// thread can reduce them together (e.g. with one allreduce per bucket) as soon
+// as the last one is computed, while the backward pass goes on.
+struct GradBucket : public std::enable_shared_from_this<GradBucket> {
+  explicit GradBucket(size_t size) : grads_(size) {}
+
+  size_t size() const {
+    return grads_.size();
+  }
+
+  // A hook that puts the gradient of the `index`-th Variable of the bucket
+  std::shared_ptr<NativeGradHook> hook(size_t index);
+
+  // Blocks until the gradients of all the Variables of the bucket are in,
+  // then returns them and empties the bucket
+  variable_list wait();
+
+private:
+  void put(size_t index, const Variable& grad);
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  variable_list grads_;
+  size_t num_ready_ = 0;
+};
+
+}} // namespace torch::autograd
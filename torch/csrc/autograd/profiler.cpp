@@ -1,19 +1,51 @@
 #include "torch/csrc/autograd/profiler.h"
 #include "torch/csrc/autograd/function.h"
 
+#ifdef WITH_CUDA
+#include <THC/THCCachingAllocator.h>
+#endif
+
 namespace torch { namespace autograd { namespace profiler {
 
 ProfilerState state = ProfilerState::Disabled;
+bool record_shapes = false;
+bool profile_memory = false;
+uint64_t sample_period = 1;
+std::size_t max_events = 0;
 uint32_t next_thread_id = 0;
 std::mutex all_event_lists_mutex;
 std::list<std::shared_ptr<RangeEventList>> all_event_lists;
 thread_local std::shared_ptr<RangeEventList> event_list;
 thread_local int32_t thread_id;
+thread_local int32_t function_depth = 0;
+thread_local bool sampled_out = false;
+thread_local uint64_t num_top_level_functions = 0;
+
+// The marks used to align the clocks when parsing the trace. They are kept
+// apart from the per-thread lists, which may drop their oldest events.
+static RangeEventList start_marks;
 
 void RecordFunction::pushFunctionRange(Function* fn) {
   pushRange(fn->name());
 }
 
+int64_t cudaMemoryAllocated() {
+#ifdef WITH_CUDA
+  int device;
+  TORCH_CUDA_CHECK(cudaGetDevice(&device));
+  return THCCachingAllocator_currentMemoryAllocated(device);
+#else
+  return 0;
+#endif
+}
+
+static void startMark(std::string name, bool include_cuda = true) {
+  if (state == ProfilerState::NVTX) {
+    return mark(std::move(name), include_cuda);
+  }
+  start_marks.record(EventKind::Mark, std::move(name), thread_id, include_cuda && state == ProfilerState::CUDA);
+}
+
 #ifdef WITH_CUDA
 static void onEachDevice(std::function<void(int)> op) {
   AutoGPU gpu_guard;
@@ -26,7 +58,8 @@ static void onEachDevice(std::function<void(int)> op) {
 }
 #endif
 
-void enableProfiler(ProfilerState new_state) {
+void enableProfiler(ProfilerState new_state, bool new_record_shapes, bool new_profile_memory,
+                    uint64_t new_sample_period, std::size_t new_max_events) {
   TORCH_ASSERT(new_state != ProfilerState::Disabled);
 #ifndef WITH_CUDA
   if (new_state == ProfilerState::NVTX)
@@ -35,7 +68,20 @@ void enableProfiler(ProfilerState new_state) {
   if (state != ProfilerState::Disabled && new_state != state) {
       throw std::runtime_error("can't change kind of profiling (e.g. NVTX to CPU) while profiler is running");
   }
+  if (new_sample_period == 0) {
+    throw std::runtime_error("sample_period must be positive");
+  }
   state = new_state;
+  record_shapes = new_record_shapes;
+  profile_memory = new_profile_memory;
+  sample_period = new_sample_period;
+  max_events = new_max_events;
+  {
+    std::lock_guard<std::mutex> guard(all_event_lists_mutex);
+    for (auto& list : all_event_lists) {
+      list->setMaxEvents(max_events);
+    }
+  }
 
 #ifdef WITH_CUDA
   if(state == ProfilerState::CUDA) {
@@ -43,7 +89,7 @@ void enableProfiler(ProfilerState new_state) {
     // to generate some dummy events first before recording syncrhonization events
     for(int i = 0; i < 5; i++) {
       onEachDevice([](int d) {
-          mark("__cuda_startup");
+          startMark("__cuda_startup");
           cudaDeviceSynchronize();
       });
     }
@@ -52,11 +98,11 @@ void enableProfiler(ProfilerState new_state) {
     // for each gpu. we then use this event to synchronize time on the GPU
     // with the CPU clock.
     onEachDevice([](int d) {
-        mark("__cuda_start_event");
+        startMark("__cuda_start_event");
     });
   }
 #endif
-  mark("__start_profile", false);
+  startMark("__start_profile", false);
 }
 
 thread_event_lists disableProfiler() {
@@ -71,6 +117,7 @@ thread_event_lists disableProfiler() {
   } else {
     thread_event_lists result;
     std::lock_guard<std::mutex> guard(all_event_lists_mutex);
+    result.emplace_back(start_marks.consolidate());
     for (auto it = all_event_lists.begin(); it != all_event_lists.end();) {
       auto & list = *it;
       result.emplace_back(list->consolidate());
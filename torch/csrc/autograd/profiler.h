@@ -3,6 +3,7 @@
 #ifdef WITH_CUDA
 #include <nvToolsExt.h>
 #endif
+#include <algorithm>
 #include <thread>
 #include <iostream>
 #include <mutex>
@@ -12,7 +13,7 @@
 #include <string>
 #include <list>
 #include <sstream>
-#include <forward_list>
+#include <deque>
 #include <tuple>
 #include "ATen/ATen.h"
 #include "torch/csrc/cuda/cuda_check.h"
@@ -42,6 +43,9 @@ enum class EventKind {
   PopRange
 };
 
+// Bytes currently allocated by the caching allocator on the current device
+int64_t cudaMemoryAllocated();
+
 struct Event {
   Event(EventKind kind, std::string name, uint32_t thread_id, bool record_cuda)
   : kind_(kind)
@@ -105,6 +109,20 @@ struct Event {
   int device() const {
     return device_;
   }
+  // sizes of the Tensor inputs of the op, if shapes are recorded
+  const std::vector<std::vector<int64_t>>& shapes() const {
+    return shapes_;
+  }
+  void set_shapes(std::vector<std::vector<int64_t>> shapes) {
+    shapes_ = std::move(shapes);
+  }
+  // CUDA memory allocated when the event was recorded, or -1 if not recorded
+  int64_t cuda_memory() const {
+    return cuda_memory_;
+  }
+  void set_cuda_memory(int64_t bytes) {
+    cuda_memory_ = bytes;
+  }
 private:
   EventKind kind_;
   std::string name_;
@@ -114,11 +132,17 @@ private:
   cudaEvent_t event = nullptr;
 #endif
   int device_ = -1;
+  int64_t cuda_memory_ = -1;
+  std::vector<std::vector<int64_t>> shapes_;
 };
 
-// a linked-list of fixed sized vectors, to avoid
+// a list of fixed sized vectors, to avoid
 // a std::vector resize from taking a large amount of time inside
 // a profiling  event
+//
+// If max_events is set, the list is a ring buffer of blocks: once it is full,
+// the oldest block is dropped to make room, so it keeps the last max_events
+// events (and up to one block more).
 struct RangeEventList {
   constexpr static std::size_t MB = 1024 * 1024;
   constexpr static std::size_t event_block_size = 16 * MB;
@@ -126,25 +150,41 @@ struct RangeEventList {
     event_block_size / ceilToMultiple(sizeof(Event), alignof(Event));
   static_assert(sizeof(Event[num_block_elements]) <= event_block_size,
                 "num_block_elements is calculated incorrectly");
+  constexpr static std::size_t num_ring_blocks = 8;
   using block_type = std::vector<Event>;
 
+  void setMaxEvents(std::size_t max_events) {
+    if (max_events == 0) {
+      block_size = num_block_elements;
+      max_blocks = 0;
+    } else {
+      block_size = std::max<std::size_t>(
+          std::min(num_block_elements, max_events / num_ring_blocks), 1);
+      max_blocks = (max_events + block_size - 1) / block_size + 1;
+    }
+  }
+
   void allocBlock() {
-    blocks.emplace_front();
-    blocks.front().reserve(num_block_elements);
+    if (max_blocks != 0 && blocks.size() == max_blocks) {
+      blocks.pop_front();
+    }
+    blocks.emplace_back();
+    blocks.back().reserve(block_size);
   }
 
   template<typename... Args>
-  void record(Args&&... args) {
-    if (blocks.empty() || blocks.front().size() == num_block_elements) {
+  Event& record(Args&&... args) {
+    if (blocks.empty() || blocks.back().size() == block_size) {
       allocBlock();
     }
-    blocks.front().emplace_back(std::forward<Args>(args)...);
+    blocks.back().emplace_back(std::forward<Args>(args)...);
+    return blocks.back().back();
   }
 
   std::vector<Event> consolidate() {
     std::vector<Event> result;
     for (auto & block : blocks) {
-      result.insert(result.begin(),
+      result.insert(result.end(),
                     std::make_move_iterator(block.begin()),
                     std::make_move_iterator(block.end()));
     }
@@ -152,7 +192,9 @@ struct RangeEventList {
     return result;
   }
 
-  std::forward_list<block_type> blocks;
+  std::deque<block_type> blocks;
+  std::size_t block_size = num_block_elements;
+  std::size_t max_blocks = 0;
 };
 
 enum class ProfilerState {
@@ -163,17 +205,25 @@ enum class ProfilerState {
 };
 
 extern ProfilerState state;
+extern bool record_shapes;
+extern bool profile_memory;
+extern uint64_t sample_period;
+extern std::size_t max_events;
 extern uint32_t next_thread_id;
 extern std::mutex all_event_lists_mutex;
 extern std::list<std::shared_ptr<RangeEventList>> all_event_lists;
 
 extern thread_local std::shared_ptr<RangeEventList> event_list;
 extern thread_local int32_t thread_id;
+extern thread_local int32_t function_depth;
+extern thread_local bool sampled_out;
+extern thread_local uint64_t num_top_level_functions;
 
 inline RangeEventList& getEventList() {
   if (!event_list) {
     std::lock_guard<std::mutex> guard(all_event_lists_mutex);
     event_list = std::make_shared<RangeEventList>();
+    event_list->setMaxEvents(max_events);
     thread_id = next_thread_id++;
     all_event_lists.emplace_front(event_list);
   }
@@ -192,15 +242,20 @@ inline void mark(std::string name, bool include_cuda = true) {
   }
 }
 
-inline void pushRange(std::string name) {
+inline Event* pushRange(std::string name) {
   if (state == ProfilerState::NVTX) {
 #ifdef WITH_CUDA
     nvtxRangePushA(name.c_str());
+    return nullptr;
 #else
     throw std::logic_error("pushRange called with NVTX tracing, but compiled without CUDA");
 #endif
   } else {
-    getEventList().record(EventKind::PushRange, std::move(name), thread_id, state == ProfilerState::CUDA);
+    auto& event = getEventList().record(EventKind::PushRange, std::move(name), thread_id, state == ProfilerState::CUDA);
+    if (profile_memory) {
+      event.set_cuda_memory(cudaMemoryAllocated());
+    }
+    return &event;
   }
 }
 
@@ -212,39 +267,102 @@ inline void popRange() {
     throw std::logic_error("popRange called with NVTX tracing, but compiled without CUDA");
 #endif
   } else {
-    getEventList().record(EventKind::PopRange, std::string(), thread_id, state == ProfilerState::CUDA);
+    auto& event = getEventList().record(EventKind::PopRange, std::string(), thread_id, state == ProfilerState::CUDA);
+    if (profile_memory) {
+      event.set_cuda_memory(cudaMemoryAllocated());
+    }
+  }
+}
+
+namespace detail {
+inline void collectShapes(std::vector<std::vector<int64_t>>& shapes) {}
+
+template<typename... Args>
+void collectShapes(std::vector<std::vector<int64_t>>& shapes, at::TensorList tensors, Args&&... args);
+
+template<typename... Args>
+void collectShapes(std::vector<std::vector<int64_t>>& shapes, const at::Tensor& tensor, Args&&... args) {
+  shapes.push_back(tensor.defined() ? tensor.sizes().vec() : std::vector<int64_t>());
+  collectShapes(shapes, std::forward<Args>(args)...);
+}
+
+template<typename... Args>
+void collectShapes(std::vector<std::vector<int64_t>>& shapes, at::TensorList tensors, Args&&... args) {
+  for (auto& tensor : tensors) {
+    shapes.push_back(tensor.defined() ? tensor.sizes().vec() : std::vector<int64_t>());
   }
+  collectShapes(shapes, std::forward<Args>(args)...);
 }
+} // namespace detail
 
+// Records a range for the duration of a function. Only one in sample_period
+// top-level functions of a thread is recorded, together with the functions
+// it calls; the others are skipped entirely.
 struct RecordFunction {
   explicit RecordFunction(Function *fn) {
-    if (state == ProfilerState::Disabled) return;
+    if (!enter()) return;
     pushFunctionRange(fn);
   }
 
   explicit RecordFunction(std::string name) {
-    if (state == ProfilerState::Disabled) return;
+    if (!enter()) return;
     pushRange(std::move(name));
   }
 
   explicit RecordFunction(const char *name) {
-    if (state == ProfilerState::Disabled) return;
+    if (!enter()) return;
     pushRange(name);
   }
 
+  // Also records the sizes of the given Tensor and TensorList inputs, if
+  // shapes are recorded
+  template<typename... Args>
+  RecordFunction(const char *name, Args&&... inputs) {
+    if (!enter()) return;
+    auto event = pushRange(name);
+    if (event && record_shapes) {
+      std::vector<std::vector<int64_t>> shapes;
+      detail::collectShapes(shapes, std::forward<Args>(inputs)...);
+      event->set_shapes(std::move(shapes));
+    }
+  }
+
   ~RecordFunction() {
-    if (state == ProfilerState::Disabled) return;
+    if (!entered_) return;
+    function_depth--;
+    if (!recorded_ || state == ProfilerState::Disabled) return;
     popRange();
   }
 
   // Needed only because we don't have Function defined yet.
   void pushFunctionRange(Function *fn);
+
+private:
+  bool enter() {
+    if (state == ProfilerState::Disabled) return false;
+    entered_ = true;
+    if (function_depth++ == 0) {
+      sampled_out = sample_period > 1 && num_top_level_functions++ % sample_period != 0;
+    }
+    recorded_ = !sampled_out;
+    return recorded_;
+  }
+
+  bool entered_ = false;
+  bool recorded_ = false;
 };
 
 using thread_event_lists = std::vector<std::vector<Event>>;
 // NOTE: changing profiler modes is **NOT THREAD SAFE**. You should ensure that
 // there no autograd functions are being executed when these function are used.
-void enableProfiler(ProfilerState state);
+//
+// record_shapes records the input sizes of ATen ops and profile_memory the
+// CUDA memory allocated at the start and end of each range. sample_period
+// records one in every sample_period top-level functions of each thread, and
+// max_events (if nonzero) bounds the number of events kept per thread, in which
+// case only the most recent ones are kept.
+void enableProfiler(ProfilerState state, bool record_shapes=false, bool profile_memory=false,
+                    uint64_t sample_period=1, std::size_t max_events=0);
 thread_event_lists disableProfiler();
 
 } // namespace profiler
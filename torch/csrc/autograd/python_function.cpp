@@ -102,7 +102,11 @@ auto PyFunction::apply(const variable_list& inputs) -> variable_list {
 
   THPObjectPtr _legacy(PyObject_GetAttrString(obj, "_is_legacy"));
   if (_legacy == Py_True) {
-    return legacy_apply(inputs);
+    auto results = legacy_apply(inputs);
+    if (release_variables_in_apply) {
+      release_saved_variables();
+    }
+    return results;
   }
 
   // Massage a C++ variable_list into a Python arguments tuple
@@ -187,6 +191,9 @@ auto PyFunction::apply(const variable_list& inputs) -> variable_list {
     }
   }
 
+  if (release_variables_in_apply) {
+    release_saved_variables();
+  }
   return results;
 }
 
@@ -199,11 +206,23 @@ auto PyFunction::is_traceable() -> bool {
   return traceable_py_bool == Py_True;
 }
 
+auto PyFunction::will_release_variables() -> void {
+  release_variables_in_apply = true;
+}
+
 auto PyFunction::release_variables() -> void {
+  if (variables_released) {
+    return;
+  }
   AutoGIL gil;
+  release_saved_variables();
+}
+
+auto PyFunction::release_saved_variables() -> void {
   auto f = (THPFunction*) obj;
   f->saved_variables.clear();
   f->has_freed_buffers = 1;
+  variables_released = true;
 }
 
 auto PyFunction::name() -> std::string {
@@ -34,6 +34,7 @@ struct PyFunction : public Function {
   virtual variable_list apply(const variable_list& inputs) override;
   variable_list legacy_apply(const variable_list& inputs);
 
+  virtual void will_release_variables() override;
   virtual void release_variables() override;
   virtual std::string name() override;
   virtual std::shared_ptr<Function> get_shared_ptr() override;
@@ -41,6 +42,15 @@ struct PyFunction : public Function {
 
   // THPFunction this Function is wrapping.
   PyObject* obj;
+
+private:
+  // Requires the GIL
+  void release_saved_variables();
+
+  // The saved variables are released at the end of apply, which holds the
+  // GIL anyway, instead of by release_variables, which would take it again.
+  bool release_variables_in_apply = false;
+  bool variables_released = false;
 };
 
 /**
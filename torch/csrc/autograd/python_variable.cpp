@@ -329,7 +329,14 @@ int THPVariable_set_backwards_hooks(THPVariable *self, PyObject *obj)
   Py_XINCREF(obj);
   Py_XDECREF(self->backward_hooks);
   self->backward_hooks = obj;
+  // Only the Python hooks are replaced, native hooks stay ahead of them
+  auto hooks = self->cdata.hooks();
   self->cdata.clear_hooks();
+  for (auto& hook : hooks) {
+    if (!dynamic_cast<PyFunctionPreHook*>(hook.get())) {
+      self->cdata.add_hook(std::move(hook));
+    }
+  }
   if (obj) {
     self->cdata.add_hook(std::make_shared<PyFunctionPreHook>(obj, 0));
   }
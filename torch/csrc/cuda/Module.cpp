@@ -8,6 +8,8 @@
 #include <TH/TH.h>
 #include <ATen/ATen.h>
 #include <THC/THCCachingAllocator.h>
+#include <THC/THCCachingHostAllocator.h>
+#include <ATen/cuda/CUFFTPlanCache.h>
 #ifdef WITH_NCCL
 #include <nccl.h>
 #endif
@@ -74,6 +76,54 @@ PyObject * THCPModule_getCurrentStream_wrap(PyObject *self)
   END_HANDLE_TH_ERRORS
 }
 
+// Makes the work queued on the cudaStream_t waiting from now on wait for the
+// work queued so far on the cudaStream_t stream, without blocking the host.
+// Both streams belong to the current device; they may come from another
+// library, e.g. when handing a tensor over through DLPack.
+PyObject * THCPModule_streamWaitStream(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  unsigned long long waiting, stream;
+  if (!PyArg_ParseTuple(args, "KK:_cuda_streamWaitStream", &waiting, &stream)) {
+    return NULL;
+  }
+  cudaEvent_t event;
+  THCudaCheck(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+  THCudaCheck(cudaEventRecord(event, (cudaStream_t)(uintptr_t)stream));
+  THCudaCheck(cudaStreamWaitEvent((cudaStream_t)(uintptr_t)waiting, event, 0));
+  THCudaCheck(cudaEventDestroy(event));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_getCopyStream_wrap(PyObject *self, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "invalid argument to _cuda_getCopyStream");
+  int device = (int) THPUtils_unpackLong(arg);
+  THCStream* stream = THCState_getCopyStream(state, device);
+  return PyLong_FromVoidPtr(stream);
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_getPoolStream_wrap(PyObject *self, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  int device, high_priority;
+  if (!PyArg_ParseTuple(args, "ii:_cuda_getPoolStream", &device, &high_priority)) {
+    return NULL;
+  }
+  if (device < 0 || device >= THCState_getNumDevices(state)) {
+    THPUtils_setError("%d is not a device", device);
+    return NULL;
+  }
+  THCStream* stream = THCStream_getPoolStream(device, high_priority);
+  // the pool keeps its streams alive
+  THCStream_free(stream);
+  return PyLong_FromVoidPtr(stream);
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject * THCPModule_setStream_wrap(PyObject *self, PyObject *obj)
 {
   HANDLE_TH_ERRORS
@@ -238,6 +288,24 @@ PyObject * THCPModule_cudaUnlockMutex(PyObject *module)
   Py_RETURN_NONE;
 }
 
+PyObject * THCPModule_getDeterministic(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  if (THCState_getDeterministic(state)) Py_RETURN_TRUE;
+  else Py_RETURN_FALSE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_setDeterministic(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyBool_Check(arg), "set_deterministic expects a bool, "
+          "but got %s", THPUtils_typename(arg));
+  THCState_setDeterministic(state, arg == Py_True);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject * THCPModule_emptyCache(PyObject *_unused)
 {
   HANDLE_TH_ERRORS
@@ -287,6 +355,73 @@ PyObject * THCPModule_maxMemoryCached(PyObject *_unused, PyObject *arg)
   END_HANDLE_TH_ERRORS
 }
 
+PyObject * THCPModule_memoryFragmentation(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "invalid argument to memory_fragmentation");
+  int device = (int) THPUtils_unpackLong(arg);
+  THCCachingAllocatorFragmentation info;
+  THCCachingAllocator_fragmentationInfo(device, &info);
+  py::dict result;
+  result["segments"] = info.num_segments;
+  result["free_blocks"] = info.num_free_blocks;
+  result["largest_free_block"] = info.largest_free_block;
+  result["inactive_split_bytes"] = info.inactive_split_bytes;
+  return result.release().ptr();
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_hostMemoryStats(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  THCCachingHostAllocatorStats stats;
+  THCCachingHostAllocator_getStats(&stats);
+  py::dict result;
+  result["hits"] = stats.hits;
+  result["misses"] = stats.misses;
+  result["bytes_pinned"] = stats.bytes_pinned;
+  result["bytes_allocated"] = stats.bytes_allocated;
+  result["arena_bytes"] = stats.arena_bytes;
+  return result.release().ptr();
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_cufftPlanCacheInfo(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "invalid argument to cufft_plan_cache_info");
+  int64_t device = THPUtils_unpackLong(arg);
+  auto info = at::cuda::cufft_plan_cache_info(device);
+  py::dict result;
+  result["size"] = info.size;
+  result["max_size"] = info.max_size;
+  result["hits"] = info.hits;
+  result["misses"] = info.misses;
+  return result.release().ptr();
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_cufftSetPlanCacheMaxSize(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  long long device, max_size;
+  if (!PyArg_ParseTuple(args, "LL:_cuda_cufftSetPlanCacheMaxSize", &device, &max_size)) {
+    return NULL;
+  }
+  at::cuda::cufft_set_plan_cache_max_size(device, max_size);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_cufftClearPlanCache(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "invalid argument to clear_cufft_plan_cache");
+  at::cuda::cufft_clear_plan_cache(THPUtils_unpackLong(arg));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Cuda module initialization
 ////////////////////////////////////////////////////////////////////////////////
@@ -390,6 +525,9 @@ static struct PyMethodDef _THCPModule_methods[] = {
   {"_cuda_getDevice",   (PyCFunction)THCPModule_getDevice_wrap,   METH_NOARGS,  NULL},
   {"_cuda_getDeviceCount", (PyCFunction)THCPModule_getDeviceCount_wrap, METH_NOARGS, NULL},
   {"_cuda_getCurrentStream", (PyCFunction)THCPModule_getCurrentStream_wrap, METH_NOARGS, NULL},
+  {"_cuda_getCopyStream", (PyCFunction)THCPModule_getCopyStream_wrap, METH_O, NULL},
+  {"_cuda_getPoolStream", (PyCFunction)THCPModule_getPoolStream_wrap, METH_VARARGS, NULL},
+  {"_cuda_streamWaitStream", (PyCFunction)THCPModule_streamWaitStream, METH_VARARGS, NULL},
   {"_cuda_getCurrentBlasHandle", (PyCFunction)THCPModule_getCurrentBlasHandle_wrap, METH_NOARGS, NULL},
   {"_cuda_setStream",    (PyCFunction)THCPModule_setStream_wrap,  METH_O, NULL},
   {"_cuda_isDriverSufficient", (PyCFunction)THCPModule_isDriverSufficient, METH_NOARGS, NULL},
@@ -397,11 +535,18 @@ static struct PyMethodDef _THCPModule_methods[] = {
   {"_cuda_getCompiledVersion", (PyCFunction)THCPModule_getCompiledVersion, METH_NOARGS, NULL},
   {"_cuda_getRNGState", (PyCFunction)THCPModule_getRNGState,      METH_NOARGS,  NULL},
   {"_cuda_setRNGState", (PyCFunction)THCPModule_setRNGState,      METH_O,       NULL},
+  {"_cuda_getDeterministic", (PyCFunction)THCPModule_getDeterministic, METH_NOARGS, NULL},
+  {"_cuda_setDeterministic", (PyCFunction)THCPModule_setDeterministic, METH_O, NULL},
   {"_cuda_emptyCache", (PyCFunction) THCPModule_emptyCache,       METH_NOARGS,  NULL},
   {"_cuda_memoryAllocated", (PyCFunction) THCPModule_memoryAllocated, METH_O,  NULL},
   {"_cuda_maxMemoryAllocated", (PyCFunction) THCPModule_maxMemoryAllocated, METH_O,  NULL},
   {"_cuda_memoryCached", (PyCFunction) THCPModule_memoryCached, METH_O,  NULL},
   {"_cuda_maxMemoryCached", (PyCFunction) THCPModule_maxMemoryCached, METH_O,  NULL},
+  {"_cuda_memoryFragmentation", (PyCFunction) THCPModule_memoryFragmentation, METH_O,  NULL},
+  {"_cuda_hostMemoryStats", (PyCFunction) THCPModule_hostMemoryStats, METH_NOARGS,  NULL},
+  {"_cuda_cufftPlanCacheInfo", (PyCFunction) THCPModule_cufftPlanCacheInfo, METH_O,  NULL},
+  {"_cuda_cufftSetPlanCacheMaxSize", (PyCFunction) THCPModule_cufftSetPlanCacheMaxSize, METH_VARARGS,  NULL},
+  {"_cuda_cufftClearPlanCache", (PyCFunction) THCPModule_cufftClearPlanCache, METH_O,  NULL},
   {"_cuda_manualSeed",  (PyCFunction)THCPModule_manualSeed,       METH_O,       NULL},
   {"_cuda_manualSeedAll", (PyCFunction)THCPModule_manualSeedAll,  METH_O,       NULL},
   {"_cuda_seed",        (PyCFunction)THCPModule_seed,             METH_NOARGS,  NULL},
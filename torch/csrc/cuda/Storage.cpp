@@ -10,6 +10,7 @@
 #include "torch/csrc/allocators.h"
 #include "torch/csrc/copy_utils.h"
 #include "DynamicTypes.h"
+#include "torch/csrc/utils/auto_gil.h"
 
 #define THC_GENERIC_FILE "torch/csrc/generic/Storage.cpp"
 #include <THC/THCGenerateAllTypes.h>
@@ -6,6 +6,7 @@
 
 #include "torch/csrc/utils/python_strings.h"
 #include "THDP.h"
+#include "Reducer.h"
 #include "torch/csrc/PythonTypes.h"
 #include "torch/csrc/autograd/python_variable.h"
 
@@ -610,6 +611,51 @@ PyObject* THDPModule_allReduce(PyObject *_unused, PyObject *args)
   END_HANDLE_TH_ERRORS
 }
 
+static void _freeReducer(void *reducer)
+{
+  delete static_cast<torch::distributed::Reducer*>(reducer);
+}
+
+PyObject* THDPModule_newReducer(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  std::vector<torch::autograd::Variable> params;
+  std::size_t length;
+  std::size_t bucket_bytes;
+  THPObjectPtr sequence;
+
+  if (PyTuple_GET_SIZE(args) != 2 || !PySequence_Check(PyTuple_GET_ITEM(args, 0)) ||
+        !THPUtils_checkLong(PyTuple_GET_ITEM(args, 1))) {
+    goto invalid_arguments;
+  }
+
+  sequence = THPObjectPtr(PySequence_Fast(PyTuple_GET_ITEM(args, 0),
+                                          "expected a sequence"));
+  if (!sequence.get()) {
+    goto invalid_arguments;
+  }
+
+  length = static_cast<std::size_t>(PySequence_Fast_GET_SIZE(sequence.get()));
+  params.reserve(length);
+  for (std::size_t i = 0; i < length; ++i) {
+    PyObject* param = PySequence_Fast_GET_ITEM(sequence.get(), i);
+    if (!THPVariable_Check(param)) {
+      goto invalid_arguments;
+    }
+    params.push_back(((THPVariable*)param)->cdata);
+  }
+  bucket_bytes = THPUtils_unpackLong(PyTuple_GET_ITEM(args, 1));
+
+  return THPWrapper_New(new torch::distributed::Reducer(std::move(params), bucket_bytes),
+                        _freeReducer);
+
+invalid_arguments:
+  THPUtils_invalidArguments(args, NULL, "new_reducer", 1,
+      "(list[tensor] params, int bucket_bytes)");
+  return NULL;
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject* THDPModule_reduce(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
@@ -993,6 +1039,7 @@ static struct PyMethodDef _THDPModule_methods[] = {
   {"_dist_recv", (PyCFunction)THDPModule_recv, METH_VARARGS, NULL},
   {"_dist_all_reduce", (PyCFunction)THDPModule_allReduce, METH_VARARGS, NULL},
   {"_dist_all_reduce_multigpu", (PyCFunction)THDPModule_allReduceMultiGPU, METH_VARARGS, NULL},
+  {"_dist_new_reducer", (PyCFunction)THDPModule_newReducer, METH_VARARGS, NULL},
   {"_dist_reduce", (PyCFunction)THDPModule_reduce, METH_VARARGS, NULL},
   {"_dist_reduce_multigpu", (PyCFunction)THDPModule_reduceMultiGPU, METH_VARARGS, NULL},
   {"_dist_broadcast", (PyCFunction)THDPModule_broadcast, METH_VARARGS, NULL},
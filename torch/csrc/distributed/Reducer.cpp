@@ -0,0 +1,148 @@
+#include "Reducer.h"
+
+#include "torch/csrc/autograd/engine.h"
+#include "torch/csrc/autograd/function_hook.h"
+#include "torch/csrc/utils/tensor_flatten.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace torch { namespace distributed {
+
+using namespace torch::autograd;
+
+struct Reducer::Hook : public FunctionPostHook {
+  Hook(Reducer* reducer, std::size_t param)
+    : reducer(reducer), param(param) {}
+
+  virtual variable_list operator()(const variable_list& grad_input, const variable_list& grad_output) override {
+    reducer->mark_ready(param);
+    return grad_input;
+  }
+
+  Reducer* reducer;
+  std::size_t param;
+};
+
+Reducer::Reducer(std::vector<Variable> params, std::size_t bucket_bytes)
+  : params_(std::move(params))
+  , param_bucket_(params_.size())
+  , param_ready_(params_.size(), false)
+  , next_bucket_(0)
+  , finalize_queued_(false) {
+  std::vector<at::Tensor> data;
+  std::unordered_map<void*, std::size_t> param_index;
+  for (std::size_t i = params_.size(); i-- > 0;) {
+    auto& param = params_[i];
+    if (!param.is_leaf() || !param.requires_grad()) {
+      throw std::runtime_error("Reducer parameters have to be leaves that require grad");
+    }
+    if (param.type().is_cuda() || param.type().is_sparse()) {
+      throw std::runtime_error("Reducer only supports dense CPU parameters");
+    }
+    data.push_back(param.data());
+    param_index.emplace(param.data().unsafeGetTH(false), i);
+  }
+
+  for (auto& group : utils::take_tensors(data, bucket_bytes)) {
+    Bucket bucket {{}, 0, {}, {}, {nullptr, THDRequest_free}};
+    for (auto& tensor : group.tensors) {
+      std::size_t i = param_index.at(tensor.unsafeGetTH(false));
+      param_bucket_[i] = buckets_.size();
+      bucket.params.push_back(i);
+    }
+    bucket.pending = bucket.params.size();
+    buckets_.push_back(std::move(bucket));
+  }
+
+  for (std::size_t i = 0; i < params_.size(); i++) {
+    auto grad_accumulator = params_[i].grad_accumulator();
+    std::unique_ptr<FunctionPostHook> hook(new Hook(this, i));
+    hooks_.push_back(hook.get());
+    grad_accumulator->add_post_hook(std::move(hook));
+    grad_accumulators_.push_back(std::move(grad_accumulator));
+  }
+}
+
+Reducer::~Reducer() {
+  for (std::size_t i = 0; i < grad_accumulators_.size(); i++) {
+    auto& hooks = grad_accumulators_[i]->post_hooks();
+    auto hook = hooks_[i];
+    hooks.erase(std::remove_if(hooks.begin(), hooks.end(),
+        [hook](const std::unique_ptr<FunctionPostHook>& h) { return h.get() == hook; }),
+        hooks.end());
+  }
+  // The all-reduces still write into the buffers
+  for (auto& bucket : buckets_) {
+    if (bucket.request) {
+      THDRequest_wait(bucket.request.get());
+    }
+  }
+}
+
+void Reducer::mark_ready(std::size_t param) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (param_ready_[param]) {
+    return;
+  }
+  param_ready_[param] = true;
+  if (!finalize_queued_) {
+    finalize_queued_ = true;
+    Engine::getDefaultEngine().queue_callback([this] { finalize(); });
+  }
+  buckets_[param_bucket_[param]].pending--;
+  launch_ready_buckets();
+}
+
+void Reducer::launch_ready_buckets() {
+  while (next_bucket_ < buckets_.size() && buckets_[next_bucket_].pending == 0) {
+    launch(buckets_[next_bucket_++]);
+  }
+}
+
+void Reducer::launch(Bucket& bucket) {
+  bucket.grads.clear();
+  for (auto i : bucket.params) {
+    bucket.grads.push_back(params_[i].grad().data());
+  }
+  bucket.flat = utils::flatten_dense_tensors(bucket.grads);
+  bucket.flat.div_(THDGetNumProcesses());
+  bucket.request.reset(THDIAllReduce(bucket.flat, THDReduceSUM, THDGroupWORLD));
+}
+
+void Reducer::finalize() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Parameters that were not used in this backward get a zero gradient, so
+  // that every process still reduces every bucket.
+  for (std::size_t i = 0; i < params_.size(); i++) {
+    if (!param_ready_[i]) {
+      auto& param = params_[i];
+      if (!param.grad().defined()) {
+        param.grad() = make_variable(at::zeros_like(param.data()));
+      }
+      buckets_[param_bucket_[i]].pending--;
+    }
+  }
+  launch_ready_buckets();
+
+  for (auto& bucket : buckets_) {
+    THDRequest_wait(bucket.request.get());
+    bucket.request.reset();
+    auto reduced = utils::unflatten_dense_tensors(bucket.flat, bucket.grads);
+    for (std::size_t i = 0; i < reduced.size(); i++) {
+      // A bucket of one contiguous gradient is reduced in place
+      if (reduced[i].data_ptr() != bucket.grads[i].data_ptr()) {
+        bucket.grads[i].copy_(reduced[i]);
+      }
+    }
+    bucket.grads.clear();
+    bucket.flat = at::Tensor();
+    bucket.pending = bucket.params.size();
+  }
+  std::fill(param_ready_.begin(), param_ready_.end(), false);
+  next_bucket_ = 0;
+  finalize_queued_ = false;
+}
+
+}} // namespace torch::distributed
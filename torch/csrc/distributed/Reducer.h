@@ -0,0 +1,57 @@
+#pragma once
+
+#include <THD/THD.h>
+
+#include "torch/csrc/autograd/function.h"
+#include "torch/csrc/autograd/variable.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace torch { namespace distributed {
+
+// Averages the gradients of a set of CPU parameters across all processes
+// during backward. The parameters are split into buckets of about
+// bucket_bytes, in reverse order since that is roughly the order in which
+// backward produces their gradients. As soon as all the gradients of a bucket
+// have been accumulated they are flattened into one buffer, and an
+// asynchronous all-reduce of that buffer is started. At the end of backward
+// the reduced buffers are copied back into the gradients.
+//
+// Buckets are reduced in order, so all processes issue the same collectives
+// in the same order no matter in which order their gradients become ready.
+struct Reducer {
+  Reducer(std::vector<autograd::Variable> params, std::size_t bucket_bytes);
+  ~Reducer();
+
+private:
+  struct Hook;
+
+  struct Bucket {
+    std::vector<std::size_t> params;
+    std::size_t pending;
+    // Gradients and flat buffer of the bucket's in-flight all-reduce.
+    std::vector<at::Tensor> grads;
+    at::Tensor flat;
+    std::unique_ptr<THDRequest, void(*)(THDRequest*)> request;
+  };
+
+  void mark_ready(std::size_t param);
+  void launch_ready_buckets();
+  void launch(Bucket& bucket);
+  void finalize();
+
+  std::vector<autograd::Variable> params_;
+  // Kept alive so that the hooks stay registered.
+  std::vector<std::shared_ptr<autograd::Function>> grad_accumulators_;
+  std::vector<autograd::FunctionPostHook*> hooks_;
+  std::vector<std::size_t> param_bucket_;
+  std::vector<bool> param_ready_;
+  std::vector<Bucket> buckets_;
+  std::size_t next_bucket_;
+  bool finalize_queued_;
+  std::mutex mutex_;
+};
+
+}} // namespace torch::distributed
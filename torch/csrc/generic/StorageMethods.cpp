@@ -185,14 +185,18 @@ static PyObject * THPStorage_(fromFile)(PyObject *_unused, PyObject *args, PyObj
   const char *filename;
   Py_ssize_t size = 0;
   int shared = 0;
-  static char *kwlist[] = {"filename", "shared", "size", NULL};
-  if (!PyArg_ParseTupleAndKeywords(args, keywds, "s|in", kwlist,
-              &filename, &shared, &size)) {
+  int readonly = 0;
+  static char *kwlist[] = {"filename", "shared", "size", "readonly", NULL};
+  if (!PyArg_ParseTupleAndKeywords(args, keywds, "s|ini", kwlist,
+              &filename, &shared, &size, &readonly)) {
     return NULL;
   }
+  int flags = 0;
   if (shared)
-    shared = TH_ALLOCATOR_MAPPED_SHARED;
-  THStorage *storage = THStorage_(newWithMapping)(LIBRARY_STATE filename, size, shared);
+    flags |= TH_ALLOCATOR_MAPPED_SHARED;
+  if (readonly)
+    flags |= TH_ALLOCATOR_MAPPED_READONLY;
+  THStorage *storage = THStorage_(newWithMapping)(LIBRARY_STATE filename, size, flags);
   return (PyObject*)THPStorage_(New)(storage);
   END_HANDLE_TH_ERRORS
 }
@@ -217,6 +221,26 @@ PyObject * THPStorage_(writeFile)(THPStorage *self, PyObject *args)
   END_HANDLE_TH_ERRORS
 }
 
+// Writes the storage like _write_file, but at the given offset of the file
+// descriptor (whose position is left unchanged) and without the GIL, so that
+// several storages can be written to the same file in parallel
+PyObject * THPStorage_(writeFileAt)(THPStorage *self, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyTuple_GET_SIZE(args) == 2 &&
+      THPUtils_checkLong(PyTuple_GET_ITEM(args, 0)) &&
+      THPUtils_checkLong(PyTuple_GET_ITEM(args, 1)),
+      "_write_file_at expects a file descriptor and an offset");
+  PositionedFile file;
+  file.fd = (int) THPUtils_unpackLong(PyTuple_GET_ITEM(args, 0));
+  file.offset = THPUtils_unpackLong(PyTuple_GET_ITEM(args, 1));
+  with_no_gil([&] {
+    THPStorage_(writeFileRaw<PositionedFile*>)(self->cdata, &file);
+  });
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject * THPStorage_(newWithFile)(PyObject *_unused, PyObject *file)
 {
   HANDLE_TH_ERRORS
@@ -323,6 +347,7 @@ static PyMethodDef THPStorage_(methods)[] = {
   {"data_ptr", (PyCFunction)THPStorage_(dataPtr), METH_NOARGS, NULL},
   {"is_pinned", (PyCFunction)THPStorage_(isPinned), METH_NOARGS, NULL},
   {"_write_file", (PyCFunction)THPStorage_(writeFile), METH_VARARGS, NULL},
+  {"_write_file_at", (PyCFunction)THPStorage_(writeFileAt), METH_VARARGS, NULL},
   {"_new_with_file", (PyCFunction)THPStorage_(newWithFile), METH_O | METH_STATIC, NULL},
   {"_set_from_file", (PyCFunction)THPStorage_(setFromFile), METH_VARARGS, NULL},
 #endif // !defined(THD_GENERIC_FILE)
@@ -61,6 +61,7 @@ void THPStorage_(writeFileRaw)(THStorage *self, io fd)
 
 template void THPStorage_(writeFileRaw<int>)(THStorage *self, int fd);
 template void THPStorage_(writeFileRaw<PyObject*>)(THStorage *self, PyObject* fd);
+template void THPStorage_(writeFileRaw<PositionedFile*>)(THStorage *self, PositionedFile* fd);
 
 template <class io>
 THStorage * THPStorage_(readFileRaw)(io file, THStorage *_storage)
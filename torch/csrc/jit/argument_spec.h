@@ -36,8 +36,10 @@ static_assert(sizeof(TensorInfoPOD) == sizeof(int64_t),
 struct TensorInfo;
 
 struct ArgumentSpec {
-  // note: tensors must always be variables
-  ArgumentSpec(bool with_grad, const variable_tensor_list & tensors)
+  // note: tensors must be variables if with_grad is true
+  // bucket_batch rounds the size of the first dimension up to a power of two,
+  // so that one spec matches a range of batch sizes
+  ArgumentSpec(bool with_grad, at::ArrayRef<at::Tensor> tensors, bool bucket_batch = false)
   :  hash_code(0), ntensors(tensors.size()) {
     int all_dims = 0;
     for(size_t i = 0; i < ntensors; i++) {
@@ -61,6 +63,8 @@ struct ArgumentSpec {
         total_dims += t.ndimension();
         auto sizes = t.sizes();
         std::copy(sizes.begin(),sizes.end(), next_dim);
+        if(bucket_batch && sizes.size() > 0)
+          *next_dim = bucketSize(*next_dim);
         next_dim += sizes.size();
         auto strides = t.strides();
         std::copy(strides.begin(), strides.end(), next_dim);
@@ -95,6 +99,13 @@ struct ArgumentSpec {
   }
 
 private:
+  // 0 and 1 are kept exact: empty and broadcasting batches behave differently
+  static int64_t bucketSize(int64_t size) {
+    int64_t bucket = 1;
+    while(bucket < size)
+      bucket *= 2;
+    return size <= 1 ? size : bucket;
+  }
   ArrayRef<TensorInfoPOD> tensor_info() const {
     return ArrayRef<TensorInfoPOD>(reinterpret_cast<const TensorInfoPOD*>(data.data()), ntensors);
   }
@@ -0,0 +1,280 @@
+#include "torch/csrc/jit/cuda_graph.h"
+
+#include "torch/csrc/jit/interned_strings.h"
+#include "torch/csrc/utils/auto_gpu.h"
+
+#include <ATen/ATen.h>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+#ifdef WITH_CUDA
+#include <THC/THC.h>
+#include <THC/THCCachingAllocator.h>
+#include <cuda_runtime.h>
+#endif
+
+namespace torch { namespace jit {
+
+// Note [CUDA graphs]
+// ~~~~~~~~~~~~~~~~~~
+// Small inference graphs on the GPU spend most of their time launching
+// kernels rather than running them. Once a shape-specialized plan has run
+// kWarmupRuns times (so that cuDNN and the fuser have picked and compiled
+// their kernels, and the caching allocator holds the memory the plan needs),
+// the next run is captured into a CUDA graph instead of being executed:
+//
+// - the inputs are cloned into static inputs, which the graph reads
+// - the code runs on the static inputs on a stream being captured, in the
+//   thread local mode, so that anything which synchronizes with the host
+//   fails the capture instead of reading results that were never computed
+// - the caching allocator keeps the memory allocated during the capture for
+//   the graph, see THCCachingAllocator_beginCapture
+//
+// Every later run copies its inputs into the static inputs, launches the
+// graph, and clones the static outputs, all on the current stream. Inputs
+// whose sizes, strides, type or device differ from the static inputs (e.g.
+// with PYTORCH_JIT_BUCKET_BATCH), and runs on another thread while one is in
+// progress, go through the interpreter instead. A plan whose capture fails
+// is never captured again.
+//
+// Kernels launched outside of the capturing thread or stream would run
+// during the capture rather than be recorded, so plans with
+// prim::ParallelBranches nodes, CPU tensors, or nodes that run Python are
+// not captured. Neither are random ops, which would replay the same numbers,
+// nor prim::MemoryArena, whose buffers go back to a pool the graph can't
+// see.
+
+namespace {
+
+constexpr int kWarmupRuns = 2;
+
+const std::unordered_set<std::string> random_ops = {
+  "bernoulli", "dropout", "feature_dropout", "multinomial", "normal",
+  "poisson", "rand", "rand_like", "randint", "randint_like", "randn",
+  "randn_like", "randperm", "rrelu", "rrelu_with_noise", "_standard_gamma",
+};
+
+// the GPU all tensors of the graph are on, or -1
+int captureDevice(const Graph& graph) {
+  int device = -1;
+  auto checkValue = [&](const Value *v) {
+    auto type = v->type()->cast<TensorType>();
+    if (!type || type->device() < 0 || (device >= 0 && type->device() != device))
+      return false;
+    device = type->device();
+    return true;
+  };
+  for (auto input : graph.inputs()) {
+    if (!checkValue(input))
+      return -1;
+  }
+  for (auto n : graph.nodes()) {
+    if (!n->blocks().empty())
+      return -1;
+    switch (n->kind()) {
+      case prim::CppOp:
+      case prim::Eval:
+      case prim::MemoryArena:
+      case prim::ParallelBranches:
+      case prim::Print:
+      case prim::PythonOp:
+        return -1;
+      default:
+        break;
+    }
+    if (n->kind().is_aten() && random_ops.count(n->kind().toUnqualString()))
+      return -1;
+    for (auto output : n->outputs()) {
+      if (!checkValue(output))
+        return -1;
+    }
+  }
+  return device;
+}
+
+} // anonymous namespace
+
+#if defined(WITH_CUDA) && CUDA_VERSION >= 10010
+
+struct CUDAGraphImpl {
+  CUDAGraphImpl(const Code& code, int device)
+  : code(code), device(device) {}
+
+  ~CUDAGraphImpl() {
+    if (!exec)
+      return;
+    AutoGPU guard(device);
+    // the last replay may still read the static tensors
+    cudaEventSynchronize(outputs_read);
+    cudaGraphExecDestroy(exec);
+    cudaEventDestroy(outputs_read);
+    static_inputs.clear();
+    static_outputs.clear();
+    THCCachingAllocator_releaseCapture(capture_id);
+    THCStream_free(capture_stream);
+  }
+
+  bool run(std::vector<at::Tensor>& stack) {
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock() || disabled)
+      return false;
+    if (exec) {
+      if (!matchesStaticInputs(stack))
+        return false;
+      replay(stack);
+      return true;
+    }
+    if (++runs <= kWarmupRuns)
+      return false;
+    if (!capture(stack)) {
+      disabled = true;
+      return false;
+    }
+    replay(stack);
+    return true;
+  }
+
+private:
+  bool matchesStaticInputs(const std::vector<at::Tensor>& stack) const {
+    if (stack.size() != static_inputs.size())
+      return false;
+    for (size_t i = 0; i < stack.size(); ++i) {
+      auto & input = stack[i];
+      auto & static_input = static_inputs[i];
+      if (!input.defined() || &input.type() != &static_input.type() ||
+          input.get_device() != device ||
+          input.sizes() != static_input.sizes() ||
+          input.strides() != static_input.strides())
+        return false;
+    }
+    return true;
+  }
+
+  bool capture(const std::vector<at::Tensor>& stack) {
+    AutoGPU guard(device);
+    THCState *state = at::globalContext().lazyInitCUDA();
+    for (auto & input : stack) {
+      if (!input.defined() || !input.type().is_cuda() || input.get_device() != device)
+        return false;
+      // clone keeps the strides of dense inputs
+      static_inputs.push_back(input.clone());
+    }
+
+    // The legacy default stream can't be captured, so capture on a stream of
+    // our own, after the clones.
+    cudaStream_t caller_stream = THCState_getCurrentStream(state);
+    capture_stream = THCStream_new(cudaStreamNonBlocking);
+    cudaEvent_t inputs_ready;
+    THCudaCheck(cudaEventCreateWithFlags(&inputs_ready, cudaEventDisableTiming));
+    THCudaCheck(cudaEventRecord(inputs_ready, caller_stream));
+    THCudaCheck(cudaStreamWaitEvent(capture_stream->stream, inputs_ready, 0));
+    THCudaCheck(cudaEventDestroy(inputs_ready));
+
+    THCStream *caller = THCState_getStream(state);
+    THCStream_retain(caller);
+    THCState_setStream(state, capture_stream);
+    capture_id = THCCachingAllocator_beginCapture(capture_stream->stream);
+    bool success = cudaStreamBeginCapture(capture_stream->stream,
+                                          cudaStreamCaptureModeThreadLocal) == cudaSuccess;
+    std::vector<at::Tensor> outputs = static_inputs;
+    if (success) {
+      try {
+        InterpreterState(code).runOneStage(outputs);
+      } catch (const std::exception&) {
+        success = false;
+      }
+    }
+    cudaGraph_t graph = nullptr;
+    if (cudaStreamEndCapture(capture_stream->stream, &graph) != cudaSuccess)
+      success = false;
+    THCCachingAllocator_endCapture(capture_stream->stream);
+    THCState_setStream(state, caller);
+    THCStream_free(caller);
+    // clear the error of the call that failed the capture
+    cudaGetLastError();
+
+    if (success)
+      success = cudaGraphInstantiate(&exec, graph, nullptr, nullptr, 0) == cudaSuccess;
+    if (graph)
+      cudaGraphDestroy(graph);
+    if (!success) {
+      cudaGetLastError();
+      exec = nullptr;
+      static_inputs.clear();
+      outputs.clear();
+      THCCachingAllocator_releaseCapture(capture_id);
+      THCStream_free(capture_stream);
+      capture_stream = nullptr;
+      return false;
+    }
+    static_outputs = std::move(outputs);
+    THCudaCheck(cudaEventCreateWithFlags(&outputs_read, cudaEventDisableTiming));
+    THCudaCheck(cudaEventRecord(outputs_read, caller_stream));
+    return true;
+  }
+
+  void replay(std::vector<at::Tensor>& stack) {
+    AutoGPU guard(device);
+    cudaStream_t stream = at::globalContext().getCurrentCUDAStream();
+    // the previous replay may have been on another stream
+    THCudaCheck(cudaStreamWaitEvent(stream, outputs_read, 0));
+    for (size_t i = 0; i < stack.size(); ++i) {
+      static_inputs[i].copy_(stack[i]);
+    }
+    THCudaCheck(cudaGraphLaunch(exec, stream));
+    stack.clear();
+    for (auto & output : static_outputs) {
+      stack.push_back(output.clone());
+    }
+    THCudaCheck(cudaEventRecord(outputs_read, stream));
+  }
+
+  std::mutex mutex;
+  Code code;
+  int device;
+  int runs = 0;
+  bool disabled = false;
+
+  cudaGraphExec_t exec = nullptr;
+  THCStream *capture_stream = nullptr;
+  int capture_id = 0;
+  std::vector<at::Tensor> static_inputs;
+  std::vector<at::Tensor> static_outputs;
+  // recorded after the outputs of the last replay were cloned
+  cudaEvent_t outputs_read = nullptr;
+};
+
+#else // defined(WITH_CUDA) && CUDA_VERSION >= 10010
+
+// Capturing in the thread local mode needs CUDA 10.1
+struct CUDAGraphImpl {
+  CUDAGraphImpl(const Code& code, int device) {}
+  bool run(std::vector<at::Tensor>& stack) {
+    return false;
+  }
+};
+
+#endif // defined(WITH_CUDA) && CUDA_VERSION >= 10010
+
+CUDAGraph::CUDAGraph(const std::shared_ptr<Graph>& graph, const Code& code) {
+  int device = captureDevice(*graph);
+  JIT_ASSERT(device >= 0);
+  pImpl.reset(new CUDAGraphImpl(code, device));
+}
+
+CUDAGraph::~CUDAGraph() = default;
+
+bool CUDAGraph::canCapture(const Graph& graph) {
+#if defined(WITH_CUDA) && CUDA_VERSION >= 10010
+  return captureDevice(graph) >= 0;
+#else
+  return false;
+#endif
+}
+
+bool CUDAGraph::run(std::vector<at::Tensor>& stack) {
+  return pImpl->run(stack);
+}
+
+}}
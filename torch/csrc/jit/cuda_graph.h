@@ -0,0 +1,33 @@
+#pragma once
+
+#include "torch/csrc/jit/interpreter.h"
+#include "torch/csrc/jit/ir.h"
+
+#include <memory>
+#include <vector>
+
+namespace torch { namespace jit {
+
+struct CUDAGraphImpl;
+
+// Runs the code of a shape-specialized inference plan by launching a CUDA
+// graph captured from one of its runs. See Note [CUDA graphs].
+struct CUDAGraph {
+  // code must be compiled from graph, and canCapture(*graph) must be true
+  CUDAGraph(const std::shared_ptr<Graph>& graph, const Code& code);
+  ~CUDAGraph();
+
+  // Whether all values of graph are tensors of known sizes on one GPU, and
+  // all nodes compute them there, deterministically.
+  static bool canCapture(const Graph& graph);
+
+  // Replaces the inputs on stack by the outputs of the code, and returns
+  // true, or returns false and leaves stack untouched, in which case the
+  // caller has to run the code itself.
+  bool run(std::vector<at::Tensor>& stack);
+
+private:
+  std::unique_ptr<CUDAGraphImpl> pImpl;
+};
+
+}}
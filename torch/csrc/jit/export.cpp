@@ -14,9 +14,11 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <cstdint>
 #include <cstring>
 #include <fstream>
 #include <memory>
+#include <ostream>
 #include <vector>
 #include <string>
 
@@ -71,21 +73,21 @@ void encodeTensor(onnx::TensorProto * p, const at::Tensor & tensor,
       break;
   }
   p->set_data_type(onnx_type);
-  // CPU's HalfTensor doesn't have contiguous(), so first calling contiguous()
-  auto t = tensor.contiguous().toBackend(at::kCPU);
-  // Add a buffer to the raw_data_export_map for the caller to dump into an
+  // Add the tensor to the raw_data_export_map for the caller to dump into an
   // external data store. If external_ref is not specified, we instead dump
-  // the contiguous data into the protobuf itself
+  // the data into the protobuf itself. Either way the tensor is only made a
+  // contiguous CPU tensor when its data is written out, so that exporting a
+  // model doesn't hold a copy of all its parameters at once.
   if (external_ref) {
     // For now, we use the name of the tensor as the external lookup name to
     // avoid ONNX protobuf changes.
     JIT_ASSERT(external_ref.value() == p->get_name());
     JIT_ASSERT(raw_data_export_map != nullptr);
     JIT_ASSERT(raw_data_export_map->count(external_ref.value()) == 0);
-    (*raw_data_export_map)[external_ref.value()] = t;
+    (*raw_data_export_map)[external_ref.value()] = tensor;
     p->set_external_data_present();
   } else {
-    p->set_raw_data(t);
+    p->set_raw_data(tensor);
   }
 }
 
@@ -310,32 +312,52 @@ void validateGraph(const std::shared_ptr<Graph>& graph) {
 
 }
 
-std::tuple<std::string, RawDataExportMap> ExportGraph(
-                        const std::shared_ptr<Graph>& graph,
-                        const std::vector<at::Tensor> & initializers,
-                        int64_t onnx_opset_version,
-                        bool defer_weight_export) {
+namespace {
 
+RawDataExportMap encodeModelProto(::torch::onnx::ModelProto* model_proto,
+                                  const std::shared_ptr<Graph>& graph,
+                                  const std::vector<at::Tensor> & initializers,
+                                  int64_t onnx_opset_version,
+                                  bool defer_weight_export) {
   validateGraph(graph);
 
-  ::torch::onnx::ModelProto model_proto;
-  model_proto.set_producer_name("pytorch");
-  model_proto.set_producer_version("0.3");
-  auto* imp = model_proto.add_opset_import();
+  model_proto->set_producer_name("pytorch");
+  model_proto->set_producer_version("0.3");
+  auto* imp = model_proto->add_opset_import();
   // This is the version of ONNX operator set we are targeting
   imp->set_version(onnx_opset_version);
 
   // Map {external_data_ref -> raw data} for external serialization of weights
   RawDataExportMap raw_data_export_map;
 
-  // Set up nanopb callbacks and compute the amount of space needed to store
-  // the resulting protobuf
+  // Set up nanopb callbacks
   if (defer_weight_export) {
-    encodeModel(&model_proto, graph, initializers, &raw_data_export_map);
+    encodeModel(model_proto, graph, initializers, &raw_data_export_map);
   } else {
-    encodeModel(&model_proto, graph, initializers);
+    encodeModel(model_proto, graph, initializers);
   }
+  return raw_data_export_map;
+}
+
+bool writeToStream(pb_ostream_t* stream, const pb_byte_t* buf, size_t count) {
+  auto* out = static_cast<std::ostream*>(stream->state);
+  out->write(reinterpret_cast<const char*>(buf), count);
+  return out->good();
+}
+
+} // namespace
+
+std::tuple<std::string, RawDataExportMap> ExportGraph(
+                        const std::shared_ptr<Graph>& graph,
+                        const std::vector<at::Tensor> & initializers,
+                        int64_t onnx_opset_version,
+                        bool defer_weight_export) {
+  ::torch::onnx::ModelProto model_proto;
+  auto raw_data_export_map = encodeModelProto(
+      &model_proto, graph, initializers, onnx_opset_version,
+      defer_weight_export);
 
+  // Compute the amount of space needed to store the resulting protobuf
   size_t out_size;
   pb_get_encoded_size(&out_size, onnx_ModelProto_fields, &model_proto.proto);
 
@@ -347,4 +369,27 @@ std::tuple<std::string, RawDataExportMap> ExportGraph(
   return std::make_tuple(out, raw_data_export_map);
 }
 
+RawDataExportMap ExportGraphToStream(
+                        std::ostream& out,
+                        const std::shared_ptr<Graph>& graph,
+                        const std::vector<at::Tensor> & initializers,
+                        int64_t onnx_opset_version,
+                        bool defer_weight_export) {
+  ::torch::onnx::ModelProto model_proto;
+  auto raw_data_export_map = encodeModelProto(
+      &model_proto, graph, initializers, onnx_opset_version,
+      defer_weight_export);
+
+  pb_ostream_t ostream = PB_OSTREAM_SIZING;
+  ostream.callback = &writeToStream;
+  ostream.state = &out;
+  ostream.max_size = SIZE_MAX;
+  if (!pb_encode(&ostream, onnx_ModelProto_fields, &model_proto.proto)) {
+    throw std::runtime_error(
+        std::string("ONNX export failed to write the model: ") +
+        PB_GET_ERROR(&ostream));
+  }
+  return raw_data_export_map;
+}
+
 }}
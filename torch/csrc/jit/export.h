@@ -2,12 +2,16 @@
 
 #include "torch/csrc/jit/ir.h"
 
+#include <ostream>
+
 namespace torch { namespace jit {
 
 // This map is used to keep track of parameters that should be exported
 // externally. When `defer_weight_export` is true, the returned map contains
 // kv pairs that map {external reference name} -> {at::Tensor to be exported}.
-// It is the responsibility of the caller to export these appropriately.
+// It is the responsibility of the caller to export these appropriately. The
+// tensors are the initializers as they were passed, which need not be
+// contiguous or on the CPU.
 //
 // For example, when exporting to a zip archive, the caller may write out files
 // for each entry in the export map, with the filename being the key and the
@@ -20,4 +24,15 @@ std::tuple<std::string, RawDataExportMap> ExportGraph(
     int64_t onnx_opset_version,
     bool defer_weight_export = false);
 
+// Like ExportGraph, but writes the serialized model to `out` while encoding
+// it, instead of returning it as a string. The parameters not deferred to the
+// returned map are written straight from their tensors, so exporting a model
+// takes about as much memory as the model itself, however big it is.
+RawDataExportMap ExportGraphToStream(
+    std::ostream& out,
+    const std::shared_ptr<Graph>& graph,
+    const std::vector<at::Tensor>& initializers,
+    int64_t onnx_opset_version,
+    bool defer_weight_export = false);
+
 }}
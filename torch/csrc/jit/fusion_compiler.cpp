@@ -14,11 +14,16 @@
 #include <string>
 #include <algorithm>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <sstream>
 #include <iostream>
+#include <fstream>
+#include <cerrno>
+#include <cstdio>
 #include <dlfcn.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
 namespace torch { namespace jit {
 
@@ -108,6 +113,44 @@ void ${kernelName}(IndexType totalElements, void ** args) {
 }
 )");
 
+// Kernels for groups with reductions give each thread (or OpenMP iteration)
+// a row of the innermost dimension, and loop over it once per level of
+// dependent reductions before computing the outputs, see emitRowBody.
+auto cuda_row_compilation_unit_template = CodeTemplate(R"(
+${type_declarations}
+
+extern "C" __global__
+void ${kernelName}(IndexType totalRows, IndexType rowSize, ${formals}) {
+  for (IndexType rowIndex = blockIdx.x * blockDim.x + threadIdx.x;
+        rowIndex < totalRows;
+        rowIndex += gridDim.x * blockDim.x) {
+      ${kernelBody}
+    }
+}
+)");
+
+auto cpu_row_compilation_unit_template = CodeTemplate(R"(
+#include <cstddef>
+#include <math.h>
+#include <iostream>
+${type_declarations}
+
+#define OMP_THRESHOLD 100000
+static void ${kernelName}_kernel(IndexType totalRows, IndexType rowSize, ${formals}) {
+  #pragma omp parallel for if(totalRows * rowSize > OMP_THRESHOLD)
+  for (IndexType rowIndex = 0;
+        rowIndex < totalRows;
+        rowIndex += 1) {
+      ${kernelBody}
+    }
+}
+
+extern "C"
+void ${kernelName}(IndexType totalRows, void ** args) {
+  ${kernelName}_kernel(totalRows, *static_cast<IndexType*>(args[1]) ${,argument_loads});
+}
+)");
+
 // curDimIndex = linearId % sizes[i]; // % sizes[i] is not needed for d == 0, because we already guard for numel outside the index calculation
 // offset += curDimIndex*strides[i]; // *strides[i] is optional if list_is_cont becaause strides.back() == 1
 // linearId /= sizes[i];
@@ -117,11 +160,13 @@ size_t ${tensor}_dimIndex${d} = ${tensor}_linearIndex ${mod_sizes};
 ${tensor}_offset += ${tensor}_dimIndex${d} ${times_stride};
 )");
 
-void emitIndexingFor(std::ostream & out, const std::string & tensor, int ndim, bool last_is_cont) {
+void emitIndexingFor(std::ostream & out, const std::string & tensor, int ndim, bool last_is_cont,
+                     const std::string & index = "linearIndex") {
   TemplateEnv env;
   env.s("tensor",tensor);
+  env.s("index",index);
   out << format("IndexType ${tensor}_offset = 0;\n",env);
-  out << format("IndexType ${tensor}_linearIndex = linearIndex;\n",env);
+  out << format("IndexType ${tensor}_linearIndex = ${index};\n",env);
   for(int d = ndim - 1; d >= 0; --d) {
     env.d("d",d);
     env.s("mod_sizes", d > 0 ? format("% ${tensor}.sizes[${d}]",env) : "");
@@ -249,11 +294,229 @@ std::string encodeRHS(Node * n) {
   return format(str, env);
 }
 
+bool isReduction(Node * n) {
+  return n->kind() == aten::sum || n->kind() == aten::mean;
+}
+
+bool isElementwise(Node * n) {
+  return !isReduction(n) && n->kind() != aten::expand && n->kind() != aten::cat;
+}
+
+// Finds how each value of a group with reductions is shaped: reductions take
+// Full values to reduced ones, expands take them back, and elementwise ops
+// have operands and results of the same shape. Values not connected to
+// either are Full.
+std::unordered_map<Value*, MapShape> inferMapShapes(Graph & subgraph) {
+  std::unordered_map<Value*, MapShape> shapes;
+  for(auto n : subgraph.nodes()) {
+    if(isReduction(n)) {
+      shapes[n->input()] = MapShape::Full;
+      shapes[n->output()] = n->i(attr::keepdim) ? MapShape::ReducedKeepDim : MapShape::Reduced;
+    } else if(n->kind() == aten::expand) {
+      shapes[n->input()] = MapShape::ReducedKeepDim;
+      shapes[n->output()] = MapShape::Full;
+    }
+  }
+  bool changed = true;
+  while(changed) {
+    changed = false;
+    for(auto n : subgraph.nodes()) {
+      if(!isElementwise(n))
+        continue;
+      std::vector<Value*> values(n->inputs().begin(), n->inputs().end());
+      values.push_back(n->output());
+      auto known = std::find_if(values.begin(), values.end(), [&](Value * v) {
+        return shapes.count(v) > 0;
+      });
+      if(known == values.end())
+        continue;
+      MapShape shape = shapes.at(*known);
+      for(auto v : values) {
+        if(shapes.count(v) == 0) {
+          shapes[v] = shape;
+          changed = true;
+        } else {
+          JIT_ASSERT(shapes.at(v) == shape);
+        }
+      }
+    }
+  }
+  for(auto v : subgraph.inputs()) {
+    shapes.emplace(v, MapShape::Full);
+  }
+  for(auto n : subgraph.nodes()) {
+    shapes.emplace(n->output(), MapShape::Full);
+  }
+  return shapes;
+}
+
+// a TensorInfo argument of the kernel
+struct Formal {
+  std::string tensor;
+  size_t nDim;
+  bool last_is_cont;
+};
+
+// Emits the body of a row kernel. Values that are reduced are computed once
+// per row. Full values are computed inside loops over the row: one loop for
+// each level of reductions, where a reduction's level is one more than the
+// highest level of the reductions it depends on, and a final loop writing
+// the Full outputs. Full values needed by several loops are recomputed
+// rather than kept in memory.
+void emitRowBody(std::ostream & body,
+                 Graph & subgraph,
+                 const std::unordered_map<Value*, MapShape> & shapes,
+                 const std::vector<Formal> & formals,
+                 const std::vector<Value*> & outputs) {
+  auto isFull = [&](Value * v) {
+    return shapes.at(v) == MapShape::Full;
+  };
+  // formals are the inputs followed by the outputs
+  size_t num_inputs = subgraph.inputs().size();
+  TemplateEnv env;
+  auto emitOffset = [&](size_t formal, const std::string & index) {
+    auto & f = formals.at(formal);
+    emitIndexingFor(body, f.tensor, f.nDim, f.last_is_cont, index);
+  };
+  auto emitNode = [&](Node * n) {
+    env.s("node",valueName(n->output()));
+    env.s("rhs",n->kind() == aten::expand ? valueName(n->input()) : encodeRHS(n));
+    body << format("auto ${node} = ${rhs};\n",env);
+  };
+  auto emitAccess = [&](size_t formal, Value * v, bool store) {
+    env.s("node",valueName(v));
+    env.s("tensor",formals.at(formal).tensor);
+    body << format(store ? "${tensor}.data[${tensor}_offset] = ${node};\n"
+                         : "auto ${node} = ${tensor}.data[${tensor}_offset];\n",env);
+  };
+
+  std::unordered_map<Value*, int> level;
+  int max_level = 0;
+  for(auto v : subgraph.inputs())
+    level[v] = 0;
+  for(auto n : subgraph.nodes()) {
+    int l = 0;
+    for(auto i : n->inputs())
+      l = std::max(l, level.at(i));
+    if(isReduction(n)) {
+      l++;
+      max_level = std::max(max_level, l);
+    }
+    level[n->output()] = l;
+  }
+
+  // opens a loop over the row that computes the Full values the roots depend
+  // on, and also stores the Full outputs if store_outputs is set
+  auto emitRowLoop = [&](const std::vector<Value*> & roots, bool store_outputs) {
+    std::unordered_set<Value*> needed;
+    std::vector<Value*> stack;
+    for(auto r : roots) {
+      if(needed.insert(r).second)
+        stack.push_back(r);
+    }
+    while(!stack.empty()) {
+      Node * n = stack.back()->node();
+      stack.pop_back();
+      if(n->kind() == prim::Param)
+        continue;
+      for(auto i : n->inputs()) {
+        if(isFull(i) && needed.insert(i).second)
+          stack.push_back(i);
+      }
+    }
+    body << "for (IndexType j = 0; j < rowSize; ++j) {\n";
+    body << "IndexType linearIndex = rowIndex * rowSize + j;\n";
+    for(size_t i = 0; i < num_inputs; ++i) {
+      if(needed.count(subgraph.inputs()[i]) > 0) {
+        emitOffset(i, "linearIndex");
+        emitAccess(i, subgraph.inputs()[i], false);
+      }
+    }
+    for(auto n : subgraph.nodes()) {
+      if(!isReduction(n) && needed.count(n->output()) > 0)
+        emitNode(n);
+    }
+    if(store_outputs) {
+      for(size_t i = 0; i < outputs.size(); ++i) {
+        if(isFull(outputs[i])) {
+          emitOffset(num_inputs + i, "linearIndex");
+          emitAccess(num_inputs + i, outputs[i], true);
+        }
+      }
+    }
+  };
+
+  // reduced inputs and outputs are indexed by the row
+  for(size_t i = 0; i < num_inputs; ++i) {
+    if(!isFull(subgraph.inputs()[i])) {
+      emitOffset(i, "rowIndex");
+      emitAccess(i, subgraph.inputs()[i], false);
+    }
+  }
+  for(int l = 0; l <= max_level; ++l) {
+    // the reductions of level l were finished by the previous loop
+    for(auto n : subgraph.nodes()) {
+      if(isElementwise(n) && !isFull(n->output()) && level.at(n->output()) == l)
+        emitNode(n);
+    }
+    if(l == max_level)
+      break;
+    std::vector<Node*> reductions;
+    std::vector<Value*> roots;
+    for(auto n : subgraph.nodes()) {
+      if(isReduction(n) && level.at(n->output()) == l + 1) {
+        reductions.push_back(n);
+        roots.push_back(n->input());
+      }
+    }
+    for(auto n : reductions) {
+      env.s("node",valueName(n->output()));
+      body << format("float ${node} = 0;\n",env);
+    }
+    emitRowLoop(roots, false);
+    for(auto n : reductions) {
+      env.s("node",valueName(n->output()));
+      env.s("input",valueName(n->input()));
+      body << format("${node} += ${input};\n",env);
+    }
+    body << "}\n";
+    for(auto n : reductions) {
+      if(n->kind() == aten::mean) {
+        env.s("node",valueName(n->output()));
+        body << format("${node} /= rowSize;\n",env);
+      }
+    }
+  }
+  std::vector<Value*> full_outputs;
+  for(auto o : outputs) {
+    if(isFull(o))
+      full_outputs.push_back(o);
+  }
+  if(!full_outputs.empty()) {
+    emitRowLoop(full_outputs, true);
+    body << "}\n";
+  }
+  for(size_t i = 0; i < outputs.size(); ++i) {
+    if(!isFull(outputs[i])) {
+      emitOffset(num_inputs + i, "rowIndex");
+      emitAccess(num_inputs + i, outputs[i], true);
+    }
+  }
+}
+
 std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
                                             const std::string & name,
                                             AnnotatedGraph & agraph,
-                                            bool use_cuda) {
+                                            bool use_cuda,
+                                            ReductionDesc & reduction_desc) {
   Graph& subgraph = *agraph.graph;
+  reduction_desc = ReductionDesc();
+  for(auto n : subgraph.nodes()) {
+    if(isReduction(n) || n->kind() == aten::expand)
+      reduction_desc.enabled = true;
+  }
+  // row kernels take the row size after the number of rows
+  size_t first_formal = reduction_desc.enabled ? 2 : 1;
   TemplateEnv env;
   env.s("kernelName",name);
   // TODO: handle cases where we need to generate > 2^32 element tensors
@@ -263,12 +526,18 @@ std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
   std::stringstream tensorOffsets;
   std::vector<std::string> formals;
   std::vector<std::string> argument_loads;
+  std::vector<Formal> row_formals;
   auto emitFormal = [&](Value * n, const TensorDesc & desc) {
     std::string tensor = "t" + std::to_string(formals.size()); //can't be unique() because Param may be an output
     size_t nDim = desc.nDim();
-    emitIndexingFor(tensorOffsets, tensor, nDim,  desc.lastIsContiguous());
+    if(reduction_desc.enabled) {
+      // row kernels compute offsets where they use the tensor
+      row_formals.push_back(Formal{tensor, nDim, desc.lastIsContiguous()});
+    } else {
+      emitIndexingFor(tensorOffsets, tensor, nDim,  desc.lastIsContiguous());
+    }
     env.s("tensor",tensor);
-    env.d("formal_index", formals.size() + 1); // + 1 because the first argument is the linearIndex
+    env.d("formal_index", formals.size() + first_formal); // the first arguments are the sizes of the kernel
     env.d("nDim",nDim);
     env.s("scalar_type",scalarTypeName(desc.scalar_type));
     formals.push_back(format("TensorInfo<${scalar_type},${nDim}> ${tensor}",env));
@@ -290,6 +559,8 @@ std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
         concat_desc.emplace_back();
         flat_output_nodes.push_back(o);
       } else {
+        // the fuser doesn't put concats and reductions in the same group
+        JIT_ASSERT(!reduction_desc.enabled);
         auto cat = o->node();
         size_t nInputs = cat->inputs().size();
         concat_desc.emplace_back(desc, nInputs, cat->i(attr::dim));
@@ -300,33 +571,48 @@ std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
       }
     }
   }
-  size_t formal_count = 0;
-  for(auto p : subgraph.inputs()) {
-    env.s("node",valueName(p));
-    env.d("formal",formal_count++);
-    env.s("access",format("t${formal}.data[t${formal}_offset]",env));
-    //TODO: actual type propagation rather than relying on auto..
-    body << format("auto ${node} = ${access};\n",env);
-  }
-  for(auto n : subgraph.nodes()) {
-    if(n->kind() == aten::cat)
-      continue; // Concat nodes by narrowing the output Tensors before the kernel runs
-    env.s("node",valueName(n->output()));
-    env.s("rhs", encodeRHS(n));
-    body << format("auto ${node} = ${rhs};\n",env);
-  }
-  for(auto o : flat_output_nodes) {
-    env.d("formal",formal_count++);
-    env.s("access",format("t${formal}.data[t${formal}_offset]",env));
-    env.s("node",valueName(o));
-    body << format("${access} = ${node};\n",env);
+  if(reduction_desc.enabled) {
+    auto shapes = inferMapShapes(subgraph);
+    for(auto p : subgraph.inputs())
+      reduction_desc.input_shapes.push_back(shapes.at(p));
+    for(auto o : flat_output_nodes)
+      reduction_desc.output_shapes.push_back(shapes.at(o));
+    for(auto n : subgraph.nodes()) {
+      if(n->kind() == aten::expand)
+        reduction_desc.row_size = n->is(attr::size).back();
+    }
+    emitRowBody(body, subgraph, shapes, row_formals, flat_output_nodes);
+  } else {
+    size_t formal_count = 0;
+    for(auto p : subgraph.inputs()) {
+      env.s("node",valueName(p));
+      env.d("formal",formal_count++);
+      env.s("access",format("t${formal}.data[t${formal}_offset]",env));
+      //TODO: actual type propagation rather than relying on auto..
+      body << format("auto ${node} = ${access};\n",env);
+    }
+    for(auto n : subgraph.nodes()) {
+      if(n->kind() == aten::cat)
+        continue; // Concat nodes by narrowing the output Tensors before the kernel runs
+      env.s("node",valueName(n->output()));
+      env.s("rhs", encodeRHS(n));
+      body << format("auto ${node} = ${rhs};\n",env);
+    }
+    for(auto o : flat_output_nodes) {
+      env.d("formal",formal_count++);
+      env.s("access",format("t${formal}.data[t${formal}_offset]",env));
+      env.s("node",valueName(o));
+      body << format("${access} = ${node};\n",env);
+    }
   }
   env.s("tensorOffsets",tensorOffsets.str());
   env.s("kernelBody",body.str());
   env.v("formals",formals);
   env.v("argument_loads",argument_loads);
   env.s("type_declarations", type_declarations_template.format(env));
-  if(use_cuda) {
+  if(reduction_desc.enabled) {
+    out << (use_cuda ? cuda_row_compilation_unit_template : cpu_row_compilation_unit_template).format(env);
+  } else if(use_cuda) {
     out << cuda_compilation_unit_template.format(env);
   } else {
     out << cpu_compilation_unit_template.format(env);
@@ -404,6 +690,35 @@ void compressContiguous(
 
 } // anonymous namespace
 
+static std::vector<int64_t> shapeFromMap(at::IntList map_size, MapShape shape) {
+  std::vector<int64_t> sizes = map_size.vec();
+  if(shape == MapShape::ReducedKeepDim) {
+    sizes.back() = 1;
+  } else if(shape == MapShape::Reduced) {
+    sizes.pop_back();
+  }
+  return sizes;
+}
+
+std::vector<int64_t> CompiledFusionFunction::mapSize(at::ArrayRef<at::Tensor> inputs) {
+  if(!reduction_desc.enabled) {
+    return inputs[0].sizes().vec();
+  }
+  for(size_t i = 0; i < inputs.size(); ++i) {
+    if(reduction_desc.input_shapes[i] == MapShape::Full)
+      return inputs[i].sizes().vec();
+  }
+  // all inputs are reduced, so the group expands them to the row size
+  JIT_ASSERT(reduction_desc.row_size >= 0);
+  std::vector<int64_t> sizes = inputs[0].sizes().vec();
+  if(reduction_desc.input_shapes[0] == MapShape::ReducedKeepDim) {
+    sizes.back() = reduction_desc.row_size;
+  } else {
+    sizes.push_back(reduction_desc.row_size);
+  }
+  return sizes;
+}
+
 void CompiledFusionFunction::launch_with_tensors(at::ArrayRef<at::Tensor> inputs, at::ArrayRef<at::Tensor> outputs) {
   AutoGPU gpu_guard(inputs);
   JIT_ASSERT(inputs.size() == input_desc.size());
@@ -413,11 +728,27 @@ void CompiledFusionFunction::launch_with_tensors(at::ArrayRef<at::Tensor> inputs
     flat_outputs_size += c.nSubtensors;
   // XXX: this code assumes that inputs are 32-bit addressable
   // XXX: this code assumes that all inputs are of the same size
-  JIT_ASSERT(inputs[0].numel() <= std::numeric_limits<uint32_t>::max());
-  uint32_t numel = inputs[0].numel();
-  at::IntList map_size = inputs[0].sizes();
+  std::vector<int64_t> map_size = mapSize(inputs);
+  int64_t map_numel = 1;
+  for(auto s : map_size)
+    map_numel *= s;
+  JIT_ASSERT(map_numel <= std::numeric_limits<uint32_t>::max());
+  uint32_t numel = map_numel;
+  uint32_t row_size = 0;
+  if(reduction_desc.enabled) {
+    // row kernels are launched over rows instead of elements
+    JIT_ASSERT(map_size.size() > 0);
+    row_size = map_size.back();
+    numel = 1;
+    for(size_t i = 0; i + 1 < map_size.size(); ++i)
+      numel *= map_size[i];
+  }
   // Compute the storage needed to store TensorInfo structs for inputs and outputs.
-  size_t uncompressedDim = input_desc.at(0).contiguity.size();
+  size_t uncompressedDim = 0;
+  for(auto & d : input_desc)
+    uncompressedDim = std::max(uncompressedDim, d.contiguity.size());
+  for(auto & d : output_desc)
+    uncompressedDim = std::max(uncompressedDim, d.contiguity.size());
   size_t maxPossibleTensorInfoSize = sizeof(TensorInfo) + 2 * sizeof(uint32_t) * uncompressedDim;
   size_t maxPossibleBufferSize = maxPossibleTensorInfoSize * (inputs.size() + flat_outputs_size);
   std::vector<char> buffer(maxPossibleBufferSize);
@@ -437,12 +768,17 @@ void CompiledFusionFunction::launch_with_tensors(at::ArrayRef<at::Tensor> inputs
     arguments.push_back(ti);
   };
   arguments.push_back(&numel);
+  if(reduction_desc.enabled)
+    arguments.push_back(&row_size);
   for (std::size_t i = 0; i < input_desc.size(); ++i)
     addTensorInfo(input_desc[i], inputs[i]);
   for (std::size_t i = 0; i < output_desc.size(); ++i) {
     auto & c = concat_desc[i];
     at::Tensor o = outputs[i];
-    if(c.nSubtensors == 1) {
+    if(reduction_desc.enabled) {
+      o.resize_(shapeFromMap(map_size, reduction_desc.output_shapes[i]));
+      addTensorInfo(output_desc[i], outputs[i]);
+    } else if(c.nSubtensors == 1) {
       o.resize_(map_size);
       addTensorInfo(output_desc[i], outputs[i]);
     } else {
@@ -496,7 +832,7 @@ struct CUDAFusionFunction : public CompiledFusionFunction {
     checkCUDAVersion(prop);
 
     std::stringstream cu;
-    concat_desc = codegen::emitCompilationUnit(cu, name, agraph, true);
+    concat_desc = codegen::emitCompilationUnit(cu, name, agraph, true, reduction_desc);
     compilation_unit = cu.str();
     nvrtcProgram program;
     TORCH_NVRTC_CHECK(nvrtcCreateProgram(&program, compilation_unit.c_str(), NULL, 0, nullptr, nullptr));
@@ -546,11 +882,13 @@ protected:
      // cudaFree(0) accomplishes this.
      cudaFree(0);
 
+     // launch on the current stream, like ATen kernels, so that the fused
+     // kernels are ordered with them and can be captured into a CUDA graph
      TORCH_CU_CHECK(cuLaunchKernel(
        function,
        numBlocks, 1, 1,
        blockSize, 1, 1,
-       0, nullptr,
+       0, at::globalContext().getCurrentCUDAStream(),
        arguments,
        nullptr));
   }
@@ -677,26 +1015,94 @@ static void disas(const std::string & so_file) {
   JIT_ASSERT(r == 0);
 }
 
+// 64-bit FNV-1a, which unlike std::hash is stable across builds
+static uint64_t hashString(const std::string & str) {
+  uint64_t hash = 14695981039346656037ULL;
+  for(unsigned char c : str) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// -march=native code only runs on CPUs with the same instruction set
+// extensions, so they are part of the key of cached kernels
+static std::string hostCPUFlags() {
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while(std::getline(cpuinfo, line)) {
+    if(line.compare(0, 5, "flags") == 0)
+      return line;
+  }
+  return "";
+}
+
+static void makeDirectories(const std::string & path) {
+  for(size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+    std::string prefix = path.substr(0, pos);
+    if(mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+      barf("failed to create fuser cache directory %s", prefix.c_str());
+    }
+    if(pos == std::string::npos)
+      break;
+  }
+}
+
 struct CPUFusionFunction : public CompiledFusionFunction {
   CPUFusionFunction(const std::string & name, AnnotatedGraph & agraph, FusionCompilerConfig & config)
   : CompiledFusionFunction(name, agraph) {
-    TempFile so_file(so_template, 3);
-    TempFile cpp_file(cpp_template, 4);
+    // Cached kernels are shared by processes that number their kernels
+    // differently, so they all export the same symbol. Every library is
+    // loaded with RTLD_LOCAL, so these don't clash.
+    bool use_cache = !config.cache_dir.empty();
+    std::string symbol = use_cache ? "fused_kernel" : name;
 
     std::stringstream cu;
-    concat_desc = codegen::emitCompilationUnit(cu, name, agraph, false);
+    concat_desc = codegen::emitCompilationUnit(cu, symbol, agraph, false, reduction_desc);
     compilation_unit = cu.str();
+    if(use_cache) {
+      loadCached(config);
+    } else {
+      TempFile so_file(so_template, 3);
+      compile(config, so_file.name());
+      so_lib.reset(new DynamicLibrary(so_file.name().c_str()));
+    }
+    kernel = reinterpret_cast<void(*)(uint32_t, void**)>(so_lib->sym(symbol.c_str()));
+  }
+protected:
+  void compile(FusionCompilerConfig & config, const std::string & so_file) {
+    TempFile cpp_file(cpp_template, 4);
     cpp_file.write(compilation_unit);
     cpp_file.sync();
-    runCompiler(config, cpp_file.name(), so_file.name());
+    runCompiler(config, cpp_file.name(), so_file);
     if(config.debug) {
       std::cout << compilation_unit << "\n";
-      disas(so_file.name());
+      disas(so_file);
     }
-    so_lib.reset(new DynamicLibrary(so_file.name().c_str()));
-    kernel = reinterpret_cast<void(*)(uint32_t, void**)>(so_lib->sym(name.c_str()));
   }
-protected:
+  // The on-disk cache is content-addressed: a library is named after the
+  // hash of everything that went into compiling it, so it is never stale,
+  // and it is moved into place atomically, so concurrent processes compiling
+  // the same kernel don't see partially written files.
+  void loadCached(FusionCompilerConfig & config) {
+    std::stringstream key;
+    key << config.cxx << "\n" << config.openmp << "\n" << hostCPUFlags() << "\n";
+    key << compilation_unit;
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016llx", (unsigned long long) hashString(key.str()));
+    std::string so_path = config.cache_dir + "/" + hash + ".so";
+    if(access(so_path.c_str(), R_OK) != 0) {
+      makeDirectories(config.cache_dir);
+      TempFile so_file(config.cache_dir + "/tmp_XXXXXX.so", 3);
+      compile(config, so_file.name());
+      if(rename(so_file.name().c_str(), so_path.c_str()) != 0) {
+        barf("failed to move compiled kernel to %s", so_path.c_str());
+      }
+    } else if(config.debug) {
+      std::cout << "loading cached kernel " << so_path << "\n";
+    }
+    so_lib.reset(new DynamicLibrary(so_path.c_str()));
+  }
   virtual at::Backend backend() const override {
     return at::kCPU;
   }
@@ -790,6 +1196,10 @@ FusionCompiler::FusionCompiler() {
   }
   const char * debug_env = getenv("PYTORCH_FUSION_DEBUG");
   config_.debug = debug_env && atoi(debug_env) != 0;
+  const char * cache_env = getenv("PYTORCH_FUSION_CACHE_DIR");
+  if(cache_env != nullptr) {
+    config_.cache_dir = cache_env;
+  }
 }
 
 //TODO: thread safety
@@ -78,6 +78,26 @@ struct ConcatDesc {
   }
 };
 
+// How a fusion group input or output is shaped relative to the map size,
+// i.e. the size of the elementwise part of the group
+enum class MapShape {
+  Full,           // same size as the map
+  ReducedKeepDim, // map size with the last dimension reduced to 1
+  Reduced,        // map size with the last dimension removed
+};
+
+// Fusion groups that reduce over the last dimension (or broadcast the
+// results of such reductions back to the map size) are compiled to kernels
+// that process one row of the innermost dimension at a time.
+struct ReductionDesc {
+  bool enabled = false; // false for groups that are a single elementwise map
+  std::vector<MapShape> input_shapes;
+  std::vector<MapShape> output_shapes;
+  // size of the last dimension as recorded by expands in the group, needed
+  // to find the map size when no input has it
+  int64_t row_size = -1;
+};
+
 struct CompiledFusionFunction {
   TH_DISALLOW_COPY_AND_ASSIGN(CompiledFusionFunction);
 
@@ -95,6 +115,9 @@ struct CompiledFusionFunction {
 protected:
   virtual at::Backend backend() const = 0;
 
+  // size of the elementwise part of the kernel
+  std::vector<int64_t> mapSize(at::ArrayRef<at::Tensor> inputs);
+
   // arguments is a list of pointers to the arguments for the compiled CUDA/CPU
   // code.
   // The format of arguments is suitable for directly passing to a call to
@@ -102,6 +125,8 @@ protected:
   // Currently the first argument is a pointer to numel (for passing to
   // CUDA code), and the remainder are pointers to the TensorInfo<T> structs
   // that compiled code uses to load Tensor data.
+  // For kernels with reductions numel is the number of rows instead, and
+  // the second argument is a pointer to the size of a row.
   // launch_with_tensors handles packing at::Tensors into this arguments array.
   // CPU code uses the same convension so that launch_with_tensors can be shared.
   virtual void launch_raw(uint32_t numel, void ** arguments) = 0;
@@ -115,12 +140,17 @@ protected:
   // an output is actually a concatenation of
   // many subtensors that the fusion group produces
   std::vector<ConcatDesc> concat_desc;
+
+  ReductionDesc reduction_desc;
 };
 
 struct FusionCompilerConfig {
   std::string cxx = "g++"; // compiler location
   bool debug = false; // emit debugging information about fusions
   bool openmp = true;
+  // directory of compiled CPU kernels shared across processes, set from
+  // PYTORCH_FUSION_CACHE_DIR; kernels are only kept in memory if empty
+  std::string cache_dir;
 };
 
 // caching compiler
@@ -2,6 +2,7 @@
 #include "torch/csrc/jit/ir.h"
 #include "torch/csrc/jit/argument_spec.h"
 #include "torch/csrc/jit/autodiff.h"
+#include "torch/csrc/jit/cuda_graph.h"
 #include "torch/csrc/jit/interpreter.h"
 #include "torch/csrc/autograd/grad_mode.h"
 #include "torch/csrc/jit/passes/create_autodiff_subgraphs.h"
@@ -12,10 +13,15 @@
 #include "torch/csrc/jit/passes/graph_fuser.h"
 #include "torch/csrc/jit/passes/inplace_check.h"
 #include "torch/csrc/jit/passes/batch_mm.h"
+#include "torch/csrc/jit/passes/memory_planning.h"
+#include "torch/csrc/jit/passes/parallel_branches.h"
 
 #include "torch/csrc/autograd/function.h"
 #include "torch/csrc/autograd/edge.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <list>
 #include <unordered_map>
 
 namespace torch { namespace jit {
@@ -80,6 +86,18 @@ struct ExecutionPlan {
     InterpreterState(f).runOneStage(stack);
     return wrapTensors(std::move(stack));
   }
+  tensor_list runInference(tensor_list&& inputs) const {
+    JIT_ASSERT(!grad);
+    auto stack = std::move(inputs);
+    if(!cuda_graph || !cuda_graph->run(stack))
+      InterpreterState(f).runOneStage(stack);
+    return stack;
+  }
+  // see Note [CUDA graphs]
+  void enableCUDAGraph(const std::shared_ptr<Graph>& graph) {
+    if(CUDAGraph::canCapture(*graph))
+      cuda_graph = std::make_shared<CUDAGraph>(graph, f);
+  }
 private:
   // inplace to avoid allocations
   tensor_list unwrapVariables(variable_tensor_list && list) const {
@@ -148,6 +166,8 @@ private:
   Gradient grad; // if(grad) is false when this is unused
   // executor for df, including code caches
   GraphExecutor grad_executor;
+  // replays runInference from a CUDA graph, if set
+  std::shared_ptr<CUDAGraph> cuda_graph;
 };
 
 } // anonymous namespace
@@ -162,11 +182,15 @@ struct GraphExecutorImpl {
   GraphExecutorImpl(std::shared_ptr<Graph> graph, bool optimize, bool symbolically_differentiable)
   : graph(std::move(graph))
   , optimize(optimize)
-  , symbolically_differentiable(symbolically_differentiable) {}
+  , symbolically_differentiable(symbolically_differentiable) {
+    readPlanCacheConfig();
+  }
   GraphExecutorImpl(std::shared_ptr<Graph> graph, bool optimize)
   : graph(std::move(graph))
   , optimize(optimize)
-  , symbolically_differentiable(isDifferentiable(*this->graph)) {}
+  , symbolically_differentiable(isDifferentiable(*this->graph)) {
+    readPlanCacheConfig();
+  }
 
   // entry point where execution begins
   variable_tensor_list run(variable_tensor_list inputs) {
@@ -183,12 +207,55 @@ struct GraphExecutorImpl {
     // either we can symbolically differentiate, or we do not need a gradient.
     // go down the route where we treat the inputs as tensors
     // and fully optimize
-    auto & implementation = getOrCompile(inputs);
-    return implementation.run(std::move(inputs));
+    auto implementation = getOrCompile(inputs, /*inference=*/false);
+    return implementation->run(std::move(inputs));
+  }
+
+  tensor_list runInference(tensor_list inputs) {
+    auto implementation = getOrCompile(inputs, /*inference=*/true);
+    return implementation->runInference(std::move(inputs));
+  }
+
+  PlanCacheStats planCacheStats() {
+    std::lock_guard<std::mutex> lock(compile_mutex);
+    PlanCacheStats result = stats;
+    result.size = plan_cache.plans.size() + inference_plan_cache.plans.size();
+    return result;
   }
 
 private:
 
+  // Serving workloads see many distinct input sizes, and by default every
+  // one of them gets its own plan, kept forever.
+  // PYTORCH_JIT_PLAN_CACHE_SIZE=N keeps only the N most recently used plans.
+  // PYTORCH_JIT_BUCKET_BATCH=1 makes a plan cover all batch sizes (the first
+  // dimension of every input) up to the same power of two. That plan is
+  // compiled for the first batch size seen, so this is only valid for graphs
+  // that don't depend on the batch size, e.g. that don't view or expand to a
+  // fixed batch size.
+  void readPlanCacheConfig() {
+    const char * size_env = getenv("PYTORCH_JIT_PLAN_CACHE_SIZE");
+    max_plans = size_env ? std::max(atoi(size_env), 0) : 0;
+    const char * bucket_env = getenv("PYTORCH_JIT_BUCKET_BATCH");
+    bucket_batch = bucket_env && atoi(bucket_env) != 0;
+    // PYTORCH_JIT_MEMORY_PLANNING=1 places fusion outputs in a preallocated
+    // arena, see Note [Memory planning]. The arena is laid out for exact sizes,
+    // so it can't be combined with bucketing.
+    const char * planning_env = getenv("PYTORCH_JIT_MEMORY_PLANNING");
+    plan_memory = planning_env && atoi(planning_env) != 0 && !bucket_batch;
+    // PYTORCH_JIT_PARALLEL_BRANCHES=1 runs independent branches of a graph
+    // on the intra-op thread pool, when each of them does more than
+    // PYTORCH_JIT_PARALLEL_BRANCHES_MIN_COST work, see Note [Parallel branches].
+    const char * branches_env = getenv("PYTORCH_JIT_PARALLEL_BRANCHES");
+    parallel_branches = branches_env && atoi(branches_env) != 0;
+    const char * cost_env = getenv("PYTORCH_JIT_PARALLEL_BRANCHES_MIN_COST");
+    min_branch_cost = cost_env ? std::max(atoll(cost_env), 0LL) : kDefaultMinBranchCost;
+    // PYTORCH_JIT_CUDA_GRAPHS=1 replays inference plans on the GPU from a
+    // CUDA graph once they have warmed up, see Note [CUDA graphs].
+    const char * graphs_env = getenv("PYTORCH_JIT_CUDA_GRAPHS");
+    cuda_graphs = graphs_env && atoi(graphs_env) != 0;
+  }
+
   static bool needsGradient(const variable_tensor_list & inputs) {
     if (!autograd::GradMode::is_enabled()) {
       return false;
@@ -221,6 +288,10 @@ private:
       // it works fine on variables.
       BatchMM(graph);
       FuseGraph(graph);
+      if(parallel_branches)
+        ParallelizeBranches(graph, min_branch_cost);
+      if(plan_memory)
+        PlanMemory(graph);
     }
   }
   const Code & getOrCreateAutogradFallback() {
@@ -236,18 +307,36 @@ private:
     autograd_fallback = Code(graph_, /*values_are_variables=*/true);
     return autograd_fallback;
   }
-  const ExecutionPlan & getOrCompile(const variable_tensor_list & inputs) {
+  // plans are returned by shared_ptr, because they can be evicted while
+  // other threads are still running them
+  std::shared_ptr<ExecutionPlan> getOrCompile(at::ArrayRef<at::Tensor> inputs, bool inference) {
     // outside lock guard, to minimize the time holding the lock on the fast path
     // ArgumentSpec even computes its hashCode here.
-    ArgumentSpec spec(autograd::GradMode::is_enabled(), inputs);
+    // inference inputs aren't Variables, so they never require grad
+    bool with_grad = !inference && autograd::GradMode::is_enabled();
+    ArgumentSpec spec(with_grad, inputs, bucket_batch);
     {
       std::lock_guard<std::mutex> lock(compile_mutex);
-      auto it = plan_cache.find(spec);
-      if(it != plan_cache.end())
-        return it->second;
-      auto plan = compileSpec(spec);
-      auto r = plan_cache.emplace(std::move(spec), std::move(plan));
-      return r.first->second;
+      auto & cache = inference ? inference_plan_cache : plan_cache;
+      auto it = cache.index.find(spec);
+      if(it != cache.index.end()) {
+        stats.hits++;
+        cache.plans.splice(cache.plans.begin(), cache.plans, it->second);
+        return it->second->second;
+      }
+      stats.misses++;
+      // bucketed specs have rounded sizes, so compile for the actual ones
+      auto plan = std::make_shared<ExecutionPlan>(bucket_batch ?
+        compileSpec(ArgumentSpec(with_grad, inputs), inference) :
+        compileSpec(spec, inference));
+      cache.plans.emplace_front(spec, plan);
+      cache.index.emplace(std::move(spec), cache.plans.begin());
+      if(max_plans > 0 && cache.plans.size() > max_plans) {
+        cache.index.erase(cache.plans.back().first);
+        cache.plans.pop_back();
+        stats.evictions++;
+      }
+      return plan;
     }
   }
   bool needsGradient(const ArgumentSpec & spec) {
@@ -311,12 +400,23 @@ private:
     // calculate all input shapes
     PropagateInputShapes(*g, spec);
   }
-  ExecutionPlan compileSpec(const ArgumentSpec & spec) {
+  ExecutionPlan compileSpec(const ArgumentSpec & spec, bool inference) {
     auto graph_ = graph->copy();
+    if(inference && !optimize) {
+      return ExecutionPlan(graph_);
+    }
     specializeToSpec(graph_, spec);
     if(!needsGradient(spec)) {
       runOptimization(graph_, /*graphMustSupportVariables=*/false);
-      return ExecutionPlan(graph_);
+      // nothing else sees the intermediates of a plan run without autograd,
+      // so their memory can be reused. CheckInplace has already rejected
+      // graphs with in-place ops of their own.
+      if(inference)
+        ReuseInplace(graph_);
+      ExecutionPlan plan(graph_);
+      if(inference && cuda_graphs)
+        plan.enableCUDAGraph(graph_);
+      return plan;
     }
     JIT_ASSERT(symbolically_differentiable);
 
@@ -353,11 +453,27 @@ private:
 
   // optimizable code paths, used when we can differentiate or when no derivative is needed
   // Spec describes input conditions, Plan describes how to execute them.
-  std::unordered_map<ArgumentSpec, ExecutionPlan> plan_cache;
+  // plans is ordered from most to least recently used, for eviction.
+  using PlanList = std::list<std::pair<ArgumentSpec, std::shared_ptr<ExecutionPlan>>>;
+  struct PlanCache {
+    PlanList plans;
+    std::unordered_map<ArgumentSpec, PlanList::iterator> index;
+  };
+  PlanCache plan_cache;
+  // plans of runInference, which differ from those of run even when
+  // no gradient is needed, see compileSpec
+  PlanCache inference_plan_cache;
+  size_t max_plans; // 0 means unbounded in each cache
+  bool bucket_batch;
+  bool plan_memory;
+  bool parallel_branches;
+  int64_t min_branch_cost;
+  bool cuda_graphs;
+  PlanCacheStats stats;
 
   // GraphExecutor can be accessed from  multiple thread so
-  // anytime we are checking or updating the autograd_fallback or
-  // plan_cache, we must hold the compile mutex.
+  // anytime we are checking or updating the autograd_fallback,
+  // plan_cache or stats, we must hold the compile mutex.
   // along the fast path (no compilation) code should
   // hold this for as little time as possible.
   std::mutex compile_mutex;
@@ -373,4 +489,12 @@ variable_tensor_list GraphExecutor::run(variable_tensor_list && inputs) {
   return pImpl->run(std::move(inputs));
 }
 
+std::vector<at::Tensor> GraphExecutor::runInference(std::vector<at::Tensor> && inputs) {
+  return pImpl->runInference(std::move(inputs));
+}
+
+PlanCacheStats GraphExecutor::planCacheStats() const {
+  return pImpl->planCacheStats();
+}
+
 }}
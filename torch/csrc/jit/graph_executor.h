@@ -6,6 +6,15 @@
 
 namespace torch { namespace jit {
 
+// statistics of the cache of plans specialized to the inputs' types, sizes
+// and requires_grad states
+struct PlanCacheStats {
+  size_t hits = 0;
+  size_t misses = 0; // every miss optimizes the graph for a new specialization
+  size_t evictions = 0;
+  size_t size = 0; // number of plans currently cached
+};
+
 struct GraphExecutorImpl;
 struct GraphExecutor {
   GraphExecutor() {}
@@ -13,6 +22,12 @@ struct GraphExecutor {
   // note: if not specified, symbolically_differentiable is computed from the graph.
   GraphExecutor(std::shared_ptr<Graph> graph, bool optimize, bool symbolically_differentiable);
   variable_tensor_list run(variable_tensor_list && inputs);
+  // Runs the graph on tensors that are not Variables, with no autograd
+  // bookkeeping at all, e.g. for serving. Its plans reuse the memory of
+  // intermediates for in-place ops (see ReuseInplace), and are cached
+  // separately from the plans of run().
+  std::vector<at::Tensor> runInference(std::vector<at::Tensor> && inputs);
+  PlanCacheStats planCacheStats() const;
   operator bool() const {
     return pImpl != nullptr;
   }
@@ -12,6 +12,9 @@
 #include "torch/csrc/jit/passes/common_subexpression_elimination.h"
 #include "torch/csrc/jit/passes/peephole.h"
 #include "torch/csrc/jit/passes/canonicalize.h"
+#include "torch/csrc/jit/passes/memory_planning.h"
+#include "torch/csrc/jit/passes/constant_propagation.h"
+#include "torch/csrc/jit/passes/parallel_branches.h"
 #include "torch/csrc/jit/passes/onnx/peephole.h"
 #include "torch/csrc/jit/graph_executor.h"
 #include "torch/csrc/jit/script/init.h"
@@ -68,6 +71,18 @@ void initJITBindings(PyObject *module) {
    .def("_jit_pass_cse", graph_pass<EliminateCommonSubexpression>)
    .def("_jit_pass_peephole", graph_pass<PeepholeOptimize>)
    .def("_jit_pass_canonicalize", graph_pass<Canonicalize>)
+   .def("_jit_pass_plan_memory", graph_pass<PlanMemory>)
+   .def("_jit_pass_constant_propagation", graph_pass<ConstantPropagation>)
+   .def("_jit_pass_prepack_weights", graph_pass<PrepackWeights>)
+   .def("_jit_pass_inline_constant_inputs", [](std::shared_ptr<tracer::TracingState>& state,
+                                               size_t first, const variable_list& values) {
+     InlineConstantInputs(state->graph, first, fmap(values, [](const autograd::Variable& v) {
+       return v.data();
+     }));
+   })
+   .def("_jit_pass_parallelize_branches", [](std::shared_ptr<tracer::TracingState>& state, int64_t min_cost) {
+     ParallelizeBranches(state->graph, min_cost);
+   })
    .def("_jit_pass_lint", graph_pass<LintGraph>)
    .def("_jit_run_cpp_tests", runJITCPPTests)
    .def("_jit_flatten", [](py::handle& obj) {
@@ -113,6 +128,38 @@ void initJITBindings(PyObject *module) {
           }
           return tuple;
         }
+      })
+      .def("run_inference", [](GraphExecutor& ge, py::args args) -> py::object {
+        auto inputs = createVariableTensorList(args);
+        std::vector<at::Tensor> tensors;
+        tensors.reserve(inputs.size());
+        for (auto & input : inputs) {
+          tensors.push_back(input.defined() ? autograd::as_variable_ref(input).data() : at::Tensor());
+        }
+        auto outputs = ge.runInference(std::move(tensors));
+        auto wrap = [](at::Tensor& output) {
+          return py::cast(autograd::make_variable(output, /*requires_grad=*/false));
+        };
+        if (outputs.size() == 0) {
+          return py::none();
+        } else if (outputs.size() == 1) {
+          return wrap(outputs[0]);
+        } else {
+          py::tuple tuple(outputs.size());
+          for(size_t i = 0; i < outputs.size(); i++) {
+            tuple[i] = wrap(outputs[i]);
+          }
+          return tuple;
+        }
+      })
+      .def("plan_cache_stats", [](GraphExecutor& ge) {
+        auto stats = ge.planCacheStats();
+        py::dict result;
+        result["hits"] = stats.hits;
+        result["misses"] = stats.misses;
+        result["evictions"] = stats.evictions;
+        result["size"] = stats.size;
+        return result;
       });
   initPythonIRBindings(module);
   initPythonTracerBindings(module);
@@ -45,9 +45,11 @@ _(prim, JumpNZ) /* debug */ \
 _(prim, JumpZ) /* debug */ \
 _(prim, Load) \
 _(prim, Loop) \
+_(prim, MemoryArena) \
 _(prim, Param) \
 _(prim, PackPadded) /* onnx */ \
 _(prim, PadPacked) /* onnx */ \
+_(prim, ParallelBranches) \
 _(prim, Placeholder) /* debug */ \
 _(prim, Print) \
 _(prim, PythonOp) \
@@ -109,6 +111,8 @@ _(onnx, Unsqueeze) \
 
 #define FORALL_ATTR_EXTRA_SYMBOLS(_) \
 _(attr, Subgraph) \
+_(attr, Subgraphs) \
+_(attr, arena_size) \
 _(attr, axes) \
 _(attr, axis) \
 _(attr, broadcast) \
@@ -118,6 +122,7 @@ _(attr, ends) \
 _(attr, inplace) \
 _(attr, input_as_shape) \
 _(attr, is_zero) \
+_(attr, memory_offsets) \
 _(attr, perm) \
 _(attr, sizes) \
 _(attr, starts) \
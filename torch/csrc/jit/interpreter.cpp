@@ -13,7 +13,13 @@
 #include "torch/csrc/jit/graph_executor.h"
 #include "torch/csrc/jit/ir.h"
 #include "torch/csrc/jit/tensor_conversions.h"
+#include "torch/csrc/utils/auto_gpu.h"
 
+#include <ATen/Parallel.h>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <typeinfo>
 
 #ifndef NO_PYTHON
@@ -629,6 +635,78 @@ Operation createEvalOperation(CppOp * op) {
   };
 }
 
+// Buffers for a prim::MemoryArena, see Note [Memory planning].
+// Every run gets a buffer of its own, which goes back to the pool when the
+// last tensor placed in it dies, so runs that overlap (on different threads,
+// or because a planned tensor is still alive) never share memory, and a
+// steady-state run doesn't need to allocate one.
+struct ArenaPool : std::enable_shared_from_this<ArenaPool> {
+  ArenaPool(int64_t size, int device)
+  : size(size), device(device) {}
+
+  at::Tensor acquire() {
+    at::Tensor buffer;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(!free_buffers.empty()) {
+        buffer = std::move(free_buffers.back());
+        free_buffers.pop_back();
+      }
+    }
+    AutoGPU guard(device);
+    auto & type = device < 0 ? at::CPU(at::kByte) : at::CUDA(at::kByte);
+    if(!buffer.defined())
+      buffer = type.tensor({size});
+    auto self = shared_from_this();
+    return type.tensorFromBlob(buffer.data_ptr(), {size}, [self, buffer](void*) {
+      std::lock_guard<std::mutex> lock(self->mutex);
+      self->free_buffers.push_back(buffer);
+    });
+  }
+
+private:
+  const int64_t size;
+  const int device;
+  std::mutex mutex;
+  std::vector<at::Tensor> free_buffers;
+};
+
+// A FusionGroup whose outputs were placed in an arena by PlanMemory.
+// The arena is its last input.
+Operation createPlannedFusionOperation(Node* node) {
+  auto fusion_fn = sharedFusionCompiler().getOrCompile(node);
+  auto num_inputs = node->inputs().size() - 1;
+  auto offsets = node->is(attr::memory_offsets);
+  std::vector<at::Type*> types;
+  std::vector<std::vector<int64_t>> sizes;
+  for(auto output : node->outputs()) {
+    auto type = output->type()->expect<TensorType>();
+    auto backend = type->device() < 0 ? at::kCPU : at::kCUDA;
+    types.push_back(&at::getType(backend, type->scalarType()));
+    sizes.push_back(type->sizes());
+  }
+  return [=](Stack & stack) {
+    autograd::profiler::RecordFunction record("FusionGroup");
+    at::Tensor arena = pop(stack);
+    AutoGPU guard(arena);
+    auto base = static_cast<char*>(arena.data_ptr());
+    std::vector<at::Tensor> toutputs;
+    toutputs.reserve(offsets.size());
+    for(size_t i = 0; i < offsets.size(); ++i) {
+      if(offsets[i] < 0) {
+        toutputs.push_back(types[i]->tensor());
+      } else {
+        // the deleter keeps the arena alive for as long as this output is
+        toutputs.push_back(types[i]->tensorFromBlob(base + offsets[i], sizes[i], [arena](void*) {}));
+      }
+    }
+    fusion_fn->launch_with_tensors(last(stack, num_inputs), toutputs);
+    drop(stack, num_inputs);
+    stack.insert(stack.end(), toutputs.begin(), toutputs.end());
+    return 0;
+  };
+}
+
 // Returns a function implementing functionality of a given node,
 // or nullptr if it's a no-op for autograd.
 Operation getOperation(jit::Node* node, bool values_are_variables) {
@@ -641,6 +719,11 @@ Operation getOperation(jit::Node* node, bool values_are_variables) {
       return createCppOperation(value);
     }
   IR_ELSEIF(FusionGroup)
+    if(value->hasAttribute(attr::memory_offsets)) {
+      // planned tensors are never wrapped in Variables
+      JIT_ASSERT(!values_are_variables);
+      return createPlannedFusionOperation(value);
+    }
     auto fusion_fn = sharedFusionCompiler().getOrCompile(value);
     auto num_inputs = value->inputs().size();
     return [fusion_fn, num_inputs](Stack & stack) {
@@ -666,6 +749,13 @@ Operation getOperation(jit::Node* node, bool values_are_variables) {
         return 0;
       };
     }
+  IR_ELSEIF(MemoryArena)
+    JIT_ASSERT(!values_are_variables);
+    auto pool = std::make_shared<ArenaPool>(value->i(attr::arena_size), value->i(attr::device));
+    return [pool](Stack & stack) {
+      stack.push_back(pool->acquire());
+      return 0;
+    };
   IR_ELSEIF(Undefined)
     return [](Stack & stack) {
       stack.push_back(at::Tensor());
@@ -716,6 +806,35 @@ Operation getOperation(jit::Node* node, bool values_are_variables) {
       return 0;
     };
 
+  // See Note [Parallel branches]
+  IR_ELSEIF(ParallelBranches)
+    std::vector<Code> branches;
+    std::vector<size_t> num_inputs;
+    for(auto subgraph : value->gs(attr::Subgraphs)) {
+      branches.emplace_back(subgraph, values_are_variables);
+      num_inputs.push_back(subgraph->inputs().size());
+    }
+    auto total_inputs = value->inputs().size();
+    return [=](Stack& stack) {
+      autograd::profiler::RecordFunction record("ParallelBranches");
+      std::vector<Stack> stacks(branches.size());
+      auto inputs = stack.end() - total_inputs;
+      for(size_t i = 0; i < branches.size(); ++i) {
+        stacks[i].assign(std::make_move_iterator(inputs), std::make_move_iterator(inputs + num_inputs[i]));
+        inputs += num_inputs[i];
+      }
+      drop(stack, total_inputs);
+      at::parallel_for(0, branches.size(), 1, [&](int64_t begin, int64_t end) {
+        for(int64_t i = begin; i < end; ++i) {
+          InterpreterState(branches[i]).runOneStage(stacks[i]);
+        }
+      });
+      for(auto & outputs : stacks) {
+        stack.insert(stack.end(), std::make_move_iterator(outputs.begin()), std::make_move_iterator(outputs.end()));
+      }
+      return 0;
+    };
+
 
   // Load x, y
   // loads values from registers onto the stack, the actual callback does
@@ -764,9 +883,19 @@ struct UseList {
   ListHandle<bool> free_flags;
 };
 
+// Instructions that only shuffle values between registers don't need the
+// stack. The interpreter runs them directly on the registers, see
+// Note [Register instructions].
+enum class RegisterOp : uint8_t {
+  None,    // load the inputs onto the stack, run callback, store the outputs
+  Move,    // assign the inputs to the outputs
+  Release, // free the inputs with free flags (Drop)
+};
+
 // one instruction plus meta-data
 struct Instruction {
-  Operation callback;
+  Operation callback; // empty if the instruction only moves values between the stack and registers
+  RegisterOp register_op = RegisterOp::None;
   UseList inputs;
   ListHandle<int> outputs;
   Symbol debug_name; // used in dump to understand the generated code
@@ -778,9 +907,26 @@ int relativeJump(int from_inst, int to_inst) {
   return to_inst - (from_inst + 1);
 }
 
+// Note [Register instructions]
+// Every value already has a fixed register assigned when the Code is
+// created. Operations still take their inputs from, and leave their outputs
+// on, the stack, but the instructions that exist only to move values around
+// don't need it: Assign (control flow joins and loop-carried values) is
+// copied from register to register, Drop just releases its registers, and
+// Load/Store, which move stage inputs and outputs between the stack and
+// registers, don't call a (no-op) Operation. Setting
+// PYTORCH_JIT_STACK_INTERPRETER=1 runs everything through the stack instead,
+// which is useful to compare against.
+static bool useRegisterInstructions() {
+  const char * env = getenv("PYTORCH_JIT_STACK_INTERPRETER");
+  return !(env && atoi(env) != 0);
+}
+
 struct CodeImpl {
   CodeImpl(std::shared_ptr<Graph>& graph_, bool values_are_variables)
-      : values_are_variables(values_are_variables), preprocess(*graph_) {
+      : values_are_variables(values_are_variables)
+      , register_instructions(useRegisterInstructions())
+      , preprocess(*graph_) {
     graph = preprocess.graph;
     //std::cout << "into code graph:\n" << *graph << "\n";
     insertNodesFromBlock(graph->block());
@@ -908,6 +1054,13 @@ struct CodeImpl {
   size_t insertInstruction(Node * n) {
     auto inst = insertInstruction(n->kind(), n->getSourceLocation(), n->inputs(), moveFlags(n) , n->outputs());
     instructions[inst].callback = getOperation(n, values_are_variables);
+    if(register_instructions) {
+      if(n->kind() == prim::Load || n->kind() == prim::Store) {
+        instructions[inst].callback = nullptr;
+      } else if(n->kind() == prim::Drop) {
+        instructions[inst].register_op = RegisterOp::Release;
+      }
+    }
     return inst;
   }
   size_t insertInstruction(Symbol sym,
@@ -946,8 +1099,22 @@ struct CodeImpl {
     // We don't need to manipulate the stack in any way, because all inputs are also outputs,
     // and the interpreter will take care of putting them in correct places.
     instructions[inst].callback = [](Stack& stack) { return 0; };
+    if(register_instructions && canAssignInOrder(instructions[inst]))
+      instructions[inst].register_op = RegisterOp::Move;
     return inst;
   }
+  // Assign has parallel semantics, e.g. for swapped loop-carried values, so
+  // it can only be done one register at a time if no output overwrites an
+  // input that is read after it.
+  bool canAssignInOrder(const Instruction & inst) const {
+    for(int i = 0; i < inst.outputs.size; i++) {
+      for(int j = i + 1; j < inst.inputs.values.size; j++) {
+        if(get(inst.outputs, i) == get(inst.inputs.values, j))
+          return false;
+      }
+    }
+    return true;
+  }
 
   // helpers to build/access RegList objects
   int get(const ListHandle<int> & list, int i)  const {
@@ -1034,6 +1201,7 @@ struct CodeImpl {
   // keep this around.
   std::shared_ptr<Graph> graph;
   bool values_are_variables;
+  bool register_instructions;
   PreprocessGraph preprocess;
 
   std::unordered_map<size_t, int> unique_to_reg; // map from unique of nodes to register in register table
@@ -1070,12 +1238,24 @@ struct InterpreterStateImpl {
         // std::cout << "\n";
         try {
           auto & inst = instructions[pc];
-          loadTensorsFromRegisters(inst.inputs, stack);
-          size_t new_pc = pc + 1 + inst.callback(stack);
-          for(int i = inst.outputs.size - 1; i >= 0; i--) {
-            int reg = get(inst.outputs,i);
-            registers[reg] = pop(stack);
-            // std::cout << "pop reg[" << reg << "];\n" << registers[reg].pImpl << "\n";
+          size_t new_pc = pc + 1;
+          switch(inst.register_op) {
+            case RegisterOp::Move:
+              assignRegisters(inst);
+              break;
+            case RegisterOp::Release:
+              releaseRegisters(inst.inputs);
+              break;
+            case RegisterOp::None:
+              loadTensorsFromRegisters(inst.inputs, stack);
+              if(inst.callback)
+                new_pc += inst.callback(stack);
+              for(int i = inst.outputs.size - 1; i >= 0; i--) {
+                int reg = get(inst.outputs,i);
+                registers[reg] = pop(stack);
+                // std::cout << "pop reg[" << reg << "];\n" << registers[reg].pImpl << "\n";
+              }
+              break;
           }
           pc = new_pc;
         } catch(std::exception & e) {
@@ -1109,6 +1289,28 @@ struct InterpreterStateImpl {
 
     }
   }
+  void assignRegisters(const Instruction & inst) {
+    for(int i = 0; i < inst.outputs.size; i++) {
+      int from = get(inst.inputs.values, i);
+      int to = get(inst.outputs, i);
+      if(from == to)
+        continue;
+      if(get(inst.inputs.free_flags, i)) {
+        // moving into a temporary empties the input register, and the old
+        // value of the output is released with the temporary
+        at::Tensor t = std::move(registers[from]);
+        registers[to] = std::move(t);
+      } else {
+        registers[to] = registers[from];
+      }
+    }
+  }
+  void releaseRegisters(const UseList & uses) {
+    for(int i = 0; i < uses.values.size; i++) {
+      if(get(uses.free_flags,i))
+        registers[get(uses.values,i)] = at::Tensor();
+    }
+  }
   size_t current_stage = 0;
   size_t current_pc = 0;
   std::shared_ptr<CodeImpl> function; // keep function alive
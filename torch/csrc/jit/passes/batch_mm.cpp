@@ -6,7 +6,10 @@
 
 #include <ATen/ATen.h>
 #include <algorithm>
+#include <map>
+#include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace torch { namespace jit {
 
@@ -60,6 +63,30 @@ namespace torch { namespace jit {
 // (I don't think it's beneficial to recompute, unless the subtree is super small,
 // but let's not get into such details).
 
+// Note [Independent matmuls]
+// Apart from trees, we batch mm ops that don't depend on each other, and share
+// an operand or have operands of the same sizes. Such patterns show up in the
+// forward of RNNs (projections of the same input for each gate) and of
+// attention (projections for each head).
+//
+// MMs that share their lhs are replaced with a single mm of the lhs with the
+// rhs operands concatenated along the columns, and MMs that share their rhs
+// with a single mm of the lhs operands concatenated along the rows. The results
+// are then narrowed back out of the wide output:
+//
+// +------+ +----+----+   +----+----+
+// |      | |    |    |   |    |    |
+// |  L   | | R1 | R2 | = | O1 | O2 |
+// |      | |    |    |   |    |    |
+// +------+ +----+----+   +----+----+
+//
+// MMs whose operands only have matching sizes are stacked into a single bmm,
+// whose results are selected out of the batch.
+//
+// A group of MMs is replaced right before its first mm, so we only add MMs to
+// a group if all their operands are defined by then. This also guarantees that
+// none of them depends on the result of another.
+
 // The algorithm we're using is simple. We're iterating through the graph in the
 // topological order and labeling nodes with TreeTokens. Then, we look for roots of
 // the trees we formed and fuse them.
@@ -139,6 +166,168 @@ struct TreeToken {
   }
 };
 
+using Position = std::unordered_map<Node*, std::size_t>;
+
+static bool isDefinedBefore(Value *v, Node *n, const Position& position) {
+  auto it = position.find(v->node());
+  // Values from outside of the block are defined before all of its nodes
+  return it == position.end() || it->second < position.at(n);
+}
+
+static bool hasTensorTypes(Node *mm) {
+  return mm->inputs()[0]->type()->cast<TensorType>() &&
+         mm->inputs()[1]->type()->cast<TensorType>() &&
+         mm->output()->type()->cast<TensorType>();
+}
+
+// Groups the MMs of each stage by key, in the order of the block.
+// See Note [Independent matmuls]
+template<typename Key, typename KeyFn>
+static std::vector<std::vector<Node*>> groupMatMuls(const std::vector<Node*>& matmuls,
+                                                    const Position& position,
+                                                    KeyFn key_fn) {
+  std::map<std::pair<std::size_t, Key>, std::vector<Node*>> groups;
+  for (auto mm : matmuls) {
+    auto & group = groups[std::make_pair(mm->stage(), key_fn(mm))];
+    if (!group.empty() &&
+        (!isDefinedBefore(mm->inputs()[0], group.front(), position) ||
+         !isDefinedBefore(mm->inputs()[1], group.front(), position)))
+      continue;
+    group.push_back(mm);
+  }
+  std::vector<std::vector<Node*>> result;
+  for (auto & item : groups) {
+    if (item.second.size() >= min_fusion_size)
+      result.push_back(std::move(item.second));
+  }
+  return result;
+}
+
+// Replaces MMs which share the operand on side 'shared' with a single mm.
+static void batchSharedOperand(Graph *graph, const std::vector<Node*>& matmuls, int shared) {
+  Node *first = matmuls.front();
+  auto stage_guard = graph->setStageTemporary(first->stage());
+  int other = 1 - shared;
+  // Concat the rhs operands along the columns, or the lhs ones along the rows
+  int cat_dim = shared == 0 ? 1 : 0;
+  auto other_type = first->inputs()[other]->type()->expect<TensorType>();
+  auto output_type = first->output()->type()->expect<TensorType>();
+
+  std::vector<int64_t> cat_sizes = other_type->sizes();
+  cat_sizes[cat_dim] = 0;
+  for (auto mm : matmuls) {
+    cat_sizes[cat_dim] += mm->inputs()[other]->type()->expect<TensorType>()->sizes().at(cat_dim);
+  }
+  auto inputs = fmap(matmuls, [=](Node *mm) { return mm->inputs()[other]; });
+  Node *cat = graph->create(aten::cat, inputs)->i_(attr::dim, cat_dim);
+  cat->output()->setType(other_type->withSizes(cat_sizes));
+  cat->insertBefore(first);
+
+  std::vector<int64_t> batch_sizes = output_type->sizes();
+  batch_sizes[cat_dim] = cat_sizes[cat_dim];
+  Node *batch_mm = shared == 0
+    ? graph->create(aten::mm, {first->inputs()[0], cat->output()})
+    : graph->create(aten::mm, {cat->output(), first->inputs()[1]});
+  batch_mm->output()->setType(output_type->withSizes(batch_sizes));
+  batch_mm->insertBefore(first);
+  auto batch_type = batch_mm->output()->type()->expect<TensorType>();
+
+  int64_t start = 0;
+  for (auto mm : matmuls) {
+    auto sizes = mm->output()->type()->expect<TensorType>()->sizes();
+    Node *narrow = graph->create(aten::narrow, {batch_mm->output()})
+                        ->i_(attr::dim, cat_dim)
+                        ->i_(attr::start, start)
+                        ->i_(attr::length, sizes[cat_dim]);
+    narrow->output()->setType(batch_type->withSizesStrides(sizes, batch_type->strides()));
+    narrow->insertBefore(first);
+    mm->output()->replaceAllUsesWith(narrow->output());
+    start += sizes[cat_dim];
+  }
+}
+
+// Replaces MMs with operands of the same sizes with a single bmm.
+static void batchSameSizes(Graph *graph, const std::vector<Node*>& matmuls) {
+  Node *first = matmuls.front();
+  auto stage_guard = graph->setStageTemporary(first->stage());
+  auto stack = [&](int inputs_off) {
+    auto type = first->inputs()[inputs_off]->type()->expect<TensorType>();
+    auto inputs = fmap(matmuls, [=](Node *mm) { return mm->inputs()[inputs_off]; });
+    std::vector<int64_t> sizes = type->sizes();
+    sizes.insert(sizes.begin(), matmuls.size());
+    Node *n = graph->create(aten::stack, inputs)->i_(attr::dim, 0);
+    n->output()->setType(type->withSizes(sizes));
+    n->insertBefore(first);
+    return n->output();
+  };
+  auto lhs_batch = stack(0);
+  auto rhs_batch = stack(1);
+
+  auto output_type = first->output()->type()->expect<TensorType>();
+  std::vector<int64_t> batch_sizes = output_type->sizes();
+  batch_sizes.insert(batch_sizes.begin(), matmuls.size());
+  Node *bmm = graph->create(aten::bmm, {lhs_batch, rhs_batch});
+  bmm->output()->setType(output_type->withSizes(batch_sizes));
+  bmm->insertBefore(first);
+  auto batch_type = bmm->output()->type()->expect<TensorType>();
+  std::vector<int64_t> strides(batch_type->strides().begin() + 1,
+                               batch_type->strides().end());
+
+  for (std::size_t i = 0; i < matmuls.size(); ++i) {
+    Node *select = graph->create(aten::select, {bmm->output()})
+                        ->i_(attr::dim, 0)
+                        ->i_(attr::index, i);
+    select->output()->setType(batch_type->withSizesStrides(output_type->sizes(), strides));
+    select->insertBefore(first);
+    matmuls[i]->output()->replaceAllUsesWith(select->output());
+  }
+}
+
+static void BatchIndependentMMs(Block* block) {
+  auto graph = block->owningGraph();
+  Position position;
+  std::vector<Node*> matmuls;
+  for (auto node : block->nodes()) {
+    std::size_t index = position.size();
+    position[node] = index;
+    if (node->kind() == aten::mm && node->inputs().size() == 2 && hasTensorTypes(node))
+      matmuls.push_back(node);
+  }
+
+  // Each mm is batched at most once, so drop the ones batched by earlier steps
+  std::unordered_set<Node*> batched;
+  auto remaining = [&]() {
+    std::vector<Node*> result;
+    for (auto mm : matmuls) {
+      if (batched.count(mm) == 0)
+        result.push_back(mm);
+    }
+    return result;
+  };
+
+  for (int shared = 0; shared < 2; ++shared) {
+    auto groups = groupMatMuls<Value*>(remaining(), position, [=](Node *mm) {
+      return mm->inputs()[shared];
+    });
+    for (auto & group : groups) {
+      batchSharedOperand(graph, group, shared);
+      batched.insert(group.begin(), group.end());
+    }
+  }
+
+  using SizesKey = std::tuple<std::vector<int64_t>, std::vector<int64_t>, at::ScalarType, int>;
+  auto groups = groupMatMuls<SizesKey>(remaining(), position, [](Node *mm) {
+    auto lhs_type = mm->inputs()[0]->type()->expect<TensorType>();
+    auto rhs_type = mm->inputs()[1]->type()->expect<TensorType>();
+    return SizesKey(lhs_type->sizes(), rhs_type->sizes(),
+                    lhs_type->scalarType(), lhs_type->device());
+  });
+  for (auto & group : groups) {
+    batchSameSizes(graph, group);
+  }
+  EliminateDeadCode(block);
+}
+
 void BatchMMBlock(Block* block) {
   enum class Side { LHS, RHS };
   auto graph = block->owningGraph();
@@ -203,6 +392,7 @@ void BatchMMBlock(Block* block) {
     // NB: don't bother with cleaning up after yourself. We'll use DCE for that.
   }
   EliminateDeadCode(block);
+  BatchIndependentMMs(block);
 }
 
 void BatchMM(std::shared_ptr<Graph>& graph) {
@@ -0,0 +1,181 @@
+#include "torch/csrc/jit/passes/constant_propagation.h"
+
+#include "torch/csrc/jit/generated/aten_dispatch.h"
+#include "torch/csrc/jit/interned_strings.h"
+#include "torch/csrc/jit/passes/dead_code_elimination.h"
+
+#include <ATen/ATen.h>
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+
+namespace torch { namespace jit {
+
+// Constant propagation runs nodes through the same ATen dispatch as the
+// interpreter, on the tensors held by prim::Constant nodes. Traces record
+// the transposes, casts and views of parameters, so once the parameters
+// are constants (see InlineConstantInputs) these disappear from the graph,
+// leaving the weights in the layout their users read them in.
+
+namespace {
+
+// Ops which don't compute the same outputs from the same inputs
+const std::unordered_set<std::string> nondeterministic_ops = {
+  "bernoulli", "multinomial", "normal", "poisson", "rand", "rand_like",
+  "randint", "randint_like", "randn", "randn_like", "randperm", "rrelu",
+  "rrelu_with_noise", "_standard_gamma",
+};
+
+bool isConstant(Value *v) {
+  return v->node()->kind() == prim::Constant;
+}
+
+bool isFoldable(Node *n) {
+  if (!n->kind().is_aten() || !n->blocks().empty())
+    return false;
+  std::string name = n->kind().toUnqualString();
+  // In-place ops would modify the constant
+  if (name.empty() || name.back() == '_' || nondeterministic_ops.count(name))
+    return false;
+  for (auto input : n->inputs()) {
+    if (!isConstant(input))
+      return false;
+  }
+  return hasTensorOp(n);
+}
+
+void ConstantPropagation(Block *block) {
+  auto graph = block->owningGraph();
+  for (auto it = block->nodes().begin(); it != block->nodes().end(); ++it) {
+    auto n = *it;
+    for (auto sub_block : n->blocks()) {
+      ConstantPropagation(sub_block);
+    }
+    if (!isFoldable(n))
+      continue;
+
+    Stack stack;
+    for (auto input : n->inputs()) {
+      stack.push_back(input->node()->t(attr::value));
+    }
+    try {
+      getTensorOp(n).op(stack);
+    } catch (const std::exception&) {
+      // Leave the node to fail when the graph is run
+      continue;
+    }
+    JIT_ASSERT(stack.size() == n->outputs().size());
+
+    auto stage_guard = graph->setStageTemporary(n->stage());
+    for (size_t i = 0; i < stack.size(); ++i) {
+      if (!stack[i].defined())
+        continue;
+      Node *constant = graph->createConstant(stack[i]);
+      constant->insertBefore(n);
+      constant->output()->copyMetadata(n->outputs()[i]);
+      n->outputs()[i]->replaceAllUsesWith(constant->output());
+    }
+  }
+}
+
+bool isCPUFloat(Value *v, size_t dim) {
+  auto type = v->type()->cast<TensorType>();
+  return type && type->device() == -1 && type->scalarType() == at::kFloat &&
+         type->sizes().size() == dim;
+}
+
+bool isOne(Node *n, Symbol name) {
+  return n->hasAttribute(name) && n->kindOf(name) == AttributeKind::t &&
+         at::Scalar(n->t(name)).toDouble() == 1;
+}
+
+// addmm(bias, input, weight.t()) == mkldnn_linear(input, weight, bias)
+bool prepackLinear(Node *n) {
+  if (n->kind() != aten::addmm || n->inputs().size() != 3 ||
+      !isOne(n, attr::alpha) || !isOne(n, attr::beta))
+    return false;
+  Value *bias = n->inputs()[0];
+  Value *input = n->inputs()[1];
+  Value *weight_t = n->inputs()[2];
+  if (!isConstant(weight_t) || !isCPUFloat(input, 2) ||
+      !isCPUFloat(weight_t, 2) || !isCPUFloat(bias, 1))
+    return false;
+
+  auto graph = n->owningGraph();
+  auto stage_guard = graph->setStageTemporary(n->stage());
+  auto weight = weight_t->node()->t(attr::value).t().contiguous();
+  Node *weight_node = graph->createConstant(weight)->insertBefore(n);
+  weight_node->output()->inferTypeFrom(weight);
+  Node *linear = graph->create(aten::mkldnn_linear, {input, weight_node->output(), bias})
+                      ->insertBefore(n);
+  linear->output()->copyMetadata(n->output());
+  n->output()->replaceAllUsesWith(linear->output());
+  return true;
+}
+
+bool prepackConvolution(Node *n) {
+  if (n->kind() != aten::_convolution || n->inputs().size() != 3 ||
+      !n->hasAttribute(attr::transposed))
+    return false;
+  Value *input = n->inputs()[0];
+  Value *weight = n->inputs()[1];
+  Value *bias = n->inputs()[2];
+  auto dilation = n->is(attr::dilation);
+  bool dilated = std::any_of(dilation.begin(), dilation.end(),
+                             [](int64_t d) { return d != 1; });
+  // The same cases as ConvParams::use_mkldnn
+  if (n->i(attr::transposed) || n->i(attr::groups) != 1 || dilated ||
+      !isConstant(weight) || !isCPUFloat(input, 4))
+    return false;
+
+  auto graph = n->owningGraph();
+  auto stage_guard = graph->setStageTemporary(n->stage());
+  Node *conv = graph->create(aten::mkldnn_convolution, {input, weight, bias})
+                    ->is_(attr::padding, std::vector<int64_t>(n->is(attr::padding)))
+                    ->is_(attr::stride, std::vector<int64_t>(n->is(attr::stride)))
+                    ->is_(attr::dilation, std::move(dilation))
+                    ->insertBefore(n);
+  conv->output()->copyMetadata(n->output());
+  n->output()->replaceAllUsesWith(conv->output());
+  return true;
+}
+
+void PrepackWeights(Block *block) {
+  for (auto n : block->nodes()) {
+    for (auto sub_block : n->blocks()) {
+      PrepackWeights(sub_block);
+    }
+    prepackLinear(n) || prepackConvolution(n);
+  }
+}
+
+} // anonymous namespace
+
+void InlineConstantInputs(std::shared_ptr<Graph>& graph, size_t first,
+                          at::ArrayRef<at::Tensor> values) {
+  JIT_ASSERT(first + values.size() <= graph->inputs().size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    Value *input = graph->inputs()[first + i];
+    auto stage_guard = graph->setStageTemporary(input->stage());
+    Node *constant = graph->block()->prependNode(graph->createConstant(values[i]));
+    constant->output()->setType(input->type());
+    input->replaceAllUsesWith(constant->output());
+  }
+  for (size_t i = values.size(); i > 0; --i) {
+    graph->eraseInput(first + i - 1);
+  }
+}
+
+void ConstantPropagation(std::shared_ptr<Graph>& graph) {
+  ConstantPropagation(graph->block());
+  EliminateDeadCode(graph);
+}
+
+void PrepackWeights(std::shared_ptr<Graph>& graph) {
+  if (!at::hasMKLDNN())
+    return;
+  PrepackWeights(graph->block());
+  EliminateDeadCode(graph);
+}
+
+}}
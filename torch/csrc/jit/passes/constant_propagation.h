@@ -0,0 +1,20 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+namespace torch { namespace jit {
+
+// Replaces the graph inputs starting at 'first' with constants holding
+// 'values', e.g. to treat the parameters of a model as constants for inference.
+void InlineConstantInputs(std::shared_ptr<Graph>& graph, size_t first,
+                          at::ArrayRef<at::Tensor> values);
+
+// Runs the nodes whose inputs are all constants, and replaces their outputs
+// with constants.
+void ConstantPropagation(std::shared_ptr<Graph>& graph);
+
+// Replaces addmm and convolution nodes whose weights are constants with
+// the MKL-DNN kernels, when the CPU backend has them.
+void PrepackWeights(std::shared_ptr<Graph>& graph);
+
+}}
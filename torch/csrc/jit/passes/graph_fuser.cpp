@@ -1,5 +1,6 @@
 #include "torch/csrc/jit/passes/graph_fuser.h"
 #include "torch/csrc/jit/fusion_compiler.h"
+#include <algorithm>
 #include <unordered_map>
 
 namespace torch { namespace jit {
@@ -77,6 +78,37 @@ bool isSimpleMap(Node *node) {
   return false;
 }
 
+// Reductions over the last dimension, which make the group a row kernel
+// (see emitRowBody in fusion_compiler.cpp). A reduction to a scalar has no
+// rows, so 1-d inputs need keepdim.
+bool isTrailingReduction(Node *node) {
+  if(node->kind() != aten::sum && node->kind() != aten::mean)
+    return false;
+  if(node->inputs().size() != 1 ||
+     !node->hasAttribute(attr::dim) || node->kindOf(attr::dim) != AttributeKind::i ||
+     !node->hasAttribute(attr::keepdim) || node->kindOf(attr::keepdim) != AttributeKind::i)
+    return false;
+  auto tt = node->input()->type()->cast<TensorType>();
+  if(!tt)
+    return false;
+  int64_t ndim = tt->sizes().size();
+  int64_t dim = node->i(attr::dim);
+  return ndim > 0 && (dim == ndim - 1 || dim == -1) && (node->i(attr::keepdim) || ndim > 1);
+}
+
+// Broadcasts of the result of a keepdim reduction back along the last dimension
+bool isRowBroadcast(Node *node) {
+  if(node->kind() != aten::expand || !node->hasAttribute(attr::size))
+    return false;
+  auto tt = node->input()->type()->cast<TensorType>();
+  if(!tt)
+    return false;
+  auto & sizes = tt->sizes();
+  auto expanded = node->is(attr::size);
+  return sizes.size() > 0 && sizes.size() == expanded.size() && sizes.back() == 1 &&
+    std::equal(sizes.begin(), sizes.end() - 1, expanded.begin());
+}
+
 struct GraphFuser {
   Block * block;
 
@@ -121,7 +153,49 @@ struct GraphFuser {
   bool isFusable(Node * node) {
     if (node->owningBlock() != block) return false;
     if (node->kind() == prim::FusionGroup) return true;
-    return isSimpleMap(node) && allFloatIO(node);
+    return (isSimpleMap(node) || isTrailingReduction(node) || isRowBroadcast(node)) &&
+      allFloatIO(node);
+  }
+
+  // The map size of a node that reduces or broadcasts along the last
+  // dimension, or of a fusion group containing one. Row kernels handle a
+  // single map size, so every such node in a group has to agree on it.
+  // Empty for other nodes, which take the size of the group they join.
+  std::vector<int64_t> rowMapSize(Node * node) {
+    if(isTrailingReduction(node))
+      return node->input()->type()->expect<TensorType>()->sizes();
+    if(isRowBroadcast(node))
+      return node->is(attr::size);
+    if(node->kind() == prim::FusionGroup) {
+      for(auto n : getSubgraph(node).nodes()) {
+        auto sizes = rowMapSize(n);
+        if(!sizes.empty())
+          return sizes;
+      }
+    }
+    return {};
+  }
+
+  bool hasConcat(Node * node) {
+    if(node->kind() == prim::FusionGroup) {
+      for(auto n : getSubgraph(node).nodes()) {
+        if(n->kind() == aten::cat)
+          return true;
+      }
+    }
+    return node->kind() == aten::cat;
+  }
+
+  // can the two end up in the same kernel? Row kernels have a single map
+  // size and don't support concatenated outputs
+  bool haveCompatibleMaps(Node * consumer, Node * producer) {
+    auto consumer_size = rowMapSize(consumer);
+    auto producer_size = rowMapSize(producer);
+    if(consumer_size.empty() && producer_size.empty())
+      return true;
+    if(hasConcat(consumer) || hasConcat(producer))
+      return false;
+    return consumer_size.empty() || producer_size.empty() || consumer_size == producer_size;
   }
 
   bool allOutputsHaveSameSize(Node * node) {
@@ -189,6 +263,7 @@ struct GraphFuser {
     // but this requires better handling of merging fusion groups so it is not done now
     int consumer_device = getDevice(consumer);
     return isFusable(producer->node()) &&
+      haveCompatibleMaps(consumer, producer->node()) &&
       allUsersAreThisConsumerOrOccurAfterIt(consumer, producer) &&
       consumer_device == getDevice(producer->node()) &&
       (consumer_device != kCPUDevice || sharedFusionCompiler().canCompileOnCPU());
@@ -377,6 +452,9 @@ struct GraphFuser {
     Value * producer_for_chunk = chunk->input();
     if (!isFusable(producer_for_chunk->node()) || !allUsersAreThisConsumer(chunk,producer_for_chunk))
       return false;
+    // reductions and broadcasts don't commute with chunk
+    if (!rowMapSize(producer_for_chunk->node()).empty())
+      return false;
     // and all uses of the chunk are in this consumer
     for (auto s : chunk->outputs()) {
       for (auto u : s->uses()) {
@@ -1,5 +1,10 @@
 #include "torch/csrc/jit/passes/inplace_check.h"
 
+#include "torch/csrc/jit/generated/aten_dispatch.h"
+
+#include <string>
+#include <unordered_set>
+
 namespace torch { namespace jit {
 
 void CheckInplace(Block * block) {
@@ -18,4 +23,86 @@ void CheckInplace(std::shared_ptr<Graph>& graph) {
   CheckInplace(graph->block());
 }
 
+namespace {
+
+// Ops with an in-place version that writes the result into their first input.
+// The interpreter can only run the in-place versions listed in
+// inplace_reuse_ops in tools/jit/gen_jit_dispatch.py.
+const std::unordered_set<std::string> reusable_ops = {
+  "add", "div", "exp", "mul", "neg", "relu", "sigmoid", "sub", "tanh",
+  "threshold",
+};
+
+// Ops whose outputs never alias their inputs or any other value.
+const std::unordered_set<std::string> allocating_ops = {
+  "_convolution", "addmm", "bmm", "mkldnn_convolution", "mkldnn_linear", "mm",
+};
+
+bool ownsStorage(Value *v) {
+  Node *n = v->node();
+  if (!n->kind().is_aten())
+    return false;
+  std::string name = n->kind().toUnqualString();
+  // the output of an in-place op is its first input, so it owns the storage
+  // if that input did
+  if (!name.empty() && name.back() == '_') {
+    name.pop_back();
+    return reusable_ops.count(name) > 0 && ownsStorage(n->inputs()[0]);
+  }
+  return reusable_ops.count(name) > 0 || allocating_ops.count(name) > 0;
+}
+
+bool sameType(Value *a, Value *b) {
+  auto a_type = a->type()->cast<TensorType>();
+  auto b_type = b->type()->cast<TensorType>();
+  return a_type && b_type && a_type->scalarType() == b_type->scalarType() &&
+         a_type->device() == b_type->device() && a_type->sizes() == b_type->sizes();
+}
+
+bool isGraphOutput(Value *v) {
+  for (auto output : v->owningGraph()->outputs()) {
+    if (output == v)
+      return true;
+  }
+  return false;
+}
+
+void ReuseInplace(Block *block) {
+  auto graph = block->owningGraph();
+  for (auto it = block->nodes().begin(); it != block->nodes().end(); ++it) {
+    auto n = *it;
+    for (auto sub_block : n->blocks()) {
+      ReuseInplace(sub_block);
+    }
+    if (!n->kind().is_aten() || n->inputs().empty() || n->outputs().size() != 1 ||
+        !reusable_ops.count(n->kind().toUnqualString()))
+      continue;
+    Value *self = n->inputs()[0];
+    // the input must be dead after this node, and not visible outside of the
+    // graph, so that overwriting it can't be observed
+    if (self->uses().size() != 1 || self->node()->owningBlock() != block ||
+        isGraphOutput(self) || !ownsStorage(self) || !sameType(self, n->output()))
+      continue;
+
+    auto stage_guard = graph->setStageTemporary(n->stage());
+    Node *inplace = graph->create(Symbol::aten(std::string(n->kind().toUnqualString()) + "_"),
+                                  n->inputs());
+    inplace->copyAttributes(*n);
+    if (!hasTensorOp(inplace)) {
+      inplace->destroy();
+      continue;
+    }
+    inplace->insertBefore(n);
+    inplace->output()->copyMetadata(n->output());
+    n->output()->replaceAllUsesWith(inplace->output());
+    it.destroyCurrent();
+  }
+}
+
+} // anonymous namespace
+
+void ReuseInplace(std::shared_ptr<Graph>& graph) {
+  ReuseInplace(graph->block());
+}
+
 }} // namespace torch::jit
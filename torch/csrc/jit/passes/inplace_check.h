@@ -6,4 +6,9 @@ namespace torch { namespace jit {
 
 void CheckInplace(std::shared_ptr<Graph>& graph);
 
+// Replaces out-of-place ops with their in-place versions where the input
+// they would overwrite is an intermediate that has no other uses.
+// Only valid for graphs run without autograd, after CheckInplace.
+void ReuseInplace(std::shared_ptr<Graph>& graph);
+
 }}
@@ -0,0 +1,215 @@
+#include "torch/csrc/jit/passes/memory_planning.h"
+
+#include "torch/csrc/jit/interned_strings.h"
+
+#include <ATen/ATen.h>
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace torch { namespace jit {
+
+// Note [Memory planning]
+// ~~~~~~~~~~~~~~~~~~~~~~
+// Once a graph is specialized to its input shapes, the size of every
+// intermediate is known before it runs, so instead of asking the allocator
+// for each of them we can compute offsets for them in one buffer, the way
+// caffe2's memonger shares blobs in a NetDef.
+//
+// Only FusionGroup outputs are planned, because they are the only tensors
+// whose allocation the interpreter controls (ATen ops allocate their own
+// outputs). The pass:
+//
+//   1. numbers the top-level nodes, and computes for every value the last
+//      position at which it, or anything that may alias it, is used
+//   2. gives up on values that escape: graph outputs, values that may alias
+//      a graph output, values seen by Python/C++ ops that might retain them,
+//      and values used inside of nested blocks
+//   3. assigns offsets greedily, largest value first, at the lowest offset
+//      that doesn't overlap any value with an intersecting lifetime
+//   4. adds a prim::MemoryArena node per device, and passes the arena to
+//      every planned FusionGroup as an extra last input, with the offsets of
+//      its outputs in attr::memory_offsets (-1 for outputs that aren't planned)
+//
+// A value's lifetime includes the node that produces it and the node that
+// uses it last, so the inputs and outputs of a FusionGroup never share
+// memory. The interpreter hands out a separate buffer to every run that is in
+// flight, and recycles it once the last tensor placed in it dies, so a
+// steady-state run doesn't call into the tensor allocator for planned values.
+
+namespace {
+
+constexpr size_t kAlignment = 64;
+
+size_t alignUp(size_t n) {
+  return (n + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Ops whose outputs never share memory with their inputs. The outputs of
+// anything else are treated as aliases of its inputs.
+std::unordered_set<NodeKind> fresh_outputs = {
+  prim::FusionGroup,
+  aten::add,
+  aten::addmm,
+  aten::baddbmm,
+  aten::bmm,
+  aten::cat,
+  aten::div,
+  aten::exp,
+  aten::log,
+  aten::mm,
+  aten::mul,
+  aten::neg,
+  aten::relu,
+  aten::sigmoid,
+  aten::sub,
+  aten::tanh,
+};
+
+// Ops that may keep references to their inputs after they return.
+std::unordered_set<NodeKind> retains_inputs = {
+  prim::CppOp,
+  prim::Eval,
+  prim::PythonOp,
+};
+
+struct Lifetime {
+  size_t first;
+  size_t last;
+  bool escapes;
+};
+
+struct Candidate {
+  Value * value;
+  size_t size;
+  Lifetime lifetime;
+  size_t offset;
+};
+
+bool overlaps(const Lifetime & a, const Lifetime & b) {
+  return a.first <= b.last && b.first <= a.last;
+}
+
+size_t sizeInBytes(const TensorType & type) {
+  int64_t numel = 1;
+  for(auto s : type.sizes())
+    numel *= s;
+  return numel * at::getType(at::kCPU, type.scalarType()).elementSizeInBytes();
+}
+
+// Returns the total size of the arena
+size_t assignOffsets(std::vector<Candidate> & candidates) {
+  std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate & a, const Candidate & b) {
+    return a.size > b.size;
+  });
+  size_t total = 0;
+  std::vector<const Candidate*> placed;
+  for(auto & c : candidates) {
+    // regions taken by values that are live at the same time, sorted by offset
+    std::vector<std::pair<size_t, size_t>> taken;
+    for(auto p : placed) {
+      if(overlaps(p->lifetime, c.lifetime))
+        taken.emplace_back(p->offset, p->offset + alignUp(p->size));
+    }
+    std::sort(taken.begin(), taken.end());
+    size_t offset = 0;
+    for(auto & region : taken) {
+      if(offset + c.size <= region.first)
+        break;
+      offset = std::max(offset, region.second);
+    }
+    c.offset = offset;
+    total = std::max(total, offset + alignUp(c.size));
+    placed.push_back(&c);
+  }
+  return total;
+}
+
+} // anonymous namespace
+
+void PlanMemory(std::shared_ptr<Graph>& graph) {
+  auto block = graph->block();
+  std::unordered_map<Node*, size_t> position;
+  std::vector<Node*> nodes;
+  for(auto node : block->nodes()) {
+    position[node] = nodes.size();
+    nodes.push_back(node);
+  }
+
+  // Walk backwards, so that the lifetimes of the aliases a node produces are
+  // known by the time we get to its inputs.
+  std::unordered_map<Value*, Lifetime> lifetimes;
+  for(auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+    Node * node = *it;
+    for(auto output : node->outputs()) {
+      Lifetime lifetime {position[node], position[node], false};
+      for(auto & use : output->uses()) {
+        Node * user = use.user;
+        if(user->owningBlock() != block || user == block->return_node() ||
+           retains_inputs.count(user->kind()) > 0) {
+          lifetime.escapes = true;
+          break;
+        }
+        lifetime.last = std::max(lifetime.last, position[user]);
+        if(fresh_outputs.count(user->kind()) == 0) {
+          for(auto alias : user->outputs()) {
+            auto & alias_lifetime = lifetimes.at(alias);
+            lifetime.last = std::max(lifetime.last, alias_lifetime.last);
+            lifetime.escapes |= alias_lifetime.escapes;
+          }
+        }
+      }
+      lifetimes.emplace(output, lifetime);
+    }
+  }
+
+  std::map<int, std::vector<Candidate>> candidates_by_device;
+  for(auto node : nodes) {
+    if(node->kind() != prim::FusionGroup)
+      continue;
+    for(auto output : node->outputs()) {
+      auto type = output->type()->cast<TensorType>();
+      auto & lifetime = lifetimes.at(output);
+      if(!type || lifetime.escapes)
+        continue;
+      size_t size = sizeInBytes(*type);
+      if(size == 0)
+        continue;
+      candidates_by_device[type->device()].push_back(Candidate {output, size, lifetime, 0});
+    }
+  }
+
+  for(auto & entry : candidates_by_device) {
+    auto & candidates = entry.second;
+    size_t total = assignOffsets(candidates);
+
+    Node * arena_node = graph->create(prim::MemoryArena);
+    arena_node->i_(attr::arena_size, total);
+    arena_node->i_(attr::device, entry.first);
+    Value * arena = arena_node->output()->setType(std::make_shared<TensorType>(
+        at::kByte, entry.first, std::vector<int64_t>{static_cast<int64_t>(total)}));
+    graph->prependNode(arena_node);
+
+    std::unordered_map<Value*, size_t> offsets;
+    for(auto & c : candidates)
+      offsets[c.value] = c.offset;
+    for(auto node : nodes) {
+      if(node->kind() != prim::FusionGroup)
+        continue;
+      std::vector<int64_t> node_offsets;
+      bool planned = false;
+      for(auto output : node->outputs()) {
+        auto it = offsets.find(output);
+        planned |= it != offsets.end();
+        node_offsets.push_back(it != offsets.end() ? static_cast<int64_t>(it->second) : -1);
+      }
+      if(!planned)
+        continue;
+      node->is_(attr::memory_offsets, node_offsets);
+      node->addInput(arena);
+    }
+  }
+}
+
+}}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+namespace torch { namespace jit {
+
+// Places the outputs of FusionGroups in a shape-specialized graph into a
+// single preallocated arena per device, reusing memory between values whose
+// lifetimes don't overlap. See Note [Memory planning].
+// It has to run last, after fusion, since it adds an input to FusionGroups.
+void PlanMemory(std::shared_ptr<Graph>& graph);
+
+}}
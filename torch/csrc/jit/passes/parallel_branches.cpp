@@ -0,0 +1,243 @@
+#include "torch/csrc/jit/passes/parallel_branches.h"
+
+#include "torch/csrc/jit/interned_strings.h"
+
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace torch { namespace jit {
+
+// Note [Parallel branches]
+// ~~~~~~~~~~~~~~~~~~~~~~~~
+// The interpreter runs one instruction at a time, so the towers of a
+// multi-tower model, or the members of an ensemble, run one after the other
+// even though none of them reads what the others compute.
+//
+// For every node J (including the Return of the graph), the pass looks at
+// the "cone" of each value J uses: the nodes that only contribute to J
+// through that value, i.e. whose outputs are used by nothing but other nodes
+// of the cone, or by J as that value. Cones of different values of J are
+// disjoint and don't depend on each other, so when at least two of them are
+// expensive enough, they are moved into the subgraphs of a
+// prim::ParallelBranches node right before J:
+//
+//   %a = tower_1(%x)                 %a, %b = prim::ParallelBranches[
+//   %b = tower_2(%x)          =>         Subgraphs=[tower_1, tower_2]](%x, %x)
+//   %c = aten::cat(%a, %b)           %c = aten::cat(%a, %b)
+//
+// The inputs of the node are the inputs of all subgraphs in order, and its
+// outputs the outputs of all subgraphs in order. The interpreter runs the
+// subgraphs with at::parallel_for, and the node returns once all of them
+// have, so the branches are joined right before J, their first use.
+//
+// J is visited from last to first, so a branch is as large as it can be,
+// and branches are never nested. Nodes that may call back into Python or
+// have blocks are never moved into a branch.
+
+namespace {
+
+int64_t numel(Value *v) {
+  auto type = v->type()->cast<TensorType>();
+  if (!type)
+    return 0;
+  int64_t n = 1;
+  for (auto s : type->sizes())
+    n *= s;
+  return n;
+}
+
+// the size of the last dimension of v, the one contracted by a matrix product
+int64_t innerSize(Value *v) {
+  auto type = v->type()->cast<TensorType>();
+  if (!type || type->sizes().empty())
+    return 1;
+  return type->sizes().back();
+}
+
+// A rough estimate of the work a node does: one unit per output element,
+// times the number of elements reduced for each of them by matrix products
+// and convolutions.
+int64_t estimateCost(Node *n) {
+  if (n->kind() == prim::FusionGroup) {
+    int64_t cost = 0;
+    for (auto inner : n->g(attr::Subgraph)->nodes())
+      cost += estimateCost(inner);
+    return cost;
+  }
+  int64_t cost = 0;
+  for (auto output : n->outputs())
+    cost += numel(output);
+  switch (n->kind()) {
+    case aten::mm:
+    case aten::bmm:
+    case aten::matmul:
+      return cost * innerSize(n->inputs()[0]);
+    case aten::addmm:
+    case aten::baddbmm:
+      return n->inputs().size() < 3 ? cost : cost * innerSize(n->inputs()[1]);
+    case aten::_convolution:
+    case aten::mkldnn_convolution:
+    case aten::thnn_conv2d: {
+      if (n->inputs().size() < 2)
+        return cost;
+      auto weight = n->inputs()[1]->type()->cast<TensorType>();
+      if (!weight || weight->sizes().empty() || weight->sizes()[0] == 0)
+        return cost;
+      return cost * (numel(n->inputs()[1]) / weight->sizes()[0]);
+    }
+    default:
+      return cost;
+  }
+}
+
+bool canRunInBranch(Node *n) {
+  if (!n->blocks().empty())
+    return false;
+  switch (n->kind()) {
+    case prim::CppOp:
+    case prim::Eval:
+    case prim::MemoryArena:
+    case prim::ParallelBranches:
+    case prim::Print:
+    case prim::PythonOp:
+      return false;
+    default:
+      return true;
+  }
+}
+
+struct Branch {
+  std::vector<Node*> nodes; // in topological order
+  int64_t cost = 0;
+};
+
+struct BranchFinder {
+  explicit BranchFinder(Block *block) : block(block) {
+    for (auto n : block->nodes()) {
+      size_t index = position.size();
+      position[n] = index;
+    }
+  }
+
+  // The nodes that only contribute to join through root
+  Branch coneOf(Value *root, Node *join) {
+    auto later = [&](Node *a, Node *b) { return position.at(a) < position.at(b); };
+    std::priority_queue<Node*, std::vector<Node*>, decltype(later)> worklist(later);
+    std::unordered_set<Node*> queued;
+    std::unordered_set<Node*> in_cone;
+    auto enqueue = [&](Value *v) {
+      Node *p = v->node();
+      if (p->owningBlock() == block && !moved.count(p) && canRunInBranch(p) &&
+          queued.insert(p).second)
+        worklist.push(p);
+    };
+    enqueue(root);
+    Branch branch;
+    // Every user of a node comes after it, so visiting from last to first
+    // decides on all users in the cone before their producers.
+    while (!worklist.empty()) {
+      Node *p = worklist.top();
+      worklist.pop();
+      bool owned = true;
+      for (auto output : p->outputs()) {
+        for (auto use : output->uses()) {
+          if (!in_cone.count(use.user) && !(use.user == join && output == root))
+            owned = false;
+        }
+      }
+      if (!owned)
+        continue;
+      in_cone.insert(p);
+      branch.nodes.push_back(p);
+      branch.cost += estimateCost(p);
+      for (auto input : p->inputs())
+        enqueue(input);
+    }
+    std::reverse(branch.nodes.begin(), branch.nodes.end());
+    return branch;
+  }
+
+  void parallelize(Node *join, int64_t min_cost) {
+    std::vector<Branch> branches;
+    std::unordered_set<Value*> seen;
+    for (auto input : join->inputs()) {
+      if (!seen.insert(input).second)
+        continue;
+      auto branch = coneOf(input, join);
+      if (!branch.nodes.empty() && branch.cost >= min_cost)
+        branches.push_back(std::move(branch));
+    }
+    if (branches.size() < 2)
+      return;
+    mergeBranches(join, branches);
+  }
+
+  void mergeBranches(Node *join, std::vector<Branch> & branches) {
+    auto graph = block->owningGraph();
+    auto stage_guard = graph->setStageTemporary(join->stage());
+    Node *group = graph->create(prim::ParallelBranches, 0);
+    std::vector<std::shared_ptr<Graph>> subgraphs;
+    for (auto & branch : branches) {
+      auto subgraph = std::make_shared<Graph>();
+      std::unordered_map<Value*, Value*> value_map;
+      auto getOrCreateInput = [&](Value *v) {
+        auto it = value_map.find(v);
+        if (it != value_map.end())
+          return it->second;
+        Value *nv = subgraph->addInput()->setType(v->type());
+        group->addInput(v);
+        value_map[v] = nv;
+        return nv;
+      };
+      std::unordered_set<Node*> branch_set(branch.nodes.begin(), branch.nodes.end());
+      for (auto n : branch.nodes) {
+        auto nn = subgraph->appendNode(subgraph->createClone(n, getOrCreateInput));
+        for (size_t i = 0; i < n->outputs().size(); ++i) {
+          auto old_output = n->outputs()[i];
+          value_map[old_output] = nn->outputs()[i];
+          // only join uses values from outside of the branch
+          if (std::any_of(old_output->uses().begin(), old_output->uses().end(),
+                          [&](const Use & u) { return !branch_set.count(u.user); })) {
+            subgraph->registerOutput(nn->outputs()[i]);
+            Value *external = group->addOutput();
+            external->copyMetadata(old_output);
+            old_output->replaceAllUsesWith(external);
+          }
+        }
+      }
+      subgraphs.push_back(std::move(subgraph));
+    }
+    group->gs_(attr::Subgraphs, std::move(subgraphs));
+    group->insertBefore(join);
+    for (auto & branch : branches) {
+      for (auto it = branch.nodes.rbegin(); it != branch.nodes.rend(); ++it) {
+        moved.insert(*it);
+        (*it)->destroy();
+      }
+    }
+  }
+
+  Block *block;
+  std::unordered_map<Node*, size_t> position;
+  // destroyed nodes, which were moved into a branch
+  std::unordered_set<Node*> moved;
+};
+
+} // anonymous namespace
+
+void ParallelizeBranches(std::shared_ptr<Graph>& graph, int64_t min_cost) {
+  auto block = graph->block();
+  BranchFinder finder(block);
+  std::vector<Node*> joins(finder.position.size());
+  for (auto & entry : finder.position)
+    joins[entry.second] = entry.first;
+  finder.parallelize(block->return_node(), min_cost);
+  for (auto it = joins.rbegin(); it != joins.rend(); ++it) {
+    if (!finder.moved.count(*it))
+      finder.parallelize(*it, min_cost);
+  }
+}
+
+}}
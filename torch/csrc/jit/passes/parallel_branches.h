@@ -0,0 +1,17 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+namespace torch { namespace jit {
+
+// Below this estimated cost (roughly, in multiply-adds) a branch is cheaper
+// to run inline than to hand over to another thread.
+constexpr int64_t kDefaultMinBranchCost = 1 << 18;
+
+// Moves independent branches of a shape-specialized graph, whose estimated
+// cost is at least min_cost, into prim::ParallelBranches nodes, which the
+// interpreter runs concurrently. See Note [Parallel branches].
+// It has to run after fusion and before PlanMemory.
+void ParallelizeBranches(std::shared_ptr<Graph>& graph, int64_t min_cost = kDefaultMinBranchCost);
+
+}}
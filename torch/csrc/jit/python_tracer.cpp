@@ -7,7 +7,11 @@
 #include "torch/csrc/jit/pybind.h"
 #include "torch/csrc/utils/python_strings.h"
 
+#include <exception>
+#include <ostream>
 #include <sstream>
+#include <streambuf>
+#include <vector>
 
 using namespace torch::autograd;
 using namespace torch::jit;
@@ -15,6 +19,82 @@ using namespace torch::jit::tracer;
 
 namespace torch { namespace jit {
 
+namespace {
+
+// A streambuf which hands what is written to it to a Python callable (e.g.
+// the write method of a file object) in chunks of up to kBufferSize bytes.
+class PythonWriteBuffer : public std::streambuf {
+ public:
+  explicit PythonWriteBuffer(py::object write)
+      : write_(std::move(write)), buffer_(kBufferSize) {
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+  }
+
+  // Errors raised by the callable can't be thrown through the encoder, so
+  // they are kept here and the stream is failed instead.
+  void rethrowError() {
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+ protected:
+  int_type overflow(int_type ch) override {
+    if (sync() != 0) {
+      return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(ch);
+      pbump(1);
+    }
+    return traits_type::not_eof(ch);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    // Large writes (i.e. parameter data) bypass the buffer
+    if (n >= static_cast<std::streamsize>(buffer_.size())) {
+      if (sync() != 0 || !call(s, n)) {
+        return 0;
+      }
+      return n;
+    }
+    return std::streambuf::xsputn(s, n);
+  }
+
+  int sync() override {
+    auto n = pptr() - pbase();
+    if (n > 0) {
+      if (!call(pbase(), n)) {
+        return -1;
+      }
+      pbump(-static_cast<int>(n));
+    }
+    return 0;
+  }
+
+ private:
+  bool call(const char* s, std::streamsize n) {
+    if (error_) {
+      return false;
+    }
+    try {
+      write_(py::bytes(s, n));
+    } catch (...) {
+      error_ = std::current_exception();
+      return false;
+    }
+    return true;
+  }
+
+  static constexpr size_t kBufferSize = 1 << 20;
+
+  py::object write_;
+  std::vector<char> buffer_;
+  std::exception_ptr error_;
+};
+
+} // namespace
+
 #define ASSERT_UNEXPIRED(METHOD_NAME) if (s.is_expired()) throw std::runtime_error("calling " METHOD_NAME " on an expired trace")
 
 void initPythonTracerBindings(PyObject* module_) {
@@ -49,7 +129,8 @@ void initPythonTracerBindings(PyObject* module_) {
         s.graph, initializers, onnx_opset_version, defer_weight_export);
       std::unordered_map<std::string, py::bytes> python_serialized_export_map;
       for (auto& kv : export_map) {
-        auto t = kv.second;
+        // CPU's HalfTensor doesn't have contiguous(), so first calling contiguous()
+        auto t = kv.second.contiguous().toBackend(at::kCPU);
         size_t copy_bytes = t.type().elementSizeInBytes() * t.numel();
         // TODO: this is an unecessary copy. In theory we can directly return
         // the map from identifier to Tensor, but we need some API in Python
@@ -59,6 +140,37 @@ void initPythonTracerBindings(PyObject* module_) {
       return std::make_tuple(
           py::bytes(graph), python_serialized_export_map);
     })
+    .def("export_to", [](TracingState& s, py::object write,
+                         const std::vector<at::Tensor>& initializers,
+                         int64_t onnx_opset_version, py::object write_weight) {
+      ASSERT_UNEXPIRED("export_to");
+      // Unlike export, this never holds the whole protobuf or all the
+      // parameters in memory: the protobuf is handed to `write` in chunks as
+      // it is encoded, and if `write_weight` is given the parameters are
+      // exported externally and passed to it one at a time.
+      bool defer_weight_export = !write_weight.is_none();
+      RawDataExportMap export_map;
+      {
+        PythonWriteBuffer buffer(std::move(write));
+        std::ostream out(&buffer);
+        try {
+          export_map = ExportGraphToStream(
+            out, s.graph, initializers, onnx_opset_version, defer_weight_export);
+          out.flush();
+        } catch (...) {
+          // Prefer the error raised by `write` itself, if there was one
+          buffer.rethrowError();
+          throw;
+        }
+        buffer.rethrowError();
+      }
+      for (auto& kv : export_map) {
+        // CPU's HalfTensor doesn't have contiguous(), so first calling contiguous()
+        auto t = kv.second.contiguous().toBackend(at::kCPU);
+        size_t copy_bytes = t.type().elementSizeInBytes() * t.numel();
+        write_weight(kv.first, py::bytes(static_cast<const char*>(t.data_ptr()), copy_bytes));
+      }
+    })
     .def("graph", [](TracingState& s) {
       return s.graph;
     })
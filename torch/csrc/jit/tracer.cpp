@@ -40,6 +40,24 @@ std::string torch::jit::tracer::getPythonInterpreterStackTrace() {
   }
   return stack_trace.str();
 }
+
+std::shared_ptr<torch::jit::SourceLocation>
+torch::jit::tracer::getPythonSourceLocation(TracingState& state) {
+  AutoGIL gil;
+  // Walking the frames is cheap; formatting them is what we want to share.
+  std::vector<std::pair<const void*, int>> key;
+  PyThreadState *tstate = PyThreadState_GET();
+  if (NULL != tstate) {
+    for (PyFrameObject *frame = tstate->frame; NULL != frame; frame = frame->f_back) {
+      key.emplace_back(frame->f_code, frame->f_lasti);
+    }
+  }
+  auto& location = state.source_locations[key];
+  if (!location) {
+    location = std::make_shared<StringSourceLocation>(getPythonInterpreterStackTrace());
+  }
+  return location;
+}
 // This is a temporary constructor so that we can write python tests of
 // the executor. It does not have most of the functionality of CompiledFunction
 // such as being able to hold parameters...
@@ -176,11 +194,10 @@ PreTraceInfo makePreTraceInfo(at::ArrayRef<Variable> inputs, F ctor) {
 
   Node *n = ctor(*graph);
 #ifndef NO_PYTHON
-  auto sl = std::make_shared<StringSourceLocation>(getPythonInterpreterStackTrace());
-  n->setSourceLocation(sl);
+  n->setSourceLocation(getPythonSourceLocation(*info.state));
 #endif
 
-  for (Variable input : inputs) {
+  for (const Variable& input : inputs) {
     n->addInput(getValueTrace(info.state, input));
   }
 
@@ -25,6 +25,9 @@ using variable_list = std::vector<Variable>;
 
 #ifndef NO_PYTHON
 std::string getPythonInterpreterStackTrace();
+// The source location for a node recorded to 'state' from the current
+// Python stack. Must be called with the lock of 'state' held.
+std::shared_ptr<SourceLocation> getPythonSourceLocation(TracingState& state);
 #endif
 
 namespace detail {
@@ -91,7 +94,8 @@ struct IsTracing : IterArgs<IsTracing> {
   bool out = false;
   using IterArgs<IsTracing>::operator();
   void operator()(const at::Tensor& var) {
-    out = out || isTracingVar(var);
+    // Cast rather than convert, which would copy the Variable
+    out = out || isTracingVar(static_cast<const Variable&>(var));
   }
   bool short_circuit() { return out; }
 };
@@ -106,9 +110,9 @@ inline bool isTracing(Args&&... args) {
 // be recorded to.  Precondition: isTracing(vars) == true.  At the moment,
 // we don't support mixing up variables from different traces; this code
 // will need to be revisited if that ever becomes supported.
-inline std::shared_ptr<TracingState> getTracingState(const variable_list& vars) {
+inline std::shared_ptr<TracingState> getTracingState(at::ArrayRef<Variable> vars) {
   std::shared_ptr<TracingState> state;
-  for (auto& var : vars) {
+  for (const Variable& var : vars) {
     if (!var.defined() || !var.has_tracing_state()) continue;
     for (auto & vts : var.tracing_state()) {
       auto var_state = vts.state.lock();
@@ -6,6 +6,7 @@
 #include <atomic>
 #include <cstdint>
 #include <list>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -15,6 +16,7 @@
 
 namespace torch { namespace jit {
 struct Graph;
+struct SourceLocation;
 struct Value;
 struct VariableFlags;
 }} // namespace torch::jit
@@ -55,6 +57,13 @@ struct TracingState : public std::enable_shared_from_this<TracingState> {
   std::mutex mutex;
   variable_list inputs; // Used only for the duration of first stage
 
+  // Source locations of the nodes, keyed by the code object and instruction
+  // of each frame of the Python stack that recorded them, so that nodes
+  // recorded from the same stack (e.g. by every iteration of a loop) share
+  // one formatted stack trace
+  std::map<std::vector<std::pair<const void*, int>>,
+           std::shared_ptr<SourceLocation>> source_locations;
+
   std::unique_lock<std::mutex> lock() {
     return std::unique_lock<std::mutex>(mutex);
   }
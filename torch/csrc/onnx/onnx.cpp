@@ -32,12 +32,20 @@ bool micropb_encode<Dimension, nullptr>(pb_ostream_t *stream, Dimension* arg) {
 // TODO: I'm not entirely sure why this can't be in the header...
 bool micropb_callback_string_from_tensor(pb_ostream_t *stream, const pb_field_t *field, void * const *arg) {
   at::Tensor* t = static_cast<at::Tensor*>(*arg);
-  JIT_ASSERT(t->is_contiguous());
+  size_t nbytes = t->type().elementSizeInBytes() * t->numel();
   // Packed array format!
   pb_encode_tag_for_field(stream, field);
-  pb_encode_string(stream, (pb_byte_t*)(t->data_ptr()),  t->type().elementSizeInBytes()*t->numel());
-
-  return true;
+  // Sizing streams (e.g. the first pass over a submessage) never read the
+  // data. Otherwise a tensor which isn't a contiguous CPU tensor is copied
+  // here, right before it is written, so that only one such copy is alive
+  // at any time.
+  if (stream->callback == nullptr ||
+      (!t->type().is_cuda() && t->is_contiguous())) {
+    return pb_encode_string(stream, (pb_byte_t*)(t->data_ptr()), nbytes);
+  }
+  // CPU's HalfTensor doesn't have contiguous(), so first calling contiguous()
+  auto cpu = t->contiguous().toBackend(at::kCPU);
+  return pb_encode_string(stream, (pb_byte_t*)(cpu.data_ptr()), nbytes);
 }
 
 GraphProto* AttributeProto::add_graphs() {
@@ -106,7 +106,8 @@ struct MicroProto {
   // intended to be assigned into the particular protobuf field.
   // The employed callback reads out the tensor's data as if it
   // were a string (adjusting for endianness, if necessary)
-  // writes it out to the protobuf.
+  // writes it out to the protobuf. The tensor needn't be contiguous or on
+  // the CPU; the callback makes such a copy only when it writes the data.
   //
   // You should call this function IN THE SETTER METHOD, because
   // the no-op callback is different from a callback with an undefined
@@ -1,5 +1,10 @@
 #include <Python.h>
 #include <system_error>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #include "THP.h"
 #include "serialization.h"
@@ -34,6 +39,21 @@ ssize_t doWrite<PyObject*>(PyObject* fildes, void* buf, size_t nbytes) {
   return doPythonWrite(fildes, buf, nbytes);
 }
 
+template <>
+ssize_t doWrite<PositionedFile*>(PositionedFile* file, void* buf, size_t nbytes) {
+#ifdef _WIN32
+  // no pwrite, so these can't be used concurrently on the same descriptor
+  if (_lseeki64(file->fd, file->offset, SEEK_SET) < 0)
+    return -1;
+  ssize_t result = write(file->fd, buf, nbytes);
+#else
+  ssize_t result = pwrite(file->fd, buf, nbytes, file->offset);
+#endif
+  if (result > 0)
+    file->offset += result;
+  return result;
+}
+
 static inline bool isUnsupportedOperation() {
   THPObjectPtr io(PyImport_ImportModule("io"));
   if (!io) throw python_error();
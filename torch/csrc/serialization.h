@@ -7,6 +7,14 @@
 #include "generic/serialization.h"
 #include <TH/THGenerateHalfType.h>
 
+// A file descriptor written at an explicit offset, which advances with the
+// writes. Unlike writes at the current position of the descriptor, these can
+// be made from several threads at once, at different offsets.
+struct PositionedFile {
+  int fd;
+  int64_t offset;
+};
+
 template <class io>
 ssize_t doRead(io fildes, void* buf, size_t nbytes);
 
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "torch/csrc/utils/disallow_copy.h"
+
+namespace torch {
+
+// A monotonic allocator: memory is carved out of large chunks with a bump
+// pointer and only given back, all at once, when the Arena is destroyed.
+// Useful for short-lived node-based containers that would otherwise make one
+// malloc/free pair per element. allocate() is thread-safe.
+struct Arena {
+  explicit Arena(size_t chunk_size = 16384)
+    : chunk_size(chunk_size)
+    , cur(nullptr)
+    , end(nullptr) {}
+  TH_DISALLOW_COPY_AND_ASSIGN(Arena);
+
+  ~Arena() {
+    for (void* chunk : chunks) {
+      std::free(chunk);
+    }
+  }
+
+  void* allocate(size_t size, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uintptr_t p = (reinterpret_cast<uintptr_t>(cur) + alignment - 1) & ~(alignment - 1);
+    if (!cur || p + size > reinterpret_cast<uintptr_t>(end)) {
+      // Oversized requests get a chunk of their own, so that the remainder of
+      // the current chunk isn't wasted
+      size_t new_chunk_size = size + alignment > chunk_size ? size + alignment : chunk_size;
+      char* chunk = static_cast<char*>(std::malloc(new_chunk_size));
+      if (!chunk) throw std::bad_alloc();
+      chunks.push_back(chunk);
+      p = (reinterpret_cast<uintptr_t>(chunk) + alignment - 1) & ~(alignment - 1);
+      if (new_chunk_size > chunk_size) {
+        return reinterpret_cast<void*>(p);
+      }
+      end = chunk + new_chunk_size;
+    }
+    cur = reinterpret_cast<char*>(p + size);
+    return reinterpret_cast<void*>(p);
+  }
+
+private:
+  std::mutex mutex;
+  size_t chunk_size;
+  char* cur;
+  char* end;
+  std::vector<void*> chunks;
+};
+
+// An STL allocator that allocates from an Arena. deallocate() is a no-op, so
+// the Arena must outlive every container using it.
+template<typename T>
+struct ArenaAllocator {
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+
+  template<typename U>
+  struct rebind { typedef ArenaAllocator<U> other; };
+
+  explicit ArenaAllocator(Arena* arena) : arena(arena) {}
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+  T* allocate(size_t n, const void* /*hint*/ = nullptr) {
+    return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T* /*p*/, size_t /*n*/) {}
+
+  size_t max_size() const {
+    return std::numeric_limits<size_t>::max() / sizeof(T);
+  }
+
+  template<typename U, typename... Args>
+  void construct(U* p, Args&&... args) {
+    ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+  }
+  template<typename U>
+  void destroy(U* p) {
+    p->~U();
+  }
+
+  Arena* arena;
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena == b.arena;
+}
+
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena != b.arena;
+}
+
+} // namespace torch
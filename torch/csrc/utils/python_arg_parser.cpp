@@ -184,6 +184,7 @@ FunctionSignature::FunctionSignature(const std::string& fmt)
   , max_pos_args(0)
   , hidden(false)
   , deprecated(false)
+  , allow_varargs_intlist(false)
 {
   auto open_paren = fmt.find('(');
   if (open_paren == std::string::npos) {
@@ -239,6 +240,12 @@ FunctionSignature::FunctionSignature(const std::string& fmt)
       max_pos_args++;
     }
   }
+
+  // if there is a single positional IntList argument, i.e. expand(..), view(...),
+  // allow a var-args style IntList, so expand(5,3) behaves as expand((5,3))
+  if (max_pos_args == 1 && params[0].type_ == ParameterType::INT_LIST) {
+    allow_varargs_intlist = true;
+  }
 }
 
 std::string FunctionSignature::toString() const {
@@ -334,17 +341,10 @@ static void extra_kwargs(FunctionSignature& signature, PyObject* kwargs, ssize_t
 }
 
 bool FunctionSignature::parse(PyObject* args, PyObject* kwargs, PyObject* dst[],
-                              bool raise_exception) {
+                              bool raise_exception, bool* value_dependent) {
   auto nargs = PyTuple_GET_SIZE(args);
   ssize_t remaining_kwargs = kwargs ? PyDict_Size(kwargs) : 0;
   ssize_t arg_pos = 0;
-  bool allow_varargs_intlist = false;
-
-  // if there is a single positional IntList argument, i.e. expand(..), view(...),
-  // allow a var-args style IntList, so expand(5,3) behaves as expand((5,3))
-  if (max_pos_args == 1 && params[0].type_ == ParameterType::INT_LIST) {
-    allow_varargs_intlist = true;
-  }
 
   if (nargs > max_pos_args && !allow_varargs_intlist) {
     if (raise_exception) {
@@ -395,6 +395,11 @@ bool FunctionSignature::parse(PyObject* args, PyObject* kwargs, PyObject* dst[],
             param.type_name().c_str(), Py_TYPE(obj)->tp_name);
       }
     } else {
+      // every check but the one of a Tensor passed as a Scalar only looks at
+      // the type of the argument
+      if (value_dependent && param.type_ == ParameterType::SCALAR && THPVariable_Check(obj)) {
+        *value_dependent = true;
+      }
       return false;
     }
 
@@ -418,6 +423,7 @@ bool FunctionSignature::parse(PyObject* args, PyObject* kwargs, PyObject* dst[],
 
 PythonArgParser::PythonArgParser(std::vector<std::string> fmts)
  : max_args(0)
+ , next_cache_entry_(0)
 {
   for (auto& fmt : fmts) {
     signatures_.push_back(FunctionSignature(fmt));
@@ -432,19 +438,69 @@ PythonArgParser::PythonArgParser(std::vector<std::string> fmts)
   }
 }
 
+const PythonArgParser::OverloadCacheEntry* PythonArgParser::find_overload(PyObject* args) const {
+  auto nargs = PyTuple_GET_SIZE(args);
+  for (auto& entry : overload_cache_) {
+    if (entry.nargs != nargs) {
+      continue;
+    }
+    ssize_t i = 0;
+    while (i < nargs && entry.types[i] == Py_TYPE(PyTuple_GET_ITEM(args, i))) {
+      i++;
+    }
+    if (i == nargs) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+void PythonArgParser::remember_overload(PyObject* args, int first_signature) {
+  auto nargs = PyTuple_GET_SIZE(args);
+  auto& entry = overload_cache_[next_cache_entry_];
+  next_cache_entry_ = (next_cache_entry_ + 1) % kOverloadCacheSize;
+  // The entries hold references to their types, so that a type freed while
+  // cached can't have its address reused by a different one
+  for (ssize_t i = 0; i < entry.nargs; i++) {
+    Py_DECREF(entry.types[i]);
+  }
+  for (ssize_t i = 0; i < nargs; i++) {
+    entry.types[i] = Py_TYPE(PyTuple_GET_ITEM(args, i));
+    Py_INCREF(entry.types[i]);
+  }
+  entry.nargs = nargs;
+  entry.first_signature = first_signature;
+}
+
 PythonArgs PythonArgParser::raw_parse(PyObject* args, PyObject* kwargs, PyObject* parsed_args[]) {
+  // an empty kwargs dict takes the positional-only path of parse()
+  if (kwargs && PyDict_Size(kwargs) == 0) {
+    kwargs = nullptr;
+  }
+
   if (signatures_.size() == 1) {
     auto& signature = signatures_[0];
     signature.parse(args, kwargs, parsed_args, true);
     return PythonArgs(0, signature, parsed_args);
   }
 
-  int i = 0;
-  for (auto& signature : signatures_) {
-    if (signature.parse(args, kwargs, parsed_args, false)) {
+  // the cache is only used without kwargs, as their names matter too
+  bool cacheable = !kwargs && PyTuple_GET_SIZE(args) <= kMaxCachedArgs;
+  const OverloadCacheEntry* cached = cacheable ? find_overload(args) : nullptr;
+  int first_possible = -1;
+  int num_signatures = signatures_.size();
+  for (int i = cached ? cached->first_signature : 0; i < num_signatures; i++) {
+    auto& signature = signatures_[i];
+    bool value_dependent = false;
+    if (signature.parse(args, kwargs, parsed_args, false, &value_dependent)) {
+      if (cacheable && !cached) {
+        remember_overload(args, first_possible < 0 ? i : first_possible);
+      }
       return PythonArgs(i, signature, parsed_args);
     }
-    i++;
+    if (value_dependent && first_possible < 0) {
+      first_possible = i;
+    }
   }
 
   print_error(args, kwargs, parsed_args);
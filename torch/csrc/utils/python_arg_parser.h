@@ -21,6 +21,7 @@
 
 
 #include <Python.h>
+#include <array>
 #include <string>
 #include <sstream>
 #include <vector>
@@ -61,13 +62,30 @@ struct PythonArgParser {
   inline PythonArgs parse(PyObject* args, PyObject* kwargs, ParsedArgs<N>& dst);
 
 private:
+  // Overloads are tried in order, so a call has to skip every signature
+  // before the one that matches. For calls without keyword arguments, the
+  // parser remembers, per tuple of positional argument types, the first
+  // signature that could match them: the ones before it were rejected for
+  // reasons that only depend on the types, so later calls start from it.
+  static constexpr int kMaxCachedArgs = 6;
+  static constexpr int kOverloadCacheSize = 8;
+  struct OverloadCacheEntry {
+    ssize_t nargs = -1;
+    PyTypeObject* types[kMaxCachedArgs];
+    int first_signature = 0;
+  };
+
   [[noreturn]]
   void print_error(PyObject* args, PyObject* kwargs, PyObject* dst[]);
   PythonArgs raw_parse(PyObject* args, PyObject* kwargs, PyObject* dst[]);
+  const OverloadCacheEntry* find_overload(PyObject* args) const;
+  void remember_overload(PyObject* args, int first_signature);
 
   std::vector<FunctionSignature> signatures_;
   std::string function_name;
   ssize_t max_args;
+  std::array<OverloadCacheEntry, kOverloadCacheSize> overload_cache_;
+  int next_cache_entry_;
 };
 
 struct PythonArgs {
@@ -106,7 +124,11 @@ struct PythonArgs {
 struct FunctionSignature {
   explicit FunctionSignature(const std::string& fmt);
 
-  bool parse(PyObject* args, PyObject* kwargs, PyObject* dst[], bool raise_exception);
+  // If value_dependent is given, it is set when the arguments were rejected
+  // for their values rather than their types (e.g. a Tensor that requires
+  // grad passed as a Scalar)
+  bool parse(PyObject* args, PyObject* kwargs, PyObject* dst[], bool raise_exception,
+             bool* value_dependent=nullptr);
   std::string toString() const;
 
   std::string name;
@@ -116,6 +138,8 @@ struct FunctionSignature {
   ssize_t max_pos_args;
   bool hidden;
   bool deprecated;
+  // a single positional IntList, which also accepts var-args: view(2, 3)
+  bool allow_varargs_intlist;
 };
 
 struct FunctionParameter {
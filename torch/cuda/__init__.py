@@ -345,12 +345,114 @@ def current_stream():
     return torch.cuda.Stream(_cdata=torch._C._cuda_getCurrentStream())
 
 
+def copy_stream(device=None):
+    r"""Returns the :class:`Stream` used by :func:`to_host_async` and
+    :func:`to_device_async` for copies between host and a given device.
+
+    Arguments:
+        device (int, optional): selected device. Uses the current device,
+                                given by :meth:`~torch.cuda.current_device`,
+                                if :attr:`device` is ``None`` (default).
+    """
+    _lazy_init()
+    if device is None:
+        device = current_device()
+    return torch.cuda.Stream(_cdata=torch._C._cuda_getCopyStream(device))
+
+
+def pool_stream(device=None, high_priority=False):
+    r"""Returns one of the :class:`Stream` s of a pool shared by all callers,
+    so that code which needs a side stream doesn't have to create its own.
+    Successive calls cycle through the streams of the pool.
+
+    Kernels queued on a high priority stream are scheduled ahead of the
+    kernels pending on low priority streams of the same device, e.g. to keep
+    latency-critical inference ahead of background copies.
+
+    Arguments:
+        device (int, optional): selected device. Uses the current device,
+                                given by :meth:`~torch.cuda.current_device`,
+                                if :attr:`device` is ``None`` (default).
+        high_priority (bool, optional): whether to return a stream of the high
+                                        priority pool (default: ``False``).
+    """
+    _lazy_init()
+    if device is None:
+        device = current_device()
+    return torch.cuda.Stream(_cdata=torch._C._cuda_getPoolStream(device, bool(high_priority)))
+
+
+def to_host_async(tensor):
+    r"""Copies a CUDA tensor to a new pinned CPU tensor without blocking.
+
+    The copy runs on :func:`copy_stream` of the tensor's device once the work
+    already queued on the current stream is done, so it overlaps with the
+    kernels queued after it. Returns the CPU tensor and an :class:`Event`
+    that completes with the copy; the CPU tensor must not be read before
+    then.
+
+    Example::
+
+        >>> loss_cpu, done = torch.cuda.to_host_async(loss)
+        >>> # ... queue more work ...
+        >>> done.synchronize()
+        >>> print(loss_cpu)
+    """
+    with device(tensor.get_device()):
+        result = tensor._to_host_async()
+        return result, copy_stream().record_event()
+
+
+def to_device_async(tensor, device=None):
+    r"""Copies a CPU tensor to a new tensor on a CUDA device without blocking.
+
+    The tensor is staged in pinned memory and copied on :func:`copy_stream`
+    of the device. Work queued on the current stream afterwards waits for
+    the copy, but work queued before it does not, and the host does not.
+
+    Arguments:
+        tensor (Tensor): the CPU tensor to copy.
+        device (int, optional): the destination device. Uses the current
+                                device if :attr:`device` is ``None`` (default).
+    """
+    if device is None:
+        device = current_device()
+    with torch.cuda.device(device):
+        cuda_type = getattr(torch.cuda, tensor.type().split('.')[-1])
+        return cuda_type(tensor.size())._copy_from_host_async_(tensor)
+
+
 def current_blas_handle():
     r"""Returns cublasHandle_t pointer to current cuBLAS handle"""
     _lazy_init()
     return torch._C._cuda_getCurrentBlasHandle()
 
 
+def set_deterministic(mode):
+    r"""Sets whether :meth:`~torch.Tensor.index_add_` and
+    :meth:`~torch.Tensor.scatter_add_` on CUDA tensors give bitwise
+    reproducible results.
+
+    By default, they accumulate into the output with atomic additions, whose
+    order (and so the rounding of floating point results) can change from run
+    to run. In deterministic mode, they sort the indices and sum the values
+    added to each output element in a fixed order instead, which is slower
+    when there are few duplicate indices.
+
+    Arguments:
+        mode (bool): whether to use the deterministic implementations
+    """
+    _lazy_init()
+    torch._C._cuda_setDeterministic(mode)
+
+
+def is_deterministic():
+    r"""Returns whether deterministic mode is enabled. See
+    :meth:`~torch.cuda.set_deterministic`."""
+    _lazy_init()
+    return torch._C._cuda_getDeterministic()
+
+
 def empty_cache():
     r"""Releases all unoccupied cached memory currently held by the caching
     allocator so that those can be used in other GPU application and visible in
@@ -443,6 +545,105 @@ def max_memory_cached(device=None):
     return torch._C._cuda_maxMemoryCached(device)
 
 
+def memory_fragmentation(device=None):
+    r"""Returns a dictionary describing how the memory cached by the caching
+    allocator is fragmented for a given device.
+
+    The dictionary contains the number of ``segments`` obtained from the CUDA
+    driver, the number of cached ``free_blocks``, the size of the
+    ``largest_free_block`` in bytes, and the ``inactive_split_bytes``: cached
+    free memory in segments that also hold tensors, which
+    :meth:`~torch.cuda.empty_cache` cannot release.
+
+    Arguments:
+        device (int, optional): selected device. Returns statistic for the
+                                current device, given by
+                                :meth:`~torch.cuda.current_device`, if
+                                :attr:`device` is ``None`` (default).
+
+    .. note::
+        Setting the ``THC_CACHING_ALLOCATOR_MAX_SPLIT_SIZE`` environment
+        variable (in MiB) stops blocks of at least that size from being split
+        for smaller tensors, which keeps ``inactive_split_bytes`` low at the
+        cost of more allocations. See :ref:`cuda-memory-management` for more
+        details about GPU memory management.
+    """
+    if device is None:
+        device = current_device()
+    return torch._C._cuda_memoryFragmentation(device)
+
+
+def cufft_plan_cache_info(device=None):
+    r"""Returns a dictionary describing the cache of cuFFT plans used by
+    :meth:`~torch.fft` and related functions for a given device.
+
+    The dictionary contains the number of cached plans (``size``), the
+    capacity of the cache (``max_size``), and the number of transforms that
+    found their plan in the cache (``hits``) or had to make one (``misses``).
+
+    Arguments:
+        device (int, optional): selected device. Returns statistic for the
+                                current device, given by
+                                :meth:`~torch.cuda.current_device`, if
+                                :attr:`device` is ``None`` (default).
+    """
+    _lazy_init()
+    if device is None:
+        device = current_device()
+    return torch._C._cuda_cufftPlanCacheInfo(device)
+
+
+def set_cufft_plan_cache_max_size(max_size, device=None):
+    r"""Sets the number of cuFFT plans cached for a given device. The least
+    recently used plans are dropped when the cache is full, and a size of 0
+    disables the cache.
+
+    Arguments:
+        max_size (int): the new capacity of the cache.
+        device (int, optional): selected device. Uses the current device,
+                                given by :meth:`~torch.cuda.current_device`,
+                                if :attr:`device` is ``None`` (default).
+    """
+    _lazy_init()
+    if device is None:
+        device = current_device()
+    torch._C._cuda_cufftSetPlanCacheMaxSize(device, max_size)
+
+
+def clear_cufft_plan_cache(device=None):
+    r"""Drops all the cuFFT plans cached for a given device.
+
+    Arguments:
+        device (int, optional): selected device. Uses the current device,
+                                given by :meth:`~torch.cuda.current_device`,
+                                if :attr:`device` is ``None`` (default).
+    """
+    _lazy_init()
+    if device is None:
+        device = current_device()
+    torch._C._cuda_cufftClearPlanCache(device)
+
+
+def host_memory_stats():
+    r"""Returns a dictionary of counters of the pinned (page-locked) host
+    memory allocator used by :meth:`~torch.Tensor.pin_memory`.
+
+    The dictionary contains the number of allocations served from the cache
+    (``hits``) and those that needed a new block (``misses``), the total
+    pinned memory held (``bytes_pinned``), the pinned memory currently used by
+    tensors (``bytes_allocated``) and the memory reserved up front as an arena
+    (``arena_bytes``).
+
+    .. note::
+        Setting the ``THC_CACHING_HOST_ALLOCATOR_ARENA_SIZE`` environment
+        variable (in MiB) reserves that much pinned memory on the first
+        allocation, so later allocations do not call ``cudaHostAlloc`` until
+        the arena is exhausted.
+    """
+    _lazy_init()
+    return torch._C._cuda_hostMemoryStats()
+
+
 def _host_allocator():
     _lazy_init()
     return torch._C._cuda_cudaHostAllocator()
@@ -557,3 +557,19 @@ def _register_stream(stream):
     if not _initialized:
         raise RuntimeError("torch.distributed needs to be initialized first")
     return torch._C._dist_register_stream(stream)
+
+
+def _new_reducer(params, bucket_size):
+    """Averages the gradients of ``params`` across all processes while
+    backward is running, by all-reducing buckets of about ``bucket_size``
+    bytes as soon as all their gradients are ready.
+
+    The gradients are reduced for as long as the returned object is alive.
+
+    Arguments:
+        params (Iterable[Tensor]): dense CPU parameters that require grad.
+        bucket_size (int): maximum size of a bucket in bytes.
+    """
+    assert torch.distributed._initialized == _INITIALIZED_PG, \
+        "reducer only supported in process-group mode"
+    return torch._C._dist_new_reducer(list(params), bucket_size)
@@ -59,7 +59,8 @@ def btrifact(A, info=None, pivot=True):
         The :attr:`info` argument is deprecated in favor of :meth:`torch.btrifact_with_info`.
 
     Arguments:
-        A (Tensor): the tensor to factor
+        A (Tensor): the tensor to factor, a batch of square matrices in its
+            last two dimensions, with any number of batch dimensions before
         info (IntTensor, optional): (deprecated) an `IntTensor` to store values
             indicating whether factorization succeeds
         pivot (bool, optional): controls whether pivoting is done
@@ -322,7 +323,7 @@ def isnan(tensor):
     return tensor != tensor
 
 
-def unique(input, sorted=False, return_inverse=False):
+def unique(input, sorted=False, return_inverse=False, return_counts=False):
     r"""Returns the unique scalar elements of the input tensor as a 1-D tensor.
 
     Arguments:
@@ -331,16 +332,24 @@ def unique(input, sorted=False, return_inverse=False):
             before returning as output.
         return_inverse (bool): Whether to also return the indices for where
             elements in the original input ended up in the returned unique list.
+        return_counts (bool): Whether to also return the number of times each
+            unique element occurs in the input.
 
     Returns:
-        (Tensor, Tensor (optional)): A tensor or a tuple of tensors containing
+        (Tensor, Tensor (optional), Tensor (optional)): A tensor or a tuple of tensors containing
 
             - **output** (*Tensor*): the output list of unique scalar elements.
             - **inverse_indices** (*Tensor*): (optional) if
-              :attr:`return_inverse` is True, there will be a
-              2nd returned tensor (same shape as input) representing the indices
-              for where elements in the original input map to in the output;
-              otherwise, this function will only return a single tensor.
+              :attr:`return_inverse` is True, there will be an
+              additional returned tensor (same shape as input) representing the
+              indices for where elements in the original input map to in the
+              output.
+            - **counts** (*Tensor*): (optional) if :attr:`return_counts` is
+              True, there will be an additional returned tensor (same shape as
+              output) representing the number of occurrences of each unique
+              element.
+
+    .. note:: On CUDA the unique elements are always sorted.
 
     Example::
 
@@ -383,16 +392,32 @@ def unique(input, sorted=False, return_inverse=False):
          0  2
          1  2
         [torch.LongTensor of size (2,2)]
+
+        >>>> output, counts = torch.unique(
+                 torch.LongTensor([1, 3, 2, 3]), sorted=True, return_counts=True)
+        >>>> counts
+
+         1
+         1
+         2
+        [torch.LongTensor of size (3,)]
     """
-    output, inverse_indices = torch._C._VariableFunctions._unique(
+    output, inverse_indices, counts = torch._C._VariableFunctions._unique(
         input,
         sorted=sorted,
         return_inverse=return_inverse,
+        return_counts=return_counts,
     )
+    return _unique_result(output, inverse_indices, counts, return_inverse, return_counts)
+
+
+def _unique_result(output, inverse_indices, counts, return_inverse, return_counts):
+    result = (output,)
     if return_inverse:
-        return output, inverse_indices
-    else:
-        return output
+        result += (inverse_indices,)
+    if return_counts:
+        result += (counts,)
+    return result if len(result) > 1 else output
 
 
 def argmax(input, dim=None, keepdim=False):
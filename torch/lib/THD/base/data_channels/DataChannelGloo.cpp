@@ -159,9 +159,11 @@ void DataChannelGloo::allGatherT(std::vector<at::Tensor>& output,
     }
   }
   std::uint64_t tensor_bytes = input.type().elementSizeInBytes() * input.numel();
-  std::uint64_t all_tensor_bytes = tensor_bytes * output.size();
+  auto count = GlooCache::bucket_count(input.numel());
+  std::uint64_t buffer_bytes = input.type().elementSizeInBytes() * count;
+  std::uint64_t all_buffer_bytes = buffer_bytes * output.size();
   auto ret = _cache->getAlgorithm<CollectiveType::ALL_GATHER, T>(
-    group_id, _groups.at(group_id), input_device, tensor_bytes, all_tensor_bytes, input.numel());
+    group_id, _groups.at(group_id), input_device, buffer_bytes, all_buffer_bytes, count);
 
 
   {
@@ -170,7 +172,7 @@ void DataChannelGloo::allGatherT(std::vector<at::Tensor>& output,
     GlooCache::algorithm(ret)->run();
     for (std::size_t i = 0; i < output.size(); i++) {
       std::memcpy(output.at(i).data_ptr(),
-                  GlooCache::output_buffer(ret).get() + (i * tensor_bytes),
+                  GlooCache::output_buffer(ret).get() + (i * buffer_bytes),
                   tensor_bytes);
     }
   }
@@ -210,9 +212,10 @@ void DataChannelGloo::scatter(std::vector<at::Tensor>& input,
 template<typename T>
 void DataChannelGloo::allReduceT(at::Tensor& t, THDReduceOp operation,
                                  THDGroup group_id) {
-  std::uint64_t tensor_bytes = t.type().elementSizeInBytes() * t.numel();
+  auto count = GlooCache::bucket_count(t.numel());
+  std::uint64_t buffer_bytes = t.type().elementSizeInBytes() * count;
   auto ret = _cache->getAlgorithm<CollectiveType::ALL_REDUCE, T>(
-    group_id, _groups.at(group_id), getDeviceType(t), tensor_bytes, t.numel(), operation);
+    group_id, _groups.at(group_id), getDeviceType(t), buffer_bytes, count, operation);
 
   {
     std::lock_guard<std::mutex> lock(*GlooCache::mutex(ret));
@@ -229,6 +232,25 @@ void DataChannelGloo::allReduce(at::Tensor& data, THDReduceOp operation,
 }
 
 
+template<typename T>
+void DataChannelGloo::prewarmAllReduceT(const std::vector<std::size_t>& numels,
+                                        DeviceType device, THDReduceOp operation,
+                                        THDGroup group_id) {
+  for (auto numel : numels) {
+    auto count = GlooCache::bucket_count(numel);
+    _cache->getAlgorithm<CollectiveType::ALL_REDUCE, T>(
+      group_id, _groups.at(group_id), device, sizeof(T) * count, count, operation);
+  }
+}
+
+void DataChannelGloo::prewarmAllReduce(const std::vector<std::size_t>& numels,
+                                       at::ScalarType type, DeviceType device,
+                                       THDReduceOp operation, THDGroup group_id) {
+  RETURN_IF_NOT_IN_GROUP
+  GENERATE_ALL_TYPES(type, prewarmAllReduceT, numels, device, operation, group_id)
+}
+
+
 // XXX: `reduce` is not supported by Gloo yet.
 void DataChannelGloo::reduce(at::Tensor& data, THDReduceOp operation,
                              rank_type dst_rank, THDGroup group_id) {
@@ -239,9 +261,10 @@ void DataChannelGloo::reduce(at::Tensor& data, THDReduceOp operation,
 template<typename T>
 void DataChannelGloo::broadcastT(at::Tensor& data, rank_type src_rank,
                                  THDGroup group_id) {
-  std::uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
+  auto count = GlooCache::bucket_count(data.numel());
+  std::uint64_t buffer_bytes = data.type().elementSizeInBytes() * count;
   auto ret = _cache->getAlgorithm<CollectiveType::BROADCAST, T>(
-    group_id, _groups.at(group_id), getDeviceType(data), tensor_bytes, data.numel(),
+    group_id, _groups.at(group_id), getDeviceType(data), buffer_bytes, count,
     _groups.at(group_id).mustGetGroupRank(src_rank));
 
   {
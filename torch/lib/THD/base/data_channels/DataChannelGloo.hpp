@@ -84,6 +84,17 @@ struct DataChannelGloo : DataChannel {
   THDGroup newGroup(const std::vector<rank_type>& ranks) override;
   void clearGroupCache(THDGroup group_id = THDGroupWORLD) override;
 
+  /**
+   * Creates the algorithms that all-reducing tensors of the given numbers of
+   * elements will use, so that the connections they need are set up before
+   * training starts rather than on its first iterations. Like a collective it
+   * has to be called by all processes of the group, with the same arguments.
+   */
+  void prewarmAllReduce(const std::vector<std::size_t>& numels,
+                        at::ScalarType type, DeviceType device,
+                        THDReduceOp operation = THDReduceSUM,
+                        THDGroup group_id = THDGroupWORLD);
+
 
 private:
 
@@ -95,6 +106,11 @@ private:
   void allReduceT(at::Tensor& data, THDReduceOp operation,
                   THDGroup group_id = THDGroupWORLD);
 
+  template<typename T>
+  void prewarmAllReduceT(const std::vector<std::size_t>& numels,
+                         DeviceType device, THDReduceOp operation,
+                         THDGroup group_id);
+
   template<typename T>
   void broadcastT(at::Tensor& data, rank_type src_rank,
                   THDGroup group_id = THDGroupWORLD);
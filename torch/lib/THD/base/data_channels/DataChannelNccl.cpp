@@ -17,6 +17,13 @@ namespace thd {
 
 namespace {
 
+/**
+ * Number of NCCL communicators (and streams) per group. Consecutive
+ * collectives of a group go to different communicators so that they can run
+ * concurrently.
+ */
+constexpr size_t NCCL_SLOTS_PER_GROUP = 2;
+
 
 std::unordered_map<THDReduceOp, ncclRedOp_t> ncclOp = {
   {THDReduceOp::THDReduceMIN, ncclMin},
@@ -62,6 +69,44 @@ std::vector<int> getDevicesList(const std::string& deviceSeq) {
 } // namespace
 
 
+// RequestNccl
+DataChannelNccl::RequestNccl::RequestNccl(std::vector<int> devices,
+                                          std::vector<cudaEvent_t> events)
+  : _devices(std::move(devices))
+  , _events(std::move(events)) {}
+
+
+DataChannelNccl::RequestNccl::~RequestNccl() {
+  AutoGPU gpuGuard;
+  for (size_t i = 0; i < _events.size(); ++i) {
+    gpuGuard.setDevice(_devices[i]);
+    THCudaCheck(cudaEventDestroy(_events[i]));
+  }
+}
+
+
+bool DataChannelNccl::RequestNccl::isCompleted() {
+  for (auto event : _events) {
+    cudaError_t err = cudaEventQuery(event);
+    if (err == cudaErrorNotReady) {
+      return false;
+    }
+    THCudaCheck(err);
+  }
+  return true;
+}
+
+
+void DataChannelNccl::RequestNccl::wait() {
+  AutoGPU gpuGuard;
+  for (size_t i = 0; i < _events.size(); ++i) {
+    gpuGuard.setDevice(_devices[i]);
+    auto stream = THCState_getCurrentStream(THDGetCudaState());
+    THCudaCheck(cudaStreamWaitEvent(stream, _events[i], 0));
+  }
+}
+
+
 // DataChannelNccl
 DataChannelNccl::DataChannelNccl(InitMethod::Config config, int timeout)
   : _rank(config.rank)
@@ -184,16 +229,18 @@ void DataChannelNccl::_destroyNcclResources(THDGroup groupId) {
     auto devices = getDevicesList(_groupDevices[groupId]);
     // Guard GPU device
     AutoGPU gpuGuard;
-    // Destroy the CUDA events
-    size_t idx = 0;
-    for (auto& event : *(_groupNcclResources[groupId].ncclCudaEvents())) {
-      gpuGuard.setDevice(devices[idx++]);
-      THCudaCheck(cudaEventSynchronize(event));
-      THCudaCheck(cudaEventDestroy(event));
-    }
-    // Destroy the communicators
-    for (auto& comm : *(_groupNcclResources[groupId].ncclComms())) {
-      NCCL_CHECK(ncclCommDestroy(comm));
+    for (auto& slot : _groupNcclResources[groupId].slots) {
+      for (size_t i = 0; i < devices.size(); ++i) {
+        gpuGuard.setDevice(devices[i]);
+        // Let the outstanding collectives finish first
+        THCudaCheck(cudaStreamSynchronize(slot.streams[i]->stream));
+        THCudaCheck(cudaEventDestroy(slot.events[i]));
+        THCStream_free(slot.streams[i]);
+      }
+      // Destroy the communicators
+      for (auto& comm : slot.comms) {
+        NCCL_CHECK(ncclCommDestroy(comm));
+      }
     }
   }
 }
@@ -244,7 +291,7 @@ rank_type DataChannelNccl::getNumProcesses() {
 }
 
 
-NcclResourcePair DataChannelNccl::_getNcclResourcePair(
+DataChannelNccl::NcclSlot& DataChannelNccl::_getNcclSlot(
     std::vector<at::Tensor>& input,
     THDGroup groupId) {
 
@@ -276,25 +323,31 @@ NcclResourcePair DataChannelNccl::_getNcclResourcePair(
     _groupDevices.erase(groupId);
   }
 
-  if (_groupNcclResources.find(groupId) != _groupNcclResources.end()) {
-    return std::make_pair(_groupNcclResources[groupId].ncclComms(),
-                          _groupNcclResources[groupId].ncclCudaEvents());
-  }
-
-  // Add in the device list of the group
-  _groupDevices[groupId] = deviceList;
+  auto it = _groupNcclResources.find(groupId);
+  if (it == _groupNcclResources.end()) {
+    // Add in the device list of the group
+    _groupDevices[groupId] = deviceList;
 
-  // NCCL communicator
-  auto comms =
-    std::unique_ptr<std::vector<ncclComm_t>>(new std::vector<ncclComm_t>());
+    NcclResources resources;
+    resources.slots.resize(NCCL_SLOTS_PER_GROUP);
+    for (auto& slot : resources.slots) {
+      _createNcclSlot(slot, input);
+    }
+    it = _groupNcclResources.emplace(groupId, std::move(resources)).first;
+  }
 
-  comms->resize(input.size());
+  auto& resources = it->second;
+  auto& slot = resources.slots[resources.nextSlot];
+  resources.nextSlot = (resources.nextSlot + 1) % resources.slots.size();
+  return slot;
+}
 
-  // Corresponding CUDA events
-  auto events =
-    std::unique_ptr<std::vector<cudaEvent_t>>(new std::vector<cudaEvent_t>());
 
-  events->resize(input.size());
+void DataChannelNccl::_createNcclSlot(NcclSlot& slot,
+                                      std::vector<at::Tensor>& input) {
+  slot.comms.resize(input.size());
+  slot.streams.resize(input.size());
+  slot.events.resize(input.size());
 
   // Create the unique NCCL ID and broadcast it
   ncclUniqueId ncclId;
@@ -306,30 +359,82 @@ NcclResourcePair DataChannelNccl::_getNcclResourcePair(
   // Guard GPU device
   AutoGPU gpuGuard;
 
-  // Now creating the CUDA events
+  // Now creating the CUDA streams and events
   for (size_t i = 0; i < input.size(); ++i) {
     gpuGuard.setDevice(input[i].get_device());
-    THCudaCheck(cudaEventCreate(&((*events)[i])));
+    slot.streams[i] = THCStream_new(cudaStreamNonBlocking);
+    THCudaCheck(cudaEventCreateWithFlags(&slot.events[i],
+                                         cudaEventDisableTiming));
   }
   // Create the communicator on each device of the input
   NCCL_CHECK(ncclGroupStart());
   for (size_t i = 0; i < input.size(); ++i) {
     int nRanks = int(_numProcesses) * input.size();
     gpuGuard.setDevice(input[i].get_device());
-    NCCL_CHECK(ncclCommInitRank(&((*comms)[i]),
+    NCCL_CHECK(ncclCommInitRank(&slot.comms[i],
                                 nRanks,
                                 ncclId,
                                 _rank * input.size() + i));
   }
   NCCL_CHECK(ncclGroupEnd());
+}
+
+
+void DataChannelNccl::_syncNcclStreams(NcclSlot& slot,
+                                       std::vector<at::Tensor>& input) {
+  AutoGPU gpuGuard;
+  for (size_t i = 0; i < input.size(); ++i) {
+    gpuGuard.setDevice(input[i].get_device());
+    auto stream = THCState_getCurrentStream(THDGetCudaState());
+    THCudaCheck(cudaEventRecord(slot.events[i], stream));
+    THCudaCheck(cudaStreamWaitEvent(slot.streams[i]->stream,
+                                    slot.events[i], 0));
+  }
+}
+
+
+DataChannelNccl::RequestNccl* DataChannelNccl::_finishCollective(
+    NcclSlot& slot,
+    std::vector<at::Tensor>& input,
+    std::vector<at::Tensor>& tensors,
+    bool async) {
 
-  // Move into the hash table
-  _groupNcclResources.emplace(
-      std::make_pair(groupId, NcclResources(std::move(comms),
-                                            std::move(events))));
+  AutoGPU gpuGuard;
+  for (auto& tensor : tensors) {
+    gpuGuard.setDevice(tensor.get_device());
+    for (size_t i = 0; i < input.size(); ++i) {
+      if (input[i].get_device() == tensor.get_device()) {
+        // The allocator tracks blocks by the start of the storage
+        THCCachingAllocator_recordStream(tensor.storage()->data(),
+                                         slot.streams[i]);
+        break;
+      }
+    }
+  }
 
-  return std::make_pair(_groupNcclResources[groupId].ncclComms(),
-                        _groupNcclResources[groupId].ncclCudaEvents());
+  std::vector<int> devices;
+  std::vector<cudaEvent_t> events;
+  for (size_t i = 0; i < input.size(); ++i) {
+    gpuGuard.setDevice(input[i].get_device());
+    auto ncclStream = slot.streams[i]->stream;
+    if (async) {
+      // The slot's event may be recorded again by the next collective
+      cudaEvent_t event;
+      THCudaCheck(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+      THCudaCheck(cudaEventRecord(event, ncclStream));
+      devices.push_back(input[i].get_device());
+      events.push_back(event);
+    } else {
+      auto stream = THCState_getCurrentStream(THDGetCudaState());
+      THCudaCheck(cudaEventRecord(slot.events[i], ncclStream));
+      THCudaCheck(cudaStreamWaitEvent(stream, slot.events[i], 0));
+    }
+  }
+
+  if (!async) {
+    return nullptr;
+  }
+  return new RequestNccl(std::move(devices), std::move(events));
 }
 
 
@@ -419,9 +524,7 @@ void DataChannelNccl::allReduce(std::vector<at::Tensor>& data,
   }
   _checkGroupIdValid(groupId);
 
-  auto ncclResourcePair  = _getNcclResourcePair(data, groupId);
-  auto comms = ncclResourcePair.first;
-  auto events = ncclResourcePair.second;
+  auto& slot = _getNcclSlot(data, groupId);
 
   // Guard GPU device
   AutoGPU gpuGuard;
@@ -429,23 +532,26 @@ void DataChannelNccl::allReduce(std::vector<at::Tensor>& data,
   std::unique_lock<std::mutex> cudaFreeMutexLock(
       *(THCCachingAllocator_getCudaFreeMutex()));
 
+  _syncNcclStreams(slot, data);
+
   NCCL_CHECK(ncclGroupStart());
   for (size_t i = 0; i < data.size(); ++i) {
 
     gpuGuard.setDevice(data[i].get_device());
-    auto stream = THCState_getCurrentStream(THDGetCudaState());
+    auto stream = slot.streams[i]->stream;
 
     NCCL_CHECK(ncclAllReduce(data[i].data_ptr(),
                              data[i].data_ptr(),
                              data[i].numel(),
                              _getNcclDataType(data[i].type().scalarType()),
                              ncclOp[operation],
-                             (*comms)[i],
+                             slot.comms[i],
                              stream));
-    THCudaCheck(cudaEventRecord((*events)[i], stream));
   }
   NCCL_CHECK(ncclGroupEnd());
 
+  _finishCollective(slot, data, data);
+
   cudaFreeMutexLock.unlock();
 }
 
@@ -459,6 +565,81 @@ void DataChannelNccl::allReduce(at::Tensor& data,
 }
 
 
+void DataChannelNccl::allReduceFused(std::vector<at::Tensor>& data,
+                                     THDReduceOp operation,
+                                     THDGroup groupId) {
+
+  _allReduceFused(data, operation, groupId, false);
+}
+
+
+DataChannelNccl::RequestNccl* DataChannelNccl::iallReduceFused(
+    std::vector<at::Tensor>& data,
+    THDReduceOp operation,
+    THDGroup groupId) {
+
+  return _allReduceFused(data, operation, groupId, true);
+}
+
+
+DataChannelNccl::RequestNccl* DataChannelNccl::_allReduceFused(
+    std::vector<at::Tensor>& data,
+    THDReduceOp operation,
+    THDGroup groupId,
+    bool async) {
+
+  std::unique_lock<std::mutex> channelLock(_mutex);
+
+  if (data.empty()) {
+    return async ? new RequestNccl({}, {}) : nullptr;
+  }
+  for (auto& tensor : data) {
+    if (!tensor.type().is_cuda() || tensor.type().is_sparse()) {
+      throw std::runtime_error("Only CUDA dense tensor is supported for NCCL "
+                               "collective operations");
+    }
+    if (!tensor.is_contiguous()) {
+      throw std::runtime_error("Expecting all GPU tensors to be contiguous");
+    }
+    if (tensor.get_device() != data[0].get_device()) {
+      throw std::runtime_error("Expecting all tensors of a fused all-reduce "
+                               "to be on the same GPU device");
+    }
+  }
+  _checkGroupIdValid(groupId);
+
+  // The communicator of the device is the one of a single tensor all-reduce
+  std::vector<at::Tensor> device = {data[0]};
+  auto& slot = _getNcclSlot(device, groupId);
+
+  // Guard GPU device
+  AutoGPU gpuGuard(data[0].get_device());
+
+  std::unique_lock<std::mutex> cudaFreeMutexLock(
+      *(THCCachingAllocator_getCudaFreeMutex()));
+
+  _syncNcclStreams(slot, device);
+
+  auto stream = slot.streams[0]->stream;
+  NCCL_CHECK(ncclGroupStart());
+  for (auto& tensor : data) {
+    NCCL_CHECK(ncclAllReduce(tensor.data_ptr(),
+                             tensor.data_ptr(),
+                             tensor.numel(),
+                             _getNcclDataType(tensor.type().scalarType()),
+                             ncclOp[operation],
+                             slot.comms[0],
+                             stream));
+  }
+  NCCL_CHECK(ncclGroupEnd());
+
+  auto request = _finishCollective(slot, device, data, async);
+
+  cudaFreeMutexLock.unlock();
+  return request;
+}
+
+
 void DataChannelNccl::allGather(std::vector<at::Tensor>& output,
                                 std::vector<at::Tensor>& input,
                                 THDGroup groupId) {
@@ -470,9 +651,7 @@ void DataChannelNccl::allGather(std::vector<at::Tensor>& output,
   }
   _checkGroupIdValid(groupId);
 
-  auto ncclResourcePair = _getNcclResourcePair(input, groupId);
-  auto comms = ncclResourcePair.first;
-  auto events = ncclResourcePair.second;
+  auto& slot = _getNcclSlot(input, groupId);
 
   // Guard GPU device
   AutoGPU gpuGuard;
@@ -480,22 +659,27 @@ void DataChannelNccl::allGather(std::vector<at::Tensor>& output,
   std::unique_lock<std::mutex> cudaFreeMutexLock(
       *(THCCachingAllocator_getCudaFreeMutex()));
 
+  _syncNcclStreams(slot, input);
+
   NCCL_CHECK(ncclGroupStart());
   for (size_t i = 0; i < input.size(); ++i) {
 
     gpuGuard.setDevice(input[i].get_device());
-    auto stream = THCState_getCurrentStream(THDGetCudaState());
+    auto stream = slot.streams[i]->stream;
 
     NCCL_CHECK(ncclAllGather(input[i].data_ptr(),
                              output[i].data_ptr(),
                              input[i].numel(),
                              _getNcclDataType(input[i].type().scalarType()),
-                             (*comms)[i],
+                             slot.comms[i],
                              stream));
-    THCudaCheck(cudaEventRecord((*events)[i], stream));
   }
   NCCL_CHECK(ncclGroupEnd());
 
+  std::vector<at::Tensor> tensors(input);
+  tensors.insert(tensors.end(), output.begin(), output.end());
+  _finishCollective(slot, input, tensors);
+
   cudaFreeMutexLock.unlock();
 }
 
@@ -522,9 +706,7 @@ void DataChannelNccl::reduce(std::vector<at::Tensor>& data,
   }
   _checkGroupIdValid(groupId);
 
-  auto ncclResourcePair = _getNcclResourcePair(data, groupId);
-  auto comms = ncclResourcePair.first;
-  auto events = ncclResourcePair.second;
+  auto& slot = _getNcclSlot(data, groupId);
 
   // Guard GPU device
   AutoGPU gpuGuard;
@@ -532,11 +714,13 @@ void DataChannelNccl::reduce(std::vector<at::Tensor>& data,
   std::unique_lock<std::mutex> cudaFreeMutexLock(
       *(THCCachingAllocator_getCudaFreeMutex()));
 
+  _syncNcclStreams(slot, data);
+
   NCCL_CHECK(ncclGroupStart());
   for (size_t i = 0; i < data.size(); ++i) {
 
     gpuGuard.setDevice(data[i].get_device());
-    auto stream = THCState_getCurrentStream(THDGetCudaState());
+    auto stream = slot.streams[i]->stream;
 
     NCCL_CHECK(ncclReduce(data[i].data_ptr(),
                           data[i].data_ptr(),
@@ -544,12 +728,13 @@ void DataChannelNccl::reduce(std::vector<at::Tensor>& data,
                           _getNcclDataType(data[i].type().scalarType()),
                           ncclOp[operation],
                           dstRank * data.size(),
-                          (*comms)[i],
+                          slot.comms[i],
                           stream));
-    THCudaCheck(cudaEventRecord((*events)[i], stream));
   }
   NCCL_CHECK(ncclGroupEnd());
 
+  _finishCollective(slot, data, data);
+
   cudaFreeMutexLock.unlock();
 }
 
@@ -574,9 +759,7 @@ void DataChannelNccl::broadcast(std::vector<at::Tensor>& data,
   }
   _checkGroupIdValid(groupId);
 
-  auto ncclResourcePair = _getNcclResourcePair(data, groupId);
-  auto comms = ncclResourcePair.first;
-  auto events = ncclResourcePair.second;
+  auto& slot = _getNcclSlot(data, groupId);
 
   // Guard GPU device
   AutoGPU gpuGuard;
@@ -584,22 +767,25 @@ void DataChannelNccl::broadcast(std::vector<at::Tensor>& data,
   std::unique_lock<std::mutex> cudaFreeMutexLock(
       *(THCCachingAllocator_getCudaFreeMutex()));
 
+  _syncNcclStreams(slot, data);
+
   NCCL_CHECK(ncclGroupStart());
   for (size_t i = 0; i < data.size(); ++i) {
 
     gpuGuard.setDevice(data[i].get_device());
-    auto stream = THCState_getCurrentStream(THDGetCudaState());
+    auto stream = slot.streams[i]->stream;
 
     NCCL_CHECK(ncclBcast(data[i].data_ptr(),
                          data[i].numel(),
                          _getNcclDataType(data[i].type().scalarType()),
                          srcRank * data.size(),
-                         (*comms)[i],
+                         slot.comms[i],
                          stream));
-    THCudaCheck(cudaEventRecord((*events)[i], stream));
   }
   NCCL_CHECK(ncclGroupEnd());
 
+  _finishCollective(slot, data, data);
+
   cudaFreeMutexLock.unlock();
 }
 
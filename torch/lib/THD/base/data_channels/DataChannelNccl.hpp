@@ -4,6 +4,7 @@
 #include "DataChannelUtils.hpp"
 
 #include <nccl.h>
+#include <THC/THC.h>
 
 #include <utility>
 #include <memory>
@@ -26,27 +27,45 @@
 
 namespace thd {
 
-// Type aliasing
-using NcclResourcePair =
-  std::pair<std::vector<ncclComm_t>*, std::vector<cudaEvent_t>*>;
-
 struct DataChannelNccl : DataChannel {
 
-  // Nothing to implement
-  struct RequestNccl : DataChannel::Request {};
+  // Completes once the NCCL kernels that it was created for have finished
+  struct RequestNccl : DataChannel::Request {
+    RequestNccl(std::vector<int> devices, std::vector<cudaEvent_t> events);
+    virtual ~RequestNccl();
 
-  // Wrapper on the pair of NCCL resources
-  class NcclResources {
+    // Checks if the NCCL kernels have finished on every device
+    virtual bool isCompleted() override;
+    /**
+     * Makes the current stream of every device wait for the NCCL kernels.
+     * Note that this does not block the host.
+     */
+    virtual void wait() override;
 
-  public:
+  private:
+    std::vector<int> _devices;
+    std::vector<cudaEvent_t> _events;
+  };
 
-    NcclResources() = default;
-    NcclResources(std::unique_ptr<std::vector<ncclComm_t>>&& ncclComm,
-                  std::unique_ptr<std::vector<cudaEvent_t>>&& event):
+  /**
+   * One NCCL communicator per device, together with the stream each of them
+   * runs its collectives on and an event used to order that stream with the
+   * current streams of the devices
+   */
+  struct NcclSlot {
+    std::vector<ncclComm_t> comms;
+    std::vector<THCStream*> streams;
+    std::vector<cudaEvent_t> events;
+  };
 
-      _commEventPair(std::pair<std::unique_ptr<std::vector<ncclComm_t>>,
-                               std::unique_ptr<std::vector<cudaEvent_t>>>
-                               (std::move(ncclComm), std::move(event))) {}
+  /**
+   * NCCL resources of a group. Collectives are assigned to the slots in
+   * round-robin order, so that collectives that are issued one after another
+   * run on different streams and can overlap. Every process issues the same
+   * collectives in the same order, so they all pick the same slot.
+   */
+  struct NcclResources {
+    NcclResources() : nextSlot(0) {}
     // Delete copy and assignment ctors
     NcclResources(const NcclResources&) = delete;
     NcclResources& operator=(const NcclResources&) = delete;
@@ -55,20 +74,8 @@ struct DataChannelNccl : DataChannel {
     NcclResources(NcclResources&&) = default;
     NcclResources& operator=(NcclResources&&) = default;
 
-    // Nccl Communicator Getter
-    std::vector<ncclComm_t>* ncclComms() {
-      return _commEventPair.first.get();
-    }
-
-    // Nccl CUDA event Getter
-    std::vector<cudaEvent_t>* ncclCudaEvents() {
-      return _commEventPair.second.get();
-    }
-
-  private:
-
-    std::pair<std::unique_ptr<std::vector<ncclComm_t>>,
-              std::unique_ptr<std::vector<cudaEvent_t>>> _commEventPair;
+    std::vector<NcclSlot> slots;
+    size_t nextSlot;
   };
 
 
@@ -90,6 +97,25 @@ struct DataChannelNccl : DataChannel {
                  THDReduceOp operation,
                  THDGroup groupId = THDGroupWORLD) override;
 
+  /**
+   * All-reduces every tensor of a list of tensors on the same device, with a
+   * single NCCL group call. Unlike allReduce with a list of tensors, which
+   * reduces one tensor per device, each tensor is reduced separately across
+   * the processes.
+   */
+  void allReduceFused(std::vector<at::Tensor>& data,
+                      THDReduceOp operation,
+                      THDGroup groupId = THDGroupWORLD);
+
+  /**
+   * Asynchronous version of allReduceFused. The current stream does not wait
+   * for the reduction until the returned request is waited on, so that
+   * kernels launched in the meantime overlap with it.
+   */
+  RequestNccl* iallReduceFused(std::vector<at::Tensor>& data,
+                               THDReduceOp operation,
+                               THDGroup groupId = THDGroupWORLD);
+
   void allGather(std::vector<at::Tensor>& output,
                  std::vector<at::Tensor>& input,
                  THDGroup groupId = THDGroupWORLD) override;
@@ -209,20 +235,45 @@ private:
    */
   std::unordered_map<THDGroup, std::string> _groupDevices;
 
-  /**
-   * NCCL resources for for each THDGroup including:
-   * NCCL communicator for the current group
-   * Cuda Events for all GPUs for NCCL operations of the current group
-   */
+  // NCCL communicators, streams and events of each THDGroup
   std::unordered_map<THDGroup, NcclResources> _groupNcclResources;
 
   // Existing groups
   std::unordered_map<THDGroup, DataChannel::Group> _groups;
 
 
-  // Helper function that gets the NCCL communicator
-  NcclResourcePair _getNcclResourcePair(std::vector<at::Tensor>& input,
-                                        THDGroup groupId);
+  /**
+   * Helper function that gets the next NCCL slot of the group, building the
+   * group's slots first if the devices of input changed
+   */
+  NcclSlot& _getNcclSlot(std::vector<at::Tensor>& input, THDGroup groupId);
+
+  // Creates the communicators, streams and events of a slot for input
+  void _createNcclSlot(NcclSlot& slot, std::vector<at::Tensor>& input);
+
+  /**
+   * Makes the NCCL streams of the slot wait for the current streams of the
+   * devices of input, which have input[i] on the i-th communicator
+   */
+  void _syncNcclStreams(NcclSlot& slot, std::vector<at::Tensor>& input);
+
+  /**
+   * Marks the memory of the tensors as in use by the NCCL streams, so that the
+   * caching allocator does not hand it out again before they are done with
+   * it, and orders the current streams after the NCCL streams again. If
+   * async is false the current streams wait right away, otherwise a request
+   * that makes them wait is returned.
+   */
+  RequestNccl* _finishCollective(NcclSlot& slot,
+                                 std::vector<at::Tensor>& input,
+                                 std::vector<at::Tensor>& tensors,
+                                 bool async = false);
+
+  // Helper shared by allReduceFused and iallReduceFused
+  RequestNccl* _allReduceFused(std::vector<at::Tensor>& data,
+                               THDReduceOp operation,
+                               THDGroup groupId,
+                               bool async);
 
   /**
    * Helper function that broadcasts the NCCL unique ID to everyone in the rank
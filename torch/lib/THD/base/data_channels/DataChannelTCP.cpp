@@ -1,8 +1,10 @@
 #include "DataChannelTCP.hpp"
 
 #include <sys/poll.h>
+#include <limits.h>
 #include <unistd.h>
 #include <algorithm>
+#include <cerrno>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
@@ -11,6 +13,7 @@
 #include <stdexcept>
 #include <string>
 #include <system_error>
+#include <unordered_map>
 
 
 namespace thd {
@@ -37,6 +40,31 @@ inline std::uint64_t pow2(T value) {
   return pof2;
 }
 
+// Tensors of at least this many bytes are all-reduced and broadcast with the
+// pipelined algorithms, which make the best use of bandwidth. Smaller ones use
+// the algorithms with the fewest rounds of messages.
+constexpr std::uint64_t PIPELINE_MIN_BYTES = 128 * 1024;
+// Size of the segments in which the pipelined algorithms send tensors, so that
+// one segment can be reduced or passed on while the next is still in flight.
+constexpr std::uint64_t SEGMENT_BYTES = 32 * 1024;
+
+// Splits elements [begin, end) of the one dimensional `data` into segments.
+std::vector<at::Tensor> segments(const at::Tensor& data, std::int64_t begin,
+                                 std::int64_t end) {
+  std::int64_t segment_numel = std::max<std::int64_t>(
+      1, SEGMENT_BYTES / data.type().elementSizeInBytes());
+  std::vector<at::Tensor> result;
+  for (std::int64_t i = begin; i < end; i += segment_numel)
+    result.push_back(data.narrow(0, i, std::min(segment_numel, end - i)));
+  return result;
+}
+
+void waitAll(std::vector<QueueWorker::Request>& requests) {
+  for (auto& request : requests)
+    request.wait();
+  requests.clear();
+}
+
 } // namespace
 
 
@@ -231,12 +259,54 @@ bool DataChannelTCP::init() {
       THDGroupWORLD,
       DataChannel::Group(ranks, _processes.size() - 1)
     });
+
+    detectNodes();
   }
 
   return ok;
 }
 
 
+void DataChannelTCP::detectNodes() {
+  /*
+   * Processes on the same machine have the same host name. Setting
+   * THD_RANKS_PER_NODE overrides that, and puts rank `r` on node
+   * `r / THD_RANKS_PER_NODE`.
+   */
+  _nodes.resize(_processes.size());
+
+  const char* ranks_per_node = std::getenv("THD_RANKS_PER_NODE");
+  if (ranks_per_node) {
+    long per_node = std::strtol(ranks_per_node, nullptr, 10);
+    if (per_node <= 0)
+      throw std::invalid_argument("THD_RANKS_PER_NODE has to be positive");
+    for (rank_type rank = 0; rank < _processes.size(); ++rank)
+      _nodes[rank] = rank / per_node;
+    return;
+  }
+
+  char hostname[HOST_NAME_MAX + 1] = {0};
+  if (gethostname(hostname, HOST_NAME_MAX) != 0)
+    throw std::system_error(errno, std::system_category());
+
+  std::vector<std::string> names(_processes.size());
+  names[_rank] = hostname;
+  for (rank_type rank = 0; rank < _processes.size(); ++rank) {
+    if (rank != _rank)
+      send_string(_processes[rank].socket, names[_rank]);
+  }
+  for (rank_type rank = 0; rank < _processes.size(); ++rank) {
+    if (rank != _rank)
+      names[rank] = recv_string(_processes[rank].socket);
+  }
+
+  // Nodes are numbered in the order of their lowest rank
+  std::unordered_map<std::string, std::size_t> ids;
+  for (rank_type rank = 0; rank < _processes.size(); ++rank)
+    _nodes[rank] = ids.emplace(names[rank], ids.size()).first->second;
+}
+
+
 rank_type DataChannelTCP::getRank() {
   return _rank;
 }
@@ -274,20 +344,46 @@ void DataChannelTCP::allGather(std::vector<at::Tensor>& output,
   for (auto out_tensor : output)
     assertSameSizeAndType(out_tensor, input, "allGather");
 
-  rank_type left = (group.size() + group_rank - 1) % group.size();
-  rank_type right = (group_rank + 1) % group.size();
+  rank_type size = group.size();
+  auto left = group.mustGetGlobalRank((size + group_rank - 1) % size);
+  auto right = group.mustGetGlobalRank((group_rank + 1) % size);
 
   memcpy(output[group_rank].data_ptr(), input.data_ptr(), input.type().elementSizeInBytes() * input.numel());
 
-  auto j = group_rank, jnext = left;
-  for (rank_type i = 0; i < group.size(); ++i) {
-    req_ptr send_request {isend((output[j]), group.mustGetGlobalRank(right))};
-    receive((output[jnext]), group.mustGetGlobalRank(left));
-    send_request->wait();
+  /*
+   * In step `i` every process passes on the tensor of rank `group_rank - i`
+   * to its right neighbour. Tensors are sent in segments and every received
+   * segment is passed on right away, so the steps overlap.
+   */
+  auto tensor_segments = [&](rank_type i) {
+    auto flat = output[(size + group_rank - i) % size].view({-1});
+    return segments(flat, 0, flat.numel());
+  };
+
+  std::vector<std::vector<QueueWorker::Request>> receives(size);
+  for (rank_type i = 1; i < size; ++i) {
+    for (auto& segment : tensor_segments(i)) {
+      receives[i].push_back(_receive_worker.push([this, segment, left]{
+        this->_receive(segment, left);
+      }));
+    }
+  }
 
-    j = jnext;
-    jnext = (group.size() + jnext - 1) % group.size();
+  std::vector<QueueWorker::Request> sends;
+  for (rank_type i = 0; i + 1 < size; ++i) {
+    auto send_segments = tensor_segments(i);
+    for (std::size_t k = 0; k < send_segments.size(); ++k) {
+      if (i > 0)
+        receives[i][k].wait();
+      auto& segment = send_segments[k];
+      sends.push_back(_send_worker.push([this, segment, right]{
+        this->_send(segment, right);
+      }));
+    }
   }
+  if (size > 1)
+    waitAll(receives[size - 1]);
+  waitAll(sends);
 }
 
 
@@ -362,8 +458,76 @@ void DataChannelTCP::scatter(std::vector<at::Tensor>& input,
 
 void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
                                THDGroup group_id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  const auto& group = _groups.at(group_id);
+  rank_type group_rank;
+  bool exists;
+
+  std::tie(group_rank, exists) = group.getGroupRank(_rank);
+  if (!exists || group.size() == 1)
+    return;
+
+  std::uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
+  if (tensor_bytes >= PIPELINE_MIN_BYTES && data.is_contiguous()) {
+    std::vector<rank_type> local_ranks, cross_ranks;
+    if (_splitByNode(group, local_ranks, cross_ranks)) {
+      rank_type max_rank = _processes.size() - 1;
+      DataChannel::Group local_group(local_ranks, max_rank);
+      DataChannel::Group cross_group(cross_ranks, max_rank);
+      _allReduceHierarchical(data, operation,
+                             local_group, local_group.mustGetGroupRank(_rank),
+                             cross_group, cross_group.mustGetGroupRank(_rank));
+    } else {
+      _allReduceRing(data, operation, group, group_rank);
+    }
+  } else {
+    _allReduceRecursiveDoubling(data, operation, group, group_rank);
+  }
+}
+
+
+bool DataChannelTCP::_splitByNode(const DataChannel::Group& group,
+                                  std::vector<rank_type>& local_ranks,
+                                  std::vector<rank_type>& cross_ranks) const {
+  // Members of the group on every node, nodes in the order of their first
+  // member in the group
+  std::vector<std::vector<rank_type>> node_ranks;
+  std::unordered_map<std::size_t, std::size_t> node_index;
+  for (rank_type group_rank = 0; group_rank < group.size(); ++group_rank) {
+    auto rank = group.mustGetGlobalRank(group_rank);
+    auto it = node_index.emplace(_nodes[rank], node_ranks.size()).first;
+    if (it->second == node_ranks.size())
+      node_ranks.emplace_back();
+    node_ranks[it->second].push_back(rank);
+  }
+
+  if (node_ranks.size() < 2)
+    return false;
+  auto per_node = node_ranks[0].size();
+  if (per_node < 2)
+    return false;
+  for (const auto& ranks : node_ranks) {
+    if (ranks.size() != per_node)
+      return false;
+  }
+
+  local_ranks = node_ranks[node_index.at(_nodes[_rank])];
+  auto position = std::find(local_ranks.begin(), local_ranks.end(), _rank) -
+                  local_ranks.begin();
+  cross_ranks.clear();
+  for (const auto& ranks : node_ranks)
+    cross_ranks.push_back(ranks[position]);
+  return true;
+}
+
+
+void DataChannelTCP::_allReduceRecursiveDoubling(at::Tensor& data,
+                                                 THDReduceOp operation,
+                                                 const DataChannel::Group& group,
+                                                 rank_type group_rank) {
   /*
-   * Allreduce implementation is recursive doubling algorithm. It is good
+   * Recursive doubling algorithm. It is good
    * algorithm for small sizes of message but other (theoratically better)
    * implementations could not be addapted because of non-commutative
    * operations on tensors (operation cannot be commutative because this could
@@ -376,16 +540,6 @@ void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
    *   > https://github.com/pmodels/mpich/blob/master/src/mpi/coll/allreduce.c
    */
 
-  std::lock_guard<std::mutex> lock(_mutex);
-
-  const auto& group = _groups.at(group_id);
-  rank_type group_rank;
-  bool exists;
-
-  std::tie(group_rank, exists) = group.getGroupRank(_rank);
-  if (!exists)
-    return;
-
   std::uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
   auto tmp_tensor = data.clone();
 
@@ -438,6 +592,166 @@ void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
 }
 
 
+void DataChannelTCP::_allReduceRing(at::Tensor& data, THDReduceOp operation,
+                                    const DataChannel::Group& group,
+                                    rank_type group_rank) {
+  /*
+   * Ring algorithm: a reduce-scatter followed by an allgather, each made of
+   * `size - 1` steps in which every process sends a chunk of the tensor to
+   * its right neighbour and receives another one from its left neighbour.
+   * Every process sends and receives 2 * (size - 1) / size of the tensor,
+   * whatever the number of processes.
+   *
+   * Every chunk is reduced along the ring in the same order and then copied
+   * to all processes, so results are still the same on all of them.
+   *
+   * Chunks are sent in segments, and a segment is passed on to the next
+   * step as soon as it has been received and reduced, so the steps overlap.
+   *
+   * More about efficiency can be found here:
+   *   > http://www.mcs.anl.gov/~thakur/papers/ijhpca-coll.pdf (section 4.5)
+   */
+
+  auto flat = data.view({-1});
+  _reduceScatterRing(flat, operation, group, group_rank);
+  _allGatherRing(flat, group, group_rank);
+}
+
+
+void DataChannelTCP::_allReduceHierarchical(
+    at::Tensor& data, THDReduceOp operation,
+    const DataChannel::Group& local_group, rank_type local_rank,
+    const DataChannel::Group& cross_group, rank_type cross_rank) {
+  /*
+   * Hierarchical algorithm, for groups spread evenly over several nodes:
+   *   1. a ring reduce-scatter among the processes of every node, after which
+   *      every process holds the node's sum of one chunk of the tensor,
+   *   2. an allreduce of that chunk among the processes holding the same
+   *      chunk on the other nodes,
+   *   3. a ring allgather among the processes of every node.
+   *
+   * Only the second phase goes between nodes, and only with a chunk of
+   * 1 / (processes per node) of the tensor.
+   */
+
+  auto flat = data.view({-1});
+  std::int64_t numel = flat.numel();
+  std::int64_t size = local_group.size();
+  std::int64_t chunk = (local_rank + 1) % size;
+
+  _reduceScatterRing(flat, operation, local_group, local_rank);
+
+  auto reduced = flat.narrow(0, numel * chunk / size,
+                             numel * (chunk + 1) / size - numel * chunk / size);
+  std::uint64_t chunk_bytes = reduced.type().elementSizeInBytes() *
+                              reduced.numel();
+  if (chunk_bytes >= PIPELINE_MIN_BYTES) {
+    _allReduceRing(reduced, operation, cross_group, cross_rank);
+  } else {
+    _allReduceRecursiveDoubling(reduced, operation, cross_group, cross_rank);
+  }
+
+  _allGatherRing(flat, local_group, local_rank);
+}
+
+
+void DataChannelTCP::_reduceScatterRing(at::Tensor& data,
+                                        THDReduceOp operation,
+                                        const DataChannel::Group& group,
+                                        rank_type group_rank) {
+  std::int64_t size = group.size();
+  auto left = group.mustGetGlobalRank((group_rank + size - 1) % size);
+  auto right = group.mustGetGlobalRank((group_rank + 1) % size);
+
+  auto tmp = data.clone();
+  std::int64_t numel = data.numel();
+  // Segments of the chunk `group_rank + offset` of `tensor`
+  auto chunk_segments = [&](const at::Tensor& tensor, std::int64_t offset) {
+    std::int64_t chunk = ((group_rank + offset) % size + size) % size;
+    return segments(tensor, numel * chunk / size, numel * (chunk + 1) / size);
+  };
+  std::vector<QueueWorker::Request> sends;
+  auto push_send = [&](const at::Tensor& segment) {
+    sends.push_back(_send_worker.push([this, segment, right]{
+      this->_send(segment, right);
+    }));
+  };
+
+  // In step `i` chunk `group_rank - i - 1` is received and reduced, after
+  // which chunk `group_rank + 1` is completely reduced.
+  std::vector<std::vector<QueueWorker::Request>> receives(size - 1);
+  for (std::int64_t i = 0; i < size - 1; ++i) {
+    for (auto& segment : chunk_segments(tmp, -i - 1)) {
+      receives[i].push_back(_receive_worker.push([this, segment, left]{
+        this->_receive(segment, left);
+      }));
+    }
+  }
+
+  for (auto& segment : chunk_segments(data, 0))
+    push_send(segment);
+
+  for (std::int64_t i = 0; i < size - 1; ++i) {
+    auto data_segments = chunk_segments(data, -i - 1);
+    auto tmp_segments = chunk_segments(tmp, -i - 1);
+    for (std::size_t k = 0; k < data_segments.size(); ++k) {
+      receives[i][k].wait();
+      _reduce(data_segments[k], tmp_segments[k], operation);
+      if (i < size - 2)
+        push_send(data_segments[k]);
+    }
+  }
+
+  // The chunks sent are overwritten once the reduced ones are gathered
+  waitAll(sends);
+}
+
+
+void DataChannelTCP::_allGatherRing(at::Tensor& data,
+                                    const DataChannel::Group& group,
+                                    rank_type group_rank) {
+  std::int64_t size = group.size();
+  auto left = group.mustGetGlobalRank((group_rank + size - 1) % size);
+  auto right = group.mustGetGlobalRank((group_rank + 1) % size);
+
+  std::int64_t numel = data.numel();
+  auto chunk_segments = [&](std::int64_t offset) {
+    std::int64_t chunk = ((group_rank + offset) % size + size) % size;
+    return segments(data, numel * chunk / size, numel * (chunk + 1) / size);
+  };
+  std::vector<QueueWorker::Request> sends;
+  auto push_send = [&](const at::Tensor& segment) {
+    sends.push_back(_send_worker.push([this, segment, right]{
+      this->_send(segment, right);
+    }));
+  };
+
+  // In step `i` chunk `group_rank - i` is received, and passed on unless the
+  // right neighbour already has it.
+  std::vector<std::vector<QueueWorker::Request>> receives(size - 1);
+  for (std::int64_t i = 0; i < size - 1; ++i) {
+    for (auto& segment : chunk_segments(-i)) {
+      receives[i].push_back(_receive_worker.push([this, segment, left]{
+        this->_receive(segment, left);
+      }));
+    }
+  }
+
+  for (auto& segment : chunk_segments(1))
+    push_send(segment);
+
+  for (std::int64_t i = 0; i < size - 1; ++i) {
+    auto data_segments = chunk_segments(-i);
+    for (std::size_t k = 0; k < data_segments.size(); ++k) {
+      receives[i][k].wait();
+      if (i < size - 2)
+        push_send(data_segments[k]);
+    }
+  }
+  waitAll(sends);
+}
+
+
 void DataChannelTCP::reduce(at::Tensor& data, THDReduceOp operation,
                             rank_type dst_rank, THDGroup group_id) {
   /*
@@ -484,16 +798,6 @@ void DataChannelTCP::reduce(at::Tensor& data, THDReduceOp operation,
 
 void DataChannelTCP::broadcast(at::Tensor& data, rank_type src_rank,
                                THDGroup group_id) {
-  /*
-   * General idea of this algorithm is to send data in `d` dimensional
-   * hypercube where vertices are nodes (processes) and edges are
-   * network connections which can be used to transfer data.
-   *
-   * Since hypercube algorithm works for case when broadcasting rank is 0
-   * we have to create `virtual_rank` which converts regular ranks to
-   * virtual ones where `virtual_rank` for `src_rank` is 0.
-   */
-
   std::lock_guard<std::mutex> lock(_mutex);
 
   const auto& group = _groups.at(group_id);
@@ -505,6 +809,29 @@ void DataChannelTCP::broadcast(at::Tensor& data, rank_type src_rank,
     return;
 
   auto group_src_rank = group.mustGetGroupRank(src_rank);
+  std::uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
+  if (tensor_bytes >= PIPELINE_MIN_BYTES && data.is_contiguous() && group.size() > 2) {
+    _broadcastPipeline(data, group, group_rank, group_src_rank);
+  } else {
+    _broadcastHypercube(data, group, group_rank, group_src_rank);
+  }
+}
+
+
+void DataChannelTCP::_broadcastHypercube(at::Tensor& data,
+                                         const DataChannel::Group& group,
+                                         rank_type group_rank,
+                                         rank_type group_src_rank) {
+  /*
+   * General idea of this algorithm is to send data in `d` dimensional
+   * hypercube where vertices are nodes (processes) and edges are
+   * network connections which can be used to transfer data.
+   *
+   * Since hypercube algorithm works for case when broadcasting rank is 0
+   * we have to create `virtual_rank` which converts regular ranks to
+   * virtual ones where `virtual_rank` for `src_rank` is 0.
+   */
+
   int dim = log2ceil(group.size());
   rank_type virtual_rank = (group_rank + group.size() - group_src_rank) % group.size();
   int64_t mask = (1 << dim) - 1;
@@ -527,6 +854,49 @@ void DataChannelTCP::broadcast(at::Tensor& data, rank_type src_rank,
 }
 
 
+void DataChannelTCP::_broadcastPipeline(at::Tensor& data,
+                                        const DataChannel::Group& group,
+                                        rank_type group_rank,
+                                        rank_type group_src_rank) {
+  /*
+   * Processes form a chain starting at `src_rank`. The tensor is sent down
+   * the chain in segments and every process passes on a segment as soon as
+   * it has received it, so the time is about that of sending the tensor
+   * once, rather than log2(size) times as in the hypercube algorithm.
+   */
+
+  rank_type size = group.size();
+  rank_type virtual_rank = (group_rank + size - group_src_rank) % size;
+  auto prev = group.mustGetGlobalRank((group_rank + size - 1) % size);
+  auto next = group.mustGetGlobalRank((group_rank + 1) % size);
+
+  auto flat = data.view({-1});
+  auto data_segments = segments(flat, 0, flat.numel());
+
+  std::vector<QueueWorker::Request> receives;
+  if (virtual_rank != 0) {
+    for (auto& segment : data_segments) {
+      receives.push_back(_receive_worker.push([this, segment, prev]{
+        this->_receive(segment, prev);
+      }));
+    }
+  }
+
+  std::vector<QueueWorker::Request> sends;
+  for (std::size_t k = 0; k < data_segments.size(); ++k) {
+    if (virtual_rank != 0)
+      receives[k].wait();
+    if (virtual_rank + 1 < size) {
+      auto& segment = data_segments[k];
+      sends.push_back(_send_worker.push([this, segment, next]{
+        this->_send(segment, next);
+      }));
+    }
+  }
+  waitAll(sends);
+}
+
+
 void DataChannelTCP::send(Scalar& data, rank_type dst_rank) {
   auto request = _send_worker.push([this, &data, dst_rank]{
     this->_send(data, dst_rank);
@@ -615,6 +985,36 @@ DataChannelTCP::RequestTCP* DataChannelTCP::ireceive(at::Tensor& data,
 }
 
 
+DataChannelTCP::RequestTCP* DataChannelTCP::iallGather(std::vector<at::Tensor>& output,
+                                                       at::Tensor& input,
+                                                       THDGroup group_id) {
+  auto request = _collective_worker.push([this, output, input, group_id]() mutable {
+    this->allGather(output, input, group_id);
+  });
+  return new DataChannelTCP::RequestTCP(std::move(request));
+}
+
+
+DataChannelTCP::RequestTCP* DataChannelTCP::iallReduce(at::Tensor& data,
+                                                       THDReduceOp operation,
+                                                       THDGroup group_id) {
+  auto request = _collective_worker.push([this, data, operation, group_id]() mutable {
+    this->allReduce(data, operation, group_id);
+  });
+  return new DataChannelTCP::RequestTCP(std::move(request));
+}
+
+
+DataChannelTCP::RequestTCP* DataChannelTCP::ibroadcast(at::Tensor& data,
+                                                       rank_type src_rank,
+                                                       THDGroup group_id) {
+  auto request = _collective_worker.push([this, data, src_rank, group_id]() mutable {
+    this->broadcast(data, src_rank, group_id);
+  });
+  return new DataChannelTCP::RequestTCP(std::move(request));
+}
+
+
 void DataChannelTCP::barrier(THDGroup group_id) {
   /*
    * Barrier is implementation of Bruck algorithm. All processes send to
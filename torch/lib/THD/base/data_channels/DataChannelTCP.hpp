@@ -69,6 +69,18 @@ struct DataChannelTCP : DataChannel {
   RequestTCP* isend(at::Tensor& data, rank_type dst_rank) override;
   RequestTCP* ireceive(at::Tensor& data, rank_type src_rank) override;
 
+  /*
+   * Asynchronous versions of the collectives. They run on a background
+   * thread in the order in which they were started, and the tensors must not
+   * be used until the returned request completes.
+   */
+  RequestTCP* iallGather(std::vector<at::Tensor>& output, at::Tensor& input,
+                         THDGroup group_id = THDGroupWORLD);
+  RequestTCP* iallReduce(at::Tensor& data, THDReduceOp operation,
+                         THDGroup group_id = THDGroupWORLD);
+  RequestTCP* ibroadcast(at::Tensor& data, rank_type src_rank,
+                         THDGroup group_id = THDGroupWORLD);
+
   void barrier(THDGroup group_id = THDGroupWORLD) override;
 
   THDGroup newGroup(const std::vector<rank_type>& ranks) override;
@@ -86,6 +98,7 @@ private:
 
   bool initMaster();
   bool initWorker();
+  void detectNodes();
 
   void _send(const Scalar& data, rank_type dst_id);
   void _send(const at::Tensor& data, rank_type dst_id);
@@ -94,6 +107,39 @@ private:
   void _reduce(at::Tensor& result, at::Tensor& data,
                THDReduceOp operation) const;
 
+  void _allReduceRecursiveDoubling(at::Tensor& data, THDReduceOp operation,
+                                   const DataChannel::Group& group,
+                                   rank_type group_rank);
+  void _allReduceRing(at::Tensor& data, THDReduceOp operation,
+                      const DataChannel::Group& group, rank_type group_rank);
+  void _allReduceHierarchical(at::Tensor& data, THDReduceOp operation,
+                              const DataChannel::Group& local_group,
+                              rank_type local_rank,
+                              const DataChannel::Group& cross_group,
+                              rank_type cross_rank);
+  // Ring reduce-scatter of the one dimensional `data` split into
+  // `group.size()` chunks, after which chunk `group_rank + 1` is reduced.
+  void _reduceScatterRing(at::Tensor& data, THDReduceOp operation,
+                          const DataChannel::Group& group,
+                          rank_type group_rank);
+  // Ring allgather of the chunks of `data`, of which this process holds
+  // chunk `group_rank + 1`.
+  void _allGatherRing(at::Tensor& data, const DataChannel::Group& group,
+                      rank_type group_rank);
+  /*
+   * Splits the members of `group` into the ones on the same node as this
+   * process and the ones with the same position as this process on the other
+   * nodes. Returns false if the group does not span several nodes with the
+   * same number of its members, more than one, on each of them.
+   */
+  bool _splitByNode(const DataChannel::Group& group,
+                    std::vector<rank_type>& local_ranks,
+                    std::vector<rank_type>& cross_ranks) const;
+  void _broadcastHypercube(at::Tensor& data, const DataChannel::Group& group,
+                           rank_type group_rank, rank_type group_src_rank);
+  void _broadcastPipeline(at::Tensor& data, const DataChannel::Group& group,
+                          rank_type group_rank, rank_type group_src_rank);
+
 
   rank_type _rank; // Rank of current process, range: [0.._processes.size()-1]
   int _socket; // Socket on which process is listening
@@ -101,6 +147,8 @@ private:
   int _timeout; // Accept waiting timeout in milliseconds (it is optional, default = infinity)
 
   std::vector<Process> _processes; // Other processes in network
+  // Node of every process, processes with the same node share a machine
+  std::vector<std::size_t> _nodes;
   std::unique_ptr<struct pollfd[]> _poll_events; // Events array for `poll`
 
   // General mutex for methods - to protect access to the TCP data channel.
@@ -111,6 +159,8 @@ private:
 
   // Workers
   QueueWorker _send_worker, _receive_worker;
+  // Runs the asynchronous collectives, which use the other two workers
+  QueueWorker _collective_worker;
 
 };
 
@@ -58,8 +58,7 @@ private:
 
     void wait() {
       std::unique_lock<std::mutex> ulock(_mutex);
-      if (!_completed)
-        _cond.wait(ulock);
+      _cond.wait(ulock, [this]{ return _completed.load(); });
 
       _validate();
     }
@@ -93,7 +92,11 @@ public:
   }
 
   ~QueueWorker() {
-    _exiting = true;
+    {
+      // Set under the lock, or the runner could miss the notification
+      std::lock_guard<std::mutex> lock(_mutex);
+      _exiting = true;
+    }
     _cond.notify_one();
     _main_thread.join();
   }
@@ -109,8 +112,7 @@ public:
 private:
   std::shared_ptr<Task> _pop() {
     std::unique_lock<std::mutex> ulock(_mutex);
-    if (_queue.empty())
-      _cond.wait(ulock);
+    _cond.wait(ulock, [this]{ return _exiting || !_queue.empty(); });
 
     if (_exiting) // check if we were woken up by destructor
       return nullptr;
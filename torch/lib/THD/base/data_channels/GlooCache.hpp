@@ -24,6 +24,8 @@
 #include <THC/THC.h>
 #endif
 #include <cstdint>
+#include <cstdlib>
+#include <list>
 #include <memory>
 #include <tuple>
 #include <vector>
@@ -49,6 +51,9 @@ const int UNUSED_STREAM = -1;
 const rank_type UNUSED_RANK = -1;
 const std::size_t UNUSED_BYTES = 0;
 
+// Number of algorithms kept per group, unless THD_GLOO_CACHE_SIZE says otherwise
+const std::size_t DEFAULT_CACHE_SIZE = 64;
+
 // Forward declaration
 template<CollectiveType D, typename T>
 struct algorithm_spec;
@@ -81,11 +86,31 @@ struct GlooCache {
     std::shared_ptr<std::mutex>      // mutex to protect same algorithm from running concurrently
   >;
 
+  /**
+   * Algorithms are kept in a least recently used list per group, and once a
+   * group has more than `capacity` of them the least recently used one is
+   * dropped. Every process of a group sees the same sequence of collectives
+   * on it, so they all drop (and later recreate) the same algorithms.
+   * Evicting across groups would not have that property, because processes
+   * belong to different sets of groups.
+   *
+   * The capacity can be set with THD_GLOO_CACHE_SIZE, which has to be the same
+   * for all processes. 0 disables eviction.
+   */
   GlooCache(rank_type rank,
             std::vector<std::shared_ptr<::gloo::transport::Device>> deviceList)
    : _rank(rank)
    , _deviceList(deviceList)
-  {}
+   , _capacity(gloo_cache::DEFAULT_CACHE_SIZE)
+  {
+    const char* capacity = std::getenv("THD_GLOO_CACHE_SIZE");
+    if (capacity) {
+      long value = std::strtol(capacity, nullptr, 10);
+      if (value < 0)
+        throw std::invalid_argument("THD_GLOO_CACHE_SIZE can't be negative");
+      _capacity = value;
+    }
+  }
 
   GlooCache(GlooCache const&)      = delete;
   void operator=(GlooCache const&) = delete;
@@ -152,29 +177,58 @@ struct GlooCache {
     }
   }
 
+  /**
+   * Rounds a number of elements up to the size of the buffer used for it.
+   * Sizes are bucketed into 8 steps per power of two, so that tensors of
+   * varying sizes share a few algorithms, each padded by at most 1/8.
+   */
+  static std::size_t bucket_count(std::size_t count) {
+    std::size_t step = 1;
+    while ((step << 3) <= count)
+      step <<= 1;
+    return (count + step - 1) / step * step;
+  }
+
   template<CollectiveType D, typename T, typename... Args>
   value_type getAlgorithm(THDGroup group_id, const DataChannelGloo::Group& group,
                           Args... args) {
     auto key = gloo_cache::algorithm_spec<D, T>::key(group_id, args...);
 
     std::unique_lock<std::mutex> lock(_mutex);
+    auto& lru = _lru[group_id];
     auto it = _algorithms.find(key);
-    if (it == _algorithms.end()) {
-      lock.unlock();
-
-      auto algorithm = gloo_cache::algorithm_spec<D, T>::create(*this, group,
-              print_key(key), std::forward<Args>(args)...);
-
-      lock.lock();
+    if (it != _algorithms.end()) {
+      lru.splice(lru.begin(), lru, it->second.second);
+      return it->second.first;
+    }
 
-      bool inserted;
-      std::tie(it, inserted) = _algorithms.emplace(
-        std::move(key), std::move(algorithm));
-      if (!inserted)
-          throw std::runtime_error("detected a race when creating Gloo algorithm");
+    // The store keys of a context can't be reused, so an algorithm that is
+    // created again after having been evicted needs a new prefix.
+    auto prefix = print_key(key) + "-" + std::to_string(_created[key]++);
+    lock.unlock();
+
+    auto algorithm = gloo_cache::algorithm_spec<D, T>::create(*this, group,
+            prefix, std::forward<Args>(args)...);
+
+    lock.lock();
+
+    bool inserted;
+    std::tie(it, inserted) = _algorithms.emplace(
+      key, std::make_pair(std::move(algorithm), lru.end()));
+    if (!inserted)
+        throw std::runtime_error("detected a race when creating Gloo algorithm");
+    lru.push_front(std::move(key));
+    it->second.second = lru.begin();
+    auto result = it->second.first;
+
+    // Callers hold on to the algorithm and buffers they got, so evicting
+    // them here doesn't affect collectives that are running
+    while (_capacity > 0 && lru.size() > _capacity) {
+      _algorithms.erase(lru.back());
+      lru.pop_back();
     }
 
-    return it->second;
+    return result;
   }
 
   static void memcpy_input(value_type& info, at::Tensor& t) {
@@ -231,7 +285,12 @@ private:
 
   std::mutex _mutex;
 
-  std::unordered_map<key_type, value_type> _algorithms;
+  std::size_t _capacity;
+  // Keys of every group's algorithms, most recently used first
+  std::unordered_map<THDGroup, std::list<key_type>> _lru;
+  std::unordered_map<key_type, std::pair<value_type, std::list<key_type>::iterator>> _algorithms;
+  // Number of times an algorithm was created for a key
+  std::unordered_map<key_type, std::size_t> _created;
 };
 
 namespace gloo_cache {
@@ -21,6 +21,7 @@ enum class QueryType : std::uint8_t {
 Store::StoreDeamon::StoreDeamon(int listen_socket)
  : _listen_socket(listen_socket)
  , _keys_awaited()
+ , _awaiting_get()
  , _sockets()
 {
   _deamon = std::thread(&Store::StoreDeamon::deamon, this);
@@ -58,6 +59,7 @@ void Store::StoreDeamon::deamon() {
       int sock_fd = std::get<0>(accept(_listen_socket));
       _sockets.push_back(sock_fd);
       _keys_awaited.push_back(0);
+      _awaiting_get.push_back(false);
       fds.push_back({ .fd = sock_fd, .events = POLLIN });
     }
     for (std::size_t rank = 0; rank < _sockets.size(); rank++) {
@@ -101,15 +103,29 @@ void Store::StoreDeamon::query(rank_type rank) {
     auto to_wake = _waiting.find(key);
     if (to_wake != _waiting.end()) {
       for (int proc : to_wake->second) {
-        if (--_keys_awaited[proc] == 0)
-          send_value<QueryType>(_sockets[proc], QueryType::STOP_WAITING);
+        if (--_keys_awaited[proc] == 0) {
+          if (_awaiting_get[proc]) {
+            _awaiting_get[proc] = false;
+            send_vector(_sockets[proc], _store.at(key));
+          } else {
+            send_value<QueryType>(_sockets[proc], QueryType::STOP_WAITING);
+          }
+        }
       }
       _waiting.erase(to_wake);
     }
   } else if (qt == QueryType::GET) {
+    // A key that isn't set yet is sent as soon as it is, which saves
+    // clients a separate WAIT
     std::string key = recv_string(socket);
-    std::vector<char> data = _store.at(key);
-    send_vector(socket, data);
+    auto it = _store.find(key);
+    if (it != _store.end()) {
+      send_vector(socket, it->second);
+    } else {
+      _waiting[key].push_back(rank);
+      _keys_awaited[rank] = 1;
+      _awaiting_get[rank] = true;
+    }
   } else if (qt == QueryType::WAIT) {
     size_type nargs;
     recv_bytes<size_type>(socket, &nargs, 1);
@@ -177,7 +193,6 @@ void Store::set(const std::string& key, const std::vector<char>& data) {
 }
 
 std::vector<char> Store::get(const std::string& key) {
-  wait({key});
   send_value<QueryType>(_socket, QueryType::GET);
   send_string(_socket, key);
   return recv_vector<char>(_socket);
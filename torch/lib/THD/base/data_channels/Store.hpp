@@ -33,6 +33,9 @@ private:
     store_type _store;
     std::unordered_map<std::string, std::vector<rank_type>> _waiting;
     std::vector<std::size_t> _keys_awaited;
+    // Whether the keys a process waits for were asked for by a GET, which
+    // is answered with the data rather than STOP_WAITING
+    std::vector<bool> _awaiting_get;
     std::vector<int> _sockets;
   };
 
@@ -28,6 +28,15 @@ void sendMessage(int socket, std::unique_ptr<rpc::RPCMessage> msg) {
   );
 }
 
+// Appends the message to `buffer` framed the way `receiveMessage` reads it.
+void appendMessage(std::string& buffer, rpc::RPCMessage& msg) {
+  auto& bytes = msg.bytes();
+  std::uint64_t msg_length = static_cast<std::uint64_t>(bytes.length());
+
+  buffer.append(reinterpret_cast<const char*>(&msg_length), sizeof(msg_length));
+  buffer.append(bytes.data(), msg_length);
+}
+
 std::unique_ptr<rpc::RPCMessage> receiveMessage(int socket) {
   std::uint64_t msg_length;
   recv_bytes<std::uint64_t>(socket, &msg_length, 1);
@@ -48,12 +57,19 @@ MasterCommandChannel::MasterCommandChannel(InitMethod::Config config)
   , _poll_events(nullptr)
   , _error_pipe(-1)
   , _error(nullptr)
-  , _mutexes(config.world_size)
 {
   _sockets[0] = config.master.listen_socket;
+  for (std::size_t i = 0; i < _sockets.size(); ++i) {
+    _outboxes.emplace_back(new Outbox());
+  }
 }
 
 MasterCommandChannel::~MasterCommandChannel() {
+  // Send what is still queued before telling the workers to exit.
+  for (std::size_t i = 1; i < _outboxes.size(); ++i) {
+    stopSender(i);
+  }
+
   if (_error_thread.joinable()) {
     if (::write(_error_pipe, "exit", 4) != 4) {
       std::cerr << "Failed to notify error thread" << std::endl;
@@ -68,7 +84,7 @@ MasterCommandChannel::~MasterCommandChannel() {
     auto socket = _sockets[i];
     if (socket == -1) continue;
     try {
-      sendMessage(rpc::packMessage(Functions::exit), i);
+      ::thd::sendMessage(socket, rpc::packMessage(Functions::exit));
     } catch(...) {}
     ::close(socket);
   }
@@ -100,6 +116,15 @@ bool MasterCommandChannel::init() {
   _sockets[0] = fd[0];
   _error_pipe = fd[1];
   _error_thread = std::thread(&MasterCommandChannel::errorHandler, this);
+
+  for (std::size_t i = 1; i < _outboxes.size(); ++i) {
+    auto& outbox = *_outboxes[i];
+    std::promise<void> nothing_sent;
+    nothing_sent.set_value();
+    outbox.sent_future = nothing_sent.get_future().share();
+    outbox.queued_future = outbox.queued_promise.get_future().share();
+    outbox.sender = std::thread(&MasterCommandChannel::senderLoop, this, i);
+  }
   return true;
 }
 
@@ -116,7 +141,10 @@ void MasterCommandChannel::errorHandler() {
   }
 }
 
-void MasterCommandChannel::sendMessage(std::unique_ptr<rpc::RPCMessage> msg, int rank) {
+std::shared_future<void> MasterCommandChannel::sendMessage(
+  std::unique_ptr<rpc::RPCMessage> msg,
+  int rank
+) {
   // Throw error received from a worker.
   if (_error) {
     throw std::runtime_error(*_error);
@@ -126,8 +154,86 @@ void MasterCommandChannel::sendMessage(std::unique_ptr<rpc::RPCMessage> msg, int
     throw std::domain_error("sendMessage received invalid rank as parameter");
   }
 
-  std::lock_guard<std::mutex> guard(_mutexes[rank]);
-  ::thd::sendMessage(_sockets[rank], std::move(msg));
+  auto& outbox = *_outboxes[rank];
+  std::lock_guard<std::mutex> guard(outbox.mutex);
+  // Throw error of sending an earlier message, the worker has missed it.
+  if (outbox.send_error) {
+    std::rethrow_exception(outbox.send_error);
+  }
+
+  bool was_empty = outbox.queued.empty();
+  appendMessage(outbox.queued, *msg);
+  if (was_empty) {
+    outbox.cv.notify_one();
+  }
+  return outbox.queued_future;
+}
+
+std::shared_future<void> MasterCommandChannel::flush(int rank) {
+  if ((rank <= 0) || (rank >= _sockets.size())) {
+    throw std::domain_error("flush received invalid rank as parameter");
+  }
+
+  auto& outbox = *_outboxes[rank];
+  std::lock_guard<std::mutex> guard(outbox.mutex);
+  if (outbox.send_error) {
+    std::rethrow_exception(outbox.send_error);
+  }
+  return outbox.queued.empty() ? outbox.sent_future : outbox.queued_future;
+}
+
+void MasterCommandChannel::senderLoop(int rank) {
+  auto& outbox = *_outboxes[rank];
+  std::string sending;
+  while (true) {
+    std::promise<void> sending_promise;
+    {
+      std::unique_lock<std::mutex> lock(outbox.mutex);
+      outbox.cv.wait(lock, [&outbox] {
+        return !outbox.queued.empty() || outbox.exiting;
+      });
+      if (outbox.queued.empty()) {
+        return;
+      }
+      // Everything queued while the previous batch was written goes out in
+      // one write, new messages are queued for the next one meanwhile.
+      sending.clear();
+      std::swap(sending, outbox.queued);
+      sending_promise = std::move(outbox.queued_promise);
+      outbox.sent_future = outbox.queued_future;
+      outbox.queued_promise = std::promise<void>();
+      outbox.queued_future = outbox.queued_promise.get_future().share();
+    }
+
+    try {
+      send_bytes<char>(_sockets[rank], sending.data(), sending.size());
+      sending_promise.set_value();
+    } catch (...) {
+      auto error = std::current_exception();
+      {
+        std::lock_guard<std::mutex> guard(outbox.mutex);
+        outbox.send_error = error;
+        outbox.queued.clear();
+        outbox.queued_promise.set_exception(error);
+      }
+      sending_promise.set_exception(error);
+      return;
+    }
+  }
+}
+
+void MasterCommandChannel::stopSender(int rank) {
+  auto& outbox = *_outboxes[rank];
+  if (!outbox.sender.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(outbox.mutex);
+    outbox.exiting = true;
+  }
+  outbox.cv.notify_one();
+  outbox.sender.join();
 }
 
 std::tuple<rank_type, std::string> MasterCommandChannel::recvError() {
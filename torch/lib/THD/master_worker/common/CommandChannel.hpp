@@ -4,6 +4,9 @@
 
 #include <sys/poll.h>
 #include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -19,11 +22,43 @@ struct MasterCommandChannel {
 
   bool init();
 
-  void sendMessage(std::unique_ptr<rpc::RPCMessage> msg, int rank);
+  /*
+   * Queues the message for the worker and returns without waiting for it to
+   * be sent. Each worker has a sender thread which writes the queued
+   * messages in order, coalescing the ones queued meanwhile into a single
+   * write, so that a stream of operations doesn't cost a round of syscalls
+   * and packets each. The returned future completes once the message is
+   * written to the socket, and holds the error if writing failed.
+   */
+  std::shared_future<void> sendMessage(std::unique_ptr<rpc::RPCMessage> msg, int rank);
+
+  /*
+   * Returns a future that completes once every message queued for the
+   * worker so far is sent. Callers that wait for an answer of the worker on
+   * the data channel have to wait for it first, or the worker may not have
+   * got the command yet.
+   */
+  std::shared_future<void> flush(int rank);
 
 private:
+  struct Outbox {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::string queued; // length-prefixed messages not sent yet
+    bool exiting = false;
+    // completes when the messages in `queued` are sent
+    std::promise<void> queued_promise;
+    std::shared_future<void> queued_future;
+    // completes when the messages handed to the sender last are sent
+    std::shared_future<void> sent_future;
+    std::exception_ptr send_error;
+    std::thread sender;
+  };
+
   std::tuple<rank_type, std::string> recvError();
   void errorHandler();
+  void senderLoop(int rank);
+  void stopSender(int rank);
 
   rank_type _rank;
   std::vector<int> _sockets;
@@ -32,7 +67,7 @@ private:
   int _error_pipe; // informs error handler thread that we are exiting
   std::unique_ptr<std::string> _error;
   std::thread _error_thread;
-  std::vector<std::mutex> _mutexes;
+  std::vector<std::unique_ptr<Outbox>> _outboxes;
 };
 
 struct WorkerCommandChannel {
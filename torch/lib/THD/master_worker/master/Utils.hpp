@@ -1,9 +1,12 @@
 #pragma once
 
 #include "process_group/General.hpp"
+#include "master_worker/master/Master.hpp"
 
 template<typename T>
 T receiveValueFromWorker(int worker_id) {
+  // The command computing the value may still be queued.
+  thd::master::masterCommandChannel->flush(worker_id).get();
   thd::RPCType type = thd::type_traits<T>::type;
   if (thd::isInteger(type)) {
     thd::IntScalar wrapped_value;
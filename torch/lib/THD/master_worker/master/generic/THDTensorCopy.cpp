@@ -12,7 +12,7 @@ void THDTensor_(copyFromMaster)(THDTensor* to, THDTensorDescriptor* from) {
   masterCommandChannel->sendMessage(
     packMessage(Functions::tensorCopyFromMaster, to),
     THDState::s_current_worker
-  );
+  ).get();
 
   thd::dataChannel->send(*from, THDState::s_current_worker);
 }
@@ -22,7 +22,7 @@ void THDTensor_(copyFromWorker)(THDTensorDescriptor* to, THDTensor* from) {
   masterCommandChannel->sendMessage(
     packMessage(Functions::tensorCopyFromWorker, from),
     THDState::s_current_worker
-  );
+  ).get();
 
   thd::dataChannel->receive(*to, THDState::s_current_worker);
 }
@@ -0,0 +1,74 @@
+#include "AsyncWork.hpp"
+
+namespace thd {
+
+AsyncWork::Request::Request(std::shared_ptr<State> state)
+  : _state(std::move(state)) {}
+
+AsyncWork::Request::~Request() {}
+
+bool AsyncWork::Request::isCompleted() {
+  std::lock_guard<std::mutex> lock(_state->mutex);
+  return _state->completed;
+}
+
+void AsyncWork::Request::wait() {
+  std::unique_lock<std::mutex> lock(_state->mutex);
+  _state->cv.wait(lock, [this] { return _state->completed; });
+  if (_state->error)
+    std::rethrow_exception(_state->error);
+}
+
+AsyncWork::AsyncWork()
+  : _stop(false)
+  , _thread(&AsyncWork::run, this) {}
+
+AsyncWork::~AsyncWork() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _cv.notify_one();
+  _thread.join();
+}
+
+DataChannel::Request* AsyncWork::enqueue(std::function<void()> work) {
+  auto state = std::make_shared<State>();
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queue.emplace(std::move(work), state);
+  }
+  _cv.notify_one();
+  return new Request(std::move(state));
+}
+
+void AsyncWork::run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    _cv.wait(lock, [this] { return _stop || !_queue.empty(); });
+    if (_queue.empty())
+      return;
+
+    auto item = std::move(_queue.front());
+    _queue.pop();
+    lock.unlock();
+
+    std::exception_ptr error;
+    try {
+      item.first();
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    auto& state = *item.second;
+    {
+      std::lock_guard<std::mutex> state_lock(state.mutex);
+      state.completed = true;
+      state.error = error;
+    }
+    state.cv.notify_all();
+    lock.lock();
+  }
+}
+
+} // namespace thd
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../base/DataChannel.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+
+namespace thd {
+
+/*
+ * Runs collectives on a background thread, one at a time and in the order in
+ * which they were queued. As long as every process queues the same
+ * collectives in the same order they match up, while the queueing thread
+ * keeps on computing.
+ */
+struct AsyncWork {
+  AsyncWork();
+  // Finishes the queued work before returning.
+  ~AsyncWork();
+
+  // Queues `work` and returns a request that completes when it has run. The
+  // request rethrows from `wait` whatever `work` threw.
+  DataChannel::Request* enqueue(std::function<void()> work);
+
+private:
+  struct State {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool completed = false;
+    std::exception_ptr error;
+  };
+
+  struct Request : DataChannel::Request {
+    explicit Request(std::shared_ptr<State> state);
+    virtual ~Request();
+
+    virtual bool isCompleted() override;
+    virtual void wait() override;
+
+  private:
+    std::shared_ptr<State> _state;
+  };
+
+  void run();
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::queue<std::pair<std::function<void()>, std::shared_ptr<State>>> _queue;
+  bool _stop;
+  std::thread _thread;
+};
+
+} // namespace thd
@@ -27,6 +27,14 @@ void THDAllReduce(THDTensorDescriptor& desc, THDReduceOp operation, THDGroup gro
   dataChannel->allReduce(desc, operation, group);
 }
 
+THDRequest* THDIAllReduce(THDTensorDescriptor& desc, THDReduceOp operation,
+                          THDGroup group) {
+  at::Tensor data = desc;
+  return asyncWork->enqueue([data, operation, group]() mutable {
+    dataChannel->allReduce(data, operation, group);
+  });
+}
+
 void THDReduceMultiGPU(THDTensorDescriptor* desc,
                        size_t len,
                        THDReduceOp operation,
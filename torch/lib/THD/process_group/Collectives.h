@@ -11,6 +11,10 @@ THD_API void THDAllReduceMultiGPU(THDTensorDescriptor* data,
                                   THDGroup group);
 THD_API void THDAllReduce(THDTensorDescriptor& desc, THDReduceOp operation,
                           THDGroup group);
+// Queues an all-reduce of desc that runs in the background, after the ones
+// queued before it. No other collective may be issued until it completes.
+THD_API THDRequest* THDIAllReduce(THDTensorDescriptor& desc, THDReduceOp operation,
+                                  THDGroup group);
 THD_API void THDReduceMultiGPU(THDTensorDescriptor* desc,
                                size_t len,
                                THDReduceOp operation,
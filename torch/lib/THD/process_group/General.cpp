@@ -3,6 +3,7 @@
 
 namespace thd {
 std::unique_ptr<DataChannel> dataChannel;
+std::unique_ptr<AsyncWork> asyncWork;
 } // namespace thd
 
 using namespace thd;
@@ -14,11 +15,14 @@ void THDProcessGroupInit(THDChannelType channel_type, std::string init_method =
       thd::DataChannel::newChannel(channel_type, init_method, world_size,
                                    group_name, rank));
   dataChannel->init();
+  asyncWork = std::unique_ptr<AsyncWork>(new AsyncWork());
   END_HANDLE_EXCEPTIONS
 }
 
 void THDProcessGroupDestroy() {
   HANDLE_EXCEPTIONS
+  // Queued collectives still need the data channel
+  asyncWork.reset(nullptr);
   if (dataChannel) {
     dataChannel->destroy();
     dataChannel.reset(nullptr);
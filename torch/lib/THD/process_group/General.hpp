@@ -1,9 +1,11 @@
 #pragma once
 
 #include "base/DataChannel.hpp"
+#include "AsyncWork.hpp"
 #include "General.h"
 #include <memory>
 
 namespace thd {
 extern std::unique_ptr<DataChannel> dataChannel;
+extern std::unique_ptr<AsyncWork> asyncWork;
 } // namespace thd
@@ -143,6 +143,55 @@ void test_allReduce(std::shared_ptr<thd::DataChannel> data_channel, int workers)
                          -1, data_channel->getNumProcesses() - 1);
 }
 
+void test_allReduce_large(std::shared_ptr<thd::DataChannel> data_channel, int workers) {
+  // Big enough for the pipelined algorithms, and not a multiple of the
+  // number of processes
+  auto int_tensor = buildTensor<int>({257, 1023}, data_channel->getRank() + 1);
+  data_channel->allReduce(*int_tensor, THDReduceOp::THDReduceSUM, 0);
+  ASSERT_TENSOR_VALUE(int, *int_tensor, (workers + 1) * (workers + 2) / 2)
+
+  auto float_tensor = buildTensor<float>({257, 1023}, data_channel->getRank());
+  data_channel->allReduce(*float_tensor, THDReduceOp::THDReduceMAX, 0);
+  ASSERT_TENSOR_VALUE(float, *float_tensor, workers)
+}
+
+void test_broadcast_large(std::shared_ptr<thd::DataChannel> data_channel) {
+  for (std::size_t dest = 0; dest < data_channel->getNumProcesses(); ++dest) {
+    auto value = data_channel->getRank() == dest ? 10.123 : -1.0;
+    auto float_tensor = buildTensor<float>({257, 1023}, value);
+    data_channel->broadcast(*float_tensor, dest);
+    ASSERT_TENSOR_VALUE(float, *float_tensor, 10.123)
+  }
+}
+
+void test_async_collectives(std::shared_ptr<thd::DataChannel> data_channel, int workers) {
+  auto tcp_channel = std::dynamic_pointer_cast<thd::DataChannelTCP>(data_channel);
+  if (!tcp_channel) {
+    return; // XXX: only TCP has asynchronous collectives
+  }
+
+  auto small_tensor = buildTensor<int>({1, 2, 3}, data_channel->getRank() + 1);
+  auto large_tensor = buildTensor<int>({257, 1023}, data_channel->getRank() + 1);
+  auto bcast_tensor = buildTensor<int>({257, 1023}, data_channel->getRank() == 0 ? 7 : -1);
+  std::unique_ptr<thd::DataChannel::Request> requests[] = {
+    std::unique_ptr<thd::DataChannel::Request>(
+      tcp_channel->iallReduce(*small_tensor, THDReduceOp::THDReduceSUM)),
+    std::unique_ptr<thd::DataChannel::Request>(
+      tcp_channel->iallReduce(*large_tensor, THDReduceOp::THDReduceSUM)),
+    std::unique_ptr<thd::DataChannel::Request>(
+      tcp_channel->ibroadcast(*bcast_tensor, 0)),
+  };
+
+  for (auto& request : requests)
+    request->wait();
+  for (auto& request : requests)
+    assert(request->isCompleted());
+
+  ASSERT_TENSOR_VALUE(int, *small_tensor, (workers + 1) * (workers + 2) / 2)
+  ASSERT_TENSOR_VALUE(int, *large_tensor, (workers + 1) * (workers + 2) / 2)
+  ASSERT_TENSOR_VALUE(int, *bcast_tensor, 7)
+}
+
 void test_scatter(std::shared_ptr<thd::DataChannel> data_channel) {
   if (g_data_channel_type == "gloo") {
     return; // XXX: Gloo does not support scatter
@@ -618,6 +667,9 @@ void run_all_tests(std::shared_ptr<thd::DataChannel> data_channel, int workers)
   test_broadcast(data_channel);
   test_reduce(data_channel, workers);
   test_allReduce(data_channel, workers);
+  test_allReduce_large(data_channel, workers);
+  test_broadcast_large(data_channel);
+  test_async_collectives(data_channel, workers);
   test_scatter(data_channel);
   test_gather(data_channel);
   test_allGather(data_channel);
@@ -673,6 +725,19 @@ void init_tcp_worker(unsigned int id, int workers) {
   run_all_tests(worker_channel, workers);
 }
 
+void run_tcp(int workers) {
+  // start tcp master
+  std::thread tcp_master_thread(init_tcp_master, workers);
+
+  // start tcp worker
+  for (int id = 1; id <= workers; ++id) {
+    g_all_workers.push_back(std::thread(init_tcp_worker, id, workers));
+  }
+
+  tcp_master_thread.join();
+  g_all_workers.clear();
+}
+
 #ifdef WITH_GLOO
 void init_gloo_master(int workers) {
   g_mutex.lock();
@@ -720,20 +785,20 @@ int main(int argc, char const *argv[]) {
     g_data_channel_type = "tcp";
     for (auto workers : WORKERS_NUM) {
       std::cout << "TCP (workers: " << workers << "):" << std::endl;
-      // start tcp master
-      std::thread tcp_master_thread(init_tcp_master, workers);
-
-      // start tcp worker
-      for (int id = 1; id <= workers; ++id) {
-        g_all_workers.push_back(std::thread(init_tcp_worker, id, workers));
-      }
-
-      tcp_master_thread.join();
-      g_all_workers.clear();
-
+      run_tcp(workers);
       std::cout << "TCP - OK" << std::endl;
     }
 
+    // Pretend that every two processes share a node, so that the large
+    // all-reduces of even numbers of processes are hierarchical
+    setenv("THD_RANKS_PER_NODE", "2", 1);
+    for (auto workers : WORKERS_NUM) {
+      std::cout << "TCP hierarchical (workers: " << workers << "):" << std::endl;
+      run_tcp(workers);
+      std::cout << "TCP hierarchical - OK" << std::endl;
+    }
+    unsetenv("THD_RANKS_PER_NODE");
+
 #ifdef WITH_GLOO
     g_data_channel_type = "gloo";
     for (auto workers : WORKERS_NUM) {
@@ -32,12 +32,26 @@ void test(std::shared_ptr<thd::DataChannel> data_channel) {
   }
 }
 
-void run_all_tests(std::shared_ptr<thd::DataChannel> data_channel, int workers) {
+void test_variable_sizes(std::shared_ptr<thd::DataChannelGloo> data_channel) {
+  data_channel->prewarmAllReduce({1, 100, 1000}, at::ScalarType::Float,
+                                 thd::DeviceType::CPU);
+  // More sizes than the cache holds, which makes it evict and recreate
+  // algorithms, and sizes that are not a bucket size, which pads them
+  for (std::size_t i = 0; i < 200; ++i) {
+    int64_t size = 1 + (i * 37) % 1000;
+    auto float_tensor = buildTensor<float>({size}, 1.5);
+    data_channel->allReduce(*float_tensor, THDReduceOp::THDReduceSUM);
+    ASSERT_TENSOR_VALUE(float, *float_tensor, 1.5 * data_channel->getNumProcesses())
+  }
+}
+
+void run_all_tests(std::shared_ptr<thd::DataChannelGloo> data_channel, int workers) {
   // NOTE: without properly working GlooCache this test would create
   // about (1000 * WORKERS ^ 3) connections what is over 'normal' system configuration
   for (std::size_t i = 0; i < 1000; ++i) {
     test(data_channel);
   }
+  test_variable_sizes(data_channel);
 }
 
 
@@ -67,6 +81,7 @@ void init_gloo_worker(unsigned int id, int workers) {
 
 int main(void)
 {
+  setenv("THD_GLOO_CACHE_SIZE", "16", 1);
   for (auto workers : WORKERS_NUM) {
     std::cout << "Gloo (workers: " << workers << "):" << std::endl;
     // start gloo master
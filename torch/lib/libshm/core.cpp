@@ -1,6 +1,9 @@
+#include <cstdlib>
 #include <cstring>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <TH/TH.h>
 #include "err.h"
@@ -8,8 +11,20 @@
 #include "libshm.h"
 
 std::unordered_map<std::string, ClientSocket> managers;
+pid_t managers_pid = 0;
 std::string manager_executable_path;
 
+// A forked child must not talk to the managers over its parent's connections,
+// the messages of both processes would interleave and the manager couldn't
+// tell when one of them dies
+void check_managers_pid() {
+  pid_t pid = getpid();
+  if (pid != managers_pid) {
+    managers.clear();
+    managers_pid = pid;
+  }
+}
+
 void libshm_init(const char *manager_exec_path) {
   manager_executable_path = std::string(manager_exec_path);
 }
@@ -24,6 +39,8 @@ libshm_context * libshm_context_new(const char *manager_handle, const char *file
     memcpy(ctx->manager_handle, manager_handle, handle_length+1);
   }
   ctx->th_context = THMapAllocatorContext_new(filename, flags);
+  ctx->flags = flags;
+  ctx->pooled = 0;
   return ctx;
 }
 
@@ -74,6 +91,7 @@ void start_manager() {
 }
 
 ClientSocket& get_manager_socket(char *manager_handle) {
+  check_managers_pid();
   std::string str_handle(manager_handle);
   auto it = managers.find(str_handle);
   if (it == managers.end()) {
@@ -104,23 +122,175 @@ AllocInfo get_alloc_info(libshm_context *ctx) {
   return info;
 }
 
+ClientSocket& get_socket_for(libshm_context *ctx) {
+  if (ctx->manager_handle) {
+    return get_manager_socket(ctx->manager_handle);
+  }
+  check_managers_pid();
+  if (managers.size() == 0)
+      start_manager();
+  const auto &manager = managers.begin();
+  ctx->manager_handle = copy_handle(manager->first);
+  return manager->second;
+}
+
+// Pool of shared memory segments for the storages this process creates to
+// send to others (e.g. the batches of a DataLoader worker). Creating, mapping
+// and registering a new segment for every tensor costs several syscalls and
+// page faults, so segments are kept mapped and handed out again once all the
+// processes that received them are done with them.
+//
+// Segments come in power of two size classes, each kept as a ring that is
+// scanned from where the last search stopped. The pool holds one reference
+// to each segment in its refcount header, so a refcount of 1 means nobody
+// else uses it. Storages too large for any class, or allocated once the pool
+// reached its size limit, get a fresh segment as before.
+//
+// The segments outlive the storages, until the process exits and the manager
+// unlinks them, so the pool is only enabled in processes that ask for it
+// (libshm_enable_pool) or when TORCH_SHM_POOL_SIZE sets its size in bytes.
+namespace {
+
+constexpr int kMinClassShift = 12;  // 4KB
+constexpr int kMaxClassShift = 26;  // 64MB
+constexpr int kNumSizeClasses = kMaxClassShift - kMinClassShift + 1;
+constexpr int64_t kDefaultPoolSize = 256 * 1024 * 1024;
+constexpr int kPoolFlags = TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_EXCLUSIVE;
+
+struct PooledSegment {
+  THMapAllocatorContext *th_context;
+  void *data;
+};
+
+struct SegmentPool {
+  std::mutex mutex;
+  pid_t pid = 0;
+  int64_t max_bytes = 0;
+  uint64_t next_id = 0;
+  std::vector<PooledSegment> rings[kNumSizeClasses];
+  size_t ring_pos[kNumSizeClasses] = {0};
+  libshm_pool_stats stats = {0};
+
+  // A forked child shares the parent's segments, so it has to start over
+  // with its own. The inherited mappings are left alone, the parent's
+  // references are not ours to drop.
+  void init_for_process() {
+    pid_t current = getpid();
+    if (pid == current) return;
+    pid = current;
+    for (int i = 0; i < kNumSizeClasses; i++) {
+      rings[i].clear();
+      ring_pos[i] = 0;
+    }
+    memset(&stats, 0, sizeof(stats));
+    const char *env = std::getenv("TORCH_SHM_POOL_SIZE");
+    max_bytes = env ? std::strtoll(env, nullptr, 10) : 0;
+  }
+};
+
+SegmentPool pool;
+
+int size_class(ptrdiff_t size) {
+  for (int shift = kMinClassShift; shift <= kMaxClassShift; shift++) {
+    if (size <= ((ptrdiff_t)1 << shift))
+      return shift - kMinClassShift;
+  }
+  return -1;
+}
+
+void * attach_segment(libshm_context *ctx, PooledSegment &segment) {
+  THRefcountedMapAllocator_incref(segment.th_context, segment.data);
+  THMapAllocatorContext_free(ctx->th_context);
+  ctx->th_context = THMapAllocatorContext_new(
+      THMapAllocatorContext_filename(segment.th_context), kPoolFlags);
+  ctx->pooled = 1;
+  return segment.data;
+}
+
+// Returns nullptr if the storage should get a segment of its own
+void * pool_alloc(libshm_context *ctx, ptrdiff_t size) {
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  pool.init_for_process();
+  if (pool.max_bytes <= 0) return nullptr;
+  int cls = size_class(size);
+  if (cls < 0) {
+    pool.stats.oversized++;
+    return nullptr;
+  }
+  pool.stats.allocations++;
+  // Receivers need the manager handle even for recycled segments
+  ClientSocket *socket;
+  try {
+    socket = &get_socket_for(ctx);
+  } catch(std::exception &e) {
+    THError(e.what());
+  }
+
+  auto &ring = pool.rings[cls];
+  size_t &pos = pool.ring_pos[cls];
+  for (size_t i = 0; i < ring.size(); i++) {
+    size_t idx = (pos + i) % ring.size();
+    auto &segment = ring[idx];
+    if (THRefcountedMapAllocator_refcount(segment.th_context, segment.data) == 1) {
+      pos = idx + 1;
+      pool.stats.reused++;
+      return attach_segment(ctx, segment);
+    }
+  }
+
+  ptrdiff_t class_size = (ptrdiff_t)1 << (cls + kMinClassShift);
+  if (pool.stats.pooled_bytes + class_size > pool.max_bytes) {
+    pool.stats.fallbacks++;
+    return nullptr;
+  }
+  std::string name = "/torch_" + std::to_string(pool.pid) + "_pool_" +
+      std::to_string(pool.next_id++);
+  PooledSegment segment;
+  segment.th_context = THMapAllocatorContext_new(name.c_str(), kPoolFlags);
+  libshm_context segment_ctx = {nullptr, segment.th_context, kPoolFlags, 1};
+  try {
+    AllocInfo info = get_alloc_info(&segment_ctx);
+    info.pooled = true;
+    socket->register_allocation(info);
+  } catch(std::exception &e) {
+    THMapAllocatorContext_free(segment.th_context);
+    THError(e.what());
+  }
+  segment.data = THRefcountedMapAllocator.malloc(segment.th_context, class_size);
+  ring.push_back(segment);
+  pool.stats.created++;
+  pool.stats.pooled_bytes += class_size;
+  return attach_segment(ctx, ring.back());
+}
+
+} // anonymous namespace
+
+void libshm_enable_pool() {
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  pool.init_for_process();
+  if (!std::getenv("TORCH_SHM_POOL_SIZE"))
+    pool.max_bytes = kDefaultPoolSize;
+}
+
+void libshm_get_pool_stats(libshm_pool_stats *stats) {
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  pool.init_for_process();
+  *stats = pool.stats;
+}
+
 void * libshm_alloc(void *_ctx, ptrdiff_t size) {
   // TODO: unlock GIL when contacting the manager
   auto *ctx = (libshm_context*)_ctx;
+  // Only storages created here to be sent elsewhere are pooled, the ones
+  // opening a segment received from another process map it as usual
+  if (ctx->flags == kPoolFlags && !ctx->manager_handle && size > 0) {
+    void *data = pool_alloc(ctx, size);
+    if (data) return data;
+  }
   try {
-    THMapAllocatorContext *th_context = ctx->th_context;
-    ClientSocket *socket;
-    if (ctx->manager_handle) {
-      socket = &get_manager_socket(ctx->manager_handle);
-    } else {
-      if (managers.size() == 0)
-          start_manager();
-      const auto &manager = managers.begin();
-      ctx->manager_handle = copy_handle(manager->first);
-      socket = &manager->second;
-    }
+    ClientSocket &socket = get_socket_for(ctx);
     AllocInfo info = get_alloc_info(ctx);
-    socket->register_allocation(info);
+    socket.register_allocation(info);
   } catch(std::exception &e) {
     THError(e.what());
   }
@@ -134,6 +304,13 @@ void * libshm_realloc(void *_ctx, void *data, ptrdiff_t size) {
 
 void libshm_free(void *_ctx, void *data) {
   auto *ctx = (libshm_context*)_ctx;
+  if (ctx->pooled) {
+    // The pool keeps the segment mapped and registered with the manager
+    THRefcountedMapAllocator_decref(ctx->th_context, data);
+    THMapAllocatorContext_free(ctx->th_context);
+    libshm_context_free(ctx);
+    return;
+  }
   AllocInfo info = get_alloc_info(ctx);
   info.free = true;
   ClientSocket &socket = get_manager_socket(ctx->manager_handle);
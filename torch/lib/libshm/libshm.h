@@ -12,11 +12,24 @@
 typedef struct {
   char *manager_handle;
   THMapAllocatorContext *th_context;
+  int flags;
+  int pooled;
 } libshm_context;
 
+typedef struct {
+  uint64_t allocations;   /* allocations that could be served by the pool */
+  uint64_t reused;        /* of those, served by a recycled segment */
+  uint64_t created;       /* segments added to the pool */
+  uint64_t fallbacks;     /* pool was full, a fresh segment was used */
+  uint64_t oversized;     /* too large for any size class */
+  int64_t pooled_bytes;   /* total size of the pooled segments */
+} libshm_pool_stats;
+
 EXPORT_API void libshm_init(const char *manager_exec_path);
 EXPORT_API libshm_context * libshm_context_new(const char *manager_handle, const char *filename, int flags);
 EXPORT_API void libshm_context_free(libshm_context *context);
+EXPORT_API void libshm_enable_pool(void);
+EXPORT_API void libshm_get_pool_stats(libshm_pool_stats *stats);
 
 extern THAllocator THManagedSharedAllocator;
 
@@ -28,6 +28,8 @@ struct ClientSession {
 
   ManagerSocket socket;
   pid_t pid;
+  // Segments the client keeps for reuse, they are never freed individually
+  std::vector<std::string> pooled_objects;
 };
 
 
@@ -116,6 +118,13 @@ int main(int argc, char *argv[]) {
         DEBUG("detaching process");
         auto &session = client_sessions.at(pfd.fd);
         DEBUG("%d has died", session.pid);
+        // Processes that received one of these keep their mapping, only
+        // the name goes away
+        for (auto &obj_name: session.pooled_objects) {
+          DEBUG("freeing pooled %s", obj_name.c_str());
+          shm_unlink(obj_name.c_str());
+          used_objects.erase(obj_name);
+        }
         to_remove.push_back(pfd.fd);
       } else if (pfd.revents & POLLIN) {
         if (pfd.fd == srv_socket->socket_fd) {
@@ -136,6 +145,8 @@ int main(int argc, char *argv[]) {
             free_used_object(info.filename);
           } else {
             used_objects.insert(info.filename);
+            if (info.pooled)
+              session.pooled_objects.emplace_back(info.filename);
             DEBUG("registered object %s", info.filename);
             session.socket.confirm();
           }
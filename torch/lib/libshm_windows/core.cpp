@@ -20,6 +20,13 @@ void libshm_context_free(libshm_context *ctx) {
   delete ctx;
 }
 
+void libshm_enable_pool() {
+}
+
+void libshm_get_pool_stats(libshm_pool_stats *stats) {
+  memset(stats, 0, sizeof(*stats));
+}
+
 void * libshm_alloc(void *_ctx, ptrdiff_t size) {
   auto *ctx = (libshm_context*)_ctx;
   return THRefcountedMapAllocator.malloc(ctx->th_context, size);
@@ -20,9 +20,21 @@ typedef struct {
   THMapAllocatorContext *th_context;
 } libshm_context;
 
+typedef struct {
+  uint64_t allocations;
+  uint64_t reused;
+  uint64_t created;
+  uint64_t fallbacks;
+  uint64_t oversized;
+  int64_t pooled_bytes;
+} libshm_pool_stats;
+
 SHM_API void libshm_init(const char *manager_exec_path);
 SHM_API libshm_context * libshm_context_new(const char *manager_handle, const char *filename, int flags);
 SHM_API void libshm_context_free(libshm_context *context);
+// Segments are not pooled on Windows, so all counters stay at zero
+SHM_API void libshm_enable_pool(void);
+SHM_API void libshm_get_pool_stats(libshm_pool_stats *stats);
 
 SHM_API THAllocator THManagedSharedAllocator;
 
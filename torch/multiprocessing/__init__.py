@@ -14,11 +14,12 @@ Because of the similarity of APIs we do not document most of this package
 contents, and we recommend referring to very good docs of the original module.
 """
 import sys
+import torch
 from .reductions import init_reductions
 import multiprocessing
 
 __all__ = ['set_sharing_strategy', 'get_sharing_strategy',
-           'get_all_sharing_strategies']
+           'get_all_sharing_strategies', 'shared_memory_pool_stats']
 
 
 from multiprocessing import *
@@ -64,4 +65,20 @@ def get_all_sharing_strategies():
     return _all_sharing_strategies
 
 
+def shared_memory_pool_stats():
+    """Returns statistics of the pool of shared memory segments reused by
+    tensors this process sends with the ``file_system`` strategy.
+
+    The returned dict has the number of ``allocations`` the pool could serve,
+    how many of them ``reused`` a segment, the number of segments ``created``,
+    the allocations that got a fresh segment because the pool was full
+    (``fallbacks``) or the tensor was too large (``oversized``), the total
+    size of the pooled segments (``pooled_bytes``) and the ``reuse_rate``.
+    """
+    stats = torch._C._shm_pool_stats()
+    allocations = stats['allocations']
+    stats['reuse_rate'] = stats['reused'] / float(allocations) if allocations else 0.0
+    return stats
+
+
 init_reductions()
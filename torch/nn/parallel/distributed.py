@@ -44,7 +44,15 @@ class DistributedDataParallel(Module):
     (see :func:`torch.distributed.init_process_group`).
 
     .. warning::
-        This module works only with the ``nccl`` and ``gloo`` backends.
+        This module works only with the ``nccl`` and ``gloo`` backends, unless
+        it is on the CPU.
+
+    If all the parameters of :attr:`module` are on the CPU and
+    :attr:`device_ids` is not given, the module runs in this process only and
+    its gradients are averaged while backward is still running: as soon as
+    all the gradients of a bucket of parameters are ready they are flattened
+    and all-reduced in the background. This works with any backend that
+    supports all-reduce of CPU tensors.
 
     .. warning::
         Constructor, forward method, and differentiation of the output (or a
@@ -102,6 +110,9 @@ class DistributedDataParallel(Module):
     def __init__(self, module, device_ids=None, output_device=None, dim=0,
                  broadcast_buffers=True):
         super(DistributedDataParallel, self).__init__()
+        if device_ids is None and not any(p.is_cuda for p in module.parameters()):
+            self._init_cpu(module, broadcast_buffers)
+            return
         if device_ids is None:
             device_ids = list(range(torch.cuda.device_count()))
         if output_device is None:
@@ -191,9 +202,33 @@ class DistributedDataParallel(Module):
         self.dispatch_lock = threading.Lock()
         self._start_reduction_threads()
 
+    def _init_cpu(self, module, broadcast_buffers):
+        self.module = module
+        self.device_ids = None
+        self.output_device = None
+        self.broadcast_buffers = broadcast_buffers
+        self.need_reduction = False
+        self._module_copies = [self.module]
+
+        MB = 1024 * 1024
+        self.broadcast_bucket_size = 10 * MB
+        self.cpu_reduce_bucket_size = 1 * MB
+
+        module_states = list(self.module.state_dict().values())
+        if len(module_states) > 0:
+            self._dist_broadcast_coalesced(module_states,
+                                           self.broadcast_bucket_size)
+        self._register_reducer()
+
+    def _register_reducer(self):
+        params = [p for p in self.module.parameters() if p.requires_grad]
+        self._reducer = dist._new_reducer(params, self.cpu_reduce_bucket_size)
+
     def __getstate__(self):
         attrs = copy.copy(self.__dict__)
-        if dist._backend != dist.dist_backend.NCCL:
+        if self.device_ids is None:
+            del attrs['_reducer']
+        elif dist._backend != dist.dist_backend.NCCL:
             del attrs['_grad_accs'], attrs['_reduction_queues'], \
                 attrs['_reduction_streams'], attrs['_reduction_threads'], \
                 attrs['_nccl_streams'], attrs['_default_streams']
@@ -201,7 +236,9 @@ class DistributedDataParallel(Module):
 
     def __setstate__(self, state):
         super(DistributedDataParallel, self).__setstate__(state)
-        if dist._backend == dist.dist_backend.NCCL:
+        if self.device_ids is None:
+            self._register_reducer()
+        elif dist._backend == dist.dist_backend.NCCL:
             self._register_nccl_grad_hook()
         else:
             self._register_grad_hooks()
@@ -209,6 +246,9 @@ class DistributedDataParallel(Module):
 
     def forward(self, *inputs, **kwargs):
         self.need_reduction = True
+        if self.device_ids is None:
+            self._sync_params()
+            return self.module(*inputs, **kwargs)
         inputs, kwargs = self.scatter(inputs, kwargs, self.device_ids)
         self._sync_params()
         if len(self.device_ids) == 1:
@@ -248,7 +288,8 @@ class DistributedDataParallel(Module):
                 tensor.copy_(synced)
 
     def _sync_params(self):
-        if len(self.device_ids) > 1:
+        multi_device = self.device_ids is not None and len(self.device_ids) > 1
+        if multi_device:
             # intra-node parameter sync
             params = [p.data for p in self.module.parameters()]
             result = broadcast_coalesced(params, self.device_ids, self.broadcast_bucket_size)
@@ -263,7 +304,7 @@ class DistributedDataParallel(Module):
                 # cross-node buffer sync
                 self._dist_broadcast_coalesced(buffers, self.broadcast_bucket_size)
 
-                if len(self.device_ids) > 1:
+                if multi_device:
                     # intra-node buffer sync
                     result = broadcast_coalesced(buffers, self.device_ids, self.broadcast_bucket_size)
                     for tensors, module in zip(result[1:], self._module_copies[1:]):
@@ -143,29 +143,35 @@ def _export(model, args, f, export_params=True, verbose=False, training=False,
     if verbose:
         print(trace)
 
-    # TODO: Don't allocate a in-memory string for the protobuf
+    # The protobuf is written out as it is encoded, and parameters exported
+    # externally are handed over one at a time, so that exporting a model
+    # never holds the whole protobuf or a copy of all its parameters.
     from torch.onnx.symbolic import _onnx_opset_version
-    defer_weight_export = export_type is not ExportTypes.PROTOBUF_FILE
     if export_params:
-        # NB: OrderedDict values is not actually a list, but trace.export is
+        # NB: OrderedDict values is not actually a list, but trace.export_to is
         # not duck-typed and expects an actual list.
-        proto, export_map = trace.export(list(_unique_state_dict(model).values()),
-                                         _onnx_opset_version, defer_weight_export)
+        params = list(_unique_state_dict(model).values())
     else:
-        proto, export_map = trace.export([], _onnx_opset_version, False)
+        params = []
+
+    def export_to(write, write_weight=None):
+        if not params:
+            write_weight = None
+        trace.export_to(write, params, _onnx_opset_version, write_weight)
 
     if export_type == ExportTypes.PROTOBUF_FILE:
-        assert(len(export_map) == 0)
-        torch.serialization._with_file_like(f, "wb", lambda f: f.write(proto))
+        torch.serialization._with_file_like(f, "wb", lambda f: export_to(f.write))
     elif export_type in [ExportTypes.ZIP_ARCHIVE, ExportTypes.COMPRESSED_ZIP_ARCHIVE]:
+        import io
         import zipfile
         compression = zipfile.ZIP_DEFLATED \
             if export_type == ExportTypes.COMPRESSED_ZIP_ARCHIVE \
             else zipfile.ZIP_STORED
         with zipfile.ZipFile(f, 'w', compression=compression) as z:
-            z.writestr(ONNX_ARCHIVE_MODEL_PROTO_NAME, proto)
-            for k, v in export_map.items():
-                z.writestr(k, v)
+            # With the parameters stored separately the protobuf is small
+            proto = io.BytesIO()
+            export_to(proto.write, z.writestr)
+            z.writestr(ONNX_ARCHIVE_MODEL_PROTO_NAME, proto.getvalue())
     elif export_type == ExportTypes.DIRECTORY:
         import os
         if os.path.exists(f):
@@ -173,14 +179,14 @@ def _export(model, args, f, export_params=True, verbose=False, training=False,
         else:
             os.makedirs(f)
 
-        model_proto_file = os.path.join(f, ONNX_ARCHIVE_MODEL_PROTO_NAME)
-        torch.serialization._with_file_like(
-            model_proto_file, "wb", lambda f: f.write(proto))
-
-        for k, v in export_map.items():
+        def write_weight(k, v):
             weight_proto_file = os.path.join(f, k)
             torch.serialization._with_file_like(
                 weight_proto_file, "wb", lambda f: f.write(v))
+
+        model_proto_file = os.path.join(f, ONNX_ARCHIVE_MODEL_PROTO_NAME)
+        torch.serialization._with_file_like(
+            model_proto_file, "wb", lambda f: export_to(f.write, write_weight))
     else:
         raise RuntimeError('Unknown export type')
     return torch_out
@@ -27,6 +27,11 @@ SHORT_SIZE = struct.Struct('=h').size
 MAGIC_NUMBER = 0x1950a86a20f9469cfc6c
 PROTOCOL_VERSION = 1001
 STORAGE_KEY_SEPARATOR = ','
+# Offset alignment of the data of each storage in files saved with
+# align_storages=True
+STORAGE_ALIGNMENT = 4096
+# Number of threads writing the storages of such files
+_SAVE_THREADS = 8
 
 
 class SourceChangeWarning(Warning):
@@ -131,7 +136,7 @@ def _is_real_file(f):
         return False
 
 
-def save(obj, f, pickle_module=pickle, pickle_protocol=DEFAULT_PROTOCOL):
+def save(obj, f, pickle_module=pickle, pickle_protocol=DEFAULT_PROTOCOL, align_storages=False):
     """Saves an object to a disk file.
 
     See also: :ref:`recommend-saving-models`
@@ -142,6 +147,11 @@ def save(obj, f, pickle_module=pickle, pickle_protocol=DEFAULT_PROTOCOL):
            containing a file name
         pickle_module: module used for pickling metadata and objects
         pickle_protocol: can be specified to override the default protocol
+        align_storages: if ``True``, the data of every storage is written at
+           an offset that is a multiple of the page size, before the pickled
+           object. Such files can be loaded with ``torch.load(..., mmap=True)``,
+           but not by versions of PyTorch that predate this option. ``f`` has
+           to implement ``tell`` too.
 
     .. warning::
         If you are using Python 2, torch.save does NOT support StringIO.StringIO
@@ -158,10 +168,14 @@ def save(obj, f, pickle_module=pickle, pickle_protocol=DEFAULT_PROTOCOL):
         >>> buffer = io.BytesIO()
         >>> torch.save(x, buffer)
     """
-    return _with_file_like(f, "wb", lambda f: _save(obj, f, pickle_module, pickle_protocol))
+    return _with_file_like(f, "wb", lambda f: _save(obj, f, pickle_module, pickle_protocol, align_storages))
 
 
-def _save(obj, f, pickle_module, pickle_protocol):
+def _padding(offset, alignment):
+    return (alignment - offset % alignment) % alignment
+
+
+def _save(obj, f, pickle_module, pickle_protocol, align_storages):
     if sys.version_info[0] == 2:
         import StringIO
         if isinstance(f, StringIO.StringIO):
@@ -224,9 +238,15 @@ def _save(obj, f, pickle_module, pickle_protocol):
         ),
     )
 
+    if align_storages:
+        sys_info['storage_alignment'] = STORAGE_ALIGNMENT
+
     pickle_module.dump(MAGIC_NUMBER, f, protocol=pickle_protocol)
     pickle_module.dump(PROTOCOL_VERSION, f, protocol=pickle_protocol)
     pickle_module.dump(sys_info, f, protocol=pickle_protocol)
+    if align_storages:
+        return _save_aligned(obj, f, pickle_module, pickle_protocol, persistent_id,
+                             serialized_storages)
     pickler = pickle_module.Pickler(f, protocol=pickle_protocol)
     pickler.persistent_id = persistent_id
     pickler.dump(obj)
@@ -238,7 +258,60 @@ def _save(obj, f, pickle_module, pickle_protocol):
         serialized_storages[key]._write_file(f, _is_real_file(f))
 
 
-def load(f, map_location=None, pickle_module=pickle):
+def _save_aligned(obj, f, pickle_module, pickle_protocol, persistent_id, serialized_storages):
+    # The storages come first, so that they are known before the object is
+    # unpickled: a list of (key, type, size), then the data of each storage
+    # (preceded by its size, as in the default format) padded to start at an
+    # aligned offset, then the pickled object.
+    #
+    # Writes to real files go through the file descriptor, which the file
+    # object doesn't see, so offsets are counted here instead of using tell().
+    pickled_obj = io.BytesIO()
+    pickler = pickle_module.Pickler(pickled_obj, protocol=pickle_protocol)
+    pickler.persistent_id = persistent_id
+    pickler.dump(obj)
+
+    serialized_storage_keys = sorted(serialized_storages.keys())
+    storage_index = [(key, normalize_storage_type(type(serialized_storages[key])),
+                      serialized_storages[key].size())
+                     for key in serialized_storage_keys]
+    pickle_module.dump(storage_index, f, protocol=pickle_protocol)
+    f.flush()
+    start = offset = f.tell()
+    storage_offsets = []
+    for key in serialized_storage_keys:
+        storage = serialized_storages[key]
+        offset += _padding(offset + 8, STORAGE_ALIGNMENT)
+        storage_offsets.append(offset)
+        offset += 8 + storage.size() * storage.element_size()
+
+    if _is_real_file(f) and sys.platform != 'win32' and len(serialized_storage_keys) > 1:
+        # The offsets are known in advance, so the storages are written in
+        # parallel with pwrite, without the GIL. The padding is left as a
+        # hole, which reads as zeros.
+        from multiprocessing.pool import ThreadPool
+        fd = f.fileno()
+        pool = ThreadPool(min(len(serialized_storage_keys), _SAVE_THREADS))
+        try:
+            pool.map(lambda i: serialized_storages[serialized_storage_keys[i]]._write_file_at(
+                fd, storage_offsets[i]), range(len(serialized_storage_keys)))
+        finally:
+            pool.close()
+            pool.join()
+        f.seek(offset)
+    else:
+        is_real_file = _is_real_file(f)
+        position = start
+        for key, storage_offset in zip(serialized_storage_keys, storage_offsets):
+            f.write(b'\0' * (storage_offset - position))
+            f.flush()
+            serialized_storages[key]._write_file(f, is_real_file)
+            position = storage_offset + 8 + serialized_storages[key].size() * \
+                serialized_storages[key].element_size()
+    f.write(pickled_obj.getvalue())
+
+
+def load(f, map_location=None, pickle_module=pickle, mmap=False):
     """Loads an object saved with :func:`torch.save` from a file.
 
     :meth:`torch.load` uses Python's unpickling facilities but treats storages,
@@ -277,6 +350,12 @@ def load(f, map_location=None, pickle_module=pickle):
             locations
         pickle_module: module used for unpickling metadata and objects (has to
             match the pickle_module used to serialize file)
+        mmap: if ``True``, the storages are mapped from the file instead of
+            being read, copy-on-write, so that loading doesn't depend on their
+            size and pages are only read when they are accessed. The file has
+            to be saved with ``align_storages=True``, and ``f`` has to be a file
+            name or a file object opened from one. Storages that
+            ``map_location`` moves to another device are still copied there.
 
     Example:
         >>> torch.load('tensors.pt')
@@ -292,6 +371,9 @@ def load(f, map_location=None, pickle_module=pickle):
         >>> with open('tensor.pt') as f:
                 buffer = io.BytesIO(f.read())
         >>> torch.load(buffer)
+        # Map the storages of a file saved with align_storages=True
+        >>> torch.save(model.state_dict(), 'model.pt', align_storages=True)
+        >>> torch.load('model.pt', mmap=True)
     """
     new_fd = False
     if isinstance(f, str) or \
@@ -300,13 +382,13 @@ def load(f, map_location=None, pickle_module=pickle):
         new_fd = True
         f = open(f, 'rb')
     try:
-        return _load(f, map_location, pickle_module)
+        return _load(f, map_location, pickle_module, mmap)
     finally:
         if new_fd:
             f.close()
 
 
-def _load(f, map_location, pickle_module):
+def _load(f, map_location, pickle_module, mmap=False):
     deserialized_objects = {}
 
     if map_location is None:
@@ -464,6 +546,13 @@ def _load(f, map_location, pickle_module):
         raise RuntimeError("Invalid protocol version: %s" % protocol_version)
 
     _sys_info = pickle_module.load(f)
+    alignment = _sys_info.get('storage_alignment')
+    if alignment is not None:
+        return _load_aligned(f, alignment, restore_location, pickle_module, mmap,
+                             _check_container_source)
+    if mmap:
+        raise RuntimeError("torch.load: mmap=True requires a file saved with "
+                           "align_storages=True")
     unpickler = pickle_module.Unpickler(f)
     unpickler.persistent_load = persistent_load
     result = unpickler.load()
@@ -477,3 +566,80 @@ def _load(f, map_location, pickle_module):
         offset = None
 
     return result
+
+
+def _load_aligned(f, alignment, restore_location, pickle_module, mmap, check_container_source):
+    # See _save_aligned for the layout
+    storage_index = pickle_module.load(f)
+    offset = f.tell()
+    f_is_real_file = _is_real_file(f)
+
+    if mmap:
+        filename = getattr(f, 'name', None)
+        if not isinstance(filename, _string_classes) or not os.path.isfile(filename):
+            raise RuntimeError("torch.load: mmap=True requires a file name or a file object "
+                               "opened from one")
+        file_size = os.path.getsize(filename)
+
+    # With mmap, the whole file is mapped once for each type of storage, and
+    # the storages are views of these mappings, which are freed with the last
+    # of them. The data offsets are aligned, so they are multiples of the
+    # element sizes.
+    mappings = {}
+    storages = {}
+    for key, storage_type, size in storage_index:
+        element_size = storage_type().element_size()
+        offset += _padding(offset + 8, alignment)
+        data_offset = offset + 8
+        if mmap:
+            if size == 0:
+                storage = storage_type()
+            else:
+                if storage_type not in mappings:
+                    mappings[storage_type] = storage_type.from_file(
+                        filename, False, file_size // element_size)
+                storage = storage_type(mappings[storage_type], data_offset // element_size, size)
+        else:
+            storage = storage_type(size)
+            if f_is_real_file:
+                storage._set_from_file(f, offset, True)
+            else:
+                f.seek(offset)
+                storage._set_from_file(f, None, False)
+        storages[key] = storage
+        offset = data_offset + size * element_size
+    if f_is_real_file and not mmap:
+        # The storages were read through the file descriptor, behind the back
+        # of the buffer of f, which seeking to the end discards
+        f.seek(0, io.SEEK_END)
+    f.seek(offset)
+
+    deserialized_objects = {}
+
+    def persistent_load(saved_id):
+        assert isinstance(saved_id, tuple)
+        typename = saved_id[0]
+        data = saved_id[1:]
+
+        if typename == 'module':
+            if all(data[1:]):
+                check_container_source(*data)
+            return data[0]
+        elif typename == 'storage':
+            data_type, root_key, location, size, view_metadata = data
+            if root_key not in deserialized_objects:
+                deserialized_objects[root_key] = restore_location(storages[root_key], location)
+            storage = deserialized_objects[root_key]
+            if view_metadata is not None:
+                view_key, view_offset, view_size = view_metadata
+                if view_key not in deserialized_objects:
+                    deserialized_objects[view_key] = storage[view_offset:view_offset + view_size]
+                return deserialized_objects[view_key]
+            else:
+                return storage
+        else:
+            raise RuntimeError("Unknown saved id type: %s" % saved_id[0])
+
+    unpickler = pickle_module.Unpickler(f)
+    unpickler.persistent_load = persistent_load
+    return unpickler.load()
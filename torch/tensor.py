@@ -106,6 +106,10 @@ class Tensor(torch._C._TensorBase):
         This function returns a handle with a method ``handle.remove()``
         that removes the hook from the module.
 
+        :attr:`hook` can also be a native hook from
+        :mod:`torch.autograd.native_hooks`, which runs without the GIL, before
+        the Python hooks of the Tensor.
+
         Example:
             >>> v = torch.tensor([0., 0., 0.], requires_grad=True)
             >>> h = v.register_hook(lambda grad: grad * 2)  # double the gradient
@@ -122,6 +126,8 @@ class Tensor(torch._C._TensorBase):
         if not self.requires_grad:
             raise RuntimeError("cannot register a hook on a tensor that "
                                "doesn't require gradient")
+        if isinstance(hook, torch.autograd.NativeGradHook):
+            return torch.autograd._register_native_hook(self, hook)
         if self._backward_hooks is None:
             self._backward_hooks = OrderedDict()
             if self.grad_fn is not None:
@@ -292,17 +298,13 @@ class Tensor(torch._C._TensorBase):
     def expand_as(self, tensor):
         return self.expand(tensor.size())
 
-    def unique(self, sorted=False, return_inverse=False):
+    def unique(self, sorted=False, return_inverse=False, return_counts=False):
         r"""Returns the unique scalar elements of the tensor as a 1-D tensor.
 
         See :func:`torch.unique`
         """
-        output, inverse_indices = self._unique(
-            sorted=sorted, return_inverse=return_inverse)
-        if return_inverse:
-            return output, inverse_indices
-        else:
-            return output
+        return torch.unique(self, sorted=sorted, return_inverse=return_inverse,
+                            return_counts=return_counts)
 
     def __rsub__(self, other):
         return -self + other
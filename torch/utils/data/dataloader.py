@@ -42,6 +42,9 @@ def _worker_loop(dataset, index_queue, data_queue, collate_fn, seed, init_fn, wo
     _set_worker_signal_handlers()
 
     torch.set_num_threads(1)
+    # batches sent with the file_system strategy recycle shared memory
+    # segments once the main process frees them
+    torch._C._enable_shm_pool()
     random.seed(seed)
     torch.manual_seed(seed)
 
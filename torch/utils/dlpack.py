@@ -1,4 +1,49 @@
 import torch
 
-from torch._C import _from_dlpack as from_dlpack
-from torch._C import _to_dlpack as to_dlpack
+from torch._C import _from_dlpack
+from torch._C import _to_dlpack
+
+
+def _stream_handle(stream):
+    if isinstance(stream, torch.cuda.Stream):
+        return stream.cuda_stream
+    return int(stream)
+
+
+def to_dlpack(tensor, stream=None):
+    r"""Returns a DLPack capsule sharing the memory of :attr:`tensor`.
+
+    Arguments:
+        tensor (Tensor): the tensor to export
+        stream (torch.cuda.Stream or int, optional): the stream on which the
+            consumer will use a CUDA tensor, as a stream object or a raw
+            ``cudaStream_t`` handle. Its work queued from now on waits for the
+            work queued so far on the current stream, without synchronizing
+            the device.
+    """
+    capsule = _to_dlpack(tensor)
+    if stream is not None and tensor.is_cuda:
+        with torch.cuda.device(tensor.get_device()):
+            torch._C._cuda_streamWaitStream(_stream_handle(stream),
+                                            torch.cuda.current_stream().cuda_stream)
+    return capsule
+
+
+def from_dlpack(dlpack, stream=None):
+    r"""Returns a tensor sharing the memory of the DLPack capsule
+    :attr:`dlpack`. A capsule can only be consumed once.
+
+    Arguments:
+        dlpack: the DLPack capsule
+        stream (torch.cuda.Stream or int, optional): the stream on which the
+            producer wrote a CUDA tensor, as a stream object or a raw
+            ``cudaStream_t`` handle. The work queued from now on on the current
+            stream waits for the work queued so far on it, without
+            synchronizing the device.
+    """
+    tensor = _from_dlpack(dlpack)
+    if stream is not None and tensor.is_cuda:
+        with torch.cuda.device(tensor.get_device()):
+            torch._C._cuda_streamWaitStream(torch.cuda.current_stream().cuda_stream,
+                                            _stream_handle(stream))
+    return tensor